@@ -70,10 +70,13 @@ LOCAL_ARM_MODE := arm
 # List of client source files, directly taken from Makefile.am
 LOCAL_SRC_FILES := \
     src/client/linux/crash_generation/crash_generation_client.cc \
+    src/client/linux/dump_writer_common/crash_key_store.cc \
+    src/client/linux/dump_writer_common/module_table.cc \
     src/client/linux/dump_writer_common/thread_info.cc \
     src/client/linux/dump_writer_common/ucontext_reader.cc \
     src/client/linux/handler/exception_handler.cc \
     src/client/linux/handler/minidump_descriptor.cc \
+    src/client/linux/handler/stack_snapshot.cc \
     src/client/linux/log/log.cc \
     src/client/linux/microdump_writer/microdump_writer.cc \
     src/client/linux/minidump_writer/linux_dumper.cc \
@@ -82,6 +85,7 @@ LOCAL_SRC_FILES := \
     src/client/linux/minidump_writer/pe_file.cc \
     src/client/minidump_file_writer.cc \
     src/common/convert_UTF.cc \
+    src/common/lz4_block.cc \
     src/common/md5.cc \
     src/common/string_conversion.cc \
     src/common/linux/breakpad_getcontext.S \
@@ -0,0 +1,133 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// crash_signature.h: Computes the quick signature of a crash for the
+// MD_CRASH_SIGNATURE_STREAM.
+//
+// A CrashSignature hashes, for each address on the crashing stack that
+// falls in a known module, the module's build id and the address's offset
+// into it.  The exception handlers feed it the crashing instruction and the
+// return addresses that WalkFramePointers() finds.  Neither allocates nor
+// calls into the C library, so they can be used from a signal handler or a
+// compromised process.
+
+#ifndef CLIENT_CRASH_SIGNATURE_H__
+#define CLIENT_CRASH_SIGNATURE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "google_breakpad/common/minidump_format.h"
+
+namespace google_breakpad {
+
+class CrashSignature {
+ public:
+  // The most addresses a signature is meant to cover.  A few frames are
+  // enough to tell bugs apart, and stay the same across small changes
+  // further up the stack.
+  static const size_t kMaxFrames = 8;
+
+  CrashSignature() : hash_(kOffsetBasis), frame_count_(0) {}
+
+  // Adds an address that lies |offset| bytes into the module whose build id
+  // is the |identifier_size| bytes at |identifier|.
+  void AddFrame(const uint8_t* identifier, size_t identifier_size,
+                uint64_t offset) {
+    for (size_t i = 0; i < identifier_size; ++i)
+      Mix(identifier[i]);
+    for (int i = 0; i < 8; ++i)
+      Mix(static_cast<uint8_t>(offset >> (i * 8)));
+    ++frame_count_;
+  }
+
+  // The signature, or 0 if no frames were added.
+  uint64_t signature() const { return frame_count_ ? hash_ : 0; }
+  uint32_t frame_count() const { return frame_count_; }
+
+  // Fills in the stream's contents.
+  void GetRaw(MDRawCrashSignature* raw) const {
+    raw->signature = signature();
+    raw->frame_count = frame_count_;
+    raw->reserved = 0;
+  }
+
+  // Writes |signature| to |buffer| as 16 lowercase hex digits and a NUL,
+  // as uploaders send it.
+  static void Format(uint64_t signature, char buffer[17]) {
+    static const char kDigits[] = "0123456789abcdef";
+    for (int i = 15; i >= 0; --i) {
+      buffer[i] = kDigits[signature & 0xf];
+      signature >>= 4;
+    }
+    buffer[16] = '\0';
+  }
+
+ private:
+  static const uint64_t kOffsetBasis = 0xcbf29ce484222325ULL;
+  static const uint64_t kPrime = 0x100000001b3ULL;
+
+  void Mix(uint8_t byte) {
+    hash_ ^= byte;
+    hash_ *= kPrime;
+  }
+
+  uint64_t hash_;
+  uint32_t frame_count_;
+};
+
+// Follows the chain of frame pointers that starts at |frame_pointer|, in
+// which each frame begins with the caller's frame pointer followed by the
+// return address, as on x86, x86-64 and ARM64.  Stores up to |max| return
+// addresses in |return_addresses| and returns how many it stored.  The walk
+// stops at the first frame pointer that is misaligned, does not move up the
+// stack, or leaves [|stack_low|, |stack_high|), so the caller must make sure
+// only that the range is readable.
+inline size_t WalkFramePointers(uintptr_t frame_pointer, uintptr_t stack_low,
+                                uintptr_t stack_high,
+                                uintptr_t* return_addresses, size_t max) {
+  size_t count = 0;
+  while (count < max && frame_pointer >= stack_low &&
+         frame_pointer % sizeof(uintptr_t) == 0 &&
+         stack_high - frame_pointer >= 2 * sizeof(uintptr_t)) {
+    const uintptr_t* frame = reinterpret_cast<const uintptr_t*>(frame_pointer);
+    const uintptr_t caller_frame_pointer = frame[0];
+    const uintptr_t return_address = frame[1];
+    if (return_address == 0)
+      break;
+    return_addresses[count++] = return_address;
+    if (caller_frame_pointer <= frame_pointer)
+      break;
+    frame_pointer = caller_frame_pointer;
+  }
+  return count;
+}
+
+}  // namespace google_breakpad
+
+#endif  // CLIENT_CRASH_SIGNATURE_H__
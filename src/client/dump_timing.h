@@ -0,0 +1,158 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// dump_timing.h: Records how long a client spends in each phase of writing
+// a minidump, for the MD_DUMP_TIMING_STREAM.
+//
+// DumpTiming only reads a monotonic clock and writes to its own members, so
+// it can be used from a signal handler or a compromised process.
+
+#ifndef CLIENT_DUMP_TIMING_H__
+#define CLIENT_DUMP_TIMING_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+#include "google_breakpad/common/minidump_format.h"
+
+namespace google_breakpad {
+
+class DumpTiming {
+ public:
+  // Start times are measured from the construction of the DumpTiming, or
+  // from the earliest phase given to Add() if that is earlier.
+  DumpTiming() : origin_(Now()) {
+    for (int i = 0; i < MD_DUMP_PHASE_COUNT; ++i) {
+      entered_[i] = false;
+      begun_[i] = 0;
+      phases_[i].phase = i;
+      phases_[i].count = 0;
+      phases_[i].bytes = 0;
+      phases_[i].start_time = 0;
+      phases_[i].duration = 0;
+    }
+  }
+
+  // Starts timing |phase|.  A phase may be entered again after End().
+  void Begin(MDDumpPhase phase) {
+    begun_[phase] = Now();
+    Enter(phase, begun_[phase]);
+  }
+
+  // Stops timing |phase|, which must have been begun, and adds |count|
+  // and |bytes| to its counters.
+  void End(MDDumpPhase phase, uint32_t count = 0, uint64_t bytes = 0) {
+    phases_[phase].duration += Now() - begun_[phase];
+    Count(phase, count, bytes);
+  }
+
+  // Adds a time spent in |phase| that was measured elsewhere, from |begin|
+  // to |end| as returned by Now(), and |count| to its counter.  This is for
+  // work done before the DumpTiming existed, such as suspending threads
+  // before a dump is started.
+  void Add(MDDumpPhase phase, uint64_t begin, uint64_t end, uint32_t count) {
+    Enter(phase, begin);
+    if (begin < origin_)
+      origin_ = begin;
+    phases_[phase].duration += end - begin;
+    Count(phase, count);
+  }
+
+  // Adds |count| and |bytes| to the counters of |phase|.
+  void Count(MDDumpPhase phase, uint32_t count, uint64_t bytes = 0) {
+    phases_[phase].count += count;
+    phases_[phase].bytes += bytes;
+  }
+
+  // Copies the phases that were entered, in MDDumpPhase order, to
+  // |entries|, which must have room for MD_DUMP_PHASE_COUNT of them.
+  // Returns the number copied.
+  size_t GetEntries(MDRawDumpPhaseTiming* entries) const {
+    size_t count = 0;
+    for (int i = 0; i < MD_DUMP_PHASE_COUNT; ++i) {
+      if (!entered_[i])
+        continue;
+      entries[count] = phases_[i];
+      entries[count].start_time -= origin_;
+      ++count;
+    }
+    return count;
+  }
+
+  // A monotonic time in nanoseconds.
+  static uint64_t Now() {
+#if defined(_WIN32)
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER ticks;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&ticks);
+    // Split the conversion so that it cannot overflow.
+    const uint64_t seconds = ticks.QuadPart / frequency.QuadPart;
+    const uint64_t remainder = ticks.QuadPart % frequency.QuadPart;
+    return seconds * 1000000000 +
+           remainder * 1000000000 / frequency.QuadPart;
+#elif defined(__APPLE__)
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    return mach_absolute_time() * timebase.numer / timebase.denom;
+#else
+    struct timespec now;
+    // clock_gettime() is async-signal-safe.
+    if (clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+      return 0;
+    return static_cast<uint64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+#endif
+  }
+
+ private:
+  // Notes that |phase| was entered at |now|.
+  void Enter(MDDumpPhase phase, uint64_t now) {
+    if (!entered_[phase] || now < phases_[phase].start_time)
+      phases_[phase].start_time = now;
+    entered_[phase] = true;
+  }
+
+  uint64_t origin_;
+  // When each phase was last begun, and whether it ever was.  Until
+  // GetEntries(), the start times in |phases_| are times from Now().
+  uint64_t begun_[MD_DUMP_PHASE_COUNT];
+  bool entered_[MD_DUMP_PHASE_COUNT];
+  MDRawDumpPhaseTiming phases_[MD_DUMP_PHASE_COUNT];
+};
+
+}  // namespace google_breakpad
+
+#endif  // CLIENT_DUMP_TIMING_H__
@@ -119,6 +119,10 @@ typedef void (*BreakpadUploadCompletionCallback)(NSString* report_id,
 //                                but pass as URL parameters when
 //                                uploading theminidump to the crash
 //                                server.
+//
+// BREAKPAD_COMPRESS_UPLOADS      If YES, crash reports are gzip-compressed
+//                                before they are uploaded, which the server
+//                                must accept.  Defaults to NO.
 //=============================================================================
 // The BREAKPAD_PRODUCT, BREAKPAD_VERSION and BREAKPAD_URL are
 // required to have non-NULL values.  By default, the BREAKPAD_PRODUCT
@@ -209,6 +213,10 @@ int BreakpadGetCrashReportCount(BreakpadRef ref);
 // Returns the next upload configuration. The report file is deleted.
 NSDictionary* BreakpadGetNextReportConfiguration(BreakpadRef ref);
 
+// Returns the configurations of up to |max_count| reports to upload next,
+// listing the report directory once. The report files are deleted.
+NSArray* BreakpadGetNextReportConfigurations(BreakpadRef ref, int max_count);
+
 // Returns the date of the most recent crash report.
 NSDate* BreakpadGetDateOfMostRecentCrashReport(BreakpadRef ref);
 
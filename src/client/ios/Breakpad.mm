@@ -160,6 +160,7 @@ class Breakpad {
   NSArray* CrashReportsToUpload();
   NSString* NextCrashReportToUpload();
   NSDictionary* NextCrashReportConfiguration();
+  NSArray* NextCrashReportConfigurations(int max_count);
   NSDictionary* FixedUpCrashReportConfiguration(NSDictionary* configuration);
   NSDate* DateOfMostRecentCrashReport();
   void UploadNextReport(NSDictionary* server_parameters);
@@ -340,6 +341,8 @@ bool Breakpad::ExtractParameters(NSDictionary* parameters) {
 
   NSDictionary* serverParameters =
       [parameters objectForKey:@BREAKPAD_SERVER_PARAMETER_DICT];
+  BOOL compressUploads =
+      [[parameters objectForKey:@BREAKPAD_COMPRESS_UPLOADS] boolValue];
 
   if (!product)
     product = [parameters objectForKey:@"CFBundleName"];
@@ -397,6 +400,8 @@ bool Breakpad::ExtractParameters(NSDictionary* parameters) {
   dictionary.SetKeyValue(BREAKPAD_VENDOR,          [vendor UTF8String]);
   dictionary.SetKeyValue(BREAKPAD_DUMP_DIRECTORY,
                          [dumpSubdirectory UTF8String]);
+  if (compressUploads)
+    dictionary.SetKeyValue(BREAKPAD_COMPRESS_UPLOADS, "YES");
 
   struct timeval tv;
   gettimeofday(&tv, NULL);
@@ -470,6 +475,27 @@ NSDictionary* Breakpad::NextCrashReportConfiguration() {
   return FixedUpCrashReportConfiguration(configuration);
 }
 
+//=============================================================================
+NSArray* Breakpad::NextCrashReportConfigurations(int max_count) {
+  NSString* directory = KeyValue(@BREAKPAD_DUMP_DIRECTORY);
+  if (!directory)
+    return nil;
+  // List the directory once for the whole batch, taking reports from the end
+  // as NextCrashReportToUpload does.
+  NSArray* configs = CrashReportsToUpload();
+  NSMutableArray* configurations = [NSMutableArray array];
+  for (NSString* config in [configs reverseObjectEnumerator]) {
+    if ((int)[configurations count] >= max_count)
+      break;
+    NSString* path = [directory stringByAppendingPathComponent:config];
+    NSDictionary* configuration =
+        [Uploader readConfigurationDataFromFile:path];
+    if (configuration)
+      [configurations addObject:FixedUpCrashReportConfiguration(configuration)];
+  }
+  return configurations;
+}
+
 //=============================================================================
 NSDictionary* Breakpad::FixedUpCrashReportConfiguration(NSDictionary* configuration) {
   NSMutableDictionary* fixedConfiguration = [[configuration mutableCopy] autorelease];
@@ -477,6 +503,12 @@ NSDictionary* Breakpad::FixedUpCrashReportConfiguration(NSDictionary* configurat
   // an UUID that is not guaranteed to stay the same over time.
   [fixedConfiguration setObject:KeyValue(@BREAKPAD_DUMP_DIRECTORY)
                     forKey:@kReporterMinidumpDirectoryKey];
+  // Whether to compress follows the running app rather than the one that
+  // crashed, so that turning compression on applies to reports already queued.
+  [fixedConfiguration removeObjectForKey:@BREAKPAD_COMPRESS_UPLOADS];
+  if (NSString* compress = KeyValue(@BREAKPAD_COMPRESS_UPLOADS)) {
+    [fixedConfiguration setObject:compress forKey:@BREAKPAD_COMPRESS_UPLOADS];
+  }
   return fixedConfiguration;
 }
 
@@ -887,6 +919,18 @@ NSDictionary* BreakpadGetNextReportConfiguration(BreakpadRef ref) {
   return nil;
 }
 
+//=============================================================================
+NSArray* BreakpadGetNextReportConfigurations(BreakpadRef ref, int max_count) {
+  try {
+    Breakpad* breakpad = (Breakpad*)ref;
+    if (breakpad && max_count > 0)
+      return breakpad->NextCrashReportConfigurations(max_count);
+  } catch(...) {    // don't let exceptions leave this C API
+    fprintf(stderr, "BreakpadGetNextReportConfigurations() : error\n");
+  }
+  return nil;
+}
+
 //=============================================================================
 NSDate* BreakpadGetDateOfMostRecentCrashReport(BreakpadRef ref) {
   try {
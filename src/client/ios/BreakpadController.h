@@ -62,6 +62,18 @@
   // done.
   int uploadIntervalInSeconds_;
 
+  // The number of reports sent each time the upload interval elapses.
+  int uploadBatchSize_;
+
+  // The number of reports of a batch that may be uploading at once.
+  int maxConcurrentUploads_;
+
+  // The time after the controller is started during which no report is sent.
+  int launchGracePeriodInSeconds_;
+
+  // When the controller was started.
+  CFAbsoluteTime startTime_;
+
   // The dictionary that contains additional server parameters to send when
   // uploading crash reports.
   NSDictionary* uploadTimeParameters_;
@@ -90,6 +102,20 @@
 // will prevent uploads.
 - (void)setUploadInterval:(int)intervalInSeconds;
 
+// Set the number of reports to send each time the upload interval elapses,
+// and how many of them may be uploading at once. Both default to 1.
+- (void)setUploadBatchSize:(int)batchSize
+      maxConcurrentUploads:(int)maxConcurrentUploads;
+
+// Set the time to wait after the controller is started before sending any
+// report, so that uploads don't compete with the work done by the
+// application at launch. Defaults to 0.
+- (void)setLaunchGracePeriod:(int)gracePeriodInSeconds;
+
+// Set whether reports are gzip-compressed before being uploaded. The server
+// must accept compressed requests. See |BREAKPAD_COMPRESS_UPLOADS|.
+- (void)setCompressUploads:(BOOL)compress;
+
 // Set additional server parameters to send when uploading crash reports.
 - (void)setParametersToAddAtUploadTime:(NSDictionary*)uploadTimeParameters;
 
@@ -48,6 +48,9 @@
 // Load a crash report and send it to the server.
 - (void)sendStoredCrashReports;
 
+// Loads a batch of crash reports and sends them to the server.
+- (void)sendNextReportBatch;
+
 // Returns when a report can be sent. |-1| means never, |0| means that a report
 // can be sent immediately, a positive number is the number of seconds to wait
 // before being allowed to upload a report.
@@ -110,6 +113,8 @@ NSString* GetPlatform() {
     queue_ = dispatch_queue_create("com.google.BreakpadQueue", NULL);
     enableUploads_ = NO;
     started_ = NO;
+    uploadBatchSize_ = 1;
+    maxConcurrentUploads_ = 1;
     [self resetConfiguration];
   }
   return self;
@@ -130,6 +135,7 @@ NSString* GetPlatform() {
   if (started_)
     return;
   started_ = YES;
+  startTime_ = CFAbsoluteTimeGetCurrent();
   void(^startBlock)() = ^{
       assert(!breakpadRef_);
       breakpadRef_ = BreakpadCreate(configuration_);
@@ -226,6 +232,28 @@ NSString* GetPlatform() {
     uploadIntervalInSeconds_ = 0;
 }
 
+- (void)setUploadBatchSize:(int)batchSize
+      maxConcurrentUploads:(int)maxConcurrentUploads {
+  NSAssert(!started_, @"The controller must not be started when "
+                      "setUploadBatchSize:maxConcurrentUploads: is called");
+  uploadBatchSize_ = batchSize < 1 ? 1 : batchSize;
+  maxConcurrentUploads_ = maxConcurrentUploads < 1 ? 1 : maxConcurrentUploads;
+}
+
+- (void)setLaunchGracePeriod:(int)gracePeriodInSeconds {
+  NSAssert(!started_,
+      @"The controller must not be started when setLaunchGracePeriod is called");
+  launchGracePeriodInSeconds_ =
+      gracePeriodInSeconds < 0 ? 0 : gracePeriodInSeconds;
+}
+
+- (void)setCompressUploads:(BOOL)compress {
+  NSAssert(!started_,
+      @"The controller must not be started when setCompressUploads is called");
+  [configuration_ setValue:(compress ? @"YES" : @"NO")
+                    forKey:@BREAKPAD_COMPRESS_UPLOADS];
+}
+
 - (void)setParametersToAddAtUploadTime:(NSDictionary*)uploadTimeParameters {
   NSAssert(!started_, @"The controller must not be started when "
                       "setParametersToAddAtUploadTime is called");
@@ -319,6 +347,12 @@ NSString* GetPlatform() {
   if (!breakpadRef_ || uploadIntervalInSeconds_ <= 0 || !enableUploads_)
     return -1;
 
+  // Nothing is sent until the launch grace period is over.
+  NSTimeInterval sinceStart = CFAbsoluteTimeGetCurrent() - startTime_;
+  int graceDelay = 0;
+  if (sinceStart < launchGracePeriodInSeconds_)
+    graceDelay = launchGracePeriodInSeconds_ - static_cast<int>(sinceStart);
+
   // To prevent overloading the crash server, crashes are not sent than one
   // report every |uploadIntervalInSeconds_|. A value in the user defaults is
   // used to keep the time of the last upload.
@@ -328,8 +362,9 @@ NSString* GetPlatform() {
   NSTimeInterval spanSeconds = CFAbsoluteTimeGetCurrent() - lastTime;
 
   if (spanSeconds >= uploadIntervalInSeconds_)
-    return 0;
-  return uploadIntervalInSeconds_ - static_cast<int>(spanSeconds);
+    return graceDelay;
+  return MAX(graceDelay,
+             uploadIntervalInSeconds_ - static_cast<int>(spanSeconds));
 }
 
 - (void)reportWillBeSent {
@@ -339,6 +374,35 @@ NSString* GetPlatform() {
   [userDefaults synchronize];
 }
 
+// This method must be called from the breakpad queue.
+- (void)sendNextReportBatch {
+  NSArray* configurations =
+      BreakpadGetNextReportConfigurations(breakpadRef_, uploadBatchSize_);
+  if ([configurations count] == 0)
+    return;
+
+  // The uploads run at utility priority so that they yield to the work of the
+  // application. The breakpad queue waits for the whole batch, which keeps
+  // breakpadRef_ alive until the uploads are done.
+  dispatch_queue_t uploadQueue = dispatch_get_global_queue(QOS_CLASS_UTILITY, 0);
+  dispatch_semaphore_t slots = dispatch_semaphore_create(maxConcurrentUploads_);
+  dispatch_group_t group = dispatch_group_create();
+  BreakpadRef ref = breakpadRef_;
+  NSDictionary* parameters = uploadTimeParameters_;
+  BreakpadUploadCompletionCallback callback = uploadCompleteCallback_;
+  for (NSDictionary* configuration in configurations) {
+    dispatch_semaphore_wait(slots, DISPATCH_TIME_FOREVER);
+    dispatch_group_async(group, uploadQueue, ^{
+        BreakpadUploadReportWithParametersAndConfiguration(
+            ref, parameters, configuration, callback);
+        dispatch_semaphore_signal(slots);
+    });
+  }
+  dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+  dispatch_release(group);
+  dispatch_release(slots);
+}
+
 // This method must be called from the breakpad queue.
 - (void)sendStoredCrashReports {
   if (BreakpadGetCrashReportCount(breakpadRef_) == 0)
@@ -353,8 +417,7 @@ NSString* GetPlatform() {
   // A report can be sent now.
   if (timeToWait == 0) {
     [self reportWillBeSent];
-    BreakpadUploadNextReportWithParameters(breakpadRef_, uploadTimeParameters_,
-                                           uploadCompleteCallback_);
+    [self sendNextReportBatch];
 
     // If more reports must be sent, make sure this method is called again.
     if (BreakpadGetCrashReportCount(breakpadRef_) > 0)
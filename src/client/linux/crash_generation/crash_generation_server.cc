@@ -40,6 +40,7 @@
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <vector>
@@ -54,8 +55,31 @@
 
 static const char kCommandQuit = 'x';
 
+// The number of threads that suspend and read the registers of a crashed
+// client's threads. Attaching to each thread waits for it to stop, so
+// processes with thousands of threads are dumped much sooner this way.
+static const int kDumperHelperThreads = 4;
+
+// Return the time on the monotonic clock, in milliseconds.
+static int64_t MonotonicMs()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
 namespace google_breakpad {
 
+// A client's report of a crash, waiting for or having its minidump written.
+struct CrashGenerationServer::DumpRequest {
+  pid_t crashing_pid;
+  // Closing this lets the client continue; -1 once it has been.
+  int signal_fd;
+  // When the client is to be released, or 0 for never.
+  int64_t deadline_ms;
+  char crash_context[sizeof(ExceptionHandler::CrashContext)];
+};
+
 CrashGenerationServer::CrashGenerationServer(
   const int listen_fd,
   OnClientDumpRequestCallback dump_callback,
@@ -69,19 +93,29 @@ CrashGenerationServer::CrashGenerationServer(
     dump_context_(dump_context),
     exit_callback_(exit_callback),
     exit_context_(exit_context),
+    dump_output_callback_(NULL),
+    dump_output_context_(NULL),
     generate_dumps_(generate_dumps),
-    started_(false)
+    started_(false),
+    max_concurrent_dumps_(1),
+    max_queued_dumps_(64),
+    dump_timeout_ms_(0),
+    stopping_(false)
 {
   if (dump_path)
     dump_dir_ = *dump_path;
   else
     dump_dir_ = "/tmp";
+  pthread_mutex_init(&queue_mutex_, NULL);
+  pthread_cond_init(&queue_cond_, NULL);
 }
 
 CrashGenerationServer::~CrashGenerationServer()
 {
   if (started_)
     Stop();
+  pthread_cond_destroy(&queue_cond_);
+  pthread_mutex_destroy(&queue_mutex_);
 }
 
 bool
@@ -105,9 +139,27 @@ CrashGenerationServer::Start()
   control_pipe_in_ = control_pipe[0];
   control_pipe_out_ = control_pipe[1];
 
-  if (pthread_create(&thread_, NULL,
-                     ThreadMain, reinterpret_cast<void*>(this)))
+  stopping_ = false;
+  for (int i = 0; i < max_concurrent_dumps_ || workers_.empty(); ++i) {
+    pthread_t worker;
+    if (pthread_create(&worker, NULL,
+                       WorkerMain, reinterpret_cast<void*>(this)))
+      break;
+    workers_.push_back(worker);
+  }
+
+  if (workers_.empty() ||
+      pthread_create(&thread_, NULL,
+                     ThreadMain, reinterpret_cast<void*>(this))) {
+    pthread_mutex_lock(&queue_mutex_);
+    stopping_ = true;
+    pthread_cond_broadcast(&queue_cond_);
+    pthread_mutex_unlock(&queue_mutex_);
+    for (size_t i = 0; i < workers_.size(); ++i)
+      pthread_join(workers_[i], NULL);
+    workers_.clear();
     return false;
+  }
 
   started_ = true;
   return true;
@@ -126,6 +178,25 @@ CrashGenerationServer::Stop()
   void* dummy;
   pthread_join(thread_, &dummy);
 
+  // Let the dumps being written finish, and release the clients still
+  // waiting without dumps.
+  pthread_mutex_lock(&queue_mutex_);
+  stopping_ = true;
+  pthread_cond_broadcast(&queue_cond_);
+  pthread_mutex_unlock(&queue_mutex_);
+  for (size_t i = 0; i < workers_.size(); ++i)
+    pthread_join(workers_[i], &dummy);
+  workers_.clear();
+
+  pthread_mutex_lock(&queue_mutex_);
+  for (std::list<DumpRequest*>::iterator iter = queued_.begin();
+       iter != queued_.end(); ++iter) {
+    ReleaseClient(*iter);
+    delete *iter;
+  }
+  queued_.clear();
+  pthread_mutex_unlock(&queue_mutex_);
+
   close(control_pipe_in_);
   close(control_pipe_out_);
 
@@ -171,8 +242,9 @@ CrashGenerationServer::Run()
   pollfds[1].events = POLLIN;
 
   while (true) {
-    // infinite timeout
-    int nevents = poll(pollfds, sizeof(pollfds)/sizeof(pollfds[0]), -1);
+    // Wake up in time to release the next client that times out, if any.
+    const int timeout = ReleaseExpiredClients();
+    int nevents = poll(pollfds, sizeof(pollfds)/sizeof(pollfds[0]), timeout);
     if (-1 == nevents) {
       if (EINTR == errno) {
         continue;
@@ -263,28 +335,137 @@ CrashGenerationServer::ClientEvent(short revents)
     return true;
   }
 
+  // Hand the client to a worker thread, so that other clients can be
+  // heard from while its minidump is written.
+  pthread_mutex_lock(&queue_mutex_);
+  if (queued_.size() >= max_queued_dumps_) {
+    pthread_mutex_unlock(&queue_mutex_);
+    close(signal_fd);
+    return true;
+  }
+  DumpRequest* request = new DumpRequest;
+  request->crashing_pid = crashing_pid;
+  request->signal_fd = signal_fd;
+  request->deadline_ms =
+      dump_timeout_ms_ > 0 ? MonotonicMs() + dump_timeout_ms_ : 0;
+  memcpy(request->crash_context, crash_context, kCrashContextSize);
+  queued_.push_back(request);
+  pthread_cond_signal(&queue_cond_);
+  pthread_mutex_unlock(&queue_mutex_);
+
+  return true;
+}
+
+void
+CrashGenerationServer::RunWorker()
+{
+  pthread_mutex_lock(&queue_mutex_);
+  while (true) {
+    while (queued_.empty() && !stopping_)
+      pthread_cond_wait(&queue_cond_, &queue_mutex_);
+    if (stopping_)
+      break;
+
+    DumpRequest* request = queued_.front();
+    queued_.pop_front();
+    active_.push_back(request);
+    pthread_mutex_unlock(&queue_mutex_);
+
+    WriteDump(request);
+
+    pthread_mutex_lock(&queue_mutex_);
+    active_.remove(request);
+    ReleaseClient(request);
+    delete request;
+  }
+  pthread_mutex_unlock(&queue_mutex_);
+}
+
+void
+CrashGenerationServer::WriteDump(DumpRequest* request)
+{
+  ClientInfo info(request->crashing_pid, this);
   string minidump_filename;
+  if (dump_output_callback_) {
+    int fd = dump_output_callback_(dump_output_context_, &info);
+    if (fd == -1)
+      return;
+    bool written = google_breakpad::WriteMinidump(
+        fd, request->crashing_pid, request->crash_context,
+        sizeof(request->crash_context), kDumperHelperThreads);
+    close(fd);
+    if (written && dump_callback_)
+      dump_callback_(dump_context_, &info, &minidump_filename);
+    return;
+  }
+
   if (!MakeMinidumpFilename(minidump_filename))
-    return true;
+    return;
 
   if (!google_breakpad::WriteMinidump(minidump_filename.c_str(),
-                                      crashing_pid, crash_context,
-                                      kCrashContextSize)) {
-    close(signal_fd);
-    return true;
+                                      request->crashing_pid,
+                                      request->crash_context,
+                                      sizeof(request->crash_context),
+                                      kDumperHelperThreads)) {
+    return;
   }
 
-  if (dump_callback_) {
-    ClientInfo info(crashing_pid, this);
-
+  if (dump_callback_)
     dump_callback_(dump_context_, &info, &minidump_filename);
-  }
+}
 
+// static
+void
+CrashGenerationServer::ReleaseClient(DumpRequest* request)
+{
   // Send the done signal to the process: it can exit now.
   // (Closing this will make the child's sys_read unblock and return 0.)
-  close(signal_fd);
+  if (request->signal_fd != -1) {
+    close(request->signal_fd);
+    request->signal_fd = -1;
+  }
+}
 
-  return true;
+int
+CrashGenerationServer::ReleaseExpiredClients()
+{
+  if (dump_timeout_ms_ <= 0)
+    return -1;
+
+  pthread_mutex_lock(&queue_mutex_);
+  const int64_t now = MonotonicMs();
+  int64_t next_deadline = 0;
+
+  std::list<DumpRequest*>::iterator iter = queued_.begin();
+  while (iter != queued_.end()) {
+    DumpRequest* request = *iter;
+    if (request->deadline_ms <= now) {
+      ReleaseClient(request);
+      delete request;
+      iter = queued_.erase(iter);
+      continue;
+    }
+    if (!next_deadline || request->deadline_ms < next_deadline)
+      next_deadline = request->deadline_ms;
+    ++iter;
+  }
+
+  // A dump that has started is left to finish, but its client need not
+  // wait for it.
+  for (iter = active_.begin(); iter != active_.end(); ++iter) {
+    DumpRequest* request = *iter;
+    if (request->signal_fd == -1)
+      continue;
+    if (request->deadline_ms <= now) {
+      ReleaseClient(request);
+      continue;
+    }
+    if (!next_deadline || request->deadline_ms < next_deadline)
+      next_deadline = request->deadline_ms;
+  }
+  pthread_mutex_unlock(&queue_mutex_);
+
+  return next_deadline ? static_cast<int>(next_deadline - now) : -1;
 }
 
 bool
@@ -333,4 +514,12 @@ CrashGenerationServer::ThreadMain(void* arg)
   return NULL;
 }
 
+// static
+void*
+CrashGenerationServer::WorkerMain(void* arg)
+{
+  reinterpret_cast<CrashGenerationServer*>(arg)->RunWorker();
+  return NULL;
+}
+
 }  // namespace google_breakpad
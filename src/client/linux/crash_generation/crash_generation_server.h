@@ -30,8 +30,13 @@
 #define CLIENT_LINUX_CRASH_GENERATION_CRASH_GENERATION_SERVER_H_
 
 #include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
 
+#include <list>
 #include <string>
+#include <vector>
 
 #include "common/using_std_string.h"
 
@@ -42,8 +47,9 @@ class ClientInfo;
 class CrashGenerationServer {
 public:
   // WARNING: callbacks may be invoked on a different thread
-  // than that which creates the CrashGenerationServer.  They must
-  // be thread safe.
+  // than that which creates the CrashGenerationServer, and dump request
+  // callbacks for different clients may run at the same time on
+  // different threads.  They must be thread safe.
   typedef void (*OnClientDumpRequestCallback)(void* context,
                                               const ClientInfo* client_info,
                                               const string* file_path);
@@ -51,6 +57,12 @@ public:
   typedef void (*OnClientExitingCallback)(void* context,
                                           const ClientInfo* client_info);
 
+  // Returns a descriptor to write the minidump of |client_info| to, such
+  // as a pipe or a socket to an uploader, or -1 to skip the dump.  The
+  // server closes the descriptor once the minidump has been written.
+  typedef int (*OpenDumpOutputCallback)(void* context,
+                                        const ClientInfo* client_info);
+
   // Create an instance with the given parameters.
   //
   // Parameter listen_fd: The server fd created by CreateReportChannel().
@@ -74,6 +86,39 @@ public:
 
   ~CrashGenerationServer();
 
+  // Set the number of clients whose minidumps may be written at the same
+  // time, each on its own thread.  The default is 1.  Must be called
+  // before Start().
+  void set_max_concurrent_dumps(int max_concurrent_dumps) {
+    max_concurrent_dumps_ = max_concurrent_dumps;
+  }
+
+  // Set the number of clients that may wait for a free thread.  A client
+  // that crashes while the queue is full is released without a dump.  The
+  // default is 64.  Must be called before Start().
+  void set_max_queued_dumps(size_t max_queued_dumps) {
+    max_queued_dumps_ = max_queued_dumps;
+  }
+
+  // Set how long, in milliseconds, a client may be kept waiting for its
+  // minidump, counting from its report.  After that the client is
+  // released; if its dump has not started it is dropped, and if it has
+  // started it may fail as the client exits.  0, the default, means no
+  // limit.  Must be called before Start().
+  void set_dump_timeout_ms(int dump_timeout_ms) {
+    dump_timeout_ms_ = dump_timeout_ms;
+  }
+
+  // Write minidumps to the descriptors that |callback| returns instead of
+  // to files in the dump path, so that they can be streamed straight to
+  // an uploader.  The dump request callback is then passed an empty path.
+  // Must be called before Start().
+  void set_dump_output_callback(OpenDumpOutputCallback callback,
+                                void* context) {
+    dump_output_callback_ = callback;
+    dump_output_context_ = context;
+  }
+
   // Perform initialization steps needed to start listening to clients.
   //
   // Return true if initialization is successful; false otherwise.
@@ -89,9 +134,14 @@ public:
   static bool CreateReportChannel(int* server_fd, int* client_fd);
 
 private:
+  struct DumpRequest;
+
   // Run the server's event loop
   void Run();
 
+  // Run a worker thread's loop, writing the minidumps of queued clients
+  void RunWorker();
+
   // Invoked when an child process (client) event occurs
   // Returning true => "keep running", false => "exit loop"
   bool ClientEvent(short revents);
@@ -103,9 +153,24 @@ private:
   // Return a unique filename at which a minidump can be written
   bool MakeMinidumpFilename(string& outFilename);
 
+  // Write the minidump for |request| and report it to |dump_callback_|
+  void WriteDump(DumpRequest* request);
+
+  // Let the client of |request| continue, if it has not already been.
+  // |queue_mutex_| must be held.
+  static void ReleaseClient(DumpRequest* request);
+
+  // Release the clients that have waited longer than |dump_timeout_ms_|,
+  // dropping those whose dumps have not started.  Return the number of
+  // milliseconds until the next one times out, or -1 if none will.
+  int ReleaseExpiredClients();
+
   // Trampoline to |Run()|
   static void* ThreadMain(void* arg);
 
+  // Trampoline to |RunWorker()|
+  static void* WorkerMain(void* arg);
+
   int server_fd_;
 
   OnClientDumpRequestCallback dump_callback_;
@@ -114,6 +179,9 @@ private:
   OnClientExitingCallback exit_callback_;
   void* exit_context_;
 
+  OpenDumpOutputCallback dump_output_callback_;
+  void* dump_output_context_;
+
   bool generate_dumps_;
 
   string dump_dir_;
@@ -124,6 +192,22 @@ private:
   int control_pipe_in_;
   int control_pipe_out_;
 
+  int max_concurrent_dumps_;
+  size_t max_queued_dumps_;
+  int dump_timeout_ms_;
+
+  std::vector<pthread_t> workers_;
+
+  // Guards the members below.
+  pthread_mutex_t queue_mutex_;
+  // Signalled when a client is queued or the workers should stop.
+  pthread_cond_t queue_cond_;
+  // Clients waiting for a worker.
+  std::list<DumpRequest*> queued_;
+  // Clients whose dumps are being written.
+  std::list<DumpRequest*> active_;
+  bool stopping_;
+
   // disable these
   CrashGenerationServer(const CrashGenerationServer&);
   CrashGenerationServer& operator=(const CrashGenerationServer&);
@@ -0,0 +1,644 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// dump_latency_benchmark.cc: Time how long the Linux client takes to write
+// a minidump of a process of a chosen shape, by each way it can write one.
+//
+// The benchmark forks a victim process with a number of threads, each
+// blocked at the bottom of a call stack of a chosen depth, extra mappings
+// of the benchmark binary standing in for shared libraries, and blocks of
+// application memory to include in the dump.  It then dumps the victim
+// repeatedly in each mode:
+//
+//   in-process  ExceptionHandler::WriteMinidump, called by the victim
+//   for-child   ExceptionHandler::WriteMinidumpForChild, as a crash
+//               generation server calls it
+//   pid2md      WriteMinidump of a live process, as pid2md calls it
+//   pid2md-l    the same, stopping the victim only while the registers
+//               and stack tops of its threads are read (pid2md -l)
+//   core2md     WriteMinidump from a core file, as core2md calls it
+//
+// For each mode it reports percentiles of the time taken, the system calls
+// made by the process writing the dump, that process's peak RSS and the
+// size of the dump.  System calls are counted in one extra run under
+// ptrace, which isn't timed.  The in-process dumper ptraces the victim
+// itself, so it can't be traced and its system calls aren't counted.  Other
+// dumpers are forked from the benchmark, so their peak RSS includes the
+// benchmark's own.  The core2md victim comes from CrashGenerator, which
+// only varies the thread count, and needs /proc/sys/kernel/core_pattern to
+// be "core".
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/ptrace.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "client/linux/handler/exception_handler.h"
+#include "client/linux/handler/minidump_descriptor.h"
+#include "client/linux/minidump_writer/linux_core_dumper.h"
+#include "client/linux/minidump_writer/minidump_writer.h"
+#include "common/linux/eintr_wrapper.h"
+#include "common/linux/tests/crash_generator.h"
+#include "common/using_std_string.h"
+
+#ifndef PR_SET_PTRACER
+#define PR_SET_PTRACER 0x59616d61
+#endif
+
+#ifndef PR_SET_PTRACER_ANY
+#define PR_SET_PTRACER_ANY ((unsigned long)-1)
+#endif
+
+namespace {
+
+using google_breakpad::AppMemory;
+using google_breakpad::AppMemoryList;
+using google_breakpad::CrashGenerator;
+using google_breakpad::ExceptionHandler;
+using google_breakpad::LinuxCoreDumper;
+using google_breakpad::MappingList;
+using google_breakpad::MinidumpDescriptor;
+using std::vector;
+
+// The shape of a victim process.
+struct VictimShape {
+  int threads = 4;               // including the main thread
+  int mappings = 64;             // extra mappings of the benchmark binary
+  int stack_depth = 32;          // frames on each thread's stack
+  int app_memory = 0;            // application memory blocks
+  size_t app_memory_size = 4096; // bytes per block
+};
+
+// Bytes of each frame on the victim's stacks.
+const size_t kFrameSize = 256;
+
+enum Mode {
+  kInProcess,
+  kForChild,
+  kPid2md,
+  kPid2mdLowPause,
+  kCore2md,
+  kNumModes
+};
+
+const char* const kModeNames[kNumModes] = {
+  "in-process", "for-child", "pid2md", "pid2md-l", "core2md"
+};
+
+// What one dump reports back to the benchmark.  A zero time means the
+// dump failed.
+struct RunResult {
+  uint64_t nanoseconds;
+  uint64_t dump_bytes;
+};
+
+// Everything a dumper needs to know to dump a victim.
+struct DumpTarget {
+  Mode mode;
+  pid_t victim;
+  const AppMemoryList* app_memory;
+  string dump_dir;
+  string core_path;
+  string procfs_dir;
+};
+
+// The results of all the runs of one mode.
+struct ModeStats {
+  vector<uint64_t> nanoseconds;
+  uint64_t dump_bytes = 0;
+  long syscalls = -1;
+  long peak_rss_kb = 0;
+};
+
+uint64_t NowNanoseconds() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+uint64_t FileSize(const char* path) {
+  struct stat st;
+  return stat(path, &st) == 0 ? st.st_size : 0;
+}
+
+bool ReadFully(int fd, void* buffer, size_t length) {
+  char* p = static_cast<char*>(buffer);
+  while (length > 0) {
+    ssize_t n = HANDLE_EINTR(read(fd, p, length));
+    if (n <= 0)
+      return false;
+    p += n;
+    length -= n;
+  }
+  return true;
+}
+
+bool WriteFully(int fd, const void* buffer, size_t length) {
+  const char* p = static_cast<const char*>(buffer);
+  while (length > 0) {
+    ssize_t n = HANDLE_EINTR(write(fd, p, length));
+    if (n <= 0)
+      return false;
+    p += n;
+    length -= n;
+  }
+  return true;
+}
+
+// Map the first page of the benchmark binary COUNT times, with a page of
+// inaccessible memory between each, so that the dumper sees COUNT modules
+// and reads a build ID for each.
+bool MapModules(int count) {
+  if (count == 0)
+    return true;
+  int fd = open("/proc/self/exe", O_RDONLY);
+  if (fd < 0)
+    return false;
+  const size_t page_size = getpagesize();
+  char* base = static_cast<char*>(mmap(NULL, 2 * count * page_size,
+                                       PROT_NONE,
+                                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  bool ok = base != MAP_FAILED;
+  for (int i = 0; ok && i < count; ++i) {
+    ok = mmap(base + 2 * i * page_size, page_size, PROT_READ,
+              MAP_PRIVATE | MAP_FIXED, fd, 0) != MAP_FAILED;
+  }
+  close(fd);
+  return ok;
+}
+
+// Call AT_BOTTOM(ARG) from DEPTH frames of kFrameSize bytes down.
+__attribute__((noinline))
+void Recurse(int depth, void (*at_bottom)(void*), void* arg) {
+  volatile char frame[kFrameSize];
+  frame[0] = static_cast<char>(depth);
+  if (depth > 0)
+    Recurse(depth - 1, at_bottom, arg);
+  else
+    at_bottom(arg);
+  frame[kFrameSize - 1] = frame[0];
+}
+
+// The state shared by a victim's threads.
+struct Victim {
+  const VictimShape* shape;
+  const AppMemoryList* app_memory;
+  bool in_process;
+  int runs;
+  string dump_dir;
+  int ready_fd;   // the threads' end of a pipe to the victim's main thread
+  int report_fd;  // the victim's end of a pipe to the benchmark
+};
+
+void BlockForever(void*) {
+  for (;;)
+    pause();
+}
+
+void ThreadBottom(void* arg) {
+  Victim* victim = static_cast<Victim*>(arg);
+  char ready = 0;
+  WriteFully(victim->ready_fd, &ready, 1);
+  BlockForever(NULL);
+}
+
+void* ThreadEntry(void* arg) {
+  Victim* victim = static_cast<Victim*>(arg);
+  Recurse(victim->shape->stack_depth, ThreadBottom, victim);
+  return NULL;
+}
+
+bool InProcessCallback(const MinidumpDescriptor& descriptor, void* context,
+                       bool succeeded) {
+  *static_cast<uint64_t*>(context) =
+      succeeded ? FileSize(descriptor.path()) : 0;
+  unlink(descriptor.path());
+  return succeeded;
+}
+
+// Write minidumps of the victim from within it, and report each one and
+// then the peak RSS of the processes that wrote them.
+void DumpInProcess(const Victim* victim) {
+  uint64_t dump_bytes = 0;
+  ExceptionHandler handler(MinidumpDescriptor(victim->dump_dir), NULL,
+                           InProcessCallback, &dump_bytes, false, -1);
+  for (const AppMemory& memory : *victim->app_memory)
+    handler.RegisterAppMemory(memory.ptr, memory.length);
+  for (int i = 0; i < victim->runs; ++i) {
+    uint64_t start = NowNanoseconds();
+    bool ok = handler.WriteMinidump();
+    RunResult result = { ok ? NowNanoseconds() - start : 0, dump_bytes };
+    if (!WriteFully(victim->report_fd, &result, sizeof(result)))
+      return;
+  }
+  struct rusage usage;
+  getrusage(RUSAGE_CHILDREN, &usage);
+  uint64_t peak_rss_kb = usage.ru_maxrss;
+  WriteFully(victim->report_fd, &peak_rss_kb, sizeof(peak_rss_kb));
+}
+
+void MainThreadBottom(void* arg) {
+  Victim* victim = static_cast<Victim*>(arg);
+  if (victim->in_process) {
+    DumpInProcess(victim);
+    _exit(0);
+  }
+  char ready = 0;
+  WriteFully(victim->report_fd, &ready, 1);
+  BlockForever(NULL);
+}
+
+// The body of a victim process.  Take on the victim's shape, then either
+// dump it in-process, reporting on REPORT_FD, or report that it's ready
+// and wait to be killed.
+void RunVictim(Victim* victim) {
+  prctl(PR_SET_PTRACER, PR_SET_PTRACER_ANY, 0, 0, 0);
+  int ready[2];
+  if (!MapModules(victim->shape->mappings) || pipe(ready) != 0)
+    _exit(1);
+  victim->ready_fd = ready[1];
+  for (int i = 1; i < victim->shape->threads; ++i) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, ThreadEntry, victim) != 0)
+      _exit(1);
+  }
+  for (int i = 1; i < victim->shape->threads; ++i) {
+    char byte;
+    if (!ReadFully(ready[0], &byte, 1))
+      _exit(1);
+  }
+  Recurse(victim->shape->stack_depth, MainThreadBottom, victim);
+}
+
+bool ForChildCallback(const MinidumpDescriptor& descriptor, void* context,
+                      bool succeeded) {
+  *static_cast<uint64_t*>(context) = FileSize(descriptor.path());
+  unlink(descriptor.path());
+  return succeeded;
+}
+
+// Write one dump of TARGET, and return how long it took.
+RunResult WriteDump(const DumpTarget& target) {
+  string path = target.dump_dir + "/" + kModeNames[target.mode] + ".dmp";
+  uint64_t dump_bytes = 0;
+  uint64_t start = NowNanoseconds();
+  bool ok = false;
+  switch (target.mode) {
+    case kForChild:
+      ok = ExceptionHandler::WriteMinidumpForChild(
+          target.victim, target.victim, target.dump_dir, ForChildCallback,
+          &dump_bytes);
+      break;
+    case kPid2md:
+    case kPid2mdLowPause:
+      ok = google_breakpad::WriteMinidump(path.c_str(), target.victim,
+                                          target.victim, *target.app_memory,
+                                          target.mode == kPid2mdLowPause);
+      break;
+    case kCore2md: {
+      LinuxCoreDumper dumper(0, target.core_path.c_str(),
+                             target.procfs_dir.c_str());
+      ok = google_breakpad::WriteMinidump(path.c_str(), MappingList(),
+                                          AppMemoryList(), &dumper);
+      break;
+    }
+    default:
+      break;
+  }
+  RunResult result = { ok ? NowNanoseconds() - start : 0, dump_bytes };
+  if (target.mode != kForChild) {
+    result.dump_bytes = FileSize(path.c_str());
+    unlink(path.c_str());
+  }
+  return result;
+}
+
+// Wait for the dumper CHILD to exit, and store its resource usage in USAGE.
+// If SYSCALLS is non-NULL, CHILD has stopped itself to be traced: count
+// its system calls there.
+bool WaitForDumper(pid_t child, long* syscalls, struct rusage* usage) {
+  int status;
+  if (syscalls) {
+    if (HANDLE_EINTR(waitpid(child, &status, 0)) != child ||
+        !WIFSTOPPED(status) ||
+        ptrace(PTRACE_SETOPTIONS, child, NULL,
+               reinterpret_cast<void*>(PTRACE_O_TRACESYSGOOD)) == -1) {
+      kill(child, SIGKILL);
+      HANDLE_EINTR(wait4(child, &status, 0, usage));
+      return false;
+    }
+    long stops = 0;
+    intptr_t signal = 0;
+    while (ptrace(PTRACE_SYSCALL, child, NULL,
+                  reinterpret_cast<void*>(signal)) != -1 &&
+           HANDLE_EINTR(wait4(child, &status, 0, usage)) == child &&
+           WIFSTOPPED(status)) {
+      signal = 0;
+      if (WSTOPSIG(status) == (SIGTRAP | 0x80))
+        ++stops;
+      else
+        signal = WSTOPSIG(status);
+    }
+    // Each system call stops the child on entry and on exit, except the
+    // exit_group that ends it.
+    *syscalls = (stops + 1) / 2;
+  } else if (HANDLE_EINTR(wait4(child, &status, 0, usage)) != child) {
+    return false;
+  }
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Fork a process to write one dump of TARGET, and store what it reports
+// in RESULT and its peak RSS in PEAK_RSS_KB.  If SYSCALLS is non-NULL,
+// trace the process and count its system calls there.
+bool RunDumper(const DumpTarget& target, long* syscalls, RunResult* result,
+               long* peak_rss_kb) {
+  int fds[2];
+  if (pipe(fds) != 0)
+    return false;
+  pid_t child = fork();
+  if (child == 0) {
+    close(fds[0]);
+    if (syscalls) {
+      ptrace(PTRACE_TRACEME, 0, NULL, NULL);
+      raise(SIGSTOP);
+    }
+    RunResult run = WriteDump(target);
+    _exit(WriteFully(fds[1], &run, sizeof(run)) && run.nanoseconds ? 0 : 1);
+  }
+  close(fds[1]);
+  struct rusage usage;
+  bool ok = child > 0 && WaitForDumper(child, syscalls, &usage) &&
+      ReadFully(fds[0], result, sizeof(*result));
+  close(fds[0]);
+  if (ok)
+    *peak_rss_kb = std::max(*peak_rss_kb, usage.ru_maxrss);
+  return ok;
+}
+
+// Fork a victim of SHAPE, returning its process ID, and its end of a pipe
+// to the benchmark in REPORT_FD.
+pid_t SpawnVictim(const VictimShape& shape, const AppMemoryList& app_memory,
+                  bool in_process, int runs, const string& dump_dir,
+                  int* report_fd) {
+  int fds[2];
+  if (pipe(fds) != 0)
+    return -1;
+  pid_t child = fork();
+  if (child == 0) {
+    close(fds[0]);
+    Victim victim = { &shape, &app_memory, in_process, runs, dump_dir, -1,
+                      fds[1] };
+    RunVictim(&victim);
+    _exit(1);
+  }
+  close(fds[1]);
+  *report_fd = fds[0];
+  return child;
+}
+
+void KillVictim(pid_t victim) {
+  kill(victim, SIGKILL);
+  HANDLE_EINTR(waitpid(victim, NULL, 0));
+}
+
+// Dump a victim of SHAPE RUNS times by MODE, and fill in STATS.
+bool RunMode(Mode mode, const VictimShape& shape,
+             const AppMemoryList& app_memory, int runs,
+             const string& dump_dir, ModeStats* stats) {
+  DumpTarget target = { mode, 0, &app_memory, dump_dir, "", "" };
+  CrashGenerator crash_generator;
+  int report_fd = -1;
+  if (mode == kCore2md) {
+    if (!crash_generator.HasDefaultCorePattern() ||
+        !crash_generator.HasResourceLimitsAmenableToCrashCollection()) {
+      fprintf(stderr, "core2md: core files are not written to the current "
+              "directory; skipping\n");
+      return false;
+    }
+    pid_t crashed;
+    if (!crash_generator.CreateChildCrash(shape.threads, 0, SIGABRT,
+                                          &crashed)) {
+      return false;
+    }
+    target.core_path = crash_generator.GetCoreFilePath();
+    target.procfs_dir = crash_generator.GetDirectoryOfProcFilesCopy();
+  } else {
+    target.victim = SpawnVictim(shape, app_memory, mode == kInProcess, runs,
+                                dump_dir, &report_fd);
+    if (target.victim < 0)
+      return false;
+  }
+
+  bool ok = true;
+  if (mode == kInProcess) {
+    for (int i = 0; ok && i < runs; ++i) {
+      RunResult result;
+      ok = ReadFully(report_fd, &result, sizeof(result)) &&
+          result.nanoseconds;
+      if (ok) {
+        stats->nanoseconds.push_back(result.nanoseconds);
+        stats->dump_bytes = result.dump_bytes;
+      }
+    }
+    uint64_t peak_rss_kb = 0;
+    ok = ok && ReadFully(report_fd, &peak_rss_kb, sizeof(peak_rss_kb));
+    stats->peak_rss_kb = peak_rss_kb;
+  } else {
+    char ready;
+    ok = mode == kCore2md || ReadFully(report_fd, &ready, 1);
+    for (int i = 0; ok && i < runs; ++i) {
+      RunResult result;
+      ok = RunDumper(target, NULL, &result, &stats->peak_rss_kb);
+      if (ok) {
+        stats->nanoseconds.push_back(result.nanoseconds);
+        stats->dump_bytes = result.dump_bytes;
+      }
+    }
+    RunResult result;
+    ok = ok && RunDumper(target, &stats->syscalls, &result,
+                         &stats->peak_rss_kb);
+  }
+
+  if (report_fd >= 0)
+    close(report_fd);
+  if (target.victim > 0)
+    KillVictim(target.victim);
+  return ok;
+}
+
+// Return the FRACTION percentile of SORTED, in milliseconds.
+double Percentile(const vector<uint64_t>& sorted, double fraction) {
+  size_t rank = static_cast<size_t>(ceil(fraction * sorted.size()));
+  return sorted[std::max<size_t>(rank, 1) - 1] / 1e6;
+}
+
+void PrintMode(Mode mode, ModeStats* stats) {
+  vector<uint64_t>& sorted = stats->nanoseconds;
+  std::sort(sorted.begin(), sorted.end());
+  printf("%-11s %5zu %9.2f %9.2f %9.2f %9.2f", kModeNames[mode],
+         sorted.size(), Percentile(sorted, 0.5), Percentile(sorted, 0.9),
+         Percentile(sorted, 0.99), sorted.back() / 1e6);
+  if (stats->syscalls < 0)
+    printf(" %9s", "n/a");
+  else
+    printf(" %9ld", stats->syscalls);
+  printf(" %9.1f %9.1f\n", stats->peak_rss_kb / 1024.0,
+         stats->dump_bytes / 1024.0);
+}
+
+void Usage(const char* program) {
+  fprintf(stderr,
+          "Usage: %s [OPTION]... [mode]...\n"
+          "Time writing minidumps of a synthetic process in each |mode|:\n"
+          "in-process, for-child, pid2md, pid2md-l or core2md (default: "
+          "all).\n\n"
+          "Options:\n"
+          "  -t <N>      Threads in the process, including the main thread\n"
+          "  -m <N>      Extra mappings of this binary in the process\n"
+          "  -d <N>      Frames of %zu bytes on each thread's stack\n"
+          "  -a <N>      Blocks of application memory to include\n"
+          "  -s <N>      Bytes per block of application memory\n"
+          "  -n <N>      Dumps to write in each mode\n",
+          program, kFrameSize);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  VictimShape shape;
+  int runs = 20;
+  int opt;
+  while ((opt = getopt(argc, argv, "t:m:d:a:s:n:h")) != -1) {
+    switch (opt) {
+      case 't':
+        shape.threads = atoi(optarg);
+        break;
+      case 'm':
+        shape.mappings = atoi(optarg);
+        break;
+      case 'd':
+        shape.stack_depth = atoi(optarg);
+        break;
+      case 'a':
+        shape.app_memory = atoi(optarg);
+        break;
+      case 's':
+        shape.app_memory_size = strtoul(optarg, NULL, 10);
+        break;
+      case 'n':
+        runs = atoi(optarg);
+        break;
+      default:
+        Usage(argv[0]);
+        return 1;
+    }
+  }
+  bool modes[kNumModes] = {};
+  for (int i = optind; i < argc; ++i) {
+    int mode = 0;
+    while (mode < kNumModes && strcmp(argv[i], kModeNames[mode]) != 0)
+      ++mode;
+    if (mode == kNumModes) {
+      Usage(argv[0]);
+      return 1;
+    }
+    modes[mode] = true;
+  }
+  if (optind == argc)
+    std::fill(modes, modes + kNumModes, true);
+  if (shape.threads < 1 || shape.mappings < 0 || shape.stack_depth < 0 ||
+      shape.app_memory < 0 || shape.app_memory_size < 1 || runs < 1) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  const char* tmpdir = getenv("TMPDIR");
+  string dump_dir = string(tmpdir ? tmpdir : "/tmp") +
+      "/dump_latency_benchmark.XXXXXX";
+  if (!mkdtemp(&dump_dir[0])) {
+    perror("mkdtemp");
+    return 1;
+  }
+
+  // Allocate the application memory before forking victims, so that it's
+  // at the same addresses in the victims as here.
+  AppMemoryList app_memory;
+  for (int i = 0; i < shape.app_memory; ++i) {
+    AppMemory memory;
+    memory.ptr = malloc(shape.app_memory_size);
+    memory.length = shape.app_memory_size;
+    memset(memory.ptr, i, memory.length);
+    app_memory.push_back(memory);
+  }
+
+  printf("victim: %d threads, %d mappings, %d frames of %zu bytes, %d "
+         "application memory blocks of %zu bytes\n\n", shape.threads,
+         shape.mappings, shape.stack_depth, kFrameSize, shape.app_memory,
+         shape.app_memory_size);
+  printf("%-11s %5s %9s %9s %9s %9s %9s %9s %9s\n", "mode", "runs",
+         "p50 ms", "p90 ms", "p99 ms", "max ms", "syscalls", "RSS MB",
+         "dump KB");
+  int status = 0;
+  for (int mode = 0; mode < kNumModes; ++mode) {
+    if (!modes[mode])
+      continue;
+    ModeStats stats;
+    if (RunMode(static_cast<Mode>(mode), shape, app_memory, runs, dump_dir,
+                &stats)) {
+      PrintMode(static_cast<Mode>(mode), &stats);
+    } else {
+      printf("%-11s %5s\n", kModeNames[mode], "failed");
+      status = 1;
+    }
+  }
+
+  for (const AppMemory& memory : app_memory)
+    free(memory.ptr);
+  rmdir(dump_dir.c_str());
+  return status;
+}
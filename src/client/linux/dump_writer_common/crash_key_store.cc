@@ -0,0 +1,202 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "client/linux/dump_writer_common/crash_key_store.h"
+
+#include <sched.h>
+#include <string.h>
+
+#include "common/linux/linux_libc_support.h"
+
+namespace google_breakpad {
+
+namespace {
+
+// Identifies a CrashKeyStore read from another process: "BPCK".
+const uint32_t kCrashKeyStoreMagic = 0x4b435042;
+
+// How many times Snapshot() tries to copy a value that writers keep
+// changing.
+const int kSnapshotAttempts = 4;
+
+static_assert((CrashKeyStore::kMaxKeys & (CrashKeyStore::kMaxKeys - 1)) == 0,
+              "kMaxKeys must be a power of two");
+
+// FNV-1a over the part of |key| that a slot keeps.
+uint32_t HashKey(const char* key) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < CrashKeyStore::kKeySize - 1 && key[i]; ++i) {
+    hash ^= static_cast<unsigned char>(key[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+}  // namespace
+
+CrashKeyStore::CrashKeyStore()
+    : magic_(kCrashKeyStoreMagic),
+      max_keys_(kMaxKeys),
+      key_size_(kKeySize),
+      value_size_(kValueSize) {
+  for (size_t i = 0; i < kMaxKeys; ++i) {
+    Slot* slot = &slots_[i];
+    slot->state.store(kSlotFree, std::memory_order_relaxed);
+    slot->sequence.store(0, std::memory_order_relaxed);
+    slot->current.store(0, std::memory_order_relaxed);
+    slot->hash = 0;
+    my_memset(slot->key, 0, sizeof(slot->key));
+    my_memset(slot->values, 0, sizeof(slot->values));
+  }
+}
+
+size_t CrashKeyStore::AddKey(const char* key) {
+  if (!key || !key[0])
+    return kMaxKeys;
+  return FindKey(key, true);
+}
+
+void CrashKeyStore::SetValueAtIndex(size_t index, const char* value) {
+  if (index >= kMaxKeys)
+    return;
+  Slot* slot = &slots_[index];
+  if (slot->state.load(std::memory_order_acquire) != kSlotNamed)
+    return;
+
+  // Writers of the same key take turns; an odd count means one is busy.
+  uint32_t sequence = slot->sequence.load(std::memory_order_relaxed);
+  for (;;) {
+    if (sequence & 1) {
+      sched_yield();
+      sequence = slot->sequence.load(std::memory_order_relaxed);
+    } else if (slot->sequence.compare_exchange_weak(
+                   sequence, sequence + 1, std::memory_order_acquire,
+                   std::memory_order_relaxed)) {
+      break;
+    }
+  }
+
+  const uint32_t next = slot->current.load(std::memory_order_relaxed) ^ 1;
+  my_strlcpy(slot->values[next], value ? value : "", kValueSize);
+  slot->current.store(next, std::memory_order_release);
+  slot->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool CrashKeyStore::SetKeyValue(const char* key, const char* value) {
+  if (!value) {
+    RemoveKey(key);
+    return true;
+  }
+  const size_t index = AddKey(key);
+  if (index == kMaxKeys)
+    return false;
+  SetValueAtIndex(index, value);
+  return true;
+}
+
+void CrashKeyStore::RemoveKey(const char* key) {
+  if (!key || !key[0])
+    return;
+  SetValueAtIndex(FindKey(key, false), "");
+}
+
+bool CrashKeyStore::IsValid() const {
+  return magic_ == kCrashKeyStoreMagic && max_keys_ == kMaxKeys &&
+         key_size_ == kKeySize && value_size_ == kValueSize;
+}
+
+size_t CrashKeyStore::Snapshot(Entry* entries) const {
+  size_t count = 0;
+  for (size_t i = 0; i < kMaxKeys; ++i) {
+    const Slot* slot = &slots_[i];
+    if (slot->state.load(std::memory_order_acquire) != kSlotNamed)
+      continue;
+
+    Entry* entry = &entries[count];
+    bool consistent = false;
+    for (int attempt = 0; attempt < kSnapshotAttempts && !consistent;
+         ++attempt) {
+      const uint32_t before = slot->sequence.load(std::memory_order_acquire);
+      const uint32_t current =
+          slot->current.load(std::memory_order_acquire) & 1;
+      memcpy(entry->value, slot->values[current], kValueSize);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      const uint32_t after = slot->sequence.load(std::memory_order_relaxed);
+      // The buffer that was current is only rewritten by the second update
+      // to start after it was current.
+      consistent = after - before <= 1;
+    }
+    entry->value[kValueSize - 1] = '\0';
+    if (!consistent || !entry->value[0])
+      continue;
+
+    memcpy(entry->key, slot->key, kKeySize);
+    entry->key[kKeySize - 1] = '\0';
+    ++count;
+  }
+  return count;
+}
+
+size_t CrashKeyStore::FindKey(const char* key, bool add) {
+  const uint32_t hash = HashKey(key);
+  for (size_t probe = 0; probe < kMaxKeys; ++probe) {
+    const size_t index = (hash + probe) & (kMaxKeys - 1);
+    Slot* slot = &slots_[index];
+    for (;;) {
+      uint32_t state = slot->state.load(std::memory_order_acquire);
+      if (state == kSlotFree) {
+        if (!add)
+          return kMaxKeys;
+        if (!slot->state.compare_exchange_strong(
+                state, kSlotNaming, std::memory_order_acquire)) {
+          continue;
+        }
+        my_strlcpy(slot->key, key, kKeySize);
+        slot->hash = hash;
+        slot->state.store(kSlotNamed, std::memory_order_release);
+        return index;
+      }
+      if (state == kSlotNaming) {
+        // Another thread is naming this slot, perhaps for |key|.
+        sched_yield();
+        continue;
+      }
+      if (slot->hash == hash && !my_strncmp(slot->key, key, kKeySize - 1))
+        return index;
+      break;
+    }
+  }
+  return kMaxKeys;
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,135 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// crash_key_store.h: A fixed-size store of crash keys that any thread can
+// update without taking a lock, and that the minidump writer reads after a
+// crash.
+//
+// Each key has a slot with a sequence counter and two value buffers.  A
+// writer makes the counter odd, fills the buffer that is not current,
+// makes it current, and makes the counter even again.  A reader copies the
+// current buffer and checks that the counter did not move far enough for
+// that buffer to have been rewritten meanwhile.  The current buffer is
+// never written, so a copy of a store taken from a stopped or crashed
+// process, even one stopped in the middle of an update, holds a complete
+// value for every key.
+//
+// The minidump writer finds the store through
+// ExceptionHandler::CrashContext and writes its keys to the
+// MD_CRASHPAD_INFO_STREAM as simple annotations.
+
+#ifndef CLIENT_LINUX_DUMP_WRITER_COMMON_CRASH_KEY_STORE_H_
+#define CLIENT_LINUX_DUMP_WRITER_COMMON_CRASH_KEY_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+namespace google_breakpad {
+
+class CrashKeyStore {
+ public:
+  // The most keys a store holds over its lifetime.  A key keeps its slot
+  // when it is removed.
+  static constexpr size_t kMaxKeys = 64;
+  // The sizes of a key and a value, including their NUL terminators.
+  // Longer ones are truncated.
+  static constexpr size_t kKeySize = 64;
+  static constexpr size_t kValueSize = 256;
+
+  // A key and its value, as Snapshot() copies them.
+  struct Entry {
+    char key[kKeySize];
+    char value[kValueSize];
+  };
+
+  CrashKeyStore();
+
+  CrashKeyStore(const CrashKeyStore&) = delete;
+  void operator=(const CrashKeyStore&) = delete;
+
+  // Returns the index of |key|, giving it a slot if it does not have one,
+  // or kMaxKeys if the store is full.  |key| must not be NULL or empty.
+  size_t AddKey(const char* key);
+
+  // Stores |value| for the key at |index|, which AddKey() returned.  An
+  // empty |value| removes the key from snapshots.
+  void SetValueAtIndex(size_t index, const char* value);
+
+  // Stores |value| for |key|.  A NULL |value| removes the key.  Returns
+  // false if the store is full.
+  bool SetKeyValue(const char* key, const char* value);
+
+  // Removes |key| from snapshots.
+  void RemoveKey(const char* key);
+
+  // Returns true if this is a whole store of the same layout as this
+  // build's, such as a copy read from another process.
+  bool IsValid() const;
+
+  // Copies each key that has a value to |entries|, which must have room
+  // for kMaxKeys, and returns how many there are.  This does not block
+  // writers and may run while they update the store; a key whose value
+  // keeps changing under it is left out after a few attempts.  It is safe
+  // to call from a compromised context, and on a copy of the store.
+  size_t Snapshot(Entry* entries) const;
+
+ private:
+  enum SlotState {
+    kSlotFree = 0,
+    kSlotNaming = 1,
+    kSlotNamed = 2
+  };
+
+  struct Slot {
+    std::atomic<uint32_t> state;
+    // Odd while a writer updates the value.
+    std::atomic<uint32_t> sequence;
+    // Which of |values| is current.
+    std::atomic<uint32_t> current;
+    uint32_t hash;
+    char key[kKeySize];
+    char values[2][kValueSize];
+  };
+
+  // Returns the slot for |key|, giving it one if |add|, or kMaxKeys.
+  size_t FindKey(const char* key, bool add);
+
+  // Fields checked by IsValid().
+  uint32_t magic_;
+  uint32_t max_keys_;
+  uint32_t key_size_;
+  uint32_t value_size_;
+  Slot slots_[kMaxKeys];
+};
+
+}  // namespace google_breakpad
+
+#endif  // CLIENT_LINUX_DUMP_WRITER_COMMON_CRASH_KEY_STORE_H_
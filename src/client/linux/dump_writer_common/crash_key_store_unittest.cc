@@ -0,0 +1,176 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "client/linux/dump_writer_common/crash_key_store.h"
+#include "common/scoped_ptr.h"
+
+namespace {
+
+using google_breakpad::CrashKeyStore;
+using google_breakpad::scoped_array;
+using google_breakpad::scoped_ptr;
+
+// Returns the value of |key| in a snapshot of |store|, or NULL.
+std::string* FindInSnapshot(const CrashKeyStore& store, const char* key,
+                            std::string* value) {
+  scoped_array<CrashKeyStore::Entry> entries(
+      new CrashKeyStore::Entry[CrashKeyStore::kMaxKeys]);
+  const size_t count = store.Snapshot(entries.get());
+  for (size_t i = 0; i < count; ++i) {
+    if (strcmp(entries[i].key, key) == 0) {
+      *value = entries[i].value;
+      return value;
+    }
+  }
+  return NULL;
+}
+
+TEST(CrashKeyStoreTest, SetAndRemove) {
+  scoped_ptr<CrashKeyStore> store(new CrashKeyStore);
+  EXPECT_TRUE(store->IsValid());
+  std::string value;
+  EXPECT_FALSE(FindInSnapshot(*store, "request", &value));
+
+  EXPECT_TRUE(store->SetKeyValue("request", "1"));
+  EXPECT_TRUE(store->SetKeyValue("request", "2"));
+  ASSERT_TRUE(FindInSnapshot(*store, "request", &value));
+  EXPECT_EQ("2", value);
+
+  const size_t index = store->AddKey("request");
+  ASSERT_LT(index, CrashKeyStore::kMaxKeys);
+  store->SetValueAtIndex(index, "3");
+  ASSERT_TRUE(FindInSnapshot(*store, "request", &value));
+  EXPECT_EQ("3", value);
+
+  store->RemoveKey("request");
+  EXPECT_FALSE(FindInSnapshot(*store, "request", &value));
+  EXPECT_TRUE(store->SetKeyValue("request", NULL));
+  EXPECT_EQ(index, store->AddKey("request"));
+
+  EXPECT_EQ(CrashKeyStore::kMaxKeys, store->AddKey(""));
+  EXPECT_EQ(CrashKeyStore::kMaxKeys, store->AddKey(NULL));
+}
+
+TEST(CrashKeyStoreTest, Truncates) {
+  scoped_ptr<CrashKeyStore> store(new CrashKeyStore);
+  const std::string key(CrashKeyStore::kKeySize + 10, 'k');
+  const std::string long_value(CrashKeyStore::kValueSize + 10, 'v');
+  EXPECT_TRUE(store->SetKeyValue(key.c_str(), long_value.c_str()));
+
+  std::string value;
+  const std::string kept_key = key.substr(0, CrashKeyStore::kKeySize - 1);
+  ASSERT_TRUE(FindInSnapshot(*store, kept_key.c_str(), &value));
+  EXPECT_EQ(long_value.substr(0, CrashKeyStore::kValueSize - 1), value);
+  // The whole key still finds its slot.
+  EXPECT_EQ(store->AddKey(kept_key.c_str()), store->AddKey(key.c_str()));
+}
+
+TEST(CrashKeyStoreTest, Full) {
+  scoped_ptr<CrashKeyStore> store(new CrashKeyStore);
+  char key[16];
+  for (size_t i = 0; i < CrashKeyStore::kMaxKeys; ++i) {
+    snprintf(key, sizeof(key), "key%zu", i);
+    EXPECT_TRUE(store->SetKeyValue(key, key));
+  }
+  EXPECT_FALSE(store->SetKeyValue("another", "value"));
+  for (size_t i = 0; i < CrashKeyStore::kMaxKeys; ++i) {
+    snprintf(key, sizeof(key), "key%zu", i);
+    std::string value;
+    ASSERT_TRUE(FindInSnapshot(*store, key, &value));
+    EXPECT_EQ(key, value);
+  }
+}
+
+struct WriterArgs {
+  CrashKeyStore* store;
+  int thread;
+  volatile bool* stop;
+};
+
+// Sets two shared keys and one of its own to values that are a run of a
+// single letter, so that a torn value is easy to see.
+void* WriteKeys(void* data) {
+  WriterArgs* args = static_cast<WriterArgs*>(data);
+  char own_key[16];
+  snprintf(own_key, sizeof(own_key), "thread%d", args->thread);
+  char value[CrashKeyStore::kValueSize];
+  for (unsigned i = 0; !*args->stop; ++i) {
+    const size_t length = 1 + (i * 7 + args->thread) % (sizeof(value) - 1);
+    memset(value, 'a' + (i + args->thread) % 26, length);
+    value[length] = '\0';
+    args->store->SetKeyValue(i & 1 ? "shared_odd" : "shared_even", value);
+    args->store->SetKeyValue(own_key, value);
+  }
+  return NULL;
+}
+
+TEST(CrashKeyStoreTest, SnapshotsWhileWriting) {
+  scoped_ptr<CrashKeyStore> store(new CrashKeyStore);
+  const int kWriters = 4;
+  volatile bool stop = false;
+  pthread_t threads[kWriters];
+  WriterArgs args[kWriters];
+  for (int i = 0; i < kWriters; ++i) {
+    args[i].store = store.get();
+    args[i].thread = i;
+    args[i].stop = &stop;
+    ASSERT_EQ(0, pthread_create(&threads[i], NULL, WriteKeys, &args[i]));
+  }
+
+  scoped_array<CrashKeyStore::Entry> entries(
+      new CrashKeyStore::Entry[CrashKeyStore::kMaxKeys]);
+  for (int snapshot = 0; snapshot < 200000; ++snapshot) {
+    const size_t count = store->Snapshot(entries.get());
+    ASSERT_LE(count, static_cast<size_t>(kWriters + 2));
+    for (size_t i = 0; i < count; ++i) {
+      const char* value = entries[i].value;
+      const size_t length = strlen(value);
+      ASSERT_GT(length, 0U);
+      ASSERT_EQ(length, strspn(value, std::string(1, value[0]).c_str()))
+          << entries[i].key << " is torn: " << value;
+    }
+  }
+
+  stop = true;
+  for (int i = 0; i < kWriters; ++i)
+    pthread_join(threads[i], NULL);
+}
+
+}  // namespace
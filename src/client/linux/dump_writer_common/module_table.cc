@@ -0,0 +1,207 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "client/linux/dump_writer_common/module_table.h"
+
+#include <link.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+
+#include "common/linux/file_id.h"
+#include "common/linux/linux_libc_support.h"
+#include "common/memory_allocator.h"
+
+namespace google_breakpad {
+
+using elf::FileID;
+using elf::kDefaultBuildIdSize;
+
+ModuleTable::ModuleTable(size_t capacity)
+    : capacity_(capacity),
+      current_(0),
+      overflowed_(false) {
+  pthread_mutex_init(&update_mutex_, NULL);
+  for (int i = 0; i < 2; ++i) {
+    tables_[i].size = 0;
+    tables_[i].entries = NULL;
+    if (!capacity_)
+      continue;
+    void* entries = mmap(NULL, capacity_ * sizeof(Entry),
+                         PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                         -1, 0);
+    if (entries != MAP_FAILED)
+      tables_[i].entries = static_cast<Entry*>(entries);
+  }
+}
+
+ModuleTable::~ModuleTable() {
+  for (int i = 0; i < 2; ++i) {
+    if (tables_[i].entries)
+      munmap(tables_[i].entries, capacity_ * sizeof(Entry));
+  }
+  pthread_mutex_destroy(&update_mutex_);
+}
+
+bool ModuleTable::Update() {
+  pthread_mutex_lock(&update_mutex_);
+  const int next = 1 - current_;
+  Table& table = tables_[next];
+  bool success = table.entries != NULL || !capacity_;
+  if (table.entries) {
+    table.size = 0;
+    overflowed_ = false;
+    dl_iterate_phdr(AddModule, this);
+    std::sort(table.entries, table.entries + table.size,
+              [](const Entry& a, const Entry& b) {
+                return a.start_addr < b.start_addr;
+              });
+    current_ = next;
+    success = !overflowed_;
+  }
+  pthread_mutex_unlock(&update_mutex_);
+  return success;
+}
+
+const ModuleTable::Entry* ModuleTable::Find(const MappingInfo& mapping) const {
+  const Table& table = tables_[current_];
+  const uintptr_t address = mapping.system_mapping_info.start_addr;
+
+  // Find the last module that starts at or below |address|.  Modules do not
+  // overlap, so no other can hold it.
+  size_t low = 0;
+  size_t high = table.size;
+  while (low < high) {
+    const size_t middle = low + (high - low) / 2;
+    if (table.entries[middle].start_addr <= address)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  if (!low)
+    return NULL;
+  const Entry& entry = table.entries[low - 1];
+  if (address >= entry.end_addr || my_strcmp(entry.name, mapping.name) != 0)
+    return NULL;
+  return &entry;
+}
+
+size_t ModuleTable::size() const {
+  return tables_[current_].size;
+}
+
+const ModuleTable::Entry* ModuleTable::GetEntryAtIndex(size_t index) const {
+  const Table& table = tables_[current_];
+  return index < table.size ? &table.entries[index] : NULL;
+}
+
+// static
+int ModuleTable::AddModule(struct dl_phdr_info* info, size_t size,
+                           void* data) {
+  ModuleTable* self = static_cast<ModuleTable*>(data);
+  Table& table = self->tables_[1 - self->current_];
+
+  uintptr_t start_addr = UINTPTR_MAX;
+  uintptr_t end_addr = 0;
+  const uintptr_t page_mask = ~static_cast<uintptr_t>(getpagesize() - 1);
+  for (int i = 0; i < info->dlpi_phnum; ++i) {
+    const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+    if (phdr.p_type != PT_LOAD)
+      continue;
+    const uintptr_t address = info->dlpi_addr + phdr.p_vaddr;
+    start_addr = std::min(start_addr, address & page_mask);
+    end_addr = std::max(end_addr, address + phdr.p_memsz);
+  }
+  if (start_addr >= end_addr)
+    return 0;
+
+  // The main program has no name of its own.  Modules without a file, such
+  // as the vDSO, are left out; the minidump writer identifies them from
+  // memory.
+  const char* path = info->dlpi_name;
+  if (!path || !*path)
+    path = "/proc/self/exe";
+  char name[PATH_MAX];
+  if (!realpath(path, name) || strlen(name) >= NAME_MAX)
+    return 0;
+
+  if (table.size == self->capacity_) {
+    self->overflowed_ = true;
+    return 1;
+  }
+  Entry& entry = table.entries[table.size];
+  entry.start_addr = start_addr;
+  entry.end_addr = end_addr;
+  strcpy(entry.name, name);
+
+  const Entry* old_entry =
+      FindEntry(self->tables_[self->current_], start_addr, name);
+  if (old_entry) {
+    entry.identifier_size = old_entry->identifier_size;
+    memcpy(entry.identifier, old_entry->identifier, entry.identifier_size);
+  } else {
+    PageAllocator allocator;
+    auto_wasteful_vector<uint8_t, kDefaultBuildIdSize> identifier(&allocator);
+    FileID file_id(name);
+    if (!file_id.ElfFileIdentifier(identifier) || identifier.empty() ||
+        identifier.size() > kMaxIdentifierSize) {
+      return 0;
+    }
+    entry.identifier_size = identifier.size();
+    memcpy(entry.identifier, &identifier[0], identifier.size());
+  }
+  ++table.size;
+  return 0;
+}
+
+// static
+const ModuleTable::Entry* ModuleTable::FindEntry(const Table& table,
+                                                 uintptr_t start_addr,
+                                                 const char* name) {
+  const Entry* begin = table.entries;
+  const Entry* end = begin + table.size;
+  const Entry* entry = std::lower_bound(
+      begin, end, start_addr,
+      [](const Entry& a, uintptr_t address) {
+        return a.start_addr < address;
+      });
+  if (entry == end || entry->start_addr != start_addr ||
+      strcmp(entry->name, name) != 0) {
+    return NULL;
+  }
+  return entry;
+}
+
+}  // namespace google_breakpad
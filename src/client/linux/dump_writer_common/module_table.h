@@ -0,0 +1,125 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// module_table.h: A table of the ELF modules loaded into this process and
+// their identifiers, kept ahead of a crash.
+//
+// Identifying a module at crash time means opening and mapping its file
+// to find its build id, which is a few system calls for each of what can
+// be a great many modules.  A ModuleTable does that work beforehand, when
+// the process is healthy, so that the minidump writer only has to look
+// each mapping up.
+
+#ifndef CLIENT_LINUX_DUMP_WRITER_COMMON_MODULE_TABLE_H_
+#define CLIENT_LINUX_DUMP_WRITER_COMMON_MODULE_TABLE_H_
+
+#include <limits.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "client/linux/dump_writer_common/mapping_info.h"
+
+struct dl_phdr_info;
+
+namespace google_breakpad {
+
+class ModuleTable {
+ public:
+  // The longest identifier that is kept.  Modules with longer ones are
+  // left for the minidump writer to identify.
+  static const size_t kMaxIdentifierSize = 32;
+
+  struct Entry {
+    // The addresses that the module's loadable segments cover.
+    uintptr_t start_addr;
+    uintptr_t end_addr;
+    // The module's file, with symbolic links resolved.
+    char name[NAME_MAX];
+    size_t identifier_size;
+    uint8_t identifier[kMaxIdentifierSize];
+  };
+
+  // Sets aside memory for up to |capacity| modules.
+  explicit ModuleTable(size_t capacity);
+  ~ModuleTable();
+
+  ModuleTable(const ModuleTable&) = delete;
+  void operator=(const ModuleTable&) = delete;
+
+  // Lists the loaded modules with dl_iterate_phdr() and identifies any
+  // that were not in the table before.  Call this after dlopen() and
+  // dlclose(), or from time to time, to keep the table current; mappings
+  // that the table does not match are identified the slow way at crash
+  // time.  This allocates and opens files, so it must not be called from a
+  // compromised context, but a crash while it runs finds the table as it
+  // was before.  Returns false if there were more than |capacity| modules,
+  // in which case the table holds the first |capacity|.
+  bool Update();
+
+  // Returns the module that |mapping|, from /proc/$x/maps, belongs to, or
+  // NULL if there is none.  This is safe to call from a compromised
+  // context.
+  const Entry* Find(const MappingInfo& mapping) const;
+
+  // Returns the number of modules in the table.
+  size_t size() const;
+
+  // Returns the |index|th module in the table, in address order, or NULL if
+  // there is none.  The entry stays as it is until the second Update()
+  // after the call.
+  const Entry* GetEntryAtIndex(size_t index) const;
+
+ private:
+  struct Table {
+    Entry* entries;
+    size_t size;
+  };
+
+  static int AddModule(struct dl_phdr_info* info, size_t size, void* data);
+
+  // Returns the entry of |table| for |name| starting at |start_addr|, or
+  // NULL if there is none.
+  static const Entry* FindEntry(const Table& table, uintptr_t start_addr,
+                                const char* name);
+
+  const size_t capacity_;
+  // Update() fills one table while the other is current, then switches.
+  Table tables_[2];
+  // The index of the current table.
+  volatile int current_;
+  // Serializes calls to Update().
+  pthread_mutex_t update_mutex_;
+  // Set while AddModule() runs if a module did not fit.
+  bool overflowed_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // CLIENT_LINUX_DUMP_WRITER_COMMON_MODULE_TABLE_H_
@@ -0,0 +1,123 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// module_table_unittest.cc: Unit tests for google_breakpad::ModuleTable.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <string.h>
+#include <unistd.h>
+
+#include "breakpad_googletest_includes.h"
+#include "client/linux/dump_writer_common/module_table.h"
+#include "client/linux/minidump_writer/linux_ptrace_dumper.h"
+#include "common/linux/file_id.h"
+#include "common/memory_allocator.h"
+
+using namespace google_breakpad;
+using google_breakpad::elf::kDefaultBuildIdSize;
+
+namespace {
+
+typedef testing::Test ModuleTableTest;
+
+// A function whose address is in this test's own module.
+void OwnFunction() {}
+
+TEST(ModuleTableTest, Empty) {
+  ModuleTable table(16);
+  EXPECT_EQ(0U, table.size());
+
+  MappingInfo mapping;
+  memset(&mapping, 0, sizeof(mapping));
+  mapping.system_mapping_info.start_addr =
+      reinterpret_cast<uintptr_t>(&OwnFunction);
+  EXPECT_EQ(nullptr, table.Find(mapping));
+}
+
+// The table should identify every module that it finds the same way that
+// the dumper identifies it from its file.
+TEST(ModuleTableTest, MatchesDumper) {
+  ModuleTable table(4096);
+  ASSERT_TRUE(table.Update());
+  EXPECT_GT(table.size(), 0U);
+
+  LinuxPtraceDumper dumper(getpid());
+  ASSERT_TRUE(dumper.Init());
+
+  // This test's own module must be found.
+  const MappingInfo* own_mapping = dumper.FindMapping(
+      reinterpret_cast<const void*>(&OwnFunction));
+  ASSERT_TRUE(own_mapping);
+  EXPECT_TRUE(table.Find(*own_mapping));
+
+  size_t matches = 0;
+  for (size_t i = 0; i < dumper.mappings().size(); ++i) {
+    const MappingInfo& mapping = *dumper.mappings()[i];
+    const ModuleTable::Entry* entry = table.Find(mapping);
+    if (!entry)
+      continue;
+    ++matches;
+
+    PageAllocator allocator;
+    auto_wasteful_vector<uint8_t, kDefaultBuildIdSize> identifier(&allocator);
+    ASSERT_TRUE(dumper.ElfFileIdentifierForMapping(mapping, true, i,
+                                                   identifier))
+        << mapping.name;
+    ASSERT_EQ(identifier.size(), entry->identifier_size) << mapping.name;
+    EXPECT_EQ(0, memcmp(&identifier[0], entry->identifier,
+                        entry->identifier_size))
+        << mapping.name;
+  }
+  EXPECT_GT(matches, 0U);
+
+  // A mapping of another file at the same address is not the module.
+  MappingInfo renamed = *own_mapping;
+  strcpy(renamed.name, "/nonexistent/module.so");
+  EXPECT_EQ(nullptr, table.Find(renamed));
+}
+
+// Updating again keeps the modules, reusing their identifiers.
+TEST(ModuleTableTest, Update) {
+  ModuleTable table(4096);
+  ASSERT_TRUE(table.Update());
+  const size_t size = table.size();
+  ASSERT_TRUE(table.Update());
+  EXPECT_EQ(size, table.size());
+}
+
+TEST(ModuleTableTest, Full) {
+  ModuleTable table(1);
+  EXPECT_FALSE(table.Update());
+  EXPECT_EQ(1U, table.size());
+}
+
+}  // namespace
@@ -93,8 +93,11 @@
 #include "common/linux/breakpad_getcontext.h"
 #include "common/linux/linux_libc_support.h"
 #include "common/memory_allocator.h"
+#include "client/crash_signature.h"
+#include "client/linux/dump_writer_common/ucontext_reader.h"
 #include "client/linux/log/log.h"
 #include "client/linux/microdump_writer/microdump_writer.h"
+#include "client/linux/minidump_writer/line_reader.h"
 #include "client/linux/minidump_writer/linux_dumper.h"
 #include "client/linux/minidump_writer/minidump_writer.h"
 #include "common/linux/eintr_wrapper.h"
@@ -216,6 +219,75 @@ pthread_mutex_t g_handler_stack_mutex_ = PTHREAD_MUTEX_INITIALIZER;
 ExceptionHandler::CrashContext g_crash_context_;
 
 FirstChanceHandler g_first_chance_handler_ = nullptr;
+
+// The size of the stack of the process cloned to write a minidump.
+// Allocating too much stack isn't a problem, and better to err on the side
+// of caution than smash it into random locations.
+const size_t kChildStackSize = 16000;
+
+// The frame pointer of |uc|, on the architectures whose frames
+// WalkFramePointers() understands, or 0.
+// This function runs in a compromised context: see the top of the file.
+uintptr_t GetFramePointer(const ucontext_t* uc) {
+#if defined(__x86_64__)
+  return uc->uc_mcontext.gregs[REG_RBP];
+#elif defined(__i386__)
+  return uc->uc_mcontext.gregs[REG_EBP];
+#elif defined(__aarch64__)
+  return uc->uc_mcontext.regs[29];
+#else
+  return 0;
+#endif
+}
+
+// Sets |stack_high| to the end of the mapping in /proc/self/maps that holds
+// |stack_pointer|.  Returns false if there is none.
+// This function runs in a compromised context: see the top of the file.
+bool FindStackEnd(uintptr_t stack_pointer, uintptr_t* stack_high) {
+  const int fd = sys_open("/proc/self/maps", O_RDONLY, 0);
+  if (fd < 0)
+    return false;
+  LineReader reader(fd);
+  bool found = false;
+  const char* line;
+  unsigned line_length;
+  while (!found && reader.GetNextLine(&line, &line_length)) {
+    uintptr_t start, end;
+    const char* next = my_read_hex_ptr(&start, line);
+    if (*next == '-') {
+      my_read_hex_ptr(&end, next + 1);
+      if (start <= stack_pointer && stack_pointer < end) {
+        *stack_high = end;
+        found = true;
+      }
+    }
+    reader.PopLine(line_length);
+  }
+  sys_close(fd);
+  return found;
+}
+
+// Returns the entry of |modules| that holds |address|, or NULL.
+// This function runs in a compromised context: see the top of the file.
+const ModuleTable::Entry* FindModule(const ModuleTable& modules,
+                                     uintptr_t address) {
+  size_t low = 0;
+  size_t high = modules.size();
+  while (low < high) {
+    const size_t middle = low + (high - low) / 2;
+    const ModuleTable::Entry* entry = modules.GetEntryAtIndex(middle);
+    if (!entry)
+      return NULL;
+    if (address < entry->start_addr)
+      high = middle;
+    else if (address >= entry->end_addr)
+      low = middle + 1;
+    else
+      return entry;
+  }
+  return NULL;
+}
+
 }  // namespace
 
 // Runs before crashing: normal context.
@@ -229,7 +301,10 @@ ExceptionHandler::ExceptionHandler(const MinidumpDescriptor& descriptor,
       callback_(callback),
       callback_context_(callback_context),
       minidump_descriptor_(descriptor),
-      crash_handler_(NULL) {
+      crash_handler_(NULL),
+      crash_key_store_(NULL),
+      dump_reserve_stack_(NULL),
+      dump_reserve_busy_(false) {
   if (server_fd >= 0)
     crash_generation_client_.reset(CrashGenerationClient::TryCreate(server_fd));
 
@@ -417,6 +492,7 @@ struct ThreadArgument {
   ExceptionHandler* handler;
   const void* context;  // a CrashContext structure
   size_t context_size;
+  PageReserve* reserve;  // memory to allocate from, or NULL
 };
 
 // This is the entry function for the cloned process. We are in a compromised
@@ -434,6 +510,11 @@ int ExceptionHandler::ThreadEntry(void* arg) {
   thread_arg->handler->WaitForContinueSignal();
   sys_close(thread_arg->handler->fdes[0]);
 
+  // This process has its own copy of the parent's memory, so the reserve
+  // only becomes active here.
+  if (thread_arg->reserve)
+    PageAllocator::SetActiveReserve(thread_arg->reserve);
+
   return thread_arg->handler->DoDump(thread_arg->pid, thread_arg->context,
                                      thread_arg->context_size) == false;
 }
@@ -472,6 +553,8 @@ bool ExceptionHandler::HandleSignal(int /*sig*/, siginfo_t* info, void* uc) {
   }
 #endif
   g_crash_context_.tid = syscall(__NR_gettid);
+  g_crash_context_.crash_key_store =
+      reinterpret_cast<uintptr_t>(crash_key_store_);
   if (crash_handler_ != NULL) {
     if (crash_handler_(&g_crash_context_, sizeof(g_crash_context_),
                        callback_context_)) {
@@ -496,16 +579,75 @@ bool ExceptionHandler::SimulateSignalDelivery(int sig) {
 
 // This function may run in a compromised context: see the top of the file.
 bool ExceptionHandler::GenerateDump(CrashContext* context) {
+  ComputeCrashSignature(context);
+
   if (IsOutOfProcess())
     return crash_generation_client_->RequestDump(context, sizeof(*context));
 
-  // Allocating too much stack isn't a problem, and better to err on the side
-  // of caution than smash it into random locations.
-  static const unsigned kChildStackSize = 16000;
+  // Use the reserved memory unless another dump is being written with it.
+  PageReserve* reserve = NULL;
+  if (dump_reserve_.get() &&
+      !dump_reserve_busy_.exchange(true, std::memory_order_acquire)) {
+    reserve = dump_reserve_.get();
+  }
+  const bool success = GenerateDumpWithReserve(context, reserve);
+  if (reserve)
+    dump_reserve_busy_.store(false, std::memory_order_release);
+  return success;
+}
+
+// Hashes the crashing instruction and the return addresses found by
+// following frame pointers, in the modules of |module_table_|, into the
+// signature in |context|.  The descriptor gets a copy for the callback.
+// This function may run in a compromised context: see the top of the file.
+void ExceptionHandler::ComputeCrashSignature(CrashContext* context) {
+  context->crash_signature = 0;
+  context->crash_signature_frames = 0;
+  minidump_descriptor_.set_crash_signature(0);
+  size_t max_frames = minidump_descriptor_.crash_signature_frames();
+  if (max_frames > CrashSignature::kMaxFrames)
+    max_frames = CrashSignature::kMaxFrames;
+  if (!module_table_.get() || max_frames == 0)
+    return;
+
+  const ucontext_t* uc = &context->context;
+  uintptr_t addresses[CrashSignature::kMaxFrames];
+  addresses[0] = UContextReader::GetInstructionPointer(uc);
+  size_t address_count = 1;
+  const uintptr_t stack_pointer = UContextReader::GetStackPointer(uc);
+  uintptr_t stack_high;
+  if (max_frames > 1 && FindStackEnd(stack_pointer, &stack_high)) {
+    address_count += WalkFramePointers(GetFramePointer(uc), stack_pointer,
+                                       stack_high, addresses + 1,
+                                       max_frames - 1);
+  }
+
+  CrashSignature signature;
+  for (size_t i = 0; i < address_count; ++i) {
+    const ModuleTable::Entry* module =
+        FindModule(*module_table_, addresses[i]);
+    if (module) {
+      signature.AddFrame(module->identifier, module->identifier_size,
+                         addresses[i] - module->start_addr);
+    }
+  }
+  context->crash_signature = signature.signature();
+  context->crash_signature_frames = signature.frame_count();
+  minidump_descriptor_.set_crash_signature(signature.signature());
+}
+
+// This function may run in a compromised context: see the top of the file.
+bool ExceptionHandler::GenerateDumpWithReserve(CrashContext* context,
+                                               PageReserve* reserve) {
   PageAllocator allocator;
-  uint8_t* stack = reinterpret_cast<uint8_t*>(allocator.Alloc(kChildStackSize));
-  if (!stack)
-    return false;
+  uint8_t* stack;
+  if (reserve) {
+    stack = dump_reserve_stack_;
+  } else {
+    stack = reinterpret_cast<uint8_t*>(allocator.Alloc(kChildStackSize));
+    if (!stack)
+      return false;
+  }
   // clone() needs the top-most address. (scrub just to be safe)
   stack += kChildStackSize;
   my_memset(stack - 16, 0, 16);
@@ -516,6 +658,7 @@ bool ExceptionHandler::GenerateDump(CrashContext* context) {
   thread_arg.pid = getpid();
   thread_arg.context = context;
   thread_arg.context_size = sizeof(*context);
+  thread_arg.reserve = reserve;
 
   // We need to explicitly enable ptrace of parent processes on some
   // kernels, but we need to know the PID of the cloned process before we
@@ -605,6 +748,7 @@ bool ExceptionHandler::DoDump(pid_t crashing_process, const void* context,
   const uintptr_t principal_mapping_address =
       minidump_descriptor_.address_within_principal_mapping();
   const bool sanitize_stacks = minidump_descriptor_.sanitize_stacks();
+  const bool include_unwind_info = minidump_descriptor_.include_unwind_info();
   if (minidump_descriptor_.IsMicrodumpOnConsole()) {
     return google_breakpad::WriteMicrodump(
         crashing_process,
@@ -626,7 +770,10 @@ bool ExceptionHandler::DoDump(pid_t crashing_process, const void* context,
                                           app_memory_list_,
                                           may_skip_dump,
                                           principal_mapping_address,
-                                          sanitize_stacks);
+                                          sanitize_stacks,
+                                          minidump_descriptor_.compressed(),
+                                          module_table_.get(),
+                                          include_unwind_info);
   }
   return google_breakpad::WriteMinidump(minidump_descriptor_.path(),
                                         minidump_descriptor_.size_limit(),
@@ -637,7 +784,10 @@ bool ExceptionHandler::DoDump(pid_t crashing_process, const void* context,
                                         app_memory_list_,
                                         may_skip_dump,
                                         principal_mapping_address,
-                                        sanitize_stacks);
+                                        sanitize_stacks,
+                                        minidump_descriptor_.compressed(),
+                                        module_table_.get(),
+                                        include_unwind_info);
 }
 
 // static
@@ -706,6 +856,7 @@ bool ExceptionHandler::WriteMinidump() {
          sizeof(context.float_state));
 #endif
   context.tid = sys_gettid();
+  context.crash_key_store = reinterpret_cast<uintptr_t>(crash_key_store_);
 
   // Add an exception stream to the minidump for better reporting.
   memset(&context.siginfo, 0, sizeof(context.siginfo));
@@ -753,6 +904,30 @@ void ExceptionHandler::AddMappingInfo(const string& name,
   mapping_list_.push_back(mapping);
 }
 
+bool ExceptionHandler::EnableModuleTable(size_t max_modules) {
+  module_table_.reset(new ModuleTable(max_modules));
+  return module_table_->Update();
+}
+
+bool ExceptionHandler::UpdateModuleTable() {
+  return module_table_.get() && module_table_->Update();
+}
+
+bool ExceptionHandler::ReserveDumpMemory(size_t bytes) {
+  if (dump_reserve_.get())
+    return false;
+  // The cloned process's stack comes first, so that it never shares pages
+  // with what that process allocates.
+  const size_t page_size = getpagesize();
+  const size_t stack_pages = (kChildStackSize + page_size - 1) / page_size;
+  scoped_ptr<PageReserve> reserve(new PageReserve);
+  if (!reserve->Init(stack_pages * page_size + bytes))
+    return false;
+  dump_reserve_stack_ = reserve->TakePages(stack_pages);
+  dump_reserve_.reset(reserve.release());
+  return true;
+}
+
 void ExceptionHandler::RegisterAppMemory(void* ptr, size_t length) {
   AppMemoryList::iterator iter =
     std::find(app_memory_list_.begin(), app_memory_list_.end(), ptr);
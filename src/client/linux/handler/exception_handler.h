@@ -34,9 +34,12 @@
 #include <stdio.h>
 #include <sys/ucontext.h>
 
+#include <atomic>
 #include <string>
 
 #include "client/linux/crash_generation/crash_generation_client.h"
+#include "client/linux/dump_writer_common/crash_key_store.h"
+#include "client/linux/dump_writer_common/module_table.h"
 #include "client/linux/handler/minidump_descriptor.h"
 #include "client/linux/minidump_writer/minidump_writer.h"
 #include "common/scoped_ptr.h"
@@ -54,6 +57,8 @@
 
 namespace google_breakpad {
 
+class PageReserve;
+
 // ExceptionHandler
 //
 // ExceptionHandler can write a minidump file when an exception occurs,
@@ -156,6 +161,14 @@ class ExceptionHandler {
     crash_generation_client_.reset(client);
   }
 
+  // Write the keys that have values in |store| to each minidump, as the
+  // simple annotations of a Crashpad info stream.  This works for dumps
+  // written out of process too.  |store| must outlive the handler, or be
+  // replaced with NULL first.
+  void set_crash_key_store(const CrashKeyStore* store) {
+    crash_key_store_ = store;
+  }
+
   // Writes a minidump immediately.  This can be used to capture the execution
   // state independently of a crash.
   // Returns true on success.
@@ -200,6 +213,12 @@ class ExceptionHandler {
     siginfo_t siginfo;
     pid_t tid;  // the crashing thread.
     ucontext_t context;
+    // The address of a CrashKeyStore in the crashing process, or 0.
+    uintptr_t crash_key_store;
+    // The crash's quick signature, and the number of frames it covers, or
+    // 0 if it has none.  See MinidumpDescriptor::crash_signature_frames().
+    uint64_t crash_signature;
+    uint32_t crash_signature_frames;
 #if GOOGLE_BREAKPAD_CRASH_CONTEXT_HAS_FLOAT_STATE
     fpstate_t float_state;
 #endif
@@ -219,6 +238,31 @@ class ExceptionHandler {
                       size_t mapping_size,
                       size_t file_offset);
 
+  // Identify the loaded modules now, and keep up to |max_modules| of them
+  // in a table that the minidump writer looks up instead of opening and
+  // mapping each module's file after a crash.  Returns false if there are
+  // more modules than that; the rest are identified at crash time.
+  bool EnableModuleTable(size_t max_modules);
+
+  // Bring the table that EnableModuleTable() built up to date.  Call this
+  // after dlopen() and dlclose(), or periodically.  Modules that are not in
+  // the table, or have been replaced, are identified at crash time.
+  // Returns false if the table is not enabled or is full.
+  bool UpdateModuleTable();
+
+  // The table that EnableModuleTable() built, or NULL.  A StackSnapshot can
+  // use it to list modules without identifying them again.
+  const ModuleTable* module_table() const { return module_table_.get(); }
+
+  // Map and fault in |bytes| of memory now, for writing minidumps in
+  // process.  The process that writes a dump runs on this memory and
+  // allocates from it, falling back to mapping pages only once it is used
+  // up, so a crash under memory pressure neither waits on page faults nor
+  // fails to map memory.  Dumps that are written at the same time as
+  // another one don't use it.  Returns false if the memory can't be mapped
+  // or was already reserved.
+  bool ReserveDumpMemory(size_t bytes);
+
   // Register a block of memory of length bytes starting at address ptr
   // to be copied to the minidump when a crash happens.
   void RegisterAppMemory(void* ptr, size_t length);
@@ -240,6 +284,8 @@ class ExceptionHandler {
 
   void PreresolveSymbols();
   bool GenerateDump(CrashContext* context);
+  void ComputeCrashSignature(CrashContext* context);
+  bool GenerateDumpWithReserve(CrashContext* context, PageReserve* reserve);
   void SendContinueSignalToChild();
   void WaitForContinueSignal();
 
@@ -276,6 +322,20 @@ class ExceptionHandler {
   // Callers can request additional memory regions to be included in
   // the dump.
   AppMemoryList app_memory_list_;
+
+  // Identifiers of the loaded modules, if EnableModuleTable() was called.
+  scoped_ptr<ModuleTable> module_table_;
+
+  // Crash keys to write to the minidump, if set_crash_key_store() was
+  // called.
+  const CrashKeyStore* crash_key_store_;
+
+  // Memory for writing minidumps, if ReserveDumpMemory() was called, and
+  // the stack of the cloned process, which is taken from it.  The reserve
+  // is used by one dump at a time; |dump_reserve_busy_| is set while it is.
+  scoped_ptr<PageReserve> dump_reserve_;
+  uint8_t* dump_reserve_stack_;
+  std::atomic<bool> dump_reserve_busy_;
 };
 
 typedef bool (*FirstChanceHandler)(int, siginfo_t*, void*);
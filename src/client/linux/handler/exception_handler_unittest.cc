@@ -982,6 +982,123 @@ TEST(ExceptionHandlerTest, ModuleInfo) {
   unlink(minidump_desc.path());
 }
 
+// Test that modules identified ahead of time by the module table are
+// written as they would be without it.
+TEST(ExceptionHandlerTest, ModuleTable) {
+  AutoTempDir temp_dir;
+  ExceptionHandler handler(
+      MinidumpDescriptor(temp_dir.path()), NULL, NULL, NULL, true, -1);
+  EXPECT_FALSE(handler.UpdateModuleTable());
+
+  ASSERT_TRUE(handler.WriteMinidump());
+  const string plain_path = handler.minidump_descriptor().path();
+
+  ASSERT_TRUE(handler.EnableModuleTable(4096));
+  ASSERT_TRUE(handler.UpdateModuleTable());
+  ASSERT_TRUE(handler.WriteMinidump());
+  const string table_path = handler.minidump_descriptor().path();
+
+  Minidump plain_minidump(plain_path);
+  ASSERT_TRUE(plain_minidump.Read());
+  MinidumpModuleList* plain_modules = plain_minidump.GetModuleList();
+  ASSERT_TRUE(plain_modules);
+  Minidump table_minidump(table_path);
+  ASSERT_TRUE(table_minidump.Read());
+  MinidumpModuleList* table_modules = table_minidump.GetModuleList();
+  ASSERT_TRUE(table_modules);
+
+  ASSERT_EQ(plain_modules->module_count(), table_modules->module_count());
+  for (unsigned int i = 0; i < plain_modules->module_count(); ++i) {
+    const MinidumpModule* plain_module =
+        plain_modules->GetModuleAtIndex(i);
+    const MinidumpModule* table_module =
+        table_modules->GetModuleAtIndex(i);
+    ASSERT_TRUE(plain_module);
+    ASSERT_TRUE(table_module);
+    EXPECT_EQ(plain_module->code_file(), table_module->code_file());
+    EXPECT_EQ(plain_module->code_identifier(),
+              table_module->code_identifier());
+    EXPECT_EQ(plain_module->debug_identifier(),
+              table_module->debug_identifier());
+  }
+
+  unlink(plain_path.c_str());
+  unlink(table_path.c_str());
+}
+
+// Test that a handler with a module table signs its dumps, the same way
+// each time for the same place.
+static bool CrashSignatureCallback(const MinidumpDescriptor& descriptor,
+                                   void* context,
+                                   bool succeeded) {
+  *reinterpret_cast<uint64_t*>(context) = descriptor.crash_signature();
+  return succeeded;
+}
+
+TEST(ExceptionHandlerTest, CrashSignature) {
+  AutoTempDir temp_dir;
+  MinidumpDescriptor descriptor(temp_dir.path());
+  descriptor.set_crash_signature_frames(4);
+  uint64_t callback_signature = 0;
+  ExceptionHandler handler(descriptor, NULL, CrashSignatureCallback,
+                           &callback_signature, false, -1);
+
+  // Without a module table there is nothing to sign with.
+  ASSERT_TRUE(handler.WriteMinidump());
+  EXPECT_EQ(0U, callback_signature);
+  Minidump unsigned_minidump(handler.minidump_descriptor().path());
+  ASSERT_TRUE(unsigned_minidump.Read());
+  EXPECT_FALSE(unsigned_minidump.GetCrashSignature());
+  unlink(handler.minidump_descriptor().path());
+
+  ASSERT_TRUE(handler.EnableModuleTable(4096));
+  uint64_t signatures[2];
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_TRUE(handler.WriteMinidump());
+    signatures[i] = callback_signature;
+    EXPECT_NE(0U, signatures[i]);
+
+    Minidump minidump(handler.minidump_descriptor().path());
+    ASSERT_TRUE(minidump.Read());
+    MinidumpCrashSignature* signature = minidump.GetCrashSignature();
+    ASSERT_TRUE(signature);
+    ASSERT_TRUE(signature->crash_signature());
+    EXPECT_EQ(signatures[i], signature->crash_signature()->signature);
+    EXPECT_GE(signature->crash_signature()->frame_count, 1U);
+    EXPECT_LE(signature->crash_signature()->frame_count, 4U);
+    unlink(handler.minidump_descriptor().path());
+  }
+  EXPECT_EQ(signatures[0], signatures[1]);
+}
+
+// Test that minidumps are written with reserved memory, including by a
+// handler that reserves less than a dump needs.
+TEST(ExceptionHandlerTest, ReserveDumpMemory) {
+  AutoTempDir temp_dir;
+  ExceptionHandler handler(
+      MinidumpDescriptor(temp_dir.path()), NULL, NULL, NULL, true, -1);
+  ASSERT_TRUE(handler.ReserveDumpMemory(4 << 20));
+  EXPECT_FALSE(handler.ReserveDumpMemory(4 << 20));
+
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_TRUE(handler.WriteMinidump());
+    Minidump minidump(handler.minidump_descriptor().path());
+    ASSERT_TRUE(minidump.Read());
+    ASSERT_TRUE(minidump.GetThreadList());
+    ASSERT_TRUE(minidump.GetModuleList());
+    unlink(handler.minidump_descriptor().path());
+  }
+
+  ExceptionHandler small_handler(
+      MinidumpDescriptor(temp_dir.path()), NULL, NULL, NULL, false, -1);
+  ASSERT_TRUE(small_handler.ReserveDumpMemory(getpagesize()));
+  ASSERT_TRUE(small_handler.WriteMinidump());
+  Minidump minidump(small_handler.minidump_descriptor().path());
+  ASSERT_TRUE(minidump.Read());
+  ASSERT_TRUE(minidump.GetThreadList());
+  unlink(small_handler.minidump_descriptor().path());
+}
+
 #ifndef ADDRESS_SANITIZER
 
 static const unsigned kControlMsgSize =
@@ -29,6 +29,8 @@
 #ifndef CLIENT_LINUX_HANDLER_MICRODUMP_EXTRA_INFO_H_
 #define CLIENT_LINUX_HANDLER_MICRODUMP_EXTRA_INFO_H_
 
+#include <stddef.h>
+
 namespace google_breakpad {
 
 struct MicrodumpExtraInfo {
@@ -39,11 +41,18 @@ struct MicrodumpExtraInfo {
   const char* gpu_fingerprint;
   const char* process_type;
 
+  // The longest line, excluding its newline, that the microdump writer
+  // emits. The stack is hex-encoded into lines of up to this length; the
+  // other lines are never split. Zero picks the longest line a single
+  // logcat entry holds.
+  size_t max_line_length;
+
   MicrodumpExtraInfo()
       : build_fingerprint(NULL),
         product_info(NULL),
         gpu_fingerprint(NULL),
-        process_type(NULL) {}
+        process_type(NULL),
+        max_line_length(0) {}
 };
 
 }
@@ -53,6 +53,10 @@ MinidumpDescriptor::MinidumpDescriptor(const MinidumpDescriptor& descriptor)
       skip_dump_if_principal_mapping_not_referenced_(
           descriptor.skip_dump_if_principal_mapping_not_referenced_),
       sanitize_stacks_(descriptor.sanitize_stacks_),
+      compressed_(descriptor.compressed_),
+      include_unwind_info_(descriptor.include_unwind_info_),
+      crash_signature_frames_(descriptor.crash_signature_frames_),
+      crash_signature_(descriptor.crash_signature_),
       microdump_extra_info_(descriptor.microdump_extra_info_) {
   // The copy constructor is not allowed to be called on a MinidumpDescriptor
   // with a valid path_, as getting its c_path_ would require the heap which
@@ -79,6 +83,10 @@ MinidumpDescriptor& MinidumpDescriptor::operator=(
   skip_dump_if_principal_mapping_not_referenced_ =
       descriptor.skip_dump_if_principal_mapping_not_referenced_;
   sanitize_stacks_ = descriptor.sanitize_stacks_;
+  compressed_ = descriptor.compressed_;
+  include_unwind_info_ = descriptor.include_unwind_info_;
+  crash_signature_frames_ = descriptor.crash_signature_frames_;
+  crash_signature_ = descriptor.crash_signature_;
   microdump_extra_info_ = descriptor.microdump_extra_info_;
   return *this;
 }
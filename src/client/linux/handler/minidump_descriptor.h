@@ -55,7 +55,11 @@ class MinidumpDescriptor {
         fd_(-1),
         size_limit_(-1),
         address_within_principal_mapping_(0),
-        skip_dump_if_principal_mapping_not_referenced_(false) {}
+        skip_dump_if_principal_mapping_not_referenced_(false),
+        compressed_(false),
+        include_unwind_info_(false),
+        crash_signature_frames_(0),
+        crash_signature_(0) {}
 
   explicit MinidumpDescriptor(const string& directory)
       : mode_(kWriteMinidumpToFile),
@@ -65,10 +69,16 @@ class MinidumpDescriptor {
         size_limit_(-1),
         address_within_principal_mapping_(0),
         skip_dump_if_principal_mapping_not_referenced_(false),
-        sanitize_stacks_(false) {
+        sanitize_stacks_(false),
+        compressed_(false),
+        include_unwind_info_(false),
+        crash_signature_frames_(0),
+        crash_signature_(0) {
     assert(!directory.empty());
   }
 
+  // |fd| may be a pipe or a socket, for instance to stream the minidump
+  // to an uploader or a compressor without writing it to disk.
   explicit MinidumpDescriptor(int fd)
       : mode_(kWriteMinidumpToFd),
         fd_(fd),
@@ -76,7 +86,11 @@ class MinidumpDescriptor {
         size_limit_(-1),
         address_within_principal_mapping_(0),
         skip_dump_if_principal_mapping_not_referenced_(false),
-        sanitize_stacks_(false) {
+        sanitize_stacks_(false),
+        compressed_(false),
+        include_unwind_info_(false),
+        crash_signature_frames_(0),
+        crash_signature_(0) {
     assert(fd != -1);
   }
 
@@ -86,7 +100,11 @@ class MinidumpDescriptor {
         size_limit_(-1),
         address_within_principal_mapping_(0),
         skip_dump_if_principal_mapping_not_referenced_(false),
-        sanitize_stacks_(false) {}
+        sanitize_stacks_(false),
+        compressed_(false),
+        include_unwind_info_(false),
+        crash_signature_frames_(0),
+        crash_signature_(0) {}
 
   explicit MinidumpDescriptor(const MinidumpDescriptor& descriptor);
   MinidumpDescriptor& operator=(const MinidumpDescriptor& descriptor);
@@ -134,6 +152,41 @@ class MinidumpDescriptor {
     sanitize_stacks_ = sanitize_stacks;
   }
 
+  // If set, the minidump is written compressed, in the layout that
+  // common/compressed_minidump.h describes.  Minidump::Open in the
+  // processor reads such files as it does plain minidumps.
+  bool compressed() const { return compressed_; }
+  void set_compressed(bool compressed) { compressed_ = compressed; }
+
+  // If set, the minidump includes the .eh_frame_hdr and .eh_frame sections
+  // of the modules that threads are running in or that the crashing
+  // thread's stack points into, so that the processor can unwind through
+  // them without symbols.
+  bool include_unwind_info() const { return include_unwind_info_; }
+  void set_include_unwind_info(bool include_unwind_info) {
+    include_unwind_info_ = include_unwind_info;
+  }
+
+  // If non-zero, the handler computes a quick signature of each crash from
+  // the crashing instruction and up to this many frames in all, found by
+  // following frame pointers, and writes it to the minidump's
+  // MD_CRASH_SIGNATURE_STREAM.  See client/crash_signature.h.  Addresses
+  // are looked up in the handler's module table, so this does nothing
+  // unless ExceptionHandler::EnableModuleTable() was called.
+  size_t crash_signature_frames() const { return crash_signature_frames_; }
+  void set_crash_signature_frames(size_t frames) {
+    crash_signature_frames_ = frames;
+  }
+
+  // The signature of the last dump written with this descriptor, or 0 if
+  // it has none, for the MinidumpCallback to send with the report or to
+  // give to CrashReportQueue::Enqueue().  CrashSignature::Format() turns it
+  // into text.
+  uint64_t crash_signature() const { return crash_signature_; }
+  void set_crash_signature(uint64_t signature) {
+    crash_signature_ = signature;
+  }
+
   MicrodumpExtraInfo* microdump_extra_info() {
     assert(IsMicrodumpOnConsole());
     return &microdump_extra_info_;
@@ -182,6 +235,17 @@ class MinidumpDescriptor {
   // register values, but elides strings and other program data.
   bool sanitize_stacks_;
 
+  // If set, the minidump is compressed as it is written.
+  bool compressed_;
+
+  // If set, modules' unwind information is written to the minidump.
+  bool include_unwind_info_;
+
+  // How many frames a crash signature covers, or 0 for none, and the
+  // signature of the last dump.
+  size_t crash_signature_frames_;
+  uint64_t crash_signature_;
+
   // The extra microdump data (e.g. product name/version, build
   // fingerprint, gpu fingerprint) that should be appended to the dump
   // (microdump only). Microdumps don't have the ability of appending
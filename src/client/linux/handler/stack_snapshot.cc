@@ -0,0 +1,450 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "client/linux/handler/stack_snapshot.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "client/linux/dump_writer_common/module_table.h"
+#include "client/linux/dump_writer_common/ucontext_reader.h"
+#include "client/minidump_file_writer-inl.h"
+#include "common/linux/linux_libc_support.h"
+#include "google_breakpad/common/minidump_format.h"
+#include "third_party/lss/linux_syscall_support.h"
+
+namespace google_breakpad {
+
+namespace {
+
+// The snapshot whose signal handler is installed, and the thread it is
+// waiting on, if any.  The thread takes the request by swapping it for
+// NULL, and the caller gives up on it the same way, so only one of them
+// ever does.
+StackSnapshot* g_snapshot = NULL;
+std::atomic<void*> g_request(NULL);
+
+// Copies |size| bytes of a stack.  The stack holds AddressSanitizer's
+// poisoned redzones, so the copy is made without memcpy(), and unchecked.
+#if defined(__clang__) || defined(__GNUC__)
+__attribute__((no_sanitize_address))
+#endif
+void CopyStack(uint8_t* dest, const volatile uint8_t* src, size_t size) {
+  for (size_t i = 0; i < size; ++i)
+    dest[i] = src[i];
+}
+
+int64_t MonotonicMilliseconds() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+}  // namespace
+
+StackSnapshot::StackSnapshot(size_t max_threads, size_t max_stack_size,
+                             int signal)
+    : max_threads_(max_threads),
+      max_stack_size_(max_stack_size),
+      signal_(signal),
+      initialized_(false),
+      thread_count_(0) {
+  memset(&old_action_, 0, sizeof(old_action_));
+}
+
+StackSnapshot::~StackSnapshot() {
+  if (!initialized_)
+    return;
+  sigaction(signal_, &old_action_, NULL);
+  g_snapshot = NULL;
+}
+
+bool StackSnapshot::Init() {
+  if (initialized_ || g_snapshot || !max_threads_)
+    return false;
+
+  threads_.reset(new Thread[max_threads_]);
+  stacks_.reset(new uint8_t[max_threads_ * max_stack_size_]);
+  // Touch the memory now, so that threads don't fault it in while they
+  // are held up.
+  memset(stacks_.get(), 0, max_threads_ * max_stack_size_);
+  for (size_t i = 0; i < max_threads_; ++i) {
+    memset(&threads_[i].context, 0, sizeof(threads_[i].context));
+    threads_[i].stack = stacks_.get() + i * max_stack_size_;
+    threads_[i].captured.store(false);
+  }
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  sigemptyset(&action.sa_mask);
+  action.sa_sigaction = SignalHandler;
+  action.sa_flags = SA_SIGINFO | SA_RESTART;
+  g_snapshot = this;
+  if (sigaction(signal_, &action, &old_action_) == -1) {
+    g_snapshot = NULL;
+    return false;
+  }
+  initialized_ = true;
+  return true;
+}
+
+size_t StackSnapshot::Capture() {
+  thread_count_ = 0;
+  if (!initialized_ || !ReadRanges())
+    return 0;
+
+  DIR* dir = opendir("/proc/self/task");
+  if (!dir)
+    return 0;
+  const pid_t self = sys_gettid();
+  while (thread_count_ < max_threads_) {
+    struct dirent* entry = readdir(dir);
+    if (!entry)
+      break;
+    int tid;
+    if (!my_strtoui(&tid, entry->d_name) || tid == self)
+      continue;
+    Thread* thread = &threads_[thread_count_];
+    thread->context.tid = tid;
+    if (SignalThread(thread))
+      ++thread_count_;
+  }
+  closedir(dir);
+  return thread_count_;
+}
+
+bool StackSnapshot::WriteMinidump(const char* path,
+                                  const ModuleTable* module_table) const {
+  MinidumpFileWriter writer;
+  if (!writer.Open(path))
+    return false;
+  return Write(&writer, module_table) && writer.Close();
+}
+
+bool StackSnapshot::WriteMinidump(int fd,
+                                  const ModuleTable* module_table) const {
+  // The file descriptor is the caller's to close.
+  MinidumpFileWriter writer;
+  writer.SetFile(fd);
+  return Write(&writer, module_table);
+}
+
+// static
+void StackSnapshot::SignalHandler(int /*sig*/, siginfo_t* info, void* uc) {
+  // Ignore the signal unless this process sent it.
+  if (info->si_code != SI_TKILL || info->si_pid != getpid())
+    return;
+
+  const int saved_errno = errno;
+  void* request = g_request.load(std::memory_order_acquire);
+  Thread* thread = static_cast<Thread*>(request);
+  if (thread && thread->context.tid == sys_gettid() &&
+      g_request.compare_exchange_strong(request, NULL,
+                                        std::memory_order_acquire)) {
+    g_snapshot->CaptureThread(thread, static_cast<ucontext_t*>(uc));
+    thread->captured.store(true, std::memory_order_release);
+  }
+  errno = saved_errno;
+}
+
+bool StackSnapshot::ReadRanges() {
+  FILE* maps = fopen("/proc/self/maps", "r");
+  if (!maps)
+    return false;
+  ranges_.clear();
+  char line[PATH_MAX + 128];
+  while (fgets(line, sizeof(line), maps)) {
+    Range range;
+    const char* next = my_read_hex_ptr(&range.start, line);
+    if (*next == '-')
+      next = my_read_hex_ptr(&range.end, next + 1);
+    if (*next != ' ' || next[1] != 'r')
+      continue;
+    // Neighbouring ranges are merged, so that a stack is not cut short
+    // where the kernel happens to have split its mapping.
+    if (!ranges_.empty() && ranges_.back().end == range.start)
+      ranges_.back().end = range.end;
+    else
+      ranges_.push_back(range);
+  }
+  fclose(maps);
+  return true;
+}
+
+// This runs in a signal handler on the captured thread.
+void StackSnapshot::CaptureThread(Thread* thread, ucontext_t* uc) const {
+  memcpy(&thread->context.context, uc, sizeof(ucontext_t));
+#if defined(__aarch64__)
+  struct fpsimd_context* fp_ptr =
+      (struct fpsimd_context*)&uc->uc_mcontext.__reserved;
+  if (fp_ptr->head.magic == FPSIMD_MAGIC) {
+    memcpy(&thread->context.float_state, fp_ptr,
+           sizeof(thread->context.float_state));
+  }
+#elif GOOGLE_BREAKPAD_CRASH_CONTEXT_HAS_FLOAT_STATE
+  if (uc->uc_mcontext.fpregs) {
+    memcpy(&thread->context.float_state, uc->uc_mcontext.fpregs,
+           sizeof(thread->context.float_state));
+  }
+#endif
+
+  // Copy from the stack pointer up to the end of its range of addresses,
+  // or as much of that as there is room for.
+  const uintptr_t stack_pointer = UContextReader::GetStackPointer(uc);
+  thread->stack_pointer = stack_pointer;
+  thread->stack_size = 0;
+  const Range* range = std::upper_bound(
+      ranges_.data(), ranges_.data() + ranges_.size(), stack_pointer,
+      [](uintptr_t address, const Range& r) { return address < r.end; });
+  if (range == ranges_.data() + ranges_.size() ||
+      stack_pointer < range->start) {
+    return;
+  }
+  thread->stack_size = std::min(max_stack_size_,
+                                static_cast<size_t>(range->end -
+                                                    stack_pointer));
+  CopyStack(thread->stack, reinterpret_cast<const uint8_t*>(stack_pointer),
+            thread->stack_size);
+}
+
+bool StackSnapshot::SignalThread(Thread* thread) {
+  thread->captured.store(false, std::memory_order_relaxed);
+  g_request.store(thread, std::memory_order_release);
+  if (sys_tgkill(getpid(), thread->context.tid, signal_) != 0) {
+    // The thread has exited.
+    g_request.store(NULL, std::memory_order_relaxed);
+    return false;
+  }
+
+  const int64_t deadline = MonotonicMilliseconds() + kThreadTimeoutMs;
+  while (!thread->captured.load(std::memory_order_acquire)) {
+    if (MonotonicMilliseconds() > deadline) {
+      // Give up on the thread, unless it has started capturing itself, in
+      // which case it will soon be done.
+      void* request = thread;
+      if (g_request.compare_exchange_strong(request, NULL))
+        return false;
+    }
+    sched_yield();
+  }
+  return true;
+}
+
+bool StackSnapshot::Write(MinidumpFileWriter* writer,
+                          const ModuleTable* module_table) const {
+  static const unsigned kNumStreams = 4;
+  TypedMDRVA<MDRawDirectory> dir(writer);
+  {
+    // The header is written out when |header| goes out of scope.
+    TypedMDRVA<MDRawHeader> header(writer);
+    if (!header.Allocate() || !dir.AllocateArray(kNumStreams))
+      return false;
+    my_memset(header.get(), 0, sizeof(MDRawHeader));
+    header.get()->signature = MD_HEADER_SIGNATURE;
+    header.get()->version = MD_HEADER_VERSION;
+    header.get()->time_date_stamp = time(NULL);
+    header.get()->stream_count = kNumStreams;
+    header.get()->stream_directory_rva = dir.position();
+  }
+
+  MDRawDirectory dirent;
+  std::vector<MDMemoryDescriptor> stacks;
+  if (!WriteThreadListStream(writer, &dirent, &stacks))
+    return false;
+  dir.CopyIndex(0, &dirent);
+  if (!WriteMemoryListStream(writer, stacks, &dirent))
+    return false;
+  dir.CopyIndex(1, &dirent);
+  if (!WriteModuleListStream(writer, module_table, &dirent))
+    return false;
+  dir.CopyIndex(2, &dirent);
+  if (!WriteSystemInfoStream(writer, &dirent))
+    return false;
+  dir.CopyIndex(3, &dirent);
+
+  return writer->Flush();
+}
+
+bool StackSnapshot::WriteThreadListStream(
+    MinidumpFileWriter* writer,
+    MDRawDirectory* dirent,
+    std::vector<MDMemoryDescriptor>* stacks) const {
+  TypedMDRVA<uint32_t> list(writer);
+  // An empty list is still written; AllocateObjectAndArray() needs at least
+  // one element.
+  if (thread_count_ ? !list.AllocateObjectAndArray(thread_count_,
+                                                   sizeof(MDRawThread))
+                    : !list.Allocate()) {
+    return false;
+  }
+  dirent->stream_type = MD_THREAD_LIST_STREAM;
+  dirent->location = list.location();
+  *list.get() = thread_count_;
+
+  for (size_t i = 0; i < thread_count_; ++i) {
+    const Thread& thread = threads_[i];
+    MDRawThread raw_thread;
+    my_memset(&raw_thread, 0, sizeof(raw_thread));
+    raw_thread.thread_id = thread.context.tid;
+
+    if (thread.stack_size) {
+      UntypedMDRVA stack(writer);
+      if (!stack.Allocate(thread.stack_size) ||
+          !stack.Copy(thread.stack, thread.stack_size)) {
+        return false;
+      }
+      raw_thread.stack.start_of_memory_range = thread.stack_pointer;
+      raw_thread.stack.memory = stack.location();
+      stacks->push_back(raw_thread.stack);
+    }
+
+    TypedMDRVA<RawContextCPU> cpu(writer);
+    if (!cpu.Allocate())
+      return false;
+    my_memset(cpu.get(), 0, sizeof(RawContextCPU));
+#if GOOGLE_BREAKPAD_CRASH_CONTEXT_HAS_FLOAT_STATE
+    UContextReader::FillCPUContext(cpu.get(), &thread.context.context,
+                                   &thread.context.float_state);
+#else
+    UContextReader::FillCPUContext(cpu.get(), &thread.context.context);
+#endif
+    raw_thread.thread_context = cpu.location();
+    list.CopyIndexAfterObject(i, &raw_thread, sizeof(raw_thread));
+  }
+  return true;
+}
+
+bool StackSnapshot::WriteMemoryListStream(
+    MinidumpFileWriter* writer,
+    const std::vector<MDMemoryDescriptor>& stacks,
+    MDRawDirectory* dirent) const {
+  TypedMDRVA<uint32_t> list(writer);
+  if (stacks.empty() ? !list.Allocate()
+                     : !list.AllocateObjectAndArray(
+                           stacks.size(), sizeof(MDMemoryDescriptor))) {
+    return false;
+  }
+  dirent->stream_type = MD_MEMORY_LIST_STREAM;
+  dirent->location = list.location();
+  *list.get() = stacks.size();
+  for (size_t i = 0; i < stacks.size(); ++i)
+    list.CopyIndexAfterObject(i, &stacks[i], sizeof(MDMemoryDescriptor));
+  return true;
+}
+
+bool StackSnapshot::WriteModuleListStream(MinidumpFileWriter* writer,
+                                          const ModuleTable* module_table,
+                                          MDRawDirectory* dirent) const {
+  const size_t num_modules = module_table ? module_table->size() : 0;
+  TypedMDRVA<uint32_t> list(writer);
+  if (num_modules ? !list.AllocateObjectAndArray(num_modules, MD_MODULE_SIZE)
+                  : !list.Allocate()) {
+    return false;
+  }
+  dirent->stream_type = MD_MODULE_LIST_STREAM;
+  dirent->location = list.location();
+
+  size_t count = 0;
+  for (size_t i = 0; i < num_modules; ++i) {
+    const ModuleTable::Entry* entry = module_table->GetEntryAtIndex(i);
+    if (!entry)
+      break;
+    MDRawModule module;
+    my_memset(&module, 0, MD_MODULE_SIZE);
+    module.base_of_image = entry->start_addr;
+    module.size_of_image = entry->end_addr - entry->start_addr;
+    MDLocationDescriptor name;
+    if (!writer->WriteString(entry->name, 0, &name))
+      return false;
+    module.module_name_rva = name.rva;
+
+    UntypedMDRVA cv(writer);
+    if (!cv.Allocate(MDCVInfoELF_minsize + entry->identifier_size))
+      return false;
+    const uint32_t cv_signature = MD_CVINFOELF_SIGNATURE;
+    cv.Copy(&cv_signature, sizeof(cv_signature));
+    cv.Copy(cv.position() + sizeof(cv_signature), entry->identifier,
+            entry->identifier_size);
+    module.cv_record = cv.location();
+
+    list.CopyIndexAfterObject(count++, &module, MD_MODULE_SIZE);
+  }
+  // The table may have shrunk while it was being read.
+  *list.get() = count;
+  return true;
+}
+
+bool StackSnapshot::WriteSystemInfoStream(MinidumpFileWriter* writer,
+                                          MDRawDirectory* dirent) const {
+  TypedMDRVA<MDRawSystemInfo> info(writer);
+  if (!info.Allocate())
+    return false;
+  dirent->stream_type = MD_SYSTEM_INFO_STREAM;
+  dirent->location = info.location();
+
+  my_memset(info.get(), 0, sizeof(MDRawSystemInfo));
+  info.get()->processor_architecture =
+#if defined(__i386__)
+      MD_CPU_ARCHITECTURE_X86;
+#elif defined(__x86_64__)
+      MD_CPU_ARCHITECTURE_AMD64;
+#elif defined(__aarch64__)
+      MD_CPU_ARCHITECTURE_ARM64_OLD;
+#elif defined(__arm__)
+      MD_CPU_ARCHITECTURE_ARM;
+#elif defined(__mips__) && _MIPS_SIM == _ABIO32
+      MD_CPU_ARCHITECTURE_MIPS;
+#elif defined(__mips__)
+      MD_CPU_ARCHITECTURE_MIPS64;
+#elif defined(__riscv) && __riscv_xlen == 32
+      MD_CPU_ARCHITECTURE_RISCV;
+#elif defined(__riscv)
+      MD_CPU_ARCHITECTURE_RISCV64;
+#endif
+  const long num_processors = sysconf(_SC_NPROCESSORS_ONLN);
+  info.get()->number_of_processors =
+      num_processors > 0 && num_processors < 256 ? num_processors : 0;
+#if defined(__ANDROID__)
+  info.get()->platform_id = MD_OS_ANDROID;
+#else
+  info.get()->platform_id = MD_OS_LINUX;
+#endif
+  return true;
+}
+
+}  // namespace google_breakpad
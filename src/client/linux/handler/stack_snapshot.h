@@ -0,0 +1,160 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// stack_snapshot.h: Captures the registers and the tops of the stacks of
+// all of the threads of this process, for reports of hangs.
+//
+// ExceptionHandler::WriteMinidump() stops every thread with ptrace from a
+// cloned process and writes the whole of every stack, the module list and
+// a number of /proc files.  That is more than a watchdog that checks on a
+// slow process every few seconds can afford.  A StackSnapshot instead
+// signals each thread in turn; the thread copies its registers and the top
+// of its stack into memory set aside beforehand, and carries on.  Each
+// thread is held up only while it copies, and nothing else is read until
+// the snapshot is written out as a small minidump.
+//
+// Signals interrupt blocking system calls.  The handler is installed with
+// SA_RESTART, but calls that are never restarted, such as poll() and
+// nanosleep(), return EINTR to a thread captured while it waits in one.
+
+#ifndef CLIENT_LINUX_HANDLER_STACK_SNAPSHOT_H_
+#define CLIENT_LINUX_HANDLER_STACK_SNAPSHOT_H_
+
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <atomic>
+#include <vector>
+
+#include "client/linux/handler/exception_handler.h"
+#include "common/scoped_ptr.h"
+#include "google_breakpad/common/minidump_format.h"
+
+namespace google_breakpad {
+
+class MinidumpFileWriter;
+class ModuleTable;
+
+class StackSnapshot {
+ public:
+  // The most time a thread is given to respond to the signal before it is
+  // left out of a snapshot.
+  static const int kThreadTimeoutMs = 100;
+
+  // Sets aside room for up to |max_threads| threads and the top
+  // |max_stack_size| bytes of each one's stack.  Threads are signalled with
+  // |signal|, which the process must not use for anything else.
+  StackSnapshot(size_t max_threads, size_t max_stack_size, int signal);
+  ~StackSnapshot();
+
+  StackSnapshot(const StackSnapshot&) = delete;
+  void operator=(const StackSnapshot&) = delete;
+
+  // Allocates the memory and installs the signal handler.  Only one
+  // StackSnapshot can be initialized at a time.  Returns false on failure.
+  bool Init();
+
+  // Captures every thread of the process but the calling one, up to
+  // |max_threads|, and returns how many were captured.  Threads that
+  // block the signal, or don't handle it in time, are left out.  Only one
+  // thread may call this at a time.
+  size_t Capture();
+
+  // Writes the most recent capture as a minidump holding the threads, their
+  // stacks, the modules in |module_table| and system information.  Keeping
+  // |module_table| current is up to the caller; see
+  // ExceptionHandler::EnableModuleTable().  It may be NULL, though the
+  // stacks can't be symbolized without modules.
+  bool WriteMinidump(const char* path, const ModuleTable* module_table) const;
+  bool WriteMinidump(int fd, const ModuleTable* module_table) const;
+
+  // The number of threads in the most recent capture.
+  size_t thread_count() const { return thread_count_; }
+
+ private:
+  // A captured thread.
+  struct Thread {
+    // The registers, in the form a crash reports them.  Only the tid,
+    // context and float_state members are used.
+    ExceptionHandler::CrashContext context;
+    // The address of the top of the stack and the number of bytes copied
+    // from there to |stack|.
+    uintptr_t stack_pointer;
+    size_t stack_size;
+    uint8_t* stack;
+    // Set by the thread once the above are filled in.
+    std::atomic<bool> captured;
+  };
+
+  // A readable range of addresses, from /proc/self/maps.
+  struct Range {
+    uintptr_t start;
+    uintptr_t end;
+  };
+
+  static void SignalHandler(int sig, siginfo_t* info, void* uc);
+
+  // Reads the readable ranges of the address space into |ranges_|, for
+  // the threads to bound their stacks by.
+  bool ReadRanges();
+  // Fills in |thread| from the signal context |uc|, on the thread.
+  void CaptureThread(Thread* thread, ucontext_t* uc) const;
+  // Signals |thread|'s thread and waits for it to capture itself.  Returns
+  // false if it doesn't do so in time.
+  bool SignalThread(Thread* thread);
+
+  bool Write(MinidumpFileWriter* writer,
+             const ModuleTable* module_table) const;
+  bool WriteThreadListStream(MinidumpFileWriter* writer,
+                             MDRawDirectory* dirent,
+                             std::vector<MDMemoryDescriptor>* stacks) const;
+  bool WriteMemoryListStream(MinidumpFileWriter* writer,
+                             const std::vector<MDMemoryDescriptor>& stacks,
+                             MDRawDirectory* dirent) const;
+  bool WriteModuleListStream(MinidumpFileWriter* writer,
+                             const ModuleTable* module_table,
+                             MDRawDirectory* dirent) const;
+  bool WriteSystemInfoStream(MinidumpFileWriter* writer,
+                             MDRawDirectory* dirent) const;
+
+  const size_t max_threads_;
+  const size_t max_stack_size_;
+  const int signal_;
+  bool initialized_;
+  scoped_array<Thread> threads_;
+  scoped_array<uint8_t> stacks_;
+  size_t thread_count_;
+  std::vector<Range> ranges_;
+  struct sigaction old_action_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // CLIENT_LINUX_HANDLER_STACK_SNAPSHOT_H_
@@ -0,0 +1,198 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "client/linux/dump_writer_common/module_table.h"
+#include "client/linux/handler/stack_snapshot.h"
+#include "common/tests/auto_tempdir.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/minidump.h"
+
+using namespace google_breakpad;
+
+namespace {
+
+const int kSignal = SIGURG;
+const uint64_t kMarker = 0x5354414b534e4150ULL;
+
+// A thread that leaves a marker on its stack, reports its id and then
+// waits to be told to exit.
+struct Worker {
+  pthread_t thread;
+  pid_t tid;
+  int ready[2];
+  int done[2];
+  bool block_signal;
+};
+
+void* WorkerMain(void* arg) {
+  Worker* worker = static_cast<Worker*>(arg);
+  if (worker->block_signal) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, kSignal);
+    pthread_sigmask(SIG_BLOCK, &set, NULL);
+  }
+  volatile uint64_t marker = kMarker;
+  worker->tid = syscall(__NR_gettid);
+  char c = 0;
+  EXPECT_EQ(1, write(worker->ready[1], &c, 1));
+  // The read is restarted after each capture.
+  EXPECT_EQ(1, read(worker->done[0], &c, 1));
+  EXPECT_EQ(kMarker, marker);
+  return NULL;
+}
+
+class StackSnapshotTest : public testing::Test {
+ public:
+  void StartWorkers(size_t count, bool block_signal) {
+    workers_.resize(count);
+    for (Worker& worker : workers_) {
+      worker.block_signal = block_signal;
+      ASSERT_EQ(0, pipe(worker.ready));
+      ASSERT_EQ(0, pipe(worker.done));
+      ASSERT_EQ(0, pthread_create(&worker.thread, NULL, WorkerMain, &worker));
+      char c;
+      ASSERT_EQ(1, read(worker.ready[0], &c, 1));
+    }
+  }
+
+  void TearDown() override {
+    for (Worker& worker : workers_) {
+      char c = 0;
+      EXPECT_EQ(1, write(worker.done[1], &c, 1));
+      pthread_join(worker.thread, NULL);
+      close(worker.ready[0]);
+      close(worker.ready[1]);
+      close(worker.done[0]);
+      close(worker.done[1]);
+    }
+  }
+
+  std::vector<Worker> workers_;
+  AutoTempDir temp_dir_;
+};
+
+// Returns whether |memory| holds kMarker.
+bool HoldsMarker(MinidumpMemoryRegion* memory) {
+  const uint8_t* bytes = memory->GetMemory();
+  const size_t size = memory->GetSize();
+  for (size_t i = 0; i + sizeof(kMarker) <= size; i += sizeof(kMarker)) {
+    uint64_t value;
+    memcpy(&value, bytes + i, sizeof(value));
+    if (value == kMarker)
+      return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+TEST_F(StackSnapshotTest, NotInitialized) {
+  StackSnapshot snapshot(16, 4096, kSignal);
+  EXPECT_EQ(0U, snapshot.Capture());
+}
+
+TEST_F(StackSnapshotTest, OnlyOneInitialized) {
+  StackSnapshot snapshot(16, 4096, kSignal);
+  ASSERT_TRUE(snapshot.Init());
+  EXPECT_FALSE(snapshot.Init());
+  StackSnapshot other(16, 4096, kSignal);
+  EXPECT_FALSE(other.Init());
+}
+
+TEST_F(StackSnapshotTest, CapturesThreads) {
+  StartWorkers(4, false);
+  ModuleTable module_table(1024);
+  ASSERT_TRUE(module_table.Update());
+
+  StackSnapshot snapshot(64, 16 * 1024, kSignal);
+  ASSERT_TRUE(snapshot.Init());
+  ASSERT_GE(snapshot.Capture(), workers_.size());
+  // Capturing again replaces the previous capture.
+  ASSERT_GE(snapshot.Capture(), workers_.size());
+
+  const string path = temp_dir_.path() + "/snapshot.dmp";
+  ASSERT_TRUE(snapshot.WriteMinidump(path.c_str(), &module_table));
+
+  Minidump minidump(path);
+  ASSERT_TRUE(minidump.Read());
+  MinidumpThreadList* threads = minidump.GetThreadList();
+  ASSERT_TRUE(threads);
+  EXPECT_EQ(snapshot.thread_count(), threads->thread_count());
+  for (const Worker& worker : workers_) {
+    MinidumpThread* thread = threads->GetThreadByID(worker.tid);
+    ASSERT_TRUE(thread);
+    ASSERT_TRUE(thread->GetContext());
+    MinidumpMemoryRegion* stack = thread->GetMemory();
+    ASSERT_TRUE(stack);
+    EXPECT_LE(stack->GetSize(), 16U * 1024);
+    EXPECT_TRUE(HoldsMarker(stack));
+  }
+
+  MinidumpModuleList* modules = minidump.GetModuleList();
+  ASSERT_TRUE(modules);
+  EXPECT_EQ(module_table.size(), modules->module_count());
+  EXPECT_TRUE(modules->GetModuleForAddress(
+      reinterpret_cast<uintptr_t>(&WorkerMain)));
+  EXPECT_TRUE(minidump.GetMemoryList());
+  ASSERT_TRUE(minidump.GetSystemInfo());
+}
+
+TEST_F(StackSnapshotTest, SkipsThreadsBlockingTheSignal) {
+  StartWorkers(2, true);
+
+  StackSnapshot snapshot(64, 4096, kSignal);
+  ASSERT_TRUE(snapshot.Init());
+  snapshot.Capture();
+
+  const string path = temp_dir_.path() + "/snapshot.dmp";
+  ASSERT_TRUE(snapshot.WriteMinidump(path.c_str(), NULL));
+  Minidump minidump(path);
+  ASSERT_TRUE(minidump.Read());
+  MinidumpThreadList* threads = minidump.GetThreadList();
+  ASSERT_TRUE(threads);
+  for (const Worker& worker : workers_)
+    EXPECT_FALSE(threads->GetThreadByID(worker.tid));
+  MinidumpModuleList* modules = minidump.GetModuleList();
+  ASSERT_TRUE(modules);
+  EXPECT_EQ(0U, modules->module_count());
+}
@@ -35,6 +35,7 @@
 
 #include "client/linux/microdump_writer/microdump_writer.h"
 
+#include <algorithm>
 #include <limits>
 
 #include <sys/utsname.h>
@@ -63,7 +64,28 @@ using google_breakpad::RawContextCPU;
 using google_breakpad::ThreadInfo;
 using google_breakpad::UContextReader;
 
-const size_t kLineBufferSize = 2048;
+// The longest line written when MicrodumpExtraInfo leaves it unset. A
+// logcat entry has room for 4068 bytes (LOGGER_ENTRY_MAX_PAYLOAD), which
+// also hold the priority and the NUL-terminated tag and message.
+const size_t kDefaultMaxLineLength = 4000;
+
+// The line buffer holds at least this many characters, whatever the
+// maximum line length, so that the CPU state, which is not split, and
+// the header lines fit.
+const size_t kMinLineCapacity =
+    std::max<size_t>(2047, sizeof("C ") - 1 + 2 * sizeof(RawContextCPU));
+
+// The two hex digits of each byte value.
+struct HexTable {
+  constexpr HexTable() : digits() {
+    for (int i = 0; i < 256; ++i) {
+      digits[2 * i] = "0123456789ABCDEF"[i >> 4];
+      digits[2 * i + 1] = "0123456789ABCDEF"[i & 0x0F];
+    }
+  }
+  char digits[512];
+};
+constexpr HexTable kHexTable;
 
 #if !defined(__LP64__)
 // The following are only used by DumpFreeSpace, so need to be compiled
@@ -151,12 +173,18 @@ class MicrodumpWriter {
         address_within_principal_mapping_(address_within_principal_mapping),
         sanitize_stack_(sanitize_stack),
         microdump_extra_info_(microdump_extra_info),
+        max_line_length_(microdump_extra_info.max_line_length
+                             ? microdump_extra_info.max_line_length
+                             : kDefaultMaxLineLength),
+        line_capacity_(std::max(max_line_length_, kMinLineCapacity)),
         log_line_(NULL),
+        log_line_length_(0),
         stack_copy_(NULL),
         stack_len_(0),
         stack_lower_bound_(0),
         stack_pointer_(0) {
-    log_line_ = reinterpret_cast<char*>(Alloc(kLineBufferSize));
+    // Leave room for the newline and the NUL after a full line.
+    log_line_ = reinterpret_cast<char*>(Alloc(line_capacity_ + 2));
     if (log_line_)
       log_line_[0] = '\0';  // Clear out the log line buffer.
   }
@@ -211,7 +239,9 @@ class MicrodumpWriter {
 
   // Stages the given string in the current line buffer.
   void LogAppend(const char* str) {
-    my_strlcat(log_line_, str, kLineBufferSize);
+    const size_t length = my_strlcpy(log_line_ + log_line_length_, str,
+                                     line_capacity_ - log_line_length_ + 1);
+    log_line_length_ = std::min(log_line_length_ + length, line_capacity_);
   }
 
   // As above (required to take precedence over template specialization below).
@@ -223,11 +253,10 @@ class MicrodumpWriter {
   template<typename T>
   void LogAppend(T value) {
     // Make enough room to hex encode the largest int type + NUL.
-    static const char HEX[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
-                               'A', 'B', 'C', 'D', 'E', 'F'};
     char hexstr[sizeof(T) * 2 + 1];
-    for (int i = sizeof(T) * 2 - 1; i >= 0; --i, value >>= 4)
-      hexstr[i] = HEX[static_cast<uint8_t>(value) & 0x0F];
+    for (int i = sizeof(T) - 1; i >= 0; --i, value >>= 8)
+      my_memcpy(&hexstr[2 * i],
+                &kHexTable.digits[2 * static_cast<uint8_t>(value)], 2);
     hexstr[sizeof(T) * 2] = '\0';
     LogAppend(hexstr);
   }
@@ -235,14 +264,25 @@ class MicrodumpWriter {
   // Stages the buffer content hex-encoded in the current line buffer.
   void LogAppend(const void* buf, size_t length) {
     const uint8_t* ptr = reinterpret_cast<const uint8_t*>(buf);
-    for (size_t i = 0; i < length; ++i, ++ptr)
-      LogAppend(*ptr);
+    length = std::min(length, (line_capacity_ - log_line_length_) / 2);
+    char* out = log_line_ + log_line_length_;
+    for (size_t i = 0; i < length; ++i, out += 2)
+      my_memcpy(out, &kHexTable.digits[2 * ptr[i]], 2);
+    *out = '\0';
+    log_line_length_ += 2 * length;
   }
 
   // Writes out the current line buffer on the system log.
   void LogCommitLine() {
+#if defined(__ANDROID__)
     LogLine(log_line_);
+#else
+    // One write per line: the buffer has room for the newline.
+    log_line_[log_line_length_] = '\n';
+    logger::write(log_line_, log_line_length_ + 1);
+#endif
     log_line_[0] = 0;
+    log_line_length_ = 0;
   }
 
   CaptureResult CaptureCrashingThreadStack(int max_stack_len) {
@@ -405,14 +445,21 @@ class MicrodumpWriter {
     LogAppend(stack_len_);
     LogCommitLine();
 
-    const size_t STACK_DUMP_CHUNK_SIZE = 384;
+    // Fill each line with as many whole words as fit after the
+    // "S <address> " prefix, and at least one.
+    const size_t kPrefixLength = sizeof("S  ") - 1 + 2 * sizeof(uintptr_t);
+    size_t chunk_size = max_line_length_ > kPrefixLength
+                            ? (max_line_length_ - kPrefixLength) / 2
+                            : 0;
+    chunk_size = std::max(chunk_size - chunk_size % sizeof(uintptr_t),
+                          sizeof(uintptr_t));
     for (size_t stack_off = 0; stack_off < stack_len_;
-         stack_off += STACK_DUMP_CHUNK_SIZE) {
+         stack_off += chunk_size) {
       LogAppend("S ");
       LogAppend(stack_lower_bound_ + stack_off);
       LogAppend(" ");
       LogAppend(stack_copy_ + stack_off,
-                std::min(STACK_DUMP_CHUNK_SIZE, stack_len_ - stack_off));
+                std::min(chunk_size, stack_len_ - stack_off));
       LogCommitLine();
     }
   }
@@ -625,7 +672,15 @@ class MicrodumpWriter {
   uintptr_t address_within_principal_mapping_;
   bool sanitize_stack_;
   const MicrodumpExtraInfo microdump_extra_info_;
+
+  // The longest stack line to write, and the number of characters the
+  // line buffer holds.
+  const size_t max_line_length_;
+  const size_t line_capacity_;
+
+  // The line being staged and its length.
   char* log_line_;
+  size_t log_line_length_;
 
   // The local copy of crashed process stack memory, beginning at
   // |stack_lower_bound_|.
@@ -421,4 +421,29 @@ TEST(MicrodumpWriterTest, NoGPUInfo) {
   ASSERT_TRUE(ContainsMicrodump(buf));
   CheckMicrodumpContents(buf, kBuildFingerprint, kProductInfo, "UNKNOWN");
 }
+
+// Ensure that the stack is split into lines no longer than the requested
+// maximum, and that it survives the split.
+TEST(MicrodumpWriterTest, StackLinesFitMaxLineLength) {
+  const size_t kMaxLineLength = 200;
+  MicrodumpExtraInfo microdump_extra_info(
+      MakeMicrodumpExtraInfo("foobar", "bazqux", NULL));
+  microdump_extra_info.max_line_length = kMaxLineLength;
+  std::string buf;
+  MappingList no_mappings;
+
+  CrashAndGetMicrodump(no_mappings, microdump_extra_info, &buf);
+  ASSERT_TRUE(ContainsMicrodump(buf));
+  ASSERT_TRUE(MicrodumpStackContains(buf, kIdentifiableString));
+
+  std::istringstream iss(buf);
+  size_t stack_lines = 0;
+  for (string line; std::getline(iss, line);) {
+    if (line.find("S ") == 0 && line.find("S 0 ") != 0) {
+      EXPECT_LE(line.size(), kMaxLineLength);
+      ++stack_lines;
+    }
+  }
+  EXPECT_GT(stack_lines, 1U);
+}
 }  // namespace
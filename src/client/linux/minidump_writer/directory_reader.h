@@ -37,6 +37,7 @@
 #include <string.h>
 
 #include "common/linux/linux_libc_support.h"
+#include "common/memory_allocator.h"
 #include "third_party/lss/linux_syscall_support.h"
 
 namespace google_breakpad {
@@ -47,9 +48,42 @@ class DirectoryReader {
  public:
   DirectoryReader(int fd)
       : fd_(fd),
+        hit_eof_(false),
+        allocator_(NULL),
+        buf_(inline_buf_),
+        buf_size_(sizeof(inline_buf_)),
+        buf_start_(0),
         buf_used_(0) {
   }
 
+  // Reads entries into a |buffer_size| byte buffer from |allocator| instead
+  // of the room for one entry within the object, so that a large
+  // directory, such as /proc/pid/task of a process with thousands of
+  // threads, takes a getdents call per |buffer_size| bytes of entries
+  // rather than per entry.  If the buffer can't be allocated, the one
+  // within the object is used.
+  DirectoryReader(int fd, PageAllocator* allocator, size_t buffer_size)
+      : fd_(fd),
+        hit_eof_(false),
+        allocator_(allocator),
+        buf_(static_cast<uint8_t*>(allocator->Alloc(buffer_size))),
+        buf_size_(buffer_size),
+        buf_start_(0),
+        buf_used_(0) {
+    if (!buf_ || buffer_size < sizeof(inline_buf_)) {
+      if (buf_)
+        allocator->Free(buf_, buffer_size);
+      allocator_ = NULL;
+      buf_ = inline_buf_;
+      buf_size_ = sizeof(inline_buf_);
+    }
+  }
+
+  ~DirectoryReader() {
+    if (allocator_)
+      allocator_->Free(buf_, buf_size_);
+  }
+
   // Return the next entry from the directory
   //   name: (output) the NUL terminated entry name
   //
@@ -58,12 +92,11 @@ class DirectoryReader {
   // After calling this, one must call |PopEntry| otherwise you'll get the same
   // entry over and over.
   bool GetNextEntry(const char** name) {
-    struct kernel_dirent* const dent =
-      reinterpret_cast<kernel_dirent*>(buf_);
-
-    if (buf_used_ == 0) {
+    if (buf_used_ == 0 && !hit_eof_) {
       // need to read more entries.
-      const int n = sys_getdents(fd_, dent, sizeof(buf_));
+      buf_start_ = 0;
+      const int n = sys_getdents(fd_, reinterpret_cast<kernel_dirent*>(buf_),
+                                 buf_size_);
       if (n < 0) {
         return false;
       } else if (n == 0) {
@@ -78,6 +111,8 @@ class DirectoryReader {
 
     assert(buf_used_ > 0);
 
+    const struct kernel_dirent* const dent =
+      reinterpret_cast<kernel_dirent*>(buf_ + buf_start_);
     *name = dent->d_name;
     return true;
   }
@@ -87,17 +122,23 @@ class DirectoryReader {
       return;
 
     const struct kernel_dirent* const dent =
-      reinterpret_cast<kernel_dirent*>(buf_);
+      reinterpret_cast<kernel_dirent*>(buf_ + buf_start_);
 
     buf_used_ -= dent->d_reclen;
-    my_memmove(buf_, buf_ + dent->d_reclen, buf_used_);
+    buf_start_ += dent->d_reclen;
   }
 
  private:
   const int fd_;
   bool hit_eof_;
+  // The allocator |buf_| came from, or NULL if it is |inline_buf_|.
+  PageAllocator* allocator_;
+  uint8_t* buf_;
+  size_t buf_size_;
+  // The entries not yet popped are the |buf_used_| bytes from |buf_start_|.
+  unsigned buf_start_;
   unsigned buf_used_;
-  uint8_t buf_[sizeof(struct kernel_dirent) + NAME_MAX + 1];
+  uint8_t inline_buf_[sizeof(struct kernel_dirent) + NAME_MAX + 1];
 };
 
 }  // namespace google_breakpad
@@ -38,16 +38,19 @@
 #include <sys/types.h>
 
 #include "client/linux/minidump_writer/directory_reader.h"
+#include "common/memory_allocator.h"
 #include "common/using_std_string.h"
 #include "breakpad_googletest_includes.h"
 
 using namespace google_breakpad;
 
 namespace {
+
 typedef testing::Test DirectoryReaderTest;
-}
 
-TEST(DirectoryReaderTest, CompareResults) {
+// Checks that |dir_reader|, reading /proc/self, returns the entries that
+// readdir does.
+void CompareResults(DirectoryReader* dir_reader) {
   std::set<string> dent_set;
 
   DIR* const dir = opendir("/proc/self");
@@ -59,17 +62,13 @@ TEST(DirectoryReaderTest, CompareResults) {
 
   closedir(dir);
 
-  const int fd = open("/proc/self", O_DIRECTORY | O_RDONLY);
-  ASSERT_GE(fd, 0);
-
-  DirectoryReader dir_reader(fd);
   unsigned seen = 0;
 
   const char* name;
-  while (dir_reader.GetNextEntry(&name)) {
+  while (dir_reader->GetNextEntry(&name)) {
     ASSERT_TRUE(dent_set.find(name) != dent_set.end());
     seen++;
-    dir_reader.PopEntry();
+    dir_reader->PopEntry();
   }
 
   ASSERT_TRUE(dent_set.find("status") != dent_set.end());
@@ -77,5 +76,26 @@ TEST(DirectoryReaderTest, CompareResults) {
   ASSERT_TRUE(dent_set.find("cmdline") != dent_set.end());
 
   ASSERT_EQ(dent_set.size(), seen);
+}
+
+}  // namespace
+
+TEST(DirectoryReaderTest, CompareResults) {
+  const int fd = open("/proc/self", O_DIRECTORY | O_RDONLY);
+  ASSERT_GE(fd, 0);
+
+  DirectoryReader dir_reader(fd);
+  CompareResults(&dir_reader);
+  close(fd);
+}
+
+TEST(DirectoryReaderTest, CompareResultsBuffered) {
+  // Many entries are read at once into a buffer from an allocator.
+  const int fd = open("/proc/self", O_DIRECTORY | O_RDONLY);
+  ASSERT_GE(fd, 0);
+
+  PageAllocator allocator;
+  DirectoryReader dir_reader(fd, &allocator, 4096);
+  CompareResults(&dir_reader);
   close(fd);
 }
@@ -34,6 +34,7 @@
 #include <string.h>
 
 #include "common/linux/linux_libc_support.h"
+#include "common/memory_allocator.h"
 #include "third_party/lss/linux_syscall_support.h"
 
 namespace google_breakpad {
@@ -45,9 +46,39 @@ class LineReader {
   LineReader(int fd)
       : fd_(fd),
         hit_eof_(false),
+        allocator_(NULL),
+        buf_(inline_buf_),
+        buf_size_(sizeof(inline_buf_)),
+        buf_start_(0),
         buf_used_(0) {
   }
 
+  // Reads through a |buffer_size| byte buffer from |allocator| instead of
+  // the kMaxLineLen bytes within the object, so that a long file, such as
+  // the maps of a process with many mappings, takes a read per
+  // |buffer_size| bytes rather than per few lines.  Lines may then be up to
+  // |buffer_size| bytes long.  If the buffer can't be allocated, the one
+  // within the object is used.
+  LineReader(int fd, PageAllocator* allocator, size_t buffer_size)
+      : fd_(fd),
+        hit_eof_(false),
+        allocator_(allocator),
+        buf_(static_cast<char*>(allocator->Alloc(buffer_size))),
+        buf_size_(buffer_size),
+        buf_start_(0),
+        buf_used_(0) {
+    if (!buf_) {
+      allocator_ = NULL;
+      buf_ = inline_buf_;
+      buf_size_ = sizeof(inline_buf_);
+    }
+  }
+
+  ~LineReader() {
+    if (allocator_)
+      allocator_->Free(buf_, buf_size_);
+  }
+
   // The maximum length of a line.
   static const size_t kMaxLineLen = 512;
 
@@ -65,26 +96,34 @@ class LineReader {
       if (buf_used_ == 0 && hit_eof_)
         return false;
 
+      char* const start = buf_ + buf_start_;
       for (unsigned i = 0; i < buf_used_; ++i) {
-        if (buf_[i] == '\n' || buf_[i] == 0) {
-          buf_[i] = 0;
+        if (start[i] == '\n' || start[i] == 0) {
+          start[i] = 0;
           *len = i;
-          *line = buf_;
+          *line = start;
           return true;
         }
       }
 
-      if (buf_used_ == sizeof(buf_)) {
+      if (buf_used_ == buf_size_) {
         // we scanned the whole buffer and didn't find an end-of-line marker.
         // This line is too long to process.
         return false;
       }
 
+      // Move the partial line to the front of the buffer, once per read
+      // rather than once per line.
+      if (buf_start_) {
+        my_memmove(buf_, start, buf_used_);
+        buf_start_ = 0;
+      }
+
       // We didn't find any end-of-line terminators in the buffer. However, if
       // this is the last line in the file it might not have one:
       if (hit_eof_) {
         assert(buf_used_);
-        // There's room for the NUL because of the buf_used_ == sizeof(buf_)
+        // There's room for the NUL because of the buf_used_ == buf_size_
         // check above.
         buf_[buf_used_] = 0;
         *len = buf_used_;
@@ -95,7 +134,7 @@ class LineReader {
 
       // Otherwise, we should pull in more data from the file
       const ssize_t n = sys_read(fd_, buf_ + buf_used_,
-                                 sizeof(buf_) - buf_used_);
+                                 buf_size_ - buf_used_);
       if (n < 0) {
         return false;
       } else if (n == 0) {
@@ -114,15 +153,105 @@ class LineReader {
 
     assert(buf_used_ >= len + 1);
     buf_used_ -= len + 1;
-    my_memmove(buf_, buf_ + len + 1, buf_used_);
+    buf_start_ = buf_used_ ? buf_start_ + len + 1 : 0;
   }
 
  private:
   const int fd_;
 
   bool hit_eof_;
+  // The allocator |buf_| came from, or NULL if it is |inline_buf_|.
+  PageAllocator* allocator_;
+  char* buf_;
+  size_t buf_size_;
+  // The unread lines are the |buf_used_| bytes from |buf_start_|.
+  unsigned buf_start_;
   unsigned buf_used_;
-  char buf_[kMaxLineLen];
+  char inline_buf_[kMaxLineLen];
+};
+
+// A class for reading a whole file, such as a file in /proc whose size
+// can't be known before it is read, into memory from a PageAllocator, and
+// then parsing it in place, line by line, as LineReader does.  Reading it
+// takes as few reads as there are buffers full, with nothing copied
+// between them, and taking its lines none at all.
+class WholeFileReader {
+ public:
+  // |buffer_size| is a guess at the size of the file.  The buffer is
+  // doubled until the file fits.
+  WholeFileReader(PageAllocator* allocator, size_t buffer_size)
+      : allocator_(allocator),
+        buf_(NULL),
+        buf_size_(buffer_size < 2 ? 2 : buffer_size),
+        size_(0),
+        line_start_(0) {
+  }
+
+  ~WholeFileReader() {
+    if (buf_)
+      allocator_->Free(buf_, buf_size_);
+  }
+
+  // Reads the rest of the file |fd|, in place of whatever was read before.
+  // Returns false if it can't be read, or the buffer can't be allocated.
+  bool Read(int fd) {
+    size_ = 0;
+    line_start_ = 0;
+    if (!buf_) {
+      buf_ = static_cast<char*>(allocator_->Alloc(buf_size_));
+      if (!buf_)
+        return false;
+    }
+    for (;;) {
+      // One byte is kept to terminate the last line, which may lack a
+      // newline.
+      if (size_ == buf_size_ - 1) {
+        char* const buf = static_cast<char*>(allocator_->Alloc(buf_size_ * 2));
+        if (!buf)
+          return false;
+        my_memcpy(buf, buf_, size_);
+        allocator_->Free(buf_, buf_size_);
+        buf_ = buf;
+        buf_size_ *= 2;
+      }
+      const ssize_t n = sys_read(fd, buf_ + size_, buf_size_ - 1 - size_);
+      if (n < 0)
+        return false;
+      if (n == 0)
+        return true;
+      size_ += n;
+    }
+  }
+
+  // The contents of the file, and its size.
+  const char* data() const { return buf_; }
+  size_t size() const { return size_; }
+
+  // As for LineReader.
+  bool GetNextLine(const char** line, unsigned* len) {
+    if (line_start_ >= size_)
+      return false;
+    char* const start = buf_ + line_start_;
+    size_t i = 0;
+    while (line_start_ + i < size_ && start[i] != '\n' && start[i] != 0)
+      ++i;
+    start[i] = 0;
+    *len = i;
+    *line = start;
+    return true;
+  }
+
+  void PopLine(unsigned len) {
+    line_start_ += len + 1;
+  }
+
+ private:
+  PageAllocator* const allocator_;
+  char* buf_;
+  size_t buf_size_;
+  size_t size_;
+  // The start of the next line within |buf_|.
+  size_t line_start_;
 };
 
 }  // namespace google_breakpad
@@ -30,19 +30,53 @@
 #include <config.h>  // Must come first
 #endif
 
+#include <fcntl.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/types.h>
 
+#include <string>
+
 #include "client/linux/minidump_writer/line_reader.h"
 #include "breakpad_googletest_includes.h"
 #include "common/linux/scoped_tmpfile.h"
+#include "common/memory_allocator.h"
+#include "common/using_std_string.h"
 
 using namespace google_breakpad;
 
 namespace {
 
 typedef testing::Test LineReaderTest;
+typedef testing::Test WholeFileReaderTest;
+
+// Returns |count| numbered lines, the last without a newline.
+string NumberedLines(int count) {
+  string lines;
+  for (int i = 0; i < count; ++i) {
+    char line[32];
+    snprintf(line, sizeof(line), "%sline %d", i ? "\n" : "", i);
+    lines += line;
+  }
+  return lines;
+}
+
+// Checks that |reader| returns the |count| lines of NumberedLines(count).
+template<typename Reader>
+void CheckNumberedLines(Reader* reader, int count) {
+  const char* line;
+  unsigned len;
+  for (int i = 0; i < count; ++i) {
+    char expected[32];
+    snprintf(expected, sizeof(expected), "line %d", i);
+    ASSERT_TRUE(reader->GetNextLine(&line, &len));
+    ASSERT_EQ(strlen(expected), len);
+    ASSERT_STREQ(expected, line);
+    reader->PopLine(len);
+  }
+  ASSERT_FALSE(reader->GetNextLine(&line, &len));
+}
 
 }
 
@@ -159,3 +193,77 @@ TEST(LineReaderTest, TooLong) {
   unsigned len;
   ASSERT_FALSE(reader.GetNextLine(&line, &len));
 }
+
+TEST(LineReaderTest, BufferedManyLines) {
+  // Lines span the refills of a small buffer.
+  ScopedTmpFile file;
+  ASSERT_TRUE(file.InitString(NumberedLines(1000).c_str()));
+  PageAllocator allocator;
+  LineReader reader(file.GetFd(), &allocator, 64);
+  CheckNumberedLines(&reader, 1000);
+}
+
+TEST(LineReaderTest, BufferedLongLine) {
+  // A buffer larger than kMaxLineLen takes longer lines.
+  string l(LineReader::kMaxLineLen * 2, 'a');
+  ScopedTmpFile file;
+  ASSERT_TRUE(file.InitString((l + "\nb").c_str()));
+  PageAllocator allocator;
+  LineReader reader(file.GetFd(), &allocator, 4096);
+
+  const char* line;
+  unsigned len;
+  ASSERT_TRUE(reader.GetNextLine(&line, &len));
+  ASSERT_EQ(l.size(), len);
+  ASSERT_EQ(l, line);
+  reader.PopLine(len);
+  ASSERT_TRUE(reader.GetNextLine(&line, &len));
+  ASSERT_STREQ("b", line);
+  reader.PopLine(len);
+  ASSERT_FALSE(reader.GetNextLine(&line, &len));
+}
+
+TEST(WholeFileReaderTest, EmptyFile) {
+  ScopedTmpFile file;
+  ASSERT_TRUE(file.InitString(""));
+  PageAllocator allocator;
+  WholeFileReader reader(&allocator, 64);
+  ASSERT_TRUE(reader.Read(file.GetFd()));
+  ASSERT_EQ(0U, reader.size());
+
+  const char* line;
+  unsigned len;
+  ASSERT_FALSE(reader.GetNextLine(&line, &len));
+}
+
+TEST(WholeFileReaderTest, ManyLines) {
+  // The buffer grows until the file fits.
+  const string lines = NumberedLines(1000);
+  ScopedTmpFile file;
+  ASSERT_TRUE(file.InitString(lines.c_str()));
+  PageAllocator allocator;
+  WholeFileReader reader(&allocator, 16);
+  ASSERT_TRUE(reader.Read(file.GetFd()));
+  ASSERT_EQ(lines.size(), reader.size());
+  ASSERT_EQ(0, memcmp(lines.data(), reader.data(), lines.size()));
+  CheckNumberedLines(&reader, 1000);
+}
+
+TEST(WholeFileReaderTest, ProcFile) {
+  // Files in /proc have no size until they are read.
+  const int fd = open("/proc/self/status", O_RDONLY);
+  ASSERT_GE(fd, 0);
+  PageAllocator allocator;
+  WholeFileReader reader(&allocator, 64);
+  ASSERT_TRUE(reader.Read(fd));
+  close(fd);
+
+  bool found = false;
+  const char* line;
+  unsigned len;
+  while (reader.GetNextLine(&line, &len)) {
+    found |= strncmp("Tgid:\t", line, 6) == 0;
+    reader.PopLine(len);
+  }
+  ASSERT_TRUE(found);
+}
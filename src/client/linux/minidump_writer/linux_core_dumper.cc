@@ -40,6 +40,7 @@
 #include <elf.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/procfs.h>
 #if defined(__mips__) && defined(__ANDROID__)
 // To get register definitions.
@@ -142,6 +143,11 @@ bool LinuxCoreDumper::EnumerateThreads() {
     fprintf(stderr, "Could not map core dump file into memory\n");
     return false;
   }
+  // Apart from the notes, the core dump is read in small scattered pieces,
+  // the thread stacks and whatever the modules need, so reading ahead
+  // mostly brings in pages that are never used.
+  madvise(const_cast<void*>(mapped_core_file_.data()),
+          mapped_core_file_.size(), MADV_RANDOM);
 
   char proc_mem_path[NAME_MAX];
   if (BuildProcPath(proc_mem_path, pid_, "mem")) {
@@ -92,9 +92,29 @@ namespace google_breakpad {
 
 namespace {
 
-bool MappingContainsAddress(const MappingInfo& mapping, uintptr_t address) {
-  return mapping.system_mapping_info.start_addr <= address &&
-         address < mapping.system_mapping_info.end_addr;
+// The size of the buffer /proc/pid/maps is read through: 64 KiB covers
+// several hundred mappings a read.
+const size_t kMapsReadBufferSize = 64 * 1024;
+
+// The number of stack words that SanitizeStackCopy() and
+// StackHasPointerToMapping() test together.
+const size_t kStackBlockWords = 8;
+
+// A block of stack words, and the result of comparing one: all ones for
+// each word that passed and zero for the rest. The compiler implements
+// the arithmetic and comparisons on them with vector instructions where
+// the target has them.
+typedef uintptr_t StackBlock
+    __attribute__((vector_size(kStackBlockWords * sizeof(uintptr_t))));
+typedef intptr_t StackBlockMask
+    __attribute__((vector_size(kStackBlockWords * sizeof(intptr_t))));
+
+// Returns true if any of the words of |mask| is set.
+inline bool AnyInStackBlock(const StackBlockMask& mask) {
+  intptr_t any = 0;
+  for (size_t i = 0; i < kStackBlockWords; ++i)
+    any |= mask[i];
+  return any != 0;
 }
 
 #if defined(__CHROMEOS__)
@@ -292,7 +312,9 @@ LinuxDumper::LinuxDumper(pid_t pid, const char* root_prefix)
       crash_thread_(pid),
       threads_(&allocator_, 8),
       mappings_(&allocator_),
-      auxv_(&allocator_, AT_MAX + 1) {
+      auxv_(&allocator_, AT_MAX + 1),
+      executable_ranges_(&allocator_),
+      executable_ranges_built_(false) {
   assert(root_prefix_ && my_strlen(root_prefix_) < PATH_MAX);
   // The passed-in size to the constructor (above) is only a hint.
   // Must call .resize() to do actual initialization of the elements.
@@ -344,6 +366,17 @@ LinuxDumper::ElfFileIdentifierForMapping(const MappingInfo& mapping,
   char filename[PATH_MAX];
   if (!GetMappingAbsolutePath(mapping, filename))
     return false;
+
+  // The build id is usually in memory already, so the file need not be
+  // opened.
+  if (ElfBuildIdFromLoadedImage(mapping, identifier)) {
+    if (member && HandleDeletedFileInMapping(filename)) {
+      mappings_[mapping_id]->name[my_strlen(mapping.name) -
+                                  sizeof(kDeletedSuffix) + 1] = '\0';
+    }
+    return true;
+  }
+
   bool filename_modified = HandleDeletedFileInMapping(filename);
 
   MemoryMappedFile mapped_file(filename, 0);
@@ -360,6 +393,77 @@ LinuxDumper::ElfFileIdentifierForMapping(const MappingInfo& mapping,
   return success;
 }
 
+bool LinuxDumper::GetLoadedElfHeader(uintptr_t start_addr, ElfW(Ehdr)* ehdr) {
+  return CopyFromProcess(ehdr, pid_,
+                         reinterpret_cast<const void*>(start_addr),
+                         sizeof(*ehdr)) &&
+         my_memcmp(&ehdr->e_ident, ELFMAG, SELFMAG) == 0;
+}
+
+bool LinuxDumper::ElfBuildIdFromLoadedImage(
+    const MappingInfo& mapping,
+    wasteful_vector<uint8_t>& identifier) {
+  // Build id notes are small; anything bigger is not worth copying.
+  static const size_t kMaxNotesSize = 64 * 1024;
+  static const unsigned char kElfClass =
+      sizeof(void*) == 8 ? ELFCLASS64 : ELFCLASS32;
+
+  // Only the mapping of the start of the file holds the ELF header.
+  if (mapping.offset != 0)
+    return false;
+  const uintptr_t start_addr = mapping.system_mapping_info.start_addr;
+  const uintptr_t end_addr = mapping.system_mapping_info.end_addr;
+  ElfW(Ehdr) ehdr;
+  if (end_addr - start_addr < sizeof(ehdr) ||
+      !GetLoadedElfHeader(start_addr, &ehdr) ||
+      ehdr.e_ident[EI_CLASS] != kElfClass ||
+      ehdr.e_phentsize != sizeof(ElfW(Phdr)) ||
+      ehdr.e_phoff > end_addr - start_addr ||
+      ehdr.e_phnum * sizeof(ElfW(Phdr)) >
+          end_addr - start_addr - ehdr.e_phoff) {
+    return false;
+  }
+
+  ElfW(Phdr)* phdrs = reinterpret_cast<ElfW(Phdr)*>(
+      allocator_.Alloc(ehdr.e_phnum * sizeof(ElfW(Phdr))));
+  if (!CopyFromProcess(phdrs, pid_,
+                       reinterpret_cast<const void*>(start_addr +
+                                                     ehdr.e_phoff),
+                       ehdr.e_phnum * sizeof(ElfW(Phdr)))) {
+    return false;
+  }
+
+  // The lowest loadable segment, rounded down to its page, is where the
+  // mapping starts.
+  uintptr_t min_vaddr = UINTPTR_MAX;
+  for (size_t i = 0; i < ehdr.e_phnum; ++i) {
+    if (phdrs[i].p_type == PT_LOAD && phdrs[i].p_vaddr < min_vaddr)
+      min_vaddr = phdrs[i].p_vaddr;
+  }
+  if (min_vaddr == UINTPTR_MAX)
+    return false;
+  const uintptr_t load_bias =
+      start_addr - (min_vaddr & ~static_cast<uintptr_t>(getpagesize() - 1));
+
+  for (size_t i = 0; i < ehdr.e_phnum; ++i) {
+    if (phdrs[i].p_type != PT_NOTE || phdrs[i].p_memsz > kMaxNotesSize)
+      continue;
+    const uintptr_t notes_addr = load_bias + phdrs[i].p_vaddr;
+    const size_t notes_size = phdrs[i].p_memsz;
+    if (notes_addr < start_addr || notes_addr > end_addr ||
+        notes_size > end_addr - notes_addr) {
+      continue;
+    }
+    void* notes = allocator_.Alloc(notes_size);
+    if (CopyFromProcess(notes, pid_, reinterpret_cast<const void*>(notes_addr),
+                        notes_size) &&
+        FileID::ElfBuildIdFromNotes(notes, notes_size, identifier)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 void LinuxDumper::SetCrashInfoFromSigInfo(const siginfo_t& siginfo) {
   set_crash_address(reinterpret_cast<uintptr_t>(siginfo.si_addr));
   set_crash_signal(siginfo.si_signo);
@@ -565,11 +669,11 @@ bool LinuxDumper::EnumerateMappings() {
   const int fd = sys_open(maps_path, O_RDONLY, 0);
   if (fd < 0)
     return false;
-  LineReader* const line_reader = new(allocator_) LineReader(fd);
+  LineReader line_reader(fd, &allocator_, kMapsReadBufferSize);
 
   const char* line;
   unsigned line_len;
-  while (line_reader->GetNextLine(&line, &line_len)) {
+  while (line_reader.GetNextLine(&line, &line_len)) {
     uintptr_t start_addr, end_addr, offset;
 
     const char* i1 = my_read_hex_ptr(&start_addr, line);
@@ -602,7 +706,7 @@ bool LinuxDumper::EnumerateMappings() {
               module->system_mapping_info.end_addr = end_addr;
               module->size = end_addr - module->start_addr;
               module->exec |= exec;
-              line_reader->PopLine(line_len);
+              line_reader.PopLine(line_len);
               continue;
             }
           }
@@ -623,7 +727,7 @@ bool LinuxDumper::EnumerateMappings() {
         }
       }
     }
-    line_reader->PopLine(line_len);
+    line_reader.PopLine(line_len);
   }
 
   if (entry_point_loc) {
@@ -653,13 +757,6 @@ bool LinuxDumper::EnumerateMappings() {
 
 #if defined(__ANDROID__)
 
-bool LinuxDumper::GetLoadedElfHeader(uintptr_t start_addr, ElfW(Ehdr)* ehdr) {
-  CopyFromProcess(ehdr, pid_,
-                  reinterpret_cast<const void*>(start_addr),
-                  sizeof(*ehdr));
-  return my_memcmp(&ehdr->e_ident, ELFMAG, SELFMAG) == 0;
-}
-
 void LinuxDumper::ParseLoadedElfProgramHeaders(ElfW(Ehdr)* ehdr,
                                                uintptr_t start_addr,
                                                uintptr_t* min_vaddr_ptr,
@@ -788,56 +885,42 @@ bool LinuxDumper::GetStackInfo(const void** stack, size_t* stack_len,
 void LinuxDumper::SanitizeStackCopy(uint8_t* stack_copy, size_t stack_len,
                                     uintptr_t stack_pointer,
                                     uintptr_t sp_offset) {
-  // We optimize the search for containing mappings in three ways:
-  // 1) We expect that pointers into the stack mapping will be common, so
-  //    we cache that address range.
-  // 2) The last referenced mapping is a reasonable predictor for the next
-  //    referenced mapping, so we test that first.
-  // 3) We precompute a bitfield based upon bits 32:32-n of the start and
-  //    stop addresses, and use that to short circuit any values that can
-  //    not be pointers. (n=11)
+  // A word is kept if it is a small integer, which is no PII risk and may
+  // be a useful register value, or could point into the stack or to code.
+  // Each block of words is first tested against the small integers, the
+  // stack mapping and the span of all the code at once. Only the words
+  // in that span need IsExecutableAddress(), which tries the range of the
+  // last hit and a bitfield before searching the table of code ranges.
   const uintptr_t defaced =
 #if defined(__LP64__)
       0x0defaced0defaced;
 #else
       0x0defaced;
 #endif
-  // the bitfield length is 2^test_bits long.
-  const unsigned int test_bits = 11;
-  // byte length of the corresponding array.
-  const unsigned int array_size = 1 << (test_bits - 3);
-  const unsigned int array_mask = array_size - 1;
-  // The amount to right shift pointers by. This captures the top bits
-  // on 32 bit architectures. On 64 bit architectures this would be
-  // uninformative so we take the same range of bits.
-  const unsigned int shift = 32 - 11;
-  const MappingInfo* last_hit_mapping = nullptr;
-  const MappingInfo* hit_mapping = nullptr;
-  const MappingInfo* stack_mapping = FindMappingNoBias(stack_pointer);
   // The magnitude below which integers are considered to be to be
   // 'small', and not constitute a PII risk. These are included to
   // avoid eliding useful register values.
-  const ssize_t small_int_magnitude = 4096;
+  const uintptr_t small_int_magnitude = 4096;
+  const uintptr_t small_int_low = -small_int_magnitude;
+  const uintptr_t small_int_range = 2 * small_int_magnitude + 1;
 
-  char could_hit_mapping[array_size];
-  my_memset(could_hit_mapping, 0, array_size);
+  if (!executable_ranges_built_)
+    BuildExecutableRanges();
 
-  // Initialize the bitfield such that if the (pointer >> shift)'th
-  // bit, modulo the bitfield size, is not set then there does not
-  // exist a mapping in mappings_ that would contain that pointer.
-  for (size_t i = 0; i < mappings_.size(); ++i) {
-    if (!mappings_[i]->exec) continue;
-    // For each mapping, work out the (unmodulo'ed) range of bits to
-    // set.
-    uintptr_t start = mappings_[i]->start_addr;
-    uintptr_t end = start + mappings_[i]->size;
-    start >>= shift;
-    end >>= shift;
-    for (size_t bit = start; bit <= end; ++bit) {
-      // Set each bit in the range, applying the modulus.
-      could_hit_mapping[(bit >> 3) & array_mask] |= 1 << (bit & 7);
-    }
+  uintptr_t stack_low = 0;
+  uintptr_t stack_range = 0;
+  const MappingInfo* stack_mapping = FindMappingNoBias(stack_pointer);
+  if (stack_mapping) {
+    stack_low = stack_mapping->system_mapping_info.start_addr;
+    stack_range = stack_mapping->system_mapping_info.end_addr - stack_low;
+  }
+  uintptr_t code_low = 0;
+  uintptr_t code_range = 0;
+  if (!executable_ranges_.empty()) {
+    code_low = executable_ranges_.front().start;
+    code_range = executable_ranges_.back().end - code_low;
   }
+  size_t last_hit = 0;
 
   // Zero memory that is below the current stack pointer.
   const uintptr_t offset =
@@ -847,36 +930,42 @@ void LinuxDumper::SanitizeStackCopy(uint8_t* stack_copy, size_t stack_len,
   }
 
   // Apply sanitization to each complete pointer-aligned word in the
-  // stack.
-  uint8_t* sp;
-  for (sp = stack_copy + offset;
-       sp <= stack_copy + stack_len - sizeof(uintptr_t);
+  // stack, a block at a time and then one at a time.
+  uint8_t* sp = stack_copy + offset;
+  const uint8_t* const stack_end = stack_copy + stack_len;
+  StackBlock block;
+  while (stack_end - sp >= static_cast<ptrdiff_t>(sizeof(block))) {
+    my_memcpy(&block, sp, sizeof(block));
+    const StackBlockMask keep = (block - small_int_low < small_int_range) |
+                                (block - stack_low < stack_range);
+    if (AnyInStackBlock(~keep)) {
+      const StackBlockMask maybe_code = block - code_low < code_range;
+      for (size_t i = 0; i < kStackBlockWords; ++i) {
+        if (keep[i])
+          continue;
+        if (maybe_code[i] && IsExecutableAddress(block[i], &last_hit))
+          continue;
+        block[i] = defaced;
+      }
+      my_memcpy(sp, &block, sizeof(block));
+    }
+    sp += sizeof(block);
+  }
+  for (; stack_end - sp >= static_cast<ptrdiff_t>(sizeof(uintptr_t));
        sp += sizeof(uintptr_t)) {
     uintptr_t addr;
     my_memcpy(&addr, sp, sizeof(uintptr_t));
-    if (static_cast<intptr_t>(addr) <= small_int_magnitude &&
-        static_cast<intptr_t>(addr) >= -small_int_magnitude) {
-      continue;
-    }
-    if (stack_mapping && MappingContainsAddress(*stack_mapping, addr)) {
-      continue;
-    }
-    if (last_hit_mapping && MappingContainsAddress(*last_hit_mapping, addr)) {
-      continue;
-    }
-    uintptr_t test = addr >> shift;
-    if (could_hit_mapping[(test >> 3) & array_mask] & (1 << (test & 7)) &&
-        (hit_mapping = FindMappingNoBias(addr)) != nullptr &&
-        hit_mapping->exec) {
-      last_hit_mapping = hit_mapping;
+    if (addr - small_int_low < small_int_range ||
+        addr - stack_low < stack_range ||
+        IsExecutableAddress(addr, &last_hit)) {
       continue;
     }
     my_memcpy(sp, &defaced, sizeof(uintptr_t));
   }
   // Zero any partial word at the top of the stack, if alignment is
   // such that that is required.
-  if (sp < stack_copy + stack_len) {
-    my_memset(sp, 0, stack_copy + stack_len - sp);
+  if (sp < stack_end) {
+    my_memset(sp, 0, stack_end - sp);
   }
 }
 
@@ -891,20 +980,108 @@ bool LinuxDumper::StackHasPointerToMapping(const uint8_t* stack_copy,
   // aligned word in the target process.
   const uintptr_t low_addr = mapping.system_mapping_info.start_addr;
   const uintptr_t high_addr = mapping.system_mapping_info.end_addr;
+  const uintptr_t range = high_addr - low_addr + 1;
   const uintptr_t offset =
       (sp_offset + sizeof(uintptr_t) - 1) & ~(sizeof(uintptr_t) - 1);
 
-  for (const uint8_t* sp = stack_copy + offset;
-       sp <= stack_copy + stack_len - sizeof(uintptr_t);
+  const uint8_t* sp = stack_copy + offset;
+  const uint8_t* const stack_end = stack_copy + stack_len;
+  StackBlock block;
+  for (; stack_end - sp >= static_cast<ptrdiff_t>(sizeof(block));
+       sp += sizeof(block)) {
+    my_memcpy(&block, sp, sizeof(block));
+    if (AnyInStackBlock(block - low_addr < range))
+      return true;
+  }
+  for (; stack_end - sp >= static_cast<ptrdiff_t>(sizeof(uintptr_t));
        sp += sizeof(uintptr_t)) {
     uintptr_t addr;
     my_memcpy(&addr, sp, sizeof(uintptr_t));
-    if (low_addr <= addr && addr <= high_addr)
+    if (addr - low_addr < range)
       return true;
   }
   return false;
 }
 
+void LinuxDumper::BuildExecutableRanges() {
+  executable_ranges_built_ = true;
+  executable_ranges_.clear();
+  my_memset(could_be_executable_, 0, sizeof(could_be_executable_));
+
+  // The mappings are in address order already, as /proc/<pid>/maps lists
+  // them, so an insertion sort does not move much.
+  for (size_t i = 0; i < mappings_.size(); ++i) {
+    const MappingInfo& mapping = *mappings_[i];
+    if (!mapping.exec ||
+        mapping.system_mapping_info.start_addr >=
+            mapping.system_mapping_info.end_addr) {
+      continue;
+    }
+    ExecutableRange range = { mapping.system_mapping_info.start_addr,
+                              mapping.system_mapping_info.end_addr };
+    size_t j = executable_ranges_.size();
+    executable_ranges_.push_back(range);
+    for (; j > 0 && executable_ranges_[j - 1].start > range.start; --j)
+      executable_ranges_[j] = executable_ranges_[j - 1];
+    executable_ranges_[j] = range;
+
+    // Set the bits for the range, modulo the bitfield's length.
+    const uintptr_t first_bit = range.start >> kExecutableBitfieldShift;
+    const uintptr_t last_bit = (range.end - 1) >> kExecutableBitfieldShift;
+    for (uintptr_t bit = first_bit;
+         bit <= last_bit && bit - first_bit < kExecutableBitfieldBits;
+         ++bit) {
+      could_be_executable_[(bit % kExecutableBitfieldBits) >> 3] |=
+          1 << (bit & 7);
+    }
+  }
+
+  // Merge the ranges that touch.
+  size_t merged = 0;
+  for (size_t i = 0; i < executable_ranges_.size(); ++i) {
+    if (merged &&
+        executable_ranges_[i].start <= executable_ranges_[merged - 1].end) {
+      if (executable_ranges_[i].end > executable_ranges_[merged - 1].end)
+        executable_ranges_[merged - 1].end = executable_ranges_[i].end;
+    } else {
+      executable_ranges_[merged++] = executable_ranges_[i];
+    }
+  }
+  executable_ranges_.resize(merged);
+}
+
+bool LinuxDumper::IsExecutableAddress(uintptr_t address,
+                                      size_t* last_hit) const {
+  const size_t count = executable_ranges_.size();
+  if (*last_hit < count &&
+      executable_ranges_[*last_hit].start <= address &&
+      address < executable_ranges_[*last_hit].end) {
+    return true;
+  }
+
+  const uintptr_t bit = address >> kExecutableBitfieldShift;
+  if (!(could_be_executable_[(bit % kExecutableBitfieldBits) >> 3] &
+        (1 << (bit & 7)))) {
+    return false;
+  }
+
+  // Find the first range that starts above |address|; the one before it
+  // is the only one that could hold it.
+  size_t low = 0;
+  size_t high = count;
+  while (low < high) {
+    const size_t middle = low + (high - low) / 2;
+    if (executable_ranges_[middle].start <= address)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  if (low == 0 || address >= executable_ranges_[low - 1].end)
+    return false;
+  *last_hit = low - 1;
+  return true;
+}
+
 // Find the mapping which the given memory address falls in.
 const MappingInfo* LinuxDumper::FindMapping(const void* address) const {
   const uintptr_t addr = (uintptr_t) address;
@@ -931,6 +1108,18 @@ const MappingInfo* LinuxDumper::FindMappingNoBias(uintptr_t address) const {
   return NULL;
 }
 
+bool LinuxDumper::CopyRangesFromProcess(pid_t child,
+                                        const MemoryCopy* copies,
+                                        size_t count) {
+  bool success = true;
+  for (size_t i = 0; i < count; ++i) {
+    if (!CopyFromProcess(copies[i].dest, child, copies[i].src,
+                         copies[i].length))
+      success = false;
+  }
+  return success;
+}
+
 bool LinuxDumper::HandleDeletedFileInMapping(char* path) const {
   static const size_t kDeletedSuffixLen = sizeof(kDeletedSuffix) - 1;
 
@@ -39,9 +39,7 @@
 
 #include <assert.h>
 #include <elf.h>
-#if defined(__ANDROID__)
 #include <link.h>
-#endif
 #include <linux/limits.h>
 #include <stdint.h>
 #include <sys/types.h>
@@ -128,7 +126,8 @@ class LinuxDumper {
   bool GetStackInfo(const void** stack, size_t* stack_len, uintptr_t stack_top);
 
   // Sanitize a copy of the stack by overwriting words that are not
-  // pointers with a sentinel (0x0defaced).
+  // pointers with a sentinel (0x0defaced). The first call builds a table
+  // of the executable mappings, so |mappings_| must not change after it.
   //   stack_copy: a copy of the stack to sanitize. |stack_copy| might
   //               not be word aligned, but it represents word aligned
   //               data copied from another location.
@@ -160,6 +159,20 @@ class LinuxDumper {
   virtual bool CopyFromProcess(void* dest, pid_t child, const void* src,
                                size_t length) = 0;
 
+  // A range of |length| bytes to copy from |src| in another process to
+  // |dest| in this one.
+  struct MemoryCopy {
+    void* dest;
+    const void* src;
+    size_t length;
+  };
+
+  // Copy each of the |count| ranges in |copies| from a given process
+  // |child|. Implementations may read several ranges with one system call;
+  // this one calls CopyFromProcess() for each. Returns true on success.
+  virtual bool CopyRangesFromProcess(pid_t child, const MemoryCopy* copies,
+                                     size_t count);
+
   // Builds a proc path for a certain pid for a node (/proc/<pid>/<node>).
   // |path| is a character array of at least NAME_MAX bytes to return the
   // result.|node| is the final node without any slashes. Returns true on
@@ -174,6 +187,13 @@ class LinuxDumper {
                                    unsigned int mapping_id,
                                    wasteful_vector<uint8_t>& identifier);
 
+  // Read the build id of the ELF file loaded at |mapping| from the PT_NOTE
+  // segments in the process's memory into |identifier|, without opening
+  // the file.  Returns false if |mapping| is not the start of a loaded ELF
+  // file or its notes are not mapped or hold no build id.
+  bool ElfBuildIdFromLoadedImage(const MappingInfo& mapping,
+                                 wasteful_vector<uint8_t>& identifier);
+
   void SetCrashInfoFromSigInfo(const siginfo_t& siginfo);
 
   uintptr_t crash_address() const { return crash_address_; }
@@ -233,6 +253,13 @@ class LinuxDumper {
   // Returns true if |path| is modified.
   bool HandleDeletedFileInMapping(char* path) const;
 
+  // Check that a given mapping at |start_addr| is for an ELF file.
+  // If it is, place the ELF header in |ehdr| and return true.
+  // The first LOAD segment in an ELF file has offset zero, so the
+  // ELF file header is at the start of this map entry, and in already mapped
+  // memory.
+  bool GetLoadedElfHeader(uintptr_t start_addr, ElfW(Ehdr)* ehdr);
+
    // ID of the crashed process.
   const pid_t pid_;
 
@@ -265,6 +292,38 @@ class LinuxDumper {
   // Info from /proc/<pid>/auxv
   wasteful_vector<elf_aux_val_t> auxv_;
 
+ private:
+  // An address range that holds code, for SanitizeStackCopy().
+  struct ExecutableRange {
+    uintptr_t start;
+    uintptr_t end;
+  };
+
+  // The number of bits in |could_be_executable_|, and how far to shift
+  // an address right to pick its bit. The shift captures the top bits on
+  // 32 bit architectures. On 64 bit architectures these would be
+  // uninformative, so the same range of bits is taken.
+  static const size_t kExecutableBitfieldBits = 1 << 11;
+  static const unsigned kExecutableBitfieldShift = 32 - 11;
+
+  // Fills |executable_ranges_| and |could_be_executable_| from the
+  // executable mappings in |mappings_|.
+  void BuildExecutableRanges();
+
+  // Returns true if |address| is in one of |executable_ranges_|. The
+  // range at index |*last_hit| is tried first, and |*last_hit| is set to
+  // the index of the range that holds |address|.
+  bool IsExecutableAddress(uintptr_t address, size_t* last_hit) const;
+
+  // The system address ranges of the executable mappings, sorted and with
+  // those that touch merged, so they can be binary searched.
+  wasteful_vector<ExecutableRange> executable_ranges_;
+  bool executable_ranges_built_;
+
+  // If the (address >> kExecutableBitfieldShift)'th bit, modulo the
+  // bitfield's length, is clear, no executable range holds the address.
+  uint8_t could_be_executable_[kExecutableBitfieldBits / 8];
+
 #if defined(__ANDROID__)
  private:
   // Android M and later support packed ELF relocations in shared libraries.
@@ -278,13 +337,6 @@ class LinuxDumper {
   // packed relocations, so that it properly represents the effective library
   // load bias. The following functions support this adjustment.
 
-  // Check that a given mapping at |start_addr| is for an ELF shared library.
-  // If it is, place the ELF header in |ehdr| and return true.
-  // The first LOAD segment in an ELF shared library has offset zero, so the
-  // ELF file header is at the start of this map entry, and in already mapped
-  // memory.
-  bool GetLoadedElfHeader(uintptr_t start_addr, ElfW(Ehdr)* ehdr);
-
   // For the ELF file mapped at |start_addr|, iterate ELF program headers to
   // find the min vaddr of all program header LOAD segments, the vaddr for
   // the DYNAMIC segment, and a count of DYNAMIC entries. Return values in
@@ -46,12 +46,15 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <pthread.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/ptrace.h>
+#include <sys/syscall.h>
 #include <sys/uio.h>
 #include <sys/wait.h>
+#include <unistd.h>
 
 #if defined(__i386)
 #include <cpuid.h>
@@ -77,6 +80,15 @@ typedef struct {
 } __attribute__((packed, aligned(4))) user_vfp_t;
 #endif  // defined(__arm__)
 
+// The pidfd system calls, from Linux 5.1 and 5.3, have the same numbers on
+// every architecture.
+#if !defined(__NR_pidfd_send_signal)
+#define __NR_pidfd_send_signal 424
+#endif
+#if !defined(__NR_pidfd_open)
+#define __NR_pidfd_open 434
+#endif
+
 // Suspends a thread by attaching to it.
 static bool SuspendThread(pid_t pid) {
   // This may fail if the thread has just died or debugged.
@@ -137,11 +149,36 @@ static bool ResumeThread(pid_t pid) {
   return sys_ptrace(PTRACE_DETACH, pid, NULL, NULL) >= 0;
 }
 
+// A first guess at the size of /proc/tid/status, which is read whole.
+static const size_t kStatusReadBufferSize = 4096;
+
+// The size of the buffer /proc/pid/task is enumerated through: 64 KiB
+// holds a few thousand threads' entries a getdents call.
+static const size_t kTaskReadBufferSize = 64 * 1024;
+
 namespace google_breakpad {
 
 LinuxPtraceDumper::LinuxPtraceDumper(pid_t pid)
     : LinuxDumper(pid),
-      threads_suspended_(false) {
+      threads_suspended_(false),
+      num_helper_threads_(1),
+      helpers_(NULL),
+      thread_infos_(NULL),
+      thread_info_valid_(NULL),
+      process_vm_readv_works_(true),
+      mem_fd_(-1),
+      mem_fd_opened_(false),
+      pidfd_(-1) {
+}
+
+LinuxPtraceDumper::~LinuxPtraceDumper() {
+  // Helper threads hold some of the process's threads stopped.
+  if (helpers_)
+    ThreadsResume();
+  if (mem_fd_ >= 0)
+    sys_close(mem_fd_);
+  if (pidfd_ >= 0)
+    sys_close(pidfd_);
 }
 
 bool LinuxPtraceDumper::BuildProcPath(char* path, pid_t pid,
@@ -168,21 +205,111 @@ bool LinuxPtraceDumper::BuildProcPath(char* path, pid_t pid,
 
 bool LinuxPtraceDumper::CopyFromProcess(void* dest, pid_t child,
                                         const void* src, size_t length) {
-  unsigned long tmp = 55;
+  MemoryCopy copy = { dest, src, length };
+  return CopyRangesFromProcess(child, &copy, 1);
+}
+
+bool LinuxPtraceDumper::CopyRangesFromProcess(pid_t child,
+                                              const MemoryCopy* copies,
+                                              size_t count) {
+  // The number of ranges to pass to each process_vm_readv() call. This
+  // code may run on a small signal-handling stack, so keep the vectors
+  // modest.
+  static const size_t kMaxRangesPerRead = 32;
+
+  // Ranges before |first| have been copied, as have the first |done| bytes
+  // of copies[first].
+  size_t first = 0;
   size_t done = 0;
-  static const size_t word_size = sizeof(tmp);
-  uint8_t* const local = (uint8_t*) dest;
-  uint8_t* const remote = (uint8_t*) src;
+  while (first < count) {
+    if (process_vm_readv_works_) {
+      struct kernel_iovec local[kMaxRangesPerRead];
+      struct kernel_iovec remote[kMaxRangesPerRead];
+      const size_t batch_end = first + kMaxRangesPerRead < count ?
+          first + kMaxRangesPerRead : count;
+      size_t ranges = 0;
+      for (size_t i = first; i < batch_end; ++i) {
+        const size_t skip = i == first ? done : 0;
+        local[ranges].iov_base =
+            static_cast<uint8_t*>(copies[i].dest) + skip;
+        remote[ranges].iov_base = const_cast<uint8_t*>(
+            static_cast<const uint8_t*>(copies[i].src) + skip);
+        local[ranges].iov_len = remote[ranges].iov_len =
+            copies[i].length - skip;
+        ++ranges;
+      }
+      const ssize_t r = sys_process_vm_readv(child, local, ranges, remote,
+                                             ranges, 0);
+      if (r < 0 && (errno == ENOSYS || errno == EPERM))
+        process_vm_readv_works_ = false;
+      size_t read = r > 0 ? r : 0;
+      while (first < batch_end && read >= copies[first].length - done) {
+        read -= copies[first].length - done;
+        ++first;
+        done = 0;
+      }
+      done += read;
+      if (first == batch_end)
+        continue;
+    }
+    // Copy the rest of the range that process_vm_readv() stopped in the
+    // hard way, then go back to reading ranges in bulk.
+    CopyRangeSlowly(static_cast<uint8_t*>(copies[first].dest) + done, child,
+                    static_cast<const uint8_t*>(copies[first].src) + done,
+                    copies[first].length - done);
+    ++first;
+    done = 0;
+  }
+  if (!threads_suspended_ && ProcessGone()) {
+    for (size_t i = 0; i < count; ++i)
+      my_memset(copies[i].dest, 0, copies[i].length);
+  }
+  return true;
+}
+
+bool LinuxPtraceDumper::ProcessGone() const {
+  // Signal 0 only checks that the process can be signalled. A process
+  // that has exited but not been reaped still can be, and keeps its pid.
+  return pidfd_ >= 0 &&
+      syscall(__NR_pidfd_send_signal, pidfd_, 0, NULL, 0) < 0 &&
+      errno == ESRCH;
+}
 
+bool LinuxPtraceDumper::OpenMemFile() {
+  if (!mem_fd_opened_) {
+    mem_fd_opened_ = true;
+    char path[NAME_MAX];
+    if (BuildProcPath(path, pid_, "mem"))
+      mem_fd_ = sys_open(path, O_RDONLY, 0);
+  }
+  return mem_fd_ >= 0;
+}
+
+void LinuxPtraceDumper::CopyRangeSlowly(uint8_t* dest, pid_t child,
+                                        const uint8_t* src, size_t length) {
+  size_t done = 0;
+  if (OpenMemFile()) {
+    while (done < length) {
+      const ssize_t r = HANDLE_EINTR(sys_pread64(
+          mem_fd_, dest + done, length - done,
+          static_cast<loff_t>(reinterpret_cast<uintptr_t>(src + done))));
+      if (r <= 0)
+        break;
+      done += r;
+    }
+  }
+
+  unsigned long tmp = 55;
+  static const size_t word_size = sizeof(tmp);
   while (done < length) {
     const size_t l = (length - done > word_size) ? word_size : (length - done);
-    if (sys_ptrace(PTRACE_PEEKDATA, child, remote + done, &tmp) == -1) {
+    if (sys_ptrace(PTRACE_PEEKDATA, child, const_cast<uint8_t*>(src + done),
+                   &tmp) == -1) {
       tmp = 0;
     }
-    my_memcpy(local + done, &tmp, l);
+    my_memcpy(dest + done, &tmp, l);
     done += l;
   }
-  return true;
 }
 
 // This read VFP registers via either PTRACE_GETREGSET or PTRACE_GETREGS
@@ -297,9 +424,18 @@ bool LinuxPtraceDumper::GetThreadInfoByIndex(size_t index, ThreadInfo* info) {
   if (index >= threads_.size())
     return false;
 
-  pid_t tid = threads_[index];
-
   assert(info != NULL);
+  if (thread_infos_) {
+    if (!thread_info_valid_[index])
+      return false;
+    *info = thread_infos_[index];
+    return true;
+  }
+  return ReadThreadInfo(threads_[index], info, &allocator_);
+}
+
+bool LinuxPtraceDumper::ReadThreadInfo(pid_t tid, ThreadInfo* info,
+                                       PageAllocator* allocator) {
   char status_path[NAME_MAX];
   if (!BuildProcPath(status_path, tid, "status"))
     return false;
@@ -308,22 +444,28 @@ bool LinuxPtraceDumper::GetThreadInfoByIndex(size_t index, ThreadInfo* info) {
   if (fd < 0)
     return false;
 
-  LineReader* const line_reader = new(allocator_) LineReader(fd);
+  // The file is read in one go, and the buffer is handed back to
+  // |allocator| for the next thread's.
+  WholeFileReader file_reader(allocator, kStatusReadBufferSize);
+  const bool read_status = file_reader.Read(fd);
+  sys_close(fd);
+  if (!read_status)
+    return false;
+
   const char* line;
   unsigned line_len;
 
   info->ppid = info->tgid = -1;
 
-  while (line_reader->GetNextLine(&line, &line_len)) {
+  while (file_reader.GetNextLine(&line, &line_len)) {
     if (my_strncmp("Tgid:\t", line, 6) == 0) {
       my_strtoui(&info->tgid, line + 6);
     } else if (my_strncmp("PPid:\t", line, 6) == 0) {
       my_strtoui(&info->ppid, line + 6);
     }
 
-    line_reader->PopLine(line_len);
+    file_reader.PopLine(line_len);
   }
-  sys_close(fd);
 
   if (info->ppid == -1 || info->tgid == -1)
     return false;
@@ -412,6 +554,11 @@ bool LinuxPtraceDumper::IsPostMortem() const {
 bool LinuxPtraceDumper::ThreadsSuspend() {
   if (threads_suspended_)
     return true;
+  // PTRACE_PEEKDATA, which CopyRangeSlowly() falls back on when it can't
+  // read /proc/<pid>/mem, only works on the thread that attached, so the
+  // threads are only left attached to helpers when that file can be read.
+  if (num_helper_threads_ > 1 && threads_.size() > 1 && OpenMemFile())
+    return ThreadsSuspendWithHelpers();
   for (size_t i = 0; i < threads_.size(); ++i) {
     if (!SuspendThread(threads_[i])) {
       // If the thread either disappeared before we could attach to it, or if
@@ -432,6 +579,10 @@ bool LinuxPtraceDumper::ThreadsSuspend() {
 bool LinuxPtraceDumper::ThreadsResume() {
   if (!threads_suspended_)
     return false;
+  if (pidfd_ < 0)
+    pidfd_ = syscall(__NR_pidfd_open, pid_, 0);
+  if (helpers_)
+    return ThreadsResumeWithHelpers();
   bool good = true;
   for (size_t i = 0; i < threads_.size(); ++i)
     good &= ResumeThread(threads_[i]);
@@ -439,6 +590,153 @@ bool LinuxPtraceDumper::ThreadsResume() {
   return good;
 }
 
+struct LinuxPtraceDumper::HelperPool {
+  struct Helper {
+    LinuxPtraceDumper* dumper;
+    HelperPool* pool;
+    // This helper handles threads_[first], threads_[first + stride], ...
+    size_t first;
+    size_t stride;
+    pthread_t thread;
+    // The threads this helper attached to, which it must detach from.
+    pid_t* attached;
+    size_t attached_count;
+    bool resumed_all;
+  };
+
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  Helper* helpers;
+  size_t helper_count;
+  // Guarded by |mutex|.
+  size_t suspended_count;
+  bool resume;
+  // Indexed like threads_; set by the helper that handles each thread.
+  bool* attached;
+};
+
+void* LinuxPtraceDumper::HelperThreadMain(void* arg) {
+  HelperPool::Helper* helper = static_cast<HelperPool::Helper*>(arg);
+  LinuxPtraceDumper* dumper = helper->dumper;
+  HelperPool* pool = helper->pool;
+  PageAllocator allocator;
+
+  for (size_t i = helper->first; i < dumper->threads_.size();
+       i += helper->stride) {
+    const pid_t tid = dumper->threads_[i];
+    if (!SuspendThread(tid))
+      continue;
+    pool->attached[i] = true;
+    helper->attached[helper->attached_count++] = tid;
+    dumper->thread_info_valid_[i] =
+        dumper->ReadThreadInfo(tid, &dumper->thread_infos_[i], &allocator);
+  }
+
+  pthread_mutex_lock(&pool->mutex);
+  ++pool->suspended_count;
+  pthread_cond_broadcast(&pool->cond);
+  while (!pool->resume)
+    pthread_cond_wait(&pool->cond, &pool->mutex);
+  pthread_mutex_unlock(&pool->mutex);
+
+  helper->resumed_all = true;
+  for (size_t i = 0; i < helper->attached_count; ++i) {
+    if (!ResumeThread(helper->attached[i]))
+      helper->resumed_all = false;
+  }
+  return NULL;
+}
+
+bool LinuxPtraceDumper::ThreadsSuspendWithHelpers() {
+  const size_t count = threads_.size();
+  thread_infos_ = new ThreadInfo[count];
+  thread_info_valid_ = new bool[count]();
+
+  HelperPool* pool = new HelperPool;
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->cond, NULL);
+  pool->helper_count = static_cast<size_t>(num_helper_threads_) < count ?
+      num_helper_threads_ : count;
+  pool->helpers = new HelperPool::Helper[pool->helper_count];
+  pool->suspended_count = 0;
+  pool->resume = false;
+  pool->attached = new bool[count]();
+
+  size_t started = 0;
+  for (; started < pool->helper_count; ++started) {
+    HelperPool::Helper* helper = &pool->helpers[started];
+    helper->dumper = this;
+    helper->pool = pool;
+    helper->first = started;
+    helper->stride = pool->helper_count;
+    helper->attached = new pid_t[count / pool->helper_count + 1];
+    helper->attached_count = 0;
+    helper->resumed_all = true;
+    if (pthread_create(&helper->thread, NULL, HelperThreadMain, helper) != 0) {
+      delete[] helper->attached;
+      break;
+    }
+  }
+  helpers_ = pool;
+  threads_suspended_ = true;
+
+  if (started < pool->helper_count) {
+    // Some threads would have no helper. Let the helpers that did start
+    // detach again, and suspend everything from this thread instead.
+    pool->helper_count = started;
+    ThreadsResumeWithHelpers();
+    num_helper_threads_ = 1;
+    return ThreadsSuspend();
+  }
+
+  pthread_mutex_lock(&pool->mutex);
+  while (pool->suspended_count < pool->helper_count)
+    pthread_cond_wait(&pool->cond, &pool->mutex);
+  pthread_mutex_unlock(&pool->mutex);
+
+  // Drop the threads that could not be suspended, as ThreadsSuspend() does,
+  // keeping the order of the rest.
+  size_t kept = 0;
+  for (size_t i = 0; i < count; ++i) {
+    if (!pool->attached[i])
+      continue;
+    threads_[kept] = threads_[i];
+    thread_infos_[kept] = thread_infos_[i];
+    thread_info_valid_[kept] = thread_info_valid_[i];
+    ++kept;
+  }
+  threads_.resize(kept);
+  return kept > 0;
+}
+
+bool LinuxPtraceDumper::ThreadsResumeWithHelpers() {
+  HelperPool* pool = helpers_;
+  pthread_mutex_lock(&pool->mutex);
+  pool->resume = true;
+  pthread_cond_broadcast(&pool->cond);
+  pthread_mutex_unlock(&pool->mutex);
+
+  bool good = true;
+  for (size_t i = 0; i < pool->helper_count; ++i) {
+    pthread_join(pool->helpers[i].thread, NULL);
+    good &= pool->helpers[i].resumed_all;
+    delete[] pool->helpers[i].attached;
+  }
+  pthread_cond_destroy(&pool->cond);
+  pthread_mutex_destroy(&pool->mutex);
+  delete[] pool->attached;
+  delete[] pool->helpers;
+  delete pool;
+
+  delete[] thread_infos_;
+  delete[] thread_info_valid_;
+  helpers_ = NULL;
+  thread_infos_ = NULL;
+  thread_info_valid_ = NULL;
+  threads_suspended_ = false;
+  return good;
+}
+
 // Parse /proc/$pid/task to list all the threads of the process identified by
 // pid.
 bool LinuxPtraceDumper::EnumerateThreads() {
@@ -449,13 +747,13 @@ bool LinuxPtraceDumper::EnumerateThreads() {
   const int fd = sys_open(task_path, O_RDONLY | O_DIRECTORY, 0);
   if (fd < 0)
     return false;
-  DirectoryReader* dir_reader = new(allocator_) DirectoryReader(fd);
+  DirectoryReader dir_reader(fd, &allocator_, kTaskReadBufferSize);
 
   // The directory may contain duplicate entries which we filter by assuming
   // that they are consecutive.
   int last_tid = -1;
   const char* dent_name;
-  while (dir_reader->GetNextEntry(&dent_name)) {
+  while (dir_reader.GetNextEntry(&dent_name)) {
     if (my_strcmp(dent_name, ".") &&
         my_strcmp(dent_name, "..")) {
       int tid = 0;
@@ -465,7 +763,7 @@ bool LinuxPtraceDumper::EnumerateThreads() {
         threads_.push_back(tid);
       }
     }
-    dir_reader->PopEntry();
+    dir_reader.PopEntry();
   }
 
   sys_close(fd);
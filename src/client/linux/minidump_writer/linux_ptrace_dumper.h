@@ -51,13 +51,36 @@ class LinuxPtraceDumper : public LinuxDumper {
   // success.
   virtual bool BuildProcPath(char* path, pid_t pid, const char* node) const;
 
+  virtual ~LinuxPtraceDumper();
+
+  // Suspend the threads and read their registers on |count| threads of
+  // this process instead of on the calling thread alone. Only the thread
+  // that attached to a thread may read its registers or detach from it, so
+  // each helper thread keeps its share of the threads until
+  // ThreadsResume(). That includes reading memory with PTRACE_PEEKDATA, so
+  // the calling thread suspends the threads alone if /proc/<pid>/mem, which
+  // any thread may read, can't be opened. Helper threads use pthreads and
+  // the heap, so this must not be used from a compromised process.
+  void set_num_helper_threads(int count) { num_helper_threads_ = count; }
+
   // Implements LinuxDumper::CopyFromProcess().
   // Copies content of |length| bytes from a given process |child|,
-  // starting from |src|, into |dest|. This method uses ptrace to extract
-  // the content from the target process. Always returns true.
+  // starting from |src|, into |dest|. Bytes that cannot be read are
+  // zeroed. Always returns true.
   virtual bool CopyFromProcess(void* dest, pid_t child, const void* src,
                                size_t length);
 
+  // Implements LinuxDumper::CopyRangesFromProcess().
+  // Reads as many ranges as possible per process_vm_readv() call. Ranges
+  // that it cannot read, or all of them if the kernel lacks the call, are
+  // read from /proc/<pid>/mem and failing that, with ptrace a word at a
+  // time. Bytes that cannot be read are zeroed. Once ThreadsResume() has
+  // let the process run again, its pid could be reused by another process
+  // while the ranges are read, so they are zeroed too unless a pidfd shows
+  // that the process is still there afterwards. Always returns true.
+  virtual bool CopyRangesFromProcess(pid_t child, const MemoryCopy* copies,
+                                     size_t count);
+
   // Implements LinuxDumper::GetThreadInfoByIndex().
   // Reads information about the |index|-th thread of |threads_|.
   // Returns true on success. One must have called |ThreadsSuspend| first.
@@ -74,6 +97,8 @@ class LinuxPtraceDumper : public LinuxDumper {
 
   // Implements LinuxDumper::ThreadsResume().
   // Resumes all threads in the given process. Returns true on success.
+  // Memory can still be read from the process afterwards; see
+  // CopyRangesFromProcess().
   virtual bool ThreadsResume();
 
  protected:
@@ -85,6 +110,53 @@ class LinuxPtraceDumper : public LinuxDumper {
   // Set to true if all threads of the crashed process are suspended.
   bool threads_suspended_;
 
+  // The number of threads to suspend and read threads with, and when
+  // they are in use, their shared state.
+  struct HelperPool;
+  int num_helper_threads_;
+  HelperPool* helpers_;
+
+  // With helper threads, the registers of each of |threads_| as read by
+  // the helper that suspended it, and whether that read succeeded.
+  ThreadInfo* thread_infos_;
+  bool* thread_info_valid_;
+
+  // Set to false once process_vm_readv() has failed in a way that means
+  // it will never succeed, such as ENOSYS on kernels before 3.2.
+  bool process_vm_readv_works_;
+
+  // A descriptor for /proc/<pid>/mem, opened by the first read that needs
+  // it; -1 if that has not happened or the open failed.
+  int mem_fd_;
+  bool mem_fd_opened_;
+
+  // A pidfd for the process, opened by ThreadsResume() while its threads
+  // are still attached, so that it refers to the process that was dumped;
+  // -1 if that has not happened or the kernel lacks pidfds.
+  int pidfd_;
+
+  // Returns true if the process has gone since ThreadsResume(), as far as
+  // |pidfd_| can tell.
+  bool ProcessGone() const;
+
+  // Open |mem_fd_| if that hasn't been tried yet. Returns true if it is
+  // open.
+  bool OpenMemFile();
+
+  // Copy |length| bytes from |src| in |child| into |dest| without
+  // process_vm_readv(), zeroing any bytes that cannot be read.
+  void CopyRangeSlowly(uint8_t* dest, pid_t child, const uint8_t* src,
+                       size_t length);
+
+  // Read the status and registers of thread |tid| into |info|, using
+  // |allocator| for temporary storage. Returns true on success.
+  bool ReadThreadInfo(pid_t tid, ThreadInfo* info, PageAllocator* allocator);
+
+  // ThreadsSuspend() and ThreadsResume() using helper threads.
+  bool ThreadsSuspendWithHelpers();
+  bool ThreadsResumeWithHelpers();
+  static void* HelperThreadMain(void* arg);
+
   // Read the tracee's registers on kernel with PTRACE_GETREGSET support.
   // Returns false if PTRACE_GETREGSET is not defined.
   // Returns true on success.
@@ -40,16 +40,21 @@
 #include <fcntl.h>
 #include <limits.h>
 #include <poll.h>
+#include <pthread.h>
 #include <unistd.h>
 #include <signal.h>
 #include <stdint.h>
 #include <string.h>
 #include <sys/mman.h>
 #include <sys/prctl.h>
+#include <sys/ptrace.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <algorithm>
+#include <chrono>
 #include <string>
+#include <vector>
 
 #include "breakpad_googletest_includes.h"
 #include "client/linux/minidump_writer/linux_ptrace_dumper.h"
@@ -57,6 +62,7 @@
 #include "common/linux/eintr_wrapper.h"
 #include "common/linux/file_id.h"
 #include "common/linux/ignore_ret.h"
+#include "common/linux/memory_mapped_file.h"
 #include "common/linux/safe_readlink.h"
 #include "common/memory_allocator.h"
 #include "common/using_std_string.h"
@@ -427,10 +433,72 @@ TEST_F(LinuxPtraceDumperChildTest, FileIDsMatch) {
   EXPECT_EQ(identifier_string1, identifier_string2);
 }
 
+// Copy the parent's text in pages, with an unreadable range in the middle,
+// and check that CopyRangesFromProcess matches our own copy of the text.
+// Also report how long copying the same bytes a word at a time with
+// PTRACE_PEEKDATA takes, for comparison.
+TEST_F(LinuxPtraceDumperChildTest, CopyRangesFromProcess) {
+  char exe_name[PATH_MAX];
+  ASSERT_TRUE(SafeReadLink("/proc/self/exe", exe_name));
+
+  LinuxPtraceDumper dumper(getppid());
+  ASSERT_TRUE(dumper.Init());
+  const MappingInfo* text = NULL;
+  for (size_t i = 0; i < dumper.mappings().size(); ++i) {
+    const MappingInfo* mapping = dumper.mappings()[i];
+    if (mapping->exec && !strcmp(mapping->name, exe_name)) {
+      text = mapping;
+      break;
+    }
+  }
+  ASSERT_TRUE(text);
+  ASSERT_TRUE(dumper.ThreadsSuspend());
+
+  const size_t kPageSize = getpagesize();
+  const size_t length = std::min<size_t>(text->size, 256 * kPageSize);
+  const uint8_t* src = reinterpret_cast<const uint8_t*>(text->start_addr);
+  std::vector<uint8_t> copy(length + kPageSize, 0xff);
+  std::vector<LinuxDumper::MemoryCopy> copies;
+  for (size_t offset = 0; offset < length; offset += kPageSize) {
+    if (offset == length / kPageSize / 2 * kPageSize) {
+      LinuxDumper::MemoryCopy unreadable = { &copy[length], NULL, kPageSize };
+      copies.push_back(unreadable);
+    }
+    LinuxDumper::MemoryCopy page = { &copy[offset], src + offset, kPageSize };
+    copies.push_back(page);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_TRUE(dumper.CopyRangesFromProcess(getppid(), &copies[0],
+                                           copies.size()));
+  const double ranges_seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+
+  std::vector<uint8_t> peeked(length);
+  start = std::chrono::steady_clock::now();
+  for (size_t offset = 0; offset < length; offset += sizeof(long)) {
+    long word = ptrace(PTRACE_PEEKDATA, getppid(), src + offset, NULL);
+    memcpy(&peeked[offset], &word, sizeof(word));
+  }
+  const double peek_seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  EXPECT_TRUE(dumper.ThreadsResume());
+
+  EXPECT_EQ(0, memcmp(&copy[0], src, length));
+  EXPECT_EQ(0, memcmp(&peeked[0], src, length));
+  EXPECT_EQ(std::vector<uint8_t>(kPageSize, 0),
+            std::vector<uint8_t>(copy.begin() + length, copy.end()));
+  printf("Copied %zu bytes in %zu ranges in %.6fs; "
+         "PTRACE_PEEKDATA took %.6fs\n",
+         length, copies.size(), ranges_seconds, peek_seconds);
+}
+
 /* Get back to normal behavior of TEST*() macros wrt TestBody. */
 #undef TestBody
 
-TEST(LinuxPtraceDumperTest, VerifyStackReadWithMultipleThreads) {
+// Suspend a helper program's threads, using |num_helper_threads| threads
+// to do so, and check that each thread's registers can be read.
+static void VerifyStackRead(int num_helper_threads) {
   static const size_t kNumberOfThreadsInHelperProgram = 5;
 
   pid_t child_pid = SetupChildProcess(kNumberOfThreadsInHelperProgram);
@@ -438,6 +506,7 @@ TEST(LinuxPtraceDumperTest, VerifyStackReadWithMultipleThreads) {
 
   // Children are ready now.
   LinuxPtraceDumper dumper(child_pid);
+  dumper.set_num_helper_threads(num_helper_threads);
   ASSERT_TRUE(dumper.Init());
 #if defined(THREAD_SANITIZER)
   EXPECT_GE(dumper.threads().size(), (size_t)kNumberOfThreadsInHelperProgram);
@@ -491,6 +560,110 @@ TEST(LinuxPtraceDumperTest, VerifyStackReadWithMultipleThreads) {
   ASSERT_EQ(SIGKILL, WTERMSIG(status));
 }
 
+// The build id read from each loaded module's notes in memory should be the
+// one in its file.
+TEST(LinuxPtraceDumperTest, BuildIdsFromLoadedImage) {
+  LinuxPtraceDumper dumper(getpid());
+  ASSERT_TRUE(dumper.Init());
+
+  PageAllocator allocator;
+  size_t found = 0;
+  for (size_t i = 0; i < dumper.mappings().size(); ++i) {
+    const MappingInfo& mapping = *dumper.mappings()[i];
+    if (mapping.name[0] != '/')
+      continue;
+    id_vector loaded_id(&allocator, kDefaultBuildIdSize);
+    if (!dumper.ElfBuildIdFromLoadedImage(mapping, loaded_id))
+      continue;
+    ++found;
+
+    MemoryMappedFile mapped_file(mapping.name, 0);
+    ASSERT_TRUE(mapped_file.data()) << mapping.name;
+    id_vector file_id(&allocator, kDefaultBuildIdSize);
+    ASSERT_TRUE(FileID::ElfBuildIdFromMappedFile(mapped_file.data(),
+                                                 file_id))
+        << mapping.name;
+    EXPECT_EQ(FileID::ConvertIdentifierToString(file_id),
+              FileID::ConvertIdentifierToString(loaded_id))
+        << mapping.name;
+  }
+  // The C library, at least, has a build id.
+  EXPECT_GT(found, 0U);
+}
+
+TEST(LinuxPtraceDumperTest, VerifyStackReadWithMultipleThreads) {
+  VerifyStackRead(1);
+}
+
+// Each helper thread attaches to, reads and detaches from its own share of
+// the threads; three helpers for five threads gives some helpers two.
+TEST(LinuxPtraceDumperTest, VerifyStackReadWithHelperThreads) {
+  VerifyStackRead(3);
+}
+
+// A dumper that can't open /proc/<pid>/mem, so that memory
+// process_vm_readv() can't read is read with PTRACE_PEEKDATA.
+class NoMemFileDumper : public LinuxPtraceDumper {
+ public:
+  explicit NoMemFileDumper(pid_t pid) : LinuxPtraceDumper(pid) {}
+
+  virtual bool BuildProcPath(char* path, pid_t pid, const char* node) const {
+    if (!strcmp(node, "mem"))
+      return false;
+    return LinuxPtraceDumper::BuildProcPath(path, pid, node);
+  }
+};
+
+static void* PauseForever(void*) {
+  for (;;)
+    pause();
+  return NULL;
+}
+
+// process_vm_readv() can't read a PROT_NONE page, but PTRACE_PEEKDATA on
+// the thread that attached to the process can, even though helper threads
+// were asked for.
+TEST(LinuxPtraceDumperTest, PeekDataWithHelperThreads) {
+  const size_t kPageSize = getpagesize();
+  void* page = mmap(NULL, kPageSize, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  ASSERT_NE(MAP_FAILED, page);
+  memset(page, 0x5a, kPageSize);
+  ASSERT_EQ(0, mprotect(page, kPageSize, PROT_NONE));
+
+  int fds[2];
+  ASSERT_NE(-1, pipe(fds));
+  pid_t child_pid = fork();
+  if (child_pid == 0) {
+    // A second thread, so that there is more than one to suspend.
+    close(fds[0]);
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, PauseForever, NULL) != 0)
+      _exit(1);
+    IGNORE_RET(write(fds[1], "r", 1));
+    PauseForever(NULL);
+  }
+  close(fds[1]);
+  munmap(page, kPageSize);
+  char ready;
+  ASSERT_EQ(1, HANDLE_EINTR(read(fds[0], &ready, 1)));
+  close(fds[0]);
+
+  NoMemFileDumper dumper(child_pid);
+  dumper.set_num_helper_threads(2);
+  ASSERT_TRUE(dumper.Init());
+  EXPECT_EQ(2U, dumper.threads().size());
+  ASSERT_TRUE(dumper.ThreadsSuspend());
+  std::vector<uint8_t> copy(kPageSize);
+  dumper.CopyFromProcess(&copy[0], child_pid, page, kPageSize);
+  EXPECT_TRUE(dumper.ThreadsResume());
+  EXPECT_EQ(std::vector<uint8_t>(kPageSize, 0x5a), copy);
+
+  kill(child_pid, SIGKILL);
+  int status;
+  ASSERT_NE(-1, HANDLE_EINTR(waitpid(child_pid, &status, 0)));
+}
+
 TEST_F(LinuxPtraceDumperTest, SanitizeStackCopy) {
   static const size_t kNumberOfThreadsInHelperProgram = 1;
 
@@ -588,3 +761,71 @@ TEST_F(LinuxPtraceDumperTest, SanitizeStackCopy) {
   ASSERT_TRUE(WIFSIGNALED(status));
   ASSERT_EQ(SIGKILL, WTERMSIG(status));
 }
+
+// Stack words, whether tested a block at a time or one at a time, are
+// matched against the right mapping among many.
+TEST(LinuxPtraceDumperTest, SanitizeStackCopyManyMappings) {
+  static const size_t kMappings = 301;
+  const size_t page_size = getpagesize();
+  void* mappings[kMappings];
+  for (size_t i = 0; i < kMappings; ++i) {
+    mappings[i] = mmap(NULL, page_size,
+                       PROT_READ | (i % 2 ? PROT_EXEC : 0),
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ASSERT_NE(MAP_FAILED, mappings[i]);
+  }
+
+  LinuxPtraceDumper dumper(getpid());
+  ASSERT_TRUE(dumper.Init());
+
+  const uintptr_t defaced =
+#if defined(__LP64__)
+      0x0defaced0defaced;
+#else
+      0x0defaced;
+#endif
+
+  // One word at the start of each mapping, some small integers and a
+  // string fragment, copied to an unaligned buffer.
+  std::vector<uintptr_t> words;
+  for (size_t i = 0; i < kMappings; ++i)
+    words.push_back(reinterpret_cast<uintptr_t>(mappings[i]) + i % 64);
+  words.push_back(static_cast<uintptr_t>(-4096));
+  words.push_back(4096);
+  uintptr_t text;
+  memcpy(&text, "abcdefghijklmnop", sizeof(text));
+  words.push_back(text);
+  std::vector<uint8_t> stack(words.size() * sizeof(uintptr_t) + 1);
+  memcpy(&stack[1], &words[0], words.size() * sizeof(uintptr_t));
+
+  uintptr_t stack_pointer = reinterpret_cast<uintptr_t>(&text);
+  dumper.SanitizeStackCopy(&stack[1], words.size() * sizeof(uintptr_t),
+                           stack_pointer, 0);
+
+  std::vector<uintptr_t> sanitized(words.size());
+  memcpy(&sanitized[0], &stack[1], words.size() * sizeof(uintptr_t));
+  for (size_t i = 0; i < kMappings; ++i) {
+    EXPECT_EQ(i % 2 ? words[i] : defaced, sanitized[i]) << i;
+  }
+  EXPECT_EQ(words[kMappings], sanitized[kMappings]);
+  EXPECT_EQ(words[kMappings + 1], sanitized[kMappings + 1]);
+  EXPECT_EQ(defaced, sanitized[kMappings + 2]);
+
+  // StackHasPointerToMapping() finds the mappings that a word points into.
+  for (size_t i = 0; i < dumper.mappings().size(); ++i) {
+    const MappingInfo& mapping = *dumper.mappings()[i];
+    const uintptr_t start = mapping.system_mapping_info.start_addr;
+    bool in_words = false;
+    for (size_t j = 0; j < kMappings; ++j) {
+      in_words |= words[j] >= start &&
+          words[j] <= mapping.system_mapping_info.end_addr;
+    }
+    EXPECT_EQ(in_words,
+              dumper.StackHasPointerToMapping(
+                  reinterpret_cast<uint8_t*>(&words[0]),
+                  words.size() * sizeof(uintptr_t), 0, mapping));
+  }
+
+  for (size_t i = 0; i < kMappings; ++i)
+    munmap(mappings[i], page_size);
+}
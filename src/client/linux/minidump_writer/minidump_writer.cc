@@ -67,6 +67,8 @@
 
 #include <algorithm>
 
+#include "client/linux/dump_writer_common/crash_key_store.h"
+#include "client/linux/dump_writer_common/module_table.h"
 #include "client/linux/dump_writer_common/thread_info.h"
 #include "client/linux/dump_writer_common/ucontext_reader.h"
 #include "client/linux/handler/exception_handler.h"
@@ -77,8 +79,10 @@
 #include "client/linux/minidump_writer/pe_file.h"
 #include "client/linux/minidump_writer/pe_structs.h"
 #include "client/linux/minidump_writer/proc_cpuinfo_reader.h"
+#include "client/dump_timing.h"
 #include "client/minidump_file_writer.h"
 #include "common/linux/file_id.h"
+#include "common/linux/guid_creator.h"
 #include "common/linux/linux_libc_support.h"
 #include "common/minidump_type_helper.h"
 #include "google_breakpad/common/minidump_format.h"
@@ -91,6 +95,8 @@ using google_breakpad::auto_wasteful_vector;
 using google_breakpad::elf::kDefaultBuildIdSize;
 using google_breakpad::ExceptionHandler;
 using google_breakpad::CpuSet;
+using google_breakpad::CrashKeyStore;
+using google_breakpad::DumpTiming;
 using google_breakpad::LineReader;
 using google_breakpad::LinuxDumper;
 using google_breakpad::LinuxPtraceDumper;
@@ -99,6 +105,7 @@ using google_breakpad::MappingEntry;
 using google_breakpad::MappingInfo;
 using google_breakpad::MappingList;
 using google_breakpad::MinidumpFileWriter;
+using google_breakpad::ModuleTable;
 using google_breakpad::PageAllocator;
 using google_breakpad::PEFile;
 using google_breakpad::PEFileFormat;
@@ -114,23 +121,63 @@ using google_breakpad::wasteful_vector;
 typedef MDTypeHelper<sizeof(void*)>::MDRawDebug MDRawDebug;
 typedef MDTypeHelper<sizeof(void*)>::MDRawLinkMap MDRawLinkMap;
 
+// A file that is copied into a stream of its own.  A |proc| file is read
+// from the crashing thread's directory in /proc.
+struct FileStream {
+  uint32_t stream_type;
+  const char* name;
+  bool proc;
+};
+
+// The file streams, in the order that they are written.
+const FileStream kFileStreams[] = {
+  { MD_LINUX_CPU_INFO, "/proc/cpuinfo", false },
+  { MD_LINUX_PROC_STATUS, "status", true },
+  { MD_LINUX_LSB_RELEASE, "/etc/lsb-release", false },
+  { MD_LINUX_CMD_LINE, "cmdline", true },
+  { MD_LINUX_ENVIRON, "environ", true },
+  { MD_LINUX_AUXV, "auxv", true },
+  { MD_LINUX_MAPS, "maps", true },
+};
+const size_t kNumFileStreams = sizeof(kFileStreams) / sizeof(kFileStreams[0]);
+
+// Rounds |size| up to the 64-bit alignment of MinidumpFileWriter
+// allocations.
+size_t AlignedSize(size_t size) {
+  return (size + 7) & ~static_cast<size_t>(7);
+}
+
 class MinidumpWriter {
  public:
+  // A minidump file contains a number of tagged streams. This is the number
+  // of stream which we write.
+  static const unsigned kNumWriters = 18;
+
   // The following kLimit* constants are for when minidump_size_limit_ is set
-  // and the minidump size might exceed it.
+  // and PlanSizeBudget() shares it out.
   //
-  // Estimate for how big each thread's stack will be (in bytes).
-  static const unsigned kLimitAverageThreadStackLength = 8 * 1024;
-  // Number of threads whose stack size we don't want to limit.  These base
-  // threads will simply be the first N threads returned by the dumper (although
-  // the crashing thread will never be limited).  Threads beyond this count are
-  // the extra threads.
-  static const unsigned kLimitBaseThreadCount = 20;
-  // Maximum stack size to dump for any extra thread (in bytes).
-  static const unsigned kLimitMaxExtraThreadStackLen = 2 * 1024;
-  // Make sure this number of additional bytes can fit in the minidump
-  // (exclude the stack data).
+  // Bytes set aside for the header and directory, the exception and system
+  // info streams, the DSO debug stream, the crash keys, the crash
+  // signature and the timing stream, none of which are planned.
   static const unsigned kLimitMinidumpFudgeFactor = 64 * 1024;
+  // Bytes of each thread's stack, from the page holding its stack pointer,
+  // that come before anything else but the crashing thread's stack.
+  static const unsigned kLimitThreadStackTopLength = 4 * 1024;
+  // Bytes allowed for each module's CodeView record and for the difference
+  // between the length of its mapping's name and of the name written.
+  static const unsigned kLimitModuleRecordSlack = 128;
+
+  // Bytes of each thread's stack, from the page holding its stack pointer,
+  // that a low-pause snapshot reads before letting the process run again.
+  static const unsigned kSnapshotStackTopLength = 16 * 1024;
+
+  // The most bytes of a module's .eh_frame, and of its ELF and program
+  // headers, that WriteUnwindInfo() writes.
+  static const unsigned kMaxEhFrameLength = 4 * 1024 * 1024;
+  static const unsigned kMaxElfHeadersLength = 4 * 1024;
+  // DW_EH_PE_pcrel | DW_EH_PE_sdata4, the encoding linkers give the
+  // .eh_frame pointer in .eh_frame_hdr.
+  static const uint8_t kEhFramePointerEncoding = 0x1b;
 
   MinidumpWriter(const char* minidump_path,
                  int minidump_fd,
@@ -150,23 +197,55 @@ class MinidumpWriter {
         dumper_(dumper),
         minidump_size_limit_(-1),
         memory_blocks_(dumper_->allocator()),
+        inconsistent_blocks_(dumper_->allocator()),
+        series_regions_(dumper_->allocator()),
         mapping_list_(mappings),
         app_memory_list_(appmem),
         skip_stacks_if_mapping_unreferenced_(
             skip_stacks_if_mapping_unreferenced),
         principal_mapping_address_(principal_mapping_address),
         principal_mapping_(nullptr),
-    sanitize_stacks_(sanitize_stacks) {
+    sanitize_stacks_(sanitize_stacks),
+    budget_left_(0),
+    stack_length_limits_(NULL),
+    app_memory_included_(NULL),
+    module_limit_(static_cast<unsigned>(-1)),
+    module_table_(NULL),
+    crash_key_store_(context ? context->crash_key_store : 0),
+    crash_signature_(context ? context->crash_signature : 0),
+    crash_signature_frames_(context ? context->crash_signature_frames : 0),
+    low_pause_(false),
+    include_unwind_info_(false),
+    unwind_info_modules_(NULL),
+    snapshot_infos_(NULL),
+    snapshot_info_valid_(NULL),
+    snapshot_stacks_(NULL),
+    series_(NULL),
+    series_delta_(false) {
+    for (size_t i = 0; i < kNumFileStreams; ++i)
+      file_length_limits_[i] = static_cast<size_t>(-1);
     // Assert there should be either a valid fd or a valid path, not both.
     assert(fd_ != -1 || minidump_path);
     assert(fd_ == -1 || !minidump_path);
   }
 
   bool Init() {
+    timing_.Begin(MD_DUMP_PHASE_TOTAL);
+
+    timing_.Begin(MD_DUMP_PHASE_MAPPING_ENUMERATION);
     if (!dumper_->Init())
       return false;
+    timing_.End(MD_DUMP_PHASE_MAPPING_ENUMERATION, dumper_->mappings().size());
 
-    if (!dumper_->ThreadsSuspend() || !dumper_->LateInit())
+    timing_.Begin(MD_DUMP_PHASE_THREAD_SUSPEND);
+    if (!dumper_->ThreadsSuspend())
+      return false;
+    timing_.End(MD_DUMP_PHASE_THREAD_SUSPEND, dumper_->threads().size());
+
+    if (!dumper_->LateInit())
+      return false;
+
+    if (low_pause_ && !TakeSnapshot())
       return false;
 
     if (skip_stacks_if_mapping_unreferenced_) {
@@ -225,9 +304,8 @@ class MinidumpWriter {
   }
 
   bool Dump() {
-    // A minidump file contains a number of tagged streams. This is the number
-    // of stream which we write.
-    unsigned kNumWriters = 13;
+    if (minidump_size_limit_ >= 0)
+      PlanSizeBudget();
 
     TypedMDRVA<MDRawDirectory> dir(&minidump_writer_);
     {
@@ -253,78 +331,330 @@ class MinidumpWriter {
     unsigned dir_index = 0;
     MDRawDirectory dirent;
 
+    if (include_unwind_info_) {
+      const size_t num_mappings = dumper_->mappings().size();
+      unwind_info_modules_ =
+          reinterpret_cast<bool*>(Alloc(num_mappings * sizeof(bool)));
+      my_memset(unwind_info_modules_, 0, num_mappings * sizeof(bool));
+    }
+
     if (!WriteThreadListStream(&dirent))
       return false;
     dir.CopyIndex(dir_index++, &dirent);
 
-    if (!WriteMappings(&dirent))
+    // A delta snapshot leaves the modules, and the rest of the streams
+    // that describe the process rather than its threads, to the first.
+    if (series_delta_)
+      NullifyDirectoryEntry(&dirent);
+    else if (!WriteMappings(&dirent))
       return false;
     dir.CopyIndex(dir_index++, &dirent);
 
+    timing_.Begin(MD_DUMP_PHASE_MEMORY_LIST);
     if (!WriteAppMemory())
       return false;
 
+    if (!WriteUnwindInfo())
+      return false;
+
     if (!WriteMemoryListStream(&dirent))
       return false;
     dir.CopyIndex(dir_index++, &dirent);
+    timing_.End(MD_DUMP_PHASE_MEMORY_LIST, memory_blocks_.size());
 
     if (!WriteExceptionStream(&dirent))
       return false;
     dir.CopyIndex(dir_index++, &dirent);
 
-    if (!WriteSystemInfoStream(&dirent))
+    if (series_delta_)
+      NullifyDirectoryEntry(&dirent);
+    else if (!WriteSystemInfoStream(&dirent))
       return false;
     dir.CopyIndex(dir_index++, &dirent);
 
-    dirent.stream_type = MD_LINUX_CPU_INFO;
-    if (!WriteFile(&dirent.location, "/proc/cpuinfo"))
-      NullifyDirectoryEntry(&dirent);
-    dir.CopyIndex(dir_index++, &dirent);
+    for (size_t i = 0; i < kNumFileStreams; ++i) {
+      char path[NAME_MAX];
+      dirent.stream_type = kFileStreams[i].stream_type;
+      if (series_delta_ || !GetFileStreamPath(i, path) ||
+          !WriteFile(&dirent.location, path, file_length_limits_[i])) {
+        NullifyDirectoryEntry(&dirent);
+      }
+      dir.CopyIndex(dir_index++, &dirent);
+    }
 
-    dirent.stream_type = MD_LINUX_PROC_STATUS;
-    if (!WriteProcFile(&dirent.location, GetCrashThread(), "status"))
+    dirent.stream_type = MD_LINUX_DSO_DEBUG;
+    if (series_delta_ || !WriteDSODebugStream(&dirent))
       NullifyDirectoryEntry(&dirent);
     dir.CopyIndex(dir_index++, &dirent);
 
-    dirent.stream_type = MD_LINUX_LSB_RELEASE;
-    if (!WriteFile(&dirent.location, "/etc/lsb-release"))
+    if (!WriteInconsistentMemoryStream(&dirent))
       NullifyDirectoryEntry(&dirent);
     dir.CopyIndex(dir_index++, &dirent);
 
-    dirent.stream_type = MD_LINUX_CMD_LINE;
-    if (!WriteProcFile(&dirent.location, GetCrashThread(), "cmdline"))
+    if (!WriteCrashpadInfoStream(&dirent))
       NullifyDirectoryEntry(&dirent);
     dir.CopyIndex(dir_index++, &dirent);
 
-    dirent.stream_type = MD_LINUX_ENVIRON;
-    if (!WriteProcFile(&dirent.location, GetCrashThread(), "environ"))
+    if (!WriteCrashSignatureStream(&dirent))
       NullifyDirectoryEntry(&dirent);
     dir.CopyIndex(dir_index++, &dirent);
 
-    dirent.stream_type = MD_LINUX_AUXV;
-    if (!WriteProcFile(&dirent.location, GetCrashThread(), "auxv"))
+    if (!WriteSnapshotSeriesStream(&dirent))
       NullifyDirectoryEntry(&dirent);
     dir.CopyIndex(dir_index++, &dirent);
 
-    dirent.stream_type = MD_LINUX_MAPS;
-    if (!WriteProcFile(&dirent.location, GetCrashThread(), "maps"))
-      NullifyDirectoryEntry(&dirent);
-    dir.CopyIndex(dir_index++, &dirent);
+    dumper_->ThreadsResume();
 
-    dirent.stream_type = MD_LINUX_DSO_DEBUG;
-    if (!WriteDSODebugStream(&dirent))
+    // Flush everything but the timing stream, so that the stream can tell
+    // how long that took.
+    timing_.Begin(MD_DUMP_PHASE_WRITE_FLUSH);
+    if (!minidump_writer_.Flush())
+      return false;
+    timing_.End(MD_DUMP_PHASE_WRITE_FLUSH, 0, minidump_writer_.position());
+
+    if (!WriteDumpTimingStream(&dirent, dir_index))
       NullifyDirectoryEntry(&dirent);
     dir.CopyIndex(dir_index++, &dirent);
 
     // If you add more directory entries, don't forget to update kNumWriters,
     // above.
 
-    dumper_->ThreadsResume();
+    return minidump_writer_.Finish();
+  }
+
+  // Shares minidump_size_limit_ out among the contents of the minidump,
+  // most important first:
+  //   1. the crashing thread's stack, and the memory around its
+  //      instruction pointer;
+  //   2. the top kLimitThreadStackTopLength bytes of the other stacks;
+  //   3. the module list;
+  //   4. the application-provided memory regions, each whole or not at all;
+  //   5. the /proc/$x/maps file;
+  //   6. the other files copied into the minidump;
+  //   7. the rest of the other stacks, a little more of each at a time.
+  // Whatever cannot be planned for exactly, such as the header and the
+  // small streams, is covered by kLimitMinidumpFudgeFactor.  The writers
+  // then hold to the plan, so the minidump fits unless the fudge factor is
+  // not enough.
+  void PlanSizeBudget() {
+    const unsigned num_threads = dumper_->threads().size();
+    const size_t num_app_memory = app_memory_list_.size();
+
+    // The thread and memory lists and the thread contexts, and what
+    // cannot be planned for.
+    const size_t fixed_size =
+        AlignedSize(sizeof(uint32_t) + num_threads * sizeof(MDRawThread)) +
+        num_threads * AlignedSize(sizeof(RawContextCPU)) +
+        AlignedSize(sizeof(uint32_t) +
+                    (num_threads + 1 + num_app_memory) *
+                    sizeof(MDMemoryDescriptor)) +
+        kLimitMinidumpFudgeFactor;
+    budget_left_ = static_cast<size_t>(minidump_size_limit_);
+    budget_left_ -= std::min(budget_left_, fixed_size);
+
+    // Find out how much of each stack there is to write.
+    size_t* stack_lengths =
+        reinterpret_cast<size_t*>(Alloc(num_threads * sizeof(size_t)));
+    stack_length_limits_ =
+        reinterpret_cast<int*>(Alloc(num_threads * sizeof(int)));
+    unsigned crash_thread_index = num_threads;
+    for (unsigned i = 0; i < num_threads; ++i) {
+      stack_lengths[i] = 0;
+      stack_length_limits_[i] = 0;
+
+      uintptr_t stack_pointer;
+      if (dumper_->threads()[i] == GetCrashThread() && ucontext_ &&
+          !dumper_->IsPostMortem()) {
+        stack_pointer = UContextReader::GetStackPointer(ucontext_);
+      } else {
+        ThreadInfo info;
+        if (!GetThreadInfo(i, &info))
+          continue;
+        stack_pointer = info.stack_pointer;
+      }
+      if (dumper_->threads()[i] == GetCrashThread())
+        crash_thread_index = i;
+
+      const void* stack;
+      if (!dumper_->GetStackInfo(&stack, &stack_lengths[i], stack_pointer))
+        stack_lengths[i] = 0;
+    }
+
+    // 1. The crashing thread's stack, and 256 bytes of code.
+    if (crash_thread_index < num_threads) {
+      TakeFromBudget(256);
+      GrowStackLimit(crash_thread_index, stack_lengths[crash_thread_index],
+                     stack_lengths);
+    }
+
+    // 2. The tops of the other stacks.
+    for (unsigned i = 0; i < num_threads; ++i)
+      GrowStackLimit(i, kLimitThreadStackTopLength, stack_lengths);
+
+    // 3. The module list, cut short if it does not all fit.
+    unsigned num_modules = 0;
+    size_t module_list_size = AlignedSize(sizeof(uint32_t));
+    for (unsigned i = 0; i < dumper_->mappings().size(); ++i) {
+      const MappingInfo& mapping = *dumper_->mappings()[i];
+      if (ShouldIncludeMapping(mapping) && !HaveMappingInfo(mapping)) {
+        module_list_size += ModuleSize(my_strlen(mapping.name));
+        ++num_modules;
+      }
+    }
+    for (MappingList::const_iterator iter = mapping_list_.begin();
+         iter != mapping_list_.end();
+         ++iter) {
+      module_list_size += ModuleSize(my_strlen(iter->first.name));
+      ++num_modules;
+    }
+    if (TakeAllFromBudget(module_list_size) || !num_modules) {
+      module_limit_ = num_modules;
+    } else {
+      // Assume that the rest of the modules are like the average one.
+      module_limit_ = budget_left_ * num_modules / module_list_size;
+      TakeFromBudget(module_list_size * module_limit_ / num_modules);
+    }
+
+    // 4. The application-provided memory, in the order it was registered.
+    app_memory_included_ =
+        reinterpret_cast<bool*>(Alloc(num_app_memory * sizeof(bool)));
+    size_t i = 0;
+    for (AppMemoryList::const_iterator iter = app_memory_list_.begin();
+         iter != app_memory_list_.end();
+         ++iter, ++i) {
+      app_memory_included_[i] = TakeAllFromBudget(AlignedSize(iter->length));
+    }
+
+    // 5 and 6. The files, maps first.
+    for (int maps = 1; maps >= 0; --maps) {
+      for (size_t j = 0; j < kNumFileStreams; ++j) {
+        if ((kFileStreams[j].stream_type == MD_LINUX_MAPS) != (maps == 1))
+          continue;
+        char path[NAME_MAX];
+        const size_t length = GetFileStreamPath(j, path) ?
+            MeasureFile(path) : 0;
+        file_length_limits_[j] = TakeFromBudget(AlignedSize(length));
+      }
+    }
+
+    // 7. The rest of the stacks, a bit at a time so that each thread gets
+    // its share.
+    size_t longest_stack = 0;
+    for (unsigned j = 0; j < num_threads; ++j)
+      longest_stack = std::max(longest_stack, stack_lengths[j]);
+    for (size_t length = 2 * kLimitThreadStackTopLength;
+         budget_left_ > 0 && length < 2 * longest_stack;
+         length *= 2) {
+      for (unsigned j = 0; j < num_threads; ++j)
+        GrowStackLimit(j, length, stack_lengths);
+    }
+  }
+
+  // Takes up to |size| bytes from the size budget, and returns how many
+  // were taken.
+  size_t TakeFromBudget(size_t size) {
+    const size_t taken = std::min(size, budget_left_);
+    budget_left_ -= taken;
+    return taken;
+  }
+
+  // Takes |size| bytes from the size budget if they are all there.
+  bool TakeAllFromBudget(size_t size) {
+    if (size > budget_left_)
+      return false;
+    budget_left_ -= size;
+    return true;
+  }
+
+  // Raises the length of thread |index|'s stack that may be written to
+  // |length| bytes, or as much of that as the budget and the stack allow.
+  void GrowStackLimit(unsigned index, size_t length,
+                      const size_t* stack_lengths) {
+    length = std::min(length, stack_lengths[index]);
+    const size_t current = stack_length_limits_[index];
+    if (length > current) {
+      stack_length_limits_[index] =
+          static_cast<int>(current + TakeFromBudget(length - current));
+    }
+  }
+
+  // The most space a module list entry whose mapping's name is
+  // |name_length| bytes long is expected to take, with its name and
+  // CodeView record.
+  static size_t ModuleSize(size_t name_length) {
+    return MD_MODULE_SIZE + kLimitModuleRecordSlack +
+        AlignedSize(sizeof(uint32_t) + (name_length + 1) * sizeof(uint16_t));
+  }
+
+  // Reads the registers of each thread and the top kSnapshotStackTopLength
+  // bytes of its stack, all in one go, then lets the process run again.
+  // Everything else is read from the running process.
+  bool TakeSnapshot() {
+    const unsigned num_threads = dumper_->threads().size();
+    snapshot_infos_ =
+        reinterpret_cast<ThreadInfo*>(Alloc(num_threads * sizeof(ThreadInfo)));
+    snapshot_info_valid_ =
+        reinterpret_cast<bool*>(Alloc(num_threads * sizeof(bool)));
+    snapshot_stacks_ = reinterpret_cast<LinuxDumper::MemoryCopy*>(
+        Alloc(num_threads * sizeof(LinuxDumper::MemoryCopy)));
+    for (unsigned i = 0; i < num_threads; ++i) {
+      LinuxDumper::MemoryCopy* stack_top = &snapshot_stacks_[i];
+      stack_top->dest = NULL;
+      stack_top->src = NULL;
+      stack_top->length = 0;
+
+      snapshot_info_valid_[i] =
+          dumper_->GetThreadInfoByIndex(i, &snapshot_infos_[i]);
+      const void* stack;
+      size_t stack_len;
+      if (!snapshot_info_valid_[i] ||
+          !dumper_->GetStackInfo(&stack, &stack_len,
+                                 snapshot_infos_[i].stack_pointer))
+        continue;
+      stack_top->src = stack;
+      stack_top->length = std::min<size_t>(stack_len, kSnapshotStackTopLength);
+      stack_top->dest = Alloc(stack_top->length);
+    }
+    dumper_->CopyRangesFromProcess(GetCrashThread(), snapshot_stacks_,
+                                   num_threads);
+    return dumper_->ThreadsResume();
+  }
+
+  // Reads information about the |index|-th thread of the dumper, from the
+  // snapshot if there is one.
+  bool GetThreadInfo(size_t index, ThreadInfo* info) {
+    if (!snapshot_infos_)
+      return dumper_->GetThreadInfoByIndex(index, info);
+    if (!snapshot_info_valid_[index])
+      return false;
+    *info = snapshot_infos_[index];
     return true;
   }
 
-  bool FillThreadStack(MDRawThread* thread, uintptr_t stack_pointer,
-                       uintptr_t pc, int max_stack_len, uint8_t** stack_copy) {
+  // Copies what the snapshot holds of the |index|-th thread's stack over
+  // |stack_copy|, the |stack_len| bytes at |stack|. Returns true if they
+  // were all in the snapshot, or there is no snapshot.
+  bool CopyStackFromSnapshot(size_t index, const void* stack,
+                             uint8_t* stack_copy, size_t stack_len) {
+    if (!snapshot_stacks_)
+      return true;
+    const LinuxDumper::MemoryCopy& stack_top = snapshot_stacks_[index];
+    const uintptr_t start = reinterpret_cast<uintptr_t>(stack);
+    const uintptr_t top_start = reinterpret_cast<uintptr_t>(stack_top.src);
+    const uintptr_t from = std::max(start, top_start);
+    const uintptr_t to = std::min(start + stack_len,
+                                  top_start + stack_top.length);
+    if (from >= to)
+      return false;
+    my_memcpy(stack_copy + (from - start),
+              static_cast<const uint8_t*>(stack_top.dest) + (from - top_start),
+              to - from);
+    return from == start && to == start + stack_len;
+  }
+
+  bool FillThreadStack(MDRawThread* thread, size_t thread_index,
+                       uintptr_t stack_pointer, uintptr_t pc,
+                       int max_stack_len, uint8_t** stack_copy) {
     *stack_copy = NULL;
     const void* stack;
     size_t stack_len;
@@ -346,9 +676,15 @@ class MinidumpWriter {
         }
         stack = reinterpret_cast<const void*>(int_stack);
       }
+      if (!stack_len)
+        return true;
       *stack_copy = reinterpret_cast<uint8_t*>(Alloc(stack_len));
+      timing_.Begin(MD_DUMP_PHASE_STACK_COPY);
       dumper_->CopyFromProcess(*stack_copy, thread->thread_id, stack,
                                stack_len);
+      timing_.End(MD_DUMP_PHASE_STACK_COPY, 1, stack_len);
+      const bool consistent =
+          CopyStackFromSnapshot(thread_index, stack, *stack_copy, stack_len);
 
       uintptr_t stack_pointer_offset =
           stack_pointer - reinterpret_cast<uintptr_t>(stack);
@@ -371,13 +707,88 @@ class MinidumpWriter {
                                    stack_pointer_offset);
       }
 
-      UntypedMDRVA memory(&minidump_writer_);
-      if (!memory.Allocate(stack_len))
+      if (!WriteMemory(reinterpret_cast<uintptr_t>(stack), *stack_copy,
+                       stack_len, &thread->stack)) {
         return false;
-      memory.Copy(*stack_copy, stack_len);
-      thread->stack.start_of_memory_range = reinterpret_cast<uintptr_t>(stack);
-      thread->stack.memory = memory.location();
-      memory_blocks_.push_back(thread->stack);
+      }
+      if (!consistent)
+        inconsistent_blocks_.push_back(thread->stack);
+    }
+    return true;
+  }
+
+  // Writes the |length| bytes at |data|, copied from |start| in the
+  // process, adds them to memory_blocks_, and sets |desc| to describe them.
+  // The first snapshot of a series records each page's part of them.  A
+  // delta snapshot writes only the parts that differ from the first
+  // snapshot's, adds the whole to series_regions_, and sets |desc|'s rva
+  // to 0.  See MD_SNAPSHOT_SERIES_STREAM.
+  bool WriteMemory(uintptr_t start, const uint8_t* data, size_t length,
+                   MDMemoryDescriptor* desc) {
+    desc->start_of_memory_range = start;
+    if (series_delta_) {
+      desc->memory.data_size = length;
+      desc->memory.rva = 0;
+      series_regions_.push_back(*desc);
+      return WriteChangedPieces(start, data, length);
+    }
+
+    UntypedMDRVA memory(&minidump_writer_);
+    if (!memory.Allocate(length))
+      return false;
+    memory.Copy(data, length);
+    desc->memory = memory.location();
+    memory_blocks_.push_back(*desc);
+    if (series_) {
+      for (uintptr_t piece = start; piece < start + length;) {
+        const uintptr_t piece_end = PieceEnd(piece, start + length);
+        series_->AddBasePiece(piece, data + (piece - start), piece_end - piece);
+        piece = piece_end;
+      }
+    }
+    return true;
+  }
+
+  // Returns the end of the piece of memory that starts at |piece|: the end
+  // of its page, or |end| if that comes first.
+  uintptr_t PieceEnd(uintptr_t piece, uintptr_t end) const {
+    const uintptr_t page_end =
+        (piece & ~static_cast<uintptr_t>(series_->page_size() - 1)) +
+        series_->page_size();
+    return std::min(page_end, end);
+  }
+
+  // Writes the runs of the pages' parts of the |length| bytes at |data|,
+  // copied from |start|, that differ from the first snapshot's, adding each
+  // run to memory_blocks_.
+  bool WriteChangedPieces(uintptr_t start, const uint8_t* data,
+                          size_t length) {
+    uintptr_t run_start = start;
+    for (uintptr_t piece = start; piece <= start + length;) {
+      bool changed = false;
+      uintptr_t piece_end = start + length;
+      if (piece < start + length) {
+        piece_end = PieceEnd(piece, start + length);
+        changed = series_->PieceChanged(piece, data + (piece - start),
+                                        piece_end - piece);
+      }
+      if (!changed) {
+        // The run of changed pieces, if any, ends here.
+        if (piece > run_start) {
+          UntypedMDRVA memory(&minidump_writer_);
+          if (!memory.Allocate(piece - run_start))
+            return false;
+          memory.Copy(data + (run_start - start), piece - run_start);
+          MDMemoryDescriptor run;
+          run.start_of_memory_range = run_start;
+          run.memory = memory.location();
+          memory_blocks_.push_back(run);
+        }
+        run_start = piece_end;
+      }
+      if (piece == start + length)
+        break;
+      piece = piece_end;
     }
     return true;
   }
@@ -395,22 +806,11 @@ class MinidumpWriter {
 
     *list.get() = num_threads;
 
-    // If there's a minidump size limit, check if it might be exceeded.  Since
-    // most of the space is filled with stack data, just check against that.
-    // If this expects to exceed the limit, set extra_thread_stack_len such
-    // that any thread beyond the first kLimitBaseThreadCount threads will
-    // have only kLimitMaxExtraThreadStackLen bytes dumped.
-    int extra_thread_stack_len = -1;  // default to no maximum
-    if (minidump_size_limit_ >= 0) {
-      const unsigned estimated_total_stack_size = num_threads *
-          kLimitAverageThreadStackLength;
-      const off_t estimated_minidump_size = minidump_writer_.position() +
-          estimated_total_stack_size + kLimitMinidumpFudgeFactor;
-      if (estimated_minidump_size > minidump_size_limit_)
-        extra_thread_stack_len = kLimitMaxExtraThreadStackLen;
-    }
-
     for (unsigned i = 0; i < num_threads; ++i) {
+      // With a size limit, PlanSizeBudget() has set how much of each stack
+      // fits.
+      const int max_stack_len =
+          stack_length_limits_ ? stack_length_limits_[i] : -1;
       MDRawThread thread;
       my_memset(&thread, 0, sizeof(thread));
       thread.thread_id = dumper_->threads()[i];
@@ -424,10 +824,12 @@ class MinidumpWriter {
           !dumper_->IsPostMortem()) {
         uint8_t* stack_copy;
         const uintptr_t stack_ptr = UContextReader::GetStackPointer(ucontext_);
-        if (!FillThreadStack(&thread, stack_ptr,
+        if (!FillThreadStack(&thread, i, stack_ptr,
                              UContextReader::GetInstructionPointer(ucontext_),
-                             -1, &stack_copy))
+                             max_stack_len, &stack_copy))
           return false;
+        MarkUnwindInfoModule(UContextReader::GetInstructionPointer(ucontext_));
+        MarkUnwindInfoModules(stack_copy, thread.stack.memory.data_size);
 
         // Copy 256 bytes around crashing instruction pointer to minidump.
         const size_t kIPMemorySize = 256;
@@ -485,17 +887,17 @@ class MinidumpWriter {
         crashing_thread_context_ = cpu.location();
       } else {
         ThreadInfo info;
-        if (!dumper_->GetThreadInfoByIndex(i, &info))
+        if (!GetThreadInfo(i, &info))
           return false;
 
         uint8_t* stack_copy;
-        int max_stack_len = -1;  // default to no maximum for this thread
-        if (minidump_size_limit_ >= 0 && i >= kLimitBaseThreadCount)
-          max_stack_len = extra_thread_stack_len;
-        if (!FillThreadStack(&thread, info.stack_pointer,
+        if (!FillThreadStack(&thread, i, info.stack_pointer,
                              info.GetInstructionPointer(), max_stack_len,
                              &stack_copy))
           return false;
+        MarkUnwindInfoModule(info.GetInstructionPointer());
+        if (dumper_->threads()[i] == GetCrashThread())
+          MarkUnwindInfoModules(stack_copy, thread.stack.memory.data_size);
 
         TypedMDRVA<RawContextCPU> cpu(&minidump_writer_);
         if (!cpu.Allocate())
@@ -522,28 +924,305 @@ class MinidumpWriter {
 
   // Write application-provided memory regions.
   bool WriteAppMemory() {
+    // Read all of the regions at once, so that a ptrace dumper can fetch
+    // them with a few system calls rather than a few per region.
+    // With a size limit, PlanSizeBudget() has chosen which regions fit.
+    LinuxDumper::MemoryCopy* copies =
+        reinterpret_cast<LinuxDumper::MemoryCopy*>(
+            Alloc(app_memory_list_.size() * sizeof(LinuxDumper::MemoryCopy)));
+    size_t count = 0;
+    size_t i = 0;
     for (AppMemoryList::const_iterator iter = app_memory_list_.begin();
          iter != app_memory_list_.end();
-         ++iter) {
-      uint8_t* data_copy =
-        reinterpret_cast<uint8_t*>(dumper_->allocator()->Alloc(iter->length));
-      dumper_->CopyFromProcess(data_copy, GetCrashThread(), iter->ptr,
-                               iter->length);
+         ++iter, ++i) {
+      if (app_memory_included_ && !app_memory_included_[i])
+        continue;
+      // A region within a stack, or within another region, is already
+      // there.
+      if (MemoryWritten(reinterpret_cast<uintptr_t>(iter->ptr), iter->length,
+                        copies, count)) {
+        continue;
+      }
+      copies[count].dest = dumper_->allocator()->Alloc(iter->length);
+      copies[count].src = iter->ptr;
+      copies[count].length = iter->length;
+      ++count;
+      timing_.Count(MD_DUMP_PHASE_MEMORY_LIST, 0, iter->length);
+    }
+    dumper_->CopyRangesFromProcess(GetCrashThread(), copies, count);
 
-      UntypedMDRVA memory(&minidump_writer_);
-      if (!memory.Allocate(iter->length)) {
+    for (size_t copy = 0; copy < count; ++copy) {
+      MDMemoryDescriptor desc;
+      if (!WriteMemory(reinterpret_cast<uintptr_t>(copies[copy].src),
+                       static_cast<const uint8_t*>(copies[copy].dest),
+                       copies[copy].length, &desc)) {
         return false;
       }
-      memory.Copy(data_copy, iter->length);
+      if (low_pause_)
+        inconsistent_blocks_.push_back(desc);
+    }
+
+    return true;
+  }
+
+  // Returns true if the length bytes at start are all within one of
+  // memory_blocks_, or of series_regions_ for a delta snapshot, or one of
+  // the count regions at copies.
+  bool MemoryWritten(uintptr_t start, size_t length,
+                     const LinuxDumper::MemoryCopy* copies, size_t count) {
+    const wasteful_vector<MDMemoryDescriptor>& blocks =
+        series_delta_ ? series_regions_ : memory_blocks_;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+      const MDMemoryDescriptor& block = blocks[i];
+      if (start >= block.start_of_memory_range &&
+          start + length <=
+              block.start_of_memory_range + block.memory.data_size) {
+        return true;
+      }
+    }
+    for (size_t i = 0; i < count; ++i) {
+      const uintptr_t copy_start = reinterpret_cast<uintptr_t>(copies[i].src);
+      if (start >= copy_start &&
+          start + length <= copy_start + copies[i].length) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // With include_unwind_info_, marks the executable module containing
+  // |address| as one whose unwind information WriteUnwindInfo() writes.
+  void MarkUnwindInfoModule(uintptr_t address) {
+    if (!unwind_info_modules_)
+      return;
+    for (size_t i = 0; i < dumper_->mappings().size(); ++i) {
+      const MappingInfo& mapping = *dumper_->mappings()[i];
+      if (address >= mapping.start_addr &&
+          address - mapping.start_addr < mapping.size) {
+        if (mapping.exec)
+          unwind_info_modules_[i] = true;
+        return;
+      }
+    }
+  }
+
+  // Marks the modules that the words of the |length| bytes of stack at
+  // |stack_copy| point into, which include those of the frames' return
+  // addresses.
+  void MarkUnwindInfoModules(const uint8_t* stack_copy, size_t length) {
+    if (!unwind_info_modules_ || !stack_copy)
+      return;
+    for (size_t offset = 0; offset + sizeof(uintptr_t) <= length;
+         offset += sizeof(uintptr_t)) {
+      uintptr_t word;
+      my_memcpy(&word, stack_copy + offset, sizeof(word));
+      MarkUnwindInfoModule(word);
+    }
+  }
+
+  // Finds the ranges of the module at mapping |index| that the processor
+  // needs to unwind with its .eh_frame: the ELF and program headers, which
+  // locate the PT_GNU_EH_FRAME segment, the .eh_frame_hdr section that
+  // segment holds, and the .eh_frame section that it indexes.  Sets the
+  // sources and lengths of up to three of |copies| and returns how many.
+  size_t FindUnwindInfo(size_t index, LinuxDumper::MemoryCopy* copies) {
+    const wasteful_vector<MappingInfo*>& mappings = dumper_->mappings();
+    const MappingInfo& mapping = *mappings[index];
+    // The ELF header is at the start of the mapping of the file's start.
+    if (mapping.offset != 0)
+      return 0;
+    const uintptr_t start = mapping.start_addr;
+    // Linkers that keep code apart from read-only data put .eh_frame_hdr
+    // and .eh_frame in a segment after the executable one, which is mapped
+    // on its own, so the module runs to the last of its file's mappings.
+    uintptr_t end = mapping.start_addr + mapping.size;
+    for (size_t i = index + 1; i < mappings.size(); ++i) {
+      if (my_strcmp(mappings[i]->name, mapping.name) != 0)
+        break;
+      end = mappings[i]->start_addr + mappings[i]->size;
+    }
+    ElfW(Ehdr) ehdr;
+    if (mapping.size < sizeof(ehdr) ||
+        !dumper_->CopyFromProcess(&ehdr, GetCrashThread(),
+                                  reinterpret_cast<const void*>(start),
+                                  sizeof(ehdr)) ||
+        my_memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0 ||
+        ehdr.e_ident[EI_CLASS] !=
+            (sizeof(uintptr_t) == 8 ? ELFCLASS64 : ELFCLASS32) ||
+        ehdr.e_phentsize != sizeof(ElfW(Phdr)) || ehdr.e_phnum == 0) {
+      return 0;
+    }
+    const size_t headers_length =
+        ehdr.e_phoff + ehdr.e_phnum * sizeof(ElfW(Phdr));
+    if (ehdr.e_phoff < sizeof(ehdr) || headers_length > kMaxElfHeadersLength ||
+        headers_length > mapping.size) {
+      return 0;
+    }
+    wasteful_vector<ElfW(Phdr)> phdrs(dumper_->allocator(), ehdr.e_phnum);
+    phdrs.resize(ehdr.e_phnum);
+    if (!dumper_->CopyFromProcess(
+            &phdrs[0], GetCrashThread(),
+            reinterpret_cast<const void*>(start + ehdr.e_phoff),
+            ehdr.e_phnum * sizeof(ElfW(Phdr)))) {
+      return 0;
+    }
+
+    // The load bias puts the first loadable segment's file offset at the
+    // mapping's start.
+    const ElfW(Phdr)* first_load = NULL;
+    const ElfW(Phdr)* eh_frame_hdr = NULL;
+    for (const ElfW(Phdr)& ph : phdrs) {
+      if (ph.p_type == PT_LOAD && !first_load)
+        first_load = &ph;
+      else if (ph.p_type == PT_GNU_EH_FRAME)
+        eh_frame_hdr = &ph;
+    }
+    if (!first_load || !eh_frame_hdr)
+      return 0;
+    const uintptr_t bias = start - (first_load->p_vaddr - first_load->p_offset);
+    const uintptr_t hdr = bias + eh_frame_hdr->p_vaddr;
+    if (hdr < start || hdr >= end || eh_frame_hdr->p_memsz > end - hdr)
+      return 0;
+
+    // The .eh_frame_hdr's version and encodings, then a pointer to
+    // .eh_frame, which linkers make a 4-byte offset from the pointer.
+    uint8_t hdr_start[8];
+    if (eh_frame_hdr->p_memsz < sizeof(hdr_start) ||
+        !dumper_->CopyFromProcess(hdr_start, GetCrashThread(),
+                                  reinterpret_cast<const void*>(hdr),
+                                  sizeof(hdr_start)) ||
+        hdr_start[0] != 1 || hdr_start[1] != kEhFramePointerEncoding) {
+      return 0;
+    }
+    int32_t eh_frame_offset;
+    my_memcpy(&eh_frame_offset, hdr_start + 4, sizeof(eh_frame_offset));
+    const uintptr_t eh_frame = hdr + 4 + eh_frame_offset;
+
+    // .eh_frame has no size of its own there; it runs to the end of the
+    // loadable segment holding it at most.
+    uintptr_t eh_frame_end = 0;
+    for (const ElfW(Phdr)& ph : phdrs) {
+      const uintptr_t segment = bias + ph.p_vaddr;
+      if (ph.p_type == PT_LOAD && eh_frame >= segment &&
+          eh_frame - segment < ph.p_filesz) {
+        eh_frame_end = segment + ph.p_filesz;
+        break;
+      }
+    }
+    if (!eh_frame_end || eh_frame < start || eh_frame >= end)
+      return 0;
+    eh_frame_end = std::min(eh_frame_end, end);
+    eh_frame_end = std::min(eh_frame_end,
+                            eh_frame + size_t(kMaxEhFrameLength));
+
+    copies[0].src = reinterpret_cast<const void*>(start);
+    copies[0].length = headers_length;
+    copies[1].src = reinterpret_cast<const void*>(hdr);
+    copies[1].length = eh_frame_hdr->p_memsz;
+    copies[2].src = reinterpret_cast<const void*>(eh_frame);
+    copies[2].length = eh_frame_end - eh_frame;
+    return 3;
+  }
+
+  // Write the unwind information of the modules that MarkUnwindInfoModule()
+  // marked.  With a size limit, only what is left of the budget is used.
+  bool WriteUnwindInfo() {
+    if (!unwind_info_modules_)
+      return true;
+    const size_t num_mappings = dumper_->mappings().size();
+    LinuxDumper::MemoryCopy* copies =
+        reinterpret_cast<LinuxDumper::MemoryCopy*>(
+            Alloc(3 * num_mappings * sizeof(LinuxDumper::MemoryCopy)));
+    size_t count = 0;
+    for (size_t i = 0; i < num_mappings; ++i) {
+      if (!unwind_info_modules_[i])
+        continue;
+      const size_t found = FindUnwindInfo(i, copies + count);
+      // A module's ranges are written together or not at all.
+      size_t length = 0;
+      for (size_t j = count; j < count + found; ++j) {
+        length += AlignedSize(copies[j].length) + sizeof(MDMemoryDescriptor);
+      }
+      if (found == 0 ||
+          (minidump_size_limit_ >= 0 && !TakeAllFromBudget(length))) {
+        continue;
+      }
+      // Some of it, such as the headers, may be written already.
+      const size_t found_end = count + found;
+      for (size_t j = count; j < found_end; ++j) {
+        if (MemoryWritten(reinterpret_cast<uintptr_t>(copies[j].src),
+                          copies[j].length, copies, count)) {
+          continue;
+        }
+        copies[count].src = copies[j].src;
+        copies[count].length = copies[j].length;
+        copies[count].dest = Alloc(copies[j].length);
+        timing_.Count(MD_DUMP_PHASE_MEMORY_LIST, 0, copies[j].length);
+        ++count;
+      }
+    }
+    dumper_->CopyRangesFromProcess(GetCrashThread(), copies, count);
+
+    for (size_t copy = 0; copy < count; ++copy) {
+      UntypedMDRVA memory(&minidump_writer_);
+      if (!memory.Allocate(copies[copy].length))
+        return false;
+      memory.Copy(copies[copy].dest, copies[copy].length);
       MDMemoryDescriptor desc;
-      desc.start_of_memory_range = reinterpret_cast<uintptr_t>(iter->ptr);
+      desc.start_of_memory_range =
+          reinterpret_cast<uintptr_t>(copies[copy].src);
       desc.memory = memory.location();
       memory_blocks_.push_back(desc);
     }
-
     return true;
   }
 
+  // Sorts the count blocks at blocks by address and makes them disjoint,
+  // returning how many are left.  The part of a block that is already
+  // covered by one that starts lower, or that starts at the same address
+  // and is longer, is cut from it, so that its descriptor points into the
+  // middle of the data written for it, and a block that is covered
+  // entirely is dropped.  Blocks that are adjacent both in memory and in
+  // the file become one.
+  static size_t CoalesceMemoryBlocks(MDMemoryDescriptor* blocks,
+                                     size_t count) {
+    std::sort(blocks, blocks + count,
+              [](const MDMemoryDescriptor& a, const MDMemoryDescriptor& b) {
+                if (a.start_of_memory_range != b.start_of_memory_range)
+                  return a.start_of_memory_range < b.start_of_memory_range;
+                return a.memory.data_size > b.memory.data_size;
+              });
+    size_t merged = 0;
+    for (size_t i = 0; i < count; ++i) {
+      MDMemoryDescriptor block = blocks[i];
+      if (block.memory.data_size == 0)
+        continue;
+      if (merged > 0) {
+        MDMemoryDescriptor* last = &blocks[merged - 1];
+        const uint64_t last_end =
+            last->start_of_memory_range + last->memory.data_size;
+        if (block.start_of_memory_range + block.memory.data_size <= last_end)
+          continue;
+        if (block.start_of_memory_range < last_end) {
+          const uint32_t covered = static_cast<uint32_t>(
+              last_end - block.start_of_memory_range);
+          block.start_of_memory_range = last_end;
+          block.memory.rva += covered;
+          block.memory.data_size -= covered;
+        }
+        if (block.start_of_memory_range == last_end &&
+            block.memory.rva == last->memory.rva + last->memory.data_size &&
+            last->memory.data_size <=
+                UINT32_MAX - block.memory.data_size) {
+          last->memory.data_size += block.memory.data_size;
+          continue;
+        }
+      }
+      blocks[merged++] = block;
+    }
+    return merged;
+  }
+
   static bool ShouldIncludeMapping(const MappingInfo& mapping) {
     if (mapping.name[0] == 0 ||  // only want modules with filenames.
         // Only want to include one mapping per shared lib.
@@ -586,6 +1265,8 @@ class MinidumpWriter {
       if (ShouldIncludeMapping(mapping) && !HaveMappingInfo(mapping))
         num_output_mappings++;
     }
+    // With a size limit, PlanSizeBudget() has set how many modules fit.
+    num_output_mappings = std::min(num_output_mappings, module_limit_);
 
     TypedMDRVA<uint32_t> list(&minidump_writer_);
     if (num_output_mappings) {
@@ -604,7 +1285,7 @@ class MinidumpWriter {
 
     // First write all the mappings from the dumper
     unsigned int j = 0;
-    for (unsigned i = 0; i < num_mappings; ++i) {
+    for (unsigned i = 0; i < num_mappings && j < num_output_mappings; ++i) {
       const MappingInfo& mapping = *dumper_->mappings()[i];
       if (!ShouldIncludeMapping(mapping) || HaveMappingInfo(mapping))
         continue;
@@ -616,7 +1297,7 @@ class MinidumpWriter {
     }
     // Next write all the mappings provided by the caller
     for (MappingList::const_iterator iter = mapping_list_.begin();
-         iter != mapping_list_.end();
+         iter != mapping_list_.end() && j < num_output_mappings;
          ++iter) {
       MDRawModule mod;
       if (!FillRawModule(iter->first, false, 0, &mod, iter->second))
@@ -647,8 +1328,18 @@ class MinidumpWriter {
                                             sizeof(file_path), file_name,
                                             sizeof(file_name));
 
+    // A module that the module table knows is an ELF file that was already
+    // identified, so its file need not be opened.
+    const ModuleTable::Entry* module = NULL;
+    if (!identifier && member && module_table_)
+      module = module_table_->Find(mapping);
+
     RSDS_DEBUG_FORMAT rsds;
-    PEFileFormat file_format = PEFile::TryGetDebugInfo(file_path, &rsds);
+    timing_.Begin(MD_DUMP_PHASE_BUILD_ID_READ);
+    PEFileFormat file_format = module ? PEFileFormat::notPeCoff :
+        PEFile::TryGetDebugInfo(file_path, &rsds);
+    timing_.End(MD_DUMP_PHASE_BUILD_ID_READ,
+                file_format == PEFileFormat::peWithBuildId ? 1 : 0);
 
     if (file_format == PEFileFormat::notPeCoff) {
       // The module is not a PE/COFF file, process as an ELF.
@@ -659,12 +1350,17 @@ class MinidumpWriter {
         // GUID was provided by caller.
         identifier_bytes.insert(identifier_bytes.end(), identifier,
                                 identifier + sizeof(MDGUID));
+      } else if (module) {
+        identifier_bytes.insert(identifier_bytes.end(), module->identifier,
+                                module->identifier + module->identifier_size);
       } else {
         // Note: ElfFileIdentifierForMapping() can manipulate the
         // |mapping.name|, that is why we need to call the method
         // GetMappingEffectiveNameAndPath again.
+        timing_.Begin(MD_DUMP_PHASE_BUILD_ID_READ);
         dumper_->ElfFileIdentifierForMapping(mapping, member, mapping_id,
                                              identifier_bytes);
+        timing_.End(MD_DUMP_PHASE_BUILD_ID_READ, 1);
         dumper_->GetMappingEffectiveNameAndPath(mapping, file_path,
                                                 sizeof(file_path), file_name,
                                                 sizeof(file_name));
@@ -730,6 +1426,14 @@ class MinidumpWriter {
   }
 
   bool WriteMemoryListStream(MDRawDirectory* dirent) {
+    // Stacks, the memory around the crash address and application regions
+    // may overlap one another.  Listing the memory once, in address order,
+    // saves the processor from resolving the overlaps.
+    if (memory_blocks_.size()) {
+      memory_blocks_.resize(
+          CoalesceMemoryBlocks(&memory_blocks_[0], memory_blocks_.size()));
+    }
+
     TypedMDRVA<uint32_t> list(&minidump_writer_);
     if (memory_blocks_.size()) {
       if (!list.AllocateObjectAndArray(memory_blocks_.size(),
@@ -754,6 +1458,167 @@ class MinidumpWriter {
     return true;
   }
 
+  // Write the memory of a low-pause snapshot that was read while the
+  // process ran. A snapshot writes the stream even when that is none.
+  bool WriteInconsistentMemoryStream(MDRawDirectory* dirent) {
+    if (!low_pause_)
+      return false;
+
+    TypedMDRVA<uint32_t> list(&minidump_writer_);
+    if (inconsistent_blocks_.size()) {
+      if (!list.AllocateObjectAndArray(inconsistent_blocks_.size(),
+                                       sizeof(MDMemoryDescriptor)))
+        return false;
+    } else {
+      if (!list.Allocate())
+        return false;
+    }
+
+    dirent->stream_type = MD_LINUX_INCONSISTENT_MEMORY;
+    dirent->location = list.location();
+
+    *list.get() = inconsistent_blocks_.size();
+
+    for (size_t i = 0; i < inconsistent_blocks_.size(); ++i) {
+      list.CopyIndexAfterObject(i, &inconsistent_blocks_[i],
+                                sizeof(MDMemoryDescriptor));
+    }
+    return true;
+  }
+
+  // Write where this minidump stands in its snapshot series, if it is one
+  // of a series, and for a delta, the memory regions it captured.
+  bool WriteSnapshotSeriesStream(MDRawDirectory* dirent) {
+    if (!series_)
+      return false;
+
+    TypedMDRVA<MDRawSnapshotSeries> series(&minidump_writer_);
+    if (series_regions_.size()) {
+      if (!series.AllocateObjectAndArray(series_regions_.size(),
+                                         sizeof(MDMemoryDescriptor)))
+        return false;
+    } else {
+      if (!series.Allocate())
+        return false;
+    }
+
+    dirent->stream_type = MD_SNAPSHOT_SERIES_STREAM;
+    dirent->location = series.location();
+
+    series.get()->series_id = series_->series_id();
+    series.get()->sequence = series_->snapshot_count();
+    series.get()->region_count = series_regions_.size();
+    for (size_t i = 0; i < series_regions_.size(); ++i) {
+      series.CopyIndexAfterObject(i, &series_regions_[i],
+                                  sizeof(MDMemoryDescriptor));
+    }
+    return true;
+  }
+
+  // Write the signature that the crashing process computed, if it did.
+  bool WriteCrashSignatureStream(MDRawDirectory* dirent) {
+    if (!crash_signature_frames_)
+      return false;
+
+    TypedMDRVA<MDRawCrashSignature> signature(&minidump_writer_);
+    if (!signature.Allocate())
+      return false;
+    signature.get()->signature = crash_signature_;
+    signature.get()->frame_count = crash_signature_frames_;
+    signature.get()->reserved = 0;
+
+    dirent->stream_type = MD_CRASH_SIGNATURE_STREAM;
+    dirent->location = signature.location();
+    return true;
+  }
+
+  // Write the keys of the crashing process's CrashKeyStore, if it has one,
+  // as the simple annotations of a Crashpad info stream.  The store is
+  // copied out of the process and read as a snapshot, which holds a whole
+  // value for each key even if the process stopped in the middle of
+  // setting it.
+  bool WriteCrashpadInfoStream(MDRawDirectory* dirent) {
+    if (!crash_key_store_)
+      return false;
+
+    CrashKeyStore* store =
+        reinterpret_cast<CrashKeyStore*>(Alloc(sizeof(CrashKeyStore)));
+    if (!dumper_->CopyFromProcess(
+            store, GetCrashThread(),
+            reinterpret_cast<const void*>(crash_key_store_),
+            sizeof(CrashKeyStore)) ||
+        !store->IsValid()) {
+      return false;
+    }
+    CrashKeyStore::Entry* entries = reinterpret_cast<CrashKeyStore::Entry*>(
+        Alloc(CrashKeyStore::kMaxKeys * sizeof(CrashKeyStore::Entry)));
+    const size_t count = store->Snapshot(entries);
+
+    TypedMDRVA<MDRawCrashpadInfo> info(&minidump_writer_);
+    if (!info.Allocate())
+      return false;
+    my_memset(info.get(), 0, sizeof(MDRawCrashpadInfo));
+    // The version of Crashpad's MinidumpCrashpadInfo.
+    info.get()->version = 1;
+
+    TypedMDRVA<uint32_t> dictionary(&minidump_writer_);
+    if (count) {
+      if (!dictionary.AllocateObjectAndArray(
+              count, sizeof(MDRawSimpleStringDictionaryEntry)))
+        return false;
+    } else {
+      if (!dictionary.Allocate())
+        return false;
+    }
+    *dictionary.get() = count;
+    for (size_t i = 0; i < count; ++i) {
+      MDRawSimpleStringDictionaryEntry entry;
+      if (!WriteUTF8String(entries[i].key, &entry.key) ||
+          !WriteUTF8String(entries[i].value, &entry.value))
+        return false;
+      dictionary.CopyIndexAfterObject(i, &entry, sizeof(entry));
+    }
+    info.get()->simple_annotations = dictionary.location();
+
+    dirent->stream_type = MD_CRASHPAD_INFO_STREAM;
+    dirent->location = info.location();
+    return true;
+  }
+
+  // Write how long each phase of the dump took, as the last of the
+  // |streams| streams.  Writing this stream is not part of any phase.
+  bool WriteDumpTimingStream(MDRawDirectory* dirent, unsigned streams) {
+    timing_.End(MD_DUMP_PHASE_TOTAL, streams);
+    MDRawDumpPhaseTiming phases[MD_DUMP_PHASE_COUNT];
+    const size_t count = timing_.GetEntries(phases);
+
+    TypedMDRVA<MDRawDumpTimingList> list(&minidump_writer_);
+    if (!list.AllocateObjectAndArray(count, sizeof(MDRawDumpPhaseTiming)))
+      return false;
+    list.get()->size_of_header = sizeof(MDRawDumpTimingList);
+    list.get()->size_of_entry = sizeof(MDRawDumpPhaseTiming);
+    list.get()->number_of_entries = count;
+    for (size_t i = 0; i < count; ++i)
+      list.CopyIndexAfterObject(i, &phases[i], sizeof(phases[i]));
+
+    dirent->stream_type = MD_DUMP_TIMING_STREAM;
+    dirent->location = list.location();
+    return true;
+  }
+
+  // Write |str| as a Crashpad UTF-8 string: its length, then its bytes
+  // and a NUL.
+  bool WriteUTF8String(const char* str, MDRVA* rva) {
+    const uint32_t length = my_strlen(str);
+    UntypedMDRVA string(&minidump_writer_);
+    if (!string.Allocate(sizeof(length) + length + 1) ||
+        !string.Copy(string.position(), &length, sizeof(length)) ||
+        !string.Copy(string.position() + sizeof(length), str, length + 1))
+      return false;
+    *rva = string.position();
+    return true;
+  }
+
   bool WriteExceptionStream(MDRawDirectory* dirent) {
     TypedMDRVA<MDRawExceptionStream> exc(&minidump_writer_);
     if (!exc.Allocate())
@@ -805,13 +1670,16 @@ class MinidumpWriter {
     // Assume the program base is at the beginning of the same page as the PHDR
     base = reinterpret_cast<char*>(reinterpret_cast<uintptr_t>(phdr) & ~0xfff);
 
-    // Search for the program PT_DYNAMIC segment
+    // Search for the program PT_DYNAMIC segment, reading all the program
+    // headers at once.
+    wasteful_vector<ElfW(Phdr)> phdrs(dumper_->allocator(), phnum);
+    phdrs.resize(phnum);
+    if (!dumper_->CopyFromProcess(&phdrs[0], GetCrashThread(), phdr,
+                                  phnum * sizeof(ElfW(Phdr)))) {
+      return false;
+    }
     ElfW(Addr) dyn_addr = 0;
-    for (; phnum >= 0; phnum--, phdr++) {
-      ElfW(Phdr) ph;
-      if (!dumper_->CopyFromProcess(&ph, GetCrashThread(), phdr, sizeof(ph)))
-        return false;
-
+    for (const ElfW(Phdr)& ph : phdrs) {
       // Adjust base address with the virtual address of the PT_LOAD segment
       // corresponding to offset 0
       if (ph.p_type == PT_LOAD && ph.p_offset == 0) {
@@ -830,15 +1698,27 @@ class MinidumpWriter {
     // DSOs loaded into the program. If this information is indeed available,
     // dump it to a MD_LINUX_DSO_DEBUG stream.
     struct r_debug* r_debug = NULL;
-    uint32_t dynamic_length = 0;
 
-    for (int i = 0; ; ++i) {
-      ElfW(Dyn) dyn;
-      dynamic_length += sizeof(dyn);
-      if (!dumper_->CopyFromProcess(&dyn, GetCrashThread(), dynamic + i,
-                                    sizeof(dyn))) {
-        return false;
+    // Read the dynamic section several entries at a time, keeping them for
+    // the copy of the section written below. A read that runs past the end
+    // of what the dumper can see is retried one entry at a time.
+    static const size_t kDynamicEntriesPerRead = 16;
+    wasteful_vector<ElfW(Dyn)> dyns(dumper_->allocator(),
+                                    kDynamicEntriesPerRead);
+    for (size_t i = 0; ; ++i) {
+      if (i == dyns.size()) {
+        dyns.resize(i + kDynamicEntriesPerRead);
+        if (!dumper_->CopyFromProcess(&dyns[i], GetCrashThread(), dynamic + i,
+                                      kDynamicEntriesPerRead *
+                                          sizeof(ElfW(Dyn)))) {
+          dyns.resize(i + 1);
+          if (!dumper_->CopyFromProcess(&dyns[i], GetCrashThread(),
+                                        dynamic + i, sizeof(ElfW(Dyn)))) {
+            return false;
+          }
+        }
       }
+      const ElfW(Dyn)& dyn = dyns[i];
 
 #ifdef __mips__
       const int32_t debug_tag = DT_MIPS_RLD_MAP;
@@ -849,9 +1729,11 @@ class MinidumpWriter {
         r_debug = reinterpret_cast<struct r_debug*>(dyn.d_un.d_ptr);
         continue;
       } else if (dyn.d_tag == DT_NULL) {
+        dyns.resize(i + 1);
         break;
       }
     }
+    const uint32_t dynamic_length = dyns.size() * sizeof(ElfW(Dyn));
 
     // The "r_map" field of that r_debug struct contains a linked list of all
     // loaded DSOs.
@@ -861,21 +1743,27 @@ class MinidumpWriter {
     // See <link.h> for a more detailed discussion of the how the dynamic
     // loader communicates with debuggers.
 
-    // Count the number of loaded DSOs
-    int dso_count = 0;
+    // Walk the list once, keeping each entry. Each read depends on the one
+    // before, so they can't be batched, but the names can.
     struct r_debug debug_entry;
     if (!dumper_->CopyFromProcess(&debug_entry, GetCrashThread(), r_debug,
                                   sizeof(debug_entry))) {
       return false;
     }
+    wasteful_vector<struct link_map> maps(dumper_->allocator());
     for (struct link_map* ptr = debug_entry.r_map; ptr; ) {
-      struct link_map map;
-      if (!dumper_->CopyFromProcess(&map, GetCrashThread(), ptr, sizeof(map)))
+      // A list this long is cyclic; the process's memory is corrupt.
+      static const size_t kMaxDSOs = 1 << 16;
+      if (maps.size() == kMaxDSOs)
         return false;
-
-      ptr = map.l_next;
-      dso_count++;
+      maps.resize(maps.size() + 1);
+      if (!dumper_->CopyFromProcess(&maps.back(), GetCrashThread(), ptr,
+                                    sizeof(struct link_map))) {
+        return false;
+      }
+      ptr = maps.back().l_next;
     }
+    const int dso_count = maps.size();
 
     MDRVA linkmap_rva = minidump_writer_.kInvalidMDRVA;
     if (dso_count > 0) {
@@ -885,28 +1773,38 @@ class MinidumpWriter {
       if (!linkmap.AllocateArray(dso_count))
         return false;
       linkmap_rva = linkmap.location().rva;
-      int idx = 0;
 
-      // Iterate over DSOs and write their information to mini dump
-      for (struct link_map* ptr = debug_entry.r_map; ptr; ) {
-        struct link_map map;
-        if (!dumper_->CopyFromProcess(&map, GetCrashThread(), ptr, sizeof(map)))
-          return  false;
-
-        ptr = map.l_next;
-        char filename[257] = { 0 };
-        if (map.l_name) {
-          dumper_->CopyFromProcess(filename, GetCrashThread(), map.l_name,
-                                   sizeof(filename) - 1);
+      // Read all the DSO names together. Each is at most kNameSize - 1
+      // bytes, and stays NUL-terminated.
+      static const size_t kNameSize = 257;
+      wasteful_vector<char> names(dumper_->allocator(), dso_count * kNameSize);
+      names.resize(dso_count * kNameSize);
+      wasteful_vector<LinuxDumper::MemoryCopy> copies(dumper_->allocator(),
+                                                      dso_count);
+      for (int idx = 0; idx < dso_count; ++idx) {
+        if (maps[idx].l_name) {
+          LinuxDumper::MemoryCopy copy = {
+            &names[idx * kNameSize], maps[idx].l_name, kNameSize - 1
+          };
+          copies.push_back(copy);
         }
+      }
+      if (!copies.empty()) {
+        dumper_->CopyRangesFromProcess(GetCrashThread(), &copies[0],
+                                       copies.size());
+      }
+
+      // Iterate over DSOs and write their information to mini dump
+      for (int idx = 0; idx < dso_count; ++idx) {
         MDLocationDescriptor location;
-        if (!minidump_writer_.WriteString(filename, 0, &location))
+        if (!minidump_writer_.WriteString(&names[idx * kNameSize], 0,
+                                          &location))
           return false;
         MDRawLinkMap entry;
         entry.name = location.rva;
-        entry.addr = map.l_addr;
-        entry.ld = reinterpret_cast<uintptr_t>(map.l_ld);
-        linkmap.CopyIndex(idx++, &entry);
+        entry.addr = maps[idx].l_addr;
+        entry.ld = reinterpret_cast<uintptr_t>(maps[idx].l_ld);
+        linkmap.CopyIndex(idx, &entry);
       }
     }
 
@@ -925,19 +1823,35 @@ class MinidumpWriter {
     debug.get()->ldbase = debug_entry.r_ldbase;
     debug.get()->dynamic = reinterpret_cast<uintptr_t>(dynamic);
 
-    wasteful_vector<char> dso_debug_data(dumper_->allocator(), dynamic_length);
-    // The passed-in size to the constructor (above) is only a hint.
-    // Must call .resize() to do actual initialization of the elements.
-    dso_debug_data.resize(dynamic_length);
-    dumper_->CopyFromProcess(&dso_debug_data[0], GetCrashThread(), dynamic,
-                             dynamic_length);
-    debug.CopyIndexAfterObject(0, &dso_debug_data[0], dynamic_length);
+    debug.CopyIndexAfterObject(0, &dyns[0], dynamic_length);
 
     return true;
   }
 
   void set_minidump_size_limit(off_t limit) { minidump_size_limit_ = limit; }
 
+  // Must be called before Init().
+  void set_compressed(bool compressed) {
+    minidump_writer_.set_compressed(compressed);
+  }
+
+  void set_module_table(const ModuleTable* module_table) {
+    module_table_ = module_table;
+  }
+
+  // Must be called before Init().
+  void set_low_pause(bool low_pause) { low_pause_ = low_pause; }
+
+  void set_include_unwind_info(bool include_unwind_info) {
+    include_unwind_info_ = include_unwind_info;
+  }
+
+  // Makes the minidump the next snapshot of |series|.
+  void set_snapshot_series(google_breakpad::MinidumpSnapshotSeries* series) {
+    series_ = series;
+    series_delta_ = series && series->snapshot_count() > 0;
+  }
+
  private:
   void* Alloc(unsigned bytes) {
     return dumper_->allocator()->Alloc(bytes);
@@ -1316,7 +2230,11 @@ class MinidumpWriter {
 #  error "Unsupported CPU"
 #endif
 
-  bool WriteFile(MDLocationDescriptor* result, const char* filename) {
+  // Copies at most |max_length| bytes of |filename| into the minidump.
+  bool WriteFile(MDLocationDescriptor* result, const char* filename,
+                 size_t max_length) {
+    if (!max_length)
+      return false;
     const int fd = sys_open(filename, O_RDONLY, 0);
     if (fd < 0)
       return false;
@@ -1334,10 +2252,12 @@ class MinidumpWriter {
     buffers->len = 0;
 
     size_t total = 0;
-    for (Buffers* bufptr = buffers;;) {
+    for (Buffers* bufptr = buffers; total < max_length;) {
+      const size_t wanted =
+          std::min(kBufSize - bufptr->len, max_length - total);
       ssize_t r;
       do {
-        r = sys_read(fd, &bufptr->data[bufptr->len], kBufSize - bufptr->len);
+        r = sys_read(fd, &bufptr->data[bufptr->len], wanted);
       } while (r == -1 && errno == EINTR);
 
       if (r < 1)
@@ -1427,12 +2347,38 @@ class MinidumpWriter {
     return true;
   }
 
-  bool WriteProcFile(MDLocationDescriptor* result, pid_t pid,
-                     const char* filename) {
-    char buf[NAME_MAX];
-    if (!dumper_->BuildProcPath(buf, pid, filename))
+  // Returns the number of bytes that can be read from |filename|.
+  size_t MeasureFile(const char* filename) {
+    const int fd = sys_open(filename, O_RDONLY, 0);
+    if (fd < 0)
+      return 0;
+
+    char buf[1024];
+    size_t total = 0;
+    for (;;) {
+      ssize_t r;
+      do {
+        r = sys_read(fd, buf, sizeof(buf));
+      } while (r == -1 && errno == EINTR);
+
+      if (r < 1)
+        break;
+      total += r;
+    }
+    sys_close(fd);
+    return total;
+  }
+
+  // Sets |path| to the path of file stream |index|.  |path| must hold
+  // NAME_MAX bytes.
+  bool GetFileStreamPath(size_t index, char* path) {
+    const FileStream& stream = kFileStreams[index];
+    if (stream.proc)
+      return dumper_->BuildProcPath(path, GetCrashThread(), stream.name);
+    if (my_strlen(stream.name) >= NAME_MAX)
       return false;
-    return WriteFile(result, buf);
+    my_strlcpy(path, stream.name, NAME_MAX);
+    return true;
   }
 
   // Only one of the 2 member variables below should be set to a valid value.
@@ -1447,10 +2393,18 @@ class MinidumpWriter {
   MinidumpFileWriter minidump_writer_;
   off_t minidump_size_limit_;
   MDLocationDescriptor crashing_thread_context_;
+  // How long each phase of the dump takes, for the timing stream.
+  DumpTiming timing_;
   // Blocks of memory written to the dump. These are all currently
   // written while writing the thread list stream, but saved here
   // so a memory list stream can be written afterwards.
   wasteful_vector<MDMemoryDescriptor> memory_blocks_;
+  // Those of |memory_blocks_| that a low-pause snapshot read after the
+  // process was let run.
+  wasteful_vector<MDMemoryDescriptor> inconsistent_blocks_;
+  // The whole of the memory regions that a delta snapshot captured, of
+  // which |memory_blocks_| holds only the changed parts.
+  wasteful_vector<MDMemoryDescriptor> series_regions_;
   // Additional information about some mappings provided by the caller.
   const MappingList& mapping_list_;
   // Additional memory regions to be included in the dump,
@@ -1463,6 +2417,43 @@ class MinidumpWriter {
   const MappingInfo* principal_mapping_;
   // If true, apply stack sanitization to stored stack data.
   bool sanitize_stacks_;
+  // What PlanSizeBudget() has yet to share out.
+  size_t budget_left_;
+  // How much of each thread's stack may be written, indexed like
+  // dumper_->threads(), or NULL to write them whole.
+  int* stack_length_limits_;
+  // Which application-provided memory regions to write, or NULL to write
+  // them all.
+  bool* app_memory_included_;
+  // The most modules to write.
+  unsigned module_limit_;
+  // The most bytes to copy from each of kFileStreams.
+  size_t file_length_limits_[kNumFileStreams];
+  // Identifiers of the process's modules found before the crash, or NULL.
+  const ModuleTable* module_table_;
+  // The address of the crashing process's CrashKeyStore, or 0.
+  uintptr_t crash_key_store_;
+  // The crash signature that the crashing process computed, and the number
+  // of frames it covers, which is 0 if there is none.
+  uint64_t crash_signature_;
+  uint32_t crash_signature_frames_;
+  // If true, Init() takes a snapshot with TakeSnapshot() and lets the
+  // process run while the rest is written.
+  bool low_pause_;
+  // If true, Dump() writes the unwind information of the modules that
+  // threads are running in or the crashing thread's stack points into.
+  bool include_unwind_info_;
+  // Which modules WriteUnwindInfo() writes the unwind information of,
+  // indexed like dumper_->mappings(), or NULL.
+  bool* unwind_info_modules_;
+  // What TakeSnapshot() read, indexed like dumper_->threads(), or NULL.
+  ThreadInfo* snapshot_infos_;
+  bool* snapshot_info_valid_;
+  LinuxDumper::MemoryCopy* snapshot_stacks_;
+  // The snapshot series this minidump is part of, or NULL, and whether it
+  // is a delta rather than the first snapshot.
+  google_breakpad::MinidumpSnapshotSeries* series_;
+  bool series_delta_;
 };
 
 
@@ -1475,8 +2466,13 @@ bool WriteMinidumpImpl(const char* minidump_path,
                        const AppMemoryList& appmem,
                        bool skip_stacks_if_mapping_unreferenced,
                        uintptr_t principal_mapping_address,
-                       bool sanitize_stacks) {
+                       bool sanitize_stacks,
+                       bool compressed,
+                       const ModuleTable* module_table,
+                       bool include_unwind_info,
+                       int num_helper_threads) {
   LinuxPtraceDumper dumper(crashing_process);
+  dumper.set_num_helper_threads(num_helper_threads);
   const ExceptionHandler::CrashContext* context = NULL;
   if (blob) {
     if (blob_size != sizeof(ExceptionHandler::CrashContext))
@@ -1490,6 +2486,9 @@ bool WriteMinidumpImpl(const char* minidump_path,
                         principal_mapping_address, sanitize_stacks, &dumper);
   // Set desired limit for file size of minidump (-1 means no limit).
   writer.set_minidump_size_limit(minidump_size_limit);
+  writer.set_compressed(compressed);
+  writer.set_module_table(module_table);
+  writer.set_include_unwind_info(include_unwind_info);
   if (!writer.Init())
     return false;
   return writer.Dump();
@@ -1509,7 +2508,7 @@ bool WriteMinidump(const char* minidump_path, pid_t crashing_process,
                            MappingList(), AppMemoryList(),
                            skip_stacks_if_mapping_unreferenced,
                            principal_mapping_address,
-                           sanitize_stacks);
+                           sanitize_stacks, false, NULL, false, 1);
 }
 
 bool WriteMinidump(int minidump_fd, pid_t crashing_process,
@@ -1522,7 +2521,27 @@ bool WriteMinidump(int minidump_fd, pid_t crashing_process,
                            MappingList(), AppMemoryList(),
                            skip_stacks_if_mapping_unreferenced,
                            principal_mapping_address,
-                           sanitize_stacks);
+                           sanitize_stacks, false, NULL, false, 1);
+}
+
+bool WriteMinidump(const char* minidump_path, pid_t crashing_process,
+                   const void* blob, size_t blob_size,
+                   int num_helper_threads) {
+  return WriteMinidumpImpl(minidump_path, -1, -1,
+                           crashing_process, blob, blob_size,
+                           MappingList(), AppMemoryList(),
+                           false, 0, false, false, NULL, false,
+                           num_helper_threads);
+}
+
+bool WriteMinidump(int minidump_fd, pid_t crashing_process,
+                   const void* blob, size_t blob_size,
+                   int num_helper_threads) {
+  return WriteMinidumpImpl(NULL, minidump_fd, -1,
+                           crashing_process, blob, blob_size,
+                           MappingList(), AppMemoryList(),
+                           false, 0, false, false, NULL, false,
+                           num_helper_threads);
 }
 
 bool WriteMinidump(const char* minidump_path, pid_t process,
@@ -1540,6 +2559,23 @@ bool WriteMinidump(const char* minidump_path, pid_t process,
   return writer.Dump();
 }
 
+bool WriteMinidump(const char* minidump_path, pid_t process,
+                   pid_t process_blamed_thread,
+                   const AppMemoryList& appdata,
+                   bool low_pause) {
+  LinuxPtraceDumper dumper(process);
+  // MinidumpWriter will set crash address
+  dumper.set_crash_signal(MD_EXCEPTION_CODE_LIN_DUMP_REQUESTED);
+  dumper.set_crash_thread(process_blamed_thread);
+  MappingList mapping_list;
+  MinidumpWriter writer(minidump_path, -1, NULL, mapping_list,
+                        appdata, false, 0, false, &dumper);
+  writer.set_low_pause(low_pause);
+  if (!writer.Init())
+    return false;
+  return writer.Dump();
+}
+
 bool WriteMinidump(const char* minidump_path, pid_t crashing_process,
                    const void* blob, size_t blob_size,
                    const MappingList& mappings,
@@ -1552,7 +2588,7 @@ bool WriteMinidump(const char* minidump_path, pid_t crashing_process,
                            mappings, appmem,
                            skip_stacks_if_mapping_unreferenced,
                            principal_mapping_address,
-                           sanitize_stacks);
+                           sanitize_stacks, false, NULL, false, 1);
 }
 
 bool WriteMinidump(int minidump_fd, pid_t crashing_process,
@@ -1567,7 +2603,7 @@ bool WriteMinidump(int minidump_fd, pid_t crashing_process,
                            mappings, appmem,
                            skip_stacks_if_mapping_unreferenced,
                            principal_mapping_address,
-                           sanitize_stacks);
+                           sanitize_stacks, false, NULL, false, 1);
 }
 
 bool WriteMinidump(const char* minidump_path, off_t minidump_size_limit,
@@ -1577,13 +2613,17 @@ bool WriteMinidump(const char* minidump_path, off_t minidump_size_limit,
                    const AppMemoryList& appmem,
                    bool skip_stacks_if_mapping_unreferenced,
                    uintptr_t principal_mapping_address,
-                   bool sanitize_stacks) {
+                   bool sanitize_stacks,
+                   bool compressed,
+                   const ModuleTable* module_table,
+                   bool include_unwind_info) {
   return WriteMinidumpImpl(minidump_path, -1, minidump_size_limit,
                            crashing_process, blob, blob_size,
                            mappings, appmem,
                            skip_stacks_if_mapping_unreferenced,
                            principal_mapping_address,
-                           sanitize_stacks);
+                           sanitize_stacks, compressed, module_table,
+                           include_unwind_info, 1);
 }
 
 bool WriteMinidump(int minidump_fd, off_t minidump_size_limit,
@@ -1593,13 +2633,17 @@ bool WriteMinidump(int minidump_fd, off_t minidump_size_limit,
                    const AppMemoryList& appmem,
                    bool skip_stacks_if_mapping_unreferenced,
                    uintptr_t principal_mapping_address,
-                   bool sanitize_stacks) {
+                   bool sanitize_stacks,
+                   bool compressed,
+                   const ModuleTable* module_table,
+                   bool include_unwind_info) {
   return WriteMinidumpImpl(NULL, minidump_fd, minidump_size_limit,
                            crashing_process, blob, blob_size,
                            mappings, appmem,
                            skip_stacks_if_mapping_unreferenced,
                            principal_mapping_address,
-                           sanitize_stacks);
+                           sanitize_stacks, compressed, module_table,
+                           include_unwind_info, 1);
 }
 
 bool WriteMinidump(const char* filename,
@@ -1613,4 +2657,62 @@ bool WriteMinidump(const char* filename,
   return writer.Dump();
 }
 
+MinidumpSnapshotSeries::MinidumpSnapshotSeries()
+    : snapshot_count_(0),
+      page_size_(getpagesize()) {
+  if (!CreateGUID(&series_id_))
+    my_memset(&series_id_, 0, sizeof(series_id_));
+}
+
+bool MinidumpSnapshotSeries::WriteSnapshot(const char* minidump_path,
+                                           pid_t process,
+                                           pid_t process_blamed_thread,
+                                           const AppMemoryList& appdata) {
+  LinuxPtraceDumper dumper(process);
+  // MinidumpWriter will set crash address
+  dumper.set_crash_signal(MD_EXCEPTION_CODE_LIN_DUMP_REQUESTED);
+  dumper.set_crash_thread(process_blamed_thread);
+  MappingList mapping_list;
+  MinidumpWriter writer(minidump_path, -1, NULL, mapping_list,
+                        appdata, false, 0, false, &dumper);
+  writer.set_snapshot_series(this);
+  if (snapshot_count_ == 0)
+    base_pieces_.clear();
+  if (!writer.Init() || !writer.Dump())
+    return false;
+  if (snapshot_count_ == 0)
+    std::sort(base_pieces_.begin(), base_pieces_.end());
+  ++snapshot_count_;
+  return true;
+}
+
+namespace {
+
+// FNV-1a over the |length| bytes at |data|.
+uint64_t HashPiece(const uint8_t* data, size_t length) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= data[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+}  // namespace
+
+void MinidumpSnapshotSeries::AddBasePiece(uintptr_t address,
+                                          const uint8_t* data,
+                                          size_t length) {
+  Piece piece = { address, length, HashPiece(data, length) };
+  base_pieces_.push_back(piece);
+}
+
+bool MinidumpSnapshotSeries::PieceChanged(uintptr_t address,
+                                          const uint8_t* data,
+                                          size_t length) const {
+  Piece piece = { address, length, HashPiece(data, length) };
+  return !std::binary_search(base_pieces_.begin(), base_pieces_.end(),
+                             piece);
+}
+
 }  // namespace google_breakpad
@@ -37,7 +37,9 @@
 #include <list>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "client/linux/dump_writer_common/module_table.h"
 #include "client/linux/minidump_writer/linux_dumper.h"
 #include "google_breakpad/common/minidump_format.h"
 
@@ -82,13 +84,27 @@ bool WriteMinidump(const char* minidump_path, pid_t crashing_process,
                    bool skip_stacks_if_mapping_unreferenced = false,
                    uintptr_t principal_mapping_address = 0,
                    bool sanitize_stacks = false);
-// Same as above but takes an open file descriptor instead of a path.
+// Same as above but takes an open file descriptor instead of a path.  The
+// descriptor may be a pipe or a socket, in which case the minidump is laid
+// out in memory, or in a spill file past MinidumpFileWriter's sequential
+// limit, and written to it in order.
 bool WriteMinidump(int minidump_fd, pid_t crashing_process,
                    const void* blob, size_t blob_size,
                    bool skip_stacks_if_mapping_unreferenced = false,
                    uintptr_t principal_mapping_address = 0,
                    bool sanitize_stacks = false);
 
+// Same as the first form above, for a crash server or another process that
+// is not compromised. The crashing process's threads are suspended and
+// their registers read on |num_helper_threads| threads of the calling
+// process, which takes pthreads and the heap.
+bool WriteMinidump(const char* minidump_path, pid_t crashing_process,
+                   const void* blob, size_t blob_size,
+                   int num_helper_threads);
+bool WriteMinidump(int minidump_fd, pid_t crashing_process,
+                   const void* blob, size_t blob_size,
+                   int num_helper_threads);
+
 // Alternate form of WriteMinidump() that works with processes that
 // are not expected to have crashed.  If |process_blamed_thread| is
 // meaningful, it will be the one from which a crash signature is
@@ -97,6 +113,16 @@ bool WriteMinidump(int minidump_fd, pid_t crashing_process,
 bool WriteMinidump(const char* minidump_path, pid_t process,
                    pid_t process_blamed_thread);
 
+// Same as above, also writing the |appdata| regions of |process|. With
+// |low_pause|, the process is stopped only while the registers of its
+// threads and the tops of their stacks are read. The rest is read while it
+// runs, and the memory regions that may not match the registers or each
+// other are listed in an MD_LINUX_INCONSISTENT_MEMORY stream.
+bool WriteMinidump(const char* minidump_path, pid_t process,
+                   pid_t process_blamed_thread,
+                   const AppMemoryList& appdata,
+                   bool low_pause);
+
 // These overloads also allow passing a list of known mappings and
 // a list of additional memory regions to be included in the minidump.
 bool WriteMinidump(const char* minidump_path, pid_t crashing_process,
@@ -114,7 +140,14 @@ bool WriteMinidump(int minidump_fd, pid_t crashing_process,
                    uintptr_t principal_mapping_address = 0,
                    bool sanitize_stacks = false);
 
-// These overloads also allow passing a file size limit for the minidump.
+// These overloads also allow passing a file size limit for the minidump,
+// writing it compressed, in the layout common/compressed_minidump.h
+// describes, and a table of module identifiers found before the crash.
+// The size limit applies to the uncompressed minidump.  With
+// |include_unwind_info|, the .eh_frame_hdr and .eh_frame sections of the
+// modules that threads are running in, or that the crashing thread's stack
+// points into, are written too, so that the processor can unwind through
+// modules it has no symbols for.
 bool WriteMinidump(const char* minidump_path, off_t minidump_size_limit,
                    pid_t crashing_process,
                    const void* blob, size_t blob_size,
@@ -122,7 +155,10 @@ bool WriteMinidump(const char* minidump_path, off_t minidump_size_limit,
                    const AppMemoryList& appdata,
                    bool skip_stacks_if_mapping_unreferenced = false,
                    uintptr_t principal_mapping_address = 0,
-                   bool sanitize_stacks = false);
+                   bool sanitize_stacks = false,
+                   bool compressed = false,
+                   const ModuleTable* module_table = NULL,
+                   bool include_unwind_info = false);
 bool WriteMinidump(int minidump_fd, off_t minidump_size_limit,
                    pid_t crashing_process,
                    const void* blob, size_t blob_size,
@@ -130,13 +166,80 @@ bool WriteMinidump(int minidump_fd, off_t minidump_size_limit,
                    const AppMemoryList& appdata,
                    bool skip_stacks_if_mapping_unreferenced = false,
                    uintptr_t principal_mapping_address = 0,
-                   bool sanitize_stacks = false);
+                   bool sanitize_stacks = false,
+                   bool compressed = false,
+                   const ModuleTable* module_table = NULL,
+                   bool include_unwind_info = false);
 
 bool WriteMinidump(const char* filename,
                    const MappingList& mappings,
                    const AppMemoryList& appdata,
                    LinuxDumper* dumper);
 
+// Writes a series of minidumps of a process that is not expected to have
+// crashed, such as the snapshots a hang detector takes of a stuck process
+// every few seconds.  The first snapshot is a complete minidump.  Each
+// later one, a delta, holds only the threads' registers and the pages of
+// their stacks and of |appdata| whose contents differ from the first
+// snapshot's, which it refers to; see MD_SNAPSHOT_SERIES_STREAM.  The
+// processor's ReconstructSnapshot (processor/snapshot_series.h) puts a
+// delta and the first snapshot back together into a complete minidump.
+// The pages are told apart by a hash of their contents kept from the first
+// snapshot, on the heap, so this must not be used from a compromised
+// process.
+class MinidumpSnapshotSeries {
+ public:
+  MinidumpSnapshotSeries();
+
+  // Writes the next snapshot of |process| to |minidump_path|, as
+  // WriteMinidump(minidump_path, process, process_blamed_thread, appdata,
+  // false) would.  Returns true iff successful; a failed snapshot is not
+  // counted, so if the first fails, the next is complete again.
+  bool WriteSnapshot(const char* minidump_path, pid_t process,
+                     pid_t process_blamed_thread,
+                     const AppMemoryList& appdata);
+
+  const MDGUID& series_id() const { return series_id_; }
+
+  // The number of snapshots written so far, which is also the sequence
+  // number of the next.
+  uint32_t snapshot_count() const { return snapshot_count_; }
+
+  // For the minidump writer: the size of the pages whose contents are
+  // compared.
+  size_t page_size() const { return page_size_; }
+
+  // For the minidump writer: records the |length| bytes at |data|, copied
+  // from |address|, which are all in one page, as written in the first
+  // snapshot, or returns whether a later snapshot's bytes there differ from
+  // those recorded.
+  void AddBasePiece(uintptr_t address, const uint8_t* data, size_t length);
+  bool PieceChanged(uintptr_t address, const uint8_t* data,
+                    size_t length) const;
+
+ private:
+  // The hash of a part of a page that the first snapshot wrote.
+  struct Piece {
+    uint64_t address;
+    uint64_t length;
+    uint64_t hash;
+
+    bool operator<(const Piece& other) const {
+      if (address != other.address)
+        return address < other.address;
+      if (length != other.length)
+        return length < other.length;
+      return hash < other.hash;
+    }
+  };
+
+  MDGUID series_id_;
+  uint32_t snapshot_count_;
+  size_t page_size_;
+  // What the first snapshot wrote, sorted once it is written.
+  std::vector<Piece> base_pieces_;
+};
+
 }  // namespace google_breakpad
 
 #endif  // CLIENT_LINUX_MINIDUMP_WRITER_MINIDUMP_WRITER_H_
@@ -31,6 +31,7 @@
 #endif
 
 #include <fcntl.h>
+#include <link.h>
 #include <poll.h>
 #include <sys/stat.h>
 #include <sys/syscall.h>
@@ -38,9 +39,14 @@
 #include <ucontext.h>
 #include <unistd.h>
 
+#include <fstream>
+#include <iterator>
+#include <sstream>
 #include <string>
+#include <thread>
 
 #include "breakpad_googletest_includes.h"
+#include "client/linux/dump_writer_common/crash_key_store.h"
 #include "client/linux/handler/exception_handler.h"
 #include "client/linux/minidump_writer/linux_dumper.h"
 #include "client/linux/minidump_writer/minidump_writer.h"
@@ -50,22 +56,35 @@
 #include "common/linux/file_id.h"
 #include "common/linux/ignore_ret.h"
 #include "common/linux/safe_readlink.h"
+#include "common/minidump_type_helper.h"
 #include "common/scoped_ptr.h"
 #include "common/tests/auto_tempdir.h"
 #include "common/tests/file_utils.h"
 #include "common/using_std_string.h"
 #include "google_breakpad/processor/minidump.h"
+#include "processor/snapshot_series.h"
 
 using namespace google_breakpad;
 using google_breakpad::elf::FileID;
 using google_breakpad::elf::kDefaultBuildIdSize;
 
+typedef MDTypeHelper<sizeof(void*)>::MDRawDebug MDRawDebug;
+typedef MDTypeHelper<sizeof(void*)>::MDRawLinkMap MDRawLinkMap;
+
 namespace {
 
 typedef testing::Test MinidumpWriterTest;
 
 const char kMDWriterUnitTestFileName[] = "/minidump-writer-unittest";
 
+// Reads the whole of the file at path into contents.
+bool ReadWholeFile(const string& path, string* contents) {
+  std::ifstream file(path.c_str(), std::ios::binary);
+  contents->assign(std::istreambuf_iterator<char>(file),
+                   std::istreambuf_iterator<char>());
+  return file.good() || file.eof();
+}
+
 TEST(MinidumpWriterTest, SetupWithPath) {
   int fds[2];
   ASSERT_NE(-1, pipe(fds));
@@ -96,6 +115,116 @@ TEST(MinidumpWriterTest, SetupWithPath) {
   IGNORE_EINTR(waitpid(child, nullptr, 0));
 }
 
+// Test that the dump records how long its phases took.
+TEST(MinidumpWriterTest, DumpTimingStream) {
+  int fds[2];
+  ASSERT_NE(-1, pipe(fds));
+
+  const pid_t child = fork();
+  if (child == 0) {
+    close(fds[1]);
+    char b;
+    IGNORE_RET(HANDLE_EINTR(read(fds[0], &b, sizeof(b))));
+    close(fds[0]);
+    syscall(__NR_exit_group);
+  }
+  close(fds[0]);
+
+  AutoTempDir temp_dir;
+  string templ = temp_dir.path() + kMDWriterUnitTestFileName;
+  ASSERT_TRUE(WriteMinidump(templ.c_str(), child, child));
+
+  Minidump minidump(templ);
+  ASSERT_TRUE(minidump.Read());
+  MinidumpDumpTiming* dump_timing = minidump.GetDumpTiming();
+  ASSERT_TRUE(dump_timing);
+  const std::vector<MDRawDumpPhaseTiming>* phases = dump_timing->phases();
+  ASSERT_TRUE(phases);
+
+  const MDRawDumpPhaseTiming* total = NULL;
+  const MDRawDumpPhaseTiming* suspend = NULL;
+  const MDRawDumpPhaseTiming* flush = NULL;
+  for (const MDRawDumpPhaseTiming& phase : *phases) {
+    if (phase.phase == MD_DUMP_PHASE_TOTAL)
+      total = &phase;
+    else if (phase.phase == MD_DUMP_PHASE_THREAD_SUSPEND)
+      suspend = &phase;
+    else if (phase.phase == MD_DUMP_PHASE_WRITE_FLUSH)
+      flush = &phase;
+  }
+  ASSERT_TRUE(total);
+  ASSERT_TRUE(suspend);
+  ASSERT_TRUE(flush);
+  EXPECT_EQ(1U, suspend->count);
+  EXPECT_GT(flush->bytes, 0U);
+  // Every phase falls within the whole dump.
+  for (const MDRawDumpPhaseTiming& phase : *phases) {
+    EXPECT_GE(phase.start_time, total->start_time);
+    EXPECT_LE(phase.start_time + phase.duration,
+              total->start_time + total->duration);
+  }
+
+  close(fds[1]);
+  IGNORE_EINTR(waitpid(child, nullptr, 0));
+}
+
+// Test that the DSO debug stream lists the same DSOs, under the same names,
+// as the dynamic linker of the (forked, so identical) child.
+TEST(MinidumpWriterTest, DSODebugStream) {
+  int fds[2];
+  ASSERT_NE(-1, pipe(fds));
+
+  const pid_t child = fork();
+  if (child == 0) {
+    close(fds[1]);
+    char b;
+    IGNORE_RET(HANDLE_EINTR(read(fds[0], &b, sizeof(b))));
+    close(fds[0]);
+    syscall(__NR_exit_group);
+  }
+  close(fds[0]);
+
+  AutoTempDir temp_dir;
+  string templ = temp_dir.path() + kMDWriterUnitTestFileName;
+  ASSERT_TRUE(WriteMinidump(templ.c_str(), child, child));
+
+  Minidump minidump(templ);
+  ASSERT_TRUE(minidump.Read());
+  uint32_t len;
+  ASSERT_TRUE(minidump.SeekToStreamType(MD_LINUX_DSO_DEBUG, &len));
+  ASSERT_GE(len, sizeof(MDRawDebug));
+  MDRawDebug debug;
+  ASSERT_TRUE(minidump.ReadBytes(&debug, sizeof(debug)));
+
+  std::vector<const struct link_map*> expected;
+  for (const struct link_map* map = _r_debug.r_map; map; map = map->l_next)
+    expected.push_back(map);
+  ASSERT_EQ(expected.size(), debug.dso_count);
+  // The main program's dynamic section is copied up to and including its
+  // DT_NULL entry.
+  ASSERT_FALSE(expected.empty());
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(expected[0]->l_ld), debug.dynamic);
+  size_t dynamic_entries = 0;
+  while (expected[0]->l_ld[dynamic_entries++].d_tag != DT_NULL) {
+  }
+  EXPECT_EQ(sizeof(debug) + dynamic_entries * sizeof(ElfW(Dyn)), len);
+
+  std::vector<MDRawLinkMap> maps(debug.dso_count);
+  ASSERT_TRUE(minidump.SeekSet(debug.map));
+  ASSERT_TRUE(minidump.ReadBytes(&maps[0],
+                                 maps.size() * sizeof(MDRawLinkMap)));
+  for (size_t i = 0; i < maps.size(); ++i) {
+    EXPECT_EQ(expected[i]->l_addr, maps[i].addr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(expected[i]->l_ld), maps[i].ld);
+    scoped_ptr<string> name(minidump.ReadString(maps[i].name));
+    ASSERT_TRUE(name.get());
+    EXPECT_EQ(string(expected[i]->l_name ? expected[i]->l_name : ""), *name);
+  }
+
+  close(fds[1]);
+  IGNORE_EINTR(waitpid(child, nullptr, 0));
+}
+
 TEST(MinidumpWriterTest, SetupWithFD) {
   int fds[2];
   ASSERT_NE(-1, pipe(fds));
@@ -127,6 +256,54 @@ TEST(MinidumpWriterTest, SetupWithFD) {
   IGNORE_EINTR(waitpid(child, nullptr, 0));
 }
 
+// Test that a minidump can be written straight to a pipe, which can't
+// seek, and still reads back whole.
+TEST(MinidumpWriterTest, WriteToPipe) {
+  int fds[2];
+  ASSERT_NE(-1, pipe(fds));
+
+  const pid_t child = fork();
+  if (child == 0) {
+    close(fds[1]);
+    char b;
+    HANDLE_EINTR(read(fds[0], &b, sizeof(b)));
+    close(fds[0]);
+    syscall(__NR_exit_group);
+  }
+  close(fds[0]);
+
+  int output[2];
+  ASSERT_NE(-1, pipe(output));
+  string contents;
+  std::thread reader([&]() {
+    char buffer[4096];
+    ssize_t count;
+    while ((count = HANDLE_EINTR(read(output[0], buffer, sizeof(buffer)))) >
+           0) {
+      contents.append(buffer, count);
+    }
+  });
+
+  ExceptionHandler::CrashContext context;
+  memset(&context, 0, sizeof(context));
+  context.tid = child;
+  EXPECT_TRUE(WriteMinidump(output[1], child, &context, sizeof(context)));
+  close(output[1]);
+  reader.join();
+  close(output[0]);
+
+  std::istringstream input(contents);
+  Minidump minidump(input);
+  ASSERT_TRUE(minidump.Read());
+  MinidumpThreadList* threads = minidump.GetThreadList();
+  ASSERT_TRUE(threads);
+  EXPECT_GE(threads->thread_count(), 1U);
+  EXPECT_TRUE(minidump.GetModuleList());
+
+  close(fds[1]);
+  IGNORE_EINTR(waitpid(child, nullptr, 0));
+}
+
 // Test that mapping info can be specified when writing a minidump,
 // and that it ends up in the module list of the minidump.
 TEST(MinidumpWriterTest, MappingInfo) {
@@ -219,6 +396,7 @@ TEST(MinidumpWriterTest, MappingInfo) {
   EXPECT_TRUE(minidump.SeekToStreamType(MD_LINUX_AUXV, &len));
   EXPECT_TRUE(minidump.SeekToStreamType(MD_LINUX_MAPS, &len));
   EXPECT_TRUE(minidump.SeekToStreamType(MD_LINUX_DSO_DEBUG, &len));
+  EXPECT_FALSE(minidump.SeekToStreamType(MD_LINUX_INCONSISTENT_MEMORY, &len));
 
   close(fds[1]);
   IGNORE_EINTR(waitpid(child, nullptr, 0));
@@ -681,6 +859,388 @@ TEST(MinidumpWriterTest, AdditionalMemory) {
   IGNORE_EINTR(waitpid(child, nullptr, 0));
 }
 
+// Application regions that overlap, or that are adjacent and written one
+// after the other, are listed once.
+TEST(MinidumpWriterTest, OverlappingAdditionalMemory) {
+  int fds[2];
+  ASSERT_NE(-1, pipe(fds));
+
+  const uint32_t kMemorySize = sysconf(_SC_PAGESIZE);
+  uint8_t* memory = new uint8_t[kMemorySize];
+  const uintptr_t kMemoryAddress = reinterpret_cast<uintptr_t>(memory);
+  for (uint32_t i = 0; i < kMemorySize; ++i) {
+    memory[i] = i % 255;
+  }
+
+  const pid_t child = fork();
+  if (child == 0) {
+    close(fds[1]);
+    char b;
+    HANDLE_EINTR(read(fds[0], &b, sizeof(b)));
+    close(fds[0]);
+    syscall(__NR_exit_group);
+  }
+  close(fds[0]);
+
+  ExceptionHandler::CrashContext context;
+  ASSERT_EQ(0, getcontext(&context.context));
+  context.tid = child;
+
+  AutoTempDir temp_dir;
+  string templ = temp_dir.path() + kMDWriterUnitTestFileName;
+  unlink(templ.c_str());
+
+  // The first half of the memory, then the second half, then a region
+  // within the first half.
+  MappingList mappings;
+  AppMemoryList memory_list;
+  AppMemory app_memory;
+  app_memory.ptr = memory;
+  app_memory.length = kMemorySize / 2;
+  memory_list.push_back(app_memory);
+  app_memory.ptr = memory + kMemorySize / 2;
+  app_memory.length = kMemorySize / 2;
+  memory_list.push_back(app_memory);
+  app_memory.ptr = memory + 16;
+  app_memory.length = 32;
+  memory_list.push_back(app_memory);
+  ASSERT_TRUE(WriteMinidump(templ.c_str(), child, &context, sizeof(context),
+                            mappings, memory_list));
+
+  Minidump minidump(templ);
+  ASSERT_TRUE(minidump.Read());
+  MinidumpMemoryList* dump_memory_list = minidump.GetMemoryList();
+  ASSERT_TRUE(dump_memory_list);
+
+  // The regions are in address order and don't overlap.
+  uint64_t last_end = 0;
+  int regions_in_memory = 0;
+  for (unsigned int i = 0; i < dump_memory_list->region_count(); ++i) {
+    MinidumpMemoryRegion* region = dump_memory_list->GetMemoryRegionAtIndex(i);
+    ASSERT_TRUE(region);
+    EXPECT_LE(last_end, region->GetBase());
+    last_end = region->GetBase() + region->GetSize();
+    if (region->GetBase() < kMemoryAddress + kMemorySize &&
+        last_end > kMemoryAddress) {
+      ++regions_in_memory;
+    }
+  }
+  EXPECT_EQ(1, regions_in_memory);
+
+  const MinidumpMemoryRegion* region =
+      dump_memory_list->GetMemoryRegionForAddress(kMemoryAddress);
+  ASSERT_TRUE(region);
+  EXPECT_EQ(kMemoryAddress, region->GetBase());
+  EXPECT_EQ(kMemorySize, region->GetSize());
+  EXPECT_EQ(0, memcmp(region->GetMemory(), memory, kMemorySize));
+
+  delete[] memory;
+  close(fds[1]);
+  IGNORE_EINTR(waitpid(child, nullptr, 0));
+}
+
+// Finds the ELF header and .eh_frame_hdr of the main executable.
+int FindExecutableEhFrameHeader(struct dl_phdr_info* info, size_t size,
+                                void* data) {
+  uintptr_t* addresses = static_cast<uintptr_t*>(data);
+  for (int i = 0; i < info->dlpi_phnum; ++i) {
+    const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+    if (phdr.p_type == PT_LOAD && !addresses[0])
+      addresses[0] = info->dlpi_addr + phdr.p_vaddr - phdr.p_offset;
+    else if (phdr.p_type == PT_GNU_EH_FRAME)
+      addresses[1] = info->dlpi_addr + phdr.p_vaddr;
+  }
+  // The main executable comes first.
+  return 1;
+}
+
+// Test that the unwind information of the module the crashing thread is
+// running in is written only if asked for.
+TEST(MinidumpWriterTest, UnwindInfo) {
+  int fds[2];
+  ASSERT_NE(-1, pipe(fds));
+
+  uintptr_t addresses[2] = {0, 0};
+  dl_iterate_phdr(FindExecutableEhFrameHeader, addresses);
+  const uintptr_t kElfHeaderAddress = addresses[0];
+  const uintptr_t kEhFrameHeaderAddress = addresses[1];
+  ASSERT_NE(0U, kElfHeaderAddress);
+  ASSERT_NE(0U, kEhFrameHeaderAddress);
+
+  const pid_t child = fork();
+  if (child == 0) {
+    close(fds[1]);
+    char b;
+    HANDLE_EINTR(read(fds[0], &b, sizeof(b)));
+    close(fds[0]);
+    syscall(__NR_exit_group);
+  }
+  close(fds[0]);
+
+  // The parent's context is in the test executable, as the child's is.
+  ExceptionHandler::CrashContext context;
+  ASSERT_EQ(0, getcontext(&context.context));
+  context.tid = child;
+
+  AutoTempDir temp_dir;
+  MappingList mappings;
+  AppMemoryList memory_list;
+  for (int include_unwind_info = 0; include_unwind_info < 2;
+       ++include_unwind_info) {
+    string templ = temp_dir.path() + kMDWriterUnitTestFileName;
+    unlink(templ.c_str());
+    ASSERT_TRUE(WriteMinidump(templ.c_str(), -1, child, &context,
+                              sizeof(context), mappings, memory_list,
+                              false, 0, false, false, NULL,
+                              include_unwind_info));
+
+    Minidump minidump(templ);
+    ASSERT_TRUE(minidump.Read());
+    MinidumpMemoryList* dump_memory_list = minidump.GetMemoryList();
+    ASSERT_TRUE(dump_memory_list);
+    MinidumpMemoryRegion* elf_header =
+        dump_memory_list->GetMemoryRegionForAddress(kElfHeaderAddress);
+    MinidumpMemoryRegion* eh_frame_header =
+        dump_memory_list->GetMemoryRegionForAddress(kEhFrameHeaderAddress);
+    if (!include_unwind_info) {
+      EXPECT_FALSE(elf_header);
+      EXPECT_FALSE(eh_frame_header);
+      continue;
+    }
+    ASSERT_TRUE(elf_header);
+    EXPECT_EQ(0, memcmp(elf_header->GetMemory(),
+                        reinterpret_cast<void*>(kElfHeaderAddress), SELFMAG));
+    ASSERT_TRUE(eh_frame_header);
+    uint8_t version = 0;
+    EXPECT_TRUE(eh_frame_header->GetMemoryAtAddress(kEhFrameHeaderAddress,
+                                                    &version));
+    EXPECT_EQ(1, version);
+  }
+
+  close(fds[1]);
+  IGNORE_EINTR(waitpid(child, nullptr, 0));
+}
+
+// Test that the keys of a CrashKeyStore named in the crash context are
+// written as Crashpad simple annotations.
+TEST(MinidumpWriterTest, CrashKeys) {
+  int fds[2];
+  ASSERT_NE(-1, pipe(fds));
+
+  // The child is a forked copy, so the store is at the same address there.
+  scoped_ptr<CrashKeyStore> store(new CrashKeyStore);
+  ASSERT_TRUE(store->SetKeyValue("request", "1234"));
+  ASSERT_TRUE(store->SetKeyValue("feature", "on"));
+  ASSERT_TRUE(store->SetKeyValue("removed", "soon"));
+  store->RemoveKey("removed");
+
+  const pid_t child = fork();
+  if (child == 0) {
+    close(fds[1]);
+    char b;
+    IGNORE_RET(HANDLE_EINTR(read(fds[0], &b, sizeof(b))));
+    close(fds[0]);
+    syscall(__NR_exit_group);
+  }
+  close(fds[0]);
+
+  ExceptionHandler::CrashContext context;
+  memset(&context, 0, sizeof(context));
+  ASSERT_EQ(0, getcontext(&context.context));
+  context.tid = child;
+  context.crash_key_store = reinterpret_cast<uintptr_t>(store.get());
+
+  AutoTempDir temp_dir;
+  string templ = temp_dir.path() + kMDWriterUnitTestFileName;
+  ASSERT_TRUE(WriteMinidump(templ.c_str(), child, &context, sizeof(context)));
+
+  Minidump minidump(templ);
+  ASSERT_TRUE(minidump.Read());
+  MinidumpCrashpadInfo* crashpad_info = minidump.GetCrashpadInfo();
+  ASSERT_TRUE(crashpad_info);
+  const std::map<std::string, std::string>* annotations =
+      crashpad_info->GetSimpleAnnotations();
+  ASSERT_TRUE(annotations);
+  EXPECT_EQ(2U, annotations->size());
+  EXPECT_EQ("1234", annotations->find("request")->second);
+  EXPECT_EQ("on", annotations->find("feature")->second);
+  EXPECT_EQ(0U, annotations->count("removed"));
+
+  close(fds[1]);
+  IGNORE_EINTR(waitpid(child, nullptr, 0));
+}
+
+// Test that a low-pause snapshot lists the memory it read while the
+// process ran.
+TEST(MinidumpWriterTest, LowPauseSnapshot) {
+  int fds[2];
+  ASSERT_NE(-1, pipe(fds));
+
+  const uint32_t kMemorySize = sysconf(_SC_PAGESIZE);
+  uint8_t* memory = new uint8_t[kMemorySize];
+  const uintptr_t kMemoryAddress = reinterpret_cast<uintptr_t>(memory);
+  for (uint32_t i = 0; i < kMemorySize; ++i) {
+    memory[i] = i % 255;
+  }
+
+  const pid_t child = fork();
+  if (child == 0) {
+    close(fds[1]);
+    char b;
+    HANDLE_EINTR(read(fds[0], &b, sizeof(b)));
+    close(fds[0]);
+    syscall(__NR_exit_group);
+  }
+  close(fds[0]);
+
+  AutoTempDir temp_dir;
+  string templ = temp_dir.path() + kMDWriterUnitTestFileName;
+  unlink(templ.c_str());
+
+  AppMemoryList memory_list;
+  AppMemory app_memory;
+  app_memory.ptr = memory;
+  app_memory.length = kMemorySize;
+  memory_list.push_back(app_memory);
+  ASSERT_TRUE(WriteMinidump(templ.c_str(), child, child, memory_list, true));
+
+  // The process runs again as soon as the snapshot has been taken.
+  char b = 0;
+  ASSERT_EQ(1, HANDLE_EINTR(write(fds[1], &b, sizeof(b))));
+  close(fds[1]);
+  IGNORE_EINTR(waitpid(child, nullptr, 0));
+
+  Minidump minidump(templ);
+  ASSERT_TRUE(minidump.Read());
+
+  MinidumpThreadList* threads = minidump.GetThreadList();
+  ASSERT_TRUE(threads);
+  EXPECT_EQ(1U, threads->thread_count());
+
+  MinidumpMemoryList* dump_memory_list = minidump.GetMemoryList();
+  ASSERT_TRUE(dump_memory_list);
+  const MinidumpMemoryRegion* region =
+      dump_memory_list->GetMemoryRegionForAddress(kMemoryAddress);
+  ASSERT_TRUE(region);
+  EXPECT_EQ(0, memcmp(region->GetMemory(), memory, kMemorySize));
+
+  // The application memory was read while the process ran.
+  uint32_t len;
+  ASSERT_TRUE(minidump.SeekToStreamType(MD_LINUX_INCONSISTENT_MEMORY, &len));
+  uint32_t count;
+  ASSERT_GE(len, sizeof(count));
+  ASSERT_TRUE(minidump.ReadBytes(&count, sizeof(count)));
+  ASSERT_EQ(sizeof(count) + count * sizeof(MDMemoryDescriptor), len);
+  bool found = false;
+  for (uint32_t i = 0; i < count; ++i) {
+    MDMemoryDescriptor descriptor;
+    ASSERT_TRUE(minidump.ReadBytes(&descriptor, sizeof(descriptor)));
+    found |= descriptor.start_of_memory_range == kMemoryAddress;
+  }
+  EXPECT_TRUE(found);
+
+  delete[] memory;
+}
+
+// Test that a later snapshot of a series holds only the pages that changed,
+// and can be put back together with the first.
+TEST(MinidumpWriterTest, SnapshotSeries) {
+  int fds[2];
+  ASSERT_NE(-1, pipe(fds));
+  int ack_fds[2];
+  ASSERT_NE(-1, pipe(ack_fds));
+
+  const size_t kPageSize = sysconf(_SC_PAGESIZE);
+  void* allocation;
+  ASSERT_EQ(0, posix_memalign(&allocation, kPageSize, 2 * kPageSize));
+  uint8_t* memory = static_cast<uint8_t*>(allocation);
+  const uintptr_t kMemoryAddress = reinterpret_cast<uintptr_t>(memory);
+  memset(memory, 'a', 2 * kPageSize);
+
+  const pid_t child = fork();
+  if (child == 0) {
+    close(fds[1]);
+    close(ack_fds[0]);
+    // Change the second page between the snapshots.
+    char b;
+    IGNORE_RET(HANDLE_EINTR(read(fds[0], &b, sizeof(b))));
+    memset(memory + kPageSize, 'b', kPageSize);
+    IGNORE_RET(HANDLE_EINTR(write(ack_fds[1], &b, sizeof(b))));
+    IGNORE_RET(HANDLE_EINTR(read(fds[0], &b, sizeof(b))));
+    syscall(__NR_exit_group);
+  }
+  close(fds[0]);
+  close(ack_fds[1]);
+
+  AutoTempDir temp_dir;
+  const string base_path = temp_dir.path() + "/base.dmp";
+  const string delta_path = temp_dir.path() + "/delta.dmp";
+
+  AppMemoryList memory_list;
+  AppMemory app_memory;
+  app_memory.ptr = memory;
+  app_memory.length = 2 * kPageSize;
+  memory_list.push_back(app_memory);
+  MinidumpSnapshotSeries series;
+  ASSERT_TRUE(series.WriteSnapshot(base_path.c_str(), child, child,
+                                   memory_list));
+  char b = 0;
+  ASSERT_EQ(1, HANDLE_EINTR(write(fds[1], &b, sizeof(b))));
+  ASSERT_EQ(1, HANDLE_EINTR(read(ack_fds[0], &b, sizeof(b))));
+  ASSERT_TRUE(series.WriteSnapshot(delta_path.c_str(), child, child,
+                                   memory_list));
+  EXPECT_EQ(2U, series.snapshot_count());
+
+  close(fds[1]);
+  close(ack_fds[0]);
+  IGNORE_EINTR(waitpid(child, nullptr, 0));
+
+  string base, delta;
+  ASSERT_TRUE(ReadWholeFile(base_path, &base));
+  ASSERT_TRUE(ReadWholeFile(delta_path, &delta));
+
+  MDRawSnapshotSeries raw_series;
+  ASSERT_TRUE(ReadSnapshotSeries(delta, &raw_series));
+  EXPECT_EQ(0, memcmp(&series.series_id(), &raw_series.series_id,
+                      sizeof(MDGUID)));
+  EXPECT_EQ(1U, raw_series.sequence);
+
+  // The delta holds the changed page alone.
+  {
+    Minidump minidump(delta_path);
+    ASSERT_TRUE(minidump.Read());
+    MinidumpMemoryList* dump_memory_list = minidump.GetMemoryList();
+    ASSERT_TRUE(dump_memory_list);
+    const MinidumpMemoryRegion* region =
+        dump_memory_list->GetMemoryRegionForAddress(kMemoryAddress +
+                                                    kPageSize);
+    ASSERT_TRUE(region);
+    EXPECT_EQ(kMemoryAddress + kPageSize, region->GetBase());
+    EXPECT_EQ(kPageSize, region->GetSize());
+    EXPECT_FALSE(dump_memory_list->GetMemoryRegionForAddress(kMemoryAddress));
+  }
+
+  string snapshot;
+  ASSERT_TRUE(ReconstructSnapshot(base, delta, &snapshot));
+  std::istringstream snapshot_stream(snapshot);
+  Minidump minidump(snapshot_stream);
+  ASSERT_TRUE(minidump.Read());
+  MinidumpThreadList* threads = minidump.GetThreadList();
+  ASSERT_TRUE(threads);
+  EXPECT_EQ(1U, threads->thread_count());
+  MinidumpMemoryList* dump_memory_list = minidump.GetMemoryList();
+  ASSERT_TRUE(dump_memory_list);
+  const MinidumpMemoryRegion* region =
+      dump_memory_list->GetMemoryRegionForAddress(kMemoryAddress);
+  ASSERT_TRUE(region);
+  ASSERT_EQ(kMemoryAddress, region->GetBase());
+  ASSERT_EQ(2 * kPageSize, region->GetSize());
+  const string expected = string(kPageSize, 'a') + string(kPageSize, 'b');
+  EXPECT_EQ(0, memcmp(region->GetMemory(), expected.data(), expected.size()));
+
+  free(allocation);
+}
+
 // Test that an invalid thread stack pointer still results in a minidump.
 TEST(MinidumpWriterTest, InvalidStackPointer) {
   int fds[2];
@@ -822,6 +1382,7 @@ TEST(MinidumpWriterTest, MinidumpSizeLimit) {
 
   off_t normal_file_size;
   int total_normal_stack_size = 0;
+  int normal_crash_stack_size = 0;
   AutoTempDir temp_dir;
 
   // First, write a minidump with no size limit.
@@ -847,6 +1408,8 @@ TEST(MinidumpWriterTest, MinidumpSizeLimit) {
       MinidumpMemoryRegion* memory = thread->GetMemory();
       ASSERT_TRUE(memory != NULL);
       total_normal_stack_size += memory->GetSize();
+      if (thread->thread()->thread_id == static_cast<uint32_t>(child_pid))
+        normal_crash_stack_size = memory->GetSize();
     }
   }
 
@@ -866,27 +1429,17 @@ TEST(MinidumpWriterTest, MinidumpSizeLimit) {
     ASSERT_EQ(0, stat(same_dump.c_str(), &st));
     // Make sure limiting wasn't actually triggered.  NOTE: If you fail this,
     // first make sure that "minidump_size_limit" above is indeed set to a
-    // large enough value -- the limit-checking code in minidump_writer.cc
-    // does just a rough estimate.
+    // large enough value -- the size budget in minidump_writer.cc sets
+    // kLimitMinidumpFudgeFactor bytes aside for what it does not plan.
     ASSERT_EQ(normal_file_size, st.st_size);
   }
 
   // Third, write a minidump with a size limit small enough to be triggered.
   {
-    // Set size limit to some arbitrary amount, such that the limiting code
-    // will kick in.  The equation used to set this value was determined by
-    // simply reversing the size-limit logic a little bit in order to pick a
-    // size we know will trigger it.  The definition of
-    // kLimitAverageThreadStackLength here was copied from class
-    // MinidumpWriter in minidump_writer.cc.
-    static const unsigned kLimitAverageThreadStackLength = 8 * 1024;
-    off_t minidump_size_limit = kNumberOfThreadsInHelperProgram *
-        kLimitAverageThreadStackLength;
-    // If, in reality, each of the threads' stack is *smaller* than
-    // kLimitAverageThreadStackLength, the normal file size could very well be
-    // smaller than the arbitrary limit that was just set.  In that case,
-    // either of these numbers should trigger the size-limiting code, but we
-    // might as well pick the smallest.
+    // Allow each thread about 8KB of stack, which is less than the writer
+    // normally takes but more than the top of each stack that it keeps
+    // before anything else.
+    off_t minidump_size_limit = kNumberOfThreadsInHelperProgram * 8 * 1024;
     if (normal_file_size < minidump_size_limit)
       minidump_size_limit = normal_file_size;
 
@@ -898,9 +1451,9 @@ TEST(MinidumpWriterTest, MinidumpSizeLimit) {
     struct stat st;
     ASSERT_EQ(0, stat(limit_dump.c_str(), &st));
     ASSERT_GT(st.st_size, 0);
-    // Make sure the file size is at least smaller than the original.  If this
-    // fails because it's the same size, then the size-limit logic didn't kick
-    // in like it was supposed to.
+    // Make sure the limit was honoured and that the size-limit logic kicked
+    // in.
+    EXPECT_LE(st.st_size, minidump_size_limit);
     EXPECT_LT(st.st_size, normal_file_size);
 
     Minidump minidump(limit_dump);
@@ -915,23 +1468,48 @@ TEST(MinidumpWriterTest, MinidumpSizeLimit) {
       MinidumpMemoryRegion* memory = thread->GetMemory();
       ASSERT_TRUE(memory != NULL);
       total_limit_stack_size += memory->GetSize();
+      // The crashing thread's stack comes first, so it is never cut short.
+      if (thread->thread()->thread_id == static_cast<uint32_t>(child_pid)) {
+        EXPECT_EQ(static_cast<uint32_t>(normal_crash_stack_size),
+                  memory->GetSize());
+      }
     }
+    EXPECT_LT(total_limit_stack_size, total_normal_stack_size);
 
-    // Make sure stack size shrunk by at least 1KB per extra thread.  The
-    // definition of kLimitBaseThreadCount here was copied from class
-    // MinidumpWriter in minidump_writer.cc.
-    // Note: The 1KB is arbitrary, and assumes that the thread stacks are big
-    // enough to shrink by that much.  For example, if each thread stack was
-    // originally only 2KB, the current size-limit logic wouldn't actually
-    // shrink them because that's the size to which it tries to shrink.  If
-    // you fail this part of the test due to something like that, the test
-    // logic should probably be improved to account for your situation.
-    const unsigned kLimitBaseThreadCount = 20;
-    const unsigned kMinPerExtraThreadStackReduction = 1024;
-    const int min_expected_reduction = (kNumberOfThreadsInHelperProgram -
-        kLimitBaseThreadCount) * kMinPerExtraThreadStackReduction;
-    EXPECT_LT(total_limit_stack_size,
-              total_normal_stack_size - min_expected_reduction);
+    // The module list comes before the files, so it is whole.
+    MinidumpModuleList* module_list = minidump.GetModuleList();
+    ASSERT_TRUE(module_list);
+    EXPECT_GT(module_list->module_count(), 0U);
+  }
+
+  // Fourth, write a minidump with application-provided memory that does not
+  // fit.  It is dropped rather than letting the minidump grow past the limit.
+  {
+    const size_t kAppMemorySize = 2 * 1024 * 1024;
+    char* app_memory = new char[kAppMemorySize];
+    AppMemoryList app_memory_list;
+    AppMemory app;
+    app.ptr = app_memory;
+    app.length = kAppMemorySize;
+    app_memory_list.push_back(app);
+
+    const off_t minidump_size_limit = normal_file_size + 1024*1024;
+    string app_dump = temp_dir.path() +
+        "/minidump-writer-unittest-app.dmp";
+    ASSERT_TRUE(WriteMinidump(app_dump.c_str(), minidump_size_limit,
+                              child_pid, NULL, 0,
+                              MappingList(), app_memory_list));
+    struct stat st;
+    ASSERT_EQ(0, stat(app_dump.c_str(), &st));
+    EXPECT_EQ(normal_file_size, st.st_size);
+
+    Minidump minidump(app_dump);
+    ASSERT_TRUE(minidump.Read());
+    MinidumpMemoryList* dump_memory_list = minidump.GetMemoryList();
+    ASSERT_TRUE(dump_memory_list);
+    EXPECT_EQ(nullptr, dump_memory_list->GetMemoryRegionForAddress(
+        reinterpret_cast<uintptr_t>(app_memory)));
+    delete[] app_memory;
   }
 
   // Kill the helper program.
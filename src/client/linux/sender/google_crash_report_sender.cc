@@ -31,11 +31,15 @@
 #endif
 
 #include "common/linux/google_crashdump_uploader.h"
+#include <time.h>
+#include <map>
 #include <string>
 #include <iostream>
 #include <gflags/gflags.h>
 #include <glog/logging.h>
 
+#include "common/linux/crash_report_queue.h"
+
 #include "common/using_std_string.h"
 
 DEFINE_string(crash_server, "https://clients2.google.com/cr",
@@ -60,6 +64,73 @@ DEFINE_string(proxy_host, "",
               "Proxy host");
 DEFINE_string(proxy_userpasswd, "",
               "Proxy username/password in user:pass format.");
+DEFINE_string(spool_dir, "",
+              "If set, queue the minidump in this directory rather than "
+              "uploading it, or with --upload_spool, upload the queue.");
+DEFINE_string(signature, "",
+              "A signature of the crash, such as a hash of its stack. Only "
+              "one queued minidump per signature is uploaded.");
+DEFINE_bool(upload_spool, false,
+            "Upload the minidumps queued in --spool_dir.");
+DEFINE_int32(max_concurrent_uploads, 2,
+             "The number of queued minidumps to upload at once.");
+DEFINE_int32(max_uploads, 100,
+             "The most queued minidumps to upload in one run.");
+
+using google_breakpad::CrashReportQueue;
+
+namespace {
+
+// Form fields recorded with a queued minidump.
+const char kProductKey[] = "prod";
+const char kVersionKey[] = "ver";
+const char kClientIdKey[] = "guid";
+const char kPtimeKey[] = "ptime";
+const char kCtimeKey[] = "ctime";
+const char kEmailKey[] = "email";
+const char kCommentsKey[] = "comments";
+
+string GetParameter(const CrashReportQueue::Report& report, const char* key) {
+  std::map<string, string>::const_iterator iter = report.parameters.find(key);
+  return iter == report.parameters.end() ? string() : iter->second;
+}
+
+CrashReportQueue::UploadResult UploadQueuedReport(
+    const CrashReportQueue::Report& report,
+    const string& minidump_path) {
+  string comments = GetParameter(report, kCommentsKey);
+  if (report.duplicates > 0) {
+    if (!comments.empty())
+      comments += " ";
+    comments += std::to_string(report.duplicates) +
+        " duplicate crashes were not uploaded.";
+  }
+  google_breakpad::GoogleCrashdumpUploader g(GetParameter(report, kProductKey),
+                                             GetParameter(report, kVersionKey),
+                                             GetParameter(report, kClientIdKey),
+                                             GetParameter(report, kPtimeKey),
+                                             GetParameter(report, kCtimeKey),
+                                             GetParameter(report, kEmailKey),
+                                             comments,
+                                             minidump_path,
+                                             FLAGS_crash_server,
+                                             FLAGS_proxy_host,
+                                             FLAGS_proxy_userpasswd);
+  int http_status_code = 0;
+  if (!g.Upload(&http_status_code, NULL, NULL) || http_status_code == 0)
+    return CrashReportQueue::UPLOAD_RETRY;
+  if (http_status_code >= 200 && http_status_code < 300)
+    return CrashReportQueue::UPLOAD_SENT;
+  // The server won't change its mind about a request it finds malformed,
+  // but may about anything else, such as being overloaded.
+  if (http_status_code >= 400 && http_status_code < 500 &&
+      http_status_code != 408 && http_status_code != 429) {
+    return CrashReportQueue::UPLOAD_REJECT;
+  }
+  return CrashReportQueue::UPLOAD_RETRY;
+}
+
+}  // namespace
 
 
 bool CheckForRequiredFlagsOrDie() {
@@ -90,9 +161,38 @@ bool CheckForRequiredFlagsOrDie() {
 int main(int argc, char* argv[]) {
   google::InitGoogleLogging(argv[0]);
   google::ParseCommandLineFlags(&argc, &argv, true);
+  if (FLAGS_upload_spool) {
+    if (FLAGS_spool_dir.empty()) {
+      std::cout << "\n--upload_spool requires --spool_dir.";
+      return 1;
+    }
+    CrashReportQueue queue(FLAGS_spool_dir);
+    int sent = queue.ProcessQueue(UploadQueuedReport,
+                                  FLAGS_max_concurrent_uploads,
+                                  FLAGS_max_uploads, time(NULL));
+    std::cout << "Uploaded " << sent << " queued minidumps.\n";
+    return 0;
+  }
   if (!CheckForRequiredFlagsOrDie()) {
     return 1;
   }
+  if (!FLAGS_spool_dir.empty()) {
+    std::map<string, string> parameters;
+    parameters[kProductKey] = FLAGS_product_name;
+    parameters[kVersionKey] = FLAGS_product_version;
+    parameters[kClientIdKey] = FLAGS_client_id;
+    parameters[kPtimeKey] = FLAGS_ptime;
+    parameters[kCtimeKey] = FLAGS_ctime;
+    parameters[kEmailKey] = FLAGS_email;
+    parameters[kCommentsKey] = FLAGS_comments;
+    CrashReportQueue queue(FLAGS_spool_dir);
+    if (!queue.Enqueue(FLAGS_minidump_path, FLAGS_signature, parameters,
+                       NULL)) {
+      std::cout << "\nFailed to queue " << FLAGS_minidump_path;
+      return 1;
+    }
+    return 0;
+  }
   google_breakpad::GoogleCrashdumpUploader g(FLAGS_product_name,
                                              FLAGS_product_version,
                                              FLAGS_client_id,
@@ -60,18 +60,32 @@ CrashGenerationServer::CrashGenerationServer(
       dump_dir_(dump_path.empty() ? "/tmp" : dump_path),
       started_(false),
       receive_port_(mach_port_name),
-      mach_port_name_(mach_port_name) {
+      mach_port_name_(mach_port_name),
+      max_concurrent_dumps_(kDefaultMaxConcurrentDumps),
+      stopping_workers_(false) {
+  pthread_mutex_init(&requests_lock_, NULL);
+  pthread_cond_init(&requests_available_, NULL);
 }
 
 CrashGenerationServer::~CrashGenerationServer() {
   if (started_)
     Stop();
+  pthread_cond_destroy(&requests_available_);
+  pthread_mutex_destroy(&requests_lock_);
+}
+
+void CrashGenerationServer::SetMaxConcurrentDumps(int max_dumps) {
+  max_concurrent_dumps_ = max_dumps > 0 ? max_dumps : 1;
 }
 
 bool CrashGenerationServer::Start() {
+  if (!StartWorkers())
+    return false;
   int thread_create_result = pthread_create(&server_thread_, NULL,
                                             &WaitForMessages, this);
   started_ = thread_create_result == 0;
+  if (!started_)
+    StopWorkers();
   return started_;
 }
 
@@ -92,11 +106,37 @@ bool CrashGenerationServer::Stop() {
   return !started_;
 }
 
+bool CrashGenerationServer::StartWorkers() {
+  stopping_workers_ = false;
+  for (int i = 0; i < max_concurrent_dumps_; ++i) {
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, &HandleDumpRequests, this) != 0) {
+      StopWorkers();
+      return false;
+    }
+    worker_threads_.push_back(thread);
+  }
+  return true;
+}
+
+void CrashGenerationServer::StopWorkers() {
+  pthread_mutex_lock(&requests_lock_);
+  stopping_workers_ = true;
+  pthread_cond_broadcast(&requests_available_);
+  pthread_mutex_unlock(&requests_lock_);
+
+  for (pthread_t thread : worker_threads_)
+    pthread_join(thread, NULL);
+  worker_threads_.clear();
+}
+
 // static
 void* CrashGenerationServer::WaitForMessages(void* server) {
   CrashGenerationServer* self =
       reinterpret_cast<CrashGenerationServer*>(server);
   while (self->WaitForOneMessage()) {}
+  // Requests received before the quit message are still handled.
+  self->StopWorkers();
   return NULL;
 }
 
@@ -107,54 +147,17 @@ bool CrashGenerationServer::WaitForOneMessage() {
   if (result == KERN_SUCCESS) {
     switch (message.GetMessageID()) {
       case kDumpRequestMessage: {
-        ExceptionInfo& info = (ExceptionInfo&)*message.GetData();
-      
-        mach_port_t remote_task = message.GetTranslatedPort(0);
-        mach_port_t crashing_thread = message.GetTranslatedPort(1);
-        mach_port_t handler_thread = message.GetTranslatedPort(2);
-        mach_port_t ack_port = message.GetTranslatedPort(3);
-        pid_t remote_pid = -1;
-        pid_for_task(remote_task, &remote_pid);
-        ClientInfo client(remote_pid);
-
-        bool result;
-        std::string dump_path;
-        if (generate_dumps_ && (!filter_ || filter_(filter_context_))) {
-          ScopedTaskSuspend suspend(remote_task);
-
-          MinidumpGenerator generator(remote_task, handler_thread);
-          dump_path = generator.UniqueNameInDirectory(dump_dir_, NULL);
-        
-          if (info.exception_type && info.exception_code) {
-            generator.SetExceptionInformation(info.exception_type,
-                                              info.exception_code,
-                                              info.exception_subcode,
-                                              crashing_thread);
-          }
-          result = generator.Write(dump_path.c_str());
-        } else {
-          result = true;
-        }
-
-        if (result && dump_callback_) {
-          dump_callback_(dump_context_, client, dump_path);
-        }
-
-        // TODO(ted): support a way for the client to send additional data,
-        // perhaps with a callback so users of the server can read the data
-        // themselves?
-      
-        if (ack_port != MACH_PORT_DEAD && ack_port != MACH_PORT_NULL) {
-          MachPortSender sender(ack_port);
-          MachSendMessage ack_message(kAcknowledgementMessage);
-          const mach_msg_timeout_t kSendTimeoutMs = 2 * 1000;
-
-          sender.SendMessage(ack_message, kSendTimeoutMs);
-        }
-
-        if (exit_callback_) {
-          exit_callback_(exit_context_, client);
-        }
+        DumpRequest request;
+        request.info = (ExceptionInfo&)*message.GetData();
+        request.remote_task = message.GetTranslatedPort(0);
+        request.crashing_thread = message.GetTranslatedPort(1);
+        request.handler_thread = message.GetTranslatedPort(2);
+        request.ack_port = message.GetTranslatedPort(3);
+
+        pthread_mutex_lock(&requests_lock_);
+        pending_requests_.push_back(request);
+        pthread_cond_signal(&requests_available_);
+        pthread_mutex_unlock(&requests_lock_);
         break;
       }
       case kQuitMessage:
@@ -166,4 +169,79 @@ bool CrashGenerationServer::WaitForOneMessage() {
   return true;
 }
 
+// static
+void* CrashGenerationServer::HandleDumpRequests(void* server) {
+  CrashGenerationServer* self =
+      reinterpret_cast<CrashGenerationServer*>(server);
+  pthread_mutex_lock(&self->requests_lock_);
+  while (true) {
+    while (self->pending_requests_.empty() && !self->stopping_workers_)
+      pthread_cond_wait(&self->requests_available_, &self->requests_lock_);
+    if (self->pending_requests_.empty())
+      break;
+    DumpRequest request = self->pending_requests_.front();
+    self->pending_requests_.pop_front();
+    pthread_mutex_unlock(&self->requests_lock_);
+    self->HandleDumpRequest(request);
+    pthread_mutex_lock(&self->requests_lock_);
+  }
+  pthread_mutex_unlock(&self->requests_lock_);
+  return NULL;
+}
+
+void CrashGenerationServer::HandleDumpRequest(const DumpRequest& request) {
+  pid_t remote_pid = -1;
+  pid_for_task(request.remote_task, &remote_pid);
+  ClientInfo client(remote_pid);
+
+  bool result;
+  std::string dump_path;
+  if (generate_dumps_ && (!filter_ || filter_(filter_context_))) {
+    ScopedTaskSuspend suspend(request.remote_task);
+
+    MinidumpGenerator generator(request.remote_task, request.handler_thread);
+    dump_path = generator.UniqueNameInDirectory(dump_dir_, NULL);
+
+    if (request.info.exception_type && request.info.exception_code) {
+      generator.SetExceptionInformation(request.info.exception_type,
+                                        request.info.exception_code,
+                                        request.info.exception_subcode,
+                                        request.crashing_thread);
+    }
+    result = generator.Write(dump_path.c_str());
+  } else {
+    result = true;
+  }
+
+  if (result && dump_callback_) {
+    dump_callback_(dump_context_, client, dump_path);
+  }
+
+  // TODO(ted): support a way for the client to send additional data,
+  // perhaps with a callback so users of the server can read the data
+  // themselves?
+
+  if (request.ack_port != MACH_PORT_DEAD &&
+      request.ack_port != MACH_PORT_NULL) {
+    MachPortSender sender(request.ack_port);
+    MachSendMessage ack_message(kAcknowledgementMessage);
+    const mach_msg_timeout_t kSendTimeoutMs = 2 * 1000;
+
+    sender.SendMessage(ack_message, kSendTimeoutMs);
+  }
+
+  if (exit_callback_) {
+    exit_callback_(exit_context_, client);
+  }
+
+  // The message carried a send right for each port; release them now that
+  // this request is done with them.
+  const mach_port_t ports[] = {request.remote_task, request.crashing_thread,
+                               request.handler_thread, request.ack_port};
+  for (mach_port_t port : ports) {
+    if (port != MACH_PORT_DEAD && port != MACH_PORT_NULL)
+      mach_port_deallocate(mach_task_self(), port);
+  }
+}
+
 }  // namespace google_breakpad
@@ -29,9 +29,12 @@
 #ifndef GOOGLE_BREAKPAD_CLIENT_MAC_CRASH_GENERATION_CRASH_GENERATION_SERVER_H_
 #define GOOGLE_BREAKPAD_CLIENT_MAC_CRASH_GENERATION_CRASH_GENERATION_SERVER_H_
 
+#include <pthread.h>
 #include <stdint.h>
 
+#include <deque>
 #include <string>
+#include <vector>
 
 #include "common/mac/MachIPC.h"
 
@@ -56,7 +59,8 @@ struct ExceptionInfo {
 class CrashGenerationServer {
  public:
   // WARNING: callbacks may be invoked on a different thread
-  // than that which creates the CrashGenerationServer.  They must
+  // than that which creates the CrashGenerationServer, and on several
+  // threads at once when clients request dumps together.  They must
   // be thread safe.
   typedef void (*OnClientDumpRequestCallback)(void* context,
                                               const ClientInfo& client_info,
@@ -94,6 +98,15 @@ class CrashGenerationServer {
 
   ~CrashGenerationServer();
 
+  // The number of dumps generated at once when none is set.
+  static const int kDefaultMaxConcurrentDumps = 4;
+
+  // Set how many client requests may be handled at once.  Each request
+  // suspends its client and writes its dump on one of this many worker
+  // threads, so that clients crashing together don't wait on each other.
+  // Must be called before Start.
+  void SetMaxConcurrentDumps(int max_dumps);
+
   // Perform initialization steps needed to start listening to clients.
   //
   // Return true if initialization is successful; false otherwise.
@@ -114,6 +127,27 @@ class CrashGenerationServer {
   // if a quit message was received or if an error occurred.
   bool WaitForOneMessage();
 
+  // A dump request received from a client.  The ports are send rights
+  // owned by the request, and are deallocated once it has been handled.
+  struct DumpRequest {
+    ExceptionInfo info;
+    mach_port_t remote_task;
+    mach_port_t crashing_thread;
+    mach_port_t handler_thread;
+    mach_port_t ack_port;
+  };
+
+  // Take requests from the queue and handle them until the server stops
+  // and the queue is empty.
+  static void* HandleDumpRequests(void* server);
+
+  // Write the dump for a request, acknowledge it, and release its ports.
+  void HandleDumpRequest(const DumpRequest& request);
+
+  // Start and stop the worker threads.
+  bool StartWorkers();
+  void StopWorkers();
+
   FilterCallback filter_;
   void* filter_context_;
 
@@ -139,6 +173,17 @@ class CrashGenerationServer {
   // The thread that waits on the receive port.
   pthread_t server_thread_;
 
+  // The number of worker threads handling dump requests.
+  int max_concurrent_dumps_;
+
+  // The worker threads, and the requests waiting for one of them.
+  // |requests_lock_| guards |pending_requests_| and |stopping_workers_|.
+  std::vector<pthread_t> worker_threads_;
+  std::deque<DumpRequest> pending_requests_;
+  bool stopping_workers_;
+  pthread_mutex_t requests_lock_;
+  pthread_cond_t requests_available_;
+
   // Disable copy constructor and operator=.
   CrashGenerationServer(const CrashGenerationServer&);
   CrashGenerationServer& operator=(const CrashGenerationServer&);
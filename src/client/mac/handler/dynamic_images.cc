@@ -42,11 +42,15 @@ extern "C" { // needed to compile on Leopard
 #include <AvailabilityMacros.h>
 #include <dlfcn.h>
 #include <mach/task_info.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <string.h>
 #include <sys/sysctl.h>
 #include <TargetConditionals.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <map>
 #include <string>
 #include <vector>
 
@@ -186,33 +190,166 @@ kern_return_t ReadTaskMemory(task_port_t target_task,
                              const uint64_t address,
                              size_t length,
                              vector<uint8_t>& bytes) {
-  int systemPageSize = getpagesize();
+  bytes.resize(length);
+  if (length == 0)
+    return KERN_SUCCESS;
+
+  // Copy straight into |bytes|, rather than having mach_vm_read() map the
+  // pages into this task only to copy them out and unmap them again.
+  mach_vm_size_t bytes_read = 0;
+  kern_return_t r = mach_vm_read_overwrite(
+      target_task, address, length,
+      reinterpret_cast<mach_vm_address_t>(&bytes[0]), &bytes_read);
+  if (r == KERN_SUCCESS && bytes_read != length)
+    r = KERN_FAILURE;
+  return r;
+}
 
-  // use the negative of the page size for the mask to find the page address
-  mach_vm_address_t page_address = address & (-systemPageSize);
+#pragma mark -
 
-  mach_vm_address_t last_page_address =
-      (address + length + (systemPageSize - 1)) & (-systemPageSize);
+//==============================================================================
+TaskMemoryReader::TaskMemoryReader(task_port_t task)
+    : task_(task),
+      scratch_(0),
+      scratch_size_(0) {
+}
 
-  mach_vm_size_t page_size = last_page_address - page_address;
-  uint8_t* local_start;
-  uint32_t local_length;
+TaskMemoryReader::~TaskMemoryReader() {
+  if (scratch_)
+    mach_vm_deallocate(mach_task_self(), scratch_, scratch_size_);
+}
 
-  kern_return_t r = mach_vm_read(target_task,
-                                 page_address,
-                                 page_size,
-                                 reinterpret_cast<vm_offset_t*>(&local_start),
-                                 &local_length);
+bool TaskMemoryReader::Reserve(size_t size) {
+  if (size <= scratch_size_)
+    return true;
 
-  if (r != KERN_SUCCESS)
-    return r;
+  if (scratch_)
+    mach_vm_deallocate(mach_task_self(), scratch_, scratch_size_);
+  scratch_ = 0;
+  scratch_size_ = 0;
 
-  bytes.resize(length);
-  memcpy(&bytes[0],
-         &local_start[(mach_vm_address_t)address - page_address],
-         length);
-  mach_vm_deallocate(mach_task_self(), (uintptr_t)local_start, local_length);
-  return KERN_SUCCESS;
+  const mach_vm_size_t page_size = getpagesize();
+  const mach_vm_size_t new_size = (size + page_size - 1) & ~(page_size - 1);
+  if (mach_vm_allocate(mach_task_self(), &scratch_, new_size,
+                       VM_FLAGS_ANYWHERE) != KERN_SUCCESS) {
+    scratch_ = 0;
+    return false;
+  }
+  scratch_size_ = new_size;
+  return true;
+}
+
+const uint8_t* TaskMemoryReader::Read(uint64_t address, size_t length) {
+  if (length == 0 || !Reserve(length))
+    return NULL;
+
+  mach_vm_size_t bytes_read = 0;
+  if (mach_vm_read_overwrite(task_, address, length, scratch_,
+                             &bytes_read) != KERN_SUCCESS ||
+      bytes_read != length) {
+    return NULL;
+  }
+  return reinterpret_cast<const uint8_t*>(scratch_);
+}
+
+static bool RangeAddressLess(const TaskMemoryReader::Range* a,
+                             const TaskMemoryReader::Range* b) {
+  return a->address < b->address;
+}
+
+void TaskMemoryReader::ReadRanges(Range* ranges, size_t count) {
+  // Visit the ranges in address order, leaving |ranges| as it is.
+  vector<Range*> sorted(count);
+  for (size_t i = 0; i < count; ++i)
+    sorted[i] = &ranges[i];
+  std::sort(sorted.begin(), sorted.end(), RangeAddressLess);
+
+  size_t first = 0;
+  while (first < count) {
+    // Gather the ranges that can be read along with sorted[first].
+    const uint64_t start = sorted[first]->address;
+    uint64_t end = start + sorted[first]->length;
+    size_t last = first + 1;
+    while (last < count && sorted[last]->address <= end + kMaxGap) {
+      const uint64_t range_end = sorted[last]->address + sorted[last]->length;
+      const uint64_t new_end = std::max(end, range_end);
+      if (new_end - start > kMaxSpan)
+        break;
+      end = new_end;
+      ++last;
+    }
+
+    const uint8_t* span = last - first > 1 ? Read(start, end - start) : NULL;
+    for (size_t i = first; i < last; ++i) {
+      Range* range = sorted[i];
+      const uint8_t* bytes = span ? span + (range->address - start) :
+                                    Read(range->address, range->length);
+      range->ok = bytes != NULL;
+      if (bytes)
+        memcpy(range->dest, bytes, range->length);
+    }
+    first = last;
+  }
+}
+
+static bool StringAddressLess(const std::pair<uint64_t, size_t>& a,
+                              const std::pair<uint64_t, size_t>& b) {
+  return a.first < b.first;
+}
+
+void TaskMemoryReader::ReadStrings(const uint64_t* addresses, size_t count,
+                                   vector<string>& strings) {
+  strings.assign(count, string());
+
+  // The addresses in order, with the index of each in |addresses|.
+  vector<std::pair<uint64_t, size_t> > sorted;
+  sorted.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    if (addresses[i])
+      sorted.push_back(std::make_pair(addresses[i], i));
+  }
+  std::sort(sorted.begin(), sorted.end(), StringAddressLess);
+
+  size_t first = 0;
+  while (first < sorted.size()) {
+    // Like ReadTaskString, read no further than kMaxStringLength bytes
+    // past a string, nor past the end of the region it's in (or of the
+    // region after that).
+    const uint64_t start = sorted[first].first;
+    mach_vm_size_t size_to_end;
+    GetMemoryRegionSize(task_, start, &size_to_end);
+    if (size_to_end == 0) {
+      ++first;
+      continue;
+    }
+    const uint64_t region_end = start + size_to_end;
+    size_t last = first + 1;
+    while (last < sorted.size() &&
+           sorted[last].first < region_end &&
+           sorted[last].first - sorted[last - 1].first <= kMaxStringLength &&
+           sorted[last].first - start < kMaxSpan) {
+      ++last;
+    }
+    const uint64_t end =
+        std::min<uint64_t>(sorted[last - 1].first + kMaxStringLength,
+                           region_end);
+
+    const uint8_t* span = Read(start, end - start);
+    for (size_t i = first; i < last; ++i) {
+      const uint64_t address = sorted[i].first;
+      if (!span) {
+        strings[sorted[i].second] = ReadTaskString(task_, address);
+        continue;
+      }
+      const char* string_start =
+          reinterpret_cast<const char*>(span + (address - start));
+      const size_t max_length =
+          std::min<uint64_t>(end - address, kMaxStringLength);
+      strings[sorted[i].second].assign(string_start,
+                                       strnlen(string_start, max_length));
+    }
+    first = last;
+  }
 }
 
 #pragma mark -
@@ -334,6 +471,50 @@ uint32_t DynamicImage::GetFileType() {
   return GetFileTypeFromHeader<MachO32>(*this);
 }
 
+//==============================================================================
+// Returns the offset of the UUID in the |header_size| bytes of mach_header
+// and load commands at |header_bytes|, or 0 if there's no LC_UUID command.
+template<typename MachBits>
+static size_t FindUUIDOffset(const uint8_t* header_bytes, size_t header_size) {
+  typedef typename MachBits::mach_header_type mach_header_type;
+
+  if (header_size < sizeof(mach_header_type))
+    return 0;
+  const mach_header_type* header =
+      reinterpret_cast<const mach_header_type*>(header_bytes);
+  if (header->magic != MachBits::magic)
+    return 0;
+
+  size_t offset = sizeof(mach_header_type);
+  for (uint32_t i = 0; i < header->ncmds; ++i) {
+    if (header_size - offset < sizeof(struct load_command))
+      break;
+    const struct load_command* cmd =
+        reinterpret_cast<const struct load_command*>(header_bytes + offset);
+    if (cmd->cmdsize < sizeof(struct load_command) ||
+        cmd->cmdsize > header_size - offset)
+      break;
+    if (cmd->cmd == LC_UUID) {
+      if (cmd->cmdsize < sizeof(struct uuid_command))
+        return 0;
+      return offset + offsetof(struct uuid_command, uuid);
+    }
+    offset += cmd->cmdsize;
+  }
+  return 0;
+}
+
+bool DynamicImage::GetUUID(uint8_t uuid[16]) {
+  const size_t offset = Is64Bit() ?
+      FindUUIDOffset<MachO64>(&header_[0], header_.size()) :
+      FindUUIDOffset<MachO32>(&header_[0], header_.size());
+  if (offset == 0)
+    return false;
+
+  memcpy(uuid, &header_[offset], 16);
+  return true;
+}
+
 #pragma mark -
 
 //==============================================================================
@@ -408,6 +589,104 @@ uint64_t DynamicImages::GetDyldAllImageInfosPointer() {
   }
 }
 
+//==============================================================================
+// Headers of images seen by earlier calls to ReadImageInfo, so that a
+// process writing many dumps doesn't read the load commands of the same
+// system libraries each time. Most images are in the dyld shared cache,
+// which is mapped at the same address in every process. An entry is only
+// used once the image's mach_header and UUID have been read again from the
+// task and found to match, so a stale entry costs a read, never a wrong
+// header.
+namespace {
+
+struct CachedImageKey {
+  uint64_t load_address;
+  uint64_t mod_date;
+  string file_path;
+
+  bool operator<(const CachedImageKey& other) const {
+    if (load_address != other.load_address)
+      return load_address < other.load_address;
+    if (mod_date != other.mod_date)
+      return mod_date < other.mod_date;
+    return file_path < other.file_path;
+  }
+};
+
+struct CachedImage {
+  vector<uint8_t> header;  // mach_header plus load commands
+  size_t uuid_offset;      // offset of the LC_UUID uuid in |header|
+};
+
+typedef std::map<CachedImageKey, CachedImage> ImageCache;
+
+// The cache is dropped rather than trimmed when it grows past this.
+const size_t kMaxCachedImages = 8192;
+
+pthread_mutex_t g_image_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+ImageCache* g_image_cache = NULL;
+
+bool LookupCachedImage(const CachedImageKey& key, CachedImage* image) {
+  bool found = false;
+  pthread_mutex_lock(&g_image_cache_lock);
+  if (g_image_cache) {
+    ImageCache::const_iterator it = g_image_cache->find(key);
+    if (it != g_image_cache->end()) {
+      *image = it->second;
+      found = true;
+    }
+  }
+  pthread_mutex_unlock(&g_image_cache_lock);
+  return found;
+}
+
+void AddCachedImage(const CachedImageKey& key, const CachedImage& image) {
+  pthread_mutex_lock(&g_image_cache_lock);
+  if (!g_image_cache)
+    g_image_cache = new ImageCache;
+  if (g_image_cache->size() >= kMaxCachedImages)
+    g_image_cache->clear();
+  (*g_image_cache)[key] = image;
+  pthread_mutex_unlock(&g_image_cache_lock);
+}
+
+// The image lists saved by DynamicImages::SaveImageTable, by pid.
+struct SavedImage {
+  vector<uint8_t> header;  // mach_header plus load commands
+  uint64_t load_address;
+  string file_path;
+  uint64_t mod_date;
+};
+
+struct SavedImageTable {
+  uint64_t start_time;
+  uint64_t info_array;
+  uint32_t info_array_count;
+  uint64_t change_timestamp;
+  vector<SavedImage> images;
+};
+
+typedef std::map<pid_t, SavedImageTable> ImageTables;
+
+// As with the image cache, the tables are dropped when there are too many.
+const size_t kMaxImageTables = 64;
+
+pthread_mutex_t g_image_tables_lock = PTHREAD_MUTEX_INITIALIZER;
+ImageTables* g_image_tables = NULL;
+
+// Returns when |pid| started, in microseconds since the epoch, or 0.
+uint64_t GetProcessStartTime(pid_t pid) {
+  int mib[4] = { CTL_KERN, KERN_PROC, KERN_PROC_PID, pid };
+  struct kinfo_proc info;
+  size_t size = sizeof(info);
+  if (sysctl(mib, 4, &info, &size, NULL, 0) != 0 || size == 0)
+    return 0;
+  const struct timeval& start = info.kp_proc.p_starttime;
+  return static_cast<uint64_t>(start.tv_sec) * 1000000 + start.tv_usec;
+}
+
+}  // namespace
+
 //==============================================================================
 // This code was written using dyld_debug.c (from Darwin) as a guide.
 
@@ -417,6 +696,7 @@ void ReadImageInfo(DynamicImages& images,
   typedef typename MachBits::dyld_image_info dyld_image_info;
   typedef typename MachBits::dyld_all_image_infos dyld_all_image_infos;
   typedef typename MachBits::mach_header_type mach_header_type;
+  typedef TaskMemoryReader::Range Range;
 
   // Read the structure inside of dyld that contains information about
   // loaded images.  We're reading from the desired task's address space.
@@ -428,14 +708,41 @@ void ReadImageInfo(DynamicImages& images,
   if (ReadTaskMemory(images.task_,
                      image_list_address,
                      sizeof(dyld_all_image_infos),
-                     dyld_all_info_bytes) != KERN_SUCCESS)
-    return;
+                     dyld_all_info_bytes) != KERN_SUCCESS) {
+    // An older dyld's structure is shorter, and may end where the memory
+    // does. Fall back to the fields every version has, and zero the rest.
+    if (ReadTaskMemory(images.task_,
+                       image_list_address,
+                       offsetof(dyld_all_image_infos, libSystemInitialized),
+                       dyld_all_info_bytes) != KERN_SUCCESS)
+      return;
+    dyld_all_info_bytes.resize(sizeof(dyld_all_image_infos));
+  }
 
   dyld_all_image_infos* dyldInfo =
     reinterpret_cast<dyld_all_image_infos*>(&dyld_all_info_bytes[0]);
 
   // number of loaded images
   int count = dyldInfo->infoArrayCount;
+  if (count <= 0)
+    return;
+
+  // If this process has been seen before and dyld hasn't changed its image
+  // list since, reuse the images found then. dyld sets infoArray to NULL
+  // while it changes the list, so a list caught mid-change is never saved.
+  DynamicImages::ImageListStamp stamp = {};
+  bool have_stamp = false;
+  if (dyldInfo->version >= 15 && dyldInfo->infoArrayChangeTimestamp &&
+      dyldInfo->infoArray &&
+      pid_for_task(images.task_, &stamp.pid) == KERN_SUCCESS) {
+    stamp.start_time = GetProcessStartTime(stamp.pid);
+    stamp.info_array = dyldInfo->infoArray;
+    stamp.info_array_count = dyldInfo->infoArrayCount;
+    stamp.change_timestamp = dyldInfo->infoArrayChangeTimestamp;
+    have_stamp = stamp.start_time != 0;
+  }
+  if (have_stamp && images.LoadImageTable(stamp))
+    return;
 
   // Read an array of dyld_image_info structures each containing
   // information about a loaded image.
@@ -450,51 +757,123 @@ void ReadImageInfo(DynamicImages& images,
         reinterpret_cast<dyld_image_info*>(&dyld_info_array_bytes[0]);
     images.image_list_.reserve(count);
 
+    TaskMemoryReader reader(images.task_);
+
+    // Read the file names from the task's memory space. dyld keeps most of
+    // them side by side, so this takes far fewer reads than there are names.
+    vector<uint64_t> file_path_addresses(count);
+    for (int i = 0; i < count; ++i)
+      file_path_addresses[i] = infoArray[i].file_path_;
+    vector<string> file_paths;
+    reader.ReadStrings(&file_path_addresses[0], count, file_paths);
+
+    // Queue one read per image: for a cached image, its mach_header and
+    // UUID, to check that the cached header is still right; otherwise, the
+    // rest of the page the image starts on, which nearly always holds all
+    // of the load commands.
+    const size_t page_size = getpagesize();
+    vector<CachedImageKey> keys(count);
+    vector<CachedImage> cached(count);
+    vector<bool> is_cached(count);
+    vector<vector<uint8_t> > headers(count);
+    vector<uint8_t> uuids(count * 16);
+    vector<Range> ranges;
+    ranges.reserve(count * 2);
+    for (int i = 0; i < count; ++i) {
+      const uint64_t load_address = infoArray[i].load_address_;
+      keys[i].load_address = load_address;
+      keys[i].mod_date = infoArray[i].file_mod_date_;
+      keys[i].file_path = file_paths[i];
+      is_cached[i] = LookupCachedImage(keys[i], &cached[i]);
+
+      size_t first_read = sizeof(mach_header_type);
+      if (!is_cached[i]) {
+        first_read = page_size - (load_address & (page_size - 1));
+        if (first_read < sizeof(mach_header_type))
+          first_read += page_size;
+      }
+      headers[i].resize(first_read);
+      Range header_range = { load_address, first_read, &headers[i][0], false };
+      ranges.push_back(header_range);
+      if (is_cached[i]) {
+        Range uuid_range = { load_address + cached[i].uuid_offset, 16,
+                             &uuids[i * 16], false };
+        ranges.push_back(uuid_range);
+      }
+    }
+    reader.ReadRanges(&ranges[0], ranges.size());
+
+    size_t range_index = 0;
     for (int i = 0; i < count; ++i) {
       dyld_image_info& info = infoArray[i];
+      const Range& header_range = ranges[range_index++];
+      const Range* uuid_range = is_cached[i] ? &ranges[range_index++] : NULL;
+
+      vector<uint8_t>& mach_header_bytes = headers[i];
+      bool cache_hit = false;
+      if (is_cached[i]) {
+        const vector<uint8_t>& cached_header = cached[i].header;
+        cache_hit = header_range.ok && uuid_range->ok &&
+            memcmp(&mach_header_bytes[0], &cached_header[0],
+                   sizeof(mach_header_type)) == 0 &&
+            memcmp(&uuids[i * 16], &cached_header[cached[i].uuid_offset],
+                   16) == 0;
+        if (cache_hit)
+          mach_header_bytes = cached_header;
+      }
 
-      // First read just the mach_header from the image in the task.
-      vector<uint8_t> mach_header_bytes;
-      if (ReadTaskMemory(images.task_,
-                         info.load_address_,
-                         sizeof(mach_header_type),
-                         mach_header_bytes) != KERN_SUCCESS)
-        continue;  // bail on this dynamic image
-
-      mach_header_type* header =
-          reinterpret_cast<mach_header_type*>(&mach_header_bytes[0]);
-
-      // Now determine the total amount necessary to read the header
-      // plus all of the load commands.
-      size_t header_size =
-          sizeof(mach_header_type) + header->sizeofcmds;
-
-      if (ReadTaskMemory(images.task_,
-                         info.load_address_,
-                         header_size,
-                         mach_header_bytes) != KERN_SUCCESS)
-        continue;
+      if (!cache_hit) {
+        // The first read failed (say the image starts on the last readable
+        // page and the rest of that page isn't mapped), or the cached header
+        // is stale; start again with just the mach_header.
+        if (!header_range.ok || is_cached[i]) {
+          if (ReadTaskMemory(images.task_,
+                             info.load_address_,
+                             sizeof(mach_header_type),
+                             mach_header_bytes) != KERN_SUCCESS)
+            continue;  // bail on this dynamic image
+        }
 
-      // Read the file name from the task's memory space.
-      string file_path;
-      if (info.file_path_) {
-        // Although we're reading kMaxStringLength bytes, it's copied in the
-        // the DynamicImage constructor below with the correct string length,
-        // so it's not really wasting memory.
-        file_path = ReadTaskString(images.task_, info.file_path_);
+        mach_header_type* header =
+            reinterpret_cast<mach_header_type*>(&mach_header_bytes[0]);
+
+        // Now determine the total amount necessary to read the header
+        // plus all of the load commands.
+        size_t header_size =
+            sizeof(mach_header_type) + header->sizeofcmds;
+
+        if (header_size <= mach_header_bytes.size()) {
+          mach_header_bytes.resize(header_size);
+        } else if (ReadTaskMemory(images.task_,
+                                  info.load_address_,
+                                  header_size,
+                                  mach_header_bytes) != KERN_SUCCESS) {
+          continue;
+        }
       }
 
       // Create an object representing this image and add it to our list.
       DynamicImage* new_image;
       new_image = new DynamicImage(&mach_header_bytes[0],
-                                   header_size,
+                                   mach_header_bytes.size(),
                                    info.load_address_,
-                                   file_path,
+                                   file_paths[i],
                                    static_cast<uintptr_t>(info.file_mod_date_),
                                    images.task_,
                                    images.cpu_type_);
 
       if (new_image->IsValid()) {
+        if (!cache_hit) {
+          const size_t uuid_offset =
+              FindUUIDOffset<MachBits>(&mach_header_bytes[0],
+                                       mach_header_bytes.size());
+          if (uuid_offset) {
+            CachedImage entry;
+            entry.header.swap(mach_header_bytes);
+            entry.uuid_offset = uuid_offset;
+            AddCachedImage(keys[i], entry);
+          }
+        }
         images.image_list_.push_back(DynamicImageRef(new_image));
       } else {
         delete new_image;
@@ -511,6 +890,89 @@ void ReadImageInfo(DynamicImages& images,
     vector<DynamicImageRef>::iterator it = unique(images.image_list_.begin(),
                                                   images.image_list_.end());
     images.image_list_.erase(it, images.image_list_.end());
+
+    if (have_stamp)
+      images.SaveImageTable(stamp);
+}
+
+bool DynamicImages::ImageListStamp::operator==(
+    const ImageListStamp& other) const {
+  return pid == other.pid &&
+      start_time == other.start_time &&
+      info_array == other.info_array &&
+      info_array_count == other.info_array_count &&
+      change_timestamp == other.change_timestamp;
+}
+
+bool DynamicImages::LoadImageTable(const ImageListStamp& stamp) {
+  // Copy the table out, so as not to hold the lock while building images.
+  SavedImageTable table;
+  bool found = false;
+  pthread_mutex_lock(&g_image_tables_lock);
+  if (g_image_tables) {
+    ImageTables::iterator it = g_image_tables->find(stamp.pid);
+    if (it != g_image_tables->end()) {
+      ImageListStamp saved_stamp = { stamp.pid,
+                                     it->second.start_time,
+                                     it->second.info_array,
+                                     it->second.info_array_count,
+                                     it->second.change_timestamp };
+      if (saved_stamp == stamp) {
+        table.images = it->second.images;
+        found = true;
+      }
+    }
+  }
+  pthread_mutex_unlock(&g_image_tables_lock);
+  if (!found)
+    return false;
+
+  // The saved images are already sorted and free of duplicates.
+  image_list_.reserve(table.images.size());
+  for (size_t i = 0; i < table.images.size(); ++i) {
+    SavedImage& saved = table.images[i];
+    image_list_.push_back(DynamicImageRef(
+        new DynamicImage(&saved.header[0],
+                         saved.header.size(),
+                         saved.load_address,
+                         saved.file_path,
+                         static_cast<uintptr_t>(saved.mod_date),
+                         task_,
+                         cpu_type_)));
+  }
+  return true;
+}
+
+void DynamicImages::SaveImageTable(const ImageListStamp& stamp) {
+  SavedImageTable table;
+  table.start_time = stamp.start_time;
+  table.info_array = stamp.info_array;
+  table.info_array_count = stamp.info_array_count;
+  table.change_timestamp = stamp.change_timestamp;
+  table.images.resize(image_list_.size());
+  for (size_t i = 0; i < image_list_.size(); ++i) {
+    DynamicImage* image = image_list_[i];
+    SavedImage& saved = table.images[i];
+    saved.header = image->header_;
+    saved.load_address = image->load_address_;
+    saved.file_path = image->file_path_;
+    saved.mod_date = image->file_mod_date_;
+  }
+
+  pthread_mutex_lock(&g_image_tables_lock);
+  if (!g_image_tables)
+    g_image_tables = new ImageTables;
+  if (g_image_tables->size() >= kMaxImageTables &&
+      g_image_tables->find(stamp.pid) == g_image_tables->end()) {
+    g_image_tables->clear();
+  }
+  SavedImageTable& saved_table = (*g_image_tables)[stamp.pid];
+  saved_table.start_time = table.start_time;
+  saved_table.info_array = table.info_array;
+  saved_table.info_array_count = table.info_array_count;
+  saved_table.change_timestamp = table.change_timestamp;
+  saved_table.images.swap(table.images);
+  pthread_mutex_unlock(&g_image_tables_lock);
 }
 
 void DynamicImages::ReadImageInfoForTask() {
@@ -70,12 +70,34 @@ typedef struct dyld_image_info64 {
 // This is as defined in "dyld_gdb.h" in the darwin source.
 // _dyld_all_image_infos (in dyld) is a structure of this type
 // which will be used to determine which dynamic code has been loaded.
+// Fields after processDetachedFromSharedRegion are only valid when version
+// is high enough; infoArrayChangeTimestamp needs version 15 (Mac OS X 10.12).
 typedef struct dyld_all_image_infos32 {
   uint32_t                      version;  // == 1 in Mac OS X 10.4
   uint32_t                      infoArrayCount;
   uint32_t                      infoArray;  // const struct dyld_image_info*
   uint32_t                      notification;
   bool                          processDetachedFromSharedRegion;
+  bool                          libSystemInitialized;
+  uint32_t                      dyldImageLoadAddress;
+  uint32_t                      jitInfo;
+  uint32_t                      dyldVersion;
+  uint32_t                      errorMessage;
+  uint32_t                      terminationFlags;
+  uint32_t                      coreSymbolicationShmPage;
+  uint32_t                      systemOrderFlag;
+  uint32_t                      uuidArrayCount;
+  uint32_t                      uuidArray;
+  uint32_t                      dyldAllImageInfosAddress;
+  uint32_t                      initialImageCount;
+  uint32_t                      errorKind;
+  uint32_t                      errorClientOfDylibPath;
+  uint32_t                      errorTargetDylibPath;
+  uint32_t                      errorSymbol;
+  uint32_t                      sharedCacheSlide;
+  uint8_t                       sharedCacheUUID[16];
+  uint32_t                      sharedCacheBaseAddress;
+  uint64_t                      infoArrayChangeTimestamp;
 } dyld_all_image_infos32;
 
 typedef struct dyld_all_image_infos64 {
@@ -84,6 +106,26 @@ typedef struct dyld_all_image_infos64 {
   uint64_t                      infoArray;  // const struct dyld_image_info*
   uint64_t                      notification;
   bool                          processDetachedFromSharedRegion;
+  bool                          libSystemInitialized;
+  uint64_t                      dyldImageLoadAddress;
+  uint64_t                      jitInfo;
+  uint64_t                      dyldVersion;
+  uint64_t                      errorMessage;
+  uint64_t                      terminationFlags;
+  uint64_t                      coreSymbolicationShmPage;
+  uint64_t                      systemOrderFlag;
+  uint64_t                      uuidArrayCount;
+  uint64_t                      uuidArray;
+  uint64_t                      dyldAllImageInfosAddress;
+  uint64_t                      initialImageCount;
+  uint64_t                      errorKind;
+  uint64_t                      errorClientOfDylibPath;
+  uint64_t                      errorTargetDylibPath;
+  uint64_t                      errorSymbol;
+  uint64_t                      sharedCacheSlide;
+  uint8_t                       sharedCacheUUID[16];
+  uint64_t                      sharedCacheBaseAddress;
+  uint64_t                      infoArrayChangeTimestamp;
 } dyld_all_image_infos64;
 
 // some typedefs to isolate 64/32 bit differences
@@ -161,6 +203,11 @@ class DynamicImage {
   bool Is64Bit() { return (GetCPUType() & CPU_ARCH_ABI64) == CPU_ARCH_ABI64; }
 
   uint32_t GetVersion() {return version_;}
+
+  // Copy the UUID from the image's LC_UUID load command to |uuid| and
+  // return true, or return false if it has none.
+  bool GetUUID(uint8_t uuid[16]);
+
   // For sorting
   bool operator<(const DynamicImage& inInfo) {
     return GetLoadAddress() < inInfo.GetLoadAddress();
@@ -302,6 +349,28 @@ class DynamicImages {
   void ReadImageInfoForTask();
   uint64_t GetDyldAllImageInfosPointer();
 
+  // The state of a process's dyld image list as far as it can be told from
+  // dyld_all_image_infos, without reading the list itself. dyld updates
+  // infoArrayChangeTimestamp whenever it adds or removes an image.
+  struct ImageListStamp {
+    pid_t pid;
+    uint64_t start_time;  // of the process, to tell a reused pid apart
+    uint64_t info_array;
+    uint32_t info_array_count;
+    uint64_t change_timestamp;
+
+    bool operator==(const ImageListStamp& other) const;
+  };
+
+  // Fills image_list_ from the images saved by an earlier DynamicImages for
+  // the same process, if its image list hasn't changed since, and returns
+  // whether it did. This spares all of the reads of the image list and the
+  // images' headers when one process is dumped repeatedly.
+  bool LoadImageTable(const ImageListStamp& stamp);
+
+  // Saves image_list_ for LoadImageTable.
+  void SaveImageTable(const ImageListStamp& stamp);
+
   mach_port_t              task_;
   cpu_type_t               cpu_type_;  // CPU type of task_
   vector<DynamicImageRef>  image_list_;
@@ -314,6 +383,55 @@ kern_return_t ReadTaskMemory(task_port_t target_task,
                              size_t length,
                              vector<uint8_t>& bytes);
 
+//==============================================================================
+// Reads memory from another task without mapping a new VM region for each
+// read, as mach_vm_read() does: every read is copied into one scratch
+// buffer with mach_vm_read_overwrite(), and ranges that lie close together
+// are read with a single call.
+class TaskMemoryReader {
+ public:
+  explicit TaskMemoryReader(task_port_t task);
+  ~TaskMemoryReader();
+
+  // |length| bytes at |address| in the task, to be copied to |dest|. |ok|
+  // is set to whether they could be read.
+  struct Range {
+    uint64_t address;
+    size_t length;
+    uint8_t* dest;
+    bool ok;
+  };
+
+  // Returns the |length| bytes at |address|, or NULL if they can't all be
+  // read. The bytes are valid until the next call to this reader.
+  const uint8_t* Read(uint64_t address, size_t length);
+
+  // Reads each of the |count| |ranges|. Ranges less than kMaxGap bytes
+  // apart are read together, up to kMaxSpan bytes at a time; if such a read
+  // fails, its ranges are read one at a time.
+  void ReadRanges(Range* ranges, size_t count);
+
+  // Sets |strings| to the NUL-terminated strings at each of the |count|
+  // |addresses|, reading strings that lie close together at once. A zero
+  // address, or one that can't be read, gives an empty string.
+  void ReadStrings(const uint64_t* addresses, size_t count,
+                   vector<string>& strings);
+
+  static const size_t kMaxGap = 16 * 1024;
+  static const size_t kMaxSpan = 1024 * 1024;
+
+ private:
+  TaskMemoryReader(const TaskMemoryReader&);
+  TaskMemoryReader& operator=(const TaskMemoryReader&);
+
+  // Makes the scratch buffer at least |size| bytes long.
+  bool Reserve(size_t size);
+
+  task_port_t task_;
+  mach_vm_address_t scratch_;
+  mach_vm_size_t scratch_size_;
+};
+
 }   // namespace google_breakpad
 
 #endif // CLIENT_MAC_HANDLER_DYNAMIC_IMAGES_H__
@@ -240,6 +240,11 @@ ExceptionHandler::ExceptionHandler(const string& dump_path,
       installed_exception_handler_(false),
       is_in_teardown_(false),
       last_minidump_write_result_(false),
+      suspend_begin_(0),
+      suspend_end_(0),
+      suspended_thread_count_(0),
+      crash_signature_frames_(0),
+      crash_signature_(0),
       use_minidump_write_mutex_(false) {
   // This will update to the ID and C-string pointers
   set_dump_path(dump_path);
@@ -267,6 +272,11 @@ ExceptionHandler::ExceptionHandler(DirectCallback callback,
       installed_exception_handler_(false),
       is_in_teardown_(false),
       last_minidump_write_result_(false),
+      suspend_begin_(0),
+      suspend_end_(0),
+      suspended_thread_count_(0),
+      crash_signature_frames_(0),
+      crash_signature_(0),
       use_minidump_write_mutex_(false) {
   MinidumpGenerator::GatherSystemInformation();
   Setup(install_handler);
@@ -400,6 +410,10 @@ bool ExceptionHandler::WriteMinidumpWithException(
                            report_current_thread ? MACH_PORT_NULL :
                                                    mach_thread_self());
       md.SetTaskContext(task_context);
+      if (suspend_end_) {
+        md.timing()->Add(MD_DUMP_PHASE_THREAD_SUSPEND, suspend_begin_,
+                         suspend_end_, suspended_thread_count_);
+      }
       if (exception_type && exception_code) {
         // If this is a real exception, give the filter (if any) a chance to
         // decide if this should be sent.
@@ -410,7 +424,9 @@ bool ExceptionHandler::WriteMinidumpWithException(
                                    exception_subcode, thread_name);
       }
 
+      md.set_crash_signature_frames(crash_signature_frames_);
       result = md.Write(next_minidump_path_c_);
+      crash_signature_ = md.crash_signature();
     }
 
     // Call user specified callback (if any)
@@ -828,6 +844,7 @@ bool ExceptionHandler::SuspendThreads() {
   thread_act_port_array_t   threads_for_task;
   mach_msg_type_number_t    thread_count;
 
+  suspend_begin_ = DumpTiming::Now();
   if (task_threads(mach_task_self(), &threads_for_task, &thread_count))
     return false;
 
@@ -839,6 +856,8 @@ bool ExceptionHandler::SuspendThreads() {
     }
   }
 
+  suspend_end_ = DumpTiming::Now();
+  suspended_thread_count_ = thread_count - 1;
   return true;
 }
 
@@ -846,6 +865,8 @@ bool ExceptionHandler::ResumeThreads() {
   thread_act_port_array_t   threads_for_task;
   mach_msg_type_number_t    thread_count;
 
+  suspend_end_ = 0;
+
   if (task_threads(mach_task_self(), &threads_for_task, &thread_count))
     return false;
 
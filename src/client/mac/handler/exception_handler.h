@@ -154,6 +154,17 @@ class ExceptionHandler {
                                     MinidumpCallback callback,
                                     void* callback_context);
 
+  // How many frames, counting the one that crashed, go into the crash
+  // signature written to in-process dumps of exceptions.  0, the default,
+  // writes no signature.
+  void set_crash_signature_frames(int frames) {
+    crash_signature_frames_ = frames;
+  }
+
+  // The crash signature of the last dump written, or 0 if it had none.
+  // The minidump callback may pass it on to an uploader.
+  uint64_t crash_signature() const { return crash_signature_; }
+
   // Returns whether out-of-process dump generation is used or not.
   bool IsOutOfProcess() const {
 #if TARGET_OS_IPHONE
@@ -258,6 +269,17 @@ class ExceptionHandler {
   // Save the last result of the last minidump
   bool last_minidump_write_result_;
 
+  // When SuspendThreads() last began and finished, as DumpTiming::Now()
+  // times, and how many threads it suspended.  suspend_end_ is zero while
+  // the threads are not suspended.
+  uint64_t suspend_begin_;
+  uint64_t suspend_end_;
+  uint32_t suspended_thread_count_;
+
+  // The number of frames to sign dumps with, and the last signature.
+  int crash_signature_frames_;
+  uint64_t crash_signature_;
+
   // A mutex for use when writing out a minidump that was requested on a
   // thread other than the exception handler.
   pthread_mutex_t minidump_write_mutex_;
@@ -85,6 +85,8 @@ MinidumpGenerator::MinidumpGenerator()
       cpu_type_(DynamicImages::GetNativeCPUType()),
       task_context_(NULL),
       dynamic_images_(NULL),
+      task_reader_(NULL),
+      crash_signature_frames_(0),
       memory_blocks_(&allocator_) {
   GatherSystemInformation();
 }
@@ -103,10 +105,15 @@ MinidumpGenerator::MinidumpGenerator(mach_port_t crashing_task,
       cpu_type_(DynamicImages::GetNativeCPUType()),
       task_context_(NULL),
       dynamic_images_(NULL),
+      task_reader_(NULL),
+      crash_signature_frames_(0),
       memory_blocks_(&allocator_) {
   if (crashing_task != mach_task_self()) {
+    timing_.Begin(MD_DUMP_PHASE_MAPPING_ENUMERATION);
     dynamic_images_ = new DynamicImages(crashing_task_);
+    timing_.End(MD_DUMP_PHASE_MAPPING_ENUMERATION);
     cpu_type_ = dynamic_images_->GetCPUType();
+    task_reader_ = new TaskMemoryReader(crashing_task_);
   } else {
     dynamic_images_ = NULL;
     cpu_type_ = DynamicImages::GetNativeCPUType();
@@ -117,6 +124,7 @@ MinidumpGenerator::MinidumpGenerator(mach_port_t crashing_task,
 
 MinidumpGenerator::~MinidumpGenerator() {
   delete dynamic_images_;
+  delete task_reader_;
 }
 
 char MinidumpGenerator::build_string_[16];
@@ -240,42 +248,80 @@ bool MinidumpGenerator::Write(const char* path) {
   };
   bool result = false;
 
+  timing_.Begin(MD_DUMP_PHASE_TOTAL);
+
   // If opening was successful, create the header, directory, and call each
   // writer.  The destructor for the TypedMDRVAs will cause the data to be
-  // flushed.  The destructor for the MinidumpFileWriter will close the file.
+  // copied, and Flush() writes it to the file.  The destructor for the
+  // MinidumpFileWriter will close the file.
   if (writer_.Open(path)) {
-    TypedMDRVA<MDRawHeader> header(&writer_);
-    TypedMDRVA<MDRawDirectory> dir(&writer_);
+    {
+      TypedMDRVA<MDRawHeader> header(&writer_);
+      TypedMDRVA<MDRawDirectory> dir(&writer_);
 
-    if (!header.Allocate())
-      return false;
+      if (!header.Allocate())
+        return false;
 
-    int writer_count = static_cast<int>(sizeof(writers) / sizeof(writers[0]));
+      int writer_count = static_cast<int>(sizeof(writers) / sizeof(writers[0]));
 
-    // If we don't have exception information, don't write out the
-    // exception stream
-    if (!exception_thread_ && !exception_type_)
-      --writer_count;
+      // If we don't have exception information, don't write out the
+      // exception stream
+      if (!exception_thread_ && !exception_type_)
+        --writer_count;
 
-    // Add space for all writers
-    if (!dir.AllocateArray(writer_count))
-      return false;
+      // Sign exceptions in this process before writing anything else.
+      if (crash_signature_frames_ > 0 && exception_thread_ &&
+          exception_type_ && crashing_task_ == mach_task_self()) {
+        ComputeCrashSignature();
+      }
+      const int signature_count = crash_signature_.frame_count() ? 1 : 0;
+
+      // Add space for all writers, and for the signature and timing streams
+      // that follow them.
+      if (!dir.AllocateArray(writer_count + signature_count + 1))
+        return false;
 
-    MDRawHeader* header_ptr = header.get();
-    header_ptr->signature = MD_HEADER_SIGNATURE;
-    header_ptr->version = MD_HEADER_VERSION;
-    time(reinterpret_cast<time_t*>(&(header_ptr->time_date_stamp)));
-    header_ptr->stream_count = writer_count;
-    header_ptr->stream_directory_rva = dir.position();
+      MDRawHeader* header_ptr = header.get();
+      header_ptr->signature = MD_HEADER_SIGNATURE;
+      header_ptr->version = MD_HEADER_VERSION;
+      time(reinterpret_cast<time_t*>(&(header_ptr->time_date_stamp)));
+      header_ptr->stream_count = writer_count + signature_count + 1;
+      header_ptr->stream_directory_rva = dir.position();
 
-    MDRawDirectory local_dir;
-    result = true;
-    for (int i = 0; (result) && (i < writer_count); ++i) {
-      result = (this->*writers[i])(&local_dir);
+      MDRawDirectory local_dir;
+      result = true;
+      for (int i = 0; (result) && (i < writer_count); ++i) {
+        result = (this->*writers[i])(&local_dir);
 
-      if (result)
-        dir.CopyIndex(i, &local_dir);
+        if (result)
+          dir.CopyIndex(i, &local_dir);
+      }
+
+      if (result && signature_count) {
+        result = WriteCrashSignatureStream(&local_dir);
+        if (result)
+          dir.CopyIndex(writer_count, &local_dir);
+      }
+
+      // Write out the streams so far, so that the timing stream can tell
+      // how long that took.
+      if (result) {
+        timing_.Begin(MD_DUMP_PHASE_WRITE_FLUSH);
+        result = writer_.Flush();
+        timing_.End(MD_DUMP_PHASE_WRITE_FLUSH, 0, writer_.position());
+      }
+
+      if (result) {
+        result = WriteDumpTimingStream(&local_dir,
+                                       writer_count + signature_count);
+        if (result)
+          dir.CopyIndex(writer_count + signature_count, &local_dir);
+      }
     }
+
+    // The header and directory have been copied, so write everything out.
+    if (!writer_.Flush())
+      result = false;
   }
   return result;
 }
@@ -367,15 +413,11 @@ bool MinidumpGenerator::WriteStackFromStartAddress(
       return false;
 
     if (dynamic_images_) {
-      vector<uint8_t> stack_memory;
-      if (ReadTaskMemory(crashing_task_,
-                         start_addr,
-                         size,
-                         stack_memory) != KERN_SUCCESS) {
+      const uint8_t* stack_memory = task_reader_->Read(start_addr, size);
+      if (!stack_memory)
         return false;
-      }
 
-      result = memory.Copy(&stack_memory[0], size);
+      result = memory.Copy(stack_memory, size);
     } else {
       result = memory.Copy(reinterpret_cast<const void*>(start_addr), size);
     }
@@ -974,8 +1016,10 @@ bool MinidumpGenerator::WriteThreadStream(mach_port_t thread_id,
       = static_cast<mach_msg_type_number_t>(sizeof(state));
 
   if (GetThreadState(thread_id, state, &state_count)) {
+    timing_.Begin(MD_DUMP_PHASE_STACK_COPY);
     if (!WriteStack(state, &thread->stack))
       return false;
+    timing_.End(MD_DUMP_PHASE_STACK_COPY, 1, thread->stack.memory.data_size);
 
     memory_blocks_.push_back(thread->stack);
 
@@ -1033,6 +1077,7 @@ bool MinidumpGenerator::WriteThreadListStream(
 
 bool MinidumpGenerator::WriteMemoryListStream(
     MDRawDirectory* memory_list_stream) {
+  timing_.Begin(MD_DUMP_PHASE_MEMORY_LIST);
   TypedMDRVA<MDRawMemoryList> list(&writer_);
 
   // If the dump has an exception, include some memory around the
@@ -1112,15 +1157,13 @@ bool MinidumpGenerator::WriteMemoryListStream(
 
     if (dynamic_images_) {
       // Out-of-process.
-      vector<uint8_t> memory;
-      if (ReadTaskMemory(crashing_task_,
-                         ip_memory_d.start_of_memory_range,
-                         ip_memory_d.memory.data_size,
-                         memory) != KERN_SUCCESS) {
+      const uint8_t* memory =
+          task_reader_->Read(ip_memory_d.start_of_memory_range,
+                             ip_memory_d.memory.data_size);
+      if (!memory)
         return false;
-      }
 
-      ip_memory.Copy(&memory[0], ip_memory_d.memory.data_size);
+      ip_memory.Copy(memory, ip_memory_d.memory.data_size);
     } else {
       // In-process, just copy from local memory.
       ip_memory.Copy(
@@ -1134,6 +1177,8 @@ bool MinidumpGenerator::WriteMemoryListStream(
                               sizeof(MDMemoryDescriptor));
   }
 
+  timing_.End(MD_DUMP_PHASE_MEMORY_LIST, static_cast<uint32_t>(memory_count),
+              have_ip_memory ? ip_memory_d.memory.data_size : 0);
   return true;
 }
 
@@ -1337,7 +1382,12 @@ bool MinidumpGenerator::WriteModuleStream(unsigned int index,
       module->version_info.file_version_lo |= (modVersion & 0xff);
     }
 
-    if (!WriteCVRecord(module, image->GetCPUType(), name.c_str(), false)) {
+    // The UUID comes from the load commands already read from the task,
+    // sparing a read of the binary from disk.
+    uint8_t uuid[16];
+    const bool has_uuid = image->GetUUID(uuid);
+    if (!WriteCVRecord(module, image->GetCPUType(), name.c_str(), false,
+                       has_uuid ? uuid : NULL)) {
       return false;
     }
   } else {
@@ -1425,7 +1475,8 @@ int MinidumpGenerator::FindExecutableModule() {
 }
 
 bool MinidumpGenerator::WriteCVRecord(MDRawModule* module, int cpu_type,
-                                      const char* module_path, bool in_memory) {
+                                      const char* module_path, bool in_memory,
+                                      const uint8_t* uuid) {
   TypedMDRVA<MDCVInfoPDB70> cv(&writer_);
 
   // Only return the last path component of the full module path
@@ -1451,9 +1502,13 @@ bool MinidumpGenerator::WriteCVRecord(MDRawModule* module, int cpu_type,
   cv_ptr->age = 0;
 
   // Get the module identifier
+  timing_.Begin(MD_DUMP_PHASE_BUILD_ID_READ);
   unsigned char identifier[16];
   bool result = false;
-  if (in_memory) {
+  if (uuid) {
+    memcpy(identifier, uuid, sizeof(identifier));
+    result = true;
+  } else if (in_memory) {
     MacFileUtilities::MachoID macho(
         reinterpret_cast<void*>(module->base_of_image),
         static_cast<size_t>(module->size_of_image));
@@ -1467,6 +1522,7 @@ bool MinidumpGenerator::WriteCVRecord(MDRawModule* module, int cpu_type,
      result = file_id.MachoIdentifier(cpu_type, CPU_SUBTYPE_MULTIPLE,
                                       identifier);
   }
+  timing_.End(MD_DUMP_PHASE_BUILD_ID_READ, result ? 1 : 0);
 
   if (result) {
     cv_ptr->signature.data1 =
@@ -1495,9 +1551,11 @@ bool MinidumpGenerator::WriteModuleListStream(
     MDRawDirectory* module_list_stream) {
   TypedMDRVA<MDRawModuleList> list(&writer_);
 
+  timing_.Begin(MD_DUMP_PHASE_MAPPING_ENUMERATION);
   uint32_t image_count = dynamic_images_ ?
       dynamic_images_->GetImageCount() :
       _dyld_image_count();
+  timing_.End(MD_DUMP_PHASE_MAPPING_ENUMERATION, image_count);
 
   if (!list.AllocateObjectAndArray(image_count, MD_MODULE_SIZE))
     return false;
@@ -1606,4 +1664,121 @@ bool MinidumpGenerator::WriteBreakpadInfoStream(
   return true;
 }
 
+bool MinidumpGenerator::WriteDumpTimingStream(
+    MDRawDirectory* dump_timing_stream, int stream_count) {
+  timing_.End(MD_DUMP_PHASE_TOTAL, stream_count);
+  MDRawDumpPhaseTiming phases[MD_DUMP_PHASE_COUNT];
+  size_t count = timing_.GetEntries(phases);
+
+  TypedMDRVA<MDRawDumpTimingList> list(&writer_);
+  if (!list.AllocateObjectAndArray(count, sizeof(MDRawDumpPhaseTiming)))
+    return false;
+
+  dump_timing_stream->stream_type = MD_DUMP_TIMING_STREAM;
+  dump_timing_stream->location = list.location();
+
+  MDRawDumpTimingList* list_ptr = list.get();
+  list_ptr->size_of_header = sizeof(MDRawDumpTimingList);
+  list_ptr->size_of_entry = sizeof(MDRawDumpPhaseTiming);
+  list_ptr->number_of_entries = count;
+  for (size_t i = 0; i < count; ++i) {
+    list.CopyIndexAfterObject(static_cast<unsigned>(i), &phases[i],
+                              sizeof(MDRawDumpPhaseTiming));
+  }
+
+  return true;
+}
+
+bool MinidumpGenerator::WriteCrashSignatureStream(
+    MDRawDirectory* crash_signature_stream) {
+  TypedMDRVA<MDRawCrashSignature> signature(&writer_);
+  if (!signature.Allocate())
+    return false;
+
+  crash_signature_stream->stream_type = MD_CRASH_SIGNATURE_STREAM;
+  crash_signature_stream->location = signature.location();
+  crash_signature_.GetRaw(signature.get());
+  return true;
+}
+
+void MinidumpGenerator::ComputeCrashSignature() {
+  breakpad_thread_state_data_t state;
+  mach_msg_type_number_t state_count
+      = static_cast<mach_msg_type_number_t>(sizeof(state));
+  if (!GetThreadState(exception_thread_, state, &state_count))
+    return;
+
+  uintptr_t addresses[CrashSignature::kMaxFrames];
+  size_t max_frames = crash_signature_frames_;
+  if (max_frames > CrashSignature::kMaxFrames)
+    max_frames = CrashSignature::kMaxFrames;
+  addresses[0] = static_cast<uintptr_t>(CurrentPCForStack(state));
+  size_t address_count = 1;
+
+#if defined(__x86_64__)
+  x86_thread_state64_t* machine_state =
+      reinterpret_cast<x86_thread_state64_t*>(state);
+  uintptr_t frame_pointer = REGISTER_FROM_THREADSTATE(machine_state, rbp);
+  uintptr_t stack_pointer = REGISTER_FROM_THREADSTATE(machine_state, rsp);
+#elif defined(__aarch64__)
+  arm_thread_state64_t* machine_state =
+      reinterpret_cast<arm_thread_state64_t*>(state);
+  uintptr_t frame_pointer = REGISTER_FROM_THREADSTATE(machine_state, fp);
+  uintptr_t stack_pointer = REGISTER_FROM_THREADSTATE(machine_state, sp);
+#else
+  uintptr_t frame_pointer = 0;
+  uintptr_t stack_pointer = 0;
+#endif
+  size_t stack_size = CalculateStackSize(stack_pointer);
+  if (max_frames > 1 && stack_size) {
+    address_count += WalkFramePointers(frame_pointer, stack_pointer,
+                                       stack_pointer + stack_size,
+                                       addresses + 1, max_frames - 1);
+  }
+#if defined(__aarch64__)
+  // Return addresses saved by arm64e code carry a pointer authentication
+  // code in their upper bits.
+  for (size_t i = 0; i < address_count; ++i)
+    addresses[i] &= 0x0000000fffffffffULL;
+#endif
+
+  // Find each address's image by the extent of its __TEXT segment.
+  const uint32_t image_count = _dyld_image_count();
+  for (size_t i = 0; i < address_count; ++i) {
+    for (uint32_t index = 0; index < image_count; ++index) {
+      const breakpad_mach_header* header =
+          reinterpret_cast<const breakpad_mach_header*>(
+              _dyld_get_image_header(index));
+      if (!header)
+        continue;
+      const uintptr_t slide = _dyld_get_image_vmaddr_slide(index);
+      const struct load_command* cmd =
+          reinterpret_cast<const struct load_command*>(header + 1);
+      uintptr_t text_start = 0;
+      uintptr_t text_size = 0;
+      const uint8_t* uuid = NULL;
+      for (uint32_t c = 0; c < header->ncmds; ++c) {
+        if (cmd->cmd == LC_SEGMENT_ARCH) {
+          const breakpad_mach_segment_command* seg =
+              reinterpret_cast<const breakpad_mach_segment_command*>(cmd);
+          if (!strcmp(seg->segname, "__TEXT")) {
+            text_start = seg->vmaddr + slide;
+            text_size = seg->vmsize;
+          }
+        } else if (cmd->cmd == LC_UUID) {
+          uuid = reinterpret_cast<const uuid_command*>(cmd)->uuid;
+        }
+        cmd = reinterpret_cast<const struct load_command*>(
+            reinterpret_cast<const char*>(cmd) + cmd->cmdsize);
+      }
+      if (addresses[i] - text_start < text_size) {
+        if (uuid) {
+          crash_signature_.AddFrame(uuid, 16, addresses[i] - text_start);
+        }
+        break;
+      }
+    }
+  }
+}
+
 }  // namespace google_breakpad
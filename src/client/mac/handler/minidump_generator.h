@@ -36,6 +36,8 @@
 
 #include <string>
 
+#include "client/crash_signature.h"
+#include "client/dump_timing.h"
 #include "client/mac/handler/ucontext_compat.h"
 #include "client/minidump_file_writer.h"
 #include "common/memory_allocator.h"
@@ -126,6 +128,20 @@ class MinidumpGenerator {
   // |thread_get_state|.
   void SetTaskContext(breakpad_ucontext_t* task_context);
 
+  // The timing of the dump's phases, written to the minidump by Write().
+  // Work done before the dump, such as suspending threads, may be added.
+  DumpTiming* timing() { return &timing_; }
+
+  // How many frames, counting the one that crashed, go into the crash
+  // signature that Write() adds to in-process dumps of exceptions.  0, the
+  // default, writes no signature.
+  void set_crash_signature_frames(int frames) {
+    crash_signature_frames_ = frames;
+  }
+
+  // The signature written by Write(), or 0 if it wrote none.
+  uint64_t crash_signature() const { return crash_signature_.signature(); }
+
   // Gather system information.  This should be call at least once before using
   // the MinidumpGenerator class.
   static void GatherSystemInformation();
@@ -147,6 +163,13 @@ class MinidumpGenerator {
   bool WriteModuleListStream(MDRawDirectory* module_list_stream);
   bool WriteMiscInfoStream(MDRawDirectory* misc_info_stream);
   bool WriteBreakpadInfoStream(MDRawDirectory* breakpad_info_stream);
+  bool WriteDumpTimingStream(MDRawDirectory* dump_timing_stream,
+                             int stream_count);
+  bool WriteCrashSignatureStream(MDRawDirectory* crash_signature_stream);
+
+  // Signs the crash on |exception_thread_| into |crash_signature_|, from
+  // the images loaded in this process.
+  void ComputeCrashSignature();
 
   // Helpers
   uint64_t CurrentPCForStack(breakpad_thread_state_data_t state);
@@ -158,8 +181,11 @@ class MinidumpGenerator {
                   MDMemoryDescriptor* stack_location);
   bool WriteContext(breakpad_thread_state_data_t state,
                     MDLocationDescriptor* register_location);
+  // If |uuid| is given, it's used as the module's identifier rather than
+  // one read from the image in memory or from |module_path|.
   bool WriteCVRecord(MDRawModule* module, int cpu_type,
-                     const char* module_path, bool in_memory);
+                     const char* module_path, bool in_memory,
+                     const uint8_t* uuid = NULL);
   bool WriteModuleStream(unsigned int index, MDRawModule* module);
   size_t CalculateStackSize(mach_vm_address_t start_addr);
   int  FindExecutableModule();
@@ -236,6 +262,16 @@ class MinidumpGenerator {
   // Information about dynamically loaded code
   DynamicImages* dynamic_images_;
 
+  // Reads the crashed task's memory when it's in another process.
+  TaskMemoryReader* task_reader_;
+
+  // How long each phase of the dump takes.
+  DumpTiming timing_;
+
+  // The number of frames to sign the dump with, and the signature.
+  int crash_signature_frames_;
+  CrashSignature crash_signature_;
+
   // PageAllocator makes it possible to allocate memory
   // directly from the system, even while handling an exception.
   mutable PageAllocator allocator_;
@@ -594,6 +594,8 @@ NSDictionary *readConfigurationData(const char *configFile) {
   }
 
   [upload setParameters:uploadParameters];
+  [upload setCompressBody:
+      [[parameters_ objectForKey:@BREAKPAD_COMPRESS_UPLOADS] boolValue]];
 
   // Add minidump file
   if (minidumpContents_) {
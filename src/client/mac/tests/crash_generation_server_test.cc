@@ -208,6 +208,64 @@ TEST_F(CrashGenerationServerTest, testRequestDump) {
   ASSERT_EQ(pid, child_pid);
 }
 
+struct DumpCounter {
+  pthread_mutex_t lock;
+  int dumps;
+};
+
+void countingDumpCallback(void* context, const ClientInfo& client_info,
+                          const std::string& file_path) {
+  DumpCounter* counter = reinterpret_cast<DumpCounter*>(context);
+  struct stat st;
+  if (stat(file_path.c_str(), &st) == 0 && st.st_size > 0) {
+    pthread_mutex_lock(&counter->lock);
+    counter->dumps++;
+    pthread_mutex_unlock(&counter->lock);
+  }
+}
+
+// Test that dumps requested by several clients at once are all written
+// when they are handled by a pool of workers.
+TEST_F(CrashGenerationServerTest, testConcurrentRequestDumps) {
+  DumpCounter counter = {PTHREAD_MUTEX_INITIALIZER, 0};
+  CrashGenerationServer server(mach_port_name,
+                               NULL,  // filter callback
+                               NULL,  // filter context
+                               countingDumpCallback,  // dump callback
+                               &counter,  // dump context
+                               NULL,  // exit callback
+                               NULL,  // exit context
+                               true, //  generate dumps
+                               temp_dir.path()); // dump path
+  server.SetMaxConcurrentDumps(3);
+  ASSERT_TRUE(server.Start());
+
+  const int kClients = 6;
+  pid_t pids[kClients];
+  for (int i = 0; i < kClients; ++i) {
+    pids[i] = fork();
+    ASSERT_NE(-1, pids[i]);
+    if (pids[i] == 0) {
+      pthread_t thread;
+      if (pthread_create(&thread, NULL, RequestDump,
+                         (void*)mach_port_name) != 0)
+        exit(1);
+      void* result;
+      pthread_join(thread, &result);
+      exit(reinterpret_cast<intptr_t>(result));
+    }
+  }
+
+  for (int i = 0; i < kClients; ++i) {
+    int ret;
+    ASSERT_EQ(pids[i], waitpid(pids[i], &ret, 0));
+    EXPECT_TRUE(WIFEXITED(ret));
+    EXPECT_EQ(0, WEXITSTATUS(ret));
+  }
+  EXPECT_TRUE(server.Stop());
+  EXPECT_EQ(kClients, counter.dumps);
+}
+
 static void Crasher() {
   int* a = (int*)0x42;
 
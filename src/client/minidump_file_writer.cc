@@ -34,15 +34,23 @@
 #include <config.h>  // Must come first
 #endif
 
+#include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 #include "client/minidump_file_writer-inl.h"
+#include "common/compressed_minidump.h"
 #include "common/linux/linux_libc_support.h"
+#include "common/lz4_block.h"
 #include "common/string_conversion.h"
+#include "common/utf16_ascii.h"
 #if defined(__linux__) && __linux__
 #include "third_party/lss/linux_syscall_support.h"
 #endif
@@ -88,20 +96,99 @@ bool NeedsFTruncateWorkAround() {
 }  // namespace
 #endif  // defined(__ANDROID__)
 
+namespace {
+
+#if defined(__linux__) && __linux__
+typedef struct kernel_iovec IOVector;
+#else
+typedef struct iovec IOVector;
+#endif
+
+// The number of UTF-16 code units to convert before writing them out.
+const size_t kStringChunkSize = 256;
+
+// Write the |count| UTF-16 code units at |units| to |mdstring|'s buffer,
+// starting at code unit |index|.
+bool CopyUTF16(google_breakpad::TypedMDRVA<MDString>* mdstring,
+               unsigned int index, const uint16_t* units, size_t count) {
+  return mdstring->Copy(
+      static_cast<MDRVA>(mdstring->position() +
+                         google_breakpad::minidump_size<MDString>::size() +
+                         index * sizeof(uint16_t)),
+      units, count * sizeof(uint16_t));
+}
+
+// Write all |size| bytes at |data| to |file|, which may be a pipe or a
+// socket that takes fewer bytes than offered.
+bool WriteFully(int file, const uint8_t* data, size_t size) {
+  size_t done = 0;
+  while (done < size) {
+#if defined(__linux__) && __linux__
+    ssize_t written = sys_write(file, data + done, size - done);
+#else
+    ssize_t written = write(file, data + done, size - done);
+#endif
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written <= 0)
+      return false;
+    done += written;
+  }
+  return true;
+}
+
+}  // namespace
+
 namespace google_breakpad {
 
 const MDRVA MinidumpFileWriter::kInvalidMDRVA = static_cast<MDRVA>(-1);
 
+#if defined(__ANDROID__)
+// Applications have no shared temporary directory.
+const char* const MinidumpFileWriter::kDefaultSpillDirectory = NULL;
+#else
+const char* const MinidumpFileWriter::kDefaultSpillDirectory = "/tmp";
+#endif
+
 MinidumpFileWriter::MinidumpFileWriter()
     : file_(-1),
       close_file_when_destroyed_(true),
       position_(0),
-      size_(0) {
+      size_(0),
+      buffer_(NULL),
+      buffer_used_(0),
+      extents_(NULL),
+      extent_count_(0),
+      sequential_(false),
+      image_(NULL),
+      image_capacity_(0),
+      image_written_(false),
+      image_complete_(false),
+      sequential_limit_(kDefaultSequentialLimit),
+      spill_directory_(kDefaultSpillDirectory),
+      sequential_file_(-1),
+      compressed_(false),
+      compressed_header_written_(false),
+      compressed_size_(0),
+      staging_(NULL),
+      output_(NULL),
+      hash_table_(NULL) {
 }
 
 MinidumpFileWriter::~MinidumpFileWriter() {
-  if (close_file_when_destroyed_)
+  if (close_file_when_destroyed_) {
     Close();
+  } else if (file_ != -1) {
+    Finish();
+    CloseSpillFile();
+  }
+  if (image_) {
+#if defined(__linux__) && __linux__
+    sys_munmap(image_, image_capacity_);
+#else
+    munmap(image_, image_capacity_);
+#endif
+  }
 }
 
 bool MinidumpFileWriter::Open(const char* path) {
@@ -119,6 +206,13 @@ void MinidumpFileWriter::SetFile(const int file) {
   assert(file_ == -1);
   file_ = file;
   close_file_when_destroyed_ = false;
+#if defined(__linux__) && __linux__
+  if (sys_lseek(file, 0, SEEK_CUR) == -1)
+    sequential_ = true;
+#else
+  if (lseek(file, 0, SEEK_CUR) == -1)
+    sequential_ = true;
+#endif
 #if defined(__ANDROID__)
   CheckNeedsFTruncateWorkAround(file);
 #endif
@@ -128,19 +222,26 @@ bool MinidumpFileWriter::Close() {
   bool result = true;
 
   if (file_ != -1) {
+    if (!Finish())
+      result = false;
+    if (!CloseSpillFile())
+      result = false;
+    // A compressed or sequential file was only appended to, so it needs no
+    // trimming.
 #if defined(__ANDROID__)
-    if (!NeedsFTruncateWorkAround() && ftruncate(file_, position_)) {
+    if (!compressed_ && !sequential_ && !NeedsFTruncateWorkAround() &&
+        ftruncate(file_, position_)) {
        return false;
     }
 #else
-    if (ftruncate(file_, position_)) {
+    if (!compressed_ && !sequential_ && ftruncate(file_, position_)) {
        return false;
     }
 #endif
 #if defined(__linux__) && __linux__
-    result = (sys_close(file_) == 0);
+    result = (sys_close(file_) == 0) && result;
 #else
-    result = (close(file_) == 0);
+    result = (close(file_) == 0) && result;
 #endif
     file_ = -1;
   }
@@ -151,60 +252,80 @@ bool MinidumpFileWriter::Close() {
 bool MinidumpFileWriter::CopyStringToMDString(const wchar_t* str,
                                               unsigned int length,
                                               TypedMDRVA<MDString>* mdstring) {
-  bool result = true;
   if (sizeof(wchar_t) == sizeof(uint16_t)) {
     // Shortcut if wchar_t is the same size as MDString's buffer
-    result = mdstring->Copy(str, mdstring->get()->length);
-  } else {
-    uint16_t out[2];
-    int out_idx = 0;
+    return mdstring->Copy(str, mdstring->get()->length);
+  }
 
-    // Copy the string character by character
-    while (length && result) {
-      UTF32ToUTF16Char(*str, out);
-      if (!out[0])
+  // Convert the string a chunk at a time, leaving room in each chunk for
+  // a character that takes two UTF-16 code units.
+  uint16_t out[kStringChunkSize];
+  size_t out_count = 0;
+  unsigned int out_idx = 0;
+  while (length) {
+    // ASCII characters, the usual case, need no conversion.
+    if (static_cast<uint32_t>(*str) < 0x80 && *str) {
+      out[out_count] = static_cast<uint16_t>(*str);
+      out[out_count + 1] = 0;
+    } else {
+      UTF32ToUTF16Char(*str, &out[out_count]);
+      if (!out[out_count])
+        return false;
+    }
+    --length;
+    ++str;
+
+    // The first UTF-16 character will be non-zero, but the second one may
+    // be zero, depending on the conversion from UTF-32.
+    out_count += out[out_count + 1] ? 2 : 1;
+    if (out_count > kStringChunkSize - 2 || !length) {
+      if (!CopyUTF16(mdstring, out_idx, out, out_count))
         return false;
-
-      // Process one character at a time
-      --length;
-      ++str;
-
-      // Append the one or two UTF-16 characters.  The first one will be non-
-      // zero, but the second one may be zero, depending on the conversion from
-      // UTF-32.
-      int out_count = out[1] ? 2 : 1;
-      size_t out_size = sizeof(uint16_t) * out_count;
-      result = mdstring->CopyIndexAfterObject(out_idx, out, out_size);
       out_idx += out_count;
+      out_count = 0;
     }
   }
-  return result;
+  return true;
 }
 
 bool MinidumpFileWriter::CopyStringToMDString(const char* str,
                                               unsigned int length,
                                               TypedMDRVA<MDString>* mdstring) {
-  bool result = true;
-  uint16_t out[2];
-  int out_idx = 0;
+  uint16_t out[kStringChunkSize];
+  size_t out_count = 0;
+  unsigned int out_idx = 0;
+
+  // Convert the string a chunk at a time, as above.
+  while (length) {
+    // Copy a run of ASCII characters at once, then convert the character
+    // that ends it, if there is room for it in this chunk.
+    size_t ascii_count = CopyASCIIToUTF16(
+        str, std::min<size_t>(length, kStringChunkSize - out_count),
+        &out[out_count]);
+    length -= static_cast<unsigned int>(ascii_count);
+    str += ascii_count;
+    out_count += ascii_count;
+
+    if (length && out_count <= kStringChunkSize - 2) {
+      int conversion_count = UTF8ToUTF16Char(str, length, &out[out_count]);
+      if (!conversion_count)
+        return false;
 
-  // Copy the string character by character
-  while (length && result) {
-    int conversion_count = UTF8ToUTF16Char(str, length, out);
-    if (!conversion_count)
-      return false;
+      // Move the pointer along based on the nubmer of converted characters
+      length -= conversion_count;
+      str += conversion_count;
 
-    // Move the pointer along based on the nubmer of converted characters
-    length -= conversion_count;
-    str += conversion_count;
+      out_count += out[out_count + 1] ? 2 : 1;
+    }
 
-    // Append the one or two UTF-16 characters
-    int out_count = out[1] ? 2 : 1;
-    size_t out_size = sizeof(uint16_t) * out_count;
-    result = mdstring->CopyIndexAfterObject(out_idx, out, out_size);
-    out_idx += out_count;
+    if (out_count > kStringChunkSize - 2 || !length) {
+      if (!CopyUTF16(mdstring, out_idx, out, out_count))
+        return false;
+      out_idx += out_count;
+      out_count = 0;
+    }
   }
-  return result;
+  return true;
 }
 
 template <typename CharType>
@@ -273,6 +394,25 @@ bool MinidumpFileWriter::WriteMemory(const void* src, size_t size,
 MDRVA MinidumpFileWriter::Allocate(size_t size) {
   assert(size);
   assert(file_ != -1);
+  size_t aligned_size = (size + 7) & ~7;  // 64-bit alignment
+
+  if (!compressed_ && sequential_ && sequential_file_ == -1 &&
+      position_ + aligned_size > sequential_limit_) {
+    // Too large to hold in memory, so carry on in a spill file below.
+    if (!Spill())
+      return kInvalidMDRVA;
+  }
+  if (compressed_ || (sequential_ && sequential_file_ == -1)) {
+    // The file is not written in place, so there is nothing to grow.
+    if (position_ + aligned_size > size_)
+      size_ = position_ + aligned_size;
+    if (!compressed_ && !GrowImage(size_))
+      return kInvalidMDRVA;
+
+    MDRVA current_position = position_;
+    position_ += static_cast<MDRVA>(aligned_size);
+    return current_position;
+  }
 #if defined(__ANDROID__)
   if (NeedsFTruncateWorkAround()) {
     // If ftruncate() is not available. We simply increase the size beyond the
@@ -287,8 +427,6 @@ MDRVA MinidumpFileWriter::Allocate(size_t size) {
     return current_position;
   }
 #endif
-  size_t aligned_size = (size + 7) & ~7;  // 64-bit alignment
-
   if (position_ + aligned_size > size_) {
     size_t growth = aligned_size;
     size_t minimal_growth = getpagesize();
@@ -319,16 +457,399 @@ bool MinidumpFileWriter::Copy(MDRVA position, const void* src, ssize_t size) {
   if (static_cast<size_t>(size + position) > size_)
     return false;
 
+  if (sequential_ && !compressed_ && sequential_file_ == -1) {
+    my_memcpy(image_ + position, src, size);
+    return true;
+  }
+
+  if (!buffer_) {
+    buffer_ = reinterpret_cast<uint8_t*>(allocator_.Alloc(kBufferSize));
+    extents_ = reinterpret_cast<BufferedExtent*>(
+        allocator_.Alloc(kMaxExtents * sizeof(BufferedExtent)));
+    if (compressed_ && (!buffer_ || !extents_ || !AllocateCompression())) {
+      buffer_ = NULL;
+      return false;
+    }
+    if (!buffer_ || !extents_) {
+      buffer_ = NULL;
+      return WriteAt(position, src, size);
+    }
+  }
+
+  // Anything already buffered for these bytes must reach the file first,
+  // so that the newer copy wins.
+  const size_t length = static_cast<size_t>(size);
+  for (size_t i = 0; i < extent_count_; ++i) {
+    if (position < extents_[i].position + extents_[i].size &&
+        extents_[i].position < position + length) {
+      if (!Flush())
+        return false;
+      break;
+    }
+  }
+
+  if (length > kMaxBufferedCopySize) {
+    if (!compressed_) {
+      // The buffer has nothing for these bytes, so write them ahead of it.
+      return WriteAt(position, src, length);
+    }
+
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(src);
+    for (size_t done = 0; done < length; done += kMaxBufferedCopySize) {
+      const size_t piece = length - done < kMaxBufferedCopySize ?
+          length - done : kMaxBufferedCopySize;
+      if (!BufferCopy(static_cast<MDRVA>(position + done), bytes + done,
+                      piece)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  return BufferCopy(position, src, length);
+}
+
+bool MinidumpFileWriter::BufferCopy(MDRVA position, const void* src,
+                                    size_t length) {
+  BufferedExtent* last = extent_count_ ? &extents_[extent_count_ - 1] : NULL;
+  const bool extends_last = last &&
+      last->position + last->size == position &&
+      last->offset + last->size == buffer_used_;
+  if (buffer_used_ + length > kBufferSize ||
+      (!extends_last && extent_count_ == kMaxExtents)) {
+    if (!Flush())
+      return false;
+    last = NULL;
+  }
+
+  my_memcpy(buffer_ + buffer_used_, src, length);
+  if (last && extends_last) {
+    last->size += length;
+  } else {
+    BufferedExtent* extent = &extents_[extent_count_++];
+    extent->position = position;
+    extent->offset = buffer_used_;
+    extent->size = length;
+  }
+  buffer_used_ += length;
+  return true;
+}
+
+bool MinidumpFileWriter::Flush() {
+  if (compressed_) {
+    // Even with nothing buffered, a frame may be needed to record that
+    // the minidump has grown.
+    if (!extent_count_ && compressed_size_ == position_)
+      return true;
+    return FlushCompressed();
+  }
+
+  if (!extent_count_)
+    return true;
+
+  // Sort the extents by position, so that runs of them that are adjacent
+  // in the file can be written with one system call.  Extents are often
+  // added out of order: TypedMDRVA writes its object after the array that
+  // follows it.
+  for (size_t i = 1; i < extent_count_; ++i) {
+    BufferedExtent extent = extents_[i];
+    size_t j = i;
+    for (; j > 0 && extents_[j - 1].position > extent.position; --j)
+      extents_[j] = extents_[j - 1];
+    extents_[j] = extent;
+  }
+
+  static const size_t kMaxVectors = 64;
+  bool result = true;
+  size_t i = 0;
+  while (i < extent_count_) {
+    IOVector vectors[kMaxVectors];
+    size_t count = 0;
+    const MDRVA start = extents_[i].position;
+    size_t total = 0;
+    while (i < extent_count_ && count < kMaxVectors &&
+           extents_[i].position == start + total) {
+      vectors[count].iov_base = buffer_ + extents_[i].offset;
+      vectors[count].iov_len = extents_[i].size;
+      total += extents_[i].size;
+      ++count;
+      ++i;
+    }
+
+#if defined(__linux__) && __linux__
+    if (sys_lseek(file_, start, SEEK_SET) != static_cast<off_t>(start) ||
+        sys_writev(file_, vectors, count) != static_cast<ssize_t>(total)) {
+      result = false;
+    }
+#else
+    if (lseek(file_, start, SEEK_SET) != static_cast<off_t>(start) ||
+        writev(file_, vectors, count) != static_cast<ssize_t>(total)) {
+      result = false;
+    }
+#endif
+  }
+
+  extent_count_ = 0;
+  buffer_used_ = 0;
+  return result;
+}
+
+bool MinidumpFileWriter::GrowImage(size_t size) {
+  if (size <= image_capacity_)
+    return true;
+
+  // Double the image, so that a minidump of many small allocations is
+  // copied only a few times.
+  const size_t page_size = getpagesize();
+  size_t capacity = image_capacity_ ? image_capacity_ : 16 * page_size;
+  while (capacity < size)
+    capacity *= 2;
+  if (capacity > sequential_limit_)
+    capacity = std::max(size, sequential_limit_);
+
+#if defined(__linux__) && __linux__
+  void* image = image_ ?
+      sys_mremap(image_, image_capacity_, capacity, MREMAP_MAYMOVE) :
+      sys_mmap(NULL, capacity, PROT_READ | PROT_WRITE,
+               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (image == MAP_FAILED)
+    return false;
+#else
+  void* image = mmap(NULL, capacity, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANON, -1, 0);
+  if (image == MAP_FAILED)
+    return false;
+  if (image_) {
+    my_memcpy(image, image_, image_capacity_);
+    munmap(image_, image_capacity_);
+  }
+#endif
+  image_ = reinterpret_cast<uint8_t*>(image);
+  image_capacity_ = capacity;
+  return true;
+}
+
+bool MinidumpFileWriter::WriteImage() {
+  return WriteFully(file_, image_, position_);
+}
+
+bool MinidumpFileWriter::Spill() {
+  if (!spill_directory_)
+    return false;
+
+  // The file is never linked into the directory where possible, and is
+  // unlinked as soon as it is made otherwise, so nothing is left behind
+  // if this process dies too.
+  int file = -1;
+#if defined(__linux__) && __linux__ && defined(O_TMPFILE)
+  file = sys_open(spill_directory_, O_RDWR | O_TMPFILE, 0600);
+#endif
+  if (file == -1) {
+    static const char kPrefix[] = "/.minidump-";
+    char path[PATH_MAX];
+#if defined(__linux__) && __linux__
+    const pid_t pid = sys_getpid();
+#else
+    const pid_t pid = getpid();
+#endif
+    const unsigned pid_length = my_uint_len(pid);
+    const size_t directory_length = my_strlen(spill_directory_);
+    if (directory_length + sizeof(kPrefix) + pid_length > sizeof(path))
+      return false;
+    my_strlcpy(path, spill_directory_, sizeof(path));
+    my_strlcat(path, kPrefix, sizeof(path));
+    my_uitos(path + directory_length + sizeof(kPrefix) - 1, pid, pid_length);
+    path[directory_length + sizeof(kPrefix) - 1 + pid_length] = '\0';
+#if defined(__linux__) && __linux__
+    file = sys_open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (file != -1)
+      sys_unlink(path);
+#else
+    file = open(path, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (file != -1)
+      unlink(path);
+#endif
+    if (file == -1)
+      return false;
+  }
+
+  // Everything allocated so far becomes the start of the file, as though
+  // it had been seekable all along.
+  if (!WriteFully(file, image_, size_)) {
+#if defined(__linux__) && __linux__
+    sys_close(file);
+#else
+    close(file);
+#endif
+    return false;
+  }
+  if (image_) {
+#if defined(__linux__) && __linux__
+    sys_munmap(image_, image_capacity_);
+#else
+    munmap(image_, image_capacity_);
+#endif
+    image_ = NULL;
+    image_capacity_ = 0;
+  }
+  sequential_file_ = file_;
+  file_ = file;
+  return true;
+}
+
+bool MinidumpFileWriter::WriteSpillFile() {
+  if (!buffer_) {
+    buffer_ = reinterpret_cast<uint8_t*>(allocator_.Alloc(kBufferSize));
+    if (!buffer_)
+      return false;
+  }
+
+  // Flush() has emptied |buffer_|, so it can carry the copy.
+  size_t done = 0;
+  while (done < position_) {
+    const size_t length = std::min<size_t>(position_ - done, kBufferSize);
+#if defined(__linux__) && __linux__
+    ssize_t count = sys_pread64(file_, buffer_, length, done);
+#else
+    ssize_t count = pread(file_, buffer_, length, done);
+#endif
+    if (count < 0 && errno == EINTR)
+      continue;
+    if (count <= 0 || !WriteFully(sequential_file_, buffer_, count))
+      return false;
+    done += count;
+  }
+  return true;
+}
+
+bool MinidumpFileWriter::CloseSpillFile() {
+  if (sequential_file_ == -1)
+    return true;
+#if defined(__linux__) && __linux__
+  bool result = sys_close(file_) == 0;
+#else
+  bool result = close(file_) == 0;
+#endif
+  file_ = sequential_file_;
+  sequential_file_ = -1;
+  return result;
+}
+
+bool MinidumpFileWriter::Finish() {
+  if (!Flush())
+    return false;
+  if (compressed_ || !sequential_)
+    return true;
+  if (!image_written_) {
+    image_written_ = true;
+    image_complete_ =
+        sequential_file_ != -1 ? WriteSpillFile() : WriteImage();
+  }
+  return image_complete_;
+}
+
+bool MinidumpFileWriter::AllocateCompression() {
+  if (staging_)
+    return true;
+
+  // Each extent becomes a segment, and one more segment ends the frame.
+  const size_t staging_size =
+      kBufferSize + (kMaxExtents + 1) * sizeof(CompressedMinidumpSegment);
+  const size_t output_size = sizeof(CompressedMinidumpHeader) +
+      sizeof(CompressedMinidumpFrame) + LZ4CompressBound(staging_size);
+  staging_ = reinterpret_cast<uint8_t*>(allocator_.Alloc(staging_size));
+  output_ = reinterpret_cast<uint8_t*>(allocator_.Alloc(output_size));
+  hash_table_ = reinterpret_cast<uint32_t*>(
+      allocator_.Alloc(kLZ4HashTableSize * sizeof(uint32_t)));
+  if (!staging_ || !output_ || !hash_table_) {
+    staging_ = NULL;
+    return false;
+  }
+  return true;
+}
+
+bool MinidumpFileWriter::FlushCompressed() {
+  // Allocate() may have been called without Copy().
+  if (!AllocateCompression())
+    return false;
+
+  // Gather the extents into segments, in the order they were copied.  A
+  // final empty segment records how far the minidump has been allocated.
+  uint8_t* segments = staging_;
+  for (size_t i = 0; i <= extent_count_; ++i) {
+    CompressedMinidumpSegment segment;
+    if (i < extent_count_) {
+      segment.position = extents_[i].position;
+      segment.size = static_cast<uint32_t>(extents_[i].size);
+    } else {
+      segment.position = position_;
+      segment.size = 0;
+    }
+    my_memcpy(segments, &segment, sizeof(segment));
+    segments += sizeof(segment);
+    if (segment.size) {
+      my_memcpy(segments, buffer_ + extents_[i].offset, segment.size);
+      segments += segment.size;
+    }
+  }
+  const size_t raw_size = segments - staging_;
+
+  uint8_t* out = output_;
+  if (!compressed_header_written_) {
+    CompressedMinidumpHeader header;
+    header.magic = kCompressedMinidumpMagic;
+    header.version = kCompressedMinidumpVersion;
+    my_memcpy(out, &header, sizeof(header));
+    out += sizeof(header);
+  }
+
+  CompressedMinidumpFrame frame;
+  frame.raw_size = static_cast<uint32_t>(raw_size);
+  uint8_t* payload = out + sizeof(frame);
+#if defined(__linux__) && __linux__
+  size_t stored_size = LZ4Compress(staging_, raw_size, payload, hash_table_);
+#else
+  // Only the Linux client builds the compressor.
+  size_t stored_size = raw_size;
+#endif
+  if (stored_size >= raw_size) {
+    stored_size = raw_size;
+    my_memcpy(payload, staging_, raw_size);
+  }
+  frame.stored_size = static_cast<uint32_t>(stored_size);
+  my_memcpy(out, &frame, sizeof(frame));
+  out = payload + stored_size;
+
+  extent_count_ = 0;
+  buffer_used_ = 0;
+
+  const ssize_t length = out - output_;
+#if defined(__linux__) && __linux__
+  if (sys_write(file_, output_, length) != length)
+    return false;
+#else
+  if (write(file_, output_, length) != length)
+    return false;
+#endif
+  compressed_header_written_ = true;
+  compressed_size_ = position_;
+  return true;
+}
+
+bool MinidumpFileWriter::WriteAt(MDRVA position, const void* src,
+                                 size_t size) {
+  const ssize_t length = static_cast<ssize_t>(size);
+
   // Seek and write the data
 #if defined(__linux__) && __linux__
   if (sys_lseek(file_, position, SEEK_SET) == static_cast<off_t>(position)) {
-    if (sys_write(file_, src, size) == size) {
+    if (sys_write(file_, src, size) == length) {
       return true;
     }
   }
 #else
   if (lseek(file_, position, SEEK_SET) == static_cast<off_t>(position)) {
-    if (write(file_, src, size) == size) {
+    if (write(file_, src, size) == length) {
       return true;
     }
   }
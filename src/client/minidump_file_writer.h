@@ -35,6 +35,7 @@
 
 #include <string>
 
+#include "common/memory_allocator.h"
 #include "google_breakpad/common/minidump_format.h"
 
 namespace google_breakpad {
@@ -80,11 +81,47 @@ public:
 
   // Sets the file descriptor |file| as the destination of the minidump data.
   // Can be used as an alternative to Open() when a file descriptor is
-  // available.
+  // available.  If |file| can't seek, such as a pipe or a socket, the
+  // minidump is written sequentially.
   // Note that |fd| is not closed when the instance of MinidumpFileWriter is
   // destroyed.
   void SetFile(const int file);
 
+  // Lay the minidump out in memory and write it from start to end, without
+  // seeking, when it is closed, so that the file may be a pipe, a socket or
+  // a compressor's input.  Minidump writers fill in directories and lists
+  // after the data they point to, so nothing can be written before the
+  // whole layout is known.  Must be called before anything is written.  A
+  // compressed minidump is only ever appended to, so is always sequential.
+  //
+  // The layout costs as much anonymous memory as the minidump is large,
+  // rounded up to a power of two, up to the sequential limit.  A minidump
+  // that grows past the limit moves to an unlinked temporary file in the
+  // spill directory, is written there in place like any seekable file, and
+  // is copied from it to the file in order when it is closed.  Without a
+  // spill directory, or if the temporary file can't be made, allocations
+  // past the limit fail.
+  void set_sequential(bool sequential) { sequential_ = sequential; }
+
+  // Sets the most memory a sequential minidump may be laid out in, by
+  // default kDefaultSequentialLimit.
+  void set_sequential_limit(size_t limit) { sequential_limit_ = limit; }
+
+  // Sets the directory that a sequential minidump larger than the limit
+  // moves to, by default kDefaultSpillDirectory.  |directory| must outlive
+  // the writer, and may be NULL to keep every minidump in memory.
+  void set_spill_directory(const char* directory) {
+    spill_directory_ = directory;
+  }
+
+  static const size_t kDefaultSequentialLimit = 32 * 1024 * 1024;
+  static const char* const kDefaultSpillDirectory;
+
+  // Write the minidump compressed, in the layout that
+  // common/compressed_minidump.h describes, rather than as a plain
+  // minidump.  Must be called before anything is written.
+  void set_compressed(bool compressed) { compressed_ = compressed; }
+
   // Close the current file (that was either created when Open was called, or
   // specified with SetFile).
   // Return true on success, or false on failure.
@@ -108,10 +145,24 @@ public:
   // Return true on success and set |output| to position, or false on failure
   bool WriteMemory(const void* src, size_t size, MDMemoryDescriptor* output);
 
-  // Copies |size| bytes from |src| to |position|
+  // Copies |size| bytes from |src| to |position|.  Small copies are held in
+  // a buffer and written out together by Flush().
   // Return true on success, or false on failure
   bool Copy(MDRVA position, const void* src, ssize_t size);
 
+  // Write out any copies that are still buffered.  Close() and the
+  // destructor do this too, but only Flush() reports whether it worked.
+  // Return true on success, or false on failure
+  bool Flush();
+
+  // Write out everything, including a sequential minidump, after which
+  // nothing more may be written.  Close() and the destructor do this too,
+  // but only Finish() and Close() report whether it worked.  A sequential
+  // minidump is written out once, so if that was cut short, every later
+  // call fails too.
+  // Return true on success, or false on failure
+  bool Finish();
+
   // Return the current position for writing to the minidump
   inline MDRVA position() const { return position_; }
 
@@ -135,6 +186,97 @@ public:
   // Current allocated size
   size_t size_;
 
+  // A run of bytes in |buffer_| that belongs at |position| in the file.
+  struct BufferedExtent {
+    MDRVA position;
+    size_t offset;
+    size_t size;
+  };
+
+  // Copies no larger than this go through |buffer_|; larger ones are
+  // written straight to the file.
+  static const size_t kBufferSize = 64 * 1024;
+  static const size_t kMaxBufferedCopySize = kBufferSize / 4;
+  static const size_t kMaxExtents = 512;
+
+  // Add a copy of no more than kMaxBufferedCopySize bytes to |buffer_|,
+  // flushing it first if there is no room.
+  bool BufferCopy(MDRVA position, const void* src, size_t length);
+
+  // Write |size| bytes from |src| to |position| in the file.
+  bool WriteAt(MDRVA position, const void* src, size_t size);
+
+  // Allocate |staging_|, |output_| and |hash_table_| if they are not
+  // already.  Return true on success, or false on failure.
+  bool AllocateCompression();
+
+  // Append the buffered copies to a compressed file as one frame.
+  bool FlushCompressed();
+
+  // Memory for |buffer_| and |extents_|, and when compressing for
+  // |staging_|, |output_| and |hash_table_|, allocated by the first Copy().
+  // The heap may be damaged, so this comes straight from the kernel.
+  PageAllocator allocator_;
+
+  // Bytes waiting to be written, and where in the file they go.  Extents
+  // never overlap one another.
+  uint8_t* buffer_;
+  size_t buffer_used_;
+  BufferedExtent* extents_;
+  size_t extent_count_;
+
+  // Whether the minidump is laid out in |image_| and written by Close().
+  // |image_| is |image_capacity_| bytes of zeroed memory straight from the
+  // kernel, grown as the minidump is allocated, up to |sequential_limit_|.
+  bool sequential_;
+  uint8_t* image_;
+  size_t image_capacity_;
+  bool image_written_;
+  // Whether all of the minidump reached the file, once |image_written_|.
+  bool image_complete_;
+  size_t sequential_limit_;
+  const char* spill_directory_;
+
+  // Once a sequential minidump has outgrown |image_|, the file it is
+  // written to in the end, while |file_| is the spill file.  Otherwise -1.
+  int sequential_file_;
+
+  // Make |image_| at least |size| bytes.  Return true on success, or false
+  // on failure.
+  bool GrowImage(size_t size);
+
+  // Write the |position_| bytes of |image_| to the file in order.
+  bool WriteImage();
+
+  // Move the minidump from |image_| to a new spill file, which |file_|
+  // then refers to.  Return true on success, or false on failure.
+  bool Spill();
+
+  // Copy the |position_| bytes of the spill file to |sequential_file_| in
+  // order.  Return true on success, or false on failure.
+  bool WriteSpillFile();
+
+  // Close the spill file, if there is one, and point |file_| back at the
+  // file it was standing in for.  Return true on success, or false on
+  // failure.
+  bool CloseSpillFile();
+
+  // Whether the file is a compressed minidump.  A compressed file is only
+  // ever appended to, so every copy goes through |buffer_|.
+  bool compressed_;
+
+  // Whether the header of the compressed file has been written.
+  bool compressed_header_written_;
+
+  // The minidump size recorded by the last compressed frame.
+  MDRVA compressed_size_;
+
+  // Where a frame's segments are gathered, where they are compressed to,
+  // and the compressor's hash table.
+  uint8_t* staging_;
+  uint8_t* output_;
+  uint32_t* hash_table_;
+
   // Copy |length| characters from |str| to |mdstring|.  These are distinct
   // because the underlying MDString is a UTF-16 based string.  The wchar_t
   // variant may need to create a MDString that has more characters than the
@@ -30,6 +30,7 @@
 
 /*
  g++ -I../ ../common/convert_UTF.cc \
+ ../common/lz4_block.cc \
  ../common/string_conversion.cc \
  minidump_file_writer.cc \
  minidump_file_writer_unittest.cc \
@@ -41,8 +42,13 @@
 #endif
 
 #include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/resource.h>
 #include <unistd.h>
 
+#include "common/compressed_minidump.h"
+#include "common/lz4_block.h"
 #include "minidump_file_writer-inl.h"
 
 using google_breakpad::MinidumpFileWriter;
@@ -170,11 +176,318 @@ static bool CompareFile(const char* path) {
   return true;
 }
 
+// Apply the segments of the compressed minidump of |size| bytes at |data|
+// to |image|, and set |image_size| to the size of the minidump.
+static bool DecompressFile(const unsigned char* data, size_t size,
+                           unsigned char* image, size_t* image_size) {
+  using google_breakpad::CompressedMinidumpFrame;
+  using google_breakpad::CompressedMinidumpHeader;
+  using google_breakpad::CompressedMinidumpSegment;
+  static unsigned char raw[1 << 20];
+
+  CompressedMinidumpHeader header;
+  ASSERT_TRUE(size >= sizeof(header));
+  memcpy(&header, data, sizeof(header));
+  ASSERT_EQ(header.magic, google_breakpad::kCompressedMinidumpMagic);
+  ASSERT_EQ(header.version, google_breakpad::kCompressedMinidumpVersion);
+
+  *image_size = 0;
+  size_t offset = sizeof(header);
+  int compressed_frames = 0;
+  while (offset < size) {
+    CompressedMinidumpFrame frame;
+    ASSERT_TRUE(size - offset >= sizeof(frame));
+    memcpy(&frame, data + offset, sizeof(frame));
+    offset += sizeof(frame);
+    ASSERT_TRUE(frame.stored_size <= size - offset);
+    ASSERT_TRUE(frame.raw_size <= sizeof(raw));
+    if (frame.stored_size == frame.raw_size) {
+      memcpy(raw, data + offset, frame.raw_size);
+    } else {
+      ASSERT_TRUE(google_breakpad::LZ4Decompress(
+          data + offset, frame.stored_size, raw, frame.raw_size));
+      ++compressed_frames;
+    }
+    offset += frame.stored_size;
+
+    size_t position = 0;
+    while (position < frame.raw_size) {
+      CompressedMinidumpSegment segment;
+      memcpy(&segment, raw + position, sizeof(segment));
+      position += sizeof(segment);
+      memcpy(image + segment.position, raw + position, segment.size);
+      position += segment.size;
+      if (segment.position + segment.size > *image_size)
+        *image_size = segment.position + segment.size;
+    }
+  }
+  ASSERT_TRUE(compressed_frames > 0);
+  return true;
+}
+
+// MinidumpFileWriter buffers small copies, so write out of order, over
+// bytes that are still buffered, around a copy too large to buffer, and a
+// string longer than one conversion chunk, then check the file.
+static bool WriteAndCompareBufferedFile(const char* path, bool compressed,
+                                        bool sequential) {
+  static unsigned char expected[200000];
+  const size_t kBlockSize = 100000;
+  for (size_t i = 0; i < kBlockSize; ++i)
+    expected[i] = static_cast<unsigned char>(i * 13);
+
+  MinidumpFileWriter writer;
+  ASSERT_TRUE(writer.Open(path));
+  writer.set_compressed(compressed);
+  writer.set_sequential(sequential);
+  google_breakpad::UntypedMDRVA block(&writer);
+  ASSERT_TRUE(block.Allocate(kBlockSize));
+  ASSERT_EQ(block.position(), 0U);
+  for (size_t offset = kBlockSize; offset > 0; offset -= 100)
+    ASSERT_TRUE(block.Copy(offset - 100, expected + offset - 100, 100));
+  const unsigned char marker[] = { 0xde, 0xad, 0xbe, 0xef };
+  memcpy(expected + 50, marker, sizeof(marker));
+  ASSERT_TRUE(block.Copy(50, marker, sizeof(marker)));
+  for (size_t i = 40000; i < 80000; ++i)
+    expected[i] = static_cast<unsigned char>(i * 7);
+  ASSERT_TRUE(block.Copy(40000, expected + 40000, 40000));
+
+  char text[1001];
+  for (size_t i = 0; i < 1000; ++i)
+    text[i] = 'a' + i % 26;
+  text[1000] = '\0';
+  MDLocationDescriptor location;
+  ASSERT_TRUE(writer.WriteString(text, 0, &location));
+  ASSERT_EQ(location.rva, kBlockSize);
+  ASSERT_EQ(location.data_size, 4 + 1001 * 2U);
+  unsigned char* string = expected + kBlockSize;
+  const uint32_t length = 2000;
+  memcpy(string, &length, sizeof(length));
+  for (size_t i = 0; i <= 1000; ++i) {
+    const uint16_t unit = text[i];
+    memcpy(string + 4 + i * 2, &unit, sizeof(unit));
+  }
+  ASSERT_TRUE(writer.Close());
+
+  const size_t expected_size = kBlockSize + location.data_size;
+  static unsigned char buffer[sizeof(expected)];
+  int fd = open(path, O_RDONLY, 0600);
+  ASSERT_NE(fd, -1);
+  ssize_t file_size = read(fd, buffer, sizeof(buffer));
+  close(fd);
+  if (compressed) {
+    static unsigned char image[sizeof(expected)];
+    size_t image_size;
+    ASSERT_TRUE(file_size > 0 &&
+                static_cast<size_t>(file_size) < expected_size);
+    ASSERT_TRUE(DecompressFile(buffer, file_size, image, &image_size));
+    ASSERT_EQ(image_size, (expected_size + 7) & ~7);
+    ASSERT_EQ(memcmp(image, expected, expected_size), 0);
+    return true;
+  }
+  ASSERT_EQ(file_size, static_cast<ssize_t>((expected_size + 7) & ~7));
+  ASSERT_EQ(memcmp(buffer, expected, expected_size), 0);
+  return true;
+}
+
+// A pipe can't seek, so the minidump must come out of it in order, with
+// the header that is written last at the front.  With |spill_directory|,
+// the second block goes past the sequential limit, so the minidump moves
+// to a spill file in that directory partway through.
+static bool WriteToPipe(const char* spill_directory) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  {
+    MinidumpFileWriter writer;
+    writer.SetFile(fds[1]);
+    if (spill_directory) {
+      writer.set_sequential_limit(1500);
+      writer.set_spill_directory(spill_directory);
+    }
+    google_breakpad::TypedMDRVA<MDRawHeader> header(&writer);
+    ASSERT_TRUE(header.Allocate());
+    unsigned char data[1000];
+    for (size_t i = 0; i < sizeof(data); ++i)
+      data[i] = static_cast<unsigned char>(i * 3);
+    google_breakpad::UntypedMDRVA block(&writer);
+    ASSERT_TRUE(block.Allocate(sizeof(data)));
+    ASSERT_TRUE(block.Copy(data, sizeof(data)));
+    google_breakpad::UntypedMDRVA second_block(&writer);
+    ASSERT_TRUE(second_block.Allocate(sizeof(data)));
+    ASSERT_TRUE(second_block.Copy(data, sizeof(data)));
+    header.get()->signature = MD_HEADER_SIGNATURE;
+    header.get()->stream_directory_rva = block.position();
+    ASSERT_TRUE(header.Flush());
+    ASSERT_TRUE(writer.Finish());
+  }
+  close(fds[1]);
+
+  unsigned char buffer[4000];
+  size_t size = 0;
+  ssize_t count;
+  while ((count = read(fds[0], buffer + size, sizeof(buffer) - size)) > 0)
+    size += count;
+  close(fds[0]);
+  ASSERT_EQ(size, sizeof(MDRawHeader) + 2000);
+  MDRawHeader header;
+  memcpy(&header, buffer, sizeof(header));
+  ASSERT_EQ(header.signature, MD_HEADER_SIGNATURE);
+  ASSERT_EQ(header.stream_directory_rva, sizeof(MDRawHeader));
+  for (size_t i = 0; i < 2000; ++i)
+    ASSERT_EQ(buffer[sizeof(MDRawHeader) + i],
+              static_cast<unsigned char>(i % 1000 * 3));
+  return true;
+}
+
+// Past the sequential limit, with no spill directory, allocations fail
+// rather than taking more memory.
+static bool LimitSequentialMemory() {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  {
+    MinidumpFileWriter writer;
+    writer.SetFile(fds[1]);
+    writer.set_sequential_limit(1500);
+    writer.set_spill_directory(NULL);
+    google_breakpad::UntypedMDRVA block(&writer);
+    ASSERT_TRUE(block.Allocate(1000));
+    google_breakpad::UntypedMDRVA second_block(&writer);
+    ASSERT_TRUE(!second_block.Allocate(1000));
+  }
+  close(fds[1]);
+  close(fds[0]);
+  return true;
+}
+
+// A minidump that fills the sequential limit exactly stays in memory, and
+// the first byte past it needs the spill directory.  With |spill_directory|,
+// that byte moves the minidump to a spill file, which comes out of the pipe
+// unchanged.
+static bool FillSequentialLimit(const char* spill_directory) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  unsigned char data[1024];
+  for (size_t i = 0; i < sizeof(data); ++i)
+    data[i] = static_cast<unsigned char>(i * 5);
+  {
+    MinidumpFileWriter writer;
+    writer.SetFile(fds[1]);
+    writer.set_sequential_limit(2 * sizeof(data));
+    writer.set_spill_directory(spill_directory);
+    google_breakpad::UntypedMDRVA block(&writer);
+    ASSERT_TRUE(block.Allocate(sizeof(data)));
+    ASSERT_TRUE(block.Copy(data, sizeof(data)));
+    google_breakpad::UntypedMDRVA second_block(&writer);
+    ASSERT_TRUE(second_block.Allocate(sizeof(data)));
+    ASSERT_TRUE(second_block.Copy(data, sizeof(data)));
+    google_breakpad::UntypedMDRVA past_limit(&writer);
+    if (spill_directory) {
+      ASSERT_TRUE(past_limit.Allocate(1));
+      ASSERT_TRUE(past_limit.Copy(data, 1));
+    } else {
+      ASSERT_TRUE(!past_limit.Allocate(1));
+    }
+    ASSERT_TRUE(writer.Finish());
+  }
+  close(fds[1]);
+
+  unsigned char buffer[4000];
+  size_t size = 0;
+  ssize_t count;
+  while ((count = read(fds[0], buffer + size, sizeof(buffer) - size)) > 0)
+    size += count;
+  close(fds[0]);
+  ASSERT_EQ(size, spill_directory ? 2 * sizeof(data) + 8 : 2 * sizeof(data));
+  for (size_t i = 0; i < 2 * sizeof(data); ++i)
+    ASSERT_EQ(buffer[i], data[i % sizeof(data)]);
+  if (spill_directory)
+    ASSERT_EQ(buffer[2 * sizeof(data)], data[0]);
+  return true;
+}
+
+// If the spill file can't be made, or the minidump can't be written to
+// it, allocations past the sequential limit fail.
+static bool FailToSpill() {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  {
+    MinidumpFileWriter writer;
+    writer.SetFile(fds[1]);
+    writer.set_sequential_limit(1500);
+    writer.set_spill_directory("/nonexistent/minidump_file_writer_unittest");
+    google_breakpad::UntypedMDRVA block(&writer);
+    ASSERT_TRUE(block.Allocate(1000));
+    google_breakpad::UntypedMDRVA second_block(&writer);
+    ASSERT_TRUE(!second_block.Allocate(1000));
+  }
+
+  // Files may not grow past 1000 bytes, so the 1400 already laid out
+  // can't be moved to the spill file.
+  struct rlimit old_limit;
+  ASSERT_EQ(getrlimit(RLIMIT_FSIZE, &old_limit), 0);
+  struct rlimit limit = old_limit;
+  limit.rlim_cur = 1000;
+  void (*old_handler)(int) = signal(SIGXFSZ, SIG_IGN);
+  ASSERT_EQ(setrlimit(RLIMIT_FSIZE, &limit), 0);
+  bool spilled;
+  {
+    MinidumpFileWriter writer;
+    writer.SetFile(fds[1]);
+    writer.set_sequential_limit(1500);
+    writer.set_spill_directory("/tmp");
+    google_breakpad::UntypedMDRVA block(&writer);
+    spilled = !block.Allocate(1400);
+    google_breakpad::UntypedMDRVA second_block(&writer);
+    spilled = spilled || second_block.Allocate(1000);
+  }
+  setrlimit(RLIMIT_FSIZE, &old_limit);
+  signal(SIGXFSZ, old_handler);
+  ASSERT_TRUE(!spilled);
+  close(fds[1]);
+  close(fds[0]);
+  return true;
+}
+
+// A sequential minidump that can't all be written to its file fails to
+// finish, however often it is asked to, rather than passing for a whole one.
+static bool FailToWriteSequential() {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  close(fds[0]);
+  void (*old_handler)(int) = signal(SIGPIPE, SIG_IGN);
+  bool finished;
+  {
+    MinidumpFileWriter writer;
+    writer.SetFile(fds[1]);
+    unsigned char data[1000] = {};
+    google_breakpad::UntypedMDRVA block(&writer);
+    ASSERT_TRUE(block.Allocate(sizeof(data)));
+    ASSERT_TRUE(block.Copy(data, sizeof(data)));
+    finished = writer.Finish() || writer.Finish();
+  }
+  signal(SIGPIPE, old_handler);
+  close(fds[1]);
+  ASSERT_TRUE(!finished);
+  return true;
+}
+
 static bool RunTests() {
   const char* path = "/tmp/minidump_file_writer_unittest.dmp";
   ASSERT_TRUE(WriteFile(path));
   ASSERT_TRUE(CompareFile(path));
   unlink(path);
+  ASSERT_TRUE(WriteAndCompareBufferedFile(path, false, false));
+  unlink(path);
+  ASSERT_TRUE(WriteAndCompareBufferedFile(path, true, false));
+  unlink(path);
+  ASSERT_TRUE(WriteAndCompareBufferedFile(path, false, true));
+  unlink(path);
+  ASSERT_TRUE(WriteToPipe(NULL));
+  ASSERT_TRUE(WriteToPipe("/tmp"));
+  ASSERT_TRUE(LimitSequentialMemory());
+  ASSERT_TRUE(FillSequentialLimit(NULL));
+  ASSERT_TRUE(FillSequentialLimit("/tmp"));
+  ASSERT_TRUE(FailToSpill());
+  ASSERT_TRUE(FailToWriteSequential());
   return true;
 }
 
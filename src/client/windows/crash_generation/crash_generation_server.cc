@@ -32,6 +32,7 @@
 
 #include "client/windows/crash_generation/crash_generation_server.h"
 #include <windows.h>
+#include <algorithm>
 #include <cassert>
 #include <list>
 #include "client/windows/common/auto_critical_section.h"
@@ -74,10 +75,16 @@ static const DWORD kPipeMode = PIPE_TYPE_MESSAGE |
 // finish very quickly.
 static const ULONG kPipeIOThreadFlags = WT_EXECUTEINWAITTHREAD;
 
-// Dump request threads will, most likely, generate dumps. That may
-// take some time to finish, so specify WT_EXECUTELONGFUNCTION flag.
-static const ULONG kDumpRequestThreadFlags = WT_EXECUTEINWAITTHREAD |
-                                             WT_EXECUTELONGFUNCTION;
+// Dump request callbacks only queue the request for a dump worker, so
+// they also execute in the wait thread.
+static const ULONG kDumpRequestThreadFlags = WT_EXECUTEINWAITTHREAD;
+
+// Dump workers generate dumps. That may take some time to finish, so
+// specify WT_EXECUTELONGFUNCTION flag.
+static const ULONG kDumpWorkerThreadFlags = WT_EXECUTELONGFUNCTION;
+
+// Interval at which to check whether dump workers have finished.
+static const DWORD kDumpWorkerPollMs = 10;
 
 static bool IsClientRequestValid(const ProtocolMessage& msg) {
   return msg.tag == MESSAGE_TAG_UPLOAD_REQUEST ||
@@ -110,7 +117,9 @@ CrashGenerationServer::CrashGenerationServer(
     void* upload_context,
     bool generate_dumps,
     const std::wstring* dump_path)
-    : pipe_name_(pipe_name),
+    : dump_workers_(0),
+      max_concurrent_dumps_(1),
+      pipe_name_(pipe_name),
       pipe_sec_attrs_(pipe_sec_attrs),
       pipe_(NULL),
       pipe_wait_handle_(NULL),
@@ -126,11 +135,13 @@ CrashGenerationServer::CrashGenerationServer(
       generate_dumps_(generate_dumps),
       pre_fetch_custom_info_(true),
       dump_path_(dump_path ? *dump_path : L""),
+      memory_policy_(NULL),
       server_state_(IPC_SERVER_STATE_UNINITIALIZED),
       shutting_down_(false),
       overlapped_(),
       client_info_(NULL) {
   InitializeCriticalSection(&sync_);
+  InitializeCriticalSection(&dbghelp_sync_);
 }
 
 // This should never be called from the OnPipeConnected callback.
@@ -176,6 +187,18 @@ CrashGenerationServer::~CrashGenerationServer() {
     CloseHandle(pipe_);
   }
 
+  // Dump workers take no more requests once shutting_down_ is set. Wait for
+  // those handling a request to finish before the clients are destroyed.
+  for (;;) {
+    {
+      AutoCriticalSection lock(&sync_);
+      if (dump_workers_ == 0) {
+        break;
+      }
+    }
+    Sleep(kDumpWorkerPollMs);
+  }
+
   // Request all ClientInfo objects to unregister all waits.
   // No need to enter the critical section because no one is allowed to modify
   // the clients_ list once the shutting_down_ flag is set.
@@ -208,6 +231,7 @@ CrashGenerationServer::~CrashGenerationServer() {
     CloseHandle(overlapped_.hEvent);
   }
 
+  DeleteCriticalSection(&dbghelp_sync_);
   DeleteCriticalSection(&sync_);
 }
 
@@ -827,12 +851,100 @@ void CALLBACK CrashGenerationServer::OnDumpRequest(void* context, BOOLEAN) {
 
   CrashGenerationServer* crash_server = client_info->crash_server();
   assert(crash_server);
-  if (crash_server->pre_fetch_custom_info_) {
-    client_info->PopulateCustomInfo();
-  }
-  crash_server->HandleDumpRequest(*client_info);
 
+  // The client waits for the dump to be generated before it requests
+  // another, so the event can be reset as soon as the request is queued.
   ResetEvent(client_info->dump_requested_handle());
+  crash_server->QueueDumpRequest(client_info);
+}
+
+// static
+DWORD WINAPI CrashGenerationServer::DumpWorkerThread(void* context) {
+  assert(context);
+  CrashGenerationServer* crash_server =
+      reinterpret_cast<CrashGenerationServer*>(context);
+  crash_server->RunDumpWorker();
+  return 0;
+}
+
+void CrashGenerationServer::QueueDumpRequest(ClientInfo* client_info) {
+  bool start_worker = false;
+  {
+    AutoCriticalSection lock(&sync_);
+    if (shutting_down_) {
+      return;
+    }
+    if (std::find(dump_queue_.begin(), dump_queue_.end(), client_info) ==
+        dump_queue_.end()) {
+      dump_queue_.push_back(client_info);
+    }
+    if (dump_workers_ < max_concurrent_dumps_) {
+      ++dump_workers_;
+      start_worker = true;
+    }
+  }
+
+  if (start_worker &&
+      !QueueUserWorkItem(DumpWorkerThread, this, kDumpWorkerThreadFlags)) {
+    // Handle the request here rather than leave it queued with no worker.
+    RunDumpWorker();
+  }
+}
+
+void CrashGenerationServer::RunDumpWorker() {
+  for (;;) {
+    ClientInfo* client_info = NULL;
+    {
+      AutoCriticalSection lock(&sync_);
+      if (!shutting_down_) {
+        // Take the client that has waited longest, skipping any whose
+        // previous request is still being handled so that each client's
+        // requests are handled in order.
+        std::list<ClientInfo*>::iterator iter;
+        for (iter = dump_queue_.begin(); iter != dump_queue_.end(); ++iter) {
+          if (std::find(dumping_clients_.begin(), dumping_clients_.end(),
+                        *iter) == dumping_clients_.end()) {
+            client_info = *iter;
+            dump_queue_.erase(iter);
+            dumping_clients_.push_back(client_info);
+            break;
+          }
+        }
+      } else {
+        dump_queue_.clear();
+      }
+
+      if (!client_info) {
+        --dump_workers_;
+        return;
+      }
+    }
+
+    if (pre_fetch_custom_info_) {
+      client_info->PopulateCustomInfo();
+    }
+    HandleDumpRequest(*client_info);
+
+    {
+      AutoCriticalSection lock(&sync_);
+      dumping_clients_.remove(client_info);
+    }
+  }
+}
+
+void CrashGenerationServer::WaitForClientDumps(ClientInfo* client_info) {
+  for (;;) {
+    {
+      AutoCriticalSection lock(&sync_);
+      if (std::find(dump_queue_.begin(), dump_queue_.end(), client_info) ==
+              dump_queue_.end() &&
+          std::find(dumping_clients_.begin(), dumping_clients_.end(),
+                    client_info) == dumping_clients_.end()) {
+        return;
+      }
+    }
+    Sleep(kDumpWorkerPollMs);
+  }
 }
 
 // static
@@ -853,6 +965,7 @@ void CrashGenerationServer::HandleClientProcessExit(ClientInfo* client_info) {
   // dump requests that might be pending to finish before proceeding
   // with the client_info cleanup.
   client_info->UnregisterDumpRequestWaitAndBlockUntilNoPending();
+  WaitForClientDumps(client_info);
 
   if (exit_callback_) {
     exit_callback_(exit_context_, client_info);
@@ -925,6 +1038,7 @@ bool CrashGenerationServer::GenerateDump(const ClientInfo& client,
                                    client.assert_info(),
                                    client.dump_type(),
                                    true);
+  dump_generator.SetMemoryPolicy(memory_policy_);
 
   if (!dump_generator.GenerateDumpFile(dump_path)) {
     return false;
@@ -940,6 +1054,9 @@ bool CrashGenerationServer::GenerateDump(const ClientInfo& client,
     }
   }
 
+  // DbgHelp functions are single threaded, so dumps of different clients
+  // may be generated concurrently up to this point only.
+  AutoCriticalSection lock(&dbghelp_sync_);
   return dump_generator.WriteMinidump();
 }
 
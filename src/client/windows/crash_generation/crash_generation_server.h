@@ -105,6 +105,22 @@ class CrashGenerationServer {
     pre_fetch_custom_info_ = do_pre_fetch;
   }
 
+  // Sets how many dump requests may be handled at once, each on its own
+  // thread pool thread. Requests from one client are always handled in the
+  // order they were made, and clients waiting for a thread are served in
+  // turn. The default of 1 handles one request at a time, as the dump
+  // callback may not be safe to run concurrently. Calls into DbgHelp, which
+  // is single threaded, are serialized whatever the limit.
+  void set_max_concurrent_dumps(int max_concurrent_dumps) {
+    max_concurrent_dumps_ = max_concurrent_dumps > 0 ? max_concurrent_dumps : 1;
+  }
+
+  // Applies memory_policy to the minidumps generated for clients; see
+  // MinidumpGenerator::SetMemoryPolicy. The policy must outlive the server.
+  void set_memory_policy(const MinidumpMemoryPolicy* memory_policy) {
+    memory_policy_ = memory_policy;
+  }
+
  private:
   // Various states the client can be in during the handshake with
   // the server.
@@ -183,12 +199,27 @@ class CrashGenerationServer {
   // Handles a dump request from the client.
   void HandleDumpRequest(const ClientInfo& client_info);
 
+  // Queues a dump request from the client, starting a dump worker if fewer
+  // than max_concurrent_dumps_ are running.
+  void QueueDumpRequest(ClientInfo* client_info);
+
+  // Handles queued dump requests until there are none left that aren't
+  // from a client whose request is already being handled.
+  void RunDumpWorker();
+
+  // Blocks until no dump request from the given client is queued or being
+  // handled.
+  void WaitForClientDumps(ClientInfo* client_info);
+
   // Callback for pipe connected event.
   static void CALLBACK OnPipeConnected(void* context, BOOLEAN timer_or_wait);
 
   // Callback for a dump request.
   static void CALLBACK OnDumpRequest(void* context, BOOLEAN timer_or_wait);
 
+  // Thread pool work item running a dump worker.
+  static DWORD WINAPI DumpWorkerThread(void* context);
+
   // Callback for client process exit event.
   static void CALLBACK OnClientEnd(void* context, BOOLEAN timer_or_wait);
 
@@ -222,6 +253,22 @@ class CrashGenerationServer {
   // List of clients.
   std::list<ClientInfo*> clients_;
 
+  // Clients with a dump request waiting to be handled, oldest first. Each
+  // client appears at most once. Guarded by sync_.
+  std::list<ClientInfo*> dump_queue_;
+
+  // Clients whose dump request is being handled. Guarded by sync_.
+  std::list<ClientInfo*> dumping_clients_;
+
+  // Number of dump workers running. Guarded by sync_.
+  int dump_workers_;
+
+  // Maximum number of dump workers.
+  int max_concurrent_dumps_;
+
+  // Sync object serializing calls into DbgHelp.
+  CRITICAL_SECTION dbghelp_sync_;
+
   // Pipe name.
   std::wstring pipe_name_;
 
@@ -270,6 +317,9 @@ class CrashGenerationServer {
   // The dump path for the server.
   const std::wstring dump_path_;
 
+  // Memory policy for generated minidumps, or NULL for none.
+  const MinidumpMemoryPolicy* memory_policy_;
+
   // State of the server in performing the IPC with the client.
   // Note that since we restrict the pipe to one instance, we
   // only need to keep one state of the server. Otherwise, server
@@ -247,6 +247,216 @@ ULONG CALLBACK HandleTraceData::RecordHandleOperations(
   return ERROR_SUCCESS;
 }
 
+// State for MemoryPolicyCallback.
+struct MemoryPolicyCallbackContext {
+  // The callback set with MinidumpGenerator::SetCallback, if any.
+  MINIDUMP_CALLBACK_INFORMATION* chained;
+
+  // Bytes of each thread's stack to keep above its stack pointer.
+  ULONG stack_window;
+
+  // Memory to add, and the next range to hand to MiniDumpWriteDump.
+  std::vector<google_breakpad::MinidumpMemoryRange> include;
+  size_t next_include;
+
+  // Memory to remove, and the next range to hand to MiniDumpWriteDump.
+  std::vector<google_breakpad::MinidumpMemoryRange> remove;
+  size_t next_remove;
+};
+
+ULONG64 GetStackPointer(const CONTEXT& context) {
+#if defined(_M_IX86)
+  return context.Esp;
+#elif defined(_M_AMD64)
+  return context.Rsp;
+#elif defined(_M_ARM64)
+  return context.Sp;
+#else
+#error Unsupported platform
+#endif
+}
+
+// The most general purpose register values GetRegisterValues returns.
+const size_t kMaxRegisterValues = 33;
+
+// Copies the general purpose registers in |context| to |values|, which must
+// have room for kMaxRegisterValues of them, and returns how many there are.
+size_t GetRegisterValues(const CONTEXT& context, ULONG64* values) {
+  size_t count = 0;
+#if defined(_M_IX86)
+  values[count++] = context.Eax;
+  values[count++] = context.Ebx;
+  values[count++] = context.Ecx;
+  values[count++] = context.Edx;
+  values[count++] = context.Esi;
+  values[count++] = context.Edi;
+  values[count++] = context.Ebp;
+  values[count++] = context.Esp;
+  values[count++] = context.Eip;
+#elif defined(_M_AMD64)
+  values[count++] = context.Rax;
+  values[count++] = context.Rbx;
+  values[count++] = context.Rcx;
+  values[count++] = context.Rdx;
+  values[count++] = context.Rsi;
+  values[count++] = context.Rdi;
+  values[count++] = context.Rbp;
+  values[count++] = context.Rsp;
+  values[count++] = context.R8;
+  values[count++] = context.R9;
+  values[count++] = context.R10;
+  values[count++] = context.R11;
+  values[count++] = context.R12;
+  values[count++] = context.R13;
+  values[count++] = context.R14;
+  values[count++] = context.R15;
+  values[count++] = context.Rip;
+#elif defined(_M_ARM64)
+  for (int i = 0; i < 29; ++i) {
+    values[count++] = context.X[i];
+  }
+  values[count++] = context.Fp;
+  values[count++] = context.Lr;
+  values[count++] = context.Sp;
+  values[count++] = context.Pc;
+#else
+#error Unsupported platform
+#endif
+  assert(count <= kMaxRegisterValues);
+  return count;
+}
+
+// Appends to |ranges| up to |window| bytes of |process|'s memory centered
+// on |address|, within the committed, accessible region containing it, as
+// long as they fit in |*budget|, which is reduced by their size.
+void AddMemoryAroundAddress(HANDLE process,
+                            ULONG64 address,
+                            ULONG window,
+                            ULONG64* budget,
+                            std::vector<google_breakpad::MinidumpMemoryRange>*
+                                ranges) {
+  MEMORY_BASIC_INFORMATION info;
+  if (VirtualQueryEx(process,
+                     reinterpret_cast<LPCVOID>(address),
+                     &info,
+                     sizeof(info)) == 0 ||
+      info.State != MEM_COMMIT ||
+      (info.Protect & (PAGE_NOACCESS | PAGE_GUARD)) != 0) {
+    return;
+  }
+
+  const ULONG64 region_base = reinterpret_cast<ULONG64>(info.BaseAddress);
+  const ULONG64 region_end = region_base + info.RegionSize;
+  const ULONG64 base = address - region_base > window / 2 ?
+      address - window / 2 : region_base;
+  const ULONG64 end = (std::min)(address + window / 2, region_end);
+  if (end <= base || end - base > *budget) {
+    return;
+  }
+
+  // Registers often point close together; skip a range that's already in.
+  for (size_t i = 0; i < ranges->size(); ++i) {
+    const google_breakpad::MinidumpMemoryRange& range = (*ranges)[i];
+    if (base >= range.base && end <= range.base + range.size) {
+      return;
+    }
+  }
+
+  google_breakpad::MinidumpMemoryRange range;
+  range.base = base;
+  range.size = static_cast<ULONG>(end - base);
+  ranges->push_back(range);
+  *budget -= range.size;
+}
+
+// A MiniDumpWriteDump callback applying a MinidumpMemoryPolicy, whose
+// context is a MemoryPolicyCallbackContext. Other callback types, and
+// memory to add once the policy's is exhausted, are left to the chained
+// callback.
+BOOL CALLBACK MemoryPolicyCallback(
+    PVOID context,
+    const PMINIDUMP_CALLBACK_INPUT callback_input,
+    PMINIDUMP_CALLBACK_OUTPUT callback_output) {
+  MemoryPolicyCallbackContext* policy_context =
+      reinterpret_cast<MemoryPolicyCallbackContext*>(context);
+  MINIDUMP_CALLBACK_INFORMATION* chained = policy_context->chained;
+
+  switch (callback_input->CallbackType) {
+    case MemoryCallback:
+      if (policy_context->next_include < policy_context->include.size()) {
+        const google_breakpad::MinidumpMemoryRange& range =
+            policy_context->include[policy_context->next_include++];
+        callback_output->MemoryBase = range.base;
+        callback_output->MemorySize = range.size;
+        return TRUE;
+      }
+      break;
+
+    case RemoveMemoryCallback:
+      if (policy_context->next_remove < policy_context->remove.size()) {
+        const google_breakpad::MinidumpMemoryRange& range =
+            policy_context->remove[policy_context->next_remove++];
+        callback_output->MemoryBase = range.base;
+        callback_output->MemorySize = range.size;
+        return TRUE;
+      }
+      break;
+
+    case ThreadCallback:
+    case ThreadExCallback: {
+      BOOL result = chained ?
+          chained->CallbackRoutine(chained->CallbackParam,
+                                   callback_input, callback_output) :
+          TRUE;
+
+      // Queue the part of the stack beyond the window for removal.
+      const MINIDUMP_THREAD_CALLBACK& thread = callback_input->Thread;
+      const ULONG64 stack_low = (std::min)(thread.StackBase, thread.StackEnd);
+      const ULONG64 stack_high = (std::max)(thread.StackBase, thread.StackEnd);
+      const ULONG64 stack_pointer = GetStackPointer(thread.Context);
+      const ULONG window = policy_context->stack_window;
+      if (window && stack_pointer >= stack_low && stack_pointer < stack_high &&
+          stack_high - stack_pointer > window) {
+        google_breakpad::MinidumpMemoryRange range;
+        range.base = stack_pointer + window;
+        range.size = static_cast<ULONG>(stack_high - range.base);
+        policy_context->remove.push_back(range);
+      }
+      return result;
+    }
+
+    case ModuleCallback: {
+      BOOL result = chained ?
+          chained->CallbackRoutine(chained->CallbackParam,
+                                   callback_input, callback_output) :
+          TRUE;
+      callback_output->ModuleWriteFlags &= ~ModuleWriteDataSeg;
+      return result;
+    }
+
+    case IncludeModuleCallback:
+    case IncludeThreadCallback:
+      if (!chained) {
+        return TRUE;
+      }
+      break;
+
+    case CancelCallback:
+      if (!chained) {
+        callback_output->CheckCancel = FALSE;
+        callback_output->Cancel = FALSE;
+        return TRUE;
+      }
+      break;
+  }
+
+  if (chained) {
+    return chained->CallbackRoutine(chained->CallbackParam,
+                                    callback_input, callback_output);
+  }
+  return FALSE;
+}
+
 }  // namespace
 
 namespace google_breakpad {
@@ -280,7 +490,8 @@ MinidumpGenerator::MinidumpGenerator(
       dump_file_is_internal_(false),
       full_dump_file_is_internal_(false),
       additional_streams_(NULL),
-      callback_info_(NULL) {
+      callback_info_(NULL),
+      memory_policy_(NULL) {
   uuid_ = {0};
   InitializeCriticalSection(&module_load_sync_);
   InitializeCriticalSection(&get_proc_address_sync_);
@@ -446,19 +657,99 @@ bool MinidumpGenerator::WriteMinidump() {
     ++user_streams.UserStreamCount;
   }
 
+  MINIDUMP_TYPE minidump_type =
+      static_cast<MINIDUMP_TYPE>((dump_type_ & (~MiniDumpWithFullMemory))
+                                  | MiniDumpNormal);
+  MINIDUMP_CALLBACK_INFORMATION* minidump_callback = callback_info_;
+
+  // With a memory policy, the policy decides what memory beyond the thread
+  // stacks goes in, so drop the dump types that take memory wholesale.
+  MemoryPolicyCallbackContext policy_context;
+  MINIDUMP_CALLBACK_INFORMATION policy_callback;
+  if (memory_policy_) {
+    minidump_type = static_cast<MINIDUMP_TYPE>(
+        minidump_type & ~(MiniDumpWithPrivateReadWriteMemory |
+                          MiniDumpWithPrivateWriteCopyMemory |
+                          MiniDumpWithDataSegs |
+                          MiniDumpWithCodeSegs));
+
+    policy_context.chained = callback_info_;
+    policy_context.stack_window = memory_policy_->stack_window;
+    GetPolicyMemoryRanges(&policy_context.include);
+    policy_context.next_include = 0;
+    policy_context.next_remove = 0;
+
+    policy_callback.CallbackRoutine = MemoryPolicyCallback;
+    policy_callback.CallbackParam = &policy_context;
+    minidump_callback = &policy_callback;
+  }
+
   bool result_minidump = write_dump(
       process_handle_,
       process_id_,
       dump_file_,
-      static_cast<MINIDUMP_TYPE>((dump_type_ & (~MiniDumpWithFullMemory))
-                                  | MiniDumpNormal),
+      minidump_type,
       dump_exception_pointers,
       &user_streams,
-      callback_info_) != FALSE;
+      minidump_callback) != FALSE;
 
   return result_minidump && result_full_memory;
 }
 
+bool MinidumpGenerator::GetExceptionContext(CONTEXT* context) const {
+  if (!exception_pointers_) {
+    return false;
+  }
+
+  if (!is_client_pointers_) {
+    *context = *exception_pointers_->ContextRecord;
+    return true;
+  }
+
+  EXCEPTION_POINTERS pointers;
+  SIZE_T bytes_read = 0;
+  if (!ReadProcessMemory(process_handle_,
+                         exception_pointers_,
+                         &pointers,
+                         sizeof(pointers),
+                         &bytes_read) ||
+      bytes_read != sizeof(pointers)) {
+    return false;
+  }
+
+  return ReadProcessMemory(process_handle_,
+                           pointers.ContextRecord,
+                           context,
+                           sizeof(*context),
+                           &bytes_read) &&
+      bytes_read == sizeof(*context);
+}
+
+void MinidumpGenerator::GetPolicyMemoryRanges(
+    std::vector<MinidumpMemoryRange>* ranges) const {
+  ULONG64 budget = memory_policy_->max_added_bytes;
+
+  CONTEXT context;
+  if (memory_policy_->register_window && GetExceptionContext(&context)) {
+    ULONG64 values[kMaxRegisterValues];
+    size_t count = GetRegisterValues(context, values);
+    for (size_t i = 0; i < count; ++i) {
+      AddMemoryAroundAddress(process_handle_, values[i],
+                             memory_policy_->register_window, &budget, ranges);
+    }
+  }
+
+  const std::vector<MinidumpMemoryRange>& app_memory =
+      memory_policy_->app_memory;
+  for (size_t i = 0; i < app_memory.size(); ++i) {
+    if (app_memory[i].size > budget) {
+      continue;
+    }
+    ranges->push_back(app_memory[i]);
+    budget -= app_memory[i].size;
+  }
+}
+
 bool MinidumpGenerator::GenerateDumpFile(wstring* dump_path) {
   // The dump file was already set by handle or this function was previously
   // called.
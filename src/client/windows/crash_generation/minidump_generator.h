@@ -34,10 +34,49 @@
 #include <rpc.h>
 #include <list>
 #include <string>
+#include <vector>
 #include "google_breakpad/common/minidump_format.h"
 
 namespace google_breakpad {
 
+// A range of memory in the process being dumped.
+struct MinidumpMemoryRange {
+  ULONG64 base;
+  ULONG size;
+};
+
+// Bounds the memory written to the minidump, so that its size and the time
+// taken to write it don't grow with the size of the process. With a policy
+// set, the minidump holds:
+//  - each thread's stack, up to stack_window bytes above its stack pointer;
+//  - register_window bytes around each crashing thread register value that
+//    points into committed memory;
+//  - the app_memory ranges the application registered;
+// and no private read-write memory or image data sections, whatever the
+// dump type asks for. The full memory dump, if any, is not affected.
+struct MinidumpMemoryPolicy {
+  MinidumpMemoryPolicy()
+      : stack_window(64 * 1024),
+        register_window(1024),
+        max_added_bytes(4 * 1024 * 1024) {}
+
+  // Bytes of each thread's stack to keep, from its stack pointer up; 0
+  // keeps all of it.
+  ULONG stack_window;
+
+  // Bytes of memory to include around each register value of the crashing
+  // thread; 0 includes none.
+  ULONG register_window;
+
+  // Ranges to include, such as those the client registered with
+  // ExceptionHandler::RegisterAppMemory.
+  std::vector<MinidumpMemoryRange> app_memory;
+
+  // The most memory the register windows and app_memory may add together.
+  // Register windows are added first.
+  ULONG64 max_added_bytes;
+};
+
 // Abstraction for various objects and operations needed to generate
 // minidump on Windows. This abstraction is useful to hide all the gory
 // details for minidump generation and provide a clean interface to
@@ -89,6 +128,13 @@ class MinidumpGenerator {
     callback_info_ = callback_info;
   }
 
+  // Applies memory_policy to the minidump. Any callback set by SetCallback
+  // is still called, and may add memory of its own. The policy must outlive
+  // the call to WriteMinidump.
+  void SetMemoryPolicy(const MinidumpMemoryPolicy* memory_policy) {
+    memory_policy_ = memory_policy;
+  }
+
   // Writes the minidump with the given parameters. Stores the
   // dump file path in the dump_path parameter if dump generation
   // succeeds.
@@ -126,6 +172,13 @@ class MinidumpGenerator {
   // Returns the path for the file to write dump to.
   bool GenerateDumpFilePath(std::wstring* file_path);
 
+  // Copies the crashing thread's context from the exception information.
+  bool GetExceptionContext(CONTEXT* context) const;
+
+  // Appends to ranges the memory memory_policy_ includes beyond what
+  // MiniDumpWriteDump writes itself.
+  void GetPolicyMemoryRanges(std::vector<MinidumpMemoryRange>* ranges) const;
+
   // Handle to dynamically loaded DbgHelp.dll.
   HMODULE dbghelp_module_;
 
@@ -189,6 +242,9 @@ class MinidumpGenerator {
   // The user defined callback for the various stages of the dump process.
   MINIDUMP_CALLBACK_INFORMATION* callback_info_;
 
+  // The memory policy for the minidump, or NULL for none.
+  const MinidumpMemoryPolicy* memory_policy_;
+
   // Critical section to sychronize action of loading modules dynamically.
   CRITICAL_SECTION module_load_sync_;
 
@@ -38,6 +38,8 @@
 
 #include "common/windows/string_utils-inl.h"
 
+#include "client/crash_signature.h"
+#include "client/dump_timing.h"
 #include "client/windows/common/ipc_protocol.h"
 #include "client/windows/handler/exception_handler.h"
 #include "common/windows/guid_string.h"
@@ -50,6 +52,174 @@ typedef struct {
   AppMemoryList::const_iterator end;
 } MinidumpCallbackContext;
 
+// The placeholder for the timing stream that is passed to
+// MiniDumpWriteDump, and later written over with the timing of that call.
+typedef struct {
+  MDRawDumpTimingList list;
+  MDRawDumpPhaseTiming phases[2];
+} DumpTimingUserStream;
+
+// Writes |size| bytes of |data| over the stream of type |stream_type| in the
+// minidump |file|, whose size must be |size|.  Returns false if the stream
+// could not be found or written.
+static bool OverwriteUserStream(HANDLE file, uint32_t stream_type,
+                                const void* data, DWORD size) {
+  MDRawHeader header;
+  DWORD bytes_read;
+  LARGE_INTEGER offset;
+  offset.QuadPart = 0;
+  if (!SetFilePointerEx(file, offset, NULL, FILE_BEGIN) ||
+      !ReadFile(file, &header, sizeof(header), &bytes_read, NULL) ||
+      bytes_read != sizeof(header) ||
+      header.signature != MD_HEADER_SIGNATURE) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < header.stream_count; ++i) {
+    MDRawDirectory entry;
+    offset.QuadPart = header.stream_directory_rva + i * sizeof(entry);
+    if (!SetFilePointerEx(file, offset, NULL, FILE_BEGIN) ||
+        !ReadFile(file, &entry, sizeof(entry), &bytes_read, NULL) ||
+        bytes_read != sizeof(entry)) {
+      return false;
+    }
+    if (entry.stream_type != stream_type)
+      continue;
+    if (entry.location.data_size != size)
+      return false;
+
+    DWORD bytes_written;
+    offset.QuadPart = entry.location.rva;
+    return SetFilePointerEx(file, offset, NULL, FILE_BEGIN) &&
+           WriteFile(file, data, size, &bytes_written, NULL) &&
+           bytes_written == size;
+  }
+  return false;
+}
+
+// The CodeView record that links a module to its PDB, whose GUID and age
+// identify the build.
+typedef struct {
+  DWORD signature;  // 'RSDS'
+  GUID guid;
+  DWORD age;
+} CodeViewRecord;
+
+// Sets |identifier| to the GUID and age of the loaded |module|, or, failing
+// those, to its link time and size, and returns how many bytes it set.
+static size_t GetModuleIdentifier(HMODULE module, uint8_t identifier[20]) {
+  const uint8_t* base = reinterpret_cast<const uint8_t*>(module);
+  const IMAGE_DOS_HEADER* dos_header =
+      reinterpret_cast<const IMAGE_DOS_HEADER*>(base);
+  if (dos_header->e_magic != IMAGE_DOS_SIGNATURE)
+    return 0;
+  const IMAGE_NT_HEADERS* nt_headers =
+      reinterpret_cast<const IMAGE_NT_HEADERS*>(base + dos_header->e_lfanew);
+  if (nt_headers->Signature != IMAGE_NT_SIGNATURE)
+    return 0;
+
+  const IMAGE_DATA_DIRECTORY& debug_directory =
+      nt_headers->OptionalHeader.DataDirectory[IMAGE_DIRECTORY_ENTRY_DEBUG];
+  const IMAGE_DEBUG_DIRECTORY* entries =
+      reinterpret_cast<const IMAGE_DEBUG_DIRECTORY*>(
+          base + debug_directory.VirtualAddress);
+  size_t entry_count = debug_directory.VirtualAddress ?
+      debug_directory.Size / sizeof(IMAGE_DEBUG_DIRECTORY) : 0;
+  for (size_t i = 0; i < entry_count; ++i) {
+    if (entries[i].Type != IMAGE_DEBUG_TYPE_CODEVIEW ||
+        entries[i].AddressOfRawData == 0 ||
+        entries[i].SizeOfData < sizeof(CodeViewRecord)) {
+      continue;
+    }
+    const CodeViewRecord* record = reinterpret_cast<const CodeViewRecord*>(
+        base + entries[i].AddressOfRawData);
+    if (record->signature != MD_CVINFOPDB70_SIGNATURE)
+      continue;
+    memcpy(identifier, &record->guid, sizeof(record->guid));
+    memcpy(identifier + sizeof(record->guid), &record->age,
+           sizeof(record->age));
+    return sizeof(record->guid) + sizeof(record->age);
+  }
+
+  DWORD time_date_stamp = nt_headers->FileHeader.TimeDateStamp;
+  DWORD size_of_image = nt_headers->OptionalHeader.SizeOfImage;
+  memcpy(identifier, &time_date_stamp, sizeof(time_date_stamp));
+  memcpy(identifier + sizeof(time_date_stamp), &size_of_image,
+         sizeof(size_of_image));
+  return sizeof(time_date_stamp) + sizeof(size_of_image);
+}
+
+// Returns the signature of the crash in |context|, made of up to
+// |max_frames| frames found in loaded modules.  The stack is walked with
+// the unwind tables on x64 and by following frame pointers elsewhere.
+static CrashSignature GetCrashSignature(const CONTEXT* context,
+                                        size_t max_frames) {
+  uintptr_t addresses[CrashSignature::kMaxFrames];
+  if (max_frames > CrashSignature::kMaxFrames)
+    max_frames = CrashSignature::kMaxFrames;
+  size_t address_count = 0;
+#if defined(_M_X64)
+  CONTEXT unwind_context = *context;
+  while (address_count < max_frames && unwind_context.Rip) {
+    addresses[address_count++] = unwind_context.Rip;
+    DWORD64 image_base;
+    PRUNTIME_FUNCTION function =
+        RtlLookupFunctionEntry(unwind_context.Rip, &image_base, NULL);
+    if (!function) {
+      // A leaf function: the return address is on top of the stack.
+      unwind_context.Rip = *reinterpret_cast<DWORD64*>(unwind_context.Rsp);
+      unwind_context.Rsp += sizeof(DWORD64);
+      continue;
+    }
+    void* handler_data;
+    DWORD64 establisher_frame;
+    RtlVirtualUnwind(UNW_FLAG_NHANDLER, image_base, unwind_context.Rip,
+                     function, &unwind_context, &handler_data,
+                     &establisher_frame, NULL);
+  }
+#else
+#if defined(_M_IX86)
+  addresses[address_count++] = context->Eip;
+  uintptr_t frame_pointer = context->Ebp;
+  uintptr_t stack_pointer = context->Esp;
+#elif defined(_M_ARM64)
+  addresses[address_count++] = context->Pc;
+  uintptr_t frame_pointer = context->Fp;
+  uintptr_t stack_pointer = context->Sp;
+#else
+  return CrashSignature();
+#endif
+  // The committed region holding the stack pointer runs up to the base of
+  // the stack.
+  MEMORY_BASIC_INFORMATION info;
+  if (max_frames > 1 &&
+      VirtualQuery(reinterpret_cast<LPCVOID>(stack_pointer), &info,
+                   sizeof(info)) != 0) {
+    uintptr_t stack_high =
+        reinterpret_cast<uintptr_t>(info.BaseAddress) + info.RegionSize;
+    address_count += WalkFramePointers(frame_pointer, stack_pointer,
+                                       stack_high, addresses + 1,
+                                       max_frames - 1);
+  }
+#endif
+
+  CrashSignature signature;
+  for (size_t i = 0; i < address_count; ++i) {
+    HMODULE module;
+    uint8_t identifier[20];
+    size_t identifier_size;
+    if (GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                               GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                           reinterpret_cast<LPCWSTR>(addresses[i]),
+                           &module) &&
+        (identifier_size = GetModuleIdentifier(module, identifier)) != 0) {
+      signature.AddFrame(identifier, identifier_size,
+                         addresses[i] - reinterpret_cast<uintptr_t>(module));
+    }
+  }
+  return signature;
+}
+
 // This define is new to Windows 10.
 #ifndef DBG_PRINTEXCEPTION_WIDE_C
 #define DBG_PRINTEXCEPTION_WIDE_C ((DWORD)0x4001000A)
@@ -177,6 +347,8 @@ void ExceptionHandler::Initialize(
   handler_return_value_ = false;
   handle_debug_exceptions_ = false;
   consume_invalid_handle_exceptions_ = false;
+  crash_signature_frames_ = 0;
+  crash_signature_ = 0;
 
   // Attempt to use out-of-process if user has specified a pipe or a
   // crash generation client.
@@ -918,10 +1090,16 @@ bool ExceptionHandler::WriteMinidumpWithExceptionForProcess(
     MDRawAssertionInfo* assertion,
     HANDLE process,
     bool write_requester_stream) {
+  // MiniDumpWriteDump suspends the threads and reads the modules and
+  // stacks itself, so the call is timed as a whole.
+  DumpTiming timing;
+  timing.Begin(MD_DUMP_PHASE_TOTAL);
+
   bool success = false;
   if (minidump_write_dump_) {
+    // The file is read as well as written, to find the timing stream.
     HANDLE dump_file = CreateFile(next_minidump_path_c_,
-                                  GENERIC_WRITE,
+                                  GENERIC_READ | GENERIC_WRITE,
                                   0,  // no sharing
                                   NULL,
                                   CREATE_NEW,  // fail if exists
@@ -934,8 +1112,8 @@ bool ExceptionHandler::WriteMinidumpWithExceptionForProcess(
       except_info.ClientPointers = FALSE;
 
       // Leave room in user_stream_array for possible breakpad and
-      // assertion info streams.
-      MINIDUMP_USER_STREAM user_stream_array[2];
+      // assertion info streams, and for the signature and timing streams.
+      MINIDUMP_USER_STREAM user_stream_array[4];
       MINIDUMP_USER_STREAM_INFORMATION user_streams;
       user_streams.UserStreamCount = 0;
       user_streams.UserStreamArray = user_stream_array;
@@ -1011,6 +1189,40 @@ bool ExceptionHandler::WriteMinidumpWithExceptionForProcess(
         }
       }
 
+      // Sign dumps of exceptions in this process, whose modules can be
+      // read directly.
+      crash_signature_ = 0;
+      MDRawCrashSignature signature_stream;
+      if (crash_signature_frames_ > 0 && exinfo &&
+          GetProcessId(process) == GetCurrentProcessId()) {
+        CrashSignature signature =
+            GetCrashSignature(exinfo->ContextRecord, crash_signature_frames_);
+        if (signature.frame_count() > 0) {
+          signature.GetRaw(&signature_stream);
+          crash_signature_ = signature.signature();
+          int index = user_streams.UserStreamCount;
+          user_stream_array[index].Type = MD_CRASH_SIGNATURE_STREAM;
+          user_stream_array[index].BufferSize = sizeof(signature_stream);
+          user_stream_array[index].Buffer = &signature_stream;
+          ++user_streams.UserStreamCount;
+        }
+      }
+
+      // Add a placeholder for the timing stream, to be filled in once the
+      // dump has been written.
+      DumpTimingUserStream timing_stream;
+      memset(&timing_stream, 0, sizeof(timing_stream));
+      timing_stream.list.size_of_header = sizeof(timing_stream.list);
+      timing_stream.list.size_of_entry = sizeof(timing_stream.phases[0]);
+      timing_stream.list.number_of_entries = 2;
+      {
+        int index = user_streams.UserStreamCount;
+        user_stream_array[index].Type = MD_DUMP_TIMING_STREAM;
+        user_stream_array[index].BufferSize = sizeof(timing_stream);
+        user_stream_array[index].Buffer = &timing_stream;
+        ++user_streams.UserStreamCount;
+      }
+
       MinidumpCallbackContext context;
       context.iter = app_memory_info_.begin();
       context.end = app_memory_info_.end();
@@ -1024,6 +1236,7 @@ bool ExceptionHandler::WriteMinidumpWithExceptionForProcess(
       callback.CallbackRoutine = MinidumpWriteDumpCallback;
       callback.CallbackParam = reinterpret_cast<void*>(&context);
 
+      timing.Begin(MD_DUMP_PHASE_WRITE_FLUSH);
       // The explicit comparison to TRUE avoids a warning (C4800).
       success = (minidump_write_dump_(process,
                                       GetProcessId(process),
@@ -1033,6 +1246,21 @@ bool ExceptionHandler::WriteMinidumpWithExceptionForProcess(
                                       &user_streams,
                                       &callback) == TRUE);
 
+      if (success) {
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx(dump_file, &file_size))
+          file_size.QuadPart = 0;
+        timing.End(MD_DUMP_PHASE_WRITE_FLUSH, 0, file_size.QuadPart);
+        timing.End(MD_DUMP_PHASE_TOTAL);
+        MDRawDumpPhaseTiming phases[MD_DUMP_PHASE_COUNT];
+        if (timing.GetEntries(phases) == 2) {
+          memcpy(timing_stream.phases, phases, sizeof(timing_stream.phases));
+          // A dump without its timing is still a good dump.
+          OverwriteUserStream(dump_file, MD_DUMP_TIMING_STREAM,
+                              &timing_stream, sizeof(timing_stream));
+        }
+      }
+
       CloseHandle(dump_file);
     }
   }
@@ -273,6 +273,18 @@ class ExceptionHandler {
     consume_invalid_handle_exceptions_ = consume_invalid_handle_exceptions;
   }
 
+  // Controls how many frames, counting the one that crashed, go into the
+  // crash signature written to in-process dumps of exceptions.  0, the
+  // default, writes no signature.
+  int get_crash_signature_frames() const { return crash_signature_frames_; }
+  void set_crash_signature_frames(int crash_signature_frames) {
+    crash_signature_frames_ = crash_signature_frames;
+  }
+
+  // The crash signature of the last dump written, or 0 if it had none.
+  // The minidump callback may pass it on to an uploader.
+  uint64_t crash_signature() const { return crash_signature_; }
+
   // Returns whether out-of-process dump generation is used or not.
   bool IsOutOfProcess() const { return crash_generation_client_.get() != NULL; }
 
@@ -486,6 +498,10 @@ class ExceptionHandler {
   // Leave this false (the default) to handle these exceptions as normal.
   bool consume_invalid_handle_exceptions_;
 
+  // The number of frames to sign dumps with, and the last signature.
+  int crash_signature_frames_;
+  uint64_t crash_signature_;
+
   // Callers can request additional memory regions to be included in
   // the dump.
   AppMemoryList app_memory_info_;
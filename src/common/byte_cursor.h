@@ -44,6 +44,7 @@
 #include <string.h>
 #include <string>
 
+#include "common/byte_swap.h"
 #include "common/using_std_string.h"
 
 namespace google_breakpad {
@@ -84,11 +85,15 @@ class ByteCursor {
   // cursor reads multi-byte values in little-endian form.
   ByteCursor(const ByteBuffer* buffer, bool big_endian = false)
       : buffer_(buffer), here_(buffer->start),
-        big_endian_(big_endian), complete_(true) { }
+        big_endian_(big_endian), swap_(big_endian != HostIsBigEndian()),
+        complete_(true) { }
 
   // Accessor and setter for this cursor's endianness flag.
   bool big_endian() const { return big_endian_; }
-  void set_big_endian(bool big_endian) { big_endian_ = big_endian; }
+  void set_big_endian(bool big_endian) {
+    big_endian_ = big_endian;
+    swap_ = big_endian != HostIsBigEndian();
+  }
 
   // Accessor and setter for this cursor's current position. The setter
   // returns a reference to this cursor.
@@ -119,14 +124,33 @@ class ByteCursor {
   ByteCursor& Read(size_t size, bool is_signed, T* result) {
     if (CheckAvailable(size)) {
       T v = 0;
-      if (big_endian_) {
-        for (size_t i = 0; i < size; i++)
-          v = (v << 8) + here_[i];
-      } else {
-        // This loop condition looks weird, but size_t is unsigned, so
-        // decrementing i after it is zero yields the largest size_t value.
-        for (size_t i = size - 1; i < size; i--)
-          v = (v << 8) + here_[i];
+      // Most reads are of whole 1, 2, 4 or 8 byte fields; load those in a
+      // single access.
+      switch (size) {
+        case 1:
+          v = here_[0];
+          break;
+        case 2:
+          v = LoadSwapped<uint16_t>(here_, swap_);
+          break;
+        case 4:
+          v = LoadSwapped<uint32_t>(here_, swap_);
+          break;
+        case 8:
+          v = static_cast<T>(LoadSwapped<uint64_t>(here_, swap_));
+          break;
+        default:
+          if (big_endian_) {
+            for (size_t i = 0; i < size; i++)
+              v = (v << 8) + here_[i];
+          } else {
+            // This loop condition looks weird, but size_t is unsigned, so
+            // decrementing i after it is zero yields the largest size_t
+            // value.
+            for (size_t i = size - 1; i < size; i--)
+              v = (v << 8) + here_[i];
+          }
+          break;
       }
       if (is_signed && size < sizeof(T)) {
         size_t sign_bit = (T)1 << (size * 8 - 1);
@@ -256,6 +280,9 @@ class ByteCursor {
   // should read in little-endian form.
   bool big_endian_;
 
+  // True if numbers' byte order differs from the host's.
+  bool swap_;
+
   // True if we've been able to read all we've been asked to.
   bool complete_;
 };
@@ -0,0 +1,87 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// byte_swap.h: Load fixed-size integers stored in either byte order.
+//
+// Binary format readers such as ByteCursor and dwarf::ByteReader learn a
+// file's byte order once, and then read many integers in it.  These
+// helpers load an integer whole and reverse its bytes only if the file's
+// order isn't the host's; compilers turn both the load and the reversal
+// into single instructions.
+
+#ifndef COMMON_BYTE_SWAP_H_
+#define COMMON_BYTE_SWAP_H_
+
+#include <stdint.h>
+#include <string.h>
+
+namespace google_breakpad {
+
+// Return true if the host stores integers with the most significant byte
+// first.
+inline bool HostIsBigEndian() {
+  const uint16_t probe = 1;
+  uint8_t first_byte;
+  memcpy(&first_byte, &probe, 1);
+  return first_byte == 0;
+}
+
+// Return VALUE with its bytes in the opposite order.
+inline uint8_t ByteSwap(uint8_t value) {
+  return value;
+}
+
+inline uint16_t ByteSwap(uint16_t value) {
+  return static_cast<uint16_t>(value >> 8 | value << 8);
+}
+
+inline uint32_t ByteSwap(uint32_t value) {
+  return value >> 24 | (value >> 8 & 0xff00) |
+         (value << 8 & 0xff0000) | value << 24;
+}
+
+inline uint64_t ByteSwap(uint64_t value) {
+  value = (value >> 8 & 0x00ff00ff00ff00ffULL) |
+          (value << 8 & 0xff00ff00ff00ff00ULL);
+  value = (value >> 16 & 0x0000ffff0000ffffULL) |
+          (value << 16 & 0xffff0000ffff0000ULL);
+  return value >> 32 | value << 32;
+}
+
+// Return the unsigned integer of type T stored at BUFFER, reversing its
+// bytes if SWAP is true.  BUFFER need not be aligned.
+template<typename T>
+inline T LoadSwapped(const uint8_t* buffer, bool swap) {
+  T value;
+  memcpy(&value, buffer, sizeof(value));
+  return swap ? ByteSwap(value) : value;
+}
+
+}  // namespace google_breakpad
+
+#endif  // COMMON_BYTE_SWAP_H_
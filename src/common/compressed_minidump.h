@@ -0,0 +1,74 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// compressed_minidump.h: The layout of a compressed minidump.
+//
+// A compressed minidump starts with a CompressedMinidumpHeader, followed
+// by frames.  Each frame is a CompressedMinidumpFrame followed by
+// |stored_size| bytes: an LZ4 block (see common/lz4_block.h) that
+// decompresses to |raw_size| bytes, or, when the two sizes are equal, the
+// raw bytes themselves.  The raw bytes of a frame are a list of segments,
+// each a CompressedMinidumpSegment followed by |size| bytes of the
+// minidump at |position|.  Segments apply in order, so a later segment
+// replaces any bytes an earlier one put in the same place, and the
+// minidump is as long as the furthest end of any segment.
+//
+// Bytes of the minidump that no segment covers are zero.  All fields are
+// in the byte order of the machine that wrote the dump; a reader can tell
+// which that was from |magic|.
+
+#ifndef COMMON_COMPRESSED_MINIDUMP_H_
+#define COMMON_COMPRESSED_MINIDUMP_H_
+
+#include <stdint.h>
+
+namespace google_breakpad {
+
+// "BPLZ" in the byte order of the writer.
+const uint32_t kCompressedMinidumpMagic = 0x5a4c5042;
+const uint32_t kCompressedMinidumpVersion = 1;
+
+struct CompressedMinidumpHeader {
+  uint32_t magic;
+  uint32_t version;
+};
+
+struct CompressedMinidumpFrame {
+  uint32_t raw_size;
+  uint32_t stored_size;
+};
+
+struct CompressedMinidumpSegment {
+  uint32_t position;
+  uint32_t size;
+};
+
+}  // namespace google_breakpad
+
+#endif  // COMMON_COMPRESSED_MINIDUMP_H_
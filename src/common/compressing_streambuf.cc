@@ -0,0 +1,295 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// compressing_streambuf.cc: A stream buffer that compresses what is written
+// to it with gzip or zstd, on several threads.
+//
+// See compressing_streambuf.h for documentation.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "common/compressing_streambuf.h"
+
+#include <string.h>
+
+#include <utility>
+
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+
+namespace google_breakpad {
+
+namespace {
+
+// The amount of text compressed as one gzip member or zstd frame.  Large
+// enough that restarting the compressor at each block costs little.
+const size_t kBlockSize = 4 << 20;
+
+// The number of compressed blocks held in memory, per compression thread,
+// before writing stops to wait for them to be written out.
+const size_t kPendingBlocksPerThread = 2;
+
+#ifdef HAVE_LIBZSTD
+// zstd's default level, which compresses symbol files at least as well as
+// gzip -6, and several times faster.
+const int kZstdLevel = 3;
+#endif
+
+}  // namespace
+
+// static
+bool CompressingStreambuf::ParseFormat(const string& name, Format* format) {
+  if (name == "gzip") {
+    *format = GZIP;
+    return true;
+  }
+  if (name == "zstd") {
+    *format = ZSTD;
+    return true;
+  }
+  return false;
+}
+
+// static
+bool CompressingStreambuf::IsSupported(Format format) {
+  switch (format) {
+    case GZIP:
+#ifdef HAVE_LIBZ
+      return true;
+#else
+      return false;
+#endif
+    case ZSTD:
+#ifdef HAVE_LIBZSTD
+      return true;
+#else
+      return false;
+#endif
+  }
+  return false;
+}
+
+// static
+const char* CompressingStreambuf::FileExtension(Format format) {
+  return format == GZIP ? ".gz" : ".zst";
+}
+
+CompressingStreambuf::CompressingStreambuf(FILE* file, Format format,
+                                           int num_threads)
+    : file_(file),
+      format_(format),
+      failed_(!IsSupported(format)),
+      finished_(false),
+      submitted_(false),
+      block_(new Block),
+      next_(0),
+      stopping_(false) {
+  block_->text.resize(kBlockSize);
+  setp(&block_->text[0], &block_->text[0] + kBlockSize);
+  if (num_threads > 1) {
+    for (int i = 0; i < num_threads; ++i)
+      threads_.emplace_back(&CompressingStreambuf::CompressBlocks, this);
+  }
+}
+
+CompressingStreambuf::~CompressingStreambuf() {
+  if (!finished_)
+    Finish();
+}
+
+bool CompressingStreambuf::Finish() {
+  if (finished_)
+    return !failed_;
+
+  if (pptr() != pbase() || !submitted_)
+    SubmitBlock();
+  WriteCompressedBlocks(0);
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    stopping_ = true;
+  }
+  block_submitted_.notify_all();
+  for (std::thread& thread : threads_)
+    thread.join();
+  threads_.clear();
+
+  block_.reset();
+  setp(NULL, NULL);
+  finished_ = true;
+  if (fflush(file_) != 0)
+    failed_ = true;
+  return !failed_;
+}
+
+CompressingStreambuf::int_type CompressingStreambuf::overflow(int_type c) {
+  if (finished_)
+    return traits_type::eof();
+  SubmitBlock();
+  if (traits_type::eq_int_type(c, traits_type::eof()))
+    return traits_type::not_eof(c);
+  *pptr() = traits_type::to_char_type(c);
+  pbump(1);
+  return c;
+}
+
+std::streamsize CompressingStreambuf::xsputn(const char* data,
+                                             std::streamsize size) {
+  if (finished_)
+    return 0;
+  std::streamsize written = 0;
+  while (written < size) {
+    std::streamsize room = epptr() - pptr();
+    if (room == 0) {
+      SubmitBlock();
+      continue;
+    }
+    std::streamsize count = size - written;
+    if (count > room)
+      count = room;
+    memcpy(pptr(), data + written, count);
+    // pbump takes an int, and count is at most kBlockSize.
+    pbump(static_cast<int>(count));
+    written += count;
+  }
+  return written;
+}
+
+void CompressingStreambuf::Compress(Block* block) const {
+  block->ok = false;
+  switch (format_) {
+    case GZIP: {
+#ifdef HAVE_LIBZ
+      z_stream stream;
+      memset(&stream, 0, sizeof(stream));
+      // A window of 15 bits, plus 16 to write a gzip header and trailer.
+      if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+                       Z_DEFAULT_STRATEGY) != Z_OK) {
+        break;
+      }
+      block->compressed.resize(deflateBound(&stream, block->text.size()));
+      stream.next_in =
+          reinterpret_cast<Bytef*>(const_cast<char*>(block->text.data()));
+      stream.avail_in = static_cast<uInt>(block->text.size());
+      stream.next_out = reinterpret_cast<Bytef*>(block->compressed.data());
+      stream.avail_out = static_cast<uInt>(block->compressed.size());
+      block->ok = deflate(&stream, Z_FINISH) == Z_STREAM_END;
+      block->compressed.resize(stream.total_out);
+      deflateEnd(&stream);
+#endif
+      break;
+    }
+    case ZSTD: {
+#ifdef HAVE_LIBZSTD
+      block->compressed.resize(ZSTD_compressBound(block->text.size()));
+      size_t size = ZSTD_compress(block->compressed.data(),
+                                  block->compressed.size(),
+                                  block->text.data(), block->text.size(),
+                                  kZstdLevel);
+      block->ok = !ZSTD_isError(size);
+      block->compressed.resize(block->ok ? size : 0);
+#endif
+      break;
+    }
+  }
+  // The text is no longer needed; don't hold on to it while the block
+  // waits to be written.
+  std::vector<char>().swap(block->text);
+}
+
+void CompressingStreambuf::SubmitBlock() {
+  block_->text.resize(pptr() - pbase());
+  std::unique_ptr<Block> block(std::move(block_));
+  block_.reset(new Block);
+  block_->text.resize(kBlockSize);
+  setp(&block_->text[0], &block_->text[0] + kBlockSize);
+  submitted_ = true;
+
+  if (threads_.empty()) {
+    Compress(block.get());
+    if (!block->ok ||
+        fwrite(block->compressed.data(), 1, block->compressed.size(),
+               file_) != block->compressed.size()) {
+      failed_ = true;
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    blocks_.push_back(std::move(block));
+  }
+  block_submitted_.notify_one();
+  WriteCompressedBlocks(threads_.size() * kPendingBlocksPerThread);
+}
+
+void CompressingStreambuf::WriteCompressedBlocks(size_t max_pending) {
+  std::unique_lock<std::mutex> guard(lock_);
+  while (!blocks_.empty()) {
+    if (!blocks_.front()->done) {
+      if (blocks_.size() <= max_pending)
+        return;
+      block_compressed_.wait(guard);
+      continue;
+    }
+    std::unique_ptr<Block> block(std::move(blocks_.front()));
+    blocks_.pop_front();
+    --next_;
+    guard.unlock();
+    if (!block->ok ||
+        fwrite(block->compressed.data(), 1, block->compressed.size(),
+               file_) != block->compressed.size()) {
+      failed_ = true;
+    }
+    guard.lock();
+  }
+}
+
+void CompressingStreambuf::CompressBlocks() {
+  std::unique_lock<std::mutex> guard(lock_);
+  for (;;) {
+    block_submitted_.wait(guard, [this] {
+      return stopping_ || next_ < blocks_.size();
+    });
+    if (next_ == blocks_.size())
+      return;
+    Block* block = blocks_[next_++].get();
+    guard.unlock();
+    Compress(block);
+    guard.lock();
+    block->done = true;
+    block_compressed_.notify_one();
+  }
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,153 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// compressing_streambuf.h: A stream buffer that compresses what is written
+// to it with gzip or zstd, on several threads.
+//
+// Symbol files for large binaries run to gigabytes, and are usually
+// compressed before they are stored.  dump_syms writes them through a
+// CompressingStreambuf, so that the plain text never reaches the disk:
+//
+//   CompressingStreambuf buffer(stdout, CompressingStreambuf::GZIP, 8);
+//   std::ostream stream(&buffer);
+//   if (!module.Write(stream, symbol_data) || !buffer.Finish())
+//     ...
+//
+// The text is cut into blocks, and each block is compressed on its own, as
+// a complete gzip member or zstd frame, so that blocks can be compressed in
+// parallel.  gunzip, zstd and the processor's compressed symbol file reader
+// all read the concatenated members or frames as a single stream.  gzip
+// support requires zlib, and zstd support requires building with
+// --enable-zstd.
+
+#ifndef COMMON_COMPRESSING_STREAMBUF_H_
+#define COMMON_COMPRESSING_STREAMBUF_H_
+
+#include <stdio.h>
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/using_std_string.h"
+
+namespace google_breakpad {
+
+class CompressingStreambuf : public std::streambuf {
+ public:
+  enum Format {
+    GZIP,
+    ZSTD
+  };
+
+  // Sets *format to the format named name, "gzip" or "zstd".  Returns false
+  // if name names neither.
+  static bool ParseFormat(const string& name, Format* format);
+
+  // Returns true if this build can write format.
+  static bool IsSupported(Format format);
+
+  // Returns the extension conventionally appended to the name of a file
+  // compressed in format: ".gz" or ".zst".
+  static const char* FileExtension(Format format);
+
+  // Compresses what is written to the buffer in format, and writes the
+  // compressed data to file, which the caller continues to own.  Up to
+  // num_threads blocks are compressed at once; with one thread, blocks are
+  // compressed on the writing thread.
+  CompressingStreambuf(FILE* file, Format format, int num_threads);
+
+  // Calls Finish if it has not been called.
+  ~CompressingStreambuf();
+
+  // Compresses and writes out everything written to the buffer, and
+  // flushes file.  Returns false if any block could not be compressed or
+  // written.  Nothing may be written to the buffer afterwards.
+  bool Finish();
+
+ protected:
+  int_type overflow(int_type c) override;
+  std::streamsize xsputn(const char* data, std::streamsize size) override;
+
+ private:
+  // A block of text and, once done is true, its compressed form.
+  struct Block {
+    std::vector<char> text;
+    std::vector<char> compressed;
+    bool ok = false;
+    bool done = false;
+  };
+
+  // Compresses block->text into block->compressed, and sets block->ok.
+  void Compress(Block* block) const;
+
+  // Hands the text written since the last call to the compressor, and
+  // starts a new block.
+  void SubmitBlock();
+
+  // Writes out the compressed blocks at the front of blocks_, waiting for
+  // them to be compressed until no more than max_pending remain.
+  void WriteCompressedBlocks(size_t max_pending);
+
+  // The body of each compression thread.
+  void CompressBlocks();
+
+  FILE* file_;
+  Format format_;
+  bool failed_;
+  bool finished_;
+
+  // True once any block has been handed to the compressor.
+  bool submitted_;
+
+  // The block being filled.  Its text is the put area.
+  std::unique_ptr<Block> block_;
+
+  // Blocks handed to the compressor, in the order they were written.
+  // Guarded by lock_, as are next_ and stopping_.
+  std::deque<std::unique_ptr<Block>> blocks_;
+
+  // The number of blocks at the front of blocks_ that some thread has
+  // started to compress.
+  size_t next_;
+
+  bool stopping_;
+  std::mutex lock_;
+  std::condition_variable block_submitted_;
+  std::condition_variable block_compressed_;
+  std::vector<std::thread> threads_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // COMMON_COMPRESSING_STREAMBUF_H_
@@ -0,0 +1,172 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// compressing_streambuf_unittest.cc: Unit tests for CompressingStreambuf.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <stdio.h>
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+
+#include "breakpad_googletest_includes.h"
+#include "common/compressing_streambuf.h"
+#include "common/tests/auto_tempdir.h"
+#include "common/using_std_string.h"
+
+namespace {
+
+using google_breakpad::AutoTempDir;
+using google_breakpad::CompressingStreambuf;
+
+// Returns text resembling a symbol file, several compression blocks long.
+string SymbolText() {
+  string text = "MODULE Linux x86_64 0123456789ABCDEF0123456789ABCDEF0 lib\n";
+  char line[64];
+  for (int i = 0; text.size() < (10 << 20); ++i) {
+    snprintf(line, sizeof(line), "FUNC %x 1c 0 function_%d\n", i * 0x30, i);
+    text += line;
+  }
+  return text;
+}
+
+// Writes text to path through a CompressingStreambuf, a line at a time
+// and then in one piece, as Module::Write and dump_syms -F do.
+bool WriteCompressed(const string& path, const string& text,
+                     CompressingStreambuf::Format format, int num_threads) {
+  FILE* file = fopen(path.c_str(), "wb");
+  if (!file)
+    return false;
+  CompressingStreambuf buffer(file, format, num_threads);
+  std::ostream stream(&buffer);
+  size_t half = text.find('\n', text.size() / 2) + 1;
+  for (size_t start = 0; start < half;) {
+    size_t end = text.find('\n', start) + 1;
+    stream << text.substr(start, end - start);
+    start = end;
+  }
+  stream.write(text.data() + half, text.size() - half);
+  bool finished = stream.good() && buffer.Finish();
+  return fclose(file) == 0 && finished;
+}
+
+TEST(CompressingStreambufTest, ParseFormat) {
+  CompressingStreambuf::Format format;
+  ASSERT_TRUE(CompressingStreambuf::ParseFormat("gzip", &format));
+  EXPECT_EQ(CompressingStreambuf::GZIP, format);
+  ASSERT_TRUE(CompressingStreambuf::ParseFormat("zstd", &format));
+  EXPECT_EQ(CompressingStreambuf::ZSTD, format);
+  EXPECT_FALSE(CompressingStreambuf::ParseFormat("lzma", &format));
+  EXPECT_STREQ(".gz",
+               CompressingStreambuf::FileExtension(CompressingStreambuf::GZIP));
+  EXPECT_STREQ(".zst",
+               CompressingStreambuf::FileExtension(CompressingStreambuf::ZSTD));
+}
+
+#ifdef HAVE_LIBZ
+// Returns the decompressed contents of the gzip file path.
+string ReadGzip(const string& path) {
+  string contents;
+  gzFile file = gzopen(path.c_str(), "rb");
+  if (!file)
+    return contents;
+  char buffer[1 << 16];
+  int read;
+  while ((read = gzread(file, buffer, sizeof(buffer))) > 0)
+    contents.append(buffer, read);
+  EXPECT_EQ(Z_OK, gzclose(file));
+  return contents;
+}
+
+class CompressingStreambufGzipTest : public testing::TestWithParam<int> { };
+
+TEST_P(CompressingStreambufGzipTest, RoundTrips) {
+  AutoTempDir temp_dir;
+  string path = temp_dir.path() + "/lib.sym.gz";
+  string text = SymbolText();
+  ASSERT_TRUE(
+      WriteCompressed(path, text, CompressingStreambuf::GZIP, GetParam()));
+  EXPECT_TRUE(ReadGzip(path) == text);
+}
+
+TEST_P(CompressingStreambufGzipTest, WritesValidEmptyFile) {
+  AutoTempDir temp_dir;
+  string path = temp_dir.path() + "/empty.sym.gz";
+  ASSERT_TRUE(
+      WriteCompressed(path, "", CompressingStreambuf::GZIP, GetParam()));
+  FILE* file = fopen(path.c_str(), "rb");
+  ASSERT_TRUE(file);
+  // A gzip member with no data still has a header and trailer.
+  EXPECT_EQ(0x1f, fgetc(file));
+  EXPECT_EQ(0x8b, fgetc(file));
+  fclose(file);
+  EXPECT_EQ("", ReadGzip(path));
+}
+
+INSTANTIATE_TEST_SUITE_P(Threads, CompressingStreambufGzipTest,
+                         testing::Values(1, 4));
+#endif  // HAVE_LIBZ
+
+#ifdef HAVE_LIBZSTD
+TEST(CompressingStreambufTest, ZstdRoundTrips) {
+  AutoTempDir temp_dir;
+  string path = temp_dir.path() + "/lib.sym.zst";
+  string text = SymbolText();
+  ASSERT_TRUE(WriteCompressed(path, text, CompressingStreambuf::ZSTD, 4));
+
+  FILE* file = fopen(path.c_str(), "rb");
+  ASSERT_TRUE(file);
+  std::vector<char> compressed;
+  char buffer[1 << 16];
+  size_t read;
+  while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    compressed.insert(compressed.end(), buffer, buffer + read);
+  fclose(file);
+
+  // ZSTD_decompress reads every frame in its input.
+  string contents(text.size() + 1, '\0');
+  size_t size = ZSTD_decompress(&contents[0], contents.size(),
+                                compressed.data(), compressed.size());
+  ASSERT_FALSE(ZSTD_isError(size));
+  contents.resize(size);
+  EXPECT_TRUE(contents == text);
+}
+#endif  // HAVE_LIBZSTD
+
+}  // namespace
@@ -33,6 +33,9 @@
 
 #include <assert.h>
 #include <stdint.h>
+#include <string.h>
+
+#include "common/byte_swap.h"
 
 namespace google_breakpad {
 
@@ -40,14 +43,11 @@ inline uint8_t ByteReader::ReadOneByte(const uint8_t* buffer) const {
   return buffer[0];
 }
 
+// The two, four and eight byte readers load the value whole and swap its
+// bytes only if the data's byte order isn't the host's; see byte_swap.h.
+
 inline uint16_t ByteReader::ReadTwoBytes(const uint8_t* buffer) const {
-  const uint16_t buffer0 = buffer[0];
-  const uint16_t buffer1 = buffer[1];
-  if (endian_ == ENDIANNESS_LITTLE) {
-    return buffer0 | buffer1 << 8;
-  } else {
-    return buffer1 | buffer0 << 8;
-  }
+  return LoadSwapped<uint16_t>(buffer, !host_byte_order_);
 }
 
 inline uint64_t ByteReader::ReadThreeBytes(const uint8_t* buffer) const {
@@ -62,33 +62,11 @@ inline uint64_t ByteReader::ReadThreeBytes(const uint8_t* buffer) const {
 }
 
 inline uint64_t ByteReader::ReadFourBytes(const uint8_t* buffer) const {
-  const uint32_t buffer0 = buffer[0];
-  const uint32_t buffer1 = buffer[1];
-  const uint32_t buffer2 = buffer[2];
-  const uint32_t buffer3 = buffer[3];
-  if (endian_ == ENDIANNESS_LITTLE) {
-    return buffer0 | buffer1 << 8 | buffer2 << 16 | buffer3 << 24;
-  } else {
-    return buffer3 | buffer2 << 8 | buffer1 << 16 | buffer0 << 24;
-  }
+  return LoadSwapped<uint32_t>(buffer, !host_byte_order_);
 }
 
 inline uint64_t ByteReader::ReadEightBytes(const uint8_t* buffer) const {
-  const uint64_t buffer0 = buffer[0];
-  const uint64_t buffer1 = buffer[1];
-  const uint64_t buffer2 = buffer[2];
-  const uint64_t buffer3 = buffer[3];
-  const uint64_t buffer4 = buffer[4];
-  const uint64_t buffer5 = buffer[5];
-  const uint64_t buffer6 = buffer[6];
-  const uint64_t buffer7 = buffer[7];
-  if (endian_ == ENDIANNESS_LITTLE) {
-    return buffer0 | buffer1 << 8 | buffer2 << 16 | buffer3 << 24 |
-      buffer4 << 32 | buffer5 << 40 | buffer6 << 48 | buffer7 << 56;
-  } else {
-    return buffer7 | buffer6 << 8 | buffer5 << 16 | buffer4 << 24 |
-      buffer3 << 32 | buffer2 << 40 | buffer1 << 48 | buffer0 << 56;
-  }
+  return LoadSwapped<uint64_t>(buffer, !host_byte_order_);
 }
 
 // Read an unsigned LEB128 number.  Each byte contains 7 bits of
@@ -97,19 +75,29 @@ inline uint64_t ByteReader::ReadEightBytes(const uint8_t* buffer) const {
 
 inline uint64_t ByteReader::ReadUnsignedLEB128(const uint8_t* buffer,
                                              size_t* len) const {
-  uint64_t result = 0;
-  size_t num_read = 0;
-  unsigned int shift = 0;
+  // Abbreviation codes, forms and most line program operands fit in one
+  // or two bytes, so decode those without looping.
+  const uint8_t byte0 = buffer[0];
+  if (byte0 < 0x80) {
+    *len = 1;
+    return byte0;
+  }
+  const uint8_t byte1 = buffer[1];
+  if (byte1 < 0x80) {
+    *len = 2;
+    return (byte0 & 0x7f) | static_cast<uint64_t>(byte1) << 7;
+  }
+
+  // Carry on from the third byte with the first two already decoded.
+  uint64_t result = (byte0 & 0x7f) | static_cast<uint64_t>(byte1 & 0x7f) << 7;
+  size_t num_read = 2;
+  unsigned int shift = 14;
   uint8_t byte;
 
   do {
-    byte = *buffer++;
-    num_read++;
-
+    byte = buffer[num_read++];
     result |= (static_cast<uint64_t>(byte & 0x7f)) << shift;
-
     shift += 7;
-
   } while (byte & 0x80);
 
   *len = num_read;
@@ -122,14 +110,26 @@ inline uint64_t ByteReader::ReadUnsignedLEB128(const uint8_t* buffer,
 
 inline int64_t ByteReader::ReadSignedLEB128(const uint8_t* buffer,
                                           size_t* len) const {
-  int64_t result = 0;
-  unsigned int shift = 0;
-  size_t num_read = 0;
+  // As above, but with the sign bit of the last byte extended.
+  const uint8_t byte0 = buffer[0];
+  if (byte0 < 0x80) {
+    *len = 1;
+    return static_cast<int64_t>(byte0 ^ 0x40) - 0x40;
+  }
+  const uint8_t byte1 = buffer[1];
+  if (byte1 < 0x80) {
+    *len = 2;
+    return static_cast<int64_t>(((byte1 ^ 0x40) << 7) | (byte0 & 0x7f)) -
+           (0x40 << 7);
+  }
+
+  int64_t result = (byte0 & 0x7f) | static_cast<int64_t>(byte1 & 0x7f) << 7;
+  unsigned int shift = 14;
+  size_t num_read = 2;
   uint8_t byte;
 
   do {
-      byte = *buffer++;
-      num_read++;
+      byte = buffer[num_read++];
       result |= (static_cast<uint64_t>(byte & 0x7f) << shift);
       shift += 7;
   } while (byte & 0x80);
@@ -141,13 +141,13 @@ inline int64_t ByteReader::ReadSignedLEB128(const uint8_t* buffer,
 }
 
 inline uint64_t ByteReader::ReadOffset(const uint8_t* buffer) const {
-  assert(this->offset_reader_);
-  return (this->*offset_reader_)(buffer);
+  assert(offset_size_);
+  return offset_size_ == 4 ? ReadFourBytes(buffer) : ReadEightBytes(buffer);
 }
 
 inline uint64_t ByteReader::ReadAddress(const uint8_t* buffer) const {
-  assert(this->address_reader_);
-  return (this->*address_reader_)(buffer);
+  assert(address_size_);
+  return address_size_ == 4 ? ReadFourBytes(buffer) : ReadEightBytes(buffer);
 }
 
 inline void ByteReader::SetCFIDataBase(uint64_t section_base,
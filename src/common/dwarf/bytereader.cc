@@ -33,6 +33,7 @@
 #include <assert.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "common/dwarf/bytereader-inl.h"
 #include "common/dwarf/bytereader.h"
@@ -40,31 +41,22 @@
 namespace google_breakpad {
 
 ByteReader::ByteReader(enum Endianness endian)
-    :offset_reader_(NULL), address_reader_(NULL), endian_(endian),
-     address_size_(0), offset_size_(0),
+    :endian_(endian), address_size_(0), offset_size_(0),
      have_section_base_(), have_text_base_(), have_data_base_(),
-     have_function_base_() { }
+     have_function_base_() {
+  host_byte_order_ = (endian == ENDIANNESS_BIG) == HostIsBigEndian();
+}
 
 ByteReader::~ByteReader() { }
 
 void ByteReader::SetOffsetSize(uint8_t size) {
   offset_size_ = size;
   assert(size == 4 || size == 8);
-  if (size == 4) {
-    this->offset_reader_ = &ByteReader::ReadFourBytes;
-  } else {
-    this->offset_reader_ = &ByteReader::ReadEightBytes;
-  }
 }
 
 void ByteReader::SetAddressSize(uint8_t size) {
   address_size_ = size;
   assert(size == 4 || size == 8);
-  if (size == 4) {
-    this->address_reader_ = &ByteReader::ReadFourBytes;
-  } else {
-    this->address_reader_ = &ByteReader::ReadEightBytes;
-  }
 }
 
 uint64_t ByteReader::ReadInitialLength(const uint8_t* start, size_t* len) {
@@ -288,23 +288,17 @@ class ByteReader {
   Endianness GetEndianness() const;
  private:
 
-  // Function pointer type for our address and offset readers.
-  typedef uint64_t (ByteReader::*AddressReader)(const uint8_t*) const;
+  Endianness endian_;
 
-  // Read an offset from BUFFER and return it as an unsigned 64 bit
-  // integer.  DWARF2/3 define offsets as either 4 or 8 bytes,
-  // generally depending on the amount of DWARF2/3 info present.
-  // This function pointer gets set by SetOffsetSize.
-  AddressReader offset_reader_;
+  // True if endian_ is the byte order of the host, so that multi-byte
+  // values can be used as loaded.
+  bool host_byte_order_;
 
-  // Read an address from BUFFER and return it as an unsigned 64 bit
-  // integer.  DWARF2/3 allow addresses to be any size from 0-255
-  // bytes currently.  Internally we support 4 and 8 byte addresses,
-  // and will CHECK on anything else.
-  // This function pointer gets set by SetAddressSize.
-  AddressReader address_reader_;
-
-  Endianness endian_;
+  // The sizes ReadAddress and ReadOffset read, as set by SetAddressSize
+  // and SetOffsetSize.  DWARF2/3 allow addresses to be any size from
+  // 0-255 bytes currently, and define offsets as either 4 or 8 bytes.
+  // Internally we support 4 and 8 byte sizes, and will CHECK on
+  // anything else; zero means the size hasn't been set.
   uint8_t address_size_;
   uint8_t offset_size_;
 
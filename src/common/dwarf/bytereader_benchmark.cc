@@ -0,0 +1,314 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// bytereader_benchmark.cc: Time ByteReader's fixed-size and LEB128 reads.
+//
+// Each workload is a buffer of values encoded as DWARF would encode them,
+// read back one after another the way the DIE and line program parsers
+// read them.  The values come from a fixed pseudo-random sequence, so that
+// runs are comparable from machine to machine and from change to change.
+// The LEB128 workloads are:
+//
+//   1 byte     values below 0x80, as attribute forms and most line
+//              program operands are
+//   2 byte     values below 0x4000
+//   mixed      mostly one byte, some two to four, and a few of up to ten,
+//              roughly the mix of a .debug_info section
+//
+// For each workload, the best of -r runs is reported as nanoseconds per
+// value and megabytes of encoded data per second.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "common/dwarf/bytereader.h"
+#include "common/dwarf/bytereader-inl.h"
+#include "common/dwarf/types.h"
+#include "common/using_std_string.h"
+
+namespace {
+
+using google_breakpad::ByteReader;
+using google_breakpad::ENDIANNESS_BIG;
+using google_breakpad::ENDIANNESS_LITTLE;
+using std::vector;
+
+// A small, fixed pseudo-random sequence.
+class Random {
+ public:
+  Random() : state_(0x2545f4914f6cdd1dULL) {}
+
+  uint64_t Next() {
+    state_ ^= state_ << 13;
+    state_ ^= state_ >> 7;
+    state_ ^= state_ << 17;
+    return state_;
+  }
+
+  // Return a value of at most BITS bits.
+  uint64_t Bits(int bits) {
+    return bits >= 64 ? Next() : Next() & ((1ULL << bits) - 1);
+  }
+
+  // Return a value whose ULEB128 encoding is mostly one byte long.
+  uint64_t Mixed() {
+    uint64_t choice = Next() % 100;
+    if (choice < 70)
+      return Bits(7);
+    if (choice < 90)
+      return Bits(14);
+    if (choice < 98)
+      return Bits(28);
+    return Next();
+  }
+
+ private:
+  uint64_t state_;
+};
+
+// Return VALUE's low BITS bits, sign-extended.
+int64_t SignExtend(uint64_t value, int bits) {
+  if (bits >= 64)
+    return static_cast<int64_t>(value);
+  const uint64_t sign = 1ULL << (bits - 1);
+  return static_cast<int64_t>(((value & ((sign << 1) - 1)) ^ sign) - sign);
+}
+
+void AppendULEB128(uint64_t value, vector<uint8_t>* buffer) {
+  do {
+    uint8_t byte = value & 0x7f;
+    value >>= 7;
+    buffer->push_back(value ? byte | 0x80 : byte);
+  } while (value);
+}
+
+void AppendSLEB128(int64_t value, vector<uint8_t>* buffer) {
+  bool more;
+  do {
+    uint8_t byte = value & 0x7f;
+    value >>= 7;
+    more = !((value == 0 && !(byte & 0x40)) ||
+             (value == -1 && (byte & 0x40)));
+    buffer->push_back(more ? byte | 0x80 : byte);
+  } while (more);
+}
+
+void AppendFixed(uint64_t value, int size, bool big_endian,
+                 vector<uint8_t>* buffer) {
+  for (int i = 0; i < size; ++i) {
+    int shift = 8 * (big_endian ? size - 1 - i : i);
+    buffer->push_back(static_cast<uint8_t>(value >> shift));
+  }
+}
+
+// Read the values in BUFFER with READ, which returns a value and advances
+// the pointer it is given past it, and return the best time of REPEAT runs
+// in seconds.  The values are added to *SUM, so that the reads can't be
+// optimized away.
+template <typename Read>
+double TimeReads(const vector<uint8_t>& buffer, int repeat, Read read,
+                 uint64_t* sum) {
+  double best = -1;
+  for (int i = 0; i < repeat; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    const uint8_t* p = buffer.data();
+    const uint8_t* const end = p + buffer.size();
+    uint64_t total = 0;
+    while (p < end)
+      total += read(&p);
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    *sum += total;
+    if (best < 0 || elapsed.count() < best)
+      best = elapsed.count();
+  }
+  return best;
+}
+
+void PrintWorkload(const char* workload, double seconds, size_t values,
+                   size_t bytes) {
+  printf("%-24s %10.2f %10.1f\n", workload, seconds * 1e9 / values,
+         bytes / seconds / (1 << 20));
+}
+
+void Usage(const char* program) {
+  fprintf(stderr,
+          "Usage: %s [OPTION]...\n"
+          "Time dwarf::ByteReader's fixed-size and LEB128 reads.\n\n"
+          "Options:\n"
+          "  -n <N>      Values per workload\n"
+          "  -r <N>      Take the best of N runs of each workload\n",
+          program);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t count = 4 << 20;
+  int repeat = 5;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:r:h")) != -1) {
+    switch (opt) {
+      case 'n':
+        count = strtoul(optarg, NULL, 10);
+        break;
+      case 'r':
+        repeat = atoi(optarg);
+        break;
+      default:
+        Usage(argv[0]);
+        return 1;
+    }
+  }
+  if (optind != argc || count < 1 || repeat < 1) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  ByteReader little(ENDIANNESS_LITTLE);
+  ByteReader big(ENDIANNESS_BIG);
+  little.SetAddressSize(8);
+  little.SetOffsetSize(4);
+  uint64_t sum = 0;
+
+  printf("%zu values per workload, best of %d runs\n\n", count, repeat);
+  printf("%-24s %10s %10s\n", "workload", "ns/value", "MB/s");
+
+  struct LEB128Workload {
+    const char* name;
+    int bits;  // or zero for the mixed distribution
+  };
+  const LEB128Workload leb128_workloads[] = {
+    { "1 byte", 7 }, { "2 byte", 14 }, { "mixed", 0 }
+  };
+  for (const LEB128Workload& workload : leb128_workloads) {
+    vector<uint8_t> unsigned_buffer, signed_buffer;
+    Random random;
+    for (size_t i = 0; i < count; ++i) {
+      uint64_t value = workload.bits ? random.Bits(workload.bits)
+                                     : random.Mixed();
+      AppendULEB128(value, &unsigned_buffer);
+      // Mirror the unsigned workload's encoded lengths.
+      int bits = workload.bits;
+      if (!bits) {
+        bits = 7;
+        while (bits < 64 && value >> bits)
+          bits += 7;
+      }
+      AppendSLEB128(SignExtend(value, bits), &signed_buffer);
+    }
+
+    double seconds = TimeReads(unsigned_buffer, repeat,
+        [&little](const uint8_t** p) {
+          size_t len;
+          uint64_t value = little.ReadUnsignedLEB128(*p, &len);
+          *p += len;
+          return value;
+        }, &sum);
+    string name = string("ULEB128 ") + workload.name;
+    PrintWorkload(name.c_str(), seconds, count, unsigned_buffer.size());
+
+    seconds = TimeReads(signed_buffer, repeat,
+        [&little](const uint8_t** p) {
+          size_t len;
+          uint64_t value = little.ReadSignedLEB128(*p, &len);
+          *p += len;
+          return value;
+        }, &sum);
+    name = string("SLEB128 ") + workload.name;
+    PrintWorkload(name.c_str(), seconds, count, signed_buffer.size());
+  }
+
+  struct FixedWorkload {
+    const char* name;
+    int size;
+    bool big_endian;
+  };
+  const FixedWorkload fixed_workloads[] = {
+    { "4 bytes, little-endian", 4, false },
+    { "4 bytes, big-endian", 4, true },
+    { "8 bytes, little-endian", 8, false },
+    { "8 bytes, big-endian", 8, true },
+  };
+  for (const FixedWorkload& workload : fixed_workloads) {
+    vector<uint8_t> buffer;
+    Random random;
+    for (size_t i = 0; i < count; ++i)
+      AppendFixed(random.Next(), workload.size, workload.big_endian, &buffer);
+    const ByteReader& reader = workload.big_endian ? big : little;
+    double seconds;
+    if (workload.size == 4) {
+      seconds = TimeReads(buffer, repeat, [&reader](const uint8_t** p) {
+        uint64_t value = reader.ReadFourBytes(*p);
+        *p += 4;
+        return value;
+      }, &sum);
+    } else {
+      seconds = TimeReads(buffer, repeat, [&reader](const uint8_t** p) {
+        uint64_t value = reader.ReadEightBytes(*p);
+        *p += 8;
+        return value;
+      }, &sum);
+    }
+    PrintWorkload(workload.name, seconds, count, buffer.size());
+  }
+
+  // ReadAddress and ReadOffset choose their width at run time.
+  vector<uint8_t> addresses, offsets;
+  Random random;
+  for (size_t i = 0; i < count; ++i) {
+    AppendFixed(random.Next(), 8, false, &addresses);
+    AppendFixed(random.Next(), 4, false, &offsets);
+  }
+  double seconds = TimeReads(addresses, repeat, [&little](const uint8_t** p) {
+    uint64_t value = little.ReadAddress(*p);
+    *p += 8;
+    return value;
+  }, &sum);
+  PrintWorkload("address, 8 bytes", seconds, count, addresses.size());
+  seconds = TimeReads(offsets, repeat, [&little](const uint8_t** p) {
+    uint64_t value = little.ReadOffset(*p);
+    *p += 4;
+    return value;
+  }, &sum);
+  PrintWorkload("offset, 4 bytes", seconds, count, offsets.size());
+
+  // Print something that depends on every value read.
+  printf("\nchecksum %016llx\n", static_cast<unsigned long long>(sum));
+  return 0;
+}
@@ -91,6 +91,50 @@ TEST_F(Reader, SimpleConstructor) {
   EXPECT_EQ(0xfec319c9, reader.ReadAddress(data + 35));
 }
 
+TEST_F(Reader, ShortLEB128) {
+  ByteReader reader(ENDIANNESS_LITTLE);
+  CFISection section(kLittleEndian, 4);
+  section
+    .ULEB128(0x7f)
+    .ULEB128(0x80)
+    .ULEB128(0x3fff)
+    .ULEB128(0x4000)
+    .LEB128(-1)
+    .LEB128(0x3f)
+    .LEB128(-0x40)
+    .LEB128(0x40)
+    .LEB128(-0x2000)
+    .LEB128(0x1fff)
+    .LEB128(-0x2001);
+  ASSERT_TRUE(section.GetContents(&contents));
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(contents.data());
+  size_t leb128_size;
+  EXPECT_EQ(0x7fU, reader.ReadUnsignedLEB128(data, &leb128_size));
+  EXPECT_EQ(1U, leb128_size);
+  data += leb128_size;
+  EXPECT_EQ(0x80U, reader.ReadUnsignedLEB128(data, &leb128_size));
+  EXPECT_EQ(2U, leb128_size);
+  data += leb128_size;
+  EXPECT_EQ(0x3fffU, reader.ReadUnsignedLEB128(data, &leb128_size));
+  EXPECT_EQ(2U, leb128_size);
+  data += leb128_size;
+  EXPECT_EQ(0x4000U, reader.ReadUnsignedLEB128(data, &leb128_size));
+  EXPECT_EQ(3U, leb128_size);
+  data += leb128_size;
+  const struct {
+    int64_t value;
+    size_t size;
+  } kSigned[] = {
+    { -1, 1 }, { 0x3f, 1 }, { -0x40, 1 }, { 0x40, 2 },
+    { -0x2000, 2 }, { 0x1fff, 2 }, { -0x2001, 3 }
+  };
+  for (const auto& expected : kSigned) {
+    EXPECT_EQ(expected.value, reader.ReadSignedLEB128(data, &leb128_size));
+    EXPECT_EQ(expected.size, leb128_size);
+    data += leb128_size;
+  }
+}
+
 TEST_F(Reader, ValidEncodings) {
   ByteReader reader(ENDIANNESS_LITTLE);
   EXPECT_TRUE(reader.ValidEncoding(
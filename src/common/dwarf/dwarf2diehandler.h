@@ -299,6 +299,8 @@ class DIEDispatcher: public Dwarf2Handler {
                             uint8_t offset_size, uint64_t cu_length,
                             uint8_t dwarf_version);
   bool StartDIE(uint64_t offset, enum DwarfTag tag);
+  // DIEHandlers never see the children of a DIE they skipped.
+  bool SkipChildrenOfSkippedDIEs() { return true; }
   void ProcessAttributeUnsigned(uint64_t offset,
                                 enum DwarfAttribute attr,
                                 enum DwarfForm form,
@@ -99,6 +99,11 @@ void CompilationUnit::SetSplitDwarf(uint64_t addr_base,
   skeleton_dwo_id_ = dwo_id;
 }
 
+void CompilationUnit::SetDwpReader(std::shared_ptr<DwpReader> dwp_reader) {
+  have_checked_for_dwp_ = true;
+  dwp_reader_ = std::move(dwp_reader);
+}
+
 // Read a DWARF2/3 abbreviation section.
 // Each abbrev consists of a abbreviation number, a tag, a byte
 // specifying whether the tag has children, and a list of
@@ -173,6 +178,27 @@ void CompilationUnit::ReadAbbrevs() {
                            value);
       abbrev.attributes.push_back(abbrev_attr);
     }
+
+    // Work out what skipping a DIE with this abbreviation takes.
+    abbrev.has_fixed_size = true;
+    abbrev.fixed_size = 0;
+    abbrev.has_sibling = false;
+    abbrev.sibling_form = DW_FORM_ref4;
+    abbrev.sibling_position = 0;
+    for (const AttrForm& attribute : abbrev.attributes) {
+      if (attribute.attr_ == DW_AT_sibling) {
+        abbrev.has_sibling = true;
+        abbrev.sibling_form = attribute.form_;
+        abbrev.sibling_position = abbrev.fixed_size;
+      }
+      uint64_t size;
+      if (abbrev.has_fixed_size &&
+          FixedAttributeSize(attribute.form_, &size)) {
+        abbrev.fixed_size += size;
+      } else {
+        abbrev.has_fixed_size = false;
+      }
+    }
     abbrevs_->push_back(abbrev);
   }
 
@@ -188,15 +214,118 @@ void CompilationUnit::ReadAbbrevs() {
 
 // Skips a single DIE's attributes.
 const uint8_t* CompilationUnit::SkipDIE(const uint8_t* start,
-                                        const Abbrev& abbrev) {
+                                        const Abbrev& abbrev,
+                                        const uint8_t** sibling) {
+  if (sibling) {
+    *sibling = nullptr;
+    if (abbrev.has_sibling && abbrev.has_fixed_size) {
+      *sibling = ReadSibling(start + abbrev.sibling_position,
+                             abbrev.sibling_form);
+    }
+  }
+  if (abbrev.has_fixed_size)
+    return start + abbrev.fixed_size;
+
   for (AttributeList::const_iterator i = abbrev.attributes.begin();
-       i != abbrev.attributes.end();
+       i != abbrev.attributes.end() && start;
        i++)  {
+    if (sibling && i->attr_ == DW_AT_sibling)
+      *sibling = ReadSibling(start, i->form_);
     start = SkipAttribute(start, i->form_);
   }
   return start;
 }
 
+bool CompilationUnit::FixedAttributeSize(enum DwarfForm form,
+                                         uint64_t* size) {
+  switch (form) {
+    case DW_FORM_flag_present:
+    case DW_FORM_implicit_const:
+      *size = 0;
+      return true;
+    case DW_FORM_addrx1:
+    case DW_FORM_data1:
+    case DW_FORM_flag:
+    case DW_FORM_ref1:
+    case DW_FORM_strx1:
+      *size = 1;
+      return true;
+    case DW_FORM_addrx2:
+    case DW_FORM_ref2:
+    case DW_FORM_data2:
+    case DW_FORM_strx2:
+      *size = 2;
+      return true;
+    case DW_FORM_addrx3:
+    case DW_FORM_strx3:
+      *size = 3;
+      return true;
+    case DW_FORM_addrx4:
+    case DW_FORM_ref4:
+    case DW_FORM_data4:
+    case DW_FORM_strx4:
+    case DW_FORM_ref_sup4:
+      *size = 4;
+      return true;
+    case DW_FORM_ref8:
+    case DW_FORM_data8:
+    case DW_FORM_ref_sig8:
+    case DW_FORM_ref_sup8:
+      *size = 8;
+      return true;
+    case DW_FORM_data16:
+      *size = 16;
+      return true;
+    case DW_FORM_addr:
+      *size = reader_->AddressSize();
+      return true;
+    case DW_FORM_ref_addr:
+      // DWARF2 and 3/4 differ on whether ref_addr is address size or
+      // offset size.
+      if (header_.version < 2)
+        return false;
+      *size = header_.version == 2 ? reader_->AddressSize()
+                                   : reader_->OffsetSize();
+      return true;
+    case DW_FORM_strp:
+    case DW_FORM_line_strp:
+    case DW_FORM_strp_sup:
+    case DW_FORM_sec_offset:
+      *size = reader_->OffsetSize();
+      return true;
+    default:
+      return false;
+  }
+}
+
+const uint8_t* CompilationUnit::ReadSibling(const uint8_t* start,
+                                            enum DwarfForm form) {
+  uint64_t offset;
+  size_t len;
+  switch (form) {
+    case DW_FORM_ref1:
+      offset = reader_->ReadOneByte(start);
+      break;
+    case DW_FORM_ref2:
+      offset = reader_->ReadTwoBytes(start);
+      break;
+    case DW_FORM_ref4:
+      offset = reader_->ReadFourBytes(start);
+      break;
+    case DW_FORM_ref8:
+      offset = reader_->ReadEightBytes(start);
+      break;
+    case DW_FORM_ref_udata:
+      offset = reader_->ReadUnsignedLEB128(start, &len);
+      break;
+    default:
+      return nullptr;
+  }
+  if (offset >= buffer_length_)
+    return nullptr;
+  return buffer_ + offset;
+}
+
 // Skips a single attribute form's data.
 const uint8_t* CompilationUnit::SkipAttribute(const uint8_t* start,
                                               enum DwarfForm form) {
@@ -942,8 +1071,10 @@ bool CompilationUnit::ProcessDIEs() {
     lengthstart += 4;
 
   std::stack<uint64_t> die_stack;
+  const uint8_t* end = lengthstart + header_.length;
+  const bool skip_children = handler_->SkipChildrenOfSkippedDIEs();
 
-  while (dieptr < (lengthstart + header_.length)) {
+  while (dieptr < end) {
     // We give the user the absolute offset from the beginning of
     // debug_info, since they need it to deal with ref_addr forms.
     uint64_t absolute_offset = (dieptr - buffer_) + offset_from_section_start_;
@@ -975,7 +1106,10 @@ bool CompilationUnit::ProcessDIEs() {
     const Abbrev& abbrev = abbrevs_->at(static_cast<size_t>(abbrev_num));
     const enum DwarfTag tag = abbrev.tag;
     if (!handler_->StartDIE(absolute_offset, tag)) {
-      dieptr = SkipDIE(dieptr, abbrev);
+      const uint8_t* sibling = nullptr;
+      dieptr = SkipDIE(dieptr, abbrev,
+                       skip_children && abbrev.has_children ? &sibling
+                                                            : nullptr);
       if (!dieptr) {
         fprintf(stderr,
                 "An error happens when skipping a DIE's attributes at offset "
@@ -984,6 +1118,12 @@ bool CompilationUnit::ProcessDIEs() {
                 absolute_offset);
         exit(1);
       }
+      // Jump straight past the DIE's children, if it says where they end.
+      if (sibling && sibling >= dieptr && sibling <= end) {
+        dieptr = sibling;
+        handler_->EndDIE(absolute_offset);
+        continue;
+      }
     } else {
       dieptr = ProcessDIE(absolute_offset, dieptr, abbrev);
       if (!dieptr) {
@@ -1025,40 +1165,22 @@ bool CompilationUnit::ProcessSplitDwarf(std::string& split_file,
   if (!have_checked_for_dwp_) {
     // Look for a .dwp file in the same directory as the executable.
     have_checked_for_dwp_ = true;
-    string dwp_suffix(".dwp");
-    std::string dwp_path = path_ + dwp_suffix;
-    if (stat(dwp_path.c_str(), &statbuf) != 0) {
-      // Fall back to a split .debug file in the same directory.
-      string debug_suffix(".debug");
-      dwp_path = path_;
-      size_t found = path_.rfind(debug_suffix);
-      if (found != string::npos &&
-          found + debug_suffix.length() == path_.length())
-        dwp_path = dwp_path.replace(found, debug_suffix.length(), dwp_suffix);
-    }
-    if (stat(dwp_path.c_str(), &statbuf) == 0) {
-      split_elf_reader_ = std::make_unique<ElfReader>(dwp_path);
-      int width = GetElfWidth(*split_elf_reader_.get());
-      if (width != 0) {
-        split_byte_reader = ByteReader(reader_->GetEndianness());
-        split_byte_reader.SetAddressSize(width);
-        dwp_reader_ = std::make_unique<DwpReader>(split_byte_reader,
-                                                  split_elf_reader_.get());
-        dwp_reader_->Initialize();
-        // If we have a .dwp file, read the debug sections for the requested CU.
-        dwp_reader_->ReadDebugSectionsForCU(dwo_id_, &sections);
-        if (!sections.empty()) {
-          SectionMap::const_iterator cu_iter =
-              GetSectionByName(sections, ".debug_info_offset");
-          SectionMap::const_iterator debug_info_iter =
-              GetSectionByName(sections, ".debug_info");
-          assert(cu_iter != sections.end());
-          assert(debug_info_iter != sections.end());
-          cu_offset = cu_iter->second.first - debug_info_iter->second.first;
-          found_in_dwp = true;
-          split_file = dwp_path;
-        }
-      }
+    dwp_reader_ = DwpReader::Open(path_, reader_->GetEndianness());
+  }
+  if (dwp_reader_) {
+    // If we have a .dwp file, read the debug sections for the requested CU.
+    dwp_reader_->ReadDebugSectionsForCU(dwo_id_, &sections);
+    if (!sections.empty()) {
+      SectionMap::const_iterator cu_iter =
+          GetSectionByName(sections, ".debug_info_offset");
+      SectionMap::const_iterator debug_info_iter =
+          GetSectionByName(sections, ".debug_info");
+      assert(cu_iter != sections.end());
+      assert(debug_info_iter != sections.end());
+      cu_offset = cu_iter->second.first - debug_info_iter->second.first;
+      found_in_dwp = true;
+      split_byte_reader = dwp_reader_->byte_reader();
+      split_file = dwp_reader_->path();
     }
   }
   if (!found_in_dwp) {
@@ -1103,13 +1225,46 @@ void CompilationUnit::ReadDebugSectionsFromDwo(ElfReader* elf_reader,
 }
 
 DwpReader::DwpReader(const ByteReader& byte_reader, ElfReader* elf_reader)
-    : elf_reader_(elf_reader), byte_reader_(byte_reader),
+    : path_(), owned_elf_reader_(), elf_reader_(elf_reader),
+      byte_reader_(byte_reader),
       cu_index_(NULL), cu_index_size_(0), string_buffer_(NULL),
       string_buffer_size_(0), version_(0), ncolumns_(0), nunits_(0),
       nslots_(0), phash_(NULL), pindex_(NULL), shndx_pool_(NULL),
       offset_table_(NULL), size_table_(NULL), abbrev_data_(NULL),
       abbrev_size_(0), info_data_(NULL), info_size_(0),
-      str_offsets_data_(NULL), str_offsets_size_(0) {}
+      str_offsets_data_(NULL), str_offsets_size_(0), rnglist_data_(NULL),
+      rnglist_size_(0) {}
+
+std::shared_ptr<DwpReader> DwpReader::Open(const string& path,
+                                           enum Endianness endianness) {
+  struct stat statbuf;
+  string dwp_suffix(".dwp");
+  string dwp_path = path + dwp_suffix;
+  if (stat(dwp_path.c_str(), &statbuf) != 0) {
+    // Fall back to a split .debug file in the same directory.
+    string debug_suffix(".debug");
+    dwp_path = path;
+    size_t found = path.rfind(debug_suffix);
+    if (found != string::npos &&
+        found + debug_suffix.length() == path.length())
+      dwp_path = dwp_path.replace(found, debug_suffix.length(), dwp_suffix);
+  }
+  if (stat(dwp_path.c_str(), &statbuf) != 0)
+    return NULL;
+  std::unique_ptr<ElfReader> elf_reader =
+      std::make_unique<ElfReader>(dwp_path);
+  int width = GetElfWidth(*elf_reader.get());
+  if (width == 0)
+    return NULL;
+  ByteReader byte_reader(endianness);
+  byte_reader.SetAddressSize(width);
+  std::shared_ptr<DwpReader> dwp_reader =
+      std::make_shared<DwpReader>(byte_reader, elf_reader.get());
+  dwp_reader->path_ = dwp_path;
+  dwp_reader->owned_elf_reader_ = std::move(elf_reader);
+  dwp_reader->Initialize();
+  return dwp_reader;
+}
 
 void DwpReader::Initialize() {
   cu_index_ = elf_reader_->GetSectionByName(".debug_cu_index",
@@ -1156,10 +1311,65 @@ void DwpReader::Initialize() {
       version_ = 0;
     }
   }
+  if (version_ == 1 || version_ == 2 || version_ == 5)
+    BuildIndex();
+}
+
+void DwpReader::BuildIndex() {
+  const char* cu_index_end = cu_index_ + cu_index_size_;
+  units_.reserve(version_ == 1 ? nslots_ : nunits_);
+  for (unsigned int slot = 0u; slot < nslots_; ++slot) {
+    uint64_t dwo_id = byte_reader_.ReadEightBytes(
+        reinterpret_cast<const uint8_t*>(phash_) + slot * sizeof(uint64_t));
+    uint32_t index = byte_reader_.ReadFourBytes(
+        reinterpret_cast<const uint8_t*>(pindex_) + slot * sizeof(uint32_t));
+    if (version_ != 1) {
+      // An empty slot has a zero row index.
+      if (index != 0)
+        units_.emplace(dwo_id, index);
+      continue;
+    }
+
+    // An empty slot has a zero signature.
+    if (dwo_id == 0)
+      continue;
+    units_.emplace(dwo_id, slot);
+
+    // Look up each section this unit's list refers to, the first time we
+    // see it.  These lists usually share most of their sections.
+    const char* shndx_list = shndx_pool_ + index * sizeof(uint32_t);
+    for (; shndx_list < cu_index_end; shndx_list += sizeof(uint32_t)) {
+      unsigned int shndx = byte_reader_.ReadFourBytes(
+          reinterpret_cast<const uint8_t*>(shndx_list));
+      if (shndx == 0)
+        break;
+      if (v1_sections_.count(shndx))
+        continue;
+      V1Section& section = v1_sections_[shndx];
+      section.name = NULL;
+      const char* section_name = elf_reader_->GetSectionName(shndx);
+      if (!section_name)
+        continue;
+      // We're only interested in these three debug sections.
+      // The section names in the .dwo file end with ".dwo", but we
+      // add them to the sections table with their normal names.
+      if (!strncmp(section_name, ".debug_abbrev", strlen(".debug_abbrev")))
+        section.name = ".debug_abbrev";
+      else if (!strncmp(section_name, ".debug_info", strlen(".debug_info")))
+        section.name = ".debug_info";
+      else if (!strncmp(section_name, ".debug_str_offsets",
+                        strlen(".debug_str_offsets")))
+        section.name = ".debug_str_offsets";
+      if (section.name) {
+        section.data = reinterpret_cast<const uint8_t*>(
+            elf_reader_->GetSectionByIndex(shndx, &section.size));
+      }
+    }
+  }
 }
 
 void DwpReader::ReadDebugSectionsForCU(uint64_t dwo_id,
-                                       SectionMap* sections) {
+                                       SectionMap* sections) const {
   if (version_ == 1) {
     int slot = LookupCU(dwo_id);
     if (slot == -1) {
@@ -1174,40 +1384,20 @@ void DwpReader::ReadDebugSectionsForCU(uint64_t dwo_id,
         + slot * sizeof(uint32_t));
     const char* shndx_list = shndx_pool_ + index * sizeof(uint32_t);
     for (;;) {
-      if (shndx_list >= cu_index_ + cu_index_size_) {
-        version_ = 0;
+      if (shndx_list >= cu_index_ + cu_index_size_)
         return;
-      }
       unsigned int shndx = byte_reader_.ReadFourBytes(
           reinterpret_cast<const uint8_t*>(shndx_list));
       shndx_list += sizeof(uint32_t);
       if (shndx == 0)
         break;
-      const char* section_name = elf_reader_->GetSectionName(shndx);
-      size_t section_size;
-      const char* section_data;
-      // We're only interested in these four debug sections.
-      // The section names in the .dwo file end with ".dwo", but we
-      // add them to the sections table with their normal names.
-      if (!strncmp(section_name, ".debug_abbrev", strlen(".debug_abbrev"))) {
-        section_data = elf_reader_->GetSectionByIndex(shndx, &section_size);
+      // BuildIndex has looked up every section in the pool.
+      std::unordered_map<unsigned int, V1Section>::const_iterator section =
+          v1_sections_.find(shndx);
+      if (section != v1_sections_.end() && section->second.name) {
         sections->insert(std::make_pair(
-            ".debug_abbrev",
-            std::make_pair(reinterpret_cast<const uint8_t*> (section_data),
-                                                              section_size)));
-      } else if (!strncmp(section_name, ".debug_info", strlen(".debug_info"))) {
-        section_data = elf_reader_->GetSectionByIndex(shndx, &section_size);
-        sections->insert(std::make_pair(
-            ".debug_info",
-            std::make_pair(reinterpret_cast<const uint8_t*> (section_data),
-                           section_size)));
-      } else if (!strncmp(section_name, ".debug_str_offsets",
-                          strlen(".debug_str_offsets"))) {
-        section_data = elf_reader_->GetSectionByIndex(shndx, &section_size);
-        sections->insert(std::make_pair(
-            ".debug_str_offsets",
-            std::make_pair(reinterpret_cast<const uint8_t*> (section_data),
-                           section_size)));
+            section->second.name,
+            std::make_pair(section->second.data, section->second.size)));
       }
     }
     sections->insert(std::make_pair(
@@ -1231,10 +1421,8 @@ void DwpReader::ReadDebugSectionsForCU(uint64_t dwo_id,
                              + index * ncolumns_ * sizeof(uint32_t);
     const char* size_row =
         size_table_ + (index - 1) * ncolumns_ * sizeof(uint32_t);
-    if (size_row + ncolumns_ * sizeof(uint32_t) > cu_index_ + cu_index_size_) {
-      version_ = 0;
+    if (size_row + ncolumns_ * sizeof(uint32_t) > cu_index_ + cu_index_size_)
       return;
-    }
     for (unsigned int col = 0u; col < ncolumns_; ++col) {
       uint32_t section_id =
           byte_reader_.ReadFourBytes(reinterpret_cast<const uint8_t*>(id_row)
@@ -1279,42 +1467,20 @@ void DwpReader::ReadDebugSectionsForCU(uint64_t dwo_id,
   }
 }
 
-int DwpReader::LookupCU(uint64_t dwo_id) {
-  uint32_t slot = static_cast<uint32_t>(dwo_id) & (nslots_ - 1);
-  uint64_t probe = byte_reader_.ReadEightBytes(
-      reinterpret_cast<const uint8_t*>(phash_) + slot * sizeof(uint64_t));
-  if (probe != 0 && probe != dwo_id) {
-    uint32_t secondary_hash =
-        (static_cast<uint32_t>(dwo_id >> 32) & (nslots_ - 1)) | 1;
-    do {
-      slot = (slot + secondary_hash) & (nslots_ - 1);
-      probe = byte_reader_.ReadEightBytes(
-          reinterpret_cast<const uint8_t*>(phash_) + slot * sizeof(uint64_t));
-    } while (probe != 0 && probe != dwo_id);
-  }
-  if (probe == 0)
+int DwpReader::LookupCU(uint64_t dwo_id) const {
+  std::unordered_map<uint64_t, uint32_t>::const_iterator unit =
+      units_.find(dwo_id);
+  if (unit == units_.end())
     return -1;
-  return slot;
+  return unit->second;
 }
 
-uint32_t DwpReader::LookupCUv2(uint64_t dwo_id) {
-  uint32_t slot = static_cast<uint32_t>(dwo_id) & (nslots_ - 1);
-  uint64_t probe = byte_reader_.ReadEightBytes(
-      reinterpret_cast<const uint8_t*>(phash_) + slot * sizeof(uint64_t));
-  uint32_t index = byte_reader_.ReadFourBytes(
-      reinterpret_cast<const uint8_t*>(pindex_) + slot * sizeof(uint32_t));
-  if (index != 0 && probe != dwo_id) {
-    uint32_t secondary_hash =
-        (static_cast<uint32_t>(dwo_id >> 32) & (nslots_ - 1)) | 1;
-    do {
-      slot = (slot + secondary_hash) & (nslots_ - 1);
-      probe = byte_reader_.ReadEightBytes(
-          reinterpret_cast<const uint8_t*>(phash_) + slot * sizeof(uint64_t));
-      index = byte_reader_.ReadFourBytes(
-          reinterpret_cast<const uint8_t*>(pindex_) + slot * sizeof(uint32_t));
-    } while (index != 0 && probe != dwo_id);
-  }
-  return index;
+uint32_t DwpReader::LookupCUv2(uint64_t dwo_id) const {
+  std::unordered_map<uint64_t, uint32_t>::const_iterator unit =
+      units_.find(dwo_id);
+  if (unit == units_.end())
+    return 0;
+  return unit->second;
 }
 
 LineInfo::LineInfo(const uint8_t* buffer, uint64_t buffer_length,
@@ -1820,11 +1986,39 @@ void LineInfo::ReadLines() {
   uint64_t pending_address = 0;
   uint32_t pending_file_num = 0, pending_line_num = 0, pending_column_num = 0;
 
-  while (lineptr < lengthstart + header_.total_length) {
+  // Most of a line program is special opcodes, each of which advances the
+  // address and line by amounts that depend only on the opcode and the
+  // header. Work those out once, and handle special opcodes here rather
+  // than in ProcessOneOpcode, so the common case is a table lookup.
+  const bool fast_special = header_.line_range != 0;
+  int64_t special_address[256];
+  int32_t special_line[256];
+  if (fast_special) {
+    for (int opcode = header_.opcode_base; opcode < 256; opcode++) {
+      const uint8_t adjusted = opcode - header_.opcode_base;
+      special_address[opcode] = (adjusted / header_.line_range)
+                              * header_.min_insn_length;
+      special_line[opcode] = (adjusted % header_.line_range)
+                           + header_.line_base;
+    }
+  }
+
+  const uint8_t* end = lengthstart + header_.total_length;
+  while (lineptr < end) {
     size_t oplength;
-    bool add_row = ProcessOneOpcode(reader_, handler_, header_,
-                                    lineptr, &lsm, &oplength, (uintptr)-1,
-                                    NULL);
+    bool add_row;
+    const uint8_t opcode = *lineptr;
+    if (fast_special && opcode >= header_.opcode_base) {
+      lsm.address += special_address[opcode];
+      lsm.line_num += special_line[opcode];
+      lsm.basic_block = true;
+      oplength = 1;
+      add_row = true;
+    } else {
+      add_row = ProcessOneOpcode(reader_, handler_, header_,
+                                 lineptr, &lsm, &oplength, (uintptr)-1,
+                                 NULL);
+    }
     if (add_row) {
       if (have_pending_line)
         handler_->AddLine(pending_address, lsm.address - pending_address,
@@ -1844,7 +2038,7 @@ void LineInfo::ReadLines() {
     lineptr += oplength;
   }
 
-  after_header_ = lengthstart + header_.total_length;
+  after_header_ = end;
 }
 
 bool RangeListReader::ReadRanges(enum DwarfForm form, uint64_t data) {
@@ -1860,21 +2054,43 @@ bool RangeListReader::ReadRanges(enum DwarfForm form, uint64_t data) {
       // will just be the first byte after the header.
       cu_info_->ranges_base_ = reader_->OffsetSize() == 4? 12: 20;
     }
-    offset_array_ = cu_info_->ranges_base_;
+    if (cu_info_->offset_table_base_ != cu_info_->ranges_base_ &&
+        !ReadOffsetTable()) {
+      return false;
+    }
+    if (data >= cu_info_->offset_entry_count_) {
+      return false;
+    }
+    const uint64_t offset_array = cu_info_->ranges_base_;
     uint64_t index_offset = reader_->OffsetSize() * data;
     uint64_t range_list_offset =
-        reader_->ReadOffset(cu_info_->buffer_ + offset_array_ + index_offset);
+        reader_->ReadOffset(cu_info_->buffer_ + offset_array + index_offset);
 
-    return ReadDebugRngList(offset_array_ + range_list_offset);
+    return ReadDebugRngList(offset_array + range_list_offset);
   }
   return false;
 }
 
+bool RangeListReader::ReadOffsetTable() {
+  // The offset entry count is the last field of the header, immediately
+  // before the table, in both the 32- and 64-bit formats.
+  const uint64_t table = cu_info_->ranges_base_;
+  if (table < 4 || table > cu_info_->size_) {
+    return false;
+  }
+  uint64_t count = reader_->ReadFourBytes(cu_info_->buffer_ + table - 4);
+  uint64_t room = (cu_info_->size_ - table) / reader_->OffsetSize();
+  cu_info_->offset_table_base_ = table;
+  cu_info_->offset_entry_count_ = std::min(count, room);
+  return true;
+}
+
 bool RangeListReader::ReadDebugRanges(uint64_t offset) {
   const uint64_t max_address =
     (reader_->AddressSize() == 4) ? 0xffffffffUL
                                   : 0xffffffffffffffffULL;
   const uint64_t entry_size = reader_->AddressSize() * 2;
+  uint64_t base_address = cu_info_->base_address_;
   bool list_end = false;
 
   do {
@@ -1887,13 +2103,13 @@ bool RangeListReader::ReadDebugRanges(uint64_t offset) {
         cu_info_->buffer_ + offset + reader_->AddressSize());
 
     if (start_address == max_address) { // Base address selection
-      cu_info_->base_address_ = end_address;
+      base_address = end_address;
     } else if (start_address == 0 && end_address == 0) { // End-of-list
       handler_->Finish();
       list_end = true;
     } else { // Add a range entry
-      handler_->AddRange(start_address + cu_info_->base_address_,
-                         end_address + cu_info_->base_address_);
+      handler_->AddRange(start_address + base_address,
+                         end_address + base_address);
     }
 
     offset += entry_size;
@@ -1903,14 +2119,35 @@ bool RangeListReader::ReadDebugRanges(uint64_t offset) {
 }
 
 bool RangeListReader::ReadDebugRngList(uint64_t offset) {
+  const uint64_t size = cu_info_->size_;
+  const uint8_t address_size = reader_->AddressSize();
+  uint64_t base_address = cu_info_->base_address_;
+
+  // This CU's contribution to .debug_addr, for the entries that refer to
+  // addresses by index.
+  const uint8_t* addresses = nullptr;
+  uint64_t address_count = 0;
+  if (cu_info_->addr_buffer_ != nullptr && address_size != 0 &&
+      cu_info_->addr_base_ <= cu_info_->addr_buffer_size_) {
+    addresses = cu_info_->addr_buffer_ + cu_info_->addr_base_;
+    address_count =
+        (cu_info_->addr_buffer_size_ - cu_info_->addr_base_) / address_size;
+  }
+  auto address_at = [=](uint64_t index, uint64_t* address) {
+    if (index >= address_count)
+      return false;
+    *address = reader_->ReadAddress(addresses + index * address_size);
+    return true;
+  };
+
   uint64_t start = 0;
   uint64_t end = 0;
   uint64_t range_len = 0;
   uint64_t index = 0;
   // A uleb128's length isn't known until after it has been read, so overruns
   // are only caught after an entire entry.
-  while (offset < cu_info_->size_) {
-    uint8_t entry_type = reader_->ReadOneByte(cu_info_->buffer_ + offset);
+  while (offset < size) {
+    uint8_t entry_type = cu_info_->buffer_[offset];
     offset += 1;
     // Handle each entry type per Dwarf 5 Standard, section 2.17.3.
     switch (entry_type) {
@@ -1919,29 +2156,32 @@ bool RangeListReader::ReadDebugRngList(uint64_t offset) {
         return true;
       case DW_RLE_base_addressx:
         offset += ReadULEB(offset, &index);
-        cu_info_->base_address_ = GetAddressAtIndex(index);
+        if (!address_at(index, &base_address))
+          return false;
         break;
       case DW_RLE_startx_endx:
         offset += ReadULEB(offset, &index);
-        start = GetAddressAtIndex(index);
+        if (!address_at(index, &start))
+          return false;
         offset += ReadULEB(offset, &index);
-        end = GetAddressAtIndex(index);
+        if (!address_at(index, &end))
+          return false;
         handler_->AddRange(start, end);
         break;
       case DW_RLE_startx_length:
         offset += ReadULEB(offset, &index);
-        start = GetAddressAtIndex(index);
+        if (!address_at(index, &start))
+          return false;
         offset += ReadULEB(offset, &range_len);
         handler_->AddRange(start, start + range_len);
         break;
       case DW_RLE_offset_pair:
         offset += ReadULEB(offset, &start);
         offset += ReadULEB(offset, &end);
-        handler_->AddRange(start + cu_info_->base_address_,
-                           end + cu_info_->base_address_);
+        handler_->AddRange(start + base_address, end + base_address);
         break;
       case DW_RLE_base_address:
-        offset += ReadAddress(offset, &cu_info_->base_address_);
+        offset += ReadAddress(offset, &base_address);
         break;
       case DW_RLE_start_end:
         offset += ReadAddress(offset, &start);
@@ -1953,6 +2193,10 @@ bool RangeListReader::ReadDebugRngList(uint64_t offset) {
         offset += ReadULEB(offset, &end);
         handler_->AddRange(start, start + end);
         break;
+      default:
+        // An unknown entry's length is unknown too, so nothing after it
+        // can be read.
+        return false;
     }
   }
   return false;
@@ -46,6 +46,7 @@
 #include <list>
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 #include <memory>
@@ -257,7 +258,8 @@ class RangeListReader {
     CURangesInfo() :
         version_(0), base_address_(0), ranges_base_(0),
         buffer_(nullptr), size_(0), addr_buffer_(nullptr),
-        addr_buffer_size_(0), addr_base_(0) { }
+        addr_buffer_size_(0), addr_base_(0), offset_table_base_(0),
+        offset_entry_count_(0) { }
 
     uint16_t version_;
     // Ranges base address. Ordinarily the CU's low_pc.
@@ -272,14 +274,22 @@ class RangeListReader {
     const uint8_t* addr_buffer_;
     uint64_t addr_buffer_size_;
     uint64_t addr_base_;
+    // The .debug_rnglists offset table at offset_table_base_, which has
+    // offset_entry_count_ entries. RangeListReader reads the count from the
+    // table's header the first time it reads a DW_FORM_rnglistx value, and
+    // again only if ranges_base_ changes, so a CURangesInfo shared by every
+    // DIE in a CU reads the header once.
+    uint64_t offset_table_base_;
+    uint64_t offset_entry_count_;
   };
 
   RangeListReader(ByteReader* reader, CURangesInfo* cu_info,
                   RangeListHandler* handler) :
-      reader_(reader), cu_info_(cu_info), handler_(handler),
-      offset_array_(0) { }
+      reader_(reader), cu_info_(cu_info), handler_(handler) { }
 
-  // Read ranges from cu_info as specified by form and data.
+  // Read ranges from cu_info as specified by form and data. This leaves
+  // cu_info's base_address_ as it was, so the same CURangesInfo can be used
+  // to read any number of lists.
   bool ReadRanges(enum DwarfForm form, uint64_t data);
 
  private:
@@ -287,6 +297,9 @@ class RangeListReader {
   bool ReadDebugRanges(uint64_t offset);
   // Read dwarf5 .debug_rngslist at offset.
   bool ReadDebugRngList(uint64_t offset);
+  // Find the number of entries in the offset table at cu_info_'s
+  // ranges_base_. Return false if the table's header is out of bounds.
+  bool ReadOffsetTable();
 
   // Convenience functions to handle the mechanics of reading entries in the
   // ranges section.
@@ -301,19 +314,9 @@ class RangeListReader {
     return reader_->AddressSize();
   }
 
-  // Read the address at this CU's addr_index in the .debug_addr section.
-  uint64_t GetAddressAtIndex(uint64_t addr_index) {
-    assert(cu_info_->addr_buffer_ != nullptr);
-    uint64_t offset =
-        cu_info_->addr_base_ + addr_index * reader_->AddressSize();
-    assert(offset < cu_info_->addr_buffer_size_);
-    return reader_->ReadAddress(cu_info_->addr_buffer_ + offset);
-  }
-
   ByteReader* reader_;
   CURangesInfo* cu_info_;
   RangeListHandler* handler_;
-  uint64_t offset_array_;
 };
 
 // This class is the main interface between the reader and the
@@ -350,6 +353,12 @@ class Dwarf2Handler {
   // section. Return false if you would like to skip this DIE.
   virtual bool StartDIE(uint64_t offset, enum DwarfTag tag) { return false; }
 
+  // Return true if skipping a DIE means you want no StartDIE calls for its
+  // children either, so that the reader may jump over the whole subtree
+  // using the DIE's DW_AT_sibling attribute; EndDIE is still called for
+  // the DIE itself.  Called once per compilation unit.
+  virtual bool SkipChildrenOfSkippedDIEs() { return false; }
+
   // Called when we have an attribute with unsigned data to give to our
   // handler. The attribute is for the DIE at OFFSET from the beginning of the
   // .debug_info section. Its name is ATTR, its form is FORM, and its value is
@@ -471,6 +480,13 @@ class CompilationUnit {
   // processing the original compilation unit.
   void SetSplitDwarf(uint64_t addr_base, uint64_t dwo_id);
 
+  // Use DWP_READER as this unit's .dwp file instead of looking for one
+  // when ProcessSplitDwarf is called; if DWP_READER is NULL, there is no
+  // .dwp file, and only the .dwo file is tried.  This lets every skeleton
+  // unit of an executable share one reader, and so one copy of its index;
+  // see DwpReader::Open.
+  void SetDwpReader(std::shared_ptr<DwpReader> dwp_reader);
+
   // Begin reading a Dwarf2 compilation unit, and calling the
   // callbacks in the Dwarf2Handler
 
@@ -520,6 +536,16 @@ class CompilationUnit {
     enum DwarfTag tag;
     bool has_children;
     AttributeList attributes;
+    // True if the size of every attribute follows from its form alone, in
+    // which case FIXED_SIZE is their total, and a DIE can be skipped in one
+    // step.
+    bool has_fixed_size;
+    uint64_t fixed_size;
+    // True if there is a DW_AT_sibling attribute; with HAS_FIXED_SIZE,
+    // SIBLING_POSITION is where in the DIE its value lies.
+    bool has_sibling;
+    enum DwarfForm sibling_form;
+    uint64_t sibling_position;
   };
 
   // A DWARF2/3 compilation unit header.  This is not the same size as
@@ -667,13 +693,24 @@ class CompilationUnit {
   bool ProcessDIEs();
 
   // Skips the die with attributes specified in ABBREV starting at
-  // START, and return the new place to position the stream to.
-  const uint8_t* SkipDIE(const uint8_t* start, const Abbrev& abbrev);
+  // START, and return the new place to position the stream to.  If
+  // SIBLING is non-null, set *SIBLING to the DIE the skipped DIE's
+  // DW_AT_sibling attribute refers to, or to null if it has none.
+  const uint8_t* SkipDIE(const uint8_t* start, const Abbrev& abbrev,
+                         const uint8_t** sibling = nullptr);
 
   // Skips the attribute starting at START, with FORM, and return the
   // new place to position the stream to.
   const uint8_t* SkipAttribute(const uint8_t* start, enum DwarfForm form);
 
+  // If attributes of FORM always take the same number of bytes in this
+  // unit, set *SIZE to it and return true.
+  bool FixedAttributeSize(enum DwarfForm form, uint64_t* size);
+
+  // Return the DIE that the DW_AT_sibling attribute at START, of FORM,
+  // refers to, or null if FORM isn't a reference within this unit.
+  const uint8_t* ReadSibling(const uint8_t* start, enum DwarfForm form);
+
   // Read the debug sections from a .dwo file.
   void ReadDebugSectionsFromDwo(ElfReader* elf_reader,
                                 SectionMap* sections);
@@ -770,8 +807,8 @@ class CompilationUnit {
   // ElfReader for the dwo/dwo file.
   std::unique_ptr<ElfReader> split_elf_reader_;
 
-  // DWP reader.
-  std::unique_ptr<DwpReader> dwp_reader_;
+  // DWP reader, possibly shared with other units.
+  std::shared_ptr<DwpReader> dwp_reader_;
 
   bool should_process_split_dwarf_;
 
@@ -795,31 +832,72 @@ class CompilationUnit {
 // one of each debug section, and the .debug_cu_index section
 // maps from the dwo_id to a set of offsets and lengths that
 // identify each .dwo file's contribution to the larger sections.
+//
+// Initialize reads the whole index, and everything ReadDebugSectionsForCU
+// needs from the ELF file, so once it has returned, several threads may
+// call ReadDebugSectionsForCU on one reader at the same time.
 
 class DwpReader {
  public:
   DwpReader(const ByteReader& byte_reader, ElfReader* elf_reader);
 
+  // Find the .dwp file for the executable or .debug file at PATH: PATH
+  // with ".dwp" appended, or with a ".debug" suffix replaced by ".dwp".
+  // If there is one and it is an ELF file, return an initialized reader
+  // for it, which owns its ElfReader; otherwise, return NULL.
+  static std::shared_ptr<DwpReader> Open(const string& path,
+                                         enum Endianness endianness);
+
   // Read the CU index and initialize data members.
   void Initialize();
 
   // Read the debug sections for the given dwo_id.
-  void ReadDebugSectionsForCU(uint64_t dwo_id, SectionMap* sections);
+  void ReadDebugSectionsForCU(uint64_t dwo_id, SectionMap* sections) const;
+
+  // The path of the .dwp file, if this reader was returned by Open.
+  const string& path() const { return path_; }
+
+  // The ByteReader for the .dwp file.
+  const ByteReader& byte_reader() const { return byte_reader_; }
 
  private:
-  // Search a v1 hash table for "dwo_id".  Returns the slot index
+  // Find "dwo_id" in the index.  For a v1 file, returns the slot index
   // where the dwo_id was found, or -1 if it was not found.
-  int LookupCU(uint64_t dwo_id);
+  int LookupCU(uint64_t dwo_id) const;
 
-  // Search a v2 hash table for "dwo_id".  Returns the row index
-  // in the offsets and sizes tables, or 0 if it was not found.
-  uint32_t LookupCUv2(uint64_t dwo_id);
+  // Find "dwo_id" in the index.  For a v2 or v5 file, returns the row
+  // index in the offsets and sizes tables, or 0 if it was not found.
+  uint32_t LookupCUv2(uint64_t dwo_id) const;
+
+  // Fill in units_ from the hash table, and for a v1 file, fill in
+  // v1_sections_ from the section index pool.
+  void BuildIndex();
+
+  // The path of the .dwp file, and the ElfReader for it, if we opened
+  // it ourselves.
+  string path_;
+  std::unique_ptr<ElfReader> owned_elf_reader_;
 
   // The ELF reader for the .dwp file.
   ElfReader* elf_reader_;
 
   // The ByteReader for the .dwp file.
-  const ByteReader& byte_reader_;
+  ByteReader byte_reader_;
+
+  // A map from each dwo_id in the hash table to its slot (v1) or its row
+  // in the offsets and sizes tables (v2 and v5), built once so that a
+  // lookup needn't probe the hash table in the file.
+  std::unordered_map<uint64_t, uint32_t> units_;
+
+  // For a v1 file, the section map entry for each section index that
+  // appears in the section index pool and names one of the sections we
+  // read, so that ReadDebugSectionsForCU needn't ask the ElfReader.
+  struct V1Section {
+    const char* name;  // NULL if this isn't a section we read.
+    const uint8_t* data;
+    size_t size;
+  };
+  std::unordered_map<unsigned int, V1Section> v1_sections_;
 
   // Pointer to the .debug_cu_index section.
   const char* cu_index_;
@@ -107,6 +107,7 @@ class MockDwarf2Handler: public Dwarf2Handler {
                                                enum DwarfForm form,
                                                uint64_t signature));
   MOCK_METHOD1(EndDIE, void(uint64_t offset));
+  MOCK_METHOD0(SkipChildrenOfSkippedDIEs, bool());
 };
 
 struct DIEFixture {
@@ -125,6 +126,8 @@ struct DIEFixture {
     EXPECT_CALL(handler, ProcessAttributeBuffer(_, _, _, _, _)).Times(0);
     EXPECT_CALL(handler, ProcessAttributeString(_, _, _, _)).Times(0);
     EXPECT_CALL(handler, EndDIE(_)).Times(0);
+    EXPECT_CALL(handler, SkipChildrenOfSkippedDIEs())
+        .WillRepeatedly(Return(false));
   }
 
   // Return a reference to a section map whose .debug_info section refers
@@ -284,6 +287,87 @@ INSTANTIATE_TEST_SUITE_P(
                       DwarfHeaderParams(kBigEndian,    8, 5, 4, 1),
                       DwarfHeaderParams(kBigEndian,    8, 5, 8, 1)));
 
+class DwarfSkipChildren: public DIEFixture,
+                         public TestWithParam<DwarfHeaderParams> { };
+
+TEST_P(DwarfSkipChildren, SiblingJumpsOverChildren) {
+  Label abbrev_table = abbrevs.Here();
+  abbrevs.Abbrev(1, google_breakpad::DW_TAG_compile_unit,
+                 google_breakpad::DW_children_yes)
+      .EndAbbrev()
+      // All attributes fixed-size.
+      .Abbrev(2, google_breakpad::DW_TAG_structure_type,
+              google_breakpad::DW_children_yes)
+      .Attribute(google_breakpad::DW_AT_byte_size,
+                 google_breakpad::DW_FORM_data1)
+      .Attribute(google_breakpad::DW_AT_sibling, google_breakpad::DW_FORM_ref4)
+      .EndAbbrev()
+      // A string ahead of the sibling attribute.
+      .Abbrev(3, google_breakpad::DW_TAG_class_type,
+              google_breakpad::DW_children_yes)
+      .Attribute(google_breakpad::DW_AT_name, google_breakpad::DW_FORM_string)
+      .Attribute(google_breakpad::DW_AT_sibling, google_breakpad::DW_FORM_ref2)
+      .EndAbbrev()
+      .Abbrev(4, google_breakpad::DW_TAG_member,
+              google_breakpad::DW_children_no)
+      .Attribute(google_breakpad::DW_AT_name, google_breakpad::DW_FORM_string)
+      .EndAbbrev()
+      .EndTable();
+
+  info.set_format_size(GetParam().format_size);
+  info.set_endianness(GetParam().endianness);
+  Label structure, class_type, after_structure, after_class;
+  info.Header(GetParam().version, abbrev_table, GetParam().address_size,
+              google_breakpad::DW_UT_compile)
+      .ULEB128(1);                    // DW_TAG_compile_unit
+  structure = info.Here();
+  info.ULEB128(2)                     // DW_TAG_structure_type
+      .D8(4)                          // DW_AT_byte_size
+      .D32(after_structure)           // DW_AT_sibling
+      .ULEB128(4).AppendCString("x")  // DW_TAG_member
+      .D8(0);                         // end of children
+  after_structure = info.Here();
+  class_type = info.Here();
+  info.ULEB128(3)                     // DW_TAG_class_type
+      .AppendCString("c")             // DW_AT_name
+      .D16(after_class)               // DW_AT_sibling
+      .ULEB128(4).AppendCString("y")  // DW_TAG_member
+      .D8(0);                         // end of children
+  after_class = info.Here();
+  info.D8(0);                         // end of compile unit's children
+  info.Finish();
+
+  {
+    InSequence s;
+    EXPECT_CALL(handler, StartCompilationUnit(_, _, _, _, _))
+        .WillOnce(Return(true));
+    EXPECT_CALL(handler, SkipChildrenOfSkippedDIEs()).WillOnce(Return(true));
+    EXPECT_CALL(handler, StartDIE(_, google_breakpad::DW_TAG_compile_unit))
+        .WillOnce(Return(true));
+    EXPECT_CALL(handler, StartDIE(structure.Value(),
+                                  google_breakpad::DW_TAG_structure_type))
+        .WillOnce(Return(false));
+    EXPECT_CALL(handler, EndDIE(structure.Value())).WillOnce(Return());
+    EXPECT_CALL(handler, StartDIE(class_type.Value(),
+                                  google_breakpad::DW_TAG_class_type))
+        .WillOnce(Return(false));
+    EXPECT_CALL(handler, EndDIE(class_type.Value())).WillOnce(Return());
+    EXPECT_CALL(handler, EndDIE(_)).WillOnce(Return());
+  }
+
+  ByteReader byte_reader(GetParam().endianness == kLittleEndian ?
+                         ENDIANNESS_LITTLE : ENDIANNESS_BIG);
+  CompilationUnit parser("", MakeSectionMap(), 0, &byte_reader, &handler);
+  EXPECT_EQ(parser.Start(), info_contents.size());
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    HeaderVariants, DwarfSkipChildren,
+    ::testing::Values(DwarfHeaderParams(kLittleEndian, 4, 4, 8, 1),
+                      DwarfHeaderParams(kLittleEndian, 8, 5, 4, 1),
+                      DwarfHeaderParams(kBigEndian,    4, 2, 4, 1),
+                      DwarfHeaderParams(kBigEndian,    8, 5, 8, 1)));
+
 struct DwarfFormsFixture: public DIEFixture {
   // Start a compilation unit, as directed by |params|, containing one
   // childless DIE of the given tag, with one attribute of the given name
@@ -966,3 +1050,84 @@ TEST(RangeList, Dwarf5ReadRangeList_sec_offset) {
   EXPECT_FALSE(range_list_reader.ReadRanges(DW_FORM_sec_offset,
                                             rnglists_contents.size()));
 }
+
+TEST(RangeList, Dwarf5ReadRangeList_shared_info) {
+  using google_breakpad::RangeListReader;
+  using google_breakpad::DW_RLE_base_addressx;
+  using google_breakpad::DW_RLE_startx_length;
+  using google_breakpad::DW_RLE_offset_pair;
+  using google_breakpad::DW_RLE_end_of_list;
+  using google_breakpad::DW_FORM_rnglistx;
+
+  Section addr;
+  addr.set_endianness(kBigEndian);
+  addr.D32(0x100).D32(0x200);
+  std::string addr_contents;
+  assert(addr.GetContents(&addr_contents));
+
+  Section rnglists(kBigEndian);
+  Label section_size;
+  rnglists.Append(kBigEndian, 4, section_size);
+  rnglists.D16(5); // Version
+  rnglists.D8(4);  // Address size
+  rnglists.D8(0);  // Segment selector size
+  rnglists.D32(3); // Offset entry count
+  const uint64_t ranges_base = rnglists.Size();
+  Label range0, range1, range2;
+  rnglists.Append(kBigEndian, 4, range0);
+  rnglists.Append(kBigEndian, 4, range1);
+  rnglists.Append(kBigEndian, 4, range2);
+
+  // Range 0 moves the base address; range 1 must not see that.
+  range0 = rnglists.Size() - ranges_base;
+  rnglists.D8(DW_RLE_base_addressx).ULEB128(1); // base_addr = 0x200
+  rnglists.D8(DW_RLE_offset_pair).ULEB128(1).ULEB128(2);
+  rnglists.D8(DW_RLE_end_of_list);
+  range1 = rnglists.Size() - ranges_base;
+  rnglists.D8(DW_RLE_offset_pair).ULEB128(1).ULEB128(2);
+  rnglists.D8(DW_RLE_startx_length).ULEB128(0).ULEB128(0x10);
+  rnglists.D8(DW_RLE_end_of_list);
+  // Range 2 refers to an address past the end of .debug_addr.
+  range2 = rnglists.Size() - ranges_base;
+  rnglists.D8(DW_RLE_startx_length).ULEB128(2).ULEB128(0x10);
+  rnglists.D8(DW_RLE_end_of_list);
+  section_size = rnglists.Size() - 4;
+  string rnglists_contents;
+  assert(rnglists.GetContents(&rnglists_contents));
+
+  RangeListReader::CURangesInfo cu_info;
+  cu_info.version_ = 5;
+  cu_info.base_address_ = 0x1000;
+  cu_info.ranges_base_ = ranges_base;
+  cu_info.buffer_ =
+      reinterpret_cast<const uint8_t*>(rnglists_contents.data());
+  cu_info.size_ = rnglists_contents.size();
+  cu_info.addr_buffer_ =
+      reinterpret_cast<const uint8_t*>(addr_contents.data());
+  cu_info.addr_buffer_size_ = addr_contents.size();
+
+  ByteReader byte_reader(ENDIANNESS_BIG);
+  byte_reader.SetOffsetSize(4);
+  byte_reader.SetAddressSize(4);
+  MockRangeListHandler handler;
+  {
+    InSequence s;
+    EXPECT_CALL(handler, AddRange(0x201, 0x202));
+    EXPECT_CALL(handler, Finish());
+    EXPECT_CALL(handler, AddRange(0x1001, 0x1002));
+    EXPECT_CALL(handler, AddRange(0x100, 0x110));
+    EXPECT_CALL(handler, Finish());
+  }
+  // Each DIE makes its own reader, but they all share the CU's info.
+  EXPECT_TRUE(RangeListReader(&byte_reader, &cu_info, &handler)
+                  .ReadRanges(DW_FORM_rnglistx, 0));
+  EXPECT_TRUE(RangeListReader(&byte_reader, &cu_info, &handler)
+                  .ReadRanges(DW_FORM_rnglistx, 1));
+  EXPECT_FALSE(RangeListReader(&byte_reader, &cu_info, &handler)
+                   .ReadRanges(DW_FORM_rnglistx, 2));
+  EXPECT_FALSE(RangeListReader(&byte_reader, &cu_info, &handler)
+                   .ReadRanges(DW_FORM_rnglistx, 3));
+  EXPECT_EQ(0x1000U, cu_info.base_address_);
+  EXPECT_EQ(ranges_base, cu_info.offset_table_base_);
+  EXPECT_EQ(3U, cu_info.offset_entry_count_);
+}
@@ -46,6 +46,7 @@
 #include <map>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 // TODO(saugustine): Add support for compressed debug.
 // Also need to add configure tests for zlib.
@@ -358,7 +359,8 @@ class ElfReaderImpl {
         plts_supported_(false),
         plt_code_size_(0),
         plt0_size_(0),
-        visited_relocation_entries_(false) {
+        visited_relocation_entries_(false),
+        section_index_built_(false) {
     string error;
     is_dwp_ = MyHasSuffixString(path, ".dwp");
     ParseHeaders(fd, path);
@@ -745,54 +747,36 @@ class ElfReaderImpl {
   // "size".  Returns NULL if the section name is not found.
   const char* GetSectionContentsByName(const string& section_name,
                                        size_t* size) {
-    for (unsigned int k = 0u; k < GetNumSections(); ++k) {
-      // When searching for sections in a .dwp file, the sections
-      // we're looking for will always be at the end of the section
-      // table, so reverse the direction of iteration.
-      int shndx = is_dwp_ ? GetNumSections() - k - 1 : k;
-      const char* name = GetSectionName(section_headers_[shndx].sh_name);
-      if (name != NULL && ElfReader::SectionNamesMatch(section_name, name)) {
-        const ElfSectionReader<ElfArch>* section = GetSection(shndx);
-        if (section == NULL) {
-          return NULL;
-        } else {
-          *size = section->section_size();
-          return section->contents();
-        }
-      }
-    }
-    return NULL;
+    int shndx = FindSectionIndex(section_name);
+    if (shndx < 0)
+      return NULL;
+    const ElfSectionReader<ElfArch>* section = GetSection(shndx);
+    if (section == NULL)
+      return NULL;
+    *size = section->section_size();
+    return section->contents();
   }
 
   // This is like GetSectionContentsByName() but it returns a lot of extra
   // information about the section.
   const char* GetSectionInfoByName(const string& section_name,
                                    ElfReader::SectionInfo* info) {
-    for (unsigned int k = 0u; k < GetNumSections(); ++k) {
-      // When searching for sections in a .dwp file, the sections
-      // we're looking for will always be at the end of the section
-      // table, so reverse the direction of iteration.
-      int shndx = is_dwp_ ? GetNumSections() - k - 1 : k;
-      const char* name = GetSectionName(section_headers_[shndx].sh_name);
-      if (name != NULL && ElfReader::SectionNamesMatch(section_name, name)) {
-        const ElfSectionReader<ElfArch>* section = GetSection(shndx);
-        if (section == NULL) {
-          return NULL;
-        } else {
-          info->type = section->header().sh_type;
-          info->flags = section->header().sh_flags;
-          info->addr = section->header().sh_addr;
-          info->offset = section->header().sh_offset;
-          info->size = section->header().sh_size;
-          info->link = section->header().sh_link;
-          info->info = section->header().sh_info;
-          info->addralign = section->header().sh_addralign;
-          info->entsize = section->header().sh_entsize;
-          return section->contents();
-        }
-      }
-    }
-    return NULL;
+    int shndx = FindSectionIndex(section_name);
+    if (shndx < 0)
+      return NULL;
+    const ElfSectionReader<ElfArch>* section = GetSection(shndx);
+    if (section == NULL)
+      return NULL;
+    info->type = section->header().sh_type;
+    info->flags = section->header().sh_flags;
+    info->addr = section->header().sh_addr;
+    info->offset = section->header().sh_offset;
+    info->size = section->header().sh_size;
+    info->link = section->header().sh_link;
+    info->info = section->header().sh_info;
+    info->addralign = section->header().sh_addralign;
+    info->entsize = section->header().sh_entsize;
+    return section->contents();
   }
 
   // p_vaddr of the first PT_LOAD segment (if any), or 0 if no PT_LOAD
@@ -887,6 +871,43 @@ class ElfReaderImpl {
     return NULL;
   }
 
+  // Return the index of the first section that ElfReader::SectionNamesMatch
+  // says is SECTION_NAME, or -1 if there is none. When searching a .dwp
+  // file, the sections we're looking for will always be at the end of the
+  // section table, so the last match wins there instead.
+  int FindSectionIndex(const string& section_name) {
+    if (!section_index_built_)
+      BuildSectionIndex();
+    auto found = section_index_.find(section_name);
+    int shndx = found != section_index_.end() ? found->second : -1;
+    // A .debug_ name also matches the .zdebug_ section of that name.
+    static const char kDebugPrefix[] = ".debug_";
+    const size_t debug_prefix_length = sizeof(kDebugPrefix) - 1;
+    if (section_name.compare(0, debug_prefix_length, kDebugPrefix) == 0) {
+      found = section_index_.find(
+          ".zdebug_" + section_name.substr(debug_prefix_length));
+      if (found != section_index_.end() &&
+          (shndx < 0 || (is_dwp_ ? found->second > shndx
+                                 : found->second < shndx))) {
+        shndx = found->second;
+      }
+    }
+    return shndx;
+  }
+
+  // Fill in section_index_, mapping each section name to the index
+  // FindSectionIndex should return for it, so that lookups by name don't
+  // walk the section header table every time.
+  void BuildSectionIndex() {
+    section_index_built_ = true;
+    for (unsigned int k = 0u; k < GetNumSections(); ++k) {
+      int shndx = is_dwp_ ? GetNumSections() - k - 1 : k;
+      const char* name = GetSectionName(section_headers_[shndx].sh_name);
+      if (name != NULL)
+        section_index_.emplace(name, shndx);
+    }
+  }
+
   // Return an ElfSectionReader for the given section. The reader will
   // be freed when this object is destroyed.
   const ElfSectionReader<ElfArch>* GetSection(int num) {
@@ -1048,6 +1069,10 @@ class ElfReaderImpl {
 
   // True if this is a .dwp file.
   bool is_dwp_;
+
+  // Section indices by name, built by the first lookup by name.
+  std::unordered_map<string, int> section_index_;
+  bool section_index_built_;
 };
 
 ElfReader::ElfReader(const string& path)
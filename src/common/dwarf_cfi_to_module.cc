@@ -37,15 +37,14 @@
 #include <config.h>  // Must come first
 #endif
 
+#include <algorithm>
 #include <memory>
-#include <sstream>
 #include <utility>
 
 #include "common/dwarf_cfi_to_module.h"
 
 namespace google_breakpad {
 
-using std::ostringstream;
 
 vector<string> DwarfCFIToModule::RegisterNames::MakeVector(
     const char * const *strings,
@@ -175,6 +174,13 @@ bool DwarfCFIToModule::Entry(size_t offset, uint64_t address, uint64_t length,
                              unsigned return_address) {
   assert(!entry_);
 
+  if (addresses_) {
+    auto it = std::lower_bound(addresses_->begin(), addresses_->end(),
+                               address);
+    if (it == addresses_->end() || *it - address >= length)
+      return false;
+  }
+
   // If CallFrameInfo can handle this version and
   // augmentation, then we should be okay with that, so there's no
   // need to check them here.
@@ -185,14 +191,17 @@ bool DwarfCFIToModule::Entry(size_t offset, uint64_t address, uint64_t length,
   entry_->size = length;
   entry_offset_ = offset;
   return_address_ = return_address;
+  current_rules_.clear();
 
   // Breakpad STACK CFI records must provide a .ra rule, but DWARF CFI
   // may not establish any rule for .ra if the return address column
   // is an ordinary register, and that register holds the return
   // address on entry to the function. So establish an initial .ra
   // rule citing the return address register.
-  if (return_address_ < register_names_.size())
+  if (return_address_ < register_names_.size()) {
     entry_->initial_rules[ra_name_] = register_names_[return_address_];
+    current_rules_[ra_name_] = register_names_[return_address_];
+  }
 
   return true;
 }
@@ -219,20 +228,26 @@ void DwarfCFIToModule::Record(Module::Address address, int reg,
                               const string& rule) {
   assert(entry_);
 
-  // Place the name in our global set of strings, and then use the string
-  // from the set. Even though the assignment looks like a copy, all the
-  // major string implementations use reference counting internally,
-  // so the effect is to have all our data structures share copies of rules
-  // whenever possible. Since register names are drawn from a
-  // vector<string>, register names are already shared.
-  string shared_rule = *common_strings_.insert(rule).first;
+  string name = RegisterName(reg);
 
   // Is this one of this entry's initial rules?
-  if (address == entry_->address)
-    entry_->initial_rules[RegisterName(reg)] = shared_rule;
+  if (address == entry_->address) {
+    entry_->initial_rules[name] = rule;
+    current_rules_[name] = rule;
+    return;
+  }
+
+  // CFI instructions are interpreted in address order, so a change that
+  // restates the rule already in force (as DW_CFA_restore_state and
+  // repeated DW_CFA_def_cfa_offset instructions often do) would only add
+  // a redundant STACK CFI record. Drop it before it creates an empty row.
+  string& current = current_rules_[name];
+  if (current == rule)
+    return;
+  current = rule;
+
   // File it under the appropriate address.
-  else
-    entry_->rule_changes[address][RegisterName(reg)] = shared_rule;
+  entry_->rule_changes[address][name] = rule;
 }
 
 bool DwarfCFIToModule::UndefinedRule(uint64_t address, int reg) {
@@ -242,33 +257,33 @@ bool DwarfCFIToModule::UndefinedRule(uint64_t address, int reg) {
 }
 
 bool DwarfCFIToModule::SameValueRule(uint64_t address, int reg) {
-  ostringstream s;
-  s << RegisterName(reg);
-  Record(address, reg, s.str());
+  Record(address, reg, RegisterName(reg));
   return true;
 }
 
 bool DwarfCFIToModule::OffsetRule(uint64_t address, int reg,
                                   int base_register, long offset) {
-  ostringstream s;
-  s << RegisterName(base_register) << " " << offset << " + ^";
-  Record(address, reg, s.str());
+  string rule = RegisterName(base_register);
+  rule += ' ';
+  rule += std::to_string(offset);
+  rule += " + ^";
+  Record(address, reg, rule);
   return true;
 }
 
 bool DwarfCFIToModule::ValOffsetRule(uint64_t address, int reg,
                                      int base_register, long offset) {
-  ostringstream s;
-  s << RegisterName(base_register) << " " << offset << " +";
-  Record(address, reg, s.str());
+  string rule = RegisterName(base_register);
+  rule += ' ';
+  rule += std::to_string(offset);
+  rule += " +";
+  Record(address, reg, rule);
   return true;
 }
 
 bool DwarfCFIToModule::RegisterRule(uint64_t address, int reg,
                                     int base_register) {
-  ostringstream s;
-  s << RegisterName(base_register);
-  Record(address, reg, s.str());
+  Record(address, reg, RegisterName(base_register));
   return true;
 }
 
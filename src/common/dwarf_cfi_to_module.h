@@ -41,7 +41,6 @@
 #include <assert.h>
 #include <stdio.h>
 
-#include <set>
 #include <string>
 #include <memory>
 #include <vector>
@@ -53,7 +52,6 @@
 namespace google_breakpad {
 
 using google_breakpad::Module;
-using std::set;
 using std::vector;
 
 // A class that accepts parsed call frame information from the DWARF
@@ -139,6 +137,13 @@ class DwarfCFIToModule: public CallFrameInfo::Handler {
   }
   virtual ~DwarfCFIToModule() = default;
 
+  // Convert only the entries covering one of ADDRESSES, which must be
+  // sorted, and have the parser skip the rest. *this keeps a reference to
+  // the vector. By default, every entry is converted.
+  void SetAddresses(const vector<uint64_t>* addresses) {
+    addresses_ = addresses;
+  }
+
   virtual bool Entry(size_t offset, uint64_t address, uint64_t length,
                      uint8_t version, const string& augmentation,
                      unsigned return_address);
@@ -167,6 +172,9 @@ class DwarfCFIToModule: public CallFrameInfo::Handler {
   // The module to which we should add entries.
   Module* module_;
 
+  // The addresses whose entries we should convert, or NULL for all.
+  const vector<uint64_t>* addresses_ = nullptr;
+
   // Map from register numbers to register names.
   const vector<string>& register_names_;
 
@@ -189,16 +197,9 @@ class DwarfCFIToModule: public CallFrameInfo::Handler {
   // popular ones). Many, many rules cite these strings.
   string cfa_name_, ra_name_;
 
-  // A set of strings used by this CFI. Before storing a string in one of
-  // our data structures, insert it into this set, and then use the string
-  // from the set.
-  //
-  // Because string uses reference counting internally, simply using
-  // strings from this set, even if passed by value, assigned, or held
-  // directly in structures and containers (map<string, ...>, for example),
-  // causes those strings to share a single instance of each distinct piece
-  // of text.
-  set<string> common_strings_;
+  // The rule currently in force for each register in the entry we're
+  // constructing, used to drop rule changes that change nothing.
+  Module::RuleMap current_rules_;
 };
 
 } // namespace google_breakpad
@@ -279,6 +279,40 @@ TEST_F(Rule, DefaultReturnAddressRuleLater) {
   EXPECT_THAT(entries[0]->rule_changes, ContainerEq(expected_changes));
 }
 
+TEST_F(Rule, RedundantChangeDropped) {
+  const int cfa = DwarfCFIToModule::kCFARegister;
+  return_reg = 2;
+  StartEntry();
+  ASSERT_TRUE(handler.ValOffsetRule(entry_address, cfa, 4, 8));
+  ASSERT_TRUE(handler.ValOffsetRule(entry_address + 1, cfa, 4, 16));
+  ASSERT_TRUE(handler.OffsetRule(entry_address + 1, 6, cfa, -16));
+  ASSERT_TRUE(handler.ValOffsetRule(entry_address + 2, cfa, 4, 16));
+  ASSERT_TRUE(handler.ValOffsetRule(entry_address + 3, cfa, 4, 8));
+  ASSERT_TRUE(handler.OffsetRule(entry_address + 3, 6, cfa, -16));
+  ASSERT_TRUE(handler.End());
+  CheckEntry();
+  Module::RuleMap expected_initial;
+  expected_initial[".cfa"] = "reg4 8 +";
+  expected_initial[".ra"] = "reg2";
+  EXPECT_THAT(entries[0]->initial_rules, ContainerEq(expected_initial));
+  Module::RuleChangeMap expected_changes;
+  expected_changes[entry_address + 1][".cfa"] = "reg4 16 +";
+  expected_changes[entry_address + 1]["reg6"] = ".cfa -16 + ^";
+  expected_changes[entry_address + 3][".cfa"] = "reg4 8 +";
+  EXPECT_THAT(entries[0]->rule_changes, ContainerEq(expected_changes));
+}
+
+TEST_F(Entry, SkipUncoveredEntries) {
+  vector<uint64_t> addresses = { 0x1000, 0x2080 };
+  handler.SetAddresses(&addresses);
+  EXPECT_FALSE(handler.Entry(0x10, 0x1800, 0x100, 3, "", 0));
+  ASSERT_TRUE(handler.Entry(0x20, 0x2000, 0x100, 3, "", 0));
+  ASSERT_TRUE(handler.End());
+  module.GetStackFrameEntries(&entries);
+  ASSERT_EQ(1U, entries.size());
+  EXPECT_EQ(0x2000U, entries[0]->address);
+}
+
 TEST(RegisterNames, I386) {
   vector<string> names = DwarfCFIToModule::RegisterNames::I386();
 
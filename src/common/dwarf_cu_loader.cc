@@ -0,0 +1,885 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// dwarf_cu_loader.cc: Read the compilation units of a file's DWARF into a
+// Module.  See dwarf_cu_loader.h.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "common/dwarf_cu_loader.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <set>
+#include <thread>
+
+#include "common/dwarf/bytereader-inl.h"
+#include "common/dwarf/dwarf2diehandler.h"
+#include "common/md5.h"
+
+namespace google_breakpad {
+
+using std::vector;
+
+namespace {
+
+// Return NAME, an ELF or Mach-O section name, in its ELF form.
+string ElfSectionName(const string& name) {
+  if (name.compare(0, 2, "__") == 0)
+    return "." + name.substr(2);
+  return name;
+}
+
+}  // namespace
+
+bool IsDwarfUnitSection(const string& name) {
+  static const char* const kUnitSections[] = {
+    ".debug_abbrev", ".debug_addr", ".debug_info", ".debug_line",
+    ".debug_line_str", ".debug_ranges", ".debug_rnglists", ".debug_str",
+    ".debug_str_offsets"
+  };
+  const string elf_name = ElfSectionName(name);
+  for (const char* section : kUnitSections) {
+    if (elf_name == section)
+      return true;
+  }
+  return false;
+}
+
+bool StartProcessSplitDwarf(CompilationUnit* reader,
+                            Module* module,
+                            Endianness endianness,
+                            bool handle_inter_cu_refs,
+                            bool handle_inline,
+                            vector<Module::Function*>* staged_functions,
+                            SharedDwpReader* dwp_reader) {
+  std::string split_file;
+  SectionMap split_sections;
+  ByteReader split_byte_reader(endianness);
+  uint64_t cu_offset = 0;
+  if (dwp_reader)
+    reader->SetDwpReader(dwp_reader->Get());
+  if (!reader->ProcessSplitDwarf(split_file, split_sections, split_byte_reader,
+                                 cu_offset))
+    return true;
+  DwarfCUToModule::FileContext file_context(split_file, module,
+                                            handle_inter_cu_refs);
+  if (staged_functions)
+    file_context.StageFunctions();
+  for (auto section : split_sections)
+    file_context.AddSectionToSectionMap(section.first, section.second.first,
+                                        section.second.second);
+  // Because DWP/DWO file doesn't have .debug_addr/.debug_line/.debug_line_str,
+  // its debug info will refer to .debug_addr/.debug_line in the main binary.
+  if (file_context.section_map().find(".debug_addr") ==
+      file_context.section_map().end())
+    file_context.AddSectionToSectionMap(".debug_addr", reader->GetAddrBuffer(),
+                                        reader->GetAddrBufferLen());
+  if (file_context.section_map().find(".debug_line") ==
+      file_context.section_map().end())
+    file_context.AddSectionToSectionMap(".debug_line", reader->GetLineBuffer(),
+                                        reader->GetLineBufferLen());
+  if (file_context.section_map().find(".debug_line_str") ==
+      file_context.section_map().end())
+    file_context.AddSectionToSectionMap(".debug_line_str",
+                                        reader->GetLineStrBuffer(),
+                                        reader->GetLineStrBufferLen());
+
+  DumperRangesHandler ranges_handler(&split_byte_reader);
+  DumperLineToModule line_to_module(&split_byte_reader);
+  DwarfCUToModule::WarningReporter reporter(split_file, cu_offset);
+  DwarfCUToModule root_handler(
+      &file_context, &line_to_module, &ranges_handler, &reporter, handle_inline,
+      reader->GetLowPC(), reader->GetAddrBase(), reader->HasSourceLineInfo(),
+      reader->GetSourceLineOffset());
+  DIEDispatcher die_dispatcher(&root_handler);
+  CompilationUnit split_reader(split_file, file_context.section_map(),
+                               cu_offset, &split_byte_reader, &die_dispatcher);
+  split_reader.SetSplitDwarf(reader->GetAddrBase(), reader->GetDWOID());
+  split_reader.Start();
+  if (staged_functions) {
+    vector<Module::Function*>* functions = file_context.staged_functions();
+    staged_functions->insert(staged_functions->end(), functions->begin(),
+                             functions->end());
+    functions->clear();
+    if (file_context.has_inter_cu_references())
+      return false;
+  }
+  // Normally, it won't happen unless we have transitive reference.
+  if (split_reader.ShouldProcessSplitDwarf()) {
+    return StartProcessSplitDwarf(&split_reader, module, endianness,
+                                  handle_inter_cu_refs, handle_inline,
+                                  staged_functions, NULL);
+  }
+  return true;
+}
+
+namespace {
+
+// Compilation units read with a cache directory are stored there in files
+// named for an MD5 digest of everything reading them depends on: the
+// unit's bytes and offset, the other DWARF sections it may refer to, and
+// the options that affect reading.  Change kDwarfCacheVersion whenever
+// reading a unit may give a different result, so that stale files are
+// never used.
+const char kDwarfCacheVersion[] = "breakpad-dwarf-cu-cache-2";
+
+// Start CONTEXT off with VERSION, a cache version string of VERSION_SIZE
+// bytes, and the options that affect reading.
+void StartCacheKey(const char* version, size_t version_size,
+                   Endianness endianness,
+                   bool handle_inter_cu_refs,
+                   bool handle_inline,
+                   MD5Context* context) {
+  MD5Init(context);
+  MD5Update(context, reinterpret_cast<const unsigned char*>(version),
+            version_size);
+  const uint8_t flags[] = {
+    static_cast<uint8_t>(endianness),
+    static_cast<uint8_t>(handle_inter_cu_refs),
+    static_cast<uint8_t>(handle_inline)
+  };
+  MD5Update(context, flags, sizeof(flags));
+}
+
+// Start CONTEXT off with the parts of the cache key that all the units of
+// SECTION_MAP share.
+void StartDwarfCacheKey(const SectionMap& section_map,
+                        Endianness endianness,
+                        bool handle_inter_cu_refs,
+                        bool handle_inline,
+                        MD5Context* context) {
+  StartCacheKey(kDwarfCacheVersion, sizeof(kDwarfCacheVersion), endianness,
+                handle_inter_cu_refs, handle_inline, context);
+  auto add = [context](const void* data, size_t size) {
+    MD5Update(context, static_cast<const unsigned char*>(data), size);
+  };
+  for (const auto& section : section_map) {
+    const string& name = section.first;
+    if (!IsDwarfUnitSection(name) || ElfSectionName(name) == ".debug_info")
+      continue;
+    uint64_t size = section.second.second;
+    add(name.c_str(), name.size() + 1);
+    add(&size, sizeof(size));
+    add(section.second.first, size);
+  }
+}
+
+// Return the name of the cache file for the unit of SIZE bytes at UNIT,
+// OFFSET bytes into .debug_info, given CONTEXT as StartDwarfCacheKey
+// left it.
+string DwarfCacheKey(MD5Context context, uint64_t offset,
+                     const uint8_t* unit, uint64_t size) {
+  MD5Update(&context, reinterpret_cast<const unsigned char*>(&offset),
+            sizeof(offset));
+  MD5Update(&context, unit, size);
+  unsigned char digest[16];
+  MD5Final(digest, &context);
+  char name[sizeof(digest) * 2 + 1];
+  for (size_t i = 0; i < sizeof(digest); ++i)
+    snprintf(name + i * 2, 3, "%02x", digest[i]);
+  return name;
+}
+
+// A unit can also be found in the cache under a normalized key, which
+// lets binaries that link the same object file share its entry wherever
+// the linker put the unit and its code.  The key covers what
+// DwarfCUToModule reads for the unit, with DIE offsets taken relative to
+// the unit, addresses taken relative to the first one the unit mentions,
+// and strings, ranges and line rows looked up in the sections they live
+// in, so that nothing depends on where in those sections they are.  Units
+// are only keyed this way when moving them moves everything read from
+// them by the same amount: they refer to no DIEs outside themselves, and
+// no address they give is zero or within a page of the end of the address
+// space, which linkers use to mark discarded code.
+const char kNormalizedDwarfCacheVersion[] =
+    "breakpad-dwarf-cu-cache-normalized-1";
+
+// The first thing in a normalized cache file: where the unit whose
+// functions follow began in .debug_info, and the address its normalized
+// key was taken relative to.
+struct NormalizedCacheHeader {
+  uint64_t unit_offset;
+  uint64_t base_address;
+};
+
+class NormalizedUnitHasher : public Dwarf2Handler {
+ public:
+  NormalizedUnitHasher(const SectionMap& section_map, Endianness endianness,
+                       uint64_t unit_offset, uint64_t unit_size)
+      : section_map_(section_map), byte_reader_(endianness),
+        unit_offset_(unit_offset), unit_size_(unit_size) { }
+
+  // Read the unit, and set *KEY to the name of its normalized cache file
+  // and *BASE_ADDRESS to the address the key was taken relative to.
+  // CONTEXT is as StartDwarfCacheKey left it, less the sections.  Return
+  // false if the unit can't be read or can't be keyed this way.
+  bool Hash(const string& dwarf_filename, const MD5Context& context,
+            string* key, uint64_t* base_address);
+
+  bool StartCompilationUnit(uint64_t offset, uint8_t address_size,
+                            uint8_t offset_size, uint64_t cu_length,
+                            uint8_t dwarf_version) override {
+    version_ = dwarf_version;
+    max_address_ = address_size == 4 ? 0xffffffff : ~0ULL;
+    Add(dwarf_version);
+    Add(address_size);
+    Add(offset_size);
+    return true;
+  }
+  bool NeedSplitDebugInfo() override { return false; }
+  bool StartDIE(uint64_t offset, enum DwarfTag tag) override {
+    ++depth_;
+    Add('D');
+    Add(offset - unit_offset_);
+    Add(tag);
+    return true;
+  }
+  void EndDIE(uint64_t offset) override {
+    --depth_;
+    Add('E');
+  }
+  void ProcessAttributeUnsigned(uint64_t offset, enum DwarfAttribute attr,
+                                enum DwarfForm form, uint64_t data) override;
+  void ProcessAttributeSigned(uint64_t offset, enum DwarfAttribute attr,
+                              enum DwarfForm form, int64_t data) override {
+    Add(attr);
+    Add(form);
+    Add(data);
+  }
+  void ProcessAttributeReference(uint64_t offset, enum DwarfAttribute attr,
+                                 enum DwarfForm form,
+                                 uint64_t data) override {
+    if (data - unit_offset_ >= unit_size_)
+      relocatable_ = false;
+    Add(attr);
+    Add(form);
+    Add(data - unit_offset_);
+  }
+  // DwarfCUToModule reads no blocks, and they hold absolute addresses.
+  void ProcessAttributeBuffer(uint64_t offset, enum DwarfAttribute attr,
+                              enum DwarfForm form, const uint8_t* data,
+                              uint64_t len) override {
+    Add(attr);
+    Add(form);
+  }
+  void ProcessAttributeString(uint64_t offset, enum DwarfAttribute attr,
+                              enum DwarfForm form,
+                              const string& data) override {
+    if (attr == DW_AT_dwo_name || attr == DW_AT_GNU_dwo_name)
+      split_ = true;
+    Add(attr);
+    AddString(data);
+  }
+  void ProcessAttributeSignature(uint64_t offset, enum DwarfAttribute attr,
+                                 enum DwarfForm form,
+                                 uint64_t signature) override {
+    Add(attr);
+    Add(form);
+    Add(signature);
+  }
+
+  void Add(uint64_t value) {
+    MD5Update(&context_, reinterpret_cast<const unsigned char*>(&value),
+              sizeof(value));
+  }
+  void AddString(const string& str) {
+    MD5Update(&context_, reinterpret_cast<const unsigned char*>(str.c_str()),
+              str.size() + 1);
+  }
+  // Add the span of SIZE bytes at ADDRESS, relative to the base address.
+  void AddSpan(uint64_t address, uint64_t size) {
+    uint64_t end = address + size;
+    if (address == 0 || end < address || end > max_address_ - 0xfff)
+      relocatable_ = false;
+    Add('A');
+    Add(size);
+    addresses_.push_back(address);
+  }
+
+ private:
+  // A line hasher that adds the rows DwarfLineToModule would use, and
+  // those it would omit as belonging to discarded code, as they are.
+  class LineHasher : public LineInfoHandler {
+   public:
+    explicit LineHasher(NormalizedUnitHasher* unit) : unit_(unit) { }
+    void DefineDir(const string& name, uint32_t dir_num) override {
+      unit_->Add('d');
+      unit_->Add(dir_num);
+      unit_->AddString(name);
+    }
+    void DefineFile(const string& name, int32_t file_num, uint32_t dir_num,
+                    uint64_t mod_time, uint64_t length) override {
+      unit_->Add('f');
+      unit_->Add(file_num);
+      unit_->Add(dir_num);
+      unit_->AddString(name);
+    }
+    void AddLine(uint64_t address, uint64_t length, uint32_t file_num,
+                 uint32_t line_num, uint32_t column_num) override {
+      if (length == 0)
+        return;
+      unit_->Add('l');
+      unit_->Add(file_num);
+      unit_->Add(line_num);
+      if (address == 0 || address == omitted_line_end_) {
+        omitted_line_end_ = address + length;
+        unit_->Add(address);
+        unit_->Add(length);
+        return;
+      }
+      omitted_line_end_ = 0;
+      unit_->AddSpan(address, length);
+    }
+   private:
+    NormalizedUnitHasher* unit_;
+    uint64_t omitted_line_end_ = 0;
+  };
+
+  void HashRanges();
+  void HashLines();
+
+  const SectionMap& section_map_;
+  ByteReader byte_reader_;
+  uint64_t unit_offset_, unit_size_;
+  MD5Context context_;
+  int depth_ = 0;
+  uint16_t version_ = 0;
+  uint64_t max_address_ = ~0ULL;
+  bool relocatable_ = true;
+  bool split_ = false;
+
+  // The addresses added, in order, to be hashed relative to the first.
+  vector<uint64_t> addresses_;
+
+  // What the unit's DIE gives for reading its ranges and lines.
+  uint64_t low_pc_ = 0;
+  uint64_t ranges_base_ = 0;
+  uint64_t addr_base_ = 0;
+  bool has_lines_ = false;
+  uint64_t line_offset_ = 0;
+
+  // The DW_AT_ranges attributes seen, to read once the unit's DIE has
+  // given all the bases.
+  vector<std::pair<DwarfForm, uint64_t>> ranges_;
+};
+
+void NormalizedUnitHasher::ProcessAttributeUnsigned(uint64_t offset,
+                                                    enum DwarfAttribute attr,
+                                                    enum DwarfForm form,
+                                                    uint64_t data) {
+  Add(attr);
+  Add(form);
+  bool is_address = form == DW_FORM_addr || form == DW_FORM_addrx ||
+      form == DW_FORM_addrx1 || form == DW_FORM_addrx2 ||
+      form == DW_FORM_addrx3 || form == DW_FORM_addrx4 ||
+      form == DW_FORM_GNU_addr_index;
+  switch (attr) {
+    case DW_AT_low_pc:
+      if (depth_ == 1) {
+        // A unit's low_pc may be zero when it only serves as the base
+        // for its range lists.
+        low_pc_ = data;
+        if (data == 0)
+          return;
+      }
+      AddSpan(data, 0);
+      return;
+    case DW_AT_high_pc:
+      if (is_address)
+        AddSpan(data, 0);
+      else
+        Add(data);
+      return;
+    case DW_AT_ranges:
+      ranges_.emplace_back(form, data);
+      return;
+    case DW_AT_stmt_list:
+      has_lines_ = true;
+      line_offset_ = data;
+      return;
+    case DW_AT_rnglists_base:
+      if (depth_ == 1)
+        ranges_base_ = data;
+      return;
+    case DW_AT_addr_base:
+    case DW_AT_GNU_addr_base:
+      if (depth_ == 1)
+        addr_base_ = data;
+      return;
+    case DW_AT_location:
+    case DW_AT_frame_base:
+    case DW_AT_macro_info:
+    case DW_AT_str_offsets_base:
+    case DW_AT_GNU_ranges_base:
+      return;
+    default:
+      break;
+  }
+  // Other addresses and section offsets go unread.
+  if (is_address || form == DW_FORM_sec_offset ||
+      form == DW_FORM_loclistx || form == DW_FORM_rnglistx)
+    return;
+  Add(data);
+}
+
+void NormalizedUnitHasher::HashRanges() {
+  RangeListReader::CURangesInfo info;
+  info.version_ = version_;
+  info.base_address_ = low_pc_;
+  info.ranges_base_ = ranges_base_;
+  SectionMap::const_iterator ranges_entry = GetSectionByName(
+      section_map_, version_ <= 4 ? ".debug_ranges" : ".debug_rnglists");
+  SectionMap::const_iterator addr_entry =
+      GetSectionByName(section_map_, ".debug_addr");
+  bool have_sections = ranges_entry != section_map_.end() &&
+      (version_ <= 4 || addr_entry != section_map_.end());
+  if (have_sections) {
+    info.buffer_ = ranges_entry->second.first;
+    info.size_ = ranges_entry->second.second;
+    if (version_ > 4) {
+      info.addr_buffer_ = addr_entry->second.first;
+      info.addr_buffer_size_ = addr_entry->second.second;
+      info.addr_base_ = addr_base_;
+    }
+  }
+  DumperRangesHandler ranges_handler(&byte_reader_);
+  for (const auto& attribute : ranges_) {
+    vector<Module::Range> ranges;
+    bool ok = have_sections &&
+        ranges_handler.ReadRanges(attribute.first, attribute.second, &info,
+                                  &ranges);
+    Add('R');
+    Add(ok ? ranges.size() : ~0ULL);
+    for (const Module::Range& range : ranges)
+      AddSpan(range.address, range.size);
+  }
+}
+
+void NormalizedUnitHasher::HashLines() {
+  SectionMap::const_iterator line_entry =
+      GetSectionByName(section_map_, ".debug_line");
+  Add('L');
+  if (line_entry == section_map_.end() ||
+      line_offset_ >= line_entry->second.second) {
+    Add(0);
+    return;
+  }
+  Add(1);
+  const uint8_t* string_section = nullptr;
+  uint64_t string_section_length = 0;
+  SectionMap::const_iterator entry =
+      GetSectionByName(section_map_, ".debug_str");
+  if (entry != section_map_.end()) {
+    string_section = entry->second.first;
+    string_section_length = entry->second.second;
+  }
+  const uint8_t* line_string_section = nullptr;
+  uint64_t line_string_section_length = 0;
+  entry = GetSectionByName(section_map_, ".debug_line_str");
+  if (entry != section_map_.end()) {
+    line_string_section = entry->second.first;
+    line_string_section_length = entry->second.second;
+  }
+  LineHasher handler(this);
+  LineInfo parser(line_entry->second.first + line_offset_,
+                  line_entry->second.second - line_offset_, &byte_reader_,
+                  string_section, string_section_length,
+                  line_string_section, line_string_section_length, &handler);
+  parser.Start();
+}
+
+bool NormalizedUnitHasher::Hash(const string& dwarf_filename,
+                                const MD5Context& context, string* key,
+                                uint64_t* base_address) {
+  context_ = context;
+  CompilationUnit reader(dwarf_filename, section_map_, unit_offset_,
+                         &byte_reader_, this);
+  if (reader.Start() != unit_size_ || split_ || !relocatable_)
+    return false;
+  HashRanges();
+  if (has_lines_)
+    HashLines();
+  if (!relocatable_)
+    return false;
+
+  *base_address = addresses_.empty() ? 0 : addresses_.front();
+  Add(addresses_.size());
+  for (uint64_t address : addresses_)
+    Add(address - *base_address);
+  unsigned char digest[16];
+  MD5Final(digest, &context_);
+  char name[sizeof(digest) * 2 + 1];
+  for (size_t i = 0; i < sizeof(digest); ++i)
+    snprintf(name + i * 2, 3, "%02x", digest[i]);
+  *key = name;
+  return true;
+}
+
+// Read the functions cached at PATH into MODULE, a fresh staging module,
+// appending them to FUNCTIONS.  If HEADER is non-NULL, the file is a
+// normalized one, and the functions are moved from where the header it
+// starts with says the unit was to where HEADER says it is.  Return false
+// if there are none.
+bool ReadCachedUnit(const string& path, Module* module,
+                    vector<Module::Function*>* functions,
+                    const NormalizedCacheHeader* header = NULL) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file)
+    return false;
+  NormalizedCacheHeader cached = {};
+  bool ok = (!header || fread(&cached, sizeof(cached), 1, file) == 1) &&
+      module->ReadStagedData(
+          file, functions,
+          header ? header->base_address - cached.base_address : 0,
+          header ? header->unit_offset - cached.unit_offset : 0);
+  fclose(file);
+  return ok;
+}
+
+// Cache FUNCTIONS, staged in MODULE, at PATH, after HEADER if it is
+// non-NULL.  The file is written under a temporary name and renamed into
+// place, so that other dump_syms processes sharing the cache never see it
+// half written.
+void WriteCachedUnit(const string& path, Module* module,
+                     const vector<Module::Function*>& functions,
+                     const NormalizedCacheHeader* header = NULL) {
+  string temp_path = path + ".XXXXXX";
+  int fd = mkstemp(&temp_path[0]);
+  if (fd < 0)
+    return;
+  FILE* file = fdopen(fd, "wb");
+  if (!file) {
+    close(fd);
+    unlink(temp_path.c_str());
+    return;
+  }
+  bool ok = (!header || fwrite(header, sizeof(*header), 1, file) == 1) &&
+      module->WriteStagedData(file, functions);
+  ok = fclose(file) == 0 && ok;
+  if (!ok || rename(temp_path.c_str(), path.c_str()) != 0)
+    unlink(temp_path.c_str());
+}
+
+// Set UNIT_OFFSETS and UNIT_SIZES to the offset and size of each unit in
+// the LENGTH bytes of .debug_info at DEBUG_INFO, from their headers.
+// Return false if a header is truncated or claims more bytes than remain.
+bool FindUnits(const uint8_t* debug_info, uint64_t length,
+               Endianness endianness, vector<uint64_t>* unit_offsets,
+               vector<uint64_t>* unit_sizes) {
+  ByteReader header_reader(endianness);
+  for (uint64_t offset = 0; offset < length;) {
+    uint64_t remaining = length - offset;
+    if (remaining < 4)
+      return false;
+    uint64_t header_size = 4;
+    uint64_t unit_length = header_reader.ReadFourBytes(debug_info + offset);
+    if (unit_length == 0xffffffff) {
+      if (remaining < 12)
+        return false;
+      header_size = 12;
+      unit_length = header_reader.ReadEightBytes(debug_info + offset + 4);
+    }
+    if (unit_length > remaining - header_size)
+      return false;
+    unit_offsets->push_back(offset);
+    unit_sizes->push_back(header_size + unit_length);
+    offset += header_size + unit_length;
+  }
+  return true;
+}
+
+// Read the .debug_aranges section of LENGTH bytes at ARANGES, and add the
+// .debug_info offset of each unit it describes to DESCRIBED, and of each
+// unit with a range covering one of ADDRESSES, which must be sorted, to
+// COVERING.  Return false if the section is malformed.
+bool ReadAranges(const uint8_t* aranges, uint64_t length,
+                 Endianness endianness, const vector<uint64_t>& addresses,
+                 std::set<uint64_t>* described, std::set<uint64_t>* covering) {
+  ByteReader reader(endianness);
+  for (uint64_t offset = 0; offset < length;) {
+    const uint8_t* set = aranges + offset;
+    uint64_t remaining = length - offset;
+    if (remaining < 4)
+      return false;
+    uint64_t header_size = 4;
+    uint64_t set_length = reader.ReadFourBytes(set);
+    uint8_t offset_size = 4;
+    if (set_length == 0xffffffff) {
+      if (remaining < 12)
+        return false;
+      header_size = 12;
+      offset_size = 8;
+      set_length = reader.ReadEightBytes(set + 4);
+    }
+    if (set_length > remaining - header_size)
+      return false;
+    const uint8_t* end = set + header_size + set_length;
+
+    // The version, the unit's offset, and the address and segment
+    // selector sizes.
+    const uint8_t* cursor = set + header_size;
+    if (end - cursor < 2 + offset_size + 2)
+      return false;
+    cursor += 2;
+    uint64_t unit_offset = offset_size == 4 ? reader.ReadFourBytes(cursor)
+                                            : reader.ReadEightBytes(cursor);
+    cursor += offset_size;
+    uint8_t address_size = reader.ReadOneByte(cursor);
+    uint8_t segment_size = reader.ReadOneByte(cursor + 1);
+    cursor += 2;
+    if ((address_size != 4 && address_size != 8) || segment_size != 0)
+      return false;
+    described->insert(unit_offset);
+
+    // The tuples start at a multiple of their size from the start of the
+    // set, and end with a pair of zeros or the end of the set.
+    const uint64_t tuple_size = 2 * address_size;
+    cursor = set + (cursor - set + tuple_size - 1) / tuple_size * tuple_size;
+    for (; end - cursor >= static_cast<ptrdiff_t>(tuple_size);
+         cursor += tuple_size) {
+      uint64_t start = address_size == 4 ? reader.ReadFourBytes(cursor)
+                                         : reader.ReadEightBytes(cursor);
+      uint64_t size = address_size == 4
+          ? reader.ReadFourBytes(cursor + address_size)
+          : reader.ReadEightBytes(cursor + address_size);
+      if (start == 0 && size == 0)
+        break;
+      auto it = std::lower_bound(addresses.begin(), addresses.end(), start);
+      if (it != addresses.end() && *it - start < size)
+        covering->insert(unit_offset);
+    }
+    offset += header_size + set_length;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool LoadDwarfConcurrently(const string& dwarf_filename,
+                           const SectionMap& section_map,
+                           Endianness endianness,
+                           bool handle_inter_cu_refs,
+                           bool handle_inline,
+                           bool report_warnings,
+                           int num_threads,
+                           const string& cache_dir,
+                           SharedDwpReader* dwp_reader,
+                           Module* module) {
+  SectionMap::const_iterator debug_info_entry =
+      GetSectionByName(section_map, ".debug_info");
+  assert(debug_info_entry != section_map.end());
+  const uint8_t* debug_info = debug_info_entry->second.first;
+  uint64_t debug_info_length = debug_info_entry->second.second;
+
+  // Find where each compilation unit starts from the unit headers.
+  vector<uint64_t> unit_offsets;
+  vector<uint64_t> unit_sizes;
+  if (!FindUnits(debug_info, debug_info_length, endianness, &unit_offsets,
+                 &unit_sizes))
+    return false;
+  if (unit_offsets.empty() ||
+      (unit_offsets.size() < 2 && cache_dir.empty()))
+    return false;
+
+  MD5Context cache_context;
+  MD5Context normalized_context;
+  if (!cache_dir.empty()) {
+    StartDwarfCacheKey(section_map, endianness, handle_inter_cu_refs,
+                       handle_inline, &cache_context);
+    StartCacheKey(kNormalizedDwarfCacheVersion,
+                  sizeof(kNormalizedDwarfCacheVersion), endianness,
+                  handle_inter_cu_refs, handle_inline, &normalized_context);
+  }
+
+  struct StagedUnit {
+    std::unique_ptr<Module> module;
+    vector<Module::Function*> functions;
+    bool ok = false;
+  };
+  vector<StagedUnit> units(unit_offsets.size());
+  std::atomic<size_t> next_unit(0);
+  std::atomic<size_t> cached_units(0);
+  auto read_units = [&]() {
+    for (size_t i = next_unit++; i < units.size(); i = next_unit++) {
+      StagedUnit& unit = units[i];
+      string cache_path;
+      string normalized_path;
+      NormalizedCacheHeader header = { unit_offsets[i], 0 };
+      if (!cache_dir.empty()) {
+        cache_path = cache_dir + "/" +
+            DwarfCacheKey(cache_context, unit_offsets[i],
+                          debug_info + unit_offsets[i], unit_sizes[i]);
+        unit.module.reset(new Module(module->name(), module->os(),
+                                     module->architecture(),
+                                     module->identifier()));
+        if (ReadCachedUnit(cache_path, unit.module.get(), &unit.functions)) {
+          unit.ok = true;
+          ++cached_units;
+          continue;
+        }
+
+        // Look for the unit as another binary linked it.
+        NormalizedUnitHasher hasher(section_map, endianness, unit_offsets[i],
+                                    unit_sizes[i]);
+        string key;
+        if (hasher.Hash(dwarf_filename, normalized_context, &key,
+                        &header.base_address)) {
+          normalized_path = cache_dir + "/" + key;
+          unit.module.reset(new Module(module->name(), module->os(),
+                                       module->architecture(),
+                                       module->identifier()));
+          if (ReadCachedUnit(normalized_path, unit.module.get(),
+                             &unit.functions, &header)) {
+            unit.ok = true;
+            ++cached_units;
+            continue;
+          }
+        }
+      }
+      unit.module.reset(new Module(module->name(), module->os(),
+                                   module->architecture(),
+                                   module->identifier()));
+      DwarfCUToModule::FileContext file_context(dwarf_filename,
+                                                unit.module.get(),
+                                                handle_inter_cu_refs);
+      for (const auto& section : section_map)
+        file_context.AddSectionToSectionMap(section.first,
+                                            section.second.first,
+                                            section.second.second);
+      file_context.StageFunctions();
+      ByteReader byte_reader(endianness);
+      DumperRangesHandler ranges_handler(&byte_reader);
+      DumperLineToModule line_to_module(&byte_reader);
+      std::unique_ptr<DwarfCUToModule::WarningReporter> reporter;
+      if (report_warnings) {
+        reporter.reset(new DwarfCUToModule::WarningReporter(dwarf_filename,
+                                                            unit_offsets[i]));
+      } else {
+        reporter.reset(new DwarfCUToModule::NullWarningReporter(
+            dwarf_filename, unit_offsets[i]));
+      }
+      DwarfCUToModule root_handler(&file_context, &line_to_module,
+                                   &ranges_handler, reporter.get(),
+                                   handle_inline);
+      DIEDispatcher die_dispatcher(&root_handler);
+      CompilationUnit reader(dwarf_filename, file_context.section_map(),
+                             unit_offsets[i], &byte_reader, &die_dispatcher);
+      unit.ok = reader.Start() == unit_sizes[i];
+      unit.functions.swap(*file_context.staged_functions());
+      unit.ok = unit.ok && !file_context.has_inter_cu_references();
+      if (unit.ok && reader.ShouldProcessSplitDwarf()) {
+        // The split unit's own file isn't part of the cache key, so units
+        // that have one are never cached.
+        unit.ok = StartProcessSplitDwarf(&reader, unit.module.get(),
+                                         endianness, handle_inter_cu_refs,
+                                         handle_inline, &unit.functions,
+                                         dwp_reader);
+      } else if (unit.ok && !cache_path.empty()) {
+        WriteCachedUnit(cache_path, unit.module.get(), unit.functions);
+        if (!normalized_path.empty()) {
+          WriteCachedUnit(normalized_path, unit.module.get(), unit.functions,
+                          &header);
+        }
+      }
+    }
+  };
+  vector<std::thread> threads;
+  size_t thread_count =
+      std::min(static_cast<size_t>(num_threads), units.size());
+  for (size_t i = 0; i < thread_count; ++i)
+    threads.emplace_back(read_units);
+  for (std::thread& thread : threads)
+    thread.join();
+
+  bool ok = true;
+  for (const StagedUnit& unit : units)
+    ok = ok && unit.ok;
+  if (!ok) {
+    for (StagedUnit& unit : units)
+      for (Module::Function* func : unit.functions)
+        delete func;
+    fprintf(stderr, "%s: compilation units refer to one another;"
+            " reading them on one thread\n", dwarf_filename.c_str());
+    return false;
+  }
+  if (!cache_dir.empty()) {
+    fprintf(stderr, "%s: %zu of %zu compilation units read from %s\n",
+            dwarf_filename.c_str(), cached_units.load(), units.size(),
+            cache_dir.c_str());
+  }
+
+  for (StagedUnit& unit : units) {
+    module->AdoptStagedData(unit.module.get(), unit.functions);
+    for (Module::Function* func : unit.functions)
+      if (!module->AddFunction(func))
+        delete func;
+    module->CheckFunctionLimit();
+  }
+  return true;
+}
+
+bool FindUnitsCoveringAddresses(const SectionMap& section_map,
+                                Endianness endianness,
+                                const vector<uint64_t>& addresses,
+                                vector<uint64_t>* unit_offsets) {
+  SectionMap::const_iterator debug_info_entry =
+      GetSectionByName(section_map, ".debug_info");
+  assert(debug_info_entry != section_map.end());
+  vector<uint64_t> all_offsets;
+  vector<uint64_t> unit_sizes;
+  if (!FindUnits(debug_info_entry->second.first,
+                 debug_info_entry->second.second, endianness, &all_offsets,
+                 &unit_sizes))
+    return false;
+
+  // Units that .debug_aranges doesn't mention, and every unit if it is
+  // missing or malformed, might cover any address, so they must be read.
+  std::set<uint64_t> described, covering;
+  SectionMap::const_iterator aranges_entry =
+      GetSectionByName(section_map, ".debug_aranges");
+  if (aranges_entry == section_map.end() ||
+      !ReadAranges(aranges_entry->second.first, aranges_entry->second.second,
+                   endianness, addresses, &described, &covering)) {
+    described.clear();
+  }
+  for (uint64_t offset : all_offsets) {
+    if (!described.count(offset) || covering.count(offset))
+      unit_offsets->push_back(offset);
+  }
+  return true;
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,183 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// dwarf_cu_loader.h: Read the compilation units of a file's DWARF into a
+// Module, on several threads when the units allow it.  The Linux and Mac
+// dump_syms share this, so that their units are read the same way.
+
+#ifndef COMMON_DWARF_CU_LOADER_H__
+#define COMMON_DWARF_CU_LOADER_H__
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/dwarf/bytereader.h"
+#include "common/dwarf/dwarf2reader.h"
+#include "common/dwarf_cu_to_module.h"
+#include "common/dwarf_line_to_module.h"
+#include "common/dwarf_range_list_handler.h"
+#include "common/module.h"
+#include "common/using_std_string.h"
+
+namespace google_breakpad {
+
+// A range handler that accepts rangelist data parsed by RangeListReader
+// and populates a range vector (typically owned by a function) with the
+// results.
+class DumperRangesHandler : public DwarfCUToModule::RangesHandler {
+ public:
+  explicit DumperRangesHandler(ByteReader* reader) : reader_(reader) { }
+
+  bool ReadRanges(enum DwarfForm form, uint64_t data,
+                  RangeListReader::CURangesInfo* cu_info,
+                  std::vector<Module::Range>* ranges) {
+    DwarfRangeListHandler handler(ranges);
+    RangeListReader range_list_reader(reader_, cu_info, &handler);
+    return range_list_reader.ReadRanges(form, data);
+  }
+
+ private:
+  ByteReader* reader_;
+};
+
+// A line-to-module loader that accepts line number info parsed by
+// LineInfo and populates a Module and a line vector with the results.
+class DumperLineToModule: public DwarfCUToModule::LineToModuleHandler {
+ public:
+  // Create a line-to-module converter using BYTE_READER.
+  explicit DumperLineToModule(ByteReader* byte_reader)
+      : byte_reader_(byte_reader) { }
+  void StartCompilationUnit(const string& compilation_dir) {
+    compilation_dir_ = compilation_dir;
+  }
+  void ReadProgram(const uint8_t* program,
+                   uint64_t length,
+                   const uint8_t* string_section,
+                   uint64_t string_section_length,
+                   const uint8_t* line_string_section,
+                   uint64_t line_string_section_length,
+                   Module* module,
+                   std::vector<Module::Line>* lines,
+                   std::map<uint32_t, Module::File*>* files) {
+    DwarfLineToModule handler(module, compilation_dir_, lines, files);
+    LineInfo parser(program, length, byte_reader_,
+                    string_section, string_section_length,
+                    line_string_section, line_string_section_length,
+                    &handler);
+    parser.Start();
+  }
+ private:
+  string compilation_dir_;
+  ByteReader* byte_reader_;
+};
+
+// The .dwp file holding a binary's split DWARF units, opened when the
+// first skeleton unit asks for it and then shared by every unit, on
+// whatever thread, so that the file is mapped and its index read once.
+class SharedDwpReader {
+ public:
+  SharedDwpReader(const string& dwarf_filename, Endianness endianness)
+      : dwarf_filename_(dwarf_filename), endianness_(endianness) {}
+
+  // Return the reader, or NULL if there is no .dwp file.
+  std::shared_ptr<DwpReader> Get() {
+    std::call_once(opened_, [this]() {
+      reader_ = DwpReader::Open(dwarf_filename_, endianness_);
+    });
+    return reader_;
+  }
+
+ private:
+  const string dwarf_filename_;
+  const Endianness endianness_;
+  std::once_flag opened_;
+  std::shared_ptr<DwpReader> reader_;
+};
+
+// Return true if NAME is one of the sections that the DWARF readers look up
+// in a file's section map when reading its compilation units.  The others,
+// .debug_loc, .debug_aranges, .debug_pubnames and the like, are never read
+// with them, so they need be neither decompressed nor hashed into cache
+// keys.  NAME may be an ELF (".debug_info") or a Mach-O ("__debug_info")
+// section name.
+bool IsDwarfUnitSection(const string& name);
+
+// Read the split DWARF unit READER refers to into MODULE.  If
+// STAGED_FUNCTIONS is non-NULL, append the unit's functions to it instead
+// of adding them to MODULE, and return false if the unit refers to DIEs
+// outside itself.  If DWP_READER is non-NULL, look for the unit in its
+// .dwp file rather than having READER open one of its own.
+bool StartProcessSplitDwarf(CompilationUnit* reader,
+                            Module* module,
+                            Endianness endianness,
+                            bool handle_inter_cu_refs,
+                            bool handle_inline,
+                            std::vector<Module::Function*>* staged_functions,
+                            SharedDwpReader* dwp_reader);
+
+// Read the compilation units of the .debug_info section in SECTION_MAP on
+// NUM_THREADS threads, each unit into a module of its own, and merge the
+// results into MODULE in unit order.  Return false, leaving MODULE's
+// functions untouched, if the units cannot be read independently of one
+// another; the caller should then read them one after the other.  If
+// CACHE_DIR is not empty, units cached there are replayed rather than
+// read, and units read are cached there; units linked from the same
+// object file into other binaries sharing CACHE_DIR are found there too,
+// wherever they were linked.  Split units are looked up in
+// DWP_READER's .dwp file, if there is one.  Warnings about the units are
+// reported only if REPORT_WARNINGS is true.
+bool LoadDwarfConcurrently(const string& dwarf_filename,
+                           const SectionMap& section_map,
+                           Endianness endianness,
+                           bool handle_inter_cu_refs,
+                           bool handle_inline,
+                           bool report_warnings,
+                           int num_threads,
+                           const string& cache_dir,
+                           SharedDwpReader* dwp_reader,
+                           Module* module);
+
+// Set UNIT_OFFSETS to the .debug_info offsets, in order, of the compilation
+// units in SECTION_MAP that may cover one of ADDRESSES, which must be
+// sorted.  Those .debug_aranges lists ranges for are included only if a
+// range covers an address; the others, and all of them if there is no
+// usable .debug_aranges, are included in case they do.  Return false if
+// the unit headers are malformed.
+bool FindUnitsCoveringAddresses(const SectionMap& section_map,
+                                Endianness endianness,
+                                const std::vector<uint64_t>& addresses,
+                                std::vector<uint64_t>* unit_offsets);
+
+}  // namespace google_breakpad
+
+#endif  // COMMON_DWARF_CU_LOADER_H__
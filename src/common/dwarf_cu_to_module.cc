@@ -49,6 +49,8 @@
 #include <algorithm>
 #include <memory>
 #include <numeric>
+#include <string_view>
+#include <unordered_map>
 #include <utility>
 
 #include "common/string_view.h"
@@ -93,6 +95,97 @@ struct DwarfCUToModule::Specification {
   StringView unqualified_name;
 };
 
+// The Specifications recorded for a file.  When inter-CU references are
+// handled these are kept for the whole file, and a large binary can have
+// millions, so rather than a map node apiece each is a 16-byte entry in a
+// vector sorted by DIE offset, naming its strings by their index in a
+// table of the distinct names seen.  DIEs are read in offset order, so
+// adding one is nearly always an append.
+class DwarfCUToModule::SpecificationTable {
+ public:
+  // Record SPEC as the Specification for the DIE at OFFSET, replacing
+  // any already recorded.
+  void Add(uint64_t offset, const Specification& spec) {
+    Entry entry;
+    entry.offset = offset;
+    if (!spec.qualified_name.empty()) {
+      entry.first = Intern(spec.qualified_name);
+      entry.second = kQualified;
+    } else {
+      entry.first = Intern(spec.enclosing_name);
+      entry.second = Intern(spec.unqualified_name);
+    }
+    if (entries_.empty() || entries_.back().offset < offset) {
+      entries_.push_back(entry);
+      return;
+    }
+    vector<Entry>::iterator it =
+        LowerBound(entries_.begin(), entries_.end(), offset);
+    if (it != entries_.end() && it->offset == offset)
+      *it = entry;
+    else
+      entries_.insert(it, entry);
+  }
+
+  // If a Specification has been recorded for the DIE at OFFSET, set *SPEC
+  // to it and return true.  Otherwise, return false.
+  bool Find(uint64_t offset, Specification* spec) const {
+    vector<Entry>::const_iterator it =
+        LowerBound(entries_.begin(), entries_.end(), offset);
+    if (it == entries_.end() || it->offset != offset)
+      return false;
+    *spec = Specification();
+    if (it->second == kQualified) {
+      spec->qualified_name = names_[it->first];
+    } else {
+      spec->enclosing_name = names_[it->first];
+      spec->unqualified_name = names_[it->second];
+    }
+    return true;
+  }
+
+  void Clear() {
+    entries_.clear();
+    names_.clear();
+    name_ids_.clear();
+  }
+
+ private:
+  struct Entry {
+    uint64_t offset;
+    // The qualified name, if second is kQualified; otherwise, the
+    // enclosing name.
+    uint32_t first;
+    // The unqualified name, or kQualified.
+    uint32_t second;
+  };
+
+  static const uint32_t kQualified = 0xffffffff;
+
+  template<typename Iterator>
+  static Iterator LowerBound(Iterator begin, Iterator end, uint64_t offset) {
+    return std::lower_bound(begin, end, offset,
+                            [](const Entry& entry, uint64_t offset) {
+                              return entry.offset < offset;
+                            });
+  }
+
+  // Return NAME's index in names_, adding it if it isn't there.  The
+  // names point into the module's string pool or the DWARF sections, so
+  // they outlive the table.
+  uint32_t Intern(StringView name) {
+    std::string_view key(name.data(), name.size());
+    auto result = name_ids_.emplace(key, names_.size());
+    if (result.second)
+      names_.push_back(name);
+    return result.first->second;
+  }
+
+  vector<Entry> entries_;
+  vector<StringView> names_;
+  std::unordered_map<std::string_view, uint32_t> name_ids_;
+};
+
 // An abstract origin -- base definition of an inline function.
 struct AbstractOrigin {
   explicit AbstractOrigin(StringView name) : name(name) {}
@@ -105,10 +198,10 @@ typedef map<uint64_t, AbstractOrigin> AbstractOriginByOffset;
 // Data global to the DWARF-bearing file that is private to the
 // DWARF-to-Module process.
 struct DwarfCUToModule::FilePrivate {
-  // A map from offsets of DIEs within the .debug_info section to
-  // Specifications describing those DIEs. Specification references can
-  // cross compilation unit boundaries.
-  SpecificationByOffset specifications;
+  // The Specifications describing DIEs within the .debug_info section,
+  // by offset. Specification references can cross compilation unit
+  // boundaries.
+  SpecificationTable specifications;
 
   AbstractOriginByOffset origins;
 
@@ -123,7 +216,9 @@ DwarfCUToModule::FileContext::FileContext(const string& filename,
     : filename_(filename),
       module_(module),
       handle_inter_cu_refs_(handle_inter_cu_refs),
-      file_private_(new FilePrivate()) {
+      file_private_(new FilePrivate()),
+      stage_functions_(false),
+      has_inter_cu_references_(false) {
 }
 
 DwarfCUToModule::FileContext::~FileContext() {
@@ -131,6 +226,8 @@ DwarfCUToModule::FileContext::~FileContext() {
         i != uncompressed_sections_.end(); ++i) {
     delete[] *i;
   }
+  for (Module::Function* func : staged_functions_)
+    delete func;
 }
 
 void DwarfCUToModule::FileContext::AddSectionToSectionMap(
@@ -155,7 +252,7 @@ DwarfCUToModule::FileContext::section_map() const {
 
 void DwarfCUToModule::FileContext::ClearSpecifications() {
   if (!handle_inter_cu_refs_)
-    file_private_->specifications.clear();
+    file_private_->specifications.Clear();
 }
 
 bool DwarfCUToModule::FileContext::IsUnhandledInterCUReference(
@@ -165,6 +262,13 @@ bool DwarfCUToModule::FileContext::IsUnhandledInterCUReference(
   return offset < compilation_unit_start;
 }
 
+void DwarfCUToModule::FileContext::NoteReference(uint64_t offset,
+                                                 uint64_t unit_start,
+                                                 uint64_t unit_end) {
+  if (stage_functions_ && (offset < unit_start || offset >= unit_end))
+    has_inter_cu_references_ = true;
+}
+
 // Information global to the particular compilation unit we're
 // parsing. This is for data shared across the CU's entire DIE tree,
 // and parameters from the code invoking the CU parser.
@@ -181,11 +285,15 @@ struct DwarfCUToModule::CUContext {
         language(Language::CPlusPlus),
         low_pc(low_pc),
         high_pc(0),
+        start_offset(0),
+        end_offset(0),
         ranges_form(DW_FORM_sec_offset),
         ranges_data(0),
         ranges_base(0),
         addr_base(addr_base),
-        str_offsets_base(0) {}
+        str_offsets_base(0),
+        range_list_info_assembled(false),
+        range_list_info_valid(false) {}
 
   ~CUContext() {
     for (vector<Module::Function*>::iterator it = functions.begin();
@@ -216,6 +324,11 @@ struct DwarfCUToModule::CUContext {
   uint64_t low_pc;
   uint64_t high_pc;
 
+  // The offsets of the start of this CU and of its end in the .debug_info
+  // section.
+  uint64_t start_offset;
+  uint64_t end_offset;
+
   // Ranges for this CU are read according to this form.
   enum DwarfForm ranges_form;
   uint64_t ranges_data;
@@ -262,6 +375,24 @@ struct DwarfCUToModule::CUContext {
     return true;
   }
 
+  // Return the data a RangeListReader needs to read this CU's ranges, or
+  // nullptr if the sections it needs are missing. The data is gathered the
+  // first time a DIE asks for it and then shared by all the CU's DIEs,
+  // which saves looking up the sections for each one and lets the reader
+  // keep the .debug_rnglists offset table it has resolved.
+  RangeListReader::CURangesInfo* RangeListInfo() {
+    if (!range_list_info_assembled) {
+      range_list_info_valid = AssembleRangeListInfo(&range_list_info);
+      range_list_info_assembled = true;
+    }
+    return range_list_info_valid ? &range_list_info : nullptr;
+  }
+
+  // RangeListInfo's cached result.
+  RangeListReader::CURangesInfo range_list_info;
+  bool range_list_info_assembled;
+  bool range_list_info_valid;
+
   // The functions defined in this compilation unit. We accumulate
   // them here during parsing. Then, in DwarfCUToModule::Finish, we
   // assign them lines and add them to file_context->module.
@@ -302,7 +433,7 @@ class DwarfCUToModule::GenericDIEHandler: public DIEHandler {
         parent_context_(parent_context),
         offset_(offset),
         declaration_(false),
-        specification_(NULL),
+        has_specification_(false),
         no_specification(false),
         abstract_origin_(NULL),
         forward_ref_die_offset_(0), specification_offset_(0) { }
@@ -347,10 +478,11 @@ class DwarfCUToModule::GenericDIEHandler: public DIEHandler {
   // It is false on DIEs with no DW_AT_declaration attribute.
   bool declaration_;
 
-  // If this DIE has a DW_AT_specification attribute, this is the
-  // Specification structure for the DIE the attribute refers to.
-  // Otherwise, this is NULL.
-  Specification* specification_;
+  // If this DIE has a DW_AT_specification attribute, has_specification_
+  // is true and specification_ is the Specification for the DIE the
+  // attribute refers to.
+  bool has_specification_;
+  Specification specification_;
 
   // If this DIE has DW_AT_specification with offset smaller than this DIE and
   // we can't find that in the specification map.
@@ -405,16 +537,16 @@ void DwarfCUToModule::GenericDIEHandler::ProcessAttributeReference(
         cu_context_->reporter->UnhandledInterCUReference(offset_, data);
         break;
       }
+      file_context->NoteReference(data, cu_context_->start_offset,
+                                  cu_context_->end_offset);
       // Find the Specification to which this attribute refers, and
       // set specification_ appropriately. We could do more processing
       // here, but it's better to leave the real work to our
       // EndAttribute member function, at which point we know we have
       // seen all the DIE's attributes.
-      SpecificationByOffset* specifications =
-          &file_context->file_private_->specifications;
-      SpecificationByOffset::iterator spec = specifications->find(data);
-      if (spec != specifications->end()) {
-        specification_ = &spec->second;
+      if (file_context->file_private_->specifications.Find(
+              data, &specification_)) {
+        has_specification_ = true;
       } else if (data > offset_) {
         forward_ref_die_offset_ = data;
       } else {
@@ -424,6 +556,8 @@ void DwarfCUToModule::GenericDIEHandler::ProcessAttributeReference(
       break;
     }
     case DW_AT_abstract_origin: {
+      cu_context_->file_context->NoteReference(
+          data, cu_context_->start_offset, cu_context_->end_offset);
       const AbstractOriginByOffset& origins =
           cu_context_->file_context->file_private_->origins;
       AbstractOriginByOffset::const_iterator origin = origins.find(data);
@@ -452,7 +586,7 @@ void DwarfCUToModule::GenericDIEHandler::ProcessAttributeString(
     case DW_AT_linkage_name: {
       string demangled;
       Language::DemangleResult result =
-          cu_context_->language->DemangleName(data, &demangled);
+          cu_context_->language->DemangleNameCached(data, &demangled);
       switch (result) {
         case Language::kDemangleSuccess:
           demangled_name_ =
@@ -482,9 +616,9 @@ StringView DwarfCUToModule::GenericDIEHandler::ComputeQualifiedName(
   if (!demangled_name_.empty()) {
     // Found it is this DIE.
     qualified_name = &demangled_name_;
-  } else if (specification_ && !specification_->qualified_name.empty()) {
+  } else if (has_specification_ && !specification_.qualified_name.empty()) {
     // Found it on the specification.
-    qualified_name = &specification_->qualified_name;
+    qualified_name = &specification_.qualified_name;
   }
 
   StringView* unqualified_name = nullptr;
@@ -503,8 +637,8 @@ StringView DwarfCUToModule::GenericDIEHandler::ComputeQualifiedName(
     // attribute, then use that; otherwise, check the specification.
     if (!name_attribute_.empty()) {
       unqualified_name = &name_attribute_;
-    } else if (specification_) {
-      unqualified_name = &specification_->unqualified_name;
+    } else if (has_specification_) {
+      unqualified_name = &specification_.unqualified_name;
     } else if (!raw_name_.empty()) {
       unqualified_name = &raw_name_;
     }
@@ -512,8 +646,8 @@ StringView DwarfCUToModule::GenericDIEHandler::ComputeQualifiedName(
     // Find the name of the enclosing context. If this DIE has a
     // specification, it's the specification's enclosing context that
     // counts; otherwise, use this DIE's context.
-    if (specification_) {
-      enclosing_name = &specification_->enclosing_name;
+    if (has_specification_) {
+      enclosing_name = &specification_.enclosing_name;
     } else if (parent_context_) {
       enclosing_name = &parent_context_->name;
     }
@@ -546,7 +680,8 @@ StringView DwarfCUToModule::GenericDIEHandler::ComputeQualifiedName(
       spec.enclosing_name = *enclosing_name;
       spec.unqualified_name = *unqualified_name;
     }
-    cu_context_->file_context->file_private_->specifications[offset_] = spec;
+    cu_context_->file_context->file_private_->specifications.Add(offset_,
+                                                                 spec);
   }
 
   return cu_context_->file_context->module_->AddStringToPool(return_value);
@@ -708,10 +843,10 @@ void DwarfCUToModule::InlineHandler::Finish() {
   } else {
     RangesHandler* ranges_handler = cu_context_->ranges_handler;
     if (ranges_handler) {
-      RangeListReader::CURangesInfo cu_info;
-      if (cu_context_->AssembleRangeListInfo(&cu_info)) {
+      RangeListReader::CURangesInfo* cu_info = cu_context_->RangeListInfo();
+      if (cu_info) {
         if (!ranges_handler->ReadRanges(ranges_form_, ranges_data_,
-                                        &cu_info, &ranges)) {
+                                        cu_info, &ranges)) {
           ranges.clear();
           cu_context_->reporter->MalformedRangeList(ranges_data_);
         }
@@ -933,10 +1068,10 @@ void DwarfCUToModule::FuncHandler::Finish() {
   } else {
     RangesHandler* ranges_handler = cu_context_->ranges_handler;
     if (ranges_handler) {
-      RangeListReader::CURangesInfo cu_info;
-      if (cu_context_->AssembleRangeListInfo(&cu_info)) {
+      RangeListReader::CURangesInfo* cu_info = cu_context_->RangeListInfo();
+      if (cu_info) {
         if (!ranges_handler->ReadRanges(ranges_form_, ranges_data_,
-                                        &cu_info, &ranges)) {
+                                        cu_info, &ranges)) {
           ranges.clear();
           cu_context_->reporter->MalformedRangeList(ranges_data_);
         }
@@ -1605,21 +1740,38 @@ void DwarfCUToModule::Finish() {
   AssignFilesToInlines();
 
   // Add our functions, which now have source lines assigned to them,
-  // to module_, and remove duplicate functions.
-  for (Module::Function* func : *functions)
-    if (!cu_context_->file_context->module_->AddFunction(func)) {
+  // to module_, and remove duplicate functions.  Staged functions are
+  // left for the caller to add.
+  FileContext* file_context = cu_context_->file_context;
+  for (Module::Function* func : *functions) {
+    if (file_context->stage_functions_) {
+      file_context->staged_functions_.push_back(func);
+    } else if (!file_context->module_->AddFunction(func)) {
       auto iter = cu_context_->spec_function_offsets.find(func);
       if (iter != cu_context_->spec_function_offsets.end())
         cu_context_->file_context->file_private_->forward_ref_die_to_func.erase(
             iter->second);
       delete func;
     }
+  }
 
   // Ownership of the function objects has shifted from cu_context to
-  // the Module.
+  // the Module, or to the file context when staging.
   functions->clear();
 
   cu_context_->file_context->ClearSpecifications();
+
+  // DIEs are read in order, so those this unit's functions wait on to
+  // name them that are not in a later unit never will be found.  Once no
+  // added function waits on a later unit, the Module may spill them.
+  if (!file_context->stage_functions_) {
+    std::map<uint64_t, Module::Function*>& forward_refs =
+        file_context->file_private_->forward_ref_die_to_func;
+    forward_refs.erase(forward_refs.begin(),
+                       forward_refs.lower_bound(cu_context_->end_offset));
+    if (forward_refs.empty())
+      file_context->module_->CheckFunctionLimit();
+  }
 }
 
 bool DwarfCUToModule::StartCompilationUnit(uint64_t offset,
@@ -1628,6 +1780,8 @@ bool DwarfCUToModule::StartCompilationUnit(uint64_t offset,
                                            uint64_t cu_length,
                                            uint8_t dwarf_version) {
   cu_context_->version = dwarf_version;
+  cu_context_->start_offset = offset;
+  cu_context_->end_offset = offset + (offset_size == 8 ? 12 : 4) + cu_length;
   return dwarf_version >= 2;
 }
 
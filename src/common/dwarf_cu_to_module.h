@@ -92,6 +92,23 @@ class DwarfCUToModule: public RootDIEHandler {
 
     const SectionMap& section_map() const;
 
+    // Make DwarfCUToModule leave the functions of the compilation units
+    // it reads in staged_functions(), in the order it would have added
+    // them to the module, instead of adding them.  For reading units into
+    // modules of their own, to merge into the file's module afterwards
+    // with Module::AdoptStagedData.
+    void StageFunctions() { stage_functions_ = true; }
+
+    // The functions staged so far.  The caller takes ownership of them.
+    vector<Module::Function*>* staged_functions() {
+      return &staged_functions_;
+    }
+
+    // Return true if, while staging, a unit referred to a DIE outside
+    // itself.  What such a unit yields depends on the units read before
+    // it, so it cannot be read on its own.
+    bool has_inter_cu_references() const { return has_inter_cu_references_; }
+
    private:
     friend class DwarfCUToModule;
 
@@ -104,6 +121,10 @@ class DwarfCUToModule: public RootDIEHandler {
     bool IsUnhandledInterCUReference(uint64_t offset,
                                      uint64_t compilation_unit_start) const;
 
+    // Note a reference to the DIE at OFFSET from the unit spanning
+    // [UNIT_START, UNIT_END), for has_inter_cu_references().
+    void NoteReference(uint64_t offset, uint64_t unit_start, uint64_t unit_end);
+
     // The name of this file, for use in error messages.
     const string filename_;
 
@@ -120,6 +141,12 @@ class DwarfCUToModule: public RootDIEHandler {
     // Inter-compilation unit data used internally by the handlers.
     scoped_ptr<FilePrivate> file_private_;
     std::vector<uint8_t *> uncompressed_sections_;
+
+    // Whether functions are staged, the functions staged, and whether a
+    // unit read while staging referred to another.
+    bool stage_functions_;
+    vector<Module::Function*> staged_functions_;
+    bool has_inter_cu_references_;
   };
 
   // An abstract base class for handlers that handle DWARF range lists for
@@ -355,15 +382,13 @@ class DwarfCUToModule: public RootDIEHandler {
   struct CUContext;
   struct DIEContext;
   struct Specification;
+  class SpecificationTable;
   class GenericDIEHandler;
   class FuncHandler;
   class LexicalBlockHandler;
   class InlineHandler;
   class NamedScopeHandler;
 
-  // A map from section offsets to specifications.
-  typedef map<uint64_t, Specification> SpecificationByOffset;
-
   // Set this compilation unit's source language to LANGUAGE.
   void SetLanguage(DwarfLanguage language);
 
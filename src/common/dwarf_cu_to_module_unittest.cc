@@ -811,6 +811,42 @@ TEST_F(SimpleCU, UnknownAbstractOrigin) {
                0x1758a0f941b71efbULL, 0x1cf154f1f545e146ULL);
 }
 
+TEST_F(SimpleCU, StageFunctions) {
+  PushLine(0x2805c4531be6ca0eULL, 0x686b52155a8d4d2cULL, "line-file", 6111581);
+
+  file_context_.StageFunctions();
+  StartCU();
+  AbstractInstanceDIE(&root_handler_, 0x6a1b0c4d5e2f3041ULL,
+                      google_breakpad::DW_INL_not_inlined, 0, "abstract-instance");
+  DefineInlineInstanceDIE(&root_handler_, "", 0x6a1b0c4d5e2f3041ULL,
+                          0x2805c4531be6ca0eULL, 0x686b52155a8d4d2cULL);
+  root_handler_.Finish();
+
+  // The function is left for the caller to add.
+  TestFunctionCount(0);
+  vector<Module::Function*>* staged = file_context_.staged_functions();
+  ASSERT_EQ(1U, staged->size());
+  EXPECT_EQ("abstract-instance", (*staged)[0]->name.str());
+  EXPECT_EQ(0x2805c4531be6ca0eULL, (*staged)[0]->address);
+  EXPECT_FALSE(file_context_.has_inter_cu_references());
+}
+
+TEST_F(SimpleCU, StageFunctionsInterCUReference) {
+  PushLine(0x2805c4531be6ca0eULL, 0x686b52155a8d4d2cULL, "line-file", 6111581);
+
+  file_context_.StageFunctions();
+  StartCU();
+  // The abstract instance lies past the end of the unit.
+  AbstractInstanceDIE(&root_handler_, 0x93e9cdad52826b39ULL,
+                      google_breakpad::DW_INL_not_inlined, 0, "abstract-instance");
+  DefineInlineInstanceDIE(&root_handler_, "", 0x93e9cdad52826b39ULL,
+                          0x2805c4531be6ca0eULL, 0x686b52155a8d4d2cULL);
+  root_handler_.Finish();
+
+  EXPECT_EQ(1U, file_context_.staged_functions()->size());
+  EXPECT_TRUE(file_context_.has_inter_cu_references());
+}
+
 TEST_F(SimpleCU, UnnamedFunction) {
   PushLine(0x72b80e41a0ac1d40ULL, 0x537174f231ee181cULL, "line-file", 14044850);
 
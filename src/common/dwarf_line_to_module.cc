@@ -104,6 +104,7 @@ void DwarfLineToModule::DefineFile(const string& name, int32_t file_num,
   // Find a Module::File object of the given name, and add it to the
   // file table.
   (*files_)[file_num] = module_->FindFile(full_name);
+  last_file_ = NULL;
 }
 
 void DwarfLineToModule::AddLine(uint64_t address, uint64_t length,
@@ -125,7 +126,11 @@ void DwarfLineToModule::AddLine(uint64_t address, uint64_t length,
   }
 
   // Find the source file being referred to.
-  Module::File *file = (*files_)[file_num];
+  if (!last_file_ || file_num != last_file_number_) {
+    last_file_number_ = file_num;
+    last_file_ = (*files_)[file_num];
+  }
+  Module::File *file = last_file_;
   if (!file) {
     if (!warned_bad_file_number_) {
       fprintf(stderr, "warning: DWARF line number data refers to "
@@ -134,6 +139,18 @@ void DwarfLineToModule::AddLine(uint64_t address, uint64_t length,
     }
     return;
   }
+
+  // Rows often differ only in their column, or in flags the symbol file
+  // doesn't record; fold those into the previous line.
+  if (extend_last_line_) {
+    Module::Line& last = lines_->back();
+    if (last.file == file && last.number == static_cast<int>(line_num) &&
+        last.address + last.size == address) {
+      last.size += length;
+      return;
+    }
+  }
+
   Module::Line line;
   line.address = address;
   // We set the size when we get the next line or the EndSequence call.
@@ -141,6 +158,7 @@ void DwarfLineToModule::AddLine(uint64_t address, uint64_t length,
   line.file = file;
   line.number = line_num;
   lines_->push_back(line);
+  extend_last_line_ = true;
 }
 
 } // namespace google_breakpad
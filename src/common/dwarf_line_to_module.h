@@ -128,7 +128,10 @@ class DwarfLineToModule: public LineInfoHandler {
         lines_(lines),
         files_(files),
         highest_file_number_(-1),
+        last_file_number_(0),
+        last_file_(NULL),
         omitted_line_end_(0),
+        extend_last_line_(false),
         warned_bad_file_number_(false),
         warned_bad_directory_number_(false) { }
 
@@ -175,11 +178,22 @@ class DwarfLineToModule: public LineInfoHandler {
   // none.  Used for dynamically defined file numbers.
   int32_t highest_file_number_;
 
+  // The file number of the last line added, and its entry in files_, or
+  // NULL if a file has been defined since.  Consecutive lines are nearly
+  // always in the same file, so this saves looking it up again.
+  uint32_t last_file_number_;
+  Module::File* last_file_;
+
   // This is the ending address of the last line we omitted, or zero if we
   // didn't omit the previous line. It is zero before we have received any
   // AddLine calls.
   uint64_t omitted_line_end_;
 
+  // True if the last entry in lines_ is one we added, and so may be
+  // extended to cover the next line, if that one continues it with the
+  // same file and line number.
+  bool extend_last_line_;
+
   // True if we've warned about:
   bool warned_bad_file_number_; // bad file numbers
   bool warned_bad_directory_number_; // bad directory numbers
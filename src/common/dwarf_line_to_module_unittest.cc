@@ -411,3 +411,50 @@ TEST(Omitted, Mix2) {
   EXPECT_EQ(67355743, lines[0].number);
   EXPECT_EQ(23365776, lines[1].number);
 }
+
+TEST(Coalesce, ContiguousSameLine) {
+  Module m("name", "os", "architecture", "id");
+  vector<Module::Line> lines;
+  std::map<uint32_t, Module::File*> cu_files;
+  DwarfLineToModule h(&m, "/", &lines, &cu_files);
+
+  h.DefineFile("filename1", 1, 0, 0, 0);
+  h.DefineFile("filename2", 2, 0, 0, 0);
+  h.AddLine(0x1000, 0x10, 1, 10, 1);
+  h.AddLine(0x1010, 0x08, 1, 10, 5);   // extends the line above
+  h.AddLine(0x1018, 0x04, 1, 10, 9);   // so does this
+  h.AddLine(0x1020, 0x04, 1, 10, 1);   // not contiguous
+  h.AddLine(0x1024, 0x04, 2, 10, 1);   // different file
+  h.AddLine(0x1028, 0x04, 2, 11, 1);   // different line
+
+  ASSERT_EQ(4U, lines.size());
+  EXPECT_EQ(0x1000U, lines[0].address);
+  EXPECT_EQ(0x1cU, lines[0].size);
+  EXPECT_EQ(10, lines[0].number);
+  EXPECT_EQ(0x1020U, lines[1].address);
+  EXPECT_EQ(0x4U, lines[1].size);
+  EXPECT_EQ(0x1024U, lines[2].address);
+  EXPECT_NE(lines[1].file, lines[2].file);
+  EXPECT_EQ(0x1028U, lines[3].address);
+  EXPECT_EQ(11, lines[3].number);
+}
+
+TEST(Coalesce, NotAcrossHandlers) {
+  Module m("name", "os", "architecture", "id");
+  vector<Module::Line> lines;
+  std::map<uint32_t, Module::File*> cu_files;
+  Module::Line existing;
+  existing.address = 0x1000;
+  existing.size = 0x10;
+  existing.file = m.FindFile("/filename1");
+  existing.number = 10;
+  lines.push_back(existing);
+
+  DwarfLineToModule h(&m, "/", &lines, &cu_files);
+  h.DefineFile("filename1", 1, 0, 0, 0);
+  h.AddLine(0x1010, 0x10, 1, 10, 0);
+
+  ASSERT_EQ(2U, lines.size());
+  EXPECT_EQ(0x10U, lines[0].size);
+  EXPECT_EQ(0x1010U, lines[1].address);
+}
@@ -39,6 +39,9 @@
 
 #include <stdlib.h>
 #include <array>
+#include <map>
+#include <mutex>
+#include <unordered_map>
 
 #if !defined(__ANDROID__)
 #include <cxxabi.h>
@@ -62,6 +65,63 @@ string MakeQualifiedNameWithSeparator(const string& parent_name,
   return parent_name + separator + name;
 }
 
+using google_breakpad::Language;
+
+// Demangled names, by demangler and mangled name, shared by every thread.
+// A null demangler stands for Language::DemangleSymbolCached.
+class DemangleCache {
+ public:
+  // Return the result of demangling MANGLED with DEMANGLER, setting
+  // *DEMANGLED as DEMANGLE does, and calling DEMANGLE only if the result
+  // isn't cached yet. The lock isn't held while demangling, so two threads
+  // may both demangle a name neither has seen; they get the same result.
+  template<typename Demangle>
+  Language::DemangleResult Lookup(const Language* demangler,
+                                  const string& mangled, string* demangled,
+                                  Demangle demangle) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ++lookups_;
+      Names& names = names_[demangler];
+      Names::const_iterator it = names.find(mangled);
+      if (it != names.end()) {
+        ++hits_;
+        demangled->assign(it->second.second);
+        return it->second.first;
+      }
+    }
+    Language::DemangleResult result = demangle(demangled);
+    // Names that aren't meant to be demangled are cheap to recognize again,
+    // and often plentiful, so don't spend memory on them.
+    if (result != Language::kDontDemangle) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      names_[demangler].emplace(mangled, std::make_pair(result, *demangled));
+    }
+    return result;
+  }
+
+  void GetStats(uint64_t* lookups, uint64_t* hits) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    *lookups = lookups_;
+    *hits = hits_;
+  }
+
+ private:
+  typedef std::unordered_map<string,
+                             std::pair<Language::DemangleResult, string>>
+      Names;
+
+  std::mutex mutex_;
+  std::map<const Language*, Names> names_;
+  uint64_t lookups_ = 0;
+  uint64_t hits_ = 0;
+};
+
+DemangleCache* GetDemangleCache() {
+  static DemangleCache* cache = new DemangleCache;
+  return cache;
+}
+
 }  // namespace
 
 namespace google_breakpad {
@@ -220,4 +280,34 @@ const Language * const Language::Swift = &SwiftLanguageSingleton;
 const Language * const Language::Rust = &RustLanguageSingleton;
 const Language * const Language::Assembler = &AssemblerLanguageSingleton;
 
+Language::DemangleResult Language::DemangleNameCached(
+    const string& mangled, string* demangled) const {
+  return GetDemangleCache()->Lookup(
+      this, mangled, demangled, [&](string* result) {
+        return DemangleName(mangled, result);
+      });
+}
+
+bool Language::DemangleSymbolCached(const char* mangled, string* demangled) {
+#if defined(__ANDROID__)
+  // Android NDK doesn't provide abi::__cxa_demangle.
+  return false;
+#else
+  DemangleResult result = GetDemangleCache()->Lookup(
+      NULL, mangled, demangled, [&](string* result) {
+        int status = 0;
+        char* demangled_c = abi::__cxa_demangle(mangled, NULL, NULL, &status);
+        if (demangled_c && status == 0)
+          result->assign(demangled_c);
+        free(demangled_c);
+        return status == 0 ? kDemangleSuccess : kDemangleFailure;
+      });
+  return result == kDemangleSuccess;
+#endif
+}
+
+void Language::GetDemangleCacheStats(uint64_t* lookups, uint64_t* hits) {
+  GetDemangleCache()->GetStats(lookups, hits);
+}
+
 } // namespace google_breakpad
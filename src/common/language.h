@@ -37,6 +37,8 @@
 #ifndef COMMON_LINUX_LANGUAGE_H__
 #define COMMON_LINUX_LANGUAGE_H__
 
+#include <stdint.h>
+
 #include <string>
 
 #include "common/using_std_string.h"
@@ -91,6 +93,22 @@ class Language {
     return kDontDemangle;
   }
 
+  // As DemangleName, but remember the result, so that a name this
+  // language has demangled before, for any compilation unit, is just
+  // looked up. Safe to call from several threads at once.
+  DemangleResult DemangleNameCached(const string& mangled,
+                                    string* demangled) const;
+
+  // Demangle MANGLED, a name from a symbol table, with abi::__cxa_demangle,
+  // caching the result as DemangleNameCached does. Return true and set
+  // *DEMANGLED on success, or return false if MANGLED doesn't demangle.
+  static bool DemangleSymbolCached(const char* mangled, string* demangled);
+
+  // Set *LOOKUPS to the number of names the two functions above have
+  // been asked to demangle, and *HITS to how many of those were found in
+  // the cache.
+  static void GetDemangleCacheStats(uint64_t* lookups, uint64_t* hits);
+
   // Instances for specific languages.
   static const Language * const CPlusPlus,
                         * const Java,
@@ -0,0 +1,505 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// crash_report_queue.cc: A spool directory of crash reports waiting to be
+// uploaded.
+//
+// See crash_report_queue.h for documentation.
+//
+// The index holds a line per report, with tab-separated fields:
+//   <id> <signature> <duplicates> <attempts> <next-attempt> <key>=<value>...
+// Characters with a meaning in that format are %-escaped. The sent file
+// holds a line per recently sent signature, as <signature> <sent-time>.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "common/linux/crash_report_queue.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace google_breakpad {
+
+namespace {
+
+const char kIndexName[] = "index";
+const char kIndexLockName[] = "index.lock";
+const char kSentName[] = "sent";
+const char kUploadLockName[] = "upload.lock";
+const char kMinidumpExtension[] = ".dmp";
+
+string Escape(const string& str) {
+  string escaped;
+  for (size_t i = 0; i < str.size(); ++i) {
+    char c = str[i];
+    if (c == '%' || c == '\t' || c == '\n' || c == '=') {
+      char hex[4];
+      snprintf(hex, sizeof(hex), "%%%02X", static_cast<unsigned char>(c));
+      escaped.append(hex);
+    } else {
+      escaped.push_back(c);
+    }
+  }
+  return escaped;
+}
+
+string Unescape(const string& str) {
+  string unescaped;
+  for (size_t i = 0; i < str.size(); ++i) {
+    if (str[i] == '%' && i + 2 < str.size()) {
+      unescaped.push_back(
+          static_cast<char>(strtol(str.substr(i + 1, 2).c_str(), NULL, 16)));
+      i += 2;
+    } else {
+      unescaped.push_back(str[i]);
+    }
+  }
+  return unescaped;
+}
+
+void Split(const string& str, char delimiter, std::vector<string>* fields) {
+  string::size_type start = 0, end;
+  while ((end = str.find(delimiter, start)) != string::npos) {
+    fields->push_back(str.substr(start, end - start));
+    start = end + 1;
+  }
+  fields->push_back(str.substr(start));
+}
+
+string FormatReport(const CrashReportQueue::Report& report) {
+  char counts[64];
+  snprintf(counts, sizeof(counts), "\t%d\t%d\t%lld", report.duplicates,
+           report.attempts, static_cast<long long>(report.next_attempt));
+  string line = Escape(report.id) + "\t" + Escape(report.signature) + counts;
+  std::map<string, string>::const_iterator iter;
+  for (iter = report.parameters.begin(); iter != report.parameters.end();
+       ++iter) {
+    line += "\t" + Escape(iter->first) + "=" + Escape(iter->second);
+  }
+  return line + "\n";
+}
+
+bool ParseReport(const string& line, CrashReportQueue::Report* report) {
+  std::vector<string> fields;
+  Split(line, '\t', &fields);
+  if (fields.size() < 5 || fields[0].empty())
+    return false;
+  report->id = Unescape(fields[0]);
+  report->signature = Unescape(fields[1]);
+  report->duplicates = atoi(fields[2].c_str());
+  report->attempts = atoi(fields[3].c_str());
+  report->next_attempt = static_cast<time_t>(atoll(fields[4].c_str()));
+  for (size_t i = 5; i < fields.size(); ++i) {
+    string::size_type equals = fields[i].find('=');
+    if (equals == string::npos)
+      continue;
+    report->parameters[Unescape(fields[i].substr(0, equals))] =
+        Unescape(fields[i].substr(equals + 1));
+  }
+  return true;
+}
+
+// Writes all of |data| to |fd|.
+bool WriteFully(int fd, const string& data) {
+  size_t done = 0;
+  while (done < data.size()) {
+    ssize_t written = write(fd, data.data() + done, data.size() - done);
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written <= 0)
+      return false;
+    done += written;
+  }
+  return true;
+}
+
+// Copies the file at |from| to |to|, for when they're on different file
+// systems and can't be renamed.
+bool CopyFile(const string& from, const string& to) {
+  int in = open(from.c_str(), O_RDONLY | O_CLOEXEC);
+  if (in < 0)
+    return false;
+  int out = open(to.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+  if (out < 0) {
+    close(in);
+    return false;
+  }
+  bool success = true;
+  char buffer[64 * 1024];
+  ssize_t count;
+  while ((count = read(in, buffer, sizeof(buffer))) != 0) {
+    if (count < 0 && errno == EINTR)
+      continue;
+    if (count < 0 || !WriteFully(out, string(buffer, count))) {
+      success = false;
+      break;
+    }
+  }
+  close(in);
+  if (close(out) != 0)
+    success = false;
+  if (!success)
+    unlink(to.c_str());
+  return success;
+}
+
+}  // namespace
+
+const int CrashReportQueue::kMaxAttempts;
+const int CrashReportQueue::kRetryDelaySeconds;
+const int CrashReportQueue::kMaxRetryDelaySeconds;
+
+CrashReportQueue::CrashReportQueue(const string& spool_directory)
+    : spool_directory_(spool_directory), recent_signature_window_(0) {
+  mkdir(spool_directory_.c_str(), 0700);
+}
+
+string CrashReportQueue::MinidumpPath(const string& id) const {
+  return spool_directory_ + "/" + id + kMinidumpExtension;
+}
+
+int CrashReportQueue::Lock(const char* name, bool wait) {
+  string path = spool_directory_ + "/" + name;
+  int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  if (fd < 0)
+    return -1;
+  int result;
+  do {
+    result = flock(fd, LOCK_EX | (wait ? 0 : LOCK_NB));
+  } while (result != 0 && errno == EINTR);
+  if (result != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+void CrashReportQueue::Unlock(int fd) {
+  // Closing the descriptor releases the lock.
+  close(fd);
+}
+
+bool CrashReportQueue::ReadIndex(std::vector<Report>* reports) {
+  reports->clear();
+  string path = spool_directory_ + "/" + kIndexName;
+  FILE* index = fopen(path.c_str(), "re");
+  if (!index)
+    return errno == ENOENT;
+
+  string line;
+  char buffer[4096];
+  while (fgets(buffer, sizeof(buffer), index)) {
+    line.append(buffer);
+    if (line.empty() || line[line.size() - 1] != '\n')
+      continue;
+    line.resize(line.size() - 1);
+    Report report;
+    // Skip lines that don't parse, which would only be left by a write cut
+    // short; they'd otherwise block the rest of the queue.
+    if (ParseReport(line, &report))
+      reports->push_back(report);
+    line.clear();
+  }
+  fclose(index);
+  return true;
+}
+
+bool CrashReportQueue::WriteIndex(const std::vector<Report>& reports) {
+  string path = spool_directory_ + "/" + kIndexName;
+  string temp_path = path + ".tmp";
+  int fd = open(temp_path.c_str(),
+                O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0)
+    return false;
+  string contents;
+  for (size_t i = 0; i < reports.size(); ++i)
+    contents.append(FormatReport(reports[i]));
+  bool success = WriteFully(fd, contents);
+  if (close(fd) != 0)
+    success = false;
+  // Replace the index in one step, so that readers never see part of it.
+  if (!success || rename(temp_path.c_str(), path.c_str()) != 0) {
+    unlink(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool CrashReportQueue::AppendToIndex(const Report& report) {
+  string path = spool_directory_ + "/" + kIndexName;
+  int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+  if (fd < 0)
+    return false;
+  bool success = WriteFully(fd, FormatReport(report));
+  if (close(fd) != 0)
+    success = false;
+  return success;
+}
+
+void CrashReportQueue::ReadSentSignatures(time_t now,
+                                          std::map<string, time_t>* sent) {
+  sent->clear();
+  string path = spool_directory_ + "/" + kSentName;
+  FILE* file = fopen(path.c_str(), "re");
+  if (!file)
+    return;
+  char buffer[4096];
+  while (fgets(buffer, sizeof(buffer), file)) {
+    string line(buffer);
+    if (line.empty() || line[line.size() - 1] != '\n')
+      continue;
+    line.resize(line.size() - 1);
+    std::vector<string> fields;
+    Split(line, '\t', &fields);
+    if (fields.size() < 2 || fields[0].empty())
+      continue;
+    time_t sent_time = static_cast<time_t>(atoll(fields[1].c_str()));
+    if (sent_time + recent_signature_window_ > now)
+      (*sent)[Unescape(fields[0])] = sent_time;
+  }
+  fclose(file);
+}
+
+bool CrashReportQueue::WriteSentSignatures(
+    const std::map<string, time_t>& sent) {
+  string path = spool_directory_ + "/" + kSentName;
+  string temp_path = path + ".tmp";
+  int fd = open(temp_path.c_str(),
+                O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  if (fd < 0)
+    return false;
+  string contents;
+  std::map<string, time_t>::const_iterator iter;
+  for (iter = sent.begin(); iter != sent.end(); ++iter) {
+    char sent_time[32];
+    snprintf(sent_time, sizeof(sent_time), "\t%lld\n",
+             static_cast<long long>(iter->second));
+    contents += Escape(iter->first) + sent_time;
+  }
+  bool success = WriteFully(fd, contents);
+  if (close(fd) != 0)
+    success = false;
+  if (!success || rename(temp_path.c_str(), path.c_str()) != 0) {
+    unlink(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool CrashReportQueue::Enqueue(const string& minidump_path,
+                               const string& signature,
+                               const std::map<string, string>& parameters,
+                               string* id) {
+  int lock = Lock(kIndexLockName, true);
+  if (lock < 0)
+    return false;
+
+  std::vector<Report> reports;
+  if (!ReadIndex(&reports)) {
+    Unlock(lock);
+    return false;
+  }
+
+  if (!signature.empty() && recent_signature_window_ > 0) {
+    std::map<string, time_t> sent;
+    ReadSentSignatures(time(NULL), &sent);
+    if (sent.count(signature)) {
+      Unlock(lock);
+      unlink(minidump_path.c_str());
+      if (id)
+        id->clear();
+      return true;
+    }
+  }
+
+  if (!signature.empty()) {
+    for (size_t i = 0; i < reports.size(); ++i) {
+      if (reports[i].signature != signature)
+        continue;
+      ++reports[i].duplicates;
+      bool success = WriteIndex(reports);
+      Unlock(lock);
+      if (success) {
+        unlink(minidump_path.c_str());
+        if (id)
+          *id = reports[i].id;
+      }
+      return success;
+    }
+  }
+
+  // Enqueuers all hold the index lock, so a free id stays free.
+  Report report;
+  report.signature = signature;
+  report.parameters = parameters;
+  unsigned int seed = static_cast<unsigned int>(time(NULL)) ^ getpid();
+  struct stat st;
+  do {
+    char name[64];
+    snprintf(name, sizeof(name), "%llx-%x",
+             static_cast<unsigned long long>(time(NULL)), rand_r(&seed));
+    report.id = name;
+  } while (stat(MinidumpPath(report.id).c_str(), &st) == 0);
+
+  string queued_path = MinidumpPath(report.id);
+  bool moved = rename(minidump_path.c_str(), queued_path.c_str()) == 0;
+  if (!moved && errno == EXDEV && CopyFile(minidump_path, queued_path)) {
+    unlink(minidump_path.c_str());
+    moved = true;
+  }
+  if (!moved) {
+    Unlock(lock);
+    return false;
+  }
+  if (!AppendToIndex(report)) {
+    // Put the minidump back, so that the caller can deal with it.
+    if (rename(queued_path.c_str(), minidump_path.c_str()) != 0 &&
+        CopyFile(queued_path, minidump_path)) {
+      unlink(queued_path.c_str());
+    }
+    Unlock(lock);
+    return false;
+  }
+  Unlock(lock);
+  if (id)
+    *id = report.id;
+  return true;
+}
+
+bool CrashReportQueue::GetReports(std::vector<Report>* reports) {
+  int lock = Lock(kIndexLockName, true);
+  if (lock < 0)
+    return false;
+  bool success = ReadIndex(reports);
+  Unlock(lock);
+  return success;
+}
+
+int CrashReportQueue::ProcessQueue(const Uploader& uploader,
+                                   int max_concurrent,
+                                   size_t max_reports,
+                                   time_t now) {
+  // The index lock isn't held while sending, so that dump writers can
+  // enqueue in the meantime; this lock keeps other uploaders out instead.
+  int upload_lock = Lock(kUploadLockName, false);
+  if (upload_lock < 0)
+    return 0;
+
+  std::vector<Report> due;
+  std::vector<Report> reports;
+  if (!GetReports(&reports)) {
+    Unlock(upload_lock);
+    return 0;
+  }
+  for (size_t i = 0; i < reports.size() && due.size() < max_reports; ++i) {
+    if (reports[i].next_attempt <= now)
+      due.push_back(reports[i]);
+  }
+
+  std::vector<UploadResult> results(due.size(), UPLOAD_RETRY);
+  std::atomic<size_t> next(0);
+  auto send = [&]() {
+    for (size_t i = next++; i < due.size(); i = next++)
+      results[i] = uploader(due[i], MinidumpPath(due[i].id));
+  };
+  size_t thread_count =
+      std::min(due.size(), static_cast<size_t>(std::max(1, max_concurrent)));
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < thread_count; ++i)
+    threads.push_back(std::thread(send));
+  send();
+  for (size_t i = 0; i < threads.size(); ++i)
+    threads[i].join();
+
+  // Reports may have been enqueued, or duplicates counted, since the index
+  // was read, so apply the results to it afresh.
+  int sent = 0;
+  int lock = Lock(kIndexLockName, true);
+  if (lock >= 0 && ReadIndex(&reports)) {
+    std::map<string, size_t> result_for_id;
+    for (size_t i = 0; i < due.size(); ++i)
+      result_for_id[due[i].id] = i;
+
+    std::map<string, time_t> sent_signatures;
+    if (recent_signature_window_ > 0)
+      ReadSentSignatures(now, &sent_signatures);
+    bool signatures_changed = false;
+
+    std::vector<Report> remaining;
+    for (size_t i = 0; i < reports.size(); ++i) {
+      Report& report = reports[i];
+      std::map<string, size_t>::const_iterator result =
+          result_for_id.find(report.id);
+      if (result == result_for_id.end()) {
+        remaining.push_back(report);
+        continue;
+      }
+      if (results[result->second] == UPLOAD_RETRY &&
+          ++report.attempts < kMaxAttempts) {
+        int delay = kRetryDelaySeconds;
+        for (int attempt = 1;
+             attempt < report.attempts && delay < kMaxRetryDelaySeconds;
+             ++attempt) {
+          delay *= 2;
+        }
+        report.next_attempt = now + std::min(delay, kMaxRetryDelaySeconds);
+        remaining.push_back(report);
+        continue;
+      }
+      if (results[result->second] == UPLOAD_SENT) {
+        ++sent;
+        if (recent_signature_window_ > 0 && !report.signature.empty()) {
+          sent_signatures[report.signature] = now;
+          signatures_changed = true;
+        }
+      }
+      unlink(MinidumpPath(report.id).c_str());
+    }
+    WriteIndex(remaining);
+    if (signatures_changed)
+      WriteSentSignatures(sent_signatures);
+  }
+  if (lock >= 0)
+    Unlock(lock);
+  Unlock(upload_lock);
+  return sent;
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,156 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// crash_report_queue.h: A spool directory of crash reports waiting to be
+// uploaded.
+//
+// Whatever writes a minidump only enqueues it: the minidump is moved into
+// the spool directory and a line describing it is appended to the
+// directory's index file. An uploader, possibly in another process, later
+// drains the queue, sending reports a few at a time and backing off from
+// those that fail. Reports are never rediscovered by scanning the
+// directory; the index is the queue.
+
+#ifndef COMMON_LINUX_CRASH_REPORT_QUEUE_H_
+#define COMMON_LINUX_CRASH_REPORT_QUEUE_H_
+
+#include <time.h>
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/using_std_string.h"
+
+namespace google_breakpad {
+
+class CrashReportQueue {
+ public:
+  // A queued report.
+  struct Report {
+    Report() : duplicates(0), attempts(0), next_attempt(0) {}
+
+    // Unique within the queue; also the base name of the minidump.
+    string id;
+    // Reports with the same non-empty signature, say a hash of the
+    // crashing stack, are only sent once while one is queued; the others
+    // are counted in |duplicates|.
+    string signature;
+    // The form fields to send the minidump with.
+    std::map<string, string> parameters;
+    int duplicates;
+    // The number of failed attempts to send the report, and the time at
+    // which it's next due to be sent.
+    int attempts;
+    time_t next_attempt;
+  };
+
+  // What became of an attempt to send a report.
+  enum UploadResult {
+    UPLOAD_SENT,    // Remove the report from the queue.
+    UPLOAD_RETRY,   // Try it again later.
+    UPLOAD_REJECT,  // The server will never accept it; remove it.
+  };
+
+  // Sends |report|, whose minidump is at |minidump_path|. May be called on
+  // several threads at once.
+  typedef std::function<UploadResult(const Report& report,
+                                     const string& minidump_path)> Uploader;
+
+  // Reports that fail this many times are dropped.
+  static const int kMaxAttempts = 8;
+
+  // The delay before retrying a report after its first failure, doubled
+  // for each failure after that up to kMaxRetryDelaySeconds.
+  static const int kRetryDelaySeconds = 60;
+  static const int kMaxRetryDelaySeconds = 24 * 60 * 60;
+
+  // |spool_directory| is created if it doesn't exist.
+  explicit CrashReportQueue(const string& spool_directory);
+
+  // Once a report with a non-empty signature has been sent, drop further
+  // reports with that signature for |seconds| afterwards, rather than
+  // sending the same crash again as soon as it recurs. Off (0) by default.
+  void set_recent_signature_window(int seconds) {
+    recent_signature_window_ = seconds;
+  }
+
+  // Moves the minidump at |minidump_path| into the queue, to be sent with
+  // |parameters|. If a report with the same non-empty |signature| is
+  // already queued, the minidump is deleted and that report's duplicate
+  // count is incremented instead. Sets |id|, if not NULL, to the id of the
+  // report the minidump was recorded as. If a report with |signature| was
+  // sent within the recent signature window, the minidump is deleted and
+  // |id| is set to the empty string. Returns false if the minidump couldn't
+  // be queued, in which case it's left where it was.
+  bool Enqueue(const string& minidump_path,
+               const string& signature,
+               const std::map<string, string>& parameters,
+               string* id);
+
+  // Sets |reports| to the queued reports, oldest first.
+  bool GetReports(std::vector<Report>* reports);
+
+  // Sends up to |max_reports| of the reports that are due at |now|, using
+  // up to |max_concurrent| threads, and updates the queue with the results.
+  // Only one process drains a queue at a time; if another is, returns
+  // immediately. Returns the number of reports sent.
+  int ProcessQueue(const Uploader& uploader,
+                   int max_concurrent,
+                   size_t max_reports,
+                   time_t now);
+
+  // The path of the minidump of the report with id |id|.
+  string MinidumpPath(const string& id) const;
+
+ private:
+  // Takes an exclusive lock on the lock file |name| in the spool directory,
+  // returning its descriptor, or -1 on failure or if |wait| is false and
+  // another process holds it.
+  int Lock(const char* name, bool wait);
+  void Unlock(int fd);
+
+  // Read and replace the index. The index lock must be held.
+  bool ReadIndex(std::vector<Report>* reports);
+  bool WriteIndex(const std::vector<Report>& reports);
+  bool AppendToIndex(const Report& report);
+
+  // Read and replace the times at which signatures were last sent, leaving
+  // out those older than the recent signature window. The index lock must
+  // be held.
+  void ReadSentSignatures(time_t now, std::map<string, time_t>* sent);
+  bool WriteSentSignatures(const std::map<string, time_t>& sent);
+
+  string spool_directory_;
+  int recent_signature_window_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // COMMON_LINUX_CRASH_REPORT_QUEUE_H_
@@ -0,0 +1,231 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <unistd.h>
+
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "breakpad_googletest_includes.h"
+#include "common/linux/crash_report_queue.h"
+#include "common/tests/auto_tempdir.h"
+#include "common/tests/file_utils.h"
+
+namespace {
+
+using google_breakpad::AutoTempDir;
+using google_breakpad::CrashReportQueue;
+using google_breakpad::WriteFile;
+using std::map;
+using std::string;
+using std::vector;
+
+const time_t kNow = 1000000;
+
+class CrashReportQueueTest : public ::testing::Test {
+ protected:
+  CrashReportQueueTest() : queue_(temp_dir_.path() + "/spool") {}
+
+  // Writes a minidump outside of the queue.
+  string NewMinidump(const string& contents) {
+    string path = temp_dir_.path() + "/" + std::to_string(next_dump_++);
+    EXPECT_TRUE(WriteFile(path.c_str(), contents.data(), contents.size()));
+    return path;
+  }
+
+  AutoTempDir temp_dir_;
+  CrashReportQueue queue_;
+  int next_dump_ = 0;
+};
+
+TEST_F(CrashReportQueueTest, EnqueueMovesMinidumpIntoQueue) {
+  string path = NewMinidump("dump");
+  map<string, string> parameters;
+  parameters["prod"] = "app";
+  parameters["odd\tkey="] = "value\nwith %escapes";
+  string id;
+  ASSERT_TRUE(queue_.Enqueue(path, "sig", parameters, &id));
+
+  EXPECT_NE(0, access(path.c_str(), F_OK));
+  EXPECT_EQ(0, access(queue_.MinidumpPath(id).c_str(), F_OK));
+
+  vector<CrashReportQueue::Report> reports;
+  ASSERT_TRUE(queue_.GetReports(&reports));
+  ASSERT_EQ(1U, reports.size());
+  EXPECT_EQ(id, reports[0].id);
+  EXPECT_EQ("sig", reports[0].signature);
+  EXPECT_EQ(parameters, reports[0].parameters);
+  EXPECT_EQ(0, reports[0].attempts);
+}
+
+TEST_F(CrashReportQueueTest, DuplicateSignaturesAreCounted) {
+  string first, second, third;
+  ASSERT_TRUE(queue_.Enqueue(NewMinidump("a"), "sig", {}, &first));
+  string duplicate = NewMinidump("b");
+  ASSERT_TRUE(queue_.Enqueue(duplicate, "sig", {}, &second));
+  ASSERT_TRUE(queue_.Enqueue(NewMinidump("c"), "", {}, &third));
+
+  EXPECT_EQ(first, second);
+  EXPECT_NE(first, third);
+  EXPECT_NE(0, access(duplicate.c_str(), F_OK));
+
+  vector<CrashReportQueue::Report> reports;
+  ASSERT_TRUE(queue_.GetReports(&reports));
+  ASSERT_EQ(2U, reports.size());
+  EXPECT_EQ(1, reports[0].duplicates);
+  EXPECT_EQ(0, reports[1].duplicates);
+}
+
+TEST_F(CrashReportQueueTest, SentReportsAreRemoved) {
+  for (int i = 0; i < 5; ++i)
+    ASSERT_TRUE(queue_.Enqueue(NewMinidump("dump"), "", {}, nullptr));
+
+  std::mutex lock;
+  std::set<string> sent_paths;
+  int sent = queue_.ProcessQueue(
+      [&](const CrashReportQueue::Report&, const string& minidump_path) {
+        std::lock_guard<std::mutex> guard(lock);
+        EXPECT_EQ(0, access(minidump_path.c_str(), F_OK));
+        sent_paths.insert(minidump_path);
+        return CrashReportQueue::UPLOAD_SENT;
+      },
+      3, 100, kNow);
+  EXPECT_EQ(5, sent);
+  EXPECT_EQ(5U, sent_paths.size());
+
+  vector<CrashReportQueue::Report> reports;
+  ASSERT_TRUE(queue_.GetReports(&reports));
+  EXPECT_TRUE(reports.empty());
+  for (const string& path : sent_paths)
+    EXPECT_NE(0, access(path.c_str(), F_OK));
+}
+
+TEST_F(CrashReportQueueTest, RecentlySentSignaturesAreDropped) {
+  queue_.set_recent_signature_window(3600);
+  auto send = [](const CrashReportQueue::Report&, const string&) {
+    return CrashReportQueue::UPLOAD_SENT;
+  };
+
+  // A signature sent longer ago than the window is sent again.
+  string id;
+  ASSERT_TRUE(queue_.Enqueue(NewMinidump("a"), "sig", {}, &id));
+  EXPECT_EQ(1, queue_.ProcessQueue(send, 1, 100, time(NULL) - 3600));
+  ASSERT_TRUE(queue_.Enqueue(NewMinidump("b"), "sig", {}, &id));
+  EXPECT_NE("", id);
+  EXPECT_EQ(1, queue_.ProcessQueue(send, 1, 100, time(NULL)));
+
+  string dropped = NewMinidump("c");
+  ASSERT_TRUE(queue_.Enqueue(dropped, "sig", {}, &id));
+  EXPECT_EQ("", id);
+  EXPECT_NE(0, access(dropped.c_str(), F_OK));
+  ASSERT_TRUE(queue_.Enqueue(NewMinidump("d"), "other", {}, &id));
+  EXPECT_NE("", id);
+
+  vector<CrashReportQueue::Report> reports;
+  ASSERT_TRUE(queue_.GetReports(&reports));
+  ASSERT_EQ(1U, reports.size());
+  EXPECT_EQ("other", reports[0].signature);
+}
+
+TEST_F(CrashReportQueueTest, FailedReportsBackOff) {
+  string id;
+  ASSERT_TRUE(queue_.Enqueue(NewMinidump("dump"), "", {}, &id));
+  auto fail = [](const CrashReportQueue::Report&, const string&) {
+    return CrashReportQueue::UPLOAD_RETRY;
+  };
+
+  EXPECT_EQ(0, queue_.ProcessQueue(fail, 1, 100, kNow));
+  vector<CrashReportQueue::Report> reports;
+  ASSERT_TRUE(queue_.GetReports(&reports));
+  ASSERT_EQ(1U, reports.size());
+  EXPECT_EQ(1, reports[0].attempts);
+  EXPECT_EQ(kNow + CrashReportQueue::kRetryDelaySeconds,
+            reports[0].next_attempt);
+
+  // It's not due yet, so isn't tried.
+  int calls = 0;
+  queue_.ProcessQueue(
+      [&](const CrashReportQueue::Report&, const string&) {
+        ++calls;
+        return CrashReportQueue::UPLOAD_SENT;
+      },
+      1, 100, kNow + 1);
+  EXPECT_EQ(0, calls);
+
+  // The delay doubles with each failure.
+  time_t now = reports[0].next_attempt;
+  EXPECT_EQ(0, queue_.ProcessQueue(fail, 1, 100, now));
+  ASSERT_TRUE(queue_.GetReports(&reports));
+  ASSERT_EQ(1U, reports.size());
+  EXPECT_EQ(now + 2 * CrashReportQueue::kRetryDelaySeconds,
+            reports[0].next_attempt);
+
+  // After enough failures it's dropped.
+  for (int i = 2; i < CrashReportQueue::kMaxAttempts; ++i) {
+    now = reports[0].next_attempt;
+    queue_.ProcessQueue(fail, 1, 100, now);
+    ASSERT_TRUE(queue_.GetReports(&reports));
+  }
+  EXPECT_TRUE(reports.empty());
+  EXPECT_NE(0, access(queue_.MinidumpPath(id).c_str(), F_OK));
+}
+
+TEST_F(CrashReportQueueTest, ReportsEnqueuedWhileSendingAreKept) {
+  ASSERT_TRUE(queue_.Enqueue(NewMinidump("first"), "", {}, nullptr));
+  string late = NewMinidump("late");
+  int sent = queue_.ProcessQueue(
+      [&](const CrashReportQueue::Report&, const string&) {
+        EXPECT_TRUE(queue_.Enqueue(late, "", {}, nullptr));
+        return CrashReportQueue::UPLOAD_SENT;
+      },
+      1, 100, kNow);
+  EXPECT_EQ(1, sent);
+
+  vector<CrashReportQueue::Report> reports;
+  ASSERT_TRUE(queue_.GetReports(&reports));
+  EXPECT_EQ(1U, reports.size());
+}
+
+TEST_F(CrashReportQueueTest, MaxReportsLimitsABatch) {
+  for (int i = 0; i < 4; ++i)
+    ASSERT_TRUE(queue_.Enqueue(NewMinidump("dump"), "", {}, nullptr));
+  auto send = [](const CrashReportQueue::Report&, const string&) {
+    return CrashReportQueue::UPLOAD_SENT;
+  };
+  EXPECT_EQ(3, queue_.ProcessQueue(send, 2, 3, kNow));
+  EXPECT_EQ(1, queue_.ProcessQueue(send, 2, 3, kNow));
+}
+
+}  // namespace
@@ -32,42 +32,51 @@
 
 #include "common/linux/crc32.h"
 
-namespace google_breakpad {
-
-// This implementation is based on the sample implementation in RFC 1952.
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#include <string.h>
+#else
+#include <zlib.h>
 
-// CRC32 polynomial, in reversed form.
-// See RFC 1952, or http://en.wikipedia.org/wiki/Cyclic_redundancy_check
-static const uint32_t kCrc32Polynomial = 0xEDB88320;
-static uint32_t kCrc32Table[256] = { 0 };
+#include <limits>
+#endif
 
-#define arraysize(f) (sizeof(f) / sizeof(*f))
+namespace google_breakpad {
 
-static void EnsureCrc32TableInited() {
-  if (kCrc32Table[arraysize(kCrc32Table) - 1])
-    return;  // already inited
-  for (uint32_t i = 0; i < arraysize(kCrc32Table); ++i) {
-    uint32_t c = i;
-    for (size_t j = 0; j < 8; ++j) {
-      if (c & 1) {
-        c = kCrc32Polynomial ^ (c >> 1);
-      } else {
-        c >>= 1;
-      }
-    }
-    kCrc32Table[i] = c;
-  }
-}
+// This is the CRC-32 of RFC 1952 (polynomial 0xEDB88320 in reversed form),
+// the checksum .gnu_debuglink records. Debug files are often hundreds of
+// megabytes, so a byte-at-a-time table walk is too slow: AArch64 CPUs with
+// the CRC extension compute exactly this polynomial in hardware, and
+// elsewhere zlib's crc32() is used, which is word-sliced and, in the zlib
+// builds that support it, uses carry-less multiply. (x86's SSE4.2 crc32
+// instruction computes CRC-32C, a different polynomial, so it cannot be
+// used here.)
 
 uint32_t UpdateCrc32(uint32_t start, const void* buf, size_t len) {
-  EnsureCrc32TableInited();
-
-  uint32_t c = start ^ 0xFFFFFFFF;
   const uint8_t* u = static_cast<const uint8_t*>(buf);
-  for (size_t i = 0; i < len; ++i) {
-    c = kCrc32Table[(c ^ u[i]) & 0xFF] ^ (c >> 8);
+#if defined(__ARM_FEATURE_CRC32)
+  uint32_t c = start ^ 0xFFFFFFFF;
+  for (; len >= sizeof(uint64_t); len -= sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, u, sizeof(word));
+    c = __crc32d(c, word);
+    u += sizeof(word);
   }
+  for (; len > 0; --len)
+    c = __crc32b(c, *u++);
   return c ^ 0xFFFFFFFF;
+#else
+  // zlib's length parameter is a uInt; feed large buffers in pieces.
+  const size_t kMaxChunk = std::numeric_limits<uInt>::max();
+  uLong c = start;
+  while (len > 0) {
+    uInt chunk = static_cast<uInt>(len < kMaxChunk ? len : kMaxChunk);
+    c = crc32(c, u, chunk);
+    u += chunk;
+    len -= chunk;
+  }
+  return static_cast<uint32_t>(c);
+#endif
 }
 
 }  // namespace google_breakpad
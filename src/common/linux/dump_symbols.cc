@@ -55,17 +55,22 @@
 #include <zstd.h>
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <memory>
 #include <set>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "common/dwarf/bytereader-inl.h"
 #include "common/dwarf/dwarf2diehandler.h"
 #include "common/dwarf_cfi_to_module.h"
+#include "common/dwarf_cu_loader.h"
 #include "common/dwarf_cu_to_module.h"
-#include "common/dwarf_line_to_module.h"
-#include "common/dwarf_range_list_handler.h"
 #include "common/linux/crc32.h"
 #include "common/linux/eintr_wrapper.h"
 #include "common/linux/elfutils.h"
@@ -86,24 +91,28 @@
 namespace {
 
 using google_breakpad::DumpOptions;
+using google_breakpad::DumperLineToModule;
+using google_breakpad::DumperRangesHandler;
 using google_breakpad::DwarfCFIToModule;
 using google_breakpad::DwarfCUToModule;
-using google_breakpad::DwarfLineToModule;
-using google_breakpad::DwarfRangeListHandler;
 using google_breakpad::ElfClass;
 using google_breakpad::ElfClass32;
 using google_breakpad::ElfClass64;
 using google_breakpad::elf::FileID;
-using google_breakpad::FindElfSectionByName;
+using google_breakpad::FindUnitsCoveringAddresses;
 using google_breakpad::GetOffset;
+using google_breakpad::IsDwarfUnitSection;
 using google_breakpad::IsValidElf;
 using google_breakpad::elf::kDefaultBuildIdSize;
+using google_breakpad::LoadDwarfConcurrently;
 using google_breakpad::Module;
 using google_breakpad::PageAllocator;
 #ifndef NO_STABS_SUPPORT
 using google_breakpad::StabsToModule;
 #endif
 using google_breakpad::scoped_ptr;
+using google_breakpad::SharedDwpReader;
+using google_breakpad::StartProcessSplitDwarf;
 using google_breakpad::wasteful_vector;
 
 // Define AARCH64 ELF architecture if host machine does not include this define.
@@ -173,6 +182,17 @@ class MmapWrapper {
   size_t size_;
 };
 
+// Return ADDRESSES, relative to LOADING_ADDR, as sorted absolute addresses.
+vector<uint64_t> AbsoluteAddresses(const vector<uint64_t>& addresses,
+                                   uint64_t loading_addr) {
+  vector<uint64_t> absolute;
+  absolute.reserve(addresses.size());
+  for (uint64_t address : addresses)
+    absolute.push_back(loading_addr + address);
+  std::sort(absolute.begin(), absolute.end());
+  return absolute;
+}
+
 // Find the preferred loading address of the binary.
 template<typename ElfClass>
 typename ElfClass::Addr GetLoadingAddress(
@@ -238,61 +258,6 @@ bool LoadStabs(const typename ElfClass::Ehdr* elf_header,
 }
 #endif  // NO_STABS_SUPPORT
 
-// A range handler that accepts rangelist data parsed by
-// google_breakpad::RangeListReader and populates a range vector (typically
-// owned by a function) with the results.
-class DumperRangesHandler : public DwarfCUToModule::RangesHandler {
- public:
-  DumperRangesHandler(google_breakpad::ByteReader* reader) :
-      reader_(reader) { }
-
-  bool ReadRanges(
-      enum google_breakpad::DwarfForm form, uint64_t data,
-      google_breakpad::RangeListReader::CURangesInfo* cu_info,
-      vector<Module::Range>* ranges) {
-    DwarfRangeListHandler handler(ranges);
-    google_breakpad::RangeListReader range_list_reader(reader_, cu_info,
-                                                    &handler);
-    return range_list_reader.ReadRanges(form, data);
-  }
-
- private:
-  google_breakpad::ByteReader* reader_;
-};
-
-// A line-to-module loader that accepts line number info parsed by
-// google_breakpad::LineInfo and populates a Module and a line vector
-// with the results.
-class DumperLineToModule: public DwarfCUToModule::LineToModuleHandler {
- public:
-  // Create a line-to-module converter using BYTE_READER.
-  explicit DumperLineToModule(google_breakpad::ByteReader* byte_reader)
-      : byte_reader_(byte_reader) { }
-  void StartCompilationUnit(const string& compilation_dir) {
-    compilation_dir_ = compilation_dir;
-  }
-  void ReadProgram(const uint8_t* program,
-                   uint64_t length,
-                   const uint8_t* string_section,
-                   uint64_t string_section_length,
-                   const uint8_t* line_string_section,
-                   uint64_t line_string_section_length,
-                   Module* module,
-                   std::vector<Module::Line>* lines,
-                   std::map<uint32_t, Module::File*>* files) {
-    DwarfLineToModule handler(module, compilation_dir_, lines, files);
-    google_breakpad::LineInfo parser(program, length, byte_reader_,
-                                  string_section, string_section_length,
-                                  line_string_section,
-                                  line_string_section_length,
-                                  &handler);
-    parser.Start();
-  }
- private:
-  string compilation_dir_;
-  google_breakpad::ByteReader* byte_reader_;
-};
-
 template<typename ElfClass>
 bool IsCompressedHeader(const typename ElfClass::Shdr* section) {
   return (section->sh_flags & SHF_COMPRESSED) != 0;
@@ -359,57 +324,85 @@ std::pair<uint8_t *, uint64_t> UncompressSectionContents(
   return std::make_pair(nullptr, 0);
 }
 
-void StartProcessSplitDwarf(google_breakpad::CompilationUnit* reader,
-                            Module* module,
-                            google_breakpad::Endianness endianness,
-                            bool handle_inter_cu_refs,
-                            bool handle_inline) {
-  std::string split_file;
-  google_breakpad::SectionMap split_sections;
-  google_breakpad::ByteReader split_byte_reader(endianness);
-  uint64_t cu_offset = 0;
-  if (!reader->ProcessSplitDwarf(split_file, split_sections, split_byte_reader,
-                                 cu_offset))
+// Tell the kernel that the SIZE bytes of compressed section contents at
+// CONTENTS won't be read again, so that the pages wholly within them can
+// be dropped from memory while the rest of the file is processed.  The
+// contents are normally mapped from the file, and are read back from it
+// should anything look at them after all.
+void ReleaseCompressedContents(const uint8_t* contents, uint64_t size) {
+#ifdef MADV_PAGEOUT
+  const uintptr_t page_size = getpagesize();
+  uintptr_t start = reinterpret_cast<uintptr_t>(contents);
+  uintptr_t end = start + size;
+  start = (start + page_size - 1) & ~(page_size - 1);
+  end &= ~(page_size - 1);
+  if (start < end)
+    madvise(reinterpret_cast<void*>(start), end - start, MADV_PAGEOUT);
+#endif
+}
+
+// Tell the kernel that the SIZE bytes of section contents at CONTENTS will
+// be read through from start to end, so that it reads ahead of the reader
+// and can drop the pages soon after they have been used, rather than
+// letting a large debug file crowd everything else out of the page cache.
+void AdviseSequentialRead(const uint8_t* contents, uint64_t size) {
+#ifdef MADV_SEQUENTIAL
+  if (size == 0)
+    return;
+  const uintptr_t page_size = getpagesize();
+  uintptr_t start = reinterpret_cast<uintptr_t>(contents);
+  uintptr_t end = start + size;
+  start &= ~(page_size - 1);
+  end = (end + page_size - 1) & ~(page_size - 1);
+  madvise(reinterpret_cast<void*>(start), end - start, MADV_SEQUENTIAL);
+#endif
+}
+
+// A SHF_COMPRESSED section, and its contents once decompressed.
+struct CompressedSection {
+  string name;
+  uint64_t compression_type;
+  const uint8_t* contents;
+  uint64_t size;
+  uint64_t uncompressed_size;
+  std::pair<uint8_t*, uint64_t> uncompressed;
+};
+
+// Decompress SECTIONS on up to NUM_THREADS threads, releasing the
+// compressed contents of each as soon as it is done.  The largest
+// sections, usually .debug_info and .debug_str, are started first, so
+// that no thread is left decompressing one of them alone at the end.
+void UncompressSections(vector<CompressedSection>* sections,
+                        int num_threads) {
+  vector<CompressedSection*> queue;
+  for (CompressedSection& section : *sections)
+    queue.push_back(&section);
+  std::stable_sort(queue.begin(), queue.end(),
+                   [](const CompressedSection* a, const CompressedSection* b) {
+                     return a->uncompressed_size > b->uncompressed_size;
+                   });
+  std::atomic<size_t> next_section(0);
+  auto uncompress_sections = [&]() {
+    for (size_t i = next_section++; i < queue.size(); i = next_section++) {
+      CompressedSection* section = queue[i];
+      AdviseSequentialRead(section->contents, section->size);
+      section->uncompressed = UncompressSectionContents(
+          section->compression_type, section->contents, section->size,
+          section->uncompressed_size);
+      ReleaseCompressedContents(section->contents, section->size);
+    }
+  };
+  size_t thread_count =
+      std::min(static_cast<size_t>(std::max(num_threads, 1)), queue.size());
+  if (thread_count <= 1) {
+    uncompress_sections();
     return;
-  DwarfCUToModule::FileContext file_context(split_file, module,
-                                            handle_inter_cu_refs);
-  for (auto section : split_sections)
-    file_context.AddSectionToSectionMap(section.first, section.second.first,
-                                        section.second.second);
-  // Because DWP/DWO file doesn't have .debug_addr/.debug_line/.debug_line_str,
-  // its debug info will refer to .debug_addr/.debug_line in the main binary.
-  if (file_context.section_map().find(".debug_addr") ==
-      file_context.section_map().end())
-    file_context.AddSectionToSectionMap(".debug_addr", reader->GetAddrBuffer(),
-                                        reader->GetAddrBufferLen());
-  if (file_context.section_map().find(".debug_line") ==
-      file_context.section_map().end())
-    file_context.AddSectionToSectionMap(".debug_line", reader->GetLineBuffer(),
-                                        reader->GetLineBufferLen());
-  if (file_context.section_map().find(".debug_line_str") ==
-      file_context.section_map().end())
-    file_context.AddSectionToSectionMap(".debug_line_str",
-                                        reader->GetLineStrBuffer(),
-                                        reader->GetLineStrBufferLen());
-
-  DumperRangesHandler ranges_handler(&split_byte_reader);
-  DumperLineToModule line_to_module(&split_byte_reader);
-  DwarfCUToModule::WarningReporter reporter(split_file, cu_offset);
-  DwarfCUToModule root_handler(
-      &file_context, &line_to_module, &ranges_handler, &reporter, handle_inline,
-      reader->GetLowPC(), reader->GetAddrBase(), reader->HasSourceLineInfo(),
-      reader->GetSourceLineOffset());
-  google_breakpad::DIEDispatcher die_dispatcher(&root_handler);
-  google_breakpad::CompilationUnit split_reader(
-      split_file, file_context.section_map(), cu_offset, &split_byte_reader,
-      &die_dispatcher);
-  split_reader.SetSplitDwarf(reader->GetAddrBase(), reader->GetDWOID());
-  split_reader.Start();
-  // Normally, it won't happen unless we have transitive reference.
-  if (split_reader.ShouldProcessSplitDwarf()) {
-    StartProcessSplitDwarf(&split_reader, module, endianness,
-                           handle_inter_cu_refs, handle_inline);
   }
+  vector<std::thread> threads;
+  for (size_t i = 0; i < thread_count; ++i)
+    threads.emplace_back(uncompress_sections);
+  for (std::thread& thread : threads)
+    thread.join();
 }
 
 template<typename ElfClass>
@@ -418,6 +411,9 @@ bool LoadDwarf(const string& dwarf_filename,
                const bool big_endian,
                bool handle_inter_cu_refs,
                bool handle_inline,
+               int num_threads,
+               const string& cache_dir,
+               const vector<uint64_t>& addresses,
                Module* module) {
   typedef typename ElfClass::Shdr Shdr;
 
@@ -430,11 +426,13 @@ bool LoadDwarf(const string& dwarf_filename,
                                             module,
                                             handle_inter_cu_refs);
 
-  // Build a map of the ELF file's sections.
+  // Build a map of the ELF file's sections, decompressing those the DWARF
+  // readers need together once the others are in.
   const Shdr* sections =
       GetOffset<ElfClass, Shdr>(elf_header, elf_header->e_shoff);
   int num_sections = elf_header->e_shnum;
   const Shdr* section_names = sections + elf_header->e_shstrndx;
+  vector<CompressedSection> compressed_sections;
   for (int i = 0; i < num_sections; i++) {
     const Shdr* section = &sections[i];
     string name = GetOffset<ElfClass, char>(elf_header,
@@ -445,9 +443,15 @@ bool LoadDwarf(const string& dwarf_filename,
     uint64_t size = section->sh_size;
 
     if (!IsCompressedHeader<ElfClass>(section)) {
+      if (name == ".debug_info" || name == ".debug_line")
+        AdviseSequentialRead(contents, size);
       file_context.AddSectionToSectionMap(name, contents, size);
       continue;
     }
+    // .debug_aranges is only read to pick the units covering ADDRESSES.
+    if (!IsDwarfUnitSection(name) &&
+        (addresses.empty() || name != ".debug_aranges"))
+      continue;
 
     typename ElfClass::Chdr chdr;
 
@@ -461,18 +465,35 @@ bool LoadDwarf(const string& dwarf_filename,
     contents += compression_header_size;
     size -= compression_header_size;
 
-    std::pair<uint8_t *, uint64_t> uncompressed =
-      UncompressSectionContents(chdr.ch_type, contents, size, chdr.ch_size);
+    compressed_sections.push_back(CompressedSection{
+        name, chdr.ch_type, contents, size, chdr.ch_size,
+        std::make_pair(nullptr, 0)});
+  }
 
-    if (uncompressed.first != nullptr && uncompressed.second != 0) {
-      file_context.AddManagedSectionToSectionMap(name, uncompressed.first, uncompressed.second);
+  UncompressSections(&compressed_sections, num_threads);
+  for (const CompressedSection& section : compressed_sections) {
+    if (section.uncompressed.first != nullptr &&
+        section.uncompressed.second != 0) {
+      file_context.AddManagedSectionToSectionMap(section.name,
+                                                 section.uncompressed.first,
+                                                 section.uncompressed.second);
     }
   }
 
+  SharedDwpReader dwp_reader(dwarf_filename, endianness);
+  if (addresses.empty() && (num_threads > 1 || !cache_dir.empty()) &&
+      LoadDwarfConcurrently(dwarf_filename, file_context.section_map(),
+                            endianness, handle_inter_cu_refs, handle_inline,
+                            true, num_threads, cache_dir, &dwp_reader,
+                            module)) {
+    return true;
+  }
+
   // .debug_ranges and .debug_rnglists reader
   DumperRangesHandler ranges_handler(&byte_reader);
 
-  // Parse all the compilation units in the .debug_info section.
+  // Parse the compilation units in the .debug_info section, or if only
+  // some addresses are wanted, those that may cover them.
   DumperLineToModule line_to_module(&byte_reader);
   google_breakpad::SectionMap::const_iterator debug_info_entry =
       file_context.section_map().find(".debug_info");
@@ -483,7 +504,16 @@ bool LoadDwarf(const string& dwarf_filename,
   // .debug_info section.
   assert(debug_info_section.first);
   uint64_t debug_info_length = debug_info_section.second;
-  for (uint64_t offset = 0; offset < debug_info_length;) {
+  vector<uint64_t> unit_offsets;
+  if (!addresses.empty() &&
+      FindUnitsCoveringAddresses(file_context.section_map(), endianness,
+                                 addresses, &unit_offsets) &&
+      unit_offsets.empty()) {
+    return true;
+  }
+  size_t next_unit = 0;
+  for (uint64_t offset = unit_offsets.empty() ? 0 : unit_offsets[0];
+       offset < debug_info_length;) {
     // Make a handler for the root DIE that populates MODULE with the
     // data that was found.
     DwarfCUToModule::WarningReporter reporter(dwarf_filename, offset);
@@ -506,7 +536,12 @@ bool LoadDwarf(const string& dwarf_filename,
     // Start to process split dwarf file.
     if (reader.ShouldProcessSplitDwarf()) {
       StartProcessSplitDwarf(&reader, module, endianness, handle_inter_cu_refs,
-                             handle_inline);
+                             handle_inline, NULL, &dwp_reader);
+    }
+    if (!unit_offsets.empty()) {
+      if (++next_unit == unit_offsets.size())
+        break;
+      offset = unit_offsets[next_unit];
     }
   }
   return true;
@@ -553,6 +588,7 @@ bool LoadDwarfCFI(const string& dwarf_filename,
                   const typename ElfClass::Shdr* got_section,
                   const typename ElfClass::Shdr* text_section,
                   const bool big_endian,
+                  const vector<uint64_t>& addresses,
                   Module* module) {
   // Find the appropriate set of register names for this file's
   // architecture.
@@ -571,10 +607,13 @@ bool LoadDwarfCFI(const string& dwarf_filename,
   const uint8_t* cfi =
       GetOffset<ElfClass, uint8_t>(elf_header, section->sh_offset);
   size_t cfi_size = section->sh_size;
+  AdviseSequentialRead(cfi, cfi_size);
 
   // Plug together the parser, handler, and their entourages.
   DwarfCFIToModule::Reporter module_reporter(dwarf_filename, section_name);
   DwarfCFIToModule handler(module, register_names, &module_reporter);
+  if (!addresses.empty())
+    handler.SetAddresses(&addresses);
   google_breakpad::ByteReader byte_reader(endianness);
 
   byte_reader.SetAddressSize(ElfClass::kAddrSize);
@@ -740,10 +779,11 @@ string ReadDebugLink(const uint8_t* debuglink,
         byte_reader.ReadFourBytes(&debuglink[debuglink_size - 4]);
 
     uint32_t actual_crc = 0;
+    const size_t kReadSize = 1 << 20;
+    std::unique_ptr<char[]> buf(new char[kReadSize]);
     while (true) {
-      const size_t kReadSize = 4096;
-      char buf[kReadSize];
-      ssize_t bytes_read = HANDLE_EINTR(read(debuglink_fd, &buf, kReadSize));
+      ssize_t bytes_read =
+          HANDLE_EINTR(read(debuglink_fd, buf.get(), kReadSize));
       if (bytes_read < 0) {
         fprintf(stderr, "Error reading debug ELF file %s.\n",
                 debuglink_path.c_str());
@@ -751,7 +791,8 @@ string ReadDebugLink(const uint8_t* debuglink,
       }
       if (bytes_read == 0)
         break;
-      actual_crc = google_breakpad::UpdateCrc32(actual_crc, buf, bytes_read);
+      actual_crc = google_breakpad::UpdateCrc32(actual_crc, buf.get(),
+                                               bytes_read);
     }
     if (actual_crc != expected_crc) {
       fprintf(stderr, "Error reading debug ELF file - CRC32 mismatch: %s\n",
@@ -773,6 +814,108 @@ string ReadDebugLink(const uint8_t* debuglink,
   return string();
 }
 
+// Look for the debug file of the ELF file mapped at |elf_header| under the
+// build ID layout used by GDB and the distributions' debug packages:
+// DEBUG_DIR/.build-id/NN/NNNNNNNN.debug, named after the hex digits of the
+// NT_GNU_BUILD_ID note. The candidate's own build ID note is compared before
+// it is accepted, so unlike .gnu_debuglink there is no file to checksum. If
+// nothing matches, return an empty string.
+string FindDebugFileByBuildId(const void* elf_header,
+                              const string& obj_file,
+                              const std::vector<string>& debug_dirs) {
+  PageAllocator allocator;
+  wasteful_vector<uint8_t> build_id(&allocator, kDefaultBuildIdSize);
+  if (!FileID::ElfBuildIdFromMappedFile(elf_header, build_id) ||
+      build_id.size() < 2) {
+    return string();
+  }
+
+  static const char kHexDigits[] = "0123456789abcdef";
+  string name;
+  name.reserve(build_id.size() * 2 + 7);
+  for (size_t i = 0; i < build_id.size(); ++i) {
+    if (i == 1)
+      name += '/';
+    name += kHexDigits[build_id[i] >> 4];
+    name += kHexDigits[build_id[i] & 0xf];
+  }
+  name += ".debug";
+
+  char obj_file_abspath[PATH_MAX];
+  if (!realpath(obj_file.c_str(), obj_file_abspath))
+    return string();
+
+  for (const string& debug_dir : debug_dirs) {
+    string debug_path = debug_dir + "/.build-id/" + name;
+    if (access(debug_path.c_str(), R_OK) != 0 ||
+        IsSameFile(obj_file_abspath, debug_path)) {
+      continue;
+    }
+
+    MmapWrapper map_wrapper;
+    void* debug_header = nullptr;
+    if (!LoadELF(debug_path, &map_wrapper, &debug_header))
+      continue;
+    wasteful_vector<uint8_t> debug_build_id(&allocator, kDefaultBuildIdSize);
+    if (!FileID::ElfBuildIdFromMappedFile(debug_header, debug_build_id) ||
+        debug_build_id.size() != build_id.size() ||
+        memcmp(&debug_build_id[0], &build_id[0], build_id.size()) != 0) {
+      fprintf(stderr, "Build ID mismatch in debug ELF file: %s\n",
+              debug_path.c_str());
+      continue;
+    }
+    return debug_path;
+  }
+  return string();
+}
+
+// The sections of an ELF file by name, so that looking up each of the
+// sections LoadSymbols wants doesn't walk the section header table again.
+template<typename ElfClass>
+class ElfSectionIndex {
+ public:
+  typedef typename ElfClass::Shdr Shdr;
+  typedef typename ElfClass::Word Word;
+
+  explicit ElfSectionIndex(const typename ElfClass::Ehdr* elf_header) {
+    if (elf_header->e_shnum == 0 ||
+        elf_header->e_shstrndx >= elf_header->e_shnum) {
+      return;
+    }
+    const Shdr* sections =
+        GetOffset<ElfClass, Shdr>(elf_header, elf_header->e_shoff);
+    const Shdr* section_names = sections + elf_header->e_shstrndx;
+    const char* names =
+        GetOffset<ElfClass, char>(elf_header, section_names->sh_offset);
+    const size_t names_size = section_names->sh_size;
+    for (int i = 0; i < elf_header->e_shnum; ++i) {
+      size_t offset = sections[i].sh_name;
+      if (offset >= names_size)
+        continue;
+      const char* name = names + offset;
+      size_t length = strnlen(name, names_size - offset);
+      if (length == 0 || length == names_size - offset)
+        continue;  // Empty, or not terminated within the table.
+      sections_[std::string_view(name, length)].push_back(&sections[i]);
+    }
+  }
+
+  // Return the first section named NAME whose type is TYPE, or NULL.
+  const Shdr* Find(const char* name, Word type) const {
+    auto found = sections_.find(name);
+    if (found == sections_.end())
+      return NULL;
+    for (const Shdr* section : found->second) {
+      if (section->sh_type == type)
+        return section;
+    }
+    return NULL;
+  }
+
+ private:
+  std::unordered_map<std::string_view, vector<const Shdr*>> sections_;
+};
+
 //
 // LoadSymbolsInfo
 //
@@ -865,6 +1008,8 @@ bool LoadSymbols(const string& obj_file,
       elf_header->e_phnum);
   module->SetLoadAddress(loading_addr);
   info->set_loading_addr(loading_addr, obj_file);
+  const vector<uint64_t> addresses =
+      AbsoluteAddresses(options.addresses, loading_addr);
 
   // Allow filtering of extraneous debug information in partitioned libraries.
   // Such libraries contain debug information for all libraries extracted from
@@ -876,22 +1021,84 @@ bool LoadSymbols(const string& obj_file,
 
   const Shdr* sections =
       GetOffset<ElfClass, Shdr>(elf_header, elf_header->e_shoff);
-  const Shdr* section_names = sections + elf_header->e_shstrndx;
-  const char* names =
-      GetOffset<ElfClass, char>(elf_header, section_names->sh_offset);
-  const char* names_end = names + section_names->sh_size;
+  const ElfSectionIndex<ElfClass> section_index(elf_header);
   bool found_debug_info_section = false;
   bool found_usable_info = false;
   bool usable_info_parsed = false;
 
+  // Dwarf Call Frame Information (CFI) is actually independent from
+  // the other DWARF debugging information, and can be used alone.
+  const Shdr* dwarf_cfi_section = NULL;
+  const Shdr* eh_frame_section = NULL;
+  const Shdr* got_section = NULL;
+  const Shdr* text_section = NULL;
+  if (options.symbol_data & CFI) {
+    dwarf_cfi_section = section_index.Find(".debug_frame", SHT_PROGBITS);
+
+    // .debug_frame section type is SHT_PROGBITS for mips on pnacl toolchains,
+    // but MIPS_DWARF for regular gnu toolchains, so both need to be checked
+    if (elf_header->e_machine == EM_MIPS && !dwarf_cfi_section) {
+      dwarf_cfi_section = section_index.Find(".debug_frame", SHT_MIPS_DWARF);
+    }
+    if (dwarf_cfi_section)
+      info->LoadedSection(".debug_frame");
+
+    // Linux C++ exception handling information can also provide
+    // unwinding data.
+    eh_frame_section = section_index.Find(".eh_frame", SHT_PROGBITS);
+    if (eh_frame_section) {
+      // Pointers in .eh_frame data may be relative to the base addresses of
+      // certain sections. Provide those sections if present.
+      got_section = section_index.Find(".got", SHT_PROGBITS);
+      text_section = section_index.Find(".text", SHT_PROGBITS);
+      info->LoadedSection(".eh_frame");
+    }
+  }
+
+  // Load the call frame information into CFI_MODULE, returning true if
+  // any of it was usable.  Failing here is not fatal; even without call
+  // frame information, the other debugging information could be perfectly
+  // useful.
+  auto load_cfi = [&](Module* cfi_module) {
+    bool result = false;
+    if (dwarf_cfi_section) {
+      result =
+          LoadDwarfCFI<ElfClass>(obj_file, elf_header, ".debug_frame",
+                                 dwarf_cfi_section, false, 0, 0, big_endian,
+                                 addresses, cfi_module) || result;
+    }
+    if (eh_frame_section) {
+      result =
+          LoadDwarfCFI<ElfClass>(obj_file, elf_header, ".eh_frame",
+                                 eh_frame_section, true,
+                                 got_section, text_section, big_endian,
+                                 addresses, cfi_module) || result;
+    }
+    return result;
+  };
+
+  // The call frame information shares nothing with the symbols but the
+  // module, so given more than one thread, read it into a module of its
+  // own alongside them, and move its entries over afterwards.
+  bool cfi_result = false;
+  std::unique_ptr<Module> cfi_module;
+  std::thread cfi_thread;
+  if (options.num_threads > 1 && (dwarf_cfi_section || eh_frame_section)) {
+    cfi_module.reset(new Module(module->name(), module->os(),
+                                module->architecture(),
+                                module->identifier()));
+    cfi_module->SetAddressRanges(address_ranges);
+    cfi_module->SetStackFrameEntryLimit(options.stack_frame_entry_limit);
+    cfi_thread = std::thread([&]() {
+      cfi_result = load_cfi(cfi_module.get());
+    });
+  }
+
   if ((options.symbol_data & SYMBOLS_AND_FILES) ||
       (options.symbol_data & INLINES)) {
 #ifndef NO_STABS_SUPPORT
     // Look for STABS debugging information, and load it if present.
-    const Shdr* stab_section =
-      FindElfSectionByName<ElfClass>(".stab", SHT_PROGBITS,
-                                     sections, names, names_end,
-                                     elf_header->e_shnum);
+    const Shdr* stab_section = section_index.Find(".stab", SHT_PROGBITS);
     if (stab_section) {
       const Shdr* stabstr_section = stab_section->sh_link + sections;
       if (stabstr_section) {
@@ -910,14 +1117,8 @@ bool LoadSymbols(const string& obj_file,
 #endif  // NO_STABS_SUPPORT
 
     // See if there are export symbols available.
-    const Shdr* symtab_section =
-        FindElfSectionByName<ElfClass>(".symtab", SHT_SYMTAB,
-                                       sections, names, names_end,
-                                       elf_header->e_shnum);
-    const Shdr* strtab_section =
-        FindElfSectionByName<ElfClass>(".strtab", SHT_STRTAB,
-                                       sections, names, names_end,
-                                       elf_header->e_shnum);
+    const Shdr* symtab_section = section_index.Find(".symtab", SHT_SYMTAB);
+    const Shdr* strtab_section = section_index.Find(".strtab", SHT_STRTAB);
     if (symtab_section && strtab_section) {
       info->LoadedSection(".symtab");
 
@@ -934,18 +1135,13 @@ bool LoadSymbols(const string& obj_file,
                              strtab_section->sh_size,
                              big_endian,
                              ElfClass::kAddrSize,
-                             module);
+                             module,
+                             options.num_threads);
       found_usable_info = found_usable_info || result;
     } else {
       // Look in dynsym only if full symbol table was not available.
-      const Shdr* dynsym_section =
-          FindElfSectionByName<ElfClass>(".dynsym", SHT_DYNSYM,
-                                         sections, names, names_end,
-                                         elf_header->e_shnum);
-      const Shdr* dynstr_section =
-          FindElfSectionByName<ElfClass>(".dynstr", SHT_STRTAB,
-                                         sections, names, names_end,
-                                         elf_header->e_shnum);
+      const Shdr* dynsym_section = section_index.Find(".dynsym", SHT_DYNSYM);
+      const Shdr* dynstr_section = section_index.Find(".dynstr", SHT_STRTAB);
       if (dynsym_section && dynstr_section) {
         info->LoadedSection(".dynsym");
 
@@ -962,7 +1158,8 @@ bool LoadSymbols(const string& obj_file,
                                dynstr_section->sh_size,
                                big_endian,
                                ElfClass::kAddrSize,
-                               module);
+                               module,
+                               options.num_threads);
         found_usable_info = found_usable_info || result;
       }
     }
@@ -970,18 +1167,12 @@ bool LoadSymbols(const string& obj_file,
     // Only Load .debug_info after loading symbol table to avoid duplicate
     // PUBLIC records.
     // Look for DWARF debugging information, and load it if present.
-    const Shdr* dwarf_section =
-      FindElfSectionByName<ElfClass>(".debug_info", SHT_PROGBITS,
-                                     sections, names, names_end,
-                                     elf_header->e_shnum);
+    const Shdr* dwarf_section = section_index.Find(".debug_info", SHT_PROGBITS);
 
     // .debug_info section type is SHT_PROGBITS for mips on pnacl toolchains,
     // but MIPS_DWARF for regular gnu toolchains, so both need to be checked
     if (elf_header->e_machine == EM_MIPS && !dwarf_section) {
-      dwarf_section =
-        FindElfSectionByName<ElfClass>(".debug_info", SHT_MIPS_DWARF,
-                                       sections, names, names_end,
-                                       elf_header->e_shnum);
+      dwarf_section = section_index.Find(".debug_info", SHT_MIPS_DWARF);
     }
 
     if (dwarf_section) {
@@ -990,7 +1181,9 @@ bool LoadSymbols(const string& obj_file,
       info->LoadedSection(".debug_info");
       bool result = LoadDwarf<ElfClass>(obj_file, elf_header, big_endian,
                                options.handle_inter_cu_refs,
-                               options.symbol_data & INLINES, module);
+                               options.symbol_data & INLINES,
+                               options.num_threads,
+                               options.dwarf_cache_dir, addresses, module);
       usable_info_parsed = usable_info_parsed || result;
       if (!result){
         fprintf(stderr, "%s: \".debug_info\" section found, but failed to load "
@@ -999,74 +1192,32 @@ bool LoadSymbols(const string& obj_file,
     }
   }
 
-  if (options.symbol_data & CFI) {
-    // Dwarf Call Frame Information (CFI) is actually independent from
-    // the other DWARF debugging information, and can be used alone.
-    const Shdr* dwarf_cfi_section =
-        FindElfSectionByName<ElfClass>(".debug_frame", SHT_PROGBITS,
-                                       sections, names, names_end,
-                                       elf_header->e_shnum);
-
-    // .debug_frame section type is SHT_PROGBITS for mips on pnacl toolchains,
-    // but MIPS_DWARF for regular gnu toolchains, so both need to be checked
-    if (elf_header->e_machine == EM_MIPS && !dwarf_cfi_section) {
-      dwarf_cfi_section =
-          FindElfSectionByName<ElfClass>(".debug_frame", SHT_MIPS_DWARF,
-                                        sections, names, names_end,
-                                        elf_header->e_shnum);
-    }
-
-    if (dwarf_cfi_section) {
-      // Ignore the return value of this function; even without call frame
-      // information, the other debugging information could be perfectly
-      // useful.
-      info->LoadedSection(".debug_frame");
-      bool result =
-          LoadDwarfCFI<ElfClass>(obj_file, elf_header, ".debug_frame",
-                                 dwarf_cfi_section, false, 0, 0, big_endian,
-                                 module);
-      found_usable_info = found_usable_info || result;
-    }
-
-    // Linux C++ exception handling information can also provide
-    // unwinding data.
-    const Shdr* eh_frame_section =
-        FindElfSectionByName<ElfClass>(".eh_frame", SHT_PROGBITS,
-                                       sections, names, names_end,
-                                       elf_header->e_shnum);
-    if (eh_frame_section) {
-      // Pointers in .eh_frame data may be relative to the base addresses of
-      // certain sections. Provide those sections if present.
-      const Shdr* got_section =
-          FindElfSectionByName<ElfClass>(".got", SHT_PROGBITS,
-                                         sections, names, names_end,
-                                         elf_header->e_shnum);
-      const Shdr* text_section =
-          FindElfSectionByName<ElfClass>(".text", SHT_PROGBITS,
-                                         sections, names, names_end,
-                                         elf_header->e_shnum);
-      info->LoadedSection(".eh_frame");
-      // As above, ignore the return value of this function.
-      bool result =
-          LoadDwarfCFI<ElfClass>(obj_file, elf_header, ".eh_frame",
-                                 eh_frame_section, true,
-                                 got_section, text_section, big_endian, module);
-      found_usable_info = found_usable_info || result;
-    }
+  if (cfi_thread.joinable()) {
+    cfi_thread.join();
+    module->AdoptStackFrameEntries(cfi_module.get());
+  } else {
+    cfi_result = load_cfi(module);
   }
+  found_usable_info = found_usable_info || cfi_result;
 
   if (!found_debug_info_section) {
     fprintf(stderr, "%s: file contains no debugging information"
             " (no \".stab\" or \".debug_info\" sections)\n",
             obj_file.c_str());
 
-    // Failed, but maybe there's a .gnu_debuglink section?
+    // Failed, but maybe the debug file can be found by build ID, or there's
+    // a .gnu_debuglink section?
     if (read_gnu_debug_link) {
       const Shdr* gnu_debuglink_section
-          = FindElfSectionByName<ElfClass>(".gnu_debuglink", SHT_PROGBITS,
-                                           sections, names,
-                                           names_end, elf_header->e_shnum);
-      if (gnu_debuglink_section) {
+          = section_index.Find(".gnu_debuglink", SHT_PROGBITS);
+      string build_id_file;
+      if (!info->debug_dirs().empty()) {
+        build_id_file = FindDebugFileByBuildId(elf_header, obj_file,
+                                               info->debug_dirs());
+      }
+      if (!build_id_file.empty()) {
+        info->set_debuglink_file(build_id_file);
+      } else if (gnu_debuglink_section) {
         if (!info->debug_dirs().empty()) {
           const uint8_t* debuglink_contents =
               GetOffset<ElfClass, uint8_t>(elf_header,
@@ -1216,6 +1367,9 @@ bool ReadSymbolDataElfClass(const typename ElfClass::Ehdr* elf_header,
                                       module, options.enable_multiple_field)) {
     return false;
   }
+  module->SetStackFrameEntryLimit(options.stack_frame_entry_limit);
+  module->SetFunctionLimit(options.function_limit);
+  module->SetWriteThreads(options.num_threads);
 
   // Figure out what endianness this file is.
   bool big_endian;
@@ -1250,6 +1404,15 @@ bool ReadSymbolDataElfClass(const typename ElfClass::Ehdr* elf_header,
     }
   }
 
+  if (!options.addresses.empty()) {
+    typedef typename ElfClass::Phdr Phdr;
+    module->RetainAddresses(AbsoluteAddresses(
+        options.addresses,
+        GetLoadingAddress<ElfClass>(
+            GetOffset<ElfClass, Phdr>(elf_header, elf_header->e_phoff),
+            elf_header->e_phnum)));
+  }
+
   *out_module = module.release();
   return true;
 }
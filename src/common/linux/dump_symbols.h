@@ -53,19 +53,47 @@ struct DumpOptions {
       : symbol_data(symbol_data),
         handle_inter_cu_refs(handle_inter_cu_refs),
         enable_multiple_field(enable_multiple_field),
-        preserve_load_address(preserve_load_address) {}
+        preserve_load_address(preserve_load_address),
+        num_threads(1),
+        stack_frame_entry_limit(0),
+        function_limit(0) {}
 
   SymbolData symbol_data;
   bool handle_inter_cu_refs;
   bool enable_multiple_field;
   bool preserve_load_address;
+  // The number of threads to read debugging information on.  With more
+  // than one, call frame information is read alongside the symbols, and
+  // DWARF compilation units and symbol table names are read concurrently,
+  // and the source files are numbered on several threads when written.
+  int num_threads;
+  // The number of call frame information entries to hold in memory before
+  // spilling them to a temporary file, or zero to hold them all.  See
+  // Module::SetStackFrameEntryLimit.
+  size_t stack_frame_entry_limit;
+  // The number of functions to hold in memory before spilling them to a
+  // temporary file as a sorted run, or zero to hold them all.  See
+  // Module::SetFunctionLimit.
+  size_t function_limit;
+  // If not empty, a directory in which to cache what is read from each
+  // DWARF compilation unit, so that later runs over a binary that shares
+  // units with this one can skip reading them.  The output is the same
+  // either way.
+  string dwarf_cache_dir;
+  // If not empty, addresses relative to the module's load address to which
+  // the output is limited: only the compilation units and call frame
+  // information entries that may cover them are read, and only the
+  // functions covering them and the nearest symbol below each are written.
+  // The symbol file is marked "INFO PARTIAL".
+  std::vector<uint64_t> addresses;
 };
 
 // Find all the debugging information in OBJ_FILE, an ELF executable
 // or shared library, and write it to SYM_STREAM in the Breakpad symbol
 // file format.
-// If OBJ_FILE has been stripped but contains a .gnu_debuglink section,
-// then look for the debug file in DEBUG_DIRS.
+// If OBJ_FILE has been stripped, then look for the debug file in DEBUG_DIRS,
+// first as .build-id/NN/NNNN.debug after its build ID note and then by the
+// name in its .gnu_debuglink section.
 // SYMBOL_DATA allows limiting the type of symbol data written.
 bool WriteSymbolFile(const string& load_path,
                      const string& obj_file,
@@ -0,0 +1,630 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// dump_symbols_benchmark.cc: Time how long google_breakpad::ReadSymbolData
+// and Module::Write take over a binary, phase by phase.
+//
+// Given no binary, the benchmark generates an ELF file with DWARF debugging
+// information and call frame information of a chosen size, so that runs are
+// comparable from machine to machine and from change to change.  Each
+// phase's time is the difference between runs that read more or less of
+// the file on one thread:
+//
+//   ELF sections   reading the synthetic file with its .debug_info emptied
+//   CU parse       reading the symbols, less the ELF sections time
+//   CFI parse      reading the symbols and CFI, less the symbols alone
+//   Module::Write  writing the module out
+//
+// The total is a single run with the -j and -s options given, and the peak
+// RSS is that of the process after that run.  To compare the memory used
+// by different options, run the benchmark once per option.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <elf.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "common/dwarf/cfi_assembler.h"
+#include "common/dwarf/dwarf2enums.h"
+#include "common/linux/dump_symbols.h"
+#include "common/linux/elfutils.h"
+#include "common/linux/synth_elf.h"
+#include "common/module.h"
+#include "common/test_assembler.h"
+#include "common/using_std_string.h"
+
+namespace {
+
+using google_breakpad::CFISection;
+using google_breakpad::DumpOptions;
+using google_breakpad::Module;
+using google_breakpad::synth_elf::ELF;
+using google_breakpad::synth_elf::StringTable;
+using google_breakpad::synth_elf::SymbolTable;
+using google_breakpad::test_assembler::kLittleEndian;
+using google_breakpad::test_assembler::Label;
+using google_breakpad::test_assembler::Section;
+using std::vector;
+
+// The shape of a synthetic binary.
+struct SyntheticShape {
+  int compilation_units = 200;
+  int functions = 100;     // per compilation unit
+  int lines = 20;          // line rows per function
+  int inlines = 0;         // inlined calls per function
+  int cfi_entries = 1;     // CFI FDEs per function
+};
+
+const uint64_t kTextAddress = 0x10000;
+const uint64_t kLineSize = 4;
+
+// Abbreviation codes in the synthetic .debug_abbrev.
+enum {
+  kCompileUnitAbbrev = 1,
+  kFunctionAbbrev,
+  kInlineOriginAbbrev,
+  kInlinedCallAbbrev
+};
+
+uint64_t FunctionSize(const SyntheticShape& shape) {
+  return std::max(shape.lines, std::max(shape.inlines, shape.cfi_entries) + 1)
+      * kLineSize;
+}
+
+void AppendAbbrev(Section* abbrevs, int code, int tag, bool children,
+                  const vector<std::pair<int, int>>& attributes) {
+  abbrevs->ULEB128(code).ULEB128(tag).D8(children ? 1 : 0);
+  for (const auto& attribute : attributes)
+    abbrevs->ULEB128(attribute.first).ULEB128(attribute.second);
+  abbrevs->ULEB128(0).ULEB128(0);
+}
+
+string Contents(Section& section) {
+  string contents;
+  section.GetContents(&contents);
+  return contents;
+}
+
+// Return the line number program for compilation unit UNIT.
+string LineProgram(const SyntheticShape& shape, int unit,
+                   uint64_t unit_address) {
+  using namespace google_breakpad;
+  Section program(kLittleEndian);
+  program.start() = 0;
+  Label length, header_start, header_length, program_start, end;
+  program.D32(length).Mark(&header_start).D16(4).D32(header_length);
+  program.D8(1)    // minimum_instruction_length
+      .D8(1)       // maximum_operations_per_instruction
+      .D8(1)       // default_is_stmt
+      .D8(-5)      // line_base
+      .D8(14)      // line_range
+      .D8(13);     // opcode_base
+  const uint8_t kOpcodeLengths[] = {0, 1, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1};
+  program.Append(kOpcodeLengths, sizeof(kOpcodeLengths));
+  program.AppendCString("/synthetic/src").D8(0);
+  char file_name[32];
+  snprintf(file_name, sizeof(file_name), "unit%d.cc", unit);
+  program.AppendCString(file_name).ULEB128(1).ULEB128(0).ULEB128(0).D8(0);
+  program.Mark(&program_start);
+  header_length = program_start - header_start - 6;
+
+  uint64_t function_size = FunctionSize(shape);
+  for (int function = 0; function < shape.functions; ++function) {
+    uint64_t address = unit_address + function * function_size;
+    program.D8(0).ULEB128(9).D8(DW_LNE_set_address).D64(address);
+    program.D8(DW_LNS_advance_line).LEB128(function * shape.lines);
+    for (int line = 0; line < shape.lines; ++line) {
+      if (line > 0) {
+        program.D8(DW_LNS_advance_pc).ULEB128(kLineSize);
+        program.D8(DW_LNS_advance_line).LEB128(1);
+      }
+      program.D8(DW_LNS_copy);
+    }
+    program.D8(DW_LNS_advance_pc).ULEB128(
+        function_size - (shape.lines - 1) * kLineSize);
+    program.D8(0).ULEB128(1).D8(DW_LNE_end_sequence);
+    program.D8(DW_LNS_advance_line).LEB128(-(function + 1) * shape.lines + 1);
+  }
+  program.Mark(&end);
+  length = end - header_start;
+  return Contents(program);
+}
+
+// Return the .debug_info entries for compilation unit UNIT, whose lines
+// are at LINE_OFFSET in .debug_line, adding its names to STRINGS.
+string CompilationUnit(const SyntheticShape& shape, int unit,
+                       uint64_t unit_address, uint64_t line_offset,
+                       string* strings) {
+  using namespace google_breakpad;
+  auto add_string = [strings](const string& s) {
+    uint32_t offset = strings->size();
+    strings->append(s.c_str(), s.size() + 1);
+    return offset;
+  };
+  char name[64];
+  uint64_t function_size = FunctionSize(shape);
+  Section cu(kLittleEndian);
+  cu.start() = 0;
+  Label length, after_length, end;
+  cu.D32(length).Mark(&after_length).D16(4).D32(0).D8(8);
+
+  snprintf(name, sizeof(name), "unit%d.cc", unit);
+  cu.ULEB128(kCompileUnitAbbrev)
+      .D32(add_string(name))
+      .D32(add_string("/synthetic/src"))
+      .D16(DW_LANG_C_plus_plus)
+      .D64(unit_address)
+      .D64(shape.functions * function_size)
+      .D32(line_offset);
+
+  vector<Label> origins(shape.inlines);
+  for (int i = 0; i < shape.inlines; ++i) {
+    snprintf(name, sizeof(name), "synthetic::Unit%d::Inline%d()", unit, i);
+    cu.Mark(&origins[i]);
+    cu.ULEB128(kInlineOriginAbbrev).D32(add_string(name)).D8(DW_INL_inlined);
+  }
+
+  uint64_t inline_size = function_size / (shape.inlines + 1);
+  for (int function = 0; function < shape.functions; ++function) {
+    uint64_t address = unit_address + function * function_size;
+    snprintf(name, sizeof(name), "synthetic::Unit%d::Function%d(int)", unit,
+             function);
+    cu.ULEB128(kFunctionAbbrev)
+        .D32(add_string(name))
+        .D64(address)
+        .D64(function_size)
+        .D8(1)
+        .D32(function * shape.lines + 1);
+    for (int i = 0; i < shape.inlines; ++i) {
+      cu.ULEB128(kInlinedCallAbbrev)
+          .D32(origins[i])
+          .D64(address + (i + 1) * inline_size)
+          .D64(inline_size)
+          .D8(1)
+          .D32(function * shape.lines + 1 + i);
+    }
+    cu.D8(0);
+  }
+  cu.D8(0);
+  cu.Mark(&end);
+  length = end - after_length;
+  return Contents(cu);
+}
+
+// Write a binary of SHAPE to PATH, along with a copy at BARE_PATH whose
+// .debug_info is empty.  Return false on failure.
+bool WriteSyntheticBinary(const SyntheticShape& shape, const string& path,
+                          const string& bare_path) {
+  using namespace google_breakpad;
+  Section abbrevs(kLittleEndian);
+  AppendAbbrev(&abbrevs, kCompileUnitAbbrev, DW_TAG_compile_unit, true,
+               {{DW_AT_name, DW_FORM_strp},
+                {DW_AT_comp_dir, DW_FORM_strp},
+                {DW_AT_language, DW_FORM_data2},
+                {DW_AT_low_pc, DW_FORM_addr},
+                {DW_AT_high_pc, DW_FORM_data8},
+                {DW_AT_stmt_list, DW_FORM_sec_offset}});
+  AppendAbbrev(&abbrevs, kFunctionAbbrev, DW_TAG_subprogram, true,
+               {{DW_AT_name, DW_FORM_strp},
+                {DW_AT_low_pc, DW_FORM_addr},
+                {DW_AT_high_pc, DW_FORM_data8},
+                {DW_AT_decl_file, DW_FORM_data1},
+                {DW_AT_decl_line, DW_FORM_data4}});
+  AppendAbbrev(&abbrevs, kInlineOriginAbbrev, DW_TAG_subprogram, false,
+               {{DW_AT_name, DW_FORM_strp},
+                {DW_AT_inline, DW_FORM_data1}});
+  AppendAbbrev(&abbrevs, kInlinedCallAbbrev, DW_TAG_inlined_subroutine, false,
+               {{DW_AT_abstract_origin, DW_FORM_ref4},
+                {DW_AT_low_pc, DW_FORM_addr},
+                {DW_AT_high_pc, DW_FORM_data8},
+                {DW_AT_call_file, DW_FORM_data1},
+                {DW_AT_call_line, DW_FORM_data4}});
+  abbrevs.ULEB128(0);
+
+  // x86-64 call frame information: each function pushes %rbp and then
+  // uses it as the frame pointer.
+  CFISection frames(kLittleEndian, 8);
+  Label cie;
+  frames.Mark(&cie)
+      .CIEHeader(1, -8, 16, 4, "")
+      .D8(DW_CFA_def_cfa).ULEB128(7).ULEB128(8)
+      .D8(DW_CFA_offset | 16).ULEB128(1)
+      .FinishEntry();
+
+  string info, lines, strings;
+  uint64_t function_size = FunctionSize(shape);
+  uint64_t unit_size = shape.functions * function_size;
+  uint64_t entry_size = function_size / shape.cfi_entries;
+  for (int unit = 0; unit < shape.compilation_units; ++unit) {
+    uint64_t unit_address = kTextAddress + unit * unit_size;
+    uint64_t line_offset = lines.size();
+    lines += LineProgram(shape, unit, unit_address);
+    info += CompilationUnit(shape, unit, unit_address, line_offset, &strings);
+    for (int function = 0; function < shape.functions; ++function) {
+      uint64_t address = unit_address + function * function_size;
+      for (int entry = 0; entry < shape.cfi_entries; ++entry) {
+        frames.FDEHeader(cie, address + entry * entry_size, entry_size)
+            .D8(DW_CFA_advance_loc | 1)
+            .D8(DW_CFA_def_cfa_offset).ULEB128(16)
+            .D8(DW_CFA_offset | 6).ULEB128(2)
+            .D8(DW_CFA_advance_loc | 3)
+            .D8(DW_CFA_def_cfa_register).ULEB128(6)
+            .FinishEntry();
+      }
+    }
+  }
+
+  Section text(kLittleEndian);
+  text.Append(shape.compilation_units * unit_size, 0xc3);
+  string debug_frame = Contents(frames);
+
+  for (bool bare : {false, true}) {
+    ELF elf(EM_X86_64, ELFCLASS64, kLittleEndian);
+    int text_index = elf.AddSection(".text", text, SHT_PROGBITS,
+                                    SHF_ALLOC | SHF_EXECINSTR, kTextAddress);
+    StringTable symbol_names(kLittleEndian);
+    SymbolTable symbols(kLittleEndian, 8, symbol_names);
+    for (int unit = 0; unit < shape.compilation_units; ++unit) {
+      for (int function = 0; function < shape.functions; ++function) {
+        char name[64];
+        snprintf(name, sizeof(name), "_ZN9synthetic5Unit%d9Function%dEi",
+                 unit, function);
+        symbols.AddSymbol(name, static_cast<uint64_t>(
+                              kTextAddress + unit * unit_size +
+                              function * function_size),
+                          function_size, ELF64_ST_INFO(STB_GLOBAL, STT_FUNC),
+                          text_index);
+      }
+    }
+    int strtab_index = elf.AddSection(".strtab", symbol_names, SHT_STRTAB);
+    elf.AddSection(".symtab", symbols, SHT_SYMTAB, 0, 0, strtab_index,
+                   sizeof(Elf64_Sym));
+    Section section(kLittleEndian);
+    elf.AddSection(".debug_abbrev", abbrevs, SHT_PROGBITS);
+    elf.AddSection(".debug_info", bare ? section : section.Append(info),
+                   SHT_PROGBITS);
+    elf.AddSection(".debug_line", Section(kLittleEndian).Append(lines),
+                   SHT_PROGBITS);
+    elf.AddSection(".debug_str", Section(kLittleEndian).Append(strings),
+                   SHT_PROGBITS);
+    elf.AddSection(".debug_frame", Section(kLittleEndian).Append(debug_frame),
+                   SHT_PROGBITS);
+    elf.Finish();
+
+    string contents = Contents(elf);
+    const string& file = bare ? bare_path : path;
+    FILE* out = fopen(file.c_str(), "wb");
+    if (!out) {
+      perror(file.c_str());
+      return false;
+    }
+    bool ok = fwrite(contents.data(), 1, contents.size(), out) ==
+        contents.size();
+    ok = fclose(out) == 0 && ok;
+    if (!ok) {
+      fprintf(stderr, "%s: write failed\n", file.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+// Sizes of the debugging information in a binary.
+struct DebugSizes {
+  uint64_t file = 0;
+  uint64_t dwarf = 0;  // .debug_* sections other than .debug_frame
+  uint64_t cfi = 0;    // .debug_frame and .eh_frame
+};
+
+template<typename ElfClass>
+void AddSectionSizes(const uint8_t* base, DebugSizes* sizes) {
+  typedef typename ElfClass::Ehdr Ehdr;
+  typedef typename ElfClass::Shdr Shdr;
+  const Ehdr* header = reinterpret_cast<const Ehdr*>(base);
+  const Shdr* sections = reinterpret_cast<const Shdr*>(base + header->e_shoff);
+  const char* names =
+      reinterpret_cast<const char*>(base +
+                                    sections[header->e_shstrndx].sh_offset);
+  for (int i = 0; i < header->e_shnum; ++i) {
+    const char* name = names + sections[i].sh_name;
+    if (strcmp(name, ".debug_frame") == 0 || strcmp(name, ".eh_frame") == 0)
+      sizes->cfi += sections[i].sh_size;
+    else if (strncmp(name, ".debug_", 7) == 0 ||
+             strncmp(name, ".zdebug_", 8) == 0)
+      sizes->dwarf += sections[i].sh_size;
+  }
+}
+
+bool GetDebugSizes(const string& path, DebugSizes* sizes) {
+  int fd = open(path.c_str(), O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    perror(path.c_str());
+    if (fd >= 0)
+      close(fd);
+    return false;
+  }
+  void* base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (base == MAP_FAILED) {
+    perror(path.c_str());
+    return false;
+  }
+  sizes->file = st.st_size;
+  bool ok = google_breakpad::IsValidElf(base);
+  if (ok && google_breakpad::ElfClass(base) == ELFCLASS64) {
+    AddSectionSizes<google_breakpad::ElfClass64>(
+        static_cast<const uint8_t*>(base), sizes);
+  } else if (ok) {
+    AddSectionSizes<google_breakpad::ElfClass32>(
+        static_cast<const uint8_t*>(base), sizes);
+  } else {
+    fprintf(stderr, "%s: not an ELF file\n", path.c_str());
+  }
+  munmap(base, st.st_size);
+  return ok;
+}
+
+// A stream buffer that throws everything written to it away, so that
+// timing Module::Write measures formatting rather than the disk.
+class NullBuffer : public std::streambuf {
+ protected:
+  int overflow(int c) override { return c; }
+  std::streamsize xsputn(const char*, std::streamsize count) override {
+    return count;
+  }
+};
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start).count();
+}
+
+// Read PATH with OPTIONS REPEAT times, and return the shortest time taken,
+// or a negative number if reading fails.  If MODULE is non-NULL, store the
+// module from the last read there.
+double TimeRead(const string& path, const DumpOptions& options, int repeat,
+                std::unique_ptr<Module>* module) {
+  double best = -1;
+  for (int i = 0; i < repeat; ++i) {
+    Module* read = NULL;
+    auto start = std::chrono::steady_clock::now();
+    if (!google_breakpad::ReadSymbolData(path, path, "Linux", "",
+                                         vector<string>(), options, &read))
+      return -1;
+    double seconds = Seconds(start);
+    if (best < 0 || seconds < best)
+      best = seconds;
+    if (module && i == repeat - 1)
+      module->reset(read);
+    else
+      delete read;
+  }
+  return best;
+}
+
+void PrintPhase(const char* phase, double seconds, uint64_t bytes) {
+  if (seconds < 0) {
+    printf("%-16s %10s\n", phase, "n/a");
+  } else if (bytes && seconds > 0) {
+    printf("%-16s %10.3f %10.1f\n", phase, seconds,
+           bytes / seconds / (1 << 20));
+  } else {
+    printf("%-16s %10.3f\n", phase, seconds);
+  }
+}
+
+void Usage(const char* program) {
+  fprintf(stderr,
+          "Usage: %s [OPTION]... [binary]\n"
+          "Time reading the debugging information of |binary|, or of a\n"
+          "synthetic binary, and writing it out as a symbol file.\n\n"
+          "Options:\n"
+          "  -u <N>      Compilation units in the synthetic binary\n"
+          "  -f <N>      Functions per compilation unit\n"
+          "  -l <N>      Line rows per function\n"
+          "  -i <N>      Inlined calls per function\n"
+          "  -e <N>      Call frame information entries per function\n"
+          "  -o <file>   Keep the synthetic binary in <file>\n"
+          "  -j <N>      Read debugging information on N threads\n"
+          "  -s <N>      Spill call frame information to disk beyond N\n"
+          "              entries\n"
+          "  -r <N>      Take the best of N runs of each phase\n",
+          program);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  SyntheticShape shape;
+  string output_path;
+  int num_threads = 1;
+  size_t stack_frame_entry_limit = 0;
+  int repeat = 1;
+  int opt;
+  while ((opt = getopt(argc, argv, "u:f:l:i:e:o:j:s:r:h")) != -1) {
+    switch (opt) {
+      case 'u':
+        shape.compilation_units = atoi(optarg);
+        break;
+      case 'f':
+        shape.functions = atoi(optarg);
+        break;
+      case 'l':
+        shape.lines = atoi(optarg);
+        break;
+      case 'i':
+        shape.inlines = atoi(optarg);
+        break;
+      case 'e':
+        shape.cfi_entries = atoi(optarg);
+        break;
+      case 'o':
+        output_path = optarg;
+        break;
+      case 'j':
+        num_threads = atoi(optarg);
+        break;
+      case 's':
+        stack_frame_entry_limit = strtoul(optarg, NULL, 10);
+        break;
+      case 'r':
+        repeat = atoi(optarg);
+        break;
+      default:
+        Usage(argv[0]);
+        return 1;
+    }
+  }
+  if (optind + 1 < argc || shape.compilation_units < 1 ||
+      shape.functions < 1 || shape.lines < 1 || shape.inlines < 0 ||
+      shape.cfi_entries < 1 || num_threads < 1 || repeat < 1) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  string path, bare_path;
+  bool synthetic = optind == argc;
+  if (synthetic) {
+    const char* tmpdir = getenv("TMPDIR");
+    string temp = string(tmpdir ? tmpdir : "/tmp") +
+        "/dump_symbols_benchmark.XXXXXX";
+    int fd = mkstemp(&temp[0]);
+    if (fd < 0) {
+      perror("mkstemp");
+      return 1;
+    }
+    close(fd);
+    path = output_path.empty() ? temp : output_path;
+    bare_path = temp + ".bare";
+    if (path != temp)
+      unlink(temp.c_str());
+
+    // Generate the binary in a child process, so that the memory the
+    // assembler takes doesn't count towards the dumper's peak RSS.
+    pid_t child = fork();
+    if (child == 0)
+      _exit(WriteSyntheticBinary(shape, path, bare_path) ? 0 : 1);
+    int status;
+    if (child < 0 || waitpid(child, &status, 0) != child ||
+        !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      fprintf(stderr, "failed to generate a synthetic binary\n");
+      return 1;
+    }
+  } else {
+    path = argv[optind];
+  }
+
+  DebugSizes sizes;
+  if (!GetDebugSizes(path, &sizes))
+    return 1;
+  if (synthetic) {
+    printf("synthetic binary: %d units, %d functions, %d lines, %d inlined "
+           "calls, %d CFI entries\n", shape.compilation_units,
+           shape.compilation_units * shape.functions,
+           shape.compilation_units * shape.functions * shape.lines,
+           shape.compilation_units * shape.functions * shape.inlines,
+           shape.compilation_units * shape.functions * shape.cfi_entries);
+  } else {
+    printf("binary: %s\n", path.c_str());
+  }
+  printf("file %.1f MB, DWARF %.1f MB, CFI %.1f MB\n\n",
+         sizes.file / double(1 << 20), sizes.dwarf / double(1 << 20),
+         sizes.cfi / double(1 << 20));
+
+  SymbolData symbols = SYMBOLS_AND_FILES;
+  if (shape.inlines > 0 || !synthetic)
+    symbols = symbols | INLINES;
+  DumpOptions options(symbols | CFI, true, false, false);
+  options.num_threads = num_threads;
+  options.stack_frame_entry_limit = stack_frame_entry_limit;
+  std::unique_ptr<Module> module;
+  double total = TimeRead(path, options, repeat, &module);
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  if (total < 0) {
+    fprintf(stderr, "%s: failed to read debugging information\n",
+            path.c_str());
+    return 1;
+  }
+
+  DumpOptions serial(symbols, true, false, false);
+  double elf = synthetic ? TimeRead(bare_path, serial, repeat, NULL) : -1;
+  double read_symbols = TimeRead(path, serial, repeat, NULL);
+  serial.symbol_data = symbols | CFI;
+  double read_all = TimeRead(path, serial, repeat, NULL);
+
+  double write = -1;
+  for (int i = 0; i < repeat; ++i) {
+    NullBuffer buffer;
+    std::ostream stream(&buffer);
+    auto start = std::chrono::steady_clock::now();
+    module->Write(stream, symbols | CFI);
+    double seconds = Seconds(start);
+    if (write < 0 || seconds < write)
+      write = seconds;
+  }
+
+  printf("%-16s %10s %10s\n", "phase", "seconds", "MB/s");
+  PrintPhase("ELF sections", elf, 0);
+  PrintPhase("CU parse",
+             read_symbols < 0 ? -1 : read_symbols - std::max(elf, 0.0),
+             sizes.dwarf);
+  PrintPhase("CFI parse",
+             read_all < 0 || read_symbols < 0 ? -1 : read_all - read_symbols,
+             sizes.cfi);
+  PrintPhase("Module::Write", write, 0);
+  char total_name[32];
+  snprintf(total_name, sizeof(total_name), "total (-j %d)", num_threads);
+  PrintPhase(total_name, total, sizes.dwarf + sizes.cfi);
+  printf("%-16s %10.1f MB\n", "peak RSS", usage.ru_maxrss / 1024.0);
+
+  if (synthetic) {
+    unlink(bare_path.c_str());
+    if (output_path.empty())
+      unlink(path.c_str());
+  }
+  return 0;
+}
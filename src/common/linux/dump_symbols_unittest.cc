@@ -38,6 +38,7 @@
 #include <elf.h>
 #include <link.h>
 #include <stdio.h>
+#include <sys/stat.h>
 
 #include <sstream>
 #include <vector>
@@ -48,6 +49,8 @@
 #include "common/linux/dump_symbols.h"
 #include "common/linux/synth_elf.h"
 #include "common/module.h"
+#include "common/tests/auto_tempdir.h"
+#include "common/tests/file_utils.h"
 #include "common/using_std_string.h"
 
 namespace google_breakpad {
@@ -260,4 +263,95 @@ TYPED_TEST(DumpSymbols, SimpleBuildID) {
   delete module;
 }
 
+TYPED_TEST(DumpSymbols, DebugFileByBuildID) {
+  const uint8_t kBuildId[] =
+    {0xab, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+     0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+     0x10, 0x11, 0x12, 0x13};
+
+  // A stripped object with only a dynamic symbol and no .gnu_debuglink.
+  ELF elf(TypeParam::kMachine, TypeParam::kClass, kLittleEndian);
+  Section text(kLittleEndian);
+  text.Append(4096, 0);
+  elf.AddSection(".text", text, SHT_PROGBITS);
+  Notes notes(kLittleEndian);
+  notes.AddNote(NT_GNU_BUILD_ID, "GNU", kBuildId, sizeof(kBuildId));
+  elf.AddSection(".note.gnu.build-id", notes, SHT_NOTE);
+  StringTable dynstr(kLittleEndian);
+  SymbolTable dynsym(kLittleEndian, TypeParam::kAddrSize, dynstr);
+  dynsym.AddSymbol("superfunc",
+                   (typename TypeParam::Addr)0x1000,
+                   (typename TypeParam::Addr)0x10,
+                   ELF32_ST_INFO(STB_GLOBAL, STT_FUNC),
+                   SHN_UNDEF + 1);
+  int index = elf.AddSection(".dynstr", dynstr, SHT_STRTAB);
+  elf.AddSection(".dynsym", dynsym,
+                 SHT_DYNSYM,          // type
+                 SHF_ALLOC,           // flags
+                 0,                   // addr
+                 index,               // link
+                 sizeof(typename TypeParam::Sym));  // entsize
+  elf.Finish();
+  this->GetElfContents(elf);
+
+  // Its debug file, carrying the same build ID and the full symbol table.
+  ELF debug_elf(TypeParam::kMachine, TypeParam::kClass, kLittleEndian);
+  Section debug_text(kLittleEndian);
+  debug_text.Append(4096, 0);
+  debug_elf.AddSection(".text", debug_text, SHT_PROGBITS);
+  Notes debug_notes(kLittleEndian);
+  debug_notes.AddNote(NT_GNU_BUILD_ID, "GNU", kBuildId, sizeof(kBuildId));
+  debug_elf.AddSection(".note.gnu.build-id", debug_notes, SHT_NOTE);
+  StringTable strtab(kLittleEndian);
+  SymbolTable symtab(kLittleEndian, TypeParam::kAddrSize, strtab);
+  symtab.AddSymbol("debugfunc",
+                   (typename TypeParam::Addr)0x2000,
+                   (typename TypeParam::Addr)0x10,
+                   ELF32_ST_INFO(STB_GLOBAL, STT_FUNC),
+                   SHN_UNDEF + 1);
+  index = debug_elf.AddSection(".strtab", strtab, SHT_STRTAB);
+  debug_elf.AddSection(".symtab", symtab,
+                       SHT_SYMTAB,          // type
+                       0,                   // flags
+                       0,                   // addr
+                       index,               // link
+                       sizeof(typename TypeParam::Sym));  // entsize
+  debug_elf.Finish();
+  string debug_contents;
+  ASSERT_TRUE(debug_elf.GetContents(&debug_contents));
+
+  AutoTempDir temp_dir;
+  const string obj_path = temp_dir.path() + "/foo";
+  ASSERT_TRUE(WriteFile(obj_path.c_str(), this->elfdata,
+                        this->elfdata_v.size()));
+  const string build_id_dir = temp_dir.path() + "/.build-id";
+  ASSERT_EQ(0, mkdir(build_id_dir.c_str(), 0755));
+  ASSERT_EQ(0, mkdir((build_id_dir + "/ab").c_str(), 0755));
+  const string debug_path =
+      build_id_dir + "/ab/0102030405060708090a0b0c0d0e0f10111213.debug";
+  ASSERT_TRUE(WriteFile(debug_path.c_str(), debug_contents.data(),
+                        debug_contents.size()));
+
+  Module* module;
+  DumpOptions options(ALL_SYMBOL_DATA, true, false, false);
+  EXPECT_TRUE(ReadSymbolDataInternal(this->elfdata,
+                                     obj_path,
+                                     "Linux",
+                                     "",
+                                     vector<string>(1, temp_dir.path()),
+                                     options,
+                                     &module));
+
+  stringstream s;
+  module->Write(s, ALL_SYMBOL_DATA);
+  const string expected =
+    string("MODULE Linux ") + TypeParam::kMachineName
+    + " 030201AB0504070608090A0B0C0D0E0F0 foo\n"
+    "INFO CODE_ID AB0102030405060708090A0B0C0D0E0F10111213\n"
+    "PUBLIC 1000 0 superfunc\n"
+    "PUBLIC 2000 0 debugfunc\n";
+  EXPECT_EQ(expected, s.str());
+  delete module;
+}
+
 }  // namespace google_breakpad
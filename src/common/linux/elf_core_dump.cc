@@ -39,6 +39,8 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <algorithm>
+
 namespace google_breakpad {
 
 // Implementation of ElfCoreDump::Note.
@@ -99,10 +101,24 @@ size_t ElfCoreDump::Note::AlignedSize(size_t size) {
 
 // Implementation of ElfCoreDump.
 
-ElfCoreDump::ElfCoreDump() : proc_mem_fd_(-1) {}
+namespace {
+
+// Orders program headers by virtual address.
+bool LoadSegmentStartsBefore(const ElfCoreDump::Phdr* a,
+                             const ElfCoreDump::Phdr* b) {
+  return a->p_vaddr < b->p_vaddr;
+}
+
+}  // namespace
+
+ElfCoreDump::ElfCoreDump()
+    : proc_mem_fd_(-1), load_segments_indexed_(false), last_load_segment_(0) {}
 
 ElfCoreDump::ElfCoreDump(const MemoryRange& content)
-    : content_(content), proc_mem_fd_(-1) {}
+    : content_(content),
+      proc_mem_fd_(-1),
+      load_segments_indexed_(false),
+      last_load_segment_(0) {}
 
 ElfCoreDump::~ElfCoreDump() {
   if (proc_mem_fd_ != -1) {
@@ -113,6 +129,9 @@ ElfCoreDump::~ElfCoreDump() {
 
 void ElfCoreDump::SetContent(const MemoryRange& content) {
   content_ = content;
+  load_segments_.clear();
+  load_segments_indexed_ = false;
+  last_load_segment_ = 0;
 }
 
 void ElfCoreDump::SetProcMem(int fd) {
@@ -163,21 +182,52 @@ unsigned ElfCoreDump::GetProgramHeaderCount() const {
   return header ? header->e_phnum : 0;
 }
 
-bool ElfCoreDump::CopyData(void* buffer, Addr virtual_address, size_t length) {
-  for (unsigned i = 0, n = GetProgramHeaderCount(); i < n; ++i) {
-    const Phdr* program = GetProgramHeader(i);
-    if (program->p_type != PT_LOAD)
-      continue;
+const ElfCoreDump::Phdr* ElfCoreDump::FindLoadSegment(Addr virtual_address) {
+  if (!load_segments_indexed_) {
+    load_segments_indexed_ = true;
+    for (unsigned i = 0, n = GetProgramHeaderCount(); i < n; ++i) {
+      const Phdr* program = GetProgramHeader(i);
+      if (program && program->p_type == PT_LOAD && program->p_filesz)
+        load_segments_.push_back(program);
+    }
+    std::stable_sort(load_segments_.begin(), load_segments_.end(),
+                     LoadSegmentStartsBefore);
+  }
 
-    size_t offset_in_segment = virtual_address - program->p_vaddr;
+  // Stacks and other runs of reads stay in one segment.
+  if (last_load_segment_ < load_segments_.size()) {
+    const Phdr* program = load_segments_[last_load_segment_];
     if (virtual_address >= program->p_vaddr &&
-        offset_in_segment < program->p_filesz) {
-      const void* data =
-          content_.GetData(program->p_offset + offset_in_segment, length);
-      if (data) {
-        memcpy(buffer, data, length);
-        return true;
-      }
+        virtual_address - program->p_vaddr < program->p_filesz) {
+      return program;
+    }
+  }
+
+  // The segment that could hold |virtual_address| is the last one that
+  // starts at or below it.
+  Phdr key = Phdr();
+  key.p_vaddr = virtual_address;
+  std::vector<const Phdr*>::const_iterator iter =
+      std::upper_bound(load_segments_.begin(), load_segments_.end(), &key,
+                       LoadSegmentStartsBefore);
+  if (iter == load_segments_.begin())
+    return NULL;
+  --iter;
+  const Phdr* program = *iter;
+  if (virtual_address - program->p_vaddr >= program->p_filesz)
+    return NULL;
+  last_load_segment_ = iter - load_segments_.begin();
+  return program;
+}
+
+bool ElfCoreDump::CopyData(void* buffer, Addr virtual_address, size_t length) {
+  const Phdr* program = FindLoadSegment(virtual_address);
+  if (program) {
+    const void* data = content_.GetData(
+        program->p_offset + (virtual_address - program->p_vaddr), length);
+    if (data) {
+      memcpy(buffer, data, length);
+      return true;
     }
   }
 
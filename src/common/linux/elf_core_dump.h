@@ -37,6 +37,8 @@
 #include <link.h>
 #include <stddef.h>
 
+#include <vector>
+
 #include "common/memory_range.h"
 
 namespace google_breakpad {
@@ -133,7 +135,10 @@ class ElfCoreDump {
   // Copies |length| bytes of data starting at |virtual_address| in the core
   // dump to |buffer|. |buffer| should be a valid pointer to a buffer of at
   // least |length| bytes. Returns true if the data to be copied is found in
-  // the core dump, or false otherwise.
+  // the core dump, or false otherwise. The first call indexes the PT_LOAD
+  // segments by address, so each call takes logarithmic time in their
+  // number, or constant time for an address in the segment last copied
+  // from.
   bool CopyData(void* buffer, Addr virtual_address, size_t length);
 
   // Returns the first note found in the note section of the core dump, or
@@ -147,8 +152,23 @@ class ElfCoreDump {
   // Core dump content.
   MemoryRange content_;
 
+  // Returns the PT_LOAD program header whose data in the core dump holds
+  // |virtual_address|, or NULL if there is none. Segments of a core dump
+  // do not overlap.
+  const Phdr* FindLoadSegment(Addr virtual_address);
+
   // Descriptor for /proc/<pid>/mem.
   int proc_mem_fd_;
+
+  // The PT_LOAD program headers with data in the core dump, sorted by
+  // virtual address, once |load_segments_indexed_| is set. SetContent()
+  // clears them.
+  std::vector<const Phdr*> load_segments_;
+  bool load_segments_indexed_;
+
+  // The index in |load_segments_| of the segment that FindLoadSegment()
+  // last found.
+  size_t last_load_segment_;
 };
 
 }  // namespace google_breakpad
@@ -36,6 +36,7 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "breakpad_googletest_includes.h"
 #include "common/linux/elf_core_dump.h"
@@ -130,6 +131,86 @@ TEST(ElfCoreDumpTest, TestElfHeader) {
   EXPECT_TRUE(core.IsValid());
 }
 
+// Builds a core dump in |core| with |count| PT_LOAD segments of 16 bytes,
+// listed out of address order, the |i|th at |base| + ((i * 7) % count)
+// pages and filled with |i|, and a PT_LOAD segment with no data at |base|
+// less a page.
+static void BuildCoreWithLoadSegments(unsigned count,
+                                      ElfCoreDump::Addr base,
+                                      std::vector<uint8_t>* core) {
+  const size_t kSegmentSize = 16;
+  const size_t kPageSize = 4096;
+  const size_t phoff = sizeof(ElfCoreDump::Ehdr);
+  const size_t data_offset = phoff + (count + 1) * sizeof(ElfCoreDump::Phdr);
+  core->assign(data_offset + count * kSegmentSize, 0);
+
+  ElfCoreDump::Ehdr header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.e_ident, ELFMAG, SELFMAG);
+  header.e_ident[EI_CLASS] = ElfCoreDump::kClass;
+  header.e_version = EV_CURRENT;
+  header.e_type = ET_CORE;
+  header.e_phoff = phoff;
+  header.e_phentsize = sizeof(ElfCoreDump::Phdr);
+  header.e_phnum = count + 1;
+  memcpy(&(*core)[0], &header, sizeof(header));
+
+  for (unsigned i = 0; i <= count; ++i) {
+    ElfCoreDump::Phdr program;
+    memset(&program, 0, sizeof(program));
+    program.p_type = PT_LOAD;
+    if (i < count) {
+      program.p_vaddr = base + ((i * 7) % count) * kPageSize;
+      program.p_offset = data_offset + i * kSegmentSize;
+      program.p_filesz = kSegmentSize;
+      memset(&(*core)[program.p_offset], i, kSegmentSize);
+    } else {
+      program.p_vaddr = base - kPageSize;
+    }
+    program.p_memsz = kPageSize;
+    memcpy(&(*core)[phoff + i * sizeof(program)], &program, sizeof(program));
+  }
+}
+
+TEST(ElfCoreDumpTest, CopyDataFromLoadSegments) {
+  const unsigned kSegments = 100;
+  const ElfCoreDump::Addr kBase = 0x100000;
+  const size_t kPageSize = 4096;
+  std::vector<uint8_t> data;
+  BuildCoreWithLoadSegments(kSegments, kBase, &data);
+
+  ElfCoreDump core;
+  core.SetContent(MemoryRange(&data[0], data.size()));
+  ASSERT_TRUE(core.IsValid());
+
+  // Each segment, twice in a row and in an order unlike the index's.
+  for (unsigned i = 0; i < kSegments; ++i) {
+    const ElfCoreDump::Addr address = kBase + ((i * 7) % kSegments) * kPageSize;
+    for (int repeat = 0; repeat < 2; ++repeat) {
+      uint8_t buffer[4];
+      ASSERT_TRUE(core.CopyData(buffer, address + 12, sizeof(buffer))) << i;
+      for (size_t j = 0; j < sizeof(buffer); ++j)
+        EXPECT_EQ(i, buffer[j]) << i;
+    }
+  }
+
+  uint8_t byte;
+  // Past the data of a segment, before the first and after the last.
+  EXPECT_FALSE(core.CopyData(&byte, kBase + 16, 1));
+  EXPECT_FALSE(core.CopyData(&byte, kBase - 1, 1));
+  EXPECT_FALSE(core.CopyData(&byte, kBase + kSegments * kPageSize, 1));
+  // In a segment that has no data.
+  EXPECT_FALSE(core.CopyData(&byte, kBase - kPageSize, 1));
+
+  // New content is indexed afresh.
+  std::vector<uint8_t> other_data;
+  BuildCoreWithLoadSegments(2, kBase + kPageSize / 2, &other_data);
+  core.SetContent(MemoryRange(&other_data[0], other_data.size()));
+  EXPECT_FALSE(core.CopyData(&byte, kBase, 1));
+  ASSERT_TRUE(core.CopyData(&byte, kBase + kPageSize * 3 / 2, 1));
+  EXPECT_EQ(1, byte);
+}
+
 TEST(ElfCoreDumpTest, ValidCoreFile) {
   CrashGenerator crash_generator;
   if (!crash_generator.HasDefaultCorePattern()) {
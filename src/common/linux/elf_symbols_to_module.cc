@@ -36,14 +36,19 @@
 
 #include "common/linux/elf_symbols_to_module.h"
 
-#include <cxxabi.h>
 #include <elf.h>
 #include <string.h>
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <thread>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "common/byte_cursor.h"
+#include "common/language.h"
 #include "common/module.h"
 
 namespace google_breakpad {
@@ -147,7 +152,8 @@ bool ELFSymbolsToModule(const uint8_t* symtab_section,
                         size_t string_size,
                         const bool big_endian,
                         size_t value_size,
-                        Module* module) {
+                        Module* module,
+                        int num_threads) {
   ByteBuffer symbols(symtab_section, symtab_size);
   // Ensure that the string section is null-terminated.
   if (string_section[string_size - 1] != '\0') {
@@ -160,25 +166,63 @@ bool ELFSymbolsToModule(const uint8_t* symtab_section,
   // The iterator walking the symbol table.
   ELFSymbolIterator iterator(&symbols, big_endian, value_size);
 
+  // Collect the function symbols first, so that their names can be
+  // demangled on several threads.
+  struct FunctionSymbol {
+    uint64_t address;
+    const char* name;
+    // False if an earlier symbol has the same address. The module keeps
+    // only the first extern at an address, so this one needs no name.
+    bool first;
+    string demangled;
+    bool is_demangled;
+  };
+  std::vector<FunctionSymbol> functions;
+  std::unordered_set<uint64_t> addresses;
   while(!iterator->at_end) {
     if (ELF32_ST_TYPE(iterator->info) == STT_FUNC &&
         iterator->shndx != SHN_UNDEF) {
-      auto ext = std::make_unique<Module::Extern>(iterator->value);
-      ext->name = SymbolString(iterator->name_offset, strings);
-#if !defined(__ANDROID__)  // Android NDK doesn't provide abi::__cxa_demangle.
-      int status = 0;
-      char* demangled =
-          abi::__cxa_demangle(ext->name.c_str(), NULL, NULL, &status);
-      if (demangled) {
-        if (status == 0)
-          ext->name = demangled;
-        free(demangled);
-      }
-#endif
-      module->AddExtern(std::move(ext));
+      bool first = addresses.insert(iterator->value).second;
+      functions.push_back({iterator->value,
+                           SymbolString(iterator->name_offset, strings),
+                           first, string(), false});
     }
     ++iterator;
   }
+
+  std::atomic<size_t> next_function(0);
+  auto demangle_functions = [&]() {
+    for (size_t i = next_function++; i < functions.size();
+         i = next_function++) {
+      FunctionSymbol& function = functions[i];
+      if (function.first) {
+        function.is_demangled =
+            Language::DemangleSymbolCached(function.name, &function.demangled);
+      }
+    }
+  };
+  size_t thread_count = std::min(static_cast<size_t>(std::max(num_threads, 1)),
+                                 addresses.size());
+  if (thread_count <= 1) {
+    demangle_functions();
+  } else {
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < thread_count; ++i)
+      threads.emplace_back(demangle_functions);
+    for (std::thread& thread : threads)
+      thread.join();
+  }
+
+  // Add the externs in symbol table order, so that the module resolves
+  // symbols sharing an address as it always has.
+  for (const FunctionSymbol& function : functions) {
+    auto ext = std::make_unique<Module::Extern>(function.address);
+    if (function.first) {
+      ext->name = module->AddStringToPool(
+          function.is_demangled ? function.demangled : string(function.name));
+    }
+    module->AddExtern(std::move(ext));
+  }
   return true;
 }
 
@@ -44,13 +44,18 @@ namespace google_breakpad {
 
 class Module;
 
+// Add an Extern to MODULE for each function symbol in the symbol table
+// SYMTAB_SECTION, whose names are in STRING_SECTION. Names are demangled
+// on up to NUM_THREADS threads; the externs are added in table order
+// either way.
 bool ELFSymbolsToModule(const uint8_t* symtab_section,
                         size_t symtab_size,
                         const uint8_t* string_section,
                         size_t string_size,
                         const bool big_endian,
                         size_t value_size,
-                        Module* module);
+                        Module* module,
+                        int num_threads = 1);
 
 }  // namespace google_breakpad
 
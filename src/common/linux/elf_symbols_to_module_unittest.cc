@@ -41,12 +41,14 @@
 #include <vector>
 
 #include "breakpad_googletest_includes.h"
+#include "common/language.h"
 #include "common/linux/elf_symbols_to_module.h"
 #include "common/linux/synth_elf.h"
 #include "common/module.h"
 #include "common/test_assembler.h"
 #include "common/using_std_string.h"
 
+using google_breakpad::Language;
 using google_breakpad::Module;
 using google_breakpad::synth_elf::StringTable;
 using google_breakpad::test_assembler::Endianness;
@@ -64,7 +66,8 @@ public:
                                 size_t value_size) : module("a", "b", "c", "d"),
                                                      section(endianness),
                                                      table(endianness),
-                                                     value_size(value_size) {}
+                                                     value_size(value_size),
+                                                     num_threads(1) {}
 
   bool ProcessSection() {
     string section_contents, table_contents;
@@ -77,7 +80,8 @@ public:
                                   table_contents.size(),
                                   section.endianness() == kBigEndian,
                                   value_size,
-                                  &module);
+                                  &module,
+                                  num_threads);
     module.GetExterns(&externs, externs.end());
     return ret;
   }
@@ -88,6 +92,7 @@ public:
   string section_contents;
   // 4 or 8 (bytes)
   size_t value_size;
+  int num_threads;
 
   vector<Module::Extern*> externs;
 };
@@ -130,6 +135,8 @@ TEST_P(ELFSymbolsToModuleTest32, OneFunc) {
   ASSERT_EQ((size_t)1, externs.size());
   Module::Extern *extern1 = externs[0];
   EXPECT_EQ(kFuncName, extern1->name);
+  // The name lives in the module's string pool, not the symbol table.
+  EXPECT_EQ(module.AddStringToPool(kFuncName).data(), extern1->name.data());
   EXPECT_EQ((Module::Address)kFuncAddr, extern1->address);
 }
 
@@ -367,6 +374,57 @@ TEST_P(ELFSymbolsToModuleTest64, SkipStuff) {
   EXPECT_EQ((Module::Address)kFuncAddr, extern1->address);
 }
 
+TEST_P(ELFSymbolsToModuleTest64, DemangledFuncs) {
+  // The same mangled name twice, as with local copies of an inline
+  // function; the second should come from the demangling cache.
+  AddElf64Sym("_ZN9superfunc4callEi", 0x1000, 0x10,
+              ELF64_ST_INFO(STB_LOCAL, STT_FUNC),
+              SHN_UNDEF + 1);
+  AddElf64Sym("_ZN9superfunc4callEi", 0x2000, 0x10,
+              ELF64_ST_INFO(STB_LOCAL, STT_FUNC),
+              SHN_UNDEF + 1);
+  AddElf64Sym("_Znotmangled", 0x3000, 0x10,
+              ELF64_ST_INFO(STB_GLOBAL, STT_FUNC),
+              SHN_UNDEF + 1);
+
+  uint64_t lookups_before, hits_before;
+  Language::GetDemangleCacheStats(&lookups_before, &hits_before);
+  ProcessSection();
+  uint64_t lookups_after, hits_after;
+  Language::GetDemangleCacheStats(&lookups_after, &hits_after);
+
+  ASSERT_EQ((size_t)3, externs.size());
+  EXPECT_EQ("superfunc::call(int)", externs[0]->name);
+  EXPECT_EQ("superfunc::call(int)", externs[1]->name);
+  EXPECT_EQ(externs[0]->name.data(), externs[1]->name.data());
+  EXPECT_EQ("_Znotmangled", externs[2]->name);
+  EXPECT_EQ(3U, lookups_after - lookups_before);
+  EXPECT_LE(1U, hits_after - hits_before);
+}
+
+TEST_P(ELFSymbolsToModuleTest64, ThreadedFuncs) {
+  const int kFuncCount = 100;
+  for (int i = 0; i < kFuncCount; ++i) {
+    string name = "func" + std::to_string(i);
+    AddElf64Sym("_Z" + std::to_string(name.size()) + name + "v",
+                0x1000 + i * 0x10, 0x10,
+                ELF64_ST_INFO(STB_LOCAL, STT_FUNC), SHN_UNDEF + 1);
+  }
+  // An alias of the first function; the first name at an address wins.
+  AddElf64Sym("_ZN8megafunc4callEv", 0x1000, 0x10,
+              ELF64_ST_INFO(STB_GLOBAL, STT_FUNC),
+              SHN_UNDEF + 1);
+
+  num_threads = 4;
+  ProcessSection();
+
+  ASSERT_EQ((size_t)kFuncCount, externs.size());
+  for (int i = 0; i < kFuncCount; ++i) {
+    EXPECT_EQ((Module::Address)(0x1000 + i * 0x10), externs[i]->address);
+    EXPECT_EQ("func" + std::to_string(i) + "()", externs[i]->name);
+  }
+}
+
 // Run all the 64-bit tests with both endianness
 INSTANTIATE_TEST_SUITE_P(Endian,
                          ELFSymbolsToModuleTest64,
@@ -71,17 +71,26 @@ static bool ElfClassBuildIDNoteIdentifier(const void* section, size_t length,
                 "Elf32_Nhdr and Elf64_Nhdr should be the same");
   typedef typename ElfClass32::Nhdr Nhdr;
 
-  const void* section_end = reinterpret_cast<const char*>(section) + length;
+  // Notes may come from a process's memory, so check that each one lies
+  // within |length| bytes.
+  const char* section_end = reinterpret_cast<const char*>(section) + length;
   const Nhdr* note_header = reinterpret_cast<const Nhdr*>(section);
-  while (reinterpret_cast<const void*>(note_header) < section_end) {
+  while (section_end - reinterpret_cast<const char*>(note_header) >=
+         static_cast<ptrdiff_t>(sizeof(Nhdr))) {
+    const size_t note_size = sizeof(Nhdr) +
+        NOTE_PADDING(static_cast<size_t>(note_header->n_namesz)) +
+        NOTE_PADDING(static_cast<size_t>(note_header->n_descsz));
+    if (note_size > static_cast<size_t>(
+            section_end - reinterpret_cast<const char*>(note_header))) {
+      return false;
+    }
     if (note_header->n_type == NT_GNU_BUILD_ID)
       break;
     note_header = reinterpret_cast<const Nhdr*>(
-                  reinterpret_cast<const char*>(note_header) + sizeof(Nhdr) +
-                  NOTE_PADDING(note_header->n_namesz) +
-                  NOTE_PADDING(note_header->n_descsz));
+                  reinterpret_cast<const char*>(note_header) + note_size);
   }
-  if (reinterpret_cast<const void*>(note_header) >= section_end ||
+  if (section_end - reinterpret_cast<const char*>(note_header) <
+          static_cast<ptrdiff_t>(sizeof(Nhdr)) ||
       note_header->n_descsz == 0) {
     return false;
   }
@@ -160,6 +169,18 @@ bool FileID::ElfFileIdentifierFromMappedFile(const void* base,
   return HashElfTextSection(base, identifier);
 }
 
+// static
+bool FileID::ElfBuildIdFromMappedFile(const void* base,
+                                      wasteful_vector<uint8_t>& build_id) {
+  return FindElfBuildIDNote(base, build_id);
+}
+
+// static
+bool FileID::ElfBuildIdFromNotes(const void* notes, size_t length,
+                                 wasteful_vector<uint8_t>& build_id) {
+  return ElfClassBuildIDNoteIdentifier(notes, length, build_id);
+}
+
 bool FileID::ElfFileIdentifier(wasteful_vector<uint8_t>& identifier) {
   MemoryMappedFile mapped_file(path_.c_str(), 0);
   if (!mapped_file.data())  // Should probably check if size >= ElfW(Ehdr)?
@@ -68,6 +68,18 @@ class FileID {
       const void* base,
       wasteful_vector<uint8_t>& identifier);
 
+  // Load only the NT_GNU_BUILD_ID note of the elf file mapped into memory at
+  // |base| into |build_id|, without the .text hash fallback. Return false if
+  // the file has no build id note.
+  static bool ElfBuildIdFromMappedFile(const void* base,
+                                       wasteful_vector<uint8_t>& build_id);
+
+  // Load the NT_GNU_BUILD_ID note among the |length| bytes of ELF notes at
+  // |notes|, such as the contents of a PT_NOTE segment, into |build_id|.
+  // Return false if there is no such note.
+  static bool ElfBuildIdFromNotes(const void* notes, size_t length,
+                                  wasteful_vector<uint8_t>& build_id);
+
   // Convert the |identifier| data to a string.  The string will
   // be formatted as a UUID in all uppercase without dashes.
   // (e.g., 22F065BBFC9C49F780FE26A7CEBD7BCE).
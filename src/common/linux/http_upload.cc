@@ -34,10 +34,27 @@
 
 #include <assert.h>
 #include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <vector>
+
+#if defined(HAVE_LIBZ)
+#include <zlib.h>
+#endif
+
 #include "third_party/curl/curl.h"
 
 namespace {
 
+using std::map;
+using std::vector;
+
 // Callback to get the response data from server.
 static size_t WriteCallback(void* ptr, size_t size,
                             size_t nmemb, void* userp) {
@@ -50,6 +67,287 @@ static size_t WriteCallback(void* ptr, size_t size,
   return real_size;
 }
 
+// Size of the chunks in which files are read, and in which the body is fed
+// to the compressor.
+const size_t kChunkSize = 64 * 1024;
+
+// A multipart/form-data request body holding a set of string parameters
+// and files, produced a piece at a time as libcurl asks for it. Files are
+// only read as their part of the body is sent, so memory use doesn't
+// depend on their size.
+class MultipartBody {
+ public:
+  MultipartBody() : failed_(false), deflate_(false) {}
+  ~MultipartBody();
+
+  // Lays out the body. Returns false, with a description of the error in
+  // |error|, if a file can't be opened.
+  bool Init(const map<string, string>& parameters,
+            const map<string, string>& files,
+            bool deflate,
+            string* error);
+
+  // Whether the body is compressed, which is only possible with zlib.
+  bool deflating() const { return deflate_; }
+
+  // The length of the uncompressed body.
+  curl_off_t length() const { return length_; }
+
+  const string& boundary() const { return boundary_; }
+
+  // libcurl read and seek callbacks, taking the MultipartBody as |userp|.
+  static size_t ReadCallback(char* buffer, size_t size, size_t nitems,
+                             void* userp);
+  static int SeekCallback(void* userp, curl_off_t offset, int origin);
+
+ private:
+  // A piece of the body: either |text|, or the first |file_size| bytes of
+  // the file open as |fd|.
+  struct Segment {
+    Segment() : fd(-1), file_size(0) {}
+    string text;
+    int fd;
+    off_t file_size;
+  };
+
+  void AddText(const string& text);
+
+  // Copies up to |length| bytes of the body after those already read to
+  // |buffer|, returning how many were copied, or 0 at the end of the body
+  // or on failure.
+  size_t ReadRaw(char* buffer, size_t length);
+
+  // As ReadRaw, but the bytes are compressed.
+  size_t ReadDeflated(char* buffer, size_t length);
+
+  // Starts reading the body from the beginning again.
+  bool Rewind();
+
+  vector<Segment> segments_;
+  string boundary_;
+  curl_off_t length_;
+
+  // The segment being read, and the offset of the next byte in it.
+  size_t segment_;
+  off_t offset_;
+
+  // Whether reading failed, which aborts the request.
+  bool failed_;
+
+  bool deflate_;
+#if defined(HAVE_LIBZ)
+  z_stream stream_;
+  bool raw_done_;
+  bool deflate_done_;
+  vector<char> raw_buffer_;
+#endif
+
+  MultipartBody(const MultipartBody&);
+  void operator=(const MultipartBody&);
+};
+
+MultipartBody::~MultipartBody() {
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    if (segments_[i].fd >= 0)
+      close(segments_[i].fd);
+  }
+#if defined(HAVE_LIBZ)
+  if (deflate_)
+    deflateEnd(&stream_);
+#endif
+}
+
+void MultipartBody::AddText(const string& text) {
+  if (segments_.empty() || segments_.back().fd >= 0)
+    segments_.push_back(Segment());
+  segments_.back().text.append(text);
+}
+
+bool MultipartBody::Init(const map<string, string>& parameters,
+                         const map<string, string>& files,
+                         bool deflate,
+                         string* error) {
+  // The boundary must not appear in the body, so make it unpredictable.
+  unsigned char random[12];
+  int random_fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+  if (random_fd < 0 ||
+      read(random_fd, random, sizeof(random)) !=
+          static_cast<ssize_t>(sizeof(random))) {
+    unsigned int seed = static_cast<unsigned int>(time(NULL)) ^ getpid();
+    for (size_t i = 0; i < sizeof(random); ++i)
+      random[i] = static_cast<unsigned char>(rand_r(&seed));
+  }
+  if (random_fd >= 0)
+    close(random_fd);
+  boundary_ = "------------------------BreakpadFormBoundary";
+  for (size_t i = 0; i < sizeof(random); ++i) {
+    char hex[3];
+    snprintf(hex, sizeof(hex), "%02x", random[i]);
+    boundary_.append(hex);
+  }
+
+  map<string, string>::const_iterator iter;
+  for (iter = parameters.begin(); iter != parameters.end(); ++iter) {
+    AddText("--" + boundary_ + "\r\n"
+            "Content-Disposition: form-data; name=\"" + iter->first +
+            "\"\r\n\r\n" + iter->second + "\r\n");
+  }
+
+  for (iter = files.begin(); iter != files.end(); ++iter) {
+    const string& path = iter->second;
+    Segment file;
+    file.fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (file.fd < 0 || fstat(file.fd, &st) != 0) {
+      if (file.fd >= 0)
+        close(file.fd);
+      if (error)
+        *error = "Failed to open " + path + ": " + strerror(errno);
+      return false;
+    }
+    file.file_size = st.st_size;
+
+    string::size_type slash = path.rfind('/');
+    string basename = slash == string::npos ? path : path.substr(slash + 1);
+    AddText("--" + boundary_ + "\r\n"
+            "Content-Disposition: form-data; name=\"" + iter->first +
+            "\"; filename=\"" + basename + "\"\r\n"
+            "Content-Type: application/octet-stream\r\n\r\n");
+    segments_.push_back(file);
+    AddText("\r\n");
+  }
+  AddText("--" + boundary_ + "--\r\n");
+
+  length_ = 0;
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    length_ += segments_[i].fd >= 0 ? segments_[i].file_size :
+                                      segments_[i].text.size();
+  }
+  segment_ = 0;
+  offset_ = 0;
+
+#if defined(HAVE_LIBZ)
+  if (deflate) {
+    memset(&stream_, 0, sizeof(stream_));
+    // Z_BEST_SPEED, as for the Windows uploader: it compresses symbol files
+    // and minidumps nearly as well as the default level, in a third of the
+    // time.
+    deflate_ = deflateInit(&stream_, Z_BEST_SPEED) == Z_OK;
+    raw_done_ = false;
+    deflate_done_ = false;
+    raw_buffer_.resize(kChunkSize);
+  }
+#else
+  (void)deflate;
+#endif
+  return true;
+}
+
+size_t MultipartBody::ReadRaw(char* buffer, size_t length) {
+  size_t copied = 0;
+  while (copied < length && segment_ < segments_.size()) {
+    const Segment& segment = segments_[segment_];
+    size_t wanted = length - copied;
+    if (segment.fd < 0) {
+      size_t available = segment.text.size() - offset_;
+      size_t count = wanted < available ? wanted : available;
+      memcpy(buffer + copied, segment.text.data() + offset_, count);
+      copied += count;
+      offset_ += count;
+      if (static_cast<size_t>(offset_) == segment.text.size()) {
+        ++segment_;
+        offset_ = 0;
+      }
+    } else {
+      off_t available = segment.file_size - offset_;
+      size_t count = static_cast<off_t>(wanted) < available ?
+          wanted : static_cast<size_t>(available);
+      ssize_t bytes_read = count ?
+          pread(segment.fd, buffer + copied, count, offset_) : 0;
+      if (bytes_read < 0 && errno == EINTR)
+        continue;
+      if (bytes_read < 0 || (count && bytes_read == 0)) {
+        // The file shrank, or can't be read; the body can't be completed.
+        failed_ = true;
+        return 0;
+      }
+      copied += bytes_read;
+      offset_ += bytes_read;
+      if (offset_ == segment.file_size) {
+        ++segment_;
+        offset_ = 0;
+      }
+    }
+  }
+  return copied;
+}
+
+size_t MultipartBody::ReadDeflated(char* buffer, size_t length) {
+#if defined(HAVE_LIBZ)
+  stream_.next_out = reinterpret_cast<Bytef*>(buffer);
+  stream_.avail_out = length;
+  while (stream_.avail_out > 0 && !deflate_done_) {
+    if (stream_.avail_in == 0 && !raw_done_) {
+      size_t raw_length = ReadRaw(&raw_buffer_[0], raw_buffer_.size());
+      if (failed_)
+        return 0;
+      raw_done_ = raw_length == 0;
+      stream_.next_in = reinterpret_cast<Bytef*>(&raw_buffer_[0]);
+      stream_.avail_in = raw_length;
+    }
+    int result = deflate(&stream_, raw_done_ ? Z_FINISH : Z_NO_FLUSH);
+    if (result == Z_STREAM_END) {
+      deflate_done_ = true;
+    } else if (result != Z_OK && result != Z_BUF_ERROR) {
+      fprintf(stderr, "Compression failed with zlib error %d\n", result);
+      failed_ = true;
+      return 0;
+    }
+  }
+  return length - stream_.avail_out;
+#else
+  (void)buffer;
+  (void)length;
+  return 0;
+#endif
+}
+
+bool MultipartBody::Rewind() {
+  segment_ = 0;
+  offset_ = 0;
+  failed_ = false;
+#if defined(HAVE_LIBZ)
+  if (deflate_) {
+    if (deflateReset(&stream_) != Z_OK)
+      return false;
+    stream_.avail_in = 0;
+    raw_done_ = false;
+    deflate_done_ = false;
+  }
+#endif
+  return true;
+}
+
+// static
+size_t MultipartBody::ReadCallback(char* buffer, size_t size, size_t nitems,
+                                   void* userp) {
+  MultipartBody* body = reinterpret_cast<MultipartBody*>(userp);
+  size_t length = size * nitems;
+  size_t count = body->deflate_ ? body->ReadDeflated(buffer, length) :
+                                  body->ReadRaw(buffer, length);
+  return body->failed_ ? CURL_READFUNC_ABORT : count;
+}
+
+// static
+int MultipartBody::SeekCallback(void* userp, curl_off_t offset, int origin) {
+  // libcurl only seeks to resend the body from the start, say after a
+  // redirect or an authentication challenge.
+  MultipartBody* body = reinterpret_cast<MultipartBody*>(userp);
+  if (offset != 0 || origin != SEEK_SET)
+    return CURL_SEEKFUNC_CANTSEEK;
+  return body->Rewind() ? CURL_SEEKFUNC_OK : CURL_SEEKFUNC_FAIL;
+}
+
 }  // namespace
 
 namespace google_breakpad {
@@ -66,12 +364,32 @@ bool HTTPUpload::SendRequest(const string& url,
                              string* response_body,
                              long* response_code,
                              string* error_description) {
+  return SendRequest(url, parameters, files, proxy, proxy_user_pwd,
+                     ca_certificate_file, /*deflate_body=*/false,
+                     response_body, response_code, error_description);
+}
+
+// static
+bool HTTPUpload::SendRequest(const string& url,
+                             const map<string, string>& parameters,
+                             const map<string, string>& files,
+                             const string& proxy,
+                             const string& proxy_user_pwd,
+                             const string& ca_certificate_file,
+                             bool deflate_body,
+                             string* response_body,
+                             long* response_code,
+                             string* error_description) {
   if (response_code != NULL)
     *response_code = 0;
 
   if (!CheckParameters(parameters))
     return false;
 
+  MultipartBody body;
+  if (!body.Init(parameters, files, deflate_body, error_description))
+    return false;
+
   // We may have been linked statically; if curl_easy_init is in the
   // current binary, no need to search for a dynamic version.
   void* curl_lib = dlopen(NULL, RTLD_NOW);
@@ -131,33 +449,29 @@ bool HTTPUpload::SendRequest(const string& url,
   if (!ca_certificate_file.empty())
     (*curl_easy_setopt)(curl, CURLOPT_CAINFO, ca_certificate_file.c_str());
 
-  struct curl_httppost* formpost = NULL;
-  struct curl_httppost* lastptr = NULL;
-  // Add form data.
-  CURLFORMcode (*curl_formadd)(struct curl_httppost**, struct curl_httppost**, ...);
-  *(void**) (&curl_formadd) = dlsym(curl_lib, "curl_formadd");
-  map<string, string>::const_iterator iter = parameters.begin();
-  for (; iter != parameters.end(); ++iter)
-    (*curl_formadd)(&formpost, &lastptr,
-                 CURLFORM_COPYNAME, iter->first.c_str(),
-                 CURLFORM_COPYCONTENTS, iter->second.c_str(),
-                 CURLFORM_END);
-
-  // Add form files.
-  for (iter = files.begin(); iter != files.end(); ++iter) {
-    (*curl_formadd)(&formpost, &lastptr,
-                 CURLFORM_COPYNAME, iter->first.c_str(),
-                 CURLFORM_FILE, iter->second.c_str(),
-                 CURLFORM_END);
+  // Stream the body from |body|. Compressed, its length isn't known up
+  // front, so it's sent in chunks.
+  (*curl_easy_setopt)(curl, CURLOPT_POST, 1L);
+  (*curl_easy_setopt)(curl, CURLOPT_READFUNCTION, MultipartBody::ReadCallback);
+  (*curl_easy_setopt)(curl, CURLOPT_READDATA, &body);
+  (*curl_easy_setopt)(curl, CURLOPT_SEEKFUNCTION, MultipartBody::SeekCallback);
+  (*curl_easy_setopt)(curl, CURLOPT_SEEKDATA, &body);
+  if (!body.deflating()) {
+    (*curl_easy_setopt)(curl, CURLOPT_POSTFIELDSIZE_LARGE, body.length());
   }
 
-  (*curl_easy_setopt)(curl, CURLOPT_HTTPPOST, formpost);
-
-  // Disable 100-continue header.
   struct curl_slist* headerlist = NULL;
-  char buf[] = "Expect:";
   struct curl_slist* (*curl_slist_append)(struct curl_slist*, const char*);
   *(void**) (&curl_slist_append) = dlsym(curl_lib, "curl_slist_append");
+  string content_type =
+      "Content-Type: multipart/form-data; boundary=" + body.boundary();
+  headerlist = (*curl_slist_append)(headerlist, content_type.c_str());
+  if (body.deflating()) {
+    headerlist = (*curl_slist_append)(headerlist, "Content-Encoding: deflate");
+    headerlist = (*curl_slist_append)(headerlist, "Transfer-Encoding: chunked");
+  }
+  // Disable 100-continue header.
+  char buf[] = "Expect:";
   headerlist = (*curl_slist_append)(headerlist, buf);
   (*curl_easy_setopt)(curl, CURLOPT_HTTPHEADER, headerlist);
 
@@ -192,11 +506,6 @@ bool HTTPUpload::SendRequest(const string& url,
   void (*curl_easy_cleanup)(CURL*);
   *(void**) (&curl_easy_cleanup) = dlsym(curl_lib, "curl_easy_cleanup");
   (*curl_easy_cleanup)(curl);
-  if (formpost != NULL) {
-    void (*curl_formfree)(struct curl_httppost*);
-    *(void**) (&curl_formfree) = dlsym(curl_lib, "curl_formfree");
-    (*curl_formfree)(formpost);
-  }
   if (headerlist != NULL) {
     void (*curl_slist_free_all)(struct curl_slist*);
     *(void**) (&curl_slist_free_all) = dlsym(curl_lib, "curl_slist_free_all");
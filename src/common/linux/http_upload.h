@@ -57,6 +57,8 @@ class HTTPUpload {
   // received (or 0 if the request failed before getting an HTTP response).
   // If the send fails, a description of the error will be
   // returned in error_description.
+  // The request body is streamed, with each file read a chunk at a time as
+  // it is sent, so memory use doesn't grow with the size of the files.
   static bool SendRequest(const string& url,
                           const map<string, string>& parameters,
                           const map<string, string>& files,
@@ -67,6 +69,21 @@ class HTTPUpload {
                           long* response_code,
                           string* error_description);
 
+  // As above, but if |deflate_body| is true and zlib support is available
+  // at build time, the body is compressed with the deflate algorithm as it
+  // is sent, with "Content-Encoding: deflate". The server must accept that
+  // encoding.
+  static bool SendRequest(const string& url,
+                          const map<string, string>& parameters,
+                          const map<string, string>& files,
+                          const string& proxy,
+                          const string& proxy_user_pwd,
+                          const string& ca_certificate_file,
+                          bool deflate_body,
+                          string* response_body,
+                          long* response_code,
+                          string* error_description);
+
  private:
   // Checks that the given list of parameters has only printable
   // ASCII characters in the parameter name, and does not contain
@@ -31,14 +31,35 @@
 #endif
 
 #include <dlfcn.h>
+#include <stdio.h>
+#include <sys/stat.h>
 
+#include <algorithm>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "common/linux/libcurl_wrapper.h"
 #include "common/using_std_string.h"
 
 namespace google_breakpad {
+
+namespace {
+
+// Options and values newer than the bundled curl headers (7.19.7). They're
+// passed to whatever libcurl is found at runtime, which ignores those it
+// doesn't know.
+const CURLoption kCurlOptTcpKeepAlive =
+    static_cast<CURLoption>(CURLOPTTYPE_LONG + 213);  // 7.25.0
+const long kCurlHttpVersion2Tls = 4;                  // 7.47.0
+const long kCurlPipeMultiplex = 2;                    // 7.43.0
+const int kCurlLockDataConnect = CURL_LOCK_DATA_CONNECT;  // Shared in 7.57.0
+
+// How long to wait for activity on uploads in SendPutRequests, in ms.
+const int kMultiWaitTimeoutMs = 1000;
+
+}  // namespace
+
 LibcurlWrapper::LibcurlWrapper()
     : init_ok_(false),
       curl_lib_(nullptr),
@@ -46,11 +67,26 @@ LibcurlWrapper::LibcurlWrapper()
       curl_(nullptr),
       formpost_(nullptr),
       lastptr_(nullptr),
-      headerlist_(nullptr) {}
+      headerlist_(nullptr),
+      session_(false),
+      has_session_connection_(false),
+      max_pipeline_depth_(1),
+      share_(nullptr),
+      multi_(nullptr),
+      put_headerlist_(nullptr) {}
 
 LibcurlWrapper::~LibcurlWrapper() {
   if (init_ok_) {
+    for (size_t i = 0; i < put_handles_.size(); ++i)
+      (*easy_cleanup_)(put_handles_[i]);
+    if (multi_ != nullptr)
+      (*multi_cleanup_)(multi_);
+    if (put_headerlist_ != nullptr)
+      (*slist_free_all_)(put_headerlist_);
     (*easy_cleanup_)(curl_);
+    // The share handle must outlive the easy handles that use it.
+    if (share_ != nullptr)
+      (*share_cleanup_)(share_);
     (*global_cleanup_)();
     dlclose(curl_lib_);
   }
@@ -176,6 +212,201 @@ bool LibcurlWrapper::SendSimplePostRequest(const string& url,
                           http_response_data);
 }
 
+bool LibcurlWrapper::EnablePersistentSession(int max_pipeline_depth) {
+  if (!CheckInit()) return false;
+
+  max_pipeline_depth_ = max_pipeline_depth > 0 ? max_pipeline_depth : 1;
+  if (session_)
+    return true;
+
+  if (!SetMultiFunctionPointers()) {
+    std::cout << "libcurl lacks the multi interface; requests will reuse "
+                 "connections but not be pipelined.\n";
+  }
+
+  share_init_ = reinterpret_cast<CURLSH* (*)(void)>(
+      dlsym(curl_lib_, "curl_share_init"));
+  share_setopt_ = reinterpret_cast<CURLSHcode (*)(CURLSH*, CURLSHoption, ...)>(
+      dlsym(curl_lib_, "curl_share_setopt"));
+  share_cleanup_ = reinterpret_cast<CURLSHcode (*)(CURLSH*)>(
+      dlsym(curl_lib_, "curl_share_cleanup"));
+  if (share_init_ && share_setopt_ && share_cleanup_) {
+    // Share state between |curl_| and the handles of SendPutRequests, so
+    // that whichever makes a request can reuse the others' connections, or
+    // at least resume their TLS sessions. No lock functions are needed, as
+    // this class is single-threaded.
+    share_ = (*share_init_)();
+    if (share_ != nullptr) {
+      (*share_setopt_)(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+      (*share_setopt_)(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+      (*share_setopt_)(share_, CURLSHOPT_SHARE, kCurlLockDataConnect);
+    }
+  }
+
+  if (multi_init_ != nullptr) {
+    multi_ = (*multi_init_)();
+    if (multi_ != nullptr) {
+      (*multi_setopt_)(multi_, CURLMOPT_PIPELINING, kCurlPipeMultiplex);
+    }
+  }
+
+  session_ = true;
+  ApplySessionOptions(curl_);
+  return true;
+}
+
+void LibcurlWrapper::ApplySessionOptions(CURL* handle) {
+  (*easy_setopt_)(handle, CURLOPT_HTTP_VERSION, kCurlHttpVersion2Tls);
+  (*easy_setopt_)(handle, kCurlOptTcpKeepAlive, 1L);
+  if (share_ != nullptr)
+    (*easy_setopt_)(handle, CURLOPT_SHARE, share_);
+}
+
+bool LibcurlWrapper::SendPutRequests(std::vector<PutRequest>* requests) {
+  if (!CheckInit()) return false;
+
+  bool success = true;
+  if (multi_ == nullptr) {
+    for (size_t i = 0; i < requests->size(); ++i) {
+      PutRequest& request = (*requests)[i];
+      request.success = SendPutRequest(request.url, request.path,
+                                       &request.http_status_code,
+                                       nullptr, nullptr);
+      success = success && request.success;
+    }
+    return success;
+  }
+
+  if (put_headerlist_ == nullptr) {
+    // Disable 100-continue header.
+    put_headerlist_ = (*slist_append_)(put_headerlist_, "Expect:");
+  }
+
+  // An upload in flight.
+  struct Transfer {
+    CURL* handle;
+    FILE* file;
+    size_t request;
+    string response;
+  };
+  while (put_handles_.size() < static_cast<size_t>(max_pipeline_depth_)) {
+    CURL* handle = (*easy_init_)();
+    if (handle == nullptr)
+      break;
+    put_handles_.push_back(handle);
+  }
+  if (put_handles_.empty())
+    return false;
+  std::vector<Transfer> transfers(
+      std::min(put_handles_.size(),
+               static_cast<size_t>(max_pipeline_depth_)));
+  std::vector<size_t> idle;  // Indices of |transfers| not in flight.
+  for (size_t i = transfers.size(); i > 0; --i) {
+    transfers[i - 1].handle = put_handles_[i - 1];
+    transfers[i - 1].file = nullptr;
+    idle.push_back(i - 1);
+  }
+
+  // The first upload goes alone, unless there's a connection from earlier
+  // requests, so that the others find its connection in the cache, know
+  // whether it multiplexes, and use it rather than each opening their own.
+  size_t depth = has_session_connection_ ? transfers.size() : 1;
+  size_t next_request = 0;
+  size_t in_flight = 0;
+  while (next_request < requests->size() || in_flight > 0) {
+    // Start as many uploads as the pipeline depth allows.
+    while (next_request < requests->size() && in_flight < depth &&
+           !idle.empty()) {
+      PutRequest& request = (*requests)[next_request];
+      request.success = false;
+      request.http_status_code = 0;
+      FILE* file = fopen(request.path.c_str(), "rb");
+      struct stat st;
+      if (file == nullptr || fstat(fileno(file), &st) != 0) {
+        fprintf(stderr, "Failed to open %s\n", request.path.c_str());
+        if (file != nullptr)
+          fclose(file);
+        success = false;
+        ++next_request;
+        continue;
+      }
+
+      Transfer& transfer = transfers[idle.back()];
+      idle.pop_back();
+      transfer.file = file;
+      transfer.request = next_request++;
+      transfer.response.clear();
+
+      (*easy_reset_)(transfer.handle);
+      ApplySessionOptions(transfer.handle);
+      (*easy_setopt_)(transfer.handle, CURLOPT_URL, request.url.c_str());
+      (*easy_setopt_)(transfer.handle, CURLOPT_UPLOAD, 1L);
+      (*easy_setopt_)(transfer.handle, CURLOPT_READDATA, file);
+      (*easy_setopt_)(transfer.handle, CURLOPT_INFILESIZE_LARGE,
+                      static_cast<curl_off_t>(st.st_size));
+      (*easy_setopt_)(transfer.handle, CURLOPT_HTTPHEADER, put_headerlist_);
+      (*easy_setopt_)(transfer.handle, CURLOPT_WRITEFUNCTION, WriteCallback);
+      (*easy_setopt_)(transfer.handle, CURLOPT_WRITEDATA,
+                      reinterpret_cast<void*>(&transfer.response));
+      (*easy_setopt_)(transfer.handle, CURLOPT_PRIVATE,
+                      reinterpret_cast<void*>(&transfer));
+      (*multi_add_handle_)(multi_, transfer.handle);
+      ++in_flight;
+    }
+    if (in_flight == 0)
+      break;
+
+    int running = 0;
+    if ((*multi_perform_)(multi_, &running) != CURLM_OK) {
+      std::cout << "curl_multi_perform failed";
+      break;
+    }
+
+    CURLMsg* message;
+    int queued;
+    bool finished = false;
+    while ((message = (*multi_info_read_)(multi_, &queued)) != nullptr) {
+      if (message->msg != CURLMSG_DONE)
+        continue;
+      Transfer* transfer = nullptr;
+      (*easy_getinfo_)(message->easy_handle, CURLINFO_PRIVATE,
+                       reinterpret_cast<char**>(&transfer));
+      PutRequest& request = (*requests)[transfer->request];
+      (*easy_getinfo_)(message->easy_handle, CURLINFO_RESPONSE_CODE,
+                       &request.http_status_code);
+      request.success = message->data.result == CURLE_OK;
+      if (!request.success) {
+        fprintf(stderr, "Failed to send http request to %s, error: %s\n",
+                request.url.c_str(),
+                (*easy_strerror_)(message->data.result));
+      }
+      success = success && request.success;
+
+      (*multi_remove_handle_)(multi_, message->easy_handle);
+      fclose(transfer->file);
+      transfer->file = nullptr;
+      idle.push_back(transfer - &transfers[0]);
+      --in_flight;
+      finished = true;
+      has_session_connection_ = true;
+      depth = transfers.size();
+    }
+
+    if (!finished && in_flight > 0)
+      (*multi_wait_)(multi_, nullptr, 0, kMultiWaitTimeoutMs, nullptr);
+  }
+
+  // Only reached with uploads in flight if the multi interface failed.
+  for (size_t i = 0; i < transfers.size(); ++i) {
+    if (transfers[i].file != nullptr) {
+      (*multi_remove_handle_)(multi_, transfers[i].handle);
+      fclose(transfers[i].file);
+      success = false;
+    }
+  }
+  return success;
+}
+
 bool LibcurlWrapper::Init() {
   // First check to see if libcurl was statically linked:
   curl_lib_ = dlopen(nullptr, RTLD_NOW);
@@ -271,6 +502,39 @@ bool LibcurlWrapper::SetFunctionPointers() {
   SET_AND_CHECK_FUNCTION_POINTER(global_cleanup_,
                                  "curl_global_cleanup",
                                  void(*)(void));
+
+  SET_AND_CHECK_FUNCTION_POINTER(easy_strerror_,
+                                 "curl_easy_strerror",
+                                 const char*(*)(CURLcode));
+  return true;
+}
+
+bool LibcurlWrapper::SetMultiFunctionPointers() {
+  multi_init_ = reinterpret_cast<CURLM* (*)(void)>(
+      dlsym(curl_lib_, "curl_multi_init"));
+  multi_setopt_ = reinterpret_cast<CURLMcode (*)(CURLM*, CURLMoption, ...)>(
+      dlsym(curl_lib_, "curl_multi_setopt"));
+  multi_add_handle_ = reinterpret_cast<CURLMcode (*)(CURLM*, CURL*)>(
+      dlsym(curl_lib_, "curl_multi_add_handle"));
+  multi_remove_handle_ = reinterpret_cast<CURLMcode (*)(CURLM*, CURL*)>(
+      dlsym(curl_lib_, "curl_multi_remove_handle"));
+  multi_perform_ = reinterpret_cast<CURLMcode (*)(CURLM*, int*)>(
+      dlsym(curl_lib_, "curl_multi_perform"));
+  // curl_multi_wait() is from 7.28.0; |extra_fds| is always null here, so
+  // the struct curl_waitfd the bundled headers lack isn't needed.
+  multi_wait_ = reinterpret_cast<
+      CURLMcode (*)(CURLM*, void*, unsigned int, int, int*)>(
+          dlsym(curl_lib_, "curl_multi_wait"));
+  multi_info_read_ = reinterpret_cast<CURLMsg* (*)(CURLM*, int*)>(
+      dlsym(curl_lib_, "curl_multi_info_read"));
+  multi_cleanup_ = reinterpret_cast<CURLMcode (*)(CURLM*)>(
+      dlsym(curl_lib_, "curl_multi_cleanup"));
+  if (!multi_init_ || !multi_setopt_ || !multi_add_handle_ ||
+      !multi_remove_handle_ || !multi_perform_ || !multi_wait_ ||
+      !multi_info_read_ || !multi_cleanup_) {
+    multi_init_ = nullptr;
+    return false;
+  }
   return true;
 }
 
@@ -300,8 +564,6 @@ bool LibcurlWrapper::SendRequestInner(const string& url,
   }
   CURLcode err_code = CURLE_OK;
   err_code = (*easy_perform_)(curl_);
-  easy_strerror_ = reinterpret_cast<const char* (*)(CURLcode)>
-      (dlsym(curl_lib_, "curl_easy_strerror"));
 
   if (http_status_code != nullptr) {
     (*easy_getinfo_)(curl_, CURLINFO_RESPONSE_CODE, http_status_code);
@@ -311,6 +573,8 @@ bool LibcurlWrapper::SendRequestInner(const string& url,
     fprintf(stderr, "Failed to send http request to %s, error: %s\n",
             url.c_str(),
             (*easy_strerror_)(err_code));
+  else if (session_)
+    has_session_connection_ = true;
 
   Reset();
 
@@ -329,6 +593,10 @@ void LibcurlWrapper::Reset() {
   }
 
   (*easy_reset_)(curl_);
+  // curl_easy_reset() keeps the connections, but not the options that
+  // share them.
+  if (session_)
+    ApplySessionOptions(curl_);
 }
 
 bool LibcurlWrapper::CheckInit() {
@@ -34,6 +34,7 @@
 
 #include <string>
 #include <map>
+#include <vector>
 
 #include "common/using_std_string.h"
 #include "third_party/curl/curl.h"
@@ -44,6 +45,16 @@ namespace google_breakpad {
 // usage of libcurl's curl_global_cleanup().
 class LibcurlWrapper {
  public:
+  // One upload for SendPutRequests.
+  struct PutRequest {
+    PutRequest() : http_status_code(0), success(false) {}
+
+    string url;
+    string path;
+    long http_status_code;  // Set on return.
+    bool success;           // Set on return.
+  };
+
   LibcurlWrapper();
   virtual ~LibcurlWrapper();
   virtual bool Init();
@@ -72,6 +83,20 @@ class LibcurlWrapper {
                              string* http_header_data,
                              string* http_response_data);
 
+  // Keeps connections, TLS sessions and DNS results alive between requests,
+  // including those made by SendPutRequests, and asks for HTTP/2 where both
+  // the libcurl found at runtime and the server support it. At most
+  // |max_pipeline_depth| uploads are then in flight at once in
+  // SendPutRequests, multiplexed over one connection where possible.
+  // Must be called after Init().
+  bool EnablePersistentSession(int max_pipeline_depth);
+
+  // Uploads each request's file with a PUT to its URL, filling in its
+  // status code and success. Without a persistent session, or with a
+  // libcurl lacking the multi interface, uploads one file at a time.
+  // Returns true if all of the uploads succeeded.
+  bool SendPutRequests(std::vector<PutRequest>* requests);
+
  private:
   // This function initializes class state corresponding to function
   // pointers into the CURL library.
@@ -86,6 +111,12 @@ class LibcurlWrapper {
 
   bool CheckInit();
 
+  // Sets the options that keep |handle|'s connections in the session.
+  void ApplySessionOptions(CURL* handle);
+
+  // Looks up the multi interface, for SendPutRequests.
+  bool SetMultiFunctionPointers();
+
   bool init_ok_;                 // Whether init succeeded
   void* curl_lib_;               // Pointer to result of dlopen() on
                                  // curl library
@@ -116,6 +147,28 @@ class LibcurlWrapper {
   void (*formfree_)(struct curl_httppost*);
   void (*global_cleanup_)(void);
 
+  // Persistent session state; see EnablePersistentSession.
+  bool session_;
+  bool has_session_connection_;  // Whether a request in it has succeeded.
+  int max_pipeline_depth_;
+  CURLSH* share_;
+  CURLM* multi_;
+  std::vector<CURL*> put_handles_;  // Reused by SendPutRequests.
+  struct curl_slist* put_headerlist_;
+
+  // Function pointers into CURL library for persistent sessions. These
+  // are optional, so Init() doesn't need them.
+  CURLSH* (*share_init_)(void);
+  CURLSHcode (*share_setopt_)(CURLSH*, CURLSHoption, ...);
+  CURLSHcode (*share_cleanup_)(CURLSH*);
+  CURLM* (*multi_init_)(void);
+  CURLMcode (*multi_setopt_)(CURLM*, CURLMoption, ...);
+  CURLMcode (*multi_add_handle_)(CURLM*, CURL*);
+  CURLMcode (*multi_remove_handle_)(CURLM*, CURL*);
+  CURLMcode (*multi_perform_)(CURLM*, int*);
+  CURLMcode (*multi_wait_)(CURLM*, void*, unsigned int, int, int*);
+  CURLMsg* (*multi_info_read_)(CURLM*, int*);
+  CURLMcode (*multi_cleanup_)(CURLM*);
 };
 }
 
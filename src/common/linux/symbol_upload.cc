@@ -36,10 +36,19 @@
 #include "common/linux/symbol_upload.h"
 
 #include <assert.h>
+#include <dirent.h>
+#include <errno.h>
 #include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
 #include <functional>
 #include <iostream>
+#include <memory>
+#include <thread>
 #include <vector>
 
 #include "common/linux/http_upload.h"
@@ -49,6 +58,110 @@
 namespace google_breakpad {
 namespace sym_upload {
 
+namespace {
+
+// The delay before the first retry of a failed batch upload, doubled for
+// each retry after that up to kMaxRetryDelayMs.
+const useconds_t kRetryDelayMs = 1000;
+const useconds_t kMaxRetryDelayMs = 30 * 1000;
+
+// Calls |task| for each index below |count| on up to |jobs| threads. Its
+// second argument is the index of the thread calling it, below |jobs|.
+void RunOnWorkers(size_t count, int jobs,
+                  const std::function<void(size_t, int)>& task) {
+  std::atomic<size_t> next(0);
+  size_t worker_count = std::min(count, static_cast<size_t>(std::max(1, jobs)));
+  std::vector<std::thread> workers;
+  for (size_t worker = 0; worker < worker_count; ++worker) {
+    workers.push_back(std::thread([&next, count, &task, worker]() {
+      for (size_t index = next++; index < count; index = next++)
+        task(index, static_cast<int>(worker));
+    }));
+  }
+  for (size_t i = 0; i < workers.size(); ++i)
+    workers[i].join();
+}
+
+// Calls |attempt| until it returns true, at most |retries| more times,
+// backing off between attempts. Returns whether an attempt succeeded.
+bool WithRetries(int retries, const std::function<bool()>& attempt) {
+  useconds_t delay_ms = kRetryDelayMs;
+  for (int i = 0; ; ++i) {
+    if (attempt())
+      return true;
+    if (i >= retries)
+      return false;
+    usleep(delay_ms * 1000);
+    delay_ms = std::min(delay_ms * 2, kMaxRetryDelayMs);
+  }
+}
+
+bool HasSuffix(const string& str, const string& suffix) {
+  return str.size() >= suffix.size() &&
+      str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Adds the paths of the .sym files under the directory |path| to |files|.
+bool FindSymbolFiles(const string& path, std::vector<string>* files) {
+  DIR* dir = opendir(path.c_str());
+  if (!dir) {
+    fprintf(stderr, "Failed to open directory %s: %s\n", path.c_str(),
+            strerror(errno));
+    return false;
+  }
+  bool success = true;
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != nullptr) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      continue;
+    string entry_path = path + "/" + entry->d_name;
+    struct stat st;
+    if (stat(entry_path.c_str(), &st) != 0)
+      continue;
+    if (S_ISDIR(st.st_mode)) {
+      success = FindSymbolFiles(entry_path, files) && success;
+    } else if (S_ISREG(st.st_mode) && HasSuffix(entry_path, ".sym")) {
+      files->push_back(entry_path);
+    }
+  }
+  closedir(dir);
+  return success;
+}
+
+// Sets |files| to the symbol files to upload in batch mode: the .sym files
+// under |path| if it's a directory, or else those it lists, one per line.
+bool CollectSymbolFiles(const string& path, std::vector<string>* files) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0) {
+    fprintf(stderr, "Failed to stat %s: %s\n", path.c_str(), strerror(errno));
+    return false;
+  }
+  if (S_ISDIR(st.st_mode)) {
+    if (!FindSymbolFiles(path, files))
+      return false;
+    std::sort(files->begin(), files->end());
+    return true;
+  }
+
+  FILE* manifest = fopen(path.c_str(), "r");
+  if (!manifest) {
+    fprintf(stderr, "Failed to open manifest %s: %s\n", path.c_str(),
+            strerror(errno));
+    return false;
+  }
+  char buffer[4096];
+  while (fgets(buffer, sizeof(buffer), manifest)) {
+    string line(buffer);
+    line.erase(line.find_last_not_of(" \t\r\n") + 1);
+    if (!line.empty() && line[0] != '#')
+      files->push_back(line);
+  }
+  fclose(manifest);
+  return true;
+}
+
+}  // namespace
+
 void TokenizeByChar(const string& source_string, int c,
                     std::vector<string>* results) {
   assert(results);
@@ -103,12 +216,14 @@ string CompactIdentifier(const string& uuid) {
 }
 
 // |options| describes the current sym_upload options.
+// |symbols_path| is the Breakpad symbol file being uploaded.
 // |module_parts| contains the strings parsed from the MODULE entry of the
 // Breakpad symbol file being uploaded.
 // |compacted_id| is the debug_id from the MODULE entry of the Breakpad symbol
 // file being uploaded, with all hyphens removed.
 bool SymUploadV1Start(
     const Options& options,
+    const string& symbols_path,
     std::vector<string> module_parts,
     const string& compacted_id) {
   std::map<string, string> parameters;
@@ -125,7 +240,7 @@ bool SymUploadV1Start(
   parameters["debug_identifier"] = compacted_id;
 
   std::map<string, string> files;
-  files["symbol_file"] = options.symbolsPath;
+  files["symbol_file"] = symbols_path;
 
   string response, error;
   long response_code;
@@ -135,6 +250,7 @@ bool SymUploadV1Start(
                                          options.proxy,
                                          options.proxy_user_pwd,
                                          /*ca_certificate_file=*/"",
+                                         options.deflate,
                                          &response,
                                          &response_code,
                                          &error);
@@ -157,25 +273,23 @@ bool SymUploadV1Start(
   return success;
 }
 
+// |libcurl_wrapper| is the initialized connection to make requests with.
 // |options| describes the current sym_upload options.
+// |symbols_path| is the symbol file being uploaded.
 // |code_id| is the basename of the module for which symbols are being
 // uploaded.
 // |debug_id| is the debug_id of the module for which symbols are being
 // uploaded.
-bool SymUploadV2Start(
+bool SymUploadV2Send(
+    LibcurlWrapper* libcurl_wrapper,
     const Options& options,
+    const string& symbols_path,
     const string& code_file,
     const string& debug_id,
     const string& type) {
-  google_breakpad::LibcurlWrapper libcurl_wrapper;
-  if (!libcurl_wrapper.Init()) {
-    printf("Failed to init google_breakpad::LibcurlWrapper.\n");
-    return false;
-  }
-
   if (!options.force) {
     SymbolStatus symbolStatus = SymbolCollectorClient::CheckSymbolStatus(
-        &libcurl_wrapper,
+        libcurl_wrapper,
         options.uploadURLStr,
         options.api_key,
         code_file,
@@ -192,7 +306,7 @@ bool SymUploadV2Start(
 
   UploadUrlResponse uploadUrlResponse;
   if (!SymbolCollectorClient::CreateUploadUrl(
-      &libcurl_wrapper,
+      libcurl_wrapper,
       options.uploadURLStr,
       options.api_key,
       &uploadUrlResponse)) {
@@ -206,11 +320,11 @@ bool SymUploadV2Start(
   string response;
   long response_code;
 
-  if (!libcurl_wrapper.SendPutRequest(signed_url,
-                                      options.symbolsPath,
-                                      &response_code,
-                                      &header,
-                                      &response)) {
+  if (!libcurl_wrapper->SendPutRequest(signed_url,
+                                       symbols_path,
+                                       &response_code,
+                                       &header,
+                                       &response)) {
     printf("Failed to send symbol file.\n");
     printf("Response code: %ld\n", response_code);
     printf("Response:\n");
@@ -227,7 +341,7 @@ bool SymUploadV2Start(
   }
 
   CompleteUploadResult completeUploadResult =
-      SymbolCollectorClient::CompleteUpload(&libcurl_wrapper,
+      SymbolCollectorClient::CompleteUpload(libcurl_wrapper,
                                             options.uploadURLStr,
                                             options.api_key,
                                             upload_key,
@@ -247,9 +361,92 @@ bool SymUploadV2Start(
   return true;
 }
 
+bool SymUploadV2Start(
+    const Options& options,
+    const string& code_file,
+    const string& debug_id,
+    const string& type) {
+  google_breakpad::LibcurlWrapper libcurl_wrapper;
+  if (!libcurl_wrapper.Init()) {
+    printf("Failed to init google_breakpad::LibcurlWrapper.\n");
+    return false;
+  }
+  // The status check, upload and completion requests go to the same
+  // server; keep its connection open between them.
+  libcurl_wrapper.EnablePersistentSession(/*max_pipeline_depth=*/1);
+
+  return SymUploadV2Send(&libcurl_wrapper, options, options.symbolsPath,
+                         code_file, debug_id, type);
+}
+
+// Uploads all of the Breakpad symbol files named by |options->symbolsPath|
+// (see Options::batch), |options->jobs| at a time. In sym-upload-v2 mode,
+// each worker checks whether its module's symbols already exist before
+// uploading them.
+void StartBatch(Options* options) {
+  options->success = false;
+  std::vector<string> files;
+  if (!CollectSymbolFiles(options->symbolsPath, &files))
+    return;
+  if (files.empty()) {
+    fprintf(stderr, "No symbol files found in %s\n",
+            options->symbolsPath.c_str());
+    return;
+  }
+
+  // Initializing libcurl isn't thread-safe, so every connection the
+  // workers use is made here. Holding one also keeps libcurl initialized
+  // for the requests HTTPUpload makes in sym-upload-v1 mode.
+  int jobs = std::max(1, std::min(options->jobs,
+                                  static_cast<int>(files.size())));
+  std::vector<std::unique_ptr<LibcurlWrapper>> connections;
+  for (int i = 0; i < jobs; ++i) {
+    connections.emplace_back(new LibcurlWrapper());
+    if (!connections.back()->Init()) {
+      printf("Failed to init google_breakpad::LibcurlWrapper.\n");
+      return;
+    }
+    connections.back()->EnablePersistentSession(/*max_pipeline_depth=*/1);
+  }
+
+  std::atomic<size_t> failures(0);
+  const Options& batch_options = *options;
+  RunOnWorkers(files.size(), jobs,
+               [&](size_t index, int worker) {
+    const string& path = files[index];
+    std::vector<string> module_parts;
+    bool success = false;
+    if (!ModuleDataForSymbolFile(path, &module_parts)) {
+      fprintf(stderr, "Failed to parse symbol file %s\n", path.c_str());
+    } else if (batch_options.upload_protocol == UploadProtocol::SYM_UPLOAD_V2) {
+      string debug_id = CompactIdentifier(module_parts[3]);
+      success = WithRetries(batch_options.retries, [&]() {
+        return SymUploadV2Send(connections[worker].get(), batch_options, path,
+                               module_parts[4], debug_id, kBreakpadSymbolType);
+      });
+    } else {
+      string compacted_id = CompactIdentifier(module_parts[3]);
+      success = WithRetries(batch_options.retries, [&]() {
+        return SymUploadV1Start(batch_options, path, module_parts,
+                                compacted_id);
+      });
+    }
+    if (!success) {
+      fprintf(stderr, "Failed to upload %s\n", path.c_str());
+      ++failures;
+    }
+  });
+
+  printf("Uploaded %zu of %zu symbol files.\n",
+         files.size() - failures, files.size());
+  options->success = failures == 0;
+}
+
 //=============================================================================
 void Start(Options* options) {
-  if (options->upload_protocol == UploadProtocol::SYM_UPLOAD_V2) {
+  if (options->batch) {
+    StartBatch(options);
+  } else if (options->upload_protocol == UploadProtocol::SYM_UPLOAD_V2) {
     string code_file;
     string debug_id;
     string type;
@@ -279,7 +476,8 @@ void Start(Options* options) {
       return;
     }
     const string compacted_id = CompactIdentifier(module_parts[3]);
-    options->success = SymUploadV1Start(*options, module_parts, compacted_id);
+    options->success = SymUploadV1Start(*options, options->symbolsPath,
+                                        module_parts, compacted_id);
   }
 }
 
@@ -48,7 +48,13 @@ enum class UploadProtocol {
 constexpr char kBreakpadSymbolType[] = "BREAKPAD";
 
 struct Options {
-  Options() : upload_protocol(UploadProtocol::SYM_UPLOAD_V1), force(false) {}
+  Options()
+      : upload_protocol(UploadProtocol::SYM_UPLOAD_V1),
+        force(false),
+        deflate(false),
+        batch(false),
+        jobs(8),
+        retries(3) {}
 
   string symbolsPath;
   string uploadURLStr;
@@ -59,6 +65,16 @@ struct Options {
   UploadProtocol upload_protocol;
   bool force;
   string api_key;
+  // Compress the upload; only used with sym-upload-v1.
+  bool deflate;
+
+  // Batch mode uploads many Breakpad symbol files: |symbolsPath| is either a
+  // directory, all of whose .sym files are uploaded, or a manifest listing
+  // one symbol file per line. |jobs| are uploaded at a time, and each
+  // failed upload is retried up to |retries| times.
+  bool batch;
+  int jobs;
+  int retries;
 
   // These only need to be set for native symbol uploads.
   string code_file;
@@ -0,0 +1,209 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// lz4_block.cc: Compression and decompression of LZ4 blocks.
+//
+// See lz4_block.h for documentation.
+//
+// A block is a series of sequences.  Each sequence is a token byte, whose
+// high nibble is a count of literal bytes and low nibble a match length
+// less four, followed by any extension of the literal count, the literal
+// bytes, a two-byte little-endian offset back to the match, and any
+// extension of the match length.  A count of 15 in the token is extended
+// by bytes that are added to it, up to and including one that is not 255.
+// The last sequence has literals only, and the format requires that it
+// hold at least the last five bytes of the input.
+
+#include "common/lz4_block.h"
+
+namespace google_breakpad {
+
+namespace {
+
+const size_t kMinMatch = 4;
+
+// A match may not start within this many bytes of the end of the input,
+// nor extend into the last kLastLiterals bytes of it.
+const size_t kMatchFindLimit = 12;
+const size_t kLastLiterals = 5;
+
+const size_t kMaxOffset = 65535;
+const int kHashBits = 12;
+
+inline uint32_t Read32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) |
+      (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline uint32_t Hash(uint32_t sequence) {
+  return (sequence * 2654435761U) >> (32 - kHashBits);
+}
+
+// Writes |length| as the extension of a count of 15 or more in a token.
+uint8_t* WriteLength(uint8_t* out, size_t length) {
+  for (; length >= 255; length -= 255)
+    *out++ = 255;
+  *out++ = static_cast<uint8_t>(length);
+  return out;
+}
+
+// Writes a sequence of the |literal_count| bytes at |literals|, followed
+// by a match of |match_length| bytes |offset| bytes back.  A zero
+// |match_length| writes the final, literal-only sequence.
+uint8_t* WriteSequence(uint8_t* out, const uint8_t* literals,
+                       size_t literal_count, size_t offset,
+                       size_t match_length) {
+  uint8_t* token = out++;
+  *token = static_cast<uint8_t>((literal_count < 15 ? literal_count : 15)
+                                << 4);
+  if (literal_count >= 15)
+    out = WriteLength(out, literal_count - 15);
+  for (size_t i = 0; i < literal_count; ++i)
+    *out++ = literals[i];
+  if (!match_length)
+    return out;
+
+  *out++ = static_cast<uint8_t>(offset);
+  *out++ = static_cast<uint8_t>(offset >> 8);
+  const size_t length = match_length - kMinMatch;
+  *token |= static_cast<uint8_t>(length < 15 ? length : 15);
+  if (length >= 15)
+    out = WriteLength(out, length - 15);
+  return out;
+}
+
+}  // namespace
+
+size_t LZ4Compress(const uint8_t* src, size_t size, uint8_t* dest,
+                   uint32_t* hash_table) {
+  uint8_t* out = dest;
+  size_t anchor = 0;
+
+  if (size > kMatchFindLimit) {
+    for (size_t i = 0; i < kLZ4HashTableSize; ++i)
+      hash_table[i] = 0;
+
+    const size_t find_limit = size - kMatchFindLimit;
+    const size_t match_limit = size - kLastLiterals;
+    size_t position = 0;
+    while (position < find_limit) {
+      const uint32_t sequence = Read32(src + position);
+      uint32_t* entry = &hash_table[Hash(sequence)];
+      size_t candidate = *entry;
+      *entry = static_cast<uint32_t>(position);
+      if (candidate >= position || position - candidate > kMaxOffset ||
+          Read32(src + candidate) != sequence) {
+        ++position;
+        continue;
+      }
+
+      // Take in any matching bytes before the ones that hashed alike.
+      while (position > anchor && candidate > 0 &&
+             src[position - 1] == src[candidate - 1]) {
+        --position;
+        --candidate;
+      }
+      size_t length = kMinMatch;
+      while (position + length < match_limit &&
+             src[position + length] == src[candidate + length]) {
+        ++length;
+      }
+
+      out = WriteSequence(out, src + anchor, position - anchor,
+                          position - candidate, length);
+      position += length;
+      anchor = position;
+    }
+  }
+
+  out = WriteSequence(out, src + anchor, size - anchor, 0, 0);
+  return out - dest;
+}
+
+bool LZ4Decompress(const uint8_t* src, size_t src_size, uint8_t* dest,
+                   size_t dest_size) {
+  const uint8_t* in = src;
+  const uint8_t* const in_end = src + src_size;
+  size_t out = 0;
+
+  while (in < in_end) {
+    const uint8_t token = *in++;
+
+    size_t literal_count = token >> 4;
+    if (literal_count == 15) {
+      uint8_t byte;
+      do {
+        if (in == in_end)
+          return false;
+        byte = *in++;
+        literal_count += byte;
+      } while (byte == 255);
+    }
+    if (literal_count > static_cast<size_t>(in_end - in) ||
+        literal_count > dest_size - out) {
+      return false;
+    }
+    for (size_t i = 0; i < literal_count; ++i)
+      dest[out++] = *in++;
+
+    // The last sequence ends after its literals.
+    if (in == in_end)
+      break;
+
+    if (in_end - in < 2)
+      return false;
+    const size_t offset = in[0] | (in[1] << 8);
+    in += 2;
+    if (offset == 0 || offset > out)
+      return false;
+
+    size_t length = token & 15;
+    if (length == 15) {
+      uint8_t byte;
+      do {
+        if (in == in_end)
+          return false;
+        byte = *in++;
+        length += byte;
+      } while (byte == 255);
+    }
+    length += kMinMatch;
+    if (length > dest_size - out)
+      return false;
+
+    // The match may overlap the bytes it produces, so copy a byte at a
+    // time.
+    for (size_t i = 0; i < length; ++i, ++out)
+      dest[out] = dest[out - offset];
+  }
+
+  return out == dest_size;
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,67 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+// lz4_block.h: Compression and decompression of LZ4 blocks.
+//
+// These implement the LZ4 block format, without the LZ4 frame format
+// around it.  Neither function allocates memory or calls into libc, so
+// the compressor is safe to use in a crashed process.
+
+#ifndef COMMON_LZ4_BLOCK_H_
+#define COMMON_LZ4_BLOCK_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace google_breakpad {
+
+// The number of entries in the hash table that LZ4Compress uses.
+const size_t kLZ4HashTableSize = 4096;
+
+// Returns the largest size that compressing |size| bytes can produce.
+inline size_t LZ4CompressBound(size_t size) {
+  return size + size / 255 + 16;
+}
+
+// Compresses the |size| bytes at |src| into |dest|, which must hold at
+// least LZ4CompressBound(size) bytes.  |hash_table| must hold
+// kLZ4HashTableSize entries; its contents on entry do not matter.
+// Returns the number of bytes written to |dest|.
+size_t LZ4Compress(const uint8_t* src, size_t size, uint8_t* dest,
+                   uint32_t* hash_table);
+
+// Decompresses the LZ4 block of |src_size| bytes at |src| into |dest|,
+// which must be exactly |dest_size| bytes long.  Returns false if the
+// block is malformed or does not decompress to exactly |dest_size| bytes.
+bool LZ4Decompress(const uint8_t* src, size_t src_size, uint8_t* dest,
+                   size_t dest_size);
+
+}  // namespace google_breakpad
+
+#endif  // COMMON_LZ4_BLOCK_H_
@@ -40,6 +40,7 @@ NS_ASSUME_NONNULL_BEGIN
  @protected
   NSURL* URL_;                   // The destination URL (STRONG)
   NSHTTPURLResponse* response_;  // The response from the send (STRONG)
+  BOOL compressBody_;            // Whether to gzip the body before sending
 }
 
 /**
@@ -57,6 +58,13 @@ NS_ASSUME_NONNULL_BEGIN
 
 - (NSData*)bodyData;  // Internal, don't call outside class hierarchy.
 
+/**
+ Sets whether the body is sent gzip-compressed, with a Content-Encoding
+ header, when that makes it smaller.  The server must accept compressed
+ requests.  Defaults to NO.
+ */
+- (void)setCompressBody:(BOOL)compress;
+
 - (NSData*)send:(NSError**)error;
 
 /**
@@ -133,6 +133,52 @@ static NSData* SendSynchronousNSURLRequest(NSURLRequest* req,
 #endif  // USE_NSURLSESSION
 }
 
+// Returns the CRC-32 of |data| used in the gzip trailer.
+static uint32_t GzipCRC32(NSData* data) {
+  static uint32_t table[256];
+  static dispatch_once_t once;
+  dispatch_once(&once, ^{
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; ++k)
+        c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+      table[i] = c;
+    }
+  });
+  const uint8_t* bytes = (const uint8_t*)[data bytes];
+  uint32_t crc = 0xffffffff;
+  for (NSUInteger i = 0; i < [data length]; ++i)
+    crc = table[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+  return crc ^ 0xffffffff;
+}
+
+// Returns |data| as a gzip stream, or nil if it can't be compressed.
+// Foundation's zlib algorithm produces a raw deflate stream, which only needs
+// the gzip header and trailer around it, so no library has to be linked.
+static NSData* GzipData(NSData* data) {
+  if (@available(macOS 10.15, iOS 13.0, *)) {
+    NSData* deflated =
+        [data compressedDataUsingAlgorithm:NSDataCompressionAlgorithmZlib
+                                     error:nil];
+    if (!deflated)
+      return nil;
+    static const uint8_t kHeader[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff};
+    uint32_t crc = GzipCRC32(data);
+    uint32_t size = (uint32_t)[data length];
+    const uint8_t trailer[8] = {
+        (uint8_t)crc, (uint8_t)(crc >> 8), (uint8_t)(crc >> 16),
+        (uint8_t)(crc >> 24), (uint8_t)size, (uint8_t)(size >> 8),
+        (uint8_t)(size >> 16), (uint8_t)(size >> 24)};
+    NSMutableData* result = [NSMutableData
+        dataWithCapacity:sizeof(kHeader) + [deflated length] + sizeof(trailer)];
+    [result appendBytes:kHeader length:sizeof(kHeader)];
+    [result appendData:deflated];
+    [result appendBytes:trailer length:sizeof(trailer)];
+    return result;
+  }
+  return nil;
+}
+
 @implementation HTTPRequest
 
 //=============================================================================
@@ -182,6 +228,11 @@ static NSData* SendSynchronousNSURLRequest(NSURLRequest* req,
   return nil;
 }
 
+//=============================================================================
+- (void)setCompressBody:(BOOL)compress {
+  compressBody_ = compress;
+}
+
 //=============================================================================
 - (NSData*)send:(NSError**)withError {
   NSMutableURLRequest* req = [[NSMutableURLRequest alloc]
@@ -195,6 +246,13 @@ static NSData* SendSynchronousNSURLRequest(NSURLRequest* req,
   }
 
   NSData* bodyData = [self bodyData];
+  if (compressBody_ && [bodyData length] > 0 && ![URL_ isFileURL]) {
+    NSData* compressed = GzipData(bodyData);
+    if (compressed && [compressed length] < [bodyData length]) {
+      bodyData = compressed;
+      [req setValue:@"gzip" forHTTPHeaderField:@"Content-Encoding"];
+    }
+  }
   if ([bodyData length] > 0) {
     [req setHTTPBody:bodyData];
   }
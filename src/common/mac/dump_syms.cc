@@ -41,24 +41,29 @@
 #include <assert.h>
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <mach-o/arch.h>
 #include <mach-o/fat.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
 #include <ostream>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "common/byte_cursor.h"
 #include "common/dwarf/bytereader-inl.h"
 #include "common/dwarf/dwarf2reader.h"
 #include "common/dwarf_cfi_to_module.h"
+#include "common/dwarf_cu_loader.h"
 #include "common/dwarf_cu_to_module.h"
-#include "common/dwarf_line_to_module.h"
-#include "common/dwarf_range_list_handler.h"
 #include "common/mac/file_id.h"
 #include "common/mac/arch_utilities.h"
 #include "common/mac/macho_reader.h"
@@ -77,10 +82,11 @@
 #define CPU_TYPE_ARM64 (static_cast<cpu_type_t>(16777228))
 #endif  // CPU_TYPE_ARM64
 
+using google_breakpad::ByteCursor;
 using google_breakpad::ByteReader;
+using google_breakpad::DumperLineToModule;
+using google_breakpad::DumperRangesHandler;
 using google_breakpad::DwarfCUToModule;
-using google_breakpad::DwarfLineToModule;
-using google_breakpad::DwarfRangeListHandler;
 using google_breakpad::mach_o::FatReader;
 using google_breakpad::mach_o::FileID;
 using google_breakpad::mach_o::Section;
@@ -119,10 +125,198 @@ vector<string> list_directory(const string& directory) {
   closedir(dir);
   return entries;
 }
+
+// Return the Breakpad identifier for a Mach-O file whose UUID is |uuid|.
+string IdentifierFromUUID(const unsigned char uuid[16]) {
+  char identifier_string[40];
+  FileID::ConvertIdentifierToString(uuid, identifier_string,
+                                    sizeof(identifier_string));
+
+  string compacted(identifier_string);
+  for(size_t i = compacted.find('-'); i != string::npos;
+      i = compacted.find('-', i))
+    compacted.erase(i, 1);
+
+  // The pdb for these IDs has an extra byte, so to make everything uniform put
+  // a 0 on the end of mac IDs.
+  compacted += "0";
+
+  return compacted;
+}
+
+// A load command handler that finds a Mach-O file's LC_UUID.
+class UUIDFinder : public google_breakpad::mach_o::Reader::LoadCommandHandler {
+ public:
+  UUIDFinder() : found_(false) {}
+
+  bool UnknownCommand(google_breakpad::mach_o::LoadCommandType type,
+                      const google_breakpad::ByteBuffer& contents) {
+    // The UUID follows the command type and size.
+    if (type != LC_UUID || contents.Size() < 8 + sizeof(uuid_))
+      return true;
+    memcpy(uuid_, contents.start + 8, sizeof(uuid_));
+    found_ = true;
+    return false;
+  }
+
+  bool found() const { return found_; }
+  const unsigned char* uuid() const { return uuid_; }
+
+ private:
+  bool found_;
+  unsigned char uuid_[16];
+};
 }
 
 namespace google_breakpad {
 
+// A dyld shared cache, with all of its files mapped into memory.
+class DumpSymbols::SharedCache {
+ public:
+  struct Image {
+    uint64_t address;  // The address of the image's Mach-O header.
+    string install_name;
+  };
+
+  explicit SharedCache(const string& filename) : filename_(filename) {}
+
+  ~SharedCache() {
+    for (const ByteBuffer& file : files_)
+      munmap(const_cast<uint8_t*>(file.start), file.Size());
+  }
+
+  // Map the cache file |path| into memory and add its mappings to map_.
+  // If |main| is true, |path| is the cache's main file, which lists its
+  // images; add them to images_. On success, return true; if there is a
+  // problem, report it and return false.
+  bool MapFile(const string& path, bool main);
+
+  const string& filename() const { return filename_; }
+  const mach_o::SharedCacheMap& map() const { return map_; }
+  const vector<Image>& images() const { return images_; }
+
+ private:
+  // The name of the cache's main file.
+  string filename_;
+
+  // The contents of each of the cache's files.
+  vector<ByteBuffer> files_;
+
+  mach_o::SharedCacheMap map_;
+  vector<Image> images_;
+};
+
+bool DumpSymbols::SharedCache::MapFile(const string& path, bool main) {
+  int fd = open(path.c_str(), O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) < 0) {
+    fprintf(stderr, "Could not open shared cache file %s: %s\n",
+            path.c_str(), strerror(errno));
+    if (fd >= 0)
+      close(fd);
+    return false;
+  }
+  void* contents = st.st_size > 0 ?
+      mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+  close(fd);
+  if (contents == MAP_FAILED) {
+    fprintf(stderr, "Could not map shared cache file %s: %s\n",
+            path.c_str(), strerror(errno));
+    return false;
+  }
+  ByteBuffer file(static_cast<const uint8_t*>(contents), st.st_size);
+  files_.push_back(file);
+
+  // All the shared caches Breakpad can dump are little-endian; the
+  // structures read below are dyld_cache_header, dyld_cache_mapping_info
+  // and dyld_cache_image_info, from dyld's dyld_cache_format.h.
+  ByteCursor cursor(&file, false);
+  string magic;
+  uint32_t mapping_offset, mapping_count, images_offset, images_count;
+  cursor.CString(&magic, 16) >> mapping_offset >> mapping_count
+         >> images_offset >> images_count;
+  if (!cursor || magic.compare(0, 7, "dyld_v1") != 0) {
+    fprintf(stderr, "%s: not a dyld shared cache\n", path.c_str());
+    return false;
+  }
+  // Later caches moved the image list after the fields they added; the
+  // mappings follow the header, so their offset gives its size.
+  const uint32_t kImagesOffsetField = 0x1c0;
+  if (mapping_offset >= kImagesOffsetField + 8 &&
+      file.Size() >= kImagesOffsetField + 8) {
+    cursor.set_here(file.start + kImagesOffsetField);
+    cursor >> images_offset >> images_count;
+  }
+
+  const size_t kMappingSize = 32;
+  if (mapping_offset > file.Size() ||
+      mapping_count > (file.Size() - mapping_offset) / kMappingSize) {
+    fprintf(stderr, "%s: mappings lie beyond the end of the file\n",
+            path.c_str());
+    return false;
+  }
+  cursor.set_here(file.start + mapping_offset);
+  for (uint32_t i = 0; i < mapping_count; ++i) {
+    uint64_t address, size, file_offset;
+    uint32_t max_prot, init_prot;
+    cursor >> address >> size >> file_offset >> max_prot >> init_prot;
+    if (file_offset > file.Size() || size > file.Size() - file_offset) {
+      fprintf(stderr, "%s: mapping at 0x%llx lies beyond the end of the"
+              " file\n", path.c_str(),
+              static_cast<unsigned long long>(address));
+      return false;
+    }
+    map_.AddMapping(address, file.start + file_offset, size);
+  }
+
+  if (!main)
+    return true;
+
+  const size_t kImageSize = 32;
+  if (images_offset > file.Size() ||
+      images_count > (file.Size() - images_offset) / kImageSize) {
+    fprintf(stderr, "%s: image list lies beyond the end of the file\n",
+            path.c_str());
+    return false;
+  }
+  for (uint32_t i = 0; i < images_count; ++i) {
+    cursor.set_here(file.start + images_offset + i * kImageSize);
+    Image image;
+    uint64_t modification_time, inode;
+    uint32_t path_offset;
+    cursor >> image.address >> modification_time >> inode >> path_offset;
+    if (path_offset >= file.Size()) {
+      fprintf(stderr, "%s: image %u's install name lies beyond the end of"
+              " the file\n", path.c_str(), i);
+      return false;
+    }
+    cursor.set_here(file.start + path_offset).CString(&image.install_name);
+    images_.push_back(image);
+  }
+  return true;
+}
+
+DumpSymbols::DumpSymbols(SymbolData symbol_data,
+                         bool handle_inter_cu_refs,
+                         bool enable_multiple,
+                         const std::string& module_name,
+                         bool prefer_extern_name)
+    : symbol_data_(symbol_data),
+      handle_inter_cu_refs_(handle_inter_cu_refs),
+      object_filename_(),
+      contents_(),
+      size_(0),
+      from_disk_(false),
+      object_files_(),
+      selected_object_file_(),
+      enable_multiple_(enable_multiple),
+      module_name_(module_name),
+      prefer_extern_name_(prefer_extern_name),
+      report_warnings_(true),
+      num_threads_(1) {}
+
+DumpSymbols::~DumpSymbols() = default;
+
 bool DumpSymbols::Read(const string& filename) {
   selected_object_file_ = nullptr;
   struct stat st;
@@ -269,101 +463,11 @@ void DumpSymbols::SetReportWarnings(bool report_warnings) {
     report_warnings_ = report_warnings;
 }
 
-string DumpSymbols::Identifier() {
-  scoped_ptr<FileID> file_id;
-
-  if (from_disk_) {
-    file_id.reset(new FileID(object_filename_.c_str()));
-  } else {
-    file_id.reset(new FileID(contents_.get(), size_));
-  }
-  unsigned char identifier_bytes[16];
-  scoped_ptr<Module> module;
-  if (!selected_object_file_) {
-    if (!CreateEmptyModule(module))
-      return string();
-  }
-  cpu_type_t cpu_type = selected_object_file_->cputype;
-  cpu_subtype_t cpu_subtype = selected_object_file_->cpusubtype;
-  if (!file_id->MachoIdentifier(cpu_type, cpu_subtype, identifier_bytes)) {
-    fprintf(stderr, "Unable to calculate UUID of mach-o binary %s!\n",
-            object_filename_.c_str());
-    return "";
-  }
-
-  char identifier_string[40];
-  FileID::ConvertIdentifierToString(identifier_bytes, identifier_string,
-                                    sizeof(identifier_string));
-
-  string compacted(identifier_string);
-  for(size_t i = compacted.find('-'); i != string::npos;
-      i = compacted.find('-', i))
-    compacted.erase(i, 1);
-
-  // The pdb for these IDs has an extra byte, so to make everything uniform put
-  // a 0 on the end of mac IDs.
-  compacted += "0";
-
-  return compacted;
+void DumpSymbols::SetNumThreads(int num_threads) {
+  num_threads_ = num_threads;
 }
 
-// A range handler that accepts rangelist data parsed by
-// RangeListReader and populates a range vector (typically
-// owned by a function) with the results.
-class DumpSymbols::DumperRangesHandler:
-      public DwarfCUToModule::RangesHandler {
- public:
-  DumperRangesHandler(ByteReader* reader) :
-      reader_(reader) { }
-
-  bool ReadRanges(
-      enum DwarfForm form, uint64_t data,
-      RangeListReader::CURangesInfo* cu_info,
-      vector<Module::Range>* ranges) {
-    DwarfRangeListHandler handler(ranges);
-    RangeListReader range_list_reader(reader_, cu_info,
-                                                    &handler);
-    return range_list_reader.ReadRanges(form, data);
-  }
-
- private:
-  ByteReader* reader_;
-};
-
-// A line-to-module loader that accepts line number info parsed by
-// LineInfo and populates a Module and a line vector
-// with the results.
-class DumpSymbols::DumperLineToModule:
-      public DwarfCUToModule::LineToModuleHandler {
- public:
-  // Create a line-to-module converter using BYTE_READER.
-  DumperLineToModule(ByteReader* byte_reader)
-      : byte_reader_(byte_reader) { }
-
-  void StartCompilationUnit(const string& compilation_dir) {
-    compilation_dir_ = compilation_dir;
-  }
-
-  void ReadProgram(const uint8_t* program,
-                   uint64_t length,
-                   const uint8_t* string_section,
-                   uint64_t string_section_length,
-                   const uint8_t* line_string_section,
-                   uint64_t line_string_section_length,
-                   Module* module,
-                   vector<Module::Line>* lines,
-                   std::map<uint32_t, Module::File*>* files) {
-    DwarfLineToModule handler(module, compilation_dir_, lines, files);
-    LineInfo parser(program, length, byte_reader_, nullptr, 0,
-                                  nullptr, 0, &handler);
-    parser.Start();
-  }
- private:
-  string compilation_dir_;
-  ByteReader* byte_reader_;  // WEAK
-};
-
-bool DumpSymbols::CreateEmptyModule(scoped_ptr<Module>& module) {
+const SuperFatArch* DumpSymbols::SelectedObjectFile() {
   // Select an object file, if SetArchitecture hasn't been called to set one
   // explicitly.
   if (!selected_object_file_) {
@@ -379,17 +483,59 @@ bool DumpSymbols::CreateEmptyModule(scoped_ptr<Module>& module) {
                 " architecture; specify an architecture explicitly"
                 " with '-a ARCH' to resolve the ambiguity\n",
                 object_filename_.c_str());
-        return false;
+        return nullptr;
       }
     }
   }
+  return selected_object_file_;
+}
+
+string DumpSymbols::ObjectFileName(const SuperFatArch& object_file) const {
+  string name = object_filename_;
+  if (object_files_.size() > 1) {
+    const char* arch_name = GetNameFromCPUType(object_file.cputype,
+                                               object_file.cpusubtype);
+    if (strcmp(arch_name, "i386") == 0)
+      arch_name = "x86";
+    name += ", architecture ";
+    name += arch_name;
+  }
+  return name;
+}
+
+string DumpSymbols::Identifier() {
+  const SuperFatArch* object_file = SelectedObjectFile();
+  if (!object_file)
+    return string();
+  return Identifier(*object_file);
+}
+
+string DumpSymbols::Identifier(const SuperFatArch& object_file) const {
+  scoped_ptr<FileID> file_id;
+
+  if (from_disk_) {
+    file_id.reset(new FileID(object_filename_.c_str()));
+  } else {
+    file_id.reset(new FileID(contents_.get(), size_));
+  }
+  unsigned char identifier_bytes[16];
+  cpu_type_t cpu_type = object_file.cputype;
+  cpu_subtype_t cpu_subtype = object_file.cpusubtype;
+  if (!file_id->MachoIdentifier(cpu_type, cpu_subtype, identifier_bytes)) {
+    fprintf(stderr, "Unable to calculate UUID of mach-o binary %s!\n",
+            object_filename_.c_str());
+    return "";
+  }
 
-  assert(selected_object_file_);
+  return IdentifierFromUUID(identifier_bytes);
+}
 
-  // Find the name of the selected file's architecture, to appear in
-  // the MODULE record and in error messages.
+bool DumpSymbols::CreateEmptyModule(const SuperFatArch& object_file,
+                                    scoped_ptr<Module>& module) const {
+  // Find the name of the object file's architecture, to appear in the
+  // MODULE record.
   const char* selected_arch_name = GetNameFromCPUType(
-      selected_object_file_->cputype, selected_object_file_->cpusubtype);
+      object_file.cputype, object_file.cpusubtype);
 
   // In certain cases, it is possible that architecture info can't be reliably
   // determined, e.g. new architectures that breakpad is unware of. In that
@@ -401,14 +547,6 @@ bool DumpSymbols::CreateEmptyModule(scoped_ptr<Module>& module) {
   if (strcmp(selected_arch_name, "i386") == 0)
     selected_arch_name = "x86";
 
-  // Produce a name to use in error messages that includes the
-  // filename, and the architecture, if there is more than one.
-  selected_object_name_ = object_filename_;
-  if (object_files_.size() > 1) {
-    selected_object_name_ += ", architecture ";
-    selected_object_name_ += selected_arch_name;
-  }
-
   // Compute a module name, to appear in the MODULE record.
   string module_name;
   if (!module_name_.empty()) {
@@ -418,7 +556,7 @@ bool DumpSymbols::CreateEmptyModule(scoped_ptr<Module>& module) {
   }
 
   // Choose an identifier string, to appear in the MODULE record.
-  string identifier = Identifier();
+  string identifier = Identifier(object_file);
   if (identifier.empty())
     return false;
 
@@ -428,70 +566,19 @@ bool DumpSymbols::CreateEmptyModule(scoped_ptr<Module>& module) {
   return true;
 }
 
-void DumpSymbols::StartProcessSplitDwarf(
-    google_breakpad::CompilationUnit* reader,
-    Module* module,
-    google_breakpad::Endianness endianness,
-    bool handle_inter_cu_refs,
-    bool handle_inline) const {
-  std::string split_file;
-  google_breakpad::SectionMap split_sections;
-  google_breakpad::ByteReader split_byte_reader(endianness);
-  uint64_t cu_offset = 0;
-  if (reader->ProcessSplitDwarf(split_file, split_sections, split_byte_reader,
-                                cu_offset))
-    return;
-  DwarfCUToModule::FileContext file_context(split_file, module,
-                                            handle_inter_cu_refs);
-  for (auto section : split_sections)
-    file_context.AddSectionToSectionMap(section.first, section.second.first,
-                                        section.second.second);
-  // Because DWP/DWO file doesn't have .debug_addr/.debug_line/.debug_line_str,
-  // its debug info will refer to .debug_addr/.debug_line in the main binary.
-  if (file_context.section_map().find(".debug_addr") ==
-      file_context.section_map().end())
-    file_context.AddSectionToSectionMap(".debug_addr", reader->GetAddrBuffer(),
-                                        reader->GetAddrBufferLen());
-  if (file_context.section_map().find(".debug_line") ==
-      file_context.section_map().end())
-    file_context.AddSectionToSectionMap(".debug_line", reader->GetLineBuffer(),
-                                        reader->GetLineBufferLen());
-  if (file_context.section_map().find(".debug_line_str") ==
-      file_context.section_map().end())
-    file_context.AddSectionToSectionMap(".debug_line_str",
-                                        reader->GetLineStrBuffer(),
-                                        reader->GetLineStrBufferLen());
-  DumperRangesHandler ranges_handler(&split_byte_reader);
-  DumperLineToModule line_to_module(&split_byte_reader);
-  DwarfCUToModule::WarningReporter reporter(split_file, cu_offset);
-  DwarfCUToModule root_handler(
-      &file_context, &line_to_module, &ranges_handler, &reporter, handle_inline,
-      reader->GetLowPC(), reader->GetAddrBase(), reader->HasSourceLineInfo(),
-      reader->GetSourceLineOffset());
-  google_breakpad::DIEDispatcher die_dispatcher(&root_handler);
-  google_breakpad::CompilationUnit split_reader(
-      split_file, file_context.section_map(), cu_offset, &split_byte_reader,
-      &die_dispatcher);
-  split_reader.SetSplitDwarf(reader->GetAddrBase(), reader->GetDWOID());
-  split_reader.Start();
-  // Normally, it won't happen unless we have transitive reference.
-  if (split_reader.ShouldProcessSplitDwarf()) {
-    StartProcessSplitDwarf(&split_reader, module, endianness,
-                           handle_inter_cu_refs, handle_inline);
-  }
-}
-
 void DumpSymbols::ReadDwarf(google_breakpad::Module* module,
                             const mach_o::Reader& macho_reader,
                             const mach_o::SectionMap& dwarf_sections,
-                            bool handle_inter_cu_refs) const {
+                            const string& object_name,
+                            bool handle_inter_cu_refs,
+                            int num_threads) const {
   // Build a byte reader of the appropriate endianness.
   google_breakpad::Endianness endianness =
       macho_reader.big_endian() ? ENDIANNESS_BIG : ENDIANNESS_LITTLE;
   ByteReader byte_reader(endianness);
 
   // Construct a context for this file.
-  DwarfCUToModule::FileContext file_context(selected_object_name_,
+  DwarfCUToModule::FileContext file_context(object_name,
                                             module,
                                             handle_inter_cu_refs);
 
@@ -510,7 +597,16 @@ void DumpSymbols::ReadDwarf(google_breakpad::Module* module,
   // There had better be a __debug_info section!
   if (debug_info_entry == file_context.section_map().end()) {
     fprintf(stderr, "%s: __DWARF segment of file has no __debug_info section\n",
-            selected_object_name_.c_str());
+            object_name.c_str());
+    return;
+  }
+
+  bool handle_inline = symbol_data_ & INLINES;
+  if (num_threads > 1 &&
+      LoadDwarfConcurrently(object_name, file_context.section_map(),
+                            endianness, handle_inter_cu_refs, handle_inline,
+                            report_warnings_, num_threads, string(), NULL,
+                            module)) {
     return;
   }
   const std::pair<const uint8_t*, uint64_t>& debug_info_section =
@@ -524,17 +620,16 @@ void DumpSymbols::ReadDwarf(google_breakpad::Module* module,
 
   // Walk the __debug_info section, one compilation unit at a time.
   uint64_t debug_info_length = debug_info_section.second;
-  bool handle_inline = symbol_data_ & INLINES;
   for (uint64_t offset = 0; offset < debug_info_length;) {
     // Make a handler for the root DIE that populates MODULE with the
     // debug info.
     std::unique_ptr<DwarfCUToModule::WarningReporter> reporter;
     if (report_warnings_) {
       reporter = std::make_unique<DwarfCUToModule::WarningReporter>(
-        selected_object_name_, offset);
+        object_name, offset);
     } else {
       reporter = std::make_unique<DwarfCUToModule::NullWarningReporter>(
-        selected_object_name_, offset);
+        object_name, offset);
     }
     DwarfCUToModule root_handler(&file_context, &line_to_module,
                                  &ranges_handler, reporter.get(),
@@ -542,7 +637,7 @@ void DumpSymbols::ReadDwarf(google_breakpad::Module* module,
     // Make a Dwarf2Handler that drives our DIEHandler.
     DIEDispatcher die_dispatcher(&root_handler);
     // Make a DWARF parser for the compilation unit at OFFSET.
-    CompilationUnit dwarf_reader(selected_object_name_,
+    CompilationUnit dwarf_reader(object_name,
                                                file_context.section_map(),
                                                offset,
                                                &byte_reader,
@@ -552,7 +647,7 @@ void DumpSymbols::ReadDwarf(google_breakpad::Module* module,
     // Start to process split dwarf file.
     if (dwarf_reader.ShouldProcessSplitDwarf()) {
       StartProcessSplitDwarf(&dwarf_reader, module, endianness,
-                             handle_inter_cu_refs, handle_inline);
+                             handle_inter_cu_refs, handle_inline, NULL, NULL);
     }
   }
 }
@@ -560,6 +655,7 @@ void DumpSymbols::ReadDwarf(google_breakpad::Module* module,
 bool DumpSymbols::ReadCFI(google_breakpad::Module* module,
                           const mach_o::Reader& macho_reader,
                           const mach_o::Section& section,
+                          const string& object_name,
                           bool eh_frame) const {
   // Find the appropriate set of register names for this file's
   // architecture.
@@ -584,7 +680,7 @@ bool DumpSymbols::ReadCFI(google_breakpad::Module* module,
           stderr,
           "%s: cannot convert DWARF call frame information for architecture "
           "'%s' (%d, %d) to Breakpad symbol file: no register name table\n",
-          selected_object_name_.c_str(), arch_name, macho_reader.cpu_type(),
+          object_name.c_str(), arch_name, macho_reader.cpu_type(),
           macho_reader.cpu_subtype());
       return false;
     }
@@ -595,7 +691,7 @@ bool DumpSymbols::ReadCFI(google_breakpad::Module* module,
   size_t cfi_size = section.contents.Size();
 
   // Plug together the parser, handler, and their entourages.
-  DwarfCFIToModule::Reporter module_reporter(selected_object_name_,
+  DwarfCFIToModule::Reporter module_reporter(object_name,
                                              section.section_name);
   DwarfCFIToModule handler(module, register_names, &module_reporter);
   ByteReader byte_reader(macho_reader.big_endian() ?
@@ -607,7 +703,7 @@ bool DumpSymbols::ReadCFI(google_breakpad::Module* module,
   // this is the only base address the CFI parser will need.
   byte_reader.SetCFIDataBase(section.address, cfi);
 
-  CallFrameInfo::Reporter dwarf_reporter(selected_object_name_,
+  CallFrameInfo::Reporter dwarf_reporter(object_name,
                                                        section.section_name);
   CallFrameInfo parser(cfi, cfi_size,
                                      &byte_reader, &handler, &dwarf_reporter,
@@ -622,17 +718,22 @@ class DumpSymbols::LoadCommandDumper:
       public mach_o::Reader::LoadCommandHandler {
  public:
   // Create a load command dumper handling load commands from READER's
-  // file, and adding data to MODULE.
+  // file, named OBJECT_NAME in error messages, and adding data to MODULE.
+  // DWARF compilation units are read on NUM_THREADS threads.
   LoadCommandDumper(const DumpSymbols& dumper,
                     google_breakpad::Module* module,
                     const mach_o::Reader& reader,
+                    const string& object_name,
                     SymbolData symbol_data,
-                    bool handle_inter_cu_refs)
+                    bool handle_inter_cu_refs,
+                    int num_threads)
       : dumper_(dumper),
         module_(module),
         reader_(reader),
+        object_name_(object_name),
         symbol_data_(symbol_data),
-        handle_inter_cu_refs_(handle_inter_cu_refs) { }
+        handle_inter_cu_refs_(handle_inter_cu_refs),
+        num_threads_(num_threads) { }
 
   bool SegmentCommand(const mach_o::Segment& segment);
   bool SymtabCommand(const ByteBuffer& entries, const ByteBuffer& strings);
@@ -641,14 +742,21 @@ class DumpSymbols::LoadCommandDumper:
   const DumpSymbols& dumper_;
   google_breakpad::Module* module_;  // WEAK
   const mach_o::Reader& reader_;
+  const string& object_name_;
   const SymbolData symbol_data_;
   const bool handle_inter_cu_refs_;
+  const int num_threads_;
 };
 
 bool DumpSymbols::LoadCommandDumper::SegmentCommand(const Segment& segment) {
-  mach_o::SectionMap section_map;
-  if (!reader_.MapSegmentSections(segment, &section_map))
+  // Only __TEXT and __DWARF hold anything of interest, so don't parse the
+  // section lists of the others.
+  if (segment.name != "__TEXT" && segment.name != "__DWARF")
+    return true;
+  const mach_o::SectionMap* sections = reader_.SegmentSections(segment.name);
+  if (!sections)
     return false;
+  const mach_o::SectionMap& section_map = *sections;
 
   if (segment.name == "__TEXT") {
     module_->SetLoadAddress(segment.vmaddr);
@@ -657,7 +765,8 @@ bool DumpSymbols::LoadCommandDumper::SegmentCommand(const Segment& segment) {
           section_map.find("__eh_frame");
       if (eh_frame != section_map.end()) {
         // If there is a problem reading this, don't treat it as a fatal error.
-        dumper_.ReadCFI(module_, reader_, eh_frame->second, true);
+        dumper_.ReadCFI(module_, reader_, eh_frame->second, object_name_,
+                        true);
       }
     }
     return true;
@@ -665,14 +774,16 @@ bool DumpSymbols::LoadCommandDumper::SegmentCommand(const Segment& segment) {
 
   if (segment.name == "__DWARF") {
     if ((symbol_data_ & SYMBOLS_AND_FILES) || (symbol_data_ & INLINES)) {
-      dumper_.ReadDwarf(module_, reader_, section_map, handle_inter_cu_refs_);
+      dumper_.ReadDwarf(module_, reader_, section_map, object_name_,
+                        handle_inter_cu_refs_, num_threads_);
     }
     if (symbol_data_ & CFI) {
       mach_o::SectionMap::const_iterator debug_frame
           = section_map.find("__debug_frame");
       if (debug_frame != section_map.end()) {
         // If there is a problem reading this, don't treat it as a fatal error.
-        dumper_.ReadCFI(module_, reader_, debug_frame->second, false);
+        dumper_.ReadCFI(module_, reader_, debug_frame->second, object_name_,
+                        false);
       }
     }
   }
@@ -697,25 +808,37 @@ bool DumpSymbols::LoadCommandDumper::SymtabCommand(const ByteBuffer& entries,
   return true;
 }
 
-bool DumpSymbols::ReadSymbolData(Module** out_module) {
-  scoped_ptr<Module> module;
-  if (!CreateEmptyModule(module))
+bool DumpSymbols::ReadObjectFile(const SuperFatArch& object_file,
+                                 int num_threads,
+                                 scoped_ptr<Module>& module) const {
+  if (!CreateEmptyModule(object_file, module))
     return false;
 
-  // Parse the selected object file.
-  mach_o::Reader::Reporter reporter(selected_object_name_);
+  // Parse the object file.
+  string object_name = ObjectFileName(object_file);
+  mach_o::Reader::Reporter reporter(object_name);
   mach_o::Reader reader(&reporter);
   if (!reader.Read(&contents_[0]
-                   + selected_object_file_->offset,
-                   selected_object_file_->size,
-                   selected_object_file_->cputype,
-                   selected_object_file_->cpusubtype))
+                   + object_file.offset,
+                   object_file.size,
+                   object_file.cputype,
+                   object_file.cpusubtype))
     return false;
 
   // Walk its load commands, and deal with whatever is there.
   LoadCommandDumper load_command_dumper(*this, module.get(), reader,
-                                        symbol_data_, handle_inter_cu_refs_);
-  if (!reader.WalkLoadCommands(&load_command_dumper))
+                                        object_name, symbol_data_,
+                                        handle_inter_cu_refs_, num_threads);
+  return reader.WalkLoadCommands(&load_command_dumper);
+}
+
+bool DumpSymbols::ReadSymbolData(Module** out_module) {
+  const SuperFatArch* object_file = SelectedObjectFile();
+  if (!object_file)
+    return false;
+
+  scoped_ptr<Module> module;
+  if (!ReadObjectFile(*object_file, num_threads_, module))
     return false;
 
   *out_module = module.release();
@@ -723,12 +846,139 @@ bool DumpSymbols::ReadSymbolData(Module** out_module) {
   return true;
 }
 
+bool DumpSymbols::ReadAllSymbolData(
+    std::vector<std::unique_ptr<Module>>* modules) {
+  // Each object file gets a thread of its own, and an even share of the
+  // threads for reading DWARF.
+  size_t count = object_files_.size();
+  int num_threads = std::max(1, num_threads_ / static_cast<int>(count));
+  vector<scoped_ptr<Module>> read_modules(count);
+  vector<char> ok(count, false);
+  vector<std::thread> threads;
+  for (size_t i = 0; i < count; ++i) {
+    threads.emplace_back([this, i, num_threads, &read_modules, &ok]() {
+      ok[i] = ReadObjectFile(object_files_[i], num_threads, read_modules[i]);
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+
+  bool all_ok = true;
+  modules->clear();
+  for (size_t i = 0; i < count; ++i) {
+    if (ok[i]) {
+      modules->emplace_back(read_modules[i].release());
+    } else {
+      modules->emplace_back();
+      all_ok = false;
+    }
+  }
+  return all_ok;
+}
+
+bool DumpSymbols::ReadSharedCache(const string& filename) {
+  std::unique_ptr<SharedCache> shared_cache(new SharedCache(filename));
+  if (!shared_cache->MapFile(filename, true))
+    return false;
+
+  // A split cache's other files are named for the main file, with a
+  // numeric suffix: .1, .2, ... or .01, .02, ...
+  string prefix = google_breakpad::BaseName(filename) + ".";
+  for (const string& entry :
+       list_directory(google_breakpad::DirName(filename))) {
+    string name = google_breakpad::BaseName(entry);
+    if (name.size() <= prefix.size() || name.compare(0, prefix.size(),
+                                                     prefix) != 0 ||
+        name.find_first_not_of("0123456789", prefix.size()) != string::npos) {
+      continue;
+    }
+    if (!shared_cache->MapFile(entry, false))
+      return false;
+  }
+
+  shared_cache_ = std::move(shared_cache);
+  return true;
+}
+
+bool DumpSymbols::ReadSharedCacheImage(uint64_t address,
+                                       const string& install_name,
+                                       scoped_ptr<Module>& module) const {
+  string object_name = shared_cache_->filename() + ": " + install_name;
+  mach_o::Reader::Reporter reporter(object_name);
+  mach_o::Reader reader(&reporter);
+  if (!reader.ReadSharedCacheImage(shared_cache_->map(), address,
+                                   CPU_TYPE_ANY, 0)) {
+    return false;
+  }
+
+  UUIDFinder uuid_finder;
+  reader.WalkLoadCommands(&uuid_finder);
+  if (!uuid_finder.found()) {
+    fprintf(stderr, "%s: image has no UUID\n", object_name.c_str());
+    return false;
+  }
+
+  const char* arch_name = GetNameFromCPUType(reader.cpu_type(),
+                                             reader.cpu_subtype());
+  if (strcmp(arch_name, kUnknownArchName) == 0)
+    return false;
+  if (strcmp(arch_name, "i386") == 0)
+    arch_name = "x86";
+
+  // BaseName isn't safe to call on several threads at once.
+  string module_name = install_name.substr(install_name.rfind('/') + 1);
+  module.reset(new Module(module_name, "mac", arch_name,
+                          IdentifierFromUUID(uuid_finder.uuid()), "",
+                          enable_multiple_, prefer_extern_name_));
+
+  LoadCommandDumper load_command_dumper(*this, module.get(), reader,
+                                        object_name, symbol_data_,
+                                        handle_inter_cu_refs_, 1);
+  return reader.WalkLoadCommands(&load_command_dumper);
+}
+
+bool DumpSymbols::ReadSharedCacheSymbolData(
+    const SharedCacheImageHandler& handler) {
+  if (!shared_cache_)
+    return false;
+
+  // Each thread takes the next image no other thread has taken.
+  const vector<SharedCache::Image>& images = shared_cache_->images();
+  std::atomic<size_t> next_image(0);
+  std::atomic<bool> all_ok(true);
+  auto read_images = [&]() {
+    for (size_t i = next_image++; i < images.size(); i = next_image++) {
+      scoped_ptr<Module> module;
+      if (!ReadSharedCacheImage(images[i].address, images[i].install_name,
+                                module)) {
+        module.reset();
+        all_ok = false;
+      }
+      handler(images[i].install_name, std::unique_ptr<Module>(module.release()));
+    }
+  };
+
+  size_t thread_count =
+      std::min(images.size(), static_cast<size_t>(std::max(num_threads_, 1)));
+  vector<std::thread> threads;
+  for (size_t i = 1; i < thread_count; ++i)
+    threads.emplace_back(read_images);
+  read_images();
+  for (std::thread& thread : threads)
+    thread.join();
+  return all_ok;
+}
+
 // Read the selected object file's debugging information, and write out the
 // header only to |stream|. Return true on success; if an error occurs, report
 // it and return false.
 bool DumpSymbols::WriteSymbolFileHeader(std::ostream& stream) {
+  const SuperFatArch* object_file = SelectedObjectFile();
+  if (!object_file)
+    return false;
+
   scoped_ptr<Module> module;
-  if (!CreateEmptyModule(module))
+  if (!CreateEmptyModule(*object_file, module))
     return false;
 
   return module->Write(stream, symbol_data_);
@@ -38,6 +38,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <functional>
+#include <memory>
 #include <ostream>
 #include <string>
 #include <vector>
@@ -59,21 +61,8 @@ class DumpSymbols {
               bool handle_inter_cu_refs,
               bool enable_multiple = false,
               const std::string& module_name = "",
-              bool prefer_extern_name = false)
-      : symbol_data_(symbol_data),
-        handle_inter_cu_refs_(handle_inter_cu_refs),
-        object_filename_(),
-        contents_(),
-        size_(0),
-        from_disk_(false),
-        object_files_(),
-        selected_object_file_(),
-        selected_object_name_(),
-        enable_multiple_(enable_multiple),
-        module_name_(module_name),
-        prefer_extern_name_(prefer_extern_name),
-        report_warnings_(true) {}
-  ~DumpSymbols() = default;
+              bool prefer_extern_name = false);
+  ~DumpSymbols();
 
   // Prepare to read debugging information from |filename|. |filename| may be
   // the name of a fat file, a Mach-O file, or a dSYM bundle containing either
@@ -107,6 +96,11 @@ class DumpSymbols {
   // Set whether or not to report DWARF warnings
   void SetReportWarnings(bool report_warnings);
 
+  // Read each object file's DWARF compilation units on |num_threads|
+  // threads, when the units can be read independently of one another. The
+  // default is to read them one after the other on the calling thread.
+  void SetNumThreads(int num_threads);
+
   // Return a pointer to an array of SuperFatArch structures describing the
   // object files contained in this dumper's file. Set *|count| to the number
   // of elements in the array. The returned array is owned by this DumpSymbols
@@ -131,45 +125,95 @@ class DumpSymbols {
   // it when finished.
   bool ReadSymbolData(Module** module);
 
+  // Read the debugging information of every object file in this dumper's
+  // file, each on a thread of its own, and store it in |modules|, in the
+  // order AvailableArchitectures lists the object files. The object files
+  // are all read from the one copy of the file that Read or ReadData
+  // loaded. The entry for an object file that can't be read is NULL;
+  // return true only if every object file was read.
+  bool ReadAllSymbolData(std::vector<std::unique_ptr<Module>>* modules);
+
   // Return an identifier string for the file this DumpSymbols is dumping.
   std::string Identifier();
 
+  // Prepare to read debugging information from each image in the dyld
+  // shared cache |filename|. If the cache is split across several files,
+  // the others must be beside |filename|, named as dyld names them. The
+  // cache's files are mapped into memory once, for all the images. On
+  // success, return true; if there is a problem reading the cache, report
+  // it and return false.
+  bool ReadSharedCache(const std::string& filename);
+
+  // Called with the install name of each image in the shared cache, and a
+  // module holding its symbols, or NULL if the image couldn't be read.
+  typedef std::function<void(const std::string& install_name,
+                             std::unique_ptr<Module> module)>
+      SharedCacheImageHandler;
+
+  // Read every image in the shared cache that ReadSharedCache loaded, on
+  // the number of threads SetNumThreads set, passing each to |handler| as
+  // soon as it has been read. |handler| may be called on several threads
+  // at once. Return true only if every image was read.
+  bool ReadSharedCacheSymbolData(const SharedCacheImageHandler& handler);
+
  private:
   // Used internally.
-  class DumperLineToModule;
-  class DumperRangesHandler;
   class LoadCommandDumper;
+  class SharedCache;
 
   // This method behaves similarly to NXFindBestFatArch, but it supports
   // SuperFatArch.
   SuperFatArch* FindBestMatchForArchitecture(
       cpu_type_t cpu_type, cpu_subtype_t cpu_subtype);
 
-  // Creates an empty module object.
-  bool CreateEmptyModule(scoped_ptr<Module>& module);
+  // Return the object file selected to dump, selecting one first if
+  // SetArchitecture hasn't been called to select one explicitly. If no
+  // object file can be selected, report the problem and return NULL.
+  const SuperFatArch* SelectedObjectFile();
+
+  // Return a string that identifies |object_file| in error messages: the
+  // name of this dumper's file, and the object file's architecture if the
+  // file has more than one.
+  string ObjectFileName(const SuperFatArch& object_file) const;
 
-  // Process the split dwarf file referenced by reader.
-  void StartProcessSplitDwarf(google_breakpad::CompilationUnit* reader,
-                              Module* module,
-                              google_breakpad::Endianness endianness,
-                              bool handle_inter_cu_refs,
-                              bool handle_inline) const;
+  // Return an identifier string for |object_file|.
+  string Identifier(const SuperFatArch& object_file) const;
+
+  // Creates an empty module object for |object_file|.
+  bool CreateEmptyModule(const SuperFatArch& object_file,
+                         scoped_ptr<Module>& module) const;
+
+  // Read |object_file|'s debugging information into a new module, reading
+  // its DWARF compilation units on |num_threads| threads, and store the
+  // module in |module|.
+  bool ReadObjectFile(const SuperFatArch& object_file, int num_threads,
+                      scoped_ptr<Module>& module) const;
+
+  // Read the image in shared_cache_ whose header is at |address| and whose
+  // install name is |install_name| into a new module, and store it in
+  // |module|.
+  bool ReadSharedCacheImage(uint64_t address, const string& install_name,
+                            scoped_ptr<Module>& module) const;
 
   // Read debugging information from |dwarf_sections|, which was taken from
-  // |macho_reader|, and add it to |module|.
+  // |macho_reader|, and add it to |module|. Use |object_name| in error
+  // messages, and read compilation units on |num_threads| threads.
   void ReadDwarf(google_breakpad::Module* module,
                  const mach_o::Reader& macho_reader,
                  const mach_o::SectionMap& dwarf_sections,
-                 bool handle_inter_cu_refs) const;
+                 const string& object_name,
+                 bool handle_inter_cu_refs,
+                 int num_threads) const;
 
   // Read DWARF CFI or .eh_frame data from |section|, belonging to
   // |macho_reader|, and record it in |module|.  If |eh_frame| is true,
   // then the data is .eh_frame-format data; otherwise, it is standard DWARF
-  // .debug_frame data. On success, return true; on failure, report
-  // the problem and return false.
+  // .debug_frame data. Use |object_name| in error messages. On success,
+  // return true; on failure, report the problem and return false.
   bool ReadCFI(google_breakpad::Module* module,
                const mach_o::Reader& macho_reader,
                const mach_o::Section& section,
+               const string& object_name,
                bool eh_frame) const;
 
   // The selection of what type of symbol data to read/write.
@@ -204,12 +248,6 @@ class DumpSymbols {
   // SetArchitecture hasn't been called yet.
   const SuperFatArch* selected_object_file_;
 
-  // A string that identifies the selected object file, for use in error
-  // messages.  This is usually object_filename_, but if that refers to a
-  // fat binary, it includes an indication of the particular architecture
-  // within that binary.
-  string selected_object_name_;
-
   // Whether symbols sharing an address should be collapsed into a single entry
   // and marked with an `m` in the output. 
   // See: https://crbug.com/google-breakpad/751 and docs at 
@@ -231,6 +269,12 @@ class DumpSymbols {
 
   // Whether or not to report warnings
   bool report_warnings_;
+
+  // The number of threads to read each object file's DWARF on.
+  int num_threads_;
+
+  // The shared cache ReadSharedCache loaded, if any.
+  std::unique_ptr<SharedCache> shared_cache_;
 };
 
 }  // namespace google_breakpad
@@ -228,6 +228,24 @@ void Reader::Reporter::UnsupportedCPUType(cpu_type_t cpu_type) {
           filename_.c_str(), cpu_type);
 }
 
+void SharedCacheMap::AddMapping(uint64_t address, const uint8_t* contents,
+                                size_t size) {
+  mappings_[address] = ByteBuffer(contents, size);
+}
+
+ByteBuffer SharedCacheMap::Contents(uint64_t address) const {
+  map<uint64_t, ByteBuffer>::const_iterator mapping =
+      mappings_.upper_bound(address);
+  if (mapping == mappings_.begin())
+    return ByteBuffer();
+  --mapping;
+  uint64_t offset = address - mapping->first;
+  if (offset >= mapping->second.Size())
+    return ByteBuffer();
+  return ByteBuffer(mapping->second.start + offset,
+                    mapping->second.Size() - offset);
+}
+
 bool Reader::Read(const uint8_t* buffer,
                   size_t size,
                   cpu_type_t expected_cpu_type,
@@ -312,6 +330,23 @@ bool Reader::Read(const uint8_t* buffer,
   return true;
 }
 
+bool Reader::ReadSharedCacheImage(const SharedCacheMap& shared_cache,
+                                  uint64_t address,
+                                  cpu_type_t expected_cpu_type,
+                                  cpu_subtype_t expected_cpu_subtype) {
+  if (!Read(shared_cache.Contents(address), expected_cpu_type,
+            expected_cpu_subtype)) {
+    return false;
+  }
+  shared_cache_ = &shared_cache;
+
+  // Find __LINKEDIT before anyone asks for the symbol table. If there isn't
+  // one, the symbol table will be reported as misplaced.
+  FindSegment("__LINKEDIT", &linkedit_);
+  linkedit_.name = "__LINKEDIT";
+  return true;
+}
+
 bool Reader::WalkLoadCommands(Reader::LoadCommandHandler* handler) const {
   ByteCursor list_cursor(&load_commands_, big_endian_);
 
@@ -358,16 +393,27 @@ bool Reader::WalkLoadCommands(Reader::LoadCommandHandler* handler) const {
           reporter_->LoadCommandTooShort(index, type);
           return false;
         }
-        if (segment.fileoff > buffer_.Size() ||
-            segment.filesize > buffer_.Size() - segment.fileoff) {
+        if (shared_cache_) {
+          // Shared cache images' segments are found by address.
+          if (segment.filesize == 0) {
+            segment.contents.start = segment.contents.end = NULL;
+          } else {
+            segment.contents = shared_cache_->Contents(segment.vmaddr);
+            if (segment.contents.Size() < segment.filesize) {
+              reporter_->MisplacedSegmentData(segment.name);
+              return false;
+            }
+            segment.contents.end = segment.contents.start + segment.filesize;
+          }
+        } else if (segment.fileoff > buffer_.Size() ||
+                   segment.filesize > buffer_.Size() - segment.fileoff) {
           reporter_->MisplacedSegmentData(segment.name);
           return false;
-        }
-        // Mach-O files in .dSYM bundles have the contents of the loaded
-        // segments removed, and their file offsets and file sizes zeroed
-        // out. To help us handle this special case properly, give such
-        // segments' contents NULL starting and ending pointers.
-        if (segment.fileoff == 0 && segment.filesize == 0) {
+        } else if (segment.fileoff == 0 && segment.filesize == 0) {
+          // Mach-O files in .dSYM bundles have the contents of the loaded
+          // segments removed, and their file offsets and file sizes zeroed
+          // out. To help us handle this special case properly, give such
+          // segments' contents NULL starting and ending pointers.
           segment.contents.start = segment.contents.end = NULL;
         } else {
           segment.contents.start = buffer_.start + segment.fileoff;
@@ -395,13 +441,30 @@ bool Reader::WalkLoadCommands(Reader::LoadCommandHandler* handler) const {
         size_t symbol_size = bits_64_ ? 16 : 12;
         // How big is the entire symbol array?
         size_t symbols_size = nsyms * symbol_size;
-        if (symoff > buffer_.Size() || symbols_size > buffer_.Size() - symoff ||
-            stroff > buffer_.Size() || strsize > buffer_.Size() - stroff) {
+        // A shared cache image's symbol table lies in its __LINKEDIT
+        // segment, at offsets from the start of the file holding that.
+        ByteBuffer region = buffer_;
+        uint64_t region_offset = 0;
+        if (shared_cache_) {
+          // ReadSharedCacheImage is still looking for __LINKEDIT.
+          if (linkedit_.name.empty())
+            break;
+          region = linkedit_.contents;
+          region_offset = linkedit_.fileoff;
+        }
+        if (symoff < region_offset || stroff < region_offset) {
+          reporter_->MisplacedSymbolTable();
+          return false;
+        }
+        symoff -= region_offset;
+        stroff -= region_offset;
+        if (symoff > region.Size() || symbols_size > region.Size() - symoff ||
+            stroff > region.Size() || strsize > region.Size() - stroff) {
           reporter_->MisplacedSymbolTable();
           return false;
         }
-        ByteBuffer entries(buffer_.start + symoff, symbols_size);
-        ByteBuffer names(buffer_.start + stroff, strsize);
+        ByteBuffer entries(region.start + symoff, symbols_size);
+        ByteBuffer names(region.start + stroff, strsize);
         if (!handler->SymtabCommand(entries, names))
           return false;
         break;
@@ -420,41 +483,55 @@ bool Reader::WalkLoadCommands(Reader::LoadCommandHandler* handler) const {
   return true;
 }
 
-// A load command handler that looks for a segment of a given name.
-class Reader::SegmentFinder : public LoadCommandHandler {
+// A load command handler that collects every segment.
+class Reader::SegmentIndexer : public LoadCommandHandler {
  public:
-  // Create a load command handler that looks for a segment named NAME,
-  // and sets SEGMENT to describe it if found.
-  SegmentFinder(const string& name, Segment* segment)
-      : name_(name), segment_(segment), found_() { }
-
-  // Return true if the traversal found the segment, false otherwise.
-  bool found() const { return found_; }
+  // Create a load command handler that appends each segment to SEGMENTS.
+  explicit SegmentIndexer(vector<Segment>* segments) : segments_(segments) { }
 
   bool SegmentCommand(const Segment& segment) {
-    if (segment.name == name_) {
-      *segment_ = segment;
-      found_ = true;
-      return false;
-    }
+    segments_->push_back(segment);
     return true;
   }
 
  private:
-  // The name of the segment our creator is looking for.
-  const string& name_;
-
-  // Where we should store the segment if found. (WEAK)
-  Segment* segment_;
-
-  // True if we found the segment.
-  bool found_;
+  // Where we should store the segments. (WEAK)
+  vector<Segment>* segments_;
 };
 
+void Reader::IndexSegments() const {
+  std::call_once(segments_indexed_, [this]() {
+    // If a load command is malformed, the walk reports it and stops; the
+    // segments before it are still worth having.
+    SegmentIndexer indexer(&segments_);
+    WalkLoadCommands(&indexer);
+    for (size_t i = 0; i < segments_.size(); ++i)
+      segment_indices_.emplace(segments_[i].name, i);
+  });
+}
+
 bool Reader::FindSegment(const string& name, Segment* segment) const {
-  SegmentFinder finder(name, segment);
-  WalkLoadCommands(&finder);
-  return finder.found();
+  IndexSegments();
+  map<string, size_t>::const_iterator found = segment_indices_.find(name);
+  if (found == segment_indices_.end())
+    return false;
+  *segment = segments_[found->second];
+  return true;
+}
+
+const SectionMap* Reader::SegmentSections(const string& name) const {
+  std::lock_guard<std::mutex> lock(section_maps_lock_);
+  auto found = section_maps_.find(name);
+  if (found != section_maps_.end())
+    return found->second.get();
+
+  std::unique_ptr<SectionMap> section_map(new SectionMap);
+  Segment segment;
+  if (!FindSegment(name, &segment) ||
+      !MapSegmentSections(segment, section_map.get())) {
+    section_map.reset();
+  }
+  return (section_maps_[name] = std::move(section_map)).get();
 }
 
 bool Reader::WalkSegmentSections(const Segment& segment,
@@ -517,6 +594,19 @@ bool Reader::WalkSegmentSections(const Segment& segment,
       // this case; the caller may just need the section's load
       // address. But do set the contents' limits to NULL, for safety.
       section.contents.start = section.contents.end = NULL;
+    } else if (shared_cache_) {
+      // Shared cache images' sections are found by address, like their
+      // segments.
+      uint64_t start = section.address - segment.vmaddr;
+      if (section.address < segment.vmaddr ||
+          start > segment.contents.Size() ||
+          size > segment.contents.Size() - start) {
+        reporter_->MisplacedSectionData(section.section_name,
+                                        section.segment_name);
+        return false;
+      }
+      section.contents.start = segment.contents.start + start;
+      section.contents.end = section.contents.start + size;
     } else {
       if (offset < size_t(segment.contents.start - buffer_.start) ||
           offset > size_t(segment.contents.end - buffer_.start) ||
@@ -42,6 +42,8 @@
 #include <unistd.h>
 
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -225,6 +227,28 @@ struct Section {
 // A map from section names to Sections.
 typedef map<string, Section> SectionMap;
 
+// The contents of a dyld shared cache, as mapped into memory by the caller.
+//
+// The images in a shared cache are scattered through it, and a cache may
+// be split across several files, each of which holds some of each image's
+// segments. The file offsets in an image's load commands are relative to
+// whichever file holds the segment in question, so a Reader reading an
+// image from a shared cache finds its contents by address instead.
+class SharedCacheMap {
+ public:
+  // Record that the |size| bytes at |contents| are the cache's contents at
+  // |address|.
+  void AddMapping(uint64_t address, const uint8_t* contents, size_t size);
+
+  // Return the cache's contents from |address| to the end of the mapping
+  // holding it, or an empty buffer if no mapping holds it.
+  ByteBuffer Contents(uint64_t address) const;
+
+ private:
+  // The cache's mappings, by address.
+  map<uint64_t, ByteBuffer> mappings_;
+};
+
 // A reader for a Mach-O file.
 //
 // This does not handle fat binaries; see FatReader above. FatReader
@@ -362,7 +386,7 @@ class Reader {
 
   // Create a Mach-O file reader that reports problems to |reporter|.
   explicit Reader(Reporter* reporter)
-      : reporter_(reporter) { }
+      : reporter_(reporter), shared_cache_(NULL) { }
 
   // Read the given data as a Mach-O file. The reader retains pointers
   // into the data passed, so the data should live as long as the reader
@@ -383,6 +407,18 @@ class Reader {
                 expected_cpu_subtype);
   }
 
+  // Read the image whose Mach-O header is at |address| in |shared_cache|.
+  // The contents of its segments, sections and symbol table are found by
+  // address in |shared_cache|, rather than by file offset; |shared_cache|
+  // and the contents it maps should live as long as the reader does.
+  //
+  // At most one of this and Read should be invoked once on each Reader
+  // instance.
+  bool ReadSharedCacheImage(const SharedCacheMap& shared_cache,
+                            uint64_t address,
+                            cpu_type_t expected_cpu_type,
+                            cpu_subtype_t expected_cpu_subtype);
+
   // Return this file's characteristics, as found in the Mach-O header.
   cpu_type_t    cpu_type()    const { return cpu_type_; }
   cpu_subtype_t cpu_subtype() const { return cpu_subtype_; }
@@ -407,8 +443,18 @@ class Reader {
   // found, |segment|'s byte buffers refer to a subregion of the bytes
   // passed to Read. If we find the section, return true; otherwise,
   // return false.
+  //
+  // The first call walks the load commands once to index the segments;
+  // later calls just look the name up.
   bool FindSegment(const string& name, Segment* segment) const;
 
+  // Return a map of the sections in the segment named |name|, or NULL if
+  // there is no such segment or its section list is malformed. The map is
+  // built on the first request for it and kept as long as the reader is;
+  // its Sections' contents refer to the bytes passed to Read, so nothing
+  // is copied. This may be called on several threads at once.
+  const SectionMap* SegmentSections(const string& name) const;
+
   // Apply |handler| to each section defined in |segment|. If |handler| returns
   // false, stop iterating and return false. If all calls to |handler| return
   // true and we reach the end of the section list, return true.
@@ -424,9 +470,12 @@ class Reader {
 
  private:
   // Used internally.
-  class SegmentFinder;
+  class SegmentIndexer;
   class SectionMapper;
 
+  // Fill in segments_ and segment_indices_, unless that's been done.
+  void IndexSegments() const;
+
   // We use this to report problems parsing the file's contents. (WEAK)
   Reporter* reporter_;
 
@@ -455,6 +504,28 @@ class Reader {
 
   // This file's header flags.
   FileFlags flags_;
+
+  // If this is an image from a dyld shared cache, the cache; otherwise,
+  // NULL. (WEAK)
+  const SharedCacheMap* shared_cache_;
+
+  // If this is an image from a dyld shared cache, its __LINKEDIT segment,
+  // which holds its symbol table. Its name is empty until
+  // ReadSharedCacheImage has looked for it.
+  Segment linkedit_;
+
+  // This file's segments, in the order their load commands appear, and
+  // the index in segments_ of the first segment with each name. These are
+  // filled in by IndexSegments when they're first needed.
+  mutable std::once_flag segments_indexed_;
+  mutable vector<Segment> segments_;
+  mutable map<string, size_t> segment_indices_;
+
+  // The section maps SegmentSections has built so far, by segment name,
+  // and a lock for them. A null map means that segment's section list is
+  // malformed.
+  mutable std::mutex section_maps_lock_;
+  mutable map<string, std::unique_ptr<SectionMap>> section_maps_;
 };
 
 }  // namespace mach_o
@@ -35,6 +35,7 @@
 #include <config.h>  // Must come first
 #endif
 
+#include <list>
 #include <map>
 #include <string>
 #include <vector>
@@ -1755,6 +1756,56 @@ TEST_F(LoadCommand, FindSegment) {
   EXPECT_EQ(0xd6b0ce83, actual_segment.vmaddr);
 }
 
+TEST_F(LoadCommand, SegmentSections) {
+  WithConfiguration config(kLittleEndian, 64);
+
+  LoadedSection section1, section2;
+  section1.Append("blood orange");
+  section2.Append("yuzu");
+
+  LoadedSection segment1, segment2;
+  segment1.address() = 0x5ad0c3f1;
+  segment1.Place(&section1);
+  segment2.address() = 0x8b21e7a0;
+  segment2.Place(&section2);
+
+  SegmentLoadCommand segment_command1, segment_command2;
+  segment_command1
+      .Header("peel", segment1, 0x5d0d1b8e, 0x33e0d7b2, 0x45a3f9c1)
+      .AppendSectionEntry("zest", "peel", 12, 0x2a0f3b11, section1);
+  segment_command2
+      .Header("pith", segment2, 0x1f6a2c9e, 0x6e3b9d04, 0x0c8e7a52)
+      .AppendSectionEntry("juice", "pith", 12, 0x7d1c4e63, section2);
+
+  LoadCommands commands;
+  commands.Place(&segment_command1).Place(&segment_command2);
+
+  MachOFile file;
+  file.Header(&commands).Place(&segment1).Place(&segment2);
+
+  ReadFile(&file, true, CPU_TYPE_ANY, 0);
+
+  EXPECT_EQ(NULL, reader.SegmentSections("rind"));
+
+  const SectionMap* pith = reader.SegmentSections("pith");
+  ASSERT_TRUE(pith != NULL);
+  EXPECT_EQ(pith, reader.SegmentSections("pith"));
+  ASSERT_EQ(1U, pith->size());
+  const Section& juice = pith->begin()->second;
+  EXPECT_EQ("juice", juice.section_name);
+  EXPECT_EQ(0x8b21e7a0U, juice.address);
+  // The contents are those of the file the reader was given, not a copy.
+  EXPECT_GE(juice.contents.start, file_bytes);
+  EXPECT_LE(juice.contents.end, file_bytes + file_contents.size());
+  EXPECT_EQ("yuzu", string(reinterpret_cast<const char*>(juice.contents.start),
+                           juice.contents.Size()));
+
+  const SectionMap* peel = reader.SegmentSections("peel");
+  ASSERT_TRUE(peel != NULL);
+  ASSERT_TRUE(peel->find("zest") != peel->end());
+  EXPECT_EQ(0x5ad0c3f1U, peel->find("zest")->second.address);
+}
+
 
 // Symtab tests.
 
@@ -1948,3 +1999,128 @@ TEST_F(Symtab, SymtabMisplacedStrings) {
   EXPECT_FALSE(reader.WalkLoadCommands(&load_command_handler));
 }
 
+
+// An image from a dyld shared cache: its header, __TEXT segment and
+// __LINKEDIT segment are each copied to a buffer of their own, so that the
+// reader can only find them by address.
+class SharedCacheImage: public ReaderFixture, public Test {
+ public:
+  // Copy the |size| bytes at |offset| in file_contents into a buffer of
+  // their own, and map them at |address|.
+  void Map(uint64_t address, uint64_t offset, uint64_t size) {
+    copies.push_back(file_contents.substr(offset, size));
+    cache.AddMapping(address,
+                     reinterpret_cast<const uint8_t*>(copies.back().data()),
+                     size);
+  }
+
+  mach_o::SharedCacheMap cache;
+  std::list<string> copies;
+};
+
+TEST_F(SharedCacheImage, FindsContentsByAddress) {
+  WithConfiguration config(kLittleEndian, 64);
+
+  LoadedSection text(0x180004000ULL), section;
+  section.Append("ugli fruit");
+  text.Append(12, 0);
+  text.Place(&section);
+
+  StringAssembler strings;
+  SymbolAssembler symbols(&strings);
+  symbols.Symbol(0x0f, 0x01, 0, 0x180004010ULL, "_pomelo");
+  LoadedSection linkedit(0x1a0000000ULL);
+  linkedit.SizedSection::Place(&symbols).SizedSection::Place(&strings);
+
+  SegmentLoadCommand text_command;
+  text_command
+      .Header("__TEXT", text, 5, 5, 0)
+      .AppendSectionEntry("__text", "__TEXT", 2, 0, section);
+  SegmentLoadCommand linkedit_command;
+  linkedit_command.Header("__LINKEDIT", linkedit, 1, 1, 0);
+  SizedSection symtab_command;
+  symtab_command
+      .D32(LC_SYMTAB)                    // command
+      .D32(symtab_command.final_size())  // size
+      .D32(symbols.start())              // file offset of symbols
+      .D32(1)                            // symbol count
+      .D32(strings.start())              // file offset of strings
+      .D32(strings.final_size());        // strings size
+
+  // The symbol table comes first, before the reader has seen __LINKEDIT.
+  LoadCommands load_commands;
+  load_commands
+      .Place(&symtab_command)
+      .Place(&text_command)
+      .Place(&linkedit_command);
+
+  MachOFile file;
+  file.Header(&load_commands).Place(&text).Place(&linkedit);
+  ASSERT_TRUE(file.GetContents(&file_contents));
+
+  Map(0x180000000ULL, 0, text.start().Value());
+  Map(text.address().Value(), text.start().Value(),
+      text.final_size().Value());
+  Map(linkedit.address().Value(), linkedit.start().Value(),
+      linkedit.final_size().Value());
+  const uint8_t* text_copy =
+      reinterpret_cast<const uint8_t*>((++copies.begin())->data());
+  const uint8_t* linkedit_copy =
+      reinterpret_cast<const uint8_t*>(copies.back().data());
+
+  ASSERT_TRUE(reader.ReadSharedCacheImage(cache, 0x180000000ULL,
+                                          CPU_TYPE_ANY, 0));
+
+  ByteBuffer symbols_found, strings_found;
+  Segment text_found, linkedit_found;
+  {
+    InSequence s;
+    EXPECT_CALL(load_command_handler, SymtabCommand(_, _))
+        .WillOnce(DoAll(SaveArg<0>(&symbols_found),
+                        SaveArg<1>(&strings_found),
+                        Return(true)));
+    EXPECT_CALL(load_command_handler, SegmentCommand(_))
+        .WillOnce(DoAll(SaveArg<0>(&text_found), Return(true)))
+        .WillOnce(DoAll(SaveArg<0>(&linkedit_found), Return(true)));
+  }
+  EXPECT_TRUE(reader.WalkLoadCommands(&load_command_handler));
+
+  EXPECT_EQ(text_copy, text_found.contents.start);
+  EXPECT_EQ(text.final_size().Value(), text_found.contents.Size());
+  EXPECT_EQ(linkedit_copy, linkedit_found.contents.start);
+  EXPECT_EQ(linkedit_copy, symbols_found.start);
+  EXPECT_EQ(16U, symbols_found.Size());
+  EXPECT_EQ(linkedit_copy + symbols.final_size().Value(),
+            strings_found.start);
+  EXPECT_EQ(8U, strings_found.Size());
+
+  SectionMap sections;
+  ASSERT_TRUE(reader.MapSegmentSections(text_found, &sections));
+  ASSERT_EQ(1U, sections.count("__text"));
+  EXPECT_EQ("ugli fruit",
+            string(reinterpret_cast<const char*>(
+                       sections["__text"].contents.start),
+                   sections["__text"].contents.Size()));
+}
+
+TEST_F(SharedCacheImage, UnmappedSegment) {
+  WithConfiguration config(kLittleEndian, 64);
+
+  LoadedSection text(0x180004000ULL);
+  text.Append(16, 0);
+  SegmentLoadCommand text_command;
+  text_command.Header("__TEXT", text, 5, 5, 0);
+  LoadCommands load_commands;
+  load_commands.Place(&text_command);
+  MachOFile file;
+  file.Header(&load_commands).Place(&text);
+  ASSERT_TRUE(file.GetContents(&file_contents));
+
+  // Only the header is mapped.
+  Map(0x180000000ULL, 0, text.start().Value());
+
+  EXPECT_CALL(reporter, MisplacedSegmentData("__TEXT")).Times(2);
+  ASSERT_TRUE(reader.ReadSharedCacheImage(cache, 0x180000000ULL,
+                                          CPU_TYPE_ANY, 0));
+  EXPECT_FALSE(reader.WalkLoadCommands(&load_command_handler));
+}
@@ -51,19 +51,111 @@
 
 namespace google_breakpad {
 
+// A region of memory mapped, and faulted in, ahead of a crash, from which
+// PageAllocator takes pages before it asks the kernel for more. Writing a
+// minidump then needs no new mappings and takes no page faults, which
+// matters when the crash happens under memory pressure.
+//
+// The region is mapped shared, so a process cloned without CLONE_VM, such
+// as the one that writes a minidump, writes to the same physical pages
+// instead of taking copy-on-write faults. The count of pages handed out is
+// ordinary memory, so each cloned process starts from the count its parent
+// had, and pages the clone takes are free again once it exits.
+class PageReserve {
+ public:
+  PageReserve()
+      : page_size_(getpagesize()),
+        base_(NULL),
+        num_pages_(0),
+        pages_used_(0) {}
+
+  ~PageReserve() {
+    if (base_)
+      sys_munmap(base_, num_pages_ * page_size_);
+  }
+
+  // Maps |bytes|, rounded up to whole pages, and faults the pages in. The
+  // pages are locked into memory too where RLIMIT_MEMLOCK allows it.
+  // Returns false if the region can't be mapped. This may only be called
+  // once, and not from a compromised context.
+  bool Init(size_t bytes) {
+    if (base_ || !bytes)
+      return false;
+
+    const size_t num_pages = (bytes + page_size_ - 1) / page_size_;
+    int flags = MAP_SHARED | MAP_ANONYMOUS;
+#if defined(MAP_POPULATE)
+    flags |= MAP_POPULATE;
+#endif
+    void* a = sys_mmap(NULL, num_pages * page_size_, PROT_READ | PROT_WRITE,
+                       flags, -1, 0);
+    if (a == MAP_FAILED)
+      return false;
+
+#if defined(MEMORY_SANITIZER)
+    __msan_unpoison(a, num_pages * page_size_);
+#endif
+
+    if (mlock(a, num_pages * page_size_) != 0) {
+      // Without the lock the pages may be reclaimed later, but they are
+      // still mapped; touch them in case MAP_POPULATE did not.
+      for (size_t i = 0; i < num_pages; ++i)
+        static_cast<volatile uint8_t*>(a)[i * page_size_] = 0;
+    }
+
+    base_ = static_cast<uint8_t*>(a);
+    num_pages_ = num_pages;
+    return true;
+  }
+
+  // Returns |num_pages| contiguous pages, or NULL if the reserve doesn't
+  // have that many left. Pages are never given back.
+  uint8_t* TakePages(size_t num_pages) {
+    if (num_pages > num_pages_ - pages_used_)
+      return NULL;
+    uint8_t* const pages = base_ + pages_used_ * page_size_;
+    pages_used_ += num_pages;
+    return pages;
+  }
+
+  bool Contains(const void* p) const {
+    return p >= base_ && p < base_ + num_pages_ * page_size_;
+  }
+
+  size_t pages_left() const { return num_pages_ - pages_used_; }
+
+ private:
+  const size_t page_size_;
+  uint8_t* base_;
+  size_t num_pages_;
+  size_t pages_used_;
+};
+
 // This is very simple allocator which fetches pages from the kernel directly.
 // Thus, it can be used even when the heap may be corrupted.
 //
-// There is no free operation. The pages are only freed when the object is
-// destroyed.
+// Small requests are carved out of shared pages in 16-byte granules. Freed
+// small blocks are kept on per-size-class free lists, and freed multi-page
+// runs are kept on a run list where they are split and coalesced, so that
+// memory is recycled without ever calling back into the kernel. Nothing here
+// takes a lock or makes a syscall other than mmap, so it stays usable from a
+// signal handler. The pages are only returned to the kernel when the object
+// is destroyed.
+//
+// While a PageReserve is active, allocators constructed afterwards take
+// pages from it first, and only map pages of their own once it runs out.
 class PageAllocator {
  public:
   PageAllocator()
       : page_size_(getpagesize()),
+        reserve_(active_reserve()),
         last_(NULL),
         current_page_(NULL),
         page_offset_(0),
+        free_runs_(NULL),
         pages_allocated_(0) {
+    for (size_t i = 0; i < kNumSizeClasses; ++i)
+      free_blocks_[i] = NULL;
   }
 
   ~PageAllocator() {
@@ -74,29 +166,31 @@ class PageAllocator {
     if (!bytes)
       return NULL;
 
-    if (current_page_ && page_size_ - page_offset_ >= bytes) {
-      uint8_t* const ret = current_page_ + page_offset_;
-      page_offset_ += bytes;
-      if (page_offset_ == page_size_) {
-        page_offset_ = 0;
-        current_page_ = NULL;
-      }
-
-      return ret;
-    }
+    if (bytes <= kMaxSmallSize)
+      return AllocSmall(bytes);
 
-    const size_t pages =
-        (bytes + sizeof(PageHeader) + page_size_ - 1) / page_size_;
-    uint8_t* const ret = GetNPages(pages);
+    const size_t pages = PagesForLargeSize(bytes);
+    uint8_t* const ret = GetRun(pages);
     if (!ret)
       return NULL;
 
-    page_offset_ =
-        (page_size_ - (page_size_ * pages - (bytes + sizeof(PageHeader)))) %
-        page_size_;
-    current_page_ = page_offset_ ? ret + page_size_ * (pages - 1) : NULL;
+    return ret + kHeaderSize;
+  }
+
+  // Returns a block obtained from Alloc() to the allocator. |bytes| must be
+  // the size that was passed to Alloc(). The memory is not unmapped; it is
+  // handed out again by later calls to Alloc().
+  void Free(void* p, size_t bytes) {
+    if (!p || !bytes)
+      return;
 
-    return ret + sizeof(PageHeader);
+    if (bytes <= kMaxSmallSize) {
+      PushFreeBlock(reinterpret_cast<uint8_t*>(p), RoundUp(bytes));
+      return;
+    }
+
+    PushFreeRun(reinterpret_cast<uint8_t*>(p) - kHeaderSize,
+                PagesForLargeSize(bytes));
   }
 
   // Checks whether the page allocator owns the passed-in pointer.
@@ -111,20 +205,201 @@ class PageAllocator {
     return false;
   }
 
+  // The number of pages obtained from the kernel or the active reserve so
+  // far.
   unsigned long pages_allocated() { return pages_allocated_; }
 
+  // Makes |reserve| the reserve that allocators constructed from now on
+  // take pages from, or stops using one if |reserve| is NULL. This affects
+  // the whole process, so it is meant for a process that does nothing but
+  // write a minidump.
+  static void SetActiveReserve(PageReserve* reserve) {
+    active_reserve() = reserve;
+  }
+
  private:
+  // Small blocks are handed out in multiples of kAlignment and recycled
+  // through power-of-two size classes from kAlignment to kMaxSmallSize.
+  static const size_t kAlignment = 16;
+  static const size_t kNumSizeClasses = 8;
+  static const size_t kMaxSmallSize = kAlignment << (kNumSizeClasses - 1);
+
+  struct PageHeader {
+    PageHeader* next;  // pointer to the start of the next set of pages.
+    size_t num_pages;  // the number of pages in this set.
+  };
+
+  // Every mapping, and every multi-page run carved out of one, starts with
+  // kHeaderSize reserved bytes. Only the first run of a mapping stores its
+  // PageHeader there, but reserving the space everywhere lets runs be split
+  // and reused without disturbing the mapping list.
+  static const size_t kHeaderSize =
+      (sizeof(PageHeader) + kAlignment - 1) & ~(kAlignment - 1);
+
+  // A free small block, linked in place.
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  // A free run of whole pages. It lives kHeaderSize bytes into the run so
+  // that a PageHeader at the start of the run is left intact.
+  struct FreeRun {
+    FreeRun* next;
+    size_t num_pages;
+  };
+
+  static size_t RoundUp(size_t bytes) {
+    return (bytes + kAlignment - 1) & ~(kAlignment - 1);
+  }
+
+  // The smallest size class whose blocks hold |bytes|.
+  static size_t SizeClassFor(size_t bytes) {
+    size_t size_class = 0;
+    while ((kAlignment << size_class) < bytes)
+      ++size_class;
+    return size_class;
+  }
+
+  size_t PagesForLargeSize(size_t bytes) const {
+    return (bytes + kHeaderSize + page_size_ - 1) / page_size_;
+  }
+
+  static uint8_t* RunStart(FreeRun* run) {
+    return reinterpret_cast<uint8_t*>(run) - kHeaderSize;
+  }
+
+  void* AllocSmall(size_t bytes) {
+    const size_t size = RoundUp(bytes);
+    for (size_t i = SizeClassFor(size); i < kNumSizeClasses; ++i) {
+      FreeBlock* const block = free_blocks_[i];
+      if (!block)
+        continue;
+      free_blocks_[i] = block->next;
+      // Give back whatever the caller does not need from a larger block.
+      const size_t block_size = kAlignment << i;
+      if (block_size > size) {
+        PushFreeBlock(reinterpret_cast<uint8_t*>(block) + size,
+                      block_size - size);
+      }
+      return block;
+    }
+
+    if (!current_page_ || page_size_ - page_offset_ < size) {
+      // Recycle the tail of the exhausted page before moving on.
+      if (current_page_)
+        PushFreeBlock(current_page_ + page_offset_, page_size_ - page_offset_);
+      uint8_t* const page = GetRun(1);
+      if (!page) {
+        current_page_ = NULL;
+        return NULL;
+      }
+      current_page_ = page;
+      page_offset_ = kHeaderSize;
+    }
+
+    uint8_t* const ret = current_page_ + page_offset_;
+    page_offset_ += size;
+    return ret;
+  }
+
+  // Files a free region of |size| bytes, a multiple of kAlignment, under the
+  // largest size classes that fit it.
+  void PushFreeBlock(uint8_t* p, size_t size) {
+    while (size >= kAlignment) {
+      size_t size_class = kNumSizeClasses - 1;
+      while ((kAlignment << size_class) > size)
+        --size_class;
+      const size_t block_size = kAlignment << size_class;
+      FreeBlock* const block = reinterpret_cast<FreeBlock*>(p);
+      block->next = free_blocks_[size_class];
+      free_blocks_[size_class] = block;
+      p += block_size;
+      size -= block_size;
+    }
+  }
+
+  // Returns |num_pages| contiguous pages, preferring a recycled run over a
+  // fresh mapping.
+  uint8_t* GetRun(size_t num_pages) {
+    for (FreeRun** link = &free_runs_; *link; link = &(*link)->next) {
+      FreeRun* const run = *link;
+      if (run->num_pages < num_pages)
+        continue;
+      uint8_t* const start = RunStart(run);
+      if (run->num_pages == num_pages) {
+        *link = run->next;
+        return start;
+      }
+      // Hand out the tail so the free run keeps its position in the list.
+      run->num_pages -= num_pages;
+      return start + run->num_pages * page_size_;
+    }
+
+    return GetNPages(num_pages);
+  }
+
+  // Files a run of |num_pages| pages starting at |start| and merges it with
+  // free neighbours from the same mapping.
+  void PushFreeRun(uint8_t* start, size_t num_pages) {
+    bool starts_mapping = IsMappingStart(start);
+    FreeRun** link = &free_runs_;
+    while (*link) {
+      FreeRun* const run = *link;
+      uint8_t* const run_start = RunStart(run);
+      if (!starts_mapping &&
+          run_start + run->num_pages * page_size_ == start) {
+        // The new run extends a free run that precedes it. Start over, since
+        // the merged run may now touch one that was already passed.
+        *link = run->next;
+        num_pages += run->num_pages;
+        start = run_start;
+        starts_mapping = IsMappingStart(start);
+        link = &free_runs_;
+        continue;
+      }
+      if (start + num_pages * page_size_ == run_start &&
+          !IsMappingStart(run_start)) {
+        // The new run is directly followed by a free run.
+        *link = run->next;
+        num_pages += run->num_pages;
+        continue;
+      }
+      link = &run->next;
+    }
+
+    FreeRun* const run = reinterpret_cast<FreeRun*>(start + kHeaderSize);
+    run->next = free_runs_;
+    run->num_pages = num_pages;
+    free_runs_ = run;
+  }
+
+  bool IsMappingStart(const uint8_t* p) const {
+    for (PageHeader* header = last_; header; header = header->next) {
+      if (reinterpret_cast<const uint8_t*>(header) == p)
+        return true;
+    }
+    return false;
+  }
+
+  static PageReserve*& active_reserve() {
+    static PageReserve* reserve = NULL;
+    return reserve;
+  }
+
   uint8_t* GetNPages(size_t num_pages) {
-    void* a = sys_mmap(NULL, page_size_ * num_pages, PROT_READ | PROT_WRITE,
-                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-    if (a == MAP_FAILED)
-      return NULL;
+    void* a = reserve_ ? reserve_->TakePages(num_pages) : NULL;
+    if (!a) {
+      a = sys_mmap(NULL, page_size_ * num_pages, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (a == MAP_FAILED)
+        return NULL;
 
 #if defined(MEMORY_SANITIZER)
-    // We need to indicate to MSan that memory allocated through sys_mmap is
-    // initialized, since linux_syscall_support.h doesn't have MSan hooks.
-    __msan_unpoison(a, page_size_ * num_pages);
+      // We need to indicate to MSan that memory allocated through sys_mmap is
+      // initialized, since linux_syscall_support.h doesn't have MSan hooks.
+      __msan_unpoison(a, page_size_ * num_pages);
 #endif
+    }
 
     struct PageHeader* header = reinterpret_cast<PageHeader*>(a);
     header->next = last_;
@@ -141,19 +416,18 @@ class PageAllocator {
 
     for (PageHeader* cur = last_; cur; cur = next) {
       next = cur->next;
-      sys_munmap(cur, cur->num_pages * page_size_);
+      if (!reserve_ || !reserve_->Contains(cur))
+        sys_munmap(cur, cur->num_pages * page_size_);
     }
   }
 
-  struct PageHeader {
-    PageHeader* next;  // pointer to the start of the next set of pages.
-    size_t num_pages;  // the number of pages in this set.
-  };
-
   const size_t page_size_;
+  PageReserve* const reserve_;
   PageHeader* last_;
   uint8_t* current_page_;
   size_t page_offset_;
+  FreeBlock* free_blocks_[kNumSizeClasses];
+  FreeRun* free_runs_;
   unsigned long pages_allocated_;
 };
 
@@ -192,8 +466,10 @@ struct PageStdAllocator {
     return static_cast<pointer>(allocator_.Alloc(size));
   }
 
-  inline void deallocate(pointer, size_type) {
-    // The PageAllocator doesn't free.
+  inline void deallocate(pointer p, size_type n) {
+    if (p == stackdata_)
+      return;
+    allocator_.Free(p, sizeof(T) * n);
   }
 
   template <typename U> struct rebind {
@@ -213,7 +489,8 @@ struct PageStdAllocator {
 
 // A wasteful vector is a std::vector, except that it allocates memory from a
 // PageAllocator. It's wasteful because, when resizing, it always allocates a
-// whole new array since the PageAllocator doesn't support realloc.
+// whole new array since the PageAllocator doesn't support realloc. The old
+// array is handed back to the PageAllocator and reused by later allocations.
 template<class T>
 class wasteful_vector : public std::vector<T, PageStdAllocator<T> > {
  public:
@@ -30,6 +30,10 @@
 #include <config.h>  // Must come first
 #endif
 
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
 #include "breakpad_googletest_includes.h"
 #include "common/memory_allocator.h"
 
@@ -125,3 +129,136 @@ TEST(WastefulVectorTest, AutoWastefulVector) {
   EXPECT_EQ(1U, allocator_.pages_allocated());
   EXPECT_TRUE(allocator_.OwnsPointer(&v[0]));
 }
+
+TEST(PageAllocatorTest, FreedSmallBlockIsReused) {
+  PageAllocator allocator;
+
+  void* p = allocator.Alloc(64);
+  ASSERT_FALSE(p == NULL);
+  allocator.Free(p, 64);
+  EXPECT_EQ(p, allocator.Alloc(50));
+  EXPECT_EQ(1U, allocator.pages_allocated());
+}
+
+TEST(PageAllocatorTest, FreedLargeRunIsReused) {
+  PageAllocator allocator;
+
+  void* p = allocator.Alloc(10000);
+  ASSERT_FALSE(p == NULL);
+  EXPECT_EQ(3U, allocator.pages_allocated());
+  allocator.Free(p, 10000);
+
+  // A smaller request is carved out of the freed run.
+  void* q = allocator.Alloc(5000);
+  ASSERT_FALSE(q == NULL);
+  EXPECT_TRUE(allocator.OwnsPointer(q));
+  memset(q, 0, 5000);
+  // So are small requests, from the page that is left over.
+  void* r = allocator.Alloc(16);
+  ASSERT_FALSE(r == NULL);
+  EXPECT_TRUE(allocator.OwnsPointer(r));
+  EXPECT_EQ(3U, allocator.pages_allocated());
+}
+
+TEST(PageAllocatorTest, FreedRunsCoalesce) {
+  PageAllocator allocator;
+
+  void* p = allocator.Alloc(10000);
+  ASSERT_FALSE(p == NULL);
+  allocator.Free(p, 10000);
+  void* a = allocator.Alloc(5000);
+  void* b = allocator.Alloc(3000);
+  ASSERT_FALSE(a == NULL);
+  ASSERT_FALSE(b == NULL);
+  EXPECT_EQ(3U, allocator.pages_allocated());
+
+  // Once both are back, the whole run is available again.
+  allocator.Free(a, 5000);
+  allocator.Free(b, 3000);
+  void* c = allocator.Alloc(10000);
+  ASSERT_FALSE(c == NULL);
+  memset(c, 0, 10000);
+  EXPECT_EQ(3U, allocator.pages_allocated());
+}
+
+TEST(WastefulVectorTest, GrowthRecyclesPages) {
+  PageAllocator allocator_;
+  wasteful_vector<unsigned> v(&allocator_);
+  for (unsigned i = 0; i < 16384; ++i)
+    v.push_back(i);
+  const unsigned long pages = allocator_.pages_allocated();
+
+  // The arrays |v| outgrew are enough for a second, smaller vector.
+  wasteful_vector<unsigned> w(&allocator_);
+  for (unsigned i = 0; i < 4096; ++i)
+    w.push_back(i);
+  EXPECT_EQ(pages, allocator_.pages_allocated());
+
+  for (unsigned i = 0; i < 16384; ++i)
+    ASSERT_EQ(v[i], i);
+  for (unsigned i = 0; i < 4096; ++i)
+    ASSERT_EQ(w[i], i);
+}
+
+TEST(PageAllocatorTest, TakesPagesFromActiveReserve) {
+  const size_t page_size = getpagesize();
+  PageReserve reserve;
+  ASSERT_TRUE(reserve.Init(4 * page_size));
+  EXPECT_FALSE(reserve.Init(page_size));
+
+  PageAllocator::SetActiveReserve(&reserve);
+  {
+    PageAllocator allocator;
+    void* p = allocator.Alloc(2 * page_size);
+    ASSERT_FALSE(p == NULL);
+    EXPECT_TRUE(reserve.Contains(p));
+    EXPECT_EQ(1U, reserve.pages_left());
+
+    // Once the reserve runs out, pages are mapped instead.
+    void* q = allocator.Alloc(2 * page_size);
+    ASSERT_FALSE(q == NULL);
+    EXPECT_FALSE(reserve.Contains(q));
+    memset(p, 0, 2 * page_size);
+    memset(q, 0, 2 * page_size);
+  }
+  PageAllocator::SetActiveReserve(NULL);
+
+  // Allocators constructed after the reserve is deactivated don't use it.
+  PageAllocator allocator;
+  void* p = allocator.Alloc(16);
+  ASSERT_FALSE(p == NULL);
+  EXPECT_FALSE(reserve.Contains(p));
+  EXPECT_EQ(1U, reserve.pages_left());
+}
+
+TEST(PageAllocatorTest, ReserveIsSharedWithForkedProcess) {
+  const size_t page_size = getpagesize();
+  PageReserve reserve;
+  ASSERT_TRUE(reserve.Init(page_size));
+
+  pid_t child = fork();
+  ASSERT_NE(-1, child);
+  if (child == 0) {
+    PageAllocator::SetActiveReserve(&reserve);
+    PageAllocator allocator;
+    char* p = static_cast<char*>(allocator.Alloc(16));
+    if (!p || !reserve.Contains(p))
+      _exit(1);
+    strcpy(p, "child");
+    _exit(0);
+  }
+  int status;
+  ASSERT_EQ(child, waitpid(child, &status, 0));
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(0, WEXITSTATUS(status));
+
+  // The child's pages were taken from the parent's count, which is
+  // untouched.
+  EXPECT_EQ(1U, reserve.pages_left());
+  PageAllocator::SetActiveReserve(&reserve);
+  PageAllocator allocator;
+  PageAllocator::SetActiveReserve(NULL);
+  char* p = static_cast<char*>(allocator.Alloc(16));
+  ASSERT_TRUE(reserve.Contains(p));
+  EXPECT_STREQ("child", p);
+}
@@ -46,14 +46,266 @@
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <thread>
 #include <utility>
 
 namespace google_breakpad {
 
-using std::dec;
-using std::hex;
 using std::unique_ptr;
 
+namespace {
+
+// Stack frame entries spilled under Module::SetStackFrameEntryLimit are
+// written in a simple native-endian form, since they are only ever read
+// back by the process that wrote them.  Staged functions written by
+// Module::WriteStagedData use the same form, led by kStagedDataMagic so
+// that a host of the other byte order doesn't misread them.
+
+const uint64_t kStagedDataMagic = 0x4250535441474531ULL;  // "BPSTAGE1"
+
+bool SpillNumber(FILE* file, uint64_t number) {
+  return fwrite(&number, sizeof(number), 1, file) == 1;
+}
+
+bool UnspillNumber(FILE* file, uint64_t* number) {
+  return fread(number, sizeof(*number), 1, file) == 1;
+}
+
+bool SpillString(FILE* file, const string& str) {
+  return SpillNumber(file, str.size()) &&
+         fwrite(str.data(), 1, str.size(), file) == str.size();
+}
+
+bool UnspillString(FILE* file, string* str) {
+  uint64_t size;
+  if (!UnspillNumber(file, &size))
+    return false;
+  str->resize(size);
+  return fread(&(*str)[0], 1, size, file) == size;
+}
+
+bool SpillInt(FILE* file, int number) {
+  return SpillNumber(file, static_cast<uint64_t>(static_cast<int64_t>(number)));
+}
+
+bool UnspillInt(FILE* file, int* number) {
+  uint64_t value;
+  if (!UnspillNumber(file, &value))
+    return false;
+  *number = static_cast<int>(static_cast<int64_t>(value));
+  return true;
+}
+
+bool SpillRanges(FILE* file, const vector<Module::Range>& ranges) {
+  if (!SpillNumber(file, ranges.size()))
+    return false;
+  for (const Module::Range& range : ranges) {
+    if (!SpillNumber(file, range.address) || !SpillNumber(file, range.size))
+      return false;
+  }
+  return true;
+}
+
+// Staged data read back is moved ADDRESS_DELTA bytes as it is read.
+bool UnspillRanges(FILE* file, vector<Module::Range>* ranges,
+                   uint64_t address_delta) {
+  uint64_t count;
+  if (!UnspillNumber(file, &count))
+    return false;
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t address, size;
+    if (!UnspillNumber(file, &address) || !UnspillNumber(file, &size))
+      return false;
+    ranges->emplace_back(address + address_delta, size);
+  }
+  return true;
+}
+
+// Source files and inline origins are written as indices into the tables
+// written ahead of the functions.  File index zero stands for no file.
+typedef unordered_map<const Module::File*, uint64_t> FileIndices;
+typedef unordered_map<const Module::InlineOrigin*, uint64_t> OriginIndices;
+
+bool SpillInlines(FILE* file,
+                  const vector<unique_ptr<Module::Inline>>& inlines,
+                  const FileIndices& files, const OriginIndices& origins) {
+  if (!SpillNumber(file, inlines.size()))
+    return false;
+  for (const unique_ptr<Module::Inline>& in : inlines) {
+    OriginIndices::const_iterator origin = origins.find(in->origin);
+    FileIndices::const_iterator call_site_file =
+        files.find(in->call_site_file);
+    if (origin == origins.end() ||
+        (in->call_site_file && call_site_file == files.end()))
+      return false;
+    if (!SpillNumber(file, origin->second) ||
+        !SpillRanges(file, in->ranges) ||
+        !SpillInt(file, in->call_site_line) ||
+        !SpillInt(file, in->call_site_file_id) ||
+        !SpillNumber(file, in->call_site_file ? call_site_file->second : 0) ||
+        !SpillInt(file, in->inline_nest_level) ||
+        !SpillInlines(file, in->child_inlines, files, origins))
+      return false;
+  }
+  return true;
+}
+
+bool UnspillInlines(FILE* file, vector<unique_ptr<Module::Inline>>* inlines,
+                    const vector<Module::File*>& files,
+                    const vector<Module::InlineOrigin*>& origins,
+                    uint64_t address_delta) {
+  uint64_t count;
+  if (!UnspillNumber(file, &count))
+    return false;
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t origin, call_site_file;
+    vector<Module::Range> ranges;
+    int call_site_line, call_site_file_id, inline_nest_level;
+    vector<unique_ptr<Module::Inline>> child_inlines;
+    if (!UnspillNumber(file, &origin) || origin >= origins.size() ||
+        !UnspillRanges(file, &ranges, address_delta) ||
+        !UnspillInt(file, &call_site_line) ||
+        !UnspillInt(file, &call_site_file_id) ||
+        !UnspillNumber(file, &call_site_file) ||
+        call_site_file >= files.size() ||
+        !UnspillInt(file, &inline_nest_level) ||
+        !UnspillInlines(file, &child_inlines, files, origins,
+                        address_delta))
+      return false;
+    inlines->push_back(std::make_unique<Module::Inline>(
+        origins[origin], ranges, call_site_line, call_site_file_id,
+        inline_nest_level, std::move(child_inlines)));
+    inlines->back()->call_site_file = files[call_site_file];
+  }
+  return true;
+}
+
+bool SpillFunction(FILE* file, const Module::Function& func,
+                   const FileIndices& files, const OriginIndices& origins) {
+  if (!SpillString(file, func.name.str()) ||
+      !SpillNumber(file, func.address) ||
+      !SpillNumber(file, func.parameter_size) ||
+      !SpillNumber(file, func.is_multiple) ||
+      !SpillNumber(file, func.prefer_extern_name) ||
+      !SpillRanges(file, func.ranges) ||
+      !SpillNumber(file, func.lines.size()))
+    return false;
+  for (const Module::Line& line : func.lines) {
+    FileIndices::const_iterator line_file = files.find(line.file);
+    if (line.file && line_file == files.end())
+      return false;
+    if (!SpillNumber(file, line.address) ||
+        !SpillNumber(file, line.size) ||
+        !SpillNumber(file, line.file ? line_file->second : 0) ||
+        !SpillInt(file, line.number))
+      return false;
+  }
+  return SpillInlines(file, func.inlines, files, origins);
+}
+
+// Read a function written by SpillFunction into FUNC, with its name in
+// MODULE's string pool.
+bool UnspillFunction(FILE* file, Module* module,
+                     const vector<Module::File*>& files,
+                     const vector<Module::InlineOrigin*>& origins,
+                     uint64_t address_delta,
+                     unique_ptr<Module::Function>* func) {
+  string name;
+  uint64_t address, is_multiple, prefer_extern_name, line_count;
+  if (!UnspillString(file, &name) || !UnspillNumber(file, &address))
+    return false;
+  func->reset(new Module::Function(module->AddStringToPool(name),
+                                   address + address_delta));
+  Module::Function* read = func->get();
+  if (!UnspillNumber(file, &read->parameter_size) ||
+      !UnspillNumber(file, &is_multiple) ||
+      !UnspillNumber(file, &prefer_extern_name) ||
+      !UnspillRanges(file, &read->ranges, address_delta) ||
+      !UnspillNumber(file, &line_count))
+    return false;
+  read->is_multiple = is_multiple;
+  read->prefer_extern_name = prefer_extern_name;
+  read->lines.reserve(line_count);
+  for (uint64_t i = 0; i < line_count; ++i) {
+    Module::Line line;
+    uint64_t line_file;
+    if (!UnspillNumber(file, &line.address) ||
+        !UnspillNumber(file, &line.size) ||
+        !UnspillNumber(file, &line_file) || line_file >= files.size() ||
+        !UnspillInt(file, &line.number))
+      return false;
+    line.address += address_delta;
+    line.file = files[line_file];
+    read->lines.push_back(line);
+  }
+  return UnspillInlines(file, &read->inlines, files, origins, address_delta);
+}
+
+// Return true if one of FUNC's ranges covers one of ADDRESSES, which are
+// sorted.
+bool CoversAnyAddress(const Module::Function& func,
+                      const vector<Module::Address>& addresses) {
+  return std::any_of(func.ranges.begin(), func.ranges.end(),
+                     [&addresses](const Module::Range& range) {
+    auto it = std::lower_bound(addresses.begin(), addresses.end(),
+                               range.address);
+    return it != addresses.end() && *it - range.address < range.size;
+  });
+}
+
+bool SpillRuleMap(FILE* file, const Module::RuleMap& rule_map) {
+  if (!SpillNumber(file, rule_map.size()))
+    return false;
+  for (const auto& rule : rule_map) {
+    if (!SpillString(file, rule.first) || !SpillString(file, rule.second))
+      return false;
+  }
+  return true;
+}
+
+bool UnspillRuleMap(FILE* file, Module::RuleMap* rule_map) {
+  uint64_t count;
+  if (!UnspillNumber(file, &count))
+    return false;
+  string name, rule;
+  for (uint64_t i = 0; i < count; ++i) {
+    if (!UnspillString(file, &name) || !UnspillString(file, &rule))
+      return false;
+    (*rule_map)[name] = rule;
+  }
+  return true;
+}
+
+bool SpillStackFrameEntry(FILE* file, const Module::StackFrameEntry& entry) {
+  if (!SpillNumber(file, entry.address) || !SpillNumber(file, entry.size) ||
+      !SpillRuleMap(file, entry.initial_rules) ||
+      !SpillNumber(file, entry.rule_changes.size()))
+    return false;
+  for (const auto& change : entry.rule_changes) {
+    if (!SpillNumber(file, change.first) || !SpillRuleMap(file, change.second))
+      return false;
+  }
+  return true;
+}
+
+bool UnspillStackFrameEntry(FILE* file, Module::StackFrameEntry* entry) {
+  uint64_t count;
+  if (!UnspillNumber(file, &entry->address) ||
+      !UnspillNumber(file, &entry->size) ||
+      !UnspillRuleMap(file, &entry->initial_rules) ||
+      !UnspillNumber(file, &count))
+    return false;
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t address;
+    if (!UnspillNumber(file, &address) ||
+        !UnspillRuleMap(file, &entry->rule_changes[address]))
+      return false;
+  }
+  return true;
+}
+
+}  // namespace
+
 Module::InlineOrigin* Module::InlineOriginMap::GetOrCreateInlineOrigin(
     uint64_t offset,
     StringView name) {
@@ -113,17 +365,27 @@ Module::Module(const string& name,
       architecture_(architecture),
       id_(id),
       code_id_(code_id),
+      partial_(false),
       load_address_(0),
+      functions_sorted_(true),
+      function_limit_(0),
+      spilled_files_(1, nullptr),
+      stack_frame_spill_(NULL),
+      stack_frame_spill_size_(0),
+      stack_frame_entry_limit_(0),
+      write_threads_(1),
       enable_multiple_field_(enable_multiple_field),
       prefer_extern_name_(prefer_extern_name) {}
 
 Module::~Module() {
   for (FileByNameMap::iterator it = files_.begin(); it != files_.end(); ++it)
     delete it->second;
-  for (FunctionSet::iterator it = functions_.begin();
-       it != functions_.end(); ++it) {
-    delete *it;
-  }
+  for (Function* function : functions_)
+    delete function;
+  for (const FunctionRun& run : function_runs_)
+    fclose(run.file);
+  if (stack_frame_spill_)
+    fclose(stack_frame_spill_);
 }
 
 void Module::SetLoadAddress(Address address) {
@@ -166,7 +428,8 @@ bool Module::AddFunction(Function* function) {
       // Don't mark multiple in this case.
       if (name_mismatch &&
           (function->name == "<name omitted>" ||
-           found_ext->name.find(function->name.str()) != string::npos)) {
+           found_ext->name.str().find(function->name.str()) !=
+               string::npos)) {
         is_multiple_based_on_name = false;
       } else {
         is_multiple_based_on_name = name_mismatch;
@@ -176,7 +439,7 @@ bool Module::AddFunction(Function* function) {
           is_multiple_based_on_name || found_ext->is_multiple;
     }
     if (name_mismatch && prefer_extern_name_) {
-      function->name = AddStringToPool(it_ext->get()->name);
+      function->name = it_ext->get()->name;
     }
     externs_.erase(it_ext);
   }
@@ -191,22 +454,153 @@ bool Module::AddFunction(Function* function) {
     }
   }
 #endif
-  if (enable_multiple_field_ && function_addresses_.count(function->address)) {
-    FunctionSet::iterator existing_function = std::find_if(
-        functions_.begin(), functions_.end(),
-        [&](Function* other) { return other->address == function->address; });
-    assert(existing_function != functions_.end());
-    (*existing_function)->is_multiple = true;
+  auto same_address = functions_by_address_.equal_range(function->address);
+  if (enable_multiple_field_ && same_address.first != same_address.second) {
+    same_address.first->second->is_multiple = true;
     // Free the duplicate that was not inserted because this Module
     // now owns it.
     return false;
   }
-  function_addresses_.emplace(function->address);
-  std::pair<FunctionSet::iterator, bool> ret = functions_.insert(function);
-  if (!ret.second && (*ret.first != function)) {
-    // Free the duplicate that was not inserted because this Module
-    // now owns it.
-    return false;
+  for (auto it = same_address.first; it != same_address.second; ++it) {
+    if (it->second->name == function->name) {
+      // Free the duplicate that was not inserted because this Module
+      // now owns it.
+      return it->second == function;
+    }
+  }
+  functions_by_address_.emplace(function->address, function);
+  if (!functions_.empty() && FunctionCompare()(function, functions_.back()))
+    functions_sorted_ = false;
+  functions_.push_back(function);
+  return true;
+}
+
+void Module::CheckFunctionLimit() {
+  if (function_limit_ && functions_.size() >= function_limit_)
+    SpillFunctions();
+}
+
+void Module::SpillFunctions() {
+  SortFunctions();
+
+  // Index the files and inline origins these functions refer to that
+  // earlier runs didn't.
+  auto index_file = [this](File* file) {
+    if (file && spilled_file_indices_.emplace(file,
+                                              spilled_files_.size()).second)
+      spilled_files_.push_back(file);
+  };
+  for (Function* func : functions_) {
+    for (const Line& line : func->lines)
+      index_file(line.file);
+    Inline::InlineDFS(func->inlines, [&](unique_ptr<Inline>& in) {
+      index_file(in->call_site_file);
+      if (spilled_origin_indices_.emplace(in->origin,
+                                          spilled_origins_.size()).second)
+        spilled_origins_.push_back(in->origin);
+    });
+  }
+
+  FILE* file = tmpfile();
+  bool spilled = file != NULL;
+  for (size_t i = 0; spilled && i < functions_.size(); ++i) {
+    spilled = SpillFunction(file, *functions_[i], spilled_file_indices_,
+                            spilled_origin_indices_);
+  }
+  if (!spilled) {
+    fprintf(stderr, "error spilling functions: %s\n", strerror(errno));
+    if (file)
+      fclose(file);
+    function_limit_ = 0;
+    return;
+  }
+  function_runs_.push_back({file, functions_.size()});
+  for (Function* func : functions_)
+    delete func;
+  functions_.clear();
+  functions_by_address_.clear();
+}
+
+bool Module::MergeFunctions(
+    const std::function<bool(Function*)>& write_function) {
+  // The next function from each run, and then from functions_, which
+  // holds those added last; NULL once a source is used up.  Those read
+  // back from runs are owned by SPILLED.
+  const size_t source_count = function_runs_.size() + 1;
+  vector<Function*> heads(source_count, nullptr);
+  vector<unique_ptr<Function>> spilled(function_runs_.size());
+  vector<size_t> taken(source_count, 0);
+  auto advance = [&](size_t source) {
+    heads[source] = nullptr;
+    if (source == function_runs_.size()) {
+      if (taken[source] < functions_.size())
+        heads[source] = functions_[taken[source]++];
+      return true;
+    }
+    const FunctionRun& run = function_runs_[source];
+    if (taken[source] == run.count)
+      return true;
+    ++taken[source];
+    if (!UnspillFunction(run.file, this, spilled_files_, spilled_origins_, 0,
+                         &spilled[source]))
+      return false;
+    heads[source] = spilled[source].get();
+    return true;
+  };
+
+  SortFunctions();
+  for (const FunctionRun& run : function_runs_) {
+    fflush(run.file);
+    fseek(run.file, 0, SEEK_SET);
+  }
+  for (size_t source = 0; source < source_count; ++source) {
+    if (!advance(source))
+      return false;
+  }
+
+  FunctionCompare less;
+  for (;;) {
+    // Take the least function, from the earliest source on a tie, which
+    // was added first.  Each source holds at most one function per
+    // address when symbols sharing one are collapsed, and AddFunction
+    // keeps the first added, so take that.
+    size_t least = source_count;
+    for (size_t source = 0; source < source_count; ++source) {
+      if (heads[source] &&
+          (least == source_count || less(heads[source], heads[least])))
+        least = source;
+    }
+    if (least == source_count)
+      break;
+    Function* func = heads[least];
+    if (enable_multiple_field_) {
+      for (size_t source = 0; source < least; ++source) {
+        if (heads[source] && heads[source]->address == func->address) {
+          least = source;
+          func = heads[source];
+          break;
+        }
+      }
+    }
+
+    // Drop the functions of later sources that AddFunction would have
+    // dropped as duplicates of this one.
+    for (size_t source = least + 1; source < source_count; ++source) {
+      while (heads[source] && heads[source]->address == func->address &&
+             (enable_multiple_field_ || heads[source]->name == func->name)) {
+        if (enable_multiple_field_)
+          func->is_multiple = true;
+        if (!advance(source))
+          return false;
+      }
+    }
+
+    if ((retained_addresses_.empty() ||
+         CoversAnyAddress(*func, retained_addresses_)) &&
+        !write_function(func))
+      return false;
+    if (!advance(least))
+      return false;
   }
   return true;
 }
@@ -216,7 +610,36 @@ void Module::AddStackFrameEntry(std::unique_ptr<StackFrameEntry> stack_frame_ent
     return;
   }
 
+  StoreStackFrameEntry(std::move(stack_frame_entry));
+}
+
+void Module::StoreStackFrameEntry(
+    std::unique_ptr<StackFrameEntry> stack_frame_entry) {
   stack_frame_entries_.push_back(std::move(stack_frame_entry));
+  if (stack_frame_entry_limit_ &&
+      stack_frame_entries_.size() >= stack_frame_entry_limit_)
+    SpillStackFrameEntries();
+}
+
+void Module::SpillStackFrameEntries() {
+  if (!stack_frame_spill_)
+    stack_frame_spill_ = tmpfile();
+  bool spilled = stack_frame_spill_ != NULL;
+  for (size_t i = 0; spilled && i < stack_frame_entries_.size(); ++i) {
+    spilled =
+        SpillStackFrameEntry(stack_frame_spill_, *stack_frame_entries_[i]);
+  }
+  if (!spilled) {
+    fprintf(stderr, "error spilling stack frame entries: %s\n",
+            strerror(errno));
+    // Drop whatever part of the entries did get written.
+    if (stack_frame_spill_)
+      fseek(stack_frame_spill_, stack_frame_spill_size_, SEEK_SET);
+    stack_frame_entry_limit_ = 0;
+    return;
+  }
+  stack_frame_spill_size_ = ftell(stack_frame_spill_);
+  stack_frame_entries_.clear();
 }
 
 void Module::AddExtern(std::unique_ptr<Extern> ext) {
@@ -232,6 +655,7 @@ void Module::AddExtern(std::unique_ptr<Extern> ext) {
 
 void Module::GetFunctions(vector<Function*>* vec,
                           vector<Function*>::iterator i) {
+  SortFunctions();
   vec->insert(i, functions_.begin(), functions_.end());
 }
 
@@ -244,6 +668,185 @@ void Module::GetExterns(vector<Extern*>* vec,
   }
 }
 
+void Module::AdoptStagedData(Module* staging,
+                             const vector<Function*>& functions) {
+  // Move over the strings this module lacks without copying them.  Names
+  // pointing at the strings left behind get pointed at this module's.
+  common_strings_.merge(staging->common_strings_);
+  unordered_map<const char*, StringView> pooled_names;
+  for (const string& str : staging->common_strings_)
+    pooled_names[str.data()] = *common_strings_.find(str);
+  auto pool_name = [&pooled_names](StringView* name) {
+    auto pooled = pooled_names.find(name->data());
+    if (pooled != pooled_names.end())
+      *name = pooled->second;
+  };
+
+  // Move over the inline origins.  Should this module have one at the
+  // same offset already, inlines get pointed at it, and STAGING keeps its
+  // own, to delete.
+  unordered_map<InlineOrigin*, InlineOrigin*> merged_origins;
+  for (auto& staged_map : staging->inline_origin_maps) {
+    InlineOriginMap& origin_map = inline_origin_maps[staged_map.first];
+    for (auto& staged : staged_map.second.inline_origins_) {
+      pool_name(&staged.second->name);
+      auto inserted = origin_map.inline_origins_.insert(staged);
+      if (inserted.second)
+        staged.second = nullptr;
+      else
+        merged_origins[staged.second] = inserted.first->second;
+    }
+    origin_map.references_.insert(staged_map.second.references_.begin(),
+                                  staged_map.second.references_.end());
+  }
+
+  unordered_map<File*, File*> files;
+  for (const auto& file : staging->files_)
+    files[file.second] = FindFile(file.second->name);
+
+  for (Function* func : functions) {
+    pool_name(&func->name);
+    for (Line& line : func->lines)
+      line.file = files[line.file];
+    Inline::InlineDFS(func->inlines, [&](unique_ptr<Inline>& in) {
+      if (in->call_site_file)
+        in->call_site_file = files[in->call_site_file];
+      auto merged = merged_origins.find(in->origin);
+      if (merged != merged_origins.end())
+        in->origin = merged->second;
+    });
+  }
+}
+
+bool Module::WriteStagedData(FILE* file,
+                             const vector<Function*>& functions) {
+  if (!SpillNumber(file, kStagedDataMagic) ||
+      !SpillNumber(file, files_.size()))
+    return false;
+  FileIndices file_indices;
+  for (const auto& file_entry : files_) {
+    if (!SpillString(file, file_entry.second->name))
+      return false;
+    uint64_t index = file_indices.size() + 1;
+    file_indices[file_entry.second] = index;
+  }
+
+  if (!SpillNumber(file, inline_origin_maps.size()))
+    return false;
+  OriginIndices origin_indices;
+  for (const auto& origin_map : inline_origin_maps) {
+    const InlineOriginMap& map = origin_map.second;
+    if (!SpillString(file, origin_map.first) ||
+        !SpillNumber(file, map.references_.size()))
+      return false;
+    for (const auto& reference : map.references_) {
+      if (!SpillNumber(file, reference.first) ||
+          !SpillNumber(file, reference.second))
+        return false;
+    }
+    if (!SpillNumber(file, map.inline_origins_.size()))
+      return false;
+    for (const auto& origin : map.inline_origins_) {
+      if (!SpillNumber(file, origin.first) ||
+          !SpillString(file, origin.second->name.str()))
+        return false;
+      uint64_t index = origin_indices.size();
+      origin_indices[origin.second] = index;
+    }
+  }
+
+  if (!SpillNumber(file, functions.size()))
+    return false;
+  for (const Function* func : functions) {
+    if (!SpillFunction(file, *func, file_indices, origin_indices))
+      return false;
+  }
+  return true;
+}
+
+bool Module::ReadStagedData(FILE* file, vector<Function*>* functions,
+                            uint64_t address_delta, uint64_t offset_delta) {
+  uint64_t magic, count;
+  if (!UnspillNumber(file, &magic) || magic != kStagedDataMagic ||
+      !UnspillNumber(file, &count))
+    return false;
+  vector<File*> files(1, nullptr);
+  string name;
+  for (uint64_t i = 0; i < count; ++i) {
+    if (!UnspillString(file, &name))
+      return false;
+    files.push_back(FindFile(name));
+  }
+
+  if (!UnspillNumber(file, &count))
+    return false;
+  vector<InlineOrigin*> origins;
+  for (uint64_t i = 0; i < count; ++i) {
+    uint64_t reference_count, origin_count;
+    if (!UnspillString(file, &name) ||
+        !UnspillNumber(file, &reference_count))
+      return false;
+    InlineOriginMap& map = inline_origin_maps[name];
+    for (uint64_t j = 0; j < reference_count; ++j) {
+      uint64_t offset, specification_offset;
+      if (!UnspillNumber(file, &offset) ||
+          !UnspillNumber(file, &specification_offset))
+        return false;
+      map.references_[offset + offset_delta] =
+          specification_offset + offset_delta;
+    }
+    if (!UnspillNumber(file, &origin_count))
+      return false;
+    for (uint64_t j = 0; j < origin_count; ++j) {
+      uint64_t offset;
+      if (!UnspillNumber(file, &offset) || !UnspillString(file, &name))
+        return false;
+      InlineOrigin*& origin = map.inline_origins_[offset + offset_delta];
+      if (origin)
+        return false;
+      origin = new InlineOrigin(AddStringToPool(name));
+      origins.push_back(origin);
+    }
+  }
+
+  if (!UnspillNumber(file, &count))
+    return false;
+  vector<unique_ptr<Function>> read;
+  for (uint64_t i = 0; i < count; ++i) {
+    read.emplace_back();
+    if (!UnspillFunction(file, this, files, origins, address_delta,
+                         &read.back()))
+      return false;
+  }
+  for (unique_ptr<Function>& func : read)
+    functions->push_back(func.release());
+  return true;
+}
+
+void Module::AdoptStackFrameEntries(Module* staging) {
+  // Read back whatever STAGING spilled, storing it as if added here.
+  if (staging->stack_frame_spill_) {
+    FILE* spill = staging->stack_frame_spill_;
+    fflush(spill);
+    fseek(spill, 0, SEEK_SET);
+    while (ftell(spill) < staging->stack_frame_spill_size_) {
+      auto entry = std::make_unique<StackFrameEntry>();
+      if (!UnspillStackFrameEntry(spill, entry.get())) {
+        fprintf(stderr, "error reading spilled stack frame entries: %s\n",
+                strerror(errno));
+        break;
+      }
+      StoreStackFrameEntry(std::move(entry));
+    }
+    fclose(spill);
+    staging->stack_frame_spill_ = NULL;
+    staging->stack_frame_spill_size_ = 0;
+  }
+  for (auto& entry : staging->stack_frame_entries_)
+    StoreStackFrameEntry(std::move(entry));
+  staging->stack_frame_entries_.clear();
+}
+
 Module::File* Module::FindFile(const string& name) {
   // A tricky bit here.  The key of each map entry needs to be a
   // pointer to the entry's File's name string.  This means that we
@@ -297,27 +900,68 @@ void Module::AssignSourceIds() {
     file_it->second->source_id = -1;
   }
 
-  // Next, mark all files actually cited by our functions' line number
-  // info, by setting each one's source id to zero.
-  for (FunctionSet::const_iterator func_it = functions_.begin();
-       func_it != functions_.end(); ++func_it) {
-    Function* func = *func_it;
-    for (vector<Line>::iterator line_it = func->lines.begin();
-         line_it != func->lines.end(); ++line_it)
-      line_it->file->source_id = 0;
-  }
-
-  // Also mark all files cited by inline callsite by setting each one's source
-  // id to zero.
-  auto markInlineFiles = [](unique_ptr<Inline>& in) {
-    // There are some artificial inline functions which don't belong to
-    // any file. Those will have file id -1.
-    if (in->call_site_file) {
-      in->call_site_file->source_id = 0;
+  // Next, find all files actually cited by our functions' line number
+  // info and inline call sites.  Consecutive lines are usually from the
+  // same file, so only record a file when it changes.  There are some
+  // artificial inline functions which don't belong to any file; those
+  // have no call site file, and get file id -1.
+  auto find_function_cited_files = [](Function* func, auto&& cite) {
+    File* last_file = nullptr;
+    for (const Line& line : func->lines) {
+      if (line.file != last_file) {
+        cite(line.file);
+        last_file = line.file;
+      }
     }
+    Inline::InlineDFS(func->inlines, [&](unique_ptr<Inline>& in) {
+      if (in->call_site_file)
+        cite(in->call_site_file);
+    });
+  };
+  auto find_cited_files = [&](size_t begin, size_t end, auto&& cite) {
+    for (size_t i = begin; i < end; ++i)
+      find_function_cited_files(functions_[i], cite);
   };
-  for (auto func : functions_) {
-    Inline::InlineDFS(func->inlines, markInlineFiles);
+
+  // Mark the cited files by setting each one's source id to zero.  With
+  // several threads, each collects the files cited by a share of the
+  // functions, and they're marked once all are done.
+  const size_t kMinFunctionsPerThread = 4096;
+  size_t thread_count = std::min(
+      static_cast<size_t>(std::max(write_threads_, 1)),
+      functions_.size() / kMinFunctionsPerThread);
+  if (!function_runs_.empty()) {
+    // Read spilled functions back one at a time, merged as Write merges
+    // them, so that the duplicates it drops cite nothing.
+    if (!MergeFunctions([&](Function* func) {
+          find_function_cited_files(func,
+                                    [](File* file) { file->source_id = 0; });
+          return true;
+        })) {
+      fprintf(stderr, "error reading spilled functions: %s\n",
+              strerror(errno));
+    }
+  } else if (thread_count <= 1) {
+    find_cited_files(0, functions_.size(),
+                     [](File* file) { file->source_id = 0; });
+  } else {
+    vector<vector<File*>> cited(thread_count);
+    vector<std::thread> threads;
+    for (size_t i = 0; i < thread_count; ++i) {
+      size_t begin = functions_.size() * i / thread_count;
+      size_t end = functions_.size() * (i + 1) / thread_count;
+      vector<File*>* files = &cited[i];
+      threads.emplace_back([=, &find_cited_files]() {
+        find_cited_files(begin, end,
+                         [files](File* file) { files->push_back(file); });
+      });
+    }
+    for (std::thread& thread : threads)
+      thread.join();
+    for (const vector<File*>& files : cited) {
+      for (File* file : files)
+        file->source_id = 0;
+    }
   }
 
   // Finally, assign source ids to those files that have been marked.
@@ -343,8 +987,16 @@ void Module::CreateInlineOrigins(
     else
       in->origin = *it;
   };
-  for (Function* func : functions_)
-    Module::Inline::InlineDFS(func->inlines, addInlineOrigins);
+  if (function_runs_.empty()) {
+    for (Function* func : functions_)
+      Module::Inline::InlineDFS(func->inlines, addInlineOrigins);
+  } else if (!MergeFunctions([&](Function* func) {
+               Module::Inline::InlineDFS(func->inlines, addInlineOrigins);
+               return true;
+             })) {
+    fprintf(stderr, "error reading spilled functions: %s\n",
+            strerror(errno));
+  }
   int next_id = 0;
   for (InlineOrigin* origin : inline_origins) {
     origin->id = next_id++;
@@ -357,14 +1009,157 @@ bool Module::ReportError() {
   return false;
 }
 
-bool Module::WriteRuleMap(const RuleMap& rule_map, std::ostream& stream) {
+// Going through the stream's << operators, switching between hex and
+// dec for each field, was most of the time Write took, so records are
+// formatted here by hand into a buffer, which goes to the stream a chunk
+// at a time.
+class Module::SymbolWriter {
+ public:
+  explicit SymbolWriter(std::ostream& stream) : stream_(stream) {
+    buffer_.reserve(kChunkSize + kChunkSize / 4);
+  }
+
+  ~SymbolWriter() { Flush(); }
+
+  SymbolWriter& Text(const char* text) {
+    buffer_.append(text);
+    return *this;
+  }
+
+  SymbolWriter& Text(StringView text) {
+    buffer_.append(text.data(), text.size());
+    return *this;
+  }
+
+  SymbolWriter& Char(char c) {
+    buffer_.push_back(c);
+    return *this;
+  }
+
+  // Append VALUE in lower-case hexadecimal, without a prefix.
+  SymbolWriter& Hex(uint64_t value) {
+    char digits[16];
+    char* start = digits + sizeof(digits);
+    do {
+      *--start = "0123456789abcdef"[value & 0xf];
+      value >>= 4;
+    } while (value);
+    buffer_.append(start, digits + sizeof(digits) - start);
+    return *this;
+  }
+
+  // Append VALUE in decimal.
+  SymbolWriter& Dec(int64_t value) {
+    uint64_t magnitude = value;
+    if (value < 0) {
+      buffer_.push_back('-');
+      magnitude = -magnitude;
+    }
+    char digits[20];
+    char* start = digits + sizeof(digits);
+    do {
+      *--start = '0' + magnitude % 10;
+      magnitude /= 10;
+    } while (magnitude);
+    buffer_.append(start, digits + sizeof(digits) - start);
+    return *this;
+  }
+
+  // Call at the end of each record: pass the buffer to the stream once it
+  // holds a chunk's worth.  Return false if the stream has failed.
+  bool EndRecord() {
+    if (buffer_.size() >= kChunkSize)
+      return Flush();
+    return stream_.good();
+  }
+
+  // Pass everything buffered to the stream.  Return false if the stream
+  // has failed.
+  bool Flush() {
+    if (!buffer_.empty()) {
+      stream_.write(buffer_.data(), buffer_.size());
+      buffer_.clear();
+    }
+    return stream_.good();
+  }
+
+ private:
+  static const size_t kChunkSize = 1 << 20;
+
+  std::ostream& stream_;
+  string buffer_;
+};
+
+void Module::WriteRuleMap(const RuleMap& rule_map, SymbolWriter* writer) {
   for (RuleMap::const_iterator it = rule_map.begin();
        it != rule_map.end(); ++it) {
     if (it != rule_map.begin())
-      stream << ' ';
-    stream << it->first << ": " << it->second;
+      writer->Char(' ');
+    writer->Text(it->first).Text(": ").Text(it->second);
+  }
+}
+
+bool Module::WriteStackFrameEntry(const StackFrameEntry& entry,
+                                  Address load_offset, SymbolWriter* writer) {
+  writer->Text("STACK CFI INIT ").Hex(entry.address - load_offset)
+      .Char(' ').Hex(entry.size).Char(' ');
+  WriteRuleMap(entry.initial_rules, writer);
+  writer->Char('\n');
+  if (!writer->EndRecord())
+    return false;
+
+  // Write out this entry's delta rules as 'STACK CFI' records.
+  for (RuleChangeMap::const_iterator delta_it = entry.rule_changes.begin();
+       delta_it != entry.rule_changes.end(); ++delta_it) {
+    writer->Text("STACK CFI ").Hex(delta_it->first - load_offset).Char(' ');
+    WriteRuleMap(delta_it->second, writer);
+    writer->Char('\n');
+    if (!writer->EndRecord())
+      return false;
+  }
+  return true;
+}
+
+void Module::RetainAddresses(const vector<Address>& addresses) {
+  assert(std::is_sorted(addresses.begin(), addresses.end()));
+  partial_ = true;
+
+  // Spilled functions are filtered as they are merged.
+  if (!function_runs_.empty())
+    retained_addresses_ = addresses;
+  size_t kept = 0;
+  for (Function* function : functions_) {
+    if (CoversAnyAddress(*function, addresses)) {
+      functions_[kept++] = function;
+    } else {
+      delete function;
+    }
+  }
+  functions_.resize(kept);
+  functions_by_address_.clear();
+  for (Function* function : functions_)
+    functions_by_address_.emplace(function->address, function);
+
+  set<Address> extern_addresses;
+  for (Address address : addresses) {
+    Extern key(address);
+    auto it = externs_.upper_bound(&key);
+    if (it != externs_.begin())
+      extern_addresses.insert((*--it)->address);
+  }
+  for (auto it = externs_.begin(); it != externs_.end();) {
+    if (extern_addresses.count((*it)->address))
+      ++it;
+    else
+      it = externs_.erase(it);
+  }
+}
+
+void Module::SortFunctions() {
+  if (!functions_sorted_) {
+    std::sort(functions_.begin(), functions_.end(), FunctionCompare());
+    functions_sorted_ = true;
   }
-  return stream.good();
 }
 
 bool Module::AddressIsInModule(Address address) const {
@@ -381,13 +1176,17 @@ bool Module::AddressIsInModule(Address address) const {
 }
 
 bool Module::Write(std::ostream& stream, SymbolData symbol_data, bool preserve_load_address) {
-  stream << "MODULE " << os_ << " " << architecture_ << " "
-         << id_ << " " << name_ << "\n";
-  if (!stream.good())
+  SymbolWriter writer(stream);
+  writer.Text("MODULE ").Text(os_).Char(' ').Text(architecture_).Char(' ')
+      .Text(id_).Char(' ').Text(name_).Char('\n');
+  if (!writer.EndRecord())
     return ReportError();
 
   if (!code_id_.empty()) {
-    stream << "INFO CODE_ID " << code_id_ << "\n";
+    writer.Text("INFO CODE_ID ").Text(code_id_).Char('\n');
+  }
+  if (partial_) {
+    writer.Text("INFO PARTIAL\n");
   }
 
   // load_address is subtracted from each line. If we use zero instead, we
@@ -398,6 +1197,8 @@ bool Module::Write(std::ostream& stream, SymbolData symbol_data, bool preserve_l
   }
 
   if (symbol_data & SYMBOLS_AND_FILES) {
+    SortFunctions();
+
     // Get all referenced inline origins.
     set<InlineOrigin*, InlineOriginCompare> inline_origins;
     CreateInlineOrigins(inline_origins);
@@ -408,102 +1209,116 @@ bool Module::Write(std::ostream& stream, SymbolData symbol_data, bool preserve_l
          file_it != files_.end(); ++file_it) {
       File* file = file_it->second;
       if (file->source_id >= 0) {
-        stream << "FILE " << file->source_id << " " <<  file->name << "\n";
-        if (!stream.good())
+        writer.Text("FILE ").Dec(file->source_id).Char(' ').Text(file->name)
+            .Char('\n');
+        if (!writer.EndRecord())
           return ReportError();
       }
     }
 
     // Write out inline origins.
     for (InlineOrigin* origin : inline_origins) {
-      stream << "INLINE_ORIGIN " << origin->id << " " << origin->name << "\n";
-      if (!stream.good())
+      writer.Text("INLINE_ORIGIN ").Dec(origin->id).Char(' ')
+          .Text(origin->name).Char('\n');
+      if (!writer.EndRecord())
         return ReportError();
     }
     // Write out functions and their inlines and lines.
-    for (FunctionSet::const_iterator func_it = functions_.begin();
-         func_it != functions_.end(); ++func_it) {
-      Function* func = *func_it;
+    auto write_function = [&](Function* func) {
+      // CreateInlineOrigins only changed the inlines of the functions in
+      // memory over to the origins it kept.
+      if (!function_runs_.empty()) {
+        Module::Inline::InlineDFS(func->inlines, [&](unique_ptr<Inline>& in) {
+          auto origin = inline_origins.find(in->origin);
+          if (origin != inline_origins.end())
+            in->origin = *origin;
+        });
+      }
       vector<Line>::iterator line_it = func->lines.begin();
       for (auto range_it = func->ranges.cbegin();
            range_it != func->ranges.cend(); ++range_it) {
-        stream << "FUNC " << (func->is_multiple ? "m " : "") << hex
-               << (range_it->address - load_offset) << " " << range_it->size
-               << " " << func->parameter_size << " " << func->name << dec
-               << "\n";
+        writer.Text(func->is_multiple ? "FUNC m " : "FUNC ")
+            .Hex(range_it->address - load_offset).Char(' ')
+            .Hex(range_it->size).Char(' ').Hex(func->parameter_size)
+            .Char(' ').Text(func->name).Char('\n');
 
-        if (!stream.good())
-          return ReportError();
+        if (!writer.EndRecord())
+          return false;
 
         // Write out inlines.
         auto write_inline = [&](unique_ptr<Inline>& in) {
-          stream << "INLINE ";
-          stream << in->inline_nest_level << " " << in->call_site_line << " "
-                 << in->getCallSiteFileID() << " " << in->origin->id << hex;
+          writer.Text("INLINE ").Dec(in->inline_nest_level).Char(' ')
+              .Dec(in->call_site_line).Char(' ')
+              .Dec(in->getCallSiteFileID()).Char(' ').Dec(in->origin->id);
           for (const Range& r : in->ranges)
-            stream << " " << (r.address - load_offset) << " " << r.size;
-          stream << dec << "\n";
+            writer.Char(' ').Hex(r.address - load_offset).Char(' ')
+                .Hex(r.size);
+          writer.Char('\n');
         };
         Module::Inline::InlineDFS(func->inlines, write_inline);
-        if (!stream.good())
-          return ReportError();
+        if (!writer.EndRecord())
+          return false;
 
         while ((line_it != func->lines.end()) &&
                (line_it->address >= range_it->address) &&
                (line_it->address < (range_it->address + range_it->size))) {
-          stream << hex
-                 << (line_it->address - load_offset) << " "
-                 << line_it->size << " "
-                 << dec
-                 << line_it->number << " "
-                 << line_it->file->source_id << "\n";
+          writer.Hex(line_it->address - load_offset).Char(' ')
+              .Hex(line_it->size).Char(' ').Dec(line_it->number).Char(' ')
+              .Dec(line_it->file->source_id).Char('\n');
 
-          if (!stream.good())
-            return ReportError();
+          if (!writer.EndRecord())
+            return false;
 
           ++line_it;
         }
       }
+      return true;
+    };
+    if (function_runs_.empty()) {
+      for (Function* func : functions_) {
+        if (!write_function(func))
+          return ReportError();
+      }
+    } else if (!MergeFunctions(write_function)) {
+      return ReportError();
     }
 
     // Write out 'PUBLIC' records.
     for (ExternSet::const_iterator extern_it = externs_.begin();
          extern_it != externs_.end(); ++extern_it) {
       Extern* ext = extern_it->get();
-      stream << "PUBLIC " << (ext->is_multiple ? "m " : "") << hex
-             << (ext->address - load_offset) << " 0 " << ext->name << dec
-             << "\n";
+      writer.Text(ext->is_multiple ? "PUBLIC m " : "PUBLIC ")
+          .Hex(ext->address - load_offset).Text(" 0 ").Text(ext->name)
+          .Char('\n');
+      writer.EndRecord();
     }
   }
 
   if (symbol_data & CFI) {
-    // Write out 'STACK CFI INIT' and 'STACK CFI' records.
+    // Write out 'STACK CFI INIT' and 'STACK CFI' records, first those
+    // spilled to stack_frame_spill_, one at a time, then those in memory.
+    if (stack_frame_spill_) {
+      fflush(stack_frame_spill_);
+      fseek(stack_frame_spill_, 0, SEEK_SET);
+      StackFrameEntry entry;
+      while (ftell(stack_frame_spill_) < stack_frame_spill_size_) {
+        entry.initial_rules.clear();
+        entry.rule_changes.clear();
+        if (!UnspillStackFrameEntry(stack_frame_spill_, &entry) ||
+            !WriteStackFrameEntry(entry, load_offset, &writer))
+          return ReportError();
+      }
+      fseek(stack_frame_spill_, stack_frame_spill_size_, SEEK_SET);
+    }
     for (auto frame_it = stack_frame_entries_.begin();
          frame_it != stack_frame_entries_.end(); ++frame_it) {
-      StackFrameEntry* entry = frame_it->get();
-      stream << "STACK CFI INIT " << hex
-             << (entry->address - load_offset) << " "
-             << entry->size << " " << dec;
-      if (!stream.good()
-          || !WriteRuleMap(entry->initial_rules, stream))
+      if (!WriteStackFrameEntry(**frame_it, load_offset, &writer))
         return ReportError();
-
-      stream << "\n";
-
-      // Write out this entry's delta rules as 'STACK CFI' records.
-      for (RuleChangeMap::const_iterator delta_it = entry->rule_changes.begin();
-           delta_it != entry->rule_changes.end(); ++delta_it) {
-        stream << "STACK CFI " << hex
-               << (delta_it->first - load_offset) << " " << dec;
-        if (!stream.good()
-            || !WriteRuleMap(delta_it->second, stream))
-          return ReportError();
-
-        stream << "\n";
-      }
     }
   }
 
+  if (!writer.Flush())
+    return ReportError();
   return true;
 }
 
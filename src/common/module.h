@@ -37,6 +37,8 @@
 #ifndef COMMON_LINUX_MODULE_H__
 #define COMMON_LINUX_MODULE_H__
 
+#include <stdio.h>
+
 #include <functional>
 #include <iostream>
 #include <limits>
@@ -44,6 +46,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "common/string_view.h"
@@ -215,6 +218,8 @@ class Module {
     }
 
    private:
+    friend class Module;
+
     // A map from a DW_TAG_subprogram's offset to the DW_TAG_subprogram.
     InlineOriginByOffset inline_origins_;
 
@@ -243,7 +248,9 @@ class Module {
   struct Extern {
     explicit Extern(const Address& address_input) : address(address_input) {}
     const Address address;
-    string name;
+    // The symbol's name, which should point into the module's string pool
+    // (see AddStringToPool), so that the extern doesn't carry a copy.
+    StringView name;
     // If this symbol has been folded with other symbols in the linked binary.
     bool is_multiple = false;
   };
@@ -354,6 +361,39 @@ class Module {
   // function: destroying the module destroys them as well.
   void AddStackFrameEntry(std::unique_ptr<StackFrameEntry> stack_frame_entry);
 
+  // Hold at most LIMIT stack frame entries in memory: whenever that many
+  // have been added, write them out to a temporary file, from which Write
+  // streams them back.  Stack frame entries need no sorting, so this
+  // bounds the memory the call frame information of a large module takes.
+  // A LIMIT of zero, the default, keeps them all in memory.
+  void SetStackFrameEntryLimit(size_t limit) {
+    stack_frame_entry_limit_ = limit;
+  }
+
+  // Hold at most LIMIT functions in memory: once CheckFunctionLimit finds
+  // that many have been added, they are sorted and written out to a
+  // temporary file as a run, and Write merges the runs back in order.  A
+  // function that duplicates one in an earlier run is dropped as they are
+  // merged, as AddFunction would have dropped it.  A LIMIT of zero, the
+  // default, keeps them all in memory.
+  void SetFunctionLimit(size_t limit) {
+    function_limit_ = limit;
+  }
+
+  // Spill the functions held in memory if there are at least the limit
+  // set by SetFunctionLimit.  Unlike stack frame entries, functions are
+  // not spilled as they are added, because a producer may still change a
+  // function it has added, as DWARF readers do to name a function from a
+  // declaration that comes after it.  Producers call this once they hold
+  // no pointers to the functions they have added.
+  void CheckFunctionLimit();
+
+  // Let Write spread the work of numbering the source files over as many
+  // as NUM_THREADS threads.  The output is the same for any number.
+  void SetWriteThreads(int num_threads) {
+    write_threads_ = num_threads;
+  }
+
   // Add PUBLIC to the module.
   // This module owns all Extern objects added with this function:
   // destroying the module destroys them as well.
@@ -370,8 +410,9 @@ class Module {
   // Otherwise, return NULL.
   File* FindExistingFile(const string& name);
 
-  // Insert pointers to the functions added to this module at I in
-  // VEC. The pointed-to Functions are still owned by this module.
+  // Insert pointers to the functions added to this module and not yet
+  // spilled under SetFunctionLimit at I in VEC, sorted by address. The
+  // pointed-to Functions are still owned by this module.
   // (Since this is effectively a copy of the function list, this is
   // mostly useful for testing; other uses should probably get a more
   // appropriate interface.)
@@ -392,7 +433,8 @@ class Module {
   void GetFiles(vector<File*>* vec);
 
   // Clear VEC and fill it with pointers to the StackFrameEntry
-  // objects that have been added to this module. (Since this is
+  // objects that have been added to this module and not yet written
+  // out under SetStackFrameEntryLimit. (Since this is
   // effectively a copy of the stack frame entry list, this is mostly
   // useful for testing; other uses should probably get
   // a more appropriate interface.)
@@ -425,6 +467,44 @@ class Module {
   // is equal to true, in which case each address will remain unchanged.
   bool Write(std::ostream& stream, SymbolData symbol_data, bool preserve_load_address = false);
 
+  // Take over the strings and inline origins of STAGING, a module the
+  // caller read part of a file's debugging information into without
+  // adding the resulting FUNCTIONS to it, and point FUNCTIONS at this
+  // module's strings, inline origins and source files instead of
+  // STAGING's.  The caller then adds FUNCTIONS with AddFunction, and may
+  // destroy STAGING.  Inline origins are keyed by DIE offset, so the
+  // parts must come from different DIEs of the same file.
+  void AdoptStagedData(Module* staging, const vector<Function*>& functions);
+
+  // Write FUNCTIONS, read into this staging module as for AdoptStagedData,
+  // to FILE along with the source files and inline origins they refer to,
+  // so that ReadStagedData can recreate them later.  Return false if
+  // writing FILE fails.
+  bool WriteStagedData(FILE* file, const vector<Function*>& functions);
+
+  // Read functions written by WriteStagedData from FILE into this module,
+  // a fresh staging module, and append them to FUNCTIONS; the caller owns
+  // them, and adopts them as it would any staged functions.  Return false,
+  // leaving FUNCTIONS alone, if FILE is truncated or was written by a
+  // different version of this code.  The functions' addresses are moved
+  // by ADDRESS_DELTA, and the DIE offsets of the inline origins they refer
+  // to by OFFSET_DELTA, so that data staged for a unit of one file can
+  // stand for the same unit linked elsewhere in another; both deltas wrap
+  // around, so either may be negative.
+  bool ReadStagedData(FILE* file, vector<Function*>* functions,
+                      uint64_t address_delta = 0, uint64_t offset_delta = 0);
+
+  // Move the stack frame entries of STAGING, a module the caller read
+  // call frame information into, to the end of this module's.
+  void AdoptStackFrameEntries(Module* staging);
+
+  // Discard the functions that cover none of ADDRESSES, which must be
+  // sorted, and all externs but the last one at or below each address.
+  // Mark the module as partial, so that Write says its output describes
+  // only those addresses.  Stack frame entries are left alone; the caller
+  // should filter them as it reads them.
+  void RetainAddresses(const vector<Address>& addresses);
+
   // Place the name in the global set of strings. Return a StringView points to
   // a string inside the pool.
   StringView AddStringToPool(const string& str) {
@@ -439,22 +519,57 @@ class Module {
   string code_identifier() const { return code_id_; }
 
  private:
+  // Formats symbol file records for Write, and hands them to its stream
+  // in large chunks.
+  class SymbolWriter;
+
   // Report an error that has occurred writing the symbol file, using
   // errno to find the appropriate cause.  Return false.
   static bool ReportError();
 
-  // Write RULE_MAP to STREAM, in the form appropriate for 'STACK CFI'
-  // records, without a final newline. Return true if all goes well;
-  // if an error occurs, return false, and leave errno set.
-  static bool WriteRuleMap(const RuleMap& rule_map, std::ostream& stream);
+  // Write RULE_MAP to WRITER, in the form appropriate for 'STACK CFI'
+  // records, without a final newline.
+  static void WriteRuleMap(const RuleMap& rule_map, SymbolWriter* writer);
+
+  // Write ENTRY to WRITER as 'STACK CFI INIT' and 'STACK CFI' records,
+  // with LOAD_OFFSET subtracted from its addresses. Return true if all
+  // goes well; if an error occurs, return false, and leave errno set.
+  static bool WriteStackFrameEntry(const StackFrameEntry& entry,
+                                   Address load_offset, SymbolWriter* writer);
+
+  // Take ownership of STACK_FRAME_ENTRY, spilling the entries held in
+  // memory if that reaches stack_frame_entry_limit_.
+  void StoreStackFrameEntry(std::unique_ptr<StackFrameEntry> stack_frame_entry);
+
+  // Append the stack frame entries held in memory to stack_frame_spill_,
+  // creating it if need be, and free them.  If that fails, report it,
+  // keep them, and stop spilling.
+  void SpillStackFrameEntries();
+
+  // Append the functions held in memory, sorted, to a new run in
+  // function_runs_, and free them.  If that fails, report it, keep them,
+  // and stop spilling.
+  void SpillFunctions();
+
+  // Pass the functions of function_runs_ and functions_ to WRITE_FUNCTION
+  // in FunctionCompare order, dropping duplicates as AddFunction does, and
+  // those RetainAddresses discarded.  Return false if a run can't be read
+  // back, or WRITE_FUNCTION returns false.
+  bool MergeFunctions(const std::function<bool(Function*)>& write_function);
 
   // Returns true of the specified address resides with an specified address
   // range, or if no ranges have been specified.
   bool AddressIsInModule(Address address) const;
 
+  // Sort functions_ by FunctionCompare, unless it already is.
+  void SortFunctions();
+
   // Module header entries.
   string name_, os_, architecture_, id_, code_id_;
 
+  // True if RetainAddresses has discarded some of this module's contents.
+  bool partial_;
+
   // The module's nominal load address.  Addresses for functions and
   // lines are absolute, assuming the module is loaded at this
   // address.
@@ -474,9 +589,6 @@ class Module {
   // pointers to the Files' names.
   typedef map<const string*, File*, CompareStringPtrs> FileByNameMap;
 
-  // A set containing Function structures, sorted by address.
-  typedef set<Function*, FunctionCompare> FunctionSet;
-
   // A set containing Extern structures, sorted by address.
   typedef set<std::unique_ptr<Extern>, ExternCompare> ExternSet;
 
@@ -484,14 +596,54 @@ class Module {
   // to it; destroying the module frees the Files and Functions these
   // point to.
   FileByNameMap files_;    // This module's source files.
-  FunctionSet functions_;  // This module's functions.
-  // Used to quickly look up whether a function exists at a particular address.
-  unordered_set<Address> function_addresses_;
+  // This module's functions, in the order they were added until
+  // SortFunctions sorts them for writing.  Most come from the debugging
+  // information roughly in address order, so a single sort at the end is
+  // far cheaper than keeping an ordered set up to date.
+  vector<Function*> functions_;
+  bool functions_sorted_;
+  // The functions by address, to find duplicates as they are added.
+  std::unordered_multimap<Address, Function*> functions_by_address_;
+
+  // A temporary file holding COUNT functions spilled from functions_,
+  // sorted by FunctionCompare.  Runs are in the order they were spilled.
+  struct FunctionRun {
+    FILE* file;
+    size_t count;
+  };
+  vector<FunctionRun> function_runs_;
+
+  // The number of functions to hold in memory before spilling them, or
+  // zero.
+  size_t function_limit_;
+
+  // The source files and inline origins spilled functions refer to, which
+  // they give as indices into these vectors; file index zero stands for
+  // no file.  The maps give each one's index.
+  vector<File*> spilled_files_;
+  unordered_map<const File*, uint64_t> spilled_file_indices_;
+  vector<InlineOrigin*> spilled_origins_;
+  unordered_map<const InlineOrigin*, uint64_t> spilled_origin_indices_;
+
+  // The addresses RetainAddresses was given, to filter spilled functions
+  // with as they are merged.
+  vector<Address> retained_addresses_;
 
   // The module owns all the call frame info entries that have been
   // added to it.
   vector<std::unique_ptr<StackFrameEntry>> stack_frame_entries_;
 
+  // The temporary file holding the call frame info entries spilled from
+  // stack_frame_entries_, in the order they were added, or NULL; the
+  // number of bytes of it holding complete entries; and the number of
+  // entries to hold in memory before spilling them, or zero.
+  FILE* stack_frame_spill_;
+  long stack_frame_spill_size_;
+  size_t stack_frame_entry_limit_;
+
+  // The number of threads AssignSourceIds may use.
+  int write_threads_;
+
   // The module owns all the externs that have been added to it;
   // destroying the module frees the Externs these point to.
   ExternSet externs_;
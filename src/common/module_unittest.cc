@@ -117,6 +117,107 @@ TEST(Module, WriteOneLineFunc) {
                contents.c_str());
 }
 
+TEST(Module, WriteExtremeValues) {
+  stringstream s;
+  Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+
+  Module::File* file = m.FindFile("file_name.cc");
+  Module::Function* function = new Module::Function("function_name", 0);
+  Module::Range range(0, 0xffffffffffffffffULL);
+  function->ranges.push_back(range);
+  function->parameter_size = 0;
+  Module::Line line1 = { 0, 0x10, file, 0 };
+  Module::Line line2 = { 0x10, 0xffffffffffffffefULL, file, -2147483647 - 1 };
+  function->lines.push_back(line1);
+  function->lines.push_back(line2);
+  m.AddFunction(function);
+
+  m.Write(s, ALL_SYMBOL_DATA);
+  string contents = s.str();
+  EXPECT_STREQ("MODULE os-name architecture id-string name with spaces\n"
+               "FILE 0 file_name.cc\n"
+               "FUNC 0 ffffffffffffffff 0 function_name\n"
+               "0 10 0 0\n"
+               "10 ffffffffffffffef -2147483648 0\n",
+               contents.c_str());
+}
+
+// Write buffers its output; make sure nothing is lost or reordered when
+// there is more than one buffer's worth.
+TEST(Module, WriteManyFunctions) {
+  stringstream s;
+  Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+  Module::File* file = m.FindFile("file_name.cc");
+  std::ostringstream expected;
+  expected << "MODULE os-name architecture id-string name with spaces\n"
+           << "FILE 0 file_name.cc\n";
+  for (int i = 0; i < 20000; i++) {
+    Module::Address address = 0x10000 + i * 0x100;
+    string name = "function_" + std::to_string(i);
+    Module::Function* function =
+        new Module::Function(m.AddStringToPool(name), address);
+    function->ranges.push_back(Module::Range(address, 0x100));
+    function->parameter_size = i;
+    for (int j = 0; j < 4; j++) {
+      Module::Line line = { address + j * 0x40, 0x40, file, i * 4 + j };
+      function->lines.push_back(line);
+    }
+    m.AddFunction(function);
+    expected << std::hex << "FUNC " << address << " 100 " << i << " "
+             << name << "\n";
+    for (int j = 0; j < 4; j++)
+      expected << std::hex << address + j * 0x40 << " 40 " << std::dec
+               << i * 4 + j << " 0\n";
+  }
+
+  ASSERT_TRUE(m.Write(s, ALL_SYMBOL_DATA));
+  EXPECT_GT(s.str().size(), 1U << 20);
+  EXPECT_EQ(expected.str(), s.str());
+}
+
+// Numbering the source files on several threads gives the same output as
+// on one.
+TEST(Module, WriteThreadedSourceIds) {
+  Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+  Module threaded(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+  threaded.SetWriteThreads(4);
+  for (Module* module : {&m, &threaded}) {
+    // Files 0 and 99 are never cited, so the ids of the others depend on
+    // which are.
+    for (int i = 0; i < 100; i++)
+      module->FindFile("file_" + std::to_string(100 + i) + ".cc");
+    for (int i = 0; i < 20000; i++) {
+      Module::Address address = 0x10000 + i * 0x100;
+      Module::Function* function =
+          new Module::Function(module->AddStringToPool("f"), address);
+      function->ranges.push_back(Module::Range(address, 0x100));
+      for (int j = 0; j < 2; j++) {
+        Module::File* file = module->FindFile(
+            "file_" + std::to_string(101 + (i * 7 + j) % 97) + ".cc");
+        Module::Line line = { address + j * 0x80, 0x80, file, j + 1 };
+        function->lines.push_back(line);
+      }
+      if (i % 1000 == 0) {
+        auto in = std::make_unique<Module::Inline>(
+            module->inline_origin_maps["obj"].GetOrCreateInlineOrigin(i, "g"),
+            vector<Module::Range>{Module::Range(address, 0x10)}, 1,
+            0, 0, vector<std::unique_ptr<Module::Inline>>());
+        in->call_site_file = module->FindFile("file_198.cc");
+        function->inlines.push_back(std::move(in));
+      }
+      module->AddFunction(function);
+    }
+  }
+
+  stringstream expected, s;
+  ASSERT_TRUE(m.Write(expected, ALL_SYMBOL_DATA));
+  ASSERT_TRUE(threaded.Write(s, ALL_SYMBOL_DATA));
+  EXPECT_EQ(expected.str(), s.str());
+  EXPECT_EQ(string::npos, s.str().find("file_100.cc"));
+  EXPECT_EQ(string::npos, s.str().find("file_199.cc"));
+  EXPECT_NE(string::npos, s.str().find("FILE 97 file_198.cc\n"));
+}
+
 TEST(Module, WriteRelativeLoadAddress) {
   stringstream s;
   Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
@@ -603,6 +704,36 @@ TEST(Module, ConstructExterns) {
                contents.c_str());
 }
 
+TEST(Module, RetainAddresses) {
+  stringstream s;
+  Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+
+  const char* const kNames[] = { "_a", "_b", "_c", "_d" };
+  for (int i = 0; i < 4; ++i) {
+    Module::Address address = 0x1000 * (i + 1);
+    Module::Function* function = new Module::Function(kNames[i], address);
+    function->ranges.push_back(Module::Range(address, 0x100));
+    m.AddFunction(function);
+    auto ext = std::make_unique<Module::Extern>(address + 0x800);
+    ext->name = kNames[i];
+    m.AddExtern(std::move(ext));
+  }
+
+  // 0x2010 is in _b; 0x3900 and 0x3a00 are past _c's extern.
+  vector<Module::Address> addresses = { 0x2010, 0x3900, 0x3a00 };
+  m.RetainAddresses(addresses);
+  m.Write(s, ALL_SYMBOL_DATA);
+  string contents = s.str();
+
+  EXPECT_STREQ("MODULE " MODULE_OS " " MODULE_ARCH " "
+               MODULE_ID " " MODULE_NAME "\n"
+               "INFO PARTIAL\n"
+               "FUNC 2000 100 0 _b\n"
+               "PUBLIC 1800 0 _a\n"
+               "PUBLIC 3800 0 _c\n",
+               contents.c_str());
+}
+
 // Externs with the same address should only keep the first entry
 // added.
 TEST(Module, ConstructDuplicateExterns) {
@@ -781,3 +912,403 @@ TEST(Module, ConstructFunctionsAndThumbExternsWithSameAddress) {
                "PUBLIC cc00 0 arm_func\n",
                contents.c_str());
 }
+
+// Functions read into a staging module should end up referring only to
+// the strings, files and inline origins of the module that adopts them.
+TEST(Module, AdoptStagedData) {
+  Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+  Module::File* file = m.FindFile("file.cc");
+  m.inline_origin_maps["obj"].SetReference(0x10, 0x10);
+  Module::InlineOrigin* origin =
+      m.inline_origin_maps["obj"].GetOrCreateInlineOrigin(
+          0x10, m.AddStringToPool("shared_inline"));
+
+  vector<Module::Function*> functions;
+  {
+    Module staging(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+    Module::File* staged_file = staging.FindFile("file.cc");
+    Module::File* staged_other_file = staging.FindFile("other.cc");
+    Module::InlineOriginMap& origins = staging.inline_origin_maps["obj"];
+    origins.SetReference(0x10, 0x10);
+    origins.SetReference(0x20, 0x20);
+    origins.GetOrCreateInlineOrigin(0x10,
+                                    staging.AddStringToPool("shared_inline"));
+    Module::InlineOrigin* staged_origin = origins.GetOrCreateInlineOrigin(
+        0x20, staging.AddStringToPool("staged_inline"));
+
+    Module::Function* function =
+        new Module::Function(staging.AddStringToPool("staged"), 0x100);
+    function->ranges.push_back(Module::Range(0x100, 0x10));
+    Module::Line line = { 0x100, 0x10, staged_other_file, 7 };
+    function->lines.push_back(line);
+    vector<Module::Range> inline_ranges(1, Module::Range(0x100, 0x8));
+    function->inlines.push_back(std::make_unique<Module::Inline>(
+        origins.GetOrCreateInlineOrigin(0x10, "shared_inline"), inline_ranges,
+        3, 0, 0, vector<std::unique_ptr<Module::Inline>>()));
+    function->inlines.back()->call_site_file = staged_file;
+    function->inlines.back()->child_inlines.push_back(
+        std::make_unique<Module::Inline>(
+            staged_origin, inline_ranges, 4, 0, 1,
+            vector<std::unique_ptr<Module::Inline>>()));
+    functions.push_back(function);
+
+    m.AdoptStagedData(&staging, functions);
+  }
+
+  Module::Function* function = functions[0];
+  EXPECT_TRUE(m.AddFunction(function));
+  EXPECT_EQ(m.AddStringToPool("staged").data(), function->name.data());
+  EXPECT_EQ(m.FindFile("other.cc"), function->lines[0].file);
+  const Module::Inline& shared_inline = *function->inlines[0];
+  EXPECT_EQ(origin, shared_inline.origin);
+  EXPECT_EQ(file, shared_inline.call_site_file);
+  Module::InlineOrigin* adopted_origin =
+      m.inline_origin_maps["obj"].GetOrCreateInlineOrigin(0x20, "unused");
+  EXPECT_EQ(adopted_origin, shared_inline.child_inlines[0]->origin);
+  EXPECT_EQ(m.AddStringToPool("staged_inline").data(),
+            adopted_origin->name.data());
+}
+
+TEST(Module, WriteReadStagedData) {
+  Module staging(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+  Module::File* file = staging.FindFile("file.cc");
+  Module::InlineOriginMap& origins = staging.inline_origin_maps["obj"];
+  origins.SetReference(0x10, 0x10);
+  Module::InlineOrigin* origin =
+      origins.GetOrCreateInlineOrigin(0x10, staging.AddStringToPool("inl"));
+  Module::Function* function =
+      new Module::Function(staging.AddStringToPool("staged"), 0x100);
+  function->ranges.push_back(Module::Range(0x100, 0x10));
+  function->parameter_size = 8;
+  function->is_multiple = true;
+  Module::Line line = { 0x100, 0x10, file, 7 };
+  function->lines.push_back(line);
+  vector<Module::Range> inline_ranges(1, Module::Range(0x104, 0x8));
+  function->inlines.push_back(std::make_unique<Module::Inline>(
+      origin, inline_ranges, 3, 0, 0,
+      vector<std::unique_ptr<Module::Inline>>()));
+  function->inlines.back()->call_site_file = file;
+  vector<Module::Function*> functions(1, function);
+
+  FILE* cache = tmpfile();
+  ASSERT_TRUE(cache);
+  ASSERT_TRUE(staging.WriteStagedData(cache, functions));
+  long size = ftell(cache);
+
+  // Adopt the functions as read back, and compare with the originals.
+  Module replayed(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+  vector<Module::Function*> read;
+  rewind(cache);
+  {
+    Module read_staging(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+    ASSERT_TRUE(read_staging.ReadStagedData(cache, &read));
+    replayed.AdoptStagedData(&read_staging, read);
+  }
+  ASSERT_EQ(1U, read.size());
+  EXPECT_TRUE(replayed.AddFunction(read[0]));
+
+  Module original(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+  original.AdoptStagedData(&staging, functions);
+  EXPECT_TRUE(original.AddFunction(function));
+
+  stringstream original_out, replayed_out;
+  original.Write(original_out, ALL_SYMBOL_DATA);
+  replayed.Write(replayed_out, ALL_SYMBOL_DATA);
+  EXPECT_EQ(original_out.str(), replayed_out.str());
+  EXPECT_NE(string::npos, replayed_out.str().find("FUNC m 100 10 8 staged"));
+
+  // A truncated file gives nothing back.
+  string contents(size - 1, '\0');
+  rewind(cache);
+  ASSERT_EQ(contents.size(), fread(&contents[0], 1, contents.size(), cache));
+  fclose(cache);
+  FILE* truncated_cache = tmpfile();
+  ASSERT_TRUE(truncated_cache);
+  fwrite(contents.data(), 1, contents.size(), truncated_cache);
+  rewind(truncated_cache);
+  Module truncated(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+  read.clear();
+  EXPECT_FALSE(truncated.ReadStagedData(truncated_cache, &read));
+  EXPECT_TRUE(read.empty());
+  fclose(truncated_cache);
+}
+
+TEST(Module, ReadRelocatedStagedData) {
+  Module staging(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+  Module::File* file = staging.FindFile("file.cc");
+  Module::InlineOriginMap& origins = staging.inline_origin_maps["obj"];
+  origins.SetReference(0x30, 0x20);
+  Module::InlineOrigin* origin =
+      origins.GetOrCreateInlineOrigin(0x30, staging.AddStringToPool("inl"));
+  Module::Function* function =
+      new Module::Function(staging.AddStringToPool("staged"), 0x1100);
+  function->ranges.push_back(Module::Range(0x1100, 0x10));
+  Module::Line line = { 0x1100, 0x10, file, 7 };
+  function->lines.push_back(line);
+  vector<Module::Range> inline_ranges(1, Module::Range(0x1104, 0x8));
+  function->inlines.push_back(std::make_unique<Module::Inline>(
+      origin, inline_ranges, 3, 0, 0,
+      vector<std::unique_ptr<Module::Inline>>()));
+  vector<Module::Function*> functions(1, function);
+
+  FILE* cache = tmpfile();
+  ASSERT_TRUE(cache);
+  ASSERT_TRUE(staging.WriteStagedData(cache, functions));
+  delete function;
+
+  // Read the function back 0x1000 bytes lower, from a unit 0x100 bytes
+  // further into .debug_info.
+  rewind(cache);
+  Module read_staging(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+  vector<Module::Function*> read;
+  ASSERT_TRUE(read_staging.ReadStagedData(cache, &read, -0x1000ULL, 0x100));
+  fclose(cache);
+  ASSERT_EQ(1U, read.size());
+  std::unique_ptr<Module::Function> relocated(read[0]);
+  EXPECT_EQ(0x100U, relocated->address);
+  ASSERT_EQ(1U, relocated->ranges.size());
+  EXPECT_EQ(0x100U, relocated->ranges[0].address);
+  EXPECT_EQ(0x10U, relocated->ranges[0].size);
+  ASSERT_EQ(1U, relocated->lines.size());
+  EXPECT_EQ(0x100U, relocated->lines[0].address);
+  ASSERT_EQ(1U, relocated->inlines.size());
+  EXPECT_EQ(0x104U, relocated->inlines[0]->ranges[0].address);
+  Module::InlineOriginMap& read_origins =
+      read_staging.inline_origin_maps["obj"];
+  EXPECT_EQ(relocated->inlines[0]->origin,
+            read_origins.GetOrCreateInlineOrigin(0x130, "unused"));
+}
+
+TEST(Module, AdoptStackFrameEntries) {
+  Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+  auto entry = std::make_unique<Module::StackFrameEntry>();
+  entry->address = 0x100;
+  entry->size = 0x10;
+  m.AddStackFrameEntry(std::move(entry));
+
+  Module staging(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+  for (Module::Address address : {0x300, 0x200}) {
+    entry = std::make_unique<Module::StackFrameEntry>();
+    entry->address = address;
+    entry->size = 0x10;
+    staging.AddStackFrameEntry(std::move(entry));
+  }
+  m.AdoptStackFrameEntries(&staging);
+
+  vector<Module::StackFrameEntry*> entries;
+  staging.GetStackFrameEntries(&entries);
+  EXPECT_TRUE(entries.empty());
+  m.GetStackFrameEntries(&entries);
+  ASSERT_EQ(3U, entries.size());
+  EXPECT_EQ(0x100U, entries[0]->address);
+  EXPECT_EQ(0x300U, entries[1]->address);
+  EXPECT_EQ(0x200U, entries[2]->address);
+}
+
+// Spilling stack frame entries to a temporary file should not change what
+// gets written, nor the order entries get written in.
+TEST(Module, StackFrameEntryLimit) {
+  Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+  Module limited(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+  Module staging(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+  m.SetLoadAddress(0x1000);
+  limited.SetLoadAddress(0x1000);
+  limited.SetStackFrameEntryLimit(2);
+  staging.SetStackFrameEntryLimit(2);
+  for (int i = 0; i < 8; ++i) {
+    Module::Address address = 0x8000 - i * 0x100;
+    for (Module* module : {&m, i < 5 ? &limited : &staging}) {
+      auto entry = std::make_unique<Module::StackFrameEntry>();
+      entry->address = address;
+      entry->size = 0x100;
+      entry->initial_rules[".cfa"] = "$sp 8 +";
+      entry->initial_rules[".ra"] = "";
+      entry->rule_changes[address + 4][".cfa"] = "$sp 16 +";
+      entry->rule_changes[address + 8][".cfa"] = "$sp 24 +";
+      module->AddStackFrameEntry(std::move(entry));
+    }
+  }
+
+  // Only the entries added since the last spill stay in memory.
+  vector<Module::StackFrameEntry*> entries;
+  limited.GetStackFrameEntries(&entries);
+  ASSERT_EQ(1U, entries.size());
+  EXPECT_EQ(0x7c00U, entries[0]->address);
+
+  limited.AdoptStackFrameEntries(&staging);
+  staging.GetStackFrameEntries(&entries);
+  EXPECT_TRUE(entries.empty());
+
+  stringstream expected, s;
+  m.Write(expected, ALL_SYMBOL_DATA);
+  limited.Write(s, ALL_SYMBOL_DATA);
+  EXPECT_EQ(expected.str(), s.str());
+  EXPECT_NE(string::npos, s.str().find("STACK CFI 6b04 .cfa: $sp 16 +\n"));
+
+  // Writing again streams the spilled entries back again.
+  stringstream again;
+  limited.Write(again, ALL_SYMBOL_DATA);
+  EXPECT_EQ(expected.str(), again.str());
+}
+
+// Add to M a function named NAME at ADDRESS, with a line in FILE_NAME
+// and, if ORIGIN_NAME is not empty, an inline of it.  Return false if M
+// dropped it as a duplicate.
+static bool AddSpillableFunction(Module* m, const char* name,
+                                 Module::Address address,
+                                 const char* file_name,
+                                 const char* origin_name) {
+  Module::Function* function =
+      new Module::Function(m->AddStringToPool(name), address);
+  function->ranges.push_back(Module::Range(address, 0x10));
+  Module::Line line = { address, 0x10, m->FindFile(file_name), 7 };
+  function->lines.push_back(line);
+  if (*origin_name) {
+    // Give each origin an offset of its own in every module, so that
+    // origins of the same name are distinct objects.
+    Module::InlineOriginMap& origins = m->inline_origin_maps["obj"];
+    origins.SetReference(address, address);
+    vector<Module::Range> inline_ranges(1, Module::Range(address, 0x8));
+    function->inlines.push_back(std::make_unique<Module::Inline>(
+        origins.GetOrCreateInlineOrigin(address,
+                                        m->AddStringToPool(origin_name)),
+        inline_ranges, 3, 0, 0, vector<std::unique_ptr<Module::Inline>>()));
+    function->inlines.back()->call_site_file = m->FindFile("call_site.cc");
+  }
+  if (m->AddFunction(function))
+    return true;
+  delete function;
+  return false;
+}
+
+// Functions spilled in sorted runs should be written out just as those
+// held in memory are, with duplicates in different runs dropped.
+TEST(Module, FunctionLimit) {
+  for (bool multiple : {false, true}) {
+    Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID, "", multiple);
+    Module limited(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID, "",
+                   multiple);
+    m.SetLoadAddress(0x1000);
+    limited.SetLoadAddress(0x1000);
+    limited.SetFunctionLimit(2);
+    m.FindFile("unused.cc");
+    limited.FindFile("unused.cc");
+    struct {
+      const char* name;
+      Module::Address address;
+      const char* file;
+      const char* origin;
+    } functions[] = {
+      { "f", 0x4000, "b.cc", "inl" },
+      { "g", 0x2000, "a.cc", "" },
+      { "h", 0x3000, "c.cc", "inl" },
+      { "f", 0x4000, "b.cc", "" },
+      { "i", 0x4000, "a.cc", "" },
+      { "j", 0x1000, "d.cc", "other_inl" },
+      { "g", 0x2000, "a.cc", "" },
+      { "k", 0x5000, "a.cc", "" },
+    };
+    for (const auto& function : functions) {
+      AddSpillableFunction(&m, function.name, function.address,
+                           function.file, function.origin);
+      AddSpillableFunction(&limited, function.name, function.address,
+                           function.file, function.origin);
+      limited.CheckFunctionLimit();
+    }
+
+    // Only the functions added since the last spill stay in memory.
+    vector<Module::Function*> in_memory;
+    limited.GetFunctions(&in_memory, in_memory.end());
+    EXPECT_GT(2U, in_memory.size());
+
+    stringstream expected, s;
+    m.Write(expected, ALL_SYMBOL_DATA);
+    limited.Write(s, ALL_SYMBOL_DATA);
+    EXPECT_EQ(expected.str(), s.str());
+    EXPECT_EQ(string::npos, s.str().find("unused.cc"));
+    EXPECT_NE(string::npos,
+              s.str().find(multiple ? "FUNC m 3000 10 0 f\n"
+                                    : "FUNC 3000 10 0 f\n"));
+
+    // Writing again merges the runs again.
+    stringstream again;
+    limited.Write(again, ALL_SYMBOL_DATA);
+    EXPECT_EQ(expected.str(), again.str());
+
+    // Spilled functions are filtered as they are merged.
+    vector<Module::Address> addresses = { 0x2004, 0x5008 };
+    m.RetainAddresses(addresses);
+    limited.RetainAddresses(addresses);
+    stringstream retained_expected, retained;
+    m.Write(retained_expected, ALL_SYMBOL_DATA);
+    limited.Write(retained, ALL_SYMBOL_DATA);
+    EXPECT_EQ(retained_expected.str(), retained.str());
+    EXPECT_EQ(string::npos, retained.str().find("FUNC 3000"));
+  }
+}
+
+// Many runs, each holding addresses that earlier and later runs hold
+// too, some under other names, should merge into the same functions, in
+// the same order, as a module that never spills.
+TEST(Module, FunctionLimitManyRuns) {
+  for (bool multiple : {false, true}) {
+    Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID, "", multiple);
+    Module limited(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID, "",
+                   multiple);
+    limited.SetFunctionLimit(3);
+    const char* const names[] = { "f", "f", "g" };
+    const char* const files[] = { "a.cc", "b.cc" };
+    const char* const origins[] = { "", "inl", "" };
+    size_t added = 0;
+    for (int i = 0; i < 60; ++i) {
+      // Twenty addresses, each added three times, far apart.
+      const Module::Address address = 0x1000 + (i * 7 % 20) * 0x100;
+      const char* name = names[i / 20];
+      if (AddSpillableFunction(&m, name, address, files[i % 2],
+                               origins[i % 3])) {
+        ++added;
+      }
+      AddSpillableFunction(&limited, name, address, files[i % 2],
+                           origins[i % 3]);
+      limited.CheckFunctionLimit();
+    }
+    EXPECT_EQ(multiple ? 20U : 40U, added);
+
+    vector<Module::Function*> in_memory;
+    limited.GetFunctions(&in_memory, in_memory.end());
+    EXPECT_GT(3U, in_memory.size());
+
+    stringstream expected, s;
+    m.Write(expected, ALL_SYMBOL_DATA);
+    limited.Write(s, ALL_SYMBOL_DATA);
+    EXPECT_EQ(expected.str(), s.str());
+  }
+}
+
+// Functions added out of address order should still be found as
+// duplicates, and come out sorted.
+TEST(Module, ConstructFunctionsOutOfOrder) {
+  Module m(MODULE_NAME, MODULE_OS, MODULE_ARCH, MODULE_ID);
+  for (Module::Address address : {0x300, 0x100, 0x200}) {
+    Module::Function* function = new Module::Function("f", address);
+    function->ranges.push_back(Module::Range(address, 0x10));
+    EXPECT_TRUE(m.AddFunction(function));
+  }
+  Module::Function* other_name = new Module::Function("g", 0x100);
+  other_name->ranges.push_back(Module::Range(0x100, 0x10));
+  EXPECT_TRUE(m.AddFunction(other_name));
+  Module::Function* duplicate = new Module::Function("f", 0x200);
+  duplicate->ranges.push_back(Module::Range(0x200, 0x10));
+  EXPECT_FALSE(m.AddFunction(duplicate));
+  delete duplicate;
+
+  vector<Module::Function*> functions;
+  m.GetFunctions(&functions, functions.end());
+  ASSERT_EQ(4U, functions.size());
+  EXPECT_EQ(0x100U, functions[0]->address);
+  EXPECT_EQ("f", functions[0]->name);
+  EXPECT_EQ(0x100U, functions[1]->address);
+  EXPECT_EQ("g", functions[1]->name);
+  EXPECT_EQ(0x200U, functions[2]->address);
+  EXPECT_EQ(0x300U, functions[3]->address);
+}
@@ -30,6 +30,7 @@
 #define COMMON_SIMPLE_STRING_DICTIONARY_H_
 
 #include <assert.h>
+#include <stdint.h>
 #include <string.h>
 
 namespace google_breakpad {
@@ -267,6 +268,311 @@ class NonAllocatingMap {
   Entry entries_[NumEntries];
 };
 
+// HashedNonAllocatingMap has the same interface and storage guarantees as
+// NonAllocatingMap, but keeps an open-addressing hash index over its fixed
+// Entry array, so that setting, looking up and removing a key takes constant
+// time instead of a scan of every entry. It suits maps whose keys are updated
+// often, such as crash keys set on every request a server handles.
+//
+// The index holds entry numbers rather than pointers and every member is a
+// fixed-size array or integer, so a map can be copied with memcpy and
+// modified from a signal handler. Serialize() produces the same Entry array
+// as NonAllocatingMap, so either map can deserialize the other's output;
+// deserializing rebuilds the index.
+template <size_t KeySize, size_t ValueSize, size_t NumEntries>
+class HashedNonAllocatingMap {
+ public:
+  typedef typename NonAllocatingMap<KeySize, ValueSize, NumEntries>::Entry
+      Entry;
+
+  static constexpr size_t key_size = KeySize;
+  static constexpr size_t value_size = ValueSize;
+  static constexpr size_t num_entries = NumEntries;
+
+  class Iterator {
+   public:
+    explicit Iterator(const HashedNonAllocatingMap& map)
+        : map_(map),
+          current_(0) {
+    }
+    Iterator(const Iterator&) = delete;
+    void operator=(const Iterator&) = delete;
+
+    // Returns the next entry in the map, or NULL if at the end of the
+    // collection.
+    const Entry* Next() {
+      while (current_ < map_.num_entries) {
+        const Entry* entry = &map_.entries_[current_++];
+        if (entry->is_active()) {
+          return entry;
+        }
+      }
+      return nullptr;
+    }
+
+   private:
+    const HashedNonAllocatingMap& map_;
+    size_t current_;
+  };
+
+  HashedNonAllocatingMap() {
+    Reset();
+  }
+
+  HashedNonAllocatingMap(const HashedNonAllocatingMap& other) {
+    *this = other;
+  }
+
+  HashedNonAllocatingMap& operator=(const HashedNonAllocatingMap& other) {
+    if (this != &other) {
+      memcpy(entries_, other.entries_, sizeof(entries_));
+      memcpy(hashes_, other.hashes_, sizeof(hashes_));
+      memcpy(slots_, other.slots_, sizeof(slots_));
+      memcpy(free_entries_, other.free_entries_, sizeof(free_entries_));
+      free_count_ = other.free_count_;
+    }
+    return *this;
+  }
+
+  // Constructs a map from a serialized NonAllocatingMap or
+  // HashedNonAllocatingMap of the same sizes. |map| should be the out
+  // parameter from Serialize() and |size| should be its return value.
+  HashedNonAllocatingMap(const SerializedNonAllocatingMap* map, size_t size) {
+    Reset();
+    assert(size == sizeof(entries_));
+    if (size != sizeof(entries_))
+      return;
+
+    memcpy(entries_, map, size);
+    for (size_t i = 0; i < num_entries; ++i) {
+      Entry* entry = &entries_[i];
+      // Terminate the strings, which may come from another process.
+      entry->key[key_size - 1] = '\0';
+      entry->value[value_size - 1] = '\0';
+      if (!entry->is_active())
+        continue;
+      if (FindSlot(entry->key) != kNoSlot) {
+        // Drop later duplicates of a key, which NonAllocatingMap never
+        // finds either.
+        entry->key[0] = '\0';
+        entry->value[0] = '\0';
+        continue;
+      }
+      hashes_[i] = Hash(entry->key);
+      slots_[EmptySlotFor(hashes_[i])] = static_cast<uint32_t>(i + 1);
+    }
+    free_count_ = 0;
+    for (size_t i = num_entries; i > 0; --i) {
+      if (!entries_[i - 1].is_active())
+        free_entries_[free_count_++] = static_cast<uint32_t>(i - 1);
+    }
+  }
+
+  // Returns the number of active key/value pairs. The upper limit for this
+  // is NumEntries.
+  size_t GetCount() const {
+    return num_entries - free_count_;
+  }
+
+  // Given |key|, returns its corresponding |value|. |key| must not be NULL. If
+  // the key is not found, NULL is returned.
+  const char* GetValueForKey(const char* key) const {
+    assert(key);
+    if (!key)
+      return NULL;
+
+    const size_t slot = FindSlot(key);
+    if (slot == kNoSlot)
+      return NULL;
+
+    return entries_[slots_[slot] - 1].value;
+  }
+
+  // Stores |value| into |key|, replacing the existing value if |key| is
+  // already present. |key| must not be NULL. If |value| is NULL, the key is
+  // removed from the map. If there is no more space in the map, then the
+  // operation silently fails. Returns an index into the map that can be used
+  // to quickly access the entry, or |num_entries| on failure or when clearing
+  // a key with a null value.
+  size_t SetKeyValue(const char* key, const char* value) {
+    if (!value) {
+      RemoveKey(key);
+      return num_entries;
+    }
+
+    assert(key);
+    if (!key)
+      return num_entries;
+
+    // Key must not be an empty string.
+    assert(key[0] != '\0');
+    if (key[0] == '\0')
+      return num_entries;
+
+    size_t entry_index;
+    const size_t slot = FindSlot(key);
+    if (slot != kNoSlot) {
+      entry_index = slots_[slot] - 1;
+    } else {
+      // If the map is out of space, the operation fails.
+      if (free_count_ == 0)
+        return num_entries;
+
+      entry_index = free_entries_[--free_count_];
+      Entry* entry = &entries_[entry_index];
+      strncpy(entry->key, key, key_size);
+      entry->key[key_size - 1] = '\0';
+
+      // Index the key as stored, which may have been truncated.
+      hashes_[entry_index] = Hash(entry->key);
+      slots_[EmptySlotFor(hashes_[entry_index])] =
+          static_cast<uint32_t>(entry_index + 1);
+    }
+
+    strncpy(entries_[entry_index].value, value, value_size);
+    entries_[entry_index].value[value_size - 1] = '\0';
+
+    return entry_index;
+  }
+
+  // Sets a value for a key that has already been set with SetKeyValue(), using
+  // the index returned from that function.
+  void SetValueAtIndex(size_t index, const char* value) {
+    assert(index < num_entries);
+    if (index >= num_entries)
+      return;
+
+    Entry* entry = &entries_[index];
+    assert(entry->key[0] != '\0');
+
+    strncpy(entry->value, value, value_size);
+    entry->value[value_size - 1] = '\0';
+  }
+
+  // Given |key|, removes any associated value. |key| must not be NULL. If
+  // the key is not found, this is a noop. This invalidates the index
+  // returned by SetKeyValue().
+  bool RemoveKey(const char* key) {
+    assert(key);
+    if (!key)
+      return false;
+
+    const size_t slot = FindSlot(key);
+    if (slot == kNoSlot)
+      return false;
+
+    return RemoveAtIndex(slots_[slot] - 1);
+  }
+
+  // Removes a value and key using an index that was returned from
+  // SetKeyValue(). After a call to this function, the index is invalidated.
+  bool RemoveAtIndex(size_t index) {
+    if (index >= num_entries || !entries_[index].is_active())
+      return false;
+
+    size_t slot = hashes_[index] & kSlotMask;
+    while (slots_[slot] != index + 1)
+      slot = (slot + 1) & kSlotMask;
+    RemoveSlot(slot);
+
+    entries_[index].key[0] = '\0';
+    entries_[index].value[0] = '\0';
+    free_entries_[free_count_++] = static_cast<uint32_t>(index);
+    return true;
+  }
+
+  // Places a serialized version of the map into |map| and returns the size.
+  // Both of these should be passed to the deserializing constructor. Note that
+  // the serialized |map| is scoped to the lifetime of the non-serialized
+  // instance of this class. The |map| can be copied across IPC boundaries.
+  size_t Serialize(const SerializedNonAllocatingMap** map) const {
+    *map = reinterpret_cast<const SerializedNonAllocatingMap*>(entries_);
+    return sizeof(entries_);
+  }
+
+ private:
+  // The index has at least twice as many slots as there are entries, so
+  // probe sequences stay short even when the map is full.
+  static constexpr size_t SlotCount(size_t n) {
+    return n >= 2 * NumEntries ? n : SlotCount(2 * n);
+  }
+  static constexpr size_t kNumSlots = SlotCount(1);
+  static constexpr size_t kSlotMask = kNumSlots - 1;
+  static constexpr size_t kNoSlot = kNumSlots;
+
+  // FNV-1a over the bytes that NonAllocatingMap compares: up to the NUL
+  // terminator, and no more than |key_size|.
+  static uint32_t Hash(const char* key) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < key_size && key[i]; ++i) {
+      hash ^= static_cast<unsigned char>(key[i]);
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
+  void Reset() {
+    memset(entries_, 0, sizeof(entries_));
+    memset(hashes_, 0, sizeof(hashes_));
+    memset(slots_, 0, sizeof(slots_));
+    // Hand out entries from the front, as NonAllocatingMap does.
+    for (size_t i = 0; i < num_entries; ++i)
+      free_entries_[i] = static_cast<uint32_t>(num_entries - 1 - i);
+    free_count_ = num_entries;
+  }
+
+  // Returns the slot indexing |key|, or kNoSlot.
+  size_t FindSlot(const char* key) const {
+    const uint32_t hash = Hash(key);
+    for (size_t slot = hash & kSlotMask;; slot = (slot + 1) & kSlotMask) {
+      const uint32_t entry = slots_[slot];
+      if (entry == 0)
+        return kNoSlot;
+      if (hashes_[entry - 1] == hash &&
+          strncmp(key, entries_[entry - 1].key, key_size) == 0) {
+        return slot;
+      }
+    }
+  }
+
+  // Returns the first empty slot in the probe sequence for |hash|.
+  size_t EmptySlotFor(uint32_t hash) const {
+    size_t slot = hash & kSlotMask;
+    while (slots_[slot] != 0)
+      slot = (slot + 1) & kSlotMask;
+    return slot;
+  }
+
+  // Empties |slot|, shifting later slots in its cluster back so that every
+  // key stays reachable from its home slot without tombstones.
+  void RemoveSlot(size_t slot) {
+    size_t next = slot;
+    for (;;) {
+      next = (next + 1) & kSlotMask;
+      const uint32_t entry = slots_[next];
+      if (entry == 0)
+        break;
+      const size_t home = hashes_[entry - 1] & kSlotMask;
+      // Move the entry back unless its home lies cyclically in
+      // (slot, next], where it would then be unreachable.
+      if (((next - home) & kSlotMask) >= ((next - slot) & kSlotMask)) {
+        slots_[slot] = entry;
+        slot = next;
+      }
+    }
+    slots_[slot] = 0;
+  }
+
+  Entry entries_[NumEntries];
+  // The hash of each active entry's key.
+  uint32_t hashes_[NumEntries];
+  // One plus the number of the entry in each slot, or 0 if it is empty.
+  uint32_t slots_[kNumSlots];
+  // A stack of the inactive entries, the next one to use on top.
+  uint32_t free_entries_[NumEntries];
+  size_t free_count_;
+};
+
 // For historical reasons this specialized version is available with the same
 // size factors as a previous implementation.
 typedef NonAllocatingMap<256, 256, 64> SimpleStringDictionary;
@@ -30,6 +30,8 @@
 #include <config.h>  // Must come first
 #endif
 
+#include <stdio.h>
+
 #include "breakpad_googletest_includes.h"
 #include "common/simple_string_dictionary.h"
 
@@ -322,6 +324,134 @@ TEST(NonAllocatingMapTest, ByIndex) {
   EXPECT_FALSE(map.RemoveAtIndex(9999));
 }
 
+TEST(HashedNonAllocatingMapTest, AddRemove) {
+  HashedNonAllocatingMap<5, 7, 6> map;
+  map.SetKeyValue("rob", "ert");
+  map.SetKeyValue("mike", "pink");
+  map.SetKeyValue("mark", "allays");
+
+  EXPECT_EQ(3u, map.GetCount());
+  EXPECT_STREQ("ert", map.GetValueForKey("rob"));
+  EXPECT_STREQ("pink", map.GetValueForKey("mike"));
+  EXPECT_STREQ("allays", map.GetValueForKey("mark"));
+
+  map.RemoveKey("mike");
+
+  EXPECT_EQ(2u, map.GetCount());
+  EXPECT_FALSE(map.GetValueForKey("mike"));
+
+  map.SetKeyValue("mark", "mal");
+  EXPECT_EQ(2u, map.GetCount());
+  EXPECT_STREQ("mal", map.GetValueForKey("mark"));
+
+  map.RemoveKey("mark");
+  EXPECT_EQ(1u, map.GetCount());
+  EXPECT_FALSE(map.GetValueForKey("mark"));
+}
+
+TEST(HashedNonAllocatingMapTest, CopyAndAssign) {
+  HashedNonAllocatingMap<10, 10, 10> map;
+  map.SetKeyValue("one", "a");
+  map.SetKeyValue("two", "b");
+  map.SetKeyValue("three", "c");
+  map.RemoveKey("two");
+
+  HashedNonAllocatingMap<10, 10, 10> map_copy(map);
+  EXPECT_EQ(2u, map_copy.GetCount());
+  EXPECT_STREQ("a", map_copy.GetValueForKey("one"));
+  EXPECT_STREQ("c", map_copy.GetValueForKey("three"));
+  map_copy.SetKeyValue("four", "d");
+  EXPECT_STREQ("d", map_copy.GetValueForKey("four"));
+  EXPECT_FALSE(map.GetValueForKey("four"));
+
+  HashedNonAllocatingMap<10, 10, 10> map_assign;
+  map_assign = map;
+  EXPECT_EQ(2u, map_assign.GetCount());
+  map.RemoveKey("one");
+  EXPECT_FALSE(map.GetValueForKey("one"));
+  EXPECT_STREQ("a", map_assign.GetValueForKey("one"));
+}
+
+// Runs the same operations on both kinds of map, with more keys than fit and
+// a small index so that probe sequences collide, and checks they agree.
+TEST(HashedNonAllocatingMapTest, MatchesNonAllocatingMap) {
+  NonAllocatingMap<4, 6, 13> map;
+  HashedNonAllocatingMap<4, 6, 13> hashed;
+  uint32_t seed = 1;
+  for (int i = 0; i < 20000; ++i) {
+    seed = seed * 1103515245 + 12345;
+    char key[4];
+    snprintf(key, sizeof(key), "%u", (seed >> 8) % 40);
+    char value[6];
+    snprintf(value, sizeof(value), "%u", i % 10000);
+    if ((seed >> 20) % 3 == 0) {
+      EXPECT_EQ(map.RemoveKey(key), hashed.RemoveKey(key));
+    } else {
+      // Entries may be reused in a different order, so only compare
+      // whether there was room.
+      EXPECT_EQ(map.SetKeyValue(key, value) == map.num_entries,
+                hashed.SetKeyValue(key, value) == hashed.num_entries);
+    }
+    ASSERT_EQ(map.GetCount(), hashed.GetCount());
+    for (int k = 0; k < 40; ++k) {
+      snprintf(key, sizeof(key), "%d", k);
+      const char* expected = map.GetValueForKey(key);
+      const char* actual = hashed.GetValueForKey(key);
+      ASSERT_EQ(!expected, !actual) << key;
+      if (expected) {
+        EXPECT_STREQ(expected, actual);
+      }
+    }
+  }
+}
+
+TEST(HashedNonAllocatingMapTest, Serialize) {
+  NonAllocatingMap<4, 5, 7> map;
+  map.SetKeyValue("one", "abc");
+  map.SetKeyValue("two", "def");
+  map.SetKeyValue("tre", "hig");
+  map.RemoveKey("two");
+
+  // A map serialized by NonAllocatingMap can be read by the hashed map and
+  // the other way around.
+  const SerializedNonAllocatingMap* serialized;
+  size_t size = map.Serialize(&serialized);
+  HashedNonAllocatingMap<4, 5, 7> hashed(serialized, size);
+  EXPECT_EQ(2u, hashed.GetCount());
+  EXPECT_STREQ("abc", hashed.GetValueForKey("one"));
+  EXPECT_FALSE(hashed.GetValueForKey("two"));
+  EXPECT_STREQ("hig", hashed.GetValueForKey("tre"));
+
+  hashed.SetKeyValue("for", "jkl");
+  size = hashed.Serialize(&serialized);
+  NonAllocatingMap<4, 5, 7> unhashed(serialized, size);
+  EXPECT_EQ(3u, unhashed.GetCount());
+  EXPECT_STREQ("abc", unhashed.GetValueForKey("one"));
+  EXPECT_STREQ("hig", unhashed.GetValueForKey("tre"));
+  EXPECT_STREQ("jkl", unhashed.GetValueForKey("for"));
+}
+
+TEST(HashedNonAllocatingMapTest, OutOfSpaceAndByIndex) {
+  HashedNonAllocatingMap<10, 10, 2> map;
+  size_t index1 = map.SetKeyValue("test", "one");
+  size_t index2 = map.SetKeyValue("moo", "foo");
+  EXPECT_LT(index1, map.num_entries);
+  EXPECT_LT(index2, map.num_entries);
+  EXPECT_NE(index1, index2);
+  EXPECT_EQ(map.num_entries, map.SetKeyValue("nogo", "full"));
+  EXPECT_EQ(2u, map.GetCount());
+
+  map.SetValueAtIndex(index2, "booo");
+  EXPECT_STREQ("booo", map.GetValueForKey("moo"));
+
+  EXPECT_TRUE(map.RemoveAtIndex(index1));
+  EXPECT_FALSE(map.RemoveAtIndex(index1));
+  EXPECT_FALSE(map.GetValueForKey("test"));
+  EXPECT_EQ(index1, map.SetKeyValue("nogo", "room"));
+  EXPECT_STREQ("room", map.GetValueForKey("nogo"));
+  EXPECT_FALSE(map.RemoveAtIndex(9999));
+}
+
 #ifndef NDEBUG
 
 TEST(NonAllocatingMapTest, NullKey) {
@@ -142,11 +142,11 @@ bool StabsToModule::Extern(const string& name, uint64_t address) {
   // Older libstdc++ demangle implementations can crash on unexpected
   // input, so be careful about what gets passed in.
   if (name.compare(0, 3, "__Z") == 0) {
-    ext->name = Demangle(name.substr(1));
+    ext->name = module_->AddStringToPool(Demangle(name.substr(1)));
   } else if (name[0] == '_') {
-    ext->name = name.substr(1);
+    ext->name = module_->AddStringToPool(name.substr(1));
   } else {
-    ext->name = name;
+    ext->name = module_->AddStringToPool(name);
   }
   module_->AddExtern(std::move(ext));
   return true;
@@ -199,9 +199,11 @@ void StabsToModule::Finalize() {
   // Now that everything has a size, add our functions to the module, and
   // dispose of our private list. Delete the functions that we fail to add, so
   // they aren't leaked.
-  for (Module::Function* func: functions_)
+  for (Module::Function* func: functions_) {
     if (!module_->AddFunction(func))
       delete func;
+    module_->CheckFunctionLimit();
+  }
   functions_.clear();
 }
 
@@ -95,13 +95,13 @@ TEST(StabsToModule, Externs) {
   m.GetExterns(&externs, externs.end());
   ASSERT_EQ((size_t) 3, externs.size());
   Module::Extern *extern1 = externs[0];
-  EXPECT_STREQ("MorphTableGetNextMorphChain", extern1->name.c_str());
+  EXPECT_STREQ("MorphTableGetNextMorphChain", extern1->name.str().c_str());
   EXPECT_EQ((Module::Address)0x1111, extern1->address);
   Module::Extern *extern2 = externs[1];
-  EXPECT_STREQ("dyldGlobalLockAcquire()", extern2->name.c_str());
+  EXPECT_STREQ("dyldGlobalLockAcquire()", extern2->name.str().c_str());
   EXPECT_EQ((Module::Address)0xaaaa, extern2->address);
   Module::Extern *extern3 = externs[2];
-  EXPECT_STREQ("foo", extern3->name.c_str());
+  EXPECT_STREQ("foo", extern3->name.str().c_str());
   EXPECT_EQ((Module::Address)0xffff, extern3->address);
 }
 #endif  // __GNUC__
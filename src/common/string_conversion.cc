@@ -35,6 +35,7 @@
 #include "common/convert_UTF.h"
 #include "common/scoped_ptr.h"
 #include "common/string_conversion.h"
+#include "common/utf16_ascii.h"
 #include "common/using_std_string.h"
 
 namespace google_breakpad {
@@ -122,6 +123,15 @@ static inline uint16_t Swap(uint16_t value) {
 }
 
 string UTF16ToUTF8(const vector<uint16_t>& in, bool swap) {
+  // Most strings are entirely ASCII, and need no conversion beyond
+  // narrowing.  As below, the result ends at the first null character.
+  string ascii(in.size(), '\0');
+  if (in.empty() ||
+      CopyASCIIFromUTF16(&in[0], in.size(), swap, &ascii[0]) == in.size()) {
+    ascii.resize(strnlen(ascii.data(), ascii.size()));
+    return ascii;
+  }
+
   const UTF16* source_ptr = &in[0];
   scoped_array<uint16_t> source_buffer;
 
@@ -137,10 +147,11 @@ string UTF16ToUTF8(const vector<uint16_t>& in, bool swap) {
     source_ptr = source_buffer.get();
   }
 
-  // The maximum expansion would be 4x the size of the input string.
+  // The maximum expansion would be 4x the size of the input string, plus a
+  // null terminator in case the input has none.
   const UTF16* source_end_ptr = source_ptr + in.size();
   size_t target_capacity = in.size() * 4;
-  scoped_array<UTF8> target_buffer(new UTF8[target_capacity]);
+  scoped_array<UTF8> target_buffer(new UTF8[target_capacity + 1]);
   UTF8* target_ptr = target_buffer.get();
   UTF8* target_end_ptr = target_ptr + target_capacity;
   ConversionResult result = ConvertUTF16toUTF8(&source_ptr, source_end_ptr,
@@ -148,6 +159,7 @@ string UTF16ToUTF8(const vector<uint16_t>& in, bool swap) {
                                                strictConversion);
 
   if (result == conversionOK) {
+    *target_ptr = 0;
     const char* targetPtr = reinterpret_cast<const char*>(target_buffer.get());
     return targetPtr;
   }
@@ -41,6 +41,7 @@
 using google_breakpad::UTF8ToUTF16;
 using google_breakpad::UTF8ToUTF16Char;
 using google_breakpad::UTF16ToUTF8;
+using std::string;
 using std::vector;
 
 TEST(StringConversionTest, UTF8ToUTF16) {
@@ -65,3 +66,28 @@ TEST(StringConversionTest, UTF16ToUTF8) {
   vector<uint16_t> in{'a', 0xdf, 'c', 0};
   EXPECT_EQ("aßc", UTF16ToUTF8(in, false));
 }
+
+TEST(StringConversionTest, UTF16ToUTF8ASCII) {
+  const string ascii = "/usr/lib/x86_64-linux-gnu/libc.so.6";
+  vector<uint16_t> in(ascii.begin(), ascii.end());
+  EXPECT_EQ(ascii, UTF16ToUTF8(in, false));
+
+  vector<uint16_t> swapped;
+  for (char c : ascii)
+    swapped.push_back(static_cast<uint16_t>(c << 8));
+  EXPECT_EQ(ascii, UTF16ToUTF8(swapped, true));
+
+  // The result stops at a NUL, wherever in the string it is.
+  in[20] = 0;
+  EXPECT_EQ(ascii.substr(0, 20), UTF16ToUTF8(in, false));
+  EXPECT_EQ("", UTF16ToUTF8(vector<uint16_t>(), false));
+}
+
+TEST(StringConversionTest, UTF16ToUTF8NonASCIIAfterASCII) {
+  const string ascii = "C:\\Program Files\\Application\\";
+  vector<uint16_t> in(ascii.begin(), ascii.end());
+  in.push_back(0xdf);
+  in.push_back(0xd83d);
+  in.push_back(0xde00);
+  EXPECT_EQ(ascii + "ß\xf0\x9f\x98\x80", UTF16ToUTF8(in, false));
+}
@@ -77,6 +77,10 @@ class StringView {
   size_t size() const { return length_; }
 
   int compare(StringView rhs) const {
+    // Names pooled by Module::AddStringToPool share their data, so equal
+    // names usually compare equal without looking at their characters.
+    if (data_ == rhs.data_ && length_ == rhs.length_)
+      return 0;
     size_t min_len = std::min(size(), rhs.size());
     int res = memcmp(data_, rhs.data(), min_len);
     if (res != 0)
@@ -104,7 +108,7 @@ inline bool operator>(StringView lhs, StringView rhs) {
 }
 
 inline std::ostream& operator<<(std::ostream& os, StringView s) {
-  os << s.str();
+  os.write(s.data(), s.size());
   return os;
 }
 
@@ -0,0 +1,139 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// utf16_ascii.h: Fast copies of runs of ASCII characters between UTF-16 and
+// UTF-8.
+//
+// Most strings in minidumps, such as module paths and thread names, are
+// entirely ASCII, and an ASCII character has the same value in UTF-16 and
+// UTF-8.  These functions copy the leading run of ASCII characters of a
+// string, several at a time with SSE2 or NEON where available, and leave
+// the first non-ASCII character for a full converter to handle.  They are
+// inline so that both the processor and the client can use them without
+// linking anything more.
+
+#ifndef COMMON_UTF16_ASCII_H_
+#define COMMON_UTF16_ASCII_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace google_breakpad {
+
+// Copies the leading ASCII code units of |in|, up to |count| of them, to
+// |out| as UTF-8, and returns how many were copied.  If |swap| is true, each
+// code unit is byte-swapped before it is examined.  |out| must have room for
+// |count| bytes.
+inline size_t CopyASCIIFromUTF16(const uint16_t* in, size_t count, bool swap,
+                                 char* out) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i non_ascii = _mm_set1_epi16(static_cast<short>(0xff80));
+  for (; i + 16 <= count; i += 16) {
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    __m128i high =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8));
+    if (swap) {
+      low = _mm_or_si128(_mm_slli_epi16(low, 8), _mm_srli_epi16(low, 8));
+      high = _mm_or_si128(_mm_slli_epi16(high, 8), _mm_srli_epi16(high, 8));
+    }
+    __m128i either = _mm_and_si128(_mm_or_si128(low, high), non_ascii);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(either, _mm_setzero_si128())) !=
+        0xffff) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_packus_epi16(low, high));
+  }
+#elif defined(__aarch64__)
+  for (; i + 16 <= count; i += 16) {
+    uint16x8_t low = vld1q_u16(in + i);
+    uint16x8_t high = vld1q_u16(in + i + 8);
+    if (swap) {
+      low = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(low)));
+      high = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(high)));
+    }
+    if (vmaxvq_u16(vorrq_u16(low, high)) >= 0x80)
+      break;
+    vst1q_u8(reinterpret_cast<uint8_t*>(out + i),
+             vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+  }
+#endif
+  for (; i < count; ++i) {
+    uint16_t unit = in[i];
+    if (swap)
+      unit = static_cast<uint16_t>((unit >> 8) | (unit << 8));
+    if (unit >= 0x80)
+      break;
+    out[i] = static_cast<char>(unit);
+  }
+  return i;
+}
+
+// Copies the leading ASCII characters of |in|, up to |count| of them, to
+// |out| as UTF-16 code units in host byte order, and returns how many were
+// copied.  |out| must have room for |count| code units.
+inline size_t CopyASCIIToUTF16(const char* in, size_t count, uint16_t* out) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  for (; i + 16 <= count; i += 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    if (_mm_movemask_epi8(bytes) != 0)
+      break;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i),
+                     _mm_unpacklo_epi8(bytes, _mm_setzero_si128()));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8),
+                     _mm_unpackhi_epi8(bytes, _mm_setzero_si128()));
+  }
+#elif defined(__aarch64__)
+  for (; i + 16 <= count; i += 16) {
+    uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(in + i));
+    if (vmaxvq_u8(bytes) >= 0x80)
+      break;
+    vst1q_u16(out + i, vmovl_u8(vget_low_u8(bytes)));
+    vst1q_u16(out + i + 8, vmovl_high_u8(bytes));
+  }
+#endif
+  for (; i < count; ++i) {
+    unsigned char c = static_cast<unsigned char>(in[i]);
+    if (c >= 0x80)
+      break;
+    out[i] = c;
+  }
+  return i;
+}
+
+}  // namespace google_breakpad
+
+#endif  // COMMON_UTF16_ASCII_H_
@@ -32,6 +32,7 @@
 #define COMMON_WINDOWS_DIA_UTIL_H_
 
 #include <Windows.h>
+#include <atlbase.h>
 #include <dia2.h>
 
 namespace google_breakpad {
@@ -59,6 +60,57 @@ bool FindTable(IDiaSession* session, InterfaceType** table) {
                    reinterpret_cast<void**>(table));
 }
 
+// Walks the items of the DIA enumerator |enumerator| in order, fetching
+// them in batches. Fetching items one at a time costs a COM call per item,
+// which dominates the time taken to walk the symbols and lines of a large
+// PDB. Use it as:
+//
+//   DiaBatchEnumerator<IDiaEnumSymbols, IDiaSymbol> batch(symbols);
+//   CComPtr<IDiaSymbol> symbol;
+//   while (batch.Next(&symbol)) { ... }
+template<typename EnumeratorType, typename ItemType>
+class DiaBatchEnumerator {
+ public:
+  explicit DiaBatchEnumerator(EnumeratorType* enumerator)
+      : enumerator_(enumerator), count_(0), next_(0), done_(false) {}
+
+  ~DiaBatchEnumerator() {
+    for (ULONG i = next_; i < count_; ++i)
+      items_[i]->Release();
+  }
+
+  DiaBatchEnumerator(const DiaBatchEnumerator&) = delete;
+  DiaBatchEnumerator& operator=(const DiaBatchEnumerator&) = delete;
+
+  // Store the next item in |item|, releasing whatever it held, and return
+  // true. Return false once the enumerator has no more items, or fails.
+  bool Next(CComPtr<ItemType>* item) {
+    if (next_ == count_) {
+      if (done_)
+        return false;
+      next_ = 0;
+      count_ = 0;
+      if (FAILED(enumerator_->Next(kBatchSize, items_, &count_)))
+        count_ = 0;
+      // The enumerator returns fewer items than asked for only at the end.
+      done_ = count_ < kBatchSize;
+      if (count_ == 0)
+        return false;
+    }
+    item->Attach(items_[next_++]);
+    return true;
+  }
+
+ private:
+  static const ULONG kBatchSize = 256;
+
+  EnumeratorType* enumerator_;
+  ItemType* items_[kBatchSize];
+  ULONG count_;
+  ULONG next_;
+  bool done_;
+};
+
 }  // namespace google_breakpad
 
 #endif  // COMMON_WINDOWS_DIA_UTIL_H_
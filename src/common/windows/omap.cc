@@ -110,7 +110,6 @@
 
 #include <algorithm>
 #include <cassert>
-#include <set>
 
 #include "common/windows/dia_util.h"
 
@@ -416,20 +415,23 @@ void BuildEndpointIndexMap(ImageMap* image_map) {
   EndpointIndexMap& eim = image_map->endpoint_index_map;
 
   // Get the unique set of interval endpoints.
-  std::set<DWORD> endpoints;
+  std::vector<DWORD> endpoints;
+  endpoints.reserve(2 * mapping.size());
   for (size_t i = 0; i < mapping.size(); ++i) {
-    endpoints.insert(mapping[i].rva_original);
-    endpoints.insert(mapping[i].rva_original +
-                         mapping[i].length +
-                         mapping[i].removed);
+    endpoints.push_back(mapping[i].rva_original);
+    endpoints.push_back(mapping[i].rva_original +
+                            mapping[i].length +
+                            mapping[i].removed);
   }
+  std::sort(endpoints.begin(), endpoints.end());
+  endpoints.erase(std::unique(endpoints.begin(), endpoints.end()),
+                  endpoints.end());
 
   // Use the endpoints to initialize the secondary search structure for the
   // mapping.
   eim.resize(endpoints.size());
-  std::set<DWORD>::const_iterator it = endpoints.begin();
-  for (size_t i = 0; it != endpoints.end(); ++it, ++i) {
-    eim[i].endpoint = *it;
+  for (size_t i = 0; i < endpoints.size(); ++i) {
+    eim[i].endpoint = endpoints[i];
     eim[i].index = mapping.size();
   }
 
@@ -535,6 +537,115 @@ void ClipMappedRangeOriginal(const AddressRange& clip_range,
   return;
 }
 
+// Appends the ranges in the transformed image that |original_range| maps to
+// to |mapped_ranges|. |it1| is the first entry of the image map's secondary
+// index whose endpoint isn't below |original_range|. |temp_ranges| is scratch
+// space, which callers mapping many ranges can reuse.
+void MapQueryRange(const ImageMap& image_map,
+                   const AddressRange& original_range,
+                   EndpointIndexMap::const_iterator it1,
+                   Mapping* temp_ranges,
+                   AddressRangeVector* mapped_ranges) {
+  const Mapping& map = image_map.mapping;
+
+  // If we get a query of length 0 we need to handle it by using a non-zero
+  // query length.
+  AddressRange query_range(original_range);
+  if (query_range.length == 0)
+    query_range.length = 1;
+
+  // Find the range of intervals that can potentially intersect our query range.
+  size_t imin = 0;
+  size_t imax = 0;
+  {
+    const EndpointIndexMap& eim = image_map.endpoint_index_map;
+    if (it1 == eim.end()) {
+      imin  = map.size();
+    } else {
+      // Backup to find the interval that contains our query point.
+      if (it1 != eim.begin() && query_range.rva < it1->endpoint)
+        --it1;
+      imin = it1->index;
+    }
+
+    // The first range that can't possibly intersect us is found by searching
+    // through the image map directly as it is already sorted by interval start
+    // point.
+    MappedRange q2 = { query_range.end(), 0 };
+    Mapping::const_iterator it2 = std::lower_bound(
+        map.begin(), map.end(), q2, MappedRangeOriginalLess);
+    imax = it2 - map.begin();
+  }
+
+  // Find all intervals that intersect the query range.
+  Mapping& temp_map = *temp_ranges;
+  temp_map.clear();
+  for (size_t i = imin; i < imax; ++i) {
+    MappedRange mr = map[i];
+    ClipMappedRangeOriginal(query_range, &mr);
+    if (mr.length + mr.injected > 0)
+      temp_map.push_back(mr);
+  }
+
+  // If there are no intersecting ranges then the query range has been removed
+  // from the image in question.
+  if (temp_map.empty())
+    return;
+
+  // Sort based on transformed addresses. Most queries fall within a single
+  // range, or ranges that kept their order, so there is usually no work.
+  if (!std::is_sorted(temp_map.begin(), temp_map.end(),
+                      MappedRangeMappedLess)) {
+    std::sort(temp_map.begin(), temp_map.end(), MappedRangeMappedLess);
+  }
+
+  // Zero-length queries can't actually be merged. We simply output the set of
+  // unique RVAs that correspond to the query RVA.
+  if (original_range.length == 0) {
+    mapped_ranges->push_back(AddressRange(temp_map[0].rva_transformed, 0));
+    for (size_t i = 1; i < temp_map.size(); ++i) {
+      if (temp_map[i].rva_transformed > mapped_ranges->back().rva)
+        mapped_ranges->push_back(AddressRange(temp_map[i].rva_transformed, 0));
+    }
+    return;
+  }
+
+  // Merge any ranges that are consecutive in the mapped image. We merge over
+  // injected content if it makes ranges contiguous, but we ignore any injected
+  // content at the tail end of a range. This allows us to detect symbols that
+  // have been lengthened by injecting content in the middle. However, it
+  // misses the case where content has been injected at the head or the tail.
+  // The problem is that it doesn't know whether to attribute it to the
+  // preceding or following symbol. It is up to the author of the transform to
+  // output explicit OMAP info in these cases to ensure full coverage of the
+  // transformed address space.
+  DWORD rva_begin = temp_map[0].rva_transformed;
+  DWORD rva_cur_content = rva_begin + temp_map[0].length;
+  DWORD rva_cur_injected = rva_cur_content + temp_map[0].injected;
+  for (size_t i = 1; i < temp_map.size(); ++i) {
+    if (rva_cur_injected < temp_map[i].rva_transformed) {
+      // This marks the end of a continuous range in the image. Output the
+      // current range and start a new one.
+      if (rva_begin < rva_cur_content) {
+        mapped_ranges->push_back(
+            AddressRange(rva_begin, rva_cur_content - rva_begin));
+      }
+      rva_begin = temp_map[i].rva_transformed;
+    }
+
+    rva_cur_content = temp_map[i].rva_transformed + temp_map[i].length;
+    rva_cur_injected = rva_cur_content + temp_map[i].injected;
+  }
+
+  // Output the range in progress.
+  if (rva_begin < rva_cur_content) {
+    mapped_ranges->push_back(
+        AddressRange(rva_begin, rva_cur_content - rva_begin));
+  }
+
+  return;
+}
+
 }  // namespace
 
 int AddressRange::Compare(const AddressRange& rhs) const {
@@ -619,102 +730,42 @@ void MapAddressRange(const ImageMap& image_map,
     return;
   }
 
-  // If we get a query of length 0 we need to handle it by using a non-zero
-  // query length.
-  AddressRange query_range(original_range);
-  if (query_range.length == 0)
-    query_range.length = 1;
-
-  // Find the range of intervals that can potentially intersect our query range.
-  size_t imin = 0;
-  size_t imax = 0;
-  {
-    // The index of the earliest possible range that can affect is us done by
-    // searching through the secondary indexing structure.
-    const EndpointIndexMap& eim = image_map.endpoint_index_map;
-    EndpointIndex q1 = { query_range.rva, 0 };
-    EndpointIndexMap::const_iterator it1 = std::lower_bound(
-        eim.begin(), eim.end(), q1, EndpointIndexLess);
-    if (it1 == eim.end()) {
-      imin  = map.size();
-    } else {
-      // Backup to find the interval that contains our query point.
-      if (it1 != eim.begin() && query_range.rva < it1->endpoint)
-        --it1;
-      imin = it1->index;
-    }
-
-    // The first range that can't possibly intersect us is found by searching
-    // through the image map directly as it is already sorted by interval start
-    // point.
-    MappedRange q2 = { query_range.end(), 0 };
-    Mapping::const_iterator it2 = std::lower_bound(
-        map.begin(), map.end(), q2, MappedRangeOriginalLess);
-    imax = it2 - map.begin();
-  }
+  // The index of the earliest possible range that can affect us is found by
+  // searching through the secondary indexing structure.
+  const EndpointIndexMap& eim = image_map.endpoint_index_map;
+  EndpointIndex q1 = { original_range.rva, 0 };
+  EndpointIndexMap::const_iterator it1 = std::lower_bound(
+      eim.begin(), eim.end(), q1, EndpointIndexLess);
 
-  // Find all intervals that intersect the query range.
   Mapping temp_map;
-  for (size_t i = imin; i < imax; ++i) {
-    MappedRange mr = map[i];
-    ClipMappedRangeOriginal(query_range, &mr);
-    if (mr.length + mr.injected > 0)
-      temp_map.push_back(mr);
-  }
-
-  // If there are no intersecting ranges then the query range has been removed
-  // from the image in question.
-  if (temp_map.empty())
-    return;
+  MapQueryRange(image_map, original_range, it1, &temp_map, mapped_ranges);
+}
 
-  // Sort based on transformed addresses.
-  std::sort(temp_map.begin(), temp_map.end(), MappedRangeMappedLess);
+void MapAddressRanges(const ImageMap& image_map,
+                      const AddressRangeVector& original_ranges,
+                      std::vector<AddressRangeVector>* mapped_ranges) {
+  assert(mapped_ranges != NULL);
 
-  // Zero-length queries can't actually be merged. We simply output the set of
-  // unique RVAs that correspond to the query RVA.
-  if (original_range.length == 0) {
-    mapped_ranges->push_back(AddressRange(temp_map[0].rva_transformed, 0));
-    for (size_t i = 1; i < temp_map.size(); ++i) {
-      if (temp_map[i].rva_transformed > mapped_ranges->back().rva)
-        mapped_ranges->push_back(AddressRange(temp_map[i].rva_transformed, 0));
-    }
+  mapped_ranges->resize(original_ranges.size());
+  if (image_map.mapping.empty()) {
+    for (size_t i = 0; i < original_ranges.size(); ++i)
+      (*mapped_ranges)[i].push_back(original_ranges[i]);
     return;
   }
 
-  // Merge any ranges that are consecutive in the mapped image. We merge over
-  // injected content if it makes ranges contiguous, but we ignore any injected
-  // content at the tail end of a range. This allows us to detect symbols that
-  // have been lengthened by injecting content in the middle. However, it
-  // misses the case where content has been injected at the head or the tail.
-  // The problem is that it doesn't know whether to attribute it to the
-  // preceding or following symbol. It is up to the author of the transform to
-  // output explicit OMAP info in these cases to ensure full coverage of the
-  // transformed address space.
-  DWORD rva_begin = temp_map[0].rva_transformed;
-  DWORD rva_cur_content = rva_begin + temp_map[0].length;
-  DWORD rva_cur_injected = rva_cur_content + temp_map[0].injected;
-  for (size_t i = 1; i < temp_map.size(); ++i) {
-    if (rva_cur_injected < temp_map[i].rva_transformed) {
-      // This marks the end of a continuous range in the image. Output the
-      // current range and start a new one.
-      if (rva_begin < rva_cur_content) {
-        mapped_ranges->push_back(
-            AddressRange(rva_begin, rva_cur_content - rva_begin));
-      }
-      rva_begin = temp_map[i].rva_transformed;
-    }
-
-    rva_cur_content = temp_map[i].rva_transformed + temp_map[i].length;
-    rva_cur_injected = rva_cur_content + temp_map[i].injected;
-  }
-
-  // Output the range in progress.
-  if (rva_begin < rva_cur_content) {
-    mapped_ranges->push_back(
-        AddressRange(rva_begin, rva_cur_content - rva_begin));
+  // The queries are sorted by address, so rather than searching the
+  // secondary index for each of them, walk it alongside them.
+  const EndpointIndexMap& eim = image_map.endpoint_index_map;
+  EndpointIndexMap::const_iterator it1 = eim.begin();
+  Mapping temp_map;
+  for (size_t i = 0; i < original_ranges.size(); ++i) {
+    const AddressRange& original_range = original_ranges[i];
+    assert(i == 0 || original_ranges[i - 1].rva <= original_range.rva);
+    while (it1 != eim.end() && it1->endpoint < original_range.rva)
+      ++it1;
+    MapQueryRange(image_map, original_range, it1, &temp_map,
+                  &(*mapped_ranges)[i]);
   }
-
-  return;
 }
 
 }  // namespace google_breakpad
@@ -67,6 +67,15 @@ void MapAddressRange(const ImageMap& image_map,
                      const AddressRange& original_range,
                      AddressRangeVector* mapped_ranges);
 
+// As MapAddressRange, but maps each of |original_ranges|, which must be
+// sorted by address, walking the image map once for all of them rather than
+// searching it for each.
+// |mapped_ranges| will be resized to hold the ranges that each of
+//     |original_ranges| maps to, at the same index.
+void MapAddressRanges(const ImageMap& image_map,
+                      const AddressRangeVector& original_ranges,
+                      std::vector<AddressRangeVector>* mapped_ranges);
+
 }  // namespace google_breakpad
 
 #endif  // COMMON_WINDOWS_OMAP_H_
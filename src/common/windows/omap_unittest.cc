@@ -330,4 +330,24 @@ TEST_F(MapAddressRangeTest, MapFull) {
   EXPECT_THAT(mapped_ranges, testing::ElementsAre(AHt));
 }
 
+TEST_F(MapAddressRangeTest, MapSortedRanges) {
+  AddressRangeVector original_ranges;
+  original_ranges.push_back(AddressRange(0, H.end()));
+  original_ranges.push_back(B);
+  original_ranges.push_back(C);
+  original_ranges.push_back(D);
+  original_ranges.push_back(AddressRange(G.rva, 0));
+  original_ranges.push_back(H);
+  original_ranges.push_back(AddressRange(H.end() + 10, 10));
+
+  std::vector<AddressRangeVector> mapped_ranges;
+  MapAddressRanges(image_map, original_ranges, &mapped_ranges);
+  ASSERT_EQ(original_ranges.size(), mapped_ranges.size());
+  for (size_t i = 0; i < original_ranges.size(); ++i) {
+    AddressRangeVector expected;
+    MapAddressRange(image_map, original_ranges[i], &expected);
+    EXPECT_THAT(mapped_ranges[i], testing::ContainerEq(expected));
+  }
+}
+
 }  // namespace google_breakpad
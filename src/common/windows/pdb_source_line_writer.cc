@@ -529,10 +529,10 @@ bool PDBSourceLineWriter::GetLine(IDiaLineNumber* dia_line, Line* line) const {
 
 bool PDBSourceLineWriter::GetLines(IDiaEnumLineNumbers* lines,
                                    Lines* line_list) const {
+  DiaBatchEnumerator<IDiaEnumLineNumbers, IDiaLineNumber> line_batch(lines);
   CComPtr<IDiaLineNumber> line;
-  ULONG count;
 
-  while (SUCCEEDED(lines->Next(1, &line, &count)) && count == 1) {
+  while (line_batch.Next(&line)) {
     Line l;
     if (!GetLine(line, &l))
       return false;
@@ -547,11 +547,18 @@ bool PDBSourceLineWriter::GetLines(IDiaEnumLineNumbers* lines,
 void PDBSourceLineWriter::PrintLines(const Lines& lines) const {
   // The line number format is:
   // <rva> <line number> <source file id>
+  // The line map is sorted by address, so map all of the lines at once.
+  AddressRangeVector line_ranges;
+  line_ranges.reserve(lines.GetLineMap().size());
+  for (const auto& kv : lines.GetLineMap())
+    line_ranges.push_back(AddressRange(kv.second.rva, kv.second.length));
+  vector<AddressRangeVector> mapped_ranges;
+  MapAddressRanges(image_map_, line_ranges, &mapped_ranges);
+
+  size_t i = 0;
   for (const auto& kv : lines.GetLineMap()) {
     const Line& l = kv.second;
-    AddressRangeVector ranges;
-    MapAddressRange(image_map_, AddressRange(l.rva, l.length), &ranges);
-    for (auto& range : ranges) {
+    for (auto& range : mapped_ranges[i++]) {
       fprintf(output_, "%lx %lx %lu %lu\n", range.rva, range.length, l.line_num,
               l.file_id);
     }
@@ -641,15 +648,17 @@ bool PDBSourceLineWriter::PrintSourceFiles() {
   // inline records might have unknown call site.
   fwprintf(output_, L"FILE %d unknown file\n", 0);
 
+  DiaBatchEnumerator<IDiaEnumSymbols, IDiaSymbol> compiland_batch(compilands);
   CComPtr<IDiaSymbol> compiland;
-  ULONG count;
-  while (SUCCEEDED(compilands->Next(1, &compiland, &count)) && count == 1) {
+  while (compiland_batch.Next(&compiland)) {
     CComPtr<IDiaEnumSourceFiles> source_files;
     if (FAILED(session_->findFile(compiland, NULL, nsNone, &source_files))) {
       return false;
     }
+    DiaBatchEnumerator<IDiaEnumSourceFiles, IDiaSourceFile> file_batch(
+        source_files);
     CComPtr<IDiaSourceFile> file;
-    while (SUCCEEDED(source_files->Next(1, &file, &count)) && count == 1) {
+    while (file_batch.Next(&file)) {
       DWORD file_id;
       if (FAILED(file->get_uniqueId(&file_id))) {
         return false;
@@ -678,7 +687,6 @@ bool PDBSourceLineWriter::PrintSourceFiles() {
 }
 
 bool PDBSourceLineWriter::PrintFunctions() {
-  ULONG count = 0;
   DWORD rva = 0;
   CComPtr<IDiaSymbol> global;
   HRESULT hr;
@@ -695,9 +703,10 @@ bool PDBSourceLineWriter::PrintFunctions() {
   hr = global->findChildren(SymTagFunction, NULL, nsNone, &symbols);
 
   if (SUCCEEDED(hr)) {
+    DiaBatchEnumerator<IDiaEnumSymbols, IDiaSymbol> symbol_batch(symbols);
     CComPtr<IDiaSymbol> symbol = NULL;
 
-    while (SUCCEEDED(symbols->Next(1, &symbol, &count)) && count == 1) {
+    while (symbol_batch.Next(&symbol)) {
       if (SUCCEEDED(symbol->get_relativeVirtualAddress(&rva))) {
         // Potentially record this as the canonical symbol for this rva.
         MaybeRecordSymbol(rva, symbol, false, &rva_symbol);
@@ -717,9 +726,10 @@ bool PDBSourceLineWriter::PrintFunctions() {
   hr = global->findChildren(SymTagPublicSymbol, NULL, nsNone, &symbols);
 
   if (SUCCEEDED(hr)) {
+    DiaBatchEnumerator<IDiaEnumSymbols, IDiaSymbol> symbol_batch(symbols);
     CComPtr<IDiaSymbol> symbol = NULL;
 
-    while (SUCCEEDED(symbols->Next(1, &symbol, &count)) && count == 1) {
+    while (symbol_batch.Next(&symbol)) {
       if (SUCCEEDED(symbol->get_relativeVirtualAddress(&rva))) {
         // Potentially record this as the canonical symbol for this rva.
         MaybeRecordSymbol(rva, symbol, true, &rva_symbol);
@@ -762,8 +772,9 @@ bool PDBSourceLineWriter::PrintFunctions() {
     return false;
   }
 
+  DiaBatchEnumerator<IDiaEnumSymbols, IDiaSymbol> compiland_batch(compilands);
   CComPtr<IDiaSymbol> compiland;
-  while (SUCCEEDED(compilands->Next(1, &compiland, &count)) && count == 1) {
+  while (compiland_batch.Next(&compiland)) {
     CComPtr<IDiaEnumSymbols> blocks;
     if (FAILED(compiland->findChildren(SymTagBlock, NULL,
                                        nsNone, &blocks))) {
@@ -771,8 +782,9 @@ bool PDBSourceLineWriter::PrintFunctions() {
       return false;
     }
 
+    DiaBatchEnumerator<IDiaEnumSymbols, IDiaSymbol> block_batch(blocks);
     CComPtr<IDiaSymbol> block;
-    while (SUCCEEDED(blocks->Next(1, &block, &count)) && count == 1) {
+    while (block_batch.Next(&block)) {
       // find this block's lexical parent function
       CComPtr<IDiaSymbol> parent;
       DWORD tag;
@@ -827,10 +839,10 @@ bool PDBSourceLineWriter::GetInlines(IDiaSymbol* block,
                                    &inline_callsites))) {
     return false;
   }
-  ULONG count;
+  DiaBatchEnumerator<IDiaEnumSymbols, IDiaSymbol> callsite_batch(
+      inline_callsites);
   CComPtr<IDiaSymbol> callsite;
-  while (SUCCEEDED(inline_callsites->Next(1, &callsite, &count)) &&
-         count == 1) {
+  while (callsite_batch.Next(&callsite)) {
     unique_ptr<Inline> new_inline(new Inline(inline_nest_level));
     CComPtr<IDiaEnumLineNumbers> lines;
     // All inlinee lines have the same file id.
@@ -839,8 +851,9 @@ bool PDBSourceLineWriter::GetInlines(IDiaSymbol* block,
     if (FAILED(session_->findInlineeLines(callsite, &lines))) {
       return false;
     }
+    DiaBatchEnumerator<IDiaEnumLineNumbers, IDiaLineNumber> line_batch(lines);
     CComPtr<IDiaLineNumber> dia_line;
-    while (SUCCEEDED(lines->Next(1, &dia_line, &count)) && count == 1) {
+    while (line_batch.Next(&dia_line)) {
       Line line;
       if (!GetLine(dia_line, &line)) {
         return false;
@@ -898,10 +911,10 @@ bool PDBSourceLineWriter::PrintFrameDataUsingPDB() {
   DWORD last_code_size = 0;
   DWORD last_prolog_size = std::numeric_limits<DWORD>::max();
 
+  DiaBatchEnumerator<IDiaEnumFrameData, IDiaFrameData> frame_data_batch(
+      frame_data_enum);
   CComPtr<IDiaFrameData> frame_data;
-  ULONG count = 0;
-  while (SUCCEEDED(frame_data_enum->Next(1, &frame_data, &count)) &&
-         count == 1) {
+  while (frame_data_batch.Next(&frame_data)) {
     DWORD type;
     if (FAILED(frame_data->get_type(&type)))
       return false;
@@ -1321,9 +1334,9 @@ int PDBSourceLineWriter::GetFunctionStackParamSize(IDiaSymbol* function) {
   int lowest_base = INT_MAX;
   int highest_end = INT_MIN;
 
+  DiaBatchEnumerator<IDiaEnumSymbols, IDiaSymbol> child_batch(data_children);
   CComPtr<IDiaSymbol> child;
-  DWORD count;
-  while (SUCCEEDED(data_children->Next(1, &child, &count)) && count == 1) {
+  while (child_batch.Next(&child)) {
     // If any operation fails at this point, just proceed to the next child.
     // Use the next_child label instead of continue because child needs to
     // be released before it's reused.  Declare constructable/destructable
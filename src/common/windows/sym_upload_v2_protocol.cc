@@ -32,6 +32,9 @@
 
 #include "common/windows/sym_upload_v2_protocol.h"
 
+#include <windows.h>
+
+#include <algorithm>
 #include <cstdio>
 
 #include "common/windows/http_upload.h"
@@ -42,10 +45,63 @@ using google_breakpad::HTTPUpload;
 using google_breakpad::SymbolCollectorClient;
 using google_breakpad::SymbolStatus;
 using google_breakpad::UploadUrlResponse;
+using std::vector;
 using std::wstring;
 
 namespace google_breakpad {
 
+namespace {
+
+// The delay before the first retry of a failed batch upload, doubled for
+// each retry after that up to kMaxRetryDelayMs.
+const DWORD kRetryDelayMs = 1000;
+const DWORD kMaxRetryDelayMs = 30 * 1000;
+
+// State shared by the threads of SymUploadV2ProtocolSendBatch.
+struct BatchState {
+  const wchar_t* api_url;
+  const wchar_t* api_key;
+  int* timeout_ms;
+  const vector<SymUploadV2File>* files;
+  const wstring* product_name;
+  bool force;
+  int retries;
+  volatile LONG next_file;  // Index of the next file to send, less one.
+  volatile LONG failures;
+};
+
+DWORD WINAPI SendBatchFiles(void* context) {
+  BatchState* state = reinterpret_cast<BatchState*>(context);
+  LONG count = static_cast<LONG>(state->files->size());
+  for (LONG index = InterlockedIncrement(&state->next_file); index < count;
+       index = InterlockedIncrement(&state->next_file)) {
+    const SymUploadV2File& file = (*state->files)[index];
+    // Each thread needs its own copy of the timeout, which the requests
+    // may update.
+    int timeout = state->timeout_ms ? *state->timeout_ms : 0;
+    DWORD delay_ms = kRetryDelayMs;
+    bool success = false;
+    for (int attempt = 0; ; ++attempt) {
+      success = SymUploadV2ProtocolSend(
+          state->api_url, state->api_key,
+          state->timeout_ms ? &timeout : nullptr, file.debug_file,
+          file.debug_id, file.symbol_filename, file.symbol_type,
+          *state->product_name, state->force);
+      if (success || attempt >= state->retries)
+        break;
+      Sleep(delay_ms);
+      delay_ms = std::min(delay_ms * 2, kMaxRetryDelayMs);
+    }
+    if (!success) {
+      fwprintf(stderr, L"Failed to upload %s\n", file.symbol_filename.c_str());
+      InterlockedIncrement(&state->failures);
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
 static bool SymUploadV2ProtocolSend(const wchar_t* api_url,
                                     const wchar_t* api_key,
                                     int* timeout_ms,
@@ -119,4 +175,47 @@ static bool SymUploadV2ProtocolSend(const wchar_t* api_url,
   return true;
 }
 
+bool SymUploadV2ProtocolSendBatch(const wchar_t* api_url,
+                                  const wchar_t* api_key,
+                                  int* timeout_ms,
+                                  const vector<SymUploadV2File>& files,
+                                  const wstring& product_name,
+                                  bool force,
+                                  int jobs,
+                                  int retries) {
+  BatchState state;
+  state.api_url = api_url;
+  state.api_key = api_key;
+  state.timeout_ms = timeout_ms;
+  state.files = &files;
+  state.product_name = &product_name;
+  state.force = force;
+  state.retries = retries;
+  state.next_file = -1;
+  state.failures = 0;
+
+  size_t thread_count = std::min(files.size(), static_cast<size_t>(
+      std::min(std::max(jobs, 1), MAXIMUM_WAIT_OBJECTS)));
+  vector<HANDLE> threads;
+  for (size_t i = 0; i < thread_count; ++i) {
+    HANDLE thread = CreateThread(NULL, 0, SendBatchFiles, &state, 0, NULL);
+    if (thread)
+      threads.push_back(thread);
+  }
+  if (threads.empty()) {
+    // Send them on this thread instead.
+    SendBatchFiles(&state);
+  } else {
+    WaitForMultipleObjects(static_cast<DWORD>(threads.size()), &threads[0],
+                           TRUE, INFINITE);
+    for (size_t i = 0; i < threads.size(); ++i)
+      CloseHandle(threads[i]);
+  }
+
+  wprintf(L"Sent %d of %d symbol files.\n",
+          static_cast<int>(files.size()) - state.failures,
+          static_cast<int>(files.size()));
+  return state.failures == 0;
+}
+
 }  // namespace google_breakpad
@@ -30,6 +30,7 @@
 #define COMMON_WINDOWS_SYM_UPLOAD_V2_PROTOCOL_H_
 
 #include <string>
+#include <vector>
 
 namespace google_breakpad {
 
@@ -61,6 +62,29 @@ bool SymUploadV2ProtocolSend(const wchar_t* api_url,
                              const std::wstring& product_name,
                              bool force);
 
+// A symbol file for SymUploadV2ProtocolSendBatch, with the identifiers and
+// type to send it with as for SymUploadV2ProtocolSend.
+struct SymUploadV2File {
+  std::wstring debug_file;
+  std::wstring debug_id;
+  std::wstring symbol_filename;
+  std::wstring symbol_type;
+};
+
+// Sends each of |files| as SymUploadV2ProtocolSend would, on up to |jobs|
+// threads at once, so that checking whether symbols already exist and
+// uploading those that don't overlap across files. A failed upload is
+// retried up to |retries| times, waiting longer before each retry.
+// Returns true if every file was sent, or already existed.
+bool SymUploadV2ProtocolSendBatch(const wchar_t* api_url,
+                                  const wchar_t* api_key,
+                                  int* timeout_ms,
+                                  const std::vector<SymUploadV2File>& files,
+                                  const std::wstring& product_name,
+                                  bool force,
+                                  int jobs,
+                                  int retries);
+
 }  // namespace google_breakpad
 
 #endif  // COMMON_WINDOWS_SYM_UPLOAD_V2_PROTOCOL_H_
\ No newline at end of file
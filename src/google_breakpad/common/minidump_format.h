@@ -327,7 +327,7 @@ typedef enum {
   MD_EXCEPTION_STREAM            =  6,  /* MDRawExceptionStream */
   MD_SYSTEM_INFO_STREAM          =  7,  /* MDRawSystemInfo */
   MD_THREAD_EX_LIST_STREAM       =  8,
-  MD_MEMORY_64_LIST_STREAM       =  9,
+  MD_MEMORY_64_LIST_STREAM       =  9,  /* MDRawMemory64List */
   MD_COMMENT_STREAM_A            = 10,
   MD_COMMENT_STREAM_W            = 11,
   MD_HANDLE_DATA_STREAM          = 12,
@@ -357,6 +357,17 @@ typedef enum {
   MD_LINUX_AUXV                  = 0x47670008,  /* /proc/$x/auxv      */
   MD_LINUX_MAPS                  = 0x47670009,  /* /proc/$x/maps      */
   MD_LINUX_DSO_DEBUG             = 0x4767000A,  /* MDRawDebug{32,64}  */
+  /* The memory of a live process that was read after it was let run
+   * again, so that it may not match the threads' registers or the rest
+   * of the memory.  Its descriptors repeat those of the memory list. */
+  MD_LINUX_INCONSISTENT_MEMORY   = 0x4767000B,  /* MDRawMemoryList    */
+  /* How long each phase of writing the minidump took. */
+  MD_DUMP_TIMING_STREAM          = 0x4767000C,  /* MDRawDumpTimingList */
+  /* A hash of where the client crashed, for telling crashes of the same
+   * bug apart without processing their minidumps. */
+  MD_CRASH_SIGNATURE_STREAM      = 0x4767000D,  /* MDRawCrashSignature */
+  /* Where a minidump stands in a series of snapshots of one process. */
+  MD_SNAPSHOT_SERIES_STREAM      = 0x4767000E,  /* MDRawSnapshotSeries */
 
   /* Crashpad extension types. 0x4350 = "CP"
    * See Crashpad's minidump/minidump_extensions.h. */
@@ -553,6 +564,25 @@ static const size_t MDRawMemoryList_minsize = offsetof(MDRawMemoryList,
                                                        memory_ranges[0]);
 
 
+/* MDMemoryDescriptor64 is used in the MDRawMemory64List carried by
+ * MD_MEMORY_64_LIST_STREAM, as found in full-memory dumps.  It has no RVA
+ * of its own: memory ranges are stored contiguously starting at the
+ * list's base_rva, in the order of their descriptors. */
+typedef struct {
+  uint64_t start_of_memory_range;
+  uint64_t data_size;
+} MDMemoryDescriptor64;  /* MINIDUMP_MEMORY_DESCRIPTOR64 */
+
+typedef struct {
+  uint64_t             number_of_memory_ranges;
+  MDRVA64              base_rva;
+  MDMemoryDescriptor64 memory_ranges[1];
+} MDRawMemory64List;  /* MINIDUMP_MEMORY64_LIST */
+
+static const size_t MDRawMemory64List_minsize = offsetof(MDRawMemory64List,
+                                                         memory_ranges[0]);
+
+
 #define MD_EXCEPTION_MAXIMUM_PARAMETERS 15u
 
 typedef struct {
@@ -1049,6 +1079,99 @@ typedef enum {
   MD_ASSERTION_INFO_TYPE_PURE_VIRTUAL_CALL
 } MDAssertionInfoData;
 
+/* The MD_DUMP_TIMING_STREAM records how long the client spent in each phase
+ * of writing the minidump, so that slow or truncated dumps can be explained.
+ * Times are in nanoseconds of a monotonic clock, and start times are relative
+ * to the moment the client began to write the dump.  The stream is an
+ * MDRawDumpTimingList followed by number_of_entries MDRawDumpPhaseTiming
+ * entries, at most one for each phase.  A phase that was entered several
+ * times, such as one stack copy per thread, has the time of all of them
+ * added together. */
+
+typedef struct {
+  uint32_t size_of_header;    /* sizeof(MDRawDumpTimingList) */
+  uint32_t size_of_entry;     /* sizeof(MDRawDumpPhaseTiming) */
+  uint64_t number_of_entries;
+} MDRawDumpTimingList;
+
+typedef struct {
+  uint32_t phase;       /* MDDumpPhase */
+  uint32_t count;       /* The number of things the phase handled; see
+                         * MDDumpPhase. */
+  uint64_t bytes;       /* The number of bytes the phase handled, if any. */
+  uint64_t start_time;  /* When the phase was first entered. */
+  uint64_t duration;    /* The time spent in the phase. */
+} MDRawDumpPhaseTiming;
+
+/* The MD_CRASH_SIGNATURE_STREAM holds a quick signature that the client
+ * computed when it crashed: a 64-bit FNV-1a hash of the build id of the
+ * module holding the crashing instruction, and that instruction's offset
+ * into the module, followed by the same for each of the next few return
+ * addresses on the crashing thread's stack.  Crashes at the same place in
+ * the same build have the same signature wherever their modules were
+ * loaded, so uploaders and servers can spot duplicates cheaply.  Return
+ * addresses outside any known module are left out of the hash. */
+
+typedef struct {
+  uint64_t signature;
+  uint32_t frame_count;  /* The number of addresses that were hashed. */
+  uint32_t reserved;
+} MDRawCrashSignature;
+
+/* The MD_SNAPSHOT_SERIES_STREAM marks a minidump as one of a series of
+ * snapshots of a process that is not expected to have crashed, such as a
+ * hang detector takes of a stuck process every few seconds.  The first
+ * snapshot of a series, whose sequence is 0, is a complete minidump.  Each
+ * later one, a delta, holds only a thread list, with every thread's
+ * context, an exception stream, and in its memory list, the parts of the
+ * threads' stacks and of the other memory regions captured whose contents
+ * differ from the first snapshot's, a page at a time.  The regions that
+ * follow list all of the memory the delta captured, with an rva of 0; the
+ * stacks in its thread list have an rva of 0 too.  Their contents are
+ * those of the delta's memory list where it has them, and the first
+ * snapshot's elsewhere.  Every other stream is the first snapshot's.  A
+ * delta put back together with the first snapshot keeps its sequence but
+ * has no regions. */
+
+typedef struct {
+  MDGUID   series_id;     /* The same for every snapshot of a series. */
+  uint32_t sequence;      /* 0 for the first snapshot, then 1, 2, ... */
+  uint32_t region_count;  /* The number of regions, 0 for a complete
+                           * minidump. */
+  MDMemoryDescriptor regions[1];
+} MDRawSnapshotSeries;
+
+static const size_t MDRawSnapshotSeries_minsize =
+    offsetof(MDRawSnapshotSeries, regions[0]);
+
+/* For (MDRawDumpPhaseTiming).phase: */
+typedef enum {
+  /* The whole dump, up to the writing of the timing stream.  count is
+   * the number of other streams written, or zero if the client does not
+   * know it. */
+  MD_DUMP_PHASE_TOTAL               = 0,
+  /* Stopping the threads of the process.  count is the number of
+   * threads. */
+  MD_DUMP_PHASE_THREAD_SUSPEND      = 1,
+  /* Listing the threads and the mapped modules or regions of the process.
+   * count is the number of mappings. */
+  MD_DUMP_PHASE_MAPPING_ENUMERATION = 2,
+  /* Reading build IDs or other module identifiers.  count is the number
+   * of modules identified. */
+  MD_DUMP_PHASE_BUILD_ID_READ       = 3,
+  /* Copying thread stacks.  count is the number of stacks and bytes their
+   * total size. */
+  MD_DUMP_PHASE_STACK_COPY          = 4,
+  /* Copying extra memory and writing the memory list.  count is the
+   * number of memory descriptors and bytes the memory copied for them,
+   * other than stacks. */
+  MD_DUMP_PHASE_MEMORY_LIST         = 5,
+  /* Writing buffered data out to the file.  bytes is the size of the
+   * minidump at that point. */
+  MD_DUMP_PHASE_WRITE_FLUSH         = 6,
+  MD_DUMP_PHASE_COUNT
+} MDDumpPhase;
+
 /* These structs are used to store the DSO debug data in Linux minidumps,
  * which is necessary for converting minidumps to usable coredumps.
  * Because of a historical accident, several fields are variably encoded
@@ -98,6 +98,12 @@ class minidump_size<MDRawMemoryList> {
   static size_t size() { return MDRawMemoryList_minsize; }
 };
 
+template<>
+class minidump_size<MDRawSnapshotSeries> {
+ public:
+  static size_t size() { return MDRawSnapshotSeries_minsize; }
+};
+
 // Explicit specialization for MDRawModule, for which sizeof may include
 // tail-padding on some architectures but not others.
 
@@ -31,6 +31,10 @@
 // SourceLineResolverInterface, using address map files produced by a
 // compatible writer, e.g. PDBSourceLineWriter.
 //
+// Symbol files indexed with "sym_to_fast -i" can be loaded with
+// LoadModuleUsingIndexedFile, which parses each function and CFI block
+// only once it is looked up.
+//
 // see "processor/source_line_resolver_base.h"
 // and "source_line_resolver_interface.h" for more documentation.
 
@@ -56,13 +60,39 @@ class BasicSourceLineResolver : public SourceLineResolverBase {
   using SourceLineResolverBase::LoadModule;
   using SourceLineResolverBase::LoadModuleUsingMapBuffer;
   using SourceLineResolverBase::LoadModuleUsingMemoryBuffer;
-  using SourceLineResolverBase::ShouldDeleteMemoryBufferAfterLoadModule;
+  using SourceLineResolverBase::LoadModuleUsingSymbolBuffer;
+  using SourceLineResolverBase::LoadModuleUsingIndexedFile;
+  using SourceLineResolverBase::LoadModuleUnwindInfoUsingMemoryBuffer;
+  using SourceLineResolverBase::LoadModuleSymbolsUsingMemoryBuffer;
   using SourceLineResolverBase::UnloadModule;
   using SourceLineResolverBase::HasModule;
+  using SourceLineResolverBase::HasModuleSymbols;
   using SourceLineResolverBase::IsModuleCorrupt;
   using SourceLineResolverBase::FillSourceLineInfo;
   using SourceLineResolverBase::FindWindowsFrameInfo;
   using SourceLineResolverBase::FindCFIFrameInfo;
+  using SourceLineResolverBase::PrewarmModule;
+  using SourceLineResolverBase::SymbolizeAddresses;
+
+  // Sets the number of threads each symbol file loaded from now on may be
+  // parsed on.  Large symbol files are split at record boundaries and the
+  // chunks parsed concurrently; the resulting module and the parse errors
+  // logged are the same as when parsing on the loading thread, which is
+  // the default.  Not safe to call while modules are being loaded.
+  void set_parse_concurrency(int parse_concurrency);
+
+  // Sets whether the symbol data of modules loaded from now on is kept
+  // for as long as the module, so that function, public symbol, inline
+  // origin and file names can point into it instead of being copied.
+  // This saves an allocation per name, at the cost of keeping the records
+  // the resolver does not use in memory.  Symbol data passed in by the
+  // caller then has to stay alive as long as the module: see
+  // ShouldDeleteMemoryBufferAfterLoadModule().  Off by default.  Not safe
+  // to call while modules are being loaded.
+  void set_retain_symbol_data(bool retain_symbol_data);
+
+  // Returns false once set_retain_symbol_data() has been turned on.
+  virtual bool ShouldDeleteMemoryBufferAfterLoadModule();
 
  private:
   // friend declarations:
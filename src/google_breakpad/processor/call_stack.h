@@ -44,6 +44,8 @@
 #ifndef GOOGLE_BREAKPAD_PROCESSOR_CALL_STACK_H__
 #define GOOGLE_BREAKPAD_PROCESSOR_CALL_STACK_H__
 
+#include <stddef.h>
+
 #include <cstdint>
 #include <vector>
 
@@ -52,16 +54,25 @@ namespace google_breakpad {
 using std::vector;
 
 struct StackFrame;
+class StackFrameAllocator;
+class StackFrameArena;
 template<typename T> class linked_ptr;
 
 class CallStack {
  public:
-  CallStack() { Clear(); }
+  CallStack() : arena_(NULL) { Clear(); }
   ~CallStack();
 
-  // Resets the CallStack to its initial empty state
+  // Resets the CallStack to its initial empty state.  A frame arena, if
+  // enabled, is kept for reuse.
   void Clear();
 
+  // Allocates the frames that Stackwalker adds to this CallStack from an
+  // arena owned by the CallStack, instead of one by one from the heap.  The
+  // arena's memory is released in a few large blocks by Clear and the
+  // destructor.  Frames must not outlive the CallStack.
+  void EnableFrameArena();
+
   const vector<StackFrame*>* frames() const { return &frames_; }
 
   // Set the TID associated with this call stack.
@@ -69,16 +80,50 @@ class CallStack {
 
   uint32_t tid() const { return tid_; }
 
+  // True if the walk of this stack stopped at its time limit, so that
+  // frames may be missing from the outer end of the stack.
+  bool truncated() const { return truncated_; }
+  void set_truncated(bool truncated) { truncated_ = truncated; }
+
+  // True if the walk of this stack stopped after a frame in a function
+  // listed by Stackwalker::set_terminal_frames, the outermost frame.
+  bool ended_at_terminal_frame() const { return ended_at_terminal_frame_; }
+  void set_ended_at_terminal_frame(bool ended_at_terminal_frame) {
+    ended_at_terminal_frame_ = ended_at_terminal_frame;
+  }
+
  private:
   // Stackwalker is responsible for building the frames_ vector.
+  // MinidumpProcessor copies it between threads with identical stacks.
   friend class Stackwalker;
+  friend class MinidumpProcessor;
+
+  // While a FrameAllocationScope is alive, StackFrame objects created on
+  // the constructing thread are allocated from the arena of the given
+  // CallStack, or from the heap if it has none.
+  class FrameAllocationScope {
+   public:
+    explicit FrameAllocationScope(CallStack* stack);
+    ~FrameAllocationScope();
+
+   private:
+    StackFrameAllocator* previous_allocator_;
+  };
 
   // Storage for pushed frames.
   vector<StackFrame*> frames_;
 
+  // The arena that frames_ are allocated from, or NULL to allocate them
+  // from the heap.  Owned.
+  StackFrameArena* arena_;
+
   // The TID associated with this call stack. Default to 0 if it's not
   // available.
   uint32_t tid_;
+
+  bool truncated_;
+
+  bool ended_at_terminal_frame_;
 };
 
 }  // namespace google_breakpad
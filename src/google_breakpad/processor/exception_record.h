@@ -61,6 +61,20 @@ class ExceptionParameter {
 // flags, address, parameters.
 class ExceptionRecord {
  public:
+  ExceptionRecord() { Clear(); }
+
+  // Resets the record to its initial empty state.  The parameters vector
+  // keeps its capacity.
+  void Clear() {
+    code_ = 0;
+    code_description_.clear();
+    flags_ = 0;
+    flags_description_.clear();
+    nested_exception_record_address_ = 0;
+    address_ = 0;
+    parameters_.clear();
+  }
+
   // Accessors. See the data declarations below.
   uint32_t code() const { return code_; }
   const string& code_description() const { return code_description_; }
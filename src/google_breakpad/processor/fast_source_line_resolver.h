@@ -34,7 +34,9 @@
 // difference is FastSourceLineResolver loads a serialized memory chunk of data
 // which can be used directly a Module without parsing or copying of underlying
 // data.  Therefore loading a symbol in FastSourceLineResolver is much faster
-// and more memory-efficient than BasicSourceLineResolver.
+// and more memory-efficient than BasicSourceLineResolver.  Serialized modules
+// saved to disk can be loaded with LoadModuleUsingMappedFile, which maps them
+// rather than reading them.
 //
 // See "source_line_resolver_base.h" and
 // "google_breakpad/source_line_resolver_interface.h" for more reference.
@@ -53,6 +55,12 @@ namespace google_breakpad {
 
 using std::map;
 
+// Extension of files holding a serialized module, appended to the name of
+// the symbol file they were converted from.  The version is bumped whenever
+// the serialization format changes, so that files written in an older
+// format are not picked up.
+static const char kSerializedBreakpadFileExtension[] = ".fast.v2";
+
 class FastSourceLineResolver : public SourceLineResolverBase {
  public:
   FastSourceLineResolver();
@@ -62,10 +70,17 @@ class FastSourceLineResolver : public SourceLineResolverBase {
   using SourceLineResolverBase::FindCFIFrameInfo;
   using SourceLineResolverBase::FindWindowsFrameInfo;
   using SourceLineResolverBase::HasModule;
+  using SourceLineResolverBase::HasModuleSymbols;
   using SourceLineResolverBase::IsModuleCorrupt;
   using SourceLineResolverBase::LoadModule;
+  using SourceLineResolverBase::LoadModuleSymbolsUsingMemoryBuffer;
+  using SourceLineResolverBase::LoadModuleUnwindInfoUsingMemoryBuffer;
   using SourceLineResolverBase::LoadModuleUsingMapBuffer;
   using SourceLineResolverBase::LoadModuleUsingMemoryBuffer;
+  using SourceLineResolverBase::LoadModuleUsingSymbolBuffer;
+  using SourceLineResolverBase::LoadModuleUsingMappedFile;
+  using SourceLineResolverBase::PrewarmModule;
+  using SourceLineResolverBase::SymbolizeAddresses;
   using SourceLineResolverBase::UnloadModule;
 
  private:
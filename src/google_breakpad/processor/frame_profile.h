@@ -0,0 +1,129 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// frame_profile.h: Counts of the instruction addresses stack walks
+// symbolize, by module, for warming up a resolver ahead of its first dumps.
+//
+// Across many dumps of the same software, a few thousand instructions make
+// up most frames.  A StackFrameSymbolizer given a FrameProfile with
+// set_frame_profile() counts each frame it symbolizes in it.  The profile
+// can be saved, merged with those of other processes, pruned to its
+// hottest addresses, and given to StackFrameSymbolizer::PrewarmFromProfile()
+// when a new process starts, which loads the modules it names and has the
+// resolver parse the functions and CFI covering its addresses.
+//
+// The text form holds one MODULE record per module, followed by its code
+// file and by its addresses, relative to the module's base address, with
+// their counts, all numbers in hexadecimal:
+//
+//   FRAMEPROFILE
+//   MODULE <debug identifier> <debug file>
+//   CODE <code file>
+//   <address> <count>
+
+#ifndef GOOGLE_BREAKPAD_PROCESSOR_FRAME_PROFILE_H__
+#define GOOGLE_BREAKPAD_PROCESSOR_FRAME_PROFILE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "common/using_std_string.h"
+
+namespace google_breakpad {
+
+class CodeModule;
+
+class FrameProfile {
+ public:
+  // Identifies a module by its code file, debug file and debug identifier,
+  // which are what a SymbolSupplier needs to find its symbols.
+  struct ModuleKey {
+    string code_file;
+    string debug_file;
+    string debug_identifier;
+
+    bool operator<(const ModuleKey& that) const {
+      if (code_file != that.code_file)
+        return code_file < that.code_file;
+      if (debug_file != that.debug_file)
+        return debug_file < that.debug_file;
+      return debug_identifier < that.debug_identifier;
+    }
+  };
+
+  // The number of times each module-relative address was recorded.
+  typedef std::map<uint64_t, uint64_t> AddressCounts;
+  typedef std::map<ModuleKey, AddressCounts> ModuleCounts;
+
+  FrameProfile() {}
+  FrameProfile(const FrameProfile&) = delete;
+  void operator=(const FrameProfile&) = delete;
+
+  // Counts the instruction at address in module.  Modules without a debug
+  // file or identifier have no symbols to warm up, and are not counted.
+  // Safe to call from several threads at once.
+  void Record(const CodeModule* module, uint64_t address);
+
+  // Adds the counts in that to this profile's.
+  void Merge(const FrameProfile& that);
+
+  // Keeps only the max_addresses addresses with the highest counts, and
+  // the modules they are in.
+  void Prune(size_t max_addresses);
+
+  // Returns the profile in the text form described above.
+  string Serialize() const;
+
+  // Reads the text form of a profile, replacing this profile's counts.
+  // Returns false, leaving the profile empty, if profile_data is not a
+  // well-formed profile.
+  bool Parse(const string& profile_data);
+
+  // Reads and parses the profile in profile_file, or writes this profile
+  // to it.
+  bool ReadFile(const string& profile_file);
+  bool WriteFile(const string& profile_file) const;
+
+  // The counts, by module.  Not safe to call while Record() may be.
+  const ModuleCounts& modules() const { return modules_; }
+
+  // Returns the number of distinct addresses recorded.
+  size_t AddressCount() const;
+
+ private:
+  ModuleCounts modules_;
+  mutable std::mutex lock_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // GOOGLE_BREAKPAD_PROCESSOR_FRAME_PROFILE_H__
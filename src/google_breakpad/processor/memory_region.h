@@ -37,6 +37,8 @@
 #ifndef GOOGLE_BREAKPAD_PROCESSOR_MEMORY_REGION_H__
 #define GOOGLE_BREAKPAD_PROCESSOR_MEMORY_REGION_H__
 
+#include <stddef.h>
+#include <string.h>
 
 #include "google_breakpad/common/breakpad_types.h"
 
@@ -67,8 +69,130 @@ class MemoryRegion {
   virtual bool GetMemoryAtAddress(uint64_t address, uint32_t* value) const = 0;
   virtual bool GetMemoryAtAddress(uint64_t address, uint64_t* value) const = 0;
 
+  // Access to count consecutive values beginning at address, which are
+  // stored in values as GetMemoryAtAddress would store them one at a time.
+  // The values are copied with CopyOut and byte-swapped together, so the
+  // bounds are checked once for the whole range.  Fails and returns false
+  // if any of the values is out of the region's bounds.
+  bool GetMemoryRangeAtAddress(uint64_t address, size_t count,
+                               uint32_t* values) const {
+    return GetMemoryRangeAtAddressInternal(address, count, values);
+  }
+  bool GetMemoryRangeAtAddress(uint64_t address, size_t count,
+                               uint64_t* values) const {
+    return GetMemoryRangeAtAddressInternal(address, count, values);
+  }
+
+  // Returns a pointer to the size bytes beginning at address, or NULL if
+  // size is zero, if they are not all within the region, or if the region
+  // does not hold them contiguously.  The bytes are as stored in the
+  // region's source, so multi-byte values in them must be byte-swapped if
+  // ByteSwapped returns true.  The pointer remains valid for as long as the
+  // region's memory does.
+  const uint8_t* GetSpan(uint64_t address, size_t size) const {
+    uint64_t offset;
+    if (size == 0 || !GetOffset(address, size, &offset))
+      return NULL;
+    return GetSpanAtOffset(offset, size);
+  }
+
+  // Copies the size bytes beginning at address to bytes, as GetSpan would
+  // return them, whether or not the region holds them contiguously.
+  // Returns false if they are not all within the region, or for other
+  // types of errors.
+  bool CopyOut(uint64_t address, size_t size, uint8_t* bytes) const {
+    uint64_t offset;
+    if (!GetOffset(address, size, &offset))
+      return false;
+    return size == 0 || CopyOutAtOffset(offset, size, bytes);
+  }
+
+  // Returns true if values are stored in the region's source in the
+  // opposite byte order to the running program's.
+  virtual bool ByteSwapped() const { return false; }
+
   // Print a human-readable representation of the object to stdout.
   virtual void Print() const = 0;
+
+ protected:
+  // Returns a pointer to the size bytes at offset within the region, for
+  // GetSpan, or NULL if they are not held contiguously.  offset and size
+  // are within the region's bounds, and size is not zero.
+  virtual const uint8_t* GetSpanAtOffset(uint64_t offset, size_t size) const {
+    return NULL;
+  }
+
+  // Copies the size bytes at offset within the region to bytes, for
+  // CopyOut.  offset and size are within the region's bounds, and size is
+  // not zero.  The default copies the span at offset if there is one, and
+  // otherwise reads one byte at a time.
+  virtual bool CopyOutAtOffset(uint64_t offset, size_t size,
+                               uint8_t* bytes) const {
+    const uint8_t* span = GetSpanAtOffset(offset, size);
+    if (span) {
+      memcpy(bytes, span, size);
+      return true;
+    }
+    uint64_t address = GetBase() + offset;
+    for (size_t i = 0; i < size; ++i) {
+      if (!GetMemoryAtAddress(address + i, &bytes[i]))
+        return false;
+    }
+    return true;
+  }
+
+  // Returns true if the running program is little-endian, for regions
+  // whose source is always little-endian.
+  static bool HostIsLittleEndian() {
+    const uint16_t probe = 1;
+    return *reinterpret_cast<const uint8_t*>(&probe) == 1;
+  }
+
+ private:
+  // Sets offset to the offset of address within the region, and returns
+  // true, if the size bytes beginning at address lie within the region.
+  bool GetOffset(uint64_t address, size_t size, uint64_t* offset) const {
+    uint64_t base = GetBase();
+    uint64_t region_size = GetSize();
+    if (address < base || address - base > region_size ||
+        size > region_size - (address - base)) {
+      return false;
+    }
+    *offset = address - base;
+    return true;
+  }
+
+  template<typename T>
+  bool GetMemoryRangeAtAddressInternal(uint64_t address, size_t count,
+                                       T* values) const {
+    if (count > SIZE_MAX / sizeof(T) ||
+        !CopyOut(address, count * sizeof(T),
+                 reinterpret_cast<uint8_t*>(values))) {
+      return false;
+    }
+    if (ByteSwapped())
+      SwapValues(values, count);
+    return true;
+  }
+
+  // Byte-swap arrays of values.  The loops are simple enough for compilers
+  // to vectorize.
+  static uint32_t Swap32(uint32_t v) {
+    return (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) |
+           (v << 24);
+  }
+  static void SwapValues(uint32_t* values, size_t count) {
+    for (size_t i = 0; i < count; ++i)
+      values[i] = Swap32(values[i]);
+  }
+  static void SwapValues(uint64_t* values, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+      uint64_t v = values[i];
+      values[i] = static_cast<uint64_t>(Swap32(static_cast<uint32_t>(v)))
+                      << 32 |
+                  Swap32(static_cast<uint32_t>(v >> 32));
+    }
+  }
 };
 
 
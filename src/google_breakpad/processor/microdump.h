@@ -39,6 +39,7 @@
 #define GOOGLE_BREAKPAD_PROCESSOR_MICRODUMP_H__
 
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "common/scoped_ptr.h"
@@ -84,6 +85,8 @@ class MicrodumpMemoryRegion : public MemoryRegion {
   // instance of this class in a test fixture class, individual tests
   // can use this to provide the region's contents.
   void Init(uint64_t base_address, const std::vector<uint8_t>& contents);
+  // As above, but takes |contents| over without copying it.
+  void Init(uint64_t base_address, std::vector<uint8_t>&& contents);
 
   virtual uint64_t GetBase() const;
   virtual uint32_t GetSize() const;
@@ -93,9 +96,15 @@ class MicrodumpMemoryRegion : public MemoryRegion {
   virtual bool GetMemoryAtAddress(uint64_t address, uint32_t* value) const;
   virtual bool GetMemoryAtAddress(uint64_t address, uint64_t* value) const;
 
+  // Microdump memory is little-endian.
+  virtual bool ByteSwapped() const;
+
   // Print a human-readable representation of the object to stdout.
   virtual void Print() const;
 
+ protected:
+  virtual const uint8_t* GetSpanAtOffset(uint64_t offset, size_t size) const;
+
  private:
   // Fetch a little-endian value from ADDRESS in contents_ whose size
   // is BYTES, and store it in *VALUE.  Returns true on success.
@@ -111,6 +120,12 @@ class MicrodumpMemoryRegion : public MemoryRegion {
 class Microdump {
  public:
   explicit Microdump(const string& contents);
+  // Parses the first microdump in |contents| in place, without copying the
+  // text. If |consumed| is not NULL, it receives the offset just past the
+  // microdump's end marker (or contents.size() if there is none), so that a
+  // buffer holding several concatenated microdumps can be walked by
+  // constructing one Microdump per dump.
+  Microdump(std::string_view contents, size_t* consumed);
   virtual ~Microdump() {}
 
   DumpContext* GetContext() { return context_.get(); }
@@ -33,6 +33,7 @@
 #define GOOGLE_BREAKPAD_PROCESSOR_MICRODUMP_PROCESSOR_H__
 
 #include <string>
+#include <vector>
 
 #include "common/using_std_string.h"
 #include "google_breakpad/processor/process_result.h"
@@ -54,6 +55,22 @@ class MicrodumpProcessor {
   // Processes the microdump contents and fills process_state with the result.
   google_breakpad::ProcessResult Process(Microdump* microdump,
                                          ProcessState* process_state);
+
+  // Processes each of microdumps, filling the ProcessState at the same
+  // index of process_states, on up to concurrency worker threads sharing the
+  // stack frame symbolizer.  Before any microdump is walked, the symbols of
+  // the modules holding the batch's crash instruction pointers are fetched
+  // and loaded once per module version, on the same workers; other modules
+  // are loaded as the walks reach them.  Returns the result of each
+  // microdump, in input order.
+  //
+  // The resolver knows modules by code file alone, so the microdumps of a
+  // batch should come from the same version of each module.
+  std::vector<google_breakpad::ProcessResult> ProcessBatch(
+      const std::vector<Microdump*>& microdumps,
+      const std::vector<ProcessState*>& process_states,
+      int concurrency);
+
  private:
   StackFrameSymbolizer* frame_symbolizer_;
 };
@@ -84,9 +84,13 @@
 #include <unistd.h>
 #endif
 
+#include <atomic>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "common/using_std_string.h"
@@ -105,6 +109,7 @@ using std::map;
 using std::vector;
 
 
+class MemoryMappedFile;
 class Minidump;
 template<typename AddressType, typename EntryType> class RangeMap;
 
@@ -214,7 +219,9 @@ class MinidumpMemoryRegion : public MinidumpObject,
 
   // Returns a pointer to the base of the memory region.  Returns the
   // cached value if available, otherwise, reads the minidump file and
-  // caches the memory region.
+  // caches the memory region.  If the minidump is backed by memory, the
+  // returned pointer refers directly into that memory and nothing is
+  // copied.
   const uint8_t* GetMemory() const;
 
   // The address of the base of the memory region.
@@ -231,6 +238,7 @@ class MinidumpMemoryRegion : public MinidumpObject,
   bool GetMemoryAtAddress(uint64_t address, uint16_t* value) const override;
   bool GetMemoryAtAddress(uint64_t address, uint32_t* value) const override;
   bool GetMemoryAtAddress(uint64_t address, uint64_t* value) const override;
+  bool ByteSwapped() const override;
 
   // Print a human-readable representation of the object to stdout.
   void Print() const override;
@@ -239,6 +247,10 @@ class MinidumpMemoryRegion : public MinidumpObject,
  protected:
   explicit MinidumpMemoryRegion(Minidump* minidump);
 
+  // The region's memory is read as a whole, so any span within it is
+  // contiguous.
+  const uint8_t* GetSpanAtOffset(uint64_t offset, size_t size) const override;
+
  private:
   friend class MinidumpThread;
   friend class MinidumpMemoryList;
@@ -264,6 +276,89 @@ class MinidumpMemoryRegion : public MinidumpObject,
 
   // Cached memory.
   mutable vector<uint8_t>* memory_;
+
+  // Memory in the minidump's backing store, used instead of memory_ when
+  // the minidump is backed by memory.
+  mutable const uint8_t* mapped_memory_;
+};
+
+
+// MinidumpMemory64Region is a region of memory described by a
+// MinidumpMemory64List.  Full-memory dumps can carry gigabytes of memory,
+// so unlike MinidumpMemoryRegion, the region's contents are never read as
+// a whole.  When the minidump is backed by memory, reads go straight to
+// the backing store; otherwise, memory is read and cached one page at a
+// time as it is accessed.
+class MinidumpMemory64Region : public MinidumpObject,
+                               public MemoryRegion {
+ public:
+  ~MinidumpMemory64Region() override;
+
+  // The address of the base of the memory region.
+  uint64_t GetBase() const override;
+
+  // The size, in bytes, of the memory region.
+  uint32_t GetSize() const override;
+
+  // The position of the region's memory in the minidump file.
+  MDRVA64 GetRVA() const;
+
+  // Frees any cached pages of the memory region.
+  void FreeMemory();
+
+  // Obtains the value of memory at the pointer specified by address.
+  bool GetMemoryAtAddress(uint64_t address, uint8_t* value) const override;
+  bool GetMemoryAtAddress(uint64_t address, uint16_t* value) const override;
+  bool GetMemoryAtAddress(uint64_t address, uint32_t* value) const override;
+  bool GetMemoryAtAddress(uint64_t address, uint64_t* value) const override;
+  bool ByteSwapped() const override;
+
+  // Print a human-readable representation of the object to stdout.  Only
+  // the location of the region is printed, not its contents.
+  void Print() const override;
+
+ protected:
+  explicit MinidumpMemory64Region(Minidump* minidump);
+
+  // Spans are contiguous when the minidump is backed by memory, or when
+  // they lie within one cached page.
+  const uint8_t* GetSpanAtOffset(uint64_t offset, size_t size) const override;
+  bool CopyOutAtOffset(uint64_t offset, size_t size,
+                       uint8_t* bytes) const override;
+
+ private:
+  friend class MinidumpMemory64List;
+
+  // The size of the pages in which memory is read and cached.
+  static const uint32_t kPageSize = 4096;
+
+  // Identify the base address and size of the memory region, and the
+  // location it may be found in the minidump file.
+  void SetRange(uint64_t base, uint32_t size, MDRVA64 rva);
+
+  // Copies size bytes at offset within the region to bytes, reading and
+  // caching the pages involved if necessary.  The range must lie within
+  // the region.
+  bool CopyBytes(uint64_t offset, size_t size, uint8_t* bytes) const;
+
+  // Returns the cached page at page_index within the region, reading it
+  // from the minidump file first if necessary.
+  const uint8_t* GetPage(uint64_t page_index) const;
+
+  // Implementation for GetMemoryAtAddress
+  template<typename T> bool GetMemoryAtAddressInternal(uint64_t address,
+                                                       T*        value) const;
+
+  uint64_t base_;
+  uint32_t size_;
+  MDRVA64 rva_;
+
+  // Serializes page reads and the page cache, which may be used by several
+  // stack walkers at once.  Owned by the MinidumpMemory64List.
+  std::mutex* page_lock_;
+
+  // Cached pages, keyed by their index within the region.
+  mutable map<uint64_t, vector<uint8_t> > pages_;
 };
 
 
@@ -499,15 +594,17 @@ class MinidumpModule : public MinidumpObject,
   // the various types.  Current toolchains generate modules which carry
   // MDCVInfoPDB70 by default.  Returns a pointer to the CodeView record on
   // success, and NULL on failure.  On success, the optional |size| argument
-  // is set to the size of the CodeView record.
-  const uint8_t* GetCVRecord(uint32_t* size);
+  // is set to the size of the CodeView record.  The record is read from the
+  // minidump the first time it is needed.
+  const uint8_t* GetCVRecord(uint32_t* size) const;
 
   // The miscellaneous debug record, which is obsolete.  Current toolchains
   // do not generate this type of debugging information (dbg), and this
   // field is not expected to be present.  Returns a pointer to the debugging
   // record on success, and NULL on failure.  On success, the optional |size|
-  // argument is set to the size of the debugging record.
-  const MDImageDebugMisc* GetMiscRecord(uint32_t* size);
+  // argument is set to the size of the debugging record.  Like the CodeView
+  // record, it is read the first time it is needed.
+  const MDImageDebugMisc* GetMiscRecord(uint32_t* size) const;
 
   // Print a human-readable representation of the object to stdout.
   void Print();
@@ -519,18 +616,23 @@ class MinidumpModule : public MinidumpObject,
   explicit MinidumpModule(Minidump* minidump);
 
   // This works like MinidumpStream::Read, but is driven by
-  // MinidumpModuleList.  No size checking is done, because
-  // MinidumpModuleList handles that directly.
-  bool Read();
-
-  // Reads indirectly-referenced data, including the module name, CodeView
-  // record, and miscellaneous debugging record.  This is necessary to allow
-  // MinidumpModuleList to fully construct MinidumpModule objects without
-  // requiring seeks to read a contiguous set of MinidumpModule objects.
-  // All auxiliary data should be available when Read is called, in order to
-  // allow the CodeModule getters to be const methods.
+  // MinidumpModuleList, which reads the raw module records for the whole
+  // list at once and passes each one's MD_MODULE_SIZE bytes as raw.  No size
+  // checking is done, because MinidumpModuleList handles that directly.
+  bool Read(const uint8_t* raw);
+
+  // Reads indirectly-referenced data that decides whether the module is
+  // valid, which is its name.  This is necessary to allow MinidumpModuleList
+  // to fully construct MinidumpModule objects without requiring seeks to
+  // read a contiguous set of MinidumpModule objects.  The CodeView and
+  // miscellaneous debugging records are left until ReadDebugInfo.
   bool ReadAuxiliaryData();
 
+  // Reads the CodeView and miscellaneous debugging records the first time
+  // the module's debug info is needed, and returns has_debug_info_.  Callers
+  // that only need a module's address range and name don't pay for them.
+  bool ReadDebugInfo() const;
+
   // The largest number of bytes that will be read from a minidump for a
   // CodeView record or miscellaneous debugging record, respectively.  The
   // default for each is 1024.
@@ -544,10 +646,13 @@ class MinidumpModule : public MinidumpObject,
   // be read.
   bool              module_valid_;
 
+  // True once ReadDebugInfo has run.
+  mutable bool      debug_info_read_;
+
   // True if debug info was read from the module.  Certain modules
   // may contain debug records in formats we don't support,
   // so we can just set this to false to ignore them.
-  bool              has_debug_info_;
+  mutable bool      has_debug_info_;
 
   MDRawModule       module_;
 
@@ -558,17 +663,17 @@ class MinidumpModule : public MinidumpObject,
   // MDCVInfoPDB70, or possibly something else entirely.  Stored as a uint8_t
   // because the structure contains a variable-sized string and its exact
   // size cannot be known until it is processed.
-  vector<uint8_t>* cv_record_;
+  mutable vector<uint8_t>* cv_record_;
 
   // If cv_record_ is present, cv_record_signature_ contains a copy of the
   // CodeView record's first four bytes, for ease of determinining the
   // type of structure that cv_record_ contains.
-  uint32_t cv_record_signature_;
+  mutable uint32_t cv_record_signature_;
 
   // Cached MDImageDebugMisc (usually not present), stored as uint8_t
   // because the structure contains a variable-sized string and its exact
   // size cannot be known until it is processed.
-  vector<uint8_t>* misc_record_;
+  mutable vector<uint8_t>* misc_record_;
 };
 
 
@@ -599,6 +704,12 @@ class MinidumpModuleList : public MinidumpStream,
   const MinidumpModule* GetModuleAtIndex(unsigned int index) const override;
   const CodeModules* Copy() const override;
 
+  // Returns a copy of the list, like Copy, that is made the first time it
+  // is requested and shared by every later caller.  The copy is immutable
+  // and outlives this list, so ProcessStates made from the same minidump
+  // can all hold it instead of each making their own.
+  std::shared_ptr<const CodeModules> GetSharedCopy() const;
+
   // Returns a vector of all modules which address ranges needed to be shrunk
   // down due to address range conflicts with other modules.
   vector<linked_ptr<const CodeModule>> GetShrunkRangeModules() const override;
@@ -633,6 +744,9 @@ class MinidumpModuleList : public MinidumpStream,
 
   MinidumpModules* modules_;
   uint32_t module_count_;
+
+  // The copy returned by GetSharedCopy, once it has been made.
+  mutable std::shared_ptr<const CodeModules> shared_copy_;
 };
 
 
@@ -662,7 +776,8 @@ class MinidumpMemoryList : public MinidumpStream {
   MinidumpMemoryRegion* GetMemoryRegionAtIndex(unsigned int index);
 
   // Random access to memory regions.  Returns the region encompassing
-  // the address identified by address.
+  // the address identified by address.  Consecutive lookups usually fall
+  // in the same region, so the region found last is checked first.
   virtual MinidumpMemoryRegion* GetMemoryRegionForAddress(uint64_t address);
 
   // Print a human-readable representation of the object to stdout.
@@ -685,9 +800,14 @@ class MinidumpMemoryList : public MinidumpStream {
   // The default is 256.
   static uint32_t max_regions_;
 
-  // Access to memory regions using addresses as the key.
+  // Access to memory regions using addresses as the key.  Frozen into a
+  // sorted array once the list is read.
   RangeMap<uint64_t, unsigned int>* range_map_;
 
+  // The index of the region GetMemoryRegionForAddress found last.  Atomic
+  // because several stack walkers may look up regions at once.
+  mutable std::atomic<unsigned int> last_region_index_;
+
   // The list of descriptors.  This is maintained separately from the list
   // of regions, because MemoryRegion doesn't own its MemoryDescriptor, it
   // maintains a pointer to it.  descriptors_ provides the storage for this
@@ -700,6 +820,69 @@ class MinidumpMemoryList : public MinidumpStream {
 };
 
 
+// MinidumpMemory64List contains the memory regions of a full-memory dump,
+// as carried by MD_MEMORY_64_LIST_STREAM.  Reading the list only indexes
+// its descriptor table; the regions' contents are only read when they are
+// accessed through MinidumpMemory64Region.  Regions larger than 4GB are
+// exposed as several consecutive regions, because MemoryRegion sizes are
+// 32 bits wide.
+class MinidumpMemory64List : public MinidumpStream {
+ public:
+  MinidumpMemory64List(const MinidumpMemory64List&) = delete;
+  void operator=(const MinidumpMemory64List&) = delete;
+  ~MinidumpMemory64List() override;
+
+  static void set_max_regions(uint32_t max_regions) {
+    max_regions_ = max_regions;
+  }
+  static uint32_t max_regions() { return max_regions_; }
+
+  unsigned int region_count() const {
+    return valid_ ? static_cast<unsigned int>(regions_.size()) : 0;
+  }
+
+  // Sequential access to memory regions.
+  MinidumpMemory64Region* GetMemoryRegionAtIndex(unsigned int index);
+
+  // Random access to memory regions.  Returns the region encompassing
+  // the address identified by address, checking the region found last
+  // first.
+  virtual MinidumpMemory64Region* GetMemoryRegionForAddress(uint64_t address);
+
+  // Print a human-readable representation of the object to stdout.
+  void Print();
+
+ private:
+  friend class Minidump;
+
+  typedef vector<MinidumpMemory64Region> MemoryRegions;
+
+  static const uint32_t kStreamType = MD_MEMORY_64_LIST_STREAM;
+
+  explicit MinidumpMemory64List(Minidump* minidump);
+
+  bool Read(uint32_t expected_size) override;
+
+  // The largest number of memory regions that will be read from a minidump.
+  // The default is 1048576.
+  static uint32_t max_regions_;
+
+  // Access to memory regions using addresses as the key.  Frozen into a
+  // sorted array once the list is read.
+  RangeMap<uint64_t, unsigned int>* range_map_;
+
+  // The index of the region GetMemoryRegionForAddress found last.
+  mutable std::atomic<unsigned int> last_region_index_;
+
+  // The list of regions.
+  MemoryRegions regions_;
+
+  // Shared by all regions in the list, because they all read from the
+  // same minidump file.
+  std::mutex page_lock_;
+};
+
+
 // MinidumpException wraps MDRawExceptionStream, which contains information
 // about the exception that caused the minidump to be generated, if the
 // minidump was generated in an exception handler called as a result of an
@@ -925,6 +1108,9 @@ class MinidumpUnloadedModuleList : public MinidumpStream,
   const CodeModules* Copy() const override;
   vector<linked_ptr<const CodeModule>> GetShrunkRangeModules() const override;
 
+  // See MinidumpModuleList::GetSharedCopy.
+  std::shared_ptr<const CodeModules> GetSharedCopy() const;
+
  protected:
   explicit MinidumpUnloadedModuleList(Minidump* minidump_);
 
@@ -946,6 +1132,9 @@ class MinidumpUnloadedModuleList : public MinidumpStream,
 
   MinidumpUnloadedModules* unloaded_modules_;
   uint32_t module_count_;
+
+  // The copy returned by GetSharedCopy, once it has been made.
+  mutable std::shared_ptr<const CodeModules> shared_copy_;
 };
 
 
@@ -1086,8 +1275,9 @@ class MinidumpMemoryInfoList : public MinidumpStream {
 
   bool Read(uint32_t expected_size) override;
 
-  // Access to memory info using addresses as the key.
-  RangeMap<uint64_t, unsigned int>* range_map_;
+  // The highest address of each memory info paired with its index in
+  // infos_, sorted by highest address, for GetMemoryInfoForAddress.
+  vector<std::pair<uint64_t, unsigned int>> address_index_;
 
   MinidumpMemoryInfos* infos_;
   uint32_t info_count_;
@@ -1131,7 +1321,10 @@ class MinidumpLinuxMaps : public MinidumpObject {
   uint64_t GetInode() const { return valid_ ? region_.inode : 0; }
 
   // The pathname of the mapped region.
-  const string GetPathname() const { return valid_ ? region_.path : ""; }
+  const string& GetPathname() const {
+    static const string kEmptyPathname;
+    return valid_ ? region_.path : kEmptyPathname;
+  }
 
   // Print the contents of this mapping.
   void Print() const;
@@ -1186,6 +1379,12 @@ class MinidumpLinuxMapsList : public MinidumpStream {
   MinidumpLinuxMappings* maps_;
   // The number of mappings.
   uint32_t maps_count_;
+  // The highest address of each non-empty mapping paired with its index in
+  // maps_, sorted by highest address, for GetLinuxMapsForAddress.
+  vector<std::pair<uint64_t, unsigned int>> address_index_;
+  // Whether any mappings overlap, in which case address_index_ can't be
+  // used and GetLinuxMapsForAddress searches maps_ in order.
+  bool overlapping_maps_;
 };
 
 // MinidumpCrashpadInfo wraps MDRawCrashpadInfo, which is an optional stream in
@@ -1208,6 +1407,11 @@ class MinidumpCrashpadInfo : public MinidumpStream {
     return valid_ ? &module_crashpad_info_annotation_objects_ : nullptr;
   }
 
+  // The process-wide simple annotations, such as crash keys.
+  const std::map<std::string, std::string>* GetSimpleAnnotations() const {
+    return valid_ ? &simple_annotations_ : nullptr;
+  }
+
   // Print a human-readable representation of the object to stdout.
   void Print();
 
@@ -1233,6 +1437,90 @@ class MinidumpCrashpadInfo : public MinidumpStream {
 };
 
 
+// MinidumpDumpTiming wraps MDRawDumpTimingList, an optional stream in which
+// the client that wrote the minidump recorded how long each phase of
+// writing it took.
+class MinidumpDumpTiming : public MinidumpStream {
+ public:
+  MinidumpDumpTiming(const MinidumpDumpTiming&) = delete;
+  void operator=(const MinidumpDumpTiming&) = delete;
+
+  // The phases that the client recorded, in the order it wrote them.
+  const std::vector<MDRawDumpPhaseTiming>* phases() const {
+    return valid_ ? &phases_ : nullptr;
+  }
+
+  // Returns the name of an MDDumpPhase, such as "stack_copy", or
+  // "unknown".  Defined here so that printing the phases a ProcessState
+  // holds doesn't need the rest of the minidump reader.
+  static const char* PhaseName(uint32_t phase) {
+    switch (phase) {
+      case MD_DUMP_PHASE_TOTAL:
+        return "total";
+      case MD_DUMP_PHASE_THREAD_SUSPEND:
+        return "thread_suspend";
+      case MD_DUMP_PHASE_MAPPING_ENUMERATION:
+        return "mapping_enumeration";
+      case MD_DUMP_PHASE_BUILD_ID_READ:
+        return "build_id_read";
+      case MD_DUMP_PHASE_STACK_COPY:
+        return "stack_copy";
+      case MD_DUMP_PHASE_MEMORY_LIST:
+        return "memory_list";
+      case MD_DUMP_PHASE_WRITE_FLUSH:
+        return "write_flush";
+      default:
+        return "unknown";
+    }
+  }
+
+  // Print a human-readable representation of the object to stdout.
+  void Print();
+
+ private:
+  friend class Minidump;
+
+  static const uint32_t kStreamType = MD_DUMP_TIMING_STREAM;
+
+  explicit MinidumpDumpTiming(Minidump* minidump_);
+
+  bool Read(uint32_t expected_size) override;
+
+  std::vector<MDRawDumpPhaseTiming> phases_;
+};
+
+
+// MinidumpCrashSignature wraps MDRawCrashSignature, an optional stream in
+// which the client recorded a quick signature of where it crashed.
+class MinidumpCrashSignature : public MinidumpStream {
+ public:
+  MinidumpCrashSignature(const MinidumpCrashSignature&) = delete;
+  void operator=(const MinidumpCrashSignature&) = delete;
+
+  const MDRawCrashSignature* crash_signature() const {
+    return valid_ ? &crash_signature_ : nullptr;
+  }
+
+  // The signature as 16 hex digits, as clients send it with reports, or
+  // an empty string if the stream is invalid.
+  string SignatureString() const;
+
+  // Print a human-readable representation of the object to stdout.
+  void Print();
+
+ private:
+  friend class Minidump;
+
+  static const uint32_t kStreamType = MD_CRASH_SIGNATURE_STREAM;
+
+  explicit MinidumpCrashSignature(Minidump* minidump_);
+
+  bool Read(uint32_t expected_size) override;
+
+  MDRawCrashSignature crash_signature_;
+};
+
+
 // Minidump is the user's interface to a minidump file.  It wraps MDRawHeader
 // and provides access to the minidump's top-level stream directory.
 class Minidump {
@@ -1245,6 +1533,20 @@ class Minidump {
   // weak pointer to input, and the caller must ensure that the stream
   // is valid as long as the Minidump object is.
   explicit Minidump(std::istream& input);
+  // mapped_file holds the minidump data, mapped into memory.  Minidump
+  // holds a weak pointer to the mapped contents, and the caller must
+  // ensure that the mapping is valid as long as the Minidump object is.
+  // Memory regions read from a mapped minidump point into the mapping
+  // instead of being copied.  Only Linux has MemoryMappedFile; elsewhere,
+  // read the minidump from its path or a stream.
+#if defined(__linux__)
+  explicit Minidump(const MemoryMappedFile& mapped_file);
+#endif  // __linux__
+  // data holds size bytes of minidump data, such as a minidump received
+  // over the network.  As for a mapped file, Minidump holds a weak pointer
+  // to data, which must remain valid as long as the Minidump object is,
+  // and memory regions point into data.
+  Minidump(const uint8_t* data, size_t size);
 
   Minidump(const Minidump&) = delete;
   void operator=(const Minidump&) = delete;
@@ -1293,6 +1595,7 @@ class Minidump {
   virtual MinidumpThreadNameList* GetThreadNameList();
   virtual MinidumpModuleList* GetModuleList();
   virtual MinidumpMemoryList* GetMemoryList();
+  virtual MinidumpMemory64List* GetMemory64List();
   virtual MinidumpException* GetException();
   virtual MinidumpAssertion* GetAssertion();
   virtual MinidumpSystemInfo* GetSystemInfo();
@@ -1301,6 +1604,8 @@ class Minidump {
   virtual MinidumpBreakpadInfo* GetBreakpadInfo();
   virtual MinidumpMemoryInfoList* GetMemoryInfoList();
   MinidumpCrashpadInfo* GetCrashpadInfo();
+  MinidumpDumpTiming* GetDumpTiming();
+  MinidumpCrashSignature* GetCrashSignature();
 
   // The next method also calls GetStream, but is exclusive for Linux dumps.
   virtual MinidumpLinuxMapsList* GetLinuxMapsList();
@@ -1328,6 +1633,16 @@ class Minidump {
   // Returns the current position of the minidump file.
   off_t Tell();
 
+  // Returns a pointer to count bytes at offset in the minidump, without
+  // copying them and without changing the current position.  Returns NULL
+  // if the minidump is not backed by memory, or if the requested range
+  // does not lie entirely within it.  The returned bytes are not
+  // byte-swapped.
+  const uint8_t* GetMappedBytes(off_t offset, size_t count) const;
+
+  // True if the minidump is read from memory rather than from a stream.
+  bool is_memory_backed() const { return memory_backed_; }
+
   // Medium-level I/O routines.
 
   // ReadString returns a string which is owned by the caller!  offset
@@ -1378,6 +1693,13 @@ class Minidump {
   // Get current hexdump display settings.
   unsigned int HexdumpMode() const { return hexdump_ ? hexdump_width_ : 0; }
 
+  // Set the hexdump display settings of a minidump that was not opened from
+  // a path.  Memory regions read afterwards print in the new mode.
+  void SetHexdumpMode(bool hexdump, unsigned int hexdump_width) {
+    hexdump_ = hexdump;
+    hexdump_width_ = hexdump_width;
+  }
+
  private:
   // MinidumpStreamInfo is used in the MinidumpStreamMap.  It lets
   // the Minidump object locate interesting streams quickly, and
@@ -1401,6 +1723,11 @@ class Minidump {
   // Opens the minidump file, or if already open, seeks to the beginning.
   bool Open();
 
+  // If stream_ holds a compressed minidump, decompresses it into
+  // decompressed_ and reads from there instead, as for a memory-backed
+  // minidump.  Otherwise, leaves stream_ at its beginning.
+  bool DecompressStream();
+
   // The largest number of top-level streams that will be read from a minidump.
   // Note that streams are only read (and only consume memory) as needed,
   // when directed by the caller.  The default is 128.
@@ -1428,6 +1755,18 @@ class Minidump {
   // Set based on the path in Open, or directly in the constructor.
   std::istream*             stream_;
 
+  // When the minidump is backed by memory, contents_ and contents_size_
+  // describe that memory and contents_position_ takes the place of the
+  // stream position.  stream_ is unused in that case.
+  bool                      memory_backed_;
+  const uint8_t*            contents_;
+  size_t                    contents_size_;
+  off_t                     contents_position_;
+
+  // A compressed minidump is decompressed into decompressed_ when it is
+  // opened, and then read from memory.
+  std::vector<uint8_t>      decompressed_;
+
   // swap_ is true if the minidump file should be byte-swapped.  If the
   // minidump was produced by a CPU that is other-endian than the CPU
   // processing the minidump, this will be true.  If the two CPUs are
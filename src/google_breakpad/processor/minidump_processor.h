@@ -30,6 +30,7 @@
 #define GOOGLE_BREAKPAD_PROCESSOR_MINIDUMP_PROCESSOR_H__
 
 #include <assert.h>
+#include <stdint.h>
 #include <string>
 
 #include "common/using_std_string.h"
@@ -38,11 +39,18 @@
 
 namespace google_breakpad {
 
+class CallStack;
 class Minidump;
 class ProcessState;
+class ProcessStateObserver;
 class StackFrameSymbolizer;
+class StackSignatureGenerator;
 class SourceLineResolverInterface;
+class StackWalkCache;
 class SymbolSupplier;
+class TerminalFrames;
+class UnsymbolizedWalk;
+struct StackFrame;
 struct SystemInfo;
 
 class MinidumpProcessor {
@@ -73,9 +81,37 @@ class MinidumpProcessor {
                         ProcessState* process_state);
 
   // Processes the minidump structure and fills process_state with the
-  // result.
+  // result.  Apart from the symbols its resolver loads, the
+  // MinidumpProcessor keeps nothing between minidumps, so one may process
+  // any number of them.  Passing the same process_state each time lets it
+  // reuse the memory of the previous result (see ProcessState::Clear).
   ProcessResult Process(Minidump* minidump,
                         ProcessState* process_state);
+
+  // Fills process_state with what can be learned without reading the
+  // minidump's threads, modules or memory: the time stamps, system info,
+  // crash reason and address, exception record, assertion and dump phases.
+  // No stacks are walked or symbols loaded, and process_state is left with
+  // no threads or modules.  This suits triage that only needs to classify
+  // crashes, and reads a small fraction of what Process does.
+  ProcessResult ProcessTriage(Minidump* minidump,
+                              ProcessState* process_state);
+
+  // Processes the minidump structure as Process does, but rebuilds each
+  // thread's stack from walk, recorded from an earlier ProcessState of the
+  // same minidump, and symbolizes it with the symbols available now,
+  // instead of walking it.  A thread is walked again if its recorded walk
+  // was incomplete, or if any of its frames is in a module that had no
+  // symbols, and so no CFI, when walk was recorded and has them now, since
+  // the module's CFI may unwind the stack differently.  Every thread is
+  // walked if walk's modules are not the minidump's.
+  // ProcessState::resymbolized_stack_count reports how many stacks were
+  // rebuilt.  Record the result in a new UnsymbolizedWalk to resymbolize
+  // it again later.
+  ProcessResult Resymbolize(Minidump* minidump,
+                            const UnsymbolizedWalk& walk,
+                            ProcessState* process_state);
+
   // Populates the cpu_* fields of the |info| parameter with textual
   // representations of the CPU type that the minidump in |dump| was
   // produced on.  Returns false if this information is not available in
@@ -138,12 +174,176 @@ class MinidumpProcessor {
     enable_objdump_for_exploitability_ = enabled;
   }
 
+  // Sets the flag to leave the exploitability analysis, when it is enabled,
+  // until ProcessState::AnalyzeExploitability is called, instead of running
+  // it in Process; its memory scans and disassembly then cost nothing for
+  // minidumps whose rating is never needed, and can be moved to a
+  // background thread for those whose rating is.  ProcessState::
+  // exploitability_deferred reports whether the analysis is pending.  The
+  // Minidump must outlive the pending analysis.  Process(const string&,
+  // ProcessState*) analyzes before it returns, since its Minidump does not
+  // outlive it.  The default is false.
+  void set_defer_exploitability(bool enabled) {
+    defer_exploitability_ = enabled;
+  }
+
   // Sets the maximum number of threads to process.
   void set_max_thread_count(int max_thread_count) {
     max_thread_count_ = max_thread_count;
   }
 
+  // Sets how many threads' stacks may be walked at once.  Values greater
+  // than 1 walk threads on a pool of worker threads; the resulting
+  // ProcessState is the same as with a serial walk.  The StackFrameSymbolizer
+  // must be safe to use concurrently.  The default is 1.
+  void set_walk_concurrency(int walk_concurrency) {
+    walk_concurrency_ = walk_concurrency;
+  }
+
+  // Sets the flag to allocate each thread's stack frames from an arena
+  // owned by its CallStack (see CallStack::EnableFrameArena), so that
+  // clearing the ProcessState releases them in a few large blocks.  The
+  // frames must not be kept after the ProcessState is cleared.
+  void set_enable_frame_arenas(bool enabled) {
+    enable_frame_arenas_ = enabled;
+  }
+
+  // Sets how many modules' symbols may be fetched and loaded at once before
+  // the stacks are walked.  Prefetching starts with the modules that
+  // contain the threads' instruction pointers, then goes on to every other
+  // module, so that fetch latency is not paid one module at a time during
+  // the walk.  Values greater than 1 call the SymbolSupplier concurrently,
+  // so it must be safe to call from several threads.  The default of 0
+  // fetches symbols only as the walk first needs them.
+  void set_symbol_prefetch_concurrency(int symbol_prefetch_concurrency) {
+    symbol_prefetch_concurrency_ = symbol_prefetch_concurrency;
+  }
+
+  // Sets the flag to prefetch symbols through
+  // SymbolSupplier::GetCStringSymbolDataAsync from the calling thread,
+  // instead of on worker threads.  The symbol prefetch concurrency is then
+  // the number of requests that may be outstanding at once.  This suits a
+  // supplier that fetches symbols asynchronously, from a remote store for
+  // instance.
+  void set_async_symbol_prefetch(bool enabled) {
+    async_symbol_prefetch_ = enabled;
+  }
+
+  // Sets the flag to copy the stack of a thread from an earlier thread
+  // instead of walking it, when both threads have the same registers and
+  // stack contents up to where their stacks are in memory.  Registers and
+  // stack words that point into the earlier thread's stack must point to
+  // the same place in the later thread's.  This suits dumps with many idle
+  // threads parked in the same place.  ProcessState::deduplicated_stack_count
+  // reports how many stacks were copied.  Only x86, amd64, arm and arm64
+  // stacks are deduplicated.  The default is false.
+  void set_deduplicate_stacks(bool enabled) {
+    deduplicate_stacks_ = enabled;
+  }
+
+  // Sets an observer to receive the parts of each ProcessState as Process
+  // fills them in.  Does not take ownership of observer, which may be NULL
+  // for none, the default.
+  void set_observer(ProcessStateObserver* observer) { observer_ = observer; }
+
+  // Sets the flag to record in ProcessState::stats the time spent in each
+  // phase of processing and in loading each module's symbols, and counts
+  // of frames by trust and of symbol lookups.  The default is false.
+  void set_collect_stats(bool enabled) { collect_stats_ = enabled; }
+
+  // Sets the time, in seconds, that walking the stacks of one minidump's
+  // threads may take, and that walking any one thread's stack may take.
+  // Once a limit is reached, the walk stops with the frames walked so far,
+  // threads not yet walked are left without frames, and the stacks and
+  // ProcessState::walk_truncated are marked as truncated.  The requesting
+  // thread is walked first so that it gets the most of the time.  Zero,
+  // the default, is no limit.
+  void set_walk_time_limit(double seconds) { walk_time_limit_ = seconds; }
+  void set_thread_walk_time_limit(double seconds) {
+    thread_walk_time_limit_ = seconds;
+  }
+
+  // Sets the flag to walk only the requesting thread's stack in Process,
+  // leaving the other threads' walks until they are first used through
+  // ProcessState::GetWalkedThread or ProcessState::WalkDeferredThreads.
+  // The Minidump must outlive the ProcessState's deferred walks, which
+  // must be done before this MinidumpProcessor processes another minidump
+  // and are subject only to the thread walk time limit.  The observer is
+  // not given deferred threads, and their stacks are not deduplicated.
+  // Process(const string&, ProcessState*) walks every thread before it
+  // returns, since its Minidump does not outlive it.  The default is
+  // false.
+  void set_defer_thread_walks(bool enabled) { defer_thread_walks_ = enabled; }
+
+  // Sets a generator for the signature of the requesting thread's stack,
+  // which is recorded in ProcessState::stack_signature along with its hash.
+  // Does not take ownership of generator, which may be NULL for none, the
+  // default.
+  void set_stack_signature_generator(
+      const StackSignatureGenerator* generator) {
+    stack_signature_generator_ = generator;
+  }
+
+  // Sets a cache of stack walks to consult before walking each thread's
+  // stack, and to keep the walks in, so that threads of later minidumps
+  // with the same modules, context and stack as one walked before are not
+  // walked again.  ProcessState::cached_stack_count reports how many stacks
+  // were copied from the cache.  Only x86, amd64, arm and arm64 stacks are
+  // cached, and walks cut short by a time limit are not kept.  Threads whose
+  // walks are deferred don't use the cache.  Does not take ownership of
+  // cache, which may be NULL for none, the default.
+  void set_stack_walk_cache(StackWalkCache* cache) {
+    stack_walk_cache_ = cache;
+  }
+
+  // Sets how many frames of each thread's stack are symbolized during the
+  // walk, not counting inlined frames.  Every frame's module is set, and
+  // its unwind information loaded, but the function and source line
+  // information of later frames is left empty until SymbolizeFrame is
+  // called for them.  Modules only later frames land in are loaded without
+  // their symbols, if the resolver supports it, until then.  Zero, the
+  // default, is no limit.
+  void set_symbolized_frame_limit(size_t frame_count) {
+    symbolized_frame_limit_ = frame_count;
+  }
+
+  // Stops each thread's walk after the first frame in a function that
+  // terminal_frames lists for the minidump's system; see
+  // terminal_frames.h.  The caller retains ownership of terminal_frames,
+  // which may be NULL for none, the default.
+  void set_terminal_frames(const TerminalFrames* terminal_frames) {
+    terminal_frames_ = terminal_frames;
+  }
+
+  // Fills in the function and source line information of frame, a frame
+  // of process_state's threads that was left unsymbolized by the
+  // symbolized frame limit.  Inlined frames are not added.  Returns true
+  // if the symbols of the frame's module were loaded.
+  bool SymbolizeFrame(const ProcessState& process_state, StackFrame* frame);
+
  private:
+  // The parts of a minidump that FillDumpInfo finds, defined in
+  // minidump_processor.cc.
+  struct DumpInfo;
+
+  // Fills in the parts of process_state that come from the minidump's
+  // header, system info, Breakpad info, exception, assertion and dump
+  // timing streams, and describes them in info, for Process and
+  // ProcessTriage.
+  ProcessResult FillDumpInfo(Minidump* dump,
+                             ProcessState* process_state,
+                             DumpInfo* info);
+
+  // Replaces the frames of destination with copies of the frames of source.
+  // Register values in the copies that are at least low and less than high
+  // are moved by delta, mapping them from the stack of source's thread to
+  // the stack of destination's.
+  static void CopyRelocatedStack(const CallStack& source,
+                                 uint64_t low,
+                                 uint64_t high,
+                                 uint64_t delta,
+                                 CallStack* destination);
+
   StackFrameSymbolizer* frame_symbolizer_;
   // Indicate whether resolver_helper_ is owned by this instance.
   bool own_frame_symbolizer_;
@@ -163,9 +363,59 @@ class MinidumpProcessor {
   // the enable_objdump_ flag.
   bool enable_objdump_for_exploitability_;
 
+  // This flag leaves the exploitability analysis to the ProcessState.
+  bool defer_exploitability_;
+
   // The maximum number of threads to process. This can be exceeded if the
   // requesting thread comes after the limit. Setting this to -1 means no limit.
   int max_thread_count_;
+
+  // The number of threads whose stacks may be walked concurrently.  Values
+  // of 1 or less walk every thread serially on the calling thread.
+  int walk_concurrency_;
+
+  // Whether each CallStack allocates its frames from an arena.
+  bool enable_frame_arenas_;
+
+  // Whether threads with identical stacks are walked once.
+  bool deduplicate_stacks_;
+
+  // The number of modules whose symbols may be prefetched concurrently, or
+  // 0 to not prefetch symbols.
+  int symbol_prefetch_concurrency_;
+
+  // Whether symbols are prefetched through asynchronous supplier requests.
+  bool async_symbol_prefetch_;
+
+  // Receives the parts of each ProcessState, or NULL.
+  ProcessStateObserver* observer_;
+
+  // Whether ProcessState::stats is recorded.
+  bool collect_stats_;
+
+  // The time limits on stack walking, in seconds, or zero for none.
+  double walk_time_limit_;
+  double thread_walk_time_limit_;
+
+  // Whether the walks of threads other than the requesting thread are left
+  // until they are needed.
+  bool defer_thread_walks_;
+
+  // Generates ProcessState::stack_signature, or NULL for none.
+  const StackSignatureGenerator* stack_signature_generator_;
+
+  // How many frames of each stack are symbolized during the walk, or zero
+  // for all of them.
+  size_t symbolized_frame_limit_;
+
+  // The functions after which walks stop, or NULL.
+  const TerminalFrames* terminal_frames_;
+
+  // Stack walks kept across minidumps, or NULL.
+  StackWalkCache* stack_walk_cache_;
+
+  // The walk Resymbolize is rebuilding stacks from, or NULL.
+  const UnsymbolizedWalk* unsymbolized_walk_;
 };
 
 }  // namespace google_breakpad
@@ -0,0 +1,65 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The caller may implement the NegativeSymbolCache abstract base class
+// to remember which modules have no symbols across processing runs.
+// SymbolSuppliers consult it before probing their symbol stores.
+
+#ifndef GOOGLE_BREAKPAD_PROCESSOR_NEGATIVE_SYMBOL_CACHE_H__
+#define GOOGLE_BREAKPAD_PROCESSOR_NEGATIVE_SYMBOL_CACHE_H__
+
+#include <string>
+
+#include "common/using_std_string.h"
+
+namespace google_breakpad {
+
+// Modules are identified by the debug_file and debug_identifier of their
+// CodeModule.  Implementations may be called from several threads at once.
+class NegativeSymbolCache {
+ public:
+  virtual ~NegativeSymbolCache() {}
+
+  // Returns true if the module was recorded as having no symbols, and the
+  // record has not expired.
+  virtual bool IsMissing(const string& debug_file,
+                         const string& debug_identifier) = 0;
+
+  // Records that no symbols were found for the module.
+  virtual void SetMissing(const string& debug_file,
+                          const string& debug_identifier) = 0;
+
+  // Forgets any record for the module, so that its symbols are looked for
+  // again.  Call this once symbols for the module have been uploaded.
+  virtual void Invalidate(const string& debug_file,
+                          const string& debug_identifier) = 0;
+};
+
+}  // namespace google_breakpad
+
+#endif  // GOOGLE_BREAKPAD_PROCESSOR_NEGATIVE_SYMBOL_CACHE_H__
@@ -33,7 +33,9 @@
 #ifndef GOOGLE_BREAKPAD_PROCESSOR_PROCESS_STATE_H__
 #define GOOGLE_BREAKPAD_PROCESSOR_PROCESS_STATE_H__
 
+#include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "common/using_std_string.h"
@@ -41,6 +43,7 @@
 #include "google_breakpad/processor/code_modules.h"
 #include "google_breakpad/processor/exception_record.h"
 #include "google_breakpad/processor/minidump.h"
+#include "google_breakpad/processor/processing_stats.h"
 #include "google_breakpad/processor/system_info.h"
 #include "processor/linked_ptr.h"
 
@@ -89,12 +92,46 @@ enum ExploitabilityRating {
                                        // was calculated.
 };
 
+// Walks the stacks of threads whose walks MinidumpProcessor deferred.  See
+// MinidumpProcessor::set_defer_thread_walks.
+class DeferredThreadWalker {
+ public:
+  virtual ~DeferredThreadWalker() {}
+
+  // Walks the stack of the thread at thread_index into stack, keeping its
+  // thread ID, and adds the modules found without symbols or with corrupt
+  // symbols to modules_without_symbols and modules_with_corrupt_symbols.
+  // Returns false if the walk was interrupted by the SymbolSupplier.  May
+  // be called for different threads at once.
+  virtual bool Walk(int thread_index,
+                    CallStack* stack,
+                    vector<const CodeModule*>* modules_without_symbols,
+                    vector<const CodeModule*>* modules_with_corrupt_symbols)
+      = 0;
+};
+
+// Rates the exploitability of a crash whose analysis MinidumpProcessor
+// deferred.  See MinidumpProcessor::set_defer_exploitability.
+class DeferredExploitability {
+ public:
+  virtual ~DeferredExploitability() {}
+
+  // Analyzes the crash and returns its rating.  Called at most once.
+  virtual ExploitabilityRating Analyze() = 0;
+};
+
 class ProcessState {
  public:
-  ProcessState() : modules_(NULL), unloaded_modules_(NULL) { Clear(); }
+  ProcessState() : deferred_walks_(NULL), deferred_exploitability_(NULL) {
+    Clear();
+  }
   ~ProcessState();
 
-  // Resets the ProcessState to its default values
+  // Resets the ProcessState to its default values.  The memory it holds
+  // is kept where it can be: vectors keep their capacity, and thread
+  // stacks are set aside, along with their frame arenas, for the next
+  // minidump processed into this ProcessState.  A service processing many
+  // minidumps allocates less by reusing one ProcessState per thread.
   void Clear();
 
   // Accessors.  See the data declarations below.
@@ -106,6 +143,12 @@ class ProcessState {
   string assertion() const { return assertion_; }
   int requesting_thread() const { return requesting_thread_; }
   int original_thread_count() const { return original_thread_count_; }
+  int deduplicated_stack_count() const { return deduplicated_stack_count_; }
+  int cached_stack_count() const { return cached_stack_count_; }
+  int resymbolized_stack_count() const { return resymbolized_stack_count_; }
+  bool walk_truncated() const { return walk_truncated_; }
+  string stack_signature() const { return stack_signature_; }
+  uint64_t stack_signature_hash() const { return stack_signature_hash_; }
   const ExceptionRecord* exception_record() const { return &exception_record_; }
   const vector<CallStack*>* threads() const { return &threads_; }
   const vector<MemoryRegion*>* thread_memory_regions() const {
@@ -113,8 +156,10 @@ class ProcessState {
   }
   const vector<string>* thread_names() const { return &thread_names_; }
   const SystemInfo* system_info() const { return &system_info_; }
-  const CodeModules* modules() const { return modules_; }
-  const CodeModules* unloaded_modules() const { return unloaded_modules_; }
+  const CodeModules* modules() const { return modules_.get(); }
+  const CodeModules* unloaded_modules() const {
+    return unloaded_modules_.get();
+  }
   const vector<linked_ptr<const CodeModule> >* shrunk_range_modules() const {
     return &shrunk_range_modules_;
   }
@@ -126,12 +171,86 @@ class ProcessState {
   }
   ExploitabilityRating exploitability() const { return exploitability_; }
 
+  // Where processing spent its time, and counts of what it did.  Only
+  // recorded if MinidumpProcessor::set_collect_stats was set.
+  const ProcessingStats* stats() const { return &stats_; }
+
+  // How long the client that wrote the minidump spent in each phase of
+  // writing it, from its MD_DUMP_TIMING_STREAM.  Empty if the minidump has
+  // no such stream.
+  const vector<MDRawDumpPhaseTiming>* dump_phases() const {
+    return &dump_phases_;
+  }
+
+  // True if the stack of the thread at thread_index has not been walked
+  // yet, because MinidumpProcessor::set_defer_thread_walks was set.  Its
+  // CallStack in threads() has its thread ID but no frames until it is
+  // walked through GetWalkedThread or WalkDeferredThreads.
+  bool thread_walk_deferred(int thread_index) const;
+
+  // Returns the stack of the thread at thread_index, walking it first if
+  // its walk was deferred.  Returns NULL if the walk was interrupted by
+  // the SymbolSupplier.  May be called from several threads at once, and
+  // while WalkDeferredThreads runs; a thread's stack is only walked once.
+  // The modules without symbols or with corrupt symbols, and
+  // walk_truncated, include those found by the walks once they are done.
+  const CallStack* GetWalkedThread(int thread_index);
+
+  // Walks the stacks of all of the threads whose walks are still deferred,
+  // on up to concurrency threads.  Returns false if a walk was interrupted
+  // by the SymbolSupplier.  This may be run on a background thread while
+  // others call GetWalkedThread.
+  bool WalkDeferredThreads(int concurrency);
+
+  // True if the crash has not been analyzed for exploitability yet,
+  // because MinidumpProcessor::set_defer_exploitability was set.
+  // exploitability() is EXPLOITABILITY_NOT_ANALYZED until it is analyzed
+  // through AnalyzeExploitability.
+  bool exploitability_deferred() const;
+
+  // Analyzes the crash for exploitability if its analysis was deferred, and
+  // returns the rating, which exploitability() returns from then on.  May
+  // be called from several threads at once, for instance on a background
+  // thread or pool while others read the stacks; the analysis is only run
+  // once, and the other callers wait for it.
+  ExploitabilityRating AnalyzeExploitability();
+
  private:
   // MinidumpProcessor and MicrodumpProcessor are responsible for building
   // ProcessState objects.
   friend class MinidumpProcessor;
   friend class MicrodumpProcessor;
 
+  struct DeferredThreadWalks;
+
+  // Leaves the walks of the threads at thread_indices to walker, which is
+  // owned.
+  void DeferThreadWalks(DeferredThreadWalker* walker,
+                        const vector<int>& thread_indices);
+
+  struct DeferredExploitabilityAnalysis;
+
+  // Leaves the exploitability analysis to analyzer, which is owned.
+  void DeferExploitability(DeferredExploitability* analyzer);
+
+  // Returns an empty CallStack for a thread, reusing one set aside by
+  // Clear if there is one.  The caller owns it until it is added to
+  // threads_.
+  CallStack* NewThread();
+
+  // Appends the modules in modules_without_symbols and
+  // modules_with_corrupt_symbols, as found by a thread's walk, to
+  // modules_without_symbols_ and modules_with_corrupt_symbols_, unless they
+  // are already there.  Walks are merged one at a time, in the order their
+  // modules are to be listed.
+  void MergeWalkModules(
+      const vector<const CodeModule*>& modules_without_symbols,
+      const vector<const CodeModule*>& modules_with_corrupt_symbols);
+
+  // The most CallStacks that Clear sets aside.  Each may keep a block of
+  // frame arena memory, so this bounds what an idle ProcessState holds.
+  static const size_t kMaxSpareThreads = 256;
+
   // The time-date stamp of the minidump (time_t format)
   uint32_t time_date_stamp_;
 
@@ -174,6 +293,32 @@ class ProcessState {
   // were originally in the minudump.
   int original_thread_count_;
 
+  // The number of threads whose stacks were copied from another thread with
+  // an identical stack instead of being walked.  See
+  // MinidumpProcessor::set_deduplicate_stacks.
+  int deduplicated_stack_count_;
+
+  // The number of threads whose stacks were copied from a walk kept in a
+  // StackWalkCache instead of being walked.  See
+  // MinidumpProcessor::set_stack_walk_cache.
+  int cached_stack_count_;
+
+  // The number of threads whose stacks were rebuilt from an
+  // UnsymbolizedWalk instead of being walked.  See
+  // MinidumpProcessor::Resymbolize.
+  int resymbolized_stack_count_;
+
+  // True if the time limits on stack walking stopped the walks of one or
+  // more threads early, leaving their stacks incomplete or empty.  See
+  // MinidumpProcessor::set_walk_time_limit and CallStack::truncated.
+  bool walk_truncated_;
+
+  // The signature of the requesting thread's stack and its hash, if
+  // MinidumpProcessor::set_stack_signature_generator was set and there is
+  // a requesting thread.  Otherwise, empty and 0.
+  string stack_signature_;
+  uint64_t stack_signature_hash_;
+
   // Exception record details: code, flags, address, parameters.
   ExceptionRecord exception_record_;
 
@@ -192,12 +337,13 @@ class ProcessState {
   SystemInfo system_info_;
 
   // The modules that were loaded into the process represented by the
-  // ProcessState.
-  const CodeModules *modules_;
+  // ProcessState.  The list is immutable, and may be shared with other
+  // ProcessStates made from the same dump.
+  std::shared_ptr<const CodeModules> modules_;
 
   // The modules that have been unloaded from the process represented by the
-  // ProcessState.
-  const CodeModules *unloaded_modules_;
+  // ProcessState.  Shared like modules_.
+  std::shared_ptr<const CodeModules> unloaded_modules_;
 
   // The modules which virtual address ranges were shrunk down due to
   // virtual address conflicts.
@@ -209,10 +355,34 @@ class ProcessState {
   // The modules that had corrupt symbols when the report was processed.
   vector<const CodeModule*> modules_with_corrupt_symbols_;
 
+  // The modules in modules_without_symbols_ and
+  // modules_with_corrupt_symbols_, so that the walks of a dump with
+  // thousands of modules lacking symbols are merged in linear time.
+  std::unordered_set<const CodeModule*> modules_without_symbols_set_;
+  std::unordered_set<const CodeModule*> modules_with_corrupt_symbols_set_;
+
   // The exploitability rating as determined by the exploitability
   // engine. When the exploitability engine is not enabled this
   // defaults to EXPLOITABILITY_NOT_ANALYZED.
   ExploitabilityRating exploitability_;
+
+  // Statistics recorded while processing.
+  ProcessingStats stats_;
+
+  // The client's timing of the dump, as recorded in the minidump.
+  vector<MDRawDumpPhaseTiming> dump_phases_;
+
+  // The state of the walks that were deferred, or NULL if there were none.
+  // Owned.
+  DeferredThreadWalks* deferred_walks_;
+
+  // The exploitability analysis that was deferred, or NULL if there was
+  // none.  Owned.
+  DeferredExploitabilityAnalysis* deferred_exploitability_;
+
+  // Cleared CallStacks of a previous minidump, for NewThread to reuse.
+  // Owned.
+  vector<CallStack*> spare_threads_;
 };
 
 }  // namespace google_breakpad
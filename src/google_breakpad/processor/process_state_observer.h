@@ -0,0 +1,60 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// The caller may implement the ProcessStateObserver abstract base class to
+// receive the parts of a ProcessState as MinidumpProcessor::Process fills
+// them in, so that output can begin before the whole minidump is processed.
+
+#ifndef GOOGLE_BREAKPAD_PROCESSOR_PROCESS_STATE_OBSERVER_H__
+#define GOOGLE_BREAKPAD_PROCESSOR_PROCESS_STATE_OBSERVER_H__
+
+namespace google_breakpad {
+
+class CallStack;
+class ProcessState;
+
+// The observer is called one method at a time, though with a concurrent
+// walk it may be called from any of the walk's threads.
+class ProcessStateObserver {
+ public:
+  virtual ~ProcessStateObserver() {}
+
+  // Called once the process_state fields describing the process, its
+  // system, its crash and its modules are filled in, before any stack is
+  // walked.  The requesting thread is not yet known.
+  virtual void OnProcessInfo(const ProcessState& process_state) = 0;
+
+  // Called once the stack of the thread at thread_index in
+  // ProcessState::threads is complete, its thread ID included.  Threads
+  // may complete in any order.
+  virtual void OnThread(int thread_index, const CallStack& stack) = 0;
+};
+
+}  // namespace google_breakpad
+
+#endif  // GOOGLE_BREAKPAD_PROCESSOR_PROCESS_STATE_OBSERVER_H__
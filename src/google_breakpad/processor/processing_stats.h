@@ -0,0 +1,236 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// processing_stats.h: Where MinidumpProcessor::Process spent its time, and
+// counts of what it did, for finding minidumps that are slow to process.
+
+#ifndef GOOGLE_BREAKPAD_PROCESSOR_PROCESSING_STATS_H__
+#define GOOGLE_BREAKPAD_PROCESSOR_PROCESSING_STATS_H__
+
+#include <time.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/using_std_string.h"
+#include "google_breakpad/common/breakpad_types.h"
+#include "google_breakpad/processor/stack_frame.h"
+
+namespace google_breakpad {
+
+// Statistics may be recorded from several threads at once, as they are
+// during a concurrent stack walk.  While a ProcessingStats is current on a
+// thread, StackFrameSymbolizer records symbol loads and lookups there.
+class ProcessingStats {
+ public:
+  enum Phase {
+    // Reading the minidump's header and streams.
+    PHASE_READ,
+    // Digesting the system, crash and assertion information.
+    PHASE_SYSTEM_INFO,
+    // Prefetching symbols; see MinidumpProcessor::set_symbol_prefetch_*.
+    PHASE_SYMBOL_PREFETCH,
+    // Walking the threads' stacks, including the symbols fetched and loaded
+    // as the walk first needs them.
+    PHASE_WALK,
+    // Rating exploitability.
+    PHASE_EXPLOITABILITY,
+    PHASE_COUNT
+  };
+
+  // The time spent fetching and loading the symbols for one module.
+  struct ModuleLoad {
+    string code_file;
+    string debug_identifier;
+    // Wall-clock seconds spent fetching the symbols from the
+    // SymbolSupplier, and parsing them into the resolver.  Symbols fetched
+    // asynchronously have no fetch time.
+    double fetch_seconds;
+    double parse_seconds;
+    // Whether symbols were found and loaded.
+    bool loaded;
+  };
+
+  // The number of frame trust levels, for frame_count.
+  static const int kFrameTrustCount = StackFrame::FRAME_TRUST_LEAF + 1;
+
+  ProcessingStats() { Clear(); }
+
+  void Clear() {
+    std::lock_guard<std::mutex> lock(lock_);
+    for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+      wall_seconds_[phase] = 0;
+      cpu_seconds_[phase] = 0;
+    }
+    module_loads_.clear();
+    for (int trust = 0; trust < kFrameTrustCount; ++trust)
+      frame_counts_[trust] = 0;
+    symbol_lookups_ = 0;
+    memoized_symbol_lookups_ = 0;
+  }
+
+  // Wall-clock and CPU seconds spent in phase.  CPU time is that of every
+  // thread that worked on the phase.
+  double wall_seconds(Phase phase) const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return wall_seconds_[phase];
+  }
+  double cpu_seconds(Phase phase) const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return cpu_seconds_[phase];
+  }
+  void AddPhaseTime(Phase phase, double wall_seconds, double cpu_seconds) {
+    std::lock_guard<std::mutex> lock(lock_);
+    wall_seconds_[phase] += wall_seconds;
+    cpu_seconds_[phase] += cpu_seconds;
+  }
+
+  // The modules whose symbols were fetched and loaded, in the order they
+  // were.
+  std::vector<ModuleLoad> module_loads() const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return module_loads_;
+  }
+  void AddModuleLoad(const ModuleLoad& module_load) {
+    std::lock_guard<std::mutex> lock(lock_);
+    module_loads_.push_back(module_load);
+  }
+
+  // The number of frames found with trust.
+  uint64_t frame_count(StackFrame::FrameTrust trust) const {
+    std::lock_guard<std::mutex> lock(lock_);
+    return frame_counts_[trust];
+  }
+  void AddFrames(StackFrame::FrameTrust trust, uint64_t count) {
+    std::lock_guard<std::mutex> lock(lock_);
+    frame_counts_[trust] += count;
+  }
+
+  // The number of frames StackFrameSymbolizer was asked to symbolize in a
+  // module, and how many of those were answered from its memo of
+  // symbolized frames; the rest were looked up in the resolver.
+  uint64_t symbol_lookups() const { return symbol_lookups_; }
+  uint64_t memoized_symbol_lookups() const { return memoized_symbol_lookups_; }
+  void CountSymbolLookup(bool memoized) {
+    ++symbol_lookups_;
+    if (memoized)
+      ++memoized_symbol_lookups_;
+  }
+
+  // The ProcessingStats current on this thread, or NULL to record nothing.
+  static ProcessingStats*& current() {
+    static thread_local ProcessingStats* current_stats = NULL;
+    return current_stats;
+  }
+
+  // Returns the CPU seconds used by the calling thread.
+  static double ThreadCPUSeconds() {
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec now;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now) == 0)
+      return now.tv_sec + now.tv_nsec / 1e9;
+#endif
+    return 0;
+  }
+
+  // Returns a wall-clock time in seconds, for measuring intervals.
+  static double WallSeconds() {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+ private:
+  mutable std::mutex lock_;
+  double wall_seconds_[PHASE_COUNT];
+  double cpu_seconds_[PHASE_COUNT];
+  std::vector<ModuleLoad> module_loads_;
+  uint64_t frame_counts_[kFrameTrustCount];
+  std::atomic<uint64_t> symbol_lookups_;
+  std::atomic<uint64_t> memoized_symbol_lookups_;
+};
+
+// Makes stats current on the calling thread for the life of the
+// ScopedProcessingStats.  stats may be NULL.
+class ScopedProcessingStats {
+ public:
+  explicit ScopedProcessingStats(ProcessingStats* stats)
+      : previous_stats_(ProcessingStats::current()) {
+    ProcessingStats::current() = stats;
+  }
+  ~ScopedProcessingStats() { ProcessingStats::current() = previous_stats_; }
+
+ private:
+  ProcessingStats* previous_stats_;
+};
+
+// Adds the wall-clock time and the calling thread's CPU time from Start
+// to Stop to a phase of stats, which may be NULL.  Starting a phase stops
+// the one before, and destruction stops the last.
+class PhaseTimer {
+ public:
+  explicit PhaseTimer(ProcessingStats* stats)
+      : stats_(stats),
+        running_(false),
+        phase_(ProcessingStats::PHASE_READ),
+        wall_start_(0),
+        cpu_start_(0) {}
+  ~PhaseTimer() { Stop(); }
+
+  void Start(ProcessingStats::Phase phase) {
+    Stop();
+    if (!stats_)
+      return;
+    running_ = true;
+    phase_ = phase;
+    wall_start_ = ProcessingStats::WallSeconds();
+    cpu_start_ = ProcessingStats::ThreadCPUSeconds();
+  }
+
+  void Stop() {
+    if (!running_)
+      return;
+    running_ = false;
+    stats_->AddPhaseTime(phase_,
+                         ProcessingStats::WallSeconds() - wall_start_,
+                         ProcessingStats::ThreadCPUSeconds() - cpu_start_);
+  }
+
+ private:
+  ProcessingStats* stats_;
+  bool running_;
+  ProcessingStats::Phase phase_;
+  double wall_start_;
+  double cpu_start_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // GOOGLE_BREAKPAD_PROCESSOR_PROCESSING_STATS_H__
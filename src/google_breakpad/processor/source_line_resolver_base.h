@@ -40,10 +40,15 @@
 #ifndef GOOGLE_BREAKPAD_PROCESSOR_SOURCE_LINE_RESOLVER_BASE_H__
 #define GOOGLE_BREAKPAD_PROCESSOR_SOURCE_LINE_RESOLVER_BASE_H__
 
+#include <atomic>
 #include <deque>
 #include <map>
+#include <memory>
 #include <set>
+#include <shared_mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "google_breakpad/processor/source_line_resolver_interface.h"
 
@@ -57,17 +62,88 @@ using std::set;
 // at run-time.
 class ModuleFactory;
 
+class SymbolFileIndex;
+
+// SourceLineResolverBase may be shared by several threads.  Lookups of
+// loaded modules proceed concurrently under a shared lock; loading and
+// unloading modules take it exclusively.  Symbol data is parsed before the
+// lock is taken, so loading one module doesn't stall lookups in the others.
+// Loaded modules are not modified by lookups.
+//
+// Loaded modules are kept until they are unloaded, unless a memory budget is
+// set, in which case the least recently used modules are evicted to stay
+// within it.
+//
+// A module loaded with LoadModuleUnwindInfoUsingMemoryBuffer() is held in
+// two parts: the unwind records, and the symbol records
+// LoadModuleSymbolsUsingMemoryBuffer() adds later.  Each part is accounted
+// its own memory, and the memory budget evicts symbol parts before whole
+// modules, so that unwinding information stays loaded the longest.
 class SourceLineResolverBase : public SourceLineResolverInterface {
  public:
+  // Counters describing the use of the loaded modules.  HasModule counts a
+  // hit when the module is loaded and a miss when it is not.
+  struct ModuleCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    size_t module_count;
+    // The memory accounted to the loaded modules, in bytes.
+    size_t memory_usage;
+  };
+
+  // The memory of one loaded module.  Only the symbol data a module keeps
+  // referring to, as FastSourceLineResolver's modules and those of a
+  // BasicSourceLineResolver retaining its symbol data do, is measured for
+  // residency.
+  struct ModuleMemoryStats {
+    string code_file;
+    // The memory accounted to the module, in bytes, as for the budget.
+    size_t memory_usage;
+    // The size of the symbol data the module keeps, or 0 if it keeps none.
+    size_t symbol_data_size;
+    // How much of that symbol data is in memory, and how many huge pages
+    // back it.  See SymbolBuffer::GetResidency().
+    size_t resident_size;
+    size_t huge_page_count;
+  };
+
   // Read the symbol_data from a file with given file_name.
   // The part of code was originally in BasicSourceLineResolver::Module's
   // LoadMap() method.
   // Place dynamically allocated heap buffer in symbol_data. Caller has the
   // ownership of the buffer, and should call delete [] to free the buffer.
+  // A compressed symbol file, named as described in
+  // processor/compressed_symbol_file.h, is decompressed into the buffer.
   static bool ReadSymbolFile(const string& file_name,
                              char** symbol_data,
                              size_t* symbol_data_size);
 
+  // Limits the memory used by loaded modules to memory_budget bytes.  Each
+  // module is accounted the size of the symbol data it was loaded from,
+  // less the blocks of an indexed module, which are parsed on demand, and
+  // each part of a module loaded in parts the size of its records.  When
+  // loading a module takes the total over the budget, the least recently
+  // used symbol parts, and then the least recently used other modules, are
+  // unloaded until it fits again; a module being looked up is never
+  // unloaded under the lookup.  0, the default, means no limit.
+  void set_memory_budget(size_t memory_budget);
+
+  ModuleCacheStats GetModuleCacheStats() const;
+
+  // Returns the memory statistics of each loaded module, by code file.
+  // Measuring residency reads the process's memory maps, so this is meant
+  // for occasional reports rather than for every minidump.
+  std::vector<ModuleMemoryStats> GetModuleMemoryStats() const;
+
+  // Sets whether the symbol data of at least SymbolBuffer::kHugePageSize
+  // bytes that modules keep referring to is copied to memory backed by
+  // huge pages as it is loaded (see SymbolBuffer::CopyToHugePages), so
+  // that lookups in large modules miss the TLB less.  Symbol data mapped
+  // from hugetlbfs is used in place.  Applies to modules loaded
+  // afterwards.  Off by default.
+  void set_huge_pages(bool huge_pages) { huge_pages_ = huge_pages; }
+
  protected:
   // Users are not allowed create SourceLineResolverBase instance directly.
   SourceLineResolverBase(ModuleFactory* module_factory);
@@ -80,15 +156,51 @@ class SourceLineResolverBase : public SourceLineResolverInterface {
   virtual bool LoadModuleUsingMemoryBuffer(const CodeModule* module,
                                            char* memory_buffer,
                                            size_t memory_buffer_size);
+  virtual bool LoadModuleUsingSymbolBuffer(
+      const CodeModule* module,
+      const std::shared_ptr<SymbolBuffer>& symbol_buffer);
+  virtual bool LoadModuleUnwindInfoUsingMemoryBuffer(
+      const CodeModule* module,
+      char* memory_buffer,
+      size_t memory_buffer_size);
+  virtual bool LoadModuleSymbolsUsingMemoryBuffer(const CodeModule* module,
+                                                  char* memory_buffer,
+                                                  size_t memory_buffer_size);
   virtual bool ShouldDeleteMemoryBufferAfterLoadModule();
+
+  // Maps map_file into memory and loads the module from the mapping, which
+  // is kept, without copying, for as long as the module is loaded.  Pages
+  // the module never writes to are shared with every process mapping the
+  // same file, so this suits resolvers whose modules use the memory buffer
+  // in place and never write to it.
+  bool LoadModuleUsingMappedFile(const CodeModule* module,
+                                 const string& map_file);
+
+  // Loads the module from map_file using the index sym_to_fast -i wrote
+  // for it, in map_file plus kSymbolFileIndexExtension.  map_file is mapped
+  // as by LoadModuleUsingMappedFile(), and only the records outside the
+  // indexed FUNC and STACK CFI blocks are parsed up front; each block is
+  // parsed when it is first looked up.  Without a usable index, such as
+  // one written for a different version of map_file, this loads map_file
+  // as LoadModule() does.
+  bool LoadModuleUsingIndexedFile(const CodeModule* module,
+                                  const string& map_file);
+
   virtual void UnloadModule(const CodeModule* module);
   virtual bool HasModule(const CodeModule* module);
+  virtual bool HasModuleSymbols(const CodeModule* module);
   virtual bool IsModuleCorrupt(const CodeModule* module);
   virtual void FillSourceLineInfo(
       StackFrame* frame,
       std::deque<std::unique_ptr<StackFrame>>* inlined_frames);
   virtual WindowsFrameInfo* FindWindowsFrameInfo(const StackFrame* frame);
   virtual CFIFrameInfo* FindCFIFrameInfo(const StackFrame* frame);
+  virtual size_t PrewarmModule(const CodeModule* module,
+                               const std::vector<uint64_t>& addresses);
+  virtual bool SymbolizeAddresses(const CodeModule* module,
+                                  const uint64_t* addresses,
+                                  size_t count,
+                                  SymbolizedAddresses* results);
 
   // Nested structs and classes.
   struct InlineOrigin;
@@ -102,23 +214,90 @@ class SourceLineResolverBase : public SourceLineResolverInterface {
   // Module is an interface for an in-memory symbol file.
   class Module;
   class AutoFileCloser;
+  class NameInterner;
 
   // All of the modules that are loaded.
   typedef map<string, Module*, CompareString> ModuleMap;
   ModuleMap* modules_;
 
+  // The symbol parts of the modules loaded in parts, by the code file of
+  // the module in modules_ holding their unwind part.  NULL until the
+  // symbol part is loaded, and again once it is evicted.
+  ModuleMap* symbol_modules_;
+
   // The loaded modules that were detecting to be corrupt during load.
   typedef set<string, CompareString> ModuleSet;
   ModuleSet* corrupt_modules_;
 
-  // All of heap-allocated buffers that are owned locally by resolver.
-  typedef std::map<string, char*, CompareString> MemoryMap;
-  MemoryMap* memory_buffers_;
+  // The symbol data that loaded modules refer to, by code file.
+  typedef std::map<string, std::shared_ptr<SymbolBuffer>, CompareString>
+      SymbolBufferMap;
+  SymbolBufferMap* symbol_buffers_;
 
   // Creates a concrete module at run-time.
   ModuleFactory* module_factory_;
 
+  // Guards modules_, symbol_modules_, corrupt_modules_ and symbol_buffers_,
+  // and the memory accounting below.
+  mutable std::shared_mutex modules_lock_;
+
  private:
+  // Returns true if a module named code_file has been loaded.
+  bool IsModuleLoaded(const string& code_file);
+
+  // Implements the LoadModule* methods.  The module is loaded from
+  // symbol_buffer, which is kept for as long as the module is loaded if the
+  // module refers to it.  With an index, the module is loaded with
+  // Module::LoadMapFromIndexedFile() and always refers to it.  A borrowed
+  // symbol_buffer is never kept: its owner keeps the data alive.
+  bool LoadModuleInternal(const CodeModule* module,
+                          const std::shared_ptr<SymbolBuffer>& symbol_buffer,
+                          const SymbolFileIndex* index);
+
+  // Implements LoadModuleUnwindInfoUsingMemoryBuffer(), or
+  // LoadModuleSymbolsUsingMemoryBuffer() if unwind_info is false.
+  bool LoadModulePart(const CodeModule* module,
+                      char* memory_buffer,
+                      size_t memory_buffer_size,
+                      bool unwind_info);
+
+  // Returns the module holding the symbol records of module, the module
+  // loaded for code_file: module itself, unless it was loaded in parts, in
+  // which case its symbol part, or NULL if that is not loaded.
+  // modules_lock_ must be held.
+  Module* GetSymbolModule(const string& code_file, Module* module) const;
+
+  // Unloads the module at mod_iter, with its symbol part if it has one.
+  // modules_lock_ must be held exclusively.
+  void EraseModule(ModuleMap::iterator mod_iter);
+
+  // Unloads the symbol part at symbol_iter, keeping the unwind part.
+  // modules_lock_ must be held exclusively.
+  void EraseSymbolModule(ModuleMap::iterator symbol_iter);
+
+  // Unloads least recently used symbol parts, and then modules, other than
+  // keep and the module keep is a part of, until the memory budget is met.
+  // modules_lock_ must be held exclusively.
+  void EvictModules(const Module* keep);
+
+  // Records a use of module for eviction purposes.  modules_lock_ must be
+  // held.
+  void MarkUsed(const Module* module);
+
+  // The memory budget for loaded modules, and the memory they account for.
+  size_t memory_budget_;
+  size_t memory_usage_;
+
+  // Whether kept symbol data is copied to huge pages.
+  bool huge_pages_;
+
+  // Advanced on each recorded use of a module, to order uses.
+  std::atomic<uint64_t> use_clock_;
+
+  std::atomic<uint64_t> cache_hits_;
+  std::atomic<uint64_t> cache_misses_;
+  std::atomic<uint64_t> cache_evictions_;
+
   // ModuleFactory needs to have access to protected type Module.
   friend class ModuleFactory;
 
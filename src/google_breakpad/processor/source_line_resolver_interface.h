@@ -41,6 +41,8 @@
 #include "common/using_std_string.h"
 #include "google_breakpad/common/breakpad_types.h"
 #include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/symbol_buffer.h"
+#include "google_breakpad/processor/symbolized_addresses.h"
 
 namespace google_breakpad {
 
@@ -76,6 +78,42 @@ class SourceLineResolverInterface {
                                            char* memory_buffer,
                                            size_t memory_buffer_size) = 0;
 
+  // Same as above, but a resolver whose modules refer to the symbol data
+  // keeps a reference to symbol_buffer for as long as the module is
+  // loaded, instead of relying on the caller to keep the data alive.  The
+  // default implementation loads the module as LoadModuleUsingMemoryBuffer()
+  // does, so a resolver that keeps references to the data must override it.
+  virtual bool LoadModuleUsingSymbolBuffer(
+      const CodeModule* module,
+      const std::shared_ptr<SymbolBuffer>& symbol_buffer) {
+    return LoadModuleUsingMemoryBuffer(module, symbol_buffer->data(),
+                                       symbol_buffer->size());
+  }
+
+  // Loads only the records of the symbol data that unwinding needs, the
+  // STACK WIN and STACK CFI records, so that FindWindowsFrameInfo() and
+  // FindCFIFrameInfo() work while FillSourceLineInfo() leaves frames in
+  // the module unfilled until LoadModuleSymbolsUsingMemoryBuffer() loads
+  // the rest.  Takes memory_buffer as LoadModuleUsingMemoryBuffer() does.
+  // Resolvers that cannot split symbol data load all of it.
+  virtual bool LoadModuleUnwindInfoUsingMemoryBuffer(
+      const CodeModule* module,
+      char* memory_buffer,
+      size_t memory_buffer_size) {
+    return LoadModuleUsingMemoryBuffer(module, memory_buffer,
+                                       memory_buffer_size);
+  }
+
+  // Loads the records of the symbol data that
+  // LoadModuleUnwindInfoUsingMemoryBuffer() left out, for a module it
+  // loaded: the function, line, inline and public symbol records.  Returns
+  // false if the module is not loaded, or its symbols already are.
+  virtual bool LoadModuleSymbolsUsingMemoryBuffer(const CodeModule* module,
+                                                  char* memory_buffer,
+                                                  size_t memory_buffer_size) {
+    return false;
+  }
+
   // Return true if the memory buffer should be deleted immediately after
   // LoadModuleUsingMemoryBuffer(). Return false if the memory buffer has to be
   // alive during the lifetime of the corresponding Module.
@@ -88,6 +126,13 @@ class SourceLineResolverInterface {
   // Returns true if the module has been loaded.
   virtual bool HasModule(const CodeModule* module) = 0;
 
+  // Returns true if the module has been loaded with its function, line,
+  // inline and public symbol records, so that FillSourceLineInfo() can
+  // fill in frames in it.
+  virtual bool HasModuleSymbols(const CodeModule* module) {
+    return HasModule(module);
+  }
+
   // Returns true if the module has been loaded and it is corrupt.
   virtual bool IsModuleCorrupt(const CodeModule* module) = 0;
 
@@ -113,6 +158,33 @@ class SourceLineResolverInterface {
   // returned CFIFrameInfo object.
   virtual CFIFrameInfo* FindCFIFrameInfo(const StackFrame* frame) = 0;
 
+  // Looks up each of addresses, relative to module's base address, in
+  // module, which must be loaded, so that whatever the resolver parses on
+  // demand for a lookup, such as the functions and CFI of a module loaded
+  // with an index, is parsed before any stack walk needs it.  Returns the
+  // number of addresses that fell in a function.  Resolvers that parse
+  // nothing on demand have nothing to do, and return 0.
+  virtual size_t PrewarmModule(const CodeModule* module,
+                               const std::vector<uint64_t>& addresses) {
+    return 0;
+  }
+
+  // Looks up the count addresses at addresses, relative to module's base
+  // address and sorted in increasing order, in module, which must be loaded
+  // with its symbols, and appends what FillSourceLineInfo() would fill in
+  // for each, and its inlined frames, to the columns of *results.  The
+  // module is found once for the whole batch, and a run of addresses in the
+  // same function and line shares their lookups, so this is much faster
+  // than calling FillSourceLineInfo() per address.  Returns false, leaving
+  // *results alone, if the module's symbols are not loaded, or if the
+  // resolver cannot look up addresses in batches.
+  virtual bool SymbolizeAddresses(const CodeModule* module,
+                                  const uint64_t* addresses,
+                                  size_t count,
+                                  SymbolizedAddresses* results) {
+    return false;
+  }
+
  protected:
   // SourceLineResolverInterface cannot be instantiated except by subclasses
   SourceLineResolverInterface() {}
@@ -29,6 +29,10 @@
 #ifndef GOOGLE_BREAKPAD_PROCESSOR_STACK_FRAME_H__
 #define GOOGLE_BREAKPAD_PROCESSOR_STACK_FRAME_H__
 
+#include <stddef.h>
+#include <stdlib.h>
+
+#include <new>
 #include <string>
 
 #include "common/using_std_string.h"
@@ -38,6 +42,24 @@ namespace google_breakpad {
 
 class CodeModule;
 
+// A source of memory for StackFrame objects.  While an allocator is current
+// on a thread, StackFrame objects created on that thread are allocated from
+// it, and deleting them leaves their memory to the allocator to reclaim.
+// CallStack uses this for its frame arena; see CallStack::EnableFrameArena.
+class StackFrameAllocator {
+ public:
+  virtual ~StackFrameAllocator() {}
+
+  // Returns size bytes of memory aligned for any type, or NULL.
+  virtual void* Allocate(size_t size) = 0;
+
+  // The allocator current on this thread, or NULL to use the heap.
+  static StackFrameAllocator*& current() {
+    static thread_local StackFrameAllocator* current_allocator = NULL;
+    return current_allocator;
+  }
+};
+
 struct StackFrame {
   // Indicates how well the instruction pointer derived during
   // stack walking is trusted. Since the stack walker can resort to
@@ -69,6 +91,32 @@ struct StackFrame {
         is_multiple(false) {}
   virtual ~StackFrame() {}
 
+  // StackFrame objects, including those of the CPU-specific subclasses, are
+  // allocated from the current StackFrameAllocator if there is one, and
+  // from the heap otherwise.
+  static void* operator new(size_t size) {
+    StackFrameAllocator* allocator = StackFrameAllocator::current();
+    size_t storage_size = sizeof(AllocationHeader) + size;
+    void* storage = allocator ? allocator->Allocate(storage_size)
+                              : malloc(storage_size);
+    if (!storage)
+      throw std::bad_alloc();
+
+    AllocationHeader* header = static_cast<AllocationHeader*>(storage);
+    header->allocator = allocator;
+    return header + 1;
+  }
+
+  static void operator delete(void* frame) {
+    if (!frame)
+      return;
+
+    // Memory from an allocator is reclaimed by the allocator.
+    AllocationHeader* header = static_cast<AllocationHeader*>(frame) - 1;
+    if (!header->allocator)
+      free(header);
+  }
+
   // Return a string describing how this stack frame was found
   // by the stackwalker.
   string trust_description() const {
@@ -151,6 +199,14 @@ struct StackFrame {
   // name, filename, etc. information above represents the state of an arbitrary
   // one of these functions.
   bool is_multiple;
+
+ private:
+  // Precedes the storage of each StackFrame, recording where it came from.
+  // The padding keeps the frame itself aligned for any type.
+  union AllocationHeader {
+    StackFrameAllocator* allocator;
+    max_align_t alignment;
+  };
 };
 
 }  // namespace google_breakpad
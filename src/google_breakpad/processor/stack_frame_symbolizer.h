@@ -35,24 +35,40 @@
 #define GOOGLE_BREAKPAD_PROCESSOR_STACK_FRAME_SYMBOLIZER_H__
 
 #include <deque>
+#include <map>
 #include <memory>
 #include <set>
+#include <shared_mutex>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "common/using_std_string.h"
 #include "google_breakpad/common/breakpad_types.h"
 #include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "google_breakpad/processor/symbol_supplier.h"
 
 namespace google_breakpad {
 class CFIFrameInfo;
 class CodeModules;
-class SymbolSupplier;
+class FrameProfile;
 class SourceLineResolverInterface;
-struct StackFrame;
 struct SystemInfo;
 struct WindowsFrameInfo;
 
+// FillSourceLineInfo, FindWindowsFrameInfo and FindCFIFrameInfo may be
+// called concurrently from several stack walkers, as MinidumpProcessor does
+// when its walk concurrency is greater than one.  Lookups share a reader
+// lock; fetching and loading symbols takes the writer lock.  Subclasses that
+// override these methods must be equally safe to call concurrently.
+//
+// FillSourceLineInfo memoizes the frames it symbolizes, keyed by module and
+// module-relative instruction address, so that the many threads of a dump
+// that are parked at the same few instructions are only symbolized once.
+//
+// Symbol loads and lookups are recorded in the ProcessingStats current on
+// the calling thread, if any.
 class StackFrameSymbolizer {
  public:
   enum SymbolizerResult {
@@ -84,6 +100,50 @@ class StackFrameSymbolizer {
       StackFrame* stack_frame,
       std::deque<std::unique_ptr<StackFrame>>* inlined_frames);
 
+  // Finds the module containing stack_frame and fetches and loads its
+  // symbols, as FillSourceLineInfo does, so that FindWindowsFrameInfo and
+  // FindCFIFrameInfo can unwind the frame, but leaves its function and
+  // source line information empty.  Returns the result FillSourceLineInfo
+  // would.  Only the unwind information is loaded, if the resolver can
+  // load it on its own; FillSourceLineInfo loads the rest once a frame in
+  // the module needs it.
+  virtual SymbolizerResult FillModuleInfo(
+      const CodeModules* modules,
+      const CodeModules* unloaded_modules,
+      const SystemInfo* system_info,
+      StackFrame* stack_frame);
+
+  // Fetches and loads the symbols for module ahead of a stack walk, as
+  // FillSourceLineInfo does when it first meets a module, and returns the
+  // result FillSourceLineInfo would for a frame in the module.
+  // Unlike FillSourceLineInfo, this fetches symbols without holding the
+  // writer lock, so several modules may be prefetched at once; the
+  // SymbolSupplier must then be safe to call concurrently.  Prefetching must
+  // not overlap stack walks that use this symbolizer.
+  virtual SymbolizerResult PrefetchModule(const CodeModule* module,
+                                          const SystemInfo* system_info);
+
+  // Prefetches the symbols for modules as PrefetchModule does, through
+  // SymbolSupplier::GetCStringSymbolDataAsync, with up to max_outstanding
+  // requests in flight at once.  Symbols are loaded on the calling thread
+  // as requests complete.  Returns kInterrupt if any request was
+  // interrupted, and kNoError otherwise.
+  virtual SymbolizerResult PrefetchModulesAsync(
+      const std::vector<const CodeModule*>& modules,
+      const SystemInfo* system_info,
+      int max_outstanding);
+
+  // Fetches and loads the symbols for each module in profile, as
+  // PrefetchModule does, and has the resolver parse ahead of time what it
+  // would parse on demand for the profile's addresses in the module.  A
+  // service can call this at startup with a profile gathered by
+  // set_frame_profile() in earlier runs, so that its first dumps are
+  // symbolized as quickly as later ones.  Like prefetching, this must not
+  // overlap stack walks that use this symbolizer.  Returns kInterrupt if
+  // fetching symbols was interrupted, and kNoError otherwise.
+  virtual SymbolizerResult PrewarmFromProfile(const FrameProfile& profile,
+                                              const SystemInfo* system_info);
+
   virtual WindowsFrameInfo* FindWindowsFrameInfo(const StackFrame* frame);
 
   virtual CFIFrameInfo* FindCFIFrameInfo(const StackFrame* frame);
@@ -92,7 +152,23 @@ class StackFrameSymbolizer {
   // A typical case is to call Reset() after processing an individual report
   // before start to process next one, in order to reset internal information
   // about missing symbols found so far.
-  virtual void Reset() { no_symbol_modules_.clear(); }
+  virtual void Reset();
+
+  // Sets whether memoized frames survive Reset.  By default the memo is
+  // cleared along with the other per-dump state; a service that processes
+  // many dumps against long-lived symbols can keep it, so that a frame is
+  // symbolized once for the lifetime of the resolver.  Only set this if the
+  // symbols loaded for a module never change.
+  void set_keep_frame_memo_across_resets(bool keep) {
+    keep_frame_memo_across_resets_ = keep;
+  }
+
+  // Sets a profile to count every frame FillSourceLineInfo symbolizes in,
+  // by module and module-relative address, or NULL, the default, to count
+  // nothing.  The profile must outlive the symbolizer's stack walks.
+  void set_frame_profile(FrameProfile* frame_profile) {
+    frame_profile_ = frame_profile;
+  }
 
   // Returns true if there is valid implementation for stack symbolization.
   virtual bool HasImplementation() { return resolver_ && supplier_; }
@@ -106,6 +182,81 @@ class StackFrameSymbolizer {
   // A list of modules known to have symbols missing. This helps avoid
   // repeated lookups for the missing symbols within one minidump.
   std::set<string> no_symbol_modules_;
+  // Guards resolver_ and no_symbol_modules_ against concurrent stack walkers.
+  std::shared_mutex lock_;
+
+ private:
+  // Returns true if module is loaded, with its symbols if
+  // fill_source_line_info is true.  lock_ must be held.
+  bool HasNeededSymbols(const CodeModule* module, bool fill_source_line_info);
+
+  // Implements FillSourceLineInfo, or FillModuleInfo if
+  // fill_source_line_info is false.
+  SymbolizerResult FillFrame(
+      const CodeModules* modules,
+      const CodeModules* unloaded_modules,
+      const SystemInfo* system_info,
+      StackFrame* frame,
+      std::deque<std::unique_ptr<StackFrame>>* inlined_frames,
+      bool fill_source_line_info);
+
+  // Returns the result of symbolizing a frame in module, which resolver_
+  // has loaded, without looking up the frame.  lock_ must be held.
+  SymbolizerResult LoadedModuleResult(const CodeModule* module);
+
+  // Sets result to the outcome of an earlier attempt to fetch and load the
+  // symbols for module, and returns true if there was one.
+  bool GetPrefetchedResult(const CodeModule* module, SymbolizerResult* result);
+
+  // Loads the symbols supplied for module into resolver_, or records that
+  // there are none.  fetch_seconds is the time the symbols took to fetch,
+  // for the current ProcessingStats.
+  SymbolizerResult LoadFetchedSymbols(
+      const CodeModule* module,
+      SymbolSupplier::SymbolResult symbol_result,
+      std::shared_ptr<SymbolBuffer> symbol_buffer,
+      double fetch_seconds);
+
+  // Drops this symbolizer's reference to the symbol data fetched for
+  // module, once it has been loaded into resolver_.
+  void ReleaseSymbolBuffer(const CodeModule* module,
+                           std::shared_ptr<SymbolBuffer>* symbol_buffer);
+
+  // The result of symbolizing one instruction.  Addresses in frame and
+  // inlined_frames are relative to the module's base address.
+  struct MemoizedFrame {
+    SymbolizerResult result;
+    StackFrame frame;
+    std::vector<StackFrame> inlined_frames;
+  };
+
+  // Memoized frames are keyed by module code file and debug identifier, then
+  // by module-relative address and whether inlined frames were requested.
+  typedef std::pair<string, string> MemoModuleKey;
+  typedef std::pair<uint64_t, bool> MemoAddressKey;
+  typedef std::map<MemoAddressKey, MemoizedFrame> ModuleFrameMemo;
+  typedef std::map<MemoModuleKey, ModuleFrameMemo> FrameMemo;
+
+  // Fills frame, and inlined_frames if it is not NULL, from frame_memo_.
+  // Returns false if the frame at this address has not been memoized.
+  bool FillFromFrameMemo(StackFrame* frame,
+                         std::deque<std::unique_ptr<StackFrame>>*
+                             inlined_frames,
+                         SymbolizerResult* result);
+
+  // Has resolver_ fill frame and inlined_frames from the loaded module
+  // containing frame, and memoizes the outcome.  lock_ must be held.
+  SymbolizerResult FillFromResolver(
+      StackFrame* frame,
+      std::deque<std::unique_ptr<StackFrame>>* inlined_frames);
+
+  FrameProfile* frame_profile_;
+
+  FrameMemo frame_memo_;
+  size_t frame_memo_size_;
+  bool keep_frame_memo_across_resets_;
+  // Guards frame_memo_ and frame_memo_size_.
+  std::shared_mutex frame_memo_lock_;
 };
 
 }  // namespace google_breakpad
@@ -0,0 +1,96 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// StackSignatureGenerator derives a crash signature from the top frames of
+// a symbolized stack, so that crashes can be bucketed without reparsing
+// printed stacks.  MinidumpProcessor::set_stack_signature_generator
+// records the signature of the requesting thread in ProcessState.
+
+#ifndef GOOGLE_BREAKPAD_PROCESSOR_STACK_SIGNATURE_GENERATOR_H__
+#define GOOGLE_BREAKPAD_PROCESSOR_STACK_SIGNATURE_GENERATOR_H__
+
+#include <stdint.h>
+
+#include <set>
+#include <string>
+
+#include "common/using_std_string.h"
+
+namespace google_breakpad {
+
+class CallStack;
+struct StackFrame;
+
+class StackSignatureGenerator {
+ public:
+  // The default number of frames in a signature.
+  static const int kDefaultFrameCount = 5;
+
+  // Starts with kDefaultFrameCount and with the default skipped functions,
+  // those that raise or report a crash rather than cause it.
+  StackSignatureGenerator();
+
+  // Sets the number of frames, after skipped frames are left out, in a
+  // signature.
+  void set_frame_count(int frame_count) { frame_count_ = frame_count; }
+  int frame_count() const { return frame_count_; }
+
+  // Leaves frames in function_name out of signatures.  A function_name
+  // ending in * skips every function that begins with the rest of it.
+  void AddSkippedFunction(const string& function_name);
+
+  // Forgets the skipped functions, the defaults included.
+  void ClearSkippedFunctions();
+
+  // Returns the signature of stack: the top frames that are not skipped,
+  // innermost first and separated by " | ".  A frame is its function name
+  // if it has one, or else the file name of its module and its offset in
+  // the module, or "??" if it has no module.  Line numbers and directories
+  // are left out, so that signatures are stable across builds and
+  // machines.  Returns an empty string if no frames are left.
+  string Generate(const CallStack& stack) const;
+
+  // Returns a 64-bit FNV-1a hash of signature, which is the same on every
+  // platform and in every run.
+  static uint64_t Hash(const string& signature);
+
+ private:
+  // Returns true if frame's function is skipped.
+  bool IsSkipped(const StackFrame& frame) const;
+
+  int frame_count_;
+
+  // The skipped function names, and the prefixes of skipped function
+  // names, without their *.
+  std::set<string> skipped_functions_;
+  std::set<string> skipped_function_prefixes_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // GOOGLE_BREAKPAD_PROCESSOR_STACK_SIGNATURE_GENERATOR_H__
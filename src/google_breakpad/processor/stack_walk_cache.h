@@ -0,0 +1,153 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// stack_walk_cache.h: Stack walks kept across minidumps.
+//
+// When symbols change, backlogs of minidumps are processed again, and many
+// of them crashed at the same place in the same build of a program.  A
+// StackWalkCache given to MinidumpProcessor::set_stack_walk_cache keeps the
+// walk of each thread's stack, keyed by everything the walk depends on
+// besides symbols: the minidump's system info and module lists, and the
+// thread's context and stack memory, address included.  A thread whose key
+// matches a kept walk gets a copy of its frames instead of being walked.
+//
+// Symbols are not part of the key.  Once a module's symbols change, call
+// InvalidateModule, and every walk of a minidump listing the module is
+// forgotten.
+
+#ifndef GOOGLE_BREAKPAD_PROCESSOR_STACK_WALK_CACHE_H__
+#define GOOGLE_BREAKPAD_PROCESSOR_STACK_WALK_CACHE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/call_stack.h"
+
+namespace google_breakpad {
+
+// StackWalkCache may be shared by MinidumpProcessors on several threads.
+class StackWalkCache {
+ public:
+  struct Stats {
+    uint64_t hits;
+    uint64_t misses;
+    // Walks forgotten by InvalidateModule or Clear.
+    uint64_t invalidations;
+    // Walks forgotten to stay within the memory budget.
+    uint64_t evictions;
+    size_t walk_count;
+    // The memory accounted to the kept walks, in bytes.
+    size_t memory_usage;
+  };
+
+  // A kept walk.  The frames' module pointers refer to the modules of the
+  // minidump that was walked, so they are kept as indexes instead: module
+  // i of a minidump's module list is i, and module i of its unloaded
+  // module list is the loaded module count plus i.  Only walks made with
+  // every module's symbols are kept, since a module's symbols may load
+  // later and change the walk.
+  struct Walk {
+    static const int kNoModule = -1;
+
+    CallStack stack;
+    // The module of each frame of stack, whose module pointers are NULL.
+    vector<int> frame_modules;
+  };
+
+  // The debug files and identifiers of the modules of a minidump, joined
+  // by a '/', that its walks depend on.
+  typedef std::set<string> ModuleSet;
+
+  // Creates a cache that keeps the most recently used walks that fit in
+  // memory_budget bytes.
+  explicit StackWalkCache(size_t memory_budget);
+  ~StackWalkCache();
+
+  // Returns the walk kept for key, or NULL.
+  std::shared_ptr<const Walk> Lookup(const string& key);
+
+  // Keeps walk for key, with the modules of the minidump it was walked in.
+  void Insert(const string& key,
+              const std::shared_ptr<const Walk>& walk,
+              const std::shared_ptr<const ModuleSet>& modules);
+
+  // Forgets the walks of minidumps listing the module.  Call this when the
+  // module's symbols change.
+  void InvalidateModule(const string& debug_file,
+                        const string& debug_identifier);
+
+  // Forgets every walk.
+  void Clear();
+
+  Stats GetStats() const;
+
+ private:
+  struct Entry {
+    string key;
+    size_t hash;
+    std::shared_ptr<const Walk> walk;
+    std::shared_ptr<const ModuleSet> modules;
+    size_t memory_usage;
+  };
+  typedef std::list<Entry> EntryList;
+
+  // Unlinks entry.  lock_ must be held.
+  void Erase(EntryList::iterator entry);
+
+  size_t memory_budget_;
+  size_t memory_usage_;
+
+  // Entries from the most to the least recently used, and indexed by the
+  // hash of their key, which can be as large as a stack.
+  EntryList entries_;
+  std::unordered_multimap<size_t, EntryList::iterator> index_;
+
+  uint64_t hits_;
+  uint64_t misses_;
+  uint64_t invalidations_;
+  uint64_t evictions_;
+
+  // Guards everything above.
+  mutable std::mutex lock_;
+
+  StackWalkCache(const StackWalkCache&) = delete;
+  void operator=(const StackWalkCache&) = delete;
+};
+
+}  // namespace google_breakpad
+
+#endif  // GOOGLE_BREAKPAD_PROCESSOR_STACK_WALK_CACHE_H__
@@ -40,8 +40,12 @@
 #ifndef GOOGLE_BREAKPAD_PROCESSOR_STACKWALKER_H__
 #define GOOGLE_BREAKPAD_PROCESSOR_STACKWALKER_H__
 
+#include <algorithm>
+#include <chrono>
 #include <set>
 #include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include "common/using_std_string.h"
@@ -54,7 +58,10 @@ namespace google_breakpad {
 
 class CallStack;
 class DumpContext;
+class EhFrameUnwindTables;
+class WindowsUnwindTables;
 class StackFrameSymbolizer;
+class TerminalFrames;
 
 using std::set;
 using std::vector;
@@ -80,6 +87,19 @@ class Stackwalker {
             vector<const CodeModule*>* modules_without_symbols,
             vector<const CodeModule*>* modules_with_corrupt_symbols);
 
+  // Populates the given CallStack as Walk does, but with the frames of an
+  // earlier walk of the same stack instead of walking it again.  frames
+  // holds the instruction and trust of each frame the earlier walk found,
+  // innermost first and not counting inlined frames.  The context frame is
+  // taken from the context, registers and all; the registers of the other
+  // frames are not known.  The frames are symbolized, and the modules
+  // without symbols or with corrupt symbols noted, as Walk does.  Returns
+  // false if the symbolizer was interrupted.
+  bool Resymbolize(const vector<StackFrame>& frames,
+                   CallStack* stack,
+                   vector<const CodeModule*>* modules_without_symbols,
+                   vector<const CodeModule*>* modules_with_corrupt_symbols);
+
   // Returns a new concrete subclass suitable for the CPU that a stack was
   // generated on, according to the CPU type indicated by the context
   // argument.  If no suitable concrete subclass exists, returns NULL.
@@ -102,6 +122,57 @@ class Stackwalker {
     max_frames_scanned_ = max_frames_scanned;
   }
 
+  // Makes the AMD64 and ARM64 walkers follow frame pointer chains without
+  // looking for unwind information, as long as each step moves up the stack
+  // and returns into a module, and symbolize the frames once the whole
+  // stack is walked.  This is only correct for code built with frame
+  // pointers in every function.  The context frame is still unwound
+  // normally, since it may have stopped in a prologue, an epilogue or a
+  // leaf function.  Off by default.
+  static void set_trust_frame_pointers(bool trust_frame_pointers) {
+    trust_frame_pointers_ = trust_frame_pointers;
+  }
+  static bool trust_frame_pointers() { return trust_frame_pointers_; }
+
+  // Stops Walk once deadline has passed, keeping the frames walked so far
+  // and marking the CallStack as truncated.  There is no deadline by
+  // default.
+  void set_deadline(std::chrono::steady_clock::time_point deadline) {
+    deadline_ = deadline;
+  }
+
+  // Fills in the function and source line information of only the first
+  // symbolized_frame_limit frames that Walk finds, not counting inlined
+  // frames.  The unwind information of the modules containing later frames
+  // is still loaded, and those frames' modules are still set; see
+  // StackFrameSymbolizer::FillModuleInfo.  Every frame is symbolized by
+  // default.
+  void set_symbolized_frame_limit(size_t symbolized_frame_limit) {
+    symbolized_frame_limit_ = symbolized_frame_limit;
+  }
+
+  // Stops Walk after the first frame in a function that terminal_frames
+  // lists for the minidump's system, marking the CallStack as ended at a
+  // terminal frame; see terminal_frames.h.  NULL, the default, for none.
+  // The list must outlive the walk.
+  void set_terminal_frames(const TerminalFrames* terminal_frames) {
+    terminal_frames_ = terminal_frames;
+  }
+
+  // Sets the unwind tables of the process's x64 Windows images, which the
+  // AMD64 walker uses for frames that no STACK CFI covers, or NULL, the
+  // default, for none.  The tables must outlive the walk.
+  void set_windows_unwind_tables(WindowsUnwindTables* windows_unwind_tables) {
+    windows_unwind_tables_ = windows_unwind_tables;
+  }
+
+  // Sets the .eh_frame unwind tables of the process's Linux images, which
+  // the AMD64 and ARM64 walkers use for frames that no STACK CFI covers,
+  // or NULL, the default, for none.  The tables must outlive the walk.
+  void set_eh_frame_unwind_tables(EhFrameUnwindTables* unwind_tables) {
+    eh_frame_unwind_tables_ = unwind_tables;
+  }
+
  protected:
   // system_info identifies the operating system, NULL or empty if unknown.
   // memory identifies a MemoryRegion that provides the stack memory
@@ -127,6 +198,28 @@ class Stackwalker {
   // Returns false otherwise.
   bool InstructionAddressSeemsValid(uint64_t address) const;
 
+  // Returns true if address falls within the address range of one of the
+  // loaded modules.  This is a cheap necessary condition for
+  // InstructionAddressSeemsValid, checked against a sorted table of module
+  // ranges built on first use, so that stack scanning can reject most
+  // stack words without a module lookup.
+  bool AddressInModuleRanges(uint64_t address);
+
+  // For walkers following frame pointers with trust_frame_pointers() set:
+  // whether the step from the frame whose frame pointer is callee_fp to a
+  // caller whose frame pointer is caller_fp, returning to caller_pc, can be
+  // taken without looking for unwind information.  The frame pointer must
+  // move up the stack, or be zero at the end of the chain, and caller_pc
+  // must be in a module.
+  bool TrustedFramePointerStep(uint64_t callee_fp,
+                               uint64_t caller_fp,
+                               uint64_t caller_pc);
+
+  // Sets frame's module and loads the module's unwind information, for
+  // walkers that fall back to unwind information for a frame that
+  // trust_frame_pointers() left unsymbolized.
+  void FillModuleInfo(StackFrame* frame);
+
   // Checks whether we should stop the stack trace.
   // (either we reached the end-of-stack or we detected a
   //  broken callstack invariant)
@@ -168,22 +261,45 @@ class Stackwalker {
                             InstructionType* location_found,
                             InstructionType* ip_found,
                             int searchwords) {
-    for (InstructionType location = location_start;
-         location <= location_start + searchwords * sizeof(InstructionType);
-         location += sizeof(InstructionType)) {
-      InstructionType ip;
-      if (!memory_->GetMemoryAtAddress(location, &ip))
+    // Stack words are read a chunk at a time, with one bounds check per
+    // chunk, up to the end of the stack memory.
+    const size_t kChunkWords = 32;
+    InstructionType words[kChunkWords];
+    const uint64_t memory_base = memory_->GetBase();
+    const uint64_t memory_end = memory_base + memory_->GetSize();
+    const InstructionType location_end =
+        location_start + searchwords * sizeof(InstructionType);
+    InstructionType location = location_start;
+    while (location <= location_end && location >= memory_base &&
+           location < memory_end) {
+      size_t word_count = static_cast<size_t>(std::min<uint64_t>(
+          std::min<uint64_t>((location_end - location) /
+                                 sizeof(InstructionType) + 1,
+                             (memory_end - location) /
+                                 sizeof(InstructionType)),
+          kChunkWords));
+      if (word_count == 0 ||
+          !memory_->GetMemoryRangeAtAddress(location, word_count, words)) {
         break;
+      }
 
-      // The return address points to the instruction after a call. If the
-      // caller was a no return function, this might point past the end of the
-      // function. Subtract one from the instruction pointer so it points into
-      // the call instruction instead.
-      if (modules_ && modules_->GetModuleForAddress(ip  - 1) &&
-          InstructionAddressSeemsValid(ip - 1)) {
-        *ip_found = ip;
-        *location_found = location;
-        return true;
+      for (size_t i = 0; i < word_count;
+           ++i, location += sizeof(InstructionType)) {
+        InstructionType ip = words[i];
+
+        // The return address points to the instruction after a call. If the
+        // caller was a no return function, this might point past the end of
+        // the function. Subtract one from the instruction pointer so it
+        // points into the call instruction instead.  Only loaded modules
+        // can hold a return address, so a word that misses all of them is
+        // rejected without consulting unloaded_modules_.
+        if (modules_ && AddressInModuleRanges(ip - 1) &&
+            modules_->GetModuleForAddress(ip - 1) &&
+            InstructionAddressSeemsValid(ip - 1)) {
+          *ip_found = ip;
+          *location_found = location;
+          return true;
+        }
       }
     }
     // nothing found
@@ -211,6 +327,17 @@ class Stackwalker {
   // The StackFrameSymbolizer implementation.
   StackFrameSymbolizer* frame_symbolizer_;
 
+  // Whether Walk leaves frames unsymbolized until the whole stack is
+  // walked.  Walkers that set this must call FillModuleInfo on a frame
+  // before looking up its unwind information.
+  bool symbolize_after_walk_;
+
+  // The unwind tables of x64 Windows images, or NULL.
+  WindowsUnwindTables* windows_unwind_tables_;
+
+  // The .eh_frame unwind tables of Linux images, or NULL.
+  EhFrameUnwindTables* eh_frame_unwind_tables_;
+
  private:
   // Obtains the context frame, the innermost called procedure in a stack
   // trace.  Returns NULL on failure.  GetContextFrame allocates a new
@@ -238,6 +365,29 @@ class Stackwalker {
   virtual StackFrame* GetCallerFrame(const CallStack* stack,
                                      bool stack_scan_allowed) = 0;
 
+  // Symbolizes the frames of stack, which holds no inlined frames yet,
+  // inserting the frames inlined into each before it.  Returns false if
+  // the symbolizer was interrupted, leaving the frames not yet symbolized
+  // at the end of stack.
+  bool SymbolizeFrames(CallStack* stack,
+                       vector<const CodeModule*>* modules_without_symbols,
+                       vector<const CodeModule*>* modules_with_corrupt_symbols);
+
+  // Symbolizes frame, the frame_index'th non-inlined frame Walk found,
+  // adding the frames inlined into it to inlined_frames and noting its
+  // module in modules_without_symbols or modules_with_corrupt_symbols if
+  // need be.  Returns false if the symbolizer was interrupted.
+  bool SymbolizeWalkedFrame(
+      StackFrame* frame,
+      size_t frame_index,
+      std::deque<std::unique_ptr<StackFrame>>* inlined_frames,
+      vector<const CodeModule*>* modules_without_symbols,
+      vector<const CodeModule*>* modules_with_corrupt_symbols);
+
+  // Returns true if frame, once symbolized, is in a function listed by
+  // terminal_frames_.
+  bool IsTerminalFrame(const StackFrame& frame) const;
+
   // The maximum number of frames Stackwalker will walk through.
   // This defaults to 1024 to prevent infinite loops.
   static uint32_t max_frames_;
@@ -252,6 +402,29 @@ class Stackwalker {
   // disable or limit it is helpful in cases where unwind performance is
   // important.  This defaults to 1024, the same as max_frames_.
   static uint32_t max_frames_scanned_;
+
+  // Whether frame pointer chains are followed without unwind information.
+  static bool trust_frame_pointers_;
+
+  // When Walk stops, or time_point::max() for no deadline.
+  std::chrono::steady_clock::time_point deadline_;
+
+  // How many frames Walk symbolizes fully.
+  size_t symbolized_frame_limit_;
+
+  // The functions after which Walk stops, or NULL.
+  const TerminalFrames* terminal_frames_;
+
+  // The [base, end) address ranges of modules_, sorted and with overlapping
+  // ranges merged, for AddressInModuleRanges.  Built on first use.
+  vector<std::pair<uint64_t, uint64_t> > module_ranges_;
+  bool module_ranges_built_;
+
+  // The modules in the lists passed to the current Walk, so that a module
+  // is looked for among them in constant time on each frame that couldn't
+  // be symbolized.
+  std::unordered_set<const CodeModule*> modules_without_symbols_set_;
+  std::unordered_set<const CodeModule*> modules_with_corrupt_symbols_set_;
 };
 
 }  // namespace google_breakpad
@@ -0,0 +1,132 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// symbol_buffer.h: The symbol data of one module, shared by reference.
+//
+// A SymbolSupplier hands symbol data to the stack walker in a SymbolBuffer,
+// and a SourceLineResolver whose modules refer to the data as long as they
+// are loaded keeps a reference to the buffer instead of a copy.  The data
+// is freed, or unmapped, when the last reference goes away, so however it
+// travels it is in memory only once.
+//
+// Lookups in a large module touch its symbol data all over, and miss the
+// TLB more often than not.  A buffer copied with CopyToHugePages(), or
+// mapped from a file on hugetlbfs, is backed by 2 MB pages instead, so
+// that a few TLB entries cover the whole module.
+
+#ifndef GOOGLE_BREAKPAD_PROCESSOR_SYMBOL_BUFFER_H__
+#define GOOGLE_BREAKPAD_PROCESSOR_SYMBOL_BUFFER_H__
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+
+#include "common/using_std_string.h"
+
+namespace google_breakpad {
+
+class SymbolBuffer {
+ public:
+  // The size of the huge pages CopyToHugePages() asks for.
+  static const size_t kHugePageSize = 2 * 1024 * 1024;
+
+  SymbolBuffer(const SymbolBuffer&) = delete;
+  void operator=(const SymbolBuffer&) = delete;
+  ~SymbolBuffer();
+
+  // Takes ownership of size bytes at data, allocated with new[].
+  static std::shared_ptr<SymbolBuffer> AdoptArray(char* data, size_t size);
+
+  // Takes the contents of *data, leaving it empty.  The buffer holds the
+  // contents followed by a null terminator, which size() counts, like the
+  // buffers GetCStringSymbolData returns.
+  static std::shared_ptr<SymbolBuffer> AdoptString(string* data);
+
+  // Maps file_name into memory copy-on-write: a resolver may write to the
+  // buffer, but pages it only reads are shared with every other mapping of
+  // the file.  Returns NULL if the file is empty or cannot be mapped.
+  static std::shared_ptr<SymbolBuffer> MapFile(const string& file_name);
+
+  // Returns a copy of buffer in anonymous memory aligned to kHugePageSize,
+  // which the system is asked to back with transparent huge pages
+  // (MADV_HUGEPAGE); or buffer itself if it is already backed by huge
+  // pages, or if the memory can't be mapped.  The copy is private, so a
+  // mapped file's pages are no longer shared with other processes.
+  static std::shared_ptr<SymbolBuffer> CopyToHugePages(
+      const std::shared_ptr<SymbolBuffer>& buffer);
+
+  // Refers to size bytes at data without owning them.  Whoever does must
+  // keep them alive for as long as the buffer is in use.
+  static std::shared_ptr<SymbolBuffer> Borrow(char* data, size_t size);
+
+  // Tells the system that a mapped buffer is about to be read once from
+  // front to back, as a text symbol file is parsed, so that it reads ahead
+  // further and frees pages sooner.  Does nothing to other buffers.
+  void AdviseSequential() const;
+
+  // Sets resident_size to how many bytes of the buffer are in memory, and
+  // huge_page_count to how many huge pages back it, as far as the system
+  // reports: huge pages are only counted on Linux, and only for buffers
+  // made by CopyToHugePages() or MapFile(), which have mappings of their
+  // own.
+  void GetResidency(size_t* resident_size, size_t* huge_page_count) const;
+
+  char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  // True for a buffer copied to huge pages, or mapped from hugetlbfs.
+  bool huge_pages() const { return huge_pages_; }
+
+  // True for a buffer made by Borrow.
+  bool borrowed() const { return storage_ == STORAGE_BORROWED; }
+
+ private:
+  enum Storage {
+    STORAGE_ARRAY,       // data_ was allocated with new[].
+    STORAGE_STRING,      // data_ is string_'s contents.
+    STORAGE_MAPPING,     // data_ was mapped with mmap().
+    STORAGE_HUGE_PAGES,  // data_ was mapped by CopyToHugePages().
+    STORAGE_BORROWED     // data_ belongs to someone else.
+  };
+
+  SymbolBuffer(char* data, size_t size, Storage storage);
+
+  char* data_;
+  size_t size_;
+  Storage storage_;
+  string string_;
+  // The length of the mapping at data_, which may be more than size_, for
+  // STORAGE_MAPPING and STORAGE_HUGE_PAGES.
+  size_t mapping_size_;
+  bool huge_pages_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // GOOGLE_BREAKPAD_PROCESSOR_SYMBOL_BUFFER_H__
@@ -32,8 +32,13 @@
 #ifndef GOOGLE_BREAKPAD_PROCESSOR_SYMBOL_SUPPLIER_H__
 #define GOOGLE_BREAKPAD_PROCESSOR_SYMBOL_SUPPLIER_H__
 
+#include <stddef.h>
+
+#include <memory>
 #include <string>
+
 #include "common/using_std_string.h"
+#include "google_breakpad/processor/symbol_buffer.h"
 
 namespace google_breakpad {
 
@@ -91,6 +96,63 @@ class SymbolSupplier {
 
   // Frees the data buffer allocated for the module in GetCStringSymbolData.
   virtual void FreeSymbolData(const CodeModule* module) = 0;
+
+  // Same as GetCStringSymbolData, except places the symbol data in a
+  // SymbolBuffer, which a resolver can keep a reference to instead of
+  // copying the data.  Unless the buffer is borrowed(), it frees the data
+  // when the last reference to it goes away, and FreeSymbolData must not
+  // be called for it.  The default implementation borrows the buffer
+  // GetCStringSymbolData returns, which FreeSymbolData frees as usual.
+  virtual SymbolResult GetSymbolBuffer(
+      const CodeModule* module,
+      const SystemInfo* system_info,
+      string* symbol_file,
+      std::shared_ptr<SymbolBuffer>* symbol_buffer) {
+    char* symbol_data = NULL;
+    size_t symbol_data_size = 0;
+    SymbolResult result = GetCStringSymbolData(
+        module, system_info, symbol_file, &symbol_data, &symbol_data_size);
+    symbol_buffer->reset();
+    if (result == FOUND)
+      *symbol_buffer = SymbolBuffer::Borrow(symbol_data, symbol_data_size);
+    return result;
+  }
+
+  // Receives the result of GetCStringSymbolDataAsync.
+  class SymbolDataCallback {
+   public:
+    virtual ~SymbolDataCallback() {}
+
+    // Called once when a request completes, with the values that
+    // GetCStringSymbolData would have returned.  May be called on any
+    // thread.  The data buffer is freed by FreeSymbolData, as for
+    // GetCStringSymbolData.
+    virtual void OnSymbolData(const CodeModule* module,
+                              SymbolResult result,
+                              const string& symbol_file,
+                              char* symbol_data,
+                              size_t symbol_data_size) = 0;
+  };
+
+  // Starts fetching the symbol data for module as GetCStringSymbolData
+  // does, and returns without waiting for it.  callback is called once with
+  // the result, possibly before this returns, and must stay alive until
+  // then.  Several requests may be outstanding at once, so a supplier that
+  // fetches symbols from a remote store can overlap their latency without a
+  // thread per request.  FreeSymbolData may be called while other requests
+  // are outstanding.  The default implementation calls GetCStringSymbolData
+  // and completes the request before returning.
+  virtual void GetCStringSymbolDataAsync(const CodeModule* module,
+                                         const SystemInfo* system_info,
+                                         SymbolDataCallback* callback) {
+    string symbol_file;
+    char* symbol_data = NULL;
+    size_t symbol_data_size = 0;
+    SymbolResult result = GetCStringSymbolData(
+        module, system_info, &symbol_file, &symbol_data, &symbol_data_size);
+    callback->OnSymbolData(module, result, symbol_file, symbol_data,
+                           symbol_data_size);
+  }
 };
 
 }  // namespace google_breakpad
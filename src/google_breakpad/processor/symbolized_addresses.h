@@ -0,0 +1,125 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// symbolized_addresses.h: Symbols for batches of addresses, in columns.
+//
+// SourceLineResolverInterface::SymbolizeAddresses() looks up many addresses
+// in one module at once, and appends what it finds for each address to the
+// columns of a SymbolizedAddresses, one element per column per address.
+// Function and file names are stored once each, in a table of distinct
+// names, and the columns hold their ids.  The table is kept when the
+// columns are cleared, so a caller reusing one object for many batches gets
+// the same id for a name every time.
+
+#ifndef GOOGLE_BREAKPAD_PROCESSOR_SYMBOLIZED_ADDRESSES_H__
+#define GOOGLE_BREAKPAD_PROCESSOR_SYMBOLIZED_ADDRESSES_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "common/using_std_string.h"
+
+namespace google_breakpad {
+
+class SymbolizedAddresses {
+ public:
+  // The id in the name columns of an address without a name.
+  static constexpr uint32_t kNoName = UINT32_MAX;
+
+  SymbolizedAddresses() {}
+  SymbolizedAddresses(const SymbolizedAddresses&) = delete;
+  void operator=(const SymbolizedAddresses&) = delete;
+
+  // The name of the function, or public symbol, covering each address, and
+  // its module-relative address; 0 for an address with no symbol.
+  std::vector<uint32_t> function_name_ids;
+  std::vector<uint64_t> function_bases;
+
+  // The source file and line of each address, as FillSourceLineInfo()
+  // gives them for the outermost frame at the address: within an inlined
+  // call, the position of the outermost call.  Line 0 for an address with
+  // no line record.
+  std::vector<uint32_t> file_name_ids;
+  std::vector<int32_t> lines;
+
+  // The inlined frames at each address run from inline_begins[i] up to
+  // inline_begins[i + 1], or the end of the inline columns for the last
+  // address, innermost first, as FillSourceLineInfo() adds them to its
+  // inlined_frames.  Each has the name of the inlined function, its
+  // module-relative base address, and the source position within it.
+  std::vector<uint32_t> inline_begins;
+  std::vector<uint32_t> inline_function_name_ids;
+  std::vector<uint64_t> inline_function_bases;
+  std::vector<uint32_t> inline_file_name_ids;
+  std::vector<int32_t> inline_lines;
+
+  // The number of addresses in the columns.
+  size_t size() const { return function_name_ids.size(); }
+
+  // Returns the name with the given id, which must not be kNoName.
+  const string& name(uint32_t id) const { return names_[id]; }
+  size_t name_count() const { return names_.size(); }
+
+  // Returns the id of the length bytes at name, adding them to the names
+  // the first time they are seen.
+  uint32_t InternName(const char* name, size_t length) {
+    string key(name, length);
+    auto it = name_ids_.find(key);
+    if (it != name_ids_.end())
+      return it->second;
+    uint32_t id = static_cast<uint32_t>(names_.size());
+    names_.push_back(key);
+    name_ids_.emplace(std::move(key), id);
+    return id;
+  }
+
+  // Empties the columns, keeping the names.
+  void ClearColumns() {
+    function_name_ids.clear();
+    function_bases.clear();
+    file_name_ids.clear();
+    lines.clear();
+    inline_begins.clear();
+    inline_function_name_ids.clear();
+    inline_function_bases.clear();
+    inline_file_name_ids.clear();
+    inline_lines.clear();
+  }
+
+ private:
+  std::vector<string> names_;
+  std::unordered_map<string, uint32_t> name_ids_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // GOOGLE_BREAKPAD_PROCESSOR_SYMBOLIZED_ADDRESSES_H__
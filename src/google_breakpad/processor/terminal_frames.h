@@ -0,0 +1,109 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// terminal_frames.h: Functions at which stack walks stop.
+//
+// Most thread stacks end in a well-known function that starts threads or
+// the program, such as start_thread or clone on Linux, thread_start on
+// macOS, or RtlUserThreadStart on Windows.  There are no real frames past
+// it, but a Stackwalker keeps trying CFI, frame pointers and stack scanning
+// until the stack memory or the scan limits run out, and often finds
+// garbage frames.  A Stackwalker given a TerminalFrames with
+// set_terminal_frames() stops after the first frame whose function is
+// listed for the minidump's system, and marks the CallStack as having
+// ended at a terminal frame.
+//
+// Functions are listed by name, as symbols give them, for a system named
+// as SystemInfo::os_short does, or for any system.  A function may be
+// limited to the module whose code file has a given base name, compared
+// without regard to case.  AddDefaults() lists the usual functions for each
+// system, and Read() adds more from a file holding one per line, in the
+// form
+//
+//   [<module>!]<function>
+//
+// for any system.  Blank lines and lines beginning with '#' are ignored.
+//
+// Frames are matched once they are symbolized, so frames past
+// Stackwalker::set_symbolized_frame_limit(), which have no function names,
+// never end a walk.
+
+#ifndef GOOGLE_BREAKPAD_PROCESSOR_TERMINAL_FRAMES_H__
+#define GOOGLE_BREAKPAD_PROCESSOR_TERMINAL_FRAMES_H__
+
+#include <string>
+#include <unordered_map>
+
+#include "common/using_std_string.h"
+
+namespace google_breakpad {
+
+struct StackFrame;
+
+class TerminalFrames {
+ public:
+  TerminalFrames() {}
+
+  // Lists the functions that start threads and programs on Linux, Android,
+  // macOS, iOS and Windows.
+  void AddDefaults();
+
+  // Lists function as terminal in minidumps from os, or from any system if
+  // os is empty, in the module whose code file's base name is module, or in
+  // any module if module is empty.
+  void Add(const string& os, const string& module, const string& function);
+
+  // Lists the functions in the file at path, in the form described above.
+  // Returns false if the file cannot be read.
+  bool Read(const string& path);
+
+  // Returns true if frame, from a minidump from os, is in a listed
+  // function.
+  bool IsTerminal(const string& os, const StackFrame& frame) const;
+
+  bool empty() const { return functions_.empty(); }
+
+  // Returns a string that is the same for two TerminalFrames exactly when
+  // they list the same functions, whatever order they were added in, so
+  // that results that depend on them can be cached by what they list.
+  string Key() const;
+
+ private:
+  // Where a listed function is terminal.  module is in lower case.
+  struct Entry {
+    string os;
+    string module;
+  };
+
+  // Entries by function name.
+  std::unordered_multimap<string, Entry> functions_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // GOOGLE_BREAKPAD_PROCESSOR_TERMINAL_FRAMES_H__
@@ -0,0 +1,139 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// unsymbolized_walk.h: The stack walks of a processed minidump, without
+// their symbols.
+//
+// Symbols for some modules, system and third-party libraries especially,
+// often arrive after the minidumps that need them were processed.  The
+// frames the walks found rarely change once they do: only a module that
+// had no symbols, and so no CFI, when a stack was walked through it can
+// change how the stack unwinds.  An UnsymbolizedWalk recorded from a
+// ProcessState keeps what MinidumpProcessor::Resymbolize needs to rebuild
+// its stacks with new symbols: each frame's module, offset and trust, and
+// the modules that had no symbols.
+//
+// The text form holds one MODULE record per module, by index, with its
+// base address, size, debug identifier and debug file; a NOCFI record for
+// each module that had no symbols; and a THREAD record for each thread,
+// with its ID and whether its walk was complete, followed by a FRAME record
+// for each of its frames, innermost first and without inlined frames, with
+// its trust, its module's index or -1 if it is in no module, and its
+// offset in the module or its address:
+//
+//   UNSYMBOLIZEDWALK
+//   MODULE <index> <base address> <size> <debug identifier> <debug file>
+//   NOCFI <index>
+//   THREAD <thread id> <complete>
+//   FRAME <trust> <index> <offset>
+//
+// Indexes and trust are decimal, and the other numbers hexadecimal.
+// Module i of a minidump's module list is index i, and module i of its
+// unloaded module list is the loaded module count plus i.
+
+#ifndef GOOGLE_BREAKPAD_PROCESSOR_UNSYMBOLIZED_WALK_H__
+#define GOOGLE_BREAKPAD_PROCESSOR_UNSYMBOLIZED_WALK_H__
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/stack_frame.h"
+
+namespace google_breakpad {
+
+class ProcessState;
+
+using std::vector;
+
+class UnsymbolizedWalk {
+ public:
+  static const int kNoModule = -1;
+
+  struct Module {
+    uint64_t base_address;
+    uint64_t size;
+    string debug_file;
+    string debug_identifier;
+  };
+
+  struct Frame {
+    StackFrame::FrameTrust trust;
+    // The index of the frame's module, or kNoModule.
+    int module;
+    // The frame's instruction, relative to its module's base address if
+    // it has a module.
+    uint64_t offset;
+  };
+
+  struct Thread {
+    uint32_t thread_id;
+    // False if the walk was cut short by a time limit, or deferred and
+    // never done, so that the thread has to be walked again.
+    bool complete;
+    vector<Frame> frames;
+  };
+
+  UnsymbolizedWalk() {}
+
+  // Records the walks of process_state's threads, replacing this walk's
+  // contents.
+  void Record(const ProcessState& process_state);
+
+  // Returns the walk in the text form described above.
+  string Serialize() const;
+
+  // Reads the text form of a walk, replacing this walk's contents.
+  // Returns false, leaving the walk empty, if walk_data is not a
+  // well-formed walk.
+  bool Parse(const string& walk_data);
+
+  // Empties the walk.
+  void Clear();
+
+  const vector<Module>& modules() const { return modules_; }
+  // The indexes of the modules that had no symbols, in ascending order.
+  const vector<int>& modules_without_cfi() const {
+    return modules_without_cfi_;
+  }
+  const vector<Thread>& threads() const { return threads_; }
+
+  // Returns true if the module at index had no symbols.
+  bool ModuleLackedCFI(int index) const;
+
+ private:
+  vector<Module> modules_;
+  vector<int> modules_without_cfi_;
+  vector<Thread> threads_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // GOOGLE_BREAKPAD_PROCESSOR_UNSYMBOLIZED_WALK_H__
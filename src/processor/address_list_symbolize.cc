@@ -0,0 +1,168 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// address_list_symbolize.cc: Print the symbols for stacks of module-relative
+// addresses.
+//
+// Reads stacks in the format described in address_list_symbolizer.h from a
+// file, or from standard input, and writes each frame's function and
+// source line, looked up in the symbols under the given symbol paths, to
+// standard output as the stacks are read.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include "common/path_helper.h"
+#include "common/scoped_ptr.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/stack_frame_symbolizer.h"
+#include "processor/address_list_symbolizer.h"
+#include "processor/simple_symbol_supplier.h"
+
+namespace {
+
+struct Options {
+  size_t batch_frames;
+
+  string input_file;
+  std::vector<string> symbol_paths;
+};
+
+using google_breakpad::AddressListSymbolizer;
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::scoped_ptr;
+using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::StackFrameSymbolizer;
+
+}  // namespace
+
+static void Usage(int argc, const char *argv[], bool error) {
+  fprintf(error ? stderr : stdout,
+          "Usage: %s [options] <input-file> [symbol-path ...]\n"
+          "\n"
+          "Output the symbols for stacks of module-relative addresses read\n"
+          "from input-file, or from standard input if it is -.  Each line\n"
+          "of input is one of:\n"
+          "\n"
+          "  MODULE <id> <debug-file> <debug-identifier> [<code-file>]\n"
+          "  STACK [<label>]\n"
+          "  <id> <hex-offset>\n"
+          "\n"
+          "and each frame is output as\n"
+          "\n"
+          "  label|frame|module|function|file|line|offset\n"
+          "\n"
+          "Options:\n"
+          "\n"
+          "  -b <n>     Look up frames in batches of n (default %zu)\n",
+          google_breakpad::BaseName(argv[0]).c_str(),
+          AddressListSymbolizer::kDefaultBatchFrames);
+}
+
+static void SetupOptions(int argc, const char *argv[], Options* options) {
+  int ch;
+
+  options->batch_frames = AddressListSymbolizer::kDefaultBatchFrames;
+
+  while ((ch = getopt(argc, (char * const*)argv, "b:h")) != -1) {
+    switch (ch) {
+      case 'h':
+        Usage(argc, argv, false);
+        exit(0);
+        break;
+
+      case 'b': {
+        int batch_frames = atoi(optarg);
+        if (batch_frames < 1) {
+          fprintf(stderr, "%s: Invalid batch size: %s\n", argv[0], optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        options->batch_frames = batch_frames;
+        break;
+      }
+
+      case '?':
+        Usage(argc, argv, true);
+        exit(1);
+        break;
+    }
+  }
+
+  if ((argc - optind) == 0) {
+    fprintf(stderr, "%s: Missing input file\n", argv[0]);
+    Usage(argc, argv, true);
+    exit(1);
+  }
+
+  options->input_file = argv[optind];
+
+  for (int argi = optind + 1; argi < argc; ++argi)
+    options->symbol_paths.push_back(argv[argi]);
+}
+
+int main(int argc, const char* argv[]) {
+  Options options;
+  SetupOptions(argc, argv, &options);
+
+  FILE* input = stdin;
+  if (options.input_file != "-") {
+    input = fopen(options.input_file.c_str(), "r");
+    if (!input) {
+      fprintf(stderr, "%s: Could not open %s: %s\n", argv[0],
+              options.input_file.c_str(), strerror(errno));
+      return 1;
+    }
+  }
+
+  scoped_ptr<SimpleSymbolSupplier> symbol_supplier;
+  if (!options.symbol_paths.empty()) {
+    symbol_supplier.reset(new SimpleSymbolSupplier(options.symbol_paths));
+  }
+
+  BasicSourceLineResolver resolver;
+  StackFrameSymbolizer frame_symbolizer(symbol_supplier.get(), &resolver);
+  AddressListSymbolizer symbolizer(&frame_symbolizer);
+  symbolizer.set_batch_frames(options.batch_frames);
+  bool succeeded = symbolizer.Symbolize(input, stdout);
+
+  if (input != stdin)
+    fclose(input);
+  return succeeded ? 0 : 1;
+}
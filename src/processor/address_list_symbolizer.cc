@@ -0,0 +1,364 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// address_list_symbolizer.cc: Symbolizes streams of stacks of
+// module-relative addresses.
+//
+// See address_list_symbolizer.h for documentation.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "processor/address_list_symbolizer.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <deque>
+#include <sstream>
+
+#include "google_breakpad/processor/source_line_resolver_interface.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "google_breakpad/processor/stack_frame_symbolizer.h"
+#include "processor/basic_code_module.h"
+#include "processor/logging.h"
+#include "processor/pathname_stripper.h"
+
+namespace google_breakpad {
+
+namespace {
+
+const char kOutputSeparator = '|';
+
+// Writes text to output without separators or line endings, which would
+// break up its line.
+void PrintStripped(FILE* output, const string& text) {
+  for (char c : text) {
+    if (c != kOutputSeparator && c != '\n' && c != '\r')
+      fputc(c, output);
+  }
+}
+
+// Appends what frame and inlined_frames hold to the columns of results, as
+// SymbolizeAddresses() would, for a resolver that can't look up addresses
+// in batches.
+void AppendFrame(const StackFrame& frame,
+                 const std::deque<std::unique_ptr<StackFrame>>& inlined_frames,
+                 SymbolizedAddresses* results) {
+  uint64_t module_base = frame.module->base_address();
+  results->function_name_ids.push_back(
+      frame.function_name.empty()
+          ? SymbolizedAddresses::kNoName
+          : results->InternName(frame.function_name.data(),
+                                frame.function_name.size()));
+  results->function_bases.push_back(
+      frame.function_name.empty() ? 0 : frame.function_base - module_base);
+  results->file_name_ids.push_back(
+      frame.source_file_name.empty()
+          ? SymbolizedAddresses::kNoName
+          : results->InternName(frame.source_file_name.data(),
+                                frame.source_file_name.size()));
+  results->lines.push_back(frame.source_line);
+  results->inline_begins.push_back(
+      static_cast<uint32_t>(results->inline_lines.size()));
+  for (const std::unique_ptr<StackFrame>& inlined : inlined_frames) {
+    results->inline_function_name_ids.push_back(results->InternName(
+        inlined->function_name.data(), inlined->function_name.size()));
+    results->inline_function_bases.push_back(inlined->function_base -
+                                             module_base);
+    results->inline_file_name_ids.push_back(
+        inlined->source_file_name.empty()
+            ? SymbolizedAddresses::kNoName
+            : results->InternName(inlined->source_file_name.data(),
+                                  inlined->source_file_name.size()));
+    results->inline_lines.push_back(inlined->source_line);
+  }
+}
+
+}  // namespace
+
+struct AddressListSymbolizer::Module {
+  Module(const string& debug_file,
+         const string& debug_identifier,
+         const string& code_file)
+      : code_module(new BasicCodeModule(
+            0, UINT64_MAX, code_file.empty() ? debug_file : code_file,
+            "" /* code_identifier */, debug_file, debug_identifier,
+            "" /* version */)),
+        name(PathnameStripper::File(code_module->code_file())),
+        fetched(false),
+        loaded(false),
+        symbolized(false) {}
+
+  // Based at 0, so that its addresses are the frames' offsets.
+  std::unique_ptr<BasicCodeModule> code_module;
+  string name;
+
+  // Whether the module's symbols have been looked for, and whether they
+  // were loaded.
+  bool fetched;
+  bool loaded;
+
+  // The distinct offsets of the buffered frames in the module, in
+  // increasing order, and whether what was found for them is in results.
+  std::vector<uint64_t> offsets;
+  bool symbolized;
+  SymbolizedAddresses results;
+};
+
+AddressListSymbolizer::AddressListSymbolizer(
+    StackFrameSymbolizer* frame_symbolizer)
+    : frame_symbolizer_(frame_symbolizer),
+      batch_frames_(kDefaultBatchFrames) {}
+
+AddressListSymbolizer::~AddressListSymbolizer() {}
+
+bool AddressListSymbolizer::Symbolize(FILE* input, FILE* output) {
+  bool succeeded = true;
+  string line;
+  char buffer[4096];
+  while (fgets(buffer, sizeof(buffer), input)) {
+    line.append(buffer);
+    if (line.back() != '\n' && !feof(input))
+      continue;
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+      line.pop_back();
+    succeeded = ReadLine(line, output) && succeeded;
+    line.clear();
+  }
+  return Flush(output) && succeeded;
+}
+
+bool AddressListSymbolizer::ReadLine(const string& line, FILE* output) {
+  std::istringstream fields(line);
+  string first;
+  if (!(fields >> first) || first[0] == '#')
+    return true;
+
+  if (first == "MODULE") {
+    string id, debug_file, debug_identifier, code_file;
+    if (!(fields >> id >> debug_file >> debug_identifier)) {
+      BPLOG(ERROR) << "Malformed MODULE line: " << line;
+      return false;
+    }
+    fields >> code_file;
+    // Buffered frames may still refer to a module being replaced.
+    std::unique_ptr<Module>& module = modules_[id];
+    if (module)
+      replaced_modules_.push_back(std::move(module));
+    module.reset(new Module(debug_file, debug_identifier, code_file));
+    return true;
+  }
+
+  if (first == "STACK") {
+    string label;
+    std::getline(fields >> std::ws, label);
+    while (!label.empty() && isspace(static_cast<unsigned char>(label.back())))
+      label.pop_back();
+    Stack stack = {label, frames_.size(), 0};
+    stacks_.push_back(stack);
+    return true;
+  }
+
+  string offset_text;
+  if (stacks_.empty() || !(fields >> offset_text)) {
+    BPLOG(ERROR) << "Malformed frame line: " << line;
+    return false;
+  }
+  char* end;
+  errno = 0;
+  uint64_t offset = strtoull(offset_text.c_str(), &end, 16);
+  if (errno || *end || end == offset_text.c_str()) {
+    BPLOG(ERROR) << "Malformed frame offset: " << line;
+    return false;
+  }
+  auto module = modules_.find(first);
+  if (module == modules_.end())
+    BPLOG(ERROR) << "Frame in undeclared module " << first;
+  Frame frame = {module == modules_.end() ? NULL : module->second.get(),
+                 offset, 0};
+  frames_.push_back(frame);
+
+  if (frames_.size() < batch_frames_)
+    return true;
+
+  Stack last = stacks_.back();
+  std::vector<Frame> last_frames;
+  if (stacks_.size() > 1) {
+    // Keep the stack being read whole for the next batch.
+    last_frames.assign(frames_.begin() + last.frame_begin, frames_.end());
+    frames_.resize(last.frame_begin);
+    stacks_.pop_back();
+  } else {
+    // The stack being read fills the batch by itself.  Write out what
+    // there is of it, and number the rest of its frames after those.
+    last.first_frame += frames_.size();
+  }
+  bool succeeded = Flush(output);
+  last.frame_begin = 0;
+  stacks_.push_back(last);
+  frames_ = std::move(last_frames);
+  return succeeded;
+}
+
+bool AddressListSymbolizer::Flush(FILE* output) {
+  std::vector<Module*> modules;
+  for (const Frame& frame : frames_) {
+    if (!frame.module)
+      continue;
+    if (frame.module->offsets.empty())
+      modules.push_back(frame.module);
+    frame.module->offsets.push_back(frame.offset);
+  }
+
+  bool succeeded = true;
+  for (Module* module : modules)
+    succeeded = SymbolizeModule(module) && succeeded;
+
+  for (Frame& frame : frames_) {
+    if (frame.module && frame.module->symbolized) {
+      const std::vector<uint64_t>& offsets = frame.module->offsets;
+      frame.result = std::lower_bound(offsets.begin(), offsets.end(),
+                                      frame.offset) - offsets.begin();
+    }
+  }
+  for (size_t i = 0; i < stacks_.size(); ++i) {
+    WriteStack(stacks_[i],
+               i + 1 < stacks_.size() ? stacks_[i + 1].frame_begin
+                                      : frames_.size(),
+               output);
+  }
+  fflush(output);
+
+  for (Module* module : modules) {
+    module->offsets.clear();
+    module->symbolized = false;
+    module->results.ClearColumns();
+  }
+  stacks_.clear();
+  replaced_modules_.clear();
+  frames_.clear();
+  return succeeded;
+}
+
+bool AddressListSymbolizer::SymbolizeModule(Module* module) {
+  std::vector<uint64_t>& offsets = module->offsets;
+  std::sort(offsets.begin(), offsets.end());
+  offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+
+  if (!module->fetched) {
+    StackFrameSymbolizer::SymbolizerResult result =
+        frame_symbolizer_->PrefetchModule(module->code_module.get(), NULL);
+    if (result == StackFrameSymbolizer::kInterrupt)
+      return false;
+    module->fetched = true;
+    module->loaded = result == StackFrameSymbolizer::kNoError ||
+                     result == StackFrameSymbolizer::kWarningCorruptSymbols;
+  }
+  if (!module->loaded)
+    return true;
+
+  SourceLineResolverInterface* resolver = frame_symbolizer_->resolver();
+  if (!resolver->SymbolizeAddresses(module->code_module.get(), offsets.data(),
+                                    offsets.size(), &module->results)) {
+    for (uint64_t offset : offsets) {
+      StackFrame frame;
+      frame.instruction = offset;
+      frame.module = module->code_module.get();
+      std::deque<std::unique_ptr<StackFrame>> inlined_frames;
+      resolver->FillSourceLineInfo(&frame, &inlined_frames);
+      AppendFrame(frame, inlined_frames, &module->results);
+    }
+  }
+  module->symbolized = true;
+  return true;
+}
+
+void AddressListSymbolizer::WriteStack(const Stack& stack,
+                                       size_t frame_end,
+                                       FILE* output) {
+  for (size_t i = stack.frame_begin; i < frame_end; ++i) {
+    const Frame& frame = frames_[i];
+    const Module* module = frame.module;
+    size_t frame_index = stack.first_frame + i - stack.frame_begin;
+    if (!module || !module->symbolized) {
+      PrintStripped(output, stack.label);
+      fprintf(output, "%c%zu%c", kOutputSeparator, frame_index,
+              kOutputSeparator);
+      if (module)
+        PrintStripped(output, module->name);
+      fprintf(output, "%c%c%c%c0x%" PRIx64 "\n", kOutputSeparator,
+              kOutputSeparator, kOutputSeparator, kOutputSeparator,
+              frame.offset);
+      continue;
+    }
+
+    const SymbolizedAddresses& results = module->results;
+    size_t inline_begin = results.inline_begins[frame.result];
+    size_t inline_end = frame.result + 1 < results.size()
+                            ? results.inline_begins[frame.result + 1]
+                            : results.inline_lines.size();
+    for (size_t j = inline_begin; j <= inline_end; ++j) {
+      bool outermost = j == inline_end;
+      uint32_t function_id = outermost
+                                 ? results.function_name_ids[frame.result]
+                                 : results.inline_function_name_ids[j];
+      uint64_t function_base = outermost
+                                   ? results.function_bases[frame.result]
+                                   : results.inline_function_bases[j];
+      uint32_t file_id = outermost ? results.file_name_ids[frame.result]
+                                   : results.inline_file_name_ids[j];
+      int line = outermost ? results.lines[frame.result]
+                           : results.inline_lines[j];
+
+      PrintStripped(output, stack.label);
+      fprintf(output, "%c%zu%c", kOutputSeparator, frame_index,
+              kOutputSeparator);
+      PrintStripped(output, module->name);
+      fputc(kOutputSeparator, output);
+      if (function_id != SymbolizedAddresses::kNoName)
+        PrintStripped(output, results.name(function_id));
+      fputc(kOutputSeparator, output);
+      if (file_id != SymbolizedAddresses::kNoName)
+        PrintStripped(output, results.name(file_id));
+      fputc(kOutputSeparator, output);
+      if (file_id != SymbolizedAddresses::kNoName)
+        fprintf(output, "%d", line);
+      fprintf(output, "%c0x%" PRIx64 "\n", kOutputSeparator,
+              function_id != SymbolizedAddresses::kNoName
+                  ? frame.offset - function_base
+                  : frame.offset);
+    }
+  }
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,160 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// address_list_symbolizer.h: Symbolizes streams of stacks of
+// module-relative addresses, such as those in perf samples, sanitizer logs
+// and profiles.
+//
+// The input is text, one record per line:
+//
+//   MODULE <id> <debug-file> <debug-identifier> [<code-file>]
+//   STACK [<label>]
+//   <id> <offset>
+//
+// A MODULE line names a module that later frames refer to by id, an
+// arbitrary word.  A STACK line starts a stack, and each following frame
+// line gives a frame's module and its hexadecimal offset in the module,
+// innermost frame first.  Blank lines and lines starting with # are
+// ignored.
+//
+// Each frame is written out as a line of |-separated fields, as
+// minidump_stackwalk's machine-readable output has them:
+//
+//   <label>|<frame>|<module>|<function>|<file>|<line>|<offset>
+//
+// where the offset is from the start of the function, if there is one, and
+// otherwise from the start of the module.  A frame within inlined calls is
+// preceded by a line for each inlined function, innermost first, with the
+// same frame number.
+//
+// Frames are buffered until enough have been read, and then the frames in
+// each module are looked up in one batch with
+// SourceLineResolverInterface::SymbolizeAddresses().  Symbols are fetched
+// and loaded through a StackFrameSymbolizer, so they can be shared with
+// other users of the same symbolizer, and a module whose symbols can't be
+// found is only looked for once.
+
+#ifndef PROCESSOR_ADDRESS_LIST_SYMBOLIZER_H__
+#define PROCESSOR_ADDRESS_LIST_SYMBOLIZER_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/symbolized_addresses.h"
+
+namespace google_breakpad {
+
+class BasicCodeModule;
+class StackFrameSymbolizer;
+
+class AddressListSymbolizer {
+ public:
+  // The number of frames buffered, by default, before they are looked up.
+  static const size_t kDefaultBatchFrames = 4096;
+
+  // frame_symbolizer must outlive this object.
+  explicit AddressListSymbolizer(StackFrameSymbolizer* frame_symbolizer);
+  ~AddressListSymbolizer();
+  AddressListSymbolizer(const AddressListSymbolizer&) = delete;
+  void operator=(const AddressListSymbolizer&) = delete;
+
+  // Sets how many frames are buffered before they are looked up and
+  // written out.  Larger batches share more lookups; smaller ones write
+  // each stack out sooner.
+  void set_batch_frames(size_t batch_frames) {
+    batch_frames_ = batch_frames ? batch_frames : 1;
+  }
+
+  // Reads records from input until its end, and writes the stacks in them
+  // to output.  Returns false if a line was malformed, in which case it is
+  // logged and skipped, or if fetching symbols was interrupted, in which
+  // case the frames that needed them are written out unsymbolized.
+  bool Symbolize(FILE* input, FILE* output);
+
+  // Handles one line of input, without its line ending, writing the
+  // buffered stacks to output once enough frames have been read.  Returns
+  // false as Symbolize() does.
+  bool ReadLine(const string& line, FILE* output);
+
+  // Looks up and writes out the buffered stacks, ending the one being read;
+  // frames read afterwards need a new STACK line.  Returns false if
+  // fetching symbols was interrupted.
+  bool Flush(FILE* output);
+
+ private:
+  struct Module;
+
+  // A frame read and not yet written out.
+  struct Frame {
+    // NULL for a frame in an undeclared module.
+    Module* module;
+    uint64_t offset;
+    // The index of the frame's offset in its module's results.
+    size_t result;
+  };
+
+  // A stack read and not yet written out, made of the frames from
+  // frame_begin up to the next stack's.  first_frame is the number of
+  // the stack's frames written out in earlier batches.
+  struct Stack {
+    string label;
+    size_t frame_begin;
+    size_t first_frame;
+  };
+
+  // Looks up the distinct offsets among the buffered frames in module, and
+  // points each frame at its result.  Returns false if fetching the
+  // module's symbols was interrupted.
+  bool SymbolizeModule(Module* module);
+
+  // Writes out the frames of stack, ending before frame_end.
+  void WriteStack(const Stack& stack, size_t frame_end, FILE* output);
+
+  StackFrameSymbolizer* frame_symbolizer_;
+  size_t batch_frames_;
+
+  // Declared modules, by id.
+  std::map<string, std::unique_ptr<Module>> modules_;
+  // Modules whose ids were declared again, kept for the buffered frames
+  // in them.
+  std::vector<std::unique_ptr<Module>> replaced_modules_;
+
+  std::vector<Stack> stacks_;
+  std::vector<Frame> frames_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_ADDRESS_LIST_SYMBOLIZER_H__
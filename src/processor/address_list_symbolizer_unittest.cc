@@ -0,0 +1,138 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// address_list_symbolizer_unittest.cc: Unit tests for the
+// AddressListSymbolizer class.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/stack_frame_symbolizer.h"
+#include "processor/address_list_symbolizer.h"
+#include "processor/simple_symbol_supplier.h"
+
+namespace {
+
+using google_breakpad::AddressListSymbolizer;
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::StackFrameSymbolizer;
+
+class AddressListSymbolizerTest : public ::testing::Test {
+ public:
+  AddressListSymbolizerTest()
+      : supplier_(string(getenv("srcdir") ? getenv("srcdir") : ".") +
+                  "/src/processor/testdata/symbols"),
+        frame_symbolizer_(&supplier_, &resolver_),
+        symbolizer_(&frame_symbolizer_) {}
+
+  // Runs the symbolizer over input, returning whether it succeeded, and
+  // its output in *output.
+  bool Symbolize(const string& input, string* output) {
+    FILE* input_file = fmemopen(const_cast<char*>(input.data()),
+                                input.size(), "r");
+    char* output_data = NULL;
+    size_t output_size = 0;
+    FILE* output_file = open_memstream(&output_data, &output_size);
+    bool succeeded = symbolizer_.Symbolize(input_file, output_file);
+    fclose(output_file);
+    fclose(input_file);
+    output->assign(output_data, output_size);
+    free(output_data);
+    return succeeded;
+  }
+
+  SimpleSymbolSupplier supplier_;
+  BasicSourceLineResolver resolver_;
+  StackFrameSymbolizer frame_symbolizer_;
+  AddressListSymbolizer symbolizer_;
+};
+
+const char kTestAppModule[] =
+    "MODULE app test_app.pdb 5A9832E5287241C1838ED98914E9B7FF1 "
+    "c:\\test_app.exe\n";
+
+TEST_F(AddressListSymbolizerTest, SymbolizesStacks) {
+  string output;
+  ASSERT_TRUE(Symbolize(string("# A comment\n") + kTestAppModule +
+                        "MODULE missing missing.pdb 0000 missing.dll\n"
+                        "STACK first stack\n"
+                        "app 41c5\n"
+                        "missing 10\n"
+                        "\n"
+                        "STACK\n"
+                        "app 41b0\n"
+                        "app 41c5\n",
+                        &output));
+  EXPECT_EQ("first stack|0|test_app.exe|main|c:\\test_app.cc|64|0x15\n"
+            "first stack|1|missing.dll||||0x10\n"
+            "|0|test_app.exe|main|c:\\test_app.cc|63|0x0\n"
+            "|1|test_app.exe|main|c:\\test_app.cc|64|0x15\n",
+            output);
+}
+
+TEST_F(AddressListSymbolizerTest, SplitsStacksAcrossBatches) {
+  symbolizer_.set_batch_frames(2);
+  string output;
+  ASSERT_TRUE(Symbolize(string(kTestAppModule) +
+                        "STACK a\n"
+                        "app 41b0\n"
+                        "STACK b\n"
+                        "app 41c5\n"
+                        "app 41fb\n"
+                        "app 4200\n",
+                        &output));
+  EXPECT_EQ("a|0|test_app.exe|main|c:\\test_app.cc|63|0x0\n"
+            "b|0|test_app.exe|main|c:\\test_app.cc|64|0x15\n"
+            "b|1|test_app.exe|main|c:\\test_app.cc|65|0x4b\n"
+            "b|2|test_app.exe|main|c:\\test_app.cc|66|0x50\n",
+            output);
+}
+
+TEST_F(AddressListSymbolizerTest, ReportsMalformedLines) {
+  string output;
+  EXPECT_FALSE(Symbolize(string(kTestAppModule) +
+                         "app 41b0\n"
+                         "MODULE app\n"
+                         "STACK\n"
+                         "app zz\n"
+                         "other 10\n",
+                         &output));
+  EXPECT_EQ("|0|||||0x10\n", output);
+}
+
+}  // namespace
@@ -39,6 +39,8 @@
 
 #include <assert.h>
 
+#include <algorithm>
+
 #include "processor/logging.h"
 
 namespace google_breakpad {
@@ -46,6 +48,12 @@ namespace google_breakpad {
 template<typename AddressType, typename EntryType>
 bool AddressMap<AddressType, EntryType>::Store(const AddressType& address,
                                                const EntryType& entry) {
+  if (frozen_) {
+    map_.insert(frozen_map_.begin(), frozen_map_.end());
+    FrozenEntryMap().swap(frozen_map_);
+    frozen_ = false;
+  }
+
   // Ensure that the specified address doesn't conflict with something already
   // in the map.
   if (map_.find(address) != map_.end()) {
@@ -65,26 +73,66 @@ bool AddressMap<AddressType, EntryType>::Retrieve(
   BPLOG_IF(ERROR, !entry) << "AddressMap::Retrieve requires |entry|";
   assert(entry);
 
+  const EntryType* stored_entry;
+  if (!Retrieve(address, &stored_entry, entry_address))
+    return false;
+
+  *entry = *stored_entry;
+  return true;
+}
+
+template<typename AddressType, typename EntryType>
+bool AddressMap<AddressType, EntryType>::Retrieve(
+    const AddressType& address,
+    const EntryType** entry, AddressType* entry_address) const {
+  BPLOG_IF(ERROR, !entry) << "AddressMap::Retrieve requires |entry|";
+  assert(entry);
+
   // upper_bound gives the first element whose key is greater than address,
   // but we want the first element whose key is less than or equal to address.
   // Decrement the iterator to get there, but not if the upper_bound already
   // points to the beginning of the map - in that case, address is lower than
   // the lowest stored key, so return false.
-  MapConstIterator iterator = map_.upper_bound(address);
-  if (iterator == map_.begin())
-    return false;
-  --iterator;
+  const MapValue* value;
+  if (frozen_) {
+    FrozenConstIterator iterator = std::upper_bound(
+        frozen_map_.begin(), frozen_map_.end(), address,
+        [](const AddressType& key, const MapValue& value) {
+          return key < value.first;
+        });
+    if (iterator == frozen_map_.begin())
+      return false;
+    value = &*--iterator;
+  } else {
+    MapConstIterator iterator = map_.upper_bound(address);
+    if (iterator == map_.begin())
+      return false;
+    value = &*--iterator;
+  }
 
-  *entry = iterator->second;
+  *entry = &value->second;
   if (entry_address)
-    *entry_address = iterator->first;
+    *entry_address = value->first;
 
   return true;
 }
 
+template<typename AddressType, typename EntryType>
+void AddressMap<AddressType, EntryType>::Freeze() {
+  if (frozen_)
+    return;
+
+  FrozenEntryMap frozen_map(map_.begin(), map_.end());
+  frozen_map_.swap(frozen_map);
+  map_.clear();
+  frozen_ = true;
+}
+
 template<typename AddressType, typename EntryType>
 void AddressMap<AddressType, EntryType>::Clear() {
   map_.clear();
+  FrozenEntryMap().swap(frozen_map_);
+  frozen_ = false;
 }
 
 }  // namespace google_breakpad
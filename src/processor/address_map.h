@@ -38,6 +38,7 @@
 #define PROCESSOR_ADDRESS_MAP_H__
 
 #include <map>
+#include <vector>
 
 namespace google_breakpad {
 
@@ -47,7 +48,7 @@ template<class, class> class AddressMapSerializer;
 template<typename AddressType, typename EntryType>
 class AddressMap {
  public:
-  AddressMap() : map_() {}
+  AddressMap() : map_(), frozen_map_(), frozen_(false) {}
 
   // Inserts an entry into the map.  Returns false without storing the entry
   // if an entry is already stored in the map at the same address as specified
@@ -62,6 +63,15 @@ class AddressMap {
   bool Retrieve(const AddressType& address,
                 EntryType* entry, AddressType* entry_address) const;
 
+  // Like Retrieve above, but sets entry to point at the stored entry instead
+  // of copying it, so that concurrent lookups leave the map untouched.  See
+  // RangeMap::RetrieveRange.
+  bool Retrieve(const AddressType& address,
+                const EntryType** entry, AddressType* entry_address) const;
+
+  // Moves the stored entries into a sorted array.  See RangeMap::Freeze.
+  void Freeze();
+
   // Empties the address map, restoring it to the same state as when it was
   // initially created.
   void Clear();
@@ -74,9 +84,16 @@ class AddressMap {
   typedef std::map<AddressType, EntryType> AddressToEntryMap;
   typedef typename AddressToEntryMap::const_iterator MapConstIterator;
   typedef typename AddressToEntryMap::value_type MapValue;
+  typedef std::vector<MapValue> FrozenEntryMap;
+  typedef typename FrozenEntryMap::const_iterator FrozenConstIterator;
 
-  // Maps the address of each entry to an EntryType.
+  // Maps the address of each entry to an EntryType.  Empty while the map is
+  // frozen.
   AddressToEntryMap map_;
+
+  // The contents of map_, in the same order, while the map is frozen.
+  FrozenEntryMap frozen_map_;
+  bool frozen_;
 };
 
 }  // namespace google_breakpad
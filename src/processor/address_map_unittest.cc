@@ -153,29 +153,47 @@ static bool DoAddressMapTest() {
                                          20, 20, 20, 20, 20,    // 20 - 24
                                          20, 20, 20, 20, 20 };  // 25 - 29
 
-  for (AddressType key = 5; key < 30; ++key) {
-    if (!test_map.Retrieve(key, &entry, &address)) {
-      fprintf(stderr,
-              "FAIL: retrieve %d expected true observed false @ %s:%d\n",
-              key, __FILE__, __LINE__);
-      return false;
-    }
-    if (entry->id() != id_verify[key]) {
-      fprintf(stderr,
-              "FAIL: retrieve %d expected entry %d observed %d @ %s:%d\n",
-              key, id_verify[key], entry->id(), __FILE__, __LINE__);
-      return false;
+  // Check again once the map is frozen, which must not change any lookup.
+  for (int pass = 0; pass < 2; ++pass) {
+    if (pass == 1) {
+      test_map.Freeze();
+      ASSERT_FALSE(test_map.Retrieve(4, &entry, &address));
     }
-    if (address != address_verify[key]) {
-      fprintf(stderr,
-              "FAIL: retrieve %d expected address %d observed %d @ %s:%d\n",
-              key, address_verify[key], address, __FILE__, __LINE__);
-      return false;
+
+    for (AddressType key = 5; key < 30; ++key) {
+      if (!test_map.Retrieve(key, &entry, &address)) {
+        fprintf(stderr,
+                "FAIL: retrieve %d expected true observed false @ %s:%d\n",
+                key, __FILE__, __LINE__);
+        return false;
+      }
+      if (entry->id() != id_verify[key]) {
+        fprintf(stderr,
+                "FAIL: retrieve %d expected entry %d observed %d @ %s:%d\n",
+                key, id_verify[key], entry->id(), __FILE__, __LINE__);
+        return false;
+      }
+      if (address != address_verify[key]) {
+        fprintf(stderr,
+                "FAIL: retrieve %d expected address %d observed %d @ %s:%d\n",
+                key, address_verify[key], address, __FILE__, __LINE__);
+        return false;
+      }
     }
   }
 
+  // Storing into a frozen map works, and still rejects duplicates.
+  ASSERT_FALSE(test_map.Store(15,
+      linked_ptr<CountedObject>(new CountedObject(8))));
+  ASSERT_TRUE(test_map.Store(30,
+      linked_ptr<CountedObject>(new CountedObject(9))));
+  ASSERT_TRUE(test_map.Retrieve(31, &entry, &address));
+  ASSERT_EQ(entry->id(), 9);
+  ASSERT_TRUE(test_map.Retrieve(19, &entry, &address));
+  ASSERT_EQ(entry->id(), 6);
+
   // The stored objects should still be in the map.
-  ASSERT_EQ(CountedObject::count(), 6);
+  ASSERT_EQ(CountedObject::count(), 7);
 
   return true;
 }
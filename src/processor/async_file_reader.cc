@@ -0,0 +1,520 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// async_file_reader.cc: Reads whole files without blocking the caller.
+//
+// See async_file_reader.h for documentation.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "processor/async_file_reader.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#if defined(__NR_io_uring_setup) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define HAVE_IO_URING 1
+#endif
+#endif
+#endif
+
+#include "processor/logging.h"
+
+namespace google_breakpad {
+
+class AsyncFileReader::Engine {
+ public:
+  virtual ~Engine() {}
+  virtual void Read(const string& path, Callback* callback) = 0;
+  virtual bool uses_io_uring() const = 0;
+};
+
+namespace {
+
+// Opens the regular file at path and sets size to its size.  Returns the
+// file descriptor, or -1 if it can't.
+int OpenFile(const string& path, size_t* size) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return -1;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(fd);
+    return -1;
+  }
+  *size = static_cast<size_t>(st.st_size);
+  return fd;
+}
+
+// Allocates a buffer for size bytes and the NUL that follows them.
+char* AllocateBuffer(size_t size) {
+  char* data = new char[size + 1];
+  data[size] = '\0';
+  return data;
+}
+
+// Reads the file at path on the calling thread.  Returns NULL if it can't.
+char* ReadFile(const string& path, size_t* size) {
+  *size = 0;
+  size_t file_size;
+  int fd = OpenFile(path, &file_size);
+  if (fd < 0)
+    return NULL;
+  char* data = AllocateBuffer(file_size);
+  size_t offset = 0;
+  while (offset < file_size) {
+    ssize_t result = pread(fd, data + offset, file_size - offset, offset);
+    if (result < 0 && errno == EINTR)
+      continue;
+    if (result <= 0)
+      break;
+    offset += result;
+  }
+  close(fd);
+  if (offset < file_size) {
+    BPLOG(ERROR) << "Could not read " << path;
+    delete [] data;
+    return NULL;
+  }
+  *size = file_size;
+  return data;
+}
+
+// Reads files with a pool of threads, each making one blocking read at a
+// time.
+class ThreadPoolEngine : public AsyncFileReader::Engine {
+ public:
+  explicit ThreadPoolEngine(int threads) : stopping_(false) {
+    for (int i = 0; i < threads; ++i)
+      threads_.push_back(std::thread(&ThreadPoolEngine::Work, this));
+  }
+
+  virtual ~ThreadPoolEngine() {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      stopping_ = true;
+    }
+    condition_.notify_all();
+    for (std::thread& thread : threads_)
+      thread.join();
+  }
+
+  virtual void Read(const string& path, AsyncFileReader::Callback* callback) {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      requests_.push_back(Request(path, callback));
+    }
+    condition_.notify_one();
+  }
+
+  virtual bool uses_io_uring() const { return false; }
+
+ private:
+  typedef std::pair<string, AsyncFileReader::Callback*> Request;
+
+  // Reads files until the queue is empty and the engine is stopping.
+  void Work() {
+    while (true) {
+      Request request;
+      {
+        std::unique_lock<std::mutex> lock(lock_);
+        condition_.wait(lock,
+                        [this] { return stopping_ || !requests_.empty(); });
+        if (requests_.empty())
+          return;
+        request = requests_.front();
+        requests_.pop_front();
+      }
+      size_t size;
+      char* data = ReadFile(request.first, &size);
+      request.second->OnRead(request.first, data, size);
+    }
+  }
+
+  // Guards stopping_ and requests_.
+  std::mutex lock_;
+  std::condition_variable condition_;
+  bool stopping_;
+  std::deque<Request> requests_;
+  std::vector<std::thread> threads_;
+};
+
+#if defined(HAVE_IO_URING)
+
+// The largest read submitted at once.  Larger files are read in pieces.
+const size_t kMaxReadSize = 1 << 30;
+
+// The most entries a ring is set up with.
+const int kMaxRingEntries = 4096;
+
+// Reads files through an io_uring.  The thread calling Read opens each file
+// and submits its read, and a completion thread collects the results,
+// resubmitting short reads for the rest of the file.  No more reads are
+// submitted than the submission queue holds, so the completion queue, which
+// the kernel makes at least as large, can't overflow; reads beyond those
+// wait in pending_.
+class IoUringEngine : public AsyncFileReader::Engine {
+ public:
+  IoUringEngine()
+      : ring_fd_(-1),
+        sq_ring_(NULL),
+        sq_ring_size_(0),
+        cq_ring_(NULL),
+        cq_ring_size_(0),
+        sqes_(NULL),
+        sqes_size_(0),
+        sq_entries_(0),
+        in_flight_(0),
+        outstanding_(0) {}
+
+  virtual ~IoUringEngine() {
+    if (completion_thread_.joinable()) {
+      // Wait for the reads, then wake the completion thread with a request
+      // that has no Request, which tells it to stop.
+      std::unique_lock<std::mutex> lock(lock_);
+      idle_.wait(lock, [this] { return outstanding_ == 0; });
+      struct io_uring_sqe* sqe = NextSubmission();
+      sqe->opcode = IORING_OP_NOP;
+      sqe->user_data = 0;
+      CommitSubmission();
+      Enter(1);
+      lock.unlock();
+      completion_thread_.join();
+    }
+    if (sqes_)
+      munmap(sqes_, sqes_size_);
+    if (cq_ring_ && cq_ring_ != sq_ring_)
+      munmap(cq_ring_, cq_ring_size_);
+    if (sq_ring_)
+      munmap(sq_ring_, sq_ring_size_);
+    if (ring_fd_ >= 0)
+      close(ring_fd_);
+  }
+
+  // Sets up a ring with room for entries reads.  Returns false if the
+  // system does not allow io_uring.
+  bool Initialize(int entries) {
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup,
+        entries < kMaxRingEntries ? entries : kMaxRingEntries, &params));
+    if (ring_fd_ < 0) {
+      BPLOG(INFO) << "io_uring is unavailable: " << strerror(errno);
+      return false;
+    }
+
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes +
+                    params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      if (cq_ring_size_ > sq_ring_size_)
+        sq_ring_size_ = cq_ring_size_;
+      cq_ring_size_ = sq_ring_size_;
+    }
+    sq_ring_ = Map(sq_ring_size_, IORING_OFF_SQ_RING);
+    if (!sq_ring_)
+      return false;
+    cq_ring_ = single_mmap ? sq_ring_ : Map(cq_ring_size_, IORING_OFF_CQ_RING);
+    if (!cq_ring_)
+      return false;
+    sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    sqes_ = static_cast<struct io_uring_sqe*>(
+        Map(sqes_size_, IORING_OFF_SQES));
+    if (!sqes_)
+      return false;
+
+    char* sq = static_cast<char*>(sq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    char* cq = static_cast<char*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+    sq_entries_ = params.sq_entries;
+
+    completion_thread_ = std::thread(&IoUringEngine::Complete, this);
+    return true;
+  }
+
+  virtual void Read(const string& path, AsyncFileReader::Callback* callback) {
+    size_t size;
+    int fd = OpenFile(path, &size);
+    if (fd < 0) {
+      callback->OnRead(path, NULL, 0);
+      return;
+    }
+    if (size == 0) {
+      close(fd);
+      callback->OnRead(path, AllocateBuffer(0), 0);
+      return;
+    }
+
+    Request* request = new Request;
+    request->path = path;
+    request->callback = callback;
+    request->fd = fd;
+    request->data = AllocateBuffer(size);
+    request->size = size;
+    request->offset = 0;
+
+    std::lock_guard<std::mutex> lock(lock_);
+    ++outstanding_;
+    pending_.push_back(request);
+    SubmitPending();
+  }
+
+  virtual bool uses_io_uring() const { return true; }
+
+ private:
+  // A file being read.
+  struct Request {
+    string path;
+    AsyncFileReader::Callback* callback;
+    int fd;
+    char* data;
+    size_t size;
+    // How much of the file has been read.
+    size_t offset;
+    // The part of data being read, which must stay put until the read
+    // completes.
+    struct iovec iovec;
+  };
+
+  void* Map(size_t size, off_t offset) {
+    void* ring = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd_, offset);
+    if (ring == MAP_FAILED) {
+      BPLOG(ERROR) << "Could not map io_uring: " << strerror(errno);
+      return NULL;
+    }
+    return ring;
+  }
+
+  // Returns the next free submission queue entry, cleared.  lock_ must be
+  // held, and in_flight_ must be below sq_entries_.
+  struct io_uring_sqe* NextSubmission() {
+    unsigned index = *sq_tail_ & sq_mask_;
+    struct io_uring_sqe* sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array_[index] = index;
+    return sqe;
+  }
+
+  // Hands the entry returned by NextSubmission to the kernel.
+  void CommitSubmission() {
+    __atomic_store_n(sq_tail_, *sq_tail_ + 1, __ATOMIC_RELEASE);
+    ++in_flight_;
+  }
+
+  // Tells the kernel about count new submissions.
+  void Enter(unsigned count) {
+    while (syscall(__NR_io_uring_enter, ring_fd_, count, 0, 0, NULL, 0) < 0) {
+      if (errno != EINTR) {
+        BPLOG(ERROR) << "io_uring_enter failed: " << strerror(errno);
+        return;
+      }
+    }
+  }
+
+  // Submits the reads in pending_ that the submission queue has room for.
+  // lock_ must be held.
+  void SubmitPending() {
+    unsigned submitted = 0;
+    while (!pending_.empty() && in_flight_ < sq_entries_) {
+      Request* request = pending_.front();
+      pending_.pop_front();
+      size_t remaining = request->size - request->offset;
+      request->iovec.iov_base = request->data + request->offset;
+      request->iovec.iov_len =
+          remaining < kMaxReadSize ? remaining : kMaxReadSize;
+      struct io_uring_sqe* sqe = NextSubmission();
+      sqe->opcode = IORING_OP_READV;
+      sqe->fd = request->fd;
+      sqe->addr = reinterpret_cast<uintptr_t>(&request->iovec);
+      sqe->len = 1;
+      sqe->off = request->offset;
+      sqe->user_data = reinterpret_cast<uintptr_t>(request);
+      CommitSubmission();
+      ++submitted;
+    }
+    if (submitted > 0)
+      Enter(submitted);
+  }
+
+  // Runs on completion_thread_, collecting completed reads and calling
+  // their callbacks, until it collects the request with no Request.
+  void Complete() {
+    std::vector<std::pair<Request*, bool> > finished;
+    bool stopping = false;
+    while (!stopping) {
+      // Only this thread moves the head.
+      unsigned head = *cq_head_;
+      unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+      if (head == tail) {
+        if (syscall(__NR_io_uring_enter, ring_fd_, 0, 1,
+                    IORING_ENTER_GETEVENTS, NULL, 0) < 0 &&
+            errno != EINTR) {
+          BPLOG(ERROR) << "io_uring_enter failed: " << strerror(errno);
+        }
+        continue;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(lock_);
+        for (; head != tail; ++head) {
+          const struct io_uring_cqe* cqe = &cqes_[head & cq_mask_];
+          --in_flight_;
+          Request* request = reinterpret_cast<Request*>(cqe->user_data);
+          if (!request) {
+            stopping = true;
+            continue;
+          }
+          if (cqe->res == -EINTR || cqe->res == -EAGAIN) {
+            pending_.push_front(request);
+          } else if (cqe->res <= 0) {
+            // An error, or the file has shrunk.
+            finished.push_back(std::make_pair(request, false));
+          } else {
+            request->offset += cqe->res;
+            if (request->offset < request->size)
+              pending_.push_front(request);
+            else
+              finished.push_back(std::make_pair(request, true));
+          }
+        }
+        __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+        SubmitPending();
+      }
+
+      if (finished.empty())
+        continue;
+      for (const std::pair<Request*, bool>& result : finished) {
+        Request* request = result.first;
+        close(request->fd);
+        if (result.second) {
+          request->callback->OnRead(request->path, request->data,
+                                    request->size);
+        } else {
+          BPLOG(ERROR) << "Could not read " << request->path;
+          delete [] request->data;
+          request->callback->OnRead(request->path, NULL, 0);
+        }
+        delete request;
+      }
+      std::lock_guard<std::mutex> lock(lock_);
+      outstanding_ -= finished.size();
+      finished.clear();
+      if (outstanding_ == 0)
+        idle_.notify_all();
+    }
+  }
+
+  int ring_fd_;
+  void* sq_ring_;
+  size_t sq_ring_size_;
+  void* cq_ring_;
+  size_t cq_ring_size_;
+  struct io_uring_sqe* sqes_;
+  size_t sqes_size_;
+
+  // Fields of the rings, which the kernel shares.
+  unsigned* sq_tail_;
+  unsigned sq_mask_;
+  unsigned* sq_array_;
+  unsigned* cq_head_;
+  unsigned* cq_tail_;
+  unsigned cq_mask_;
+  struct io_uring_cqe* cqes_;
+  unsigned sq_entries_;
+
+  // Guards the submission queue, pending_, in_flight_, and outstanding_.
+  std::mutex lock_;
+  // Signaled when outstanding_ drops to 0.
+  std::condition_variable idle_;
+  // Reads waiting for room in the submission queue.
+  std::deque<Request*> pending_;
+  // The number of submissions whose completions have not been collected.
+  unsigned in_flight_;
+  // The number of reads whose callbacks have not returned.
+  size_t outstanding_;
+  std::thread completion_thread_;
+};
+
+#endif  // HAVE_IO_URING
+
+}  // namespace
+
+AsyncFileReader::AsyncFileReader(int concurrency, bool allow_io_uring) {
+  if (concurrency < 1)
+    concurrency = 1;
+#if defined(HAVE_IO_URING)
+  if (allow_io_uring) {
+    std::unique_ptr<IoUringEngine> ring(new IoUringEngine());
+    if (ring->Initialize(concurrency)) {
+      engine_ = std::move(ring);
+      return;
+    }
+  }
+#endif
+  engine_.reset(new ThreadPoolEngine(concurrency));
+}
+
+AsyncFileReader::~AsyncFileReader() {
+}
+
+void AsyncFileReader::Read(const string& path, Callback* callback) {
+  engine_->Read(path, callback);
+}
+
+bool AsyncFileReader::uses_io_uring() const {
+  return engine_->uses_io_uring();
+}
+
+}  // namespace google_breakpad
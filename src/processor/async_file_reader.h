@@ -0,0 +1,97 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// async_file_reader.h: Reads whole files without blocking the caller.
+//
+// AsyncFileReader reads each file it is asked for into a buffer and hands
+// the buffer to a callback.  On Linux it submits the reads to an io_uring
+// and collects them on a single thread, so that many reads are in flight
+// without a thread apiece.  Where io_uring is unavailable, because the
+// system is not Linux, the kernel predates it, or a sandbox forbids it, the
+// reads are made by a small pool of threads instead.
+//
+// With io_uring, files are opened and their sizes found by the thread that
+// asks for them, which is cheap next to reading them; only the reads
+// themselves are asynchronous.
+
+#ifndef PROCESSOR_ASYNC_FILE_READER_H__
+#define PROCESSOR_ASYNC_FILE_READER_H__
+
+#include <stddef.h>
+
+#include <memory>
+#include <string>
+
+#include "common/using_std_string.h"
+
+namespace google_breakpad {
+
+class AsyncFileReader {
+ public:
+  // Receives the contents of a file read by Read.
+  class Callback {
+   public:
+    virtual ~Callback() {}
+
+    // Called once when the read of path completes, on any thread and
+    // possibly before Read returns.  data holds the size bytes of the file
+    // followed by a NUL, and was allocated with new[]; the callback takes
+    // ownership of it.  data is NULL if the file could not be read.
+    virtual void OnRead(const string& path, char* data, size_t size) = 0;
+  };
+
+  // Creates a reader that keeps up to concurrency reads in flight.  If
+  // allow_io_uring is false, a pool of concurrency threads is used even
+  // where io_uring is available.
+  explicit AsyncFileReader(int concurrency, bool allow_io_uring = true);
+
+  // Waits for all outstanding reads to complete.
+  ~AsyncFileReader();
+
+  // Starts reading the whole of the file at path, and returns without
+  // waiting for it.  callback must stay alive until it is called.  Reads
+  // beyond those in flight are queued.
+  void Read(const string& path, Callback* callback);
+
+  // Whether reads are submitted to an io_uring rather than a thread pool.
+  bool uses_io_uring() const;
+
+  // The io_uring or thread pool that makes the reads.
+  class Engine;
+
+ private:
+  std::unique_ptr<Engine> engine_;
+
+  // Disallow copy constructor and assignment operator.
+  AsyncFileReader(const AsyncFileReader&);
+  void operator=(const AsyncFileReader&);
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_ASYNC_FILE_READER_H__
@@ -0,0 +1,150 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Unit tests for AsyncFileReader, through io_uring where the system allows
+// it and through its thread pool.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <stdio.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "common/tests/auto_tempdir.h"
+#include "common/using_std_string.h"
+#include "processor/async_file_reader.h"
+
+namespace {
+
+using google_breakpad::AsyncFileReader;
+using google_breakpad::AutoTempDir;
+using std::map;
+
+// Records the contents of each file read, or "<failed>".
+class RecordingCallback : public AsyncFileReader::Callback {
+ public:
+  virtual void OnRead(const string& path, char* data, size_t size) {
+    std::lock_guard<std::mutex> lock(lock_);
+    if (!data) {
+      contents_[path] = "<failed>";
+      return;
+    }
+    EXPECT_EQ('\0', data[size]);
+    contents_[path] = string(data, size);
+    delete [] data;
+  }
+
+  const map<string, string>& contents() const { return contents_; }
+
+ private:
+  std::mutex lock_;
+  map<string, string> contents_;
+};
+
+void WriteFile(const string& path, const string& contents) {
+  FILE* file = fopen(path.c_str(), "wb");
+  ASSERT_TRUE(file);
+  ASSERT_EQ(contents.size(), fwrite(contents.data(), 1, contents.size(), file));
+  fclose(file);
+}
+
+// The parameter is whether io_uring may be used.
+class AsyncFileReaderTest : public ::testing::TestWithParam<bool> {
+ public:
+  AutoTempDir directory_;
+  RecordingCallback callback_;
+};
+
+TEST_P(AsyncFileReaderTest, ReadsFiles) {
+  string small = directory_.path() + "/small";
+  string empty = directory_.path() + "/empty";
+  string missing = directory_.path() + "/missing";
+  string large = directory_.path() + "/large";
+  string large_contents;
+  for (int i = 0; i < (3 << 20); ++i)
+    large_contents.push_back(static_cast<char>(i * 7));
+  WriteFile(small, "MODULE Linux x86_64 0123 small\n");
+  WriteFile(empty, "");
+  WriteFile(large, large_contents);
+
+  {
+    AsyncFileReader reader(4, GetParam());
+    if (!GetParam())
+      EXPECT_FALSE(reader.uses_io_uring());
+    reader.Read(small, &callback_);
+    reader.Read(empty, &callback_);
+    reader.Read(missing, &callback_);
+    reader.Read(large, &callback_);
+    reader.Read(directory_.path(), &callback_);
+  }
+
+  const map<string, string>& contents = callback_.contents();
+  ASSERT_EQ(5U, contents.size());
+  EXPECT_EQ("MODULE Linux x86_64 0123 small\n", contents.at(small));
+  EXPECT_EQ("", contents.at(empty));
+  EXPECT_EQ("<failed>", contents.at(missing));
+  EXPECT_EQ("<failed>", contents.at(directory_.path()));
+  EXPECT_TRUE(large_contents == contents.at(large));
+}
+
+TEST_P(AsyncFileReaderTest, QueuesReadsBeyondConcurrency) {
+  const int kFiles = 200;
+  for (int i = 0; i < kFiles; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "/%d.sym", i);
+    WriteFile(directory_.path() + name, string(i * 100, 'a' + i % 26));
+  }
+
+  {
+    AsyncFileReader reader(2, GetParam());
+    for (int i = 0; i < kFiles; ++i) {
+      char name[32];
+      snprintf(name, sizeof(name), "/%d.sym", i);
+      reader.Read(directory_.path() + name, &callback_);
+    }
+  }
+
+  const map<string, string>& contents = callback_.contents();
+  ASSERT_EQ(static_cast<size_t>(kFiles), contents.size());
+  for (int i = 0; i < kFiles; ++i) {
+    char name[32];
+    snprintf(name, sizeof(name), "/%d.sym", i);
+    EXPECT_EQ(string(i * 100, 'a' + i % 26),
+              contents.at(directory_.path() + name));
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, AsyncFileReaderTest,
+                         ::testing::Values(true, false));
+
+}  // namespace
@@ -0,0 +1,319 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// async_log_sink.cc: A LogSink that writes messages out on its own thread.
+//
+// See async_log_sink.h for documentation.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "processor/async_log_sink.h"
+
+#include <time.h>
+
+#include <chrono>
+#include <utility>
+
+#include "processor/pathname_stripper.h"
+
+namespace google_breakpad {
+
+namespace {
+
+// How long the writer sleeps at most when the queue is empty.  A producer
+// wakes it sooner unless the wakeup races with its going to sleep.
+const std::chrono::milliseconds kWriterIdleWait(20);
+
+// How many sites FindSite looks at before giving up on a statement.
+const size_t kMaxSiteProbes = 8;
+
+// Appends text to *output as a quoted value, escaped.
+void AppendQuoted(const string& text, string* output) {
+  output->push_back('"');
+  for (char c : text) {
+    switch (c) {
+      case '"':
+      case '\\':
+        output->push_back('\\');
+        output->push_back(c);
+        break;
+      case '\n':
+        output->append("\\n");
+        break;
+      case '\r':
+        output->append("\\r");
+        break;
+      default:
+        output->push_back(c);
+    }
+  }
+  output->push_back('"');
+}
+
+}  // namespace
+
+AsyncLogSink::AsyncLogSink(FILE* output, const Options& options)
+    : output_(output),
+      options_(options),
+      mask_(0),
+      enqueue_position_(0),
+      dequeue_position_(0),
+      written_position_(0),
+      sites_(new Site[kSiteCount]),
+      dropped_(0),
+      suppressed_(0),
+      writer_waiting_(false),
+      stopping_(false) {
+  size_t capacity = 2;
+  while (capacity < options_.capacity)
+    capacity *= 2;
+  mask_ = capacity - 1;
+  slots_.reset(new Slot[capacity]);
+  for (size_t i = 0; i < capacity; ++i)
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  for (size_t i = 0; i < kSiteCount; ++i) {
+    sites_[i].key.store(0, std::memory_order_relaxed);
+    sites_[i].period.store(0, std::memory_order_relaxed);
+    sites_[i].count.store(0, std::memory_order_relaxed);
+    sites_[i].suppressed.store(0, std::memory_order_relaxed);
+  }
+  writer_ = std::thread(&AsyncLogSink::WriterThread, this);
+}
+
+AsyncLogSink::~AsyncLogSink() {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    stopping_ = true;
+  }
+  wake_.notify_one();
+  writer_.join();
+}
+
+bool AsyncLogSink::ShouldLog(LogStream::Severity severity,
+                             const char* file, int line) {
+  if (options_.max_messages_per_site <= 0 ||
+      severity == LogStream::SEVERITY_CRITICAL) {
+    return true;
+  }
+  Site* site = FindSite(file, line);
+  if (!site)
+    return true;
+
+  // Sites race to start a new period; the one that wins resets the count.
+  // A message counted against the old period just before the reset is
+  // lost from the new one, which errs toward logging more.
+  int64_t period = time(NULL) / (options_.period_seconds > 0 ?
+                                 options_.period_seconds : 1);
+  int64_t site_period = site->period.load(std::memory_order_relaxed);
+  if (site_period != period &&
+      site->period.compare_exchange_strong(site_period, period,
+                                           std::memory_order_relaxed)) {
+    site->count.store(0, std::memory_order_relaxed);
+  }
+  if (site->count.fetch_add(1, std::memory_order_relaxed) <
+      options_.max_messages_per_site) {
+    return true;
+  }
+  site->suppressed.fetch_add(1, std::memory_order_relaxed);
+  suppressed_.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void AsyncLogSink::Write(Message* message) {
+  int suppressed = 0;
+  if (options_.max_messages_per_site > 0) {
+    Site* site = FindSite(message->file, message->line);
+    if (site)
+      suppressed = site->suppressed.exchange(0, std::memory_order_relaxed);
+  }
+
+  // Claim the slot at the end of the queue.  Its sequence equals the
+  // position when it is free for that position, and is behind it when the
+  // writer hasn't emptied it yet, which means the queue is full.
+  size_t position = enqueue_position_.load(std::memory_order_relaxed);
+  Slot* slot;
+  for (;;) {
+    slot = &slots_[position & mask_];
+    size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    intptr_t difference = static_cast<intptr_t>(sequence) -
+                          static_cast<intptr_t>(position);
+    if (difference == 0) {
+      if (enqueue_position_.compare_exchange_weak(position, position + 1,
+                                                  std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (difference < 0) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    } else {
+      position = enqueue_position_.load(std::memory_order_relaxed);
+    }
+  }
+  slot->message = std::move(*message);
+  slot->suppressed = suppressed;
+  slot->sequence.store(position + 1, std::memory_order_release);
+
+  if (writer_waiting_.load(std::memory_order_acquire))
+    wake_.notify_one();
+}
+
+void AsyncLogSink::Flush() {
+  size_t position = enqueue_position_.load(std::memory_order_acquire);
+  std::unique_lock<std::mutex> lock(lock_);
+  wake_.notify_one();
+  written_.wait(lock, [this, position] {
+    return written_position_.load(std::memory_order_acquire) >= position;
+  });
+}
+
+AsyncLogSink::Site* AsyncLogSink::FindSite(const char* file, int line) {
+  // A statement is identified by the address of its __FILE__ string, which
+  // is the same for every statement in a file, and its line.  Statements
+  // whose keys collide share a limit.
+  uintptr_t key = reinterpret_cast<uintptr_t>(file) * 31 +
+                  static_cast<uintptr_t>(line);
+  // 0 marks an unused site.
+  if (key == 0)
+    key = 1;
+  size_t index = static_cast<size_t>(key * 0x9e3779b97f4a7c15ULL >> 20);
+  for (size_t probe = 0; probe < kMaxSiteProbes; ++probe) {
+    Site* site = &sites_[(index + probe) % kSiteCount];
+    uintptr_t site_key = site->key.load(std::memory_order_relaxed);
+    if (site_key == key)
+      return site;
+    if (site_key == 0 &&
+        (site->key.compare_exchange_strong(site_key, key,
+                                           std::memory_order_relaxed) ||
+         site_key == key)) {
+      return site;
+    }
+  }
+  return NULL;
+}
+
+bool AsyncLogSink::Dequeue(Message* message, int* suppressed) {
+  Slot* slot = &slots_[dequeue_position_ & mask_];
+  if (slot->sequence.load(std::memory_order_acquire) != dequeue_position_ + 1)
+    return false;
+  *message = std::move(slot->message);
+  *suppressed = slot->suppressed;
+  slot->sequence.store(dequeue_position_ + mask_ + 1,
+                       std::memory_order_release);
+  ++dequeue_position_;
+  return true;
+}
+
+void AsyncLogSink::AppendMessage(const Message& message,
+                                 int suppressed,
+                                 string* output) {
+  string file = PathnameStripper::File(message.file);
+  if (options_.format == FORMAT_KEY_VALUE) {
+    output->append("time=");
+    AppendQuoted(LogTimeString(message.time), output);
+    output->append(" severity=");
+    output->append(LogSeverityName(message.severity));
+    output->append(" file=");
+    AppendQuoted(file, output);
+    output->append(" line=");
+    output->append(std::to_string(message.line));
+    output->append(" message=");
+    AppendQuoted(message.text, output);
+    if (suppressed) {
+      output->append(" suppressed=");
+      output->append(std::to_string(suppressed));
+    }
+  } else {
+    output->append(LogTimeString(message.time));
+    output->append(": ");
+    output->append(file);
+    output->push_back(':');
+    output->append(std::to_string(message.line));
+    output->append(": ");
+    output->append(LogSeverityName(message.severity));
+    output->append(": ");
+    output->append(message.text);
+    if (suppressed) {
+      output->append(" (");
+      output->append(std::to_string(suppressed));
+      output->append(" similar messages suppressed)");
+    }
+  }
+  output->push_back('\n');
+}
+
+void AsyncLogSink::WriterThread() {
+  uint64_t reported_dropped = 0;
+  string batch;
+  Message message;
+  int suppressed;
+  for (;;) {
+    batch.clear();
+    while (Dequeue(&message, &suppressed))
+      AppendMessage(message, suppressed, &batch);
+
+    uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped != reported_dropped) {
+      Message dropped_message = {
+        LogStream::SEVERITY_ERROR, time(NULL), __FILE__, __LINE__,
+        "Dropped " + std::to_string(dropped - reported_dropped) +
+            " log messages with the queue full"
+      };
+      AppendMessage(dropped_message, 0, &batch);
+      reported_dropped = dropped;
+    }
+
+    if (!batch.empty()) {
+      fwrite(batch.data(), 1, batch.size(), output_);
+      fflush(output_);
+    }
+
+    std::unique_lock<std::mutex> lock(lock_);
+    written_position_.store(dequeue_position_, std::memory_order_release);
+    written_.notify_all();
+    if (!batch.empty())
+      continue;
+    if (stopping_ &&
+        enqueue_position_.load(std::memory_order_acquire) ==
+            dequeue_position_) {
+      return;
+    }
+    // Check the queue again after announcing that the writer is waiting,
+    // so that a message enqueued in between is not left until the timeout.
+    writer_waiting_.store(true, std::memory_order_seq_cst);
+    Slot* slot = &slots_[dequeue_position_ & mask_];
+    if (slot->sequence.load(std::memory_order_acquire) !=
+        dequeue_position_ + 1) {
+      wake_.wait_for(lock, kWriterIdleWait);
+    }
+    writer_waiting_.store(false, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace google_breakpad
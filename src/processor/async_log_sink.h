@@ -0,0 +1,184 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// async_log_sink.h: A LogSink that writes messages out on its own thread.
+//
+// AsyncLogSink takes messages from the threads that log them through a
+// fixed-size lock-free queue, and a writer thread writes them out in
+// batches, with a single flush per batch, so that logging costs the
+// logging thread little more than formatting the message.  If the queue is
+// full, messages are dropped and counted, and the count is logged once
+// there is room.
+//
+// It can also limit how many messages each logging statement, identified
+// by its source file and line, logs per period, which keeps statements
+// that log for every module or frame of a large dump from flooding the
+// output.  Limited messages are declined before they are formatted, and
+// the next message from the statement that is logged says how many were
+// suppressed.  CRITICAL messages are never limited.
+//
+// Messages are written as logging.h's streams write them, or as key=value
+// pairs for log collectors that parse fields.
+//
+// To use it:
+//   AsyncLogSink sink(stderr, AsyncLogSink::Options());
+//   LogSink* previous_sink = SetLogSink(&sink);
+//   ...
+//   SetLogSink(previous_sink);
+// The sink writes out any messages left when it is destroyed.
+
+#ifndef PROCESSOR_ASYNC_LOG_SINK_H__
+#define PROCESSOR_ASYNC_LOG_SINK_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "common/using_std_string.h"
+#include "processor/logging.h"
+
+namespace google_breakpad {
+
+class AsyncLogSink : public LogSink {
+ public:
+  enum Format {
+    // "<time>: <file>:<line>: <SEVERITY>: <text>", as the streams have it.
+    FORMAT_TEXT,
+    // time="<time>" severity=<SEVERITY> file=<file> line=<line>
+    // message="<text>", with quotes, backslashes and line endings in the
+    // text escaped.
+    FORMAT_KEY_VALUE
+  };
+
+  struct Options {
+    Options()
+        : format(FORMAT_TEXT),
+          capacity(4096),
+          max_messages_per_site(0),
+          period_seconds(1) {}
+
+    Format format;
+    // The most messages waiting to be written out, rounded up to a power
+    // of two.
+    size_t capacity;
+    // The most messages each statement logs per period_seconds, or 0 for
+    // no limit.
+    int max_messages_per_site;
+    int period_seconds;
+  };
+
+  AsyncLogSink(FILE* output, const Options& options);
+  ~AsyncLogSink();
+  AsyncLogSink(const AsyncLogSink&) = delete;
+  void operator=(const AsyncLogSink&) = delete;
+
+  // Implementation of LogSink.
+  bool ShouldLog(LogStream::Severity severity,
+                 const char* file, int line) override;
+  void Write(Message* message) override;
+  void Flush() override;
+
+  // The number of messages dropped because the queue was full.
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  // The number of messages declined by the limit on messages per site.
+  uint64_t suppressed() const {
+    return suppressed_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  // An element of the queue.  sequence tells producers and the writer
+  // whose turn it is to use the slot.
+  struct Slot {
+    std::atomic<size_t> sequence;
+    Message message;
+    int suppressed;
+  };
+
+  // A logging statement's count of messages in the current period.
+  struct Site {
+    std::atomic<uintptr_t> key;
+    std::atomic<int64_t> period;
+    std::atomic<int> count;
+    std::atomic<int> suppressed;
+  };
+
+  // The number of sites whose messages can be limited; messages from
+  // statements beyond these are not.
+  static const size_t kSiteCount = 1024;
+
+  // Returns the site for the statement at file and line, adding it if
+  // there is room, or NULL.
+  Site* FindSite(const char* file, int line);
+
+  // Moves the next message in the queue to *message, returning false if
+  // there is none.  Only the writer thread calls this.
+  bool Dequeue(Message* message, int* suppressed);
+
+  // Appends message, formatted, to *output.
+  void AppendMessage(const Message& message, int suppressed, string* output);
+
+  void WriterThread();
+
+  FILE* output_;
+  const Options options_;
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t mask_;
+  std::atomic<size_t> enqueue_position_;
+  // Only the writer thread uses dequeue_position_.
+  size_t dequeue_position_;
+  // The position up to which messages have been written out.
+  std::atomic<size_t> written_position_;
+
+  std::unique_ptr<Site[]> sites_;
+
+  std::atomic<uint64_t> dropped_;
+  std::atomic<uint64_t> suppressed_;
+
+  // The writer sleeps on wake_ when the queue is empty, with
+  // writer_waiting_ set so that producers know to wake it.  Flush waits on
+  // written_ for the writer to catch up.
+  std::mutex lock_;
+  std::condition_variable wake_;
+  std::condition_variable written_;
+  std::atomic<bool> writer_waiting_;
+  bool stopping_;
+
+  std::thread writer_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_ASYNC_LOG_SINK_H__
@@ -0,0 +1,175 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// async_log_sink_unittest.cc: Unit tests for AsyncLogSink.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <stdio.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "breakpad_googletest_includes.h"
+#include "common/using_std_string.h"
+#include "processor/async_log_sink.h"
+#include "processor/logging.h"
+
+namespace {
+
+using google_breakpad::AsyncLogSink;
+using google_breakpad::LogSink;
+using google_breakpad::SetLogSink;
+
+class AsyncLogSinkTest : public ::testing::Test {
+ public:
+  void SetUp() override {
+    output_ = tmpfile();
+    ASSERT_TRUE(output_);
+  }
+
+  void TearDown() override {
+    fclose(output_);
+  }
+
+  // Returns everything written to output_ so far.
+  string Output() {
+    string contents;
+    rewind(output_);
+    char buffer[4096];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof(buffer), output_)) > 0)
+      contents.append(buffer, size);
+    return contents;
+  }
+
+  // Returns the number of times text appears in Output().
+  size_t CountInOutput(const string& text) {
+    string contents = Output();
+    size_t count = 0;
+    for (size_t position = contents.find(text); position != string::npos;
+         position = contents.find(text, position + text.size())) {
+      ++count;
+    }
+    return count;
+  }
+
+  FILE* output_;
+};
+
+TEST_F(AsyncLogSinkTest, WritesText) {
+  AsyncLogSink sink(output_, AsyncLogSink::Options());
+  LogSink* previous_sink = SetLogSink(&sink);
+  BPLOG(ERROR) << "Message " << 1;
+  BPLOG(INFO) << "Message " << 2;
+  sink.Flush();
+  SetLogSink(previous_sink);
+
+  string output = Output();
+  EXPECT_NE(string::npos,
+            output.find(": async_log_sink_unittest.cc:"));
+  EXPECT_NE(string::npos, output.find(": ERROR: Message 1\n"));
+  EXPECT_NE(string::npos, output.find(": INFO: Message 2\n"));
+  EXPECT_LT(output.find("Message 1"), output.find("Message 2"));
+}
+
+TEST_F(AsyncLogSinkTest, WritesKeyValues) {
+  AsyncLogSink::Options options;
+  options.format = AsyncLogSink::FORMAT_KEY_VALUE;
+  AsyncLogSink sink(output_, options);
+  LogSink* previous_sink = SetLogSink(&sink);
+  BPLOG(ERROR) << "A \"quoted\"\nmessage";
+  sink.Flush();
+  SetLogSink(previous_sink);
+
+  string output = Output();
+  EXPECT_NE(string::npos,
+            output.find(" severity=ERROR file=\"async_log_sink_unittest.cc\""
+                        " line="));
+  EXPECT_NE(string::npos,
+            output.find(" message=\"A \\\"quoted\\\"\\nmessage\"\n"));
+}
+
+TEST_F(AsyncLogSinkTest, LimitsMessagesPerSite) {
+  AsyncLogSink::Options options;
+  options.max_messages_per_site = 3;
+  // A period long enough that the test doesn't cross into the next one.
+  options.period_seconds = 1 << 30;
+  AsyncLogSink sink(output_, options);
+  LogSink* previous_sink = SetLogSink(&sink);
+  int formatted = 0;
+  for (int i = 0; i < 10; ++i) {
+    BPLOG(ERROR) << "Limited " << ++formatted;
+    BPLOG(ERROR) << "Other";
+  }
+  for (int i = 0; i < 2; ++i)
+    BPLOG(CRITICAL) << "Critical";
+  sink.Flush();
+  SetLogSink(previous_sink);
+
+  // The suppressed messages weren't even formatted.
+  EXPECT_EQ(3, formatted);
+  EXPECT_EQ(3U, CountInOutput("Limited"));
+  EXPECT_EQ(3U, CountInOutput("Other"));
+  EXPECT_EQ(2U, CountInOutput("Critical"));
+  EXPECT_EQ(14U, sink.suppressed());
+}
+
+TEST_F(AsyncLogSinkTest, WritesOrCountsConcurrentMessages) {
+  const int kThreads = 4;
+  const int kMessagesPerThread = 2000;
+  AsyncLogSink::Options options;
+  options.capacity = 64;
+  size_t dropped;
+  {
+    AsyncLogSink sink(output_, options);
+    LogSink* previous_sink = SetLogSink(&sink);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < kThreads; ++i) {
+      threads.emplace_back([] {
+        for (int j = 0; j < kMessagesPerThread; ++j)
+          BPLOG(INFO) << "Concurrent " << j;
+      });
+    }
+    for (std::thread& thread : threads)
+      thread.join();
+    SetLogSink(previous_sink);
+    dropped = sink.dropped();
+  }
+
+  // Destroying the sink wrote out what was left.
+  EXPECT_EQ(static_cast<size_t>(kThreads * kMessagesPerThread),
+            CountInOutput("Concurrent ") + dropped);
+  EXPECT_EQ(dropped > 0 ? 1U : 0U,
+            CountInOutput(" log messages with the queue full") ? 1U : 0U);
+}
+
+}  // namespace
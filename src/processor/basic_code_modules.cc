@@ -54,7 +54,7 @@ using std::vector;
 
 BasicCodeModules::BasicCodeModules(const CodeModules* that,
                                    MergeRangeStrategy strategy)
-    : main_address_(0), map_() {
+    : main_address_(0), map_(), index_built_(false), last_hit_(0) {
   BPLOG_IF(ERROR, !that) << "BasicCodeModules::BasicCodeModules requires "
                             "|that|";
   assert(that);
@@ -80,10 +80,12 @@ BasicCodeModules::BasicCodeModules(const CodeModules* that,
 
   // Report modules with shrunk ranges.
   for (unsigned int i = 0; i < count; ++i) {
-    linked_ptr<const CodeModule> module(that->GetModuleAtIndex(i)->Copy());
+    const CodeModule* that_module = that->GetModuleAtIndex(i);
+    linked_ptr<const CodeModule> module;
     uint64_t delta = 0;
-    if (map_.RetrieveRange(module->base_address() + module->size() - 1,
-                           &module, NULL /* base */, &delta, NULL /* size */) &&
+    if (map_.RetrieveRange(
+            that_module->base_address() + that_module->size() - 1, &module,
+            NULL /* base */, &delta, NULL /* size */) &&
         delta > 0) {
       BPLOG(INFO) << "The range for module " << module->code_file()
                   << " was shrunk down by " << HexString(delta) << " bytes.";
@@ -95,9 +97,16 @@ BasicCodeModules::BasicCodeModules(const CodeModules* that,
 
   // TODO(ivanpe): Report modules with conflicting ranges.  The list of such
   // modules should be copied from |that|.
+
+  // Copies are made once per minidump and then consulted for every frame,
+  // so build the index now rather than in the middle of a stack walk.  For
+  // an unloaded module list, whose ranges often overlap, the map has
+  // already truncated them, so the index holds disjoint ranges.
+  EnsureIndex();
 }
 
-BasicCodeModules::BasicCodeModules() : main_address_(0), map_() { }
+BasicCodeModules::BasicCodeModules()
+    : main_address_(0), map_(), index_built_(false), last_hit_(0) { }
 
 BasicCodeModules::~BasicCodeModules() {
 }
@@ -108,14 +117,41 @@ unsigned int BasicCodeModules::module_count() const {
 
 const CodeModule* BasicCodeModules::GetModuleForAddress(
     uint64_t address) const {
-  linked_ptr<const CodeModule> module;
-  if (!map_.RetrieveRange(address, &module, NULL /* base */, NULL /* delta */,
-                          NULL /* size */)) {
+  EnsureIndex();
+
+  const size_t count = index_low_.size();
+  const uint64_t* low = index_low_.data();
+  const uint64_t* high = index_high_.data();
+
+  size_t hit = last_hit_.load(std::memory_order_relaxed);
+  if (hit < count && low[hit] <= address && address <= high[hit])
+    return index_modules_[hit];
+
+  if (count == 0 || address < low[0]) {
     BPLOG(INFO) << "No module at " << HexString(address);
     return NULL;
   }
 
-  return module.get();
+  // Find the last range whose low address is at or below address.  The
+  // loop has a fixed trip count for a given index size and its body
+  // compiles to a conditional move, so it doesn't stall on mispredicted
+  // branches.
+  const uint64_t* base = low;
+  size_t remaining = count;
+  while (remaining > 1) {
+    size_t half = remaining / 2;
+    base = base[half] <= address ? base + half : base;
+    remaining -= half;
+  }
+
+  hit = base - low;
+  if (address > high[hit]) {
+    BPLOG(INFO) << "No module at " << HexString(address);
+    return NULL;
+  }
+
+  last_hit_.store(hit, std::memory_order_relaxed);
+  return index_modules_[hit];
 }
 
 const CodeModule* BasicCodeModules::GetMainModule() const {
@@ -124,22 +160,21 @@ const CodeModule* BasicCodeModules::GetMainModule() const {
 
 const CodeModule* BasicCodeModules::GetModuleAtSequence(
     unsigned int sequence) const {
-  linked_ptr<const CodeModule> module;
-  if (!map_.RetrieveRangeAtIndex(sequence, &module, NULL /* base */,
-                                 NULL /* delta */, NULL /* size */)) {
-    BPLOG(ERROR) << "RetrieveRangeAtIndex failed for sequence " << sequence;
+  EnsureIndex();
+
+  if (sequence >= index_modules_.size()) {
+    BPLOG(ERROR) << "Index out of range: " << sequence << "/"
+                 << index_modules_.size();
     return NULL;
   }
 
-  return module.get();
+  return index_modules_[sequence];
 }
 
 const CodeModule* BasicCodeModules::GetModuleAtIndex(
     unsigned int index) const {
-  // This class stores everything in a RangeMap, without any more-efficient
-  // way to walk the list of CodeModule objects.  Implement GetModuleAtIndex
-  // using GetModuleAtSequence, which meets all of the requirements, and
-  // in addition, guarantees ordering.
+  // The index is kept in address order, which meets all of the requirements
+  // of GetModuleAtIndex, and in addition, guarantees ordering.
   return GetModuleAtSequence(index);
 }
 
@@ -152,4 +187,50 @@ BasicCodeModules::GetShrunkRangeModules() const {
   return shrunk_range_modules_;
 }
 
+void BasicCodeModules::InvalidateIndex() {
+  std::lock_guard<std::mutex> lock(index_lock_);
+  index_built_.store(false, std::memory_order_release);
+  index_low_.clear();
+  index_high_.clear();
+  index_modules_.clear();
+  last_hit_.store(0, std::memory_order_relaxed);
+}
+
+void BasicCodeModules::EnsureIndex() const {
+  if (index_built_.load(std::memory_order_acquire))
+    return;
+
+  std::lock_guard<std::mutex> lock(index_lock_);
+  if (index_built_.load(std::memory_order_relaxed))
+    return;
+
+  // RangeMap has no iterator, and RetrieveRangeAtIndex walks the map from
+  // its start, so collect the ranges from the top down with
+  // RetrieveNearestRange, which costs a single tree search per range.
+  size_t count = map_.GetCount();
+  index_low_.resize(count);
+  index_high_.resize(count);
+  index_modules_.resize(count);
+  uint64_t address = UINT64_MAX;
+  for (size_t i = count; i > 0; --i) {
+    const linked_ptr<const CodeModule>* module;
+    uint64_t base;
+    uint64_t size;
+    if (!map_.RetrieveNearestRange(address, &module, &base, NULL /* delta */,
+                                   &size)) {
+      BPLOG(ERROR) << "RetrieveNearestRange failed building module index";
+      index_low_.clear();
+      index_high_.clear();
+      index_modules_.clear();
+      break;
+    }
+    index_low_[i - 1] = base;
+    index_high_[i - 1] = base + size - 1;
+    index_modules_[i - 1] = module->get();
+    address = base - 1;
+  }
+
+  index_built_.store(true, std::memory_order_release);
+}
+
 }  // namespace google_breakpad
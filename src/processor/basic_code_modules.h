@@ -42,6 +42,8 @@
 
 #include <stddef.h>
 
+#include <atomic>
+#include <mutex>
 #include <vector>
 
 #include "google_breakpad/processor/code_modules.h"
@@ -74,6 +76,11 @@ class BasicCodeModules : public CodeModules {
  protected:
   BasicCodeModules();
 
+  // Discards the lookup index after map_ has been modified.  The index is
+  // rebuilt on the next lookup.  This must not be called while lookups may
+  // be made from other threads.
+  void InvalidateIndex();
+
   // The base address of the main module.
   uint64_t main_address_;
 
@@ -86,6 +93,26 @@ class BasicCodeModules : public CodeModules {
   std::vector<linked_ptr<const CodeModule> > shrunk_range_modules_;
 
  private:
+  // Builds the lookup index from map_ if it is not current.  Safe to call
+  // from several threads at once.
+  void EnsureIndex() const;
+
+  // A flat copy of the ranges in map_, in address order, so that lookups
+  // binary search contiguous arrays instead of walking the map's tree.
+  // index_low_[i] and index_high_[i] are the inclusive bounds of the range
+  // stored for index_modules_[i].  The index is built when the modules are
+  // copied from another CodeModules, or otherwise on first use, and is
+  // immutable until InvalidateIndex.
+  mutable std::vector<uint64_t> index_low_;
+  mutable std::vector<uint64_t> index_high_;
+  mutable std::vector<const CodeModule*> index_modules_;
+  mutable std::atomic<bool> index_built_;
+  mutable std::mutex index_lock_;
+
+  // The position in the index of the module most recently returned by
+  // GetModuleForAddress.  Consecutive lookups usually hit the same module.
+  mutable std::atomic<size_t> last_hit_;
+
   // Disallow copy constructor and assignment operator.
   BasicCodeModules(const BasicCodeModules& that);
   void operator=(const BasicCodeModules& that);
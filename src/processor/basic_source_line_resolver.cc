@@ -41,9 +41,13 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 
+#include <algorithm>
+#include <atomic>
 #include <limits>
 #include <map>
 #include <memory>
+#include <set>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -102,15 +106,186 @@ bool TokenizeWithOptionalField(char* line,
   return true;
 }
 
+// Returns whether line starts a record other than a line or INLINE record,
+// which makes it a place symbol data can be split at for parsing in chunks.
+bool IsChunkBoundary(const char* line) {
+  return strncmp(line, "FUNC ", 5) == 0 ||
+         strncmp(line, "PUBLIC ", 7) == 0 ||
+         strncmp(line, "STACK ", 6) == 0 ||
+         strncmp(line, "FILE ", 5) == 0 ||
+         strncmp(line, "INLINE_ORIGIN ", 14) == 0 ||
+         strncmp(line, "MODULE ", 7) == 0 ||
+         strncmp(line, "INFO ", 5) == 0;
+}
+
+// Returns the start of the first line after position that IsChunkBoundary(),
+// or end if there is none.  The line is always preceded by a line break.
+char* FindChunkBoundary(char* position, char* end) {
+  while (position < end) {
+    char* line_break = static_cast<char*>(
+        memchr(position, '\n', end - position));
+    if (!line_break)
+      return end;
+    char* line = line_break + 1;
+    while (line < end && (*line == '\r' || *line == '\n'))
+      ++line;
+    if (line < end && IsChunkBoundary(line))
+      return line;
+    position = line;
+  }
+  return end;
+}
+
+// Decodes the run of hex digits at *p into *value and advances *p past it.
+// Returns false if the run is empty or longer than max_digits.
+bool ParseHexDigits(const char** p, int max_digits, uint64_t* value) {
+  const char* digit = *p;
+  uint64_t result = 0;
+  for (;; ++digit) {
+    unsigned decimal = static_cast<unsigned char>(*digit) - '0';
+    unsigned letter = (static_cast<unsigned char>(*digit) | 0x20) - 'a';
+    if (decimal < 10)
+      result = result << 4 | decimal;
+    else if (letter < 6)
+      result = result << 4 | (letter + 10);
+    else
+      break;
+  }
+  int count = digit - *p;
+  if (count == 0 || count > max_digits)
+    return false;
+  *value = result;
+  *p = digit;
+  return true;
+}
+
+// Decodes the run of decimal digits at *p into *value and advances *p past
+// it.  Returns false if the run is empty or longer than max_digits.
+bool ParseDecimalDigits(const char** p, int max_digits, long* value) {
+  const char* digit = *p;
+  long result = 0;
+  for (; static_cast<unsigned>(*digit - '0') < 10; ++digit)
+    result = result * 10 + (*digit - '0');
+  int count = digit - *p;
+  if (count == 0 || count > max_digits)
+    return false;
+  *value = result;
+  *p = digit;
+  return true;
+}
+
+// Parses a line record in its usual form, "<address> <size> <line number>
+// <source file id>" with plain digits separated by single spaces and fields
+// short enough that they can't overflow, without tokenizing it.  Returns
+// false for anything else, which SymbolParseHelper::ParseLine() then
+// parses the slow way, so that both accept exactly the same records.
+bool ParseLineFields(const char* line, uint64_t* address, uint64_t* size,
+                     long* line_number, long* source_file) {
+  if (!ParseHexDigits(&line, 16, address) || *line++ != ' ' ||
+      !ParseHexDigits(&line, 16, size) || *line++ != ' ' ||
+      !ParseDecimalDigits(&line, 9, line_number) || *line++ != ' ' ||
+      !ParseDecimalDigits(&line, 9, source_file)) {
+    return false;
+  }
+  return (*line == '\0' || *line == ' ' || *line == '\r' || *line == '\n') &&
+         *address != std::numeric_limits<uint64_t>::max() &&
+         *size != std::numeric_limits<uint64_t>::max();
+}
+
+// Returns the hex number in field as strtoul() would, decoding fields of
+// nothing but hex digits directly.
+unsigned long ParseHexField(const char* field) {
+  const char* end = field;
+  uint64_t value;
+  if (ParseHexDigits(&end, 2 * sizeof(unsigned long), &value) && *end == '\0')
+    return static_cast<unsigned long>(value);
+  return strtoul(field, NULL, 16);
+}
+
 }  // namespace
 
 static const char* kWhitespace = " \r\n";
 static const int kMaxErrorsPrinted = 5;
 static const int kMaxErrorsBeforeBailing = 100;
 
+// Symbol data is parsed concurrently only when there is at least this much
+// for each chunk, and split in this many chunks per thread, so that threads
+// finishing early can pick up more of the work.
+static const size_t kMinParseChunkSize = 64 * 1024;
+static const int kParseChunksPerThread = 4;
+
+// Names copied out of the symbol data are packed into blocks of this size,
+// except for names over a quarter of it, which get a block of their own.
+static const size_t kNameBlockSize = 16 * 1024;
+
+struct BasicSourceLineResolver::Module::ParsedChunk {
+  enum RecordType {
+    PARSE_ERROR,  // Indexes errors.
+    INLINE_PARSE_ERROR,  // Indexes errors.
+    FILE_RECORD,  // Indexes files.
+    INLINE_ORIGIN_RECORD,  // Indexes inline_origins.
+    FUNC_RECORD,  // Indexes functions.
+    PUBLIC_RECORD,  // Indexes public_symbols.
+    STACK_RECORD,  // Indexes stack_infos.
+    SOURCE_RECORD  // Indexes source_records.
+  };
+
+  struct Record {
+    Record(RecordType type, int line_number, size_t index)
+        : type(type), line_number(line_number), index(index) {}
+
+    RecordType type;
+    // The line number within the chunk, starting at 1.
+    int line_number;
+    size_t index;
+  };
+
+  // A line or INLINE record that can't be stored in its function until the
+  // chunk is merged: either it follows a parse error in its function, and
+  // would not be stored if that error stopped the parse, or function is
+  // NULL, and it belongs to the function current at the end of the
+  // previous chunk.  Exactly one of line and in is set, except for lines
+  // of an unknown function that failed to parse.
+  struct SourceRecord {
+    Function* function;
+    linked_ptr<Line> line;
+    linked_ptr<Inline> in;
+  };
+
+  ParsedChunk() : line_count(0) {}
+
+  int line_count;
+  // The records to merge, in the order they appear in the chunk.
+  vector<Record> records;
+  vector<const char*> errors;
+  vector<std::pair<long, char*> > files;
+  vector<std::pair<long, linked_ptr<InlineOrigin> > > inline_origins;
+  // NULL where a FUNC record failed to parse.
+  vector<linked_ptr<Function> > functions;
+  // NULL where a PUBLIC record failed to parse or is ignored.
+  vector<linked_ptr<PublicSymbol> > public_symbols;
+  vector<StackInfo> stack_infos;
+  vector<SourceRecord> source_records;
+};
+
 BasicSourceLineResolver::BasicSourceLineResolver() :
     SourceLineResolverBase(new BasicModuleFactory) { }
 
+void BasicSourceLineResolver::set_parse_concurrency(int parse_concurrency) {
+  static_cast<BasicModuleFactory*>(module_factory_)->set_parse_concurrency(
+      parse_concurrency);
+}
+
+void BasicSourceLineResolver::set_retain_symbol_data(bool retain_symbol_data) {
+  static_cast<BasicModuleFactory*>(module_factory_)->set_retain_symbol_data(
+      retain_symbol_data);
+}
+
+bool BasicSourceLineResolver::ShouldDeleteMemoryBufferAfterLoadModule() {
+  return !static_cast<BasicModuleFactory*>(module_factory_)->
+      retain_symbol_data();
+}
+
 // static
 void BasicSourceLineResolver::Module::LogParseError(
    const string& message,
@@ -128,16 +303,26 @@ void BasicSourceLineResolver::Module::LogParseError(
 bool BasicSourceLineResolver::Module::LoadMapFromMemory(
     char* memory_buffer,
     size_t memory_buffer_size) {
+  return LoadMapFromBuffer(memory_buffer, memory_buffer_size,
+                           retain_symbol_data_);
+}
+
+bool BasicSourceLineResolver::Module::LoadMapFromBuffer(
+    char* memory_buffer,
+    size_t memory_buffer_size,
+    bool buffer_outlives_module) {
+  copy_names_ = !buffer_outlives_module;
   linked_ptr<Function> cur_func;
   int line_number = 0;
   int num_errors = 0;
   int inline_num_errors = 0;
-  char* save_ptr;
+  char* cursor = memory_buffer;
 
   // If the length is 0, we can still pretend we have a symbol file. This is
   // for scenarios that want to test symbol lookup, but don't necessarily care
   // if certain modules do not have any information, like system libraries.
   if (memory_buffer_size == 0) {
+    FreezeMaps();
     return true;
   }
 
@@ -167,8 +352,19 @@ bool BasicSourceLineResolver::Module::LoadMapFromMemory(
        &num_errors);
   }
 
+  if (parse_concurrency_ > 1 &&
+      last_null_terminator >= 2 * kMinParseChunkSize) {
+    LoadMapFromMemoryConcurrently(memory_buffer,
+                                  memory_buffer + last_null_terminator,
+                                  &num_errors,
+                                  &inline_num_errors);
+    FreezeMaps();
+    is_corrupt_ = num_errors > 0;
+    return true;
+  }
+
   char* buffer;
-  buffer = strtok_r(memory_buffer, "\r\n", &save_ptr);
+  buffer = NextLine(&cursor, memory_buffer + last_null_terminator);
 
   while (buffer != NULL) {
     ++line_number;
@@ -186,6 +382,7 @@ bool BasicSourceLineResolver::Module::LoadMapFromMemory(
       if (!cur_func.get()) {
         LogParseError("ParseFunction failed", line_number, &num_errors);
       } else {
+        cur_func->name = StoreName(cur_func->name);
         // StoreRange will fail if the function has an invalid address or size.
         // We'll silently ignore this, the function and any corresponding lines
         // will be destroyed when cur_func is released.
@@ -213,6 +410,9 @@ bool BasicSourceLineResolver::Module::LoadMapFromMemory(
       linked_ptr<Inline> in = ParseInline(buffer);
       if (!in.get())
         LogParseError("ParseInline failed", line_number, &inline_num_errors);
+      else if (!cur_func.get())
+        LogParseError("Found inline data without a function", line_number,
+                      &inline_num_errors);
       else
         cur_func->AppendInline(in);
     } else if (strncmp(buffer, "INLINE_ORIGIN ", 14) == 0) {
@@ -237,12 +437,392 @@ bool BasicSourceLineResolver::Module::LoadMapFromMemory(
     if (num_errors > kMaxErrorsBeforeBailing) {
       break;
     }
-    buffer = strtok_r(NULL, "\r\n", &save_ptr);
+    buffer = NextLine(&cursor, memory_buffer + last_null_terminator);
   }
+  FreezeMaps();
   is_corrupt_ = num_errors > 0;
   return true;
 }
 
+void BasicSourceLineResolver::Module::FreezeMaps() {
+  functions_.Freeze();
+  for (int64_t i = 0; i < functions_.GetCount(); ++i) {
+    const linked_ptr<Function>* function;
+    if (functions_.RetrieveRangeAtIndex(i, &function, NULL /* base */,
+                                        NULL /* delta */, NULL /* size */)) {
+      (*function)->lines.Freeze();
+      (*function)->inlines.Freeze();
+    }
+  }
+  for (int i = 0; i < WindowsFrameInfo::STACK_INFO_LAST; ++i)
+    windows_frame_info_[i].Freeze();
+  public_symbols_.Freeze();
+  cfi_initial_rules_.Freeze();
+  file_names_.clear();
+}
+
+bool BasicSourceLineResolver::Module::LoadMapPartFromMemory(
+    char* memory_buffer,
+    size_t memory_buffer_size,
+    SymbolDataPart part,
+    size_t* part_size) {
+  // Gather the records of part, in order, and parse them as usual.
+  // Dropping the STACK records from between a FUNC record and its line
+  // records leaves the line records with their function.
+  const char* end = static_cast<const char*>(
+      memchr(memory_buffer, '\0', memory_buffer_size));
+  if (!end)
+    end = memory_buffer + memory_buffer_size;
+  string records;
+  for (const char* line = memory_buffer; line < end;) {
+    const char* newline =
+        static_cast<const char*>(memchr(line, '\n', end - line));
+    const char* next = newline ? newline + 1 : end;
+    bool is_unwind_record = next - line >= 6 && strncmp(line, "STACK ", 6) == 0;
+    if (is_unwind_record == (part == UNWIND_RECORDS))
+      records.append(line, next - line);
+    line = next;
+  }
+  records.push_back('\0');
+  *part_size = records.size();
+  return LoadMapFromBuffer(&records[0], records.size(),
+                           false /* buffer_outlives_module */);
+}
+
+bool BasicSourceLineResolver::Module::LoadMapFromIndexedFile(
+    const char* memory_buffer,
+    size_t memory_buffer_size,
+    const SymbolFileIndex& index) {
+  if (index.symbol_file_size() != memory_buffer_size)
+    return false;
+
+  // Gather the records outside the blocks, which the index checks do not
+  // overlap, and parse them as usual.
+  std::vector<const SymbolFileIndex::Block*> blocks;
+  for (size_t i = 0; i < index.functions().size(); ++i)
+    blocks.push_back(&index.functions()[i]);
+  for (size_t i = 0; i < index.cfi().size(); ++i)
+    blocks.push_back(&index.cfi()[i]);
+  std::sort(blocks.begin(), blocks.end(),
+            [](const SymbolFileIndex::Block* a,
+               const SymbolFileIndex::Block* b) {
+              return a->offset < b->offset;
+            });
+  string unindexed;
+  uint64_t position = 0;
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    unindexed.append(memory_buffer + position, blocks[i]->offset - position);
+    position = blocks[i]->offset + blocks[i]->length;
+  }
+  unindexed.append(memory_buffer + position, memory_buffer_size - position);
+  unindexed.push_back('\0');
+  if (!LoadMapFromBuffer(&unindexed[0], unindexed.size(),
+                         false /* buffer_outlives_module */)) {
+    return false;
+  }
+
+  // Store the blocks' ranges in file order, so that overlapping ranges
+  // are dropped just as when parsing the whole file.
+  indexed_data_ = memory_buffer;
+  indexed_function_blocks_ = index.functions();
+  indexed_cfi_blocks_ = index.cfi();
+  for (size_t i = 0; i < indexed_function_blocks_.size(); ++i) {
+    indexed_functions_.StoreRange(indexed_function_blocks_[i].address,
+                                  indexed_function_blocks_[i].size, i);
+  }
+  for (size_t i = 0; i < indexed_cfi_blocks_.size(); ++i) {
+    indexed_cfi_.StoreRange(indexed_cfi_blocks_[i].address,
+                            indexed_cfi_blocks_[i].size, i);
+  }
+  indexed_functions_.Freeze();
+  indexed_cfi_.Freeze();
+  return true;
+}
+
+void BasicSourceLineResolver::Module::LoadMapFromMemoryConcurrently(
+    char* memory_buffer,
+    char* data_end,
+    int* num_errors,
+    int* inline_num_errors) {
+  size_t data_size = data_end - memory_buffer;
+  size_t chunk_size = std::max(
+      data_size / (parse_concurrency_ * kParseChunksPerThread),
+      kMinParseChunkSize);
+
+  // Chunks are null terminated in place of the line break before each
+  // boundary, which NextLine() would have skipped anyway.
+  vector<char*> chunk_starts(1, memory_buffer);
+  char* boundary = memory_buffer;
+  while (static_cast<size_t>(data_end - boundary) > chunk_size) {
+    boundary = FindChunkBoundary(boundary + chunk_size, data_end);
+    if (boundary == data_end)
+      break;
+    boundary[-1] = '\0';
+    chunk_starts.push_back(boundary);
+  }
+
+  vector<ParsedChunk> chunks(chunk_starts.size());
+  std::atomic<size_t> next_chunk(0);
+  auto parse_chunks = [&]() {
+    size_t chunk_index;
+    while ((chunk_index = next_chunk++) < chunks.size()) {
+      char* chunk_end = chunk_index + 1 < chunk_starts.size() ?
+          chunk_starts[chunk_index + 1] - 1 : data_end;
+      ParseChunk(chunk_starts[chunk_index], chunk_end, &chunks[chunk_index]);
+    }
+  };
+  int thread_count = std::min(static_cast<size_t>(parse_concurrency_),
+                              chunks.size());
+  vector<std::thread> threads;
+  for (int i = 1; i < thread_count; ++i) {
+    threads.push_back(std::thread(parse_chunks));
+  }
+  parse_chunks();
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  Function* cur_func = NULL;
+  int first_line_number = 0;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    if (!MergeChunk(chunks[i], first_line_number, &cur_func, num_errors,
+                    inline_num_errors)) {
+      break;
+    }
+    first_line_number += chunks[i].line_count;
+  }
+}
+
+void BasicSourceLineResolver::Module::ParseChunk(char* chunk,
+                                                 char* chunk_end,
+                                                 ParsedChunk* parsed) {
+  // Until the first FUNC or PUBLIC record, lines belong to the function
+  // current at the end of the previous chunk, which is not known yet.
+  bool inherits_func = true;
+  Function* cur_func = NULL;
+  // Whether lines of cur_func have to wait for the merge to be stored.
+  bool defer_source = false;
+  int line_number = 0;
+  int num_errors = 0;
+  char* cursor = chunk;
+
+  auto parse_error = [&](const char* message) {
+    parsed->records.push_back(ParsedChunk::Record(
+        ParsedChunk::PARSE_ERROR, line_number, parsed->errors.size()));
+    parsed->errors.push_back(message);
+    ++num_errors;
+    defer_source = true;
+  };
+  auto inline_parse_error = [&](const char* message) {
+    parsed->records.push_back(ParsedChunk::Record(
+        ParsedChunk::INLINE_PARSE_ERROR, line_number, parsed->errors.size()));
+    parsed->errors.push_back(message);
+  };
+  auto add_record = [&](ParsedChunk::RecordType type, size_t index) {
+    parsed->records.push_back(ParsedChunk::Record(type, line_number, index));
+  };
+  auto defer_source_record = [&](Function* function, Line* line,
+                                 linked_ptr<Inline> in) {
+    add_record(ParsedChunk::SOURCE_RECORD, parsed->source_records.size());
+    ParsedChunk::SourceRecord source;
+    source.function = function;
+    source.line.reset(line);
+    source.in = in;
+    parsed->source_records.push_back(source);
+  };
+
+  char* buffer = NextLine(&cursor, chunk_end);
+  while (buffer != NULL) {
+    ++line_number;
+
+    if (strncmp(buffer, "FILE ", 5) == 0) {
+      long index;
+      char* filename;
+      if (SymbolParseHelper::ParseFile(buffer, &index, &filename)) {
+        add_record(ParsedChunk::FILE_RECORD, parsed->files.size());
+        parsed->files.push_back(make_pair(index, filename));
+      } else {
+        parse_error("ParseFile on buffer failed");
+      }
+    } else if (strncmp(buffer, "STACK ", 6) == 0) {
+      StackInfo stack_info;
+      if (ParseStackInfo(buffer, &stack_info)) {
+        add_record(ParsedChunk::STACK_RECORD, parsed->stack_infos.size());
+        parsed->stack_infos.push_back(stack_info);
+      } else {
+        parse_error("ParseStackInfo failed");
+      }
+    } else if (strncmp(buffer, "FUNC ", 5) == 0) {
+      inherits_func = false;
+      defer_source = false;
+      cur_func = ParseFunction(buffer);
+      add_record(ParsedChunk::FUNC_RECORD, parsed->functions.size());
+      parsed->functions.push_back(linked_ptr<Function>(cur_func));
+      if (!cur_func) {
+        parse_error("ParseFunction failed");
+      }
+    } else if (strncmp(buffer, "PUBLIC ", 7) == 0) {
+      inherits_func = false;
+      defer_source = false;
+      cur_func = NULL;
+
+      bool is_multiple;
+      uint64_t address;
+      long stack_param_size;
+      char* name;
+      add_record(ParsedChunk::PUBLIC_RECORD, parsed->public_symbols.size());
+      if (SymbolParseHelper::ParsePublicSymbol(buffer, &is_multiple, &address,
+                                               &stack_param_size, &name)) {
+        // See ParsePublicSymbol() about public symbols at address 0.
+        parsed->public_symbols.push_back(linked_ptr<PublicSymbol>(
+            address == 0 ? NULL : new PublicSymbol(name, address,
+                                                   stack_param_size,
+                                                   is_multiple)));
+      } else {
+        parsed->public_symbols.push_back(linked_ptr<PublicSymbol>());
+        parse_error("ParsePublicSymbol failed");
+      }
+    } else if (strncmp(buffer, "MODULE ", 7) == 0 ||
+               strncmp(buffer, "INFO ", 5) == 0) {
+      // Ignored, see LoadMapFromMemory().
+    } else if (strncmp(buffer, "INLINE ", 7) == 0) {
+      linked_ptr<Inline> in = ParseInline(buffer);
+      if (!in.get()) {
+        inline_parse_error("ParseInline failed");
+      } else if (inherits_func || (cur_func && defer_source)) {
+        defer_source_record(cur_func, NULL, in);
+      } else if (!cur_func) {
+        inline_parse_error("Found inline data without a function");
+      } else {
+        cur_func->AppendInline(in);
+      }
+    } else if (strncmp(buffer, "INLINE_ORIGIN ", 14) == 0) {
+      bool has_file_id;
+      long origin_id;
+      long source_file_id;
+      char* origin_name;
+      if (SymbolParseHelper::ParseInlineOrigin(buffer, &has_file_id,
+                                               &origin_id, &source_file_id,
+                                               &origin_name)) {
+        add_record(ParsedChunk::INLINE_ORIGIN_RECORD,
+                   parsed->inline_origins.size());
+        parsed->inline_origins.push_back(make_pair(
+            origin_id,
+            linked_ptr<InlineOrigin>(new InlineOrigin(has_file_id,
+                                                      source_file_id,
+                                                      origin_name))));
+      } else {
+        inline_parse_error("ParseInlineOrigin failed");
+      }
+    } else if (inherits_func) {
+      // Whether the line is an error depends on the function it belongs to.
+      defer_source_record(NULL, ParseLine(buffer), linked_ptr<Inline>());
+    } else if (!cur_func) {
+      parse_error("Found source line data without a function");
+    } else {
+      Line* line = ParseLine(buffer);
+      if (!line) {
+        parse_error("ParseLine failed");
+      } else if (defer_source) {
+        defer_source_record(cur_func, line, linked_ptr<Inline>());
+      } else {
+        cur_func->lines.StoreRange(line->address, line->size,
+                                   linked_ptr<Line>(line));
+      }
+    }
+    // Parsing would stop here at the latest, so the rest of the chunk is of
+    // no use.
+    if (num_errors > kMaxErrorsBeforeBailing) {
+      break;
+    }
+    buffer = NextLine(&cursor, chunk_end);
+  }
+  parsed->line_count = line_number;
+}
+
+bool BasicSourceLineResolver::Module::MergeChunk(const ParsedChunk& parsed,
+                                                 int first_line_number,
+                                                 Function** cur_func,
+                                                 int* num_errors,
+                                                 int* inline_num_errors) {
+  for (size_t i = 0; i < parsed.records.size(); ++i) {
+    const ParsedChunk::Record& record = parsed.records[i];
+    int line_number = first_line_number + record.line_number;
+    switch (record.type) {
+      case ParsedChunk::PARSE_ERROR:
+        LogParseError(parsed.errors[record.index], line_number, num_errors);
+        break;
+      case ParsedChunk::INLINE_PARSE_ERROR:
+        LogParseError(parsed.errors[record.index], line_number,
+                      inline_num_errors);
+        break;
+      case ParsedChunk::FILE_RECORD: {
+        const std::pair<long, char*>& file = parsed.files[record.index];
+        files_.insert(make_pair(file.first, StoreFileName(file.second)));
+        break;
+      }
+      case ParsedChunk::INLINE_ORIGIN_RECORD: {
+        const std::pair<long, linked_ptr<InlineOrigin> >& origin =
+            parsed.inline_origins[record.index];
+        origin.second->name = StoreName(origin.second->name);
+        inline_origins_.insert(origin);
+        break;
+      }
+      case ParsedChunk::FUNC_RECORD: {
+        const linked_ptr<Function>& func = parsed.functions[record.index];
+        *cur_func = func.get();
+        if (func.get()) {
+          func->name = StoreName(func->name);
+          // As in LoadMapFromMemory(), StoreRange failing is ignored.
+          functions_.StoreRange(func->address, func->size, func);
+        }
+        break;
+      }
+      case ParsedChunk::PUBLIC_RECORD: {
+        *cur_func = NULL;
+        const linked_ptr<PublicSymbol>& symbol =
+            parsed.public_symbols[record.index];
+        if (!symbol.get())
+          break;
+        symbol->name = StoreName(symbol->name);
+        if (!public_symbols_.Store(symbol->address, symbol)) {
+          LogParseError("ParsePublicSymbol failed", line_number, num_errors);
+        }
+        break;
+      }
+      case ParsedChunk::STACK_RECORD:
+        StoreStackInfo(parsed.stack_infos[record.index]);
+        break;
+      case ParsedChunk::SOURCE_RECORD: {
+        const ParsedChunk::SourceRecord& source =
+            parsed.source_records[record.index];
+        Function* function = source.function ? source.function : *cur_func;
+        if (source.in.get()) {
+          if (!function) {
+            LogParseError("Found inline data without a function", line_number,
+                          inline_num_errors);
+          } else {
+            function->AppendInline(source.in);
+          }
+        } else if (!function) {
+          LogParseError("Found source line data without a function",
+                        line_number, num_errors);
+        } else if (!source.line.get()) {
+          LogParseError("ParseLine failed", line_number, num_errors);
+        } else {
+          function->lines.StoreRange(source.line->address, source.line->size,
+                                     source.line);
+        }
+        break;
+      }
+    }
+    if (*num_errors > kMaxErrorsBeforeBailing) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void BasicSourceLineResolver::Module::ConstructInlineFrames(
     StackFrame* frame,
     MemAddr address,
@@ -258,7 +838,7 @@ void BasicSourceLineResolver::Module::ConstructInlineFrames(
         unique_ptr<StackFrame>(new StackFrame(*frame));
     auto origin = inline_origins_.find(in->get()->origin_id);
     if (origin != inline_origins_.end()) {
-      new_frame->function_name = origin->second->name;
+      new_frame->function_name = origin->second->name.str();
     } else {
       new_frame->function_name = "<name omitted>";
     }
@@ -269,7 +849,7 @@ void BasicSourceLineResolver::Module::ConstructInlineFrames(
     if (in->get()->has_call_site_file_id) {
       auto file = files_.find(in->get()->call_site_file_id);
       if (file != files_.end()) {
-        new_frame->source_file_name = file->second;
+        new_frame->source_file_name = file->second.str();
       }
     }
 
@@ -312,40 +892,154 @@ void BasicSourceLineResolver::Module::LookupAddress(
   // extent of the PUBLIC symbol we find, below. This does mean we
   // need to check that address indeed falls within the function we
   // find; do the range comparison in an overflow-friendly way.
-  linked_ptr<Function> func;
-  linked_ptr<PublicSymbol> public_symbol;
+  // Entries are retrieved by pointer rather than copied, because copying a
+  // linked_ptr modifies it, and lookups may run on several threads at once.
+  const linked_ptr<Function>* func = NULL;
+  const linked_ptr<PublicSymbol>* public_symbol;
   MemAddr function_base;
   MemAddr function_size;
   MemAddr public_address;
-  if (functions_.RetrieveNearestRange(address, &func, &function_base,
-                                      NULL /* delta */, &function_size) &&
+  if (RetrieveNearestFunction(address, &func, &function_base,
+                              &function_size) &&
       address >= function_base && address - function_base < function_size) {
-    frame->function_name = func->name;
+    frame->function_name = (*func)->name.str();
     frame->function_base = frame->module->base_address() + function_base;
-    frame->is_multiple = func->is_multiple;
+    frame->is_multiple = (*func)->is_multiple;
 
-    linked_ptr<Line> line;
+    const linked_ptr<Line>* line;
     MemAddr line_base;
-    if (func->lines.RetrieveRange(address, &line, &line_base, NULL /* delta */,
-                                  NULL /* size */)) {
-      FileMap::const_iterator it = files_.find(line->source_file_id);
+    if ((*func)->lines.RetrieveRange(address, &line, &line_base,
+                                     NULL /* delta */, NULL /* size */)) {
+      FileMap::const_iterator it = files_.find((*line)->source_file_id);
       if (it != files_.end()) {
-        frame->source_file_name = files_.find(line->source_file_id)->second;
+        frame->source_file_name = it->second.str();
       }
-      frame->source_line = line->line;
+      frame->source_line = (*line)->line;
       frame->source_line_base = frame->module->base_address() + line_base;
     }
 
     // Check if this is inlined function call.
     if (inlined_frames) {
-      ConstructInlineFrames(frame, address, func->inlines, inlined_frames);
+      ConstructInlineFrames(frame, address, (*func)->inlines, inlined_frames);
     }
   } else if (public_symbols_.Retrieve(address,
                                       &public_symbol, &public_address) &&
-             (!func.get() || public_address > function_base)) {
-    frame->function_name = public_symbol->name;
+             (!func || public_address > function_base)) {
+    frame->function_name = (*public_symbol)->name.str();
     frame->function_base = frame->module->base_address() + public_address;
-    frame->is_multiple = public_symbol->is_multiple;
+    frame->is_multiple = (*public_symbol)->is_multiple;
+  }
+}
+
+void BasicSourceLineResolver::Module::LookupAddresses(
+    const CodeModule* code_module,
+    const MemAddr* addresses,
+    size_t count,
+    SymbolizedAddresses* results) const {
+  static const char kNameOmitted[] = "<name omitted>";
+  NameInterner names(results);
+
+  // The function covering the last address looked up, and the line within
+  // it.  The addresses are sorted, so an address is usually in the same
+  // function, and often on the same line, as the one before it.
+  const Function* func = NULL;
+  MemAddr function_base = 0;
+  MemAddr function_size = 0;
+  uint32_t function_name_id = SymbolizedAddresses::kNoName;
+  const Line* line = NULL;
+  MemAddr line_base = 0;
+  MemAddr line_size = 0;
+  uint32_t line_file_id = SymbolizedAddresses::kNoName;
+  vector<const linked_ptr<Inline>*> inlines;
+
+  for (size_t i = 0; i < count; ++i) {
+    const MemAddr address = addresses[i];
+    if (i > 0 && address == addresses[i - 1]) {
+      RepeatLastAddress(results);
+      continue;
+    }
+
+    if (!func || address < function_base ||
+        address - function_base >= function_size) {
+      func = NULL;
+      line = NULL;
+      // As in LookupAddress(), the nearest function bounds the extent of
+      // the PUBLIC symbol used when no function covers the address.
+      const linked_ptr<Function>* nearest = NULL;
+      if (RetrieveNearestFunction(address, &nearest, &function_base,
+                                  &function_size) &&
+          address >= function_base &&
+          address - function_base < function_size) {
+        func = nearest->get();
+        function_name_id = names.Intern(func->name);
+      } else {
+        const linked_ptr<PublicSymbol>* public_symbol;
+        MemAddr public_address;
+        if (public_symbols_.Retrieve(address,
+                                     &public_symbol, &public_address) &&
+            (!nearest || public_address > function_base)) {
+          results->function_name_ids.push_back(
+              names.Intern((*public_symbol)->name));
+          results->function_bases.push_back(public_address);
+        } else {
+          results->function_name_ids.push_back(SymbolizedAddresses::kNoName);
+          results->function_bases.push_back(0);
+        }
+        results->file_name_ids.push_back(SymbolizedAddresses::kNoName);
+        results->lines.push_back(0);
+        results->inline_begins.push_back(
+            static_cast<uint32_t>(results->inline_function_name_ids.size()));
+        continue;
+      }
+    }
+
+    if (!line || address < line_base || address - line_base >= line_size) {
+      line = NULL;
+      const linked_ptr<Line>* found;
+      if (func->lines.RetrieveRange(address, &found, &line_base,
+                                    NULL /* delta */, &line_size)) {
+        line = found->get();
+        FileMap::const_iterator it = files_.find(line->source_file_id);
+        line_file_id = it != files_.end() ? names.Intern(it->second)
+                                          : SymbolizedAddresses::kNoName;
+      }
+    }
+
+    results->function_name_ids.push_back(function_name_id);
+    results->function_bases.push_back(function_base);
+    results->file_name_ids.push_back(line ? line_file_id
+                                          : SymbolizedAddresses::kNoName);
+    results->lines.push_back(line ? line->line : 0);
+    const size_t inline_begin = results->inline_function_name_ids.size();
+    results->inline_begins.push_back(static_cast<uint32_t>(inline_begin));
+
+    inlines.clear();
+    if (!func->inlines.RetrieveRanges(address, inlines))
+      continue;
+    for (const linked_ptr<Inline>* in : inlines) {
+      auto origin = inline_origins_.find((*in)->origin_id);
+      results->inline_function_name_ids.push_back(
+          origin != inline_origins_.end()
+              ? names.Intern(origin->second->name)
+              : names.Intern(StringView(kNameOmitted)));
+      MemAddr inline_base = 0;
+      for (const auto& range : (*in)->inline_ranges) {
+        if (address >= range.first && address < range.first + range.second) {
+          inline_base = range.first;
+          break;
+        }
+      }
+      results->inline_function_bases.push_back(inline_base);
+      uint32_t call_site_file_id = SymbolizedAddresses::kNoName;
+      if ((*in)->has_call_site_file_id) {
+        FileMap::const_iterator file = files_.find((*in)->call_site_file_id);
+        if (file != files_.end())
+          call_site_file_id = names.Intern(file->second);
+      }
+      results->inline_file_name_ids.push_back(call_site_file_id);
+      results->inline_lines.push_back((*in)->call_site_line);
+    }
+    RotateInlineSourcePositions(inline_begin, results);
   }
 }
 
@@ -360,12 +1054,12 @@ WindowsFrameInfo* BasicSourceLineResolver::Module::FindWindowsFrameInfo(
   // includes its own program string.
   // WindowsFrameInfo::STACK_INFO_FPO is the older type
   // corresponding to the FPO_DATA struct. See stackwalker_x86.cc.
-  linked_ptr<WindowsFrameInfo> frame_info;
+  const linked_ptr<WindowsFrameInfo>* frame_info;
   if ((windows_frame_info_[WindowsFrameInfo::STACK_INFO_FRAME_DATA]
        .RetrieveRange(address, &frame_info))
       || (windows_frame_info_[WindowsFrameInfo::STACK_INFO_FPO]
           .RetrieveRange(address, &frame_info))) {
-    result->CopyFrom(*frame_info.get());
+    result->CopyFrom(*frame_info->get());
     return result.release();
   }
 
@@ -376,23 +1070,23 @@ WindowsFrameInfo* BasicSourceLineResolver::Module::FindWindowsFrameInfo(
   // below. However, this does mean we need to check that ADDRESS
   // falls within the retrieved function's range; do the range
   // comparison in an overflow-friendly way.
-  linked_ptr<Function> function;
+  const linked_ptr<Function>* function = NULL;
   MemAddr function_base, function_size;
-  if (functions_.RetrieveNearestRange(address, &function, &function_base,
-                                      NULL /* delta */, &function_size) &&
+  if (RetrieveNearestFunction(address, &function, &function_base,
+                              &function_size) &&
       address >= function_base && address - function_base < function_size) {
-    result->parameter_size = function->parameter_size;
+    result->parameter_size = (*function)->parameter_size;
     result->valid |= WindowsFrameInfo::VALID_PARAMETER_SIZE;
     return result.release();
   }
 
   // PUBLIC symbols might have a parameter size. Use the function we
   // found above to limit the range the public symbol covers.
-  linked_ptr<PublicSymbol> public_symbol;
+  const linked_ptr<PublicSymbol>* public_symbol;
   MemAddr public_address;
   if (public_symbols_.Retrieve(address, &public_symbol, &public_address) &&
-      (!function.get() || public_address > function_base)) {
-    result->parameter_size = public_symbol->parameter_size;
+      (!function || public_address > function_base)) {
+    result->parameter_size = (*public_symbol)->parameter_size;
   }
 
   return NULL;
@@ -402,41 +1096,249 @@ CFIFrameInfo* BasicSourceLineResolver::Module::FindCFIFrameInfo(
     const StackFrame* frame) const {
   MemAddr address = frame->instruction - frame->module->base_address();
   MemAddr initial_base, initial_size;
-  string initial_rules;
+  const string* initial_rules;
 
   // Find the initial rule whose range covers this address. That
-  // provides an initial set of register recovery rules. Then, walk
-  // forward from the initial rule's starting address to frame's
-  // instruction address, applying delta rules.
-  if (!cfi_initial_rules_.RetrieveRange(address, &initial_rules, &initial_base,
-                                        NULL /* delta */, &initial_size)) {
+  // provides an initial set of register recovery rules. The rules in
+  // effect at the frame's instruction address are those of the initial
+  // rule with the delta rules from its starting address up to the
+  // instruction applied, which GetCFIRuleStates() works out once for
+  // every address in the range.
+  const CFIRuleStates* states;
+  if (indexed_data_) {
+    const size_t* block;
+    if (!indexed_cfi_.RetrieveRange(address, &block, &initial_base,
+                                    NULL /* delta */, &initial_size)) {
+      return NULL;
+    }
+    states = GetIndexedCFIRuleStates(*block, initial_base, initial_size);
+  } else {
+    if (!cfi_initial_rules_.RetrieveRange(address, &initial_rules,
+                                          &initial_base, NULL /* delta */,
+                                          &initial_size)) {
+      return NULL;
+    }
+    states = GetCFIRuleStates(initial_base, initial_size, *initial_rules);
+  }
+  if (states->empty())
     return NULL;
+
+  // Find the last state starting at or before the frame's address.  The
+  // first state starts at initial_base, which is no greater than address.
+  CFIRuleStates::const_iterator state = std::upper_bound(
+      states->begin(), states->end(), address,
+      [](MemAddr address, const std::pair<MemAddr, CFIFrameInfo>& state) {
+        return address < state.first;
+      });
+  --state;
+  return new CFIFrameInfo(state->second);
+}
+
+const BasicSourceLineResolver::Module::CFIRuleStates*
+BasicSourceLineResolver::Module::GetCFIRuleStates(
+    MemAddr initial_base,
+    MemAddr initial_size,
+    const string& initial_rules) const {
+  const CFIRuleStates* cached = FindCachedCFIRuleStates(initial_base);
+  if (cached)
+    return cached;
+
+  // Parse the rules without holding the lock, so that threads walking
+  // through other functions aren't held up.
+  CFIRuleStates states;
+  ComputeCFIRuleStates(initial_base, initial_size, initial_rules,
+                       cfi_delta_rules_, &states);
+  return CacheCFIRuleStates(initial_base, states);
+}
+
+const BasicSourceLineResolver::Module::CFIRuleStates*
+BasicSourceLineResolver::Module::GetIndexedCFIRuleStates(
+    size_t block,
+    MemAddr initial_base,
+    MemAddr initial_size) const {
+  const CFIRuleStates* cached = FindCachedCFIRuleStates(initial_base);
+  if (cached)
+    return cached;
+
+  // Parse the STACK CFI INIT record and the delta records after it.
+  const SymbolFileIndex::Block& extent = indexed_cfi_blocks_[block];
+  string text(indexed_data_ + extent.offset, extent.length);
+  string initial_rules;
+  std::map<MemAddr, string> delta_rules;
+  char* save_ptr;
+  for (char* line = strtok_r(&text[0], "\r\n", &save_ptr); line;
+       line = strtok_r(NULL, "\r\n", &save_ptr)) {
+    StackInfo stack_info;
+    if (strncmp(line, "STACK ", 6) != 0 || !ParseStackInfo(line, &stack_info))
+      continue;
+    if (stack_info.kind == StackInfo::CFI_INIT)
+      initial_rules = stack_info.rules;
+    else if (stack_info.kind == StackInfo::CFI_DELTA)
+      delta_rules[stack_info.address] = stack_info.rules;
   }
 
-  // Create a frame info structure, and populate it with the rules from
-  // the STACK CFI INIT record.
-  scoped_ptr<CFIFrameInfo> rules(new CFIFrameInfo());
-  if (!ParseCFIRuleSet(initial_rules, rules.get()))
-    return NULL;
+  CFIRuleStates states;
+  ComputeCFIRuleStates(initial_base, initial_size, initial_rules, delta_rules,
+                       &states);
+  return CacheCFIRuleStates(initial_base, states);
+}
 
-  // Find the first delta rule that falls within the initial rule's range.
-  map<MemAddr, string>::const_iterator delta =
-    cfi_delta_rules_.lower_bound(initial_base);
+void BasicSourceLineResolver::Module::ComputeCFIRuleStates(
+    MemAddr initial_base,
+    MemAddr initial_size,
+    const string& initial_rules,
+    const std::map<MemAddr, string>& delta_rules,
+    CFIRuleStates* states) const {
+  CFIFrameInfo rules;
+  if (!ParseCFIRuleSet(initial_rules, &rules))
+    return;
+  states->push_back(std::make_pair(initial_base, rules));
+
+  // Apply the delta rules within the range in turn, recording the rules
+  // in effect from each delta rule's address on.  As before, a delta rule
+  // that fails to parse leaves whatever it managed to apply in place.
+  for (map<MemAddr, string>::const_iterator delta =
+           delta_rules.lower_bound(initial_base);
+       delta != delta_rules.end() &&
+           delta->first - initial_base < initial_size;
+       ++delta) {
+    ParseCFIRuleSet(delta->second, &rules);
+    if (delta->first == states->back().first)
+      states->back().second = rules;
+    else
+      states->push_back(std::make_pair(delta->first, rules));
+  }
+}
+
+const BasicSourceLineResolver::Module::CFIRuleStates*
+BasicSourceLineResolver::Module::FindCachedCFIRuleStates(
+    MemAddr initial_base) const {
+  std::lock_guard<std::mutex> lock(cfi_rule_states_lock_);
+  std::map<MemAddr, CFIRuleStates>::const_iterator cached =
+      cfi_rule_states_.find(initial_base);
+  return cached != cfi_rule_states_.end() ? &cached->second : NULL;
+}
+
+const BasicSourceLineResolver::Module::CFIRuleStates*
+BasicSourceLineResolver::Module::CacheCFIRuleStates(
+    MemAddr initial_base,
+    const CFIRuleStates& states) const {
+  // Another thread may have cached the same range in the meantime, in
+  // which case its states are kept.
+  std::lock_guard<std::mutex> lock(cfi_rule_states_lock_);
+  return &cfi_rule_states_.insert(
+      std::make_pair(initial_base, states)).first->second;
+}
 
-  // Apply delta rules up to and including the frame's address.
-  while (delta != cfi_delta_rules_.end() && delta->first <= address) {
-    ParseCFIRuleSet(delta->second, rules.get());
-    delta++;
+bool BasicSourceLineResolver::Module::RetrieveNearestFunction(
+    MemAddr address,
+    const linked_ptr<Function>** function,
+    MemAddr* function_base,
+    MemAddr* function_size) const {
+  if (!indexed_data_) {
+    return functions_.RetrieveNearestRange(address, function, function_base,
+                                           NULL /* delta */, function_size);
   }
 
-  return rules.release();
+  const size_t* block;
+  if (!indexed_functions_.RetrieveNearestRange(address, &block,
+                                               function_base,
+                                               NULL /* delta */,
+                                               function_size)) {
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(parsed_functions_lock_);
+    std::map<size_t, linked_ptr<Function> >::const_iterator parsed =
+        parsed_functions_.find(*block);
+    if (parsed != parsed_functions_.end()) {
+      *function = &parsed->second;
+      return parsed->second.get() != NULL;
+    }
+  }
+
+  // Parse the block without holding the lock, as GetCFIRuleStates() does.
+  const SymbolFileIndex::Block& extent = indexed_function_blocks_[*block];
+  linked_ptr<Function> parsed(
+      ParseFunctionBlock(indexed_data_ + extent.offset, extent.length));
+  std::lock_guard<std::mutex> lock(parsed_functions_lock_);
+  *function = &parsed_functions_.insert(
+      std::make_pair(*block, parsed)).first->second;
+  return (*function)->get() != NULL;
+}
+
+// static
+BasicSourceLineResolver::Function*
+BasicSourceLineResolver::Module::ParseFunctionBlock(const char* block,
+                                                    size_t length) {
+  string text(block, length);
+  char* save_ptr;
+  char* line = strtok_r(&text[0], "\r\n", &save_ptr);
+  if (!line || strncmp(line, "FUNC ", 5) != 0)
+    return NULL;
+  Function* function = ParseFunction(line);
+  if (!function)
+    return NULL;
+  // Point the name at the same characters in block, which outlives the
+  // module, rather than in text, which is gone once the block is parsed.
+  function->name = StringView(block + (function->name.data() - text.data()),
+                              function->name.size());
+
+  while ((line = strtok_r(NULL, "\r\n", &save_ptr)) != NULL) {
+    if (strncmp(line, "INLINE ", 7) == 0) {
+      linked_ptr<Inline> in = ParseInline(line);
+      if (in.get())
+        function->AppendInline(in);
+    } else {
+      Line* parsed_line = ParseLine(line);
+      if (parsed_line) {
+        function->lines.StoreRange(parsed_line->address, parsed_line->size,
+                                   linked_ptr<Line>(parsed_line));
+      }
+    }
+  }
+  function->lines.Freeze();
+  function->inlines.Freeze();
+  return function;
+}
+
+StringView BasicSourceLineResolver::Module::StoreName(StringView name) {
+  if (!copy_names_ || name.empty())
+    return name;
+  char* copy;
+  if (name.size() > kNameBlockSize / 4) {
+    name_blocks_.push_back(std::unique_ptr<char[]>(new char[name.size()]));
+    copy = name_blocks_.back().get();
+  } else {
+    if (name.size() > name_block_left_) {
+      name_blocks_.push_back(std::unique_ptr<char[]>(new char[kNameBlockSize]));
+      name_block_free_ = name_blocks_.back().get();
+      name_block_left_ = kNameBlockSize;
+    }
+    copy = name_block_free_;
+    name_block_free_ += name.size();
+    name_block_left_ -= name.size();
+  }
+  memcpy(copy, name.data(), name.size());
+  return StringView(copy, name.size());
+}
+
+StringView BasicSourceLineResolver::Module::StoreFileName(StringView name) {
+  if (!copy_names_)
+    return name;
+  std::set<StringView>::const_iterator interned = file_names_.find(name);
+  if (interned != file_names_.end())
+    return *interned;
+  StringView copy = StoreName(name);
+  file_names_.insert(copy);
+  return copy;
 }
 
 bool BasicSourceLineResolver::Module::ParseFile(char* file_line) {
   long index;
   char* filename;
   if (SymbolParseHelper::ParseFile(file_line, &index, &filename)) {
-    files_.insert(make_pair(index, string(filename)));
+    files_.insert(make_pair(index, StoreFileName(filename)));
     return true;
   }
   return false;
@@ -453,7 +1355,8 @@ bool BasicSourceLineResolver::Module::ParseInlineOrigin(
                                            &origin_name)) {
     inline_origins_.insert(make_pair(
         origin_id,
-        new InlineOrigin(has_file_id, source_file_id, origin_name)));
+        new InlineOrigin(has_file_id, source_file_id,
+                         StoreName(origin_name))));
     return true;
   }
   return false;
@@ -523,7 +1426,8 @@ bool BasicSourceLineResolver::Module::ParsePublicSymbol(char* public_line) {
       return true;
     }
 
-    linked_ptr<PublicSymbol> symbol(new PublicSymbol(name, address,
+    linked_ptr<PublicSymbol> symbol(new PublicSymbol(StoreName(name),
+                                                     address,
                                                      stack_param_size,
                                                      is_multiple));
     return public_symbols_.Store(address, symbol);
@@ -532,6 +1436,16 @@ bool BasicSourceLineResolver::Module::ParsePublicSymbol(char* public_line) {
 }
 
 bool BasicSourceLineResolver::Module::ParseStackInfo(char* stack_info_line) {
+  StackInfo stack_info;
+  if (!ParseStackInfo(stack_info_line, &stack_info))
+    return false;
+  StoreStackInfo(stack_info);
+  return true;
+}
+
+// static
+bool BasicSourceLineResolver::Module::ParseStackInfo(char* stack_info_line,
+                                                     StackInfo* stack_info) {
   // Skip "STACK " prefix.
   stack_info_line += 6;
 
@@ -556,39 +1470,24 @@ bool BasicSourceLineResolver::Module::ParseStackInfo(char* stack_info_line) {
     if (stack_frame_info == NULL)
       return false;
 
-    // TODO(mmentovai): I wanted to use StoreRange's return value as this
-    // method's return value, but MSVC infrequently outputs stack info that
-    // violates the containment rules.  This happens with a section of code
-    // in strncpy_s in test_app.cc (testdata/minidump2).  There, problem looks
-    // like this:
-    //   STACK WIN 4 4242 1a a 0 ...  (STACK WIN 4 base size prolog 0 ...)
-    //   STACK WIN 4 4243 2e 9 0 ...
-    // ContainedRangeMap treats these two blocks as conflicting.  In reality,
-    // when the prolog lengths are taken into account, the actual code of
-    // these blocks doesn't conflict.  However, we can't take the prolog lengths
-    // into account directly here because we'd wind up with a different set
-    // of range conflicts when MSVC outputs stack info like this:
-    //   STACK WIN 4 1040 73 33 0 ...
-    //   STACK WIN 4 105a 59 19 0 ...
-    // because in both of these entries, the beginning of the code after the
-    // prolog is at 0x1073, and the last byte of contained code is at 0x10b2.
-    // Perhaps we could get away with storing ranges by rva + prolog_size
-    // if ContainedRangeMap were modified to allow replacement of
-    // already-stored values.
-
-    windows_frame_info_[type].StoreRange(rva, code_size, stack_frame_info);
+    stack_info->kind = StackInfo::WINDOWS;
+    stack_info->type = type;
+    stack_info->address = rva;
+    stack_info->size = code_size;
+    stack_info->windows_frame_info = stack_frame_info;
     return true;
   } else if (strcmp(platform, "CFI") == 0) {
     // DWARF CFI stack frame info
-    return ParseCFIFrameInfo(stack_info_line);
+    return ParseCFIFrameInfo(stack_info_line, stack_info);
   } else {
     // Something unrecognized.
     return false;
   }
 }
 
+// static
 bool BasicSourceLineResolver::Module::ParseCFIFrameInfo(
-    char* stack_info_line) {
+    char* stack_info_line, StackInfo* stack_info) {
   char* cursor;
 
   // Is this an INIT record or a delta record?
@@ -607,9 +1506,10 @@ bool BasicSourceLineResolver::Module::ParseCFIFrameInfo(
     char* initial_rules = strtok_r(NULL, "\r\n", &cursor);
     if (!initial_rules) return false;
 
-    MemAddr address = strtoul(address_field, NULL, 16);
-    MemAddr size    = strtoul(size_field,    NULL, 16);
-    cfi_initial_rules_.StoreRange(address, size, initial_rules);
+    stack_info->kind = StackInfo::CFI_INIT;
+    stack_info->address = ParseHexField(address_field);
+    stack_info->size    = ParseHexField(size_field);
+    stack_info->rules = initial_rules;
     return true;
   }
 
@@ -617,11 +1517,49 @@ bool BasicSourceLineResolver::Module::ParseCFIFrameInfo(
   char* address_field = init_or_address;
   char* delta_rules = strtok_r(NULL, "\r\n", &cursor);
   if (!delta_rules) return false;
-  MemAddr address = strtoul(address_field, NULL, 16);
-  cfi_delta_rules_[address] = delta_rules;
+  stack_info->kind = StackInfo::CFI_DELTA;
+  stack_info->address = ParseHexField(address_field);
+  stack_info->rules = delta_rules;
   return true;
 }
 
+void BasicSourceLineResolver::Module::StoreStackInfo(
+    const StackInfo& stack_info) {
+  switch (stack_info.kind) {
+    case StackInfo::WINDOWS:
+      // TODO(mmentovai): I wanted to use StoreRange's return value as this
+      // method's return value, but MSVC infrequently outputs stack info that
+      // violates the containment rules.  This happens with a section of code
+      // in strncpy_s in test_app.cc (testdata/minidump2).  There, problem
+      // looks like this:
+      //   STACK WIN 4 4242 1a a 0 ...  (STACK WIN 4 base size prolog 0 ...)
+      //   STACK WIN 4 4243 2e 9 0 ...
+      // ContainedRangeMap treats these two blocks as conflicting.  In reality,
+      // when the prolog lengths are taken into account, the actual code of
+      // these blocks doesn't conflict.  However, we can't take the prolog
+      // lengths into account directly here because we'd wind up with a
+      // different set of range conflicts when MSVC outputs stack info like
+      // this:
+      //   STACK WIN 4 1040 73 33 0 ...
+      //   STACK WIN 4 105a 59 19 0 ...
+      // because in both of these entries, the beginning of the code after the
+      // prolog is at 0x1073, and the last byte of contained code is at
+      // 0x10b2.  Perhaps we could get away with storing ranges by
+      // rva + prolog_size if ContainedRangeMap were modified to allow
+      // replacement of already-stored values.
+      windows_frame_info_[stack_info.type].StoreRange(
+          stack_info.address, stack_info.size, stack_info.windows_frame_info);
+      break;
+    case StackInfo::CFI_INIT:
+      cfi_initial_rules_.StoreRange(stack_info.address, stack_info.size,
+                                    stack_info.rules);
+      break;
+    case StackInfo::CFI_DELTA:
+      cfi_delta_rules_[stack_info.address] = stack_info.rules;
+      break;
+  }
+}
+
 bool BasicSourceLineResolver::Function::AppendInline(linked_ptr<Inline> in) {
   // This happends if in's parent wasn't added due to a malformed INLINE record.
   if (in->inline_nest_level > last_added_inline_nest_level + 1)
@@ -845,6 +1783,10 @@ bool SymbolParseHelper::ParseLine(char* line_line, uint64_t* address,
                                   uint64_t* size, long* line_number,
                                   long* source_file) {
   // <address> <size> <line number> <source file id>
+  if (ParseLineFields(line_line, address, size, line_number, source_file)) {
+    return true;
+  }
+
   vector<char*> tokens;
   if (!Tokenize(line_line, kWhitespace, 4, &tokens)) {
     return false;
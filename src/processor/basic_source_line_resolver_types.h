@@ -37,9 +37,15 @@
 #define PROCESSOR_BASIC_SOURCE_LINE_RESOLVER_TYPES_H__
 
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/scoped_ptr.h"
+#include "common/string_view.h"
 #include "google_breakpad/processor/basic_source_line_resolver.h"
 #include "processor/source_line_resolver_base_types.h"
 
@@ -56,7 +62,7 @@ namespace google_breakpad {
 
 struct
 BasicSourceLineResolver::Function : public SourceLineResolverBase::Function {
-  Function(const string& function_name,
+  Function(StringView function_name,
            MemAddr function_address,
            MemAddr code_size,
            int set_parameter_size,
@@ -86,7 +92,10 @@ BasicSourceLineResolver::Function : public SourceLineResolverBase::Function {
 
 class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
  public:
-  explicit Module(const string& name) : name_(name), is_corrupt_(false) { }
+  explicit Module(const string& name)
+      : name_(name), is_corrupt_(false), parse_concurrency_(1),
+        retain_symbol_data_(false), copy_names_(true),
+        name_block_free_(NULL), name_block_left_(0), indexed_data_(NULL) { }
   virtual ~Module() { }
 
   // Loads a map from the given buffer in char* type.
@@ -97,6 +106,40 @@ class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
   virtual bool LoadMapFromMemory(char* memory_buffer,
                                  size_t memory_buffer_size);
 
+  // Splits the symbol data by record, so that each part holds the records
+  // it would hold in a whole module.  A line record stays with the FUNC
+  // record before it, whatever STACK records come in between.
+  virtual bool CanLoadMapParts() const { return true; }
+  virtual bool LoadMapPartFromMemory(char* memory_buffer,
+                                     size_t memory_buffer_size,
+                                     SymbolDataPart part,
+                                     size_t* part_size);
+
+  // Loads the records index does not cover from memory_buffer, and keeps
+  // the index to parse the FUNC and STACK CFI INIT blocks it covers from
+  // memory_buffer as they are looked up.  Parse errors in those blocks
+  // only skip the records in error; IsCorrupt() does not reflect them.
+  virtual bool LoadMapFromIndexedFile(const char* memory_buffer,
+                                      size_t memory_buffer_size,
+                                      const SymbolFileIndex& index);
+
+  // Sets the number of threads LoadMapFromMemory() may parse symbol data
+  // on.  Large buffers are split into chunks at record boundaries, which
+  // are parsed concurrently and then merged in file order, so the result
+  // and the parse errors reported are the same as when parsing serially.
+  // The default, 1, parses on the calling thread.
+  void set_parse_concurrency(int parse_concurrency) {
+    parse_concurrency_ = parse_concurrency;
+  }
+
+  // Sets whether the buffer passed to LoadMapFromMemory() stays alive, and
+  // unmodified, as long as the module.  If so, names point into it; by
+  // default they are copied into blocks owned by the module, with each
+  // distinct file name copied once.
+  void set_retain_symbol_data(bool retain_symbol_data) {
+    retain_symbol_data_ = retain_symbol_data;
+  }
+
   // Tells whether the loaded symbol data is corrupt.  Return value is
   // undefined, if the symbol data hasn't been loaded yet.
   virtual bool IsCorrupt() const { return is_corrupt_; }
@@ -107,6 +150,13 @@ class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
       StackFrame* frame,
       std::deque<std::unique_ptr<StackFrame>>* inlined_frame) const;
 
+  // Looks up a sorted batch of addresses, keeping the function and line
+  // found for one address for the addresses after it that they cover.
+  virtual void LookupAddresses(const CodeModule* code_module,
+                               const MemAddr* addresses,
+                               size_t count,
+                               SymbolizedAddresses* results) const;
+
   // Construct inlined frames for |frame| and store them in |inline_frames|.
   // |frame|'s source line and source file name may be updated if an inlined
   // frame is found inside |frame|. As a result, the innermost inlined frame
@@ -136,7 +186,67 @@ class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
   friend class ModuleComparer;
   friend class ModuleSerializer;
 
-  typedef std::map<int, string> FileMap;
+  typedef std::map<int, StringView> FileMap;
+
+  // A STACK record that has been parsed, but not stored yet.
+  struct StackInfo {
+    enum Kind { WINDOWS, CFI_INIT, CFI_DELTA };
+
+    StackInfo()
+        : kind(WINDOWS), type(0), address(0), size(0), rules(NULL) {}
+
+    Kind kind;
+    // For WINDOWS, the WindowsFrameInfoTypes type of windows_frame_info.
+    int type;
+    MemAddr address;
+    // For WINDOWS and CFI_INIT, the size of the range covered.
+    MemAddr size;
+    linked_ptr<WindowsFrameInfo> windows_frame_info;
+    // For CFI_INIT and CFI_DELTA, the rules, pointing into the symbol data.
+    char* rules;
+  };
+
+  // Symbol data parsed on one thread by LoadMapFromMemoryConcurrently(),
+  // waiting to be merged into the module.  Defined in
+  // basic_source_line_resolver.cc.
+  struct ParsedChunk;
+
+  // Implements LoadMapFromMemory(), copying names out of memory_buffer
+  // unless buffer_outlives_module.
+  bool LoadMapFromBuffer(char* memory_buffer,
+                         size_t memory_buffer_size,
+                         bool buffer_outlives_module);
+
+  // Returns name as the module is to keep it: copied into the module's
+  // name blocks while copy_names_ is set, name itself otherwise.
+  StringView StoreName(StringView name);
+
+  // Like StoreName(), for a file name, which is only copied the first
+  // time it is seen during the load.
+  StringView StoreFileName(StringView name);
+
+  // Implements LoadMapFromMemory() when parsing concurrently.
+  // memory_buffer has been checked to be null terminated, with no null
+  // terminators before data_end.
+  void LoadMapFromMemoryConcurrently(char* memory_buffer,
+                                     char* data_end,
+                                     int* num_errors,
+                                     int* inline_num_errors);
+
+  // Parses the records in the chunk, which is null terminated at chunk_end,
+  // into parsed, without storing anything in the module.  Lines and inlines
+  // are stored into functions, though, as long as nothing parsed later can
+  // affect them.
+  void ParseChunk(char* chunk, char* chunk_end, ParsedChunk* parsed);
+
+  // Stores what ParseChunk() parsed into the module, picking up parsing
+  // state and line numbers where the previous chunk left them.  Returns
+  // false once there are too many errors to carry on.
+  bool MergeChunk(const ParsedChunk& parsed,
+                  int first_line_number,
+                  Function** cur_func,
+                  int* num_errors,
+                  int* inline_num_errors);
 
   // Logs parse errors.  |*num_errors| is increased every time LogParseError is
   // called.
@@ -152,13 +262,26 @@ class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
   bool ParseInlineOrigin(char* inline_origin_line);
 
   // Parses an inline declaration.
-  linked_ptr<Inline> ParseInline(char* inline_line);
+  static linked_ptr<Inline> ParseInline(char* inline_line);
 
   // Parses a function declaration, returning a new Function object.
-  Function* ParseFunction(char* function_line);
+  static Function* ParseFunction(char* function_line);
 
   // Parses a line declaration, returning a new Line object.
-  Line* ParseLine(char* line_line);
+  static Line* ParseLine(char* line_line);
+
+  // Parses a FUNC block of an indexed symbol file: the FUNC record, with
+  // its line and INLINE records.  Returns NULL if the FUNC record does not
+  // parse.
+  static Function* ParseFunctionBlock(const char* block, size_t length);
+
+  // Finds the function covering address, or failing that, the function
+  // nearest below it, as RangeMap::RetrieveNearestRange() does.  Functions
+  // of an indexed module are parsed on first use.
+  bool RetrieveNearestFunction(MemAddr address,
+                               const linked_ptr<Function>** function,
+                               MemAddr* function_base,
+                               MemAddr* function_size) const;
 
   // Parses a PUBLIC symbol declaration, storing it in public_symbols_.
   // Returns false if an error occurs.
@@ -168,8 +291,19 @@ class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
   // it in the appropriate table.
   bool ParseStackInfo(char* stack_info_line);
 
-  // Parses a STACK CFI record, storing it in cfi_frame_info_.
-  bool ParseCFIFrameInfo(char* stack_info_line);
+  // Parses a STACK WIN or STACK CFI frame info declaration into
+  // *stack_info.
+  static bool ParseStackInfo(char* stack_info_line, StackInfo* stack_info);
+
+  // Parses a STACK CFI record into *stack_info.
+  static bool ParseCFIFrameInfo(char* stack_info_line, StackInfo* stack_info);
+
+  // Stores a parsed STACK record in the appropriate table.
+  void StoreStackInfo(const StackInfo& stack_info);
+
+  // Freezes the address-keyed maps once loading is complete, so that
+  // lookups search sorted arrays instead of trees.  See RangeMap::Freeze.
+  void FreezeMaps();
 
   string name_;
   FileMap files_;
@@ -177,6 +311,20 @@ class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
   RangeMap< MemAddr, linked_ptr<Function> > functions_;
   AddressMap< MemAddr, linked_ptr<PublicSymbol> > public_symbols_;
   bool is_corrupt_;
+  int parse_concurrency_;
+  bool retain_symbol_data_;
+
+  // Whether the load in progress copies names out of the symbol data.
+  bool copy_names_;
+
+  // The copies of names that do not point into the symbol data, packed
+  // into blocks that never move, and the unused end of the last block.
+  std::vector<std::unique_ptr<char[]> > name_blocks_;
+  char* name_block_free_;
+  size_t name_block_left_;
+
+  // The file names copied during the load in progress, to intern them.
+  std::set<StringView> file_names_;
 
   // Each element in the array is a ContainedRangeMap for a type
   // listed in WindowsFrameInfoTypes. These are split by type because
@@ -202,6 +350,63 @@ class BasicSourceLineResolver::Module : public SourceLineResolverBase::Module {
   // this map, or the end of the range as given by the cfi_initial_rules_
   // entry (which FindCFIFrameInfo looks up first).
   std::map<MemAddr, string> cfi_delta_rules_;
+
+  // The rule sets in effect throughout a STACK CFI INIT range, parsed from
+  // its initial rules and the delta rules within it: the rules starting
+  // at each address, in address order.  Empty if the initial rules don't
+  // parse.
+  typedef std::vector<std::pair<MemAddr, CFIFrameInfo> > CFIRuleStates;
+
+  // Returns the rule states for the STACK CFI INIT range starting at
+  // initial_base, parsing and caching them the first time the range is
+  // used.  The returned states stay valid for the lifetime of the module.
+  const CFIRuleStates* GetCFIRuleStates(MemAddr initial_base,
+                                        MemAddr initial_size,
+                                        const string& initial_rules) const;
+
+  // Like GetCFIRuleStates(), for the STACK CFI INIT block of an indexed
+  // module at index block, parsing the block the first time it is used.
+  const CFIRuleStates* GetIndexedCFIRuleStates(size_t block,
+                                               MemAddr initial_base,
+                                               MemAddr initial_size) const;
+
+  // Works out the rule states for the STACK CFI INIT range initial_base,
+  // initial_size from initial_rules and the delta_rules within the range.
+  void ComputeCFIRuleStates(MemAddr initial_base,
+                            MemAddr initial_size,
+                            const string& initial_rules,
+                            const std::map<MemAddr, string>& delta_rules,
+                            CFIRuleStates* states) const;
+
+  // Returns the cached rule states for the range starting at initial_base,
+  // or NULL if they have not been worked out yet.
+  const CFIRuleStates* FindCachedCFIRuleStates(MemAddr initial_base) const;
+
+  // Caches states for the range starting at initial_base, unless another
+  // thread cached them first, and returns the cached states.
+  const CFIRuleStates* CacheCFIRuleStates(MemAddr initial_base,
+                                          const CFIRuleStates& states) const;
+
+  // The rule states of the STACK CFI INIT ranges used so far, keyed by the
+  // starting address of the range.  Entries are never removed, so that
+  // lookups can use them without holding cfi_rule_states_lock_.
+  mutable std::map<MemAddr, CFIRuleStates> cfi_rule_states_;
+  mutable std::mutex cfi_rule_states_lock_;
+
+  // For a module loaded by LoadMapFromIndexedFile(), the symbol file
+  // contents, and its FUNC and STACK CFI INIT blocks, with ranges mapping
+  // addresses to their positions in the blocks.  NULL otherwise.
+  const char* indexed_data_;
+  std::vector<SymbolFileIndex::Block> indexed_function_blocks_;
+  std::vector<SymbolFileIndex::Block> indexed_cfi_blocks_;
+  RangeMap<MemAddr, size_t> indexed_functions_;
+  RangeMap<MemAddr, size_t> indexed_cfi_;
+
+  // The functions of an indexed module parsed so far, keyed by their
+  // position in indexed_function_blocks_.  As with cfi_rule_states_,
+  // entries are never removed.
+  mutable std::map<size_t, linked_ptr<Function> > parsed_functions_;
+  mutable std::mutex parsed_functions_lock_;
 };
 
 }  // namespace google_breakpad
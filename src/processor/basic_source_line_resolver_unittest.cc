@@ -32,28 +32,47 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <string.h>
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 
 #include "breakpad_googletest_includes.h"
 #include "common/scoped_ptr.h"
+#include "common/tests/auto_tempdir.h"
 #include "common/using_std_string.h"
 #include "google_breakpad/processor/basic_source_line_resolver.h"
 #include "google_breakpad/processor/code_module.h"
 #include "google_breakpad/processor/stack_frame.h"
 #include "google_breakpad/processor/memory_region.h"
+#include "google_breakpad/processor/symbol_buffer.h"
+#include "google_breakpad/processor/symbolized_addresses.h"
 #include "processor/linked_ptr.h"
 #include "processor/logging.h"
+#include "processor/symbol_file_index.h"
+#include "processor/tokenize.h"
 #include "processor/windows_frame_info.h"
 #include "processor/cfi_frame_info.h"
 
 namespace {
 
+using google_breakpad::AutoTempDir;
 using google_breakpad::BasicSourceLineResolver;
 using google_breakpad::CFIFrameInfo;
 using google_breakpad::CodeModule;
+using google_breakpad::kSymbolFileIndexExtension;
 using google_breakpad::MemoryRegion;
+using google_breakpad::NextLine;
+using google_breakpad::SourceLineResolverInterface;
 using google_breakpad::StackFrame;
+using google_breakpad::SymbolBuffer;
+using google_breakpad::SymbolFileIndex;
+using google_breakpad::SymbolizedAddresses;
 using google_breakpad::WindowsFrameInfo;
 using google_breakpad::scoped_ptr;
 using google_breakpad::SymbolParseHelper;
@@ -420,6 +439,677 @@ TEST_F(TestBasicSourceLineResolver, TestUnload)
   ASSERT_TRUE(resolver.HasModule(&module1));
 }
 
+TEST_F(TestBasicSourceLineResolver, TestConcurrentLookups)
+{
+  TestCodeModule module1("module1");
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+  TestCodeModule module2("module2");
+
+  // Look up module1 from several threads while module2 is repeatedly loaded
+  // and unloaded.  Every lookup must see module1's symbols.
+  const int kLookupThreads = 4;
+  const int kLookups = 1000;
+  std::atomic<int> failures(0);
+  std::vector<std::thread> threads;
+  for (int thread_index = 0; thread_index < kLookupThreads; ++thread_index) {
+    threads.push_back(std::thread([&]() {
+      for (int lookup = 0; lookup < kLookups; ++lookup) {
+        StackFrame frame;
+        frame.instruction = 0x1000;
+        frame.module = &module1;
+        resolver.FillSourceLineInfo(&frame, nullptr);
+        scoped_ptr<CFIFrameInfo> cfi_frame_info(
+            resolver.FindCFIFrameInfo(&frame));
+        if (frame.function_name != "Function1_1" || frame.source_line != 44 ||
+            !resolver.HasModule(&module1)) {
+          ++failures;
+        }
+      }
+    }));
+  }
+  for (int load = 0; load < 50; ++load) {
+    EXPECT_TRUE(resolver.LoadModule(&module2, testdata_dir + "/module2.out"));
+    resolver.UnloadModule(&module2);
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, failures);
+
+  // Loading a module that is already loaded still fails.
+  ASSERT_TRUE(resolver.LoadModule(&module2, testdata_dir + "/module2.out"));
+  ASSERT_FALSE(resolver.LoadModule(&module2, testdata_dir + "/module2.out"));
+}
+
+TEST_F(TestBasicSourceLineResolver, TestMemoryBudget)
+{
+  // Modules are accounted the size of their symbol files, which are parsed
+  // from mappings of the files: 1004 bytes for module1, 663 for module2 and
+  // 91 for module3.
+  resolver.set_memory_budget(1700);
+  TestCodeModule module1("module1");
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+  TestCodeModule module2("module2");
+  ASSERT_TRUE(resolver.LoadModule(&module2, testdata_dir + "/module2.out"));
+  BasicSourceLineResolver::ModuleCacheStats stats =
+      resolver.GetModuleCacheStats();
+  EXPECT_EQ(2U, stats.module_count);
+  EXPECT_EQ(1667U, stats.memory_usage);
+  EXPECT_EQ(0U, stats.evictions);
+
+  // Using module1 makes module2 the least recently used module, so it is
+  // the one evicted to make room for module3.
+  StackFrame frame;
+  frame.instruction = 0x1000;
+  frame.module = &module1;
+  resolver.FillSourceLineInfo(&frame, nullptr);
+  ASSERT_EQ(frame.function_name, "Function1_1");
+  TestCodeModule module3("module3");
+  ASSERT_TRUE(resolver.LoadModule(&module3,
+                                  testdata_dir + "/module3_bad.out"));
+  stats = resolver.GetModuleCacheStats();
+  EXPECT_EQ(2U, stats.module_count);
+  EXPECT_EQ(1095U, stats.memory_usage);
+  EXPECT_EQ(1U, stats.evictions);
+  ASSERT_TRUE(resolver.HasModule(&module3));
+  ASSERT_TRUE(resolver.HasModule(&module1));
+  ASSERT_FALSE(resolver.HasModule(&module2));
+  stats = resolver.GetModuleCacheStats();
+  EXPECT_EQ(2U, stats.hits);
+  EXPECT_EQ(1U, stats.misses);
+
+  // Lowering the budget evicts right away.  module3 was used before module1.
+  resolver.set_memory_budget(1050);
+  ASSERT_FALSE(resolver.HasModule(&module3));
+  ASSERT_TRUE(resolver.HasModule(&module1));
+  stats = resolver.GetModuleCacheStats();
+  EXPECT_EQ(1U, stats.module_count);
+  EXPECT_EQ(1004U, stats.memory_usage);
+  EXPECT_EQ(2U, stats.evictions);
+
+  // An evicted module can be loaded again, and unloading keeps the
+  // accounting straight.
+  resolver.set_memory_budget(0);
+  ASSERT_TRUE(resolver.LoadModule(&module2, testdata_dir + "/module2.out"));
+  resolver.UnloadModule(&module1);
+  stats = resolver.GetModuleCacheStats();
+  EXPECT_EQ(1U, stats.module_count);
+  EXPECT_EQ(663U, stats.memory_usage);
+}
+
+// Returns symbol data for function_count functions of 0x100 bytes each,
+// with enough of every kind of record to be split in many chunks when parsed
+// concurrently.  Every hundredth function has a bad line, and the function
+// at bad_function, if any, is followed by enough bad lines to stop parsing.
+static string MakeLargeSymbolData(int function_count, int bad_function) {
+  string data = "MODULE Linux x86 000000000000000000000000000000000 large\n";
+  char record[128];
+  for (int i = 0; i < function_count; ++i) {
+    unsigned int address = 0x1000 + i * 0x100;
+    if (i % 50 == 0) {
+      snprintf(record, sizeof(record), "FILE %d file%d.cc\n", i / 50, i / 50);
+      data += record;
+    }
+    if (i % 7 == 0) {
+      snprintf(record, sizeof(record), "INLINE_ORIGIN %d inlined%d\n", i, i);
+      data += record;
+    }
+    snprintf(record, sizeof(record), "FUNC %x 100 0 func%d\n", address, i);
+    data += record;
+    if (i % 7 == 0) {
+      snprintf(record, sizeof(record), "INLINE 0 %d %d %d %x 20\n",
+               i, i / 50, i, address + 0x40);
+      data += record;
+    }
+    if (i % 100 == 99)
+      data += "bad line\n";
+    for (int j = 0; j < 2; ++j) {
+      snprintf(record, sizeof(record), "%x 40 %d %d\n",
+               address + j * 0x40, i * 10 + j, i / 50);
+      data += record;
+    }
+    // Lines of a function may follow other records, which is what makes
+    // the lines at the start of a chunk belong to the previous chunk's
+    // current function.
+    snprintf(record, sizeof(record),
+             "STACK CFI INIT %x 100 .cfa: $esp 4 + .ra: .cfa 4 - ^\n",
+             address);
+    data += record;
+    snprintf(record, sizeof(record), "STACK CFI %x .cfa: $esp %d +\n",
+             address + 0x80, 8 + i % 4 * 4);
+    data += record;
+    for (int j = 2; j < 4; ++j) {
+      snprintf(record, sizeof(record), "%x 40 %d %d\n",
+               address + j * 0x40, i * 10 + j, i / 50);
+      data += record;
+    }
+    snprintf(record, sizeof(record),
+             "STACK WIN 4 %x 100 %d 0 0 0 0 0 0 1\n", address, i % 16);
+    data += record;
+    if (i % 13 == 0) {
+      snprintf(record, sizeof(record), "PUBLIC %x 0 public%d\n",
+               0x1000000 + i * 0x10, i);
+      data += record;
+    }
+    if (i == bad_function) {
+      for (int j = 0; j < 150; ++j)
+        data += "bad line\n";
+    }
+  }
+  return data;
+}
+
+// Checks that resolver and expected_resolver give the same results for the
+// functions in MakeLargeSymbolData(function_count, ...) loaded as module.
+static void ExpectSameLookups(BasicSourceLineResolver* resolver,
+                              BasicSourceLineResolver* expected_resolver,
+                              const CodeModule* module,
+                              int function_count) {
+  ASSERT_EQ(expected_resolver->IsModuleCorrupt(module),
+            resolver->IsModuleCorrupt(module));
+  for (int i = 0; i < function_count; ++i) {
+    for (uint64_t offset = 0x10; offset < 0x100; offset += 0x40) {
+      StackFrame frame;
+      frame.instruction = 0x1000 + i * 0x100 + offset;
+      frame.module = module;
+      StackFrame expected_frame = frame;
+      std::deque<std::unique_ptr<StackFrame>> inlined_frames;
+      std::deque<std::unique_ptr<StackFrame>> expected_inlined_frames;
+      resolver->FillSourceLineInfo(&frame, &inlined_frames);
+      expected_resolver->FillSourceLineInfo(&expected_frame,
+                                           &expected_inlined_frames);
+      ASSERT_EQ(expected_frame.function_name, frame.function_name);
+      ASSERT_EQ(expected_frame.source_file_name, frame.source_file_name);
+      ASSERT_EQ(expected_frame.source_line, frame.source_line);
+      ASSERT_EQ(expected_inlined_frames.size(), inlined_frames.size());
+      for (size_t j = 0; j < inlined_frames.size(); ++j) {
+        ASSERT_EQ(expected_inlined_frames[j]->function_name,
+                  inlined_frames[j]->function_name);
+      }
+
+      scoped_ptr<WindowsFrameInfo> windows_frame_info(
+          resolver->FindWindowsFrameInfo(&frame));
+      scoped_ptr<WindowsFrameInfo> expected_windows_frame_info(
+          expected_resolver->FindWindowsFrameInfo(&expected_frame));
+      ASSERT_EQ(expected_windows_frame_info.get() != NULL,
+                windows_frame_info.get() != NULL);
+      if (windows_frame_info.get()) {
+        ASSERT_EQ(expected_windows_frame_info->type_,
+                  windows_frame_info->type_);
+      }
+
+      scoped_ptr<CFIFrameInfo> cfi_frame_info(
+          resolver->FindCFIFrameInfo(&frame));
+      scoped_ptr<CFIFrameInfo> expected_cfi_frame_info(
+          expected_resolver->FindCFIFrameInfo(&expected_frame));
+      ASSERT_EQ(expected_cfi_frame_info.get() != NULL,
+                cfi_frame_info.get() != NULL);
+      if (cfi_frame_info.get()) {
+        ASSERT_EQ(expected_cfi_frame_info->Serialize(),
+                  cfi_frame_info->Serialize());
+      }
+    }
+  }
+}
+
+TEST_F(TestBasicSourceLineResolver, TestConcurrentParsing)
+{
+  const int kFunctionCount = 4000;
+  BasicSourceLineResolver concurrent_resolver;
+  concurrent_resolver.set_parse_concurrency(4);
+
+  TestCodeModule module("large");
+  string data = MakeLargeSymbolData(kFunctionCount, -1);
+  ASSERT_GT(data.size(), 512U * 1024);
+  ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&module, data));
+  ASSERT_TRUE(concurrent_resolver.LoadModuleUsingMapBuffer(&module, data));
+  ASSERT_TRUE(resolver.IsModuleCorrupt(&module));
+  StackFrame frame;
+  frame.instruction = 0x1000 + 2345 * 0x100 + 0xc8;
+  frame.module = &module;
+  concurrent_resolver.FillSourceLineInfo(&frame, nullptr);
+  ASSERT_EQ(frame.function_name, "func2345");
+  ASSERT_EQ(frame.source_file_name, "file46.cc");
+  ASSERT_EQ(frame.source_line, 23453);
+  ExpectSameLookups(&concurrent_resolver, &resolver, &module, kFunctionCount);
+
+  // Parsing stops at the same line when there are too many errors.
+  TestCodeModule bad_module("large_bad");
+  data = MakeLargeSymbolData(kFunctionCount, 2345);
+  ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&bad_module, data));
+  ASSERT_TRUE(concurrent_resolver.LoadModuleUsingMapBuffer(&bad_module,
+                                                           data));
+  ClearSourceLineInfo(&frame);
+  frame.instruction = 0x1000 + 2346 * 0x100;
+  frame.module = &bad_module;
+  concurrent_resolver.FillSourceLineInfo(&frame, nullptr);
+  ASSERT_TRUE(frame.function_name.empty());
+  ExpectSameLookups(&concurrent_resolver, &resolver, &bad_module,
+                    kFunctionCount);
+}
+
+TEST_F(TestBasicSourceLineResolver, TestLoadInParts)
+{
+  const int kFunctionCount = 1000;
+  TestCodeModule module("large");
+  string data = MakeLargeSymbolData(kFunctionCount, -1);
+  ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&module, data));
+
+  // With only the unwind information loaded, frames unwind but get no
+  // functions.
+  BasicSourceLineResolver parts_resolver;
+  std::vector<char> buffer(data.begin(), data.end());
+  buffer.push_back('\0');
+  ASSERT_FALSE(parts_resolver.LoadModuleSymbolsUsingMemoryBuffer(
+      &module, &buffer[0], buffer.size()));
+  ASSERT_TRUE(parts_resolver.LoadModuleUnwindInfoUsingMemoryBuffer(
+      &module, &buffer[0], buffer.size()));
+  ASSERT_TRUE(parts_resolver.HasModule(&module));
+  ASSERT_FALSE(parts_resolver.HasModuleSymbols(&module));
+  size_t unwind_memory_usage =
+      parts_resolver.GetModuleCacheStats().memory_usage;
+  ASSERT_LT(unwind_memory_usage, data.size());
+  StackFrame frame;
+  frame.instruction = 0x1000 + 123 * 0x100 + 0x90;
+  frame.module = &module;
+  parts_resolver.FillSourceLineInfo(&frame, nullptr);
+  ASSERT_TRUE(frame.function_name.empty());
+  scoped_ptr<CFIFrameInfo> cfi_frame_info(
+      parts_resolver.FindCFIFrameInfo(&frame));
+  ASSERT_TRUE(cfi_frame_info.get());
+  ASSERT_EQ(".cfa: $esp 20 + .ra: .cfa 4 - ^", cfi_frame_info->Serialize());
+
+  // Adding the symbols makes the module whole.  Line records separated
+  // from their FUNC record by STACK records still belong to it.
+  std::vector<char> symbols_buffer(data.begin(), data.end());
+  symbols_buffer.push_back('\0');
+  ASSERT_TRUE(parts_resolver.LoadModuleSymbolsUsingMemoryBuffer(
+      &module, &symbols_buffer[0], symbols_buffer.size()));
+  ASSERT_TRUE(parts_resolver.HasModuleSymbols(&module));
+  ASSERT_FALSE(parts_resolver.LoadModuleSymbolsUsingMemoryBuffer(
+      &module, &symbols_buffer[0], symbols_buffer.size()));
+  ASSERT_EQ(data.size() + 2,
+            parts_resolver.GetModuleCacheStats().memory_usage);
+  ExpectSameLookups(&parts_resolver, &resolver, &module, kFunctionCount);
+
+  // The memory budget evicts the symbols of the least recently used module
+  // before any module's unwind information.
+  TestCodeModule other_module("other");
+  buffer.assign(data.begin(), data.end());
+  buffer.push_back('\0');
+  parts_resolver.set_memory_budget(data.size() + 1 + unwind_memory_usage);
+  ASSERT_TRUE(parts_resolver.LoadModuleUnwindInfoUsingMemoryBuffer(
+      &other_module, &buffer[0], buffer.size()));
+  ASSERT_TRUE(parts_resolver.HasModule(&module));
+  ASSERT_FALSE(parts_resolver.HasModuleSymbols(&module));
+  ASSERT_TRUE(parts_resolver.HasModule(&other_module));
+  ASSERT_EQ(2 * unwind_memory_usage,
+            parts_resolver.GetModuleCacheStats().memory_usage);
+  ASSERT_EQ(1U, parts_resolver.GetModuleCacheStats().evictions);
+  cfi_frame_info.reset(parts_resolver.FindCFIFrameInfo(&frame));
+  ASSERT_TRUE(cfi_frame_info.get());
+
+  // Unloading a module unloads both parts.
+  parts_resolver.set_memory_budget(0);
+  symbols_buffer.assign(data.begin(), data.end());
+  symbols_buffer.push_back('\0');
+  ASSERT_TRUE(parts_resolver.LoadModuleSymbolsUsingMemoryBuffer(
+      &other_module, &symbols_buffer[0], symbols_buffer.size()));
+  parts_resolver.UnloadModule(&other_module);
+  ASSERT_FALSE(parts_resolver.HasModuleSymbols(&other_module));
+  ASSERT_EQ(unwind_memory_usage,
+            parts_resolver.GetModuleCacheStats().memory_usage);
+}
+
+TEST_F(TestBasicSourceLineResolver, TestCachedCFIRules)
+{
+  TestCodeModule module("cfi");
+  ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&module,
+      "STACK CFI INIT 1000 100 .cfa: $esp 4 + .ra: .cfa 4 - ^\n"
+      "STACK CFI 1000 .cfa: $esp 8 +\n"
+      "STACK CFI 1010 $ebp: .cfa 8 - ^\n"
+      "STACK CFI 1020 .cfa: $esp\n"
+      "STACK CFI 1030 .cfa: $ebp 8 + $esi:\n"
+      "STACK CFI INIT 2000 10 .cfa: $esp 4 + .ra: .cfa 4 - ^\n"
+      "STACK CFI INIT 3000 10 .cfa\n"));
+
+  // Look the rules up out of order, and more than once, to check that
+  // cached rule sets are picked by address.  The delta rule at 0x1030 is
+  // bad, but the CFA rule before the error still applies.
+  const struct {
+    uint64_t address;
+    const char* rules;
+  } kExpected[] = {
+    { 0x1025, ".cfa: $esp .ra: .cfa 4 - ^ $ebp: .cfa 8 - ^" },
+    { 0x1000, ".cfa: $esp 8 + .ra: .cfa 4 - ^" },
+    { 0x10ff, ".cfa: $ebp 8 + .ra: .cfa 4 - ^ $ebp: .cfa 8 - ^" },
+    { 0x100f, ".cfa: $esp 8 + .ra: .cfa 4 - ^" },
+    { 0x1010, ".cfa: $esp 8 + .ra: .cfa 4 - ^ $ebp: .cfa 8 - ^" },
+    { 0x1000, ".cfa: $esp 8 + .ra: .cfa 4 - ^" },
+    { 0x200f, ".cfa: $esp 4 + .ra: .cfa 4 - ^" },
+  };
+  StackFrame frame;
+  frame.module = &module;
+  scoped_ptr<CFIFrameInfo> cfi_frame_info;
+  for (size_t i = 0; i < sizeof(kExpected) / sizeof(kExpected[0]); ++i) {
+    frame.instruction = kExpected[i].address;
+    cfi_frame_info.reset(resolver.FindCFIFrameInfo(&frame));
+    ASSERT_TRUE(cfi_frame_info.get());
+    ASSERT_EQ(kExpected[i].rules, cfi_frame_info->Serialize());
+  }
+
+  // An initial rule set that doesn't parse gives no rules, every time.
+  frame.instruction = 0x3008;
+  ASSERT_FALSE(resolver.FindCFIFrameInfo(&frame));
+  ASSERT_FALSE(resolver.FindCFIFrameInfo(&frame));
+}
+
+// Returns the records of MakeLargeSymbolData(function_count, -1), less its
+// bad lines, in the order dump_syms writes them: each FUNC record followed
+// by its INLINE and line records, and each STACK CFI INIT record by its
+// STACK CFI records.
+TEST_F(TestBasicSourceLineResolver, TestRetainSymbolData)
+{
+  const int kFunctionCount = 4000;
+  TestCodeModule module("large");
+  string data = MakeLargeSymbolData(kFunctionCount, -1);
+  ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&module, data));
+  ASSERT_TRUE(resolver.ShouldDeleteMemoryBufferAfterLoadModule());
+
+  // By default names are copied, also when parsing concurrently, so the
+  // symbol data can be overwritten once loaded.
+  BasicSourceLineResolver copying_resolver;
+  copying_resolver.set_parse_concurrency(4);
+  std::vector<char> buffer(data.begin(), data.end());
+  buffer.push_back('\0');
+  ASSERT_TRUE(copying_resolver.LoadModuleUsingMemoryBuffer(
+      &module, &buffer[0], buffer.size()));
+  std::fill(buffer.begin(), buffer.end(), 'x');
+  ExpectSameLookups(&copying_resolver, &resolver, &module, kFunctionCount);
+
+  // Otherwise the resolver keeps the symbol data it owns along with the
+  // module, and names point into it.
+  BasicSourceLineResolver retaining_resolver;
+  retaining_resolver.set_retain_symbol_data(true);
+  ASSERT_FALSE(retaining_resolver.ShouldDeleteMemoryBufferAfterLoadModule());
+  ASSERT_TRUE(retaining_resolver.LoadModuleUsingMapBuffer(&module, data));
+  ExpectSameLookups(&retaining_resolver, &resolver, &module, kFunctionCount);
+  retaining_resolver.UnloadModule(&module);
+  ASSERT_FALSE(retaining_resolver.HasModule(&module));
+}
+
+TEST_F(TestBasicSourceLineResolver, TestLoadUsingSymbolBuffer)
+{
+  const int kFunctionCount = 100;
+  TestCodeModule module("large");
+  string data = MakeLargeSymbolData(kFunctionCount, -1);
+  ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&module, data));
+
+  // A resolver that copies names lets go of the buffer once it is parsed.
+  string copy = data;
+  std::shared_ptr<SymbolBuffer> buffer = SymbolBuffer::AdoptString(&copy);
+  BasicSourceLineResolver copying_resolver;
+  ASSERT_TRUE(copying_resolver.LoadModuleUsingSymbolBuffer(&module, buffer));
+  EXPECT_EQ(1, buffer.use_count());
+  ExpectSameLookups(&copying_resolver, &resolver, &module, kFunctionCount);
+
+  // One whose names point into the symbol data holds on to the buffer
+  // rather than copying it, until the module is unloaded.
+  copy = data;
+  buffer = SymbolBuffer::AdoptString(&copy);
+  BasicSourceLineResolver retaining_resolver;
+  retaining_resolver.set_retain_symbol_data(true);
+  ASSERT_TRUE(retaining_resolver.LoadModuleUsingSymbolBuffer(&module, buffer));
+  EXPECT_EQ(2, buffer.use_count());
+  ExpectSameLookups(&retaining_resolver, &resolver, &module, kFunctionCount);
+  retaining_resolver.UnloadModule(&module);
+  EXPECT_EQ(1, buffer.use_count());
+}
+
+TEST_F(TestBasicSourceLineResolver, TestHugePages)
+{
+  const int kFunctionCount = 40000;
+  TestCodeModule module("large");
+  string data = MakeLargeSymbolData(kFunctionCount, -1);
+  ASSERT_GE(data.size(), SymbolBuffer::kHugePageSize);
+  ASSERT_TRUE(resolver.LoadModuleUsingMapBuffer(&module, data));
+
+  // Symbol data the module keeps is copied to huge pages, and the copy is
+  // measured in the module's statistics.
+  string copy = data;
+  std::shared_ptr<SymbolBuffer> buffer = SymbolBuffer::AdoptString(&copy);
+  BasicSourceLineResolver huge_page_resolver;
+  huge_page_resolver.set_retain_symbol_data(true);
+  huge_page_resolver.set_huge_pages(true);
+  ASSERT_TRUE(huge_page_resolver.LoadModuleUsingSymbolBuffer(&module,
+                                                             buffer));
+  EXPECT_EQ(1, buffer.use_count());
+  ExpectSameLookups(&huge_page_resolver, &resolver, &module, kFunctionCount);
+  std::vector<BasicSourceLineResolver::ModuleMemoryStats> stats =
+      huge_page_resolver.GetModuleMemoryStats();
+  ASSERT_EQ(1U, stats.size());
+  EXPECT_EQ("large", stats[0].code_file);
+  EXPECT_EQ(buffer->size(), stats[0].symbol_data_size);
+  EXPECT_GT(stats[0].resident_size, 0U);
+  EXPECT_LE(stats[0].resident_size, stats[0].symbol_data_size);
+  // Whether the system gave huge pages depends on its configuration.
+  EXPECT_LE(stats[0].huge_page_count * SymbolBuffer::kHugePageSize,
+            stats[0].symbol_data_size + SymbolBuffer::kHugePageSize);
+
+  // Without huge pages, the buffer itself is kept.
+  copy = data;
+  buffer = SymbolBuffer::AdoptString(&copy);
+  BasicSourceLineResolver retaining_resolver;
+  retaining_resolver.set_retain_symbol_data(true);
+  ASSERT_TRUE(retaining_resolver.LoadModuleUsingSymbolBuffer(&module, buffer));
+  EXPECT_EQ(2, buffer.use_count());
+  stats = retaining_resolver.GetModuleMemoryStats();
+  ASSERT_EQ(1U, stats.size());
+  EXPECT_EQ(0U, stats[0].huge_page_count);
+}
+
+static string MakeIndexableSymbolData(int function_count) {
+  string data = MakeLargeSymbolData(function_count, -1);
+  string header;
+  string functions;
+  string others;
+  string* function_records = &others;
+  size_t position = 0;
+  while (position < data.size()) {
+    size_t end = data.find('\n', position) + 1;
+    string line = data.substr(position, end - position);
+    position = end;
+    if (line == "bad line\n") {
+      continue;
+    } else if (line.compare(0, 5, "FUNC ") == 0) {
+      function_records = &functions;
+      functions += line;
+    } else if (line.compare(0, 7, "INLINE ") == 0 ||
+               isxdigit(static_cast<unsigned char>(line[0]))) {
+      *function_records += line;
+    } else if (line.compare(0, 5, "FILE ") == 0 ||
+               line.compare(0, 7, "MODULE ") == 0 ||
+               line.compare(0, 14, "INLINE_ORIGIN ") == 0) {
+      header += line;
+    } else {
+      others += line;
+    }
+  }
+  return header + functions + others;
+}
+
+static bool WriteFile(const string& path, const string& contents) {
+  FILE* file = fopen(path.c_str(), "wb");
+  if (!file)
+    return false;
+  bool written =
+      fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+  return fclose(file) == 0 && written;
+}
+
+TEST_F(TestBasicSourceLineResolver, TestIndexedLoad)
+{
+  const int kFunctionCount = 2000;
+  AutoTempDir directory;
+  string symbol_file = directory.path() + "/large.sym";
+  string data = MakeIndexableSymbolData(kFunctionCount);
+  ASSERT_TRUE(WriteFile(symbol_file, data));
+
+  SymbolFileIndex index;
+  ASSERT_TRUE(index.Build(data.data(), data.size()));
+  ASSERT_EQ(static_cast<size_t>(kFunctionCount), index.functions().size());
+  ASSERT_EQ(static_cast<size_t>(kFunctionCount), index.cfi().size());
+  ASSERT_TRUE(WriteFile(symbol_file + kSymbolFileIndexExtension,
+                        index.Serialize()));
+
+  TestCodeModule module("large");
+  BasicSourceLineResolver indexed_resolver;
+  ASSERT_TRUE(resolver.LoadModule(&module, symbol_file));
+  ASSERT_TRUE(indexed_resolver.LoadModuleUsingIndexedFile(&module,
+                                                          symbol_file));
+  ASSERT_FALSE(resolver.IsModuleCorrupt(&module));
+  // Only the records outside the blocks count against the memory budget.
+  ASSERT_EQ(data.size() - index.IndexedLength(),
+            indexed_resolver.GetModuleCacheStats().memory_usage);
+  ASSERT_LT(indexed_resolver.GetModuleCacheStats().memory_usage,
+            data.size() / 4);
+  ExpectSameLookups(&indexed_resolver, &resolver, &module, kFunctionCount);
+  // The blocks parsed for the first lookups serve the second.
+  ExpectSameLookups(&indexed_resolver, &resolver, &module, kFunctionCount);
+
+  // module1.out has line records with no FUNC record, PUBLIC and STACK WIN
+  // records, which stay outside the blocks.
+  string module1_data;
+  char* module1_buffer;
+  size_t module1_size;
+  ASSERT_TRUE(BasicSourceLineResolver::ReadSymbolFile(
+      testdata_dir + "/module1.out", &module1_buffer, &module1_size));
+  module1_data.assign(module1_buffer, module1_size - 1);
+  delete [] module1_buffer;
+  string module1_file = directory.path() + "/module1.sym";
+  ASSERT_TRUE(WriteFile(module1_file, module1_data));
+  ASSERT_TRUE(index.Build(module1_data.data(), module1_data.size()));
+  ASSERT_TRUE(WriteFile(module1_file + kSymbolFileIndexExtension,
+                        index.Serialize()));
+  TestCodeModule module1("module1");
+  ASSERT_TRUE(resolver.LoadModule(&module1, module1_file));
+  ASSERT_TRUE(indexed_resolver.LoadModuleUsingIndexedFile(&module1,
+                                                          module1_file));
+  for (uint64_t address = 0xf00; address < 0xa100; address += 2) {
+    StackFrame frame;
+    frame.instruction = address;
+    frame.module = &module1;
+    StackFrame expected_frame = frame;
+    indexed_resolver.FillSourceLineInfo(&frame, nullptr);
+    resolver.FillSourceLineInfo(&expected_frame, nullptr);
+    ASSERT_EQ(expected_frame.function_name, frame.function_name);
+    ASSERT_EQ(expected_frame.function_base, frame.function_base);
+    ASSERT_EQ(expected_frame.source_line, frame.source_line);
+    scoped_ptr<WindowsFrameInfo> windows_frame_info(
+        indexed_resolver.FindWindowsFrameInfo(&frame));
+    scoped_ptr<WindowsFrameInfo> expected_windows_frame_info(
+        resolver.FindWindowsFrameInfo(&expected_frame));
+    ASSERT_EQ(expected_windows_frame_info.get() != NULL,
+              windows_frame_info.get() != NULL);
+    if (windows_frame_info.get()) {
+      ASSERT_EQ(expected_windows_frame_info->parameter_size,
+                windows_frame_info->parameter_size);
+    }
+    scoped_ptr<CFIFrameInfo> cfi_frame_info(
+        indexed_resolver.FindCFIFrameInfo(&frame));
+    scoped_ptr<CFIFrameInfo> expected_cfi_frame_info(
+        resolver.FindCFIFrameInfo(&expected_frame));
+    ASSERT_EQ(expected_cfi_frame_info.get() != NULL,
+              cfi_frame_info.get() != NULL);
+    if (cfi_frame_info.get()) {
+      ASSERT_EQ(expected_cfi_frame_info->Serialize(),
+                cfi_frame_info->Serialize());
+    }
+  }
+}
+
+TEST_F(TestBasicSourceLineResolver, TestLoadFileWithoutFinalNewline)
+{
+  // A file is parsed from a mapping only if overwriting its last byte with
+  // a null terminator costs nothing, so a last record with no line break
+  // after it survives.
+  AutoTempDir directory;
+  string symbol_file = directory.path() + "/unterminated.sym";
+  ASSERT_TRUE(WriteFile(symbol_file,
+                        "MODULE Linux x86 000000000000000000000000000000000 "
+                        "unterminated\n"
+                        "PUBLIC 1000 0 last_public"));
+  TestCodeModule module("unterminated");
+  ASSERT_TRUE(resolver.LoadModule(&module, symbol_file));
+  StackFrame frame;
+  frame.instruction = 0x1000;
+  frame.module = &module;
+  resolver.FillSourceLineInfo(&frame, nullptr);
+  EXPECT_EQ("last_public", frame.function_name);
+}
+
+TEST_F(TestBasicSourceLineResolver, TestIndexedLoadFallback)
+{
+  AutoTempDir directory;
+  string symbol_file = directory.path() + "/large.sym";
+  string data = MakeIndexableSymbolData(100);
+  ASSERT_TRUE(WriteFile(symbol_file, data));
+
+  // Without an index, the whole file is loaded.
+  TestCodeModule module("large");
+  ASSERT_TRUE(resolver.LoadModuleUsingIndexedFile(&module, symbol_file));
+  ASSERT_EQ(data.size(), resolver.GetModuleCacheStats().memory_usage);
+  resolver.UnloadModule(&module);
+
+  // Nor is an index written for another version of the file used.
+  SymbolFileIndex index;
+  ASSERT_TRUE(index.Build(data.data(), data.size() - 1));
+  string index_file = symbol_file + kSymbolFileIndexExtension;
+  ASSERT_TRUE(WriteFile(index_file, index.Serialize()));
+  ASSERT_TRUE(resolver.LoadModuleUsingIndexedFile(&module, symbol_file));
+  ASSERT_EQ(data.size(), resolver.GetModuleCacheStats().memory_usage);
+  resolver.UnloadModule(&module);
+
+  ASSERT_TRUE(WriteFile(index_file, "SYMINDEX 1\nFUNC 1000 100 0 2\n"));
+  ASSERT_TRUE(resolver.LoadModuleUsingIndexedFile(&module, symbol_file));
+  ASSERT_EQ(data.size(), resolver.GetModuleCacheStats().memory_usage);
+  StackFrame frame;
+  frame.instruction = 0x1000 + 42 * 0x100;
+  frame.module = &module;
+  resolver.FillSourceLineInfo(&frame, nullptr);
+  ASSERT_EQ("func42", frame.function_name);
+}
+
+TEST(SymbolFileIndex, SerializeAndParse) {
+  string data = MakeIndexableSymbolData(20);
+  SymbolFileIndex index;
+  ASSERT_TRUE(index.Build(data.data(), data.size()));
+  SymbolFileIndex parsed;
+  ASSERT_TRUE(parsed.Parse(index.Serialize()));
+  ASSERT_EQ(data.size(), parsed.symbol_file_size());
+  ASSERT_EQ(index.functions().size(), parsed.functions().size());
+  for (size_t i = 0; i < index.functions().size(); ++i) {
+    ASSERT_EQ(index.functions()[i].address, parsed.functions()[i].address);
+    ASSERT_EQ(index.functions()[i].size, parsed.functions()[i].size);
+    ASSERT_EQ(index.functions()[i].offset, parsed.functions()[i].offset);
+    ASSERT_EQ(index.functions()[i].length, parsed.functions()[i].length);
+  }
+  ASSERT_EQ(index.cfi().size(), parsed.cfi().size());
+  ASSERT_EQ(index.IndexedLength(), parsed.IndexedLength());
+
+  // Blocks must lie within the symbol file and not overlap.
+  ASSERT_TRUE(parsed.Parse("SYMINDEX 10\nFUNC 1 1 0 8\nCFI 1 1 8 8\n"));
+  ASSERT_FALSE(parsed.Parse("SYMINDEX 10\nFUNC 1 1 0 9\nCFI 1 1 8 8\n"));
+  ASSERT_FALSE(parsed.Parse("SYMINDEX 10\nFUNC 1 1 8 9\n"));
+  ASSERT_FALSE(parsed.Parse("SYMINDEX 10\nLINE 1 1 0 8\n"));
+  ASSERT_FALSE(parsed.Parse("FUNC 1 1 0 8\n"));
+
+  // Records parted from the records they belong to can't be indexed.
+  data = MakeLargeSymbolData(20, -1);
+  ASSERT_FALSE(index.Build(data.data(), data.size()));
+  ASSERT_TRUE(index.functions().empty());
+}
+
 TEST_F(TestBasicSourceLineResolver, TestLoadAndResolveOldInlines) {
   TestCodeModule module("linux_inline");
   ASSERT_TRUE(resolver.LoadModule(
@@ -510,7 +1200,96 @@ TEST_F(TestBasicSourceLineResolver, TestLoadAndResolveNewInlines) {
   ASSERT_EQ(inlined_frames[0]->trust, StackFrame::FRAME_TRUST_INLINE);
 }
 
-// Test parsing of valid FILE lines.  The format is:
+// Checks that SymbolizeAddresses() gives for each of addresses what
+// FillSourceLineInfo() fills in.
+void ExpectSymbolizedLikeFrames(SourceLineResolverInterface* resolver,
+                                const CodeModule* module,
+                                const std::vector<uint64_t>& addresses) {
+  SymbolizedAddresses results;
+  ASSERT_TRUE(resolver->SymbolizeAddresses(module, addresses.data(),
+                                           addresses.size(), &results));
+  ASSERT_EQ(addresses.size(), results.size());
+  ASSERT_EQ(addresses.size(), results.inline_begins.size());
+  for (size_t i = 0; i < addresses.size(); ++i) {
+    SCOPED_TRACE(addresses[i]);
+    StackFrame frame;
+    frame.instruction = module->base_address() + addresses[i];
+    frame.module = module;
+    std::deque<std::unique_ptr<StackFrame>> inlined_frames;
+    resolver->FillSourceLineInfo(&frame, &inlined_frames);
+
+    uint32_t id = results.function_name_ids[i];
+    EXPECT_EQ(frame.function_name,
+              id == SymbolizedAddresses::kNoName ? "" : results.name(id));
+    if (!frame.function_name.empty()) {
+      EXPECT_EQ(frame.function_base - module->base_address(),
+                results.function_bases[i]);
+    }
+    id = results.file_name_ids[i];
+    EXPECT_EQ(frame.source_file_name,
+              id == SymbolizedAddresses::kNoName ? "" : results.name(id));
+    EXPECT_EQ(frame.source_line, results.lines[i]);
+
+    size_t begin = results.inline_begins[i];
+    size_t end = i + 1 < addresses.size() ? results.inline_begins[i + 1]
+                                          : results.inline_lines.size();
+    ASSERT_EQ(inlined_frames.size(), end - begin);
+    for (size_t j = 0; j < inlined_frames.size(); ++j) {
+      const StackFrame& inlined = *inlined_frames[j];
+      EXPECT_EQ(inlined.function_name,
+                results.name(results.inline_function_name_ids[begin + j]));
+      EXPECT_EQ(inlined.function_base - module->base_address(),
+                results.inline_function_bases[begin + j]);
+      id = results.inline_file_name_ids[begin + j];
+      EXPECT_EQ(inlined.source_file_name,
+                id == SymbolizedAddresses::kNoName ? "" : results.name(id));
+      EXPECT_EQ(inlined.source_line, results.inline_lines[begin + j]);
+    }
+  }
+}
+
+TEST_F(TestBasicSourceLineResolver, TestSymbolizeAddresses) {
+  TestCodeModule module1("module1");
+  std::vector<uint64_t> addresses;
+  EXPECT_FALSE(resolver.SymbolizeAddresses(&module1, addresses.data(),
+                                           addresses.size(), NULL));
+  ASSERT_TRUE(resolver.LoadModule(&module1, testdata_dir + "/module1.out"));
+
+  // Functions, lines, the gaps between them, and the public symbol, with
+  // some addresses repeated.
+  for (uint64_t address = 0xf00; address < 0x3100; address += 0x13) {
+    addresses.push_back(address);
+    if (address % 3 == 0)
+      addresses.push_back(address);
+  }
+  ExpectSymbolizedLikeFrames(&resolver, &module1, addresses);
+
+  TestCodeModule inline_module("linux_inline");
+  ASSERT_TRUE(resolver.LoadModule(
+      &inline_module,
+      testdata_dir + "/symbols/linux_inline/BBA6FA10B8AAB33D00000000000000000/"
+                     "linux_inline.new.sym"));
+  addresses.clear();
+  for (uint64_t address = 0x15b20; address < 0x16210; address += 3)
+    addresses.push_back(address);
+  ExpectSymbolizedLikeFrames(&resolver, &inline_module, addresses);
+
+  // Names keep their ids from one batch to the next.
+  SymbolizedAddresses results;
+  uint64_t address = 0x161b6;
+  ASSERT_TRUE(resolver.SymbolizeAddresses(&inline_module, &address, 1,
+                                          &results));
+  uint32_t main_id = results.function_name_ids[0];
+  EXPECT_EQ("main", results.name(main_id));
+  size_t names = results.name_count();
+  results.ClearColumns();
+  ASSERT_TRUE(resolver.SymbolizeAddresses(&inline_module, &address, 1,
+                                          &results));
+  EXPECT_EQ(main_id, results.function_name_ids[0]);
+  EXPECT_EQ(names, results.name_count());
+}
+
+// Test parsing of valid FILE lines.  The format is:// Test parsing of valid FILE lines.  The format is:
 // FILE <id> <filename>
 TEST(SymbolParseHelper, ParseFileValid) {
   long index;
@@ -692,6 +1471,24 @@ TEST(SymbolParseHelper, ParseLineValid) {
   EXPECT_EQ(0xa2ULL, size);
   EXPECT_EQ(0, line_number);
   EXPECT_EQ(4, source_file);
+
+  // Lines out of the usual form are parsed the slow way, which accepts
+  // them all the same.
+  char kTestLine3[] = "0xA1  00000000000000000a2 +3 0004\r";
+  ASSERT_TRUE(SymbolParseHelper::ParseLine(kTestLine3, &address, &size,
+                                           &line_number, &source_file));
+  EXPECT_EQ(0xa1ULL, address);
+  EXPECT_EQ(0xa2ULL, size);
+  EXPECT_EQ(3, line_number);
+  EXPECT_EQ(4, source_file);
+
+  char kTestLine4[] = "fffffffffffffffe FFFFFFFFFFFFFFFE 1234567890 5";
+  ASSERT_TRUE(SymbolParseHelper::ParseLine(kTestLine4, &address, &size,
+                                           &line_number, &source_file));
+  EXPECT_EQ(0xfffffffffffffffeULL, address);
+  EXPECT_EQ(0xfffffffffffffffeULL, size);
+  EXPECT_EQ(1234567890, line_number);
+  EXPECT_EQ(5, source_file);
 }
 
 // Test parsing of invalid lines.  The format is:
@@ -738,6 +1535,53 @@ TEST(SymbolParseHelper, ParseLineInvalid) {
   char kTestLine8[] = "1 2 3 f";
   ASSERT_FALSE(SymbolParseHelper::ParseLine(kTestLine8, &address, &size,
                                             &line_number, &source_file));
+  // Test maximum address and size.
+  char kTestLine9[] = "ffffffffffffffff 2 3 4";
+  ASSERT_FALSE(SymbolParseHelper::ParseLine(kTestLine9, &address, &size,
+                                            &line_number, &source_file));
+  char kTestLine10[] = "1 ffffffffffffffff 3 4";
+  ASSERT_FALSE(SymbolParseHelper::ParseLine(kTestLine10, &address, &size,
+                                            &line_number, &source_file));
+  // Test a bad character right after the source file id.
+  char kTestLine11[] = "1 2 3 4z";
+  ASSERT_FALSE(SymbolParseHelper::ParseLine(kTestLine11, &address, &size,
+                                            &line_number, &source_file));
+}
+
+// NextLine() splits text into the same lines as strtok_r() does, whatever
+// the line lengths.
+TEST(NextLine, SplitsLikeStrtok) {
+  string text =
+      "\r\nFUNC 1000 10 0 a_function_with_a_rather_long_name\r\n"
+      "1000 4 1 0\n\n\n"
+      "1004 c 2 0\r"
+      "a line whose break falls right on the sixteenth byte\n"
+      "0123456789abcde\n"
+      "0123456789abcdef\n"
+      "unterminated last line";
+  for (size_t length = 0; length <= text.size(); ++length) {
+    string expected_text = text.substr(0, length);
+    string actual_text = expected_text;
+    std::vector<string> expected;
+    char* save_ptr;
+    for (char* line = strtok_r(&expected_text[0], "\r\n", &save_ptr); line;
+         line = strtok_r(NULL, "\r\n", &save_ptr)) {
+      expected.push_back(line);
+    }
+    std::vector<string> actual;
+    char* cursor = &actual_text[0];
+    char* end = cursor + length;
+    while (char* line = NextLine(&cursor, end))
+      actual.push_back(line);
+    EXPECT_EQ(expected, actual) << "length " << length;
+  }
+
+  // Lines end at a null terminator, as they do for strtok_r().
+  char kText[] = "first\nsecond\0third\n";
+  char* cursor = kText;
+  EXPECT_STREQ("first", NextLine(&cursor, kText + sizeof(kText) - 1));
+  EXPECT_STREQ("second", NextLine(&cursor, kText + sizeof(kText) - 1));
+  EXPECT_EQ(NULL, NextLine(&cursor, kText + sizeof(kText) - 1));
 }
 
 // Test parsing of valid PUBLIC lines.  The format is:
@@ -37,12 +37,103 @@
 #endif
 
 #include "google_breakpad/processor/call_stack.h"
+
+#include <stdlib.h>
+
 #include "google_breakpad/processor/stack_frame.h"
 
 namespace google_breakpad {
 
+// Hands out memory for StackFrame objects from large blocks, which are
+// freed all at once.
+class StackFrameArena : public StackFrameAllocator {
+ public:
+  StackFrameArena() : blocks_(), large_allocations_(), next_(NULL),
+                      remaining_(0) {}
+  virtual ~StackFrameArena() { Reset(false); }
+
+  virtual void* Allocate(size_t size);
+
+  // Frees every block, or every block but the first if keep_first_block is
+  // true, so that a reused CallStack allocates nothing for small stacks.
+  void Reset(bool keep_first_block);
+
+ private:
+  // The size of each block.  A thread's frames usually fit in one.
+  static const size_t kBlockSize = 64 * 1024;
+
+  vector<char*> blocks_;
+
+  // Allocations too large for a block, which get one of their own.
+  vector<char*> large_allocations_;
+
+  // The unused part of the last block.
+  char* next_;
+  size_t remaining_;
+};
+
+namespace {
+
+// Allocations are padded to a multiple of this, so that each one stays
+// aligned for any type.
+const size_t kArenaAlignment = alignof(max_align_t);
+
+size_t RoundUpToAlignment(size_t size) {
+  return (size + kArenaAlignment - 1) & ~(kArenaAlignment - 1);
+}
+
+}  // namespace
+
+void* StackFrameArena::Allocate(size_t size) {
+  size = RoundUpToAlignment(size);
+  if (size > kBlockSize) {
+    char* allocation = static_cast<char*>(malloc(size));
+    if (allocation)
+      large_allocations_.push_back(allocation);
+    return allocation;
+  }
+
+  if (size > remaining_) {
+    char* block = static_cast<char*>(malloc(kBlockSize));
+    if (!block)
+      return NULL;
+    blocks_.push_back(block);
+    next_ = block;
+    remaining_ = kBlockSize;
+  }
+  void* allocation = next_;
+  next_ += size;
+  remaining_ -= size;
+  return allocation;
+}
+
+void StackFrameArena::Reset(bool keep_first_block) {
+  for (size_t i = 0; i < large_allocations_.size(); ++i) {
+    free(large_allocations_[i]);
+  }
+  large_allocations_.clear();
+
+  size_t kept_blocks = keep_first_block && !blocks_.empty() ? 1 : 0;
+  for (size_t i = kept_blocks; i < blocks_.size(); ++i) {
+    free(blocks_[i]);
+  }
+  blocks_.resize(kept_blocks);
+  next_ = kept_blocks ? blocks_[0] : NULL;
+  remaining_ = kept_blocks ? kBlockSize : 0;
+}
+
+CallStack::FrameAllocationScope::FrameAllocationScope(CallStack* stack)
+    : previous_allocator_(StackFrameAllocator::current()) {
+  StackFrameAllocator::current() = stack->arena_;
+}
+
+CallStack::FrameAllocationScope::~FrameAllocationScope() {
+  StackFrameAllocator::current() = previous_allocator_;
+}
+
 CallStack::~CallStack() {
   Clear();
+  delete arena_;
 }
 
 void CallStack::Clear() {
@@ -51,7 +142,17 @@ void CallStack::Clear() {
        ++iterator) {
     delete *iterator;
   }
+  frames_.clear();
+  if (arena_)
+    arena_->Reset(true);
   tid_ = 0;
+  truncated_ = false;
+  ended_at_terminal_frame_ = false;
+}
+
+void CallStack::EnableFrameArena() {
+  if (!arena_)
+    arena_ = new StackFrameArena();
 }
 
 }  // namespace google_breakpad
@@ -35,8 +35,6 @@
 #ifndef PROCESSOR_CFI_FRAME_INFO_INL_H_
 #define PROCESSOR_CFI_FRAME_INFO_INL_H_
 
-#include <string.h>
-
 namespace google_breakpad {
 
 template <typename RegisterType, class RawContextType>
@@ -47,51 +45,47 @@ bool SimpleCFIWalker<RegisterType, RawContextType>::FindCallerRegisters(
     int callee_validity,
     RawContextType* caller_context,
     int* caller_validity) const {
-  typedef CFIFrameInfo::RegisterValueMap<RegisterType> ValueMap;
-  ValueMap callee_registers;
-  ValueMap caller_registers;
-  // Just for brevity.
-  typename ValueMap::const_iterator caller_none = caller_registers.end();
+  RegisterType callee_registers[CFIFrameInfo::kMaxRegisters];
+  bool callee_register_validity[CFIFrameInfo::kMaxRegisters];
+  RegisterType caller_registers[CFIFrameInfo::kMaxRegisters];
+  bool caller_register_validity[CFIFrameInfo::kMaxRegisters];
+  if (map_size_ > CFIFrameInfo::kMaxRegisters)
+    return false;
 
   // Populate callee_registers with register values from callee_context.
   for (size_t i = 0; i < map_size_; i++) {
     const RegisterSet& r = register_map_[i];
-    if (callee_validity & r.validity_flag)
-      callee_registers[r.name] = callee_context.*r.context_member;
+    callee_register_validity[i] = (callee_validity & r.validity_flag) != 0;
+    callee_registers[i] = callee_context.*r.context_member;
   }
 
   // Apply the rules, and see what register values they yield.
-  if (!cfi_frame_info.FindCallerRegs<RegisterType>(callee_registers, memory,
-                                                   &caller_registers))
+  if (!cfi_frame_info.FindCallerRegs<RegisterType>(register_names_.data(),
+                                                   map_size_,
+                                                   callee_registers,
+                                                   callee_register_validity,
+                                                   memory,
+                                                   caller_registers,
+                                                   caller_register_validity))
     return false;
 
   // Populate *caller_context with the values the rules placed in
-  // caller_registers.
-  memset(caller_context, 0xda, sizeof(*caller_context));
+  // caller_registers. Only the registers in our map are touched; the rest
+  // of the context (floating-point and vector state, say) is often several
+  // times larger, and callers get it value-initialized with the frame.
   *caller_validity = 0;
   for (size_t i = 0; i < map_size_; i++) {
     const RegisterSet& r = register_map_[i];
-    typename ValueMap::const_iterator caller_entry;
+    caller_context->*r.context_member = 0;
 
-    // Did the rules provide a value for this register by its name?
-    caller_entry = caller_registers.find(r.name);
-    if (caller_entry != caller_none) {
-      caller_context->*r.context_member = caller_entry->second;
+    // Did the rules provide a value for this register, by its name or its
+    // alternate name?
+    if (caller_register_validity[i]) {
+      caller_context->*r.context_member = caller_registers[i];
       *caller_validity |= r.validity_flag;
       continue;
     }
 
-    // Did the rules provide a value for this register under its
-    // alternate name?
-    if (r.alternate_name) {
-      caller_entry = caller_registers.find(r.alternate_name);
-      if (caller_entry != caller_none) {
-        caller_context->*r.context_member = caller_entry->second;
-        *caller_validity |= r.validity_flag;
-        continue;
-      }
-    }
-
     // Is this a callee-saves register? The walker assumes that these
     // still hold the caller's value if the CFI doesn't mention them.
     //
@@ -39,7 +39,10 @@
 
 #include <string.h>
 
+#include <algorithm>
+#include <mutex>
 #include <sstream>
+#include <vector>
 
 #include "common/scoped_ptr.h"
 #include "processor/postfix_evaluator-inl.h"
@@ -50,6 +53,49 @@ namespace google_breakpad {
 #define strtok_r strtok_s
 #endif
 
+class CFIFrameInfo::CompiledRules {
+ public:
+  // Returns the rules of info compiled for ValueType V: the CFA rule, the
+  // RA rule, and then the register rules in register_rules_ order.
+  template<typename V>
+  const std::vector<typename PostfixEvaluator<V>::Program>& Get(
+      const CFIFrameInfo& info) {
+    Programs<V>* programs = ForValueType(static_cast<V*>(NULL));
+    std::call_once(programs->compiled, [&info, programs]() {
+      programs->programs.reserve(2 + info.register_rules_.size());
+      programs->programs.push_back(
+          typename PostfixEvaluator<V>::Program(info.cfa_rule_));
+      programs->programs.push_back(
+          typename PostfixEvaluator<V>::Program(info.ra_rule_));
+      for (RuleMap::const_iterator it = info.register_rules_.begin();
+           it != info.register_rules_.end(); it++) {
+        programs->programs.push_back(
+            typename PostfixEvaluator<V>::Program(it->second));
+      }
+    });
+    return programs->programs;
+  }
+
+ private:
+  template<typename V>
+  struct Programs {
+    std::once_flag compiled;
+    std::vector<typename PostfixEvaluator<V>::Program> programs;
+  };
+
+  Programs<uint32_t>* ForValueType(uint32_t*) { return &programs_32_; }
+  Programs<uint64_t>* ForValueType(uint64_t*) { return &programs_64_; }
+
+  Programs<uint32_t> programs_32_;
+  Programs<uint64_t> programs_64_;
+};
+
+CFIFrameInfo::CFIFrameInfo() : compiled_rules_(new CompiledRules) {}
+
+void CFIFrameInfo::ResetCompiledRules() {
+  compiled_rules_.reset(new CompiledRules);
+}
+
 template<typename V>
 bool CFIFrameInfo::FindCallerRegs(const RegisterValueMap<V>& registers,
                                   const MemoryRegion& memory,
@@ -59,6 +105,8 @@ bool CFIFrameInfo::FindCallerRegs(const RegisterValueMap<V>& registers,
   if (cfa_rule_.empty() || ra_rule_.empty())
     return false;
 
+  const std::vector<typename PostfixEvaluator<V>::Program>& programs =
+      compiled_rules_->Get<V>(*this);
   RegisterValueMap<V> working;
   PostfixEvaluator<V> evaluator(&working, &memory);
 
@@ -67,23 +115,24 @@ bool CFIFrameInfo::FindCallerRegs(const RegisterValueMap<V>& registers,
   // First, compute the CFA.
   V cfa;
   working = registers;
-  if (!evaluator.EvaluateForValue(cfa_rule_, &cfa))
+  if (!evaluator.EvaluateForValue(programs[0], &cfa))
     return false;
 
   // Then, compute the return address.
   V ra;
   working = registers;
   working[".cfa"] = cfa;
-  if (!evaluator.EvaluateForValue(ra_rule_, &ra))
+  if (!evaluator.EvaluateForValue(programs[1], &ra))
     return false;
 
   // Now, compute values for all the registers register_rules_ mentions.
+  size_t program_index = 2;
   for (RuleMap::const_iterator it = register_rules_.begin();
-       it != register_rules_.end(); it++) {
+       it != register_rules_.end(); it++, program_index++) {
     V value;
     working = registers;
     working[".cfa"] = cfa;
-    if (!evaluator.EvaluateForValue(it->second, &value))
+    if (!evaluator.EvaluateForValue(programs[program_index], &value))
       continue;
     (*caller_registers)[it->first] = value;
   }
@@ -104,6 +153,195 @@ template bool CFIFrameInfo::FindCallerRegs<uint64_t>(
     const MemoryRegion& memory,
     RegisterValueMap<uint64_t>* caller_registers) const;
 
+const size_t CFIFrameInfo::kMaxRegisters;
+
+namespace {
+
+// The most identifiers a rule may refer to, and the most register rules
+// there may be, for FindCallerRegs to evaluate the rules on arrays.
+const size_t kMaxIdentifiers = 64;
+
+// Sets slots[i] to the index of the register program.identifier(i) names,
+// or to cfa_slot for ".cfa", or to -1 if it names neither.  As with the
+// RegisterValueMap that FindCallerRegs populates from the current frame's
+// registers, alternate names are not looked up.
+template<typename V>
+void BindIdentifiers(const typename PostfixEvaluator<V>::Program& program,
+                     const CFIFrameInfo::RegisterName* register_names,
+                     size_t register_count,
+                     int cfa_slot,
+                     int* slots) {
+  for (size_t i = 0; i < program.identifier_count(); ++i) {
+    const string& identifier = program.identifier(i);
+    slots[i] = -1;
+    if (identifier == ".cfa") {
+      slots[i] = cfa_slot;
+      continue;
+    }
+    for (size_t j = 0; j < register_count; ++j) {
+      if (identifier == register_names[j].name) {
+        slots[i] = j;
+        break;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+template<typename V>
+bool CFIFrameInfo::FindCallerValue(const char* name,
+                                   const V* rule_values,
+                                   const bool* rule_validity,
+                                   V ra,
+                                   V cfa,
+                                   V* value) const {
+  if (strcmp(name, ".ra") == 0) {
+    *value = ra;
+    return true;
+  }
+  if (strcmp(name, ".cfa") == 0) {
+    *value = cfa;
+    return true;
+  }
+  size_t rule_index = 0;
+  for (RuleMap::const_iterator it = register_rules_.begin();
+       it != register_rules_.end(); it++, rule_index++) {
+    if (it->first == name) {
+      if (!rule_validity[rule_index])
+        return false;
+      *value = rule_values[rule_index];
+      return true;
+    }
+  }
+  return false;
+}
+
+template<typename V>
+bool CFIFrameInfo::FindCallerRegs(const RegisterName* register_names,
+                                  size_t register_count,
+                                  const V* registers,
+                                  const bool* validity,
+                                  const MemoryRegion& memory,
+                                  V* caller_registers,
+                                  bool* caller_validity) const {
+  if (register_count > kMaxRegisters) {
+    BPLOG(ERROR) << "Too many registers for CFI evaluation: "
+                 << register_count;
+    return false;
+  }
+
+  // If there are not rules for both .ra and .cfa in effect at this address,
+  // don't use this CFI data for stack walking.
+  if (cfa_rule_.empty() || ra_rule_.empty())
+    return false;
+
+  const std::vector<typename PostfixEvaluator<V>::Program>& programs =
+      compiled_rules_->Get<V>(*this);
+  bool use_dictionary = register_rules_.size() > kMaxIdentifiers;
+  for (size_t i = 0; i < programs.size(); ++i) {
+    if (programs[i].assigns() ||
+        programs[i].identifier_count() > kMaxIdentifiers) {
+      use_dictionary = true;
+    }
+  }
+
+  if (use_dictionary) {
+    // Rules with temporaries, which only a dictionary can hold, or with
+    // more identifiers than fit below, are rare enough to simply evaluate
+    // as FindCallerRegs above does.
+    RegisterValueMap<V> callee_map;
+    for (size_t i = 0; i < register_count; ++i) {
+      if (validity[i])
+        callee_map[register_names[i].name] = registers[i];
+    }
+    RegisterValueMap<V> caller_map;
+    if (!FindCallerRegs(callee_map, memory, &caller_map))
+      return false;
+    for (size_t i = 0; i < register_count; ++i) {
+      typename RegisterValueMap<V>::const_iterator caller_entry =
+          caller_map.find(register_names[i].name);
+      if (caller_entry == caller_map.end() && register_names[i].alternate_name)
+        caller_entry = caller_map.find(register_names[i].alternate_name);
+      caller_validity[i] = caller_entry != caller_map.end();
+      if (caller_validity[i])
+        caller_registers[i] = caller_entry->second;
+    }
+    return true;
+  }
+
+  // The current frame's registers, followed by the CFA once it is known.
+  V values[kMaxRegisters + 1];
+  bool value_validity[kMaxRegisters + 1];
+  std::copy(registers, registers + register_count, values);
+  std::copy(validity, validity + register_count, value_validity);
+  int cfa_slot = register_count;
+  value_validity[cfa_slot] = false;
+
+  PostfixEvaluator<V> evaluator(NULL, &memory);
+  int slots[kMaxIdentifiers];
+
+  // First, compute the CFA.
+  V cfa;
+  BindIdentifiers<V>(programs[0], register_names, register_count, cfa_slot,
+                     slots);
+  if (!evaluator.EvaluateForValue(programs[0], slots, values, value_validity,
+                                  &cfa)) {
+    return false;
+  }
+  values[cfa_slot] = cfa;
+  value_validity[cfa_slot] = true;
+
+  // Then, compute the return address.
+  V ra;
+  BindIdentifiers<V>(programs[1], register_names, register_count, cfa_slot,
+                     slots);
+  if (!evaluator.EvaluateForValue(programs[1], slots, values, value_validity,
+                                  &ra)) {
+    return false;
+  }
+
+  // Now, compute values for all the registers register_rules_ mentions.
+  V rule_values[kMaxIdentifiers];
+  bool rule_validity[kMaxIdentifiers];
+  for (size_t i = 2; i < programs.size(); ++i) {
+    BindIdentifiers<V>(programs[i], register_names, register_count, cfa_slot,
+                       slots);
+    rule_validity[i - 2] = evaluator.EvaluateForValue(
+        programs[i], slots, values, value_validity, &rule_values[i - 2]);
+  }
+
+  // Hand out the values the way a lookup in FindCallerRegs' result by
+  // each register's name, then its alternate name, would.
+  for (size_t i = 0; i < register_count; ++i) {
+    caller_validity[i] =
+        FindCallerValue(register_names[i].name, rule_values, rule_validity,
+                        ra, cfa, &caller_registers[i]) ||
+        (register_names[i].alternate_name &&
+         FindCallerValue(register_names[i].alternate_name, rule_values,
+                         rule_validity, ra, cfa, &caller_registers[i]));
+  }
+
+  return true;
+}
+
+template bool CFIFrameInfo::FindCallerRegs<uint32_t>(
+    const RegisterName* register_names,
+    size_t register_count,
+    const uint32_t* registers,
+    const bool* validity,
+    const MemoryRegion& memory,
+    uint32_t* caller_registers,
+    bool* caller_validity) const;
+template bool CFIFrameInfo::FindCallerRegs<uint64_t>(
+    const RegisterName* register_names,
+    size_t register_count,
+    const uint64_t* registers,
+    const bool* validity,
+    const MemoryRegion& memory,
+    uint64_t* caller_registers,
+    bool* caller_validity) const;
+
 string CFIFrameInfo::Serialize() const {
   std::ostringstream stream;
 
@@ -186,4 +424,65 @@ void CFIFrameInfoParseHandler::RegisterRule(const string& name,
   frame_info_->SetRegisterRule(name, expression);
 }
 
+namespace {
+
+// A handler that writes the rules it's given as a compiled rule set.
+class CFIRuleSetCompiler : public CFIRuleParser::Handler {
+ public:
+  explicit CFIRuleSetCompiler(string* compiled) : compiled_(compiled) { }
+
+  void CFARule(const string& expression) {
+    RegisterRule(".cfa", expression);
+  }
+  void RARule(const string& expression) {
+    RegisterRule(".ra", expression);
+  }
+  void RegisterRule(const string& name, const string& expression) {
+    compiled_->append(name);
+    compiled_->push_back('\n');
+    compiled_->append(expression);
+    compiled_->push_back('\n');
+  }
+
+ private:
+  string* compiled_;
+};
+
+}  // namespace
+
+bool CompileCFIRuleSet(const string& rule_set, string* compiled) {
+  compiled->clear();
+  CFIRuleSetCompiler compiler(compiled);
+  CFIRuleParser parser(&compiler);
+  if (!parser.Parse(rule_set)) {
+    compiled->clear();
+    return false;
+  }
+  return true;
+}
+
+bool ApplyCompiledCFIRuleSet(const char* compiled, CFIFrameInfo* frame_info) {
+  if (!*compiled)
+    return false;
+  while (*compiled) {
+    const char* name_end = strchr(compiled, '\n');
+    if (!name_end)
+      return false;
+    const char* expression = name_end + 1;
+    const char* expression_end = strchr(expression, '\n');
+    if (!expression_end)
+      return false;
+    string name(compiled, name_end - compiled);
+    string value(expression, expression_end - expression);
+    if (name == ".cfa")
+      frame_info->SetCFARule(value);
+    else if (name == ".ra")
+      frame_info->SetRARule(value);
+    else
+      frame_info->SetRegisterRule(name, value);
+    compiled = expression_end + 1;
+  }
+  return true;
+}
+
 } // namespace google_breakpad
@@ -38,7 +38,9 @@
 #define PROCESSOR_CFI_FRAME_INFO_H_
 
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "common/using_std_string.h"
 #include "google_breakpad/common/breakpad_types.h"
@@ -68,13 +70,33 @@ class CFIFrameInfo {
   template<typename ValueType> class RegisterValueMap: 
     public map<string, ValueType> { };
 
+  // The names of a register passed to the array form of FindCallerRegs,
+  // as in SimpleCFIWalker::RegisterSet: the name STACK CFI rules use, and
+  // an alternate name to take the caller's value from, or NULL.
+  struct RegisterName {
+    const char* name;
+    const char* alternate_name;
+  };
+
+  // The most registers the array form of FindCallerRegs accepts.
+  static const size_t kMaxRegisters = 64;
+
+  CFIFrameInfo();
+
   // Set the expression for computing a call frame address, return
   // address, or register's value. At least the CFA rule and the RA
   // rule must be set before calling FindCallerRegs.
-  void SetCFARule(const string& expression) { cfa_rule_ = expression; }
-  void SetRARule(const string& expression)  { ra_rule_ = expression; }
+  void SetCFARule(const string& expression) {
+    cfa_rule_ = expression;
+    ResetCompiledRules();
+  }
+  void SetRARule(const string& expression) {
+    ra_rule_ = expression;
+    ResetCompiledRules();
+  }
   void SetRegisterRule(const string& register_name, const string& expression) {
     register_rules_[register_name] = expression;
+    ResetCompiledRules();
   }
 
   // Compute the values of the calling frame's registers, according to
@@ -99,6 +121,23 @@ class CFIFrameInfo {
                       const MemoryRegion& memory,
                       RegisterValueMap<ValueType>* caller_registers) const;
 
+  // Like FindCallerRegs above, but with the registers held in arrays
+  // indexed like the REGISTER_COUNT entries of REGISTER_NAMES, which saves
+  // building dictionaries of register names for every frame. REGISTERS[i]
+  // is the value of register i in the current frame if VALIDITY[i] is
+  // true. On success, CALLER_REGISTERS[i] is set to the value the rules
+  // give register i under its name or, failing that, under its alternate
+  // name, which may be ".ra" or ".cfa"; CALLER_VALIDITY[i] is set to
+  // whether they gave one. REGISTER_COUNT must not exceed kMaxRegisters.
+  template<typename ValueType>
+  bool FindCallerRegs(const RegisterName* register_names,
+                      size_t register_count,
+                      const ValueType* registers,
+                      const bool* validity,
+                      const MemoryRegion& memory,
+                      ValueType* caller_registers,
+                      bool* caller_validity) const;
+
   // Serialize the rules in this object into a string in the format
   // of STACK CFI records.
   string Serialize() const;
@@ -108,6 +147,24 @@ class CFIFrameInfo {
   // A map from register names onto evaluation rules. 
   typedef map<string, string> RuleMap;
 
+  // The rules compiled for PostfixEvaluator, for each ValueType
+  // FindCallerRegs is used with.  Defined in cfi_frame_info.cc.
+  class CompiledRules;
+
+  // Drops the compiled rules, which no longer match the rules.
+  void ResetCompiledRules();
+
+  // Looks name up among the caller's registers the rules yielded, as
+  // stored in a RegisterValueMap by FindCallerRegs: the register rules that
+  // evaluated successfully in RULE_VALUES, followed by ".ra" and ".cfa".
+  template<typename ValueType>
+  bool FindCallerValue(const char* name,
+                       const ValueType* rule_values,
+                       const bool* rule_validity,
+                       ValueType ra,
+                       ValueType cfa,
+                       ValueType* value) const;
+
   // In this type, a "postfix expression" is an expression of the sort
   // interpreted by google_breakpad::PostfixEvaluator.
 
@@ -131,6 +188,11 @@ class CFIFrameInfo {
   // which leaves the value of REG in the calling frame on the top of
   // the stack. You should evaluate this expression
   RuleMap register_rules_;
+
+  // The rules above, compiled on first use by FindCallerRegs.  Copies of
+  // this object share the compiled rules, so that copies of the rules a
+  // SourceLineResolver hands out for each frame only compile them once.
+  std::shared_ptr<CompiledRules> compiled_rules_;
 };
 
 // A parser for STACK CFI-style rule sets.
@@ -190,6 +252,19 @@ class CFIFrameInfoParseHandler: public CFIRuleParser::Handler {
   CFIFrameInfo* frame_info_;
 };
 
+// Compiled rule sets, in the form the fast resolver's serialized modules
+// store them: the name and then the expression of each rule, each followed
+// by a newline. Unlike a rule set as it appears in a STACK CFI record,
+// applying a compiled rule set needs no tokenizing or copying.
+//
+// Compile RULE_SET, in the format of STACK CFI records, into COMPILED.
+// Return false, leaving COMPILED empty, if RULE_SET doesn't parse.
+bool CompileCFIRuleSet(const string& rule_set, string* compiled);
+
+// Apply the rules in COMPILED, a null-terminated compiled rule set, to
+// FRAME_INFO. Return false if COMPILED is empty or malformed.
+bool ApplyCompiledCFIRuleSet(const char* compiled, CFIFrameInfo* frame_info);
+
 // A utility class template for simple 'STACK CFI'-driven stack walkers.
 // Given a CFIFrameInfo instance, a table describing the architecture's
 // register set, and a context holding the last frame's registers, an
@@ -240,7 +315,13 @@ class SimpleCFIWalker {
   // RegisterSet structures; MAP_SIZE is the number of elements in the
   // array.
   SimpleCFIWalker(const RegisterSet* register_map, size_t map_size)
-      : register_map_(register_map), map_size_(map_size) { }
+      : register_map_(register_map), map_size_(map_size),
+        register_names_(map_size) {
+    for (size_t i = 0; i < map_size; i++) {
+      register_names_[i].name = register_map[i].name;
+      register_names_[i].alternate_name = register_map[i].alternate_name;
+    }
+  }
 
   // Compute the calling frame's raw context given the callee's raw
   // context.
@@ -254,7 +335,9 @@ class SimpleCFIWalker {
   //
   // fill in CALLER_CONTEXT with the caller's register values, and set
   // CALLER_VALIDITY to indicate which registers are valid in
-  // CALLER_CONTEXT. Return true on success, or false on failure.
+  // CALLER_CONTEXT. Registers the rules don't recover are set to zero;
+  // members of CALLER_CONTEXT that aren't in the register map are left
+  // unchanged. Return true on success, or false on failure.
   bool FindCallerRegisters(const MemoryRegion& memory,
                            const CFIFrameInfo& cfi_frame_info,
                            const RawContextType& callee_context,
@@ -265,6 +348,11 @@ class SimpleCFIWalker {
  private:
   const RegisterSet* register_map_;
   size_t map_size_;
+
+  // The names in register_map_, for evaluating rules on arrays of register
+  // values indexed like register_map_.  MAP_SIZE must not exceed
+  // CFIFrameInfo::kMaxRegisters.
+  std::vector<CFIFrameInfo::RegisterName> register_names_;
 };
 
 }  // namespace google_breakpad
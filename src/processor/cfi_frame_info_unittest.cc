@@ -42,9 +42,11 @@
 #include "processor/cfi_frame_info.h"
 #include "google_breakpad/processor/memory_region.h"
 
+using google_breakpad::ApplyCompiledCFIRuleSet;
 using google_breakpad::CFIFrameInfo;
 using google_breakpad::CFIFrameInfoParseHandler;
 using google_breakpad::CFIRuleParser;
+using google_breakpad::CompileCFIRuleSet;
 using google_breakpad::MemoryRegion;
 using google_breakpad::SimpleCFIWalker;
 using testing::_;
@@ -294,6 +296,55 @@ TEST_F(Scope, SeparateTempsRA) {
                                              &caller_registers));
 }
 
+// The array form of FindCallerRegs looks registers up by name, and
+// recovers the caller's registers by name or else by alternate name.
+TEST_F(Scope, RegisterArrays) {
+  ExpectNoMemoryReferences();
+
+  static const CFIFrameInfo::RegisterName register_names[] = {
+    { "$r1", NULL }, { "$r2", NULL }, { "$sp", ".cfa" }, { "$pc", ".ra" }
+  };
+  const uint64_t callee_registers[] = { 0x10, 0x20, 0x1000, 0x2000 };
+  const bool callee_validity[] = { true, false, true, true };
+  uint64_t caller_values[4];
+  bool caller_validity[4];
+
+  cfi.SetCFARule("$sp 16 +");
+  cfi.SetRARule("$pc .cfa +");
+  cfi.SetRegisterRule("$r1", "$r1 .cfa +");
+  cfi.SetRegisterRule("$r2", "$r2");
+  cfi.SetRegisterRule("$pc", "$r2");
+  ASSERT_TRUE(cfi.FindCallerRegs<uint64_t>(register_names, 4,
+                                           callee_registers, callee_validity,
+                                           memory, caller_values,
+                                           caller_validity));
+  ASSERT_TRUE(caller_validity[0]);
+  ASSERT_EQ(0x1020U, caller_values[0]);
+  ASSERT_FALSE(caller_validity[1]);
+  ASSERT_TRUE(caller_validity[2]);
+  ASSERT_EQ(0x1010U, caller_values[2]);
+  ASSERT_TRUE(caller_validity[3]);
+  ASSERT_EQ(0x3010U, caller_values[3]);
+
+  // Rules with temporaries give the same results.
+  cfi.SetRegisterRule("$r2", "$temp $r1 = $temp 1 +");
+  ASSERT_TRUE(cfi.FindCallerRegs<uint64_t>(register_names, 4,
+                                           callee_registers, callee_validity,
+                                           memory, caller_values,
+                                           caller_validity));
+  ASSERT_TRUE(caller_validity[1]);
+  ASSERT_EQ(0x11U, caller_values[1]);
+  ASSERT_EQ(0x1010U, caller_values[2]);
+  ASSERT_EQ(0x3010U, caller_values[3]);
+
+  // The CFA rule can't see the CFA.
+  cfi.SetCFARule(".cfa");
+  ASSERT_FALSE(cfi.FindCallerRegs<uint64_t>(register_names, 4,
+                                            callee_registers, callee_validity,
+                                            memory, caller_values,
+                                            caller_validity));
+}
+
 class MockCFIRuleParserHandler: public CFIRuleParser::Handler {
  public:
   MOCK_METHOD1(CFARule, void(const string&));
@@ -457,6 +508,36 @@ TEST_F(ParseHandler, RegisterRules) {
   ASSERT_EQ(caller_registers.end(), caller_registers.find("reg3"));
 }
 
+class CompiledRuleSet: public CFIFixture, public Test { };
+
+TEST_F(CompiledRuleSet, RoundTrip) {
+  string compiled;
+  ASSERT_TRUE(CompileCFIRuleSet(".cfa:  reg-for-cfa  .ra: reg-for-ra 8 +\t"
+                                "reg1: reg-for-reg1", &compiled));
+  EXPECT_EQ(".cfa\nreg-for-cfa\n.ra\nreg-for-ra 8 +\nreg1\nreg-for-reg1\n",
+            compiled);
+  ASSERT_TRUE(ApplyCompiledCFIRuleSet(compiled.c_str(), &cfi));
+  EXPECT_EQ(".cfa: reg-for-cfa .ra: reg-for-ra 8 + reg1: reg-for-reg1",
+            cfi.Serialize());
+
+  registers["reg-for-cfa"] = 0x268a9a4a3821a797ULL;
+  registers["reg-for-ra"] = 0x6301b475b8b91c02ULL;
+  registers["reg-for-reg1"] = 0x06cde8e2ff062481ULL;
+  ASSERT_TRUE(cfi.FindCallerRegs<uint64_t>(registers, memory,
+                                            &caller_registers));
+  ASSERT_EQ(0x6301b475b8b91c0aULL, caller_registers[".ra"]);
+  ASSERT_EQ(0x06cde8e2ff062481ULL, caller_registers["reg1"]);
+}
+
+TEST_F(CompiledRuleSet, BadRuleSets) {
+  string compiled = "stale";
+  EXPECT_FALSE(CompileCFIRuleSet("r0: r1:   expr", &compiled));
+  EXPECT_EQ("", compiled);
+  EXPECT_FALSE(ApplyCompiledCFIRuleSet("", &cfi));
+  EXPECT_FALSE(ApplyCompiledCFIRuleSet(".cfa\nexpr", &cfi));
+  EXPECT_FALSE(ApplyCompiledCFIRuleSet(".cfa", &cfi));
+}
+
 struct SimpleCFIWalkerFixture {
   struct RawContext {
     uint64_t r0, r1, r2, r3, r4, sp, pc;
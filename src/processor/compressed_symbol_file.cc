@@ -0,0 +1,191 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// compressed_symbol_file.cc: Reading of compressed symbol files.
+//
+// See compressed_symbol_file.h for documentation.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "processor/compressed_symbol_file.h"
+
+#include <stdio.h>
+
+#include <algorithm>
+#include <vector>
+
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+
+#include "processor/logging.h"
+
+namespace google_breakpad {
+
+const char kGzipSymbolFileExtension[] = ".gz";
+const char kZstdSymbolFileExtension[] = ".zst";
+
+const char* const kReadableCompressedSymbolFileExtensions[] = {
+#ifdef HAVE_LIBZ
+  kGzipSymbolFileExtension,
+#endif
+#ifdef HAVE_LIBZSTD
+  kZstdSymbolFileExtension,
+#endif
+  NULL
+};
+
+namespace {
+
+// The amount of room to make at the end of the contents before each read
+// of decompressed data.
+const size_t kReadChunkSize = 1 << 20;
+
+bool HasExtension(const string& file_name, const string& extension) {
+  return file_name.size() > extension.size() &&
+         file_name.compare(file_name.size() - extension.size(),
+                           extension.size(), extension) == 0;
+}
+
+// Makes room for at least min_room more bytes after the first size bytes of
+// contents, growing it geometrically so that decompressing into it takes
+// linear time.
+char* ReserveRoom(string* contents, size_t size, size_t min_room) {
+  if (contents->size() - size < min_room)
+    contents->resize(std::max(contents->size() * 2, size + min_room));
+  return &(*contents)[size];
+}
+
+#ifdef HAVE_LIBZ
+bool ReadGzipFile(const string& file_name, string* contents) {
+  gzFile file = gzopen(file_name.c_str(), "rb");
+  if (!file)
+    return false;
+
+  size_t size = 0;
+  bool succeeded = true;
+  for (;;) {
+    char* room = ReserveRoom(contents, size, kReadChunkSize);
+    int read = gzread(file, room, kReadChunkSize);
+    if (read < 0) {
+      succeeded = false;
+      break;
+    }
+    if (read == 0)
+      break;
+    size += read;
+  }
+  contents->resize(size);
+  // gzclose reports a stream cut short.
+  return gzclose(file) == Z_OK && succeeded;
+}
+#endif  // HAVE_LIBZ
+
+#ifdef HAVE_LIBZSTD
+bool ReadZstdFile(const string& file_name, string* contents) {
+  FILE* file = fopen(file_name.c_str(), "rb");
+  if (!file)
+    return false;
+  ZSTD_DCtx* context = ZSTD_createDCtx();
+  if (!context) {
+    fclose(file);
+    return false;
+  }
+
+  std::vector<char> input(ZSTD_DStreamInSize());
+  size_t size = 0;
+  // Zero once a frame has been decompressed completely.
+  size_t result = 0;
+  bool succeeded = true;
+  size_t read;
+  while (succeeded &&
+         (read = fread(&input[0], 1, input.size(), file)) > 0) {
+    ZSTD_inBuffer in = { &input[0], read, 0 };
+    while (in.pos < in.size) {
+      size_t room = ZSTD_DStreamOutSize();
+      ZSTD_outBuffer out = { ReserveRoom(contents, size, room), room, 0 };
+      result = ZSTD_decompressStream(context, &out, &in);
+      if (ZSTD_isError(result)) {
+        succeeded = false;
+        break;
+      }
+      size += out.pos;
+    }
+  }
+  contents->resize(size);
+  if (ferror(file) || result != 0)
+    succeeded = false;
+
+  ZSTD_freeDCtx(context);
+  fclose(file);
+  return succeeded;
+}
+#endif  // HAVE_LIBZSTD
+
+}  // namespace
+
+bool IsCompressedSymbolFile(const string& file_name) {
+  return HasExtension(file_name, kGzipSymbolFileExtension) ||
+         HasExtension(file_name, kZstdSymbolFileExtension);
+}
+
+bool ReadCompressedSymbolFile(const string& file_name, string* contents) {
+  contents->clear();
+  bool read = false;
+  bool supported = false;
+#ifdef HAVE_LIBZ
+  if (HasExtension(file_name, kGzipSymbolFileExtension)) {
+    supported = true;
+    read = ReadGzipFile(file_name, contents);
+  }
+#endif
+#ifdef HAVE_LIBZSTD
+  if (HasExtension(file_name, kZstdSymbolFileExtension)) {
+    supported = true;
+    read = ReadZstdFile(file_name, contents);
+  }
+#endif
+  if (!supported) {
+    BPLOG(ERROR) << "Reading " << file_name << " is not supported in this "
+                    "build";
+    return false;
+  }
+  if (!read) {
+    BPLOG(ERROR) << "Could not decompress " << file_name;
+    contents->clear();
+    return false;
+  }
+  return true;
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,70 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// compressed_symbol_file.h: Reading of compressed symbol files.
+//
+// A symbol file may be stored compressed with gzip, named with
+// kGzipSymbolFileExtension appended, or with zstd, named with
+// kZstdSymbolFileExtension appended:
+//
+//   symbols/libc.so.6/F4F8DFCD5A5FB5A7CE64717E9E6AE3890/libc.so.6.sym.gz
+//
+// SimpleSymbolSupplier and SourceLineResolverBase::ReadSymbolFile
+// decompress such files as they read them.  gzip support requires zlib, and
+// zstd support requires building with --enable-zstd.
+
+#ifndef PROCESSOR_COMPRESSED_SYMBOL_FILE_H__
+#define PROCESSOR_COMPRESSED_SYMBOL_FILE_H__
+
+#include <string>
+
+#include "common/using_std_string.h"
+
+namespace google_breakpad {
+
+// Appended to the name of a symbol file compressed with gzip.
+extern const char kGzipSymbolFileExtension[];
+
+// Appended to the name of a symbol file compressed with zstd.
+extern const char kZstdSymbolFileExtension[];
+
+// The extensions of the compressed symbol files that can be read in this
+// build, terminated by NULL.
+extern const char* const kReadableCompressedSymbolFileExtensions[];
+
+// Returns true if file_name ends in a compressed symbol file extension,
+// whether or not this build can read it.
+bool IsCompressedSymbolFile(const string& file_name);
+
+// Decompresses the compressed symbol file file_name into contents.  Returns
+// false if the file cannot be read or decompressed.
+bool ReadCompressedSymbolFile(const string& file_name, string* contents);
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_COMPRESSED_SYMBOL_FILE_H__
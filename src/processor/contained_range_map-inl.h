@@ -39,6 +39,8 @@
 
 #include <assert.h>
 
+#include <algorithm>
+
 #include "processor/logging.h"
 
 
@@ -57,6 +59,12 @@ bool ContainedRangeMap<AddressType, EntryType>::StoreRange(
     const AddressType& base, const AddressType& size, const EntryType& entry) {
   AddressType high = base + size - 1;
 
+  // The flattened tree would no longer match the tree.
+  if (frozen_) {
+    delete frozen_;
+    frozen_ = NULL;
+  }
+
   // Check for undersize or overflow.
   if (size <= 0 || high < base) {
     //TODO(nealsid) We are commenting this out in order to prevent
@@ -157,6 +165,30 @@ bool ContainedRangeMap<AddressType, EntryType>::RetrieveRange(
                              "|entry|";
   assert(entry);
 
+  const EntryType* stored_entry;
+  if (!RetrieveRange(address, &stored_entry))
+    return false;
+
+  *entry = *stored_entry;
+  return true;
+}
+
+
+template<typename AddressType, typename EntryType>
+bool ContainedRangeMap<AddressType, EntryType>::RetrieveRange(
+    const AddressType& address, const EntryType** entry) const {
+  BPLOG_IF(ERROR, !entry) << "ContainedRangeMap::RetrieveRange requires "
+                             "|entry|";
+  assert(entry);
+
+  if (frozen_) {
+    uint32_t index = FindFrozenRange(address);
+    if (index == kNoParent)
+      return false;
+    *entry = (*frozen_)[index].entry;
+    return true;
+  }
+
   // If nothing was ever stored, then there's nothing to retrieve.
   if (!map_)
     return false;
@@ -175,7 +207,7 @@ bool ContainedRangeMap<AddressType, EntryType>::RetrieveRange(
   // if it has a more-specific descendant that also contains it.  If it does,
   // it will set |entry| appropriately.  If not, set |entry| to the child.
   if (!iterator->second->RetrieveRange(address, entry))
-    *entry = iterator->second->entry_;
+    *entry = &iterator->second->entry_;
 
   return true;
 }
@@ -184,6 +216,16 @@ template <typename AddressType, typename EntryType>
 bool ContainedRangeMap<AddressType, EntryType>::RetrieveRanges(
     const AddressType& address,
     std::vector<const EntryType*>& entries) const {
+  if (frozen_) {
+    uint32_t index = FindFrozenRange(address);
+    if (index == kNoParent)
+      return false;
+    entries.reserve(entries.size() + (*frozen_)[index].depth + 1);
+    for (; index != kNoParent; index = (*frozen_)[index].parent)
+      entries.push_back((*frozen_)[index].entry);
+    return true;
+  }
+
   // If nothing was ever stored, then there's nothing to retrieve.
   if (!map_)
     return false;
@@ -195,8 +237,54 @@ bool ContainedRangeMap<AddressType, EntryType>::RetrieveRanges(
   return true;
 }
 
+template<typename AddressType, typename EntryType>
+void ContainedRangeMap<AddressType, EntryType>::Freeze() {
+  delete frozen_;
+  frozen_ = new FrozenRanges();
+  if (map_)
+    AppendFrozenRanges(kNoParent, 0, frozen_);
+}
+
+template<typename AddressType, typename EntryType>
+void ContainedRangeMap<AddressType, EntryType>::AppendFrozenRanges(
+    uint32_t parent, uint32_t depth, FrozenRanges* ranges) const {
+  // Children are disjoint, so ordering them by high address, as map_
+  // does, orders them by base address too.
+  MapConstIterator end = map_->end();
+  for (MapConstIterator child = map_->begin(); child != end; ++child) {
+    uint32_t index = static_cast<uint32_t>(ranges->size());
+    FrozenRange range = { child->second->base_, child->first, parent, depth,
+                          &child->second->entry_ };
+    ranges->push_back(range);
+    if (child->second->map_)
+      child->second->AppendFrozenRanges(index, depth + 1, ranges);
+  }
+}
+
+template<typename AddressType, typename EntryType>
+uint32_t ContainedRangeMap<AddressType, EntryType>::FindFrozenRange(
+    const AddressType& address) const {
+  // Find the last range starting at or below address.  Ranges either nest
+  // or are disjoint, so the ranges containing address are that range or
+  // its ancestors: any other range starting at or below address lies
+  // entirely before that range, and so entirely below address.
+  typename FrozenRanges::const_iterator range = std::upper_bound(
+      frozen_->begin(), frozen_->end(), address,
+      [](const AddressType& address, const FrozenRange& range) {
+        return address < range.base;
+      });
+  if (range == frozen_->begin())
+    return kNoParent;
+  uint32_t index = static_cast<uint32_t>(range - frozen_->begin() - 1);
+  while (index != kNoParent && (*frozen_)[index].high < address)
+    index = (*frozen_)[index].parent;
+  return index;
+}
+
 template<typename AddressType, typename EntryType>
 void ContainedRangeMap<AddressType, EntryType>::Clear() {
+  delete frozen_;
+  frozen_ = NULL;
   if (map_) {
     MapConstIterator end = map_->end();
     for (MapConstIterator child = map_->begin(); child != end; ++child)
@@ -54,12 +54,18 @@
 // is the only node directly accessible to the user, and represents the
 // entire address space.
 //
+// Once a map is fully populated, Freeze flattens the tree into an array of
+// ranges in depth-first order, each with the index of its parent, so that
+// a lookup is a binary search followed by a walk up the parent indices.
+//
 // Author: Mark Mentovai
 
 #ifndef PROCESSOR_CONTAINED_RANGE_MAP_H__
 #define PROCESSOR_CONTAINED_RANGE_MAP_H__
 
 
+#include <stdint.h>
+
 #include <map>
 #include <vector>
 
@@ -76,7 +82,8 @@ class ContainedRangeMap {
   // and no entry, and as such is only suitable for the root node of a
   // ContainedRangeMap tree.
   explicit ContainedRangeMap(bool allow_equal_range = false)
-      : base_(), entry_(), map_(NULL), allow_equal_range_(allow_equal_range) {}
+      : base_(), entry_(), map_(NULL), frozen_(NULL),
+        allow_equal_range_(allow_equal_range) {}
 
   ~ContainedRangeMap();
 
@@ -98,11 +105,24 @@ class ContainedRangeMap {
   // encompasses the address, returns false.
   bool RetrieveRange(const AddressType& address, EntryType* entries) const;
 
+  // Like RetrieveRange above, but sets entry to point at the stored entry
+  // instead of copying it, so that concurrent lookups leave the map
+  // untouched.  See RangeMap::RetrieveRange.
+  bool RetrieveRange(const AddressType& address,
+                     const EntryType** entry) const;
+
   // Retrieves the vector of entries encompassing the specified address from the
   // innermost entry to the outermost entry.
   bool RetrieveRanges(const AddressType& address,
                       std::vector<const EntryType*>& entries) const;
 
+  // Builds a flattened copy of the tree that RetrieveRange and
+  // RetrieveRanges search instead of descending through the child maps.
+  // The tree itself is kept, and the entries are not copied.  Storing a
+  // range discards the flattened copy, so this is meant to be called, on
+  // the root node, once the map is fully populated.
+  void Freeze();
+
   // Removes all children.  Note that Clear only removes descendants,
   // leaving the node on which it is called intact.  Because the only
   // meaningful things contained by a root node are descendants, this
@@ -121,6 +141,29 @@ class ContainedRangeMap {
   typedef typename AddressToRangeMap::iterator MapIterator;
   typedef typename AddressToRangeMap::value_type MapValue;
 
+  // A range in the flattened tree built by Freeze.
+  struct FrozenRange {
+    AddressType base;
+    AddressType high;
+    // The index of the smallest range containing this one, or kNoParent.
+    uint32_t parent;
+    // The number of ranges containing this one.
+    uint32_t depth;
+    const EntryType* entry;
+  };
+  typedef std::vector<FrozenRange> FrozenRanges;
+
+  static const uint32_t kNoParent = UINT32_MAX;
+
+  // Appends this node's children and their descendants to ranges, each
+  // before its own children, which is the order of their base addresses.
+  void AppendFrozenRanges(uint32_t parent, uint32_t depth,
+                          FrozenRanges* ranges) const;
+
+  // Returns the index in frozen_ of the smallest range containing address,
+  // or kNoParent if there is none.
+  uint32_t FindFrozenRange(const AddressType& address) const;
+
   // Creates a new ContainedRangeMap with the specified base address, entry,
   // and initial child map, which may be NULL.  This is only used internally
   // by ContainedRangeMap when it creates a new child.
@@ -131,6 +174,7 @@ class ContainedRangeMap {
       : base_(base),
         entry_(entry),
         map_(map),
+        frozen_(NULL),
         allow_equal_range_(allow_equal_range) {}
 
   // The base address of this range.  The high address does not need to
@@ -153,6 +197,10 @@ class ContainedRangeMap {
   // leaf nodes, where they are not needed.
   AddressToRangeMap* map_;
 
+  // The ranges below this node in depth-first order, or NULL if the map
+  // has not been frozen.  Only ever set on the root node.
+  FrozenRanges* frozen_;
+
   // Whether or not we allow storing an entry into a range that equals to
   // existing range in the map. Default is false.
   // If this is true, the newly added range will become a child of existing
@@ -288,7 +288,21 @@ static bool RunTestsWithNoEqualRange() {
     0    // 99
   };
   unsigned int test_length = sizeof(test_data) / sizeof(int);
-  return RunTestsWithRetrieveRange(crm, test_data, test_length);
+  if (!RunTestsWithRetrieveRange(crm, test_data, test_length))
+    return false;
+
+  // A frozen map must return the same entries.
+  crm.Freeze();
+  if (!RunTestsWithRetrieveRange(crm, test_data, test_length))
+    return false;
+
+  // Storing a range in a frozen map discards the flattened copy, which
+  // would not know about the new range.
+  ASSERT_TRUE(crm.StoreRange(91, 2, 46));
+  int value;
+  ASSERT_TRUE(crm.RetrieveRange(92, &value));
+  ASSERT_TRUE(value == 46);
+  return true;
 }
 
 static bool RunTestsWithEqualRange() {
@@ -364,6 +378,13 @@ static bool RunTestsWithEqualRange() {
       {16, {17, 16}},
       {17, {}},
   };
+  if (!RunTestsWithRetrieveRange(crm, test_data, test_length) ||
+      !RunTestsWithRetrieveRangeVector(crm, entries_tests)) {
+    return false;
+  }
+
+  // A frozen map must return the same entries, in the same order.
+  crm.Freeze();
   return RunTestsWithRetrieveRange(crm, test_data, test_length) &&
          RunTestsWithRetrieveRangeVector(crm, entries_tests);
 }
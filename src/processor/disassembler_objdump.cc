@@ -39,6 +39,7 @@
 #include <unistd.h>
 #include <sys/wait.h>
 
+#include <algorithm>
 #include <array>
 #include <fstream>
 #include <iostream>
@@ -204,8 +205,609 @@ bool GetRegisterValue(const DumpContext& context, string register_name,
     return false;
   }
 }
+
+string HexString(uint64_t value) {
+  std::ostringstream stream;
+  stream << "0x" << std::hex << value;
+  return stream.str();
+}
+
+const char* const kRegisterNames64[16] = {
+  "rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+  "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"
+};
+const char* const kRegisterNames32[16] = {
+  "eax", "ecx", "edx", "ebx", "esp", "ebp", "esi", "edi",
+  "r8d", "r9d", "r10d", "r11d", "r12d", "r13d", "r14d", "r15d"
+};
+const char* const kRegisterNames16[16] = {
+  "ax", "cx", "dx", "bx", "sp", "bp", "si", "di",
+  "r8w", "r9w", "r10w", "r11w", "r12w", "r13w", "r14w", "r15w"
+};
+const char* const kRegisterNames8Rex[16] = {
+  "al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil",
+  "r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b"
+};
+const char* const kRegisterNames8[8] = {
+  "al", "cl", "dl", "bl", "ah", "ch", "dh", "bh"
+};
+const char* const kArithmeticOperations[8] = {
+  "add", "or", "adc", "sbb", "and", "sub", "xor", "cmp"
+};
+const char* const kShiftOperations[8] = {
+  "rol", "ror", "rcl", "rcr", "shl", "shr", NULL, "sar"
+};
+const char* const kUnaryOperations[8] = {
+  "test", NULL, "not", "neg", "mul", "imul", "div", "idiv"
+};
+
+bool IsLockableOperation(const string& operation) {
+  static const char* const kLockableOperations[] = {
+    "add", "or", "adc", "sbb", "and", "sub", "xor", "inc", "dec", "not",
+    "neg", "xchg", "cmpxchg", "xadd"
+  };
+  for (const char* lockable : kLockableOperations) {
+    if (operation == lockable)
+      return true;
+  }
+  return false;
+}
+
+const uint8_t kRexW = 0x08;
+const uint8_t kRexR = 0x04;
+const uint8_t kRexX = 0x02;
+const uint8_t kRexB = 0x01;
+const uint8_t kRexPresent = 0x40;
+
+// Formats the x86 or x86-64 instruction at the start of a buffer as
+// "objdump -M intel" does, for the instructions most often found at a
+// crash: integer loads, stores and read-modify-writes through a ModRM
+// operand, indirect calls and jumps, and string operations.  Format fails
+// for any other instruction, and for any encoding whose objdump rendering
+// it does not reproduce exactly, such as prefixes that the instruction
+// does not use, so that the caller can fall back to objdump.
+class IntelSyntaxFormatter {
+ public:
+  IntelSyntaxFormatter(bool amd64, const uint8_t* bytes, size_t length)
+      : amd64_(amd64), bytes_(bytes), length_(length), offset_(0),
+        lock_(false), data16_(false), data16_used_(false), repeat_(0),
+        segment_(0), segment_used_(false), rex_(0), rex_used_(0), modrm_(0),
+        rip_relative_(false), rip_displacement_(0) {}
+
+  bool Format(string* instruction);
+
+ private:
+  bool Next(uint8_t* byte);
+  bool ReadSigned(size_t size, int64_t* value);
+
+  // Consumes the prefixes, returning false for any that are not supported.
+  bool ReadPrefixes();
+
+  // Returns the operand size, in bytes, of a non-byte operation.
+  int OperandSize();
+
+  string Register(int number, int size);
+
+  // Formats the register operand in the ModRM reg field.
+  string RegOperand(int size);
+
+  // Formats the ModRM r/m operand, a register or memory.  A memory operand
+  // is given a size, unless size_ptr is false.
+  bool RmOperand(int size, bool size_ptr, string* operand);
+
+  // Formats a memory operand addressed by a string operation's register.
+  string StringOperand(int size, const char* segment, int address_register);
+
+  bool Immediate(int immediate_size, int operand_size, string* operand);
+
+  // Formats a string operation, with an optional repeat prefix.
+  bool StringOperation(uint8_t opcode, string* instruction);
+
+  // Formats the operation and its operands, without prefixes.
+  bool Operation(string* operation, string* dest, string* src);
+
+  bool amd64_;
+  const uint8_t* bytes_;
+  size_t length_;
+  size_t offset_;
+
+  bool lock_;
+  bool data16_;
+  bool data16_used_;
+  uint8_t repeat_;
+  uint8_t segment_;
+  bool segment_used_;
+  uint8_t rex_;
+  uint8_t rex_used_;
+  uint8_t modrm_;
+  bool rip_relative_;
+  int64_t rip_displacement_;
+};
+
+bool IntelSyntaxFormatter::Next(uint8_t* byte) {
+  if (offset_ >= length_)
+    return false;
+  *byte = bytes_[offset_++];
+  return true;
+}
+
+bool IntelSyntaxFormatter::ReadSigned(size_t size, int64_t* value) {
+  if (length_ - offset_ < size)
+    return false;
+  uint64_t bits = 0;
+  for (size_t i = 0; i < size; ++i)
+    bits |= static_cast<uint64_t>(bytes_[offset_ + i]) << (8 * i);
+  offset_ += size;
+  int shift = 64 - 8 * static_cast<int>(size);
+  *value = static_cast<int64_t>(bits << shift) >> shift;
+  return true;
+}
+
+bool IntelSyntaxFormatter::ReadPrefixes() {
+  while (offset_ < length_) {
+    uint8_t prefix = bytes_[offset_];
+    if (prefix == 0xf0 && !lock_) {
+      lock_ = true;
+    } else if (prefix == 0x66 && !data16_) {
+      data16_ = true;
+    } else if ((prefix == 0xf2 || prefix == 0xf3) && !repeat_) {
+      repeat_ = prefix;
+    } else if ((prefix == 0x64 || prefix == 0x65) && !segment_) {
+      segment_ = prefix;
+    } else if ((prefix == 0x26 || prefix == 0x2e || prefix == 0x36 ||
+                prefix == 0x3e) && !segment_ && !amd64_) {
+      // In 64-bit mode these overrides are ignored, and objdump shows them
+      // apart from the operand.
+      segment_ = prefix;
+    } else if (amd64_ && (prefix & 0xf0) == 0x40) {
+      // A REX prefix must come last.
+      rex_ = prefix;
+      ++offset_;
+      return offset_ < length_ && (bytes_[offset_] & 0xf0) != 0x40 &&
+             bytes_[offset_] != 0xf0 && bytes_[offset_] != 0x66 &&
+             bytes_[offset_] != 0xf2 && bytes_[offset_] != 0xf3 &&
+             bytes_[offset_] != 0x64 && bytes_[offset_] != 0x65;
+    } else if ((prefix & 0xe7) == 0x26 || prefix == 0x64 || prefix == 0x65 ||
+               prefix == 0x66 || prefix == 0x67 || prefix == 0xf0 ||
+               prefix == 0xf2 || prefix == 0xf3) {
+      return false;
+    } else {
+      return true;
+    }
+    ++offset_;
+  }
+  return false;
+}
+
+int IntelSyntaxFormatter::OperandSize() {
+  if (rex_ & kRexW) {
+    rex_used_ |= kRexW | kRexPresent;
+    return 8;
+  }
+  if (data16_) {
+    data16_used_ = true;
+    return 2;
+  }
+  return 4;
+}
+
+string IntelSyntaxFormatter::Register(int number, int size) {
+  switch (size) {
+    case 8:
+      return kRegisterNames64[number];
+    case 4:
+      return kRegisterNames32[number];
+    case 2:
+      return kRegisterNames16[number];
+  }
+  if (rex_) {
+    // Only spl, bpl, sil and dil need the REX prefix itself.
+    if (number >= 4 && number < 8)
+      rex_used_ |= kRexPresent;
+    return kRegisterNames8Rex[number];
+  }
+  return kRegisterNames8[number];
+}
+
+string IntelSyntaxFormatter::RegOperand(int size) {
+  int number = (modrm_ >> 3) & 7;
+  if (rex_ & kRexR) {
+    rex_used_ |= kRexR | kRexPresent;
+    number += 8;
+  }
+  return Register(number, size);
+}
+
+bool IntelSyntaxFormatter::RmOperand(int size, bool size_ptr,
+                                     string* operand) {
+  int mod = modrm_ >> 6;
+  int rm = modrm_ & 7;
+  int extension = 0;
+  if (rex_ & kRexB) {
+    rex_used_ |= kRexB | kRexPresent;
+    extension = 8;
+  }
+  if (mod == 3) {
+    *operand = Register(rm + extension, size);
+    return true;
+  }
+
+  const char* const* address_registers =
+      amd64_ ? kRegisterNames64 : kRegisterNames32;
+  string address = "[";
+  if (rm == 4) {
+    uint8_t sib;
+    if (!Next(&sib))
+      return false;
+    int scale = sib >> 6;
+    int index = (sib >> 3) & 7;
+    int base = sib & 7;
+    if (rex_ & kRexX) {
+      rex_used_ |= kRexX | kRexPresent;
+      index += 8;
+    }
+    if (mod == 0 && base == 5) {
+      // Addresses without a base register are shown differently.
+      return false;
+    }
+    address += address_registers[base + extension];
+    if (scale != 0 || index != 4 || base != 4) {
+      address += "+";
+      if (index != 4) {
+        address += address_registers[index];
+      } else {
+        address += amd64_ ? "riz" : "eiz";
+      }
+      address += "*" + std::to_string(1 << scale);
+    }
+  } else if (mod == 0 && rm == 5) {
+    if (!amd64_)
+      return false;
+    rip_relative_ = true;
+    address += "rip";
+  } else {
+    address += address_registers[rm + extension];
+  }
+
+  int64_t displacement = 0;
+  if (mod == 1) {
+    if (!ReadSigned(1, &displacement))
+      return false;
+  } else if (mod == 2 || rip_relative_) {
+    if (!ReadSigned(4, &displacement))
+      return false;
+  }
+  if (displacement != 0 || mod != 0 || rip_relative_) {
+    if (rip_relative_) {
+      // objdump shows rip-relative displacements unsigned.
+      address += "+" + HexString(static_cast<uint64_t>(displacement));
+    } else if (displacement < 0) {
+      address += "-" + HexString(-static_cast<uint64_t>(displacement));
+    } else {
+      address += "+" + HexString(displacement);
+    }
+  }
+  if (rip_relative_)
+    rip_displacement_ = displacement;
+  address += "]";
+
+  operand->clear();
+  if (size_ptr) {
+    switch (size) {
+      case 1:
+        *operand = "BYTE PTR ";
+        break;
+      case 2:
+        *operand = "WORD PTR ";
+        break;
+      case 4:
+        *operand = "DWORD PTR ";
+        break;
+      case 8:
+        *operand = "QWORD PTR ";
+        break;
+    }
+  }
+  if (segment_) {
+    segment_used_ = true;
+    switch (segment_) {
+      case 0x26:
+        *operand += "es:";
+        break;
+      case 0x2e:
+        *operand += "cs:";
+        break;
+      case 0x36:
+        *operand += "ss:";
+        break;
+      case 0x3e:
+        *operand += "ds:";
+        break;
+      case 0x64:
+        *operand += "fs:";
+        break;
+      case 0x65:
+        *operand += "gs:";
+        break;
+    }
+  }
+  *operand += address;
+  return true;
+}
+
+string IntelSyntaxFormatter::StringOperand(int size, const char* segment,
+                                           int address_register) {
+  const char* size_ptr = size == 1 ? "BYTE PTR " :
+                         size == 2 ? "WORD PTR " :
+                         size == 4 ? "DWORD PTR " : "QWORD PTR ";
+  return string(size_ptr) + segment + ":[" +
+         (amd64_ ? kRegisterNames64 : kRegisterNames32)[address_register] +
+         "]";
+}
+
+bool IntelSyntaxFormatter::Immediate(int immediate_size, int operand_size,
+                                     string* operand) {
+  int64_t value;
+  if (!ReadSigned(immediate_size, &value))
+    return false;
+  uint64_t bits = static_cast<uint64_t>(value);
+  if (operand_size < 8)
+    bits &= (1ULL << (8 * operand_size)) - 1;
+  *operand = HexString(bits);
+  return true;
+}
+
+bool IntelSyntaxFormatter::StringOperation(uint8_t opcode,
+                                           string* instruction) {
+  static const int kSi = 6;
+  static const int kDi = 7;
+  if (segment_)
+    return false;
+  int size = (opcode & 1) ? OperandSize() : 1;
+  string accumulator = Register(0, size);
+  string operation;
+  string operands;
+  bool compares = false;
+  switch (opcode & 0xfe) {
+    case 0xa4:
+      operation = "movs";
+      operands = StringOperand(size, "es", kDi) + "," +
+                 StringOperand(size, "ds", kSi);
+      break;
+    case 0xa6:
+      operation = "cmps";
+      operands = StringOperand(size, "ds", kSi) + "," +
+                 StringOperand(size, "es", kDi);
+      compares = true;
+      break;
+    case 0xaa:
+      operation = "stos";
+      operands = StringOperand(size, "es", kDi) + "," + accumulator;
+      break;
+    case 0xac:
+      operation = "lods";
+      operands = accumulator + "," + StringOperand(size, "ds", kSi);
+      break;
+    case 0xae:
+      operation = "scas";
+      operands = accumulator + "," + StringOperand(size, "es", kDi);
+      compares = true;
+      break;
+    default:
+      return false;
+  }
+  *instruction = operation + " " + operands;
+  if (repeat_ == 0xf3) {
+    *instruction = (compares ? "repz " : "rep ") + *instruction;
+  } else if (repeat_ == 0xf2) {
+    *instruction = "repnz " + *instruction;
+  }
+  return true;
+}
+
+bool IntelSyntaxFormatter::Operation(string* operation, string* dest,
+                                     string* src) {
+  uint8_t opcode;
+  if (!Next(&opcode))
+    return false;
+
+  if (opcode == 0x0f) {
+    if (!Next(&opcode) || !Next(&modrm_))
+      return false;
+    switch (opcode) {
+      case 0xaf:
+        *operation = "imul";
+        *dest = RegOperand(OperandSize());
+        return RmOperand(OperandSize(), true, src);
+      case 0xb0:
+      case 0xb1:
+      case 0xc0:
+      case 0xc1: {
+        *operation = opcode < 0xc0 ? "cmpxchg" : "xadd";
+        int size = (opcode & 1) ? OperandSize() : 1;
+        if (!RmOperand(size, true, dest))
+          return false;
+        *src = RegOperand(size);
+        return true;
+      }
+      case 0xb6:
+      case 0xb7:
+      case 0xbe:
+      case 0xbf:
+        *operation = opcode < 0xbe ? "movzx" : "movsx";
+        *dest = RegOperand(OperandSize());
+        return RmOperand((opcode & 1) ? 2 : 1, true, src);
+    }
+    return false;
+  }
+
+  if ((opcode >= 0xa4 && opcode <= 0xa7) ||
+      (opcode >= 0xaa && opcode <= 0xaf)) {
+    return false;
+  }
+
+  if (!Next(&modrm_))
+    return false;
+  int extension = (modrm_ >> 3) & 7;
+  int size = (opcode & 1) ? OperandSize() : 1;
+
+  if (opcode < 0x40 && (opcode & 7) < 4) {
+    // The arithmetic operations between a register and r/m.
+    *operation = kArithmeticOperations[opcode >> 3];
+    if (opcode & 2) {
+      *dest = RegOperand(size);
+      return RmOperand(size, true, src);
+    }
+    if (!RmOperand(size, true, dest))
+      return false;
+    *src = RegOperand(size);
+    return true;
+  }
+
+  switch (opcode) {
+    case 0x84:
+    case 0x85:
+    case 0x86:
+    case 0x87:
+    case 0x88:
+    case 0x89:
+      *operation = opcode < 0x86 ? "test" : opcode < 0x88 ? "xchg" : "mov";
+      if (!RmOperand(size, true, dest))
+        return false;
+      *src = RegOperand(size);
+      return true;
+    case 0x8a:
+    case 0x8b:
+      *operation = "mov";
+      *dest = RegOperand(size);
+      return RmOperand(size, true, src);
+    case 0x8d:
+      if ((modrm_ >> 6) == 3)
+        return false;
+      *operation = "lea";
+      *dest = RegOperand(OperandSize());
+      return RmOperand(0, false, src);
+    case 0x80:
+    case 0x81:
+    case 0x83:
+      *operation = kArithmeticOperations[extension];
+      return RmOperand(size, true, dest) &&
+             Immediate(opcode == 0x81 ? std::min(size, 4) : 1, size, src);
+    case 0xc6:
+    case 0xc7:
+      if (extension != 0)
+        return false;
+      *operation = "mov";
+      return RmOperand(size, true, dest) &&
+             Immediate(std::min(size, 4), size, src);
+    case 0xc0:
+    case 0xc1:
+    case 0xd0:
+    case 0xd1:
+    case 0xd2:
+    case 0xd3:
+      if (!kShiftOperations[extension])
+        return false;
+      *operation = kShiftOperations[extension];
+      if (!RmOperand(size, true, dest))
+        return false;
+      if (opcode < 0xd0)
+        return Immediate(1, 1, src);
+      *src = opcode < 0xd2 ? "1" : "cl";
+      return true;
+    case 0xf6:
+    case 0xf7:
+      if (!kUnaryOperations[extension])
+        return false;
+      *operation = kUnaryOperations[extension];
+      if (!RmOperand(size, true, dest))
+        return false;
+      return extension != 0 || Immediate(std::min(size, 4), size, src);
+    case 0xfe:
+    case 0xff:
+      if (extension == 0 || extension == 1) {
+        *operation = extension == 0 ? "inc" : "dec";
+        return RmOperand(size, true, dest);
+      }
+      if (opcode == 0xff &&
+          (extension == 2 || extension == 4 || extension == 6)) {
+        // Near calls, jumps and pushes are always of the stack width, and
+        // objdump shows a ds override of a call or jump as "notrack".
+        if (data16_ || (rex_ & kRexW) || segment_ == 0x3e)
+          return false;
+        *operation = extension == 2 ? "call" :
+                     extension == 4 ? "jmp" : "push";
+        return RmOperand(amd64_ ? 8 : 4, true, dest);
+      }
+      return false;
+    case 0x8f:
+      if (extension != 0 || data16_ || (rex_ & kRexW))
+        return false;
+      *operation = "pop";
+      return RmOperand(amd64_ ? 8 : 4, true, dest);
+  }
+  return false;
+}
+
+bool IntelSyntaxFormatter::Format(string* instruction) {
+  if (!ReadPrefixes())
+    return false;
+
+  uint8_t opcode = bytes_[offset_];
+  if ((opcode >= 0xa4 && opcode <= 0xa7) ||
+      (opcode >= 0xaa && opcode <= 0xaf)) {
+    ++offset_;
+    if (lock_ || !StringOperation(opcode, instruction))
+      return false;
+  } else {
+    if (repeat_)
+      return false;
+    string operation;
+    string dest;
+    string src;
+    if (!Operation(&operation, &dest, &src))
+      return false;
+    // Only read-modify-writes of memory may be locked.
+    if (lock_ && (dest.find('[') == string::npos ||
+                  !IsLockableOperation(operation))) {
+      return false;
+    }
+    *instruction = (lock_ ? "lock " : "") + operation + " " + dest;
+    if (!src.empty())
+      *instruction += "," + src;
+  }
+
+  // objdump shows each prefix that the instruction does not use.
+  if ((data16_ && !data16_used_) || (segment_ && !segment_used_) ||
+      (rex_ && rex_used_ != rex_)) {
+    return false;
+  }
+  if (rip_relative_) {
+    uint64_t target = offset_ + rip_displacement_;
+    *instruction += "        # " + HexString(target);
+  }
+  return true;
+}
 }  // namespace
 
+// static
+bool DisassemblerObjdump::DecodeInstruction(uint32_t cpu,
+                                            const uint8_t* raw_bytes,
+                                            unsigned int raw_bytes_len,
+                                            string& instruction) {
+  instruction = "";
+  if (!raw_bytes || (cpu != MD_CONTEXT_X86 && cpu != MD_CONTEXT_AMD64))
+    return false;
+
+  IntelSyntaxFormatter formatter(cpu == MD_CONTEXT_AMD64, raw_bytes,
+                                 raw_bytes_len);
+  if (!formatter.Format(&instruction)) {
+    instruction = "";
+    return false;
+  }
+  return true;
+}
+
 // static
 bool DisassemblerObjdump::DisassembleInstruction(uint32_t cpu,
                                                  const uint8_t* raw_bytes,
@@ -451,20 +1053,23 @@ DisassemblerObjdump::DisassemblerObjdump(const uint32_t cpu,
     return;
   }
 
+  // Read as many bytes as the region has, up to the longest instruction,
+  // since we still want to try and disassemble an instruction even if we
+  // don't have enough bytes.
   uint8_t ip_bytes[kMaxX86InstructionLength] = {0};
-  size_t ip_bytes_length;
-  for (ip_bytes_length = 0; ip_bytes_length < kMaxX86InstructionLength;
-       ++ip_bytes_length) {
-    // We have to read byte-by-byte here, since we still want to try and
-    // disassemble an instruction even if we don't have enough bytes.
-    if (!memory_region->GetMemoryAtAddress(address + ip_bytes_length,
-                                           &ip_bytes[ip_bytes_length])) {
-      break;
-    }
+  uint64_t region_end = memory_region->GetBase() + memory_region->GetSize();
+  size_t ip_bytes_length = static_cast<size_t>(std::min<uint64_t>(
+      kMaxX86InstructionLength, region_end - address));
+  if (!memory_region->CopyOut(address, ip_bytes_length, ip_bytes)) {
+    return;
   }
 
+  // Most faulting instructions are simple enough to decode here, which
+  // saves running objdump for them.
   string instruction;
-  if (!DisassembleInstruction(cpu, ip_bytes, kMaxX86InstructionLength,
+  if (!DecodeInstruction(cpu, ip_bytes, kMaxX86InstructionLength,
+                         instruction) &&
+      !DisassembleInstruction(cpu, ip_bytes, kMaxX86InstructionLength,
                               instruction)) {
     return;
   }
@@ -42,7 +42,8 @@
 
 namespace google_breakpad {
 
-// Uses objdump to disassemble a single instruction.
+// Disassembles a single instruction, decoding the common integer instructions
+// in process and using objdump for the rest.
 //
 // Currently supports disassembly for x86 and x86_64 on linux hosts only; on
 // unsupported platform or for unsupported architectures disassembly will fail.
@@ -106,6 +107,15 @@ class DisassemblerObjdump {
  private:
   friend class DisassemblerObjdumpForTest;
 
+  // Decodes the instruction at the start of `raw_bytes` in process, for
+  // `cpu` MD_CONTEXT_X86 or MD_CONTEXT_AMD64, and stores it in `instruction`
+  // exactly as objdump would print it. Only common integer instructions are
+  // supported; returns false for anything else, so that the caller can fall
+  // back to DisassembleInstruction.
+  static bool DecodeInstruction(uint32_t cpu, const uint8_t* raw_bytes,
+                                unsigned int raw_bytes_len,
+                                string& instruction);
+
   // Writes out the provided `raw_bytes` to a temporary file, and executes objdump
   // to disassemble according to `cpu`, which must be either MD_CONTEXT_X86 or
   // MD_CONTEXT_AMD64. Once objdump has completed, parses out the instruction
@@ -46,6 +46,7 @@ namespace google_breakpad {
 class DisassemblerObjdumpForTest : public DisassemblerObjdump {
  public:
   using DisassemblerObjdump::CalculateAddress;
+  using DisassemblerObjdump::DecodeInstruction;
   using DisassemblerObjdump::DisassembleInstruction;
   using DisassemblerObjdump::TokenizeInstruction;
 };
@@ -226,6 +227,59 @@ TEST(DisassemblerObjdumpTest, DisassembleInstructionAMD64) {
   ASSERT_EQ(instruction, "pop    rax");
 }
 
+TEST(DisassemblerObjdumpTest, DecodeInstructionX86) {
+  string instruction;
+  ASSERT_FALSE(DisassemblerObjdumpForTest::DecodeInstruction(
+      MD_CONTEXT_X86, nullptr, 0, instruction));
+  std::vector<uint8_t> load = {0x8b, 0x44, 0x24, 0x10};
+  ASSERT_TRUE(DisassemblerObjdumpForTest::DecodeInstruction(
+      MD_CONTEXT_X86, load.data(), load.size(), instruction));
+  ASSERT_EQ(instruction, "mov eax,DWORD PTR [esp+0x10]");
+  std::vector<uint8_t> lock_cmpxchg = {0xf0, 0x0f, 0xb1, 0x56, 0x10};
+  ASSERT_TRUE(DisassemblerObjdumpForTest::DecodeInstruction(
+      MD_CONTEXT_X86, lock_cmpxchg.data(), lock_cmpxchg.size(), instruction));
+  ASSERT_EQ(instruction, "lock cmpxchg DWORD PTR [esi+0x10],edx");
+  std::vector<uint8_t> rep_stosb = {0xf3, 0xaa};
+  ASSERT_TRUE(DisassemblerObjdumpForTest::DecodeInstruction(
+      MD_CONTEXT_X86, rep_stosb.data(), rep_stosb.size(), instruction));
+  ASSERT_EQ(instruction, "rep stos BYTE PTR es:[edi],al");
+  std::vector<uint8_t> add_imm8 = {0x83, 0x44, 0x8b, 0xfc, 0xff};
+  ASSERT_TRUE(DisassemblerObjdumpForTest::DecodeInstruction(
+      MD_CONTEXT_X86, add_imm8.data(), add_imm8.size(), instruction));
+  ASSERT_EQ(instruction, "add DWORD PTR [ebx+ecx*4-0x4],0xffffffff");
+  // Left to objdump.
+  std::vector<uint8_t> pop_eax = {0x58};
+  ASSERT_FALSE(DisassemblerObjdumpForTest::DecodeInstruction(
+      MD_CONTEXT_X86, pop_eax.data(), pop_eax.size(), instruction));
+  ASSERT_EQ(instruction, "");
+}
+
+TEST(DisassemblerObjdumpTest, DecodeInstructionAMD64) {
+  string instruction;
+  std::vector<uint8_t> load = {0x48, 0x8b, 0x47, 0x08};
+  ASSERT_TRUE(DisassemblerObjdumpForTest::DecodeInstruction(
+      MD_CONTEXT_AMD64, load.data(), load.size(), instruction));
+  ASSERT_EQ(instruction, "mov rax,QWORD PTR [rdi+0x8]");
+  std::vector<uint8_t> store = {0x44, 0x88, 0x04, 0x01};
+  ASSERT_TRUE(DisassemblerObjdumpForTest::DecodeInstruction(
+      MD_CONTEXT_AMD64, store.data(), store.size(), instruction));
+  ASSERT_EQ(instruction, "mov BYTE PTR [rcx+rax*1],r8b");
+  std::vector<uint8_t> call = {0x41, 0xff, 0x54, 0x24, 0x18};
+  ASSERT_TRUE(DisassemblerObjdumpForTest::DecodeInstruction(
+      MD_CONTEXT_AMD64, call.data(), call.size(), instruction));
+  ASSERT_EQ(instruction, "call QWORD PTR [r12+0x18]");
+  std::vector<uint8_t> load_rip_relative = {0x48, 0x8b, 0x05, 0x10, 0x00,
+                                            0x00, 0x00};
+  ASSERT_TRUE(DisassemblerObjdumpForTest::DecodeInstruction(
+      MD_CONTEXT_AMD64, load_rip_relative.data(), load_rip_relative.size(),
+      instruction));
+  ASSERT_EQ(instruction, "mov rax,QWORD PTR [rip+0x10]        # 0x17");
+  // objdump shows the unused REX prefix.
+  std::vector<uint8_t> rex_load = {0x40, 0x8a, 0x07};
+  ASSERT_FALSE(DisassemblerObjdumpForTest::DecodeInstruction(
+      MD_CONTEXT_AMD64, rex_load.data(), rex_load.size(), instruction));
+}
+
 TEST(DisassemblerObjdumpTest, TokenizeInstruction) {
   string operation, dest, src;
   ASSERT_TRUE(DisassemblerObjdumpForTest::TokenizeInstruction(
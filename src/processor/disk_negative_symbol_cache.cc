@@ -0,0 +1,120 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// disk_negative_symbol_cache.cc: A NegativeSymbolCache kept in a directory.
+//
+// See disk_negative_symbol_cache.h for documentation.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "processor/disk_negative_symbol_cache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "processor/logging.h"
+#include "processor/pathname_stripper.h"
+
+namespace google_breakpad {
+
+const char kNotFoundMarkerExtension[] = ".notfound";
+
+bool DiskNegativeSymbolCache::GetMarkerPath(const string& debug_file,
+                                            const string& debug_identifier,
+                                            string* path) const {
+  string debug_file_name = PathnameStripper::File(debug_file);
+  if (debug_file_name.empty() || debug_file_name == "." ||
+      debug_file_name == ".." || debug_identifier.empty() ||
+      debug_identifier.find('/') != string::npos) {
+    return false;
+  }
+  *path = directory_ + "/" + debug_file_name + "." + debug_identifier +
+          kNotFoundMarkerExtension;
+  return true;
+}
+
+bool DiskNegativeSymbolCache::IsMissing(const string& debug_file,
+                                        const string& debug_identifier) {
+  string path;
+  struct stat marker_stat;
+  if (ttl_ <= 0 || !GetMarkerPath(debug_file, debug_identifier, &path) ||
+      stat(path.c_str(), &marker_stat) != 0) {
+    return false;
+  }
+  return time(NULL) - marker_stat.st_mtime < ttl_;
+}
+
+void DiskNegativeSymbolCache::SetMissing(const string& debug_file,
+                                         const string& debug_identifier) {
+  string path;
+  if (ttl_ <= 0 || !GetMarkerPath(debug_file, debug_identifier, &path))
+    return;
+
+  if (mkdir(directory_.c_str(), 0755) != 0 && errno != EEXIST) {
+    BPLOG(ERROR) << "Could not create directory " << directory_ << ": "
+                 << strerror(errno);
+    return;
+  }
+
+  // Create the marker under a temporary name and rename it into place, so
+  // that an existing marker's modification time is refreshed atomically.
+  string temp_path = path + ".XXXXXX";
+  int fd = mkstemp(&temp_path[0]);
+  if (fd == -1) {
+    BPLOG(ERROR) << "Could not create " << temp_path << ": "
+                 << strerror(errno);
+    return;
+  }
+  bool written = fchmod(fd, 0644) == 0;
+  if (close(fd) != 0)
+    written = false;
+  if (!written || rename(temp_path.c_str(), path.c_str()) != 0) {
+    BPLOG(ERROR) << "Could not write " << path << ": " << strerror(errno);
+    unlink(temp_path.c_str());
+  }
+}
+
+void DiskNegativeSymbolCache::Invalidate(const string& debug_file,
+                                         const string& debug_identifier) {
+  string path;
+  if (!GetMarkerPath(debug_file, debug_identifier, &path))
+    return;
+  if (unlink(path.c_str()) != 0 && errno != ENOENT) {
+    BPLOG(ERROR) << "Could not delete " << path << ": " << strerror(errno);
+  }
+}
+
+}  // namespace google_breakpad
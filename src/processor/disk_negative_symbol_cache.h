@@ -0,0 +1,88 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// disk_negative_symbol_cache.h: A NegativeSymbolCache kept in a directory.
+//
+// DiskNegativeSymbolCache records a module without symbols as an empty
+// marker file in its directory, named for the module's debug file and
+// identifier with kNotFoundMarkerExtension appended:
+//
+//   <directory>/libc.so.6.F4F8DFCD5A5FB5A7CE64717E9E6AE3890.notfound
+//
+// The record expires once the marker's modification time is older than the
+// TTL.  Markers persist across processes, and several processes may share
+// a directory.  Invalidating a module deletes its marker, so a symbol
+// upload job can do it by deleting the file, too.
+
+#ifndef PROCESSOR_DISK_NEGATIVE_SYMBOL_CACHE_H__
+#define PROCESSOR_DISK_NEGATIVE_SYMBOL_CACHE_H__
+
+#include <string>
+
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/negative_symbol_cache.h"
+
+namespace google_breakpad {
+
+// Appended to the name of a marker file.
+extern const char kNotFoundMarkerExtension[];
+
+class DiskNegativeSymbolCache : public NegativeSymbolCache {
+ public:
+  // Creates a DiskNegativeSymbolCache keeping its markers in directory,
+  // which is created if needed.
+  explicit DiskNegativeSymbolCache(const string& directory)
+      : directory_(directory), ttl_(60 * 60) {}
+
+  virtual ~DiskNegativeSymbolCache() {}
+
+  virtual bool IsMissing(const string& debug_file,
+                         const string& debug_identifier);
+  virtual void SetMissing(const string& debug_file,
+                          const string& debug_identifier);
+  virtual void Invalidate(const string& debug_file,
+                          const string& debug_identifier);
+
+  // How long, in seconds, a module is recorded as having no symbols.  0
+  // disables the cache.  The default is one hour.
+  void set_ttl(int ttl) { ttl_ = ttl; }
+
+  // Sets path to the marker file for the module.  Returns false if the
+  // module's debug file or identifier cannot be part of a file name.
+  bool GetMarkerPath(const string& debug_file,
+                     const string& debug_identifier,
+                     string* path) const;
+
+ private:
+  string directory_;
+  int ttl_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_DISK_NEGATIVE_SYMBOL_CACHE_H__
@@ -0,0 +1,159 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Unit tests for DiskNegativeSymbolCache.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "common/tests/auto_tempdir.h"
+#include "common/using_std_string.h"
+#include "processor/basic_code_module.h"
+#include "processor/disk_negative_symbol_cache.h"
+#include "processor/simple_symbol_supplier.h"
+
+namespace {
+
+using google_breakpad::AutoTempDir;
+using google_breakpad::BasicCodeModule;
+using google_breakpad::DiskNegativeSymbolCache;
+using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::SymbolSupplier;
+
+const char kDebugIdentifier[] = "F4F8DFCD5A5FB5A7CE64717E9E6AE3890";
+
+TEST(DiskNegativeSymbolCacheTest, RecordsMissingModules) {
+  AutoTempDir directory;
+  DiskNegativeSymbolCache cache(directory.path() + "/markers");
+  EXPECT_FALSE(cache.IsMissing("libc.so.6", kDebugIdentifier));
+
+  cache.SetMissing("/lib/libc.so.6", kDebugIdentifier);
+  EXPECT_TRUE(cache.IsMissing("libc.so.6", kDebugIdentifier));
+  EXPECT_TRUE(cache.IsMissing("/lib/libc.so.6", kDebugIdentifier));
+  EXPECT_FALSE(cache.IsMissing("libc.so.6", "0123456789ABCDEF"));
+  EXPECT_FALSE(cache.IsMissing("libm.so.6", kDebugIdentifier));
+
+  // Records persist across instances.
+  DiskNegativeSymbolCache other_cache(directory.path() + "/markers");
+  EXPECT_TRUE(other_cache.IsMissing("libc.so.6", kDebugIdentifier));
+
+  other_cache.Invalidate("libc.so.6", kDebugIdentifier);
+  EXPECT_FALSE(cache.IsMissing("libc.so.6", kDebugIdentifier));
+  // Invalidating a module that is not recorded does nothing.
+  other_cache.Invalidate("libc.so.6", kDebugIdentifier);
+}
+
+TEST(DiskNegativeSymbolCacheTest, ExpiresRecords) {
+  AutoTempDir directory;
+  DiskNegativeSymbolCache cache(directory.path());
+  cache.set_ttl(60);
+  cache.SetMissing("libc.so.6", kDebugIdentifier);
+  EXPECT_TRUE(cache.IsMissing("libc.so.6", kDebugIdentifier));
+
+  string marker;
+  ASSERT_TRUE(cache.GetMarkerPath("libc.so.6", kDebugIdentifier, &marker));
+  struct timespec times[2];
+  times[0].tv_sec = 0;
+  times[0].tv_nsec = UTIME_OMIT;
+  times[1].tv_sec = time(NULL) - 61;
+  times[1].tv_nsec = 0;
+  ASSERT_EQ(0, utimensat(AT_FDCWD, marker.c_str(), times, 0));
+  EXPECT_FALSE(cache.IsMissing("libc.so.6", kDebugIdentifier));
+
+  // Recording the module again refreshes it.
+  cache.SetMissing("libc.so.6", kDebugIdentifier);
+  EXPECT_TRUE(cache.IsMissing("libc.so.6", kDebugIdentifier));
+
+  // A TTL of 0 disables the cache.
+  cache.set_ttl(0);
+  EXPECT_FALSE(cache.IsMissing("libc.so.6", kDebugIdentifier));
+  cache.SetMissing("libm.so.6", kDebugIdentifier);
+  cache.set_ttl(60);
+  EXPECT_FALSE(cache.IsMissing("libm.so.6", kDebugIdentifier));
+}
+
+TEST(DiskNegativeSymbolCacheTest, IgnoresUnusableNames) {
+  AutoTempDir directory;
+  DiskNegativeSymbolCache cache(directory.path() + "/markers");
+  string marker;
+  EXPECT_FALSE(cache.GetMarkerPath("", kDebugIdentifier, &marker));
+  EXPECT_FALSE(cache.GetMarkerPath("libc.so.6", "", &marker));
+  EXPECT_FALSE(cache.GetMarkerPath("/lib/..", kDebugIdentifier, &marker));
+  EXPECT_FALSE(cache.GetMarkerPath("libc.so.6", "../ABCDEF", &marker));
+
+  cache.SetMissing("libc.so.6", "");
+  EXPECT_FALSE(cache.IsMissing("libc.so.6", ""));
+  struct stat directory_stat;
+  EXPECT_NE(0, stat((directory.path() + "/markers").c_str(),
+                    &directory_stat));
+}
+
+TEST(DiskNegativeSymbolCacheTest, SkipsSimpleSymbolSupplierSearch) {
+  AutoTempDir directory;
+  DiskNegativeSymbolCache cache(directory.path() + "/markers");
+  string symbols = directory.path() + "/symbols";
+  SimpleSymbolSupplier supplier(symbols);
+  supplier.set_negative_cache(&cache);
+  BasicCodeModule module(0x1000, 0x1000, "/lib/libc.so.6", "", "libc.so.6",
+                         kDebugIdentifier, "");
+
+  string symbol_file;
+  EXPECT_EQ(SymbolSupplier::NOT_FOUND,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file));
+  EXPECT_TRUE(cache.IsMissing("libc.so.6", kDebugIdentifier));
+
+  // Symbols added without invalidating the record are not found.
+  string symbol_dir = symbols + "/libc.so.6";
+  ASSERT_EQ(0, mkdir(symbols.c_str(), 0755));
+  ASSERT_EQ(0, mkdir(symbol_dir.c_str(), 0755));
+  symbol_dir += string("/") + kDebugIdentifier;
+  ASSERT_EQ(0, mkdir(symbol_dir.c_str(), 0755));
+  FILE* file = fopen((symbol_dir + "/libc.so.6.sym").c_str(), "w");
+  ASSERT_TRUE(file);
+  fputs("MODULE Linux x86_64 F4F8DFCD5A5FB5A7CE64717E9E6AE3890 libc.so.6\n",
+        file);
+  fclose(file);
+  EXPECT_EQ(SymbolSupplier::NOT_FOUND,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file));
+
+  cache.Invalidate("libc.so.6", kDebugIdentifier);
+  EXPECT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file));
+  EXPECT_EQ(symbol_dir + "/libc.so.6.sym", symbol_file);
+}
+
+}  // namespace
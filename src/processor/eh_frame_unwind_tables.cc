@@ -0,0 +1,448 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// eh_frame_unwind_tables.cc: Unwind Linux frames with the .eh_frame call
+// frame information in the ELF images themselves.
+//
+// See eh_frame_unwind_tables.h for documentation.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "processor/eh_frame_unwind_tables.h"
+
+#include <string>
+
+#include "common/dwarf/bytereader-inl.h"
+#include "common/dwarf/bytereader.h"
+#include "common/dwarf/dwarf2enums.h"
+#include "common/dwarf/dwarf2reader.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/memory_region.h"
+#include "processor/cfi_frame_info.h"
+#include "processor/logging.h"
+
+namespace google_breakpad {
+
+using std::vector;
+
+namespace {
+
+// ELF header and program header fields, for 64-bit little-endian images.
+const uint32_t kElfMagic = 0x464c457f;  // "\x7f" "ELF"
+const uint8_t kElfClass64 = 2;
+const uint8_t kElfDataLittleEndian = 1;
+const uint16_t kElfMachineX86_64 = 62;
+const uint16_t kElfMachineAArch64 = 183;
+const uint32_t kProgramHeaderLoad = 1;
+const uint32_t kProgramHeaderGnuEhFrame = 0x6474e550;
+const uint16_t kProgramHeaderSize = 56;
+
+// The most program headers read, and the largest CFI entry copied.
+const uint16_t kMaxProgramHeaders = 256;
+const uint32_t kMaxEntrySize = 64 * 1024;
+
+// The names STACK CFI rules use for the registers DWARF numbers, as
+// DwarfCFIToModule names them.
+const char* const kX86_64RegisterNames[] = {
+  "$rax", "$rdx", "$rcx", "$rbx", "$rsi", "$rdi", "$rbp", "$rsp",
+  "$r8",  "$r9",  "$r10", "$r11", "$r12", "$r13", "$r14", "$r15",
+  "$rip",
+};
+
+const char* const kARM64RegisterNames[] = {
+  "x0",  "x1",  "x2",  "x3",  "x4",  "x5",  "x6",  "x7",
+  "x8",  "x9",  "x10", "x11", "x12", "x13", "x14", "x15",
+  "x16", "x17", "x18", "x19", "x20", "x21", "x22", "x23",
+  "x24", "x25", "x26", "x27", "x28", "x29", "x30", "sp",
+};
+
+// Returns the size of a pointer in .eh_frame_hdr with encoding, or zero if
+// the encoding is not one that linkers use there.
+int EncodedPointerSize(uint8_t encoding) {
+  switch (encoding & 0x0f) {
+    case DW_EH_PE_udata4:
+    case DW_EH_PE_sdata4:
+      return 4;
+    case DW_EH_PE_absptr:
+    case DW_EH_PE_udata8:
+    case DW_EH_PE_sdata8:
+      return 8;
+  }
+  return 0;
+}
+
+}  // namespace
+
+// Collects the rules of the row of an FDE's table that covers an address,
+// in the form of STACK CFI rules.  Rules are reported in address order, so
+// the row is whatever was in force when the rules pass the address.
+class EhFrameUnwindTables::RuleHandler : public CallFrameInfo::Handler {
+ public:
+  RuleHandler(uint16_t machine, uint64_t address)
+      : address_(address), matched_(false), return_address_(0),
+        supported_(true) {
+    if (machine == kElfMachineAArch64) {
+      architecture_ = "arm64";
+      names_ = kARM64RegisterNames;
+      name_count_ = sizeof(kARM64RegisterNames) / sizeof(*kARM64RegisterNames);
+    } else {
+      architecture_ = "x86_64";
+      names_ = kX86_64RegisterNames;
+      name_count_ =
+          sizeof(kX86_64RegisterNames) / sizeof(*kX86_64RegisterNames);
+    }
+  }
+
+  bool Entry(size_t offset, uint64_t address, uint64_t length,
+             uint8_t version, const string& augmentation,
+             unsigned return_address) override {
+    if (address_ < address || address_ - address >= length)
+      return false;
+    matched_ = true;
+    return_address_ = return_address;
+    // The return address column often names the register that holds the
+    // return address on entry, with no rule of its own.
+    if (return_address_ < name_count_)
+      rules_[".ra"] = names_[return_address_];
+    return true;
+  }
+
+  bool UndefinedRule(uint64_t address, int reg) override {
+    if (Applies(address))
+      Forget(reg);
+    return true;
+  }
+
+  bool SameValueRule(uint64_t address, int reg) override {
+    const string name = RegisterName(reg);
+    if (Applies(address) && !name.empty())
+      Record(reg, name);
+    return true;
+  }
+
+  bool OffsetRule(uint64_t address, int reg, int base_register,
+                  long offset) override {
+    const string base = RegisterName(base_register);
+    if (Applies(address) && !base.empty())
+      Record(reg, base + " " + std::to_string(offset) + " + ^");
+    return true;
+  }
+
+  bool ValOffsetRule(uint64_t address, int reg, int base_register,
+                     long offset) override {
+    const string base = RegisterName(base_register);
+    if (Applies(address) && !base.empty())
+      Record(reg, base + " " + std::to_string(offset) + " +");
+    return true;
+  }
+
+  bool RegisterRule(uint64_t address, int reg, int base_register) override {
+    const string base = RegisterName(base_register);
+    if (Applies(address) && !base.empty())
+      Record(reg, base);
+    return true;
+  }
+
+  // STACK CFI has no equivalent of DWARF expressions.
+  bool ExpressionRule(uint64_t address, int reg,
+                      const string& expression) override {
+    if (Applies(address))
+      Forget(reg);
+    return true;
+  }
+
+  bool ValExpressionRule(uint64_t address, int reg,
+                         const string& expression) override {
+    if (Applies(address))
+      Forget(reg);
+    return true;
+  }
+
+  bool End() override { return true; }
+
+  string Architecture() override { return architecture_; }
+
+  // Returns the rules for the address, or NULL if no FDE covered it or
+  // the CFA or return address can't be expressed.
+  CFIFrameInfo* Finish() const {
+    if (!matched_ || !supported_)
+      return NULL;
+    std::map<string, string>::const_iterator cfa = rules_.find(".cfa");
+    std::map<string, string>::const_iterator ra = rules_.find(".ra");
+    if (cfa == rules_.end() || ra == rules_.end())
+      return NULL;
+    CFIFrameInfo* info = new CFIFrameInfo();
+    info->SetCFARule(cfa->second);
+    info->SetRARule(ra->second);
+    for (const std::pair<const string, string>& rule : rules_) {
+      if (rule.first != ".cfa" && rule.first != ".ra")
+        info->SetRegisterRule(rule.first, rule.second);
+    }
+    return info;
+  }
+
+ private:
+  bool Applies(uint64_t address) const { return address <= address_; }
+
+  // Returns the name of reg, or the empty string if it has none.
+  string RegisterName(int reg) const {
+    if (reg == kCFARegister)
+      return ".cfa";
+    if (static_cast<unsigned>(reg) == return_address_)
+      return ".ra";
+    if (reg >= 0 && static_cast<unsigned>(reg) < name_count_)
+      return names_[reg];
+    return string();
+  }
+
+  void Record(int reg, const string& rule) {
+    const string name = RegisterName(reg);
+    if (!name.empty())
+      rules_[name] = rule;
+  }
+
+  // Drops the rule for reg, whose value can't be recovered.  Without the
+  // CFA or the return address there is no caller to recover.
+  void Forget(int reg) {
+    const string name = RegisterName(reg);
+    if (name == ".cfa" || name == ".ra")
+      supported_ = false;
+    else if (!name.empty())
+      rules_.erase(name);
+  }
+
+  const uint64_t address_;
+  string architecture_;
+  const char* const* names_;
+  size_t name_count_;
+  bool matched_;
+  unsigned return_address_;
+  bool supported_;
+  std::map<string, string> rules_;
+};
+
+EhFrameUnwindTables::EhFrameUnwindTables(const MemoryRegion* process_memory)
+    : process_memory_(process_memory) {}
+
+EhFrameUnwindTables::~EhFrameUnwindTables() {}
+
+CFIFrameInfo* EhFrameUnwindTables::FindCFIFrameInfo(const CodeModule* module,
+                                                    uint64_t pc,
+                                                    bool context_frame) {
+  if (!module)
+    return NULL;
+  const uint64_t base = module->base_address();
+  const SearchTable* table = GetSearchTable(base);
+  if (!table || table->count == 0)
+    return NULL;
+
+  // A return address may be just past the end of a function that ends
+  // with a call, so look up the call instruction instead.
+  const uint64_t address = context_frame ? pc : pc - 1;
+  uint64_t fde;
+  if (!FindFDE(*table, address, &fde))
+    return NULL;
+
+  // Copy the FDE and its CIE into a buffer of their own, the CIE first,
+  // and point the FDE at it, so that CallFrameInfo parses just the two.
+  uint32_t cie_pointer;
+  if (!process_memory_->GetMemoryAtAddress(fde + 4, &cie_pointer) ||
+      cie_pointer == 0) {
+    return NULL;
+  }
+  vector<uint8_t> entries;
+  if (!ReadEntry(fde + 4 - cie_pointer, &entries))
+    return NULL;
+  const size_t cie_size = entries.size();
+  if (!ReadEntry(fde, &entries))
+    return NULL;
+  const uint32_t new_cie_pointer = static_cast<uint32_t>(cie_size + 4);
+  for (int byte = 0; byte < 4; ++byte)
+    entries[cie_size + 4 + byte] = (new_cie_pointer >> (byte * 8)) & 0xff;
+
+  ByteReader reader(ENDIANNESS_LITTLE);
+  reader.SetAddressSize(8);
+  reader.SetCFIDataBase(fde - cie_size, entries.data());
+  reader.SetTextBase(base);
+  reader.SetDataBase(table->header);
+  RuleHandler handler(table->machine, address);
+  CallFrameInfo::Reporter reporter(module->code_file(), ".eh_frame");
+  CallFrameInfo parser(entries.data(), entries.size(), &reader, &handler,
+                       &reporter, true);
+  parser.Start();
+  return handler.Finish();
+}
+
+const EhFrameUnwindTables::SearchTable*
+EhFrameUnwindTables::GetSearchTable(uint64_t base) {
+  std::lock_guard<std::mutex> lock(search_tables_lock_);
+  std::unique_ptr<SearchTable>& table = search_tables_[base];
+  if (!table) {
+    table.reset(new SearchTable());
+    if (!ReadSearchTable(base, table.get()))
+      table->count = 0;
+  }
+  return table.get();
+}
+
+bool EhFrameUnwindTables::ReadSearchTable(uint64_t base,
+                                          SearchTable* table) const {
+  // The ELF header is at the image's base, and locates the program
+  // headers, which give the image's load bias and the address of the
+  // PT_GNU_EH_FRAME segment.
+  uint32_t magic;
+  uint8_t elf_class, data;
+  uint64_t program_headers;
+  uint16_t program_header_size, program_header_count;
+  if (!process_memory_->GetMemoryAtAddress(base, &magic) ||
+      magic != kElfMagic ||
+      !process_memory_->GetMemoryAtAddress(base + 4, &elf_class) ||
+      elf_class != kElfClass64 ||
+      !process_memory_->GetMemoryAtAddress(base + 5, &data) ||
+      data != kElfDataLittleEndian ||
+      !process_memory_->GetMemoryAtAddress(base + 18, &table->machine) ||
+      (table->machine != kElfMachineX86_64 &&
+       table->machine != kElfMachineAArch64) ||
+      !process_memory_->GetMemoryAtAddress(base + 0x20, &program_headers) ||
+      !process_memory_->GetMemoryAtAddress(base + 0x36,
+                                           &program_header_size) ||
+      program_header_size < kProgramHeaderSize ||
+      !process_memory_->GetMemoryAtAddress(base + 0x38,
+                                           &program_header_count) ||
+      program_header_count > kMaxProgramHeaders) {
+    return false;
+  }
+
+  bool found_load = false;
+  uint64_t bias = 0;
+  bool found_eh_frame = false;
+  uint64_t eh_frame_header = 0;
+  for (uint16_t index = 0; index < program_header_count; ++index) {
+    const uint64_t header =
+        base + program_headers + index * program_header_size;
+    uint32_t type;
+    uint64_t offset, address;
+    if (!process_memory_->GetMemoryAtAddress(header, &type) ||
+        !process_memory_->GetMemoryAtAddress(header + 8, &offset) ||
+        !process_memory_->GetMemoryAtAddress(header + 16, &address)) {
+      return false;
+    }
+    // The image's base is where its first loadable segment's file offset
+    // was mapped.
+    if (type == kProgramHeaderLoad && !found_load) {
+      bias = base - (address - offset);
+      found_load = true;
+    } else if (type == kProgramHeaderGnuEhFrame) {
+      eh_frame_header = address;
+      found_eh_frame = true;
+    }
+  }
+  if (!found_load || !found_eh_frame)
+    return false;
+  table->header = bias + eh_frame_header;
+
+  // .eh_frame_hdr: version, the encodings of the .eh_frame pointer, of the
+  // entry count and of the table's entries, then the pointer, the count
+  // and the table.  Only the encoding linkers use for a searchable table
+  // is supported.
+  uint8_t version, eh_frame_encoding, count_encoding, table_encoding;
+  if (!process_memory_->GetMemoryAtAddress(table->header, &version) ||
+      version != 1 ||
+      !process_memory_->GetMemoryAtAddress(table->header + 1,
+                                           &eh_frame_encoding) ||
+      !process_memory_->GetMemoryAtAddress(table->header + 2,
+                                           &count_encoding) ||
+      !process_memory_->GetMemoryAtAddress(table->header + 3,
+                                           &table_encoding)) {
+    BPLOG(INFO) << ".eh_frame_hdr of image at " << HexString(base)
+                << " is not in memory";
+    return false;
+  }
+  const int eh_frame_pointer_size = EncodedPointerSize(eh_frame_encoding);
+  if (eh_frame_pointer_size == 0 || count_encoding != DW_EH_PE_udata4 ||
+      table_encoding != (DW_EH_PE_datarel | DW_EH_PE_sdata4)) {
+    return false;
+  }
+  const uint64_t count_address = table->header + 4 + eh_frame_pointer_size;
+  if (!process_memory_->GetMemoryAtAddress(count_address, &table->count))
+    return false;
+  table->entries = count_address + 4;
+  return true;
+}
+
+bool EhFrameUnwindTables::FindFDE(const SearchTable& table, uint64_t address,
+                                  uint64_t* fde) const {
+  // Find the last entry whose function starts at or below address.
+  uint32_t low = 0;
+  uint32_t high = table.count;
+  while (low < high) {
+    const uint32_t middle = low + (high - low) / 2;
+    uint32_t start;
+    if (!process_memory_->GetMemoryAtAddress(table.entries + middle * 8ULL,
+                                             &start)) {
+      return false;
+    }
+    if (table.header + static_cast<int32_t>(start) <= address)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  if (low == 0)
+    return false;
+  uint32_t offset;
+  if (!process_memory_->GetMemoryAtAddress(table.entries + (low - 1) * 8ULL + 4,
+                                           &offset)) {
+    return false;
+  }
+  *fde = table.header + static_cast<int32_t>(offset);
+  return true;
+}
+
+bool EhFrameUnwindTables::ReadEntry(uint64_t address,
+                                    vector<uint8_t>* entry) const {
+  // Entries too large for a 32-bit length, and the terminator, aren't
+  // ones the search table points to.
+  uint32_t length;
+  if (!process_memory_->GetMemoryAtAddress(address, &length) ||
+      length == 0 || length > kMaxEntrySize) {
+    return false;
+  }
+  const size_t start = entry->size();
+  entry->resize(start + 4 + length);
+  for (uint32_t byte = 0; byte < 4 + length; ++byte) {
+    if (!process_memory_->GetMemoryAtAddress(address + byte,
+                                             &(*entry)[start + byte])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace google_breakpad
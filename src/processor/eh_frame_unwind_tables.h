@@ -0,0 +1,125 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// eh_frame_unwind_tables.h: Unwind Linux frames with the .eh_frame call
+// frame information in the ELF images themselves.
+//
+// Every ELF image built for C++ exceptions or with asynchronous unwind
+// tables carries DWARF CFI in its .eh_frame section, and a PT_GNU_EH_FRAME
+// segment whose .eh_frame_hdr indexes that CFI with a table sorted by
+// function address.  For a module without symbols this is the same
+// information dump_syms would have turned into STACK CFI.  Minidumps carry
+// it when the writer was asked to capture it (see
+// MinidumpWriter's unwind info option), or when they include the module's
+// memory.
+//
+// The table is searched in the dump's memory, and only the one FDE that
+// covers an address, and its CIE, are parsed.
+//
+// See
+// https://refspecs.linuxfoundation.org/LSB_5.0.0/LSB-Core-generic/LSB-Core-generic/ehframechpt.html
+
+#ifndef PROCESSOR_EH_FRAME_UNWIND_TABLES_H__
+#define PROCESSOR_EH_FRAME_UNWIND_TABLES_H__
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "google_breakpad/common/breakpad_types.h"
+
+namespace google_breakpad {
+
+class CFIFrameInfo;
+class CodeModule;
+class MemoryRegion;
+
+class EhFrameUnwindTables {
+ public:
+  // process_memory reads the memory of the process whose images are to be
+  // unwound; its base and size are not used.  It must outlive this object.
+  explicit EhFrameUnwindTables(const MemoryRegion* process_memory);
+  EhFrameUnwindTables(const EhFrameUnwindTables&) = delete;
+  void operator=(const EhFrameUnwindTables&) = delete;
+  ~EhFrameUnwindTables();
+
+  // Returns rules for recovering the registers of the caller of the frame
+  // whose instruction pointer is pc, in module, or NULL if module is not an
+  // x86-64 or ARM64 ELF image whose .eh_frame_hdr is in memory, or its CFI
+  // doesn't cover pc.  context_frame is true for the innermost frame;
+  // other frames are at return addresses.  The caller takes ownership of
+  // the returned rules.  This may be called by several stack walkers at
+  // once.
+  CFIFrameInfo* FindCFIFrameInfo(const CodeModule* module, uint64_t pc,
+                                 bool context_frame);
+
+ private:
+  // Where an image's .eh_frame_hdr search table is.  An image without one
+  // in memory has a table with no entries.
+  struct SearchTable {
+    SearchTable() : header(0), entries(0), count(0), machine(0) {}
+
+    // The address of the .eh_frame_hdr section, which the table's entries
+    // are relative to.
+    uint64_t header;
+    // The address of the first entry: pairs of signed 32-bit offsets of a
+    // function's start and of its FDE.
+    uint64_t entries;
+    uint32_t count;
+    // The image's ELF e_machine.
+    uint16_t machine;
+  };
+
+  class RuleHandler;
+
+  // Returns the search table of the image at base, reading it the first
+  // time.
+  const SearchTable* GetSearchTable(uint64_t base);
+
+  // Reads the location of the search table of the image at base into
+  // table.
+  bool ReadSearchTable(uint64_t base, SearchTable* table) const;
+
+  // Sets *fde to the address of the FDE that the search table lists for
+  // the function containing address, if any.
+  bool FindFDE(const SearchTable& table, uint64_t address,
+               uint64_t* fde) const;
+
+  // Appends the CFI entry at address to entry.
+  bool ReadEntry(uint64_t address, std::vector<uint8_t>* entry) const;
+
+  const MemoryRegion* process_memory_;
+
+  // Guards search_tables_.  Tables are never changed once read.
+  std::mutex search_tables_lock_;
+  std::map<uint64_t, std::unique_ptr<SearchTable>> search_tables_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_EH_FRAME_UNWIND_TABLES_H__
@@ -0,0 +1,329 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+// eh_frame_unwind_tables_unittest.cc: Unit tests for EhFrameUnwindTables.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "breakpad_googletest_includes.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/memory_region.h"
+#include "processor/basic_code_module.h"
+#include "processor/cfi_frame_info.h"
+#include "processor/eh_frame_unwind_tables.h"
+
+namespace {
+
+using google_breakpad::BasicCodeModule;
+using google_breakpad::CFIFrameInfo;
+using google_breakpad::EhFrameUnwindTables;
+using google_breakpad::MemoryRegion;
+using std::vector;
+
+// Sparse little-endian memory, holding an image and a stack.
+class FakeProcessMemory : public MemoryRegion {
+ public:
+  void Set8(uint64_t address, uint8_t value) { bytes_[address] = value; }
+  void Set16(uint64_t address, uint16_t value) { Set(address, value, 2); }
+  void Set32(uint64_t address, uint32_t value) { Set(address, value, 4); }
+  void Set64(uint64_t address, uint64_t value) { Set(address, value, 8); }
+  void SetBytes(uint64_t address, const vector<uint8_t>& bytes) {
+    for (size_t i = 0; i < bytes.size(); ++i)
+      bytes_[address + i] = bytes[i];
+  }
+
+  uint64_t GetBase() const override { return 0; }
+  uint32_t GetSize() const override { return UINT32_MAX; }
+  bool GetMemoryAtAddress(uint64_t address, uint8_t* value) const override {
+    return Get(address, value);
+  }
+  bool GetMemoryAtAddress(uint64_t address, uint16_t* value) const override {
+    return Get(address, value);
+  }
+  bool GetMemoryAtAddress(uint64_t address, uint32_t* value) const override {
+    return Get(address, value);
+  }
+  bool GetMemoryAtAddress(uint64_t address, uint64_t* value) const override {
+    return Get(address, value);
+  }
+  void Print() const override {}
+
+ private:
+  void Set(uint64_t address, uint64_t value, int size) {
+    for (int i = 0; i < size; ++i)
+      bytes_[address + i] = static_cast<uint8_t>(value >> (i * 8));
+  }
+
+  template<typename T> bool Get(uint64_t address, T* value) const {
+    uint64_t result = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+      std::map<uint64_t, uint8_t>::const_iterator byte =
+          bytes_.find(address + i);
+      if (byte == bytes_.end())
+        return false;
+      result |= static_cast<uint64_t>(byte->second) << (i * 8);
+    }
+    *value = static_cast<T>(result);
+    return true;
+  }
+
+  std::map<uint64_t, uint8_t> bytes_;
+};
+
+
+const uint64_t kBase = 0x7f0000000000ULL;
+const uint64_t kImageSize = 0x10000;
+const uint64_t kEhFrameHeader = kBase + 0x2000;
+const uint64_t kEhFrame = kBase + 0x3000;
+const uint64_t kStack = 0x7ffd0000ULL;
+
+// ELF machines, and DWARF register numbers.
+enum { X86_64 = 62, AARCH64 = 183 };
+enum { RBP = 6, RSP = 7, RIP = 16, X29 = 29, X30 = 30, SP = 31 };
+
+// Call frame instructions.
+enum {
+  DW_CFA_nop = 0x00,
+  DW_CFA_def_cfa = 0x0c,
+  DW_CFA_def_cfa_register = 0x0d,
+  DW_CFA_def_cfa_offset = 0x0e,
+  DW_CFA_advance_loc = 0x40,
+  DW_CFA_offset = 0x80,
+};
+
+class EhFrameUnwindTablesTest : public ::testing::Test {
+ public:
+  EhFrameUnwindTablesTest()
+      : module_(kBase, kImageSize, "libtest.so", "", "libtest.so", "", ""),
+        tables_(&memory_) {}
+
+  // Writes the ELF header and program headers of an image for machine,
+  // whose first loadable segment and PT_GNU_EH_FRAME segment start at
+  // 0x0 and 0x2000, and an empty .eh_frame_hdr.
+  void SetImage(uint16_t machine) {
+    memory_.Set32(kBase, 0x464c457f);
+    memory_.Set8(kBase + 4, 2);
+    memory_.Set8(kBase + 5, 1);
+    memory_.Set16(kBase + 18, machine);
+    memory_.Set64(kBase + 0x20, 0x40);
+    memory_.Set16(kBase + 0x36, 56);
+    memory_.Set16(kBase + 0x38, 2);
+    memory_.Set32(kBase + 0x40, 1);
+    memory_.Set64(kBase + 0x40 + 8, 0);
+    memory_.Set64(kBase + 0x40 + 16, 0);
+    memory_.Set32(kBase + 0x78, 0x6474e550);
+    memory_.Set64(kBase + 0x78 + 8, 0x2000);
+    memory_.Set64(kBase + 0x78 + 16, 0x2000);
+
+    // Version 1, with a pc-relative .eh_frame pointer and a table of
+    // offsets from the header.
+    memory_.SetBytes(kEhFrameHeader, {1, 0x1b, 0x03, 0x3b});
+    memory_.Set32(kEhFrameHeader + 4,
+                  static_cast<uint32_t>(kEhFrame - (kEhFrameHeader + 4)));
+    memory_.Set32(kEhFrameHeader + 8, 0);
+    eh_frame_end_ = kEhFrame;
+  }
+
+  // Appends a CIE with a code alignment factor of 1, a data alignment
+  // factor of -8 and pc-relative FDE addresses to .eh_frame.
+  void AddCIE(uint8_t return_address, const vector<uint8_t>& instructions) {
+    vector<uint8_t> fields = {0, 0, 0, 0, 1, 'z', 'R', 0, 1, 0x78,
+                              return_address, 1, 0x1b};
+    fields.insert(fields.end(), instructions.begin(), instructions.end());
+    cie_ = eh_frame_end_;
+    AddEntry(fields);
+  }
+
+  // Appends an FDE for the function at offset begin of the image to
+  // .eh_frame, and lists it in .eh_frame_hdr.  Functions must be added in
+  // address order.
+  void AddFDE(uint32_t begin, uint32_t length,
+              const vector<uint8_t>& instructions) {
+    const uint64_t fde = eh_frame_end_;
+    vector<uint8_t> fields;
+    AppendWord(&fields, static_cast<uint32_t>(fde + 4 - cie_));
+    AppendWord(&fields, static_cast<uint32_t>(kBase + begin - (fde + 8)));
+    AppendWord(&fields, length);
+    fields.push_back(0);
+    fields.insert(fields.end(), instructions.begin(), instructions.end());
+    AddEntry(fields);
+
+    const uint64_t entry = kEhFrameHeader + 12 + fde_count_ * 8;
+    memory_.Set32(entry,
+                  static_cast<uint32_t>(kBase + begin - kEhFrameHeader));
+    memory_.Set32(entry + 4, static_cast<uint32_t>(fde - kEhFrameHeader));
+    memory_.Set32(kEhFrameHeader + 8, ++fde_count_);
+  }
+
+  // An x86-64 image with a function at 0x1000 that pushes rbp and makes
+  // it the frame pointer, and one at 0x1100 that does nothing to the
+  // stack.
+  void SetX86_64Image() {
+    SetImage(X86_64);
+    AddCIE(RIP, {DW_CFA_def_cfa, RSP, 8, DW_CFA_offset | RIP, 1});
+    AddFDE(0x1000, 0x40,
+           {DW_CFA_advance_loc | 1, DW_CFA_def_cfa_offset, 16,
+            DW_CFA_offset | RBP, 2,
+            DW_CFA_advance_loc | 3, DW_CFA_def_cfa_register, RBP});
+    AddFDE(0x1100, 0x20, {});
+  }
+
+  // Unwinds the frame at pc with the registers in registers, returning
+  // false if there are no rules for it.
+  bool Unwind(uint64_t pc, bool context_frame,
+              const CFIFrameInfo::RegisterValueMap<uint64_t>& registers,
+              CFIFrameInfo::RegisterValueMap<uint64_t>* caller) {
+    std::unique_ptr<CFIFrameInfo> rules(
+        tables_.FindCFIFrameInfo(&module_, pc, context_frame));
+    return rules && rules->FindCallerRegs(registers, memory_, caller);
+  }
+
+  FakeProcessMemory memory_;
+  BasicCodeModule module_;
+  EhFrameUnwindTables tables_;
+
+ private:
+  static void AppendWord(vector<uint8_t>* bytes, uint32_t word) {
+    for (int i = 0; i < 4; ++i)
+      bytes->push_back(static_cast<uint8_t>(word >> (i * 8)));
+  }
+
+  // Writes an entry with fields, padded to a multiple of four bytes, at
+  // the end of .eh_frame.
+  void AddEntry(vector<uint8_t> fields) {
+    while ((fields.size() + 4) % 4)
+      fields.push_back(DW_CFA_nop);
+    memory_.Set32(eh_frame_end_, static_cast<uint32_t>(fields.size()));
+    memory_.SetBytes(eh_frame_end_ + 4, fields);
+    eh_frame_end_ += 4 + fields.size();
+  }
+
+  uint64_t eh_frame_end_ = 0;
+  uint64_t cie_ = 0;
+  uint32_t fde_count_ = 0;
+};
+
+TEST_F(EhFrameUnwindTablesTest, FunctionEntry) {
+  SetX86_64Image();
+  memory_.Set64(kStack, kBase + 0x4321);
+
+  CFIFrameInfo::RegisterValueMap<uint64_t> registers, caller;
+  registers["$rsp"] = kStack;
+  registers["$rbp"] = 0xba5e;
+  ASSERT_TRUE(Unwind(kBase + 0x1000, true, registers, &caller));
+  EXPECT_EQ(kBase + 0x4321, caller[".ra"]);
+  EXPECT_EQ(kStack + 8, caller[".cfa"]);
+  EXPECT_EQ(0U, caller.count("$rbp"));
+}
+
+TEST_F(EhFrameUnwindTablesTest, Body) {
+  SetX86_64Image();
+  const uint64_t frame = kStack + 0x40;
+  memory_.Set64(frame, 0xba5e);
+  memory_.Set64(frame + 8, kBase + 0x4321);
+
+  CFIFrameInfo::RegisterValueMap<uint64_t> registers, caller;
+  registers["$rsp"] = kStack;
+  registers["$rbp"] = frame;
+  ASSERT_TRUE(Unwind(kBase + 0x1020, true, registers, &caller));
+  EXPECT_EQ(kBase + 0x4321, caller[".ra"]);
+  EXPECT_EQ(frame + 16, caller[".cfa"]);
+  EXPECT_EQ(0xba5eU, caller["$rbp"]);
+}
+
+TEST_F(EhFrameUnwindTablesTest, ReturnAddress) {
+  SetX86_64Image();
+  // Returning to just after the push, before rbp became the frame
+  // pointer: the row in force is that of the push.
+  memory_.Set64(kStack, 0xba5e);
+  memory_.Set64(kStack + 8, kBase + 0x4321);
+
+  CFIFrameInfo::RegisterValueMap<uint64_t> registers, caller;
+  registers["$rsp"] = kStack;
+  ASSERT_TRUE(Unwind(kBase + 0x1004, false, registers, &caller));
+  EXPECT_EQ(kBase + 0x4321, caller[".ra"]);
+  EXPECT_EQ(kStack + 16, caller[".cfa"]);
+  EXPECT_EQ(0xba5eU, caller["$rbp"]);
+}
+
+TEST_F(EhFrameUnwindTablesTest, LaterFunction) {
+  SetX86_64Image();
+  memory_.Set64(kStack, kBase + 0x4321);
+
+  CFIFrameInfo::RegisterValueMap<uint64_t> registers, caller;
+  registers["$rsp"] = kStack;
+  ASSERT_TRUE(Unwind(kBase + 0x1110, true, registers, &caller));
+  EXPECT_EQ(kBase + 0x4321, caller[".ra"]);
+  EXPECT_EQ(kStack + 8, caller[".cfa"]);
+}
+
+TEST_F(EhFrameUnwindTablesTest, NotCovered) {
+  SetX86_64Image();
+  // Before the first function, between functions, and past the last.
+  EXPECT_EQ(NULL, tables_.FindCFIFrameInfo(&module_, kBase + 0x800, true));
+  EXPECT_EQ(NULL, tables_.FindCFIFrameInfo(&module_, kBase + 0x1080, true));
+  EXPECT_EQ(NULL, tables_.FindCFIFrameInfo(&module_, kBase + 0x1200, true));
+}
+
+TEST_F(EhFrameUnwindTablesTest, NotInMemory) {
+  // Without the image's headers there are no tables to search.
+  EXPECT_EQ(NULL, tables_.FindCFIFrameInfo(&module_, kBase + 0x1000, true));
+  EXPECT_EQ(NULL, tables_.FindCFIFrameInfo(NULL, kBase + 0x1000, true));
+}
+
+TEST_F(EhFrameUnwindTablesTest, ARM64) {
+  SetImage(AARCH64);
+  // stp x29, x30, [sp, #-16]!; mov x29, sp.
+  AddCIE(X30, {DW_CFA_def_cfa, SP, 0});
+  AddFDE(0x1000, 0x40,
+         {DW_CFA_advance_loc | 4, DW_CFA_def_cfa_offset, 16,
+          DW_CFA_offset | X29, 2, DW_CFA_offset | X30, 1});
+  memory_.Set64(kStack, 0xf4a3e);
+  memory_.Set64(kStack + 8, kBase + 0x4321);
+
+  CFIFrameInfo::RegisterValueMap<uint64_t> registers, caller;
+  registers["sp"] = kStack;
+  registers["x29"] = kStack;
+  registers["x30"] = kBase + 0x1234;
+  ASSERT_TRUE(Unwind(kBase + 0x1010, true, registers, &caller));
+  EXPECT_EQ(kBase + 0x4321, caller[".ra"]);
+  EXPECT_EQ(kStack + 16, caller[".cfa"]);
+  EXPECT_EQ(0xf4a3eU, caller["x29"]);
+
+  // At entry, the return address is still in x30.
+  ASSERT_TRUE(Unwind(kBase + 0x1000, true, registers, &caller));
+  EXPECT_EQ(kBase + 0x1234, caller[".ra"]);
+  EXPECT_EQ(kStack, caller[".cfa"]);
+}
+
+}  // namespace
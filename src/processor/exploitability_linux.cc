@@ -251,12 +251,13 @@ bool ExploitabilityLinux::ExecutableStackOrHeap() {
     for (size_t i = 0; i < linux_maps_list->get_maps_count(); i++) {
       const MinidumpLinuxMaps* linux_maps =
           linux_maps_list->GetLinuxMapsAtIndex(i);
-      // Check for executable stack or heap for each mapping.
-      if (linux_maps && (!linux_maps->GetPathname().compare(
-                             0, strlen(kStackPrefix), kStackPrefix) ||
-                         !linux_maps->GetPathname().compare(
-                             0, strlen(kHeapPrefix), kHeapPrefix)) &&
-          linux_maps->IsExecutable()) {
+      // Check for executable stack or heap for each mapping, testing the
+      // permission first since few mappings are executable.
+      if (linux_maps && linux_maps->IsExecutable() &&
+          (!linux_maps->GetPathname().compare(
+               0, strlen(kStackPrefix), kStackPrefix) ||
+           !linux_maps->GetPathname().compare(
+               0, strlen(kHeapPrefix), kHeapPrefix))) {
         return true;
       }
     }
@@ -35,10 +35,12 @@
 
 #include <type_traits>
 #include <string>
+#include <thread>
 
 #include "breakpad_googletest_includes.h"
 #include "common/using_std_string.h"
 #include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/minidump.h"
 #include "google_breakpad/processor/minidump_processor.h"
 #include "google_breakpad/processor/process_state.h"
 #ifdef __linux__
@@ -67,6 +69,7 @@ using google_breakpad::BasicSourceLineResolver;
 #ifdef __linux__
 using google_breakpad::ExploitabilityLinuxTestMinidumpContext;
 #endif  // __linux__
+using google_breakpad::Minidump;
 using google_breakpad::MinidumpProcessor;
 using google_breakpad::ProcessState;
 using google_breakpad::SimpleSymbolSupplier;
@@ -179,4 +182,40 @@ TEST(ExploitabilityTest, TestLinuxEngine) {
 #endif  // __linux__
 }
 
+TEST(ExploitabilityTest, TestDeferredAnalysis) {
+  SimpleSymbolSupplier supplier(TestDataDir() + "/symbols");
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(&supplier, &resolver, true);
+  processor.set_defer_exploitability(true);
+  ProcessState state;
+
+  Minidump dump(TestDataDir() + "/ascii_read_av.dmp");
+  ASSERT_TRUE(dump.Read());
+  ASSERT_EQ(google_breakpad::PROCESS_OK, processor.Process(&dump, &state));
+  ASSERT_TRUE(state.exploitability_deferred());
+  ASSERT_EQ(google_breakpad::EXPLOITABILITY_NOT_ANALYZED,
+            state.exploitability());
+
+  // The analysis can be run on another thread, and only runs once.
+  google_breakpad::ExploitabilityRating background_rating =
+      google_breakpad::EXPLOITABILITY_NOT_ANALYZED;
+  std::thread analyzer([&]() {
+    background_rating = state.AnalyzeExploitability();
+  });
+  google_breakpad::ExploitabilityRating rating =
+      state.AnalyzeExploitability();
+  analyzer.join();
+  ASSERT_EQ(google_breakpad::EXPLOITABILITY_HIGH, rating);
+  ASSERT_EQ(rating, background_rating);
+  ASSERT_FALSE(state.exploitability_deferred());
+  ASSERT_EQ(google_breakpad::EXPLOITABILITY_HIGH, state.exploitability());
+
+  // Processing a file, whose Minidump goes away, analyzes before returning.
+  state.Clear();
+  ASSERT_EQ(google_breakpad::PROCESS_OK,
+            processor.Process(TestDataDir() + "/null_read_av.dmp", &state));
+  ASSERT_FALSE(state.exploitability_deferred());
+  ASSERT_EQ(google_breakpad::EXPLOITABILITY_NONE, state.exploitability());
+}
+
 }  // namespace
@@ -45,12 +45,14 @@
 
 #include <cassert>
 #include <cstdint>
+#include <cstring>
 #include <map>
 #include <string>
 #include <utility>
 
 #include "common/scoped_ptr.h"
 #include "common/using_std_string.h"
+#include "processor/cfi_frame_info.h"
 #include "processor/logging.h"
 #include "processor/module_factory.h"
 #include "processor/simple_serializer-inl.h"
@@ -67,6 +69,28 @@ bool FastSourceLineResolver::ShouldDeleteMemoryBufferAfterLoadModule() {
   return false;
 }
 
+const uint32_t FastSourceLineResolver::Module::kSerializedMagic;
+const uint32_t FastSourceLineResolver::Module::kSerializedVersion;
+const size_t FastSourceLineResolver::Module::kSerializedHeaderSize;
+
+// static
+uint64_t FastSourceLineResolver::Module::Checksum(const char* data,
+                                                  size_t size) {
+  // FNV-1a, taken a 64-bit word at a time so that checking a large module
+  // costs little next to reading it in the first place.
+  const uint64_t kPrime = 0x100000001b3ULL;
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, data + i, sizeof(word));
+    hash = (hash ^ word) * kPrime;
+  }
+  for (; i < size; ++i)
+    hash = (hash ^ static_cast<uint8_t>(data[i])) * kPrime;
+  return hash;
+}
+
 void FastSourceLineResolver::Module::LookupAddress(
     StackFrame* frame,
     std::deque<std::unique_ptr<StackFrame>>* inlined_frames) const {
@@ -90,7 +114,7 @@ void FastSourceLineResolver::Module::LookupAddress(
                                       &function_base, &function_size) &&
       address >= function_base && address - function_base < function_size) {
     func->CopyFrom(func_ptr);
-    frame->function_name = func->name;
+    frame->function_name = func->name.str();
     frame->function_base = frame->module->base_address() + function_base;
     frame->is_multiple = func->is_multiple;
 
@@ -115,12 +139,138 @@ void FastSourceLineResolver::Module::LookupAddress(
                                       public_symbol_ptr, &public_address) &&
              (!func_ptr || public_address > function_base)) {
     public_symbol->CopyFrom(public_symbol_ptr);
-    frame->function_name = public_symbol->name;
+    frame->function_name = public_symbol->name.str();
     frame->function_base = frame->module->base_address() + public_address;
     frame->is_multiple = public_symbol->is_multiple;
   }
 }
 
+void FastSourceLineResolver::Module::LookupAddresses(
+    const CodeModule* code_module,
+    const MemAddr* addresses,
+    size_t count,
+    SymbolizedAddresses* results) const {
+  static const char kNameOmitted[] = "<name omitted>";
+  NameInterner names(results);
+
+  // The function covering the last address looked up, and the line within
+  // it.  The addresses are sorted, so an address is usually in the same
+  // function, and often on the same line, as the one before it.
+  Function func;
+  bool have_func = false;
+  MemAddr function_base = 0;
+  MemAddr function_size = 0;
+  uint32_t function_name_id = SymbolizedAddresses::kNoName;
+  Line line;
+  bool have_line = false;
+  MemAddr line_base = 0;
+  MemAddr line_size = 0;
+  uint32_t line_file_id = SymbolizedAddresses::kNoName;
+  std::vector<const char*> inline_ptrs;
+
+  for (size_t i = 0; i < count; ++i) {
+    const MemAddr address = addresses[i];
+    if (i > 0 && address == addresses[i - 1]) {
+      RepeatLastAddress(results);
+      continue;
+    }
+
+    if (!have_func || address < function_base ||
+        address - function_base >= function_size) {
+      have_func = false;
+      have_line = false;
+      // As in LookupAddress(), the nearest function bounds the extent of
+      // the PUBLIC symbol used when no function covers the address.
+      const Function* func_ptr = 0;
+      if (functions_.RetrieveNearestRange(address, func_ptr, &function_base,
+                                          &function_size) &&
+          address >= function_base &&
+          address - function_base < function_size) {
+        func.CopyFrom(func_ptr);
+        have_func = true;
+        function_name_id = names.Intern(func.name);
+      } else {
+        const PublicSymbol* public_symbol_ptr = 0;
+        MemAddr public_address;
+        if (public_symbols_.Retrieve(address,
+                                     public_symbol_ptr, &public_address) &&
+            (!func_ptr || public_address > function_base)) {
+          PublicSymbol public_symbol;
+          public_symbol.CopyFrom(public_symbol_ptr);
+          results->function_name_ids.push_back(
+              names.Intern(public_symbol.name));
+          results->function_bases.push_back(public_address);
+        } else {
+          results->function_name_ids.push_back(SymbolizedAddresses::kNoName);
+          results->function_bases.push_back(0);
+        }
+        results->file_name_ids.push_back(SymbolizedAddresses::kNoName);
+        results->lines.push_back(0);
+        results->inline_begins.push_back(
+            static_cast<uint32_t>(results->inline_function_name_ids.size()));
+        continue;
+      }
+    }
+
+    if (!have_line || address < line_base ||
+        address - line_base >= line_size) {
+      have_line = false;
+      const Line* line_ptr = 0;
+      if (func.lines.RetrieveRange(address, line_ptr, &line_base,
+                                   &line_size)) {
+        line.CopyFrom(line_ptr);
+        have_line = true;
+        FileMap::iterator it = files_.find(line.source_file_id);
+        line_file_id = it != files_.end()
+                           ? names.Intern(StringView(it.GetValuePtr()))
+                           : SymbolizedAddresses::kNoName;
+      }
+    }
+
+    results->function_name_ids.push_back(function_name_id);
+    results->function_bases.push_back(function_base);
+    results->file_name_ids.push_back(have_line ? line_file_id
+                                               : SymbolizedAddresses::kNoName);
+    results->lines.push_back(have_line ? line.line : 0);
+    const size_t inline_begin = results->inline_function_name_ids.size();
+    results->inline_begins.push_back(static_cast<uint32_t>(inline_begin));
+
+    inline_ptrs.clear();
+    if (!func.inlines.RetrieveRanges(address, inline_ptrs))
+      continue;
+    for (const char* inline_ptr : inline_ptrs) {
+      Inline in;
+      in.CopyFrom(inline_ptr);
+      auto origin_iter = inline_origins_.find(in.origin_id);
+      if (origin_iter != inline_origins_.end()) {
+        InlineOrigin origin;
+        origin.CopyFrom(origin_iter.GetValuePtr());
+        results->inline_function_name_ids.push_back(names.Intern(origin.name));
+      } else {
+        results->inline_function_name_ids.push_back(
+            names.Intern(StringView(kNameOmitted)));
+      }
+      MemAddr inline_base = 0;
+      for (const auto& range : in.inline_ranges) {
+        if (address >= range.first && address < range.first + range.second) {
+          inline_base = range.first;
+          break;
+        }
+      }
+      results->inline_function_bases.push_back(inline_base);
+      uint32_t call_site_file_id = SymbolizedAddresses::kNoName;
+      if (in.has_call_site_file_id) {
+        auto file_iter = files_.find(in.call_site_file_id);
+        if (file_iter != files_.end())
+          call_site_file_id = names.Intern(StringView(file_iter.GetValuePtr()));
+      }
+      results->inline_file_name_ids.push_back(call_site_file_id);
+      results->inline_lines.push_back(in.call_site_line);
+    }
+    RotateInlineSourcePositions(inline_begin, results);
+  }
+}
+
 void FastSourceLineResolver::Module::ConstructInlineFrames(
     StackFrame* frame,
     MemAddr address,
@@ -140,7 +290,7 @@ void FastSourceLineResolver::Module::ConstructInlineFrames(
     if (origin_iter != inline_origins_.end()) {
       scoped_ptr<InlineOrigin> origin(new InlineOrigin);
       origin->CopyFrom(origin_iter.GetValuePtr());
-      new_frame->function_name = origin->name;
+      new_frame->function_name = origin->name.str();
     } else {
       new_frame->function_name = "<name omitted>";
     }
@@ -225,14 +375,39 @@ bool FastSourceLineResolver::Module::LoadMapFromMemory(
     size_t memory_buffer_size) {
   if (!memory_buffer) return false;
 
-  // Read the "is_corrupt" flag.
+  unsigned int header_size = kNumberMaps_ * sizeof(uint64_t);
+  if (memory_buffer_size <
+      kSerializedHeaderSize + sizeof(bool) + header_size) {
+    BPLOG(ERROR) << "Memory buffer is too small to be a serialized module"
+                 << ", size: " << memory_buffer_size;
+    is_corrupt_ = true;
+    return false;
+  }
+
+  // Check the magic number and format version.
   const char* mem_buffer = memory_buffer;
+  uint32_t magic, version;
+  uint64_t checksum;
+  memcpy(&magic, mem_buffer, sizeof(magic));
+  mem_buffer += sizeof(magic);
+  memcpy(&version, mem_buffer, sizeof(version));
+  mem_buffer += sizeof(version);
+  memcpy(&checksum, mem_buffer, sizeof(checksum));
+  mem_buffer += sizeof(checksum);
+  if (magic != kSerializedMagic || version != kSerializedVersion) {
+    BPLOG(ERROR) << "Memory buffer is not a serialized module in version "
+                 << kSerializedVersion << ", magic: " << magic
+                 << ", version: " << version;
+    is_corrupt_ = true;
+    return false;
+  }
+  const char* body = mem_buffer;
+
+  // Read the "is_corrupt" flag.
   mem_buffer = SimpleSerializer<bool>::Read(mem_buffer, &is_corrupt_);
 
   const uint64_t* map_sizes = reinterpret_cast<const uint64_t*>(mem_buffer);
 
-  unsigned int header_size = kNumberMaps_ * sizeof(uint64_t);
-
   // offsets[]: an array of offset addresses (with respect to mem_buffer),
   // for each "Static***Map" component of Module.
   // "Static***Map": static version of std::map or map wrapper, i.e., StaticMap,
@@ -242,7 +417,8 @@ bool FastSourceLineResolver::Module::LoadMapFromMemory(
   for (int i = 1; i < kNumberMaps_; ++i) {
     offsets[i] = offsets[i - 1] + map_sizes[i - 1];
   }
-  size_t expected_size = sizeof(bool) + offsets[kNumberMaps_ - 1] +
+  size_t expected_size = kSerializedHeaderSize + sizeof(bool) +
+                         offsets[kNumberMaps_ - 1] +
                          map_sizes[kNumberMaps_ - 1] + 1;
   if (expected_size != memory_buffer_size &&
       // Allow for having an extra null terminator.
@@ -252,9 +428,15 @@ bool FastSourceLineResolver::Module::LoadMapFromMemory(
     BPLOG(ERROR) << "Memory buffer is either corrupt or an unsupported version"
                  << ", expected size: " << expected_size
                  << ", actual size: " << memory_buffer_size;
+    is_corrupt_ = true;
     return false;
   }
   BPLOG(INFO) << "Memory buffer size looks good, size: " << memory_buffer_size;
+  if (Checksum(body, expected_size - kSerializedHeaderSize) != checksum) {
+    BPLOG(ERROR) << "Memory buffer checksum mismatch";
+    is_corrupt_ = true;
+    return false;
+  }
 
   // Use pointers to construct Static*Map data members in Module:
   int map_id = 0;
@@ -346,7 +528,7 @@ CFIFrameInfo* FastSourceLineResolver::Module::FindCFIFrameInfo(
   // Create a frame info structure, and populate it with the rules from
   // the STACK CFI INIT record.
   scoped_ptr<CFIFrameInfo> rules(new CFIFrameInfo());
-  if (!ParseCFIRuleSet(initial_rules, rules.get()))
+  if (!ApplyCompiledCFIRuleSet(initial_rules, rules.get()))
     return NULL;
 
   // Find the first delta rule that falls within the initial rule's range.
@@ -355,7 +537,7 @@ CFIFrameInfo* FastSourceLineResolver::Module::FindCFIFrameInfo(
 
   // Apply delta rules up to and including the frame's address.
   while (delta != cfi_delta_rules_.end() && delta.GetKey() <= address) {
-    ParseCFIRuleSet(delta.GetValuePtr(), rules.get());
+    ApplyCompiledCFIRuleSet(delta.GetValuePtr(), rules.get());
     delta++;
   }
 
@@ -83,7 +83,7 @@ public SourceLineResolverBase::Function {
   // De-serialize the memory data of a Function.
   void CopyFrom(const char* raw) {
     size_t name_size = strlen(raw) + 1;
-    name = raw;
+    name = StringView(raw, name_size - 1);
     raw += name_size;
     DESERIALIZE(raw, address);
     DESERIALIZE(raw, size);
@@ -148,7 +148,7 @@ public SourceLineResolverBase::PublicSymbol {
   // De-serialize the memory data of a PublicSymbol.
   void CopyFrom(const char* raw) {
     size_t name_size = strlen(raw) + 1;
-    name = raw;
+    name = StringView(raw, name_size - 1);
     raw += name_size;
     DESERIALIZE(raw, address);
     DESERIALIZE(raw, parameter_size);
@@ -169,6 +169,13 @@ class FastSourceLineResolver::Module: public SourceLineResolverBase::Module {
       StackFrame* frame,
       std::deque<std::unique_ptr<StackFrame>>* inlined_frames) const;
 
+  // Looks up a sorted batch of addresses, keeping the function and line
+  // found for one address for the addresses after it that they cover.
+  virtual void LookupAddresses(const CodeModule* code_module,
+                               const MemAddr* addresses,
+                               size_t count,
+                               SymbolizedAddresses* results) const;
+
   // Construct inlined frames for |frame| and store them in |inline_frames|.
   // |frame|'s source line and source file name may be updated if an inlined
   // frame is found inside |frame|. As a result, the innermost inlined frame
@@ -203,6 +210,17 @@ class FastSourceLineResolver::Module: public SourceLineResolverBase::Module {
   // Number of serialized map components of Module.
   static const int kNumberMaps_ = 6 + WindowsFrameInfo::STACK_INFO_LAST;
 
+  // A serialized module starts with kSerializedMagic, the version of the
+  // format it's in, and a checksum of the rest of the data, as computed by
+  // Checksum.  Data in any other version is rejected rather than misread.
+  static const uint32_t kSerializedMagic = 0x54534146;  // "FAST"
+  static const uint32_t kSerializedVersion = 2;
+  static const size_t kSerializedHeaderSize =
+      2 * sizeof(uint32_t) + sizeof(uint64_t);
+
+  // The checksum of the size bytes at data.
+  static uint64_t Checksum(const char* data, size_t size);
+
  private:
   friend class FastSourceLineResolver;
   friend class ModuleComparer;
@@ -222,10 +240,11 @@ class FastSourceLineResolver::Module: public SourceLineResolverBase::Module {
     windows_frame_info_[WindowsFrameInfo::STACK_INFO_LAST];
 
   // DWARF CFI stack walking data. The Module stores the initial rule sets
-  // and rule deltas as strings, just as they appear in the symbol file:
-  // although the file may contain hundreds of thousands of STACK CFI
-  // records, walking a stack will only ever use a few of them, so it's
-  // best to delay parsing a record until it's actually needed.
+  // and rule deltas as compiled rule sets (see CompileCFIRuleSet), which
+  // were parsed when the module was serialized: although the file may
+  // contain hundreds of thousands of STACK CFI records, walking a stack
+  // will only ever use a few of them, so it's best not to build anything
+  // from a record until it's actually needed.
   //
   // STACK CFI INIT records: for each range, an initial set of register
   // recovery rules. The RangeMap's itself gives the starting and ending
@@ -42,31 +42,48 @@
 
 #include <assert.h>
 #include <stdio.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
 
+#include <deque>
+#include <memory>
 #include <sstream>
 #include <string>
+#include <vector>
 
 #include "breakpad_googletest_includes.h"
+#include "common/tests/auto_tempdir.h"
 #include "common/using_std_string.h"
 #include "google_breakpad/processor/code_module.h"
+#include "processor/basic_code_module.h"
 #include "google_breakpad/processor/stack_frame.h"
 #include "google_breakpad/processor/memory_region.h"
+#include "google_breakpad/processor/symbolized_addresses.h"
 #include "processor/logging.h"
 #include "processor/module_serializer.h"
 #include "processor/module_comparer.h"
+#include "processor/simple_symbol_supplier.h"
 
 namespace {
 
+using google_breakpad::AutoTempDir;
+using google_breakpad::BasicCodeModule;
 using google_breakpad::SourceLineResolverBase;
 using google_breakpad::BasicSourceLineResolver;
 using google_breakpad::FastSourceLineResolver;
+using google_breakpad::kSerializedBreakpadFileExtension;
 using google_breakpad::ModuleSerializer;
 using google_breakpad::ModuleComparer;
 using google_breakpad::CFIFrameInfo;
 using google_breakpad::CodeModule;
 using google_breakpad::MemoryRegion;
+using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::SymbolSupplier;
 using google_breakpad::StackFrame;
+using google_breakpad::SymbolizedAddresses;
 using google_breakpad::WindowsFrameInfo;
+using google_breakpad::scoped_array;
 using google_breakpad::scoped_ptr;
 
 class TestCodeModule : public CodeModule {
@@ -519,6 +536,75 @@ TEST_F(TestFastSourceLineResolver, TestLoadAndResolveNewInlines) {
   ASSERT_EQ(inlined_frames[0]->trust, StackFrame::FRAME_TRUST_INLINE);
 }
 
+// Checks that SymbolizeAddresses() gives for each of addresses what
+// FillSourceLineInfo() fills in.
+void ExpectSymbolizedLikeFrames(FastSourceLineResolver* resolver,
+                                const CodeModule* module,
+                                const std::vector<uint64_t>& addresses) {
+  SymbolizedAddresses results;
+  ASSERT_TRUE(resolver->SymbolizeAddresses(module, addresses.data(),
+                                           addresses.size(), &results));
+  ASSERT_EQ(addresses.size(), results.size());
+  for (size_t i = 0; i < addresses.size(); ++i) {
+    SCOPED_TRACE(addresses[i]);
+    StackFrame frame;
+    frame.instruction = addresses[i];
+    frame.module = module;
+    std::deque<std::unique_ptr<StackFrame>> inlined_frames;
+    resolver->FillSourceLineInfo(&frame, &inlined_frames);
+
+    uint32_t id = results.function_name_ids[i];
+    EXPECT_EQ(frame.function_name,
+              id == SymbolizedAddresses::kNoName ? "" : results.name(id));
+    if (!frame.function_name.empty())
+      EXPECT_EQ(frame.function_base, results.function_bases[i]);
+    id = results.file_name_ids[i];
+    EXPECT_EQ(frame.source_file_name,
+              id == SymbolizedAddresses::kNoName ? "" : results.name(id));
+    EXPECT_EQ(frame.source_line, results.lines[i]);
+
+    size_t begin = results.inline_begins[i];
+    size_t end = i + 1 < addresses.size() ? results.inline_begins[i + 1]
+                                          : results.inline_lines.size();
+    ASSERT_EQ(inlined_frames.size(), end - begin);
+    for (size_t j = 0; j < inlined_frames.size(); ++j) {
+      EXPECT_EQ(inlined_frames[j]->function_name,
+                results.name(results.inline_function_name_ids[begin + j]));
+      EXPECT_EQ(inlined_frames[j]->function_base,
+                results.inline_function_bases[begin + j]);
+      EXPECT_EQ(inlined_frames[j]->source_line,
+                results.inline_lines[begin + j]);
+    }
+  }
+}
+
+TEST_F(TestFastSourceLineResolver, TestSymbolizeAddresses) {
+  TestCodeModule module1("module1");
+  ASSERT_TRUE(basic_resolver.LoadModule(&module1, testdata_dir +
+                                                  "/module1.out"));
+  ASSERT_TRUE(serializer.ConvertOneModule(module1.code_file(),
+                                          &basic_resolver, &fast_resolver));
+  std::vector<uint64_t> addresses;
+  for (uint64_t address = 0xf00; address < 0x3100; address += 0x13) {
+    addresses.push_back(address);
+    if (address % 3 == 0)
+      addresses.push_back(address);
+  }
+  ExpectSymbolizedLikeFrames(&fast_resolver, &module1, addresses);
+
+  TestCodeModule inline_module("linux_inline");
+  ASSERT_TRUE(basic_resolver.LoadModule(
+      &inline_module,
+      testdata_dir + "/symbols/linux_inline/BBA6FA10B8AAB33D00000000000000000/"
+                     "linux_inline.new.sym"));
+  ASSERT_TRUE(serializer.ConvertOneModule(inline_module.code_file(),
+                                          &basic_resolver, &fast_resolver));
+  addresses.clear();
+  for (uint64_t address = 0x15b20; address < 0x16210; address += 3)
+    addresses.push_back(address);
+  ExpectSymbolizedLikeFrames(&fast_resolver, &inline_module, addresses);
+}
+
 TEST_F(TestFastSourceLineResolver, TestInvalidLoads) {
   TestCodeModule module3("module3");
   ASSERT_TRUE(basic_resolver.LoadModule(&module3,
@@ -553,6 +639,40 @@ TEST_F(TestFastSourceLineResolver, TestInvalidLoads) {
   ASSERT_FALSE(fast_resolver.HasModule(&invalidmodule));
 }
 
+TEST_F(TestFastSourceLineResolver, TestRejectsOtherVersionsAndCorruption) {
+  char* symbol_data;
+  size_t symbol_data_size;
+  ASSERT_TRUE(SourceLineResolverBase::ReadSymbolFile(
+      symbol_file(1), &symbol_data, &symbol_data_size));
+  string symbol_data_string(symbol_data, symbol_data_size);
+  delete [] symbol_data;
+  size_t serialized_size;
+  scoped_array<char> serialized(
+      serializer.SerializeSymbolFileData(symbol_data_string,
+                                         &serialized_size));
+  ASSERT_TRUE(serialized.get());
+  string good(serialized.get(), serialized_size);
+
+  TestCodeModule module1("module1");
+  ASSERT_TRUE(fast_resolver.LoadModuleUsingMapBuffer(&module1, good));
+  ASSERT_FALSE(fast_resolver.IsModuleCorrupt(&module1));
+  fast_resolver.UnloadModule(&module1);
+
+  // The format version follows the 4-byte magic number.
+  string other_version = good;
+  other_version[4]++;
+  ASSERT_TRUE(fast_resolver.LoadModuleUsingMapBuffer(&module1,
+                                                     other_version));
+  ASSERT_TRUE(fast_resolver.IsModuleCorrupt(&module1));
+  fast_resolver.UnloadModule(&module1);
+
+  // Flip a bit in the last byte before the null terminator.
+  string corrupt = good;
+  corrupt[corrupt.size() - 2] ^= 1;
+  ASSERT_TRUE(fast_resolver.LoadModuleUsingMapBuffer(&module1, corrupt));
+  ASSERT_TRUE(fast_resolver.IsModuleCorrupt(&module1));
+}
+
 TEST_F(TestFastSourceLineResolver, TestUnload) {
   TestCodeModule module1("module1");
   ASSERT_FALSE(basic_resolver.HasModule(&module1));
@@ -577,6 +697,140 @@ TEST_F(TestFastSourceLineResolver, TestUnload) {
   ASSERT_TRUE(fast_resolver.HasModule(&module1));
 }
 
+TEST_F(TestFastSourceLineResolver, TestLoadFromMappedFile) {
+  char* symbol_data;
+  size_t symbol_data_size;
+  ASSERT_TRUE(SourceLineResolverBase::ReadSymbolFile(
+      symbol_file(1), &symbol_data, &symbol_data_size));
+  string symbol_data_string(symbol_data, symbol_data_size);
+  delete [] symbol_data;
+  size_t serialized_size;
+  scoped_array<char> serialized(
+      serializer.SerializeSymbolFileData(symbol_data_string,
+                                         &serialized_size));
+  ASSERT_TRUE(serialized.get());
+
+  AutoTempDir temp_dir;
+  string serialized_file = temp_dir.path() + "/module1.fast";
+  FILE* file = fopen(serialized_file.c_str(), "wb");
+  ASSERT_TRUE(file);
+  ASSERT_EQ(serialized_size,
+            fwrite(serialized.get(), 1, serialized_size, file));
+  ASSERT_EQ(0, fclose(file));
+
+  TestCodeModule module1("module1");
+  ASSERT_TRUE(fast_resolver.LoadModuleUsingMappedFile(&module1,
+                                                      serialized_file));
+  ASSERT_TRUE(fast_resolver.HasModule(&module1));
+  ASSERT_FALSE(fast_resolver.IsModuleCorrupt(&module1));
+  ASSERT_FALSE(fast_resolver.LoadModuleUsingMappedFile(&module1,
+                                                       serialized_file));
+
+  StackFrame frame;
+  frame.instruction = 0x1000;
+  frame.module = &module1;
+  fast_resolver.FillSourceLineInfo(&frame, nullptr);
+  ASSERT_EQ(frame.function_name, "Function1_1");
+  ASSERT_EQ(frame.source_file_name, "file1_1.cc");
+  ASSERT_EQ(frame.source_line, 44);
+  scoped_ptr<WindowsFrameInfo> windows_frame_info(
+      fast_resolver.FindWindowsFrameInfo(&frame));
+  ASSERT_TRUE(windows_frame_info.get());
+  ASSERT_EQ(windows_frame_info->program_string,
+            "$eip 4 + ^ = $esp $ebp 8 + = $ebp $ebp ^ =");
+
+  fast_resolver.UnloadModule(&module1);
+  ASSERT_FALSE(fast_resolver.HasModule(&module1));
+
+  // A truncated file loads as a corrupt module with no symbols.
+  ASSERT_EQ(0, truncate(serialized_file.c_str(), 4));
+  ASSERT_TRUE(fast_resolver.LoadModuleUsingMappedFile(&module1,
+                                                      serialized_file));
+  ASSERT_TRUE(fast_resolver.IsModuleCorrupt(&module1));
+  ClearSourceLineInfo(&frame);
+  frame.instruction = 0x1000;
+  frame.module = &module1;
+  fast_resolver.FillSourceLineInfo(&frame, nullptr);
+  ASSERT_TRUE(frame.function_name.empty());
+  fast_resolver.UnloadModule(&module1);
+
+  TestCodeModule module5("module5");
+  ASSERT_FALSE(fast_resolver.LoadModuleUsingMappedFile(
+      &module5, temp_dir.path() + "/missing.fast"));
+  ASSERT_FALSE(fast_resolver.HasModule(&module5));
+}
+
+TEST_F(TestFastSourceLineResolver, TestSupplierPrefersSerializedSymbols) {
+  char* symbol_data;
+  size_t symbol_data_size;
+  ASSERT_TRUE(SourceLineResolverBase::ReadSymbolFile(
+      symbol_file(1), &symbol_data, &symbol_data_size));
+  string symbol_data_string(symbol_data, symbol_data_size - 1);
+  delete [] symbol_data;
+  size_t serialized_size;
+  scoped_array<char> serialized(
+      serializer.SerializeSymbolFileData(symbol_data_string,
+                                         &serialized_size));
+  ASSERT_TRUE(serialized.get());
+
+  // Lay out a symbol store holding module1's symbol file and, next to it,
+  // its serialized form.
+  AutoTempDir temp_dir;
+  string symbol_dir = temp_dir.path() + "/module1.pdb";
+  ASSERT_EQ(0, mkdir(symbol_dir.c_str(), 0755));
+  symbol_dir += "/ABCDEF0123";
+  ASSERT_EQ(0, mkdir(symbol_dir.c_str(), 0755));
+  string text_file = symbol_dir + "/module1.sym";
+  string serialized_file = text_file + kSerializedBreakpadFileExtension;
+  FILE* file = fopen(text_file.c_str(), "wb");
+  ASSERT_TRUE(file);
+  ASSERT_EQ(symbol_data_string.size(),
+            fwrite(symbol_data_string.data(), 1, symbol_data_string.size(),
+                   file));
+  ASSERT_EQ(0, fclose(file));
+  file = fopen(serialized_file.c_str(), "wb");
+  ASSERT_TRUE(file);
+  ASSERT_EQ(serialized_size,
+            fwrite(serialized.get(), 1, serialized_size, file));
+  ASSERT_EQ(0, fclose(file));
+
+  BasicCodeModule module1(0, 0x10000, "module1", "", "module1.pdb",
+                          "ABCDEF0123", "");
+  SimpleSymbolSupplier supplier(temp_dir.path());
+  string found_file;
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolFile(&module1, NULL, &found_file));
+  ASSERT_EQ(text_file, found_file);
+
+  supplier.set_prefer_serialized_symbols(true);
+  char* supplied_data;
+  size_t supplied_size;
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            supplier.GetCStringSymbolData(&module1, NULL, &found_file,
+                                          &supplied_data, &supplied_size));
+  ASSERT_EQ(serialized_file, found_file);
+  ASSERT_EQ(serialized_size + 1, supplied_size);
+  ASSERT_TRUE(fast_resolver.LoadModuleUsingMemoryBuffer(
+      &module1, supplied_data, supplied_size));
+  StackFrame frame;
+  frame.instruction = 0x1000;
+  frame.module = &module1;
+  fast_resolver.FillSourceLineInfo(&frame, nullptr);
+  ASSERT_EQ(frame.function_name, "Function1_1");
+  fast_resolver.UnloadModule(&module1);
+  supplier.FreeSymbolData(&module1);
+
+  // A serialized file older than its symbol file is stale.
+  struct timeval times[2];
+  ASSERT_EQ(0, gettimeofday(&times[0], NULL));
+  times[0].tv_sec += 10;
+  times[1] = times[0];
+  ASSERT_EQ(0, utimes(text_file.c_str(), times));
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolFile(&module1, NULL, &found_file));
+  ASSERT_EQ(text_file, found_file);
+}
+
 TEST_F(TestFastSourceLineResolver, CompareModule) {
   char* symbol_data;
   size_t symbol_data_size;
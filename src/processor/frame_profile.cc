@@ -0,0 +1,231 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// frame_profile.cc: Counts of the instruction addresses stack walks
+// symbolize, by module.
+//
+// See frame_profile.h for documentation.
+
+// For <inttypes.h> PRI* macros, before anything else might #include it.
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif  /* __STDC_FORMAT_MACROS */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "google_breakpad/processor/frame_profile.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <tuple>
+#include <vector>
+
+#include "google_breakpad/processor/code_module.h"
+#include "processor/logging.h"
+
+namespace google_breakpad {
+
+namespace {
+
+// Returns true if line starts with prefix, and sets rest to what follows.
+bool ParseRest(const string& line, const char* prefix, string* rest) {
+  string::size_type prefix_length = strlen(prefix);
+  if (line.compare(0, prefix_length, prefix) != 0 ||
+      line.size() == prefix_length) {
+    return false;
+  }
+  *rest = line.substr(prefix_length);
+  return true;
+}
+
+}  // namespace
+
+void FrameProfile::Record(const CodeModule* module, uint64_t address) {
+  ModuleKey key;
+  key.debug_file = module->debug_file();
+  key.debug_identifier = module->debug_identifier();
+  if (key.debug_file.empty() || key.debug_identifier.empty())
+    return;
+  key.code_file = module->code_file();
+
+  std::lock_guard<std::mutex> lock(lock_);
+  ++modules_[key][address];
+}
+
+void FrameProfile::Merge(const FrameProfile& that) {
+  if (&that == this)
+    return;
+  std::scoped_lock lock(lock_, that.lock_);
+  for (const auto& module : that.modules_) {
+    AddressCounts& counts = modules_[module.first];
+    for (const auto& address : module.second)
+      counts[address.first] += address.second;
+  }
+}
+
+void FrameProfile::Prune(size_t max_addresses) {
+  std::lock_guard<std::mutex> lock(lock_);
+  // Rank every address by its count, highest first, breaking ties by
+  // module and address so that pruning is deterministic.
+  typedef std::tuple<uint64_t, const ModuleKey*, uint64_t> Entry;
+  std::vector<Entry> entries;
+  for (const auto& module : modules_) {
+    for (const auto& address : module.second)
+      entries.push_back(Entry(address.second, &module.first, address.first));
+  }
+  if (entries.size() <= max_addresses)
+    return;
+  std::nth_element(entries.begin(), entries.begin() + max_addresses,
+                   entries.end(), [](const Entry& a, const Entry& b) {
+    if (std::get<0>(a) != std::get<0>(b))
+      return std::get<0>(a) > std::get<0>(b);
+    if (*std::get<1>(a) < *std::get<1>(b))
+      return true;
+    if (*std::get<1>(b) < *std::get<1>(a))
+      return false;
+    return std::get<2>(a) < std::get<2>(b);
+  });
+
+  ModuleCounts kept;
+  for (size_t i = 0; i < max_addresses; ++i) {
+    kept[*std::get<1>(entries[i])][std::get<2>(entries[i])] =
+        std::get<0>(entries[i]);
+  }
+  modules_.swap(kept);
+}
+
+string FrameProfile::Serialize() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  string profile_data = "FRAMEPROFILE\n";
+  char line[64];
+  for (const auto& module : modules_) {
+    profile_data.append("MODULE " + module.first.debug_identifier + " " +
+                        module.first.debug_file + "\n");
+    profile_data.append("CODE " + module.first.code_file + "\n");
+    for (const auto& address : module.second) {
+      snprintf(line, sizeof(line), "%" PRIx64 " %" PRIx64 "\n",
+               address.first, address.second);
+      profile_data.append(line);
+    }
+  }
+  return profile_data;
+}
+
+bool FrameProfile::Parse(const string& profile_data) {
+  std::lock_guard<std::mutex> lock(lock_);
+  modules_.clear();
+
+  size_t position = 0;
+  bool have_header = false;
+  // The module being read, and its counts once its CODE record has been
+  // read.
+  ModuleKey key;
+  bool have_module = false;
+  AddressCounts* counts = NULL;
+  bool well_formed = true;
+  while (well_formed && position < profile_data.size()) {
+    size_t newline = profile_data.find('\n', position);
+    if (newline == string::npos)
+      newline = profile_data.size();
+    string line = profile_data.substr(position, newline - position);
+    position = newline + 1;
+
+    string rest;
+    if (!have_header) {
+      well_formed = have_header = line == "FRAMEPROFILE";
+    } else if (ParseRest(line, "MODULE ", &rest)) {
+      string::size_type space = rest.find(' ');
+      well_formed = space != 0 && space != string::npos &&
+                    space + 1 < rest.size() && (!have_module || counts);
+      key.debug_identifier = rest.substr(0, space);
+      key.debug_file = rest.substr(space + 1);
+      have_module = true;
+      counts = NULL;
+    } else if (ParseRest(line, "CODE ", &rest)) {
+      well_formed = have_module && !counts;
+      key.code_file = rest;
+      counts = &modules_[key];
+    } else {
+      uint64_t address, count;
+      char extra;
+      well_formed = counts &&
+          sscanf(line.c_str(), "%" SCNx64 " %" SCNx64 " %c", &address,
+                 &count, &extra) == 2;
+      if (well_formed)
+        (*counts)[address] += count;
+    }
+  }
+
+  if (!well_formed || !have_header || (have_module && !counts)) {
+    modules_.clear();
+    return false;
+  }
+  return true;
+}
+
+bool FrameProfile::ReadFile(const string& profile_file) {
+  std::ifstream in(profile_file.c_str(), std::ios::binary);
+  if (!in)
+    return false;
+  string profile_data((std::istreambuf_iterator<char>(in)),
+                      std::istreambuf_iterator<char>());
+  if (!Parse(profile_data)) {
+    BPLOG(ERROR) << "Malformed frame profile " << profile_file;
+    return false;
+  }
+  return true;
+}
+
+bool FrameProfile::WriteFile(const string& profile_file) const {
+  std::ofstream out(profile_file.c_str(), std::ios::binary);
+  string profile_data = Serialize();
+  out.write(profile_data.data(), profile_data.size());
+  out.close();
+  if (!out) {
+    BPLOG(ERROR) << "Could not write frame profile " << profile_file;
+    return false;
+  }
+  return true;
+}
+
+size_t FrameProfile::AddressCount() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  size_t count = 0;
+  for (const auto& module : modules_)
+    count += module.second.size();
+  return count;
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,384 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// http_symbol_supplier.cc: A SymbolSupplier that downloads symbol files
+// from HTTP symbol servers into a local cache.
+//
+// See http_symbol_supplier.h for documentation.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "processor/http_symbol_supplier.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "common/linux/libcurl_wrapper.h"
+#include "google_breakpad/processor/code_module.h"
+#include "processor/logging.h"
+
+namespace google_breakpad {
+
+namespace {
+
+// Inserted before the random suffix of files being written to the cache, so
+// that they are not mistaken for cache entries.
+const char kTemporaryFileInfix[] = ".tmp.";
+
+const long kHttpOk = 200;
+const long kHttpNotFound = 404;
+
+// Creates directory and any missing parents.
+bool MakeDirectories(const string& directory) {
+  for (size_t slash = directory.find('/', 1); ;
+       slash = directory.find('/', slash + 1)) {
+    string prefix = directory.substr(0, slash);
+    if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+      BPLOG(ERROR) << "Could not create directory " << prefix << ": "
+                   << strerror(errno);
+      return false;
+    }
+    if (slash == string::npos)
+      return true;
+  }
+}
+
+}  // namespace
+
+HttpSymbolSupplier::HttpSymbolSupplier(const vector<string>& server_urls,
+                                       const string& cache_path)
+    : SimpleSymbolSupplier(cache_path),
+      server_urls_(server_urls),
+      cache_path_(cache_path),
+      max_cache_size_(0),
+      default_negative_cache_(cache_path),
+      max_concurrent_downloads_(4),
+      cache_size_(0),
+      cache_entries_loaded_(false),
+      idle_workers_(0),
+      shutting_down_(false) {
+  set_negative_cache(&default_negative_cache_);
+  for (size_t i = 0; i < server_urls_.size(); ++i) {
+    string& url = server_urls_[i];
+    while (!url.empty() && url[url.size() - 1] == '/')
+      url.erase(url.size() - 1);
+  }
+}
+
+HttpSymbolSupplier::~HttpSymbolSupplier() {
+  {
+    std::lock_guard<std::mutex> lock(async_lock_);
+    shutting_down_ = true;
+  }
+  async_condition_.notify_all();
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    workers_[i].join();
+  }
+
+  for (size_t i = 0; i < connections_.size(); ++i) {
+    delete connections_[i];
+  }
+}
+
+SymbolSupplier::SymbolResult HttpSymbolSupplier::GetSymbolFile(
+    const CodeModule* module, const SystemInfo* system_info,
+    string* symbol_file) {
+  SymbolResult result = GetSymbolFileAtPathFromRoot(module, system_info,
+                                                    cache_path_, symbol_file);
+  if (result == FOUND) {
+    TouchCacheFile(*symbol_file);
+    return FOUND;
+  }
+
+  string relative_path;
+  if (!GetSymbolFileRelativePath(module, &relative_path))
+    return NOT_FOUND;
+  if (negative_cache() &&
+      negative_cache()->IsMissing(module->debug_file(),
+                                  module->debug_identifier())) {
+    return NOT_FOUND;
+  }
+
+  result = Download(module, relative_path);
+  if (result == FOUND)
+    *symbol_file = cache_path_ + "/" + relative_path;
+  return result;
+}
+
+void HttpSymbolSupplier::GetCStringSymbolDataAsync(
+    const CodeModule* module, const SystemInfo* system_info,
+    SymbolDataCallback* callback) {
+  {
+    std::lock_guard<std::mutex> lock(async_lock_);
+    AsyncRequest request = { module, system_info, callback };
+    async_requests_.push_back(request);
+    if (async_requests_.size() > idle_workers_ &&
+        workers_.size() <
+            static_cast<size_t>(std::max(1, max_concurrent_downloads_))) {
+      workers_.push_back(
+          std::thread(&HttpSymbolSupplier::ProcessAsyncRequests, this));
+    }
+  }
+  async_condition_.notify_one();
+}
+
+bool HttpSymbolSupplier::Fetch(const string& url,
+                               long* http_status_code,
+                               string* response) {
+  LibcurlWrapper* connection = NULL;
+  {
+    // Initializing libcurl is not thread-safe, so connections are created
+    // with the lock held.
+    std::lock_guard<std::mutex> lock(connections_lock_);
+    if (!connections_.empty()) {
+      connection = connections_.back();
+      connections_.pop_back();
+    } else {
+      connection = new LibcurlWrapper();
+      if (!connection->Init()) {
+        BPLOG(ERROR) << "Could not initialize libcurl";
+        delete connection;
+        return false;
+      }
+    }
+  }
+
+  bool sent =
+      connection->SendGetRequest(url, http_status_code, NULL, response);
+
+  std::lock_guard<std::mutex> lock(connections_lock_);
+  connections_.push_back(connection);
+  return sent;
+}
+
+SymbolSupplier::SymbolResult HttpSymbolSupplier::Download(
+    const CodeModule* module, const string& relative_path) {
+  string cache_file = cache_path_ + "/" + relative_path;
+  bool server_failed = false;
+  for (size_t i = 0; i < server_urls_.size(); ++i) {
+    string url = server_urls_[i] + "/" + relative_path;
+    long http_status_code = 0;
+    string response;
+    if (!Fetch(url, &http_status_code, &response)) {
+      BPLOG(ERROR) << "Could not fetch " << url;
+      server_failed = true;
+      continue;
+    }
+
+    if (http_status_code == kHttpOk) {
+      if (!WriteCacheFile(cache_file, response))
+        return INTERRUPT;
+      if (negative_cache()) {
+        negative_cache()->Invalidate(module->debug_file(),
+                                     module->debug_identifier());
+      }
+      AddCacheFile(cache_file, response.size());
+      BPLOG(INFO) << "Downloaded " << url;
+      return FOUND;
+    }
+
+    if (http_status_code != kHttpNotFound) {
+      BPLOG(ERROR) << "Fetching " << url << " returned HTTP status "
+                   << http_status_code;
+      server_failed = true;
+    }
+  }
+
+  if (server_failed)
+    return INTERRUPT;
+
+  BPLOG(INFO) << "No server has symbol file " << relative_path;
+  if (negative_cache()) {
+    negative_cache()->SetMissing(module->debug_file(),
+                                 module->debug_identifier());
+  }
+  return NOT_FOUND;
+}
+
+bool HttpSymbolSupplier::WriteCacheFile(const string& path,
+                                        const string& data) {
+  size_t slash = path.rfind('/');
+  if (slash != string::npos && slash > 0 &&
+      !MakeDirectories(path.substr(0, slash)))
+    return false;
+
+  // Write to a temporary file renamed into place, so that readers never see
+  // a partially written file.
+  string temp_path = path + kTemporaryFileInfix + "XXXXXX";
+  int fd = mkstemp(&temp_path[0]);
+  if (fd == -1) {
+    BPLOG(ERROR) << "Could not create " << temp_path << ": "
+                 << strerror(errno);
+    return false;
+  }
+  bool written = fchmod(fd, 0644) == 0;
+  for (size_t offset = 0; written && offset < data.size(); ) {
+    ssize_t count = write(fd, data.data() + offset, data.size() - offset);
+    if (count < 0 && errno == EINTR)
+      continue;
+    written = count > 0;
+    if (written)
+      offset += count;
+  }
+  if (close(fd) != 0)
+    written = false;
+  if (!written || rename(temp_path.c_str(), path.c_str()) != 0) {
+    BPLOG(ERROR) << "Could not write " << path << ": " << strerror(errno);
+    unlink(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+void HttpSymbolSupplier::TouchCacheFile(const string& path) {
+  // The access time orders files for eviction.  The modification time is
+  // left alone, since it tells whether a serialized module is stale.
+  struct timespec times[2];
+  times[0].tv_sec = 0;
+  times[0].tv_nsec = UTIME_NOW;
+  times[1].tv_sec = 0;
+  times[1].tv_nsec = UTIME_OMIT;
+  utimensat(AT_FDCWD, path.c_str(), times, 0);
+
+  std::lock_guard<std::mutex> lock(cache_lock_);
+  map<string, CacheEntry>::iterator entry = cache_entries_.find(path);
+  if (entry != cache_entries_.end())
+    entry->second.last_use = time(NULL);
+}
+
+void HttpSymbolSupplier::AddCacheFile(const string& path, uint64_t size) {
+  std::lock_guard<std::mutex> lock(cache_lock_);
+  if (max_cache_size_ == 0)
+    return;
+
+  LoadCacheEntries();
+  CacheEntry& entry = cache_entries_[path];
+  cache_size_ = cache_size_ - entry.size + size;
+  entry = CacheEntry(time(NULL), size);
+  EvictCacheFiles(path);
+}
+
+void HttpSymbolSupplier::LoadCacheEntries() {
+  if (cache_entries_loaded_)
+    return;
+  cache_entries_loaded_ = true;
+  LoadCacheEntriesFromDirectory(cache_path_);
+}
+
+void HttpSymbolSupplier::LoadCacheEntriesFromDirectory(
+    const string& directory) {
+  DIR* dir = opendir(directory.c_str());
+  if (!dir)
+    return;
+
+  dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      continue;
+    string path = directory + "/" + entry->d_name;
+    struct stat path_stat;
+    if (lstat(path.c_str(), &path_stat) != 0)
+      continue;
+    if (S_ISDIR(path_stat.st_mode)) {
+      LoadCacheEntriesFromDirectory(path);
+    } else if (S_ISREG(path_stat.st_mode) &&
+               !strstr(entry->d_name, kTemporaryFileInfix)) {
+      cache_entries_[path] = CacheEntry(path_stat.st_atime, path_stat.st_size);
+      cache_size_ += path_stat.st_size;
+    }
+  }
+  closedir(dir);
+}
+
+void HttpSymbolSupplier::EvictCacheFiles(const string& keep_path) {
+  if (cache_size_ <= max_cache_size_)
+    return;
+
+  vector<std::pair<time_t, string> > eviction_order;
+  for (map<string, CacheEntry>::const_iterator entry = cache_entries_.begin();
+       entry != cache_entries_.end(); ++entry) {
+    if (entry->first != keep_path)
+      eviction_order.push_back(
+          std::make_pair(entry->second.last_use, entry->first));
+  }
+  std::sort(eviction_order.begin(), eviction_order.end());
+
+  for (size_t i = 0;
+       i < eviction_order.size() && cache_size_ > max_cache_size_; ++i) {
+    const string& path = eviction_order[i].second;
+    if (unlink(path.c_str()) != 0 && errno != ENOENT) {
+      BPLOG(ERROR) << "Could not evict " << path << ": " << strerror(errno);
+      continue;
+    }
+    BPLOG(INFO) << "Evicted " << path << " from the symbol cache";
+    map<string, CacheEntry>::iterator entry = cache_entries_.find(path);
+    cache_size_ -= entry->second.size;
+    cache_entries_.erase(entry);
+  }
+}
+
+void HttpSymbolSupplier::ProcessAsyncRequests() {
+  std::unique_lock<std::mutex> lock(async_lock_);
+  for (;;) {
+    ++idle_workers_;
+    async_condition_.wait(lock, [this]() {
+      return shutting_down_ || !async_requests_.empty();
+    });
+    --idle_workers_;
+    if (async_requests_.empty())
+      return;
+
+    AsyncRequest request = async_requests_.front();
+    async_requests_.pop_front();
+    lock.unlock();
+
+    string symbol_file;
+    char* symbol_data = NULL;
+    size_t symbol_data_size = 0;
+    SymbolResult result =
+        GetCStringSymbolData(request.module, request.system_info,
+                             &symbol_file, &symbol_data, &symbol_data_size);
+    request.callback->OnSymbolData(request.module, result, symbol_file,
+                                   symbol_data, symbol_data_size);
+
+    lock.lock();
+  }
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,197 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// http_symbol_supplier.h: A SymbolSupplier that downloads symbol files
+// from HTTP symbol servers into a local cache.
+//
+// HttpSymbolSupplier fetches symbol files from one or more server URLs,
+// which are laid out like a SimpleSymbolSupplier root:
+//
+//   <server_url>/test_app.pdb/63FE4780728D49379B9D7BB6460CB42A1/test_app.sym
+//
+// Servers are tried in order.  A downloaded symbol file is written to the
+// same relative path below the cache directory, which is therefore also
+// usable as a root for SimpleSymbolSupplier, and is served from there on
+// later requests without contacting the servers.
+//
+// Files are written to a temporary name and renamed into place, so that
+// several processes may share a cache directory.  If a maximum cache size
+// is set, the least recently used files are deleted once the cache grows
+// beyond it.
+//
+// When no server has a symbol file (HTTP 404), the module is recorded in
+// the negative cache, and the servers are not asked again until the record
+// expires or is invalidated.  By default this is a DiskNegativeSymbolCache
+// kept in the cache directory.  Any other failure to fetch a symbol file
+// from a server that might have it returns INTERRUPT, so that the minidump
+// can be processed again once the server is reachable.
+//
+// HttpSymbolSupplier may be called from several threads at once.  Each
+// download uses a LibcurlWrapper from a pool, so connections to the servers
+// are reused across requests.  GetCStringSymbolDataAsync downloads up to
+// max_concurrent_downloads symbol files at a time on worker threads.
+
+#ifndef PROCESSOR_HTTP_SYMBOL_SUPPLIER_H__
+#define PROCESSOR_HTTP_SYMBOL_SUPPLIER_H__
+
+#include <stdint.h>
+#include <time.h>
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/using_std_string.h"
+#include "processor/disk_negative_symbol_cache.h"
+#include "processor/simple_symbol_supplier.h"
+
+namespace google_breakpad {
+
+class LibcurlWrapper;
+
+class HttpSymbolSupplier : public SimpleSymbolSupplier {
+ public:
+  // Creates a new HttpSymbolSupplier that downloads symbol files from
+  // server_urls into cache_path.
+  HttpSymbolSupplier(const vector<string>& server_urls,
+                     const string& cache_path);
+
+  // Waits for outstanding GetCStringSymbolDataAsync requests to complete.
+  virtual ~HttpSymbolSupplier();
+
+  using SimpleSymbolSupplier::GetSymbolFile;
+
+  // Returns the path to the symbol file for the given module in the cache,
+  // downloading it first if necessary.
+  virtual SymbolResult GetSymbolFile(const CodeModule* module,
+                                     const SystemInfo* system_info,
+                                     string* symbol_file);
+
+  // Completes the request on a worker thread.
+  virtual void GetCStringSymbolDataAsync(const CodeModule* module,
+                                         const SystemInfo* system_info,
+                                         SymbolDataCallback* callback);
+
+  // The size in bytes beyond which least recently used files are deleted
+  // from the cache.  0, the default, leaves the cache size unbounded.
+  void set_max_cache_size(uint64_t max_cache_size) {
+    max_cache_size_ = max_cache_size;
+  }
+
+  // How long, in seconds, the default negative cache remembers that no
+  // server has a symbol file.  0 disables it.  The default is one hour.
+  void set_not_found_ttl(int not_found_ttl) {
+    default_negative_cache_.set_ttl(not_found_ttl);
+  }
+
+  // The number of worker threads downloading symbol files for
+  // GetCStringSymbolDataAsync, started as requests arrive.  The default is
+  // 4.
+  void set_max_concurrent_downloads(int max_concurrent_downloads) {
+    max_concurrent_downloads_ = max_concurrent_downloads;
+  }
+
+ protected:
+  // Sends a GET request for url, and stores the HTTP status code and the
+  // response body.  Returns false if no response was received.  May be
+  // called from several threads at once.
+  virtual bool Fetch(const string& url,
+                     long* http_status_code,
+                     string* response);
+
+ private:
+  struct CacheEntry {
+    CacheEntry() : last_use(0), size(0) {}
+    CacheEntry(time_t last_use, uint64_t size)
+        : last_use(last_use), size(size) {}
+
+    time_t last_use;
+    uint64_t size;
+  };
+
+  struct AsyncRequest {
+    const CodeModule* module;
+    const SystemInfo* system_info;
+    SymbolDataCallback* callback;
+  };
+
+  // Downloads the symbol file for module, at relative_path, into the cache.
+  SymbolResult Download(const CodeModule* module, const string& relative_path);
+
+  // Writes data to path through a temporary file.
+  bool WriteCacheFile(const string& path, const string& data);
+
+  // Records a use of the cache file at path, and evicts least recently used
+  // files if the cache has outgrown max_cache_size_.
+  void TouchCacheFile(const string& path);
+  void AddCacheFile(const string& path, uint64_t size);
+
+  // Fills cache_entries_ from the files in the cache directory.  Called
+  // with cache_lock_ held.
+  void LoadCacheEntries();
+  void LoadCacheEntriesFromDirectory(const string& directory);
+
+  // Deletes least recently used files until the cache fits, keeping
+  // keep_path.  Called with cache_lock_ held.
+  void EvictCacheFiles(const string& keep_path);
+
+  // Runs on the worker threads.
+  void ProcessAsyncRequests();
+
+  vector<string> server_urls_;
+  string cache_path_;
+  uint64_t max_cache_size_;
+  DiskNegativeSymbolCache default_negative_cache_;
+  int max_concurrent_downloads_;
+
+  // Idle connections, guarded by connections_lock_.
+  vector<LibcurlWrapper*> connections_;
+  std::mutex connections_lock_;
+
+  // The files in the cache, by path, once loaded.  Guarded by cache_lock_.
+  map<string, CacheEntry> cache_entries_;
+  uint64_t cache_size_;
+  bool cache_entries_loaded_;
+  std::mutex cache_lock_;
+
+  // Requests waiting for a worker thread, guarded by async_lock_.
+  std::deque<AsyncRequest> async_requests_;
+  vector<std::thread> workers_;
+  size_t idle_workers_;
+  bool shutting_down_;
+  std::mutex async_lock_;
+  std::condition_variable async_condition_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_HTTP_SYMBOL_SUPPLIER_H__
@@ -0,0 +1,426 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Unit tests for HttpSymbolSupplier.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "breakpad_googletest_includes.h"
+#include "common/tests/auto_tempdir.h"
+#include "common/using_std_string.h"
+#include "processor/basic_code_module.h"
+#include "processor/http_symbol_supplier.h"
+
+namespace {
+
+using google_breakpad::AutoTempDir;
+using google_breakpad::BasicCodeModule;
+using google_breakpad::CodeModule;
+using google_breakpad::DiskNegativeSymbolCache;
+using google_breakpad::HttpSymbolSupplier;
+using google_breakpad::SymbolSupplier;
+using std::map;
+using std::vector;
+
+const char kServer[] = "http://symbols.example.com/store";
+const char kMirror[] = "http://mirror.example.com";
+
+// Serves canned responses instead of sending requests.
+class TestHttpSymbolSupplier : public HttpSymbolSupplier {
+ public:
+  TestHttpSymbolSupplier(const vector<string>& server_urls,
+                         const string& cache_path)
+      : HttpSymbolSupplier(server_urls, cache_path),
+        fetch_delay_ms_(0),
+        outstanding_fetches_(0),
+        max_outstanding_fetches_(0) {}
+
+  // Responds to url with http_status_code and body.  Fetching a url with no
+  // response set fails as though the server was unreachable.
+  void SetResponse(const string& url, long http_status_code,
+                   const string& body) {
+    std::lock_guard<std::mutex> lock(lock_);
+    responses_[url] = std::make_pair(http_status_code, body);
+  }
+
+  void set_fetch_delay_ms(int fetch_delay_ms) {
+    fetch_delay_ms_ = fetch_delay_ms;
+  }
+
+  int fetch_count(const string& url) {
+    std::lock_guard<std::mutex> lock(lock_);
+    return fetch_counts_[url];
+  }
+
+  int max_outstanding_fetches() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return max_outstanding_fetches_;
+  }
+
+ protected:
+  virtual bool Fetch(const string& url,
+                     long* http_status_code,
+                     string* response) {
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      ++fetch_counts_[url];
+      max_outstanding_fetches_ =
+          std::max(max_outstanding_fetches_, ++outstanding_fetches_);
+    }
+    if (fetch_delay_ms_) {
+      std::this_thread::sleep_for(
+          std::chrono::milliseconds(fetch_delay_ms_));
+    }
+
+    std::lock_guard<std::mutex> lock(lock_);
+    --outstanding_fetches_;
+    map<string, std::pair<long, string> >::const_iterator it =
+        responses_.find(url);
+    if (it == responses_.end())
+      return false;
+    *http_status_code = it->second.first;
+    *response = it->second.second;
+    return true;
+  }
+
+ private:
+  map<string, std::pair<long, string> > responses_;
+  map<string, int> fetch_counts_;
+  int fetch_delay_ms_;
+  int outstanding_fetches_;
+  int max_outstanding_fetches_;
+  std::mutex lock_;
+};
+
+// Collects the results of GetCStringSymbolDataAsync.
+class TestSymbolDataCallback : public SymbolSupplier::SymbolDataCallback {
+ public:
+  virtual void OnSymbolData(const CodeModule* module,
+                            SymbolSupplier::SymbolResult result,
+                            const string& symbol_file,
+                            char* symbol_data,
+                            size_t symbol_data_size) {
+    std::lock_guard<std::mutex> lock(lock_);
+    results_[module] = std::make_pair(
+        result, result == SymbolSupplier::FOUND ? string(symbol_data) : "");
+    completed_.notify_all();
+  }
+
+  // Waits for count requests to complete.
+  map<const CodeModule*, std::pair<SymbolSupplier::SymbolResult, string> >
+  WaitForResults(size_t count) {
+    std::unique_lock<std::mutex> lock(lock_);
+    completed_.wait(lock, [this, count]() { return results_.size() >= count; });
+    return results_;
+  }
+
+ private:
+  map<const CodeModule*, std::pair<SymbolSupplier::SymbolResult, string> >
+      results_;
+  std::mutex lock_;
+  std::condition_variable completed_;
+};
+
+BasicCodeModule MakeModule(const string& name) {
+  return BasicCodeModule(0x1000, 0x1000, "/lib/" + name, "", name,
+                         "0123456789ABCDEF0123456789ABCDEF0", "");
+}
+
+string SymbolPath(const string& root, const string& name) {
+  return root + "/" + name + "/0123456789ABCDEF0123456789ABCDEF0/" + name +
+         ".sym";
+}
+
+string ReadFile(const string& path) {
+  std::ifstream in(path.c_str(), std::ios::binary);
+  return string(std::istreambuf_iterator<char>(in),
+                std::istreambuf_iterator<char>());
+}
+
+TEST(HttpSymbolSupplierTest, DownloadsIntoCache) {
+  AutoTempDir cache;
+  BasicCodeModule module = MakeModule("libfoo.so");
+  string url = SymbolPath(kServer, "libfoo.so");
+  string symbols = "MODULE Linux x86_64 0123456789ABCDEF libfoo.so\n";
+
+  vector<string> servers(1, string(kServer) + "/");
+  {
+    TestHttpSymbolSupplier supplier(servers, cache.path());
+    supplier.SetResponse(url, 200, symbols);
+
+    string symbol_file;
+    string symbol_data;
+    ASSERT_EQ(SymbolSupplier::FOUND,
+              supplier.GetSymbolFile(&module, NULL, &symbol_file,
+                                     &symbol_data));
+    EXPECT_EQ(SymbolPath(cache.path(), "libfoo.so"), symbol_file);
+    EXPECT_EQ(symbols, symbol_data);
+    EXPECT_EQ(symbols, ReadFile(symbol_file));
+
+    ASSERT_EQ(SymbolSupplier::FOUND,
+              supplier.GetSymbolFile(&module, NULL, &symbol_file));
+    EXPECT_EQ(1, supplier.fetch_count(url));
+  }
+
+  // A new supplier finds the file in the cache.
+  TestHttpSymbolSupplier supplier(servers, cache.path());
+  char* symbol_data = NULL;
+  size_t symbol_data_size = 0;
+  string symbol_file;
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            supplier.GetCStringSymbolData(&module, NULL, &symbol_file,
+                                          &symbol_data, &symbol_data_size));
+  EXPECT_EQ(symbols, string(symbol_data));
+  EXPECT_EQ(symbols.size() + 1, symbol_data_size);
+  supplier.FreeSymbolData(&module);
+  EXPECT_EQ(0, supplier.fetch_count(url));
+}
+
+TEST(HttpSymbolSupplierTest, TriesServersInOrder) {
+  AutoTempDir cache;
+  BasicCodeModule module = MakeModule("libfoo.so");
+  vector<string> servers;
+  servers.push_back(kServer);
+  servers.push_back(kMirror);
+  TestHttpSymbolSupplier supplier(servers, cache.path());
+  supplier.SetResponse(SymbolPath(kServer, "libfoo.so"), 404, "");
+  supplier.SetResponse(SymbolPath(kMirror, "libfoo.so"), 200, "MODULE\n");
+
+  string symbol_file;
+  string symbol_data;
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file, &symbol_data));
+  EXPECT_EQ("MODULE\n", symbol_data);
+  EXPECT_EQ(1, supplier.fetch_count(SymbolPath(kServer, "libfoo.so")));
+  EXPECT_EQ(1, supplier.fetch_count(SymbolPath(kMirror, "libfoo.so")));
+}
+
+TEST(HttpSymbolSupplierTest, CachesNotFound) {
+  AutoTempDir cache;
+  BasicCodeModule module = MakeModule("libfoo.so");
+  string url = SymbolPath(kServer, "libfoo.so");
+  vector<string> servers(1, kServer);
+  DiskNegativeSymbolCache markers(cache.path());
+
+  TestHttpSymbolSupplier supplier(servers, cache.path());
+  supplier.SetResponse(url, 404, "Not Found");
+  string symbol_file;
+  EXPECT_EQ(SymbolSupplier::NOT_FOUND,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file));
+  EXPECT_EQ(SymbolSupplier::NOT_FOUND,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file));
+  EXPECT_EQ(1, supplier.fetch_count(url));
+  EXPECT_TRUE(markers.IsMissing(module.debug_file(),
+                                module.debug_identifier()));
+
+  // Once the record expires, the server is asked again.
+  supplier.set_not_found_ttl(0);
+  EXPECT_EQ(SymbolSupplier::NOT_FOUND,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file));
+  EXPECT_EQ(2, supplier.fetch_count(url));
+
+  // An upload is not seen until the record is invalidated.
+  supplier.set_not_found_ttl(60 * 60);
+  supplier.SetResponse(url, 200, "MODULE\n");
+  EXPECT_EQ(SymbolSupplier::NOT_FOUND,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file));
+  EXPECT_EQ(2, supplier.fetch_count(url));
+  markers.Invalidate(module.debug_file(), module.debug_identifier());
+  EXPECT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file));
+  EXPECT_EQ(3, supplier.fetch_count(url));
+}
+
+TEST(HttpSymbolSupplierTest, UsesNegativeCache) {
+  AutoTempDir cache;
+  AutoTempDir shared;
+  BasicCodeModule module = MakeModule("libfoo.so");
+  string url = SymbolPath(kServer, "libfoo.so");
+  vector<string> servers(1, kServer);
+  DiskNegativeSymbolCache negative_cache(shared.path());
+
+  TestHttpSymbolSupplier supplier(servers, cache.path());
+  supplier.set_negative_cache(&negative_cache);
+  supplier.SetResponse(url, 404, "");
+  string symbol_file;
+  EXPECT_EQ(SymbolSupplier::NOT_FOUND,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file));
+  EXPECT_TRUE(negative_cache.IsMissing(module.debug_file(),
+                                       module.debug_identifier()));
+
+  // A supplier sharing the negative cache does not ask the server.
+  TestHttpSymbolSupplier other_supplier(servers, cache.path() + "/other");
+  other_supplier.set_negative_cache(&negative_cache);
+  EXPECT_EQ(SymbolSupplier::NOT_FOUND,
+            other_supplier.GetSymbolFile(&module, NULL, &symbol_file));
+  EXPECT_EQ(0, other_supplier.fetch_count(url));
+
+  other_supplier.SetResponse(url, 200, "MODULE\n");
+  negative_cache.Invalidate(module.debug_file(), module.debug_identifier());
+  EXPECT_EQ(SymbolSupplier::FOUND,
+            other_supplier.GetSymbolFile(&module, NULL, &symbol_file));
+  EXPECT_EQ(1, other_supplier.fetch_count(url));
+}
+
+TEST(HttpSymbolSupplierTest, InterruptsOnServerFailure) {
+  AutoTempDir cache;
+  BasicCodeModule module = MakeModule("libfoo.so");
+  vector<string> servers;
+  servers.push_back(kServer);
+  servers.push_back(kMirror);
+  TestHttpSymbolSupplier supplier(servers, cache.path());
+  supplier.SetResponse(SymbolPath(kServer, "libfoo.so"), 503, "");
+
+  // The mirror is unreachable.
+  string symbol_file;
+  EXPECT_EQ(SymbolSupplier::INTERRUPT,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file));
+
+  // Failures are not cached.
+  supplier.SetResponse(SymbolPath(kMirror, "libfoo.so"), 404, "");
+  EXPECT_EQ(SymbolSupplier::INTERRUPT,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file));
+  supplier.SetResponse(SymbolPath(kServer, "libfoo.so"), 404, "");
+  EXPECT_EQ(SymbolSupplier::NOT_FOUND,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file));
+  EXPECT_EQ(3, supplier.fetch_count(SymbolPath(kServer, "libfoo.so")));
+  EXPECT_EQ(3, supplier.fetch_count(SymbolPath(kMirror, "libfoo.so")));
+}
+
+TEST(HttpSymbolSupplierTest, EvictsLeastRecentlyUsed) {
+  AutoTempDir cache;
+  vector<string> servers(1, kServer);
+  string data(100, 'x');
+
+  // Fill the cache with two files, the first used more recently.
+  {
+    TestHttpSymbolSupplier supplier(servers, cache.path());
+    const char* names[] = { "liba.so", "libb.so" };
+    for (int i = 0; i < 2; ++i) {
+      BasicCodeModule module = MakeModule(names[i]);
+      supplier.SetResponse(SymbolPath(kServer, names[i]), 200, data);
+      string symbol_file;
+      ASSERT_EQ(SymbolSupplier::FOUND,
+                supplier.GetSymbolFile(&module, NULL, &symbol_file));
+    }
+  }
+  struct timespec times[2];
+  times[0].tv_sec = 2000;
+  times[0].tv_nsec = 0;
+  times[1].tv_sec = 0;
+  times[1].tv_nsec = UTIME_OMIT;
+  ASSERT_EQ(0, utimensat(AT_FDCWD, SymbolPath(cache.path(), "liba.so").c_str(),
+                         times, 0));
+  times[0].tv_sec = 1000;
+  ASSERT_EQ(0, utimensat(AT_FDCWD, SymbolPath(cache.path(), "libb.so").c_str(),
+                         times, 0));
+
+  TestHttpSymbolSupplier supplier(servers, cache.path());
+  supplier.set_max_cache_size(250);
+  BasicCodeModule module = MakeModule("libc.so");
+  supplier.SetResponse(SymbolPath(kServer, "libc.so"), 200, data);
+  string symbol_file;
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file));
+
+  struct stat file_stat;
+  EXPECT_EQ(0, stat(SymbolPath(cache.path(), "liba.so").c_str(), &file_stat));
+  EXPECT_NE(0, stat(SymbolPath(cache.path(), "libb.so").c_str(), &file_stat));
+  EXPECT_EQ(0, stat(SymbolPath(cache.path(), "libc.so").c_str(), &file_stat));
+}
+
+TEST(HttpSymbolSupplierTest, DownloadsConcurrently) {
+  AutoTempDir cache;
+  vector<string> servers(1, kServer);
+  const int kModuleCount = 8;
+  vector<std::unique_ptr<BasicCodeModule> > modules;
+  for (int i = 0; i < kModuleCount; ++i) {
+    string name = "lib" + std::to_string(i) + ".so";
+    modules.push_back(std::unique_ptr<BasicCodeModule>(new BasicCodeModule(
+        0x1000, 0x1000, "/lib/" + name, "", name,
+        "0123456789ABCDEF0123456789ABCDEF0", "")));
+  }
+
+  TestSymbolDataCallback callback;
+  {
+    TestHttpSymbolSupplier supplier(servers, cache.path());
+    supplier.set_max_concurrent_downloads(3);
+    supplier.set_fetch_delay_ms(20);
+    for (int i = 0; i < kModuleCount; ++i) {
+      // Leave one module missing.
+      if (i != 5) {
+        supplier.SetResponse(
+            SymbolPath(kServer, modules[i]->debug_file()), 200,
+            "MODULE " + modules[i]->debug_file() + "\n");
+      } else {
+        supplier.SetResponse(
+            SymbolPath(kServer, modules[i]->debug_file()), 404, "");
+      }
+    }
+
+    for (int i = 0; i < kModuleCount; ++i) {
+      supplier.GetCStringSymbolDataAsync(modules[i].get(), NULL, &callback);
+    }
+    map<const CodeModule*, std::pair<SymbolSupplier::SymbolResult, string> >
+        results = callback.WaitForResults(kModuleCount);
+    ASSERT_EQ(static_cast<size_t>(kModuleCount), results.size());
+    for (int i = 0; i < kModuleCount; ++i) {
+      if (i != 5) {
+        EXPECT_EQ(SymbolSupplier::FOUND, results[modules[i].get()].first);
+        EXPECT_EQ("MODULE " + modules[i]->debug_file() + "\n",
+                  results[modules[i].get()].second);
+        supplier.FreeSymbolData(modules[i].get());
+      } else {
+        EXPECT_EQ(SymbolSupplier::NOT_FOUND, results[modules[i].get()].first);
+      }
+    }
+    EXPECT_GT(supplier.max_outstanding_fetches(), 1);
+    EXPECT_LE(supplier.max_outstanding_fetches(), 3);
+  }
+}
+
+}  // namespace
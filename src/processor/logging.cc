@@ -41,6 +41,7 @@
 #include <string.h>
 #include <time.h>
 
+#include <atomic>
 #include <string>
 
 #include "common/stdio_wrapper.h"
@@ -50,11 +51,51 @@
 
 namespace google_breakpad {
 
+namespace {
+
+std::atomic<LogSink*> log_sink(NULL);
+
+}  // namespace
+
 LogStream::LogStream(std::ostream& stream, Severity severity,
                      const char* file, int line)
-    : stream_(stream) {
-  time_t clock;
-  time(&clock);
+    : stream_(stream),
+      sink_(GetLogSink()),
+      severity_(severity),
+      file_(file),
+      line_(line),
+      time_(time(NULL)) {
+  if (sink_) {
+    buffer_.reset(new std::ostringstream);
+    return;
+  }
+  stream_ << LogTimeString(time_) << ": " << PathnameStripper::File(file)
+          << ":" << line << ": " << LogSeverityName(severity) << ": ";
+}
+
+LogStream::~LogStream() {
+  if (sink_) {
+    LogSink::Message message = {severity_, time_, file_, line_,
+                                buffer_->str()};
+    sink_->Write(&message);
+    return;
+  }
+  stream_ << std::endl;
+}
+
+const char* LogSeverityName(LogStream::Severity severity) {
+  switch (severity) {
+    case LogStream::SEVERITY_INFO:
+      return "INFO";
+    case LogStream::SEVERITY_ERROR:
+      return "ERROR";
+    case LogStream::SEVERITY_CRITICAL:
+      return "CRITICAL";
+  }
+  return "UNKNOWN_SEVERITY";
+}
+
+string LogTimeString(time_t clock) {
   struct tm tm_struct;
 #ifdef _WIN32
   localtime_s(&tm_struct, &clock);
@@ -63,26 +104,20 @@ LogStream::LogStream(std::ostream& stream, Severity severity,
 #endif
   char time_string[20];
   strftime(time_string, sizeof(time_string), "%Y-%m-%d %H:%M:%S", &tm_struct);
+  return time_string;
+}
 
-  const char* severity_string = "UNKNOWN_SEVERITY";
-  switch (severity) {
-    case SEVERITY_INFO:
-      severity_string = "INFO";
-      break;
-    case SEVERITY_ERROR:
-      severity_string = "ERROR";
-      break;
-    case SEVERITY_CRITICAL:
-      severity_string = "CRITICAL";
-      break;
-  }
+LogSink* SetLogSink(LogSink* sink) {
+  return log_sink.exchange(sink, std::memory_order_acq_rel);
+}
 
-  stream_ << time_string << ": " << PathnameStripper::File(file) << ":" <<
-             line << ": " << severity_string << ": ";
+LogSink* GetLogSink() {
+  return log_sink.load(std::memory_order_acquire);
 }
 
-LogStream::~LogStream() {
-  stream_ << std::endl;
+bool LogSiteEnabled(LogStream::Severity severity, const char* file, int line) {
+  LogSink* sink = GetLogSink();
+  return !sink || sink->ShouldLog(severity, file, line);
 }
 
 string HexString(uint32_t number) {
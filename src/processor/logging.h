@@ -51,12 +51,22 @@
 // BPLOG_INIT(&argc, &argv); before any logging can be performed; define
 // BPLOG_INIT appropriately if initialization is required.
 //
+// At run time, messages may instead be sent to a LogSink with SetLogSink.
+// A sink sees each message whole, with its severity and source location,
+// and may decline messages before they are formatted, so that it can write
+// them out on another thread, limit how often a noisy statement is
+// logged, or write them in another format.  AsyncLogSink, in
+// processor/async_log_sink.h, does all three.
+//
 // Author: Mark Mentovai
 
 #ifndef PROCESSOR_LOGGING_H__
 #define PROCESSOR_LOGGING_H__
 
+#include <time.h>
+
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <string>
 #include <iomanip>
@@ -79,6 +89,8 @@ namespace google_breakpad {
 #undef ERROR
 #endif
 
+class LogSink;
+
 class LogStream {
  public:
   enum Severity {
@@ -89,25 +101,87 @@ class LogStream {
 
   // Begin logging a message to the stream identified by |stream|, at the
   // indicated severity.  The file and line parameters should be set so as to
-  // identify the line of source code that is producing a message.
+  // identify the line of source code that is producing a message.  If a
+  // LogSink is set, the message goes to it instead of to |stream|.
   LogStream(std::ostream& stream, Severity severity,
             const char* file, int line);
 
-  // Finish logging by printing a newline and flushing the output stream.
+  // Finish logging by printing a newline and flushing the output stream,
+  // or by passing the message to the LogSink.
   ~LogStream();
 
   template<typename T> std::ostream& operator<<(const T& t) {
-    return stream_ << t;
+    return (buffer_ ? *buffer_ : stream_) << t;
   }
 
  private:
   std::ostream& stream_;
 
+  // The sink the message goes to, if any, and what it is given along with
+  // the text collected in buffer_.
+  LogSink* sink_;
+  Severity severity_;
+  const char* file_;
+  int line_;
+  time_t time_;
+  std::unique_ptr<std::ostringstream> buffer_;
+
   // Disallow copy constructor and assignment operator
   explicit LogStream(const LogStream& that);
   void operator=(const LogStream& that);
 };
 
+// A destination for log messages, in place of the streams.  A sink may be
+// called from any thread, concurrently.
+class LogSink {
+ public:
+  struct Message {
+    LogStream::Severity severity;
+    time_t time;
+    // The source location that produced the message.  file is __FILE__,
+    // which lives as long as the program does.
+    const char* file;
+    int line;
+    string text;
+  };
+
+  virtual ~LogSink() {}
+
+  // Returns whether a message at severity from the statement at file and
+  // line should be formatted and passed to Write.  This is called for every
+  // message before its text is formatted, and must be cheap.
+  virtual bool ShouldLog(LogStream::Severity severity,
+                         const char* file, int line) {
+    return true;
+  }
+
+  // Takes a message that ShouldLog accepted.
+  virtual void Write(Message* message) = 0;
+
+  // Returns once the messages written so far are out.
+  virtual void Flush() {}
+};
+
+// Returns severity's name, such as "ERROR".
+const char* LogSeverityName(LogStream::Severity severity);
+
+// Returns clock as the local time that log messages begin with, such as
+// "2026-01-31 23:59:59".
+string LogTimeString(time_t clock);
+
+// Sends log messages to sink, which may be NULL to send them to the
+// streams again, and returns the sink that was set before.  The sink must
+// outlive its use: a message being logged on another thread while the sink
+// is replaced may still go to the old one.
+LogSink* SetLogSink(LogSink* sink);
+
+// Returns the sink set by SetLogSink, or NULL.
+LogSink* GetLogSink();
+
+// Returns whether a message at severity from file and line should be
+// logged, which, unless a LogSink says otherwise, it should.
+bool LogSiteEnabled(LogStream::Severity severity, const char* file, int line);
+
 // This class is used to explicitly ignore values in the conditional logging
 // macros.  This avoids compiler warnings like "value computed is not used"
 // and "statement has no effect".
@@ -153,8 +227,15 @@ int ErrnoString(string* error_string);
     ((google_breakpad::LogStream::SEVERITY_ ## severity) >= \
      (google_breakpad::LogStream::BPLOG_MINIMUM_SEVERITY))
 
+// Whether a LogSink, if one is set, accepts messages from this statement.
+#define BPLOG_SITE_ENABLED(severity) \
+    google_breakpad::LogSiteEnabled( \
+        google_breakpad::LogStream::SEVERITY_ ## severity, __FILE__, __LINE__)
+
 #ifndef BPLOG
-#define BPLOG(severity) BPLOG_LAZY_STREAM(severity, BPLOG_LOG_IS_ON(severity))
+#define BPLOG(severity) \
+    BPLOG_LAZY_STREAM(severity, \
+                      BPLOG_LOG_IS_ON(severity) && BPLOG_SITE_ENABLED(severity))
 #endif  // BPLOG
 
 #ifndef BPLOG_INFO
@@ -186,7 +267,8 @@ int ErrnoString(string* error_string);
 
 #ifndef BPLOG_IF
 #define BPLOG_IF(severity, condition) \
-    BPLOG_LAZY_STREAM(severity, ((condition) && BPLOG_LOG_IS_ON(severity)))
+    BPLOG_LAZY_STREAM(severity, ((condition) && BPLOG_LOG_IS_ON(severity) && \
+                                 BPLOG_SITE_ENABLED(severity)))
 #endif  // BPLOG_IF
 
 #endif  // PROCESSOR_LOGGING_H__
@@ -50,24 +50,37 @@
 
 namespace google_breakpad {
 
-template<typename Key, typename Value>
-size_t StdMapSerializer<Key, Value>::SizeOf(
+template<typename Key, typename Value, typename ValueSerializer>
+size_t StdMapSerializer<Key, Value, ValueSerializer>::SizeOf(
     const std::map<Key, Value>& m) const {
+  return SizeOf(m.begin(), m.end(), m.size());
+}
+
+template<typename Key, typename Value, typename ValueSerializer>
+template<typename Iterator>
+size_t StdMapSerializer<Key, Value, ValueSerializer>::SizeOf(
+    Iterator begin, Iterator end, size_t count) const {
   size_t size = 0;
-  size_t header_size = (1 + m.size()) * sizeof(uint64_t);
+  size_t header_size = (1 + count) * sizeof(uint64_t);
   size += header_size;
 
-  typename std::map<Key, Value>::const_iterator iter;
-  for (iter = m.begin(); iter != m.end(); ++iter) {
+  for (Iterator iter = begin; iter != end; ++iter) {
     size += key_serializer_.SizeOf(iter->first);
     size += value_serializer_.SizeOf(iter->second);
   }
   return size;
 }
 
-template<typename Key, typename Value>
-char* StdMapSerializer<Key, Value>::Write(const std::map<Key, Value>& m,
-                                          char* dest) const {
+template<typename Key, typename Value, typename ValueSerializer>
+char* StdMapSerializer<Key, Value, ValueSerializer>::Write(
+    const std::map<Key, Value>& m, char* dest) const {
+  return Write(m.begin(), m.end(), m.size(), dest);
+}
+
+template<typename Key, typename Value, typename ValueSerializer>
+template<typename Iterator>
+char* StdMapSerializer<Key, Value, ValueSerializer>::Write(
+    Iterator begin, Iterator end, size_t count, char* dest) const {
   if (!dest) {
     BPLOG(ERROR) << "StdMapSerializer failed: write to NULL address.";
     return NULL;
@@ -76,18 +89,17 @@ char* StdMapSerializer<Key, Value>::Write(const std::map<Key, Value>& m,
 
   // Write header:
   // Number of nodes.
-  dest = SimpleSerializer<uint64_t>::Write(m.size(), dest);
+  dest = SimpleSerializer<uint64_t>::Write(count, dest);
   // Nodes offsets.
   uint64_t* offsets = reinterpret_cast<uint64_t*>(dest);
-  dest += sizeof(uint64_t) * m.size();
+  dest += sizeof(uint64_t) * count;
 
   char* key_address = dest;
-  dest += sizeof(Key) * m.size();
+  dest += sizeof(Key) * count;
 
   // Traverse map.
-  typename std::map<Key, Value>::const_iterator iter;
   int64_t index = 0;
-  for (iter = m.begin(); iter != m.end(); ++iter, ++index) {
+  for (Iterator iter = begin; iter != end; ++iter, ++index) {
     offsets[index] = static_cast<uint64_t>(dest - start_address);
     key_address = key_serializer_.Write(iter->first, key_address);
     dest = value_serializer_.Write(iter->second, dest);
@@ -95,8 +107,8 @@ char* StdMapSerializer<Key, Value>::Write(const std::map<Key, Value>& m,
   return dest;
 }
 
-template<typename Key, typename Value>
-char* StdMapSerializer<Key, Value>::Serialize(
+template<typename Key, typename Value, typename ValueSerializer>
+char* StdMapSerializer<Key, Value, ValueSerializer>::Serialize(
     const std::map<Key, Value>& m, uint64_t* size) const {
   // Compute size of memory to be allocated.
   uint64_t size_to_alloc = SizeOf(m);
@@ -114,15 +126,25 @@ char* StdMapSerializer<Key, Value>::Serialize(
   return serialized_data;
 }
 
-template<typename Address, typename Entry>
-size_t RangeMapSerializer<Address, Entry>::SizeOf(
+template<typename Address, typename Entry, typename EntrySerializer>
+size_t RangeMapSerializer<Address, Entry, EntrySerializer>::SizeOf(
     const RangeMap<Address, Entry>& m) const {
+  if (m.frozen_) {
+    return SizeOfRanges(m.frozen_map_.begin(), m.frozen_map_.end(),
+                        m.frozen_map_.size());
+  }
+  return SizeOfRanges(m.map_.begin(), m.map_.end(), m.map_.size());
+}
+
+template<typename Address, typename Entry, typename EntrySerializer>
+template<typename Iterator>
+size_t RangeMapSerializer<Address, Entry, EntrySerializer>::SizeOfRanges(
+    Iterator begin, Iterator end, size_t count) const {
   size_t size = 0;
-  size_t header_size = (1 + m.map_.size()) * sizeof(uint64_t);
+  size_t header_size = (1 + count) * sizeof(uint64_t);
   size += header_size;
 
-  typename std::map<Address, Range>::const_iterator iter;
-  for (iter = m.map_.begin(); iter != m.map_.end(); ++iter) {
+  for (Iterator iter = begin; iter != end; ++iter) {
     // Size of key (high address).
     size += address_serializer_.SizeOf(iter->first);
     // Size of base (low address).
@@ -133,9 +155,20 @@ size_t RangeMapSerializer<Address, Entry>::SizeOf(
   return size;
 }
 
-template<typename Address, typename Entry>
-char* RangeMapSerializer<Address, Entry>::Write(
+template<typename Address, typename Entry, typename EntrySerializer>
+char* RangeMapSerializer<Address, Entry, EntrySerializer>::Write(
     const RangeMap<Address, Entry>& m, char* dest) const {
+  if (m.frozen_) {
+    return WriteRanges(m.frozen_map_.begin(), m.frozen_map_.end(),
+                       m.frozen_map_.size(), dest);
+  }
+  return WriteRanges(m.map_.begin(), m.map_.end(), m.map_.size(), dest);
+}
+
+template<typename Address, typename Entry, typename EntrySerializer>
+template<typename Iterator>
+char* RangeMapSerializer<Address, Entry, EntrySerializer>::WriteRanges(
+    Iterator begin, Iterator end, size_t count, char* dest) const {
   if (!dest) {
     BPLOG(ERROR) << "RangeMapSerializer failed: write to NULL address.";
     return NULL;
@@ -144,18 +177,17 @@ char* RangeMapSerializer<Address, Entry>::Write(
 
   // Write header:
   // Number of nodes.
-  dest = SimpleSerializer<uint64_t>::Write(m.map_.size(), dest);
+  dest = SimpleSerializer<uint64_t>::Write(count, dest);
   // Nodes offsets.
   uint64_t* offsets = reinterpret_cast<uint64_t*>(dest);
-  dest += sizeof(uint64_t) * m.map_.size();
+  dest += sizeof(uint64_t) * count;
 
   char* key_address = dest;
-  dest += sizeof(Address) * m.map_.size();
+  dest += sizeof(Address) * count;
 
   // Traverse map.
-  typename std::map<Address, Range>::const_iterator iter;
   int64_t index = 0;
-  for (iter = m.map_.begin(); iter != m.map_.end(); ++iter, ++index) {
+  for (Iterator iter = begin; iter != end; ++iter, ++index) {
     offsets[index] = static_cast<uint64_t>(dest - start_address);
     key_address = address_serializer_.Write(iter->first, key_address);
     dest = address_serializer_.Write(iter->second.base(), dest);
@@ -164,8 +196,8 @@ char* RangeMapSerializer<Address, Entry>::Write(
   return dest;
 }
 
-template<typename Address, typename Entry>
-char* RangeMapSerializer<Address, Entry>::Serialize(
+template<typename Address, typename Entry, typename EntrySerializer>
+char* RangeMapSerializer<Address, Entry, EntrySerializer>::Serialize(
     const RangeMap<Address, Entry>& m, uint64_t* size) const {
   // Compute size of memory to be allocated.
   uint64_t size_to_alloc = SizeOf(m);
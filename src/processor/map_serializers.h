@@ -47,8 +47,11 @@
 namespace google_breakpad {
 
 // StdMapSerializer allocates memory and serializes an std::map instance into a
-// chunk of memory data.
-template<typename Key, typename Value>
+// chunk of memory data.  ValueSerializer, which has the static SizeOf and
+// Write methods of SimpleSerializer, may write values in another form than
+// SimpleSerializer<Value> does.
+template<typename Key, typename Value,
+         typename ValueSerializer = SimpleSerializer<Value> >
 class StdMapSerializer {
  public:
   // Calculate the memory size of serialized data.
@@ -67,9 +70,17 @@ class StdMapSerializer {
   // Caller has the ownership of memory allocated as "new char[]".
   char* Serialize(const std::map<Key, Value>& m, uint64_t* size) const;
 
+  // Like SizeOf and Write above, but for the count key-value pairs in
+  // [begin, end), which must be sorted by key.  These serialize the frozen
+  // arrays of an AddressMap in the same format as a std::map.
+  template<typename Iterator>
+  size_t SizeOf(Iterator begin, Iterator end, size_t count) const;
+  template<typename Iterator>
+  char* Write(Iterator begin, Iterator end, size_t count, char* dest) const;
+
  private:
   SimpleSerializer<Key> key_serializer_;
-  SimpleSerializer<Value> value_serializer_;
+  ValueSerializer value_serializer_;
 };
 
 // AddressMapSerializer allocates memory and serializes an AddressMap into a
@@ -79,6 +90,11 @@ class AddressMapSerializer {
  public:
   // Calculate the memory size of serialized data.
   size_t SizeOf(const AddressMap<Addr, Entry>& m) const {
+    if (m.frozen_) {
+      return std_map_serializer_.SizeOf(m.frozen_map_.begin(),
+                                        m.frozen_map_.end(),
+                                        m.frozen_map_.size());
+    }
     return std_map_serializer_.SizeOf(m.map_);
   }
 
@@ -86,6 +102,11 @@ class AddressMapSerializer {
   // of data, i.e., return the address after the final byte of data.
   // NOTE: caller has to allocate enough memory before invoke Write() method.
   char* Write(const AddressMap<Addr, Entry>& m, char* dest) const {
+    if (m.frozen_) {
+      return std_map_serializer_.Write(m.frozen_map_.begin(),
+                                       m.frozen_map_.end(),
+                                       m.frozen_map_.size(), dest);
+    }
     return std_map_serializer_.Write(m.map_, dest);
   }
 
@@ -94,7 +115,14 @@ class AddressMapSerializer {
   // to the size of serialized data, i.e., SizeOf(m).
   // Caller has the ownership of memory allocated as "new char[]".
   char* Serialize(const AddressMap<Addr, Entry>& m, uint64_t* size) const {
-    return std_map_serializer_.Serialize(m.map_, size);
+    if (!m.frozen_)
+      return std_map_serializer_.Serialize(m.map_, size);
+
+    uint64_t size_to_alloc = SizeOf(m);
+    char* serialized_data = new char[size_to_alloc];
+    Write(m, serialized_data);
+    if (size) *size = size_to_alloc;
+    return serialized_data;
   }
 
  private:
@@ -104,8 +132,10 @@ class AddressMapSerializer {
 };
 
 // RangeMapSerializer allocates memory and serializes a RangeMap instance into a
-// chunk of memory data.
-template<typename Address, typename Entry>
+// chunk of memory data.  As with StdMapSerializer, EntrySerializer may write
+// entries in another form than SimpleSerializer<Entry> does.
+template<typename Address, typename Entry,
+         typename EntrySerializer = SimpleSerializer<Entry> >
 class RangeMapSerializer {
  public:
   // Calculate the memory size of serialized data.
@@ -126,10 +156,18 @@ class RangeMapSerializer {
   // Convenient type name for Range.
   typedef typename RangeMap<Address, Entry>::Range Range;
 
+  // SizeOf and Write for the count ranges in [begin, end), which hold either
+  // the tree or the frozen array of a RangeMap.
+  template<typename Iterator>
+  size_t SizeOfRanges(Iterator begin, Iterator end, size_t count) const;
+  template<typename Iterator>
+  char* WriteRanges(Iterator begin, Iterator end, size_t count,
+                    char* dest) const;
+
   // Serializer for RangeMap's key and Range::base_.
   SimpleSerializer<Address> address_serializer_;
   // Serializer for RangeMap::Range::entry_.
-  SimpleSerializer<Entry> entry_serializer_;
+  EntrySerializer entry_serializer_;
 };
 
 // ContainedRangeMapSerializer allocates memory and serializes a
@@ -199,6 +199,29 @@ TEST_F(TestAddressMapSerializer, MapWithFourElementsTestCase) {
   EXPECT_EQ(memcmp(correct_data, serialized_data_, correct_size), 0);
 }
 
+TEST_F(TestAddressMapSerializer, FrozenMapTestCase) {
+  const int64_t correct_data[] = {
+      // # of nodes
+      2,
+      // Offsets
+      40, 48,
+      // Keys
+      1, 3,
+      // Values
+      2, 6
+  };
+  uint64_t correct_size = sizeof(correct_data);
+
+  address_map_.Store(3, 6);
+  address_map_.Store(1, 2);
+  address_map_.Freeze();
+
+  serialized_data_ = serializer_.Serialize(address_map_, &serialized_size_);
+
+  EXPECT_EQ(correct_size, serialized_size_);
+  EXPECT_EQ(memcmp(correct_data, serialized_data_, correct_size), 0);
+}
+
 
 class TestRangeMapSerializer : public ::testing::Test {
  protected:
@@ -272,6 +295,30 @@ TEST_F(TestRangeMapSerializer, MapWithThreeRangesTestCase) {
   EXPECT_EQ(memcmp(correct_data, serialized_data_, correct_size), 0);
 }
 
+TEST_F(TestRangeMapSerializer, FrozenMapTestCase) {
+  const int64_t correct_data[] = {
+      // # of nodes
+      3,
+      // Offsets
+      56, 72, 88,
+      // Keys: high address
+      5, 9, 20,
+      // Values: (low address, entry) pairs
+      2, 1, 6, 2, 10, 3
+  };
+  uint64_t correct_size = sizeof(correct_data);
+
+  ASSERT_TRUE(range_map_.StoreRange(10, 11, 3));
+  ASSERT_TRUE(range_map_.StoreRange(2, 4, 1));
+  ASSERT_TRUE(range_map_.StoreRange(6, 4, 2));
+  range_map_.Freeze();
+
+  serialized_data_ = serializer_.Serialize(range_map_, &serialized_size_);
+
+  EXPECT_EQ(correct_size, serialized_size_);
+  EXPECT_EQ(memcmp(correct_data, serialized_data_, correct_size), 0);
+}
+
 
 class TestContainedRangeMapSerializer : public ::testing::Test {
  protected:
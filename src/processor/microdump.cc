@@ -39,9 +39,12 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
+#include <iostream>
 #include <memory>
-#include <sstream>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #include "google_breakpad/common/minidump_cpu_arm.h"
@@ -69,34 +72,108 @@ static const char kX86Architecture[] = "x86";
 static const char kMipsArchitecture[] = "mips";
 static const char kMips64Architecture[] = "mips64";
 static const char kGpuUnknown[] = "UNKNOWN";
+// Upper bound on the stack buffer reserved from the S 0 header's length.
+static const uint64_t kMaxStackReserve = 16 * 1024 * 1024;
+
+// Value of each hex digit, or -1 for characters that are not hex digits.
+class HexDigitTable {
+ public:
+  HexDigitTable() {
+    memset(values_, -1, sizeof(values_));
+    for (int i = 0; i < 10; ++i)
+      values_['0' + i] = i;
+    for (int i = 0; i < 6; ++i) {
+      values_['a' + i] = 10 + i;
+      values_['A' + i] = 10 + i;
+    }
+  }
+  int operator[](char c) const { return values_[static_cast<uint8_t>(c)]; }
+
+ private:
+  int8_t values_[256];
+};
+
+const HexDigitTable& HexDigits() {
+  static const HexDigitTable table;
+  return table;
+}
+
+bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' ||
+         c == '\r';
+}
 
+// Parses the leading hex number in |str|, with the same leniency as reading
+// it through std::hex: leading whitespace and a "0x" prefix are skipped and
+// parsing stops at the first non-hex character.
 template<typename T>
-T HexStrToL(const string& str) {
+T HexStrToL(std::string_view str) {
+  const HexDigitTable& digits = HexDigits();
+  size_t i = 0;
+  while (i < str.size() && IsSpace(str[i]))
+    ++i;
+  if (i + 2 < str.size() && str[i] == '0' &&
+      (str[i + 1] == 'x' || str[i + 1] == 'X') && digits[str[i + 2]] >= 0) {
+    i += 2;
+  }
   uint64_t res = 0;
-  std::istringstream ss(str);
-  ss >> std::hex >> res;
+  for (; i < str.size() && digits[str[i]] >= 0; ++i)
+    res = (res << 4) | digits[str[i]];
   return static_cast<T>(res);
 }
 
-std::vector<uint8_t> ParseHexBuf(const string& str) {
-  std::vector<uint8_t> buf;
-  for (size_t i = 0; i < str.length(); i += 2) {
-    buf.push_back(HexStrToL<uint8_t>(str.substr(i, 2)));
+// Decodes the hex pairs of |str| and appends the bytes to |buf| in place.
+void AppendHexBuf(std::string_view str, std::vector<uint8_t>* buf) {
+  const HexDigitTable& digits = HexDigits();
+  size_t offset = buf->size();
+  buf->resize(offset + (str.size() + 1) / 2);
+  uint8_t* out = &(*buf)[offset];
+  const char* in = str.data();
+  const char* end = in + str.size();
+  for (; end - in >= 2; in += 2) {
+    int high = digits[in[0]];
+    int low = digits[in[1]];
+    if ((high | low) >= 0) {
+      *out++ = static_cast<uint8_t>((high << 4) | low);
+    } else {
+      // Malformed pair: keep the leading valid digit, as std::hex would.
+      *out++ = static_cast<uint8_t>(high < 0 ? 0 : high);
+    }
   }
-  return buf;
+  if (in != end)
+    *out = static_cast<uint8_t>(std::max(digits[*in], 0));
 }
 
-bool GetLine(std::istringstream* istream, string* str) {
-  if (std::getline(*istream, *str)) {
-    // Trim any trailing newline from the end of the line. Allows us
-    // to seamlessly handle both Windows/DOS and Unix formatted input. The
-    // adb tool generally writes logcat dumps in Windows/DOS format.
-    if (!str->empty() && str->at(str->size() - 1) == '\r') {
-      str->erase(str->size() - 1);
-    }
-    return true;
-  }
-  return false;
+// Returns the next line of |contents| at |*pos| and advances |*pos| past its
+// terminator. Trims any trailing carriage return from the end of the line,
+// which allows us to seamlessly handle both Windows/DOS and Unix formatted
+// input. The adb tool generally writes logcat dumps in Windows/DOS format.
+bool GetLine(std::string_view contents, size_t* pos, std::string_view* line) {
+  if (*pos >= contents.size())
+    return false;
+  size_t end = contents.find('\n', *pos);
+  size_t next = end == std::string_view::npos ? contents.size() : end + 1;
+  if (end == std::string_view::npos)
+    end = contents.size();
+  *line = contents.substr(*pos, end - *pos);
+  if (!line->empty() && line->back() == '\r')
+    line->remove_suffix(1);
+  *pos = next;
+  return true;
+}
+
+// Returns the next whitespace-delimited token of |*str| and removes it, and
+// the whitespace before it, from |*str|.
+std::string_view NextToken(std::string_view* str) {
+  size_t start = 0;
+  while (start < str->size() && IsSpace((*str)[start]))
+    ++start;
+  size_t end = start;
+  while (end < str->size() && !IsSpace((*str)[end]))
+    ++end;
+  std::string_view token = str->substr(start, end - start);
+  str->remove_prefix(end);
+  return token;
 }
 
 }  // namespace
@@ -108,6 +185,7 @@ namespace google_breakpad {
 //
 
 void MicrodumpModules::Add(const CodeModule* module) {
+  InvalidateIndex();
   linked_ptr<const CodeModule> module_ptr(module);
   if (!map_.StoreRange(module->base_address(), module->size(), module_ptr)) {
     BPLOG(ERROR) << "Module " << module->code_file() <<
@@ -167,6 +245,12 @@ void MicrodumpMemoryRegion::Init(uint64_t base_address,
   contents_ = contents;
 }
 
+void MicrodumpMemoryRegion::Init(uint64_t base_address,
+                                 std::vector<uint8_t>&& contents) {
+  base_address_ = base_address;
+  contents_ = std::move(contents);
+}
+
 uint64_t MicrodumpMemoryRegion::GetBase() const { return base_address_; }
 
 uint32_t MicrodumpMemoryRegion::GetSize() const { return contents_.size(); }
@@ -206,6 +290,15 @@ bool MicrodumpMemoryRegion::GetMemoryLittleEndian(uint64_t address,
   return true;
 }
 
+bool MicrodumpMemoryRegion::ByteSwapped() const {
+  return !HostIsLittleEndian();
+}
+
+const uint8_t* MicrodumpMemoryRegion::GetSpanAtOffset(uint64_t offset,
+                                                      size_t size) const {
+  return &contents_[offset];
+}
+
 void MicrodumpMemoryRegion::Print() const {
   // Not reached, just needed to honor the base class contract.
   assert(false);
@@ -215,6 +308,10 @@ void MicrodumpMemoryRegion::Print() const {
 // Microdump
 //
 Microdump::Microdump(const string& contents)
+  : Microdump(std::string_view(contents), NULL) {
+}
+
+Microdump::Microdump(std::string_view contents, size_t* consumed)
   : context_(new MicrodumpContext()),
     stack_region_(new MicrodumpMemoryRegion()),
     modules_(new MicrodumpModules()),
@@ -224,48 +321,43 @@ Microdump::Microdump(const string& contents)
   assert(!contents.empty());
 
   bool in_microdump = false;
-  string line;
+  std::string_view line;
+  size_t line_start = 0;
   uint64_t stack_start = 0;
   std::vector<uint8_t> stack_content;
   string arch;
 
-  std::istringstream stream(contents);
-  while (GetLine(&stream, &line)) {
-    if (line.find(kGoogleBreakpadKey) == string::npos) {
+  while (GetLine(contents, &line_start, &line)) {
+    if (line.find(kGoogleBreakpadKey) == std::string_view::npos) {
       continue;
     }
-    if (line.find(kMicrodumpBegin) != string::npos) {
+    if (line.find(kMicrodumpBegin) != std::string_view::npos) {
       in_microdump = true;
       continue;
     }
     if (!in_microdump) {
       continue;
     }
-    if (line.find(kMicrodumpEnd) != string::npos) {
+    if (line.find(kMicrodumpEnd) != std::string_view::npos) {
       break;
     }
 
     size_t pos;
-    if ((pos = line.find(kOsKey)) != string::npos) {
-      string os_str(line, pos + strlen(kOsKey));
-      std::istringstream os_tokens(os_str);
-      string os_id;
-      string num_cpus;
-      string os_version;
+    if ((pos = line.find(kOsKey)) != std::string_view::npos) {
+      std::string_view os_tokens = line.substr(pos + strlen(kOsKey));
+      std::string_view os_id = NextToken(&os_tokens);
+      arch = string(NextToken(&os_tokens));
+      std::string_view num_cpus = NextToken(&os_tokens);
       // This reflect the actual HW arch and might not match the arch emulated
       // for the execution (e.g., running a 32-bit binary on a 64-bit cpu).
-      string hw_arch;
-
-      os_tokens >> os_id;
-      os_tokens >> arch;
-      os_tokens >> num_cpus;
-      os_tokens >> hw_arch;
-      GetLine(&os_tokens, &os_version);
-      os_version.erase(0, 1);  // remove leading space.
+      NextToken(&os_tokens);  // hw_arch
+      std::string_view os_version = os_tokens;
+      if (!os_version.empty())
+        os_version.remove_prefix(1);  // remove leading space.
 
       system_info_->cpu = arch;
       system_info_->cpu_count = HexStrToL<uint8_t>(num_cpus);
-      system_info_->os_version = os_version;
+      system_info_->os_version = string(os_version);
 
       if (os_id == "L") {
         system_info_->os = "Linux";
@@ -277,21 +369,24 @@ Microdump::Microdump(const string& contents)
       }
 
       // OS line also contains release and version for future use.
-    } else if ((pos = line.find(kStackKey)) != string::npos) {
-      if (line.find(kStackFirstLineKey) != string::npos) {
+    } else if ((pos = line.find(kStackKey)) != std::string_view::npos) {
+      if (line.find(kStackFirstLineKey) != std::string_view::npos) {
         // The first line of the stack (S 0 stack header) provides the value of
         // the stack pointer, the start address of the stack being dumped and
-        // the length of the stack. We could use it in future to double check
-        // that we received all the stack as expected.
+        // the length of the stack. The length is used to size the stack
+        // buffer up front; we could use it in future to double check that we
+        // received all the stack as expected.
+        std::string_view header_tokens =
+            line.substr(pos + strlen(kStackFirstLineKey));
+        NextToken(&header_tokens);  // stack pointer
+        NextToken(&header_tokens);  // stack start
+        uint64_t stack_length = HexStrToL<uint64_t>(NextToken(&header_tokens));
+        stack_content.reserve(static_cast<size_t>(
+            std::min<uint64_t>(stack_length, kMaxStackReserve)));
         continue;
       }
-      string stack_str(line, pos + strlen(kStackKey));
-      std::istringstream stack_tokens(stack_str);
-      string start_addr_str;
-      string raw_content;
-      stack_tokens >> start_addr_str;
-      stack_tokens >> raw_content;
-      uint64_t start_addr = HexStrToL<uint64_t>(start_addr_str);
+      std::string_view stack_tokens = line.substr(pos + strlen(kStackKey));
+      uint64_t start_addr = HexStrToL<uint64_t>(NextToken(&stack_tokens));
 
       if (stack_start != 0) {
         // Verify that the stack chunks in the microdump are contiguous.
@@ -299,12 +394,11 @@ Microdump::Microdump(const string& contents)
       } else {
         stack_start = start_addr;
       }
-      std::vector<uint8_t> chunk = ParseHexBuf(raw_content);
-      stack_content.insert(stack_content.end(), chunk.begin(), chunk.end());
+      AppendHexBuf(NextToken(&stack_tokens), &stack_content);
 
-    } else if ((pos = line.find(kCpuKey)) != string::npos) {
-      string cpu_state_str(line, pos + strlen(kCpuKey));
-      std::vector<uint8_t> cpu_state_raw = ParseHexBuf(cpu_state_str);
+    } else if ((pos = line.find(kCpuKey)) != std::string_view::npos) {
+      std::vector<uint8_t> cpu_state_raw;
+      AppendHexBuf(line.substr(pos + strlen(kCpuKey)), &cpu_state_raw);
       if (strcmp(arch.c_str(), kArmArchitecture) == 0) {
         if (cpu_state_raw.size() != sizeof(MDRawContextARM)) {
           std::cerr << "Malformed CPU context. Got " << cpu_state_raw.size()
@@ -365,32 +459,34 @@ Microdump::Microdump(const string& contents)
       } else {
         std::cerr << "Unsupported architecture: " << arch << std::endl;
       }
-    } else if ((pos = line.find(kCrashReasonKey)) != string::npos) {
-      string crash_reason_str(line, pos + strlen(kCrashReasonKey));
-      std::istringstream crash_reason_tokens(crash_reason_str);
-      string signal;
-      string address;
-      crash_reason_tokens >> signal;
-      crash_reason_tokens >> crash_reason_;
-      crash_reason_tokens >> address;
-      crash_address_ = HexStrToL<uint64_t>(address);
-    } else if ((pos = line.find(kGpuKey)) != string::npos) {
-      string gpu_str(line, pos + strlen(kGpuKey));
-      if (strcmp(gpu_str.c_str(), kGpuUnknown) != 0) {
-        std::istringstream gpu_tokens(gpu_str);
-        std::getline(gpu_tokens, system_info_->gl_version, '|');
-        std::getline(gpu_tokens, system_info_->gl_vendor, '|');
-        std::getline(gpu_tokens, system_info_->gl_renderer, '|');
+    } else if ((pos = line.find(kCrashReasonKey)) != std::string_view::npos) {
+      std::string_view crash_reason_tokens =
+          line.substr(pos + strlen(kCrashReasonKey));
+      NextToken(&crash_reason_tokens);  // signal
+      crash_reason_ = string(NextToken(&crash_reason_tokens));
+      crash_address_ = HexStrToL<uint64_t>(NextToken(&crash_reason_tokens));
+    } else if ((pos = line.find(kGpuKey)) != std::string_view::npos) {
+      std::string_view gpu_tokens = line.substr(pos + strlen(kGpuKey));
+      if (gpu_tokens != kGpuUnknown) {
+        string* gpu_fields[] = { &system_info_->gl_version,
+                                 &system_info_->gl_vendor,
+                                 &system_info_->gl_renderer };
+        for (string* field : gpu_fields) {
+          if (gpu_tokens.empty())
+            break;
+          size_t separator = gpu_tokens.find('|');
+          *field = string(gpu_tokens.substr(0, separator));
+          gpu_tokens.remove_prefix(separator == std::string_view::npos ?
+                                   gpu_tokens.size() : separator + 1);
+        }
       }
-    } else if ((pos = line.find(kMmapKey)) != string::npos) {
-      string mmap_line(line, pos + strlen(kMmapKey));
-      std::istringstream mmap_tokens(mmap_line);
-      string addr, offset, size, identifier, filename;
-      mmap_tokens >> addr;
-      mmap_tokens >> offset;
-      mmap_tokens >> size;
-      mmap_tokens >> identifier;
-      mmap_tokens >> filename;
+    } else if ((pos = line.find(kMmapKey)) != std::string_view::npos) {
+      std::string_view mmap_tokens = line.substr(pos + strlen(kMmapKey));
+      std::string_view addr = NextToken(&mmap_tokens);
+      NextToken(&mmap_tokens);  // offset
+      std::string_view size = NextToken(&mmap_tokens);
+      string identifier(NextToken(&mmap_tokens));
+      string filename(NextToken(&mmap_tokens));
 
       modules_->Add(new BasicCodeModule(
           HexStrToL<uint64_t>(addr),  // base_address
@@ -402,7 +498,10 @@ Microdump::Microdump(const string& contents)
           ""));                       // version
     }
   }
-  stack_region_->Init(stack_start, stack_content);
+  stack_region_->Init(stack_start, std::move(stack_content));
+  if (consumed) {
+    *consumed = line_start;
+  }
 }
 
 }  // namespace google_breakpad
@@ -38,10 +38,18 @@
 
 #include <assert.h>
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <set>
 #include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "common/using_std_string.h"
 #include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/code_module.h"
 #include "google_breakpad/processor/microdump.h"
 #include "google_breakpad/processor/process_state.h"
 #include "google_breakpad/processor/stackwalker.h"
@@ -50,6 +58,36 @@
 
 namespace google_breakpad {
 
+namespace {
+
+// Calls work with each index below count, on up to concurrency threads.
+void RunConcurrently(size_t count, int concurrency,
+                     const std::function<void(size_t)>& work) {
+  std::atomic<size_t> next_index(0);
+  auto worker = [&]() {
+    for (size_t index = next_index++; index < count; index = next_index++) {
+      work(index);
+    }
+  };
+
+  size_t worker_count = std::min(
+      static_cast<size_t>(std::max(concurrency, 1)), count);
+  if (worker_count <= 1) {
+    worker();
+    return;
+  }
+  std::vector<std::thread> workers;
+  workers.reserve(worker_count);
+  for (size_t worker_index = 0; worker_index < worker_count; ++worker_index) {
+    workers.push_back(std::thread(worker));
+  }
+  for (std::thread& thread : workers) {
+    thread.join();
+  }
+}
+
+}  // namespace
+
 MicrodumpProcessor::MicrodumpProcessor(StackFrameSymbolizer* frame_symbolizer)
     : frame_symbolizer_(frame_symbolizer) {
   assert(frame_symbolizer);
@@ -63,17 +101,17 @@ ProcessResult MicrodumpProcessor::Process(Microdump *microdump,
 
   process_state->Clear();
 
-  process_state->modules_ = microdump->GetModules()->Copy();
+  process_state->modules_.reset(microdump->GetModules()->Copy());
   scoped_ptr<Stackwalker> stackwalker(
       Stackwalker::StackwalkerForCPU(
                             &process_state->system_info_,
                             microdump->GetContext(),
                             microdump->GetMemory(),
-                            process_state->modules_,
+                            process_state->modules(),
                             /* unloaded_modules= */ NULL,
                             frame_symbolizer_));
 
-  scoped_ptr<CallStack> stack(new CallStack());
+  scoped_ptr<CallStack> stack(process_state->NewThread());
   if (stackwalker.get()) {
     if (!stackwalker->Walk(stack.get(),
                            &process_state->modules_without_symbols_,
@@ -97,4 +135,43 @@ ProcessResult MicrodumpProcessor::Process(Microdump *microdump,
   return PROCESS_OK;
 }
 
+std::vector<ProcessResult> MicrodumpProcessor::ProcessBatch(
+    const std::vector<Microdump*>& microdumps,
+    const std::vector<ProcessState*>& process_states,
+    int concurrency) {
+  assert(microdumps.size() == process_states.size());
+
+  // Each microdump has its own modules, so versions are told apart by code
+  // file and debug identifier.
+  std::vector<std::pair<const CodeModule*, const SystemInfo*>>
+      prefetch_modules;
+  std::set<std::pair<string, string>> seen_modules;
+  for (Microdump* microdump : microdumps) {
+    uint64_t instruction_pointer;
+    if (!microdump->GetContext()->GetInstructionPointer(&instruction_pointer))
+      continue;
+    const CodeModule* module =
+        microdump->GetModules()->GetModuleForAddress(instruction_pointer);
+    if (module && seen_modules.insert(std::make_pair(
+            module->code_file(), module->debug_identifier())).second) {
+      prefetch_modules.push_back(
+          std::make_pair(module, microdump->GetSystemInfo()));
+    }
+  }
+  BPLOG(INFO) << "Prefetching symbols for " << prefetch_modules.size()
+              << " modules of " << microdumps.size() << " microdumps";
+  // A failed or interrupted prefetch is met again, and reported, by the
+  // walk that needs the module.
+  RunConcurrently(prefetch_modules.size(), concurrency, [&](size_t index) {
+    frame_symbolizer_->PrefetchModule(prefetch_modules[index].first,
+                                      prefetch_modules[index].second);
+  });
+
+  std::vector<ProcessResult> results(microdumps.size(), PROCESS_OK);
+  RunConcurrently(microdumps.size(), concurrency, [&](size_t index) {
+    results[index] = Process(microdumps[index], process_states[index]);
+  });
+  return results;
+}
+
 }  // namespace google_breakpad
@@ -35,6 +35,7 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "breakpad_googletest_includes.h"
@@ -138,6 +139,37 @@ TEST_F(MicrodumpProcessorTest, TestProcess_WithCrashReason) {
   ASSERT_EQ(state.crash_address(), 0x4A7CB000u);
 }
 
+TEST_F(MicrodumpProcessorTest, TestParseConcatenatedMicrodumps) {
+  // microdump-withcrashreason.dmp holds six microdumps back to back.
+  string microdump_contents;
+  ReadFile(files_path_ + "microdump-withcrashreason.dmp", &microdump_contents);
+  const uint64_t kExpectedCrashAddresses[] = {
+    0x4A7CB000u, 0x22F73000u, 0x29627000u, 0x0u, 0x4ED50008u, 0x0u
+  };
+
+  std::string_view remaining(microdump_contents);
+  size_t microdump_count = 0;
+  while (!remaining.empty()) {
+    size_t consumed = 0;
+    Microdump microdump(remaining, &consumed);
+    ASSERT_GT(consumed, 0U);
+    ASSERT_LE(consumed, remaining.size());
+    remaining.remove_prefix(consumed);
+    if (!microdump.GetContext()->valid())
+      continue;
+
+    ASSERT_LT(microdump_count, sizeof(kExpectedCrashAddresses) /
+                               sizeof(kExpectedCrashAddresses[0]));
+    ASSERT_EQ("SIGTRAP", microdump.GetCrashReason());
+    ASSERT_EQ(kExpectedCrashAddresses[microdump_count],
+              microdump.GetCrashAddress());
+    ASSERT_EQ("arm", microdump.GetSystemInfo()->cpu);
+    ASSERT_EQ(0x2000U, microdump.GetMemory()->GetSize());
+    ++microdump_count;
+  }
+  ASSERT_EQ(6U, microdump_count);
+}
+
 TEST_F(MicrodumpProcessorTest, TestProcess_MissingSymbols) {
   ProcessState state;
   AnalyzeDump("microdump-arm64.dmp", true /* omit_symbols */,
@@ -238,6 +270,48 @@ TEST_F(MicrodumpProcessorTest, TestProcessMultiple) {
   ASSERT_EQ(5U, state.threads()->at(0)->frames()->size());
 }
 
+TEST_F(MicrodumpProcessorTest, TestProcessBatch) {
+  string arm64_contents;
+  string x86_contents;
+  ReadFile(files_path_ + "microdump-arm64.dmp", &arm64_contents);
+  ReadFile(files_path_ + "microdump-x86.dmp", &x86_contents);
+  Microdump arm64_microdump(arm64_contents);
+  Microdump x86_microdump(x86_contents);
+  Microdump second_arm64_microdump(arm64_contents);
+  Microdump invalid_microdump("This is not a valid microdump");
+
+  SimpleSymbolSupplier supplier(files_path_ + "symbols/microdump");
+  BasicSourceLineResolver resolver;
+  StackFrameSymbolizer frame_symbolizer(&supplier, &resolver);
+  MicrodumpProcessor processor(&frame_symbolizer);
+  std::vector<Microdump*> microdumps = {
+    &arm64_microdump, &x86_microdump, &second_arm64_microdump,
+    &invalid_microdump
+  };
+  ProcessState states[4];
+  std::vector<ProcessState*> process_states = {
+    &states[0], &states[1], &states[2], &states[3]
+  };
+  std::vector<google_breakpad::ProcessResult> results =
+      processor.ProcessBatch(microdumps, process_states, 3);
+
+  ASSERT_EQ(4U, results.size());
+  ASSERT_EQ(google_breakpad::PROCESS_OK, results[0]);
+  ASSERT_EQ(google_breakpad::PROCESS_OK, results[1]);
+  ASSERT_EQ(google_breakpad::PROCESS_OK, results[2]);
+  ASSERT_EQ(google_breakpad::PROCESS_ERROR_NO_THREAD_LIST, results[3]);
+  for (int index : {0, 2}) {
+    ASSERT_EQ("arm64", states[index].system_info()->cpu);
+    ASSERT_EQ(9U, states[index].threads()->at(0)->frames()->size());
+    ASSERT_EQ("MicrodumpWriterTest_Setup_Test::TestBody",
+              states[index].threads()->at(0)->frames()->at(0)->function_name);
+    ASSERT_EQ("main",
+              states[index].threads()->at(0)->frames()->at(7)->function_name);
+  }
+  ASSERT_EQ("x86", states[1].system_info()->cpu);
+  ASSERT_EQ(17U, states[1].threads()->at(0)->frames()->size());
+}
+
 TEST_F(MicrodumpProcessorTest, TestProcessMips) {
   ProcessState state;
   AnalyzeDump("microdump-mips32.dmp", false /* omit_symbols */,
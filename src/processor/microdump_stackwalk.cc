@@ -28,17 +28,29 @@
 
 // microdump_stackwalk.cc: Process a microdump with MicrodumpProcessor, printing
 // the results, including stack traces.
+//
+// With -B, microdump_stackwalk processes every microdump in a file, such as
+// a logcat archive holding many, or in each file under a directory, on
+// several threads sharing loaded symbols.  The results are printed in input
+// order, each preceded by its file, index and outcome.
 
 #ifdef HAVE_CONFIG_H
 #include <config.h>  // Must come first
 #endif
 
+#include <dirent.h>
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <fstream>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "common/path_helper.h"
@@ -59,6 +71,7 @@ namespace {
 struct Options {
   bool machine_readable;
   bool output_stack_contents;
+  int batch_concurrency;
 
   string microdump_file;
   std::vector<string> symbol_paths;
@@ -68,11 +81,31 @@ using google_breakpad::BasicSourceLineResolver;
 using google_breakpad::Microdump;
 using google_breakpad::MicrodumpProcessor;
 using google_breakpad::ProcessResult;
+using google_breakpad::ProcessResultName;
 using google_breakpad::ProcessState;
 using google_breakpad::scoped_ptr;
 using google_breakpad::SimpleSymbolSupplier;
 using google_breakpad::StackFrameSymbolizer;
 
+// Reads the contents of microdump_file into microdump_content.  Returns
+// false if the file could not be read or is empty.
+bool ReadMicrodumpFile(const string& microdump_file,
+                       string* microdump_content) {
+  std::ifstream file_stream(microdump_file);
+  std::vector<char> bytes;
+  file_stream.seekg(0, std::ios_base::end);
+  std::streamoff size = file_stream.tellg();
+  if (size <= 0) {
+    BPLOG(ERROR) << "Microdump " << microdump_file << " is empty.";
+    return false;
+  }
+  bytes.resize(size);
+  file_stream.seekg(0, std::ios_base::beg);
+  file_stream.read(&bytes[0], bytes.size());
+  microdump_content->assign(&bytes[0], bytes.size());
+  return true;
+}
+
 // Processes |options.microdump_file| using
 // MicrodumpProcessor. |options.symbol_path|, if non-empty, is the
 // base directory of a symbol storage area, laid out in the format
@@ -84,17 +117,10 @@ using google_breakpad::StackFrameSymbolizer;
 // information and call stacks for the crashing thread.
 // All information is printed to stdout.
 int PrintMicrodumpProcess(const Options& options) {
-  std::ifstream file_stream(options.microdump_file);
-  std::vector<char> bytes;
-  file_stream.seekg(0, std::ios_base::end);
-  bytes.resize(file_stream.tellg());
-  if (bytes.empty()) {
-    BPLOG(ERROR) << "Microdump is empty.";
+  string microdump_content;
+  if (!ReadMicrodumpFile(options.microdump_file, &microdump_content)) {
     return 1;
   }
-  file_stream.seekg(0, std::ios_base::beg);
-  file_stream.read(&bytes[0], bytes.size());
-  string microdump_content(&bytes[0], bytes.size());
 
   scoped_ptr<SimpleSymbolSupplier> symbol_supplier;
   if (!options.symbol_paths.empty()) {
@@ -111,11 +137,11 @@ int PrintMicrodumpProcess(const Options& options) {
 
   if (res == google_breakpad::PROCESS_OK) {
     if (options.machine_readable) {
-      PrintProcessStateMachineReadable(process_state);
+      PrintProcessStateMachineReadable(stdout, process_state);
     } else {
       // Microdump has only one thread, |output_requesting_thread_only|'s value
       // has no effect.
-      PrintProcessState(process_state, options.output_stack_contents,
+      PrintProcessState(stdout, process_state, options.output_stack_contents,
                         /*output_requesting_thread_only=*/false, &resolver);
     }
     return 0;
@@ -125,6 +151,134 @@ int PrintMicrodumpProcess(const Options& options) {
   return 1;
 }
 
+
+// Appends the path of each regular file under directory, which is searched
+// recursively, to microdump_files.  Returns false if a directory could not
+// be read.
+bool FindMicrodumpFiles(const string& directory,
+                        std::vector<string>* microdump_files) {
+  DIR* dir = opendir(directory.c_str());
+  if (!dir) {
+    BPLOG(ERROR) << "Could not open directory " << directory << ": "
+                 << strerror(errno);
+    return false;
+  }
+  bool found = true;
+  while (struct dirent* entry = readdir(dir)) {
+    string name = entry->d_name;
+    if (name == "." || name == "..")
+      continue;
+    string path = directory + "/" + name;
+    struct stat path_stat;
+    if (stat(path.c_str(), &path_stat) != 0)
+      continue;
+    if (S_ISDIR(path_stat.st_mode)) {
+      found = FindMicrodumpFiles(path, microdump_files) && found;
+    } else if (S_ISREG(path_stat.st_mode)) {
+      microdump_files->push_back(path);
+    }
+  }
+  closedir(dir);
+  return found;
+}
+
+// One microdump of a batch, or a file that could not be read.
+struct BatchEntry {
+  BatchEntry(const string* file, int index) : file(file), index(index) {}
+
+  const string* file;
+  // The index of the microdump within file.
+  int index;
+  // NULL if file could not be read.
+  std::unique_ptr<Microdump> microdump;
+  ProcessState process_state;
+};
+
+// Processes every microdump in |options.microdump_file|, or in each file
+// under it if it is a directory, with MicrodumpProcessor::ProcessBatch on
+// |options.batch_concurrency| threads.  Each microdump's file, index within
+// the file and outcome are printed, followed by its call stacks if it was
+// processed, and then the totals.  All information is printed to stdout.
+//
+// Returns 0 if every microdump was processed, and 1 otherwise.
+int PrintMicrodumpBatch(const Options& options) {
+  std::vector<string> microdump_files;
+  struct stat input_stat;
+  if (stat(options.microdump_file.c_str(), &input_stat) == 0 &&
+      S_ISDIR(input_stat.st_mode)) {
+    if (!FindMicrodumpFiles(options.microdump_file, &microdump_files))
+      return 1;
+    std::sort(microdump_files.begin(), microdump_files.end());
+  } else {
+    microdump_files.push_back(options.microdump_file);
+  }
+
+  // The microdumps of each file are parsed in place, one after the other.
+  static const char kMicrodumpBegin[] = "-----BEGIN BREAKPAD MICRODUMP-----";
+  std::vector<std::unique_ptr<BatchEntry>> entries;
+  std::vector<Microdump*> microdumps;
+  std::vector<ProcessState*> process_states;
+  for (const string& microdump_file : microdump_files) {
+    string microdump_content;
+    if (!ReadMicrodumpFile(microdump_file, &microdump_content)) {
+      entries.push_back(
+          std::unique_ptr<BatchEntry>(new BatchEntry(&microdump_file, 0)));
+      continue;
+    }
+    std::string_view remaining(microdump_content);
+    int index = 0;
+    while (remaining.find(kMicrodumpBegin) != std::string_view::npos) {
+      BatchEntry* entry = new BatchEntry(&microdump_file, index++);
+      entries.push_back(std::unique_ptr<BatchEntry>(entry));
+      size_t consumed = 0;
+      entry->microdump.reset(new Microdump(remaining, &consumed));
+      remaining.remove_prefix(consumed);
+      microdumps.push_back(entry->microdump.get());
+      process_states.push_back(&entry->process_state);
+    }
+  }
+
+  scoped_ptr<SimpleSymbolSupplier> symbol_supplier;
+  if (!options.symbol_paths.empty()) {
+    symbol_supplier.reset(new SimpleSymbolSupplier(options.symbol_paths));
+  }
+
+  BasicSourceLineResolver resolver;
+  StackFrameSymbolizer frame_symbolizer(symbol_supplier.get(), &resolver);
+  MicrodumpProcessor microdump_processor(&frame_symbolizer);
+  std::vector<ProcessResult> results = microdump_processor.ProcessBatch(
+      microdumps, process_states, options.batch_concurrency);
+
+  size_t result_index = 0;
+  int failed_count = 0;
+  for (const std::unique_ptr<BatchEntry>& entry : entries) {
+    if (!entry->microdump) {
+      printf("%s: FAILED (could not be read)\n", entry->file->c_str());
+      ++failed_count;
+      continue;
+    }
+    ProcessResult result = results[result_index++];
+    printf("%s #%d: ", entry->file->c_str(), entry->index);
+    if (result != google_breakpad::PROCESS_OK) {
+      printf("FAILED (%s)\n", ProcessResultName(result));
+      ++failed_count;
+      continue;
+    }
+    printf("OK\n");
+    if (options.machine_readable) {
+      PrintProcessStateMachineReadable(stdout, entry->process_state);
+    } else {
+      PrintProcessState(stdout, entry->process_state,
+                        options.output_stack_contents,
+                        /*output_requesting_thread_only=*/false, &resolver);
+    }
+    printf("\n");
+  }
+  printf("%zu microdumps processed, %d failed\n", entries.size(),
+         failed_count);
+  return failed_count > 0 ? 1 : 0;
+}
+
 }  // namespace
 
 static void Usage(int argc, const char *argv[], bool error) {
@@ -135,6 +289,8 @@ static void Usage(int argc, const char *argv[], bool error) {
           "\n"
           "Options:\n"
           "\n"
+          "  -B <n>     Process every microdump in <microdump-file>, or in\n"
+          "             each file under it if it is a directory, on n threads\n"
           "  -m         Output in machine-readable format\n"
           "  -s         Output stack contents\n",
           google_breakpad::BaseName(argv[0]).c_str());
@@ -145,14 +301,23 @@ static void SetupOptions(int argc, const char *argv[], Options* options) {
 
   options->machine_readable = false;
   options->output_stack_contents = false;
+  options->batch_concurrency = 0;
 
-  while ((ch = getopt(argc, (char * const*)argv, "hms")) != -1) {
+  while ((ch = getopt(argc, (char * const*)argv, "B:hms")) != -1) {
     switch (ch) {
       case 'h':
         Usage(argc, argv, false);
         exit(0);
         break;
 
+      case 'B':
+        options->batch_concurrency = atoi(optarg);
+        if (options->batch_concurrency < 1) {
+          fprintf(stderr, "%s: Invalid concurrency: %s\n", argv[0], optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        break;
       case 'm':
         options->machine_readable = true;
         break;
@@ -183,5 +348,7 @@ int main(int argc, const char* argv[]) {
   Options options;
   SetupOptions(argc, argv, &options);
 
+  if (options.batch_concurrency > 0)
+    return PrintMicrodumpBatch(options);
   return PrintMicrodumpProcess(options);
 }
@@ -59,14 +59,21 @@
 
 #include <algorithm>
 #include <fstream>
+#include <iterator>
 #include <limits>
 #include <utility>
 
 #include "processor/range_map-inl.h"
 
+#include "common/compressed_minidump.h"
+#if defined(__linux__)
+#include "common/linux/memory_mapped_file.h"
+#endif  // __linux__
+#include "common/lz4_block.h"
 #include "common/macros.h"
 #include "common/scoped_ptr.h"
 #include "common/stdio_wrapper.h"
+#include "common/utf16_ascii.h"
 #include "google_breakpad/processor/dump_context.h"
 #include "processor/basic_code_module.h"
 #include "processor/basic_code_modules.h"
@@ -258,19 +265,27 @@ inline void Swap(uint16_t* data, size_t size_in_bytes) {
 // parameter, a converter that uses iconv would also need to take the host
 // CPU's endianness into consideration.  It doesn't seems worth the trouble
 // of making it a dependency when we don't care about anything but UTF-16.
-string* UTF16ToUTF8(const vector<uint16_t>& in, bool swap) {
+string* UTF16ToUTF8(const uint16_t* in_data, size_t in_size, bool swap) {
   scoped_ptr<string> out(new string());
-
-  // Set the string's initial capacity to the number of UTF-16 characters,
-  // because the UTF-8 representation will always be at least this long.
-  // If the UTF-8 representation is longer, the string will grow dynamically.
-  out->reserve(in.size());
-
-  for (vector<uint16_t>::const_iterator iterator = in.begin();
-       iterator != in.end();
-       ++iterator) {
+  if (in_size == 0)
+    return out.release();
+
+  // Most strings are entirely ASCII, and their UTF-8 representation is
+  // exactly as long as the UTF-16 one, so try copying the whole string as
+  // ASCII first.
+  out->resize(in_size);
+  size_t in_index = CopyASCIIFromUTF16(in_data, in_size, swap, &(*out)[0]);
+  if (in_index == in_size)
+    return out.release();
+
+  // Otherwise, each remaining UTF-16 value takes at most three bytes of
+  // UTF-8, since characters that take four take two values.
+  out->resize(in_index + (in_size - in_index) * 3);
+  char* out_data = &(*out)[0];
+  size_t out_index = in_index;
+  while (in_index < in_size) {
     // Get a 16-bit value from the input
-    uint16_t in_word = *iterator;
+    uint16_t in_word = in_data[in_index++];
     if (swap)
       Swap(&in_word);
 
@@ -283,13 +298,15 @@ string* UTF16ToUTF8(const vector<uint16_t>& in, bool swap) {
     } else if (in_word >= 0xd800 && in_word <= 0xdbff) {
       // High surrogate.
       unichar = (in_word - 0xd7c0) << 10;
-      if (++iterator == in.end()) {
+      if (in_index == in_size) {
         BPLOG(ERROR) << "UTF16ToUTF8 found high surrogate " <<
                         HexString(in_word) << " at end of string";
         return NULL;
       }
       uint32_t high_word = in_word;
-      in_word = *iterator;
+      in_word = in_data[in_index++];
+      if (swap)
+        Swap(&in_word);
       if (in_word < 0xdc00 || in_word > 0xdcff) {
         BPLOG(ERROR) << "UTF16ToUTF8 found high surrogate " <<
                         HexString(high_word) << " without low " <<
@@ -306,19 +323,25 @@ string* UTF16ToUTF8(const vector<uint16_t>& in, bool swap) {
     // Convert the Unicode code point (unichar) into its UTF-8 representation,
     // appending it to the out string.
     if (unichar < 0x80) {
-      (*out) += static_cast<char>(unichar);
+      out_data[out_index++] = static_cast<char>(unichar);
+      // Copy any run of ASCII that follows at once.
+      size_t ascii_count = CopyASCIIFromUTF16(in_data + in_index,
+                                              in_size - in_index, swap,
+                                              out_data + out_index);
+      in_index += ascii_count;
+      out_index += ascii_count;
     } else if (unichar < 0x800) {
-      (*out) += 0xc0 | static_cast<char>(unichar >> 6);
-      (*out) += 0x80 | static_cast<char>(unichar & 0x3f);
+      out_data[out_index++] = 0xc0 | static_cast<char>(unichar >> 6);
+      out_data[out_index++] = 0x80 | static_cast<char>(unichar & 0x3f);
     } else if (unichar < 0x10000) {
-      (*out) += 0xe0 | static_cast<char>(unichar >> 12);
-      (*out) += 0x80 | static_cast<char>((unichar >> 6) & 0x3f);
-      (*out) += 0x80 | static_cast<char>(unichar & 0x3f);
+      out_data[out_index++] = 0xe0 | static_cast<char>(unichar >> 12);
+      out_data[out_index++] = 0x80 | static_cast<char>((unichar >> 6) & 0x3f);
+      out_data[out_index++] = 0x80 | static_cast<char>(unichar & 0x3f);
     } else if (unichar < 0x200000) {
-      (*out) += 0xf0 | static_cast<char>(unichar >> 18);
-      (*out) += 0x80 | static_cast<char>((unichar >> 12) & 0x3f);
-      (*out) += 0x80 | static_cast<char>((unichar >> 6) & 0x3f);
-      (*out) += 0x80 | static_cast<char>(unichar & 0x3f);
+      out_data[out_index++] = 0xf0 | static_cast<char>(unichar >> 18);
+      out_data[out_index++] = 0x80 | static_cast<char>((unichar >> 12) & 0x3f);
+      out_data[out_index++] = 0x80 | static_cast<char>((unichar >> 6) & 0x3f);
+      out_data[out_index++] = 0x80 | static_cast<char>(unichar & 0x3f);
     } else {
       BPLOG(ERROR) << "UTF16ToUTF8 cannot represent high value " <<
                       HexString(unichar) << " in UTF-8";
@@ -326,9 +349,14 @@ string* UTF16ToUTF8(const vector<uint16_t>& in, bool swap) {
     }
   }
 
+  out->resize(out_index);
   return out.release();
 }
 
+string* UTF16ToUTF8(const vector<uint16_t>& in, bool swap) {
+  return UTF16ToUTF8(in.empty() ? NULL : &in[0], in.size(), swap);
+}
+
 // Return the smaller of the number of code units in the UTF-16 string,
 // not including the terminating null word, or maxlen.
 size_t UTF16codeunits(const uint16_t* string, size_t maxlen) {
@@ -360,10 +388,7 @@ void ConvertUTF16BufferToUTF8String(const uint16_t* utf16_data,
   size_t max_word_length = max_length_in_bytes / sizeof(utf16_data[0]);
   size_t word_length = UTF16codeunits(utf16_data, max_word_length);
   if (word_length > 0) {
-    size_t byte_length = word_length * sizeof(utf16_data[0]);
-    vector<uint16_t> utf16_vector(word_length);
-    memcpy(&utf16_vector[0], &utf16_data[0], byte_length);
-    scoped_ptr<string> temp(UTF16ToUTF8(utf16_vector, swap));
+    scoped_ptr<string> temp(UTF16ToUTF8(utf16_data, word_length, swap));
     if (temp.get()) {
       utf8_result->assign(*temp);
     }
@@ -394,6 +419,82 @@ void PrintValueOrInvalid(bool valid,
   }
 }
 
+// The two hex digits and the hexdump character of each byte value.
+struct HexdumpTables {
+  HexdumpTables() {
+    static const char kHexDigits[] = "0123456789abcdef";
+    for (int byte = 0; byte < 256; ++byte) {
+      hex[byte][0] = kHexDigits[byte >> 4];
+      hex[byte][1] = kHexDigits[byte & 0xf];
+      character[byte] = isprint(byte) ? byte : '.';
+    }
+  }
+
+  char hex[256][2];
+  char character[256];
+};
+
+const HexdumpTables& GetHexdumpTables() {
+  static const HexdumpTables tables;
+  return tables;
+}
+
+// Prints size bytes of memory, width to a line, each line headed by its
+// offset and followed by the bytes as characters.  Lines are formatted
+// whole from tables and written at once, since the bytes of a memory
+// region can number in the millions.
+void PrintHexdump(const uint8_t* memory, uint32_t size, unsigned int width) {
+  const HexdumpTables& tables = GetHexdumpTables();
+  // The offset and two spaces, three characters and a character per byte,
+  // a space per 8 bytes, and the bars and newline.
+  vector<char> line(10 + width * 4 + width / 8 + 3);
+  for (uint32_t offset = 0; offset < size; offset += width) {
+    // In case the memory won't fill a whole line.
+    unsigned int count = std::min(size - offset, width);
+    char* out = &line[0];
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      memcpy(out, tables.hex[(offset >> shift) & 0xff], 2);
+      out += 2;
+    }
+    *out++ = ' ';
+    *out++ = ' ';
+    for (unsigned int i = 0; i < width; ++i) {
+      if (i < count) {
+        memcpy(out, tables.hex[memory[offset + i]], 2);
+      } else {
+        out[0] = ' ';
+        out[1] = ' ';
+      }
+      out[2] = ' ';
+      out += 3;
+      // A space every 8 bytes makes it more readable.
+      if (((i + 1) % 8) == 0)
+        *out++ = ' ';
+    }
+    *out++ = '|';
+    for (unsigned int i = 0; i < width; ++i)
+      *out++ = i < count ? tables.character[memory[offset + i]] : ' ';
+    *out++ = '|';
+    *out++ = '\n';
+    fwrite(&line[0], 1, out - &line[0], stdout);
+  }
+}
+
+// Prints size bytes of memory as a single hex number.
+void PrintHexString(const uint8_t* memory, uint32_t size) {
+  const HexdumpTables& tables = GetHexdumpTables();
+  char chunk[8192];
+  fputs("0x", stdout);
+  for (uint32_t offset = 0; offset < size;) {
+    uint32_t count = std::min<uint32_t>(size - offset, sizeof(chunk) / 2);
+    for (uint32_t i = 0; i < count; ++i)
+      memcpy(&chunk[i * 2], tables.hex[memory[offset + i]], 2);
+    fwrite(chunk, 1, count * 2, stdout);
+    offset += count;
+  }
+  fputc('\n', stdout);
+}
+
 // Converts a time_t to a string showing the time in UTC.
 string TimeTToUTCString(time_t tt) {
   struct tm timestruct;
@@ -434,6 +535,135 @@ bool IsDevAshmem(const string& filename) {
   return filename.compare(0, kDevAshmem.length(), kDevAshmem) == 0;
 }
 
+// Returns true if the |size| bytes at |data| begin with the magic number of
+// a compressed minidump, setting |swap| if it is in the other byte order.
+bool IsCompressedMinidump(const uint8_t* data, size_t size, bool* swap) {
+  uint32_t magic;
+  if (size < sizeof(magic))
+    return false;
+  memcpy(&magic, data, sizeof(magic));
+  if (magic == kCompressedMinidumpMagic) {
+    *swap = false;
+    return true;
+  }
+  Swap(&magic);
+  if (magic == kCompressedMinidumpMagic) {
+    *swap = true;
+    return true;
+  }
+  return false;
+}
+
+// Decompresses the compressed minidump of |size| bytes at |data|, whose
+// fields need byte-swapping if |swap| is set, into |image|.  See
+// common/compressed_minidump.h for the layout.
+bool DecompressMinidump(const uint8_t* data, size_t size, bool swap,
+                        vector<uint8_t>* image) {
+  CompressedMinidumpHeader header;
+  if (size < sizeof(header)) {
+    BPLOG(ERROR) << "DecompressMinidump header is truncated";
+    return false;
+  }
+  memcpy(&header, data, sizeof(header));
+  if (swap)
+    Swap(&header.version);
+  if (header.version != kCompressedMinidumpVersion) {
+    BPLOG(ERROR) << "DecompressMinidump unknown version " << header.version;
+    return false;
+  }
+
+  image->clear();
+  vector<uint8_t> raw;
+  size_t offset = sizeof(header);
+  while (offset < size) {
+    CompressedMinidumpFrame frame;
+    if (size - offset < sizeof(frame)) {
+      BPLOG(ERROR) << "DecompressMinidump frame header is truncated";
+      return false;
+    }
+    memcpy(&frame, data + offset, sizeof(frame));
+    offset += sizeof(frame);
+    if (swap) {
+      Swap(&frame.raw_size);
+      Swap(&frame.stored_size);
+    }
+    if (frame.stored_size > size - offset ||
+        frame.stored_size > frame.raw_size) {
+      BPLOG(ERROR) << "DecompressMinidump frame has bad size " <<
+                      frame.stored_size << "/" << frame.raw_size;
+      return false;
+    }
+
+    const uint8_t* segments = data + offset;
+    offset += frame.stored_size;
+    if (frame.stored_size != frame.raw_size) {
+      // No LZ4 block expands by more than this.
+      if (frame.raw_size / 255 > frame.stored_size) {
+        BPLOG(ERROR) << "DecompressMinidump frame has bad size " <<
+                        frame.stored_size << "/" << frame.raw_size;
+        return false;
+      }
+      raw.resize(frame.raw_size);
+      if (!LZ4Decompress(segments, frame.stored_size, &raw[0], raw.size())) {
+        BPLOG(ERROR) << "DecompressMinidump could not decompress frame";
+        return false;
+      }
+      segments = &raw[0];
+    }
+
+    size_t position = 0;
+    while (position < frame.raw_size) {
+      CompressedMinidumpSegment segment;
+      if (frame.raw_size - position < sizeof(segment)) {
+        BPLOG(ERROR) << "DecompressMinidump segment header is truncated";
+        return false;
+      }
+      memcpy(&segment, segments + position, sizeof(segment));
+      position += sizeof(segment);
+      if (swap) {
+        Swap(&segment.position);
+        Swap(&segment.size);
+      }
+      if (segment.size > frame.raw_size - position) {
+        BPLOG(ERROR) << "DecompressMinidump segment is truncated";
+        return false;
+      }
+
+      const uint64_t end = static_cast<uint64_t>(segment.position) +
+          segment.size;
+      if (end > image->size())
+        image->resize(end);
+      if (segment.size) {
+        memcpy(&(*image)[segment.position], segments + position,
+               segment.size);
+      }
+      position += segment.size;
+    }
+  }
+
+  return true;
+}
+
+// An address index pairs the highest address of each of a list's address
+// ranges with the range's index in the list, sorted by highest address.  When
+// the ranges don't overlap, the only range that can contain an address is the
+// first one whose highest address isn't below it.
+typedef vector<std::pair<uint64_t, unsigned int>> AddressIndex;
+
+// Sets *index to the index of the only range in address_index that can
+// contain address, and returns true; or returns false if no range can.  The
+// caller must still check the range's base address.
+bool LookUpAddressIndex(const AddressIndex& address_index, uint64_t address,
+                        unsigned int* index) {
+  AddressIndex::const_iterator iterator =
+      std::lower_bound(address_index.begin(), address_index.end(),
+                       std::make_pair(address, 0U));
+  if (iterator == address_index.end())
+    return false;
+  *index = iterator->second;
+  return true;
+}
+
 }  // namespace
 
 //
@@ -1498,7 +1728,8 @@ uint32_t MinidumpMemoryRegion::max_bytes_ = 64 * 1024 * 1024;  // 64MB
 MinidumpMemoryRegion::MinidumpMemoryRegion(Minidump* minidump)
     : MinidumpObject(minidump),
       descriptor_(NULL),
-      memory_(NULL) {
+      memory_(NULL),
+      mapped_memory_(NULL) {
   hexdump_width_ = minidump_ ? minidump_->HexdumpMode() : 0;
   hexdump_ = hexdump_width_ != 0;
 }
@@ -1524,12 +1755,34 @@ const uint8_t* MinidumpMemoryRegion::GetMemory() const {
     return NULL;
   }
 
+  if (mapped_memory_) {
+    return mapped_memory_;
+  }
+
   if (!memory_) {
     if (descriptor_->memory.data_size == 0) {
       BPLOG(ERROR) << "MinidumpMemoryRegion is empty";
       return NULL;
     }
 
+    if (minidump_->is_memory_backed()) {
+      if (descriptor_->memory.data_size > max_bytes_) {
+        BPLOG(ERROR) << "MinidumpMemoryRegion size " <<
+                        descriptor_->memory.data_size << " exceeds maximum " <<
+                        max_bytes_;
+        return NULL;
+      }
+
+      mapped_memory_ = minidump_->GetMappedBytes(
+          descriptor_->memory.rva, descriptor_->memory.data_size);
+      if (!mapped_memory_) {
+        BPLOG(ERROR) << "MinidumpMemoryRegion could not map memory region";
+        return NULL;
+      }
+
+      return mapped_memory_;
+    }
+
     if (!minidump_->SeekSet(descriptor_->memory.rva)) {
       BPLOG(ERROR) << "MinidumpMemoryRegion could not seek to memory region";
       return NULL;
@@ -1580,6 +1833,7 @@ uint32_t MinidumpMemoryRegion::GetSize() const {
 void MinidumpMemoryRegion::FreeMemory() {
   delete memory_;
   memory_ = NULL;
+  mapped_memory_ = NULL;
 }
 
 
@@ -1651,6 +1905,21 @@ bool MinidumpMemoryRegion::GetMemoryAtAddress(uint64_t  address,
 }
 
 
+bool MinidumpMemoryRegion::ByteSwapped() const {
+  return valid_ && minidump_->swap();
+}
+
+
+const uint8_t* MinidumpMemoryRegion::GetSpanAtOffset(uint64_t offset,
+                                                     size_t size) const {
+  if (!valid_)
+    return NULL;
+  // GetMemory logs its own failures.
+  const uint8_t* memory = GetMemory();
+  return memory ? memory + offset : NULL;
+}
+
+
 void MinidumpMemoryRegion::Print() const {
   if (!valid_) {
     BPLOG(ERROR) << "MinidumpMemoryRegion cannot print invalid data";
@@ -1660,55 +1929,9 @@ void MinidumpMemoryRegion::Print() const {
   const uint8_t* memory = GetMemory();
   if (memory) {
     if (hexdump_) {
-      // Pretty hexdump view.
-      for (unsigned int byte_index = 0;
-           byte_index < descriptor_->memory.data_size;
-           byte_index += hexdump_width_) {
-        // In case the memory won't fill a whole line.
-        unsigned int num_bytes = std::min(
-            descriptor_->memory.data_size - byte_index, hexdump_width_);
-
-        // Display the leading address.
-        printf("%08x  ", byte_index);
-
-        // Show the bytes in hex.
-        for (unsigned int i = 0; i < hexdump_width_; ++i) {
-          if (i < num_bytes) {
-            // Show the single byte of memory in hex.
-            printf("%02x ", memory[byte_index + i]);
-          } else {
-            // If this line doesn't fill up, pad it out.
-            printf("   ");
-          }
-
-          // Insert a space every 8 bytes to make it more readable.
-          if (((i + 1) % 8) == 0) {
-            printf(" ");
-          }
-        }
-
-        // Decode the line as ASCII.
-        printf("|");
-        for (unsigned int i = 0; i < hexdump_width_; ++i) {
-          if (i < num_bytes) {
-            uint8_t byte = memory[byte_index + i];
-            printf("%c", isprint(byte) ? byte : '.');
-          } else {
-            // If this line doesn't fill up, pad it out.
-            printf(" ");
-          }
-        }
-        printf("|\n");
-      }
+      PrintHexdump(memory, descriptor_->memory.data_size, hexdump_width_);
     } else {
-      // Ugly raw string view.
-      printf("0x");
-      for (unsigned int i = 0;
-           i < descriptor_->memory.data_size;
-           i++) {
-        printf("%02x", memory[i]);
-      }
-      printf("\n");
+      PrintHexString(memory, descriptor_->memory.data_size);
     }
   } else {
     printf("No memory\n");
@@ -2293,6 +2516,7 @@ uint32_t MinidumpModule::max_misc_bytes_ = 32768;
 MinidumpModule::MinidumpModule(Minidump* minidump)
     : MinidumpObject(minidump),
       module_valid_(false),
+      debug_info_read_(false),
       has_debug_info_(false),
       module_(),
       name_(NULL),
@@ -2309,7 +2533,7 @@ MinidumpModule::~MinidumpModule() {
 }
 
 
-bool MinidumpModule::Read() {
+bool MinidumpModule::Read(const uint8_t* raw) {
   // Invalidate cached data.
   delete name_;
   name_ = NULL;
@@ -2320,13 +2544,11 @@ bool MinidumpModule::Read() {
   misc_record_ = NULL;
 
   module_valid_ = false;
+  debug_info_read_ = false;
   has_debug_info_ = false;
   valid_ = false;
 
-  if (!minidump_->ReadBytes(&module_, MD_MODULE_SIZE)) {
-    BPLOG(ERROR) << "MinidumpModule cannot read module";
-    return false;
-  }
+  memcpy(&module_, raw, MD_MODULE_SIZE);
 
   if (minidump_->swap()) {
     Swap(&module_.base_of_image);
@@ -2383,6 +2605,14 @@ bool MinidumpModule::ReadAuxiliaryData() {
 
   // At this point, we have enough info for the module to be valid.
   valid_ = true;
+  return true;
+}
+
+
+bool MinidumpModule::ReadDebugInfo() const {
+  if (debug_info_read_)
+    return has_debug_info_;
+  debug_info_read_ = true;
 
   // CodeView and miscellaneous debug records are only required if the
   // module indicates that they exist.
@@ -2419,7 +2649,7 @@ string MinidumpModule::code_identifier() const {
     return "";
   }
 
-  if (!has_debug_info_)
+  if (!ReadDebugInfo())
     return "";
 
   MinidumpSystemInfo* minidump_system_info = minidump_->GetSystemInfo();
@@ -2503,7 +2733,7 @@ string MinidumpModule::debug_file() const {
     return "";
   }
 
-  if (!has_debug_info_)
+  if (!ReadDebugInfo())
     return "";
 
   string file;
@@ -2611,7 +2841,7 @@ string MinidumpModule::debug_identifier() const {
     return "";
   }
 
-  if (!has_debug_info_)
+  if (!ReadDebugInfo())
     return "";
 
   string identifier;
@@ -2723,7 +2953,7 @@ void MinidumpModule::SetShrinkDownDelta(uint64_t shrink_down_delta) {
 }
 
 
-const uint8_t* MinidumpModule::GetCVRecord(uint32_t* size) {
+const uint8_t* MinidumpModule::GetCVRecord(uint32_t* size) const {
   if (!module_valid_) {
     BPLOG(ERROR) << "Invalid MinidumpModule for GetCVRecord";
     return NULL;
@@ -2860,7 +3090,7 @@ const uint8_t* MinidumpModule::GetCVRecord(uint32_t* size) {
 }
 
 
-const MDImageDebugMisc* MinidumpModule::GetMiscRecord(uint32_t* size) {
+const MDImageDebugMisc* MinidumpModule::GetMiscRecord(uint32_t* size) const {
   if (!module_valid_) {
     BPLOG(ERROR) << "Invalid MinidumpModule for GetMiscRecord";
     return NULL;
@@ -3122,6 +3352,7 @@ bool MinidumpModuleList::Read(uint32_t expected_size) {
   delete modules_;
   modules_ = NULL;
   module_count_ = 0;
+  shared_copy_.reset();
 
   valid_ = false;
 
@@ -3171,6 +3402,14 @@ bool MinidumpModuleList::Read(uint32_t expected_size) {
   }
 
   if (module_count != 0) {
+    // The raw module records are contiguous, so read them all at once
+    // rather than with a read per module.
+    vector<uint8_t> raw_modules(module_count * MD_MODULE_SIZE);
+    if (!minidump_->ReadBytes(&raw_modules[0], raw_modules.size())) {
+      BPLOG(ERROR) << "MinidumpModuleList could not read modules";
+      return false;
+    }
+
     scoped_ptr<MinidumpModules> modules(
         new MinidumpModules(module_count, MinidumpModule(minidump_)));
 
@@ -3178,8 +3417,7 @@ bool MinidumpModuleList::Read(uint32_t expected_size) {
          ++module_index) {
       MinidumpModule* module = &(*modules)[module_index];
 
-      // Assume that the file offset is correct after the last read.
-      if (!module->Read()) {
+      if (!module->Read(&raw_modules[module_index * MD_MODULE_SIZE])) {
         BPLOG(ERROR) << "MinidumpModuleList could not read module " <<
                         module_index << "/" << module_count;
         return false;
@@ -3187,20 +3425,17 @@ bool MinidumpModuleList::Read(uint32_t expected_size) {
     }
 
     // Loop through the module list once more to read additional data and
-    // build the range map.  This is done in a second pass because
-    // MinidumpModule::ReadAuxiliaryData seeks around, and if it were
-    // included in the loop above, additional seeks would be needed where
-    // none are now to read contiguous data.
+    // build the range map.
     uint64_t last_end_address = 0;
     for (uint32_t module_index = 0; module_index < module_count;
          ++module_index) {
       MinidumpModule& module = (*modules)[module_index];
 
-      // ReadAuxiliaryData fails if any data that the module indicates should
-      // exist is missing, but we treat some such cases as valid anyway.  See
-      // issue #222: if a debugging record is of a format that's too large to
-      // handle, it shouldn't render the entire dump invalid.  Check module
-      // validity before giving up.
+      // ReadAuxiliaryData reads only the module name, which every module
+      // must have.  The debugging records are read when first needed, and
+      // one that is missing or of a format that's too large to handle only
+      // leaves the module without debug info (see issue #222); it shouldn't
+      // render the entire dump invalid.
       if (!module.ReadAuxiliaryData() && !module.valid()) {
         BPLOG(ERROR) << "MinidumpModuleList could not read required module "
                         "auxiliary data for module " <<
@@ -3373,6 +3608,12 @@ const CodeModules* MinidumpModuleList::Copy() const {
   return new BasicCodeModules(this, range_map_->GetMergeStrategy());
 }
 
+std::shared_ptr<const CodeModules> MinidumpModuleList::GetSharedCopy() const {
+  if (!shared_copy_)
+    shared_copy_.reset(Copy());
+  return shared_copy_;
+}
+
 vector<linked_ptr<const CodeModule> >
 MinidumpModuleList::GetShrunkRangeModules() const {
   return vector<linked_ptr<const CodeModule> >();
@@ -3409,6 +3650,7 @@ uint32_t MinidumpMemoryList::max_regions_ = 4096;
 MinidumpMemoryList::MinidumpMemoryList(Minidump* minidump)
     : MinidumpStream(minidump),
       range_map_(new RangeMap<uint64_t, unsigned int>()),
+      last_region_index_(0),
       descriptors_(NULL),
       regions_(NULL),
       region_count_(0) {
@@ -3429,6 +3671,7 @@ bool MinidumpMemoryList::Read(uint32_t expected_size) {
   delete regions_;
   regions_ = NULL;
   range_map_->Clear();
+  last_region_index_ = 0;
   region_count_ = 0;
 
   valid_ = false;
@@ -3528,6 +3771,7 @@ bool MinidumpMemoryList::Read(uint32_t expected_size) {
 
     descriptors_ = descriptors.release();
     regions_ = regions.release();
+    range_map_->Freeze();
   }
 
   region_count_ = region_count;
@@ -3561,7 +3805,17 @@ MinidumpMemoryRegion* MinidumpMemoryList::GetMemoryRegionForAddress(
     return NULL;
   }
 
-  unsigned int region_index;
+  unsigned int region_index =
+      last_region_index_.load(std::memory_order_relaxed);
+  if (region_index < region_count_) {
+    const MDMemoryDescriptor& descriptor = (*descriptors_)[region_index];
+    if (address >= descriptor.start_of_memory_range &&
+        address - descriptor.start_of_memory_range <
+            descriptor.memory.data_size) {
+      return &(*regions_)[region_index];
+    }
+  }
+
   if (!range_map_->RetrieveRange(address, &region_index, NULL /* base */,
                                  NULL /* delta */, NULL /* size */)) {
     BPLOG(INFO) << "MinidumpMemoryList has no memory region at " <<
@@ -3569,6 +3823,7 @@ MinidumpMemoryRegion* MinidumpMemoryList::GetMemoryRegionForAddress(
     return NULL;
   }
 
+  last_region_index_.store(region_index, std::memory_order_relaxed);
   return GetMemoryRegionAtIndex(region_index);
 }
 
@@ -3605,6 +3860,451 @@ void MinidumpMemoryList::Print() {
 }
 
 
+//
+// MinidumpMemory64Region
+//
+
+
+MinidumpMemory64Region::MinidumpMemory64Region(Minidump* minidump)
+    : MinidumpObject(minidump),
+      base_(0),
+      size_(0),
+      rva_(0),
+      page_lock_(NULL),
+      pages_() {
+}
+
+
+MinidumpMemory64Region::~MinidumpMemory64Region() {
+}
+
+
+void MinidumpMemory64Region::SetRange(uint64_t base,
+                                      uint32_t size,
+                                      MDRVA64 rva) {
+  base_ = base;
+  size_ = size;
+  rva_ = rva;
+  pages_.clear();
+  valid_ = size <= numeric_limits<uint64_t>::max() - base &&
+           size <= numeric_limits<uint64_t>::max() - rva;
+}
+
+
+uint64_t MinidumpMemory64Region::GetBase() const {
+  if (!valid_) {
+    BPLOG(ERROR) << "Invalid MinidumpMemory64Region for GetBase";
+    return static_cast<uint64_t>(-1);
+  }
+
+  return base_;
+}
+
+
+uint32_t MinidumpMemory64Region::GetSize() const {
+  if (!valid_) {
+    BPLOG(ERROR) << "Invalid MinidumpMemory64Region for GetSize";
+    return 0;
+  }
+
+  return size_;
+}
+
+
+MDRVA64 MinidumpMemory64Region::GetRVA() const {
+  if (!valid_) {
+    BPLOG(ERROR) << "Invalid MinidumpMemory64Region for GetRVA";
+    return 0;
+  }
+
+  return rva_;
+}
+
+
+void MinidumpMemory64Region::FreeMemory() {
+  pages_.clear();
+}
+
+
+const uint8_t* MinidumpMemory64Region::GetPage(uint64_t page_index) const {
+  map<uint64_t, vector<uint8_t> >::const_iterator iterator =
+      pages_.find(page_index);
+  if (iterator != pages_.end()) {
+    return &iterator->second[0];
+  }
+
+  uint64_t offset = page_index * kPageSize;
+  uint32_t page_size = static_cast<uint32_t>(
+      std::min(static_cast<uint64_t>(kPageSize), size_ - offset));
+  vector<uint8_t> page(page_size);
+  if (!minidump_->SeekSet(rva_ + offset)) {
+    BPLOG(ERROR) << "MinidumpMemory64Region could not seek to page at " <<
+                    HexString(base_ + offset);
+    return NULL;
+  }
+  if (!minidump_->ReadBytes(&page[0], page_size)) {
+    BPLOG(ERROR) << "MinidumpMemory64Region could not read page at " <<
+                    HexString(base_ + offset);
+    return NULL;
+  }
+
+  vector<uint8_t>& cached_page = pages_[page_index];
+  cached_page.swap(page);
+  return &cached_page[0];
+}
+
+
+bool MinidumpMemory64Region::CopyBytes(uint64_t offset,
+                                       size_t size,
+                                       uint8_t* bytes) const {
+  if (minidump_->is_memory_backed()) {
+    const uint8_t* mapped = minidump_->GetMappedBytes(rva_ + offset, size);
+    if (!mapped) {
+      BPLOG(ERROR) << "MinidumpMemory64Region could not map memory at " <<
+                      HexString(base_ + offset);
+      return false;
+    }
+    memcpy(bytes, mapped, size);
+    return true;
+  }
+
+  std::unique_lock<std::mutex> lock;
+  if (page_lock_) {
+    lock = std::unique_lock<std::mutex>(*page_lock_);
+  }
+  while (size > 0) {
+    uint64_t page_index = offset / kPageSize;
+    uint32_t page_offset = static_cast<uint32_t>(offset % kPageSize);
+    size_t chunk_size =
+        std::min(size, static_cast<size_t>(kPageSize - page_offset));
+    const uint8_t* page = GetPage(page_index);
+    if (!page) {
+      // GetPage already logged a perfectly good message.
+      return false;
+    }
+    memcpy(bytes, page + page_offset, chunk_size);
+    bytes += chunk_size;
+    offset += chunk_size;
+    size -= chunk_size;
+  }
+
+  return true;
+}
+
+
+template<typename T>
+bool MinidumpMemory64Region::GetMemoryAtAddressInternal(uint64_t address,
+                                                        T*       value) const {
+  BPLOG_IF(ERROR, !value) << "MinidumpMemory64Region::"
+                             "GetMemoryAtAddressInternal requires |value|";
+  assert(value);
+  *value = 0;
+
+  if (!valid_) {
+    BPLOG(ERROR) << "Invalid MinidumpMemory64Region for "
+                    "GetMemoryAtAddressInternal";
+    return false;
+  }
+
+  // Common failure case
+  if (address < base_ ||
+      sizeof(T) > numeric_limits<uint64_t>::max() - address ||
+      address + sizeof(T) > base_ + size_) {
+    BPLOG(INFO) << "MinidumpMemory64Region request out of range: " <<
+                    HexString(address) << "+" << sizeof(T) << "/" <<
+                    HexString(base_) << "+" << HexString(size_);
+    return false;
+  }
+
+  if (!CopyBytes(address - base_, sizeof(T),
+                 reinterpret_cast<uint8_t*>(value))) {
+    return false;
+  }
+
+  if (minidump_->swap())
+    Swap(value);
+
+  return true;
+}
+
+
+bool MinidumpMemory64Region::GetMemoryAtAddress(uint64_t  address,
+                                                uint8_t*  value) const {
+  return GetMemoryAtAddressInternal(address, value);
+}
+
+
+bool MinidumpMemory64Region::GetMemoryAtAddress(uint64_t  address,
+                                                uint16_t* value) const {
+  return GetMemoryAtAddressInternal(address, value);
+}
+
+
+bool MinidumpMemory64Region::GetMemoryAtAddress(uint64_t  address,
+                                                uint32_t* value) const {
+  return GetMemoryAtAddressInternal(address, value);
+}
+
+
+bool MinidumpMemory64Region::GetMemoryAtAddress(uint64_t  address,
+                                                uint64_t* value) const {
+  return GetMemoryAtAddressInternal(address, value);
+}
+
+
+bool MinidumpMemory64Region::ByteSwapped() const {
+  return valid_ && minidump_->swap();
+}
+
+
+const uint8_t* MinidumpMemory64Region::GetSpanAtOffset(uint64_t offset,
+                                                       size_t size) const {
+  if (!valid_)
+    return NULL;
+  if (minidump_->is_memory_backed())
+    return minidump_->GetMappedBytes(rva_ + offset, size);
+
+  uint64_t page_index = offset / kPageSize;
+  if ((offset + size - 1) / kPageSize != page_index)
+    return NULL;
+  std::unique_lock<std::mutex> lock;
+  if (page_lock_) {
+    lock = std::unique_lock<std::mutex>(*page_lock_);
+  }
+  // Cached pages stay put until FreeMemory.
+  const uint8_t* page = GetPage(page_index);
+  return page ? page + offset % kPageSize : NULL;
+}
+
+
+bool MinidumpMemory64Region::CopyOutAtOffset(uint64_t offset,
+                                             size_t size,
+                                             uint8_t* bytes) const {
+  return valid_ && CopyBytes(offset, size, bytes);
+}
+
+
+void MinidumpMemory64Region::Print() const {
+  if (!valid_) {
+    BPLOG(ERROR) << "MinidumpMemory64Region cannot print invalid data";
+    return;
+  }
+
+  printf("  start_of_memory_range = 0x%" PRIx64 "\n", base_);
+  printf("  data_size             = 0x%x\n", size_);
+  printf("  rva                   = 0x%" PRIx64 "\n", rva_);
+}
+
+
+//
+// MinidumpMemory64List
+//
+
+
+uint32_t MinidumpMemory64List::max_regions_ = 1024 * 1024;
+
+
+MinidumpMemory64List::MinidumpMemory64List(Minidump* minidump)
+    : MinidumpStream(minidump),
+      range_map_(new RangeMap<uint64_t, unsigned int>()),
+      last_region_index_(0),
+      regions_() {
+}
+
+
+MinidumpMemory64List::~MinidumpMemory64List() {
+  delete range_map_;
+}
+
+
+bool MinidumpMemory64List::Read(uint32_t expected_size) {
+  // Invalidate cached data.
+  regions_.clear();
+  range_map_->Clear();
+  last_region_index_ = 0;
+
+  valid_ = false;
+
+  uint64_t region_count;
+  MDRVA64 base_rva;
+  if (expected_size < MDRawMemory64List_minsize) {
+    BPLOG(ERROR) << "MinidumpMemory64List header size mismatch, " <<
+                    expected_size << " < " << MDRawMemory64List_minsize;
+    return false;
+  }
+  if (!minidump_->ReadBytes(&region_count, sizeof(region_count)) ||
+      !minidump_->ReadBytes(&base_rva, sizeof(base_rva))) {
+    BPLOG(ERROR) << "MinidumpMemory64List could not read header";
+    return false;
+  }
+
+  if (minidump_->swap()) {
+    Swap(&region_count);
+    Swap(&base_rva);
+  }
+
+  if (region_count > max_regions_) {
+    BPLOG(ERROR) << "MinidumpMemory64List count " << region_count <<
+                    " exceeds maximum " << max_regions_;
+    return false;
+  }
+
+  if (expected_size != MDRawMemory64List_minsize +
+                       region_count * sizeof(MDMemoryDescriptor64)) {
+    BPLOG(ERROR) << "MinidumpMemory64List size mismatch, " << expected_size <<
+                    " != " << MDRawMemory64List_minsize +
+                    region_count * sizeof(MDMemoryDescriptor64);
+    return false;
+  }
+
+  if (region_count == 0) {
+    valid_ = true;
+    return true;
+  }
+
+  // Read the entire descriptor table in one fell swoop, instead of reading
+  // one entry at a time in the loop.  Only the table is read: the memory
+  // itself is read by the regions, on demand.
+  vector<MDMemoryDescriptor64> descriptors(region_count);
+  if (!minidump_->ReadBytes(&descriptors[0],
+                            sizeof(MDMemoryDescriptor64) * region_count)) {
+    BPLOG(ERROR) << "MinidumpMemory64List could not read memory region list";
+    return false;
+  }
+
+  MemoryRegions regions;
+  regions.reserve(region_count);
+  MDRVA64 rva = base_rva;
+  for (uint64_t region_index = 0;
+       region_index < region_count;
+       ++region_index) {
+    MDMemoryDescriptor64* descriptor = &descriptors[region_index];
+
+    if (minidump_->swap()) {
+      Swap(&descriptor->start_of_memory_range);
+      Swap(&descriptor->data_size);
+    }
+
+    uint64_t base_address = descriptor->start_of_memory_range;
+    uint64_t region_size = descriptor->data_size;
+
+    // Check for base + size and rva + size overflow or undersize.
+    if (region_size == 0 ||
+        region_size > numeric_limits<uint64_t>::max() - base_address ||
+        region_size > numeric_limits<uint64_t>::max() - rva) {
+      BPLOG(ERROR) << "MinidumpMemory64List has a memory region problem, " <<
+                      " region " << region_index << "/" << region_count <<
+                      ", " << HexString(base_address) << "+" <<
+                      HexString(region_size);
+      return false;
+    }
+
+    // Split regions that don't fit in a MemoryRegion on page boundaries.
+    while (region_size > 0) {
+      uint32_t piece_size = static_cast<uint32_t>(std::min(
+          region_size,
+          static_cast<uint64_t>(numeric_limits<uint32_t>::max() &
+                                ~(MinidumpMemory64Region::kPageSize - 1))));
+
+      if (regions.size() >= max_regions_) {
+        BPLOG(ERROR) << "MinidumpMemory64List region count exceeds maximum " <<
+                        max_regions_;
+        return false;
+      }
+
+      unsigned int index = static_cast<unsigned int>(regions.size());
+      if (!range_map_->StoreRange(base_address, piece_size, index)) {
+        BPLOG(ERROR) << "MinidumpMemory64List could not store memory region " <<
+                        region_index << "/" << region_count << ", " <<
+                        HexString(base_address) << "+" <<
+                        HexString(piece_size);
+        return false;
+      }
+
+      regions.push_back(MinidumpMemory64Region(minidump_));
+      regions.back().SetRange(base_address, piece_size, rva);
+      regions.back().page_lock_ = &page_lock_;
+
+      base_address += piece_size;
+      rva += piece_size;
+      region_size -= piece_size;
+    }
+  }
+
+  regions_.swap(regions);
+  range_map_->Freeze();
+
+  valid_ = true;
+  return true;
+}
+
+
+MinidumpMemory64Region* MinidumpMemory64List::GetMemoryRegionAtIndex(
+      unsigned int index) {
+  if (!valid_) {
+    BPLOG(ERROR) << "Invalid MinidumpMemory64List for GetMemoryRegionAtIndex";
+    return NULL;
+  }
+
+  if (index >= regions_.size()) {
+    BPLOG(ERROR) << "MinidumpMemory64List index out of range: " <<
+                    index << "/" << regions_.size();
+    return NULL;
+  }
+
+  return &regions_[index];
+}
+
+
+MinidumpMemory64Region* MinidumpMemory64List::GetMemoryRegionForAddress(
+    uint64_t address) {
+  if (!valid_) {
+    BPLOG(ERROR) << "Invalid MinidumpMemory64List for "
+                    "GetMemoryRegionForAddress";
+    return NULL;
+  }
+
+  unsigned int region_index =
+      last_region_index_.load(std::memory_order_relaxed);
+  if (region_index < regions_.size()) {
+    const MinidumpMemory64Region& region = regions_[region_index];
+    if (address >= region.base_ && address - region.base_ < region.size_)
+      return &regions_[region_index];
+  }
+
+  if (!range_map_->RetrieveRange(address, &region_index, NULL /* base */,
+                                 NULL /* delta */, NULL /* size */)) {
+    BPLOG(INFO) << "MinidumpMemory64List has no memory region at " <<
+                   HexString(address);
+    return NULL;
+  }
+
+  last_region_index_.store(region_index, std::memory_order_relaxed);
+  return GetMemoryRegionAtIndex(region_index);
+}
+
+
+void MinidumpMemory64List::Print() {
+  if (!valid_) {
+    BPLOG(ERROR) << "MinidumpMemory64List cannot print invalid data";
+    return;
+  }
+
+  printf("MinidumpMemory64List\n");
+  printf("  region_count = %zu\n", regions_.size());
+  printf("\n");
+
+  for (unsigned int region_index = 0;
+       region_index < regions_.size();
+       ++region_index) {
+    printf("region[%d]\n", region_index);
+    printf("MDMemoryDescriptor64\n");
+    regions_[region_index].Print();
+    printf("\n");
+  }
+}
+
+
 //
 // MinidumpException
 //
@@ -4331,6 +5031,7 @@ bool MinidumpUnloadedModuleList::Read(uint32_t expected_size) {
   delete unloaded_modules_;
   unloaded_modules_ = NULL;
   module_count_ = 0;
+  shared_copy_.reset();
 
   valid_ = false;
 
@@ -4498,6 +5199,13 @@ const CodeModules* MinidumpUnloadedModuleList::Copy() const {
   return new BasicCodeModules(this, range_map_->GetMergeStrategy());
 }
 
+std::shared_ptr<const CodeModules>
+MinidumpUnloadedModuleList::GetSharedCopy() const {
+  if (!shared_copy_)
+    shared_copy_.reset(Copy());
+  return shared_copy_;
+}
+
 vector<linked_ptr<const CodeModule>>
 MinidumpUnloadedModuleList::GetShrunkRangeModules() const {
   return vector<linked_ptr<const CodeModule> >();
@@ -4969,14 +5677,12 @@ void MinidumpMemoryInfo::Print() {
 
 MinidumpMemoryInfoList::MinidumpMemoryInfoList(Minidump* minidump)
     : MinidumpStream(minidump),
-      range_map_(new RangeMap<uint64_t, unsigned int>()),
       infos_(NULL),
       info_count_(0) {
 }
 
 
 MinidumpMemoryInfoList::~MinidumpMemoryInfoList() {
-  delete range_map_;
   delete infos_;
 }
 
@@ -4985,7 +5691,7 @@ bool MinidumpMemoryInfoList::Read(uint32_t expected_size) {
   // Invalidate cached data.
   delete infos_;
   infos_ = NULL;
-  range_map_->Clear();
+  address_index_.clear();
   info_count_ = 0;
 
   valid_ = false;
@@ -5071,8 +5777,9 @@ bool MinidumpMemoryInfoList::Read(uint32_t expected_size) {
 
       uint64_t base_address = info->GetBase();
       uint64_t region_size = info->GetSize();
+      uint64_t high_address = base_address + region_size - 1;
 
-      if (!range_map_->StoreRange(base_address, region_size, index)) {
+      if (region_size == 0 || high_address < base_address) {
         BPLOG(ERROR) << "MinidumpMemoryInfoList could not store"
                         " memory region " <<
                         index << "/" << header.number_of_entries << ", " <<
@@ -5080,6 +5787,25 @@ bool MinidumpMemoryInfoList::Read(uint32_t expected_size) {
                         HexString(region_size);
         return false;
       }
+      address_index_.push_back(std::make_pair(high_address, index));
+    }
+
+    // Regions are usually listed in address order already, so this is cheap.
+    std::sort(address_index_.begin(), address_index_.end());
+    for (size_t i = 1; i < address_index_.size(); ++i) {
+      const MinidumpMemoryInfo& info = (*infos)[address_index_[i].second];
+      if (info.GetBase() <= address_index_[i - 1].first) {
+        BPLOG(ERROR) << "MinidumpMemoryInfoList could not store"
+                        " memory region " <<
+                        address_index_[i].second << "/" <<
+                        header.number_of_entries << ", " <<
+                        HexString(info.GetBase()) << "+" <<
+                        HexString(info.GetSize()) <<
+                        ", which overlaps region " <<
+                        address_index_[i - 1].second;
+        address_index_.clear();
+        return false;
+      }
     }
 
     infos_ = infos.release();
@@ -5118,8 +5844,8 @@ const MinidumpMemoryInfo* MinidumpMemoryInfoList::GetMemoryInfoForAddress(
   }
 
   unsigned int info_index;
-  if (!range_map_->RetrieveRange(address, &info_index, NULL /* base */,
-                                 NULL /* delta */, NULL /* size */)) {
+  if (!LookUpAddressIndex(address_index_, address, &info_index) ||
+      (*infos_)[info_index].GetBase() > address) {
     BPLOG(INFO) << "MinidumpMemoryInfoList has no memory info at " <<
                    HexString(address);
     return NULL;
@@ -5171,7 +5897,8 @@ void MinidumpLinuxMaps::Print() const {
 MinidumpLinuxMapsList::MinidumpLinuxMapsList(Minidump* minidump)
     : MinidumpStream(minidump),
       maps_(NULL),
-      maps_count_(0) {
+      maps_count_(0),
+      overlapping_maps_(false) {
 }
 
 MinidumpLinuxMapsList::~MinidumpLinuxMapsList() {
@@ -5190,13 +5917,21 @@ const MinidumpLinuxMaps* MinidumpLinuxMapsList::GetLinuxMapsForAddress(
     return NULL;
   }
 
-  // Search every memory mapping.
-  for (unsigned int index = 0; index < maps_count_; index++) {
-    // Check if address is within bounds of the current memory region.
-    if ((*maps_)[index]->GetBase() <= address &&
-        (*maps_)[index]->GetBase() + (*maps_)[index]->GetSize() > address) {
+  unsigned int index;
+  if (!overlapping_maps_) {
+    if (LookUpAddressIndex(address_index_, address, &index) &&
+        (*maps_)[index]->GetBase() <= address) {
       return (*maps_)[index];
     }
+  } else {
+    // Search every memory mapping, so that the first one listed wins.
+    for (index = 0; index < maps_count_; index++) {
+      // Check if address is within bounds of the current memory region.
+      if ((*maps_)[index]->GetBase() <= address &&
+          (*maps_)[index]->GetBase() + (*maps_)[index]->GetSize() > address) {
+        return (*maps_)[index];
+      }
+    }
   }
 
   // No mapping encloses the memory address.
@@ -5233,6 +5968,8 @@ bool MinidumpLinuxMapsList::Read(uint32_t expected_size) {
   }
   maps_ = NULL;
   maps_count_ = 0;
+  address_index_.clear();
+  overlapping_maps_ = false;
 
   valid_ = false;
 
@@ -5250,14 +5987,12 @@ bool MinidumpLinuxMapsList::Read(uint32_t expected_size) {
     return false;
   }
 
-  // Create a vector to read stream data. The vector needs to have
-  // at least enough capacity to read all the data.
-  vector<char> mapping_bytes(length);
-  if (!minidump_->ReadBytes(&mapping_bytes[0], length)) {
+  // Read the stream data straight into the string that gets parsed.
+  string map_string(length, '\0');
+  if (length && !minidump_->ReadBytes(&map_string[0], length)) {
     BPLOG(ERROR) << "MinidumpLinuxMapsList failed to read bytes";
     return false;
   }
-  string map_string(mapping_bytes.begin(), mapping_bytes.end());
   vector<MappedMemoryRegion> all_regions;
 
   // Parse string into mapping data.
@@ -5266,15 +6001,35 @@ bool MinidumpLinuxMapsList::Read(uint32_t expected_size) {
   }
 
   scoped_ptr<MinidumpLinuxMappings> maps(new MinidumpLinuxMappings());
+  maps->reserve(all_regions.size());
 
-  // Push mapping data into wrapper classes.
+  // Push mapping data into wrapper classes.  The index below only needs the
+  // addresses, so the regions' strings can be moved rather than copied.
   for (size_t i = 0; i < all_regions.size(); i++) {
     scoped_ptr<MinidumpLinuxMaps> ele(new MinidumpLinuxMaps(minidump_));
-    ele->region_ = all_regions[i];
+    ele->region_ = std::move(all_regions[i]);
     ele->valid_ = true;
     maps->push_back(ele.release());
   }
 
+  // Index the mappings by address.  /proc/self/maps lists them in address
+  // order without overlaps; GetLinuxMapsForAddress falls back to a linear
+  // search if a malformed stream does not.
+  for (size_t i = 0; i < all_regions.size(); i++) {
+    if (all_regions[i].end > all_regions[i].start) {
+      address_index_.push_back(std::make_pair(all_regions[i].end - 1,
+                                              static_cast<unsigned int>(i)));
+    }
+  }
+  std::sort(address_index_.begin(), address_index_.end());
+  for (size_t i = 1; i < address_index_.size(); i++) {
+    if (all_regions[address_index_[i].second].start <=
+        address_index_[i - 1].first) {
+      overlapping_maps_ = true;
+      break;
+    }
+  }
+
   // Set instance variables.
   maps_ = maps.release();
   maps_count_ = static_cast<uint32_t>(maps_->size());
@@ -5544,6 +6299,159 @@ void MinidumpCrashpadInfo::Print() {
 }
 
 
+//
+// MinidumpDumpTiming
+//
+
+
+MinidumpDumpTiming::MinidumpDumpTiming(Minidump* minidump)
+    : MinidumpStream(minidump),
+      phases_() {
+}
+
+
+bool MinidumpDumpTiming::Read(uint32_t expected_size) {
+  phases_.clear();
+  valid_ = false;
+
+  MDRawDumpTimingList header;
+  if (expected_size < sizeof(MDRawDumpTimingList)) {
+    BPLOG(ERROR) << "MinidumpDumpTiming header size mismatch, " <<
+                    expected_size << " < " << sizeof(MDRawDumpTimingList);
+    return false;
+  }
+  if (!minidump_->ReadBytes(&header, sizeof(header))) {
+    BPLOG(ERROR) << "MinidumpDumpTiming could not read header";
+    return false;
+  }
+
+  if (minidump_->swap()) {
+    Swap(&header.size_of_header);
+    Swap(&header.size_of_entry);
+    Swap(&header.number_of_entries);
+  }
+
+  if (header.size_of_header != sizeof(MDRawDumpTimingList) ||
+      header.size_of_entry != sizeof(MDRawDumpPhaseTiming)) {
+    BPLOG(ERROR) << "MinidumpDumpTiming header or entry size mismatch, " <<
+                    header.size_of_header << ", " << header.size_of_entry;
+    return false;
+  }
+
+  // Each phase appears at most once.
+  if (header.number_of_entries > MD_DUMP_PHASE_COUNT ||
+      expected_size != sizeof(MDRawDumpTimingList) +
+                       header.number_of_entries *
+                           sizeof(MDRawDumpPhaseTiming)) {
+    BPLOG(ERROR) << "MinidumpDumpTiming size mismatch, " << expected_size <<
+                    " for " << header.number_of_entries << " entries";
+    return false;
+  }
+
+  phases_.resize(header.number_of_entries);
+  if (!phases_.empty() &&
+      !minidump_->ReadBytes(&phases_[0],
+                            phases_.size() * sizeof(MDRawDumpPhaseTiming))) {
+    BPLOG(ERROR) << "MinidumpDumpTiming could not read entries";
+    phases_.clear();
+    return false;
+  }
+
+  if (minidump_->swap()) {
+    for (MDRawDumpPhaseTiming& phase : phases_) {
+      Swap(&phase.phase);
+      Swap(&phase.count);
+      Swap(&phase.bytes);
+      Swap(&phase.start_time);
+      Swap(&phase.duration);
+    }
+  }
+
+  valid_ = true;
+  return true;
+}
+
+
+void MinidumpDumpTiming::Print() {
+  if (!valid_) {
+    BPLOG(ERROR) << "MinidumpDumpTiming cannot print invalid data";
+    return;
+  }
+
+  printf("MDRawDumpTimingList\n");
+  printf("  number_of_entries = %zu\n", phases_.size());
+  for (size_t i = 0; i < phases_.size(); ++i) {
+    const MDRawDumpPhaseTiming& phase = phases_[i];
+    printf("  phase[%zu] = %s (%u)\n", i, PhaseName(phase.phase),
+           phase.phase);
+    printf("    count      = %u\n", phase.count);
+    printf("    bytes      = %" PRIu64 "\n", phase.bytes);
+    printf("    start_time = %" PRIu64 " ns\n", phase.start_time);
+    printf("    duration   = %" PRIu64 " ns\n", phase.duration);
+  }
+
+  printf("\n");
+}
+
+
+//
+// MinidumpCrashSignature
+//
+
+
+MinidumpCrashSignature::MinidumpCrashSignature(Minidump* minidump)
+    : MinidumpStream(minidump),
+      crash_signature_() {
+}
+
+
+bool MinidumpCrashSignature::Read(uint32_t expected_size) {
+  valid_ = false;
+
+  if (expected_size != sizeof(crash_signature_)) {
+    BPLOG(ERROR) << "MinidumpCrashSignature size mismatch, " <<
+                    expected_size << " != " << sizeof(crash_signature_);
+    return false;
+  }
+  if (!minidump_->ReadBytes(&crash_signature_, sizeof(crash_signature_))) {
+    BPLOG(ERROR) << "MinidumpCrashSignature cannot read signature";
+    return false;
+  }
+
+  if (minidump_->swap()) {
+    Swap(&crash_signature_.signature);
+    Swap(&crash_signature_.frame_count);
+    Swap(&crash_signature_.reserved);
+  }
+
+  valid_ = true;
+  return true;
+}
+
+
+string MinidumpCrashSignature::SignatureString() const {
+  if (!valid_)
+    return string();
+  char signature[17];
+  snprintf(signature, sizeof(signature), "%016" PRIx64,
+           crash_signature_.signature);
+  return signature;
+}
+
+
+void MinidumpCrashSignature::Print() {
+  if (!valid_) {
+    BPLOG(ERROR) << "MinidumpCrashSignature cannot print invalid data";
+    return;
+  }
+
+  printf("MDRawCrashSignature\n");
+  printf("  signature   = 0x%016" PRIx64 "\n", crash_signature_.signature);
+  printf("  frame_count = %u\n", crash_signature_.frame_count);
+  printf("\n");
+}
+
+
 //
 // Minidump
 //
@@ -5559,6 +6467,10 @@ Minidump::Minidump(const string& path, bool hexdump, unsigned int hexdump_width)
       stream_map_(new MinidumpStreamMap()),
       path_(path),
       stream_(NULL),
+      memory_backed_(false),
+      contents_(NULL),
+      contents_size_(0),
+      contents_position_(0),
       swap_(false),
       is_big_endian_(false),
       valid_(false),
@@ -5572,6 +6484,34 @@ Minidump::Minidump(istream& stream)
       stream_map_(new MinidumpStreamMap()),
       path_(),
       stream_(&stream),
+      memory_backed_(false),
+      contents_(NULL),
+      contents_size_(0),
+      contents_position_(0),
+      swap_(false),
+      is_big_endian_(false),
+      valid_(false),
+      hexdump_(false),
+      hexdump_width_(0) {
+}
+
+#if defined(__linux__)
+Minidump::Minidump(const MemoryMappedFile& mapped_file)
+    : Minidump(static_cast<const uint8_t*>(mapped_file.data()),
+               mapped_file.size()) {
+}
+#endif  // __linux__
+
+Minidump::Minidump(const uint8_t* data, size_t size)
+    : header_(),
+      directory_(NULL),
+      stream_map_(new MinidumpStreamMap()),
+      path_(),
+      stream_(NULL),
+      memory_backed_(true),
+      contents_(data),
+      contents_size_(size),
+      contents_position_(0),
       swap_(false),
       is_big_endian_(false),
       valid_(false),
@@ -5580,7 +6520,7 @@ Minidump::Minidump(istream& stream)
 }
 
 Minidump::~Minidump() {
-  if (stream_) {
+  if (stream_ || memory_backed_) {
     BPLOG(INFO) << "Minidump closing minidump";
   }
   if (!path_.empty()) {
@@ -5592,12 +6532,31 @@ Minidump::~Minidump() {
 
 
 bool Minidump::Open() {
+  if (memory_backed_) {
+    bool swap;
+    if (IsCompressedMinidump(contents_, contents_size_, &swap)) {
+      if (!DecompressMinidump(contents_, contents_size_, swap,
+                              &decompressed_)) {
+        BPLOG(ERROR) << "Minidump could not decompress minidump";
+        return false;
+      }
+      contents_ = decompressed_.empty() ? NULL : &decompressed_[0];
+      contents_size_ = decompressed_.size();
+    }
+
+    // There is nothing to open.  Rewind to the beginning, as for a file that
+    // is already open.
+    return SeekSet(0);
+  }
+
   if (stream_ != NULL) {
     BPLOG(INFO) << "Minidump reopening minidump " << path_;
 
     // The file is already open.  Seek to the beginning, which is the position
     // the file would be at if it were opened anew.
-    return SeekSet(0);
+    if (!SeekSet(0))
+      return false;
+    return DecompressStream();
   }
 
   stream_ = new ifstream(path_.c_str(), std::ios::in | std::ios::binary);
@@ -5610,6 +6569,35 @@ bool Minidump::Open() {
   }
 
   BPLOG(INFO) << "Minidump opened minidump " << path_;
+  return DecompressStream();
+}
+
+bool Minidump::DecompressStream() {
+  uint8_t magic[sizeof(kCompressedMinidumpMagic)];
+  stream_->read(reinterpret_cast<char*>(magic), sizeof(magic));
+  const size_t magic_size = stream_->gcount();
+  stream_->clear();
+  bool swap;
+  if (!IsCompressedMinidump(magic, magic_size, &swap))
+    return SeekSet(0);
+
+  if (!SeekSet(0))
+    return false;
+  const vector<uint8_t> compressed((std::istreambuf_iterator<char>(*stream_)),
+                                   std::istreambuf_iterator<char>());
+  if (!DecompressMinidump(&compressed[0], compressed.size(), swap,
+                          &decompressed_)) {
+    BPLOG(ERROR) << "Minidump could not decompress minidump " << path_;
+    return false;
+  }
+
+  // Read the minidump from memory from now on.
+  memory_backed_ = true;
+  contents_ = decompressed_.empty() ? NULL : &decompressed_[0];
+  contents_size_ = decompressed_.size();
+  contents_position_ = 0;
+  BPLOG(INFO) << "Minidump decompressed minidump " << path_ << " to " <<
+                 contents_size_ << " bytes";
   return true;
 }
 
@@ -5808,11 +6796,14 @@ bool Minidump::Read() {
         case MD_THREAD_NAME_LIST_STREAM:
         case MD_MODULE_LIST_STREAM:
         case MD_MEMORY_LIST_STREAM:
+        case MD_MEMORY_64_LIST_STREAM:
         case MD_EXCEPTION_STREAM:
         case MD_SYSTEM_INFO_STREAM:
         case MD_MISC_INFO_STREAM:
         case MD_BREAKPAD_INFO_STREAM:
-        case MD_CRASHPAD_INFO_STREAM: {
+        case MD_CRASHPAD_INFO_STREAM:
+        case MD_DUMP_TIMING_STREAM:
+        case MD_CRASH_SIGNATURE_STREAM: {
           if (stream_map_->find(stream_type) != stream_map_->end()) {
             // Another stream with this type was already found.  A minidump
             // file should contain at most one of each of these stream types.
@@ -5861,6 +6852,12 @@ MinidumpMemoryList* Minidump::GetMemoryList() {
 }
 
 
+MinidumpMemory64List* Minidump::GetMemory64List() {
+  MinidumpMemory64List* memory64_list;
+  return GetStream(&memory64_list);
+}
+
+
 MinidumpException* Minidump::GetException() {
   MinidumpException* exception;
   return GetStream(&exception);
@@ -5937,6 +6934,16 @@ MinidumpCrashpadInfo* Minidump::GetCrashpadInfo() {
   return GetStream(&crashpad_info);
 }
 
+MinidumpDumpTiming* Minidump::GetDumpTiming() {
+  MinidumpDumpTiming* dump_timing;
+  return GetStream(&dump_timing);
+}
+
+MinidumpCrashSignature* Minidump::GetCrashSignature() {
+  MinidumpCrashSignature* crash_signature;
+  return GetStream(&crash_signature);
+}
+
 static const char* get_stream_name(uint32_t stream_type) {
   switch (stream_type) {
   case MD_UNUSED_STREAM:
@@ -6009,8 +7016,16 @@ static const char* get_stream_name(uint32_t stream_type) {
     return "MD_LINUX_MAPS";
   case MD_LINUX_DSO_DEBUG:
     return "MD_LINUX_DSO_DEBUG";
+  case MD_LINUX_INCONSISTENT_MEMORY:
+    return "MD_LINUX_INCONSISTENT_MEMORY";
   case MD_CRASHPAD_INFO_STREAM:
     return "MD_CRASHPAD_INFO_STREAM";
+  case MD_DUMP_TIMING_STREAM:
+    return "MD_DUMP_TIMING_STREAM";
+  case MD_CRASH_SIGNATURE_STREAM:
+    return "MD_CRASH_SIGNATURE_STREAM";
+  case MD_SNAPSHOT_SERIES_STREAM:
+    return "MD_SNAPSHOT_SERIES_STREAM";
   default:
     return "unknown";
   }
@@ -6083,6 +7098,20 @@ const MDRawDirectory* Minidump::GetDirectoryEntryAtIndex(unsigned int index)
 bool Minidump::ReadBytes(void* bytes, size_t count) {
   // Can't check valid_ because Read needs to call this method before
   // validity can be determined.
+  if (memory_backed_) {
+    const uint8_t* source = GetMappedBytes(contents_position_, count);
+    if (!source) {
+      BPLOG(ERROR) << "ReadBytes: read " << count << " bytes at " <<
+                      contents_position_ << " beyond end of " <<
+                      contents_size_;
+      return false;
+    }
+    if (count)
+      memcpy(bytes, source, count);
+    contents_position_ += count;
+    return true;
+  }
+
   if (!stream_) {
     return false;
   }
@@ -6115,6 +7144,16 @@ bool Minidump::ReadBytes(void* bytes, size_t count) {
 bool Minidump::SeekSet(off_t offset) {
   // Can't check valid_ because Read needs to call this method before
   // validity can be determined.
+  if (memory_backed_) {
+    if (offset < 0 || static_cast<uint64_t>(offset) > contents_size_) {
+      BPLOG(ERROR) << "SeekSet: offset " << offset << " beyond end of " <<
+                      contents_size_;
+      return false;
+    }
+    contents_position_ = offset;
+    return true;
+  }
+
   if (!stream_) {
     return false;
   }
@@ -6129,6 +7168,10 @@ bool Minidump::SeekSet(off_t offset) {
 }
 
 off_t Minidump::Tell() {
+  if (valid_ && memory_backed_) {
+    return contents_position_;
+  }
+
   if (!valid_ || !stream_) {
     return (off_t)-1;
   }
@@ -6145,6 +7188,17 @@ off_t Minidump::Tell() {
 }
 
 
+const uint8_t* Minidump::GetMappedBytes(off_t offset, size_t count) const {
+  if (!memory_backed_ || offset < 0 ||
+      static_cast<uint64_t>(offset) > contents_size_ ||
+      count > contents_size_ - static_cast<uint64_t>(offset)) {
+    return NULL;
+  }
+
+  return contents_ + offset;
+}
+
+
 string* Minidump::ReadString(off_t offset) {
   if (!valid_) {
     BPLOG(ERROR) << "Invalid Minidump for ReadString";
@@ -6178,6 +7232,18 @@ string* Minidump::ReadString(off_t offset) {
     return NULL;
   }
 
+  // A string in a memory-backed minidump is converted where it lies, unless
+  // it isn't aligned for reading as UTF-16.
+  if (memory_backed_) {
+    const uint8_t* mapped = GetMappedBytes(contents_position_, bytes);
+    if (mapped &&
+        reinterpret_cast<uintptr_t>(mapped) % sizeof(uint16_t) == 0) {
+      contents_position_ += bytes;
+      return UTF16ToUTF8(reinterpret_cast<const uint16_t*>(mapped),
+                         utf16_words, swap_);
+    }
+  }
+
   vector<uint16_t> string_utf16(utf16_words);
 
   if (utf16_words) {
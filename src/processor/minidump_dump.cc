@@ -35,10 +35,17 @@
 #include <config.h>  // Must come first
 #endif
 
+#include <getopt.h>
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
 
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include "common/linux/memory_mapped_file.h"
+#endif  // __linux__
 #include "common/path_helper.h"
 #include "common/scoped_ptr.h"
 #include "google_breakpad/processor/minidump.h"
@@ -46,28 +53,115 @@
 
 namespace {
 
+#if defined(__linux__)
+using google_breakpad::MemoryMappedFile;
+#endif  // __linux__
 using google_breakpad::Minidump;
+using google_breakpad::MinidumpThread;
 using google_breakpad::MinidumpThreadList;
+using google_breakpad::MinidumpThreadName;
 using google_breakpad::MinidumpThreadNameList;
+using google_breakpad::MinidumpModule;
 using google_breakpad::MinidumpModuleList;
 using google_breakpad::MinidumpMemoryInfoList;
+using google_breakpad::MinidumpMemory64List;
+using google_breakpad::MinidumpMemory64Region;
 using google_breakpad::MinidumpMemoryList;
+using google_breakpad::MinidumpMemoryRegion;
 using google_breakpad::MinidumpException;
 using google_breakpad::MinidumpAssertion;
 using google_breakpad::MinidumpSystemInfo;
 using google_breakpad::MinidumpMiscInfo;
 using google_breakpad::MinidumpBreakpadInfo;
 using google_breakpad::MinidumpCrashpadInfo;
+using google_breakpad::MinidumpCrashSignature;
+using google_breakpad::MinidumpDumpTiming;
+using google_breakpad::scoped_ptr;
+
+// The streams that can be selected with --stream.
+enum Stream {
+  kStreamHeader = 1 << 0,
+  kStreamThreads = 1 << 1,
+  kStreamThreadNames = 1 << 2,
+  kStreamModules = 1 << 3,
+  kStreamMemory = 1 << 4,
+  kStreamMemory64 = 1 << 5,
+  kStreamException = 1 << 6,
+  kStreamAssertion = 1 << 7,
+  kStreamSystemInfo = 1 << 8,
+  kStreamMiscInfo = 1 << 9,
+  kStreamBreakpadInfo = 1 << 10,
+  kStreamMemoryInfo = 1 << 11,
+  kStreamCrashpadInfo = 1 << 12,
+  kStreamDumpTiming = 1 << 13,
+  kStreamLinux = 1 << 14,
+  kStreamCrashSignature = 1 << 15,
+  kStreamAll = (1 << 16) - 1
+};
+
+const struct {
+  const char* name;
+  unsigned int stream;
+} kStreamNames[] = {
+  {"header", kStreamHeader},
+  {"threads", kStreamThreads},
+  {"thread_names", kStreamThreadNames},
+  {"modules", kStreamModules},
+  {"memory", kStreamMemory},
+  {"memory64", kStreamMemory64},
+  {"exception", kStreamException},
+  {"assertion", kStreamAssertion},
+  {"system_info", kStreamSystemInfo},
+  {"misc_info", kStreamMiscInfo},
+  {"breakpad_info", kStreamBreakpadInfo},
+  {"memory_info", kStreamMemoryInfo},
+  {"crashpad_info", kStreamCrashpadInfo},
+  {"dump_timing", kStreamDumpTiming},
+  {"linux", kStreamLinux},
+  {"crash_signature", kStreamCrashSignature},
+};
 
 struct Options {
   Options()
-      : minidumpPath(), hexdump(false), hexdump_width(16) {}
+      : minidumpPath(), hexdump(false), hexdump_width(16),
+        streams(kStreamAll), json(false), mmap(false) {}
 
   string minidumpPath;
   bool hexdump;
   unsigned int hexdump_width;
+  // The Stream bits of the streams to print.
+  unsigned int streams;
+  bool json;
+  bool mmap;
 };
 
+// Sets streams to the Stream bits of the comma-separated stream names in
+// list.  Returns false if a name is unknown.
+static bool ParseStreamList(const char* list, unsigned int* streams) {
+  *streams = 0;
+  while (*list) {
+    size_t length = strcspn(list, ",");
+    bool found = false;
+    for (const auto& stream_name : kStreamNames) {
+      if (strlen(stream_name.name) == length &&
+          strncmp(stream_name.name, list, length) == 0) {
+        *streams |= stream_name.stream;
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      fprintf(stderr, "Unknown stream %.*s\n", static_cast<int>(length),
+              list);
+      return false;
+    }
+    list += length;
+    if (*list == ',')
+      ++list;
+  }
+  return *streams != 0;
+}
+
 static void DumpRawStream(Minidump *minidump,
                           uint32_t stream_type,
                           const char *stream_name,
@@ -107,126 +201,491 @@ static void DumpRawStream(Minidump *minidump,
   printf("\n\n");
 }
 
-static bool PrintMinidumpDump(const Options& options) {
-  Minidump minidump(options.minidumpPath,
-                    options.hexdump);
-  if (!minidump.Read()) {
-    BPLOG(ERROR) << "minidump.Read() failed";
-    return false;
+// Prints the streams of minidump in text, and returns the number of
+// streams that were expected and could not be read.
+static int PrintMinidumpText(Minidump *minidump, unsigned int streams) {
+  int errors = 0;
+
+  if (streams & kStreamHeader)
+    minidump->Print();
+
+  if (streams & kStreamThreads) {
+    MinidumpThreadList *thread_list = minidump->GetThreadList();
+    if (!thread_list) {
+      ++errors;
+      BPLOG(ERROR) << "minidump.GetThreadList() failed";
+    } else {
+      thread_list->Print();
+    }
+  }
+
+  if (streams & kStreamThreadNames) {
+    MinidumpThreadNameList *thread_name_list = minidump->GetThreadNameList();
+    if (thread_name_list) {
+      thread_name_list->Print();
+    }
+  }
+
+  if (streams & kStreamModules) {
+    MinidumpModuleList *module_list = minidump->GetModuleList();
+    if (!module_list) {
+      ++errors;
+      BPLOG(ERROR) << "minidump.GetModuleList() failed";
+    } else {
+      module_list->Print();
+    }
+  }
+
+  if (streams & kStreamMemory) {
+    MinidumpMemoryList *memory_list = minidump->GetMemoryList();
+    if (!memory_list) {
+      ++errors;
+      BPLOG(ERROR) << "minidump.GetMemoryList() failed";
+    } else {
+      memory_list->Print();
+    }
+  }
+
+  if (streams & kStreamMemory64) {
+    MinidumpMemory64List *memory64_list = minidump->GetMemory64List();
+    if (!memory64_list) {
+      BPLOG(INFO) << "minidump.GetMemory64List() failed";
+    } else {
+      memory64_list->Print();
+    }
+  }
+
+  if (streams & kStreamException) {
+    MinidumpException *exception = minidump->GetException();
+    if (!exception) {
+      BPLOG(INFO) << "minidump.GetException() failed";
+    } else {
+      exception->Print();
+    }
+  }
+
+  if (streams & kStreamAssertion) {
+    MinidumpAssertion *assertion = minidump->GetAssertion();
+    if (!assertion) {
+      BPLOG(INFO) << "minidump.GetAssertion() failed";
+    } else {
+      assertion->Print();
+    }
+  }
+
+  if (streams & kStreamSystemInfo) {
+    MinidumpSystemInfo *system_info = minidump->GetSystemInfo();
+    if (!system_info) {
+      ++errors;
+      BPLOG(ERROR) << "minidump.GetSystemInfo() failed";
+    } else {
+      system_info->Print();
+    }
+  }
+
+  if (streams & kStreamMiscInfo) {
+    MinidumpMiscInfo *misc_info = minidump->GetMiscInfo();
+    if (!misc_info) {
+      ++errors;
+      BPLOG(ERROR) << "minidump.GetMiscInfo() failed";
+    } else {
+      misc_info->Print();
+    }
+  }
+
+  if (streams & kStreamBreakpadInfo) {
+    MinidumpBreakpadInfo *breakpad_info = minidump->GetBreakpadInfo();
+    if (!breakpad_info) {
+      // Breakpad info is optional, so don't treat this as an error.
+      BPLOG(INFO) << "minidump.GetBreakpadInfo() failed";
+    } else {
+      breakpad_info->Print();
+    }
+  }
+
+  if (streams & kStreamMemoryInfo) {
+    MinidumpMemoryInfoList *memory_info_list =
+        minidump->GetMemoryInfoList();
+    if (!memory_info_list) {
+      ++errors;
+      BPLOG(ERROR) << "minidump.GetMemoryInfoList() failed";
+    } else {
+      memory_info_list->Print();
+    }
+  }
+
+  if (streams & kStreamCrashpadInfo) {
+    MinidumpCrashpadInfo *crashpad_info = minidump->GetCrashpadInfo();
+    if (crashpad_info) {
+      // Crashpad info is optional, so don't treat absence as an error.
+      crashpad_info->Print();
+    }
+  }
+
+  if (streams & kStreamDumpTiming) {
+    MinidumpDumpTiming *dump_timing = minidump->GetDumpTiming();
+    if (dump_timing) {
+      // Dump timing is optional, so don't treat absence as an error.
+      dump_timing->Print();
+    }
+  }
+
+  if (streams & kStreamCrashSignature) {
+    MinidumpCrashSignature *crash_signature = minidump->GetCrashSignature();
+    if (crash_signature) {
+      // The crash signature is optional, so don't treat absence as an error.
+      crash_signature->Print();
+    }
+  }
+
+  if (streams & kStreamLinux) {
+    DumpRawStream(minidump,
+                  MD_LINUX_CMD_LINE,
+                  "MD_LINUX_CMD_LINE",
+                  &errors);
+    DumpRawStream(minidump,
+                  MD_LINUX_ENVIRON,
+                  "MD_LINUX_ENVIRON",
+                  &errors);
+    DumpRawStream(minidump,
+                  MD_LINUX_LSB_RELEASE,
+                  "MD_LINUX_LSB_RELEASE",
+                  &errors);
+    DumpRawStream(minidump,
+                  MD_LINUX_PROC_STATUS,
+                  "MD_LINUX_PROC_STATUS",
+                  &errors);
+    DumpRawStream(minidump,
+                  MD_LINUX_CPU_INFO,
+                  "MD_LINUX_CPU_INFO",
+                  &errors);
+    DumpRawStream(minidump,
+                  MD_LINUX_MAPS,
+                  "MD_LINUX_MAPS",
+                  &errors);
+  }
+
+  return errors;
+}
+
+// Writes compact JSON to stdout.  Keys are given for the members of an
+// object and are NULL for the elements of an array.
+class JSONWriter {
+ public:
+  JSONWriter() : first_(true) {}
+
+  void BeginObject(const char *key) {
+    Key(key);
+    putchar('{');
+    first_ = true;
+  }
+  void EndObject() {
+    putchar('}');
+    first_ = false;
+  }
+  void BeginArray(const char *key) {
+    Key(key);
+    putchar('[');
+    first_ = true;
+  }
+  void EndArray() {
+    putchar(']');
+    first_ = false;
+  }
+
+  void Number(const char *key, uint64_t value) {
+    Key(key);
+    printf("%" PRIu64, value);
+  }
+  // Addresses are written as strings, since JSON readers commonly hold
+  // numbers as doubles, which can't hold every 64-bit address.
+  void Address(const char *key, uint64_t value) {
+    Key(key);
+    printf("\"0x%" PRIx64 "\"", value);
+  }
+  void String(const char *key, const string& value) {
+    Key(key);
+    WriteString(value);
+  }
+
+ private:
+  void Key(const char *key) {
+    if (!first_)
+      putchar(',');
+    first_ = false;
+    if (key) {
+      WriteString(key);
+      putchar(':');
+    }
+  }
+
+  static void WriteString(const string& value) {
+    putchar('"');
+    for (unsigned char c : value) {
+      if (c == '"' || c == '\\') {
+        putchar('\\');
+        putchar(c);
+      } else if (c < 0x20) {
+        printf("\\u%04x", c);
+      } else {
+        putchar(c);
+      }
+    }
+    putchar('"');
   }
-  minidump.Print();
 
+  // Whether nothing has been written in the current object or array.
+  bool first_;
+};
+
+// Prints the streams of minidump as a JSON object with a member for each
+// stream, and returns the number of streams that were expected and could
+// not be read.  The JSON holds the fields that tools commonly extract, and
+// leaves out streams without such fields: the assertion, memory info,
+// Crashpad info, dump timing, and Linux streams.
+static int PrintMinidumpJSON(Minidump *minidump, unsigned int streams) {
   int errors = 0;
+  JSONWriter json;
+  json.BeginObject(NULL);
+
+  if (streams & kStreamHeader) {
+    const MDRawHeader *header = minidump->header();
+    json.BeginObject("header");
+    json.Number("version", header->version);
+    json.Number("stream_count", header->stream_count);
+    json.Number("time_date_stamp", header->time_date_stamp);
+    json.Number("flags", header->flags);
+    json.EndObject();
+  }
+
+  if (streams & kStreamThreads) {
+    MinidumpThreadList *thread_list = minidump->GetThreadList();
+    if (!thread_list) {
+      ++errors;
+      BPLOG(ERROR) << "minidump.GetThreadList() failed";
+    } else {
+      json.BeginArray("threads");
+      for (unsigned int i = 0; i < thread_list->thread_count(); ++i) {
+        const MinidumpThread *thread = thread_list->GetThreadAtIndex(i);
+        const MDRawThread *raw_thread = thread ? thread->thread() : NULL;
+        if (!raw_thread)
+          continue;
+        json.BeginObject(NULL);
+        json.Number("thread_id", raw_thread->thread_id);
+        json.Number("suspend_count", raw_thread->suspend_count);
+        json.Address("teb", raw_thread->teb);
+        json.Address("stack_start", raw_thread->stack.start_of_memory_range);
+        json.Number("stack_size", raw_thread->stack.memory.data_size);
+        json.EndObject();
+      }
+      json.EndArray();
+    }
+  }
+
+  if (streams & kStreamThreadNames) {
+    MinidumpThreadNameList *thread_name_list = minidump->GetThreadNameList();
+    if (thread_name_list) {
+      json.BeginArray("thread_names");
+      for (unsigned int i = 0; i < thread_name_list->thread_name_count();
+           ++i) {
+        const MinidumpThreadName *thread_name =
+            thread_name_list->GetThreadNameAtIndex(i);
+        uint32_t thread_id;
+        if (!thread_name || !thread_name->GetThreadID(&thread_id))
+          continue;
+        json.BeginObject(NULL);
+        json.Number("thread_id", thread_id);
+        json.String("name", thread_name->GetThreadName());
+        json.EndObject();
+      }
+      json.EndArray();
+    }
+  }
+
+  if (streams & kStreamModules) {
+    MinidumpModuleList *module_list = minidump->GetModuleList();
+    if (!module_list) {
+      ++errors;
+      BPLOG(ERROR) << "minidump.GetModuleList() failed";
+    } else {
+      json.BeginArray("modules");
+      for (unsigned int i = 0; i < module_list->module_count(); ++i) {
+        const MinidumpModule *module = module_list->GetModuleAtSequence(i);
+        if (!module)
+          continue;
+        json.BeginObject(NULL);
+        json.Address("base_address", module->base_address());
+        json.Number("size", module->size());
+        json.String("code_file", module->code_file());
+        json.String("code_identifier", module->code_identifier());
+        json.String("debug_file", module->debug_file());
+        json.String("debug_identifier", module->debug_identifier());
+        json.String("version", module->version());
+        json.EndObject();
+      }
+      json.EndArray();
+    }
+  }
+
+  if (streams & kStreamMemory) {
+    MinidumpMemoryList *memory_list = minidump->GetMemoryList();
+    if (!memory_list) {
+      ++errors;
+      BPLOG(ERROR) << "minidump.GetMemoryList() failed";
+    } else {
+      json.BeginArray("memory");
+      for (unsigned int i = 0; i < memory_list->region_count(); ++i) {
+        MinidumpMemoryRegion *region = memory_list->GetMemoryRegionAtIndex(i);
+        if (!region)
+          continue;
+        json.BeginObject(NULL);
+        json.Address("base", region->GetBase());
+        json.Number("size", region->GetSize());
+        json.EndObject();
+      }
+      json.EndArray();
+    }
+  }
+
+  if (streams & kStreamMemory64) {
+    MinidumpMemory64List *memory64_list = minidump->GetMemory64List();
+    if (memory64_list) {
+      json.BeginArray("memory64");
+      for (unsigned int i = 0; i < memory64_list->region_count(); ++i) {
+        MinidumpMemory64Region *region =
+            memory64_list->GetMemoryRegionAtIndex(i);
+        if (!region)
+          continue;
+        json.BeginObject(NULL);
+        json.Address("base", region->GetBase());
+        json.Number("size", region->GetSize());
+        json.EndObject();
+      }
+      json.EndArray();
+    }
+  }
+
+  if (streams & kStreamException) {
+    MinidumpException *exception = minidump->GetException();
+    const MDRawExceptionStream *raw_exception =
+        exception ? exception->exception() : NULL;
+    if (raw_exception) {
+      json.BeginObject("exception");
+      json.Number("thread_id", raw_exception->thread_id);
+      json.Number("code", raw_exception->exception_record.exception_code);
+      json.Number("flags", raw_exception->exception_record.exception_flags);
+      json.Address("address",
+                   raw_exception->exception_record.exception_address);
+      json.EndObject();
+    }
+  }
+
+  if (streams & kStreamSystemInfo) {
+    MinidumpSystemInfo *system_info = minidump->GetSystemInfo();
+    const MDRawSystemInfo *raw_system_info =
+        system_info ? system_info->system_info() : NULL;
+    if (!raw_system_info) {
+      ++errors;
+      BPLOG(ERROR) << "minidump.GetSystemInfo() failed";
+    } else {
+      json.BeginObject("system_info");
+      json.String("os", system_info->GetOS());
+      json.Number("major_version", raw_system_info->major_version);
+      json.Number("minor_version", raw_system_info->minor_version);
+      json.Number("build_number", raw_system_info->build_number);
+      const string *csd_version = system_info->GetCSDVersion();
+      if (csd_version)
+        json.String("csd_version", *csd_version);
+      json.String("cpu", system_info->GetCPU());
+      json.Number("number_of_processors",
+                  raw_system_info->number_of_processors);
+      json.EndObject();
+    }
+  }
+
+  if (streams & kStreamMiscInfo) {
+    MinidumpMiscInfo *misc_info = minidump->GetMiscInfo();
+    const MDRawMiscInfo *raw_misc_info =
+        misc_info ? misc_info->misc_info() : NULL;
+    if (!raw_misc_info) {
+      ++errors;
+      BPLOG(ERROR) << "minidump.GetMiscInfo() failed";
+    } else {
+      json.BeginObject("misc_info");
+      if (raw_misc_info->flags1 & MD_MISCINFO_FLAGS1_PROCESS_ID)
+        json.Number("process_id", raw_misc_info->process_id);
+      if (raw_misc_info->flags1 & MD_MISCINFO_FLAGS1_PROCESS_TIMES) {
+        json.Number("process_create_time",
+                    raw_misc_info->process_create_time);
+      }
+      json.EndObject();
+    }
+  }
+
+  if (streams & kStreamBreakpadInfo) {
+    MinidumpBreakpadInfo *breakpad_info = minidump->GetBreakpadInfo();
+    const MDRawBreakpadInfo *raw_breakpad_info =
+        breakpad_info ? breakpad_info->breakpad_info() : NULL;
+    if (raw_breakpad_info) {
+      json.BeginObject("breakpad_info");
+      if (raw_breakpad_info->validity &
+          MD_BREAKPAD_INFO_VALID_DUMP_THREAD_ID) {
+        json.Number("dump_thread_id", raw_breakpad_info->dump_thread_id);
+      }
+      if (raw_breakpad_info->validity &
+          MD_BREAKPAD_INFO_VALID_REQUESTING_THREAD_ID) {
+        json.Number("requesting_thread_id",
+                    raw_breakpad_info->requesting_thread_id);
+      }
+      json.EndObject();
+    }
+  }
 
-  MinidumpThreadList *thread_list = minidump.GetThreadList();
-  if (!thread_list) {
-    ++errors;
-    BPLOG(ERROR) << "minidump.GetThreadList() failed";
-  } else {
-    thread_list->Print();
+  if (streams & kStreamMemoryInfo) {
+    if (!minidump->GetMemoryInfoList()) {
+      ++errors;
+      BPLOG(ERROR) << "minidump.GetMemoryInfoList() failed";
+    }
   }
 
-  MinidumpThreadNameList *thread_name_list = minidump.GetThreadNameList();
-  if (thread_name_list) {
-    thread_name_list->Print();
+  json.EndObject();
+  putchar('\n');
+  return errors;
+}
+
+static bool PrintMinidumpDump(const Options& options) {
+#if defined(__linux__)
+  // The minidump points into the mapping, so the mapping must outlive it.
+  MemoryMappedFile mapped_file;
+#endif  // __linux__
+  scoped_ptr<Minidump> minidump;
+#if defined(__linux__)
+  if (options.mmap) {
+    if (!mapped_file.Map(options.minidumpPath.c_str(), 0)) {
+      BPLOG(ERROR) << "Could not map " << options.minidumpPath;
+      return false;
+    }
+    minidump.reset(new Minidump(mapped_file));
+    minidump->SetHexdumpMode(options.hexdump, options.hexdump_width);
+  }
+#endif  // __linux__
+  if (!minidump.get()) {
+    minidump.reset(new Minidump(options.minidumpPath,
+                                options.hexdump,
+                                options.hexdump_width));
+  }
+  if (!minidump->Read()) {
+    BPLOG(ERROR) << "minidump.Read() failed";
+    return false;
   }
 
   // It's useful to be able to see the full list of modules here even if it
   // would cause minidump_stackwalk to fail.
   MinidumpModuleList::set_max_modules(UINT32_MAX);
-  MinidumpModuleList *module_list = minidump.GetModuleList();
-  if (!module_list) {
-    ++errors;
-    BPLOG(ERROR) << "minidump.GetModuleList() failed";
-  } else {
-    module_list->Print();
-  }
-
-  MinidumpMemoryList *memory_list = minidump.GetMemoryList();
-  if (!memory_list) {
-    ++errors;
-    BPLOG(ERROR) << "minidump.GetMemoryList() failed";
-  } else {
-    memory_list->Print();
-  }
-
-  MinidumpException *exception = minidump.GetException();
-  if (!exception) {
-    BPLOG(INFO) << "minidump.GetException() failed";
-  } else {
-    exception->Print();
-  }
-
-  MinidumpAssertion *assertion = minidump.GetAssertion();
-  if (!assertion) {
-    BPLOG(INFO) << "minidump.GetAssertion() failed";
-  } else {
-    assertion->Print();
-  }
-
-  MinidumpSystemInfo *system_info = minidump.GetSystemInfo();
-  if (!system_info) {
-    ++errors;
-    BPLOG(ERROR) << "minidump.GetSystemInfo() failed";
-  } else {
-    system_info->Print();
-  }
-
-  MinidumpMiscInfo *misc_info = minidump.GetMiscInfo();
-  if (!misc_info) {
-    ++errors;
-    BPLOG(ERROR) << "minidump.GetMiscInfo() failed";
-  } else {
-    misc_info->Print();
-  }
-
-  MinidumpBreakpadInfo *breakpad_info = minidump.GetBreakpadInfo();
-  if (!breakpad_info) {
-    // Breakpad info is optional, so don't treat this as an error.
-    BPLOG(INFO) << "minidump.GetBreakpadInfo() failed";
-  } else {
-    breakpad_info->Print();
-  }
-
-  MinidumpMemoryInfoList *memory_info_list = minidump.GetMemoryInfoList();
-  if (!memory_info_list) {
-    ++errors;
-    BPLOG(ERROR) << "minidump.GetMemoryInfoList() failed";
-  } else {
-    memory_info_list->Print();
-  }
-
-  MinidumpCrashpadInfo *crashpad_info = minidump.GetCrashpadInfo();
-  if (crashpad_info) {
-    // Crashpad info is optional, so don't treat absence as an error.
-    crashpad_info->Print();
-  }
-
-  DumpRawStream(&minidump,
-                MD_LINUX_CMD_LINE,
-                "MD_LINUX_CMD_LINE",
-                &errors);
-  DumpRawStream(&minidump,
-                MD_LINUX_ENVIRON,
-                "MD_LINUX_ENVIRON",
-                &errors);
-  DumpRawStream(&minidump,
-                MD_LINUX_LSB_RELEASE,
-                "MD_LINUX_LSB_RELEASE",
-                &errors);
-  DumpRawStream(&minidump,
-                MD_LINUX_PROC_STATUS,
-                "MD_LINUX_PROC_STATUS",
-                &errors);
-  DumpRawStream(&minidump,
-                MD_LINUX_CPU_INFO,
-                "MD_LINUX_CPU_INFO",
-                &errors);
-  DumpRawStream(&minidump,
-                MD_LINUX_MAPS,
-                "MD_LINUX_MAPS",
-                &errors);
 
+  int errors = options.json ?
+      PrintMinidumpJSON(minidump.get(), options.streams) :
+      PrintMinidumpText(minidump.get(), options.streams);
   return errors == 0;
 }
 
@@ -242,6 +701,15 @@ Usage(int argc, char *argv[], bool error) {
           "Options:\n"
           "  <minidump> should be a minidump.\n"
           "  -x:\t Display memory in a hexdump like format\n"
+          "  -s, --stream=<streams>:\t Print only the comma-separated\n"
+          "\t streams: header, threads, thread_names, modules, memory,\n"
+          "\t memory64, exception, assertion, system_info, misc_info,\n"
+          "\t breakpad_info, memory_info, crashpad_info, dump_timing,\n"
+          "\t linux, crash_signature\n"
+          "  -j, --json:\t Print the streams' common fields as compact JSON\n"
+#if defined(__linux__)
+          "  -m, --mmap:\t Map the minidump instead of reading it\n"
+#endif
           "  -h:\t Usage\n",
           google_breakpad::BaseName(argv[0]).c_str());
 }
@@ -251,11 +719,31 @@ static void
 SetupOptions(int argc, char *argv[], Options *options) {
   int ch;
 
-  while ((ch = getopt(argc, (char * const*)argv, "xh")) != -1) {
+  static const struct option kLongOptions[] = {
+    {"stream", required_argument, NULL, 's'},
+    {"json", no_argument, NULL, 'j'},
+    {"mmap", no_argument, NULL, 'm'},
+    {NULL, 0, NULL, 0}
+  };
+
+  while ((ch = getopt_long(argc, (char * const*)argv, "xs:jmh",
+                           kLongOptions, NULL)) != -1) {
     switch (ch) {
       case 'x':
         options->hexdump = true;
         break;
+      case 's':
+        if (!ParseStreamList(optarg, &options->streams)) {
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        break;
+      case 'j':
+        options->json = true;
+        break;
+      case 'm':
+        options->mmap = true;
+        break;
       case 'h':
         Usage(argc, argv, false);
         exit(0);
@@ -281,5 +769,8 @@ int main(int argc, char *argv[]) {
   Options options;
   BPLOG_INIT(&argc, &argv);
   SetupOptions(argc, argv, &options);
+  // The streams are printed with many small writes.
+  static char stdout_buffer[1 << 16];
+  setvbuf(stdout, stdout_buffer, _IOFBF, sizeof(stdout_buffer));
   return PrintMinidumpDump(options) ? 0 : 1;
 }
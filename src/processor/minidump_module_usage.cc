@@ -0,0 +1,379 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// minidump_module_usage.cc: Count, for each module in a corpus of
+// minidumps, the minidumps that list it and the thread contexts that
+// point into it, to decide which symbols are worth uploading or
+// prefetching.
+//
+// Only each minidump's directory, module list, thread list and thread
+// contexts are read, the same small part that triage reads; stacks are not
+// walked and no symbols are loaded.  On Linux minidumps are mapped rather
+// than read, so that only the pages holding those streams are touched.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include "common/linux/memory_mapped_file.h"
+#endif  // __linux__
+#include "common/path_helper.h"
+#include "common/scoped_ptr.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/minidump.h"
+#include "processor/logging.h"
+
+namespace {
+
+#if defined(__linux__)
+using google_breakpad::MemoryMappedFile;
+#endif  // __linux__
+using google_breakpad::Minidump;
+using google_breakpad::MinidumpContext;
+using google_breakpad::MinidumpException;
+using google_breakpad::MinidumpModule;
+using google_breakpad::MinidumpModuleList;
+using google_breakpad::MinidumpThread;
+using google_breakpad::MinidumpThreadList;
+using google_breakpad::scoped_ptr;
+using std::vector;
+
+struct Options {
+  Options() : jobs(0), quiet(false) {}
+
+  int jobs;
+  bool quiet;
+  string output_file;
+  vector<string> paths;
+};
+
+// A module's debug file and debug identifier.
+typedef std::pair<string, string> ModuleKey;
+
+struct ModuleUsage {
+  ModuleUsage() : dumps(0), frames(0) {}
+
+  // The minidumps listing the module.
+  uint64_t dumps;
+  // The thread contexts whose instruction pointer is in the module.
+  uint64_t frames;
+};
+
+typedef std::map<ModuleKey, ModuleUsage> ModuleHistogram;
+
+// Appends the regular files found under path to minidump_files.
+static void FindMinidumpFiles(const string& path,
+                              vector<string>* minidump_files) {
+  struct stat path_stat;
+  if (stat(path.c_str(), &path_stat) != 0) {
+    BPLOG(ERROR) << "Could not stat " << path;
+    return;
+  }
+  if (!S_ISDIR(path_stat.st_mode)) {
+    if (S_ISREG(path_stat.st_mode))
+      minidump_files->push_back(path);
+    return;
+  }
+
+  DIR* dir = opendir(path.c_str());
+  if (!dir) {
+    BPLOG(ERROR) << "Could not open directory " << path;
+    return;
+  }
+  dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      continue;
+    FindMinidumpFiles(path + "/" + entry->d_name, minidump_files);
+  }
+  closedir(dir);
+}
+
+// Adds the modules of minidump and the contexts of its threads to
+// histogram.  Returns false if the minidump or its module list can't be
+// read.
+static bool ScanMinidump(Minidump* minidump, ModuleHistogram* histogram) {
+  if (!minidump->Read())
+    return false;
+  MinidumpModuleList* module_list = minidump->GetModuleList();
+  if (!module_list)
+    return false;
+
+  // A module loaded more than once is counted once per minidump.
+  std::set<ModuleKey> modules;
+  for (unsigned int i = 0; i < module_list->module_count(); ++i) {
+    const MinidumpModule* module = module_list->GetModuleAtSequence(i);
+    if (!module)
+      continue;
+    ModuleKey key(module->debug_file(), module->debug_identifier());
+    if (modules.insert(key).second)
+      ++(*histogram)[key].dumps;
+  }
+
+  MinidumpThreadList* thread_list = minidump->GetThreadList();
+  if (!thread_list)
+    return true;
+
+  // As when walking stacks, the thread that raised the exception is
+  // described by the exception's context rather than its own.
+  uint32_t exception_thread_id = 0;
+  MinidumpContext* exception_context = NULL;
+  MinidumpException* exception = minidump->GetException();
+  if (exception && exception->GetThreadID(&exception_thread_id))
+    exception_context = exception->GetContext();
+
+  for (unsigned int i = 0; i < thread_list->thread_count(); ++i) {
+    MinidumpThread* thread = thread_list->GetThreadAtIndex(i);
+    uint32_t thread_id;
+    if (!thread || !thread->GetThreadID(&thread_id))
+      continue;
+    MinidumpContext* context =
+        exception_context && thread_id == exception_thread_id ?
+        exception_context : thread->GetContext();
+    uint64_t instruction_pointer;
+    if (!context || !context->GetInstructionPointer(&instruction_pointer))
+      continue;
+    const MinidumpModule* module =
+        module_list->GetModuleForAddress(instruction_pointer);
+    if (module) {
+      ++(*histogram)[ModuleKey(module->debug_file(),
+                               module->debug_identifier())].frames;
+    }
+  }
+  return true;
+}
+
+static bool ScanMinidumpFile(const string& path, ModuleHistogram* histogram) {
+#if defined(__linux__)
+  MemoryMappedFile mapped_file;
+  if (!mapped_file.Map(path.c_str(), 0)) {
+    BPLOG(ERROR) << "Could not map " << path;
+    return false;
+  }
+  Minidump minidump(mapped_file);
+#else
+  Minidump minidump(path);
+#endif  // __linux__
+  if (!ScanMinidump(&minidump, histogram)) {
+    BPLOG(ERROR) << "Could not read the modules of " << path;
+    return false;
+  }
+  return true;
+}
+
+static bool MoreUsed(const std::pair<ModuleKey, ModuleUsage>& a,
+                     const std::pair<ModuleKey, ModuleUsage>& b) {
+  if (a.second.dumps != b.second.dumps)
+    return a.second.dumps > b.second.dumps;
+  if (a.second.frames != b.second.frames)
+    return a.second.frames > b.second.frames;
+  return a.first < b.first;
+}
+
+static bool ScanMinidumpFiles(const Options& options) {
+  vector<string> minidump_files;
+  for (size_t i = 0; i < options.paths.size(); ++i) {
+    FindMinidumpFiles(options.paths[i], &minidump_files);
+  }
+
+  int jobs = options.jobs;
+  if (jobs <= 0)
+    jobs = std::max(1U, std::thread::hardware_concurrency());
+  if (static_cast<size_t>(jobs) > minidump_files.size())
+    jobs = std::max(static_cast<size_t>(1), minidump_files.size());
+
+  // Each worker counts into its own histogram, and they are merged once
+  // all are done.
+  vector<ModuleHistogram> histograms(jobs);
+  std::atomic<size_t> next_file(0);
+  std::atomic<int> failed(0);
+  auto scan = [&](ModuleHistogram* histogram) {
+    size_t index;
+    while ((index = next_file++) < minidump_files.size()) {
+      if (!ScanMinidumpFile(minidump_files[index], histogram))
+        ++failed;
+    }
+  };
+
+  // Reading a minidump logs at INFO level, which costs more than reading
+  // it does.
+  int saved_stderr = -1;
+  if (options.quiet) {
+    fflush(stderr);
+    saved_stderr = dup(STDERR_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDERR_FILENO);
+    close(null_fd);
+  }
+
+  vector<std::thread> workers;
+  for (int i = 1; i < jobs; ++i) {
+    workers.push_back(std::thread(scan, &histograms[i]));
+  }
+  scan(&histograms[0]);
+  for (size_t i = 0; i < workers.size(); ++i) {
+    workers[i].join();
+  }
+
+  if (saved_stderr != -1) {
+    dup2(saved_stderr, STDERR_FILENO);
+    close(saved_stderr);
+  }
+
+  ModuleHistogram& histogram = histograms[0];
+  for (int i = 1; i < jobs; ++i) {
+    for (const auto& module : histograms[i]) {
+      ModuleUsage& usage = histogram[module.first];
+      usage.dumps += module.second.dumps;
+      usage.frames += module.second.frames;
+    }
+    histograms[i].clear();
+  }
+  vector<std::pair<ModuleKey, ModuleUsage>> modules(histogram.begin(),
+                                                    histogram.end());
+  std::sort(modules.begin(), modules.end(), MoreUsed);
+
+  FILE* output = stdout;
+  if (!options.output_file.empty()) {
+    output = fopen(options.output_file.c_str(), "w");
+    if (!output) {
+      fprintf(stderr, "Could not create %s\n", options.output_file.c_str());
+      return false;
+    }
+  }
+  for (const auto& module : modules) {
+    fprintf(output, "%llu\t%llu\t%s\t%s\n",
+            static_cast<unsigned long long>(module.second.dumps),
+            static_cast<unsigned long long>(module.second.frames),
+            module.first.first.c_str(), module.first.second.c_str());
+  }
+  bool written = !ferror(output);
+  if (output != stdout && fclose(output) != 0)
+    written = false;
+  if (!written) {
+    fprintf(stderr, "Could not write the module histogram\n");
+    return false;
+  }
+
+  fprintf(stderr, "%zu minidumps scanned, %d failed, %zu modules\n",
+          minidump_files.size(), failed.load(), modules.size());
+  return true;
+}
+
+//=============================================================================
+static void
+Usage(int argc, char* argv[], bool error) {
+  FILE* fp = error ? stderr : stdout;
+
+  fprintf(fp,
+          "Usage: %s [options...] <minidump-path> [<minidump-path> ...]\n"
+          "Count how often each module appears in a set of minidumps.\n"
+          "\n"
+          "Options:\n"
+          "  <minidump-path> is a minidump, or a directory searched for\n"
+          "  minidumps.  Each module is written on a line of four\n"
+          "  tab-separated columns, the most used first: the number of\n"
+          "  minidumps listing it, the number of thread contexts whose\n"
+          "  instruction pointer is in it, its debug file and its debug\n"
+          "  identifier.\n"
+          "  -j <n>:\t Scan n minidumps at a time (default: one per CPU)\n"
+          "  -o <file>:\t Write the histogram to file instead of stdout\n"
+          "  -q:\t Don't log while scanning\n"
+          "  -h:\t Usage\n",
+          google_breakpad::BaseName(argv[0]).c_str());
+}
+
+//=============================================================================
+static void
+SetupOptions(int argc, char* argv[], Options* options) {
+  int ch;
+
+  while ((ch = getopt(argc, (char* const*)argv, "hj:o:q")) != -1) {
+    switch (ch) {
+      case 'h':
+        Usage(argc, argv, false);
+        exit(0);
+        break;
+      case 'j':
+        options->jobs = atoi(optarg);
+        if (options->jobs < 1) {
+          fprintf(stderr, "%s: Invalid job count: %s\n", argv[0], optarg);
+          exit(1);
+        }
+        break;
+      case 'o':
+        options->output_file = optarg;
+        break;
+      case 'q':
+        options->quiet = true;
+        break;
+
+      default:
+        Usage(argc, argv, true);
+        exit(1);
+        break;
+    }
+  }
+
+  if ((argc - optind) < 1) {
+    fprintf(stderr, "%s: Missing minidump path\n", argv[0]);
+    Usage(argc, argv, true);
+    exit(1);
+  }
+
+  for (int i = optind; i < argc; ++i) {
+    options->paths.push_back(argv[i]);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+  BPLOG_INIT(&argc, &argv);
+  SetupOptions(argc, argv, &options);
+  return ScanMinidumpFiles(options) ? 0 : 1;
+}
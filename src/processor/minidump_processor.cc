@@ -35,24 +35,45 @@
 #include <assert.h>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "common/scoped_ptr.h"
 #include "common/stdio_wrapper.h"
 #include "common/using_std_string.h"
 #include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/code_modules.h"
+#include "google_breakpad/processor/memory_region.h"
 #include "google_breakpad/processor/minidump.h"
 #include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/process_state_observer.h"
+#include "google_breakpad/processor/processing_stats.h"
 #include "google_breakpad/processor/exploitability.h"
+#include "google_breakpad/processor/stack_frame_cpu.h"
 #include "google_breakpad/processor/stack_frame_symbolizer.h"
+#include "google_breakpad/processor/stack_signature_generator.h"
+#include "google_breakpad/processor/stack_walk_cache.h"
+#include "google_breakpad/processor/system_info.h"
+#include "google_breakpad/processor/terminal_frames.h"
+#include "google_breakpad/processor/unsymbolized_walk.h"
+#include "processor/eh_frame_unwind_tables.h"
 #include "processor/logging.h"
 #include "processor/stackwalker_x86.h"
 #include "processor/symbolic_constants_win.h"
+#include "processor/windows_unwind_tables.h"
 
 #ifdef __linux__
 #include "processor/disassembler_objdump.h"
@@ -67,7 +88,23 @@ MinidumpProcessor::MinidumpProcessor(SymbolSupplier* supplier,
       enable_exploitability_(false),
       enable_objdump_(false),
       enable_objdump_for_exploitability_(false),
-      max_thread_count_(-1) {
+      defer_exploitability_(false),
+      max_thread_count_(-1),
+      walk_concurrency_(1),
+      enable_frame_arenas_(false),
+      deduplicate_stacks_(false),
+      symbol_prefetch_concurrency_(0),
+      async_symbol_prefetch_(false),
+      observer_(NULL),
+      collect_stats_(false),
+      walk_time_limit_(0),
+      thread_walk_time_limit_(0),
+      defer_thread_walks_(false),
+      stack_signature_generator_(NULL),
+      symbolized_frame_limit_(0),
+      terminal_frames_(NULL),
+      stack_walk_cache_(NULL),
+      unsymbolized_walk_(NULL) {
 }
 
 MinidumpProcessor::MinidumpProcessor(SymbolSupplier* supplier,
@@ -78,7 +115,23 @@ MinidumpProcessor::MinidumpProcessor(SymbolSupplier* supplier,
       enable_exploitability_(enable_exploitability),
       enable_objdump_(false),
       enable_objdump_for_exploitability_(false),
-      max_thread_count_(-1) {
+      defer_exploitability_(false),
+      max_thread_count_(-1),
+      walk_concurrency_(1),
+      enable_frame_arenas_(false),
+      deduplicate_stacks_(false),
+      symbol_prefetch_concurrency_(0),
+      async_symbol_prefetch_(false),
+      observer_(NULL),
+      collect_stats_(false),
+      walk_time_limit_(0),
+      thread_walk_time_limit_(0),
+      defer_thread_walks_(false),
+      stack_signature_generator_(NULL),
+      symbolized_frame_limit_(0),
+      terminal_frames_(NULL),
+      stack_walk_cache_(NULL),
+      unsymbolized_walk_(NULL) {
 }
 
 MinidumpProcessor::MinidumpProcessor(StackFrameSymbolizer* frame_symbolizer,
@@ -88,7 +141,23 @@ MinidumpProcessor::MinidumpProcessor(StackFrameSymbolizer* frame_symbolizer,
       enable_exploitability_(enable_exploitability),
       enable_objdump_(false),
       enable_objdump_for_exploitability_(false),
-      max_thread_count_(-1) {
+      defer_exploitability_(false),
+      max_thread_count_(-1),
+      walk_concurrency_(1),
+      enable_frame_arenas_(false),
+      deduplicate_stacks_(false),
+      symbol_prefetch_concurrency_(0),
+      async_symbol_prefetch_(false),
+      observer_(NULL),
+      collect_stats_(false),
+      walk_time_limit_(0),
+      thread_walk_time_limit_(0),
+      defer_thread_walks_(false),
+      stack_signature_generator_(NULL),
+      symbolized_frame_limit_(0),
+      terminal_frames_(NULL),
+      stack_walk_cache_(NULL),
+      unsymbolized_walk_(NULL) {
   assert(frame_symbolizer_);
 }
 
@@ -96,13 +165,1066 @@ MinidumpProcessor::~MinidumpProcessor() {
   if (own_frame_symbolizer_) delete frame_symbolizer_;
 }
 
-ProcessResult MinidumpProcessor::Process(
-    Minidump* dump, ProcessState* process_state) {
-  assert(dump);
-  assert(process_state);
+// What FillDumpInfo learned about a minidump's streams, for Process to log
+// and to find the dump and requesting threads with.
+struct MinidumpProcessor::DumpInfo {
+  DumpInfo()
+      : has_process_create_time(false),
+        has_cpu_info(false),
+        has_os_info(false),
+        breakpad_info(NULL),
+        exception(NULL),
+        dump_thread_id(0),
+        has_dump_thread(false),
+        requesting_thread_id(0),
+        has_requesting_thread(false) {}
+
+  bool has_process_create_time;
+  bool has_cpu_info;
+  bool has_os_info;
+  MinidumpBreakpadInfo* breakpad_info;
+  MinidumpException* exception;
+  uint32_t dump_thread_id;
+  bool has_dump_thread;
+  uint32_t requesting_thread_id;
+  bool has_requesting_thread;
+};
+
+namespace {
+
+// Makes stats current on a worker thread for the life of the
+// ScopedWorkerStats, and adds the worker's CPU time to phase.  The
+// wall-clock time is recorded by the thread that waits for the workers.
+class ScopedWorkerStats {
+ public:
+  ScopedWorkerStats(ProcessingStats* stats, ProcessingStats::Phase phase)
+      : scoped_stats_(stats),
+        stats_(stats),
+        phase_(phase),
+        cpu_start_(stats ? ProcessingStats::ThreadCPUSeconds() : 0) {}
+  ~ScopedWorkerStats() {
+    if (stats_) {
+      stats_->AddPhaseTime(phase_, 0,
+                           ProcessingStats::ThreadCPUSeconds() - cpu_start_);
+    }
+  }
 
-  process_state->Clear();
+ private:
+  ScopedProcessingStats scoped_stats_;
+  ProcessingStats* stats_;
+  ProcessingStats::Phase phase_;
+  double cpu_start_;
+};
+
+// The memory of a minidump's process, in either of its memory lists, from
+// which WindowsUnwindTables and EhFrameUnwindTables read images' unwind
+// information.  Regions read
+// their contents when first used, so reads are serialized for stack walkers
+// on several threads.
+class MinidumpProcessMemory : public MemoryRegion {
+ public:
+  MinidumpProcessMemory(MinidumpMemoryList* memory_list,
+                        MinidumpMemory64List* memory64_list)
+      : memory_list_(memory_list), memory64_list_(memory64_list) {}
+
+  uint64_t GetBase() const override { return 0; }
+  uint32_t GetSize() const override { return UINT32_MAX; }
+  bool GetMemoryAtAddress(uint64_t address, uint8_t* value) const override {
+    return GetMemoryAtAddressInternal(address, value);
+  }
+  bool GetMemoryAtAddress(uint64_t address, uint16_t* value) const override {
+    return GetMemoryAtAddressInternal(address, value);
+  }
+  bool GetMemoryAtAddress(uint64_t address, uint32_t* value) const override {
+    return GetMemoryAtAddressInternal(address, value);
+  }
+  bool GetMemoryAtAddress(uint64_t address, uint64_t* value) const override {
+    return GetMemoryAtAddressInternal(address, value);
+  }
+  void Print() const override {}
+
+ private:
+  template<typename T>
+  bool GetMemoryAtAddressInternal(uint64_t address, T* value) const {
+    std::lock_guard<std::mutex> lock(lock_);
+    MemoryRegion* region = NULL;
+    if (memory_list_)
+      region = memory_list_->GetMemoryRegionForAddress(address);
+    if (!region && memory64_list_)
+      region = memory64_list_->GetMemoryRegionForAddress(address);
+    return region && region->GetMemoryAtAddress(address, value);
+  }
+
+  MinidumpMemoryList* memory_list_;
+  MinidumpMemory64List* memory64_list_;
+  mutable std::mutex lock_;
+};
+
+// The unwind tables of a minidump's images, with the memory they are read
+// from: those of x64 Windows images, or the .eh_frame of Linux images.
+struct DumpUnwindTables {
+  DumpUnwindTables(MinidumpMemoryList* memory_list,
+                   MinidumpMemory64List* memory64_list)
+      : memory(memory_list, memory64_list), windows_tables(&memory),
+        eh_frame_tables(&memory) {}
+
+  MinidumpProcessMemory memory;
+  WindowsUnwindTables windows_tables;
+  EhFrameUnwindTables eh_frame_tables;
+};
+
+// A thread whose stack is to be walked on a worker thread.  The results are
+// kept per thread so that they can be merged in thread order afterwards.
+struct ThreadWalk {
+  MinidumpContext* context;
+  MemoryRegion* memory;
+  // The unwind tables of the dump's images, or NULL.
+  DumpUnwindTables* unwind_tables;
+  string thread_string;
+  uint32_t thread_id;
+  // The index of the thread in ProcessState::threads.
+  int thread_index;
+  CallStack* stack;
+  vector<const CodeModule*> modules_without_symbols;
+  vector<const CodeModule*> modules_with_corrupt_symbols;
+  bool interrupted;
+};
+
+// The time limits on walking the stacks of one minidump's threads.  See
+// MinidumpProcessor::set_walk_time_limit.
+class WalkTimeLimits {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  WalkTimeLimits(double walk_seconds, double thread_walk_seconds)
+      : walk_seconds_(walk_seconds),
+        thread_walk_seconds_(thread_walk_seconds),
+        walk_deadline_(Clock::time_point::max()) {}
+
+  bool limited() const {
+    return walk_seconds_ > 0 || thread_walk_seconds_ > 0;
+  }
+
+  // Starts the time allowed for walking all of the threads.
+  void Start() {
+    if (walk_seconds_ > 0)
+      walk_deadline_ = Clock::now() + ToDuration(walk_seconds_);
+  }
+
+  // Returns false if the time allowed for walking all of the threads has
+  // run out.  Otherwise, sets deadline to the time by which a walk starting
+  // now must stop, and returns true.
+  bool ThreadDeadline(Clock::time_point* deadline) const {
+    Clock::time_point now = Clock::now();
+    if (now >= walk_deadline_)
+      return false;
+    *deadline = walk_deadline_;
+    if (thread_walk_seconds_ > 0)
+      *deadline = std::min(*deadline, now + ToDuration(thread_walk_seconds_));
+    return true;
+  }
+
+ private:
+  static Clock::duration ToDuration(double seconds) {
+    return std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(seconds));
+  }
+
+  double walk_seconds_;
+  double thread_walk_seconds_;
+  Clock::time_point walk_deadline_;
+};
+
+// The parts of a thread that its stack walk depends on, for finding threads
+// whose stacks are the same.
+struct StackSnapshot {
+  uint32_t cpu;
+  // The size of the thread's registers and of the words compared on its
+  // stack, which are those of a pointer.
+  size_t word_size;
+  // The thread's general-purpose registers.
+  vector<uint64_t> registers;
+  // The rest of the thread's context, with its general-purpose registers
+  // cleared.
+  string other_state;
+  const MemoryRegion* memory;
+  // Values in [low, high) are taken to point into the thread's stack.  The
+  // range extends beyond the stack memory on both sides to allow for
+  // addresses that are computed from an address on the stack.
+  uint64_t low;
+  uint64_t high;
+  CallStack* stack;
+};
+
+// A thread whose stack is copied from an earlier thread's.
+struct DuplicateStack {
+  const CallStack* source;
+  uint64_t low;
+  uint64_t high;
+  uint64_t delta;
+  CallStack* stack;
+  // The index of stack's thread in ProcessState::threads.
+  int thread_index;
+};
+
+// Only stacks that are a multiple of this apart are deduplicated, so that
+// rounding a stack address down to an alignment, as some CFI rules do, gives
+// the same result on both stacks.
+const uint64_t kStackDeduplicationAlignment = 16;
+
+// The most general-purpose registers in a context that stacks are
+// deduplicated for, which is arm64's.
+const size_t kMaxStackRegisters = MD_CONTEXT_ARM64_GPR_COUNT;
+
+// Sets registers to the general-purpose registers of context, and returns
+// how many there are.
+static size_t GetStackRegisters(MDRawContextX86* context,
+                                uint32_t** registers) {
+  uint32_t* context_registers[] = {
+    &context->eax, &context->ebx, &context->ecx, &context->edx,
+    &context->esi, &context->edi, &context->ebp, &context->esp,
+    &context->eip
+  };
+  const size_t count =
+      sizeof(context_registers) / sizeof(context_registers[0]);
+  std::copy(context_registers, context_registers + count, registers);
+  return count;
+}
+
+static size_t GetStackRegisters(MDRawContextAMD64* context,
+                                uint64_t** registers) {
+  uint64_t* context_registers[] = {
+    &context->rax, &context->rbx, &context->rcx, &context->rdx,
+    &context->rsi, &context->rdi, &context->rbp, &context->rsp,
+    &context->r8, &context->r9, &context->r10, &context->r11,
+    &context->r12, &context->r13, &context->r14, &context->r15,
+    &context->rip
+  };
+  const size_t count =
+      sizeof(context_registers) / sizeof(context_registers[0]);
+  std::copy(context_registers, context_registers + count, registers);
+  return count;
+}
+
+static size_t GetStackRegisters(MDRawContextARM* context,
+                                uint32_t** registers) {
+  for (size_t i = 0; i < MD_CONTEXT_ARM_GPR_COUNT; ++i) {
+    registers[i] = &context->iregs[i];
+  }
+  return MD_CONTEXT_ARM_GPR_COUNT;
+}
+
+static size_t GetStackRegisters(MDRawContextARM64* context,
+                                uint64_t** registers) {
+  for (size_t i = 0; i < MD_CONTEXT_ARM64_GPR_COUNT; ++i) {
+    registers[i] = &context->iregs[i];
+  }
+  return MD_CONTEXT_ARM64_GPR_COUNT;
+}
+
+// Fills in the context fields of snapshot from a raw context.
+template<typename RawContext, typename Register>
+static void SnapshotContext(const RawContext* context,
+                            StackSnapshot* snapshot) {
+  RawContext other_state = *context;
+  Register* registers[kMaxStackRegisters];
+  size_t register_count = GetStackRegisters(&other_state, registers);
+  for (size_t i = 0; i < register_count; ++i) {
+    snapshot->registers.push_back(*registers[i]);
+    *registers[i] = 0;
+  }
+  snapshot->other_state.assign(reinterpret_cast<const char*>(&other_state),
+                               sizeof(other_state));
+  snapshot->word_size = sizeof(Register);
+}
+
+// Reads the word at address in memory.
+static bool ReadStackWord(const MemoryRegion* memory,
+                          uint64_t address,
+                          size_t word_size,
+                          uint64_t* word) {
+  if (word_size == sizeof(uint32_t)) {
+    uint32_t word32;
+    if (!memory->GetMemoryAtAddress(address, &word32))
+      return false;
+    *word = word32;
+    return true;
+  }
+  return memory->GetMemoryAtAddress(address, word);
+}
+
+// Returns true if address is in one of modules.
+static bool AddressInModule(const CodeModules* modules, uint64_t address) {
+  return modules && modules->GetModuleForAddress(address);
+}
+
+// Fills in snapshot for a thread with context and stack memory, and returns
+// a hash of it that is the same for threads whose stacks can be
+// deduplicated.  Returns false if stacks of the thread's CPU are not
+// deduplicated; it is left to be walked.
+static bool TakeStackSnapshot(const MinidumpContext* context,
+                              const MemoryRegion* memory,
+                              StackSnapshot* snapshot,
+                              size_t* hash) {
+  if (!context || !memory || memory->GetSize() == 0)
+    return false;
+
+  snapshot->cpu = context->GetContextCPU();
+  switch (snapshot->cpu) {
+    case MD_CONTEXT_X86:
+      SnapshotContext<MDRawContextX86, uint32_t>(context->GetContextX86(),
+                                                 snapshot);
+      break;
+    case MD_CONTEXT_AMD64:
+      SnapshotContext<MDRawContextAMD64, uint64_t>(context->GetContextAMD64(),
+                                                   snapshot);
+      break;
+    case MD_CONTEXT_ARM:
+      SnapshotContext<MDRawContextARM, uint32_t>(context->GetContextARM(),
+                                                 snapshot);
+      break;
+    case MD_CONTEXT_ARM64:
+      SnapshotContext<MDRawContextARM64, uint64_t>(context->GetContextARM64(),
+                                                   snapshot);
+      break;
+    default:
+      return false;
+  }
+
+  uint64_t base = memory->GetBase();
+  uint64_t size = memory->GetSize();
+  snapshot->memory = memory;
+  snapshot->low = base > size ? base - size : 0;
+  snapshot->high = base + 2 * size;
+  if (snapshot->high < base)
+    snapshot->high = std::numeric_limits<uint64_t>::max();
+
+  // Values that point into the stack are hashed relative to its base, and
+  // other values as they are.
+  size_t value_hash = std::hash<string>()(snapshot->other_state);
+  auto mix = [&](uint64_t value) {
+    value_hash = value_hash * 1000003 ^ std::hash<uint64_t>()(value);
+  };
+  auto hash_value = [&](uint64_t value) {
+    if (value >= snapshot->low && value < snapshot->high)
+      value = (value - base) ^ 0x9e3779b97f4a7c15ULL;
+    mix(value);
+  };
+  mix(snapshot->cpu);
+  mix(size);
+  mix(base % kStackDeduplicationAlignment);
+  for (uint64_t value : snapshot->registers) {
+    hash_value(value);
+  }
+  for (uint64_t offset = 0; offset + snapshot->word_size <= size;
+       offset += snapshot->word_size) {
+    uint64_t word;
+    if (!ReadStackWord(memory, base + offset, snapshot->word_size, &word))
+      return false;
+    hash_value(word);
+  }
+  *hash = value_hash;
+  return true;
+}
+
+// Returns true if a value from the stack or registers of thread b
+// corresponds to one from thread a: either both point to the same place in
+// their respective stacks, or both are the same value pointing elsewhere.
+// Stack addresses must not also be code addresses, as the stack walk treats
+// those differently.
+static bool StackValuesMatch(const StackSnapshot& a,
+                             uint64_t a_value,
+                             const StackSnapshot& b,
+                             uint64_t b_value,
+                             uint64_t delta,
+                             const CodeModules* modules,
+                             const CodeModules* unloaded_modules) {
+  if (a_value >= a.low && a_value < a.high) {
+    uint64_t mask = a.word_size == sizeof(uint32_t) ?
+        std::numeric_limits<uint32_t>::max() :
+        std::numeric_limits<uint64_t>::max();
+    return b_value == ((a_value + delta) & mask) &&
+           !AddressInModule(modules, a_value) &&
+           !AddressInModule(modules, b_value) &&
+           !AddressInModule(unloaded_modules, a_value) &&
+           !AddressInModule(unloaded_modules, b_value);
+  }
+  return a_value == b_value && (b_value < b.low || b_value >= b.high);
+}
+
+// Returns true if the stack of thread b is that of thread a moved by delta.
+static bool StacksMatch(const StackSnapshot& a,
+                        const StackSnapshot& b,
+                        const CodeModules* modules,
+                        const CodeModules* unloaded_modules,
+                        uint64_t* delta) {
+  uint64_t a_base = a.memory->GetBase();
+  uint64_t b_base = b.memory->GetBase();
+  uint64_t size = a.memory->GetSize();
+  *delta = b_base - a_base;
+  if (a.cpu != b.cpu || a.other_state != b.other_state ||
+      a.registers.size() != b.registers.size() ||
+      size != b.memory->GetSize() ||
+      *delta % kStackDeduplicationAlignment != 0) {
+    return false;
+  }
+
+  for (size_t i = 0; i < a.registers.size(); ++i) {
+    if (!StackValuesMatch(a, a.registers[i], b, b.registers[i], *delta,
+                          modules, unloaded_modules)) {
+      return false;
+    }
+  }
+
+  for (uint64_t offset = 0; offset < size; offset += a.word_size) {
+    // A trailing partial word is compared byte by byte.
+    if (offset + a.word_size > size) {
+      for (; offset < size; ++offset) {
+        uint8_t a_byte, b_byte;
+        if (!a.memory->GetMemoryAtAddress(a_base + offset, &a_byte) ||
+            !b.memory->GetMemoryAtAddress(b_base + offset, &b_byte) ||
+            a_byte != b_byte) {
+          return false;
+        }
+      }
+      break;
+    }
+    uint64_t a_word, b_word;
+    if (!ReadStackWord(a.memory, a_base + offset, a.word_size, &a_word) ||
+        !ReadStackWord(b.memory, b_base + offset, b.word_size, &b_word) ||
+        !StackValuesMatch(a, a_word, b, b_word, *delta, modules,
+                          unloaded_modules)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Copies frame, moving the register values in its context that are at least
+// low and less than high by delta.
+template<typename Frame, typename Register>
+static Frame* CopyRelocatedFrame(const Frame& frame,
+                                 uint64_t low,
+                                 uint64_t high,
+                                 uint64_t delta) {
+  Frame* copy = new Frame(frame);
+  Register* registers[kMaxStackRegisters];
+  size_t register_count = GetStackRegisters(&copy->context, registers);
+  for (size_t i = 0; i < register_count; ++i) {
+    if (*registers[i] >= low && *registers[i] < high)
+      *registers[i] = static_cast<Register>(*registers[i] + delta);
+  }
+  return copy;
+}
+
+// Appends the size bytes at data to key, preceded by their size, so that
+// the parts of a key can't run into each other.
+static void AppendToKey(const void* data, size_t size, string* key) {
+  uint64_t size64 = size;
+  key->append(reinterpret_cast<const char*>(&size64), sizeof(size64));
+  key->append(static_cast<const char*>(data), size);
+}
+
+static void AppendToKey(const string& value, string* key) {
+  AppendToKey(value.data(), value.size(), key);
+}
+
+static void AppendToKey(uint64_t value, string* key) {
+  key->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Appends what identifies each of modules to key, and adds its debug file
+// and identifier to module_set.
+static void AppendModulesToKey(const CodeModules* modules,
+                               string* key,
+                               StackWalkCache::ModuleSet* module_set) {
+  unsigned int count = modules ? modules->module_count() : 0;
+  AppendToKey(count, key);
+  for (unsigned int i = 0; i < count; ++i) {
+    const CodeModule* module = modules->GetModuleAtSequence(i);
+    AppendToKey(module->base_address(), key);
+    AppendToKey(module->size(), key);
+    AppendToKey(module->code_file(), key);
+    AppendToKey(module->code_identifier(), key);
+    AppendToKey(module->debug_file(), key);
+    AppendToKey(module->debug_identifier(), key);
+    module_set->insert(module->debug_file() + "/" +
+                       module->debug_identifier());
+  }
+}
+
+// Returns the part of the stack walk cache key of each of process_state's
+// threads that is the same for all of them, and sets module_set to its
+// modules.
+static string GetStackWalkCacheDumpKey(const ProcessState& process_state,
+                                       size_t symbolized_frame_limit,
+                                       const TerminalFrames* terminal_frames,
+                                       StackWalkCache::ModuleSet* module_set) {
+  string key;
+  const SystemInfo* system_info = process_state.system_info();
+  AppendToKey(system_info->os, &key);
+  AppendToKey(system_info->os_version, &key);
+  AppendToKey(system_info->cpu, &key);
+  AppendToKey(system_info->cpu_info, &key);
+  AppendToKey(symbolized_frame_limit, &key);
+  AppendToKey(terminal_frames ? terminal_frames->Key() : string(), &key);
+  AppendModulesToKey(process_state.modules(), &key, module_set);
+  AppendModulesToKey(process_state.unloaded_modules(), &key, module_set);
+  return key;
+}
+
+// Sets key to the stack walk cache key of a thread with context and stack
+// memory in a minidump whose key is dump_key.  Returns false if stacks of
+// the thread's CPU are not cached, or its stack can't be read.
+static bool GetStackWalkCacheKey(const string& dump_key,
+                                 const MinidumpContext* context,
+                                 const MemoryRegion* memory,
+                                 string* key) {
+  if (!context || !memory || memory->GetSize() == 0)
+    return false;
+
+  *key = dump_key;
+  uint32_t cpu = context->GetContextCPU();
+  AppendToKey(cpu, key);
+  switch (cpu) {
+    case MD_CONTEXT_X86:
+      AppendToKey(context->GetContextX86(), sizeof(MDRawContextX86), key);
+      break;
+    case MD_CONTEXT_AMD64:
+      AppendToKey(context->GetContextAMD64(), sizeof(MDRawContextAMD64), key);
+      break;
+    case MD_CONTEXT_ARM:
+      AppendToKey(context->GetContextARM(), sizeof(MDRawContextARM), key);
+      break;
+    case MD_CONTEXT_ARM64:
+      AppendToKey(context->GetContextARM64(), sizeof(MDRawContextARM64), key);
+      break;
+    default:
+      return false;
+  }
+
+  uint64_t base = memory->GetBase();
+  size_t size = memory->GetSize();
+  AppendToKey(base, key);
+  AppendToKey(size, key);
+  size_t offset = key->size();
+  key->resize(offset + size);
+  return memory->CopyOut(base, size,
+                         reinterpret_cast<uint8_t*>(&(*key)[offset]));
+}
+
+// Maps the modules of a minidump to the indexes StackWalkCache::Walk and
+// UnsymbolizedWalk refer to them by, and back.
+class StackWalkCacheModules {
+ public:
+  explicit StackWalkCacheModules(const ProcessState& process_state)
+      : modules_(process_state.modules()),
+        unloaded_modules_(process_state.unloaded_modules()),
+        module_count_(modules_ ? modules_->module_count() : 0),
+        indexes_built_(false) {}
+
+  // The number of modules, loaded and unloaded.
+  unsigned int count() const {
+    return module_count_ +
+           (unloaded_modules_ ? unloaded_modules_->module_count() : 0);
+  }
+
+  // Returns the index of module, or StackWalkCache::Walk::kNoModule.
+  int Index(const CodeModule* module) {
+    if (!module)
+      return StackWalkCache::Walk::kNoModule;
+    if (!indexes_built_) {
+      indexes_built_ = true;
+      for (unsigned int i = 0; i < module_count_; ++i)
+        indexes_[modules_->GetModuleAtSequence(i)] = i;
+      unsigned int unloaded_count =
+          unloaded_modules_ ? unloaded_modules_->module_count() : 0;
+      for (unsigned int i = 0; i < unloaded_count; ++i) {
+        indexes_[unloaded_modules_->GetModuleAtSequence(i)] =
+            module_count_ + i;
+      }
+    }
+    auto index = indexes_.find(module);
+    return index == indexes_.end() ? StackWalkCache::Walk::kNoModule :
+                                     index->second;
+  }
+
+  // Returns the module at index, or NULL.
+  const CodeModule* Module(int index) const {
+    if (index == StackWalkCache::Walk::kNoModule)
+      return NULL;
+    if (static_cast<unsigned int>(index) < module_count_)
+      return modules_->GetModuleAtSequence(index);
+    return unloaded_modules_->GetModuleAtSequence(index - module_count_);
+  }
+
+ private:
+  const CodeModules* modules_;
+  const CodeModules* unloaded_modules_;
+  unsigned int module_count_;
+  bool indexes_built_;
+  std::unordered_map<const CodeModule*, int> indexes_;
+};
+
+// A thread whose stack was not in the stack walk cache, to be kept there
+// once it has been walked.
+struct StackWalkCacheMiss {
+  StackWalkCacheMiss() : stack(NULL), pending_walk(-1), interrupted(false) {}
+
+  string key;
+  CallStack* stack;
+  // The index in the pending walks of the thread's walk, or -1 if it was
+  // walked right away.
+  int pending_walk;
+  vector<const CodeModule*> modules_without_symbols;
+  vector<const CodeModule*> modules_with_corrupt_symbols;
+  bool interrupted;
+};
+
+}  // namespace
+
+// static
+void MinidumpProcessor::CopyRelocatedStack(const CallStack& source,
+                                           uint64_t low,
+                                           uint64_t high,
+                                           uint64_t delta,
+                                           CallStack* destination) {
+  uint32_t tid = destination->tid();
+  destination->Clear();
+  destination->set_tid(tid);
+  destination->set_truncated(source.truncated());
+  destination->set_ended_at_terminal_frame(source.ended_at_terminal_frame());
+  CallStack::FrameAllocationScope frame_allocation_scope(destination);
+  for (const StackFrame* frame : source.frames_) {
+    StackFrame* copy;
+    if (const StackFrameX86* x86 = dynamic_cast<const StackFrameX86*>(frame)) {
+      StackFrameX86* x86_copy =
+          CopyRelocatedFrame<StackFrameX86, uint32_t>(*x86, low, high, delta);
+      // The frame info belongs to the source frame, and is only used while
+      // walking the stack.
+      x86_copy->windows_frame_info = NULL;
+      x86_copy->cfi_frame_info = NULL;
+      copy = x86_copy;
+    } else if (const StackFrameAMD64* amd64 =
+                   dynamic_cast<const StackFrameAMD64*>(frame)) {
+      copy = CopyRelocatedFrame<StackFrameAMD64, uint64_t>(*amd64, low, high,
+                                                           delta);
+    } else if (const StackFrameARM* arm =
+                   dynamic_cast<const StackFrameARM*>(frame)) {
+      copy = CopyRelocatedFrame<StackFrameARM, uint32_t>(*arm, low, high,
+                                                         delta);
+    } else if (const StackFrameARM64* arm64 =
+                   dynamic_cast<const StackFrameARM64*>(frame)) {
+      copy = CopyRelocatedFrame<StackFrameARM64, uint64_t>(*arm64, low, high,
+                                                           delta);
+    } else {
+      // Inlined frames have no context.
+      copy = new StackFrame(*frame);
+    }
+    destination->frames_.push_back(copy);
+  }
+}
+
+// Walks the stack described by context and memory into stack, within
+// time_limits, symbolizing up to symbolized_frame_limit frames if it is not
+// zero and stopping after a frame listed by terminal_frames if it is not
+// NULL.  Returns false if the walk was interrupted, in which case it should
+// be retried later.
+static bool WalkThread(ProcessState* process_state,
+                       MinidumpContext* context,
+                       MemoryRegion* memory,
+                       DumpUnwindTables* unwind_tables,
+                       const string& thread_string,
+                       StackFrameSymbolizer* frame_symbolizer,
+                       const WalkTimeLimits& time_limits,
+                       size_t symbolized_frame_limit,
+                       const TerminalFrames* terminal_frames,
+                       CallStack* stack,
+                       vector<const CodeModule*>* modules_without_symbols,
+                       vector<const CodeModule*>* modules_with_corrupt_symbols) {
+  WalkTimeLimits::Clock::time_point deadline;
+  if (!time_limits.ThreadDeadline(&deadline)) {
+    BPLOG(INFO) << "No time left to walk " << thread_string;
+    stack->Clear();
+    stack->set_truncated(true);
+    return true;
+  }
+
+  // Use process_state->modules_ instead of module_list, because the
+  // |modules| argument will be used to populate the |module| fields in
+  // the returned StackFrame objects, which will be placed into the
+  // returned ProcessState object.  module_list's lifetime is only as
+  // long as the Minidump object: it will be deleted when Process
+  // returns.  process_state->modules_ is owned by the ProcessState object
+  // (just like the StackFrame objects), and is much more suitable for this
+  // task.
+  scoped_ptr<Stackwalker> stackwalker(
+      Stackwalker::StackwalkerForCPU(process_state->system_info(),
+                                     context,
+                                     memory,
+                                     process_state->modules(),
+                                     process_state->unloaded_modules(),
+                                     frame_symbolizer));
+  if (!stackwalker.get()) {
+    // Threads with missing CPU contexts will hit this, but
+    // don't abort processing the rest of the dump just for
+    // one bad thread.
+    BPLOG(ERROR) << "No stackwalker for " << thread_string;
+    return true;
+  }
+  if (time_limits.limited())
+    stackwalker->set_deadline(deadline);
+  if (unwind_tables) {
+    if (process_state->system_info()->os_short == "windows") {
+      stackwalker->set_windows_unwind_tables(&unwind_tables->windows_tables);
+    } else {
+      stackwalker->set_eh_frame_unwind_tables(
+          &unwind_tables->eh_frame_tables);
+    }
+  }
+  if (symbolized_frame_limit)
+    stackwalker->set_symbolized_frame_limit(symbolized_frame_limit);
+  stackwalker->set_terminal_frames(terminal_frames);
+
+  if (!stackwalker->Walk(stack, modules_without_symbols,
+                         modules_with_corrupt_symbols)) {
+    BPLOG(INFO) << "Stackwalker interrupt (missing symbols?) at "
+                << thread_string;
+    return false;
+  }
+  return true;
+}
+
+// Returns true if walk was recorded from a minidump with the modules
+// listed by modules.
+static bool UnsymbolizedWalkMatches(const UnsymbolizedWalk& walk,
+                                    const StackWalkCacheModules& modules) {
+  if (walk.modules().size() != modules.count())
+    return false;
+  for (unsigned int i = 0; i < modules.count(); ++i) {
+    const UnsymbolizedWalk::Module& walk_module = walk.modules()[i];
+    const CodeModule* module = modules.Module(i);
+    if (!module || walk_module.base_address != module->base_address() ||
+        walk_module.size != module->size() ||
+        walk_module.debug_file != module->debug_file() ||
+        walk_module.debug_identifier != module->debug_identifier()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Rebuilds the stack of thread, as recorded in walk, from context and
+// memory into stack, and symbolizes it, symbolizing up to
+// symbolized_frame_limit frames if it is not zero and dropping the frames
+// after one listed by terminal_frames if it is not NULL.  Returns false,
+// leaving the thread to be walked, if there is no stackwalker for it or any
+// of its frames is in a module that had no symbols when walk was recorded
+// and has them now.  Sets interrupted if the symbolizer was interrupted.
+static bool ResymbolizeThread(
+    ProcessState* process_state,
+    const UnsymbolizedWalk& walk,
+    const UnsymbolizedWalk::Thread& thread,
+    const StackWalkCacheModules& modules,
+    MinidumpContext* context,
+    MemoryRegion* memory,
+    StackFrameSymbolizer* frame_symbolizer,
+    size_t symbolized_frame_limit,
+    const TerminalFrames* terminal_frames,
+    CallStack* stack,
+    vector<const CodeModule*>* modules_without_symbols,
+    vector<const CodeModule*>* modules_with_corrupt_symbols,
+    bool* interrupted) {
+  scoped_ptr<Stackwalker> stackwalker(
+      Stackwalker::StackwalkerForCPU(process_state->system_info(),
+                                     context,
+                                     memory,
+                                     process_state->modules(),
+                                     process_state->unloaded_modules(),
+                                     frame_symbolizer));
+  if (!stackwalker.get())
+    return false;
+  if (symbolized_frame_limit)
+    stackwalker->set_symbolized_frame_limit(symbolized_frame_limit);
+  stackwalker->set_terminal_frames(terminal_frames);
+
+  vector<StackFrame> frames(thread.frames.size());
+  for (size_t i = 0; i < frames.size(); ++i) {
+    const UnsymbolizedWalk::Frame& walk_frame = thread.frames[i];
+    const CodeModule* module = modules.Module(walk_frame.module);
+    frames[i].instruction =
+        walk_frame.offset + (module ? module->base_address() : 0);
+    frames[i].trust = walk_frame.trust;
+  }
+  *interrupted = !stackwalker->Resymbolize(frames, stack,
+                                           modules_without_symbols,
+                                           modules_with_corrupt_symbols);
+  if (*interrupted)
+    return true;
+
+  std::unordered_set<const CodeModule*> still_without_symbols(
+      modules_without_symbols->begin(), modules_without_symbols->end());
+  for (const UnsymbolizedWalk::Frame& walk_frame : thread.frames) {
+    const CodeModule* module = modules.Module(walk_frame.module);
+    if (module && walk.ModuleLackedCFI(walk_frame.module) &&
+        still_without_symbols.count(module) == 0) {
+      BPLOG(INFO) << "Walking again through " << module->debug_file()
+                  << ", which has symbols now";
+      modules_without_symbols->clear();
+      modules_with_corrupt_symbols->clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+// Adds the frames of process_state's threads to the counts by trust in
+// stats.
+static void CountFrames(const ProcessState& process_state,
+                        ProcessingStats* stats) {
+  uint64_t frame_counts[ProcessingStats::kFrameTrustCount] = {};
+  for (const CallStack* stack : *process_state.threads()) {
+    for (const StackFrame* frame : *stack->frames()) {
+      if (frame->trust >= 0 &&
+          frame->trust < ProcessingStats::kFrameTrustCount) {
+        ++frame_counts[frame->trust];
+      }
+    }
+  }
+  for (int trust = 0; trust < ProcessingStats::kFrameTrustCount; ++trust) {
+    if (frame_counts[trust] > 0) {
+      stats->AddFrames(static_cast<StackFrame::FrameTrust>(trust),
+                       frame_counts[trust]);
+    }
+  }
+}
+
+// Walks the stacks of walks on up to concurrency worker threads, or on
+// this thread if concurrency is 1, beginning with walks[first_walk] if
+// there is one.  Each walk records its results in its own ThreadWalk.  If
+// observer is not NULL, it is given each stack as its walk completes, one
+// at a time.
+static void WalkThreadsConcurrently(ProcessState* process_state,
+                                    StackFrameSymbolizer* frame_symbolizer,
+                                    ProcessStateObserver* observer,
+                                    const WalkTimeLimits& time_limits,
+                                    size_t symbolized_frame_limit,
+                                    const TerminalFrames* terminal_frames,
+                                    int concurrency,
+                                    size_t first_walk,
+                                    vector<ThreadWalk>* walks) {
+  vector<size_t> walk_order;
+  walk_order.reserve(walks->size());
+  if (first_walk < walks->size())
+    walk_order.push_back(first_walk);
+  for (size_t index = 0; index < walks->size(); ++index) {
+    if (index != first_walk)
+      walk_order.push_back(index);
+  }
+
+  std::atomic<size_t> next_walk(0);
+  std::mutex observer_mutex;
+  auto walk_threads = [&]() {
+    for (size_t order = next_walk++; order < walk_order.size();
+         order = next_walk++) {
+      ThreadWalk& walk = (*walks)[walk_order[order]];
+      walk.interrupted = !WalkThread(process_state, walk.context, walk.memory,
+                                     walk.unwind_tables, walk.thread_string,
+                                     frame_symbolizer, time_limits,
+                                     symbolized_frame_limit, terminal_frames,
+                                     walk.stack,
+                                     &walk.modules_without_symbols,
+                                     &walk.modules_with_corrupt_symbols);
+      if (observer) {
+        // Walk clears the stack, thread ID included.
+        walk.stack->set_tid(walk.thread_id);
+        std::lock_guard<std::mutex> lock(observer_mutex);
+        observer->OnThread(walk.thread_index, *walk.stack);
+      }
+    }
+  };
+
+  size_t worker_count =
+      std::min(static_cast<size_t>(concurrency), walks->size());
+  if (worker_count <= 1) {
+    walk_threads();
+    return;
+  }
+  ProcessingStats* stats = ProcessingStats::current();
+  auto worker = [&]() {
+    ScopedWorkerStats worker_stats(stats, ProcessingStats::PHASE_WALK);
+    walk_threads();
+  };
+  vector<std::thread> workers;
+  workers.reserve(worker_count);
+  for (size_t worker_index = 0; worker_index < worker_count; ++worker_index) {
+    workers.push_back(std::thread(worker));
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+namespace {
+
+// Walks the threads whose walks Process deferred, from the Minidump that
+// they were found in.
+class MinidumpDeferredThreadWalker : public DeferredThreadWalker {
+ public:
+  MinidumpDeferredThreadWalker(
+      ProcessState* process_state,
+      StackFrameSymbolizer* frame_symbolizer,
+      std::shared_ptr<DumpUnwindTables> unwind_tables,
+      double thread_walk_time_limit,
+      size_t symbolized_frame_limit,
+      const TerminalFrames* terminal_frames)
+      : process_state_(process_state),
+        frame_symbolizer_(frame_symbolizer),
+        unwind_tables_(unwind_tables),
+        thread_walk_time_limit_(thread_walk_time_limit),
+        symbolized_frame_limit_(symbolized_frame_limit),
+        terminal_frames_(terminal_frames) {}
+
+  // Defers walk, whose thread_index is its key.
+  void Add(const ThreadWalk& walk) { walks_[walk.thread_index] = walk; }
+
+  bool empty() const { return walks_.empty(); }
+
+  vector<int> thread_indices() const {
+    vector<int> thread_indices;
+    for (const auto& walk : walks_)
+      thread_indices.push_back(walk.first);
+    return thread_indices;
+  }
 
+  virtual bool Walk(int thread_index,
+                    CallStack* stack,
+                    vector<const CodeModule*>* modules_without_symbols,
+                    vector<const CodeModule*>* modules_with_corrupt_symbols) {
+    std::map<int, ThreadWalk>::const_iterator walk = walks_.find(thread_index);
+    if (walk == walks_.end())
+      return true;
+    WalkTimeLimits time_limits(0, thread_walk_time_limit_);
+    bool walked = WalkThread(process_state_, walk->second.context,
+                             walk->second.memory, walk->second.unwind_tables,
+                             walk->second.thread_string,
+                             frame_symbolizer_, time_limits,
+                             symbolized_frame_limit_, terminal_frames_, stack,
+                             modules_without_symbols,
+                             modules_with_corrupt_symbols);
+    // Walk clears the stack, thread ID included.
+    stack->set_tid(walk->second.thread_id);
+    return walked;
+  }
+
+ private:
+  ProcessState* process_state_;
+  StackFrameSymbolizer* frame_symbolizer_;
+  // Kept for the deferred walks, which the tables outlive.
+  std::shared_ptr<DumpUnwindTables> unwind_tables_;
+  double thread_walk_time_limit_;
+  size_t symbolized_frame_limit_;
+  const TerminalFrames* terminal_frames_;
+  std::map<int, ThreadWalk> walks_;
+};
+
+// Runs the exploitability analysis that Process deferred.
+class MinidumpDeferredExploitability : public DeferredExploitability {
+ public:
+  // Takes ownership of exploitability.
+  explicit MinidumpDeferredExploitability(Exploitability* exploitability)
+      : exploitability_(exploitability) {}
+
+  virtual ExploitabilityRating Analyze() {
+    return exploitability_->CheckExploitability();
+  }
+
+ private:
+  scoped_ptr<Exploitability> exploitability_;
+};
+
+}  // namespace
+
+// Fetches and loads the symbols for the modules of process_state,
+// beginning with the modules containing the instruction pointers of the
+// crash and of threads.  Up to concurrency modules are fetched at once, on
+// worker threads or, if async is set, through asynchronous requests.
+static void PrefetchSymbols(MinidumpThreadList* threads,
+                            MinidumpException* exception,
+                            ProcessState* process_state,
+                            StackFrameSymbolizer* frame_symbolizer,
+                            int concurrency,
+                            bool async) {
+  const CodeModules* modules = process_state->modules();
+  vector<const CodeModule*> prefetch_modules;
+  std::set<const CodeModule*> seen_modules;
+  auto add_module = [&](const CodeModule* module) {
+    if (module && seen_modules.insert(module).second)
+      prefetch_modules.push_back(module);
+  };
+  auto add_module_for_context = [&](const MinidumpContext* context) {
+    uint64_t instruction_pointer;
+    if (context && context->GetInstructionPointer(&instruction_pointer))
+      add_module(modules->GetModuleForAddress(instruction_pointer));
+  };
+
+  if (exception)
+    add_module_for_context(exception->GetContext());
+  for (unsigned int thread_index = 0; thread_index < threads->thread_count();
+       ++thread_index) {
+    MinidumpThread* thread = threads->GetThreadAtIndex(thread_index);
+    if (thread)
+      add_module_for_context(thread->GetContext());
+  }
+  size_t pc_module_count = prefetch_modules.size();
+  for (unsigned int module_index = 0; module_index < modules->module_count();
+       ++module_index) {
+    add_module(modules->GetModuleAtIndex(module_index));
+  }
+  BPLOG(INFO) << "Prefetching symbols for " << prefetch_modules.size()
+              << " modules, " << pc_module_count
+              << " of them containing thread instruction pointers";
+
+  if (async) {
+    frame_symbolizer->PrefetchModulesAsync(
+        prefetch_modules, process_state->system_info(), concurrency);
+    return;
+  }
+
+  // An interrupted fetch will interrupt the walk too, so there is no point
+  // in fetching more.
+  std::atomic<size_t> next_module(0);
+  std::atomic<bool> interrupted(false);
+  ProcessingStats* stats = ProcessingStats::current();
+  auto prefetch = [&]() {
+    ScopedWorkerStats worker_stats(stats,
+                                   ProcessingStats::PHASE_SYMBOL_PREFETCH);
+    for (size_t index = next_module++;
+         index < prefetch_modules.size() && !interrupted;
+         index = next_module++) {
+      if (frame_symbolizer->PrefetchModule(prefetch_modules[index],
+                                           process_state->system_info()) ==
+          StackFrameSymbolizer::kInterrupt) {
+        interrupted = true;
+      }
+    }
+  };
+
+  size_t worker_count =
+      std::min(static_cast<size_t>(concurrency), prefetch_modules.size());
+  vector<std::thread> workers;
+  workers.reserve(worker_count);
+  for (size_t worker_index = 0; worker_index < worker_count; ++worker_index) {
+    workers.push_back(std::thread(prefetch));
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+ProcessResult MinidumpProcessor::FillDumpInfo(Minidump* dump,
+                                              ProcessState* process_state,
+                                              DumpInfo* info) {
   const MDRawHeader* header = dump->header();
   if (!header) {
     BPLOG(ERROR) << "Minidump " << dump->path() << " has no header";
@@ -110,28 +1232,27 @@ ProcessResult MinidumpProcessor::Process(
   }
   process_state->time_date_stamp_ = header->time_date_stamp;
 
-  bool has_process_create_time =
+  info->has_process_create_time =
       GetProcessCreateTime(dump, &process_state->process_create_time_);
 
-  bool has_cpu_info = GetCPUInfo(dump, &process_state->system_info_);
-  bool has_os_info = GetOSInfo(dump, &process_state->system_info_);
-
-  uint32_t dump_thread_id = 0;
-  bool has_dump_thread = false;
-  uint32_t requesting_thread_id = 0;
-  bool has_requesting_thread = false;
+  info->has_cpu_info = GetCPUInfo(dump, &process_state->system_info_);
+  info->has_os_info = GetOSInfo(dump, &process_state->system_info_);
 
   MinidumpBreakpadInfo* breakpad_info = dump->GetBreakpadInfo();
+  info->breakpad_info = breakpad_info;
   if (breakpad_info) {
-    has_dump_thread = breakpad_info->GetDumpThreadID(&dump_thread_id);
-    has_requesting_thread =
-        breakpad_info->GetRequestingThreadID(&requesting_thread_id);
+    info->has_dump_thread =
+        breakpad_info->GetDumpThreadID(&info->dump_thread_id);
+    info->has_requesting_thread =
+        breakpad_info->GetRequestingThreadID(&info->requesting_thread_id);
   }
 
   MinidumpException* exception = dump->GetException();
+  info->exception = exception;
   if (exception) {
     process_state->crashed_ = true;
-    has_requesting_thread = exception->GetThreadID(&requesting_thread_id);
+    info->has_requesting_thread =
+        exception->GetThreadID(&info->requesting_thread_id);
 
     process_state->crash_reason_ = GetCrashReason(
         dump, &process_state->crash_address_, enable_objdump_);
@@ -161,13 +1282,64 @@ ProcessResult MinidumpProcessor::Process(
   // This will just return an empty string if it doesn't exist.
   process_state->assertion_ = GetAssertion(dump);
 
+  MinidumpDumpTiming* dump_timing = dump->GetDumpTiming();
+  if (dump_timing && dump_timing->phases())
+    process_state->dump_phases_ = *dump_timing->phases();
+
+  return PROCESS_OK;
+}
+
+ProcessResult MinidumpProcessor::ProcessTriage(Minidump* dump,
+                                               ProcessState* process_state) {
+  assert(dump);
+  assert(process_state);
+
+  process_state->Clear();
+
+  DumpInfo info;
+  ProcessResult result = FillDumpInfo(dump, process_state, &info);
+  if (result != PROCESS_OK)
+    return result;
+
+  BPLOG(INFO) << "Triaged " << dump->path();
+  return PROCESS_OK;
+}
+
+ProcessResult MinidumpProcessor::Process(
+    Minidump* dump, ProcessState* process_state) {
+  assert(dump);
+  assert(process_state);
+
+  process_state->Clear();
+
+  ProcessingStats* stats = collect_stats_ ? &process_state->stats_ : NULL;
+  ScopedProcessingStats scoped_stats(stats);
+  PhaseTimer phase_timer(stats);
+  phase_timer.Start(ProcessingStats::PHASE_SYSTEM_INFO);
+
+  DumpInfo info;
+  ProcessResult result = FillDumpInfo(dump, process_state, &info);
+  if (result != PROCESS_OK)
+    return result;
+  bool has_process_create_time = info.has_process_create_time;
+  bool has_cpu_info = info.has_cpu_info;
+  bool has_os_info = info.has_os_info;
+  MinidumpBreakpadInfo* breakpad_info = info.breakpad_info;
+  MinidumpException* exception = info.exception;
+  uint32_t dump_thread_id = info.dump_thread_id;
+  bool has_dump_thread = info.has_dump_thread;
+  uint32_t requesting_thread_id = info.requesting_thread_id;
+  bool has_requesting_thread = info.has_requesting_thread;
+
+  phase_timer.Start(ProcessingStats::PHASE_READ);
   MinidumpModuleList* module_list = dump->GetModuleList();
 
   // Put a copy of the module list into ProcessState object.  This is not
   // necessarily a MinidumpModuleList, but it adheres to the CodeModules
-  // interface, which is all that ProcessState needs to expose.
+  // interface, which is all that ProcessState needs to expose.  The copy is
+  // made once per dump and shared by every ProcessState made from it.
   if (module_list) {
-    process_state->modules_ = module_list->Copy();
+    process_state->modules_ = module_list->GetSharedCopy();
     process_state->shrunk_range_modules_ =
         process_state->modules_->GetShrunkRangeModules();
     for (unsigned int i = 0;
@@ -184,7 +1356,7 @@ ProcessResult MinidumpProcessor::Process(
   MinidumpUnloadedModuleList* unloaded_module_list =
       dump->GetUnloadedModuleList();
   if (unloaded_module_list) {
-    process_state->unloaded_modules_ = unloaded_module_list->Copy();
+    process_state->unloaded_modules_ = unloaded_module_list->GetSharedCopy();
   }
 
   MinidumpMemoryList* memory_list = dump->GetMemoryList();
@@ -210,14 +1382,56 @@ ProcessResult MinidumpProcessor::Process(
       (has_requesting_thread   ? "" : "no ") << "requesting thread, and " <<
       (has_process_create_time ? "" : "no ") << "process create time";
 
+  if (observer_)
+    observer_->OnProcessInfo(*process_state);
+
   bool interrupted = false;
   bool found_requesting_thread = false;
+  // Threads whose stacks are walked once every thread has been found, on
+  // the worker pool when walk_concurrency_ is greater than 1.
+  vector<ThreadWalk> pending_walks;
+  // x64 Windows images carry unwind information of their own, and Linux
+  // images their .eh_frame, which stand in for symbols if the dump has
+  // that part of the images' memory.
+  std::shared_ptr<DumpUnwindTables> unwind_tables;
+  const string& os = process_state->system_info_.os_short;
+  const string& cpu = process_state->system_info_.cpu;
+  if ((os == "windows" && cpu == "amd64") ||
+      ((os == "linux" || os == "android") &&
+       (cpu == "amd64" || cpu == "arm64"))) {
+    MinidumpMemory64List* memory64_list = dump->GetMemory64List();
+    if (memory_list || memory64_list) {
+      unwind_tables =
+          std::make_shared<DumpUnwindTables>(memory_list, memory64_list);
+    }
+  }
+  // Threads whose walks are left to the ProcessState, when
+  // defer_thread_walks_ is set.
+  scoped_ptr<MinidumpDeferredThreadWalker> deferred_walker;
+  if (defer_thread_walks_) {
+    deferred_walker.reset(new MinidumpDeferredThreadWalker(
+        process_state, frame_symbolizer_, unwind_tables,
+        thread_walk_time_limit_, symbolized_frame_limit_, terminal_frames_));
+  }
+  // Threads whose stacks may be copied by later threads, by hash, and the
+  // threads whose stacks are copied, when deduplicate_stacks_ is set.
+  vector<StackSnapshot> stack_snapshots;
+  std::unordered_multimap<size_t, size_t> stack_snapshot_indices;
+  vector<DuplicateStack> duplicate_stacks;
   unsigned int thread_count = threads->thread_count();
   process_state->original_thread_count_ = thread_count;
 
   // Reset frame_symbolizer_ at the beginning of stackwalk for each minidump.
   frame_symbolizer_->Reset();
 
+  if (symbol_prefetch_concurrency_ > 0 && process_state->modules_ &&
+      frame_symbolizer_->HasImplementation()) {
+    phase_timer.Start(ProcessingStats::PHASE_SYMBOL_PREFETCH);
+    PrefetchSymbols(threads, exception, process_state, frame_symbolizer_,
+                    symbol_prefetch_concurrency_, async_symbol_prefetch_);
+  }
+
+  phase_timer.Start(ProcessingStats::PHASE_READ);
   MinidumpThreadNameList* thread_names = dump->GetThreadNameList();
   std::map<uint32_t, string> thread_id_to_name;
   if (thread_names) {
@@ -242,6 +1456,37 @@ ProcessResult MinidumpProcessor::Process(
     }
   }
 
+  // The part of the stack walk cache keys that is the same for every
+  // thread, and the threads to keep walks of in the cache once walked.
+  bool use_stack_walk_cache = stack_walk_cache_ && !defer_thread_walks_;
+  string stack_walk_cache_dump_key;
+  std::shared_ptr<StackWalkCache::ModuleSet> stack_walk_cache_modules(
+      new StackWalkCache::ModuleSet);
+  StackWalkCacheModules cache_modules(*process_state);
+  vector<StackWalkCacheMiss> stack_walk_cache_misses;
+  int cached_stack_count = 0;
+  if (use_stack_walk_cache) {
+    stack_walk_cache_dump_key = GetStackWalkCacheDumpKey(
+        *process_state, symbolized_frame_limit_, terminal_frames_,
+        stack_walk_cache_modules.get());
+  }
+
+  // The walk Resymbolize is rebuilding stacks from, if it was recorded from
+  // a minidump with this one's modules.
+  const UnsymbolizedWalk* unsymbolized_walk = NULL;
+  int resymbolized_stack_count = 0;
+  if (unsymbolized_walk_) {
+    if (UnsymbolizedWalkMatches(*unsymbolized_walk_, cache_modules)) {
+      unsymbolized_walk = unsymbolized_walk_;
+    } else {
+      BPLOG(ERROR) << "Unsymbolized walk does not match the modules of "
+                   << dump->path() << ", walking every thread";
+    }
+  }
+
+  phase_timer.Start(ProcessingStats::PHASE_WALK);
+  WalkTimeLimits time_limits(walk_time_limit_, thread_walk_time_limit_);
+  time_limits.Start();
   for (unsigned int thread_index = 0;
        thread_index < thread_count;
        ++thread_index) {
@@ -324,12 +1569,25 @@ ProcessResult MinidumpProcessor::Process(
     // If the memory region for the stack cannot be read using the RVA stored
     // in the memory descriptor inside MINIDUMP_THREAD, try to locate and use
     // a memory region (containing the stack) from the minidump memory list.
-    MinidumpMemoryRegion* thread_memory = thread->GetMemory();
-    if (!thread_memory && memory_list) {
+    // Full-memory dumps carry their memory, stacks included, in the 64-bit
+    // memory list instead.
+    MinidumpMemoryRegion* minidump_memory = thread->GetMemory();
+    MemoryRegion* thread_memory = minidump_memory;
+    if (!thread_memory) {
       uint64_t start_stack_memory_range = thread->GetStartOfStackMemoryRange();
       if (start_stack_memory_range) {
-        thread_memory = memory_list->GetMemoryRegionForAddress(
-           start_stack_memory_range);
+        if (memory_list) {
+          minidump_memory = memory_list->GetMemoryRegionForAddress(
+             start_stack_memory_range);
+          thread_memory = minidump_memory;
+        }
+        if (!thread_memory) {
+          MinidumpMemory64List* memory64_list = dump->GetMemory64List();
+          if (memory64_list) {
+            thread_memory = memory64_list->GetMemoryRegionForAddress(
+                start_stack_memory_range);
+          }
+        }
       }
     }
     if (!thread_memory) {
@@ -344,35 +1602,218 @@ ProcessResult MinidumpProcessor::Process(
     // returns.  process_state->modules_ is owned by the ProcessState object
     // (just like the StackFrame objects), and is much more suitable for this
     // task.
-    scoped_ptr<Stackwalker> stackwalker(
-        Stackwalker::StackwalkerForCPU(process_state->system_info(),
-                                       context,
-                                       thread_memory,
-                                       process_state->modules_,
-                                       process_state->unloaded_modules_,
-                                       frame_symbolizer_));
-
-    scoped_ptr<CallStack> stack(new CallStack());
-    if (stackwalker.get()) {
-      if (!stackwalker->Walk(stack.get(),
-                             &process_state->modules_without_symbols_,
-                             &process_state->modules_with_corrupt_symbols_)) {
-        BPLOG(INFO) << "Stackwalker interrupt (missing symbols?) at "
-                    << thread_string;
-        interrupted = true;
+    scoped_ptr<CallStack> stack(process_state->NewThread());
+    if (enable_frame_arenas_)
+      stack->EnableFrameArena();
+    StackSnapshot snapshot;
+    size_t snapshot_hash;
+    bool duplicate = false;
+    if (deduplicate_stacks_ && !defer_thread_walks_ &&
+        TakeStackSnapshot(context, thread_memory, &snapshot, &snapshot_hash)) {
+      auto candidates = stack_snapshot_indices.equal_range(snapshot_hash);
+      for (auto candidate = candidates.first;
+           candidate != candidates.second && !duplicate; ++candidate) {
+        const StackSnapshot& source = stack_snapshots[candidate->second];
+        DuplicateStack duplicate_stack;
+        if (StacksMatch(source, snapshot, process_state->modules(),
+                        process_state->unloaded_modules(),
+                        &duplicate_stack.delta)) {
+          duplicate_stack.source = source.stack;
+          duplicate_stack.low = source.low;
+          duplicate_stack.high = source.high;
+          duplicate_stack.stack = stack.get();
+          duplicate_stack.thread_index = process_state->threads_.size();
+          duplicate_stacks.push_back(duplicate_stack);
+          duplicate = true;
+        }
+      }
+      if (!duplicate) {
+        snapshot.stack = stack.get();
+        stack_snapshot_indices.insert(
+            std::make_pair(snapshot_hash, stack_snapshots.size()));
+        stack_snapshots.push_back(snapshot);
+      }
+    }
+
+    // A stack recorded in the unsymbolized walk is rebuilt right away.
+    bool resymbolized = false;
+    size_t walk_thread_index = process_state->threads_.size();
+    if (unsymbolized_walk && !duplicate &&
+        walk_thread_index < unsymbolized_walk->threads().size() &&
+        unsymbolized_walk->threads()[walk_thread_index].thread_id ==
+            thread_id &&
+        unsymbolized_walk->threads()[walk_thread_index].complete) {
+      vector<const CodeModule*> modules_without_symbols;
+      vector<const CodeModule*> modules_with_corrupt_symbols;
+      bool resymbolize_interrupted = false;
+      resymbolized = ResymbolizeThread(
+          process_state, *unsymbolized_walk,
+          unsymbolized_walk->threads()[walk_thread_index], cache_modules,
+          context, thread_memory, frame_symbolizer_, symbolized_frame_limit_,
+          terminal_frames_, stack.get(), &modules_without_symbols,
+          &modules_with_corrupt_symbols, &resymbolize_interrupted);
+      if (resymbolized) {
+        if (resymbolize_interrupted)
+          interrupted = true;
+        process_state->MergeWalkModules(modules_without_symbols,
+                                        modules_with_corrupt_symbols);
+        ++resymbolized_stack_count;
       }
-    } else {
-      // Threads with missing CPU contexts will hit this, but
-      // don't abort processing the rest of the dump just for
-      // one bad thread.
-      BPLOG(ERROR) << "No stackwalker for " << thread_string;
+    }
+
+    // A stack kept in the cache is copied right away.
+    bool cached = false;
+    StackWalkCacheMiss cache_miss;
+    bool missed_cache = false;
+    if (use_stack_walk_cache && !duplicate && !resymbolized &&
+        GetStackWalkCacheKey(stack_walk_cache_dump_key, context,
+                             thread_memory, &cache_miss.key)) {
+      std::shared_ptr<const StackWalkCache::Walk> walk =
+          stack_walk_cache_->Lookup(cache_miss.key);
+      if (walk) {
+        CopyRelocatedStack(walk->stack, 0, 0, 0, stack.get());
+        for (size_t i = 0; i < walk->frame_modules.size(); ++i) {
+          stack->frames_[i]->module =
+              cache_modules.Module(walk->frame_modules[i]);
+        }
+        cached = true;
+        ++cached_stack_count;
+      } else {
+        missed_cache = true;
+      }
+    }
+
+    // A duplicate stack is copied once its source thread has been walked.
+    // A MinidumpMemoryRegion reads its contents from the minidump file on
+    // first use, so that read is done here rather than on a worker.  A
+    // region whose contents can't be read would try again on every access,
+    // and is walked right away instead.  Under a time limit, serial walks
+    // wait too, so that the requesting thread can be walked first.  Walks
+    // are deferred on the same terms as they are left to workers.
+    bool deferred = defer_thread_walks_ && !resymbolized &&
+                    !(has_requesting_thread &&
+                      thread_id == requesting_thread_id) &&
+                    (!minidump_memory || minidump_memory->GetMemory());
+    bool pending = !duplicate && !cached && !resymbolized && !deferred &&
+                   (walk_concurrency_ > 1 ?
+                        !minidump_memory || minidump_memory->GetMemory() :
+                        time_limits.limited());
+    if (deferred || pending) {
+      ThreadWalk walk;
+      walk.context = context;
+      walk.memory = thread_memory;
+      walk.unwind_tables = unwind_tables.get();
+      walk.thread_string = thread_string;
+      walk.thread_id = thread_id;
+      walk.thread_index = process_state->threads_.size();
+      walk.stack = stack.get();
+      walk.interrupted = false;
+      if (deferred)
+        deferred_walker->Add(walk);
+      else
+        pending_walks.push_back(walk);
+    } else if (!duplicate && !cached && !resymbolized) {
+      // Each walk records the modules it found to be without symbols on its
+      // own, to be merged into the dump's and, if the walk is to be kept in
+      // the cache, kept along with it.
+      cache_miss.interrupted =
+          !WalkThread(process_state, context, thread_memory,
+                      unwind_tables.get(), thread_string,
+                      frame_symbolizer_, time_limits, symbolized_frame_limit_,
+                      terminal_frames_, stack.get(),
+                      &cache_miss.modules_without_symbols,
+                      &cache_miss.modules_with_corrupt_symbols);
+      if (cache_miss.interrupted)
+        interrupted = true;
+      process_state->MergeWalkModules(
+          cache_miss.modules_without_symbols,
+          cache_miss.modules_with_corrupt_symbols);
+    }
+    if (missed_cache) {
+      cache_miss.stack = stack.get();
+      cache_miss.pending_walk =
+          pending ? static_cast<int>(pending_walks.size()) - 1 : -1;
+      stack_walk_cache_misses.push_back(std::move(cache_miss));
     }
     stack->set_tid(thread_id);
+    if (observer_ && !duplicate && !pending && !deferred)
+      observer_->OnThread(process_state->threads_.size(), *stack);
     process_state->threads_.push_back(stack.release());
     process_state->thread_memory_regions_.push_back(thread_memory);
     process_state->thread_names_.push_back(thread_name);
   }
 
+  if (!pending_walks.empty()) {
+    size_t first_walk = 0;
+    while (first_walk < pending_walks.size() &&
+           pending_walks[first_walk].thread_index !=
+               process_state->requesting_thread_) {
+      ++first_walk;
+    }
+    WalkThreadsConcurrently(process_state, frame_symbolizer_, observer_,
+                            time_limits, symbolized_frame_limit_,
+                            terminal_frames_, walk_concurrency_, first_walk,
+                            &pending_walks);
+    // Merge in thread order, so that the result is the same as walking the
+    // threads serially.
+    for (const ThreadWalk& walk : pending_walks) {
+      // Walk clears the stack, thread ID included.
+      walk.stack->set_tid(walk.thread_id);
+      process_state->MergeWalkModules(walk.modules_without_symbols,
+                                      walk.modules_with_corrupt_symbols);
+      if (walk.interrupted) {
+        interrupted = true;
+      }
+    }
+  }
+
+  for (const DuplicateStack& duplicate_stack : duplicate_stacks) {
+    CopyRelocatedStack(*duplicate_stack.source, duplicate_stack.low,
+                       duplicate_stack.high, duplicate_stack.delta,
+                       duplicate_stack.stack);
+    if (observer_)
+      observer_->OnThread(duplicate_stack.thread_index, *duplicate_stack.stack);
+  }
+  process_state->deduplicated_stack_count_ = duplicate_stacks.size();
+  process_state->cached_stack_count_ = cached_stack_count;
+  process_state->resymbolized_stack_count_ = resymbolized_stack_count;
+  for (StackWalkCacheMiss& miss : stack_walk_cache_misses) {
+    if (miss.pending_walk >= 0) {
+      const ThreadWalk& walk = pending_walks[miss.pending_walk];
+      miss.modules_without_symbols = walk.modules_without_symbols;
+      miss.modules_with_corrupt_symbols = walk.modules_with_corrupt_symbols;
+      miss.interrupted = walk.interrupted;
+    }
+    // A module's symbols may become available after this walk, and a walk
+    // made without them could differ, so only complete walks are kept.
+    if (miss.interrupted || miss.stack->truncated() ||
+        !miss.modules_without_symbols.empty() ||
+        !miss.modules_with_corrupt_symbols.empty())
+      continue;
+    std::shared_ptr<StackWalkCache::Walk> walk(new StackWalkCache::Walk);
+    CopyRelocatedStack(*miss.stack, 0, 0, 0, &walk->stack);
+    for (StackFrame* frame : walk->stack.frames_) {
+      walk->frame_modules.push_back(cache_modules.Index(frame->module));
+      frame->module = NULL;
+    }
+    stack_walk_cache_->Insert(miss.key, walk, stack_walk_cache_modules);
+  }
+  if (deferred_walker.get() && !deferred_walker->empty()) {
+    vector<int> deferred_thread_indices = deferred_walker->thread_indices();
+    process_state->DeferThreadWalks(deferred_walker.release(),
+                                    deferred_thread_indices);
+  }
+  for (const CallStack* stack : process_state->threads_) {
+    if (stack->truncated()) {
+      BPLOG(INFO) << "Stack walks truncated by time limit in " << dump->path();
+      process_state->walk_truncated_ = true;
+      break;
+    }
+  }
+  phase_timer.Stop();
+  if (stats)
+    CountFrames(*process_state, stats);
+
   if (interrupted) {
     BPLOG(INFO) << "Processing interrupted for " << dump->path();
     return PROCESS_SYMBOL_SUPPLIER_INTERRUPTED;
@@ -387,6 +1828,13 @@ ProcessResult MinidumpProcessor::Process(
     process_state->requesting_thread_ = -1;
   }
 
+  if (stack_signature_generator_ && process_state->requesting_thread_ != -1) {
+    process_state->stack_signature_ = stack_signature_generator_->Generate(
+        *process_state->threads_[process_state->requesting_thread_]);
+    process_state->stack_signature_hash_ =
+        StackSignatureGenerator::Hash(process_state->stack_signature_);
+  }
+
   // Exploitability defaults to EXPLOITABILITY_NOT_ANALYZED
   process_state->exploitability_ = EXPLOITABILITY_NOT_ANALYZED;
 
@@ -397,10 +1845,14 @@ ProcessResult MinidumpProcessor::Process(
         Exploitability::ExploitabilityForPlatform(
           dump, process_state, enable_objdump_for_exploitability_));
     // The engine will be null if the platform is not supported
-    if (exploitability != NULL) {
-      process_state->exploitability_ = exploitability->CheckExploitability();
-    } else {
+    if (exploitability == NULL) {
       process_state->exploitability_ = EXPLOITABILITY_ERR_NOENGINE;
+    } else if (defer_exploitability_) {
+      process_state->DeferExploitability(
+          new MinidumpDeferredExploitability(exploitability.release()));
+    } else {
+      phase_timer.Start(ProcessingStats::PHASE_EXPLOITABILITY);
+      process_state->exploitability_ = exploitability->CheckExploitability();
     }
   }
 
@@ -412,13 +1864,52 @@ ProcessResult MinidumpProcessor::Process(
     const string& minidump_file, ProcessState* process_state) {
   BPLOG(INFO) << "Processing minidump in file " << minidump_file;
 
+  // Process clears the statistics, so reading the minidump is added to
+  // them afterwards.
+  double read_wall_start = ProcessingStats::WallSeconds();
+  double read_cpu_start = ProcessingStats::ThreadCPUSeconds();
   Minidump dump(minidump_file);
   if (!dump.Read()) {
      BPLOG(ERROR) << "Minidump " << dump.path() << " could not be read";
      return PROCESS_ERROR_MINIDUMP_NOT_FOUND;
   }
+  double read_wall_seconds = ProcessingStats::WallSeconds() - read_wall_start;
+  double read_cpu_seconds =
+      ProcessingStats::ThreadCPUSeconds() - read_cpu_start;
+
+  ProcessResult result = Process(&dump, process_state);
+  // Deferred walks need dump, which goes away on return.
+  if (!process_state->WalkDeferredThreads(walk_concurrency_) &&
+      result == PROCESS_OK) {
+    result = PROCESS_SYMBOL_SUPPLIER_INTERRUPTED;
+  }
+  // As does a deferred exploitability analysis.
+  process_state->AnalyzeExploitability();
+  if (collect_stats_) {
+    process_state->stats_.AddPhaseTime(ProcessingStats::PHASE_READ,
+                                       read_wall_seconds, read_cpu_seconds);
+  }
+  return result;
+}
+
+ProcessResult MinidumpProcessor::Resymbolize(Minidump* minidump,
+                                           const UnsymbolizedWalk& walk,
+                                           ProcessState* process_state) {
+  unsymbolized_walk_ = &walk;
+  ProcessResult result = Process(minidump, process_state);
+  unsymbolized_walk_ = NULL;
+  return result;
+}
 
-  return Process(&dump, process_state);
+bool MinidumpProcessor::SymbolizeFrame(const ProcessState& process_state,
+                                       StackFrame* frame) {
+  StackFrameSymbolizer::SymbolizerResult result =
+      frame_symbolizer_->FillSourceLineInfo(process_state.modules(),
+                                            process_state.unloaded_modules(),
+                                            process_state.system_info(),
+                                            frame, nullptr);
+  return result == StackFrameSymbolizer::kNoError ||
+         result == StackFrameSymbolizer::kWarningCorruptSymbols;
 }
 
 // Returns the MDRawSystemInfo from a minidump, or NULL if system info is
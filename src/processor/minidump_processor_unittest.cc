@@ -35,10 +35,17 @@
 
 #include <stdlib.h>
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <memory>
 #include <string>
 #include <iostream>
 #include <fstream>
 #include <map>
+#include <mutex>
+#include <set>
+#include <thread>
 #include <utility>
 
 #include "breakpad_googletest_includes.h"
@@ -48,15 +55,22 @@
 #include "google_breakpad/processor/call_stack.h"
 #include "google_breakpad/processor/code_module.h"
 #include "google_breakpad/processor/code_modules.h"
+#include "google_breakpad/processor/frame_profile.h"
 #include "google_breakpad/processor/minidump.h"
 #include "google_breakpad/processor/minidump_processor.h"
 #include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/process_state_observer.h"
 #include "google_breakpad/processor/stack_frame.h"
+#include "google_breakpad/processor/stack_frame_cpu.h"
+#include "google_breakpad/processor/stack_frame_symbolizer.h"
+#include "google_breakpad/processor/stack_walk_cache.h"
 #include "google_breakpad/processor/symbol_supplier.h"
+#include "google_breakpad/processor/unsymbolized_walk.h"
 #include "processor/logging.h"
 #include "processor/stackwalker_unittest_utils.h"
 
 using std::map;
+using std::vector;
 
 namespace google_breakpad {
 class MockMinidump : public Minidump {
@@ -164,6 +178,7 @@ namespace {
 using google_breakpad::BasicSourceLineResolver;
 using google_breakpad::CallStack;
 using google_breakpad::CodeModule;
+using google_breakpad::Minidump;
 using google_breakpad::MinidumpContext;
 using google_breakpad::MinidumpMemoryRegion;
 using google_breakpad::MinidumpMiscInfo;
@@ -179,7 +194,15 @@ using google_breakpad::MockMinidumpThreadList;
 using google_breakpad::MockMinidumpUnloadedModule;
 using google_breakpad::MockMinidumpUnloadedModuleList;
 using google_breakpad::ProcessState;
+using google_breakpad::ProcessStateObserver;
+using google_breakpad::ProcessingStats;
 using google_breakpad::scoped_ptr;
+using google_breakpad::StackFrame;
+using google_breakpad::StackFrameSymbolizer;
+using google_breakpad::FrameProfile;
+using google_breakpad::StackFrameX86;
+using google_breakpad::StackWalkCache;
+using google_breakpad::UnsymbolizedWalk;
 using google_breakpad::SymbolSupplier;
 using google_breakpad::SystemInfo;
 using ::testing::_;
@@ -239,6 +262,8 @@ class TestSymbolSupplier : public SymbolSupplier {
  private:
   bool interrupt_;
   map<string, char*> memory_buffers_;
+  // Guards memory_buffers_, for symbols prefetched concurrently.
+  std::mutex memory_buffers_lock_;
 };
 
 SymbolSupplier::SymbolResult TestSymbolSupplier::GetSymbolFile(
@@ -304,6 +329,7 @@ SymbolSupplier::SymbolResult TestSymbolSupplier::GetCStringSymbolData(
     }
     memcpy(*symbol_data, symbol_data_string.c_str(), symbol_data_string.size());
     (*symbol_data)[symbol_data_string.size()] = '\0';
+    std::lock_guard<std::mutex> lock(memory_buffers_lock_);
     memory_buffers_.insert(make_pair(module->code_file(), *symbol_data));
   }
 
@@ -311,6 +337,7 @@ SymbolSupplier::SymbolResult TestSymbolSupplier::GetCStringSymbolData(
 }
 
 void TestSymbolSupplier::FreeSymbolData(const CodeModule* module) {
+  std::lock_guard<std::mutex> lock(memory_buffers_lock_);
   map<string, char*>::iterator it = memory_buffers_.find(module->code_file());
   if (it != memory_buffers_.end()) {
     delete [] it->second;
@@ -318,6 +345,92 @@ void TestSymbolSupplier::FreeSymbolData(const CodeModule* module) {
   }
 }
 
+// A symbol supplier that completes GetCStringSymbolDataAsync requests on
+// threads of its own, and records how many were outstanding at once.
+class AsyncTestSymbolSupplier : public TestSymbolSupplier {
+ public:
+  AsyncTestSymbolSupplier()
+      : request_count_(0), outstanding_(0), max_outstanding_(0) {}
+
+  ~AsyncTestSymbolSupplier() {
+    for (std::thread& request_thread : request_threads_) {
+      request_thread.join();
+    }
+  }
+
+  virtual void GetCStringSymbolDataAsync(const CodeModule* module,
+                                         const SystemInfo* system_info,
+                                         SymbolDataCallback* callback) {
+    ++request_count_;
+    int outstanding = ++outstanding_;
+    int max_outstanding = max_outstanding_;
+    while (outstanding > max_outstanding &&
+           !max_outstanding_.compare_exchange_weak(max_outstanding,
+                                                   outstanding)) {
+    }
+    std::lock_guard<std::mutex> lock(request_threads_lock_);
+    request_threads_.push_back(std::thread([=]() {
+      string symbol_file;
+      char* symbol_data = NULL;
+      size_t symbol_data_size = 0;
+      SymbolResult result = GetCStringSymbolData(
+          module, system_info, &symbol_file, &symbol_data, &symbol_data_size);
+      --outstanding_;
+      callback->OnSymbolData(module, result, symbol_file, symbol_data,
+                             symbol_data_size);
+    }));
+  }
+
+  int request_count() const { return request_count_; }
+  int max_outstanding() const { return max_outstanding_; }
+
+ private:
+  std::atomic<int> request_count_;
+  std::atomic<int> outstanding_;
+  std::atomic<int> max_outstanding_;
+  std::mutex request_threads_lock_;
+  vector<std::thread> request_threads_;
+};
+
+// A symbol supplier that finds empty symbols for every module, so that
+// every walk is made with each of its modules' symbols.
+class EmptySymbolSupplier : public SymbolSupplier {
+ public:
+  virtual SymbolResult GetSymbolFile(const CodeModule* module,
+                                     const SystemInfo* system_info,
+                                     string* symbol_file) {
+    *symbol_file = module->debug_file() + ".sym";
+    return FOUND;
+  }
+
+  virtual SymbolResult GetSymbolFile(const CodeModule* module,
+                                     const SystemInfo* system_info,
+                                     string* symbol_file,
+                                     string* symbol_data) {
+    symbol_data->clear();
+    return GetSymbolFile(module, system_info, symbol_file);
+  }
+
+  virtual SymbolResult GetCStringSymbolData(const CodeModule* module,
+                                            const SystemInfo* system_info,
+                                            string* symbol_file,
+                                            char** symbol_data,
+                                            size_t* symbol_data_size) {
+    std::lock_guard<std::mutex> lock(symbol_data_lock_);
+    symbol_data_.emplace_back(new char[1]());
+    *symbol_data = symbol_data_.back().get();
+    *symbol_data_size = 1;
+    return GetSymbolFile(module, system_info, symbol_file);
+  }
+
+  // The buffers are freed with the supplier.
+  virtual void FreeSymbolData(const CodeModule* module) {}
+
+ private:
+  std::mutex symbol_data_lock_;
+  vector<std::unique_ptr<char[]>> symbol_data_;
+};
+
 // A test system info stream, just returns values from the
 // MDRawSystemInfo fed to it.
 class TestMinidumpSystemInfo : public MinidumpSystemInfo {
@@ -502,6 +615,30 @@ TEST_F(MinidumpProcessorTest, TestSymbolSupplierLookupCounts) {
             google_breakpad::PROCESS_OK);
 }
 
+// Prefetching symbols consults the symbol supplier once for every module,
+// and the walk doesn't consult it again.
+TEST_F(MinidumpProcessorTest, TestSymbolPrefetchLookupCounts) {
+  MockSymbolSupplier supplier;
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(&supplier, &resolver);
+  processor.set_symbol_prefetch_concurrency(4);
+
+  string minidump_file = GetTestDataPath() + "minidump2.dmp";
+  ProcessState state;
+  EXPECT_CALL(supplier, GetCStringSymbolData(
+      Property(&google_breakpad::CodeModule::code_file,
+               "c:\\test_app.exe"),
+      _, _, _, _)).WillOnce(Return(SymbolSupplier::NOT_FOUND));
+  EXPECT_CALL(supplier, GetCStringSymbolData(
+      Property(&google_breakpad::CodeModule::code_file,
+               Ne("c:\\test_app.exe")),
+      _, _, _, _)).Times(12).WillRepeatedly(Return(SymbolSupplier::NOT_FOUND));
+  EXPECT_CALL(supplier, FreeSymbolData(_)).Times(AnyNumber());
+  ASSERT_EQ(processor.Process(minidump_file, &state),
+            google_breakpad::PROCESS_OK);
+  ASSERT_EQ(13U, state.modules()->module_count());
+}
+
 TEST_F(MinidumpProcessorTest, TestBasicProcessing) {
   TestSymbolSupplier supplier;
   BasicSourceLineResolver resolver;
@@ -586,6 +723,919 @@ TEST_F(MinidumpProcessorTest, TestBasicProcessing) {
             google_breakpad::PROCESS_SYMBOL_SUPPLIER_INTERRUPTED);
 }
 
+// Expects the threads of actual to have the same stacks as those of
+// expected, and the same modules without symbols, in the same order unless
+// same_module_order is false.
+static void ExpectSameThreads(const ProcessState& expected,
+                              const ProcessState& actual,
+                              bool same_module_order = true) {
+  ASSERT_EQ(expected.threads()->size(), actual.threads()->size());
+  EXPECT_EQ(expected.requesting_thread(), actual.requesting_thread());
+  for (size_t thread_index = 0;
+       thread_index < expected.threads()->size(); ++thread_index) {
+    const CallStack* expected_stack = expected.threads()->at(thread_index);
+    const CallStack* actual_stack = actual.threads()->at(thread_index);
+    EXPECT_EQ(expected_stack->tid(), actual_stack->tid());
+    EXPECT_EQ(expected.thread_names()->at(thread_index),
+              actual.thread_names()->at(thread_index));
+    ASSERT_EQ(expected_stack->frames()->size(),
+              actual_stack->frames()->size());
+    for (size_t frame_index = 0;
+         frame_index < expected_stack->frames()->size(); ++frame_index) {
+      const StackFrame* expected_frame =
+          expected_stack->frames()->at(frame_index);
+      const StackFrame* actual_frame = actual_stack->frames()->at(frame_index);
+      EXPECT_EQ(expected_frame->instruction, actual_frame->instruction);
+      EXPECT_EQ(expected_frame->trust, actual_frame->trust);
+      EXPECT_EQ(expected_frame->function_name, actual_frame->function_name);
+      EXPECT_EQ(expected_frame->source_file_name,
+                actual_frame->source_file_name);
+      EXPECT_EQ(expected_frame->source_line, actual_frame->source_line);
+    }
+  }
+
+  vector<string> expected_code_files;
+  for (const CodeModule* module : *expected.modules_without_symbols())
+    expected_code_files.push_back(module->code_file());
+  vector<string> actual_code_files;
+  for (const CodeModule* module : *actual.modules_without_symbols())
+    actual_code_files.push_back(module->code_file());
+  if (!same_module_order) {
+    std::sort(expected_code_files.begin(), expected_code_files.end());
+    std::sort(actual_code_files.begin(), actual_code_files.end());
+  }
+  EXPECT_EQ(expected_code_files, actual_code_files);
+}
+
+TEST_F(MinidumpProcessorTest, TestTriage) {
+  string minidump_file = GetTestDataPath() + "minidump2.dmp";
+
+  MinidumpProcessor expected_processor(nullptr, nullptr);
+  ProcessState expected_state;
+  ASSERT_EQ(expected_processor.Process(minidump_file, &expected_state),
+            google_breakpad::PROCESS_OK);
+
+  Minidump dump(minidump_file);
+  ASSERT_TRUE(dump.Read());
+  MinidumpProcessor processor(nullptr, nullptr);
+  ProcessState state;
+  ASSERT_EQ(processor.ProcessTriage(&dump, &state),
+            google_breakpad::PROCESS_OK);
+  EXPECT_EQ(expected_state.system_info()->os, state.system_info()->os);
+  EXPECT_EQ(expected_state.system_info()->cpu, state.system_info()->cpu);
+  EXPECT_EQ(expected_state.system_info()->cpu_info,
+            state.system_info()->cpu_info);
+  EXPECT_TRUE(state.crashed());
+  EXPECT_EQ(expected_state.crash_reason(), state.crash_reason());
+  EXPECT_EQ(expected_state.crash_address(), state.crash_address());
+  EXPECT_EQ(expected_state.time_date_stamp(), state.time_date_stamp());
+  EXPECT_EQ(expected_state.process_create_time(),
+            state.process_create_time());
+
+  // Nothing that needs the threads or modules is filled in.
+  EXPECT_TRUE(state.threads()->empty());
+  EXPECT_EQ(-1, state.requesting_thread());
+  EXPECT_EQ(nullptr, state.modules());
+}
+
+TEST_F(MinidumpProcessorTest, TestSharedModuleLists) {
+  string minidump_file = GetTestDataPath() + "minidump2.dmp";
+  MinidumpProcessor processor(nullptr, nullptr);
+  ProcessState first_state;
+  ProcessState second_state;
+  {
+    Minidump dump(minidump_file);
+    ASSERT_TRUE(dump.Read());
+    ASSERT_EQ(processor.Process(&dump, &first_state),
+              google_breakpad::PROCESS_OK);
+    ASSERT_EQ(processor.Process(&dump, &second_state),
+              google_breakpad::PROCESS_OK);
+  }
+
+  // Both states hold the same copy of the module list, which outlives the
+  // minidump it came from.
+  ASSERT_TRUE(first_state.modules());
+  EXPECT_EQ(first_state.modules(), second_state.modules());
+  EXPECT_EQ(13U, first_state.modules()->module_count());
+  const CallStack* stack = second_state.threads()->at(0);
+  ASSERT_FALSE(stack->frames()->empty());
+  EXPECT_EQ(first_state.modules()->GetModuleForAddress(0x400000),
+            stack->frames()->at(1)->module);
+
+  // Clearing one state leaves the other's modules intact.
+  first_state.Clear();
+  EXPECT_EQ(nullptr, first_state.modules());
+  EXPECT_EQ("c:\\test_app.exe",
+            second_state.modules()->GetMainModule()->code_file());
+}
+
+TEST_F(MinidumpProcessorTest, TestConcurrentWalk) {
+  const char* kMinidumps[] = {"thread_name_list.dmp",
+                              "minidump_crashpad_annotation.dmp"};
+  for (const char* minidump : kMinidumps) {
+    string minidump_file = GetTestDataPath() + minidump;
+
+    BasicSourceLineResolver serial_resolver;
+    MinidumpProcessor serial_processor(NULL, &serial_resolver);
+    ProcessState serial_state;
+    ASSERT_EQ(serial_processor.Process(minidump_file, &serial_state),
+              google_breakpad::PROCESS_OK);
+
+    BasicSourceLineResolver concurrent_resolver;
+    MinidumpProcessor concurrent_processor(NULL, &concurrent_resolver);
+    concurrent_processor.set_walk_concurrency(4);
+    ProcessState concurrent_state;
+    ASSERT_EQ(concurrent_processor.Process(minidump_file, &concurrent_state),
+              google_breakpad::PROCESS_OK);
+
+    ASSERT_GT(serial_state.threads()->size(), 1U);
+    ExpectSameThreads(serial_state, concurrent_state);
+  }
+
+  // The symbol supplier can interrupt a concurrent walk too.
+  TestSymbolSupplier supplier;
+  supplier.set_interrupt(true);
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(&supplier, &resolver);
+  processor.set_walk_concurrency(4);
+  ProcessState state;
+  ASSERT_EQ(processor.Process(GetTestDataPath() + "minidump2.dmp", &state),
+            google_breakpad::PROCESS_SYMBOL_SUPPLIER_INTERRUPTED);
+}
+
+TEST_F(MinidumpProcessorTest, TestFrameArenas) {
+  string minidump_file = GetTestDataPath() + "thread_name_list.dmp";
+
+  BasicSourceLineResolver heap_resolver;
+  MinidumpProcessor heap_processor(NULL, &heap_resolver);
+  ProcessState heap_state;
+  ASSERT_EQ(heap_processor.Process(minidump_file, &heap_state),
+            google_breakpad::PROCESS_OK);
+  ASSERT_GT(heap_state.threads()->size(), 1U);
+
+  for (int walk_concurrency = 1; walk_concurrency <= 4;
+       walk_concurrency += 3) {
+    BasicSourceLineResolver arena_resolver;
+    MinidumpProcessor arena_processor(NULL, &arena_resolver);
+    arena_processor.set_enable_frame_arenas(true);
+    arena_processor.set_walk_concurrency(walk_concurrency);
+    ProcessState arena_state;
+    ASSERT_EQ(arena_processor.Process(minidump_file, &arena_state),
+              google_breakpad::PROCESS_OK);
+    ExpectSameThreads(heap_state, arena_state);
+
+    // Processing again into the same state reuses its call stacks' arenas
+    // after clearing them.
+    ASSERT_EQ(arena_processor.Process(minidump_file, &arena_state),
+              google_breakpad::PROCESS_OK);
+    ExpectSameThreads(heap_state, arena_state);
+  }
+}
+
+TEST_F(MinidumpProcessorTest, TestReuseProcessState) {
+  string thread_names_file = GetTestDataPath() + "thread_name_list.dmp";
+  string exception_file = GetTestDataPath() + "ascii_read_av.dmp";
+
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(NULL, &resolver);
+  ProcessState fresh_state;
+  ASSERT_EQ(processor.Process(thread_names_file, &fresh_state),
+            google_breakpad::PROCESS_OK);
+
+  ProcessState state;
+  ASSERT_EQ(processor.Process(exception_file, &state),
+            google_breakpad::PROCESS_OK);
+  ASSERT_GT(state.exception_record()->parameters()->size(), 0U);
+  std::set<const CallStack*> stacks(state.threads()->begin(),
+                                    state.threads()->end());
+
+  // Nothing of the first minidump is left in the state, but the call
+  // stacks of its threads are reused.
+  ASSERT_EQ(processor.Process(thread_names_file, &state),
+            google_breakpad::PROCESS_OK);
+  ExpectSameThreads(fresh_state, state);
+  EXPECT_EQ(state.threads()->size(), state.thread_memory_regions()->size());
+  EXPECT_EQ(fresh_state.exception_record()->parameters()->size(),
+            state.exception_record()->parameters()->size());
+  EXPECT_EQ(fresh_state.crash_reason(), state.crash_reason());
+  size_t reused = 0;
+  for (const CallStack* stack : *state.threads()) {
+    reused += stacks.count(stack);
+  }
+  EXPECT_EQ(std::min(stacks.size(), state.threads()->size()), reused);
+}
+
+// A resolver that counts the frames it is asked to fill.
+class CountingSourceLineResolver : public BasicSourceLineResolver {
+ public:
+  CountingSourceLineResolver() : fill_count_(0) {}
+
+  virtual void FillSourceLineInfo(
+      StackFrame* frame,
+      std::deque<std::unique_ptr<StackFrame>>* inlined_frames) {
+    ++fill_count_;
+    BasicSourceLineResolver::FillSourceLineInfo(frame, inlined_frames);
+  }
+
+  int fill_count() const { return fill_count_; }
+
+ private:
+  std::atomic<int> fill_count_;
+};
+
+TEST_F(MinidumpProcessorTest, TestFrameMemo) {
+  string minidump_file = GetTestDataPath() + "minidump2.dmp";
+
+  TestSymbolSupplier supplier;
+  BasicSourceLineResolver expected_resolver;
+  MinidumpProcessor expected_processor(&supplier, &expected_resolver);
+  ProcessState expected_state;
+  ASSERT_EQ(expected_processor.Process(minidump_file, &expected_state),
+            google_breakpad::PROCESS_OK);
+
+  // By default, the memo lasts for one dump.
+  CountingSourceLineResolver resolver;
+  StackFrameSymbolizer symbolizer(&supplier, &resolver);
+  MinidumpProcessor processor(&symbolizer, false);
+  ProcessState state;
+  ASSERT_EQ(processor.Process(minidump_file, &state),
+            google_breakpad::PROCESS_OK);
+  ExpectSameThreads(expected_state, state);
+  int fill_count = resolver.fill_count();
+  ASSERT_GT(fill_count, 0);
+
+  ASSERT_EQ(processor.Process(minidump_file, &state),
+            google_breakpad::PROCESS_OK);
+  ExpectSameThreads(expected_state, state);
+  EXPECT_EQ(2 * fill_count, resolver.fill_count());
+
+  // Kept across resets, the memo symbolizes every frame of later dumps.
+  symbolizer.set_keep_frame_memo_across_resets(true);
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_EQ(processor.Process(minidump_file, &state),
+              google_breakpad::PROCESS_OK);
+    ExpectSameThreads(expected_state, state);
+    EXPECT_EQ(2 * fill_count, resolver.fill_count());
+  }
+}
+
+TEST_F(MinidumpProcessorTest, TestSymbolPrefetch) {
+  string minidump_file = GetTestDataPath() + "minidump2.dmp";
+
+  TestSymbolSupplier supplier;
+  BasicSourceLineResolver expected_resolver;
+  MinidumpProcessor expected_processor(&supplier, &expected_resolver);
+  ProcessState expected_state;
+  ASSERT_EQ(expected_processor.Process(minidump_file, &expected_state),
+            google_breakpad::PROCESS_OK);
+
+  for (int prefetch_concurrency = 1; prefetch_concurrency <= 4;
+       prefetch_concurrency += 3) {
+    BasicSourceLineResolver resolver;
+    MinidumpProcessor processor(&supplier, &resolver);
+    processor.set_symbol_prefetch_concurrency(prefetch_concurrency);
+    ProcessState state;
+    ASSERT_EQ(processor.Process(minidump_file, &state),
+              google_breakpad::PROCESS_OK);
+    ExpectSameThreads(expected_state, state);
+  }
+
+  // The symbol supplier can interrupt prefetching, and so processing.
+  supplier.set_interrupt(true);
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(&supplier, &resolver);
+  processor.set_symbol_prefetch_concurrency(4);
+  ProcessState state;
+  ASSERT_EQ(processor.Process(minidump_file, &state),
+            google_breakpad::PROCESS_SYMBOL_SUPPLIER_INTERRUPTED);
+}
+
+TEST_F(MinidumpProcessorTest, TestAsyncSymbolPrefetch) {
+  string minidump_file = GetTestDataPath() + "minidump2.dmp";
+
+  TestSymbolSupplier expected_supplier;
+  BasicSourceLineResolver expected_resolver;
+  MinidumpProcessor expected_processor(&expected_supplier, &expected_resolver);
+  ProcessState expected_state;
+  ASSERT_EQ(expected_processor.Process(minidump_file, &expected_state),
+            google_breakpad::PROCESS_OK);
+
+  AsyncTestSymbolSupplier supplier;
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(&supplier, &resolver);
+  processor.set_symbol_prefetch_concurrency(4);
+  processor.set_async_symbol_prefetch(true);
+  ProcessState state;
+  ASSERT_EQ(processor.Process(minidump_file, &state),
+            google_breakpad::PROCESS_OK);
+  ExpectSameThreads(expected_state, state);
+  // Every module is requested once, and the walk requests no more.
+  EXPECT_EQ(13, supplier.request_count());
+  EXPECT_GE(supplier.max_outstanding(), 1);
+  EXPECT_LE(supplier.max_outstanding(), 4);
+
+  // An interrupted request interrupts processing.
+  AsyncTestSymbolSupplier interrupting_supplier;
+  interrupting_supplier.set_interrupt(true);
+  BasicSourceLineResolver interrupted_resolver;
+  MinidumpProcessor interrupted_processor(&interrupting_supplier,
+                                          &interrupted_resolver);
+  interrupted_processor.set_symbol_prefetch_concurrency(4);
+  interrupted_processor.set_async_symbol_prefetch(true);
+  ASSERT_EQ(interrupted_processor.Process(minidump_file, &state),
+            google_breakpad::PROCESS_SYMBOL_SUPPLIER_INTERRUPTED);
+}
+
+TEST_F(MinidumpProcessorTest, TestFrameProfile) {
+  string minidump_file = GetTestDataPath() + "minidump2.dmp";
+
+  TestSymbolSupplier supplier;
+  BasicSourceLineResolver expected_resolver;
+  MinidumpProcessor expected_processor(&supplier, &expected_resolver);
+  ProcessState expected_state;
+  ASSERT_EQ(expected_processor.Process(minidump_file, &expected_state),
+            google_breakpad::PROCESS_OK);
+
+  // Every symbolized frame is counted, in the only module with symbols.
+  FrameProfile profile;
+  BasicSourceLineResolver recording_resolver;
+  StackFrameSymbolizer recording_symbolizer(&supplier, &recording_resolver);
+  recording_symbolizer.set_frame_profile(&profile);
+  MinidumpProcessor recording_processor(&recording_symbolizer, false);
+  ProcessState state;
+  ASSERT_EQ(recording_processor.Process(minidump_file, &state),
+            google_breakpad::PROCESS_OK);
+  ASSERT_GT(profile.AddressCount(), 1U);
+  const CodeModule* test_app = state.modules()->GetMainModule();
+  FrameProfile::ModuleKey key = {test_app->code_file(),
+                                 test_app->debug_file(),
+                                 test_app->debug_identifier()};
+  ASSERT_EQ(1U, profile.modules().count(key));
+
+  // The text form reads back the same, and merging doubles the counts.
+  FrameProfile read_profile;
+  ASSERT_TRUE(read_profile.Parse(profile.Serialize()));
+  EXPECT_EQ(profile.Serialize(), read_profile.Serialize());
+  read_profile.Merge(profile);
+  EXPECT_EQ(profile.AddressCount(), read_profile.AddressCount());
+  const FrameProfile::AddressCounts& counts =
+      profile.modules().find(key)->second;
+  const FrameProfile::AddressCounts& merged_counts =
+      read_profile.modules().find(key)->second;
+  EXPECT_EQ(2 * counts.begin()->second, merged_counts.begin()->second);
+  EXPECT_FALSE(read_profile.Parse("FRAMEPROFILE\n10 1\n"));
+  EXPECT_EQ(0U, read_profile.AddressCount());
+
+  // A fresh symbolizer warmed up from the profile has the module with
+  // symbols loaded, and each of its addresses looked up, before it walks
+  // any stacks.
+  CountingSourceLineResolver resolver;
+  StackFrameSymbolizer symbolizer(&supplier, &resolver);
+  ASSERT_EQ(StackFrameSymbolizer::kNoError,
+            symbolizer.PrewarmFromProfile(profile, state.system_info()));
+  EXPECT_TRUE(resolver.HasModule(test_app));
+  EXPECT_EQ(static_cast<int>(counts.size()), resolver.fill_count());
+  MinidumpProcessor processor(&symbolizer, false);
+  ASSERT_EQ(processor.Process(minidump_file, &state),
+            google_breakpad::PROCESS_OK);
+  ExpectSameThreads(expected_state, state);
+
+  // Pruning keeps the hottest addresses.
+  uint64_t hottest = 0;
+  for (const auto& module : profile.modules()) {
+    for (const auto& address : module.second)
+      hottest = std::max(hottest, address.second);
+  }
+  profile.Prune(1);
+  ASSERT_EQ(1U, profile.AddressCount());
+  ASSERT_EQ(1U, profile.modules().size());
+  EXPECT_EQ(hottest, profile.modules().begin()->second.begin()->second);
+}
+
+TEST_F(MinidumpProcessorTest, TestProcessingStats) {
+  string minidump_file = GetTestDataPath() + "minidump2.dmp";
+
+  // Statistics are only recorded when requested.
+  TestSymbolSupplier supplier;
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(&supplier, &resolver);
+  ProcessState state;
+  ASSERT_EQ(processor.Process(minidump_file, &state),
+            google_breakpad::PROCESS_OK);
+  EXPECT_EQ(0U, state.stats()->symbol_lookups());
+  EXPECT_TRUE(state.stats()->module_loads().empty());
+
+  for (int concurrency = 1; concurrency <= 4; concurrency += 3) {
+    BasicSourceLineResolver stats_resolver;
+    MinidumpProcessor stats_processor(&supplier, &stats_resolver);
+    stats_processor.set_collect_stats(true);
+    stats_processor.set_walk_concurrency(concurrency);
+    stats_processor.set_symbol_prefetch_concurrency(concurrency);
+    ASSERT_EQ(stats_processor.Process(minidump_file, &state),
+              google_breakpad::PROCESS_OK);
+    const ProcessingStats* stats = state.stats();
+
+    uint64_t frame_count = 0;
+    for (int trust = 0; trust < ProcessingStats::kFrameTrustCount; ++trust) {
+      frame_count +=
+          stats->frame_count(static_cast<StackFrame::FrameTrust>(trust));
+    }
+    uint64_t expected_frame_count = 0;
+    for (const CallStack* stack : *state.threads())
+      expected_frame_count += stack->frames()->size();
+    EXPECT_EQ(expected_frame_count, frame_count);
+    EXPECT_EQ(1U, stats->frame_count(StackFrame::FRAME_TRUST_CONTEXT));
+
+    EXPECT_GT(stats->symbol_lookups(), 0U);
+    EXPECT_LE(stats->memoized_symbol_lookups(), stats->symbol_lookups());
+    // Every module is prefetched, and loaded at most once.
+    EXPECT_EQ(state.modules()->module_count(), stats->module_loads().size());
+    for (int phase = 0; phase < ProcessingStats::PHASE_COUNT; ++phase) {
+      EXPECT_GE(stats->wall_seconds(
+                    static_cast<ProcessingStats::Phase>(phase)), 0);
+    }
+    EXPECT_GT(stats->wall_seconds(ProcessingStats::PHASE_READ), 0);
+  }
+}
+
+// Records the order in which threads are walked.
+class ThreadOrderObserver : public ProcessStateObserver {
+ public:
+  void OnProcessInfo(const ProcessState& process_state) {}
+  void OnThread(int thread_index, const CallStack& stack) {
+    std::lock_guard<std::mutex> lock(lock_);
+    thread_indices_.push_back(thread_index);
+  }
+
+  vector<int> thread_indices() const { return thread_indices_; }
+
+ private:
+  std::mutex lock_;
+  vector<int> thread_indices_;
+};
+
+TEST_F(MinidumpProcessorTest, TestWalkTimeLimits) {
+  // The requesting thread of this minidump is its last.
+  string minidump_file = GetTestDataPath() + "thread_name_list.dmp";
+
+  // Without symbols, so that walks are quick.
+  MinidumpProcessor expected_processor(nullptr, nullptr);
+  ProcessState expected_state;
+  ASSERT_EQ(expected_processor.Process(minidump_file, &expected_state),
+            google_breakpad::PROCESS_OK);
+  ASSERT_EQ(5, expected_state.requesting_thread());
+  EXPECT_FALSE(expected_state.walk_truncated());
+
+  for (int concurrency = 1; concurrency <= 4; concurrency += 3) {
+    // Limits that are not reached change nothing, except that the
+    // requesting thread is walked first.  Concurrent walks may finish in
+    // any order.
+    MinidumpProcessor processor(nullptr, nullptr);
+    processor.set_walk_concurrency(concurrency);
+    processor.set_walk_time_limit(1000);
+    processor.set_thread_walk_time_limit(1000);
+    ThreadOrderObserver observer;
+    processor.set_observer(&observer);
+    ProcessState state;
+    ASSERT_EQ(processor.Process(minidump_file, &state),
+              google_breakpad::PROCESS_OK);
+    ExpectSameThreads(expected_state, state);
+    EXPECT_FALSE(state.walk_truncated());
+    ASSERT_EQ(state.threads()->size(), observer.thread_indices().size());
+    if (concurrency == 1)
+      EXPECT_EQ(5, observer.thread_indices()[0]);
+
+    // A thread's walk stops at its deadline, after its context frame.
+    MinidumpProcessor thread_limited_processor(nullptr, nullptr);
+    thread_limited_processor.set_walk_concurrency(concurrency);
+    thread_limited_processor.set_thread_walk_time_limit(1e-9);
+    ASSERT_EQ(thread_limited_processor.Process(minidump_file, &state),
+              google_breakpad::PROCESS_OK);
+    EXPECT_TRUE(state.walk_truncated());
+    ASSERT_EQ(expected_state.threads()->size(), state.threads()->size());
+    for (size_t thread_index = 0; thread_index < state.threads()->size();
+         ++thread_index) {
+      const CallStack* stack = state.threads()->at(thread_index);
+      EXPECT_EQ(expected_state.threads()->at(thread_index)->tid(),
+                stack->tid());
+      EXPECT_TRUE(stack->truncated());
+      ASSERT_EQ(1U, stack->frames()->size());
+      EXPECT_EQ(StackFrame::FRAME_TRUST_CONTEXT,
+                stack->frames()->at(0)->trust);
+    }
+
+    // Once the minidump's time has run out, no more threads are walked.
+    MinidumpProcessor limited_processor(nullptr, nullptr);
+    limited_processor.set_walk_concurrency(concurrency);
+    limited_processor.set_walk_time_limit(1e-9);
+    ASSERT_EQ(limited_processor.Process(minidump_file, &state),
+              google_breakpad::PROCESS_OK);
+    EXPECT_TRUE(state.walk_truncated());
+    ASSERT_EQ(expected_state.threads()->size(), state.threads()->size());
+    for (const CallStack* stack : *state.threads()) {
+      EXPECT_TRUE(stack->truncated());
+      EXPECT_TRUE(stack->frames()->empty());
+    }
+  }
+}
+
+TEST_F(MinidumpProcessorTest, TestDeferThreadWalks) {
+  // The requesting thread of this minidump is its last.
+  string minidump_file = GetTestDataPath() + "thread_name_list.dmp";
+
+  MinidumpProcessor expected_processor(nullptr, nullptr);
+  ProcessState expected_state;
+  ASSERT_EQ(expected_processor.Process(minidump_file, &expected_state),
+            google_breakpad::PROCESS_OK);
+  ASSERT_EQ(5, expected_state.requesting_thread());
+  ASSERT_EQ(6U, expected_state.threads()->size());
+
+  for (int concurrency = 1; concurrency <= 4; concurrency += 3) {
+    Minidump dump(minidump_file);
+    ASSERT_TRUE(dump.Read());
+    MinidumpProcessor processor(nullptr, nullptr);
+    processor.set_defer_thread_walks(true);
+    ProcessState state;
+    ASSERT_EQ(processor.Process(&dump, &state), google_breakpad::PROCESS_OK);
+    ASSERT_EQ(expected_state.threads()->size(), state.threads()->size());
+
+    // Only the requesting thread is walked.
+    EXPECT_FALSE(state.thread_walk_deferred(5));
+    EXPECT_EQ(expected_state.threads()->at(5)->frames()->size(),
+              state.threads()->at(5)->frames()->size());
+    for (int thread_index = 0; thread_index < 5; ++thread_index) {
+      EXPECT_TRUE(state.thread_walk_deferred(thread_index));
+      EXPECT_EQ(expected_state.threads()->at(thread_index)->tid(),
+                state.threads()->at(thread_index)->tid());
+      EXPECT_TRUE(state.threads()->at(thread_index)->frames()->empty());
+    }
+
+    // Threads are walked when first used, or all at once.
+    const CallStack* stack = state.GetWalkedThread(2);
+    ASSERT_TRUE(stack);
+    EXPECT_FALSE(state.thread_walk_deferred(2));
+    EXPECT_EQ(expected_state.threads()->at(2)->frames()->size(),
+              stack->frames()->size());
+    EXPECT_TRUE(state.thread_walk_deferred(3));
+    EXPECT_TRUE(state.WalkDeferredThreads(concurrency));
+    for (int thread_index = 0; thread_index < 6; ++thread_index)
+      EXPECT_FALSE(state.thread_walk_deferred(thread_index));
+    // The requesting thread's modules come first.
+    ExpectSameThreads(expected_state, state, false);
+  }
+
+  // Processing a minidump file walks every thread.
+  MinidumpProcessor processor(nullptr, nullptr);
+  processor.set_defer_thread_walks(true);
+  ProcessState state;
+  ASSERT_EQ(processor.Process(minidump_file, &state),
+            google_breakpad::PROCESS_OK);
+  for (int thread_index = 0; thread_index < 6; ++thread_index)
+    EXPECT_FALSE(state.thread_walk_deferred(thread_index));
+  ExpectSameThreads(expected_state, state, false);
+}
+
+TEST_F(MinidumpProcessorTest, TestSymbolizedFrameLimit) {
+  string minidump_file = GetTestDataPath() + "minidump2.dmp";
+
+  TestSymbolSupplier supplier;
+  BasicSourceLineResolver expected_resolver;
+  MinidumpProcessor expected_processor(&supplier, &expected_resolver);
+  ProcessState expected_state;
+  ASSERT_EQ(expected_processor.Process(minidump_file, &expected_state),
+            google_breakpad::PROCESS_OK);
+  const vector<StackFrame*>* expected_frames =
+      expected_state.threads()->at(0)->frames();
+  ASSERT_EQ(4U, expected_frames->size());
+
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(&supplier, &resolver);
+  processor.set_symbolized_frame_limit(2);
+  ProcessState state;
+  ASSERT_EQ(processor.Process(minidump_file, &state),
+            google_breakpad::PROCESS_OK);
+  const vector<StackFrame*>* frames = state.threads()->at(0)->frames();
+
+  // Unwinding is unaffected, and every frame has its module, but only the
+  // top frames have functions.
+  ASSERT_EQ(expected_frames->size(), frames->size());
+  for (size_t i = 0; i < frames->size(); ++i) {
+    EXPECT_EQ(expected_frames->at(i)->instruction, frames->at(i)->instruction);
+    EXPECT_EQ(expected_frames->at(i)->trust, frames->at(i)->trust);
+    ASSERT_TRUE(frames->at(i)->module);
+    EXPECT_EQ(expected_frames->at(i)->module->code_file(),
+              frames->at(i)->module->code_file());
+  }
+  EXPECT_EQ("`anonymous namespace'::CrashFunction",
+            frames->at(0)->function_name);
+  EXPECT_EQ("main", frames->at(1)->function_name);
+  EXPECT_TRUE(frames->at(2)->function_name.empty());
+  EXPECT_TRUE(frames->at(2)->source_file_name.empty());
+  EXPECT_TRUE(frames->at(3)->function_name.empty());
+
+  // Later frames are symbolized on request.
+  EXPECT_TRUE(processor.SymbolizeFrame(state, frames->at(2)));
+  EXPECT_EQ("__tmainCRTStartup", frames->at(2)->function_name);
+  EXPECT_EQ(expected_frames->at(2)->source_file_name,
+            frames->at(2)->source_file_name);
+  EXPECT_EQ(expected_frames->at(2)->source_line,
+            frames->at(2)->source_line);
+}
+
+// Returns the contents of an x86 stack at base whose frames are linked
+// through %ebp, with the given return addresses.
+static string X86StackContents(uint32_t base,
+                               const vector<uint32_t>& return_addresses) {
+  string contents;
+  for (size_t i = 0; i < return_addresses.size(); ++i) {
+    // The frame's saved %ebp points at the next frame, or is zero for the
+    // outermost frame.
+    uint32_t words[2] = {
+      i + 1 < return_addresses.size() ?
+          base + static_cast<uint32_t>(i + 1) * 8 : 0,
+      return_addresses[i]
+    };
+    contents.append(reinterpret_cast<const char*>(words), sizeof(words));
+  }
+  return contents;
+}
+
+TEST_F(MinidumpProcessorTest, TestDeduplicateStacks) {
+  MockMinidump dump;
+  EXPECT_CALL(dump, path()).WillRepeatedly(Return("mock minidump"));
+  EXPECT_CALL(dump, Read()).WillRepeatedly(Return(true));
+
+  MDRawHeader fake_header;
+  fake_header.time_date_stamp = 0;
+  EXPECT_CALL(dump, header()).WillRepeatedly(Return(&fake_header));
+
+  MDRawSystemInfo raw_system_info;
+  memset(&raw_system_info, 0, sizeof(raw_system_info));
+  raw_system_info.processor_architecture = MD_CPU_ARCHITECTURE_X86;
+  raw_system_info.platform_id = MD_OS_WIN32_NT;
+  TestMinidumpSystemInfo dump_system_info(raw_system_info);
+  EXPECT_CALL(dump, GetSystemInfo()).
+      WillRepeatedly(Return(&dump_system_info));
+
+  MockMinidumpThreadList thread_list;
+  EXPECT_CALL(dump, GetThreadList()).WillRepeatedly(Return(&thread_list));
+
+  // Threads 0 and 1 are parked in the same place on stacks at different
+  // addresses; thread 2's stack differs in one return address.
+  const uint32_t kStackBases[] = {0x10000, 0x30000, 0x50000};
+  const size_t kThreadCount = sizeof(kStackBases) / sizeof(kStackBases[0]);
+  vector<uint32_t> return_addresses;
+  return_addresses.push_back(0x40001234);
+  return_addresses.push_back(0x40005678);
+  MockMinidumpThread threads[kThreadCount];
+  scoped_ptr<MockMinidumpMemoryRegion> memory[kThreadCount];
+  scoped_ptr<TestMinidumpContext> contexts[kThreadCount];
+  for (size_t i = 0; i < kThreadCount; ++i) {
+    if (i == 2)
+      return_addresses.back() = 0x40009abc;
+    memory[i].reset(new MockMinidumpMemoryRegion(
+        kStackBases[i], X86StackContents(kStackBases[i], return_addresses)));
+
+    MDRawContextX86 raw_context;
+    memset(&raw_context, 0, sizeof(raw_context));
+    raw_context.context_flags = MD_CONTEXT_X86_FULL;
+    raw_context.eip = 0x40000100;
+    raw_context.esp = kStackBases[i];
+    raw_context.ebp = kStackBases[i];
+    raw_context.eax = 0x1234;
+    contexts[i].reset(new TestMinidumpContext(raw_context));
+
+    EXPECT_CALL(threads[i], GetThreadID(_)).
+        WillRepeatedly(DoAll(SetArgumentPointee<0>(i + 1), Return(true)));
+    EXPECT_CALL(threads[i], GetContext()).
+        WillRepeatedly(Return(contexts[i].get()));
+    EXPECT_CALL(threads[i], GetMemory()).
+        WillRepeatedly(Return(memory[i].get()));
+    EXPECT_CALL(thread_list, GetThreadAtIndex(i)).
+        WillRepeatedly(Return(&threads[i]));
+  }
+  EXPECT_CALL(thread_list, thread_count()).
+      WillRepeatedly(Return(kThreadCount));
+
+  MinidumpProcessor walking_processor(
+      reinterpret_cast<SymbolSupplier*>(NULL), NULL);
+  ProcessState walked_state;
+  ASSERT_EQ(walking_processor.Process(&dump, &walked_state),
+            google_breakpad::PROCESS_OK);
+  EXPECT_EQ(0, walked_state.deduplicated_stack_count());
+
+  for (int walk_concurrency = 1; walk_concurrency <= 4;
+       walk_concurrency += 3) {
+    MinidumpProcessor processor(reinterpret_cast<SymbolSupplier*>(NULL),
+                                NULL);
+    processor.set_deduplicate_stacks(true);
+    processor.set_walk_concurrency(walk_concurrency);
+    ProcessState state;
+    ASSERT_EQ(processor.Process(&dump, &state), google_breakpad::PROCESS_OK);
+    EXPECT_EQ(1, state.deduplicated_stack_count());
+    ExpectSameThreads(walked_state, state);
+
+    for (size_t i = 0; i < kThreadCount; ++i) {
+      const vector<StackFrame*>* walked_frames =
+          walked_state.threads()->at(i)->frames();
+      const vector<StackFrame*>* frames = state.threads()->at(i)->frames();
+      ASSERT_EQ(3U, frames->size());
+      for (size_t j = 0; j < frames->size(); ++j) {
+        const StackFrameX86* walked_frame =
+            static_cast<const StackFrameX86*>(walked_frames->at(j));
+        const StackFrameX86* frame =
+            static_cast<const StackFrameX86*>(frames->at(j));
+        EXPECT_EQ(walked_frame->context_validity, frame->context_validity);
+        EXPECT_EQ(walked_frame->context.eip, frame->context.eip);
+        EXPECT_EQ(walked_frame->context.esp, frame->context.esp);
+        EXPECT_EQ(walked_frame->context.ebp, frame->context.ebp);
+        EXPECT_EQ(walked_frame->context.eax, frame->context.eax);
+      }
+    }
+  }
+}
+
+TEST_F(MinidumpProcessorTest, TestStackWalkCache) {
+  string minidump_file = GetTestDataPath() + "thread_name_list.dmp";
+
+  EmptySymbolSupplier supplier;
+  BasicSourceLineResolver walking_resolver;
+  MinidumpProcessor walking_processor(&supplier, &walking_resolver);
+  ProcessState walked_state;
+  ASSERT_EQ(walking_processor.Process(minidump_file, &walked_state),
+            google_breakpad::PROCESS_OK);
+  ASSERT_GT(walked_state.threads()->size(), 1U);
+  EXPECT_TRUE(walked_state.modules_without_symbols()->empty());
+  EXPECT_TRUE(walked_state.modules_with_corrupt_symbols()->empty());
+
+  for (int walk_concurrency = 1; walk_concurrency <= 4;
+       walk_concurrency += 3) {
+    StackWalkCache cache(64 * 1024 * 1024);
+    BasicSourceLineResolver resolver;
+    MinidumpProcessor processor(&supplier, &resolver);
+    processor.set_stack_walk_cache(&cache);
+    processor.set_walk_concurrency(walk_concurrency);
+    ProcessState state;
+    ASSERT_EQ(processor.Process(minidump_file, &state),
+              google_breakpad::PROCESS_OK);
+    EXPECT_EQ(0, state.cached_stack_count());
+    ExpectSameThreads(walked_state, state);
+    size_t walk_count = cache.GetStats().walk_count;
+    EXPECT_GT(walk_count, 0U);
+
+    // Processing the minidump again copies the kept walks, with their
+    // frames pointing to the new minidump's modules.
+    ASSERT_EQ(processor.Process(minidump_file, &state),
+              google_breakpad::PROCESS_OK);
+    EXPECT_EQ(walk_count, static_cast<size_t>(state.cached_stack_count()));
+    EXPECT_EQ(walk_count, cache.GetStats().hits);
+    ExpectSameThreads(walked_state, state);
+    for (const CallStack* stack : *state.threads()) {
+      for (const StackFrame* frame : *stack->frames()) {
+        if (frame->module) {
+          EXPECT_EQ(frame->module, state.modules()->GetModuleForAddress(
+                                       frame->module->base_address()));
+        }
+      }
+    }
+
+    // Every walk depends on the main module.
+    const CodeModule* main_module = state.modules()->GetMainModule();
+    ASSERT_TRUE(main_module);
+    cache.InvalidateModule(main_module->debug_file(),
+                           main_module->debug_identifier());
+    EXPECT_EQ(walk_count, cache.GetStats().invalidations);
+    EXPECT_EQ(0U, cache.GetStats().walk_count);
+    ASSERT_EQ(processor.Process(minidump_file, &state),
+              google_breakpad::PROCESS_OK);
+    EXPECT_EQ(0, state.cached_stack_count());
+    ExpectSameThreads(walked_state, state);
+  }
+}
+
+TEST_F(MinidumpProcessorTest, TestStackWalkCacheSkipsUnsymbolizedWalks) {
+  string minidump_file = GetTestDataPath() + "minidump2.dmp";
+
+  TestSymbolSupplier supplier;
+  BasicSourceLineResolver expected_resolver;
+  MinidumpProcessor expected_processor(&supplier, &expected_resolver);
+  ProcessState expected_state;
+  ASSERT_EQ(expected_processor.Process(minidump_file, &expected_state),
+            google_breakpad::PROCESS_OK);
+
+  // Walked without symbols, no walk is kept.
+  StackWalkCache cache(64 * 1024 * 1024);
+  BasicSourceLineResolver unsymbolized_resolver;
+  MinidumpProcessor unsymbolized_processor(NULL, &unsymbolized_resolver);
+  unsymbolized_processor.set_stack_walk_cache(&cache);
+  ProcessState state;
+  ASSERT_EQ(unsymbolized_processor.Process(minidump_file, &state),
+            google_breakpad::PROCESS_OK);
+  EXPECT_FALSE(state.modules_without_symbols()->empty());
+  EXPECT_EQ(0U, cache.GetStats().walk_count);
+
+  // Once the symbols are available, the frames resolve.
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(&supplier, &resolver);
+  processor.set_stack_walk_cache(&cache);
+  ASSERT_EQ(processor.Process(minidump_file, &state),
+            google_breakpad::PROCESS_OK);
+  EXPECT_EQ(0, state.cached_stack_count());
+  ExpectSameThreads(expected_state, state);
+  const vector<StackFrame*>* expected_frames =
+      expected_state.threads()->at(0)->frames();
+  const vector<StackFrame*>* frames = state.threads()->at(0)->frames();
+  ASSERT_EQ(expected_frames->size(), frames->size());
+  ASSERT_FALSE(frames->empty());
+  EXPECT_FALSE(frames->at(0)->function_name.empty());
+  for (size_t i = 0; i < frames->size(); ++i) {
+    EXPECT_EQ(expected_frames->at(i)->function_name,
+              frames->at(i)->function_name);
+  }
+}
+
+TEST_F(MinidumpProcessorTest, TestResymbolize) {
+  string minidump_file = GetTestDataPath() + "minidump2.dmp";
+  Minidump dump(minidump_file);
+  ASSERT_TRUE(dump.Read());
+
+  TestSymbolSupplier supplier;
+  BasicSourceLineResolver expected_resolver;
+  MinidumpProcessor expected_processor(&supplier, &expected_resolver);
+  ProcessState expected_state;
+  ASSERT_EQ(expected_processor.Process(&dump, &expected_state),
+            google_breakpad::PROCESS_OK);
+
+  // Walked without symbols, the main module lacks CFI.
+  BasicSourceLineResolver unsymbolized_resolver;
+  MinidumpProcessor unsymbolized_processor(NULL, &unsymbolized_resolver);
+  ProcessState unsymbolized_state;
+  ASSERT_EQ(unsymbolized_processor.Process(&dump, &unsymbolized_state),
+            google_breakpad::PROCESS_OK);
+  UnsymbolizedWalk walk;
+  walk.Record(unsymbolized_state);
+  ASSERT_EQ(unsymbolized_state.threads()->size(), walk.threads().size());
+  const CodeModule* main_module =
+      unsymbolized_state.modules()->GetMainModule();
+  ASSERT_TRUE(main_module);
+  int main_module_index = UnsymbolizedWalk::kNoModule;
+  for (size_t i = 0; i < walk.modules().size(); ++i) {
+    if (walk.modules()[i].base_address == main_module->base_address())
+      main_module_index = static_cast<int>(i);
+  }
+  ASSERT_NE(UnsymbolizedWalk::kNoModule, main_module_index);
+  EXPECT_TRUE(walk.ModuleLackedCFI(main_module_index));
+
+  // The text form reads back the same.
+  UnsymbolizedWalk read_walk;
+  ASSERT_TRUE(read_walk.Parse(walk.Serialize()));
+  EXPECT_EQ(walk.Serialize(), read_walk.Serialize());
+  EXPECT_FALSE(read_walk.Parse("UNSYMBOLIZEDWALK\nFRAME 4 -1 1000\n"));
+  EXPECT_TRUE(read_walk.threads().empty());
+  ASSERT_TRUE(read_walk.Parse(walk.Serialize()));
+
+  // With the main module's symbols, the threads that passed through it are
+  // walked again, and the rest only symbolized.
+  int expected_resymbolized_count = 0;
+  for (const UnsymbolizedWalk::Thread& thread : read_walk.threads()) {
+    bool passed_through_main_module = false;
+    for (const UnsymbolizedWalk::Frame& frame : thread.frames) {
+      if (frame.module == main_module_index)
+        passed_through_main_module = true;
+    }
+    if (!passed_through_main_module)
+      ++expected_resymbolized_count;
+  }
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(&supplier, &resolver);
+  ProcessState state;
+  ASSERT_EQ(processor.Resymbolize(&dump, read_walk, &state),
+            google_breakpad::PROCESS_OK);
+  EXPECT_EQ(expected_resymbolized_count, state.resymbolized_stack_count());
+  ExpectSameThreads(expected_state, state);
+
+  // A walk recorded with every module's symbols is only symbolized.
+  walk.Record(state);
+  ASSERT_EQ(processor.Resymbolize(&dump, walk, &state),
+            google_breakpad::PROCESS_OK);
+  EXPECT_EQ(static_cast<int>(expected_state.threads()->size()),
+            state.resymbolized_stack_count());
+  ExpectSameThreads(expected_state, state);
+  const StackFrameX86* context_frame = static_cast<const StackFrameX86*>(
+      state.threads()->at(0)->frames()->at(0));
+  EXPECT_EQ(StackFrameX86::CONTEXT_VALID_ALL, context_frame->context_validity);
+
+  // A walk of another minidump is ignored.
+  ASSERT_TRUE(read_walk.Parse("UNSYMBOLIZEDWALK\n"
+                              "MODULE 0 400000 1000 - other.pdb\n"
+                              "THREAD 0 1\n"
+                              "FRAME 6 0 10\n"));
+  ASSERT_EQ(processor.Resymbolize(&dump, read_walk, &state),
+            google_breakpad::PROCESS_OK);
+  EXPECT_EQ(0, state.resymbolized_stack_count());
+  ExpectSameThreads(expected_state, state);
+}
+
 TEST_F(MinidumpProcessorTest, TestThreadMissingMemory) {
   MockMinidump dump;
   EXPECT_CALL(dump, path()).WillRepeatedly(Return("mock minidump"));
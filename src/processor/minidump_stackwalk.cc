@@ -29,18 +29,53 @@
 // minidump_stackwalk.cc: Process a minidump with MinidumpProcessor, printing
 // the results, including stack traces.
 //
+// With -S, minidump_stackwalk instead reads minidump paths from stdin, one
+// per line, and processes each in turn, keeping loaded symbols between
+// them.  The output for each minidump is followed by a line consisting of a
+// NUL character and "OK", or "FAILED" if the minidump could not be
+// processed.
+//
+// With -B, minidump_stackwalk processes a directory of minidumps, or a file
+// listing them, on several threads sharing loaded symbols.  The output for
+// each minidump is written to its own file, and the outcome of each is
+// printed, with the ProcessResult of each that failed.  With -N as well,
+// the threads are placed on the machine's NUMA nodes, each node loading its
+// own copy of the symbols, and minidumps with the same main module are
+// processed on the same node.
+//
+// With -r, each minidump is a later snapshot of a series whose first
+// snapshot is given, and is put back together with it before it is
+// processed.
+//
 // Author: Mark Mentovai
 
 #ifdef HAVE_CONFIG_H
 #include <config.h>  // Must come first
 #endif
 
+#include <dirent.h>
+#include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <iterator>
 #include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "common/path_helper.h"
@@ -50,8 +85,18 @@
 #include "google_breakpad/processor/minidump.h"
 #include "google_breakpad/processor/minidump_processor.h"
 #include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/processing_stats.h"
+#include "google_breakpad/processor/stack_frame_symbolizer.h"
+#include "google_breakpad/processor/stack_signature_generator.h"
+#include "google_breakpad/processor/stackwalker.h"
+#include "google_breakpad/processor/terminal_frames.h"
+#include "processor/async_file_reader.h"
+#include "processor/disk_negative_symbol_cache.h"
 #include "processor/logging.h"
+#include "processor/numa_nodes.h"
+#include "processor/process_state_proto_writer.h"
 #include "processor/simple_symbol_supplier.h"
+#include "processor/snapshot_series.h"
 #include "processor/stackwalk_common.h"
 
 
@@ -59,23 +104,536 @@ namespace {
 
 struct Options {
   bool machine_readable;
+  bool proto;
+  bool json;
+  bool stats;
+  bool stack_signature;
   bool output_stack_contents;
   bool output_requesting_thread_only;
   bool brief;
+  int walk_concurrency;
+  bool deduplicate_stacks;
+  int symbol_prefetch_concurrency;
+  bool async_symbol_reads;
+  double walk_time_limit;
+  double thread_walk_time_limit;
+  int symbolized_frame_limit;
+  bool trust_frame_pointers;
+  google_breakpad::TerminalFrames terminal_frames;
+  string negative_cache_path;
+  bool index_symbol_paths;
+  bool read_compressed_symbols;
+  bool serve;
+  int batch_concurrency;
+  bool numa;
+  string batch_input;
+  string output_directory;
+  string snapshot_base;
 
   string minidump_file;
   std::vector<string> symbol_paths;
 };
 
+using google_breakpad::AsyncFileReader;
 using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::CodeModule;
+using google_breakpad::DiskNegativeSymbolCache;
+using google_breakpad::JSONProcessStatePrinter;
 using google_breakpad::Minidump;
 using google_breakpad::MinidumpMemoryList;
+using google_breakpad::MinidumpModuleList;
 using google_breakpad::MinidumpThreadList;
 using google_breakpad::MinidumpProcessor;
+using google_breakpad::NumaNodes;
+using google_breakpad::ProcessResult;
+using google_breakpad::ProcessResultName;
 using google_breakpad::ProcessState;
+using google_breakpad::ProcessStateProtoWriter;
+using google_breakpad::ProcessingStats;
 using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::StackFrameSymbolizer;
+using google_breakpad::StackSignatureGenerator;
+using google_breakpad::SymbolSupplier;
+using google_breakpad::Stackwalker;
 using google_breakpad::scoped_ptr;
 
+// The size of the buffer for JSON output, which is printed in many small
+// writes.
+const size_t kJSONOutputBufferSize = 1 << 20;
+
+// The module, by code file, of each version claimed by a minidump.
+typedef std::map<string, const CodeModule*> ClaimedModules;
+
+// Tracks the version, by debug identifier, of each module that the
+// resolver may hold symbols for, since the resolver knows modules by code
+// file alone.  A minidump claims the versions of its modules before it is
+// processed, unloading symbols for versions that are no longer claimed, and
+// releases them afterwards.  Minidumps claiming different versions of a
+// module are processed one after the other.
+class ModuleVersionTracker {
+ public:
+  explicit ModuleVersionTracker(BasicSourceLineResolver* resolver)
+      : resolver_(resolver) {}
+
+  // Claims the versions of dump's modules, and records them in claimed.
+  // Blocks while another minidump holds a different version of one of
+  // them.
+  void Claim(Minidump* dump, ClaimedModules* claimed);
+
+  // Releases the versions recorded in claimed by Claim.
+  void Release(const ClaimedModules& claimed);
+
+ private:
+  struct Version {
+    Version() : users(0) {}
+
+    string debug_identifier;
+    int users;
+  };
+
+  // Returns true if another minidump holds a different version of one of
+  // the claimed modules.  lock_ must be held.
+  bool Conflicts(const ClaimedModules& claimed) const;
+
+  BasicSourceLineResolver* resolver_;
+  std::map<string, Version> versions_;
+  std::mutex lock_;
+  std::condition_variable released_;
+};
+
+void ModuleVersionTracker::Claim(Minidump* dump, ClaimedModules* claimed) {
+  claimed->clear();
+  MinidumpModuleList* module_list = dump->GetModuleList();
+  if (module_list) {
+    for (unsigned int i = 0; i < module_list->module_count(); ++i) {
+      const CodeModule* module = module_list->GetModuleAtIndex(i);
+      claimed->insert(std::make_pair(module->code_file(), module));
+    }
+  }
+
+  std::unique_lock<std::mutex> lock(lock_);
+  released_.wait(lock, [this, claimed] { return !Conflicts(*claimed); });
+  for (ClaimedModules::const_iterator iterator = claimed->begin();
+       iterator != claimed->end(); ++iterator) {
+    const CodeModule* module = iterator->second;
+    Version& version = versions_[iterator->first];
+    if (version.debug_identifier != module->debug_identifier()) {
+      if (resolver_->HasModule(module)) {
+        BPLOG(INFO) << "Unloading symbols for module " << module->code_file()
+                    << " with debug identifier " << version.debug_identifier;
+        resolver_->UnloadModule(module);
+      }
+      version.debug_identifier = module->debug_identifier();
+    }
+    ++version.users;
+  }
+}
+
+void ModuleVersionTracker::Release(const ClaimedModules& claimed) {
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    for (ClaimedModules::const_iterator iterator = claimed.begin();
+         iterator != claimed.end(); ++iterator) {
+      --versions_[iterator->first].users;
+    }
+  }
+  released_.notify_all();
+}
+
+bool ModuleVersionTracker::Conflicts(const ClaimedModules& claimed) const {
+  for (ClaimedModules::const_iterator iterator = claimed.begin();
+       iterator != claimed.end(); ++iterator) {
+    std::map<string, Version>::const_iterator version =
+        versions_.find(iterator->first);
+    if (version != versions_.end() && version->second.users > 0 &&
+        version->second.debug_identifier !=
+            iterator->second->debug_identifier()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Applies the processing options to minidump_processor.
+void ConfigureProcessor(const Options& options,
+                        MinidumpProcessor* minidump_processor) {
+  minidump_processor->set_walk_concurrency(options.walk_concurrency);
+  minidump_processor->set_deduplicate_stacks(options.deduplicate_stacks);
+  minidump_processor->set_symbol_prefetch_concurrency(
+      options.symbol_prefetch_concurrency);
+  minidump_processor->set_async_symbol_prefetch(options.async_symbol_reads);
+  minidump_processor->set_collect_stats(options.stats);
+  minidump_processor->set_walk_time_limit(options.walk_time_limit);
+  minidump_processor->set_thread_walk_time_limit(
+      options.thread_walk_time_limit);
+  // The brief output shows only the requesting thread, so the other
+  // threads need never be walked.
+  minidump_processor->set_defer_thread_walks(
+      options.brief && !options.json && !options.proto &&
+      !options.machine_readable);
+  minidump_processor->set_symbolized_frame_limit(
+      options.symbolized_frame_limit);
+  if (!options.terminal_frames.empty())
+    minidump_processor->set_terminal_frames(&options.terminal_frames);
+  Stackwalker::set_trust_frame_pointers(options.trust_frame_pointers);
+  if (options.stack_signature) {
+    static const StackSignatureGenerator stack_signature_generator;
+    minidump_processor->set_stack_signature_generator(
+        &stack_signature_generator);
+  }
+}
+
+// Reads the whole of the file at path into contents.
+bool ReadFile(const string& path, string* contents) {
+  std::ifstream file(path.c_str(), std::ios::binary);
+  if (!file)
+    return false;
+  contents->assign(std::istreambuf_iterator<char>(file),
+                   std::istreambuf_iterator<char>());
+  return !file.bad();
+}
+
+// Processes minidump_file using minidump_processor, and prints the results
+// to output.  If version_tracker is not NULL, the minidump claims its
+// modules' versions from it while it is processed.
+//
+// Returns the result of processing the minidump.
+ProcessResult PrintMinidump(const Options& options,
+                            const string& minidump_file,
+                            FILE* output,
+                            MinidumpProcessor* minidump_processor,
+                            BasicSourceLineResolver* resolver,
+                            ModuleVersionTracker* version_tracker) {
+  double read_start = ProcessingStats::WallSeconds();
+  std::istringstream snapshot;
+  scoped_ptr<Minidump> dump;
+  if (options.snapshot_base.empty()) {
+    dump.reset(new Minidump(minidump_file));
+  } else {
+    string base, delta, contents;
+    if (!ReadFile(options.snapshot_base, &base) ||
+        !ReadFile(minidump_file, &delta) ||
+        !google_breakpad::ReconstructSnapshot(base, delta, &contents)) {
+      BPLOG(ERROR) << "Snapshot " << minidump_file
+                   << " could not be reconstructed";
+      return google_breakpad::PROCESS_ERROR_MINIDUMP_NOT_FOUND;
+    }
+    snapshot.str(contents);
+    dump.reset(new Minidump(snapshot));
+  }
+  if (!dump->Read()) {
+     BPLOG(ERROR) << "Minidump " << minidump_file << " could not be read";
+     return google_breakpad::PROCESS_ERROR_MINIDUMP_NOT_FOUND;
+  }
+  double read_seconds = ProcessingStats::WallSeconds() - read_start;
+  ClaimedModules claimed;
+  if (version_tracker)
+    version_tracker->Claim(dump.get(), &claimed);
+  ProcessState process_state;
+  // JSON is printed as the minidump is processed, even if processing
+  // fails.
+  scoped_ptr<JSONProcessStatePrinter> json_printer;
+  if (options.json) {
+    json_printer.reset(new JSONProcessStatePrinter(output));
+    minidump_processor->set_observer(json_printer.get());
+  }
+  ProcessResult result =
+      minidump_processor->Process(dump.get(), &process_state);
+  if (json_printer.get()) {
+    minidump_processor->set_observer(NULL);
+    json_printer->Finish(process_state, result == google_breakpad::PROCESS_OK);
+  }
+  if (result != google_breakpad::PROCESS_OK) {
+    BPLOG(ERROR) << "MinidumpProcessor::Process failed";
+  } else if (options.json) {
+    // Printed as the minidump was processed.
+  } else if (options.proto) {
+    ProcessStateProtoWriter writer(output);
+    if (!writer.Write(process_state))
+      BPLOG(ERROR) << "Could not write the output for " << minidump_file;
+  } else if (options.machine_readable) {
+    PrintProcessStateMachineReadable(output, process_state);
+  } else if (options.brief) {
+    PrintRequestingThreadBrief(output, process_state);
+  } else {
+    PrintProcessState(output, process_state, options.output_stack_contents,
+                      options.output_requesting_thread_only, resolver);
+  }
+  if (version_tracker)
+    version_tracker->Release(claimed);
+
+  if (options.stats) {
+    // Statistics from concurrent batch workers are printed whole.
+    flockfile(stderr);
+    fprintf(stderr, "Processing statistics for %s:\n", minidump_file.c_str());
+    fprintf(stderr, "Minidump file read in %.6f s\n", read_seconds);
+    PrintProcessingStats(stderr, process_state);
+    funlockfile(stderr);
+  }
+
+  return result;
+}
+
+// Appends the path of each minidump (*.dmp) file under directory, which is
+// searched recursively, to minidump_files.  Returns false if a directory
+// could not be read.
+bool FindMinidumps(const string& directory,
+                   std::vector<string>* minidump_files) {
+  DIR* dir = opendir(directory.c_str());
+  if (!dir) {
+    BPLOG(ERROR) << "Could not open directory " << directory << ": "
+                 << strerror(errno);
+    return false;
+  }
+  static const char kMinidumpExtension[] = ".dmp";
+  const size_t extension_length = sizeof(kMinidumpExtension) - 1;
+  bool found = true;
+  while (struct dirent* entry = readdir(dir)) {
+    string name = entry->d_name;
+    if (name == "." || name == "..")
+      continue;
+    string path = directory + "/" + name;
+    struct stat path_stat;
+    if (stat(path.c_str(), &path_stat) != 0)
+      continue;
+    if (S_ISDIR(path_stat.st_mode)) {
+      found = FindMinidumps(path, minidump_files) && found;
+    } else if (S_ISREG(path_stat.st_mode) &&
+               name.size() > extension_length &&
+               name.compare(name.size() - extension_length, extension_length,
+                            kMinidumpExtension) == 0) {
+      minidump_files->push_back(path);
+    }
+  }
+  closedir(dir);
+  return found;
+}
+
+// Sets minidump_files to the minidumps named by input: those under it if
+// it is a directory, or those listed in it, one per line, otherwise.
+// Returns false if input could not be read.
+bool GetBatchMinidumps(const string& input,
+                       std::vector<string>* minidump_files) {
+  struct stat input_stat;
+  if (stat(input.c_str(), &input_stat) == 0 && S_ISDIR(input_stat.st_mode)) {
+    if (!FindMinidumps(input, minidump_files))
+      return false;
+    std::sort(minidump_files->begin(), minidump_files->end());
+    return true;
+  }
+
+  std::ifstream list(input.c_str());
+  if (!list) {
+    BPLOG(ERROR) << "Could not open minidump list " << input;
+    return false;
+  }
+  string minidump_file;
+  while (std::getline(list, minidump_file)) {
+    if (!minidump_file.empty())
+      minidump_files->push_back(minidump_file);
+  }
+  return true;
+}
+
+// The minidumps of a batch routed to one NUMA node, or all of them without
+// NUMA placement, and the symbols loaded to process them.
+struct BatchNode {
+  explicit BatchNode(SymbolSupplier* symbol_supplier)
+      : frame_symbolizer(symbol_supplier, &resolver),
+        version_tracker(&resolver),
+        next_minidump(0) {
+    // The resolver keeps symbols between minidumps, so the symbolized
+    // frames drawn from it stay valid too.
+    frame_symbolizer.set_keep_frame_memo_across_resets(true);
+  }
+
+  // The number of minidumps not yet taken.
+  size_t remaining() const {
+    size_t next = next_minidump.load();
+    return next < minidumps.size() ? minidumps.size() - next : 0;
+  }
+
+  BasicSourceLineResolver resolver;
+  StackFrameSymbolizer frame_symbolizer;
+  ModuleVersionTracker version_tracker;
+  // Indices into the batch's minidump_files.
+  std::vector<size_t> minidumps;
+  std::atomic<size_t> next_minidump;
+};
+
+// Routes each of minidump_files to one of nodes, keeping minidumps with the
+// same main module together so that its symbols are loaded on one node.
+// Groups are placed largest first on the node with the least work for each
+// of its workers_per_node[node] threads.
+void RouteMinidumps(const std::vector<string>& minidump_files,
+                    const std::vector<int>& workers_per_node,
+                    std::vector<std::unique_ptr<BatchNode> >* nodes) {
+  std::map<string, std::vector<size_t> > groups;
+  for (size_t i = 0; i < minidump_files.size(); ++i) {
+    // Minidumps that can't be read fail quickly wherever they go.
+    string key;
+    Minidump dump(minidump_files[i]);
+    MinidumpModuleList* module_list =
+        dump.Read() ? dump.GetModuleList() : NULL;
+    const CodeModule* main_module =
+        module_list ? module_list->GetMainModule() : NULL;
+    if (main_module)
+      key = main_module->code_file() + "/" + main_module->debug_identifier();
+    groups[key].push_back(i);
+  }
+
+  std::vector<const std::vector<size_t>*> by_size;
+  for (std::map<string, std::vector<size_t> >::const_iterator group =
+           groups.begin();
+       group != groups.end(); ++group) {
+    by_size.push_back(&group->second);
+  }
+  std::stable_sort(by_size.begin(), by_size.end(),
+                   [](const std::vector<size_t>* a,
+                      const std::vector<size_t>* b) {
+                     return a->size() > b->size();
+                   });
+  for (size_t i = 0; i < by_size.size(); ++i) {
+    size_t target = 0;
+    for (size_t node = 1; node < nodes->size(); ++node) {
+      if ((*nodes)[node]->minidumps.size() * workers_per_node[target] <
+          (*nodes)[target]->minidumps.size() * workers_per_node[node]) {
+        target = node;
+      }
+    }
+    std::vector<size_t>& minidumps = (*nodes)[target]->minidumps;
+    minidumps.insert(minidumps.end(), by_size[i]->begin(),
+                     by_size[i]->end());
+  }
+}
+
+// Processes the minidumps named by options.batch_input on
+// options.batch_concurrency threads sharing loaded symbols, writing the
+// results for each to a file, named for the minidump, in
+// options.output_directory.  Reports the outcome for each minidump on
+// stdout, followed by totals.
+//
+// If options.numa is set and the machine has more than one NUMA node, the
+// threads are spread over the nodes and bound to them, and each node has
+// its own resolver, whose symbols are allocated in its memory.  Minidumps
+// are routed to nodes by main module; a thread whose node has no minidumps
+// left takes them from the node with the most, loading their symbols on its
+// own node.
+//
+// Returns false if any minidump could not be processed.
+bool ProcessMinidumpBatch(const Options& options,
+                          SymbolSupplier* symbol_supplier) {
+  std::vector<string> minidump_files;
+  if (!GetBatchMinidumps(options.batch_input, &minidump_files))
+    return false;
+
+  // Each minidump's output is named for it, so the names must be distinct.
+  std::vector<string> output_files;
+  std::set<string> output_names;
+  for (size_t i = 0; i < minidump_files.size(); ++i) {
+    string output_name = google_breakpad::BaseName(minidump_files[i]);
+    if (!output_names.insert(output_name).second) {
+      BPLOG(ERROR) << "More than one minidump is named " << output_name;
+      return false;
+    }
+    output_files.push_back(options.output_directory + "/" + output_name +
+                           (options.proto ? ".pb" :
+                            options.json ? ".json" : ".txt"));
+  }
+
+  scoped_ptr<NumaNodes> numa_nodes;
+  if (options.numa) {
+    numa_nodes.reset(new NumaNodes());
+    if (numa_nodes->node_count() < 2) {
+      BPLOG(INFO) << "Found " << numa_nodes->node_count()
+                  << " NUMA nodes; not placing batch threads";
+      numa_nodes.reset();
+    }
+  }
+
+  size_t node_count = numa_nodes.get() ?
+      std::min(numa_nodes->node_count(),
+               static_cast<size_t>(options.batch_concurrency)) : 1;
+  std::vector<std::unique_ptr<BatchNode> > nodes;
+  std::vector<int> workers_per_node(node_count, 0);
+  for (size_t node = 0; node < node_count; ++node)
+    nodes.emplace_back(new BatchNode(symbol_supplier));
+  for (int i = 0; i < options.batch_concurrency; ++i)
+    ++workers_per_node[i % node_count];
+  if (node_count > 1) {
+    RouteMinidumps(minidump_files, workers_per_node, &nodes);
+  } else {
+    for (size_t i = 0; i < minidump_files.size(); ++i)
+      nodes[0]->minidumps.push_back(i);
+  }
+
+  std::atomic<size_t> failures(0);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < options.batch_concurrency; ++i) {
+    workers.push_back(std::thread([&, i] {
+      BatchNode* node = nodes[i % node_count].get();
+      // Bind before anything is allocated, so that it is local.
+      if (numa_nodes.get())
+        numa_nodes->BindCurrentThread(i % node_count);
+      MinidumpProcessor minidump_processor(&node->frame_symbolizer, false);
+      ConfigureProcessor(options, &minidump_processor);
+      BatchNode* source = node;
+      while (source) {
+        size_t next = source->next_minidump++;
+        if (next >= source->minidumps.size()) {
+          // Take minidumps from the node with the most left.
+          source = NULL;
+          size_t most = 0;
+          for (size_t j = 0; j < nodes.size(); ++j) {
+            size_t remaining = nodes[j]->remaining();
+            if (remaining > most) {
+              most = remaining;
+              source = nodes[j].get();
+            }
+          }
+          continue;
+        }
+        size_t index = source->minidumps[next];
+        const string& minidump_file = minidump_files[index];
+        FILE* output = fopen(output_files[index].c_str(), "wb");
+        if (!output) {
+          printf("%s: FAILED (could not open %s: %s)\n",
+                 minidump_file.c_str(), output_files[index].c_str(),
+                 strerror(errno));
+          ++failures;
+          continue;
+        }
+        if (options.json)
+          setvbuf(output, NULL, _IOFBF, kJSONOutputBufferSize);
+        ProcessResult result = PrintMinidump(options, minidump_file, output,
+                                             &minidump_processor,
+                                             &node->resolver,
+                                             &node->version_tracker);
+        bool written = fclose(output) == 0;
+        if (result != google_breakpad::PROCESS_OK || !written)
+          unlink(output_files[index].c_str());
+        if (result != google_breakpad::PROCESS_OK) {
+          printf("%s: FAILED (%s)\n", minidump_file.c_str(),
+                 ProcessResultName(result));
+          ++failures;
+        } else if (!written) {
+          printf("%s: FAILED (could not write %s)\n", minidump_file.c_str(),
+                 output_files[index].c_str());
+          ++failures;
+        } else {
+          printf("%s: OK\n", minidump_file.c_str());
+        }
+      }
+    }));
+  }
+  for (size_t i = 0; i < workers.size(); ++i)
+    workers[i].join();
+
+  printf("%zu minidumps processed, %zu failed\n", minidump_files.size(),
+         failures.load());
+  return failures == 0;
+}
+
 // Processes |options.minidump_file| using MinidumpProcessor.
 // |options.symbol_path|, if non-empty, is the base directory of a
 // symbol storage area, laid out in the format required by
@@ -87,41 +645,72 @@ using google_breakpad::scoped_ptr;
 // information if the minidump was produced as a result of a crash, and
 // call stacks for each thread contained in the minidump.  All information
 // is printed to stdout.
+//
+// If options.serve is set, processes each minidump named on stdin instead,
+// with the same processor, and returns true at the end of input.  If
+// options.batch_concurrency is set, processes a batch of minidumps with
+// ProcessMinidumpBatch instead.
 bool PrintMinidumpProcess(const Options& options) {
   scoped_ptr<SimpleSymbolSupplier> symbol_supplier;
+  scoped_ptr<DiskNegativeSymbolCache> negative_cache;
+  scoped_ptr<AsyncFileReader> file_reader;
   if (!options.symbol_paths.empty()) {
     // TODO(mmentovai): check existence of symbol_path if specified?
     symbol_supplier.reset(new SimpleSymbolSupplier(options.symbol_paths));
+    symbol_supplier->set_use_directory_index(options.index_symbol_paths);
+    symbol_supplier->set_read_compressed_symbols(
+        options.read_compressed_symbols);
+    if (!options.negative_cache_path.empty()) {
+      negative_cache.reset(
+          new DiskNegativeSymbolCache(options.negative_cache_path));
+      symbol_supplier->set_negative_cache(negative_cache.get());
+    }
+    if (options.async_symbol_reads) {
+      // Every processor of a batch prefetches at once.
+      file_reader.reset(new AsyncFileReader(
+          options.symbol_prefetch_concurrency *
+          std::max(options.batch_concurrency, 1)));
+      symbol_supplier->set_async_file_reader(file_reader.get());
+    }
   }
 
-  BasicSourceLineResolver resolver;
-  MinidumpProcessor minidump_processor(symbol_supplier.get(), &resolver);
-
   // Increase the maximum number of threads and regions.
   MinidumpThreadList::set_max_threads(std::numeric_limits<uint32_t>::max());
   MinidumpMemoryList::set_max_regions(std::numeric_limits<uint32_t>::max());
-  // Process the minidump.
-  Minidump dump(options.minidump_file);
-  if (!dump.Read()) {
-     BPLOG(ERROR) << "Minidump " << dump.path() << " could not be read";
-     return false;
-  }
-  ProcessState process_state;
-  if (minidump_processor.Process(&dump, &process_state) !=
-      google_breakpad::PROCESS_OK) {
-    BPLOG(ERROR) << "MinidumpProcessor::Process failed";
-    return false;
-  }
 
-  if (options.machine_readable) {
-    PrintProcessStateMachineReadable(process_state);
-  } else if (options.brief) {
-    PrintRequestingThreadBrief(process_state);
-  } else {
-    PrintProcessState(process_state, options.output_stack_contents,
-                      options.output_requesting_thread_only, &resolver);
+  if (options.batch_concurrency > 0)
+    return ProcessMinidumpBatch(options, symbol_supplier.get());
+
+  BasicSourceLineResolver resolver;
+  StackFrameSymbolizer frame_symbolizer(symbol_supplier.get(), &resolver);
+  // The resolver keeps symbols between minidumps while serving, so the
+  // symbolized frames drawn from it stay valid too.
+  frame_symbolizer.set_keep_frame_memo_across_resets(options.serve);
+
+  if (options.json)
+    setvbuf(stdout, NULL, _IOFBF, kJSONOutputBufferSize);
+
+  MinidumpProcessor minidump_processor(&frame_symbolizer, false);
+  ConfigureProcessor(options, &minidump_processor);
+
+  if (!options.serve) {
+    return PrintMinidump(options, options.minidump_file, stdout,
+                         &minidump_processor, &resolver, NULL) ==
+           google_breakpad::PROCESS_OK;
   }
 
+  ModuleVersionTracker version_tracker(&resolver);
+  string minidump_file;
+  while (std::getline(std::cin, minidump_file)) {
+    if (minidump_file.empty())
+      continue;
+    bool processed = PrintMinidump(options, minidump_file, stdout,
+                                   &minidump_processor, &resolver,
+                                   &version_tracker) ==
+                     google_breakpad::PROCESS_OK;
+    printf("%c%s\n", '\0', processed ? "OK" : "FAILED");
+    fflush(stdout);
+  }
   return true;
 }
 
@@ -130,15 +719,68 @@ bool PrintMinidumpProcess(const Options& options) {
 static void Usage(int argc, const char *argv[], bool error) {
   fprintf(error ? stderr : stdout,
           "Usage: %s [options] <minidump-file> [symbol-path ...]\n"
+          "       %s -S [options] [symbol-path ...]\n"
+          "       %s -B <n> -o <dir> [options] <minidump-dir-or-list> "
+          "[symbol-path ...]\n"
           "\n"
-          "Output a stack trace for the provided minidump\n"
+          "Output a stack trace for the provided minidump, or with -S, for\n"
+          "each minidump path read from stdin, or with -B, for each minidump\n"
+          "in a directory or list file\n"
           "\n"
           "Options:\n"
           "\n"
           "  -m         Output in machine-readable format\n"
+          "  -J         Output JSON, printing each thread as soon as its\n"
+          "             stack is walked\n"
+          "  -P         Output a binary ProcessStateProto, as described in\n"
+          "             processor/proto/process_state.proto\n"
           "  -s         Output stack contents\n"
+          "  -t         Print time spent in each phase of processing and in\n"
+          "             loading each module's symbols, and counts of frames\n"
+          "             by trust and of symbol lookups, to stderr\n"
           "  -c         Output thread that causes crash or dump only\n"
-          "  -b         Brief of the thread that causes crash or dump\n",
+          "  -b         Brief of the thread that causes crash or dump\n"
+          "  -g         Output a signature of the top frames of the thread\n"
+          "             that causes crash or dump, and its hash\n"
+          "  -d         Walk threads with identical stacks once\n"
+          "  -j <n>     Walk up to n threads' stacks concurrently\n"
+          "  -p <n>     Fetch symbols for up to n modules concurrently before\n"
+          "             walking\n"
+          "  -a         With -p, read symbol files asynchronously, through\n"
+          "             io_uring where available, rather than on a thread\n"
+          "             per module\n"
+          "  -w <s>     Stop walking stacks after s seconds per minidump,\n"
+          "             keeping the frames walked so far\n"
+          "  -W <s>     Stop walking each thread's stack after s seconds\n"
+          "  -k <n>     Look up functions and source lines for only the top\n"
+          "             n frames of each stack\n"
+          "  -F         Follow AMD64 and ARM64 frame pointer chains without\n"
+          "             looking for unwind information, for code built with\n"
+          "             frame pointers everywhere\n"
+          "  -E         Stop each stack walk after a function that starts\n"
+          "             threads or programs, such as start_thread, clone,\n"
+          "             thread_start or RtlUserThreadStart\n"
+          "  -e <file>  Stop each stack walk after a function listed in\n"
+          "             file, one [module!]function per line\n"
+          "  -n <dir>   Remember modules without symbols in dir for an hour\n"
+          "  -i         List the symbol paths once instead of checking them\n"
+          "             for each module's symbols\n"
+          "  -z         Read symbol files compressed as .sym.gz or .sym.zst\n"
+          "             when there is no .sym file\n"
+          "  -S         Serve minidump paths from stdin, keeping symbols\n"
+          "             loaded.  Each output ends with a line of NUL and\n"
+          "             OK or FAILED\n"
+          "  -B <n>     Process a batch of minidumps on n threads\n"
+          "  -N         Spread the threads of a batch over the NUMA nodes,\n"
+          "             each loading its own copy of symbols, and process\n"
+          "             minidumps with the same main module on one node\n"
+          "  -o <dir>   Write the output for each minidump in a batch to\n"
+          "             dir/<minidump-name>.txt, or .json with -J, or .pb\n"
+          "             with -P\n"
+          "  -r <file>  Each minidump is a later snapshot of the series\n"
+          "             whose first snapshot is file\n",
+          google_breakpad::BaseName(argv[0]).c_str(),
+          google_breakpad::BaseName(argv[0]).c_str(),
           google_breakpad::BaseName(argv[0]).c_str());
 }
 
@@ -146,29 +788,147 @@ static void SetupOptions(int argc, const char *argv[], Options* options) {
   int ch;
 
   options->machine_readable = false;
+  options->proto = false;
+  options->json = false;
+  options->stats = false;
+  options->stack_signature = false;
   options->output_stack_contents = false;
   options->output_requesting_thread_only = false;
   options->brief = false;
+  options->walk_concurrency = 1;
+  options->deduplicate_stacks = false;
+  options->symbol_prefetch_concurrency = 0;
+  options->async_symbol_reads = false;
+  options->walk_time_limit = 0;
+  options->thread_walk_time_limit = 0;
+  options->symbolized_frame_limit = 0;
+  options->trust_frame_pointers = false;
+  options->index_symbol_paths = false;
+  options->read_compressed_symbols = false;
+  options->serve = false;
+  options->batch_concurrency = 0;
+  options->numa = false;
 
-  while ((ch = getopt(argc, (char* const*)argv, "bchms")) != -1) {
+  while ((ch = getopt(argc, (char* const*)argv,
+                      "aB:bcdEe:FghiJj:k:mNn:o:Pp:r:sStW:w:z")) != -1) {
     switch (ch) {
       case 'h':
         Usage(argc, argv, false);
         exit(0);
         break;
 
+      case 'a':
+        options->async_symbol_reads = true;
+        break;
+
+      case 'B':
+        options->batch_concurrency = atoi(optarg);
+        if (options->batch_concurrency < 1) {
+          fprintf(stderr, "%s: Invalid concurrency: %s\n", argv[0], optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        break;
       case 'b':
         options->brief = true;
         break;
       case 'c':
         options->output_requesting_thread_only = true;
         break;
+      case 'd':
+        options->deduplicate_stacks = true;
+        break;
+      case 'E':
+        options->terminal_frames.AddDefaults();
+        break;
+      case 'e':
+        if (!options->terminal_frames.Read(optarg)) {
+          fprintf(stderr, "%s: Can't read terminal functions from %s\n",
+                  argv[0], optarg);
+          exit(1);
+        }
+        break;
+      case 'F':
+        options->trust_frame_pointers = true;
+        break;
+      case 'g':
+        options->stack_signature = true;
+        break;
+      case 'i':
+        options->index_symbol_paths = true;
+        break;
+      case 'J':
+        options->json = true;
+        break;
+      case 'j':
+        options->walk_concurrency = atoi(optarg);
+        if (options->walk_concurrency < 1) {
+          fprintf(stderr, "%s: Invalid concurrency: %s\n", argv[0], optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        break;
+      case 'k':
+        options->symbolized_frame_limit = atoi(optarg);
+        if (options->symbolized_frame_limit < 1) {
+          fprintf(stderr, "%s: Invalid frame count: %s\n", argv[0], optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        break;
       case 'm':
         options->machine_readable = true;
         break;
+      case 'N':
+        options->numa = true;
+        break;
+      case 'n':
+        options->negative_cache_path = optarg;
+        break;
+      case 'o':
+        options->output_directory = optarg;
+        break;
+      case 'P':
+        options->proto = true;
+        break;
+      case 'p':
+        options->symbol_prefetch_concurrency = atoi(optarg);
+        if (options->symbol_prefetch_concurrency < 1) {
+          fprintf(stderr, "%s: Invalid concurrency: %s\n", argv[0], optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        break;
+      case 'r':
+        options->snapshot_base = optarg;
+        break;
       case 's':
         options->output_stack_contents = true;
         break;
+      case 'S':
+        options->serve = true;
+        break;
+      case 't':
+        options->stats = true;
+        break;
+      case 'w':
+      case 'W': {
+        char* end;
+        double seconds = strtod(optarg, &end);
+        if (*optarg == '\0' || *end != '\0' || !(seconds > 0)) {
+          fprintf(stderr, "%s: Invalid time limit: %s\n", argv[0], optarg);
+          Usage(argc, argv, true);
+          exit(1);
+        }
+        if (ch == 'w')
+          options->walk_time_limit = seconds;
+        else
+          options->thread_walk_time_limit = seconds;
+        break;
+      }
+      case 'z':
+        options->read_compressed_symbols = true;
+        break;
 
       case '?':
         Usage(argc, argv, true);
@@ -177,15 +937,55 @@ static void SetupOptions(int argc, const char *argv[], Options* options) {
     }
   }
 
-  if ((argc - optind) == 0) {
-    fprintf(stderr, "%s: Missing minidump file\n", argv[0]);
+  if (options->serve && options->batch_concurrency > 0) {
+    fprintf(stderr, "%s: -S and -B cannot be combined\n", argv[0]);
+    Usage(argc, argv, true);
+    exit(1);
+  }
+  if (options->json && options->proto) {
+    fprintf(stderr, "%s: -J and -P cannot be combined\n", argv[0]);
+    Usage(argc, argv, true);
+    exit(1);
+  }
+  if (options->serve && options->proto) {
+    fprintf(stderr, "%s: -S and -P cannot be combined\n", argv[0]);
+    Usage(argc, argv, true);
+    exit(1);
+  }
+  if (options->async_symbol_reads &&
+      options->symbol_prefetch_concurrency == 0) {
+    fprintf(stderr, "%s: -a requires -p\n", argv[0]);
+    Usage(argc, argv, true);
+    exit(1);
+  }
+  if (options->numa && options->batch_concurrency == 0) {
+    fprintf(stderr, "%s: -N requires -B\n", argv[0]);
+    Usage(argc, argv, true);
+    exit(1);
+  }
+  if ((options->batch_concurrency > 0) != !options->output_directory.empty()) {
+    fprintf(stderr, "%s: -B and -o must be given together\n", argv[0]);
     Usage(argc, argv, true);
     exit(1);
   }
 
-  options->minidump_file = argv[optind];
+  if (options->batch_concurrency > 0) {
+    if ((argc - optind) == 0) {
+      fprintf(stderr, "%s: Missing minidump directory or list\n", argv[0]);
+      Usage(argc, argv, true);
+      exit(1);
+    }
+    options->batch_input = argv[optind++];
+  } else if (!options->serve) {
+    if ((argc - optind) == 0) {
+      fprintf(stderr, "%s: Missing minidump file\n", argv[0]);
+      Usage(argc, argv, true);
+      exit(1);
+    }
+    options->minidump_file = argv[optind++];
+  }
 
-  for (int argi = optind + 1; argi < argc; ++argi)
+  for (int argi = optind; argi < argc; ++argi)
     options->symbol_paths.push_back(argv[argi]);
 }
 
@@ -35,12 +35,19 @@
 
 #include <iostream>
 #include <fstream>
+#include <iterator>
 #include <sstream>
 #include <stdlib.h>
 #include <string>
+#include <unistd.h>
 #include <vector>
 
 #include "breakpad_googletest_includes.h"
+#include "common/compressed_minidump.h"
+#if defined(__linux__)
+#include "common/linux/memory_mapped_file.h"
+#endif  // __linux__
+#include "common/lz4_block.h"
 #include "common/using_std_string.h"
 #include "google_breakpad/common/minidump_format.h"
 #include "google_breakpad/processor/minidump.h"
@@ -49,10 +56,20 @@
 
 namespace {
 
+using google_breakpad::CompressedMinidumpFrame;
+using google_breakpad::CompressedMinidumpHeader;
+using google_breakpad::CompressedMinidumpSegment;
+#if defined(__linux__)
+using google_breakpad::MemoryMappedFile;
+#endif  // __linux__
 using google_breakpad::Minidump;
 using google_breakpad::MinidumpContext;
 using google_breakpad::MinidumpCrashpadInfo;
+using google_breakpad::MinidumpCrashSignature;
+using google_breakpad::MinidumpDumpTiming;
 using google_breakpad::MinidumpException;
+using google_breakpad::MinidumpMemory64List;
+using google_breakpad::MinidumpMemory64Region;
 using google_breakpad::MinidumpMemoryInfo;
 using google_breakpad::MinidumpMemoryInfoList;
 using google_breakpad::MinidumpMemoryList;
@@ -77,6 +94,7 @@ using google_breakpad::SynthMinidump::SystemInfo;
 using google_breakpad::SynthMinidump::Thread;
 using google_breakpad::test_assembler::kBigEndian;
 using google_breakpad::test_assembler::kLittleEndian;
+using google_breakpad::test_assembler::Label;
 using std::ifstream;
 using std::istringstream;
 using std::vector;
@@ -88,9 +106,116 @@ public:
     minidump_file_ = string(getenv("srcdir") ? getenv("srcdir") : ".") +
       "/src/processor/testdata/minidump2.dmp";
   }
+
+  string ReadMinidumpFile() {
+    ifstream file_stream(minidump_file_.c_str(),
+                         std::ios::in | std::ios::binary);
+    return string(std::istreambuf_iterator<char>(file_stream),
+                  std::istreambuf_iterator<char>());
+  }
+
   string minidump_file_;
 };
 
+uint32_t CompressedField(uint32_t value, bool swap) {
+  if (!swap)
+    return value;
+  return (value >> 24) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) |
+      (value << 24);
+}
+
+// Returns |contents| laid out as a compressed minidump, with each frame
+// holding |frame_size| bytes of it as two segments in reverse order.  The
+// first frame also holds a segment of garbage that the last frame
+// overwrites.  If |swap| is set, the fields are byte-swapped, as if a
+// machine of the other byte order had written them.
+string CompressMinidump(const string& contents, size_t frame_size,
+                        bool swap) {
+  string compressed;
+  CompressedMinidumpHeader header;
+  header.magic =
+      CompressedField(google_breakpad::kCompressedMinidumpMagic, swap);
+  header.version =
+      CompressedField(google_breakpad::kCompressedMinidumpVersion, swap);
+  compressed.append(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  vector<uint32_t> hash_table(google_breakpad::kLZ4HashTableSize);
+  for (size_t start = 0; start < contents.size(); start += frame_size) {
+    const size_t end = std::min(start + frame_size, contents.size());
+    const size_t middle = start + (end - start) / 2;
+    string raw;
+    if (start == 0) {
+      CompressedMinidumpSegment garbage;
+      garbage.position = CompressedField(
+          static_cast<uint32_t>(contents.size() - 4), swap);
+      garbage.size = CompressedField(4, swap);
+      raw.append(reinterpret_cast<const char*>(&garbage), sizeof(garbage));
+      raw.append("junk");
+    }
+    const size_t pieces[2][2] = { { middle, end }, { start, middle } };
+    for (const auto& piece : pieces) {
+      CompressedMinidumpSegment segment;
+      segment.position =
+          CompressedField(static_cast<uint32_t>(piece[0]), swap);
+      segment.size =
+          CompressedField(static_cast<uint32_t>(piece[1] - piece[0]), swap);
+      raw.append(reinterpret_cast<const char*>(&segment), sizeof(segment));
+      raw.append(contents, piece[0], piece[1] - piece[0]);
+    }
+
+    vector<uint8_t> block(google_breakpad::LZ4CompressBound(raw.size()));
+    const size_t block_size = google_breakpad::LZ4Compress(
+        reinterpret_cast<const uint8_t*>(raw.data()), raw.size(), &block[0],
+        &hash_table[0]);
+    CompressedMinidumpFrame frame;
+    frame.raw_size = CompressedField(static_cast<uint32_t>(raw.size()), swap);
+    frame.stored_size =
+        CompressedField(static_cast<uint32_t>(block_size), swap);
+    compressed.append(reinterpret_cast<const char*>(&frame), sizeof(frame));
+    compressed.append(reinterpret_cast<const char*>(&block[0]), block_size);
+  }
+  return compressed;
+}
+
+// Checks that |compressed| reads back as the same minidump as |plain|.
+void ExpectSameMinidump(Minidump* plain, Minidump* compressed) {
+  ASSERT_TRUE(plain->Read());
+  ASSERT_TRUE(compressed->Read());
+  EXPECT_TRUE(compressed->is_memory_backed());
+  EXPECT_EQ(plain->GetDirectoryEntryCount(),
+            compressed->GetDirectoryEntryCount());
+
+  MinidumpModuleList* plain_modules = plain->GetModuleList();
+  MinidumpModuleList* compressed_modules = compressed->GetModuleList();
+  ASSERT_TRUE(plain_modules != NULL);
+  ASSERT_TRUE(compressed_modules != NULL);
+  ASSERT_EQ(plain_modules->module_count(),
+            compressed_modules->module_count());
+  for (unsigned int i = 0; i < plain_modules->module_count(); ++i) {
+    EXPECT_EQ(plain_modules->GetModuleAtIndex(i)->code_file(),
+              compressed_modules->GetModuleAtIndex(i)->code_file());
+    EXPECT_EQ(plain_modules->GetModuleAtIndex(i)->debug_identifier(),
+              compressed_modules->GetModuleAtIndex(i)->debug_identifier());
+  }
+
+  MinidumpMemoryList* plain_memory = plain->GetMemoryList();
+  MinidumpMemoryList* compressed_memory = compressed->GetMemoryList();
+  ASSERT_TRUE(plain_memory != NULL);
+  ASSERT_TRUE(compressed_memory != NULL);
+  ASSERT_EQ(plain_memory->region_count(), compressed_memory->region_count());
+  for (unsigned int i = 0; i < plain_memory->region_count(); ++i) {
+    MinidumpMemoryRegion* plain_region =
+        plain_memory->GetMemoryRegionAtIndex(i);
+    MinidumpMemoryRegion* compressed_region =
+        compressed_memory->GetMemoryRegionAtIndex(i);
+    ASSERT_EQ(plain_region->GetBase(), compressed_region->GetBase());
+    ASSERT_EQ(plain_region->GetSize(), compressed_region->GetSize());
+    EXPECT_EQ(0, memcmp(plain_region->GetMemory(),
+                        compressed_region->GetMemory(),
+                        plain_region->GetSize()));
+  }
+}
+
 TEST_F(MinidumpTest, TestMinidumpFromFile) {
   Minidump minidump(minidump_file_);
   ASSERT_EQ(minidump.path(), minidump_file_);
@@ -135,6 +260,93 @@ TEST_F(MinidumpTest, TestMinidumpFromStream) {
   //TODO: add more checks here
 }
 
+TEST_F(MinidumpTest, TestMinidumpFromBuffer) {
+  ifstream file_stream(minidump_file_.c_str(), std::ios::in | std::ios::binary);
+  ASSERT_TRUE(file_stream.good());
+  vector<uint8_t> bytes((std::istreambuf_iterator<char>(file_stream)),
+                        std::istreambuf_iterator<char>());
+  ASSERT_FALSE(bytes.empty());
+
+  Minidump minidump(&bytes[0], bytes.size());
+  ASSERT_EQ(minidump.path(), "");
+  ASSERT_TRUE(minidump.is_memory_backed());
+  ASSERT_TRUE(minidump.Read());
+  const MDRawHeader* header = minidump.header();
+  ASSERT_NE(header, (MDRawHeader*)NULL);
+  ASSERT_EQ(header->signature, uint32_t(MD_HEADER_SIGNATURE));
+
+  // Memory regions point into the buffer rather than into a copy.
+  MinidumpMemoryList* memory_list = minidump.GetMemoryList();
+  ASSERT_TRUE(memory_list != NULL);
+  ASSERT_GT(memory_list->region_count(), 0U);
+  for (unsigned int i = 0; i < memory_list->region_count(); ++i) {
+    MinidumpMemoryRegion* region = memory_list->GetMemoryRegionAtIndex(i);
+    ASSERT_TRUE(region != NULL);
+    const uint8_t* memory = region->GetMemory();
+    ASSERT_TRUE(memory != NULL);
+    EXPECT_GE(memory, &bytes[0]);
+    EXPECT_LE(memory + region->GetSize(), &bytes[0] + bytes.size());
+  }
+}
+
+#if defined(__linux__)
+TEST_F(MinidumpTest, TestMinidumpFromMappedFile) {
+  MemoryMappedFile mapped_file(minidump_file_.c_str(), 0);
+  ASSERT_NE(mapped_file.data(), (const void*)NULL);
+
+  Minidump mapped_minidump(mapped_file);
+  ASSERT_EQ(mapped_minidump.path(), "");
+  ASSERT_TRUE(mapped_minidump.is_memory_backed());
+  ASSERT_TRUE(mapped_minidump.Read());
+  const MDRawHeader* header = mapped_minidump.header();
+  ASSERT_NE(header, (MDRawHeader*)NULL);
+  ASSERT_EQ(header->signature, uint32_t(MD_HEADER_SIGNATURE));
+
+  MinidumpModuleList* md_module_list = mapped_minidump.GetModuleList();
+  ASSERT_TRUE(md_module_list != NULL);
+  const MinidumpModule* md_module = md_module_list->GetModuleAtIndex(0);
+  ASSERT_TRUE(md_module != NULL);
+  ASSERT_EQ("c:\\test_app.exe", md_module->code_file());
+  ASSERT_EQ("c:\\test_app.pdb", md_module->debug_file());
+  ASSERT_EQ("45D35F6C2d000", md_module->code_identifier());
+  ASSERT_EQ("5A9832E5287241C1838ED98914E9B7FF1", md_module->debug_identifier());
+
+  // Memory regions must match those read through a stream, and must point
+  // into the mapping rather than into a copy.
+  Minidump file_minidump(minidump_file_);
+  ASSERT_TRUE(file_minidump.Read());
+  MinidumpMemoryList* mapped_memory_list = mapped_minidump.GetMemoryList();
+  MinidumpMemoryList* file_memory_list = file_minidump.GetMemoryList();
+  ASSERT_TRUE(mapped_memory_list != NULL);
+  ASSERT_TRUE(file_memory_list != NULL);
+  ASSERT_EQ(file_memory_list->region_count(),
+            mapped_memory_list->region_count());
+  ASSERT_GT(mapped_memory_list->region_count(), 0U);
+
+  const uint8_t* mapping_start =
+      static_cast<const uint8_t*>(mapped_file.data());
+  const uint8_t* mapping_end = mapping_start + mapped_file.size();
+  for (unsigned int i = 0; i < mapped_memory_list->region_count(); ++i) {
+    MinidumpMemoryRegion* mapped_region =
+        mapped_memory_list->GetMemoryRegionAtIndex(i);
+    MinidumpMemoryRegion* file_region =
+        file_memory_list->GetMemoryRegionAtIndex(i);
+    ASSERT_TRUE(mapped_region != NULL);
+    ASSERT_TRUE(file_region != NULL);
+    ASSERT_EQ(file_region->GetBase(), mapped_region->GetBase());
+    ASSERT_EQ(file_region->GetSize(), mapped_region->GetSize());
+
+    const uint8_t* mapped_bytes = mapped_region->GetMemory();
+    const uint8_t* file_bytes = file_region->GetMemory();
+    ASSERT_TRUE(mapped_bytes != NULL);
+    ASSERT_TRUE(file_bytes != NULL);
+    EXPECT_GE(mapped_bytes, mapping_start);
+    EXPECT_LE(mapped_bytes + mapped_region->GetSize(), mapping_end);
+    EXPECT_EQ(0, memcmp(file_bytes, mapped_bytes, file_region->GetSize()));
+  }
+}
+#endif  // __linux__
+
 TEST_F(MinidumpTest, TestMinidumpWithCrashpadAnnotations) {
   string crashpad_minidump_file =
       string(getenv("srcdir") ? getenv("srcdir") : ".") +
@@ -171,6 +383,75 @@ TEST_F(MinidumpTest, TestMinidumpWithCrashpadAnnotations) {
   ASSERT_EQ(annotation_names, expected_strings);
 }
 
+TEST_F(MinidumpTest, TestCompressedMinidumpFromStream) {
+  const string contents = ReadMinidumpFile();
+  ASSERT_FALSE(contents.empty());
+
+  for (bool swap : { false, true }) {
+    istringstream compressed_stream(CompressMinidump(contents, 4096, swap));
+    Minidump plain_minidump(minidump_file_);
+    Minidump compressed_minidump(compressed_stream);
+    ExpectSameMinidump(&plain_minidump, &compressed_minidump);
+
+    // Reading again starts over from the decompressed minidump.
+    ASSERT_TRUE(compressed_minidump.Read());
+    ASSERT_TRUE(compressed_minidump.GetModuleList() != NULL);
+  }
+}
+
+TEST_F(MinidumpTest, TestCompressedMinidumpFromFile) {
+  const string contents = ReadMinidumpFile();
+  ASSERT_FALSE(contents.empty());
+
+  char path[] = "/tmp/minidump_unittest_compressed_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(-1, fd);
+  const string compressed = CompressMinidump(contents, 64 * 1024, false);
+  ASSERT_EQ(static_cast<ssize_t>(compressed.size()),
+            write(fd, compressed.data(), compressed.size()));
+  close(fd);
+  EXPECT_LT(compressed.size(), contents.size());
+
+  Minidump plain_minidump(minidump_file_);
+  Minidump compressed_minidump(path);
+  ExpectSameMinidump(&plain_minidump, &compressed_minidump);
+
+#if defined(__linux__)
+  MemoryMappedFile mapped_file(path, 0);
+  ASSERT_NE(mapped_file.data(), (const void*)NULL);
+  Minidump mapped_minidump(mapped_file);
+  ExpectSameMinidump(&plain_minidump, &mapped_minidump);
+#endif  // __linux__
+  unlink(path);
+}
+
+TEST_F(MinidumpTest, TestCorruptCompressedMinidump) {
+  const string compressed =
+      CompressMinidump(ReadMinidumpFile(), 4096, false);
+
+  // The last frame is missing a byte.
+  istringstream truncated_stream(compressed.substr(0, compressed.size() - 1));
+  Minidump truncated_minidump(truncated_stream);
+  EXPECT_FALSE(truncated_minidump.Read());
+
+  // The first frame claims more stored bytes than it decompresses to.
+  string bad_frame = compressed;
+  CompressedMinidumpFrame frame;
+  memcpy(&frame, &bad_frame[sizeof(CompressedMinidumpHeader)], sizeof(frame));
+  frame.stored_size = frame.raw_size + 1;
+  memcpy(&bad_frame[sizeof(CompressedMinidumpHeader)], &frame, sizeof(frame));
+  istringstream bad_frame_stream(bad_frame);
+  Minidump bad_frame_minidump(bad_frame_stream);
+  EXPECT_FALSE(bad_frame_minidump.Read());
+
+  // The version is unknown.
+  string bad_version = compressed;
+  bad_version[offsetof(CompressedMinidumpHeader, version)] = 2;
+  istringstream bad_version_stream(bad_version);
+  Minidump bad_version_minidump(bad_version_stream);
+  EXPECT_FALSE(bad_version_minidump.Read());
+}
+
 TEST(Dump, ReadBackEmpty) {
   Dump dump(0);
   dump.Finish();
@@ -258,6 +539,166 @@ TEST(Dump, OneMemory) {
   ASSERT_TRUE(memcmp("memory contents", region1_bytes, 15) == 0);
 }
 
+TEST(Dump, MemoryListLookups) {
+  Dump dump(0, kBigEndian);
+  Memory memory1(dump, 0x1000);
+  memory1.D32(0x01020304).D32(0x05060708).D32(0x090a0b0c);
+  Memory memory2(dump, 0x3000);
+  memory2.D64(0x1112131415161718ULL).D64(0x2122232425262728ULL);
+  dump.Add(&memory1);
+  dump.Add(&memory2);
+  dump.Finish();
+
+  string contents;
+  ASSERT_TRUE(dump.GetContents(&contents));
+  istringstream minidump_stream(contents);
+  Minidump minidump(minidump_stream);
+  ASSERT_TRUE(minidump.Read());
+  MinidumpMemoryList* memory_list = minidump.GetMemoryList();
+  ASSERT_TRUE(memory_list != NULL);
+  ASSERT_EQ(2U, memory_list->region_count());
+  MinidumpMemoryRegion* region1 = memory_list->GetMemoryRegionAtIndex(0);
+  MinidumpMemoryRegion* region2 = memory_list->GetMemoryRegionAtIndex(1);
+
+  // Repeated and alternating lookups find the right regions.
+  EXPECT_EQ(region1, memory_list->GetMemoryRegionForAddress(0x1000));
+  EXPECT_EQ(region1, memory_list->GetMemoryRegionForAddress(0x100b));
+  EXPECT_TRUE(memory_list->GetMemoryRegionForAddress(0x100c) == NULL);
+  EXPECT_EQ(region2, memory_list->GetMemoryRegionForAddress(0x300f));
+  EXPECT_EQ(region1, memory_list->GetMemoryRegionForAddress(0x1004));
+  EXPECT_TRUE(memory_list->GetMemoryRegionForAddress(0x3010) == NULL);
+  EXPECT_TRUE(memory_list->GetMemoryRegionForAddress(0xfff) == NULL);
+
+  // Ranges of values are byte-swapped like single values.
+  uint32_t values32[3];
+  ASSERT_TRUE(region1->GetMemoryRangeAtAddress(0x1000, 3, values32));
+  EXPECT_EQ(0x01020304U, values32[0]);
+  EXPECT_EQ(0x05060708U, values32[1]);
+  EXPECT_EQ(0x090a0b0cU, values32[2]);
+  EXPECT_TRUE(region1->GetMemoryRangeAtAddress(0x100c, 0, values32));
+  EXPECT_FALSE(region1->GetMemoryRangeAtAddress(0x1004, 3, values32));
+  EXPECT_FALSE(region1->GetMemoryRangeAtAddress(0xffc, 2, values32));
+  uint64_t values64[2];
+  ASSERT_TRUE(region2->GetMemoryRangeAtAddress(0x3000, 2, values64));
+  EXPECT_EQ(0x1112131415161718ULL, values64[0]);
+  EXPECT_EQ(0x2122232425262728ULL, values64[1]);
+
+  // Spans and copies hold the bytes as stored in the minidump.
+  const uint8_t kExpectedBytes[] = {0x05, 0x06, 0x07, 0x08, 0x09};
+  const uint8_t* span = region1->GetSpan(0x1004, 5);
+  ASSERT_TRUE(span != NULL);
+  EXPECT_EQ(0, memcmp(kExpectedBytes, span, 5));
+  uint8_t bytes[5];
+  ASSERT_TRUE(region1->CopyOut(0x1004, 5, bytes));
+  EXPECT_EQ(0, memcmp(kExpectedBytes, bytes, 5));
+  EXPECT_TRUE(region1->GetSpan(0x1004, 9) == NULL);
+  EXPECT_FALSE(region1->CopyOut(0x1004, 9, bytes));
+  EXPECT_TRUE(region1->GetSpan(0x1004, 0) == NULL);
+  uint32_t value32;
+  ASSERT_TRUE(region1->GetMemoryAtAddress(0x1004, &value32));
+  uint32_t span_value32;
+  memcpy(&span_value32, span, sizeof(span_value32));
+  EXPECT_EQ(value32 != span_value32, region1->ByteSwapped());
+}
+
+// Build a dump with a two-region MD_MEMORY_64_LIST_STREAM, the second
+// region spanning several pages, and check reads from it.
+static void CheckMemory64List(google_breakpad::test_assembler::Endianness
+                                  endianness) {
+  Dump dump(0, endianness);
+  const uint64_t kBase1 = 0x7ffe12340000ULL;
+  const uint64_t kBase2 = 0x5e9a0000ULL;
+  const uint64_t kSize2 = 3 * 4096 + 100;
+  Label base_rva;
+  Stream list(dump, MD_MEMORY_64_LIST_STREAM);
+  list.D64(2).D64(base_rva)
+      .D64(kBase1).D64(8)
+      .D64(kBase2).D64(kSize2);
+  dump.Add(&list);
+
+  base_rva = dump.Size();
+  Section contents(dump);
+  contents.D64(0x0123456789abcdefULL);
+  contents.Append(4096 - 2, 0x11);
+  // This value straddles the first page boundary of the second region.
+  contents.D32(0xfeedf00d);
+  contents.Append(kSize2 - 4096 - 2, 0x22);
+  dump.Add(&contents);
+  dump.Finish();
+
+  string dump_contents;
+  ASSERT_TRUE(dump.GetContents(&dump_contents));
+  istringstream minidump_stream(dump_contents);
+  Minidump minidump(minidump_stream);
+  ASSERT_TRUE(minidump.Read());
+  ASSERT_TRUE(minidump.GetMemoryList() == NULL);
+
+  MinidumpMemory64List* memory64_list = minidump.GetMemory64List();
+  ASSERT_TRUE(memory64_list != NULL);
+  ASSERT_EQ(2U, memory64_list->region_count());
+
+  MinidumpMemory64Region* region1 = memory64_list->GetMemoryRegionAtIndex(0);
+  ASSERT_TRUE(region1 != NULL);
+  EXPECT_EQ(kBase1, region1->GetBase());
+  EXPECT_EQ(8U, region1->GetSize());
+  uint64_t value64;
+  ASSERT_TRUE(region1->GetMemoryAtAddress(kBase1, &value64));
+  EXPECT_EQ(0x0123456789abcdefULL, value64);
+  EXPECT_FALSE(region1->GetMemoryAtAddress(kBase1 + 4, &value64));
+
+  MinidumpMemory64Region* region2 =
+      memory64_list->GetMemoryRegionForAddress(kBase2 + 2 * 4096);
+  ASSERT_TRUE(region2 != NULL);
+  EXPECT_EQ(kBase2, region2->GetBase());
+  EXPECT_EQ(kSize2, region2->GetSize());
+  uint8_t value8;
+  ASSERT_TRUE(region2->GetMemoryAtAddress(kBase2, &value8));
+  EXPECT_EQ(0x11U, value8);
+  uint32_t value32;
+  ASSERT_TRUE(region2->GetMemoryAtAddress(kBase2 + 4096 - 2, &value32));
+  EXPECT_EQ(0xfeedf00dU, value32);
+  uint16_t value16;
+  ASSERT_TRUE(region2->GetMemoryAtAddress(kBase2 + kSize2 - 2, &value16));
+  EXPECT_EQ(0x2222U, value16);
+  EXPECT_FALSE(region2->GetMemoryAtAddress(kBase2 + kSize2 - 1, &value16));
+
+  EXPECT_TRUE(memory64_list->GetMemoryRegionForAddress(kBase2 + kSize2) ==
+              NULL);
+
+  // Ranges are read across page boundaries, and only within the region.
+  uint32_t values32[3];
+  ASSERT_TRUE(region2->GetMemoryRangeAtAddress(kBase2 + 4096 - 6, 3,
+                                               values32));
+  EXPECT_EQ(0x11111111U, values32[0]);
+  EXPECT_EQ(0xfeedf00dU, values32[1]);
+  EXPECT_EQ(0x22222222U, values32[2]);
+  EXPECT_TRUE(region2->GetMemoryRangeAtAddress(kBase2 + kSize2 - 8, 2,
+                                               values32));
+  EXPECT_FALSE(region2->GetMemoryRangeAtAddress(kBase2 + kSize2 - 8, 3,
+                                                values32));
+
+  // Memory read from a stream is cached a page at a time, so spans can't
+  // cross pages, but copies can.
+  const uint8_t* span = region2->GetSpan(kBase2 + 4096 - 4, 4);
+  ASSERT_TRUE(span != NULL);
+  EXPECT_EQ(0x11, span[0]);
+  EXPECT_TRUE(region2->GetSpan(kBase2 + 4096 - 4, 8) == NULL);
+  uint8_t bytes[8];
+  ASSERT_TRUE(region2->CopyOut(kBase2 + 4096 - 4, 8, bytes));
+  EXPECT_EQ(0x11, bytes[1]);
+  EXPECT_EQ(0x22, bytes[7]);
+  EXPECT_TRUE(memory64_list->GetMemoryRegionForAddress(kBase1) == region1);
+  EXPECT_TRUE(memory64_list->GetMemoryRegionForAddress(kBase2) == region2);
+}
+
+TEST(Dump, Memory64ListLittleEndian) {
+  CheckMemory64List(kLittleEndian);
+}
+
+TEST(Dump, Memory64ListBigEndian) {
+  CheckMemory64List(kBigEndian);
+}
+
 // One thread --- and its requisite entourage.
 TEST(Dump, OneThread) {
   Dump dump(0, kLittleEndian);
@@ -1086,6 +1527,144 @@ TEST(Dump, OneMemoryInfo) {
   ASSERT_EQ(kRegionSize, info2->GetSize());
 }
 
+// Adds a MD_MEMORY_INFO_LIST_STREAM holding a readable region for each
+// (base, size) pair in regions to dump.
+static void AddMemoryInfoList(Dump* dump, Stream* stream,
+                              const vector<std::pair<uint64_t, uint64_t>>&
+                                  regions) {
+  stream->D32(sizeof(MDRawMemoryInfoList))     // size_of_header
+         .D32(sizeof(MDRawMemoryInfo))         // size_of_entry
+         .D64(regions.size());                 // number_of_entries
+  for (const std::pair<uint64_t, uint64_t>& region : regions) {
+    stream->D64(region.first)                  // base_address
+           .D64(region.first)                  // allocation_base
+           .D32(MD_MEMORY_PROTECT_READONLY)    // allocation_protection
+           .D32(0)                             // __alignment1
+           .D64(region.second)                 // region_size
+           .D32(MD_MEMORY_STATE_COMMIT)        // state
+           .D32(MD_MEMORY_PROTECT_READONLY)    // protection
+           .D32(MD_MEMORY_TYPE_PRIVATE)        // type
+           .D32(0);                            // __alignment2
+  }
+  dump->Add(stream);
+  dump->Finish();
+}
+
+TEST(Dump, MemoryInfoLookups) {
+  Dump dump(0, kLittleEndian);
+  Stream stream(dump, MD_MEMORY_INFO_LIST_STREAM);
+  // Out of address order, with a gap between the second and third regions.
+  AddMemoryInfoList(&dump, &stream,
+                    {{0x3000, 0x1000}, {0x1000, 0x2000}, {0x5000, 0x1000}});
+
+  string contents;
+  ASSERT_TRUE(dump.GetContents(&contents));
+  istringstream minidump_stream(contents);
+  Minidump minidump(minidump_stream);
+  ASSERT_TRUE(minidump.Read());
+
+  MinidumpMemoryInfoList* info_list = minidump.GetMemoryInfoList();
+  ASSERT_TRUE(info_list != NULL);
+  ASSERT_EQ(3U, info_list->info_count());
+
+  EXPECT_EQ(NULL, info_list->GetMemoryInfoForAddress(0xfff));
+  EXPECT_EQ(info_list->GetMemoryInfoAtIndex(1),
+            info_list->GetMemoryInfoForAddress(0x1000));
+  EXPECT_EQ(info_list->GetMemoryInfoAtIndex(1),
+            info_list->GetMemoryInfoForAddress(0x2fff));
+  EXPECT_EQ(info_list->GetMemoryInfoAtIndex(0),
+            info_list->GetMemoryInfoForAddress(0x3000));
+  EXPECT_EQ(info_list->GetMemoryInfoAtIndex(0),
+            info_list->GetMemoryInfoForAddress(0x3fff));
+  EXPECT_EQ(NULL, info_list->GetMemoryInfoForAddress(0x4000));
+  EXPECT_EQ(info_list->GetMemoryInfoAtIndex(2),
+            info_list->GetMemoryInfoForAddress(0x5fff));
+  EXPECT_EQ(NULL, info_list->GetMemoryInfoForAddress(0x6000));
+}
+
+TEST(Dump, OverlappingMemoryInfo) {
+  Dump dump(0, kLittleEndian);
+  Stream stream(dump, MD_MEMORY_INFO_LIST_STREAM);
+  AddMemoryInfoList(&dump, &stream, {{0x3000, 0x1000}, {0x1000, 0x2001}});
+
+  string contents;
+  ASSERT_TRUE(dump.GetContents(&contents));
+  istringstream minidump_stream(contents);
+  Minidump minidump(minidump_stream);
+  ASSERT_TRUE(minidump.Read());
+  EXPECT_EQ(NULL, minidump.GetMemoryInfoList());
+}
+
+TEST(Dump, DumpTiming) {
+  Dump dump(0, kBigEndian);
+  Stream stream(dump, MD_DUMP_TIMING_STREAM);
+
+  // Add the MDRawDumpTimingList header.
+  stream.D32(sizeof(MDRawDumpTimingList))  // size_of_header
+        .D32(sizeof(MDRawDumpPhaseTiming)) // size_of_entry
+        .D64(2);                           // number_of_entries
+
+  // Now add two MDRawDumpPhaseTiming entries.
+  stream.D32(MD_DUMP_PHASE_TOTAL)          // phase
+        .D32(5)                            // count
+        .D64(0)                            // bytes
+        .D64(0)                            // start_time
+        .D64(3000000);                     // duration
+  stream.D32(MD_DUMP_PHASE_STACK_COPY)     // phase
+        .D32(4)                            // count
+        .D64(0x8000)                       // bytes
+        .D64(1000)                         // start_time
+        .D64(250000);                      // duration
+
+  dump.Add(&stream);
+  dump.Finish();
+
+  string contents;
+  ASSERT_TRUE(dump.GetContents(&contents));
+  istringstream minidump_stream(contents);
+  Minidump minidump(minidump_stream);
+  ASSERT_TRUE(minidump.Read());
+
+  MinidumpDumpTiming* timing = minidump.GetDumpTiming();
+  ASSERT_TRUE(timing != NULL);
+  const vector<MDRawDumpPhaseTiming>* phases = timing->phases();
+  ASSERT_TRUE(phases != NULL);
+  ASSERT_EQ(2U, phases->size());
+  EXPECT_EQ((uint32_t) MD_DUMP_PHASE_TOTAL, (*phases)[0].phase);
+  EXPECT_EQ(5U, (*phases)[0].count);
+  EXPECT_EQ(3000000U, (*phases)[0].duration);
+  EXPECT_EQ((uint32_t) MD_DUMP_PHASE_STACK_COPY, (*phases)[1].phase);
+  EXPECT_EQ(4U, (*phases)[1].count);
+  EXPECT_EQ(0x8000U, (*phases)[1].bytes);
+  EXPECT_EQ(1000U, (*phases)[1].start_time);
+  EXPECT_STREQ("stack_copy",
+               MinidumpDumpTiming::PhaseName((*phases)[1].phase));
+}
+
+TEST(Dump, CrashSignature) {
+  Dump dump(0, kBigEndian);
+  Stream stream(dump, MD_CRASH_SIGNATURE_STREAM);
+  stream.D64(0x0123456789abcdefULL)  // signature
+        .D32(3)                      // frame_count
+        .D32(0);                     // reserved
+  dump.Add(&stream);
+  dump.Finish();
+
+  string contents;
+  ASSERT_TRUE(dump.GetContents(&contents));
+  istringstream minidump_stream(contents);
+  Minidump minidump(minidump_stream);
+  ASSERT_TRUE(minidump.Read());
+
+  MinidumpCrashSignature* signature = minidump.GetCrashSignature();
+  ASSERT_TRUE(signature != NULL);
+  const MDRawCrashSignature* raw = signature->crash_signature();
+  ASSERT_TRUE(raw != NULL);
+  EXPECT_EQ(0x0123456789abcdefULL, raw->signature);
+  EXPECT_EQ(3U, raw->frame_count);
+  EXPECT_EQ("0123456789abcdef", signature->SignatureString());
+}
+
 TEST(Dump, OneExceptionX86) {
   Dump dump(0, kLittleEndian);
 
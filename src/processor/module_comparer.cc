@@ -42,6 +42,7 @@
 
 #include "common/scoped_ptr.h"
 #include "processor/basic_code_module.h"
+#include "processor/cfi_frame_info.h"
 #include "processor/logging.h"
 
 #define ASSERT_TRUE(condition) \
@@ -86,7 +87,8 @@ bool ModuleComparer::Compare(const string& symbol_data) {
   return true;
 }
 
-// Traversal the content of module and do comparison
+// Traversal the content of module and do comparison.  LoadMapFromMemory
+// leaves the maps of basic_module frozen, so their frozen arrays are walked.
 bool ModuleComparer::CompareModule(const BasicModule *basic_module,
                                   const FastModule *fast_module) const {
   // Compare name_.
@@ -110,11 +112,12 @@ bool ModuleComparer::CompareModule(const BasicModule *basic_module,
 
   // Compare functions_:
   {
-    RangeMap<MemAddr, linked_ptr<BasicFunc> >::MapConstIterator iter1;
+    ASSERT_TRUE(basic_module->functions_.frozen_);
+    RangeMap<MemAddr, linked_ptr<BasicFunc> >::FrozenConstIterator iter1;
     StaticRangeMap<MemAddr, FastFunc>::MapConstIterator iter2;
-    iter1 = basic_module->functions_.map_.begin();
+    iter1 = basic_module->functions_.frozen_map_.begin();
     iter2 = fast_module->functions_.map_.begin();
-    while (iter1 != basic_module->functions_.map_.end()
+    while (iter1 != basic_module->functions_.frozen_map_.end()
         && iter2 != fast_module->functions_.map_.end()) {
       ASSERT_TRUE(iter1->first == iter2.GetKey());
       ASSERT_TRUE(iter1->second.base() == iter2.GetValuePtr()->base());
@@ -123,17 +126,18 @@ bool ModuleComparer::CompareModule(const BasicModule *basic_module,
       ++iter1;
       ++iter2;
     }
-    ASSERT_TRUE(iter1 == basic_module->functions_.map_.end());
+    ASSERT_TRUE(iter1 == basic_module->functions_.frozen_map_.end());
     ASSERT_TRUE(iter2 == fast_module->functions_.map_.end());
   }
 
   // Compare public_symbols_:
   {
-    AddressMap<MemAddr, linked_ptr<BasicPubSymbol> >::MapConstIterator iter1;
+    ASSERT_TRUE(basic_module->public_symbols_.frozen_);
+    AddressMap<MemAddr, linked_ptr<BasicPubSymbol> >::FrozenConstIterator iter1;
     StaticAddressMap<MemAddr, FastPubSymbol>::MapConstIterator iter2;
-    iter1 = basic_module->public_symbols_.map_.begin();
+    iter1 = basic_module->public_symbols_.frozen_map_.begin();
     iter2 = fast_module->public_symbols_.map_.begin();
-    while (iter1 != basic_module->public_symbols_.map_.end()
+    while (iter1 != basic_module->public_symbols_.frozen_map_.end()
           && iter2 != fast_module->public_symbols_.map_.end()) {
       ASSERT_TRUE(iter1->first == iter2.GetKey());
       ASSERT_TRUE(ComparePubSymbol(
@@ -141,7 +145,7 @@ bool ModuleComparer::CompareModule(const BasicModule *basic_module,
       ++iter1;
       ++iter2;
     }
-    ASSERT_TRUE(iter1 == basic_module->public_symbols_.map_.end());
+    ASSERT_TRUE(iter1 == basic_module->public_symbols_.frozen_map_.end());
     ASSERT_TRUE(iter2 == fast_module->public_symbols_.map_.end());
   }
 
@@ -153,20 +157,22 @@ bool ModuleComparer::CompareModule(const BasicModule *basic_module,
 
   // Compare cfi_initial_rules_:
   {
-    RangeMap<MemAddr, string>::MapConstIterator iter1;
+    ASSERT_TRUE(basic_module->cfi_initial_rules_.frozen_);
+    RangeMap<MemAddr, string>::FrozenConstIterator iter1;
     StaticRangeMap<MemAddr, char>::MapConstIterator iter2;
-    iter1 = basic_module->cfi_initial_rules_.map_.begin();
+    iter1 = basic_module->cfi_initial_rules_.frozen_map_.begin();
     iter2 = fast_module->cfi_initial_rules_.map_.begin();
-    while (iter1 != basic_module->cfi_initial_rules_.map_.end()
+    while (iter1 != basic_module->cfi_initial_rules_.frozen_map_.end()
         && iter2 != fast_module->cfi_initial_rules_.map_.end()) {
       ASSERT_TRUE(iter1->first == iter2.GetKey());
       ASSERT_TRUE(iter1->second.base() == iter2.GetValuePtr()->base());
-      string tmp(iter2.GetValuePtr()->entryptr());
-      ASSERT_TRUE(iter1->second.entry() == tmp);
+      string compiled;
+      CompileCFIRuleSet(iter1->second.entry(), &compiled);
+      ASSERT_TRUE(compiled == iter2.GetValuePtr()->entryptr());
       ++iter1;
       ++iter2;
     }
-    ASSERT_TRUE(iter1 == basic_module->cfi_initial_rules_.map_.end());
+    ASSERT_TRUE(iter1 == basic_module->cfi_initial_rules_.frozen_map_.end());
     ASSERT_TRUE(iter2 == fast_module->cfi_initial_rules_.map_.end());
   }
 
@@ -179,8 +185,9 @@ bool ModuleComparer::CompareModule(const BasicModule *basic_module,
     while (iter1 != basic_module->cfi_delta_rules_.end()
         && iter2 != fast_module->cfi_delta_rules_.end()) {
       ASSERT_TRUE(iter1->first == iter2.GetKey());
-      string tmp(iter2.GetValuePtr());
-      ASSERT_TRUE(iter1->second == tmp);
+      string compiled;
+      CompileCFIRuleSet(iter1->second, &compiled);
+      ASSERT_TRUE(compiled == iter2.GetValuePtr());
       ++iter1;
       ++iter2;
     }
@@ -200,11 +207,12 @@ bool ModuleComparer::CompareFunction(const BasicFunc *basic_func,
   ASSERT_TRUE(basic_func->size == fast_func->size);
 
   // compare range map of lines:
-  RangeMap<MemAddr, linked_ptr<BasicLine> >::MapConstIterator iter1;
+  ASSERT_TRUE(basic_func->lines.frozen_);
+  RangeMap<MemAddr, linked_ptr<BasicLine> >::FrozenConstIterator iter1;
   StaticRangeMap<MemAddr, FastLine>::MapConstIterator iter2;
-  iter1 = basic_func->lines.map_.begin();
+  iter1 = basic_func->lines.frozen_map_.begin();
   iter2 = fast_func->lines.map_.begin();
-  while (iter1 != basic_func->lines.map_.end()
+  while (iter1 != basic_func->lines.frozen_map_.end()
       && iter2 != fast_func->lines.map_.end()) {
     ASSERT_TRUE(iter1->first == iter2.GetKey());
     ASSERT_TRUE(iter1->second.base() == iter2.GetValuePtr()->base());
@@ -213,7 +221,7 @@ bool ModuleComparer::CompareFunction(const BasicFunc *basic_func,
     ++iter1;
     ++iter2;
   }
-  ASSERT_TRUE(iter1 == basic_func->lines.map_.end());
+  ASSERT_TRUE(iter1 == basic_func->lines.frozen_map_.end());
   ASSERT_TRUE(iter2 == fast_func->lines.map_.end());
 
   delete fast_func;
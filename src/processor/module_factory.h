@@ -50,11 +50,32 @@ class ModuleFactory {
 
 class BasicModuleFactory : public ModuleFactory {
  public:
+  BasicModuleFactory() : parse_concurrency_(1), retain_symbol_data_(false) { }
   virtual ~BasicModuleFactory() { }
   virtual BasicSourceLineResolver::Module* CreateModule(
       const string& name) const {
-    return new BasicSourceLineResolver::Module(name);
+    BasicSourceLineResolver::Module* module =
+        new BasicSourceLineResolver::Module(name);
+    module->set_parse_concurrency(parse_concurrency_);
+    module->set_retain_symbol_data(retain_symbol_data_);
+    return module;
   }
+
+  // Sets the parse concurrency of the modules created from now on.
+  void set_parse_concurrency(int parse_concurrency) {
+    parse_concurrency_ = parse_concurrency;
+  }
+
+  // Sets whether the modules created from now on may point into the
+  // symbol data they are loaded from.
+  void set_retain_symbol_data(bool retain_symbol_data) {
+    retain_symbol_data_ = retain_symbol_data;
+  }
+  bool retain_symbol_data() const { return retain_symbol_data_; }
+
+ private:
+  int parse_concurrency_;
+  bool retain_symbol_data_;
 };
 
 class FastModuleFactory : public ModuleFactory {
@@ -41,6 +41,7 @@
 #include <cstdint>
 #include <cstring>
 #include <map>
+#include <shared_mutex>
 #include <string>
 
 #include "common/scoped_ptr.h"
@@ -48,6 +49,7 @@
 #include "google_breakpad/processor/code_module.h"
 #include "google_breakpad/processor/fast_source_line_resolver.h"
 #include "processor/basic_code_module.h"
+#include "processor/cfi_frame_info.h"
 #include "processor/linked_ptr.h"
 #include "processor/logging.h"
 #include "processor/map_serializers.h"
@@ -66,9 +68,25 @@ ContainedRangeMapSerializer<MemAddr,
     SimpleSerializer<
         BasicSourceLineResolver::Function>::inline_range_map_serializer_;
 
+size_t CompiledCFIRuleSetSerializer::SizeOf(const string& rule_set) {
+  string compiled;
+  CompileCFIRuleSet(rule_set, &compiled);
+  return compiled.size() + 1;
+}
+
+char* CompiledCFIRuleSetSerializer::Write(const string& rule_set, char* dest) {
+  string compiled;
+  CompileCFIRuleSet(rule_set, &compiled);
+  memcpy(dest, compiled.c_str(), compiled.size() + 1);
+  return dest + compiled.size() + 1;
+}
+
 size_t ModuleSerializer::SizeOf(const BasicSourceLineResolver::Module& module) {
   size_t total_size_alloc_ = 0;
 
+  // Size of the magic number, format version and checksum.
+  total_size_alloc_ += FastSourceLineResolver::Module::kSerializedHeaderSize;
+
   // Size of the "is_corrupt" flag.
   total_size_alloc_ += SimpleSerializer<bool>::SizeOf(module.is_corrupt_);
 
@@ -102,6 +120,15 @@ size_t ModuleSerializer::SizeOf(const BasicSourceLineResolver::Module& module) {
 
 char* ModuleSerializer::Write(const BasicSourceLineResolver::Module& module,
                               char* dest) {
+  // Write the magic number and format version, leaving room for the
+  // checksum of everything after them, which is filled in last.
+  dest = SimpleSerializer<uint32_t>::Write(
+      FastSourceLineResolver::Module::kSerializedMagic, dest);
+  dest = SimpleSerializer<uint32_t>::Write(
+      FastSourceLineResolver::Module::kSerializedVersion, dest);
+  char* checksum = dest;
+  dest += sizeof(uint64_t);
+  char* body = dest;
   // Write the is_corrupt flag.
   dest = SimpleSerializer<bool>::Write(module.is_corrupt_, dest);
   // Write header.
@@ -118,6 +145,8 @@ char* ModuleSerializer::Write(const BasicSourceLineResolver::Module& module,
   dest = inline_origin_serializer_.Write(module.inline_origins_, dest);
   // Write a null terminator.
   dest = SimpleSerializer<char>::Write(0, dest);
+  SimpleSerializer<uint64_t>::Write(
+      FastSourceLineResolver::Module::Checksum(body, dest - body), checksum);
   return dest;
 }
 
@@ -190,6 +219,8 @@ void ModuleSerializer::ConvertAllModules(
     return;
 
   // Traverse module list in basic resolver.
+  std::shared_lock<std::shared_mutex> reader_lock(
+      basic_resolver->modules_lock_);
   BasicSourceLineResolver::ModuleMap::const_iterator iter;
   iter = basic_resolver->modules_->begin();
   for (; iter != basic_resolver->modules_->end(); ++iter)
@@ -204,6 +235,8 @@ bool ModuleSerializer::ConvertOneModule(
   if (!basic_resolver || !fast_resolver)
     return false;
 
+  std::shared_lock<std::shared_mutex> reader_lock(
+      basic_resolver->modules_lock_);
   BasicSourceLineResolver::ModuleMap::const_iterator iter;
   iter = basic_resolver->modules_->find(moduleid);
   if (iter == basic_resolver->modules_->end())
@@ -214,16 +247,32 @@ bool ModuleSerializer::ConvertOneModule(
 
 char* ModuleSerializer::SerializeSymbolFileData(const string& symbol_data,
                                                 size_t* size) {
-  scoped_ptr<BasicSourceLineResolver::Module> module(
-      new BasicSourceLineResolver::Module("no name"));
   scoped_array<char> buffer(new char[symbol_data.size() + 1]);
   memcpy(buffer.get(), symbol_data.c_str(), symbol_data.size());
   buffer.get()[symbol_data.size()] = '\0';
-  if (!module->LoadMapFromMemory(buffer.get(), symbol_data.size() + 1)) {
+  return SerializeSymbolFileData(buffer.get(), symbol_data.size() + 1, size);
+}
+
+char* ModuleSerializer::SerializeSymbolFileData(char* symbol_data,
+                                                size_t symbol_data_size,
+                                                size_t* size) {
+  scoped_ptr<BasicSourceLineResolver::Module> module(
+      new BasicSourceLineResolver::Module("no name"));
+  if (!module->LoadMapFromMemory(symbol_data, symbol_data_size)) {
     return NULL;
   }
-  buffer.reset(NULL);
   return Serialize(*module, size);
 }
 
+// static
+bool ModuleSerializer::IsSerializedData(const char* data, size_t size) {
+  uint32_t magic, version;
+  if (size < sizeof(magic) + sizeof(version))
+    return false;
+  memcpy(&magic, data, sizeof(magic));
+  memcpy(&version, data + sizeof(magic), sizeof(version));
+  return magic == FastSourceLineResolver::Module::kSerializedMagic &&
+         version == FastSourceLineResolver::Module::kSerializedVersion;
+}
+
 }  // namespace google_breakpad
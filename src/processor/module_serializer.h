@@ -51,6 +51,15 @@
 
 namespace google_breakpad {
 
+// Writes a STACK CFI rule set as a compiled rule set (see CompileCFIRuleSet
+// in cfi_frame_info.h), so that the fast resolver can apply it without
+// parsing it.  A rule set that doesn't parse is written as an empty string.
+class CompiledCFIRuleSetSerializer {
+ public:
+  static size_t SizeOf(const string& rule_set);
+  static char* Write(const string& rule_set, char* dest);
+};
+
 // ModuleSerializer serializes a loaded BasicSourceLineResolver::Module into a
 // chunk of memory data. ModuleSerializer also provides interface to compute
 // memory size of the serialized data, write serialized data directly into
@@ -81,6 +90,18 @@ class ModuleSerializer {
   char* SerializeSymbolFileData(const string& symbol_data,
                                 size_t* size = nullptr);
 
+  // As above, but parses symbol_data in place instead of copying it, which
+  // saves a copy of large symbol files.  symbol_data must be null-terminated,
+  // with the terminator counted in symbol_data_size, and its contents are
+  // clobbered.  The caller keeps ownership of symbol_data.
+  char* SerializeSymbolFileData(char* symbol_data,
+                                size_t symbol_data_size,
+                                size_t* size);
+
+  // Returns whether the size bytes at data start as a module serialized in
+  // the current format does, rather than as text symbol data.
+  static bool IsSerializedData(const char* data, size_t size);
+
   // Serializes one loaded module with given moduleid in the basic source line
   // resolver, and loads the serialized data into the fast source line resolver.
   // Return false if the basic source line doesn't have a module with the given
@@ -114,13 +135,15 @@ class ModuleSerializer {
   uint64_t map_sizes_[kNumberMaps_];
 
   // Serializers for each individual map component in Module class.
-  StdMapSerializer<int, string> files_serializer_;
+  StdMapSerializer<int, StringView> files_serializer_;
   RangeMapSerializer<MemAddr, linked_ptr<Function> > functions_serializer_;
   AddressMapSerializer<MemAddr, linked_ptr<PublicSymbol> > pubsym_serializer_;
   ContainedRangeMapSerializer<MemAddr,
                               linked_ptr<WindowsFrameInfo> > wfi_serializer_;
-  RangeMapSerializer<MemAddr, string> cfi_init_rules_serializer_;
-  StdMapSerializer<MemAddr, string> cfi_delta_rules_serializer_;
+  RangeMapSerializer<MemAddr, string, CompiledCFIRuleSetSerializer>
+      cfi_init_rules_serializer_;
+  StdMapSerializer<MemAddr, string, CompiledCFIRuleSetSerializer>
+      cfi_delta_rules_serializer_;
   StdMapSerializer<int, linked_ptr<InlineOrigin>> inline_origin_serializer_;
 };
 
@@ -0,0 +1,142 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// numa_nodes.cc: The NUMA nodes of the machine, and binding threads to them.
+//
+// See numa_nodes.h for documentation.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "processor/numa_nodes.h"
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+#include "processor/logging.h"
+
+namespace google_breakpad {
+
+NumaNodes::NumaNodes(const string& directory) {
+  DIR* dir = opendir(directory.c_str());
+  if (!dir)
+    return;
+
+  // Nodes are numbered, but readdir lists them in no particular order.
+  std::map<long, std::vector<int> > nodes;
+  while (struct dirent* entry = readdir(dir)) {
+    const char* name = entry->d_name;
+    if (strncmp(name, "node", 4) != 0 || name[4] < '0' || name[4] > '9')
+      continue;
+    char* end;
+    long number = strtol(name + 4, &end, 10);
+    if (*end != '\0')
+      continue;
+
+    std::ifstream cpulist((directory + "/" + name + "/cpulist").c_str());
+    string list;
+    std::vector<int> cpus;
+    if (!std::getline(cpulist, list) || !ParseCPUList(list, &cpus)) {
+      BPLOG(ERROR) << "Could not read the CPUs of NUMA node " << number;
+      continue;
+    }
+    if (!cpus.empty())
+      nodes[number].swap(cpus);
+  }
+  closedir(dir);
+
+  for (std::map<long, std::vector<int> >::iterator node = nodes.begin();
+       node != nodes.end(); ++node) {
+    cpus_.push_back(std::vector<int>());
+    cpus_.back().swap(node->second);
+  }
+}
+
+bool NumaNodes::BindCurrentThread(size_t node) const {
+  if (node >= cpus_.size())
+    return false;
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (size_t i = 0; i < cpus_[node].size(); ++i) {
+    if (cpus_[node][i] < CPU_SETSIZE)
+      CPU_SET(cpus_[node][i], &set);
+  }
+  int error = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (error != 0) {
+    BPLOG(ERROR) << "Could not bind a thread to NUMA node " << node << ": "
+                 << strerror(error);
+    return false;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+// static
+bool NumaNodes::ParseCPUList(const string& list, std::vector<int>* cpus) {
+  cpus->clear();
+  const char* cursor = list.c_str();
+  while (*cursor != '\0' && *cursor != '\n') {
+    char* end;
+    long first = strtol(cursor, &end, 10);
+    if (end == cursor || first < 0)
+      return false;
+    long last = first;
+    if (*end == '-') {
+      cursor = end + 1;
+      last = strtol(cursor, &end, 10);
+      if (end == cursor || last < first)
+        return false;
+    }
+    for (long cpu = first; cpu <= last; ++cpu)
+      cpus->push_back(static_cast<int>(cpu));
+    cursor = end;
+    if (*cursor == ',')
+      ++cursor;
+    else if (*cursor != '\0' && *cursor != '\n')
+      return false;
+  }
+  std::sort(cpus->begin(), cpus->end());
+  cpus->erase(std::unique(cpus->begin(), cpus->end()), cpus->end());
+  return true;
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,73 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// numa_nodes.h: The NUMA nodes of the machine, and binding threads to them.
+//
+// NumaNodes reads the CPUs of each node from sysfs, where Linux lists them
+// as /sys/devices/system/node/node<n>/cpulist.  On other systems, or on a
+// machine with one node, it finds at most one node, and callers need not
+// place threads at all.
+
+#ifndef PROCESSOR_NUMA_NODES_H__
+#define PROCESSOR_NUMA_NODES_H__
+
+#include <stddef.h>
+
+#include <string>
+#include <vector>
+
+#include "common/using_std_string.h"
+
+namespace google_breakpad {
+
+class NumaNodes {
+ public:
+  // Reads the nodes listed under directory.  Nodes without CPUs, such as
+  // those holding only memory, are left out.
+  explicit NumaNodes(const string& directory = "/sys/devices/system/node");
+
+  size_t node_count() const { return cpus_.size(); }
+
+  // The CPUs of node, in increasing order.
+  const std::vector<int>& cpus(size_t node) const { return cpus_[node]; }
+
+  // Binds the calling thread to the CPUs of node, so that memory it
+  // touches first is allocated there.  Returns false if it could not.
+  bool BindCurrentThread(size_t node) const;
+
+  // Parses a list of CPUs in the kernel's form, such as "0-3,8,10-11",
+  // into cpus.  Returns false if list is malformed.
+  static bool ParseCPUList(const string& list, std::vector<int>* cpus);
+
+ private:
+  std::vector<std::vector<int> > cpus_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_NUMA_NODES_H__
@@ -0,0 +1,103 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Unit tests for NumaNodes.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+
+#include "breakpad_googletest_includes.h"
+#include "common/tests/auto_tempdir.h"
+#include "common/using_std_string.h"
+#include "processor/numa_nodes.h"
+
+namespace {
+
+using google_breakpad::AutoTempDir;
+using google_breakpad::NumaNodes;
+using std::vector;
+
+// Writes a sysfs node directory holding a cpulist of list.
+void WriteNode(const string& directory, const string& node,
+               const string& list) {
+  string path = directory + "/" + node;
+  ASSERT_EQ(0, mkdir(path.c_str(), 0755));
+  FILE* file = fopen((path + "/cpulist").c_str(), "w");
+  ASSERT_TRUE(file);
+  fprintf(file, "%s\n", list.c_str());
+  fclose(file);
+}
+
+TEST(NumaNodesTest, ParsesCPULists) {
+  vector<int> cpus;
+  ASSERT_TRUE(NumaNodes::ParseCPUList("0-3,8,10-11\n", &cpus));
+  int expected[] = { 0, 1, 2, 3, 8, 10, 11 };
+  EXPECT_EQ(vector<int>(expected, expected + 7), cpus);
+
+  ASSERT_TRUE(NumaNodes::ParseCPUList("", &cpus));
+  EXPECT_TRUE(cpus.empty());
+
+  EXPECT_FALSE(NumaNodes::ParseCPUList("3-1", &cpus));
+  EXPECT_FALSE(NumaNodes::ParseCPUList("0,,1", &cpus));
+  EXPECT_FALSE(NumaNodes::ParseCPUList("0-", &cpus));
+  EXPECT_FALSE(NumaNodes::ParseCPUList("0 1", &cpus));
+}
+
+TEST(NumaNodesTest, ReadsNodesInOrder) {
+  AutoTempDir directory;
+  WriteNode(directory.path(), "node10", "12-15");
+  WriteNode(directory.path(), "node2", "4-7");
+  WriteNode(directory.path(), "node0", "0-3");
+  // A node holding only memory has no CPUs, and is left out.
+  WriteNode(directory.path(), "node3", "");
+  WriteNode(directory.path(), "has_cpu", "0-15");
+
+  NumaNodes nodes(directory.path());
+  ASSERT_EQ(3U, nodes.node_count());
+  EXPECT_EQ(0, nodes.cpus(0).front());
+  EXPECT_EQ(4, nodes.cpus(1).front());
+  EXPECT_EQ(12, nodes.cpus(2).front());
+  EXPECT_EQ(4U, nodes.cpus(2).size());
+  EXPECT_FALSE(nodes.BindCurrentThread(3));
+}
+
+TEST(NumaNodesTest, FindsNoNodesWithoutSysfs) {
+  AutoTempDir directory;
+  NumaNodes nodes(directory.path() + "/missing");
+  EXPECT_EQ(0U, nodes.node_count());
+  EXPECT_FALSE(nodes.BindCurrentThread(0));
+}
+
+}  // namespace
@@ -42,14 +42,19 @@ namespace google_breakpad {
 
 // static
 string PathnameStripper::File(const string& path) {
-  string::size_type slash = path.rfind('/');
-  string::size_type backslash = path.rfind('\\');
+  return string(FileView(path));
+}
+
+// static
+std::string_view PathnameStripper::FileView(std::string_view path) {
+  std::string_view::size_type slash = path.rfind('/');
+  std::string_view::size_type backslash = path.rfind('\\');
 
-  string::size_type file_start = 0;
-  if (slash != string::npos &&
-      (backslash == string::npos || slash > backslash)) {
+  std::string_view::size_type file_start = 0;
+  if (slash != std::string_view::npos &&
+      (backslash == std::string_view::npos || slash > backslash)) {
     file_start = slash + 1;
-  } else if (backslash != string::npos) {
+  } else if (backslash != std::string_view::npos) {
     file_start = backslash + 1;
   }
 
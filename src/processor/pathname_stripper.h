@@ -34,6 +34,7 @@
 #define PROCESSOR_PATHNAME_STRIPPER_H__
 
 #include <string>
+#include <string_view>
 
 #include "common/using_std_string.h"
 
@@ -45,6 +46,11 @@ class PathnameStripper {
   // backslashes (\), returns the trailing component, without any separator.
   // If path ends in a separator character, returns an empty string.
   static string File(const string& path);
+
+  // Like File, but returns a view of the trailing component within path
+  // rather than a copy of it, so that callers formatting many names don't
+  // allocate for each one.  The view is valid as long as path's storage is.
+  static std::string_view FileView(std::string_view path);
 };
 
 }  // namespace google_breakpad
@@ -78,6 +78,14 @@ static bool RunTests() {
   ASSERT_EQ(PathnameStripper::File("c:\\dir\\file"), "file");
   ASSERT_EQ(PathnameStripper::File("c:\\dir\\file.ext"), "file.ext");
 
+  ASSERT_TRUE(PathnameStripper::FileView("/dir/file") == "file");
+  ASSERT_TRUE(PathnameStripper::FileView("c:\\dir/file") == "file");
+  ASSERT_TRUE(PathnameStripper::FileView("file") == "file");
+  ASSERT_TRUE(PathnameStripper::FileView("dir/").empty());
+  ASSERT_TRUE(PathnameStripper::FileView("").empty());
+  const char kPath[] = "dir1\\dir2/file";
+  ASSERT_TRUE(PathnameStripper::FileView(kPath).data() == kPath + 10);
+
   return true;
 }
 
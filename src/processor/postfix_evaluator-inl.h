@@ -50,179 +50,212 @@
 namespace google_breakpad {
 
 using std::istringstream;
-using std::ostringstream;
 
 
 // A small class used in Evaluate to make sure to clean up the stack
 // before returning failure.
+template<typename StackType>
 class AutoStackClearer {
  public:
-  explicit AutoStackClearer(vector<string>* stack) : stack_(stack) {}
+  explicit AutoStackClearer(StackType* stack) : stack_(stack) {}
   ~AutoStackClearer() { stack_->clear(); }
 
  private:
-  vector<string>* stack_;
+  StackType* stack_;
 };
 
 
 template<typename ValueType>
-bool PostfixEvaluator<ValueType>::EvaluateToken(
-    const string& token,
-    const string& expression,
-    DictionaryValidityType* assigned) {
-  // There are enough binary operations that do exactly the same thing
-  // (other than the specific operation, of course) that it makes sense
-  // to share as much code as possible.
-  enum BinaryOperation {
-    BINARY_OP_NONE = 0,
-    BINARY_OP_ADD,
-    BINARY_OP_SUBTRACT,
-    BINARY_OP_MULTIPLY,
-    BINARY_OP_DIVIDE_QUOTIENT,
-    BINARY_OP_DIVIDE_MODULUS,
-    BINARY_OP_ALIGN
-  };
-
-  BinaryOperation operation = BINARY_OP_NONE;
-  if (token == "+")
-    operation = BINARY_OP_ADD;
-  else if (token == "-")
-    operation = BINARY_OP_SUBTRACT;
-  else if (token == "*")
-    operation = BINARY_OP_MULTIPLY;
-  else if (token == "/")
-    operation = BINARY_OP_DIVIDE_QUOTIENT;
-  else if (token == "%")
-    operation = BINARY_OP_DIVIDE_MODULUS;
-  else if (token == "@")
-    operation = BINARY_OP_ALIGN;
-
-  if (operation != BINARY_OP_NONE) {
-    // Get the operands.
-    ValueType operand1 = ValueType();
-    ValueType operand2 = ValueType();
-    if (!PopValues(&operand1, &operand2)) {
-      BPLOG(ERROR) << "Could not PopValues to get two values for binary "
-                      "operation " << token << ": " << expression;
-      return false;
-    }
-
-    // Perform the operation.
-    ValueType result;
-    switch (operation) {
-      case BINARY_OP_ADD:
-        result = operand1 + operand2;
-        break;
-      case BINARY_OP_SUBTRACT:
-        result = operand1 - operand2;
-        break;
-      case BINARY_OP_MULTIPLY:
-        result = operand1 * operand2;
-        break;
-      case BINARY_OP_DIVIDE_QUOTIENT:
-        result = operand1 / operand2;
-        break;
-      case BINARY_OP_DIVIDE_MODULUS:
-        result = operand1 % operand2;
-        break;
-      case BINARY_OP_ALIGN:
-	result =
-	  operand1 & (static_cast<ValueType>(-1) ^ (operand2 - 1));
-        break;
-      case BINARY_OP_NONE:
-        // This will not happen, but compilers will want a default or
-        // BINARY_OP_NONE case.
-        BPLOG(ERROR) << "Not reached!";
-        return false;
-        break;
+PostfixEvaluator<ValueType>::Program::Program(const string& expression)
+    : expression_(expression), assigns_(false) {
+  // Tokenize, splitting on whitespace.
+  istringstream stream(expression);
+  string token;
+  while (stream >> token) {
+    // Normally, tokens are whitespace-separated, but occasionally, the
+    // assignment operator is smashed up against the next token, i.e.
+    // $T0 $ebp 128 + =$eip $T0 4 + ^ =$ebp $T0 ^ =
+    // This has been observed in program strings produced by MSVS 2010 in LTO
+    // mode.
+    if (token.size() > 1 && token[0] == '=') {
+      CompileToken("=");
+      CompileToken(token.substr(1));
+    } else {
+      CompileToken(token);
     }
+  }
+}
 
-    // Save the result.
-    PushValue(result);
+template<typename ValueType>
+void PostfixEvaluator<ValueType>::Program::CompileToken(const string& token) {
+  Instruction instruction;
+  instruction.value = ValueType();
+  instruction.identifier = 0;
+  if (token == "+") {
+    instruction.opcode = OP_ADD;
+  } else if (token == "-") {
+    instruction.opcode = OP_SUBTRACT;
+  } else if (token == "*") {
+    instruction.opcode = OP_MULTIPLY;
+  } else if (token == "/") {
+    instruction.opcode = OP_DIVIDE_QUOTIENT;
+  } else if (token == "%") {
+    instruction.opcode = OP_DIVIDE_MODULUS;
+  } else if (token == "@") {
+    instruction.opcode = OP_ALIGN;
   } else if (token == "^") {
-    // ^ for unary dereference.  Can't dereference without memory.
-    if (!memory_) {
-      BPLOG(ERROR) << "Attempt to dereference without memory: " <<
-                      expression;
-      return false;
-    }
-
-    ValueType address;
-    if (!PopValue(&address)) {
-      BPLOG(ERROR) << "Could not PopValue to get value to derefence: " <<
-                      expression;
-      return false;
-    }
-
-    ValueType value;
-    if (!memory_->GetMemoryAtAddress(address, &value)) {
-      BPLOG(ERROR) << "Could not dereference memory at address " <<
-                      HexString(address) << ": " << expression;
-      return false;
-    }
-
-    PushValue(value);
+    instruction.opcode = OP_DEREFERENCE;
   } else if (token == "=") {
-    // = for assignment.
-    ValueType value;
-    if (!PopValue(&value)) {
-      BPLOG(INFO) << "Could not PopValue to get value to assign: " <<
-                     expression;
-      return false;
-    }
-
-    // Assignment is only meaningful when assigning into an identifier.
-    // The identifier must name a variable, not a constant.  Variables
-    // begin with '$'.
-    string identifier;
-    if (PopValueOrIdentifier(NULL, &identifier) != POP_RESULT_IDENTIFIER) {
-      BPLOG(ERROR) << "PopValueOrIdentifier returned a value, but an "
-                      "identifier is needed to assign " <<
-                      HexString(value) << ": " << expression;
-      return false;
-    }
-    if (identifier.empty() || identifier[0] != '$') {
-      BPLOG(ERROR) << "Can't assign " << HexString(value) << " to " <<
-                      identifier << ": " << expression;
-      return false;
-    }
-
-    (*dictionary_)[identifier] = value;
-    if (assigned)
-      (*assigned)[identifier] = true;
+    instruction.opcode = OP_ASSIGN;
+    assigns_ = true;
+  } else if (ParseLiteral(token, &instruction.value)) {
+    instruction.opcode = OP_PUSH_VALUE;
   } else {
-    // The token is not an operator, it's a literal value or an identifier.
-    // Push it onto the stack as-is.  Use push_back instead of PushValue
-    // because PushValue pushes ValueType as a string, but token is already
-    // a string.
-    stack_.push_back(token);
+    // The token is a constant or variable identifier, which is looked up
+    // when it's popped, as assignments may change its value in between.
+    instruction.opcode = OP_PUSH_IDENTIFIER;
+    instruction.identifier = identifiers_.size();
+    identifiers_.push_back(token);
   }
-  return true;
+  instructions_.push_back(instruction);
 }
 
 template<typename ValueType>
 bool PostfixEvaluator<ValueType>::EvaluateInternal(
-    const string& expression,
+    const Program& program,
     DictionaryValidityType* assigned) {
-  // Tokenize, splitting on whitespace.
-  istringstream stream(expression);
-  string token;
-  while (stream >> token) {
-    // Normally, tokens are whitespace-separated, but occasionally, the
-    // assignment operator is smashed up against the next token, i.e.
-    // $T0 $ebp 128 + =$eip $T0 4 + ^ =$ebp $T0 ^ =
-    // This has been observed in program strings produced by MSVS 2010 in LTO
-    // mode.
-    if (token.size() > 1 && token[0] == '=') {
-      if (!EvaluateToken("=", expression, assigned)) {
-        return false;
+  const string& expression = program.expression_;
+  for (size_t i = 0; i < program.instructions_.size(); ++i) {
+    const typename Program::Instruction& instruction =
+        program.instructions_[i];
+    switch (instruction.opcode) {
+      case Program::OP_PUSH_VALUE:
+        PushValue(instruction.value);
+        break;
+
+      case Program::OP_PUSH_IDENTIFIER: {
+        StackEntry entry;
+        entry.identifier = &program.identifiers_[instruction.identifier];
+        entry.slot = slots_ ? slots_[instruction.identifier] : -1;
+        entry.value = ValueType();
+        stack_.push_back(entry);
+        break;
       }
 
-      if (!EvaluateToken(token.substr(1), expression, assigned)) {
-        return false;
+      case Program::OP_ADD:
+      case Program::OP_SUBTRACT:
+      case Program::OP_MULTIPLY:
+      case Program::OP_DIVIDE_QUOTIENT:
+      case Program::OP_DIVIDE_MODULUS:
+      case Program::OP_ALIGN: {
+        // Get the operands.
+        ValueType operand1 = ValueType();
+        ValueType operand2 = ValueType();
+        if (!PopValues(&operand1, &operand2)) {
+          static const char kOperators[] = "+-*/%@";
+          BPLOG(ERROR) << "Could not PopValues to get two values for binary "
+                          "operation " <<
+                          kOperators[instruction.opcode - Program::OP_ADD] <<
+                          ": " << expression;
+          return false;
+        }
+
+        // Perform the operation.
+        ValueType result = ValueType();
+        switch (instruction.opcode) {
+          case Program::OP_ADD:
+            result = operand1 + operand2;
+            break;
+          case Program::OP_SUBTRACT:
+            result = operand1 - operand2;
+            break;
+          case Program::OP_MULTIPLY:
+            result = operand1 * operand2;
+            break;
+          case Program::OP_DIVIDE_QUOTIENT:
+            result = operand1 / operand2;
+            break;
+          case Program::OP_DIVIDE_MODULUS:
+            result = operand1 % operand2;
+            break;
+          case Program::OP_ALIGN:
+            result =
+                operand1 & (static_cast<ValueType>(-1) ^ (operand2 - 1));
+            break;
+          default:
+            // This will not happen, but compilers will want a default.
+            BPLOG(ERROR) << "Not reached!";
+            return false;
+        }
+
+        // Save the result.
+        PushValue(result);
+        break;
+      }
+
+      case Program::OP_DEREFERENCE: {
+        // ^ for unary dereference.  Can't dereference without memory.
+        if (!memory_) {
+          BPLOG(ERROR) << "Attempt to dereference without memory: " <<
+                          expression;
+          return false;
+        }
+
+        ValueType address;
+        if (!PopValue(&address)) {
+          BPLOG(ERROR) << "Could not PopValue to get value to derefence: " <<
+                          expression;
+          return false;
+        }
+
+        ValueType value;
+        if (!memory_->GetMemoryAtAddress(address, &value)) {
+          BPLOG(ERROR) << "Could not dereference memory at address " <<
+                          HexString(address) << ": " << expression;
+          return false;
+        }
+
+        PushValue(value);
+        break;
+      }
+
+      case Program::OP_ASSIGN: {
+        // = for assignment.
+        ValueType value;
+        if (!PopValue(&value)) {
+          BPLOG(INFO) << "Could not PopValue to get value to assign: " <<
+                         expression;
+          return false;
+        }
+
+        // Assignment is only meaningful when assigning into an identifier.
+        // The identifier must name a variable, not a constant.  Variables
+        // begin with '$'.
+        if (stack_.empty() || !stack_.back().identifier) {
+          BPLOG(ERROR) << "PopValueOrIdentifier returned a value, but an "
+                          "identifier is needed to assign " <<
+                          HexString(value) << ": " << expression;
+          return false;
+        }
+        const string& identifier = *stack_.back().identifier;
+        stack_.pop_back();
+        if (identifier.empty() || identifier[0] != '$') {
+          BPLOG(ERROR) << "Can't assign " << HexString(value) << " to " <<
+                          identifier << ": " << expression;
+          return false;
+        }
+        if (slots_) {
+          BPLOG(ERROR) << "Can't assign " << HexString(value) << " to " <<
+                          identifier << " without a dictionary: " <<
+                          expression;
+          return false;
+        }
+
+        (*dictionary_)[identifier] = value;
+        if (assigned)
+          (*assigned)[identifier] = true;
+        break;
       }
-    } else if (!EvaluateToken(token, expression, assigned)) {
-      return false;
     }
   }
 
@@ -232,10 +265,22 @@ bool PostfixEvaluator<ValueType>::EvaluateInternal(
 template<typename ValueType>
 bool PostfixEvaluator<ValueType>::Evaluate(const string& expression,
                                            DictionaryValidityType* assigned) {
+  return Evaluate(Program(expression), assigned);
+}
+
+template<typename ValueType>
+bool PostfixEvaluator<ValueType>::EvaluateForValue(const string& expression,
+                                                   ValueType* result) {
+  return EvaluateForValue(Program(expression), result);
+}
+
+template<typename ValueType>
+bool PostfixEvaluator<ValueType>::Evaluate(const Program& program,
+                                           DictionaryValidityType* assigned) {
   // Ensure that the stack is cleared before returning.
-  AutoStackClearer clearer(&stack_);
+  AutoStackClearer<vector<StackEntry> > clearer(&stack_);
 
-  if (!EvaluateInternal(expression, assigned))
+  if (!EvaluateInternal(program, assigned))
     return false;
 
   // If there's anything left on the stack, it indicates incomplete execution.
@@ -244,23 +289,23 @@ bool PostfixEvaluator<ValueType>::Evaluate(const string& expression,
   if (stack_.empty())
     return true;
 
-  BPLOG(ERROR) << "Incomplete execution: " << expression;
+  BPLOG(ERROR) << "Incomplete execution: " << program.expression();
   return false;
 }
 
 template<typename ValueType>
-bool PostfixEvaluator<ValueType>::EvaluateForValue(const string& expression,
+bool PostfixEvaluator<ValueType>::EvaluateForValue(const Program& program,
                                                    ValueType* result) {
   // Ensure that the stack is cleared before returning.
-  AutoStackClearer clearer(&stack_);
+  AutoStackClearer<vector<StackEntry> > clearer(&stack_);
 
-  if (!EvaluateInternal(expression, NULL))
+  if (!EvaluateInternal(program, NULL))
     return false;
 
   // A successful execution should leave exactly one value on the stack.
   if (stack_.size() != 1) {
     BPLOG(ERROR) << "Expression yielded bad number of results: "
-                 << "'" << expression << "'";
+                 << "'" << program.expression() << "'";
     return false;
   }
 
@@ -268,21 +313,25 @@ bool PostfixEvaluator<ValueType>::EvaluateForValue(const string& expression,
 }
 
 template<typename ValueType>
-typename PostfixEvaluator<ValueType>::PopResult
-PostfixEvaluator<ValueType>::PopValueOrIdentifier(
-    ValueType* value, string* identifier) {
-  // There needs to be at least one element on the stack to pop.
-  if (!stack_.size())
-    return POP_RESULT_FAIL;
-
-  string token = stack_.back();
-  stack_.pop_back();
+bool PostfixEvaluator<ValueType>::EvaluateForValue(const Program& program,
+                                                   const int* slots,
+                                                   const ValueType* values,
+                                                   const bool* validity,
+                                                   ValueType* result) {
+  slots_ = slots;
+  slot_values_ = values;
+  slot_validity_ = validity;
+  bool evaluated = EvaluateForValue(program, result);
+  slots_ = NULL;
+  slot_values_ = NULL;
+  slot_validity_ = NULL;
+  return evaluated;
+}
 
-  // First, try to treat the value as a literal. Literals may have leading
-  // '-' sign, and the entire remaining string must be parseable as
-  // ValueType. If this isn't possible, it can't be a literal, so treat it
-  // as an identifier instead.
-  //
+// static
+template<typename ValueType>
+bool PostfixEvaluator<ValueType>::ParseLiteral(const string& token,
+                                               ValueType* value) {
   // Some versions of the libstdc++, the GNU standard C++ library, have
   // stream extractors for unsigned integer values that permit a leading
   // '-' sign (6.0.13); others do not (6.0.9). Since we require it, we
@@ -297,46 +346,49 @@ PostfixEvaluator<ValueType>::PopValueOrIdentifier(
     negative = false;
   }
   if (token_stream >> literal && token_stream.peek() == EOF) {
-    if (value) {
-      *value = literal;
-    }
-    if (negative)
-      *value = -*value;
-    return POP_RESULT_VALUE;
-  } else {
-    if (identifier) {
-      *identifier = token;
-    }
-    return POP_RESULT_IDENTIFIER;
+    *value = negative ? -literal : literal;
+    return true;
   }
+  return false;
 }
 
 
 template<typename ValueType>
 bool PostfixEvaluator<ValueType>::PopValue(ValueType* value) {
-  ValueType literal = ValueType();
-  string token;
-  PopResult result;
-  if ((result = PopValueOrIdentifier(&literal, &token)) == POP_RESULT_FAIL) {
+  // There needs to be at least one element on the stack to pop.
+  if (stack_.empty())
     return false;
-  } else if (result == POP_RESULT_VALUE) {
+
+  StackEntry entry = stack_.back();
+  stack_.pop_back();
+
+  if (!entry.identifier) {
     // This is the easy case.
-    *value = literal;
-  } else {  // result == POP_RESULT_IDENTIFIER
-    // There was an identifier at the top of the stack.  Resolve it to a
-    // value by looking it up in the dictionary.
-    typename DictionaryType::const_iterator iterator =
-        dictionary_->find(token);
-    if (iterator == dictionary_->end()) {
-      // The identifier wasn't found in the dictionary.  Don't imply any
-      // default value, just fail.
-      BPLOG(INFO) << "Identifier " << token << " not in dictionary";
+    *value = entry.value;
+    return true;
+  }
+
+  if (slots_) {
+    if (entry.slot < 0 || !slot_validity_[entry.slot]) {
+      BPLOG(INFO) << "Identifier " << *entry.identifier << " not in dictionary";
       return false;
     }
+    *value = slot_values_[entry.slot];
+    return true;
+  }
 
-    *value = iterator->second;
+  // There was an identifier at the top of the stack.  Resolve it to a
+  // value by looking it up in the dictionary.
+  typename DictionaryType::const_iterator iterator =
+      dictionary_->find(*entry.identifier);
+  if (iterator == dictionary_->end()) {
+    // The identifier wasn't found in the dictionary.  Don't imply any
+    // default value, just fail.
+    BPLOG(INFO) << "Identifier " << *entry.identifier << " not in dictionary";
+    return false;
   }
 
+  *value = iterator->second;
   return true;
 }
 
@@ -350,9 +402,11 @@ bool PostfixEvaluator<ValueType>::PopValues(ValueType* value1,
 
 template<typename ValueType>
 void PostfixEvaluator<ValueType>::PushValue(const ValueType& value) {
-  ostringstream token_stream;
-  token_stream << value;
-  stack_.push_back(token_stream.str());
+  StackEntry entry;
+  entry.identifier = NULL;
+  entry.slot = -1;
+  entry.value = value;
+  stack_.push_back(entry);
 }
 
 
@@ -59,6 +59,11 @@
 // values remaining on the stack are treated as evidence of incomplete
 // execution and cause the evaluator to indicate failure.
 //
+// An expression that is evaluated repeatedly may be compiled once into a
+// PostfixEvaluator::Program, a list of stack machine instructions with the
+// expression's literals parsed and its identifiers collected, which saves
+// tokenizing the expression on each evaluation.
+//
 // PostfixEvaluator is intended to support evaluation of "program strings"
 // obtained from MSVC frame data debugging information in pdb files as
 // returned by the DIA APIs.
@@ -88,6 +93,56 @@ class PostfixEvaluator {
   typedef map<string, ValueType> DictionaryType;
   typedef map<string, bool> DictionaryValidityType;
 
+  // An expression compiled for evaluation.  Evaluating a Program gives the
+  // same results as evaluating the expression it was compiled from.
+  // Programs are immutable, so one may be evaluated by several evaluators
+  // at once.
+  class Program {
+   public:
+    explicit Program(const string& expression);
+
+    const string& expression() const { return expression_; }
+
+    // Whether the program assigns to variables.
+    bool assigns() const { return assigns_; }
+
+    // The constant and variable identifiers the program refers to.
+    size_t identifier_count() const { return identifiers_.size(); }
+    const string& identifier(size_t index) const {
+      return identifiers_[index];
+    }
+
+   private:
+    friend class PostfixEvaluator;
+
+    enum Opcode {
+      OP_PUSH_VALUE,  // Push value.
+      OP_PUSH_IDENTIFIER,  // Push identifiers_[identifier].
+      OP_ADD,
+      OP_SUBTRACT,
+      OP_MULTIPLY,
+      OP_DIVIDE_QUOTIENT,
+      OP_DIVIDE_MODULUS,
+      OP_ALIGN,
+      OP_DEREFERENCE,
+      OP_ASSIGN
+    };
+
+    struct Instruction {
+      Opcode opcode;
+      ValueType value;
+      size_t identifier;
+    };
+
+    // Appends the instruction for token.
+    void CompileToken(const string& token);
+
+    string expression_;
+    vector<Instruction> instructions_;
+    vector<string> identifiers_;
+    bool assigns_;
+  };
+
   // Create a PostfixEvaluator object that may be used (with Evaluate) on
   // one or more expressions.  PostfixEvaluator does not take ownership of
   // either argument.  |memory| may be NULL, in which case dereferencing
@@ -95,7 +150,8 @@ class PostfixEvaluator {
   // will fail in that case unless set_dictionary is used before calling
   // Evaluate.
   PostfixEvaluator(DictionaryType* dictionary, const MemoryRegion* memory)
-      : dictionary_(dictionary), memory_(memory), stack_() {}
+      : dictionary_(dictionary), memory_(memory), stack_(),
+        slots_(NULL), slot_values_(NULL), slot_validity_(NULL) {}
 
   // Evaluate the expression, starting with an empty stack. The results of
   // execution will be stored in one (or more) variables in the dictionary.
@@ -112,26 +168,42 @@ class PostfixEvaluator {
   // Otherwise, return false.
   bool EvaluateForValue(const string& expression, ValueType* result);
 
+  // Like Evaluate and EvaluateForValue, but evaluate a compiled program.
+  // Apart from assignments to new variables, these don't allocate memory
+  // once the evaluator's stack has grown to the size program needs.
+  bool Evaluate(const Program& program, DictionaryValidityType* assigned);
+  bool EvaluateForValue(const Program& program, ValueType* result);
+
+  // Like EvaluateForValue, but look identifiers up in an array of values
+  // rather than in the dictionary: program.identifier(i) has the value
+  // values[slots[i]], if slots[i] is not negative and validity[slots[i]]
+  // is true.  Evaluation fails if program assigns to variables.
+  bool EvaluateForValue(const Program& program,
+                        const int* slots,
+                        const ValueType* values,
+                        const bool* validity,
+                        ValueType* result);
+
   DictionaryType* dictionary() const { return dictionary_; }
 
   // Reset the dictionary.  PostfixEvaluator does not take ownership.
   void set_dictionary(DictionaryType* dictionary) {dictionary_ = dictionary; }
 
  private:
-  // Return values for PopValueOrIdentifier
-  enum PopResult {
-    POP_RESULT_FAIL = 0,
-    POP_RESULT_VALUE,
-    POP_RESULT_IDENTIFIER
+  // An entry on the stack: either a value, or an identifier to look up in
+  // the dictionary when it is popped.
+  struct StackEntry {
+    const string* identifier;
+    // When evaluating with slots_, the slot of identifier.
+    int slot;
+    ValueType value;
   };
 
-  // Retrieves the topmost literal value, constant, or variable from the
-  // stack.  Returns POP_RESULT_VALUE if the topmost entry is a literal
-  // value, and sets |value| accordingly.  Returns POP_RESULT_IDENTIFIER
-  // if the topmost entry is a constant or variable identifier, and sets
-  // |identifier| accordingly.  Returns POP_RESULT_FAIL on failure, such
-  // as when the stack is empty.
-  PopResult PopValueOrIdentifier(ValueType* value, string* identifier);
+  // Parses token as a literal value into *value.  Literals may have a
+  // leading '-' sign, and the entire remaining string must be parseable as
+  // ValueType.  Returns false if token is not a literal, but a constant or
+  // variable identifier.
+  static bool ParseLiteral(const string& token, ValueType* value);
 
   // Retrieves the topmost value on the stack.  If the topmost entry is
   // an identifier, the dictionary is queried for the identifier's value.
@@ -147,16 +219,12 @@ class PostfixEvaluator {
   // Pushes a new value onto the stack.
   void PushValue(const ValueType& value);
 
-  // Evaluate expression, updating *assigned if it is non-zero. Return
+  // Evaluate program, updating *assigned if it is non-zero. Return
   // true if evaluation completes successfully. Do not clear the stack
   // upon successful evaluation.
-  bool EvaluateInternal(const string& expression,
+  bool EvaluateInternal(const Program& program,
                         DictionaryValidityType* assigned);
 
-  bool EvaluateToken(const string& token,
-                     const string& expression,
-                     DictionaryValidityType* assigned);
-
   // The dictionary mapping constant and variable identifiers (strings) to
   // values.  Keys beginning with '$' are treated as variable names, and
   // PostfixEvaluator is free to create and modify these keys.  Weak pointer.
@@ -169,7 +237,14 @@ class PostfixEvaluator {
   // The stack contains state information as execution progresses.  Values
   // are pushed on to it as the expression string is read and as operations
   // yield values; values are popped when used as operands to operators.
-  vector<string> stack_;
+  // Identifiers on the stack point into the program being evaluated.
+  vector<StackEntry> stack_;
+
+  // While evaluating with an array of values rather than the dictionary,
+  // the arguments given to EvaluateForValue, and NULL otherwise.
+  const int* slots_;
+  const ValueType* slot_values_;
+  const bool* slot_validity_;
 };
 
 }  // namespace google_breakpad
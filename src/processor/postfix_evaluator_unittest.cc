@@ -392,6 +392,41 @@ static bool RunTests() {
     return false;
   }
 
+  // Compiled programs may be evaluated repeatedly, against different
+  // dictionaries, with identifiers looked up at the time they're used.
+  const PostfixEvaluator<unsigned int>::Program program(
+      "$T0 $ebp = $eip $T0 4 + ^ =$ebp $T0 ^ = $esp $T0 8 + =");
+  for (unsigned int ebp = 0xbfff0010; ebp < 0xbfff0040; ebp += 0x10) {
+    PostfixEvaluator<unsigned int>::DictionaryType dictionary_3;
+    dictionary_3["$ebp"] = ebp;
+    PostfixEvaluator<unsigned int>::DictionaryValidityType assigned;
+    postfix_evaluator.set_dictionary(&dictionary_3);
+    if (!postfix_evaluator.Evaluate(program, &assigned) ||
+        assigned.size() != 4 ||
+        dictionary_3["$eip"] != ebp + 5 ||
+        dictionary_3["$ebp"] != ebp + 1 ||
+        dictionary_3["$esp"] != ebp + 8) {
+      fprintf(stderr, "FAIL: compiled program evaluation with $ebp 0x%x\n",
+              ebp);
+      return false;
+    }
+  }
+
+  const PostfixEvaluator<unsigned int>::Program value_program("$new 4 +");
+  PostfixEvaluator<unsigned int>::DictionaryType dictionary_4;
+  postfix_evaluator.set_dictionary(&dictionary_4);
+  unsigned int value;
+  if (postfix_evaluator.EvaluateForValue(value_program, &value)) {
+    fprintf(stderr, "FAIL: compiled program evaluation with $new unset\n");
+    return false;
+  }
+  dictionary_4["$new"] = 0x10000000;
+  if (!postfix_evaluator.EvaluateForValue(value_program, &value) ||
+      value != 0x10000004) {
+    fprintf(stderr, "FAIL: compiled program evaluation with $new set\n");
+    return false;
+  }
+
   return true;
 }
 
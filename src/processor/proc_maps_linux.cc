@@ -2,106 +2,182 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
-// For <inttypes.h> PRI* macros, before anything else might #include it.
-#ifndef __STDC_FORMAT_MACROS
-#define __STDC_FORMAT_MACROS
-#endif  /* __STDC_FORMAT_MACROS */
-
 #ifdef HAVE_CONFIG_H
 #include <config.h>  // Must come first
 #endif
 
 #include "google_breakpad/processor/proc_maps_linux.h"
 
-#include <fcntl.h>
-#include <inttypes.h>
-#include <stdio.h>
+#include <string.h>
 
 #include "common/using_std_string.h"
 #include "processor/logging.h"
 
-#if defined(OS_ANDROID) && !defined(__LP64__)
-// In 32-bit mode, Bionic's inttypes.h defines PRI/SCNxPTR as an
-// unsigned long int, which is incompatible with Bionic's stdint.h
-// defining uintptr_t as an unsigned int:
-// https://code.google.com/p/android/issues/detail?id=57218
-#undef SCNxPTR
-#define SCNxPTR "x"
-#endif
-
 namespace google_breakpad {
 
-bool ParseProcMaps(const string& input,
-                   std::vector<MappedMemoryRegion>* regions_out) {
-  std::vector<MappedMemoryRegion> regions;
+namespace {
 
-  // This isn't async safe nor terribly efficient, but it doesn't need to be at
-  // this point in time.
-
-  // Split the string by newlines.
-  std::vector<string> lines;
-  string l = "";
-  for (size_t i = 0; i < input.size(); i++) {
-    if (input[i] != '\n' && input[i] != '\r') {
-      l.push_back(input[i]);
-    } else if (l.size() > 0) {
-      lines.push_back(l);
-      l.clear();
-    }
+bool IsSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\v' || c == '\f';
+}
+
+void SkipSpaces(const char** cursor, const char* end) {
+  while (*cursor < end && IsSpace(**cursor))
+    ++*cursor;
+}
+
+// Parses a number in |base| (16 or 10) at |*cursor| as sscanf's %x and %d
+// would: after any spaces, an optional sign and, in base 16, an optional "0x"
+// prefix.  Advances |*cursor| past it and returns true, or returns false if
+// there are no digits or the number doesn't fit in 64 bits.
+bool ParseNumber(const char** cursor, const char* end, int base,
+                 uint64_t* value) {
+  SkipSpaces(cursor, end);
+  const char* p = *cursor;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+'))
+    negative = *p++ == '-';
+  const char* digits = p;
+  if (base == 16 && end - p >= 2 && p[0] == '0' && (p[1] | 0x20) == 'x') {
+    // sscanf takes a bare "0x" as zero.
+    p += 2;
+    digits = p - 1;
+  }
+  uint64_t result = 0;
+  for (; p < end; ++p) {
+    unsigned int digit;
+    if (*p >= '0' && *p <= '9')
+      digit = *p - '0';
+    else if (base == 16 && (*p | 0x20) >= 'a' && (*p | 0x20) <= 'f')
+      digit = (*p | 0x20) - 'a' + 10;
+    else
+      break;
+    if (result > (UINT64_MAX - digit) / base)
+      return false;
+    result = result * base + digit;
   }
-  if (l.size() > 0) {
-    BPLOG(ERROR) << "Input doesn't end in newline";
+  if (p == digits)
+    return false;
+  *value = negative ? 0 - result : result;
+  *cursor = p;
+  return true;
+}
+
+bool ParseChar(const char** cursor, const char* end, char c) {
+  if (*cursor == end || **cursor != c)
+    return false;
+  ++*cursor;
+  return true;
+}
+
+// Parses one line of /proc/<pid>/maps, [line, end), into |region|, except
+// for its strings.  Sets |*path| to the start of the path name, which runs to
+// |end|.
+bool ParseLine(const char* line, const char* end, MappedMemoryRegion* region,
+               const char** path) {
+  // Sample format from man 5 proc:
+  //
+  // address           perms offset  dev   inode   pathname
+  // 08048000-08056000 r-xp 00000000 03:0c 64593   /usr/sbin/gpm
+  const char* cursor = line;
+  uint64_t major_device, minor_device;
+  if (!ParseNumber(&cursor, end, 16, &region->start) ||
+      !ParseChar(&cursor, end, '-') ||
+      !ParseNumber(&cursor, end, 16, &region->end)) {
     return false;
   }
 
-  for (size_t i = 0; i < lines.size(); ++i) {
-    MappedMemoryRegion region;
-    const char* line = lines[i].c_str();
-    char permissions[5] = {'\0'};  // Ensure NUL-terminated string.
-    int path_index = 0;
-
-    // Sample format from man 5 proc:
-    //
-    // address           perms offset  dev   inode   pathname
-    // 08048000-08056000 r-xp 00000000 03:0c 64593   /usr/sbin/gpm
-    //
-    // The final %n term captures the offset in the input string, which is used
-    // to determine the path name. It *does not* increment the return value.
-    // Refer to man 3 sscanf for details.
-    if (sscanf(line, "%" SCNx64 "-%" SCNx64 " %4c %" SCNx64" %hhx:%hhx %"
-               SCNd64 " %n", &region.start, &region.end, permissions,
-               &region.offset, &region.major_device, &region.minor_device,
-               &region.inode, &path_index) < 7) {
-      BPLOG(ERROR) << "sscanf failed for line: " << line;
-      return false;
-    }
+  SkipSpaces(&cursor, end);
+  if (end - cursor < 4)
+    return false;
+  const char* permissions = cursor;
+  cursor += 4;
+
+  if (!ParseNumber(&cursor, end, 16, &region->offset) ||
+      !ParseNumber(&cursor, end, 16, &major_device) ||
+      !ParseChar(&cursor, end, ':') ||
+      !ParseNumber(&cursor, end, 16, &minor_device) ||
+      !ParseNumber(&cursor, end, 10, &region->inode)) {
+    return false;
+  }
+  // As with sscanf's %hhx, only the low byte of each device number is kept.
+  region->major_device = static_cast<uint8_t>(major_device);
+  region->minor_device = static_cast<uint8_t>(minor_device);
 
-    region.permissions = 0;
+  region->permissions = 0;
 
-    if (permissions[0] == 'r')
-      region.permissions |= MappedMemoryRegion::READ;
-    else if (permissions[0] != '-')
-      return false;
+  if (permissions[0] == 'r')
+    region->permissions |= MappedMemoryRegion::READ;
+  else if (permissions[0] != '-')
+    return false;
 
-    if (permissions[1] == 'w')
-      region.permissions |= MappedMemoryRegion::WRITE;
-    else if (permissions[1] != '-')
-      return false;
+  if (permissions[1] == 'w')
+    region->permissions |= MappedMemoryRegion::WRITE;
+  else if (permissions[1] != '-')
+    return false;
 
-    if (permissions[2] == 'x')
-      region.permissions |= MappedMemoryRegion::EXECUTE;
-    else if (permissions[2] != '-')
-      return false;
+  if (permissions[2] == 'x')
+    region->permissions |= MappedMemoryRegion::EXECUTE;
+  else if (permissions[2] != '-')
+    return false;
+
+  if (permissions[3] == 'p')
+    region->permissions |= MappedMemoryRegion::PRIVATE;
+  else if (permissions[3] != 's' && permissions[3] != 'S')  // Shared memory.
+    return false;
 
-    if (permissions[3] == 'p')
-      region.permissions |= MappedMemoryRegion::PRIVATE;
-    else if (permissions[3] != 's' && permissions[3] != 'S')  // Shared memory.
+  SkipSpaces(&cursor, end);
+  *path = cursor;
+  return true;
+}
+
+}  // namespace
+
+bool ParseProcMaps(const string& input,
+                   std::vector<MappedMemoryRegion>* regions_out) {
+  std::vector<MappedMemoryRegion> regions;
+
+  // Parse the input in place, a line at a time, without copying it into
+  // per-line strings first.  Each line is one region, so counting the
+  // newlines sizes |regions| up front.
+  const char* input_begin = input.data();
+  const char* input_end = input_begin + input.size();
+  size_t line_count = 0;
+  for (const char* p = input_begin;
+       (p = static_cast<const char*>(memchr(p, '\n', input_end - p)));
+       ++p) {
+    ++line_count;
+  }
+  regions.reserve(line_count);
+
+  const char* cursor = input_begin;
+  while (cursor < input_end) {
+    // Lines end with \n or \r, and empty lines are skipped.
+    const char* line = cursor;
+    while (cursor < input_end && *cursor != '\n' && *cursor != '\r')
+      ++cursor;
+    if (cursor == input_end) {
+      BPLOG(ERROR) << "Input doesn't end in newline";
       return false;
+    }
+    const char* line_end = cursor++;
+    if (line == line_end)
+      continue;
+    // Fields end at a NUL, as if the line were a C string.
+    if (const char* nul =
+            static_cast<const char*>(memchr(line, '\0', line_end - line))) {
+      line_end = nul;
+    }
 
-    // Pushing then assigning saves us a string copy.
-    regions.push_back(region);
-    regions.back().path.assign(line + path_index);
-    regions.back().line.assign(line);
+    regions.emplace_back();
+    MappedMemoryRegion& region = regions.back();
+    const char* path;
+    if (!ParseLine(line, line_end, &region, &path)) {
+      BPLOG(ERROR) << "Failed to parse line: " << string(line, line_end);
+      return false;
+    }
+    region.path.assign(path, line_end);
+    region.line.assign(line, line_end);
   }
 
   regions_out->swap(regions);
@@ -37,13 +37,69 @@
 #endif
 
 #include "google_breakpad/processor/process_state.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "common/scoped_ptr.h"
 #include "google_breakpad/processor/call_stack.h"
 #include "google_breakpad/processor/code_modules.h"
 
 namespace google_breakpad {
 
+struct ProcessState::DeferredThreadWalks {
+  enum WalkState {
+    WALKED,
+    DEFERRED,
+    WALKING,
+    INTERRUPTED
+  };
+
+  scoped_ptr<DeferredThreadWalker> walker;
+
+  // Guards walk_states, and the parts of the ProcessState that walks add
+  // to.
+  std::mutex lock;
+
+  // Signaled when a walk finishes.
+  std::condition_variable walked;
+
+  // The state of the walk of each thread, by thread index.
+  vector<WalkState> walk_states;
+};
+
+struct ProcessState::DeferredExploitabilityAnalysis {
+  scoped_ptr<DeferredExploitability> analyzer;
+
+  // Guards analyzed and exploitability_.
+  std::mutex lock;
+
+  bool analyzed;
+};
+
+namespace {
+
+// Appends the modules in source that are not yet in destination, as
+// recorded in destination_set.
+void MergeModules(const vector<const CodeModule*>& source,
+                  vector<const CodeModule*>* destination,
+                  std::unordered_set<const CodeModule*>* destination_set) {
+  for (const CodeModule* module : source) {
+    if (destination_set->insert(module).second)
+      destination->push_back(module);
+  }
+}
+
+}  // namespace
+
 ProcessState::~ProcessState() {
   Clear();
+  for (CallStack* stack : spare_threads_) {
+    delete stack;
+  }
 }
 
 void ProcessState::Clear() {
@@ -55,22 +111,186 @@ void ProcessState::Clear() {
   assertion_.clear();
   requesting_thread_ = -1;
   original_thread_count_ = 0;
-  for (vector<CallStack*>::const_iterator iterator = threads_.begin();
-       iterator != threads_.end();
-       ++iterator) {
-    delete *iterator;
+  deduplicated_stack_count_ = 0;
+  cached_stack_count_ = 0;
+  resymbolized_stack_count_ = 0;
+  walk_truncated_ = false;
+  stack_signature_.clear();
+  stack_signature_hash_ = 0;
+  stats_.Clear();
+  dump_phases_.clear();
+  delete deferred_walks_;
+  deferred_walks_ = NULL;
+  delete deferred_exploitability_;
+  deferred_exploitability_ = NULL;
+  exception_record_.Clear();
+  for (CallStack* stack : threads_) {
+    if (spare_threads_.size() < kMaxSpareThreads) {
+      stack->Clear();
+      spare_threads_.push_back(stack);
+    } else {
+      delete stack;
+    }
   }
   threads_.clear();
+  thread_memory_regions_.clear();
   system_info_.Clear();
   thread_names_.clear();
   // modules_without_symbols_ and modules_with_corrupt_symbols_ DO NOT own
   // the underlying CodeModule pointers.  Just clear the vectors.
   modules_without_symbols_.clear();
   modules_with_corrupt_symbols_.clear();
-  delete modules_;
-  modules_ = NULL;
-  delete unloaded_modules_;
-  unloaded_modules_ = NULL;
+  modules_without_symbols_set_.clear();
+  modules_with_corrupt_symbols_set_.clear();
+  modules_.reset();
+  unloaded_modules_.reset();
+  shrunk_range_modules_.clear();
+  exploitability_ = EXPLOITABILITY_NOT_ANALYZED;
+}
+
+CallStack* ProcessState::NewThread() {
+  if (spare_threads_.empty())
+    return new CallStack();
+  CallStack* stack = spare_threads_.back();
+  spare_threads_.pop_back();
+  return stack;
+}
+
+void ProcessState::MergeWalkModules(
+    const vector<const CodeModule*>& modules_without_symbols,
+    const vector<const CodeModule*>& modules_with_corrupt_symbols) {
+  MergeModules(modules_without_symbols, &modules_without_symbols_,
+               &modules_without_symbols_set_);
+  MergeModules(modules_with_corrupt_symbols, &modules_with_corrupt_symbols_,
+               &modules_with_corrupt_symbols_set_);
+}
+
+bool ProcessState::thread_walk_deferred(int thread_index) const {
+  if (!deferred_walks_ || thread_index < 0 ||
+      static_cast<size_t>(thread_index) >= threads_.size()) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(deferred_walks_->lock);
+  DeferredThreadWalks::WalkState walk_state =
+      deferred_walks_->walk_states[thread_index];
+  return walk_state == DeferredThreadWalks::DEFERRED ||
+         walk_state == DeferredThreadWalks::WALKING;
+}
+
+const CallStack* ProcessState::GetWalkedThread(int thread_index) {
+  if (thread_index < 0 ||
+      static_cast<size_t>(thread_index) >= threads_.size()) {
+    return NULL;
+  }
+  CallStack* stack = threads_[thread_index];
+  if (!deferred_walks_)
+    return stack;
+
+  std::unique_lock<std::mutex> lock(deferred_walks_->lock);
+  DeferredThreadWalks::WalkState* walk_state =
+      &deferred_walks_->walk_states[thread_index];
+  while (*walk_state == DeferredThreadWalks::WALKING)
+    deferred_walks_->walked.wait(lock);
+  if (*walk_state == DeferredThreadWalks::DEFERRED) {
+    *walk_state = DeferredThreadWalks::WALKING;
+    lock.unlock();
+    vector<const CodeModule*> modules_without_symbols;
+    vector<const CodeModule*> modules_with_corrupt_symbols;
+    bool walked = deferred_walks_->walker->Walk(thread_index, stack,
+                                                &modules_without_symbols,
+                                                &modules_with_corrupt_symbols);
+    lock.lock();
+    MergeWalkModules(modules_without_symbols, modules_with_corrupt_symbols);
+    if (stack->truncated())
+      walk_truncated_ = true;
+    *walk_state = walked ? DeferredThreadWalks::WALKED :
+                           DeferredThreadWalks::INTERRUPTED;
+    deferred_walks_->walked.notify_all();
+  }
+  return *walk_state == DeferredThreadWalks::INTERRUPTED ? NULL : stack;
+}
+
+bool ProcessState::WalkDeferredThreads(int concurrency) {
+  if (!deferred_walks_)
+    return true;
+
+  vector<int> thread_indices;
+  {
+    std::lock_guard<std::mutex> lock(deferred_walks_->lock);
+    for (size_t thread_index = 0;
+         thread_index < deferred_walks_->walk_states.size(); ++thread_index) {
+      if (deferred_walks_->walk_states[thread_index] !=
+          DeferredThreadWalks::WALKED) {
+        thread_indices.push_back(thread_index);
+      }
+    }
+  }
+
+  std::atomic<size_t> next_thread(0);
+  std::atomic<bool> interrupted(false);
+  auto walk_threads = [&]() {
+    for (size_t index = next_thread++; index < thread_indices.size();
+         index = next_thread++) {
+      if (!GetWalkedThread(thread_indices[index]))
+        interrupted = true;
+    }
+  };
+
+  size_t worker_count = std::min(static_cast<size_t>(std::max(concurrency, 1)),
+                                 thread_indices.size());
+  if (worker_count <= 1) {
+    walk_threads();
+  } else {
+    vector<std::thread> workers;
+    workers.reserve(worker_count);
+    for (size_t worker_index = 0; worker_index < worker_count;
+         ++worker_index) {
+      workers.push_back(std::thread(walk_threads));
+    }
+    for (std::thread& worker : workers) {
+      worker.join();
+    }
+  }
+  return !interrupted;
+}
+
+void ProcessState::DeferThreadWalks(DeferredThreadWalker* walker,
+                                    const vector<int>& thread_indices) {
+  delete deferred_walks_;
+  deferred_walks_ = new DeferredThreadWalks();
+  deferred_walks_->walker.reset(walker);
+  deferred_walks_->walk_states.assign(threads_.size(),
+                                      DeferredThreadWalks::WALKED);
+  for (int thread_index : thread_indices)
+    deferred_walks_->walk_states[thread_index] = DeferredThreadWalks::DEFERRED;
+}
+
+bool ProcessState::exploitability_deferred() const {
+  if (!deferred_exploitability_)
+    return false;
+  std::lock_guard<std::mutex> lock(deferred_exploitability_->lock);
+  return !deferred_exploitability_->analyzed;
+}
+
+ExploitabilityRating ProcessState::AnalyzeExploitability() {
+  if (!deferred_exploitability_)
+    return exploitability_;
+
+  // Holding the lock through the analysis makes other callers wait for it.
+  std::lock_guard<std::mutex> lock(deferred_exploitability_->lock);
+  if (!deferred_exploitability_->analyzed) {
+    exploitability_ = deferred_exploitability_->analyzer->Analyze();
+    deferred_exploitability_->analyzed = true;
+  }
+  return exploitability_;
+}
+
+void ProcessState::DeferExploitability(DeferredExploitability* analyzer) {
+  delete deferred_exploitability_;
+  deferred_exploitability_ = new DeferredExploitabilityAnalysis();
+  deferred_exploitability_->analyzer.reset(analyzer);
+  deferred_exploitability_->analyzed = false;
+  exploitability_ = EXPLOITABILITY_NOT_ANALYZED;
 }
 
 }  // namespace google_breakpad
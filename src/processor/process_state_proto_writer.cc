@@ -0,0 +1,254 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// process_state_proto_writer.cc: Writes a ProcessState as a
+// ProcessStateProto.
+//
+// See process_state_proto_writer.h for documentation.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "processor/process_state_proto_writer.h"
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/code_modules.h"
+#include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "google_breakpad/processor/system_info.h"
+
+namespace google_breakpad {
+
+namespace {
+
+// Field numbers, from processor/proto/process_state.proto.
+enum ProcessStateField {
+  kProcessStateTimeDateStamp = 1,
+  kProcessStateCrash = 2,
+  kProcessStateAssertion = 3,
+  kProcessStateRequestingThread = 4,
+  kProcessStateThreads = 5,
+  kProcessStateModules = 6,
+  kProcessStateOS = 7,
+  kProcessStateOSShort = 8,
+  kProcessStateOSVersion = 9,
+  kProcessStateCPU = 10,
+  kProcessStateCPUInfo = 11,
+  kProcessStateCPUCount = 12,
+  kProcessStateProcessCreateTime = 13
+};
+
+enum CrashField {
+  kCrashReason = 1,
+  kCrashAddress = 2
+};
+
+enum ThreadField {
+  kThreadFrames = 1
+};
+
+enum StackFrameField {
+  kStackFrameInstruction = 1,
+  kStackFrameModule = 2,
+  kStackFrameFunctionName = 3,
+  kStackFrameFunctionBase = 4,
+  kStackFrameSourceFileName = 5,
+  kStackFrameSourceLine = 6,
+  kStackFrameSourceLineBase = 7
+};
+
+enum CodeModuleField {
+  kCodeModuleBaseAddress = 1,
+  kCodeModuleSize = 2,
+  kCodeModuleCodeFile = 3,
+  kCodeModuleCodeIdentifier = 4,
+  kCodeModuleDebugFile = 5,
+  kCodeModuleDebugIdentifier = 6,
+  kCodeModuleVersion = 7
+};
+
+// Wire types of the protocol buffer binary format.
+enum WireType {
+  kWireTypeVarint = 0,
+  kWireTypeLengthDelimited = 2
+};
+
+// Encodes the fields of a message.
+class MessageEncoder {
+ public:
+  // Appends an int32 or int64 field.  Negative values take ten bytes, as
+  // the format requires of both types.
+  void AddInteger(int field, int64_t value) {
+    AddTag(field, kWireTypeVarint);
+    AddVarint(static_cast<uint64_t>(value));
+  }
+
+  // Appends a string field, or an embedded message field, given the
+  // encoded message.
+  void AddBytes(int field, const string& value) {
+    AddTag(field, kWireTypeLengthDelimited);
+    AddVarint(value.size());
+    data_.append(value);
+  }
+
+  // Appends a string field if value is not empty.
+  void AddNonEmptyString(int field, const string& value) {
+    if (!value.empty())
+      AddBytes(field, value);
+  }
+
+  const string& data() const { return data_; }
+  void Clear() { data_.clear(); }
+
+ private:
+  void AddTag(int field, WireType wire_type) {
+    AddVarint((static_cast<uint64_t>(field) << 3) | wire_type);
+  }
+
+  void AddVarint(uint64_t value) {
+    while (value >= 0x80) {
+      data_.push_back(static_cast<char>((value & 0x7f) | 0x80));
+      value >>= 7;
+    }
+    data_.push_back(static_cast<char>(value));
+  }
+
+  string data_;
+};
+
+}  // namespace
+
+bool ProcessStateProtoWriter::Write(const ProcessState& process_state) {
+  if (!WriteProcessInfo(process_state))
+    return false;
+  const std::vector<CallStack*>* threads = process_state.threads();
+  for (size_t thread_index = 0; thread_index < threads->size();
+       ++thread_index) {
+    if (!WriteThread(*threads->at(thread_index)))
+      return false;
+  }
+  return true;
+}
+
+bool ProcessStateProtoWriter::WriteProcessInfo(
+    const ProcessState& process_state) {
+  MessageEncoder message;
+  message.AddInteger(kProcessStateTimeDateStamp,
+                     process_state.time_date_stamp());
+  message.AddInteger(kProcessStateProcessCreateTime,
+                     process_state.process_create_time());
+  if (process_state.crashed()) {
+    MessageEncoder crash;
+    crash.AddBytes(kCrashReason, process_state.crash_reason());
+    crash.AddInteger(kCrashAddress, process_state.crash_address());
+    message.AddBytes(kProcessStateCrash, crash.data());
+  }
+  message.AddNonEmptyString(kProcessStateAssertion, process_state.assertion());
+  if (process_state.requesting_thread() != -1) {
+    message.AddInteger(kProcessStateRequestingThread,
+                       process_state.requesting_thread());
+  }
+
+  const SystemInfo* system_info = process_state.system_info();
+  message.AddNonEmptyString(kProcessStateOS, system_info->os);
+  message.AddNonEmptyString(kProcessStateOSShort, system_info->os_short);
+  message.AddNonEmptyString(kProcessStateOSVersion, system_info->os_version);
+  message.AddNonEmptyString(kProcessStateCPU, system_info->cpu);
+  message.AddNonEmptyString(kProcessStateCPUInfo, system_info->cpu_info);
+  message.AddInteger(kProcessStateCPUCount, system_info->cpu_count);
+
+  const CodeModules* modules = process_state.modules();
+  if (modules) {
+    unsigned int module_count = modules->module_count();
+    for (unsigned int module_index = 0; module_index < module_count;
+         ++module_index) {
+      message.AddBytes(kProcessStateModules,
+                       EncodeModule(modules->GetModuleAtIndex(module_index)));
+    }
+  }
+
+  const string& data = message.data();
+  return fwrite(data.data(), 1, data.size(), output_) == data.size();
+}
+
+bool ProcessStateProtoWriter::WriteThread(const CallStack& stack) {
+  MessageEncoder thread;
+  MessageEncoder frame;
+  const std::vector<StackFrame*>* frames = stack.frames();
+  for (size_t frame_index = 0; frame_index < frames->size(); ++frame_index) {
+    const StackFrame* stack_frame = frames->at(frame_index);
+    frame.Clear();
+    frame.AddInteger(kStackFrameInstruction, stack_frame->instruction);
+    if (stack_frame->module)
+      frame.AddBytes(kStackFrameModule, EncodeModule(stack_frame->module));
+    if (!stack_frame->function_name.empty()) {
+      frame.AddBytes(kStackFrameFunctionName, stack_frame->function_name);
+      frame.AddInteger(kStackFrameFunctionBase, stack_frame->function_base);
+    }
+    if (!stack_frame->source_file_name.empty()) {
+      frame.AddBytes(kStackFrameSourceFileName,
+                     stack_frame->source_file_name);
+      frame.AddInteger(kStackFrameSourceLine, stack_frame->source_line);
+      frame.AddInteger(kStackFrameSourceLineBase,
+                       stack_frame->source_line_base);
+    }
+    thread.AddBytes(kThreadFrames, frame.data());
+  }
+
+  MessageEncoder message;
+  message.AddBytes(kProcessStateThreads, thread.data());
+  const string& data = message.data();
+  return fwrite(data.data(), 1, data.size(), output_) == data.size();
+}
+
+const string& ProcessStateProtoWriter::EncodeModule(const CodeModule* module) {
+  std::map<const CodeModule*, string>::iterator encoded =
+      encoded_modules_.find(module);
+  if (encoded != encoded_modules_.end())
+    return encoded->second;
+
+  MessageEncoder message;
+  message.AddInteger(kCodeModuleBaseAddress, module->base_address());
+  message.AddInteger(kCodeModuleSize, module->size());
+  message.AddNonEmptyString(kCodeModuleCodeFile, module->code_file());
+  message.AddNonEmptyString(kCodeModuleCodeIdentifier,
+                            module->code_identifier());
+  message.AddNonEmptyString(kCodeModuleDebugFile, module->debug_file());
+  message.AddNonEmptyString(kCodeModuleDebugIdentifier,
+                            module->debug_identifier());
+  message.AddNonEmptyString(kCodeModuleVersion, module->version());
+  return encoded_modules_[module] = message.data();
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,90 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// process_state_proto_writer.h: Writes a ProcessState as a
+// ProcessStateProto.
+//
+// ProcessStateProtoWriter writes a ProcessState in the protocol buffer
+// binary format of ProcessStateProto, described in
+// processor/proto/process_state.proto, without depending on the protocol
+// buffer library.  Each thread is a separate element of the repeated
+// threads field, so the message is written a field at a time, and no more
+// than one thread's stack is encoded in memory at once.  The fields of the
+// message follow one another in the output, which any protocol buffer
+// implementation parses as a whole ProcessStateProto.
+
+#ifndef PROCESSOR_PROCESS_STATE_PROTO_WRITER_H__
+#define PROCESSOR_PROCESS_STATE_PROTO_WRITER_H__
+
+#include <stdio.h>
+
+#include <map>
+#include <string>
+
+#include "common/using_std_string.h"
+
+namespace google_breakpad {
+
+class CallStack;
+class CodeModule;
+class ProcessState;
+
+class ProcessStateProtoWriter {
+ public:
+  // Creates a ProcessStateProtoWriter writing to output, which must be
+  // open in binary mode.  A writer writes a single ProcessState.
+  explicit ProcessStateProtoWriter(FILE* output) : output_(output) {}
+
+  // Writes process_state, then each of its threads.  Returns false if
+  // writing to output failed.
+  bool Write(const ProcessState& process_state);
+
+  // Writes the fields of process_state other than its threads.  Returns
+  // false if writing to output failed.
+  bool WriteProcessInfo(const ProcessState& process_state);
+
+  // Writes stack as the next element of the threads field.  Threads must
+  // be written in the order of ProcessState::threads, since the
+  // requesting_thread field indexes them.  Returns false if writing to
+  // output failed.
+  bool WriteThread(const CallStack& stack);
+
+ private:
+  // Returns module encoded as a CodeModule message.  Each module is
+  // encoded once, and repeated for every frame it holds.
+  const string& EncodeModule(const CodeModule* module);
+
+  FILE* output_;
+
+  // Encoded CodeModule messages, by module.
+  std::map<const CodeModule*, string> encoded_modules_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_PROCESS_STATE_PROTO_WRITER_H__
@@ -0,0 +1,204 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Unit tests for ProcessStateProtoWriter.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "breakpad_googletest_includes.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/minidump_processor.h"
+#include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "processor/process_state_proto_writer.h"
+#include "processor/simple_symbol_supplier.h"
+
+namespace {
+
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::CallStack;
+using google_breakpad::MinidumpProcessor;
+using google_breakpad::ProcessState;
+using google_breakpad::ProcessStateProtoWriter;
+using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::StackFrame;
+
+string GetTestDataPath() {
+  char* srcdir = getenv("srcdir");
+
+  return string(srcdir ? srcdir : ".") + "/src/processor/testdata/";
+}
+
+// The fields of a decoded message, by field number.  Varint fields hold
+// their value, and length-delimited fields their bytes.
+struct Message {
+  std::multimap<int, uint64_t> integers;
+  std::multimap<int, string> bytes;
+
+  uint64_t Integer(int field) const {
+    std::multimap<int, uint64_t>::const_iterator iterator =
+        integers.find(field);
+    return iterator == integers.end() ? 0 : iterator->second;
+  }
+
+  string Bytes(int field) const {
+    std::multimap<int, string>::const_iterator iterator = bytes.find(field);
+    return iterator == bytes.end() ? string() : iterator->second;
+  }
+
+  std::vector<string> AllBytes(int field) const {
+    std::vector<string> values;
+    for (std::multimap<int, string>::const_iterator iterator =
+             bytes.lower_bound(field);
+         iterator != bytes.upper_bound(field); ++iterator) {
+      values.push_back(iterator->second);
+    }
+    return values;
+  }
+};
+
+bool ReadVarint(const string& data, size_t* offset, uint64_t* value) {
+  *value = 0;
+  for (int shift = 0; shift < 64 && *offset < data.size(); shift += 7) {
+    uint8_t byte = data[(*offset)++];
+    *value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+// Decodes data, which must hold only varint and length-delimited fields.
+bool Decode(const string& data, Message* message) {
+  size_t offset = 0;
+  while (offset < data.size()) {
+    uint64_t tag, value;
+    if (!ReadVarint(data, &offset, &tag) ||
+        !ReadVarint(data, &offset, &value)) {
+      return false;
+    }
+    int field = tag >> 3;
+    switch (tag & 7) {
+      case 0:
+        message->integers.insert(std::make_pair(field, value));
+        break;
+      case 2:
+        if (value > data.size() - offset)
+          return false;
+        message->bytes.insert(
+            std::make_pair(field, data.substr(offset, value)));
+        offset += value;
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+// Writes state with a ProcessStateProtoWriter, and decodes the output.
+void WriteAndDecode(const ProcessState& state, Message* message) {
+  FILE* output = tmpfile();
+  ASSERT_TRUE(output);
+  ProcessStateProtoWriter writer(output);
+  ASSERT_TRUE(writer.Write(state));
+  string data;
+  rewind(output);
+  char buffer[4096];
+  size_t count;
+  while ((count = fread(buffer, 1, sizeof(buffer), output)) > 0)
+    data.append(buffer, count);
+  fclose(output);
+  ASSERT_TRUE(Decode(data, message));
+}
+
+TEST(ProcessStateProtoWriterTest, WritesProcessState) {
+  SimpleSymbolSupplier supplier(GetTestDataPath() + "symbols");
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(&supplier, &resolver);
+  ProcessState state;
+  ASSERT_EQ(google_breakpad::PROCESS_OK,
+            processor.Process(GetTestDataPath() + "minidump2.dmp", &state));
+
+  Message message;
+  WriteAndDecode(state, &message);
+  EXPECT_EQ(state.time_date_stamp(), message.Integer(1));
+  EXPECT_EQ(state.process_create_time(), message.Integer(13));
+  EXPECT_EQ(static_cast<uint64_t>(state.requesting_thread()),
+            message.Integer(4));
+  EXPECT_EQ(state.system_info()->os, message.Bytes(7));
+  EXPECT_EQ(state.system_info()->os_short, message.Bytes(8));
+  EXPECT_EQ(state.system_info()->cpu, message.Bytes(10));
+  EXPECT_EQ(static_cast<uint64_t>(state.system_info()->cpu_count),
+            message.Integer(12));
+
+  Message crash;
+  ASSERT_TRUE(Decode(message.Bytes(2), &crash));
+  EXPECT_EQ("EXCEPTION_ACCESS_VIOLATION_WRITE", crash.Bytes(1));
+  EXPECT_EQ(state.crash_address(), crash.Integer(2));
+
+  EXPECT_EQ(state.modules()->module_count(), message.AllBytes(6).size());
+
+  std::vector<string> threads = message.AllBytes(5);
+  ASSERT_EQ(state.threads()->size(), threads.size());
+  const CallStack* stack = state.threads()->at(0);
+  Message thread;
+  ASSERT_TRUE(Decode(threads[0], &thread));
+  std::vector<string> frames = thread.AllBytes(1);
+  ASSERT_EQ(stack->frames()->size(), frames.size());
+  ASSERT_EQ("`anonymous namespace'::CrashFunction",
+            stack->frames()->at(0)->function_name);
+  for (size_t i = 0; i < frames.size(); ++i) {
+    const StackFrame* stack_frame = stack->frames()->at(i);
+    Message frame;
+    ASSERT_TRUE(Decode(frames[i], &frame));
+    EXPECT_EQ(stack_frame->instruction, frame.Integer(1));
+    EXPECT_EQ(stack_frame->function_name, frame.Bytes(3));
+    EXPECT_EQ(stack_frame->source_file_name, frame.Bytes(5));
+    EXPECT_EQ(static_cast<uint64_t>(stack_frame->source_line),
+              frame.Integer(6));
+    Message module;
+    ASSERT_TRUE(Decode(frame.Bytes(2), &module));
+    EXPECT_EQ(stack_frame->module->base_address(), module.Integer(1));
+    EXPECT_EQ(stack_frame->module->code_file(), module.Bytes(3));
+  }
+}
+
+}  // namespace
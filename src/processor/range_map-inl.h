@@ -38,6 +38,8 @@
 
 #include <assert.h>
 
+#include <algorithm>
+
 #include "common/safe_math.h"
 #include "processor/range_map.h"
 #include "processor/linked_ptr.h"
@@ -76,6 +78,9 @@ bool RangeMap<AddressType, EntryType>::StoreRangeInternal(
     return false;
   }
 
+  if (frozen_)
+    Thaw();
+
   // Ensure that this range does not overlap with another one already in the
   // map.
   MapConstIterator iterator_base = map_.lower_bound(base);
@@ -191,8 +196,26 @@ bool RangeMap<AddressType, EntryType>::RetrieveRange(
   BPLOG_IF(ERROR, !entry) << "RangeMap::RetrieveRange requires |entry|";
   assert(entry);
 
-  MapConstIterator iterator = map_.lower_bound(address);
-  if (iterator == map_.end())
+  const EntryType* stored_entry;
+  if (!RetrieveRange(address, &stored_entry, entry_base, entry_delta,
+                     entry_size))
+    return false;
+
+  *entry = *stored_entry;
+  return true;
+}
+
+
+template<typename AddressType, typename EntryType>
+bool RangeMap<AddressType, EntryType>::RetrieveRange(
+    const AddressType& address, const EntryType** entry,
+    AddressType* entry_base, AddressType* entry_delta,
+    AddressType* entry_size) const {
+  BPLOG_IF(ERROR, !entry) << "RangeMap::RetrieveRange requires |entry|";
+  assert(entry);
+
+  const MapValue* iterator = LowerBound(address);
+  if (!iterator)
     return false;
 
   // The map is keyed by the high address of each range, so |address| is
@@ -203,7 +226,7 @@ bool RangeMap<AddressType, EntryType>::RetrieveRange(
   if (address < iterator->second.base())
     return false;
 
-  *entry = iterator->second.entry();
+  *entry = &iterator->second.entry();
   if (entry_base)
     *entry_base = iterator->second.base();
   if (entry_delta)
@@ -222,21 +245,35 @@ bool RangeMap<AddressType, EntryType>::RetrieveNearestRange(
   BPLOG_IF(ERROR, !entry) << "RangeMap::RetrieveNearestRange requires |entry|";
   assert(entry);
 
+  const EntryType* stored_entry;
+  if (!RetrieveNearestRange(address, &stored_entry, entry_base, entry_delta,
+                            entry_size))
+    return false;
+
+  *entry = *stored_entry;
+  return true;
+}
+
+
+template<typename AddressType, typename EntryType>
+bool RangeMap<AddressType, EntryType>::RetrieveNearestRange(
+    const AddressType& address, const EntryType** entry,
+    AddressType* entry_base, AddressType* entry_delta,
+    AddressType* entry_size) const {
+  BPLOG_IF(ERROR, !entry) << "RangeMap::RetrieveNearestRange requires |entry|";
+  assert(entry);
+
   // If address is within a range, RetrieveRange can handle it.
   if (RetrieveRange(address, entry, entry_base, entry_delta, entry_size))
     return true;
 
-  // upper_bound gives the first element whose key is greater than address,
-  // but we want the first element whose key is less than or equal to address.
-  // Decrement the iterator to get there, but not if the upper_bound already
-  // points to the beginning of the map - in that case, address is lower than
-  // the lowest stored key, so return false.
-  MapConstIterator iterator = map_.upper_bound(address);
-  if (iterator == map_.begin())
+  // Find the range with the highest high address below address.  If there
+  // is none, address is lower than the lowest stored key, so return false.
+  const MapValue* iterator = LastAtOrBelow(address);
+  if (!iterator)
     return false;
-  --iterator;
 
-  *entry = iterator->second.entry();
+  *entry = &iterator->second.entry();
   if (entry_base)
     *entry_base = iterator->second.base();
   if (entry_delta)
@@ -255,18 +292,41 @@ bool RangeMap<AddressType, EntryType>::RetrieveRangeAtIndex(
   BPLOG_IF(ERROR, !entry) << "RangeMap::RetrieveRangeAtIndex requires |entry|";
   assert(entry);
 
+  const EntryType* stored_entry;
+  if (!RetrieveRangeAtIndex(index, &stored_entry, entry_base, entry_delta,
+                            entry_size))
+    return false;
+
+  *entry = *stored_entry;
+  return true;
+}
+
+
+template<typename AddressType, typename EntryType>
+bool RangeMap<AddressType, EntryType>::RetrieveRangeAtIndex(
+    int64_t index, const EntryType** entry, AddressType* entry_base,
+    AddressType* entry_delta, AddressType* entry_size) const {
+  BPLOG_IF(ERROR, !entry) << "RangeMap::RetrieveRangeAtIndex requires |entry|";
+  assert(entry);
+
   if (index >= GetCount()) {
     BPLOG(ERROR) << "Index out of range: " << index << "/" << GetCount();
     return false;
   }
 
-  // Walk through the map.  Although it's ordered, it's not a vector, so it
-  // can't be addressed directly by index.
-  MapConstIterator iterator = map_.begin();
-  for (int64_t this_index = 0; this_index < index; ++this_index)
-    ++iterator;
+  const MapValue* iterator;
+  if (frozen_) {
+    iterator = &frozen_map_[index];
+  } else {
+    // Walk through the map.  Although it's ordered, it's not a vector, so it
+    // can't be addressed directly by index.
+    MapConstIterator map_iterator = map_.begin();
+    for (int64_t this_index = 0; this_index < index; ++this_index)
+      ++map_iterator;
+    iterator = &*map_iterator;
+  }
 
-  *entry = iterator->second.entry();
+  *entry = &iterator->second.entry();
   if (entry_base)
     *entry_base = iterator->second.base();
   if (entry_delta)
@@ -280,13 +340,75 @@ bool RangeMap<AddressType, EntryType>::RetrieveRangeAtIndex(
 
 template<typename AddressType, typename EntryType>
 int64_t RangeMap<AddressType, EntryType>::GetCount() const {
-  return static_cast<int64_t>(map_.size());
+  return static_cast<int64_t>(frozen_ ? frozen_map_.size() : map_.size());
+}
+
+
+template<typename AddressType, typename EntryType>
+void RangeMap<AddressType, EntryType>::Freeze() {
+  if (frozen_)
+    return;
+
+  FrozenRangeMap frozen_map(map_.begin(), map_.end());
+  frozen_map_.swap(frozen_map);
+  map_.clear();
+  frozen_ = true;
+}
+
+
+template<typename AddressType, typename EntryType>
+void RangeMap<AddressType, EntryType>::Thaw() {
+  map_.insert(frozen_map_.begin(), frozen_map_.end());
+  FrozenRangeMap().swap(frozen_map_);
+  frozen_ = false;
+}
+
+
+template<typename AddressType, typename EntryType>
+const typename RangeMap<AddressType, EntryType>::MapValue*
+RangeMap<AddressType, EntryType>::LowerBound(
+    const AddressType& address) const {
+  if (frozen_) {
+    FrozenConstIterator iterator = std::lower_bound(
+        frozen_map_.begin(), frozen_map_.end(), address,
+        [](const MapValue& value, const AddressType& key) {
+          return value.first < key;
+        });
+    return iterator == frozen_map_.end() ? NULL : &*iterator;
+  }
+
+  MapConstIterator iterator = map_.lower_bound(address);
+  return iterator == map_.end() ? NULL : &*iterator;
+}
+
+
+template<typename AddressType, typename EntryType>
+const typename RangeMap<AddressType, EntryType>::MapValue*
+RangeMap<AddressType, EntryType>::LastAtOrBelow(
+    const AddressType& address) const {
+  // upper_bound gives the first element whose key is greater than address,
+  // but we want the first element whose key is less than or equal to address.
+  // Decrement the iterator to get there, but not if the upper_bound already
+  // points to the beginning of the map.
+  if (frozen_) {
+    FrozenConstIterator iterator = std::upper_bound(
+        frozen_map_.begin(), frozen_map_.end(), address,
+        [](const AddressType& key, const MapValue& value) {
+          return key < value.first;
+        });
+    return iterator == frozen_map_.begin() ? NULL : &*--iterator;
+  }
+
+  MapConstIterator iterator = map_.upper_bound(address);
+  return iterator == map_.begin() ? NULL : &*--iterator;
 }
 
 
 template<typename AddressType, typename EntryType>
 void RangeMap<AddressType, EntryType>::Clear() {
   map_.clear();
+  FrozenRangeMap().swap(frozen_map_);
+  frozen_ = false;
 }
 
 
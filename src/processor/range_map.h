@@ -42,12 +42,13 @@
 
 #include <stdint.h>
 #include <map>
+#include <vector>
 
 
 namespace google_breakpad {
 
 // Forward declarations (for later friend declarations of specialized template).
-template<class, class> class RangeMapSerializer;
+template<class, class, class> class RangeMapSerializer;
 
 // Determines what happens when two ranges overlap.
 enum class MergeRangeStrategy {
@@ -67,7 +68,11 @@ enum class MergeRangeStrategy {
 template<typename AddressType, typename EntryType>
 class RangeMap {
  public:
-  RangeMap() : merge_strategy_(MergeRangeStrategy::kExclusiveRanges), map_() {}
+  RangeMap()
+      : merge_strategy_(MergeRangeStrategy::kExclusiveRanges),
+        map_(),
+        frozen_map_(),
+        frozen_(false) {}
 
   void SetMergeStrategy(MergeRangeStrategy strat) { merge_strategy_ = strat; }
 
@@ -114,9 +119,32 @@ class RangeMap {
                             AddressType* entry_base, AddressType* entry_delta,
                             AddressType* entry_size) const;
 
+  // These overloads set entry to point at the stored entry instead of
+  // copying it.  Copying some entry types, such as linked_ptr, modifies the
+  // stored entry, so lookups made concurrently from several threads must use
+  // these.  The pointer remains valid until the RangeMap is modified.
+  bool RetrieveRange(const AddressType& address, const EntryType** entry,
+                     AddressType* entry_base, AddressType* entry_delta,
+                     AddressType* entry_size) const;
+  bool RetrieveNearestRange(const AddressType& address,
+                            const EntryType** entry, AddressType* entry_base,
+                            AddressType* entry_delta,
+                            AddressType* entry_size) const;
+  bool RetrieveRangeAtIndex(int64_t index, const EntryType** entry,
+                            AddressType* entry_base, AddressType* entry_delta,
+                            AddressType* entry_size) const;
+
   // Returns the number of ranges stored in the RangeMap.
   int64_t GetCount() const;
 
+  // Moves the stored ranges out of the tree used while building the map and
+  // into a sorted array.  Lookups then binary search the array, which takes
+  // a fraction of the tree's memory and touches fewer cache lines.
+  // RetrieveRangeAtIndex becomes a constant-time operation.  Storing a range
+  // in a frozen map moves the ranges back into a tree first, so this is
+  // meant to be called once the map is fully populated.
+  void Freeze();
+
   // Empties the range map, restoring it to the state it was when it was
   // initially created.
   void Clear();
@@ -124,7 +152,7 @@ class RangeMap {
  private:
   // Friend declarations.
   friend class ModuleComparer;
-  friend class RangeMapSerializer<AddressType, EntryType>;
+  template<class, class, class> friend class RangeMapSerializer;
 
   // Same a StoreRange() with the only exception that the |delta| can be
   // passed in.
@@ -139,7 +167,7 @@ class RangeMap {
 
     AddressType base() const { return base_; }
     AddressType delta() const { return delta_; }
-    EntryType entry() const { return entry_; }
+    const EntryType& entry() const { return entry_; }
 
    private:
     // The base address of the range.  The high address does not need to
@@ -157,11 +185,30 @@ class RangeMap {
   typedef std::map<AddressType, Range> AddressToRangeMap;
   typedef typename AddressToRangeMap::const_iterator MapConstIterator;
   typedef typename AddressToRangeMap::value_type MapValue;
+  typedef std::vector<MapValue> FrozenRangeMap;
+  typedef typename FrozenRangeMap::const_iterator FrozenConstIterator;
+
+  // Returns the stored range with the lowest high address at or above
+  // address, or NULL if there is none.
+  const MapValue* LowerBound(const AddressType& address) const;
+
+  // Returns the stored range with the highest high address at or below
+  // address, or NULL if there is none.
+  const MapValue* LastAtOrBelow(const AddressType& address) const;
+
+  // Moves the ranges in frozen_map_ back into map_ so that they can be
+  // modified.
+  void Thaw();
 
   MergeRangeStrategy merge_strategy_;
 
-  // Maps the high address of each range to a EntryType.
+  // Maps the high address of each range to a EntryType.  Empty while the
+  // map is frozen.
   AddressToRangeMap map_;
+
+  // The contents of map_, in the same order, while the map is frozen.
+  FrozenRangeMap frozen_map_;
+  bool frozen_;
 };
 
 
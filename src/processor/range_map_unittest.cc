@@ -181,6 +181,19 @@ static bool RetrieveTest(TestMap* range_map, const RangeTest* range_test) {
 
       bool observed_result = retrieved && object->id() == range_test->id;
 
+      // The overload that doesn't copy the entry must find the same one.
+      const linked_ptr<CountedObject>* stored_object;
+      if (range_map->RetrieveRange(address, &stored_object, NULL, NULL,
+                                   NULL) != retrieved ||
+          (retrieved && stored_object->get() != object.get())) {
+        fprintf(stderr, "FAILED: "
+                        "RetrieveRange by pointer id %d, side %d, offset %d\n",
+                        range_test->id,
+                        side,
+                        offset);
+        return false;
+      }
+
       if (observed_result != expected_result) {
         fprintf(stderr, "FAILED: "
                         "RetrieveRange id %d, side %d, offset %d, "
@@ -524,6 +537,27 @@ static bool RunTests() {
         return false;
     }
 
+    if (!RetrieveIndexTest(range_map.get(), range_test_set_index))
+      return false;
+
+    // Freezing the map must not change the result of any lookup.
+    range_map->Freeze();
+    if (range_map->GetCount() != stored_count) {
+      fprintf(stderr, "FAILED: frozen object count doesn't match GetCount, "
+              "expected %d, observed %" PRId64 "\n",
+              stored_count, range_map->GetCount());
+
+      return false;
+    }
+
+    for (unsigned int range_test_index = 0;
+         range_test_index < range_test_count;
+         ++range_test_index) {
+      const RangeTest* range_test = &range_tests[range_test_index];
+      if (!RetrieveTest(range_map.get(), range_test))
+        return false;
+    }
+
     if (!RetrieveIndexTest(range_map.get(), range_test_set_index))
       return false;
 
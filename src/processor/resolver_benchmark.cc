@@ -0,0 +1,441 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// resolver_benchmark.cc: Compare how BasicSourceLineResolver and
+// FastSourceLineResolver load a symbol file and answer lookups in it.
+//
+// Given no symbol file, the benchmark generates one of a chosen shape, so
+// that runs are comparable from machine to machine and from change to
+// change.  For each resolver it measures:
+//
+//   load       the best time to load the module, out of the -r runs
+//   rss        the growth of the resident set from loading the module,
+//              which counts the serialized data the fast resolver keeps
+//   fill       FillSourceLineInfo, per lookup
+//   cfi        FindCFIFrameInfo, per lookup
+//
+// Lookups are made at addresses spread uniformly over the functions
+// ("random"), and at addresses within a few functions ("clustered"), as a
+// stack walk of a busy thread makes them.  The results are printed one per
+// line as tab-separated resolver, metric, value and unit, so that they can
+// be collected and compared across runs.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <malloc.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/fast_source_line_resolver.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "google_breakpad/processor/symbol_buffer.h"
+#include "processor/basic_code_module.h"
+#include "processor/cfi_frame_info.h"
+#include "processor/module_serializer.h"
+
+namespace {
+
+using google_breakpad::BasicCodeModule;
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::CFIFrameInfo;
+using google_breakpad::FastSourceLineResolver;
+using google_breakpad::ModuleSerializer;
+using google_breakpad::SourceLineResolverInterface;
+using google_breakpad::StackFrame;
+using google_breakpad::SymbolBuffer;
+using std::vector;
+
+// The shape of a synthetic symbol file.
+struct SyntheticShape {
+  SyntheticShape()
+      : functions(100000), lines(8), inlines(2), cfi_rows(4) {}
+
+  int functions;
+  int lines;     // LINE records per function
+  int inlines;   // INLINE records per function
+  int cfi_rows;  // STACK CFI records per function, after its STACK CFI INIT
+};
+
+// The size of each synthetic function.
+const uint64_t kFunctionSize = 0x100;
+
+// The number of FILE and INLINE_ORIGIN records in a synthetic symbol file.
+const int kFiles = 500;
+const int kInlineOrigins = 500;
+
+// Clustered lookups are made within this many functions.
+const int kHotFunctions = 16;
+
+string MakeSymbolData(const SyntheticShape& shape) {
+  string data = "MODULE Linux x86_64 000000000000000000000000000000000 "
+                "synthetic\n";
+  char record[256];
+  for (int i = 0; i < kFiles; ++i) {
+    snprintf(record, sizeof(record), "FILE %d src/synthetic/file%d.cc\n", i,
+             i);
+    data += record;
+  }
+  for (int i = 0; i < kInlineOrigins; ++i) {
+    snprintf(record, sizeof(record),
+             "INLINE_ORIGIN %d synthetic::Inline%d()\n", i, i);
+    data += record;
+  }
+
+  int lines = std::max(shape.lines, 1);
+  uint64_t line_size = kFunctionSize / lines;
+  // Each INLINE record is nested in the one before it.
+  int inlines = std::max(shape.inlines, 0);
+  uint64_t inline_step = kFunctionSize / (2 * (inlines + 1));
+  int cfi_rows = std::max(shape.cfi_rows, 0);
+  uint64_t cfi_step = kFunctionSize / (cfi_rows + 1);
+  for (int f = 0; f < shape.functions; ++f) {
+    uint64_t address = 0x1000 + f * kFunctionSize;
+    snprintf(record, sizeof(record),
+             "FUNC %llx %llx 0 synthetic::Function%d(int)\n",
+             static_cast<unsigned long long>(address),
+             static_cast<unsigned long long>(kFunctionSize), f);
+    data += record;
+    for (int i = 0; i < inlines; ++i) {
+      uint64_t margin = (i + 1) * inline_step;
+      snprintf(record, sizeof(record), "INLINE %d %d %d %d %llx %llx\n", i,
+               10 + i, f % kFiles, (f + i) % kInlineOrigins,
+               static_cast<unsigned long long>(address + margin),
+               static_cast<unsigned long long>(kFunctionSize - 2 * margin));
+      data += record;
+    }
+    for (int i = 0; i < lines; ++i) {
+      snprintf(record, sizeof(record), "%llx %llx %d %d\n",
+               static_cast<unsigned long long>(address + i * line_size),
+               static_cast<unsigned long long>(line_size), 100 + i,
+               f % kFiles);
+      data += record;
+    }
+  }
+  for (int f = 0; f < shape.functions; ++f) {
+    uint64_t address = 0x1000 + f * kFunctionSize;
+    snprintf(record, sizeof(record),
+             "STACK CFI INIT %llx %llx .cfa: $rsp 8 + .ra: .cfa -8 + ^\n",
+             static_cast<unsigned long long>(address),
+             static_cast<unsigned long long>(kFunctionSize));
+    data += record;
+    for (int i = 1; i <= cfi_rows; ++i) {
+      snprintf(record, sizeof(record),
+               "STACK CFI %llx .cfa: $rsp %d + $rbp: .cfa -16 + ^\n",
+               static_cast<unsigned long long>(address + i * cfi_step),
+               8 + 8 * i);
+      data += record;
+    }
+  }
+  return data;
+}
+
+// The address range of a FUNC record.
+struct Range {
+  uint64_t address;
+  uint64_t size;
+};
+
+// Collects the ranges of data's FUNC records.
+vector<Range> FunctionRanges(const string& data) {
+  vector<Range> ranges;
+  size_t position = 0;
+  while (position < data.size()) {
+    size_t end = data.find('\n', position);
+    if (end == string::npos)
+      end = data.size();
+    if (data.compare(position, 5, "FUNC ") == 0) {
+      const char* fields = data.c_str() + position + 5;
+      if (fields[0] == 'm' && fields[1] == ' ')
+        fields += 2;
+      char* size_field;
+      Range range;
+      range.address = strtoull(fields, &size_field, 16);
+      range.size = strtoull(size_field, NULL, 16);
+      if (range.size)
+        ranges.push_back(range);
+    }
+    position = end + 1;
+  }
+  return ranges;
+}
+
+// Returns count addresses in functions chosen by random from ranges, or
+// from kHotFunctions of them if clustered is true.
+vector<uint64_t> LookupAddresses(const vector<Range>& ranges, size_t count,
+                                 bool clustered) {
+  std::mt19937_64 random(clustered ? 2 : 1);
+  vector<Range> candidates;
+  if (clustered) {
+    for (int i = 0; i < kHotFunctions; ++i)
+      candidates.push_back(ranges[random() % ranges.size()]);
+  }
+  const vector<Range>& from = clustered ? candidates : ranges;
+  vector<uint64_t> addresses(count);
+  for (size_t i = 0; i < count; ++i) {
+    const Range& range = from[random() % from.size()];
+    addresses[i] = range.address + random() % range.size;
+  }
+  return addresses;
+}
+
+// The resident set size of this process, in bytes, after returning the
+// memory the allocator holds free to the system.
+long ResidentBytes() {
+#ifdef __GLIBC__
+  malloc_trim(0);
+#endif
+  long pages = 0;
+  long resident = 0;
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (statm) {
+    if (fscanf(statm, "%ld %ld", &pages, &resident) != 2)
+      resident = 0;
+    fclose(statm);
+  }
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start).count();
+}
+
+void PrintResult(const char* resolver, const char* metric, double value,
+                 const char* unit) {
+  // Counts are printed in full, times to six significant digits.
+  if (value == static_cast<double>(static_cast<int64_t>(value)))
+    printf("%s\t%s\t%lld\t%s\n", resolver, metric,
+           static_cast<long long>(value), unit);
+  else
+    printf("%s\t%s\t%.6g\t%s\n", resolver, metric, value, unit);
+}
+
+// Times FillSourceLineInfo and FindCFIFrameInfo at addresses, and prints
+// the mean time of each, per lookup.
+void TimeLookups(const char* name, SourceLineResolverInterface* resolver,
+                 const BasicCodeModule& module,
+                 const vector<uint64_t>& addresses, const char* distribution) {
+  std::deque<std::unique_ptr<StackFrame>> inlined_frames;
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t address : addresses) {
+    StackFrame frame;
+    frame.instruction = address;
+    frame.module = &module;
+    resolver->FillSourceLineInfo(&frame, &inlined_frames);
+    inlined_frames.clear();
+  }
+  double seconds = Seconds(start);
+  string metric = string("fill_") + distribution;
+  PrintResult(name, metric.c_str(), seconds * 1e9 / addresses.size(), "ns");
+
+  start = std::chrono::steady_clock::now();
+  for (uint64_t address : addresses) {
+    StackFrame frame;
+    frame.instruction = address;
+    frame.module = &module;
+    delete resolver->FindCFIFrameInfo(&frame);
+  }
+  seconds = Seconds(start);
+  metric = string("cfi_") + distribution;
+  PrintResult(name, metric.c_str(), seconds * 1e9 / addresses.size(), "ns");
+}
+
+// Makes the buffer a resolver loads the module from.
+typedef std::shared_ptr<SymbolBuffer> (*MakeBuffer)(const string& data);
+
+std::shared_ptr<SymbolBuffer> TextBuffer(const string& data) {
+  string copy = data;
+  return SymbolBuffer::AdoptString(&copy);
+}
+
+std::shared_ptr<SymbolBuffer> SerializedBuffer(const string& data) {
+  ModuleSerializer serializer;
+  size_t size = 0;
+  char* serialized = serializer.SerializeSymbolFileData(data, &size);
+  return serialized ? SymbolBuffer::AdoptArray(serialized, size) : NULL;
+}
+
+// Loads data into a new Resolver repeat times, printing the best load time
+// and the memory the module takes, then times lookups in the last one.
+template<typename Resolver>
+bool Benchmark(const char* name, const string& data, MakeBuffer make_buffer,
+               const BasicCodeModule& module, int repeat,
+               const vector<uint64_t>& random_addresses,
+               const vector<uint64_t>& clustered_addresses) {
+  double best = -1;
+  long rss = 0;
+  std::unique_ptr<Resolver> resolver;
+  for (int i = 0; i < repeat; ++i) {
+    resolver.reset();
+    long rss_before = ResidentBytes();
+    std::shared_ptr<SymbolBuffer> buffer = make_buffer(data);
+    if (!buffer) {
+      fprintf(stderr, "%s: can't prepare the symbol data\n", name);
+      return false;
+    }
+    resolver.reset(new Resolver());
+    auto start = std::chrono::steady_clock::now();
+    bool loaded = resolver->LoadModuleUsingSymbolBuffer(&module, buffer);
+    double seconds = Seconds(start);
+    if (!loaded) {
+      fprintf(stderr, "%s: can't load the symbol data\n", name);
+      return false;
+    }
+    buffer.reset();
+    rss = ResidentBytes() - rss_before;
+    if (best < 0 || seconds < best)
+      best = seconds;
+  }
+  PrintResult(name, "load", best, "s");
+  PrintResult(name, "rss", rss, "bytes");
+  TimeLookups(name, resolver.get(), module, random_addresses, "random");
+  TimeLookups(name, resolver.get(), module, clustered_addresses, "clustered");
+  return true;
+}
+
+void Usage(const char* program) {
+  fprintf(stderr,
+          "Usage: %s [OPTION]... [symbol-file]\n"
+          "Compare loading |symbol-file|, or a synthetic symbol file, and\n"
+          "looking up addresses in it with BasicSourceLineResolver and\n"
+          "FastSourceLineResolver.\n\n"
+          "Options:\n"
+          "  -f <N>      Functions in the synthetic symbol file\n"
+          "  -l <N>      LINE records per function\n"
+          "  -i <N>      INLINE records per function\n"
+          "  -c <N>      STACK CFI records per function\n"
+          "  -o <file>   Keep the synthetic symbol file in <file>\n"
+          "  -n <N>      Lookups of each kind (default 1000000)\n"
+          "  -r <N>      Take the best of N loads\n",
+          program);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  SyntheticShape shape;
+  string output_path;
+  size_t lookups = 1000000;
+  int repeat = 1;
+  int opt;
+  while ((opt = getopt(argc, argv, "f:l:i:c:o:n:r:h")) != -1) {
+    switch (opt) {
+      case 'f':
+        shape.functions = atoi(optarg);
+        break;
+      case 'l':
+        shape.lines = atoi(optarg);
+        break;
+      case 'i':
+        shape.inlines = atoi(optarg);
+        break;
+      case 'c':
+        shape.cfi_rows = atoi(optarg);
+        break;
+      case 'o':
+        output_path = optarg;
+        break;
+      case 'n':
+        lookups = strtoul(optarg, NULL, 10);
+        break;
+      case 'r':
+        repeat = atoi(optarg);
+        break;
+      default:
+        Usage(argv[0]);
+        return 1;
+    }
+  }
+  if (optind + 1 < argc || shape.functions < 1 || lookups < 1 ||
+      repeat < 1) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  string data;
+  if (optind < argc) {
+    std::ifstream in(argv[optind], std::ios::binary);
+    if (!in) {
+      fprintf(stderr, "%s: can't read\n", argv[optind]);
+      return 1;
+    }
+    data.assign(std::istreambuf_iterator<char>(in),
+                std::istreambuf_iterator<char>());
+  } else {
+    data = MakeSymbolData(shape);
+    if (!output_path.empty()) {
+      std::ofstream out(output_path.c_str(), std::ios::binary);
+      out << data;
+      if (!out) {
+        fprintf(stderr, "%s: write failed\n", output_path.c_str());
+        return 1;
+      }
+    }
+  }
+
+  vector<Range> ranges = FunctionRanges(data);
+  if (ranges.empty()) {
+    fprintf(stderr, "The symbol file has no functions\n");
+    return 1;
+  }
+  uint64_t end = 0;
+  for (const Range& range : ranges)
+    end = std::max(end, range.address + range.size);
+  BasicCodeModule module(0, end, "benchmark", "", "benchmark", "", "");
+  vector<uint64_t> random_addresses = LookupAddresses(ranges, lookups, false);
+  vector<uint64_t> clustered_addresses =
+      LookupAddresses(ranges, lookups, true);
+
+  PrintResult("input", "symbol_data", data.size(), "bytes");
+  PrintResult("input", "functions", ranges.size(), "count");
+  if (!Benchmark<BasicSourceLineResolver>(
+          "basic", data, TextBuffer, module, repeat, random_addresses,
+          clustered_addresses) ||
+      !Benchmark<FastSourceLineResolver>(
+          "fast", data, SerializedBuffer, module, repeat, random_addresses,
+          clustered_addresses)) {
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,629 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// resolver_diff.cc: Check that the ways of loading symbols agree with each
+// other, and compare what each costs, on a directory of real symbol files
+// and minidumps.
+//
+// Three paths are run side by side:
+//
+//   basic            BasicSourceLineResolver parsing on the loading thread,
+//                    which the others are checked against
+//   basic_parallel   BasicSourceLineResolver parsing on -j threads
+//   fast             FastSourceLineResolver, loading each symbol file as
+//                    ModuleSerializer serializes it
+//
+// For each symbol file (*.sym), ModuleComparer first checks the serialized
+// module against the parsed one record by record.  Then each path loads
+// the file, and FillSourceLineInfo, FindCFIFrameInfo and
+// FindWindowsFrameInfo are asked about addresses taken from its FUNC,
+// PUBLIC and STACK records: at most -n of them, spread evenly over the
+// file.  Every answer, inlined frames included, must match the basic
+// path's.
+//
+// For each minidump (*.dmp), MinidumpProcessor processes it once per path,
+// finding symbols under the symbol path, and the resulting ProcessStates
+// must match frame by frame.
+//
+// Timings and the growth of the resident set are printed one per line as
+// tab-separated path, input, metric, value and unit, like
+// resolver_benchmark's; differences are printed to stderr.  Exits with 1
+// if any answer differs.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <dirent.h>
+#include <malloc.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/scoped_ptr.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/fast_source_line_resolver.h"
+#include "google_breakpad/processor/minidump.h"
+#include "google_breakpad/processor/minidump_processor.h"
+#include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "google_breakpad/processor/symbol_buffer.h"
+#include "processor/basic_code_module.h"
+#include "processor/cfi_frame_info.h"
+#include "processor/module_comparer.h"
+#include "processor/module_serializer.h"
+#include "processor/simple_symbol_supplier.h"
+#include "processor/windows_frame_info.h"
+
+namespace {
+
+using google_breakpad::BasicCodeModule;
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::CallStack;
+using google_breakpad::CFIFrameInfo;
+using google_breakpad::CodeModule;
+using google_breakpad::FastSourceLineResolver;
+using google_breakpad::Minidump;
+using google_breakpad::MinidumpProcessor;
+using google_breakpad::ModuleComparer;
+using google_breakpad::ModuleSerializer;
+using google_breakpad::ProcessState;
+using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::SourceLineResolverInterface;
+using google_breakpad::StackFrame;
+using google_breakpad::SymbolBuffer;
+using google_breakpad::SystemInfo;
+using google_breakpad::WindowsFrameInfo;
+using std::vector;
+
+// The most differences printed per input, so that one systematic
+// difference doesn't bury the rest.
+const int kMaxReportedDifferences = 10;
+
+void Usage(const char* program_name) {
+  fprintf(stderr,
+          "usage: %s [-j threads] [-n lookups] [-s symbol-path] directory\n"
+          "\n"
+          "Loads each symbol file (*.sym) under directory with each\n"
+          "resolver and compares their answers at up to lookups addresses\n"
+          "(default 10000), and processes each minidump (*.dmp) under\n"
+          "directory with each resolver, finding symbols in symbol-path\n"
+          "(default directory), and compares the stacks.  basic_parallel\n"
+          "parses on threads threads (default 4).\n",
+          program_name);
+}
+
+// The resolvers being compared.
+enum Path {
+  PATH_BASIC,
+  PATH_BASIC_PARALLEL,
+  PATH_FAST,
+  PATH_COUNT
+};
+
+const char* const kPathNames[PATH_COUNT] = {
+  "basic",
+  "basic_parallel",
+  "fast"
+};
+
+SourceLineResolverInterface* MakeResolver(Path path, int threads) {
+  switch (path) {
+    case PATH_BASIC_PARALLEL: {
+      BasicSourceLineResolver* resolver = new BasicSourceLineResolver();
+      resolver->set_parse_concurrency(threads);
+      return resolver;
+    }
+    case PATH_FAST:
+      return new FastSourceLineResolver();
+    default:
+      return new BasicSourceLineResolver();
+  }
+}
+
+// Makes the buffer path's resolver loads data from, or returns NULL if
+// data can't be serialized.
+std::shared_ptr<SymbolBuffer> MakeBuffer(Path path, const string& data) {
+  if (path == PATH_FAST) {
+    ModuleSerializer serializer;
+    size_t size = 0;
+    char* serialized = serializer.SerializeSymbolFileData(data, &size);
+    return serialized ? SymbolBuffer::AdoptArray(serialized, size) : NULL;
+  }
+  string copy = data;
+  return SymbolBuffer::AdoptString(&copy);
+}
+
+// Supplies symbol files as ModuleSerializer serializes them, for
+// FastSourceLineResolver.  MinidumpProcessor only asks for symbols through
+// GetSymbolBuffer.
+class SerializingSymbolSupplier : public SimpleSymbolSupplier {
+ public:
+  explicit SerializingSymbolSupplier(const string& path)
+      : SimpleSymbolSupplier(path) {}
+
+  virtual SymbolResult GetSymbolBuffer(
+      const CodeModule* module,
+      const SystemInfo* system_info,
+      string* symbol_file,
+      std::shared_ptr<SymbolBuffer>* symbol_buffer) {
+    std::shared_ptr<SymbolBuffer> text;
+    SymbolResult result = SimpleSymbolSupplier::GetSymbolBuffer(
+        module, system_info, symbol_file, &text);
+    symbol_buffer->reset();
+    if (result != FOUND)
+      return result;
+    size_t size = text->size();
+    while (size > 0 && text->data()[size - 1] == '\0')
+      --size;
+    *symbol_buffer = MakeBuffer(PATH_FAST, string(text->data(), size));
+    if (text->borrowed())
+      FreeSymbolData(module);
+    return *symbol_buffer ? FOUND : INTERRUPT;
+  }
+};
+
+// The resident set size of this process, in bytes, after returning the
+// memory the allocator holds free to the system.
+long ResidentBytes() {
+#ifdef __GLIBC__
+  malloc_trim(0);
+#endif
+  long pages = 0;
+  long resident = 0;
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (statm) {
+    if (fscanf(statm, "%ld %ld", &pages, &resident) != 2)
+      resident = 0;
+    fclose(statm);
+  }
+  return resident * sysconf(_SC_PAGESIZE);
+}
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start).count();
+}
+
+void PrintResult(const char* path, const string& input, const char* metric,
+                 double value, const char* unit) {
+  // Counts are printed in full, times to six significant digits.
+  if (value == static_cast<double>(static_cast<int64_t>(value)))
+    printf("%s\t%s\t%s\t%lld\t%s\n", path, input.c_str(), metric,
+           static_cast<long long>(value), unit);
+  else
+    printf("%s\t%s\t%s\t%.6g\t%s\n", path, input.c_str(), metric, value,
+           unit);
+}
+
+// Collects the files under directory whose names end in suffix.
+void FindFiles(const string& directory, const char* suffix,
+               vector<string>* files) {
+  DIR* dir = opendir(directory.c_str());
+  if (!dir)
+    return;
+  size_t suffix_length = strlen(suffix);
+  while (struct dirent* entry = readdir(dir)) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      continue;
+    string path = directory + "/" + entry->d_name;
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+      continue;
+    size_t length = strlen(entry->d_name);
+    if (S_ISDIR(info.st_mode)) {
+      FindFiles(path, suffix, files);
+    } else if (length > suffix_length &&
+               strcmp(entry->d_name + length - suffix_length, suffix) == 0) {
+      files->push_back(path);
+    }
+  }
+  closedir(dir);
+}
+
+// Parses the hexadecimal field at position in line, advancing position
+// past it.  Returns false if there is none.
+bool HexField(const string& line, size_t* position, uint64_t* value) {
+  const char* start = line.c_str() + *position;
+  while (*start == ' ')
+    ++start;
+  char* end;
+  *value = strtoull(start, &end, 16);
+  if (end == start)
+    return false;
+  *position = end - line.c_str();
+  return true;
+}
+
+// Collects addresses worth looking up in a symbol file: the first, middle
+// and last byte of each function, and the byte before it; each public
+// symbol; and the start of each STACK record.  Also sets end to just past
+// the highest address seen.
+void LookupAddresses(const string& data, vector<uint64_t>* addresses,
+                     uint64_t* end) {
+  *end = 1;
+  size_t position = 0;
+  while (position < data.size()) {
+    size_t line_end = data.find('\n', position);
+    if (line_end == string::npos)
+      line_end = data.size();
+    string line = data.substr(position, line_end - position);
+    position = line_end + 1;
+
+    size_t field = 0;
+    bool has_size = true;
+    if (line.compare(0, 5, "FUNC ") == 0) {
+      field = line.compare(5, 2, "m ") == 0 ? 7 : 5;
+    } else if (line.compare(0, 7, "PUBLIC ") == 0) {
+      field = line.compare(7, 2, "m ") == 0 ? 9 : 7;
+      has_size = false;
+    } else if (line.compare(0, 15, "STACK CFI INIT ") == 0) {
+      field = 15;
+    } else if (line.compare(0, 10, "STACK CFI ") == 0) {
+      field = 10;
+      has_size = false;
+    } else if (line.compare(0, 10, "STACK WIN ") == 0) {
+      // The address follows the frame type.
+      field = 10;
+      uint64_t type;
+      if (!HexField(line, &field, &type))
+        continue;
+    } else {
+      continue;
+    }
+    uint64_t address;
+    uint64_t size = 1;
+    if (!HexField(line, &field, &address) ||
+        (has_size && !HexField(line, &field, &size))) {
+      continue;
+    }
+    if (size == 0)
+      size = 1;
+    addresses->push_back(address);
+    if (has_size && line[0] == 'F') {
+      if (address > 0)
+        addresses->push_back(address - 1);
+      addresses->push_back(address + size / 2);
+      addresses->push_back(address + size - 1);
+    }
+    *end = std::max(*end, address + size);
+  }
+  std::sort(addresses->begin(), addresses->end());
+  addresses->erase(std::unique(addresses->begin(), addresses->end()),
+                   addresses->end());
+}
+
+// Keeps count of addresses, spread evenly over them.
+void Sample(size_t count, vector<uint64_t>* addresses) {
+  if (addresses->size() <= count)
+    return;
+  vector<uint64_t> sample(count);
+  for (size_t i = 0; i < count; ++i)
+    sample[i] = (*addresses)[i * addresses->size() / count];
+  addresses->swap(sample);
+}
+
+// Describes what FillSourceLineInfo fills in for frame.
+string DescribeFrame(const StackFrame& frame) {
+  char base[64];
+  snprintf(base, sizeof(base), "%llx %llx %d",
+           static_cast<unsigned long long>(frame.function_base),
+           static_cast<unsigned long long>(frame.source_line_base),
+           frame.source_line);
+  return frame.function_name + " " + base + " " + frame.source_file_name;
+}
+
+// Describes everything resolver knows about address in module.
+string DescribeLookup(SourceLineResolverInterface* resolver,
+                      const CodeModule& module, uint64_t address) {
+  StackFrame frame;
+  frame.instruction = address;
+  frame.module = &module;
+  std::deque<std::unique_ptr<StackFrame>> inlined_frames;
+  resolver->FillSourceLineInfo(&frame, &inlined_frames);
+  string description = "frame: " + DescribeFrame(frame);
+  for (const std::unique_ptr<StackFrame>& inlined : inlined_frames)
+    description += "\ninlined: " + DescribeFrame(*inlined);
+
+  google_breakpad::scoped_ptr<CFIFrameInfo> cfi(
+      resolver->FindCFIFrameInfo(&frame));
+  if (cfi.get())
+    description += "\ncfi: " + cfi->Serialize();
+
+  google_breakpad::scoped_ptr<WindowsFrameInfo> windows(
+      resolver->FindWindowsFrameInfo(&frame));
+  if (windows.get()) {
+    char fields[256];
+    snprintf(fields, sizeof(fields),
+             "%d %x %x %x %x %x %x %x %d ", windows->type_, windows->valid,
+             windows->prolog_size, windows->epilog_size,
+             windows->parameter_size, windows->saved_register_size,
+             windows->local_size, windows->max_stack_size,
+             windows->allocates_base_pointer);
+    description += "\nwin: " + string(fields) + windows->program_string;
+  }
+  return description;
+}
+
+// Prints the first line at which expected and actual differ, if they do,
+// and returns whether they did.
+bool ReportDifference(const string& input, const char* path,
+                      const string& what, const string& expected,
+                      const string& actual, int* reported) {
+  if (expected == actual)
+    return false;
+  if (++*reported <= kMaxReportedDifferences) {
+    fprintf(stderr, "%s: %s differs at %s:\n  basic: %s\n  %s: %s\n",
+            input.c_str(), path, what.c_str(), expected.c_str(), path,
+            actual.c_str());
+  }
+  return true;
+}
+
+// Compares the paths on the symbol file at file_name.  Returns false if
+// they disagree.
+bool DiffSymbolFile(const string& file_name, int threads, size_t lookups) {
+  std::ifstream in(file_name.c_str(), std::ios::binary);
+  string data((std::istreambuf_iterator<char>(in)),
+              std::istreambuf_iterator<char>());
+  if (!in.eof() && !in) {
+    fprintf(stderr, "%s: can't read\n", file_name.c_str());
+    return false;
+  }
+
+  bool same = true;
+  if (!ModuleComparer().Compare(data)) {
+    fprintf(stderr, "%s: the serialized module differs from the parsed one\n",
+            file_name.c_str());
+    same = false;
+  }
+
+  vector<uint64_t> addresses;
+  uint64_t end;
+  LookupAddresses(data, &addresses, &end);
+  Sample(lookups, &addresses);
+  BasicCodeModule module(0, end, file_name, "", file_name, "", "");
+  PrintResult("input", file_name, "symbol_data", data.size(), "bytes");
+  PrintResult("input", file_name, "lookups", addresses.size(), "count");
+
+  vector<string> expected;
+  for (int p = 0; p < PATH_COUNT; ++p) {
+    Path path = static_cast<Path>(p);
+    const char* name = kPathNames[p];
+    long rss_before = ResidentBytes();
+    std::shared_ptr<SymbolBuffer> buffer = MakeBuffer(path, data);
+    if (!buffer) {
+      fprintf(stderr, "%s: %s can't prepare the symbol data\n",
+              file_name.c_str(), name);
+      same = false;
+      continue;
+    }
+    std::unique_ptr<SourceLineResolverInterface> resolver(
+        MakeResolver(path, threads));
+    auto start = std::chrono::steady_clock::now();
+    bool loaded = resolver->LoadModuleUsingSymbolBuffer(&module, buffer);
+    double load_seconds = Seconds(start);
+    buffer.reset();
+    long rss = ResidentBytes() - rss_before;
+    if (!loaded) {
+      fprintf(stderr, "%s: %s can't load the symbol data\n",
+              file_name.c_str(), name);
+      same = false;
+      continue;
+    }
+
+    vector<string> answers(addresses.size());
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < addresses.size(); ++i)
+      answers[i] = DescribeLookup(resolver.get(), module, addresses[i]);
+    double lookup_seconds = Seconds(start);
+
+    PrintResult(name, file_name, "load", load_seconds, "s");
+    PrintResult(name, file_name, "rss", rss, "bytes");
+    if (!addresses.empty()) {
+      PrintResult(name, file_name, "lookup",
+                  lookup_seconds * 1e9 / addresses.size(), "ns");
+    }
+
+    if (path == PATH_BASIC) {
+      expected.swap(answers);
+      continue;
+    }
+    if (expected.size() != answers.size())
+      continue;
+    int reported = 0;
+    for (size_t i = 0; i < answers.size(); ++i) {
+      char what[32];
+      snprintf(what, sizeof(what), "0x%llx",
+               static_cast<unsigned long long>(addresses[i]));
+      if (ReportDifference(file_name, name, what, expected[i], answers[i],
+                           &reported)) {
+        same = false;
+      }
+    }
+  }
+  return same;
+}
+
+// Describes state one line per thread and frame, with what a frame's
+// symbols contribute to it.
+vector<string> DescribeProcessState(const ProcessState& state) {
+  vector<string> lines;
+  char line[256];
+  snprintf(line, sizeof(line), "requesting thread %d, %zu threads",
+           state.requesting_thread(), state.threads()->size());
+  lines.push_back("crash: " + state.crash_reason() + ", " + line);
+  for (size_t t = 0; t < state.threads()->size(); ++t) {
+    const CallStack* stack = (*state.threads())[t];
+    snprintf(line, sizeof(line), "thread %zu: %zu frames", t,
+             stack->frames()->size());
+    lines.push_back(line);
+    for (size_t f = 0; f < stack->frames()->size(); ++f) {
+      const StackFrame* frame = (*stack->frames())[f];
+      snprintf(line, sizeof(line), "thread %zu frame %zu: %llx %d ", t, f,
+               static_cast<unsigned long long>(frame->instruction),
+               frame->trust);
+      lines.push_back(line +
+                      (frame->module ? frame->module->code_file() : "") +
+                      " " + DescribeFrame(*frame));
+    }
+  }
+  return lines;
+}
+
+// Compares the paths on the minidump at file_name.  Returns false if they
+// disagree.
+bool DiffMinidump(const string& file_name, const string& symbol_path,
+                  int threads) {
+  Minidump dump(file_name);
+  if (!dump.Read()) {
+    // Such as a microdump, which is also named *.dmp.
+    fprintf(stderr, "%s: not a minidump, skipped\n", file_name.c_str());
+    return true;
+  }
+
+  bool same = true;
+  vector<string> expected;
+  for (int p = 0; p < PATH_COUNT; ++p) {
+    Path path = static_cast<Path>(p);
+    const char* name = kPathNames[p];
+    long rss_before = ResidentBytes();
+    std::unique_ptr<SimpleSymbolSupplier> supplier(
+        path == PATH_FAST ? new SerializingSymbolSupplier(symbol_path)
+                          : new SimpleSymbolSupplier(symbol_path));
+    std::unique_ptr<SourceLineResolverInterface> resolver(
+        MakeResolver(path, threads));
+    MinidumpProcessor processor(supplier.get(), resolver.get());
+    ProcessState state;
+    auto start = std::chrono::steady_clock::now();
+    bool processed =
+        processor.Process(&dump, &state) == google_breakpad::PROCESS_OK;
+    double seconds = Seconds(start);
+    long rss = ResidentBytes() - rss_before;
+    if (!processed) {
+      // testdata holds minidumps that can't be processed on purpose;
+      // all that matters is that every path agrees.
+      if (path == PATH_BASIC)
+        expected.clear();
+      else if (!expected.empty())
+        same = false;
+      fprintf(stderr, "%s: %s can't process\n", file_name.c_str(), name);
+      continue;
+    }
+
+    PrintResult(name, file_name, "process", seconds, "s");
+    PrintResult(name, file_name, "rss", rss, "bytes");
+    vector<string> lines = DescribeProcessState(state);
+    if (path == PATH_BASIC) {
+      expected.swap(lines);
+      continue;
+    }
+    int reported = 0;
+    for (size_t i = 0; i < std::max(expected.size(), lines.size()); ++i) {
+      if (ReportDifference(file_name, name, "line " + std::to_string(i + 1),
+                           i < expected.size() ? expected[i] : "",
+                           i < lines.size() ? lines[i] : "", &reported)) {
+        same = false;
+      }
+    }
+  }
+  return same;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int threads = 4;
+  size_t lookups = 10000;
+  string symbol_path;
+  int ch;
+  while ((ch = getopt(argc, argv, "hj:n:s:")) != -1) {
+    switch (ch) {
+      case 'j':
+        threads = atoi(optarg);
+        break;
+      case 'n':
+        lookups = strtoul(optarg, NULL, 10);
+        break;
+      case 's':
+        symbol_path = optarg;
+        break;
+      case 'h':
+      default:
+        Usage(argv[0]);
+        return ch == 'h' ? 0 : 1;
+    }
+  }
+  if (threads < 1 || optind != argc - 1) {
+    Usage(argv[0]);
+    return 1;
+  }
+  string directory = argv[optind];
+  if (symbol_path.empty())
+    symbol_path = directory;
+
+  vector<string> symbol_files;
+  vector<string> minidumps;
+  FindFiles(directory, ".sym", &symbol_files);
+  FindFiles(directory, ".dmp", &minidumps);
+  std::sort(symbol_files.begin(), symbol_files.end());
+  std::sort(minidumps.begin(), minidumps.end());
+  if (symbol_files.empty() && minidumps.empty()) {
+    fprintf(stderr, "No symbol files or minidumps under %s\n",
+            directory.c_str());
+    return 1;
+  }
+
+  int differing = 0;
+  for (const string& file_name : symbol_files) {
+    if (!DiffSymbolFile(file_name, threads, lookups))
+      ++differing;
+  }
+  for (const string& file_name : minidumps) {
+    if (!DiffMinidump(file_name, symbol_path, threads))
+      ++differing;
+  }
+  fprintf(stderr, "%zu inputs, %d differing\n",
+          symbol_files.size() + minidumps.size(), differing);
+  return differing ? 1 : 0;
+}
@@ -0,0 +1,345 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// shared_symbol_cache_supplier.cc: A SymbolSupplier that shares modules
+// serialized for FastSourceLineResolver between processes.
+//
+// See shared_symbol_cache_supplier.h for documentation.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "processor/shared_symbol_cache_supplier.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/fast_source_line_resolver.h"
+#include "processor/logging.h"
+#include "processor/module_serializer.h"
+#include "processor/pathname_stripper.h"
+
+namespace google_breakpad {
+
+namespace {
+
+// Appended to the path of a cache file to name its lock file.
+const char kLockFileExtension[] = ".lock";
+
+// Holds an exclusive flock() on a lock file, which is deleted before the
+// lock is released: a process that was waiting on it checks the cache again
+// anyway, and the next process to need the lock creates a new file.
+class ScopedLockFile {
+ public:
+  explicit ScopedLockFile(const string& path) : path_(path), fd_(-1) {
+    fd_ = open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ == -1) {
+      BPLOG(ERROR) << "Could not create " << path_ << ": " << strerror(errno);
+      return;
+    }
+    while (flock(fd_, LOCK_EX) != 0) {
+      if (errno != EINTR) {
+        BPLOG(ERROR) << "Could not lock " << path_ << ": " << strerror(errno);
+        break;
+      }
+    }
+  }
+
+  ~ScopedLockFile() {
+    if (fd_ != -1) {
+      unlink(path_.c_str());
+      close(fd_);
+    }
+  }
+
+ private:
+  string path_;
+  int fd_;
+};
+
+}  // namespace
+
+SharedSymbolCacheSupplier::SharedSymbolCacheSupplier(SymbolSupplier* supplier,
+                                                     const string& directory)
+    : supplier_(supplier), directory_(directory), max_cache_size_(0) {
+  if (mkdir(directory_.c_str(), 0755) != 0 && errno != EEXIST) {
+    BPLOG(ERROR) << "Could not create directory " << directory_ << ": "
+                 << strerror(errno);
+  }
+}
+
+bool SharedSymbolCacheSupplier::GetCachePath(const CodeModule* module,
+                                             string* path) const {
+  if (!module)
+    return false;
+  string debug_file_name = PathnameStripper::File(module->debug_file());
+  string debug_identifier = module->debug_identifier();
+  if (debug_file_name.empty() || debug_file_name == "." ||
+      debug_file_name == ".." || debug_identifier.empty() ||
+      debug_identifier.find('/') != string::npos) {
+    return false;
+  }
+  *path = directory_ + "/" + debug_file_name + "." + debug_identifier +
+          kSerializedBreakpadFileExtension;
+  return true;
+}
+
+SymbolSupplier::SymbolResult SharedSymbolCacheSupplier::GetSymbolFile(
+    const CodeModule* module,
+    const SystemInfo* system_info,
+    string* symbol_file) {
+  std::shared_ptr<SymbolBuffer> symbol_buffer;
+  return GetSymbolBuffer(module, system_info, symbol_file, &symbol_buffer);
+}
+
+SymbolSupplier::SymbolResult SharedSymbolCacheSupplier::GetSymbolFile(
+    const CodeModule* module,
+    const SystemInfo* system_info,
+    string* symbol_file,
+    string* symbol_data) {
+  std::shared_ptr<SymbolBuffer> symbol_buffer;
+  SymbolResult result =
+      GetSymbolBuffer(module, system_info, symbol_file, &symbol_buffer);
+  if (symbol_data) {
+    symbol_data->clear();
+    if (result == FOUND)
+      symbol_data->assign(symbol_buffer->data(), symbol_buffer->size());
+  }
+  return result;
+}
+
+SymbolSupplier::SymbolResult SharedSymbolCacheSupplier::GetCStringSymbolData(
+    const CodeModule* module,
+    const SystemInfo* system_info,
+    string* symbol_file,
+    char** symbol_data,
+    size_t* symbol_data_size) {
+  std::shared_ptr<SymbolBuffer> symbol_buffer;
+  SymbolResult result =
+      GetSymbolBuffer(module, system_info, symbol_file, &symbol_buffer);
+  if (result != FOUND)
+    return result;
+
+  *symbol_data = symbol_buffer->data();
+  *symbol_data_size = symbol_buffer->size();
+  std::lock_guard<std::mutex> lock(buffers_lock_);
+  buffers_[module->code_file()] = symbol_buffer;
+  return result;
+}
+
+void SharedSymbolCacheSupplier::FreeSymbolData(const CodeModule* module) {
+  if (!module)
+    return;
+
+  // Data that supplier_ lends is passed on as it is, and freed by it.
+  bool borrowed = true;
+  {
+    std::lock_guard<std::mutex> lock(buffers_lock_);
+    auto buffer = buffers_.find(module->code_file());
+    if (buffer != buffers_.end()) {
+      borrowed = buffer->second->borrowed();
+      buffers_.erase(buffer);
+    }
+  }
+  if (borrowed)
+    supplier_->FreeSymbolData(module);
+}
+
+SymbolSupplier::SymbolResult SharedSymbolCacheSupplier::GetSymbolBuffer(
+    const CodeModule* module,
+    const SystemInfo* system_info,
+    string* symbol_file,
+    std::shared_ptr<SymbolBuffer>* symbol_buffer) {
+  symbol_buffer->reset();
+  string path;
+  if (!GetCachePath(module, &path)) {
+    return supplier_->GetSymbolBuffer(module, system_info, symbol_file,
+                                      symbol_buffer);
+  }
+
+  if (MapCacheFile(path, symbol_buffer)) {
+    *symbol_file = path;
+    return FOUND;
+  }
+
+  // Serialize the module under its lock, unless whoever held the lock
+  // before did.
+  ScopedLockFile lock(path + kLockFileExtension);
+  if (MapCacheFile(path, symbol_buffer)) {
+    *symbol_file = path;
+    return FOUND;
+  }
+  return AddCacheFile(module, system_info, path, symbol_file, symbol_buffer);
+}
+
+SymbolSupplier::SymbolResult SharedSymbolCacheSupplier::AddCacheFile(
+    const CodeModule* module,
+    const SystemInfo* system_info,
+    const string& path,
+    string* symbol_file,
+    std::shared_ptr<SymbolBuffer>* symbol_buffer) {
+  std::shared_ptr<SymbolBuffer> symbol_data;
+  SymbolResult result =
+      supplier_->GetSymbolBuffer(module, system_info, symbol_file,
+                                 &symbol_data);
+  if (result != FOUND || !symbol_data || symbol_data->size() == 0 ||
+      ModuleSerializer::IsSerializedData(symbol_data->data(),
+                                         symbol_data->size())) {
+    *symbol_buffer = symbol_data;
+    return result;
+  }
+
+  // The text is parsed in place, which clobbers it; it isn't needed again.
+  ModuleSerializer serializer;
+  size_t serialized_size = 0;
+  char* serialized = serializer.SerializeSymbolFileData(
+      symbol_data->data(), symbol_data->size(), &serialized_size);
+  if (symbol_data->borrowed())
+    supplier_->FreeSymbolData(module);
+  symbol_data.reset();
+  if (!serialized) {
+    BPLOG(ERROR) << "Could not serialize symbols from " << *symbol_file;
+    return NOT_FOUND;
+  }
+
+  std::shared_ptr<SymbolBuffer> unshared =
+      SymbolBuffer::AdoptArray(serialized, serialized_size);
+  if (!WriteCacheFile(path, serialized, serialized_size) ||
+      !MapCacheFile(path, symbol_buffer)) {
+    *symbol_buffer = unshared;
+    return FOUND;
+  }
+  BPLOG(INFO) << "Serialized " << *symbol_file << " into " << path;
+  *symbol_file = path;
+  EvictCacheFiles(path);
+  return FOUND;
+}
+
+bool SharedSymbolCacheSupplier::MapCacheFile(
+    const string& path,
+    std::shared_ptr<SymbolBuffer>* symbol_buffer) {
+  *symbol_buffer = SymbolBuffer::MapFile(path);
+  if (!*symbol_buffer)
+    return false;
+
+  // The access time orders files for eviction.
+  struct timespec times[2];
+  times[0].tv_sec = 0;
+  times[0].tv_nsec = UTIME_NOW;
+  times[1].tv_sec = 0;
+  times[1].tv_nsec = UTIME_OMIT;
+  utimensat(AT_FDCWD, path.c_str(), times, 0);
+  return true;
+}
+
+bool SharedSymbolCacheSupplier::WriteCacheFile(const string& path,
+                                               const char* data,
+                                               size_t size) {
+  // Write to a temporary file renamed into place, so that no process maps
+  // a partially written file.
+  string temp_path = path + ".XXXXXX";
+  int fd = mkstemp(&temp_path[0]);
+  if (fd == -1) {
+    BPLOG(ERROR) << "Could not create " << temp_path << ": "
+                 << strerror(errno);
+    return false;
+  }
+  bool written = fchmod(fd, 0644) == 0;
+  for (size_t offset = 0; written && offset < size; ) {
+    ssize_t count = write(fd, data + offset, size - offset);
+    if (count < 0 && errno == EINTR)
+      continue;
+    written = count > 0;
+    if (written)
+      offset += count;
+  }
+  if (close(fd) != 0)
+    written = false;
+  if (!written || rename(temp_path.c_str(), path.c_str()) != 0) {
+    BPLOG(ERROR) << "Could not write " << path << ": " << strerror(errno);
+    unlink(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+void SharedSymbolCacheSupplier::EvictCacheFiles(const string& keep_path) {
+  if (max_cache_size_ == 0)
+    return;
+
+  // Other processes add files too, so the directory is the only record of
+  // what the cache holds.
+  DIR* dir = opendir(directory_.c_str());
+  if (!dir)
+    return;
+  std::vector<std::pair<time_t, string>> files;
+  uint64_t cache_size = 0;
+  size_t extension_size = strlen(kSerializedBreakpadFileExtension);
+  while (dirent* entry = readdir(dir)) {
+    size_t length = strlen(entry->d_name);
+    if (length <= extension_size ||
+        strcmp(entry->d_name + length - extension_size,
+               kSerializedBreakpadFileExtension) != 0) {
+      continue;
+    }
+    string path = directory_ + "/" + entry->d_name;
+    struct stat file_stat;
+    if (stat(path.c_str(), &file_stat) != 0)
+      continue;
+    cache_size += file_stat.st_size;
+    if (path != keep_path)
+      files.push_back(std::make_pair(file_stat.st_atime, path));
+  }
+  closedir(dir);
+
+  std::sort(files.begin(), files.end());
+  for (size_t i = 0; i < files.size() && cache_size > max_cache_size_; ++i) {
+    struct stat file_stat;
+    if (stat(files[i].second.c_str(), &file_stat) != 0 ||
+        unlink(files[i].second.c_str()) != 0) {
+      continue;
+    }
+    BPLOG(INFO) << "Evicted " << files[i].second << " from the cache";
+    cache_size -= std::min<uint64_t>(cache_size, file_stat.st_size);
+  }
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,148 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// shared_symbol_cache_supplier.h: A SymbolSupplier that shares modules
+// serialized for FastSourceLineResolver between processes.
+//
+// Stack walkers that run as many processes on a host each parse and hold
+// the symbols of the same popular modules.  SharedSymbolCacheSupplier wraps
+// the supplier that finds their text symbol files, and keeps each module
+// serialized with ModuleSerializer in a directory shared by the processes,
+// named for the module's debug file and identifier:
+//
+//   <directory>/libc.so.6.F4F8DFCD5A5FB5A7CE64717E9E6AE3890.fast.v2
+//
+// The first process to need a module serializes it there, and every
+// process, including the first, maps the file.  A FastSourceLineResolver
+// uses a mapping in place, so on a memory-backed file system such as
+// /dev/shm the host holds each module once, however many processes use it.
+//
+// Files are written to a temporary name and renamed into place.  While one
+// process serializes a module, others wanting the same module wait on a
+// lock file next to it instead of serializing it too.  The lock is an
+// flock(), so it is released if its holder dies.  If a maximum cache size
+// is set, the least recently used files are deleted once the cache grows
+// beyond it.  A process that has a deleted file mapped keeps using it, and
+// its memory is freed once the last mapping goes away.
+
+#ifndef PROCESSOR_SHARED_SYMBOL_CACHE_SUPPLIER_H__
+#define PROCESSOR_SHARED_SYMBOL_CACHE_SUPPLIER_H__
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/symbol_supplier.h"
+
+namespace google_breakpad {
+
+class SharedSymbolCacheSupplier : public SymbolSupplier {
+ public:
+  // Creates a SharedSymbolCacheSupplier that gets symbol files from
+  // supplier and keeps them serialized in directory, which is created if
+  // needed.  supplier must outlive this.
+  SharedSymbolCacheSupplier(SymbolSupplier* supplier,
+                            const string& directory);
+
+  virtual ~SharedSymbolCacheSupplier() {}
+
+  // symbol_file is set to the path of the serialized module in the cache,
+  // or to the path supplier gave if the module could not be cached.
+  virtual SymbolResult GetSymbolFile(const CodeModule* module,
+                                     const SystemInfo* system_info,
+                                     string* symbol_file);
+  virtual SymbolResult GetSymbolFile(const CodeModule* module,
+                                     const SystemInfo* system_info,
+                                     string* symbol_file,
+                                     string* symbol_data);
+  virtual SymbolResult GetCStringSymbolData(const CodeModule* module,
+                                            const SystemInfo* system_info,
+                                            string* symbol_file,
+                                            char** symbol_data,
+                                            size_t* symbol_data_size);
+  virtual void FreeSymbolData(const CodeModule* module);
+
+  // Returns the mapped serialized module, which a FastSourceLineResolver
+  // loads with LoadModuleUsingSymbolBuffer().  Symbol data supplier
+  // already returns serialized is returned as it is.
+  virtual SymbolResult GetSymbolBuffer(
+      const CodeModule* module,
+      const SystemInfo* system_info,
+      string* symbol_file,
+      std::shared_ptr<SymbolBuffer>* symbol_buffer);
+
+  // The size in bytes beyond which least recently used files are deleted
+  // from the cache.  0, the default, leaves the cache size unbounded.
+  void set_max_cache_size(uint64_t max_cache_size) {
+    max_cache_size_ = max_cache_size;
+  }
+
+  // Sets path to the serialized module in the cache.  Returns false if the
+  // module's debug file or identifier cannot be part of a file name.
+  bool GetCachePath(const CodeModule* module, string* path) const;
+
+ private:
+  // Serializes the symbol data supplier_ has for module into the cache at
+  // path, unless another process did meanwhile, and maps it into
+  // *symbol_buffer.  Returns supplier_'s result; if the module can't be
+  // cached, *symbol_buffer holds it unshared.
+  SymbolResult AddCacheFile(const CodeModule* module,
+                            const SystemInfo* system_info,
+                            const string& path,
+                            string* symbol_file,
+                            std::shared_ptr<SymbolBuffer>* symbol_buffer);
+
+  // Maps the cache file at path into *symbol_buffer, and records the use.
+  // Returns false if there is no such file.
+  bool MapCacheFile(const string& path,
+                    std::shared_ptr<SymbolBuffer>* symbol_buffer);
+
+  // Writes the size bytes at data to path through a temporary file.
+  bool WriteCacheFile(const string& path, const char* data, size_t size);
+
+  // Deletes least recently used files until the cache fits, keeping
+  // keep_path.
+  void EvictCacheFiles(const string& keep_path);
+
+  SymbolSupplier* supplier_;
+  string directory_;
+  uint64_t max_cache_size_;
+
+  // The buffers GetCStringSymbolData returned, by code file, until
+  // FreeSymbolData.  Guarded by buffers_lock_.
+  std::map<string, std::shared_ptr<SymbolBuffer>> buffers_;
+  std::mutex buffers_lock_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_SHARED_SYMBOL_CACHE_SUPPLIER_H__
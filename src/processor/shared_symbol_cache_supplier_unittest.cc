@@ -0,0 +1,269 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Unit tests for SharedSymbolCacheSupplier.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "common/tests/auto_tempdir.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/fast_source_line_resolver.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "processor/basic_code_module.h"
+#include "processor/module_serializer.h"
+#include "processor/shared_symbol_cache_supplier.h"
+
+namespace {
+
+using google_breakpad::AutoTempDir;
+using google_breakpad::BasicCodeModule;
+using google_breakpad::CodeModule;
+using google_breakpad::FastSourceLineResolver;
+using google_breakpad::ModuleSerializer;
+using google_breakpad::SharedSymbolCacheSupplier;
+using google_breakpad::StackFrame;
+using google_breakpad::SymbolBuffer;
+using google_breakpad::SymbolSupplier;
+using google_breakpad::SystemInfo;
+
+const char kSymbols[] =
+    "MODULE Linux x86 F4F8DFCD5A5FB5A7CE64717E9E6AE3890 libc.so.6\n"
+    "FILE 0 malloc.c\n"
+    "FUNC 1000 20 0 malloc\n"
+    "1000 20 42 0\n";
+
+// Supplies the same text symbol data for every module, and counts how
+// often it is asked for it.
+class CountingSymbolSupplier : public SymbolSupplier {
+ public:
+  explicit CountingSymbolSupplier(const string& symbol_data)
+      : symbol_data_(symbol_data), requests_(0), buffers_(0) {}
+
+  virtual SymbolResult GetSymbolFile(const CodeModule* module,
+                                     const SystemInfo* system_info,
+                                     string* symbol_file) {
+    *symbol_file = "/symbols/libc.so.6.sym";
+    return FOUND;
+  }
+  virtual SymbolResult GetSymbolFile(const CodeModule* module,
+                                     const SystemInfo* system_info,
+                                     string* symbol_file,
+                                     string* symbol_data) {
+    *symbol_data = symbol_data_;
+    return GetSymbolFile(module, system_info, symbol_file);
+  }
+  virtual SymbolResult GetCStringSymbolData(const CodeModule* module,
+                                            const SystemInfo* system_info,
+                                            string* symbol_file,
+                                            char** symbol_data,
+                                            size_t* symbol_data_size) {
+    ++requests_;
+    ++buffers_;
+    *symbol_data_size = symbol_data_.size() + 1;
+    *symbol_data = new char[*symbol_data_size];
+    memcpy(*symbol_data, symbol_data_.c_str(), *symbol_data_size);
+    buffer_.reset(*symbol_data);
+    return GetSymbolFile(module, system_info, symbol_file);
+  }
+  virtual void FreeSymbolData(const CodeModule* module) {
+    --buffers_;
+    buffer_.reset();
+  }
+
+  int requests() const { return requests_; }
+  // The buffers handed out and not freed yet.
+  int buffers() const { return buffers_; }
+
+ private:
+  string symbol_data_;
+  std::unique_ptr<char[]> buffer_;
+  int requests_;
+  int buffers_;
+};
+
+BasicCodeModule MakeModule(const string& debug_file) {
+  return BasicCodeModule(0x10000, 0x10000, "/lib/" + debug_file, "",
+                         debug_file, "F4F8DFCD5A5FB5A7CE64717E9E6AE3890",
+                         "");
+}
+
+TEST(SharedSymbolCacheSupplierTest, SharesSerializedModules) {
+  AutoTempDir directory;
+  BasicCodeModule module = MakeModule("libc.so.6");
+  CountingSymbolSupplier text_supplier(kSymbols);
+  SharedSymbolCacheSupplier supplier(&text_supplier, directory.path());
+
+  string symbol_file;
+  std::shared_ptr<SymbolBuffer> buffer;
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolBuffer(&module, NULL, &symbol_file, &buffer));
+  string cache_path;
+  ASSERT_TRUE(supplier.GetCachePath(&module, &cache_path));
+  EXPECT_EQ(directory.path() +
+                "/libc.so.6.F4F8DFCD5A5FB5A7CE64717E9E6AE3890" +
+                google_breakpad::kSerializedBreakpadFileExtension,
+            cache_path);
+  EXPECT_EQ(cache_path, symbol_file);
+  EXPECT_EQ(1, text_supplier.requests());
+  EXPECT_EQ(0, text_supplier.buffers());
+  EXPECT_TRUE(ModuleSerializer::IsSerializedData(buffer->data(),
+                                                 buffer->size()));
+  // No lock file is left behind.
+  struct stat lock_stat;
+  EXPECT_NE(0, stat((cache_path + ".lock").c_str(), &lock_stat));
+
+  FastSourceLineResolver resolver;
+  ASSERT_TRUE(resolver.LoadModuleUsingSymbolBuffer(&module, buffer));
+  StackFrame frame;
+  frame.instruction = 0x11010;
+  frame.module = &module;
+  resolver.FillSourceLineInfo(&frame, nullptr);
+  EXPECT_EQ("malloc", frame.function_name);
+  EXPECT_EQ("malloc.c", frame.source_file_name);
+  EXPECT_EQ(42, frame.source_line);
+
+  // Another process maps what the first one serialized.
+  CountingSymbolSupplier other_text_supplier(kSymbols);
+  SharedSymbolCacheSupplier other_supplier(&other_text_supplier,
+                                           directory.path());
+  std::shared_ptr<SymbolBuffer> other_buffer;
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            other_supplier.GetSymbolBuffer(&module, NULL, &symbol_file,
+                                           &other_buffer));
+  EXPECT_EQ(0, other_text_supplier.requests());
+  ASSERT_EQ(buffer->size(), other_buffer->size());
+  EXPECT_EQ(0, memcmp(buffer->data(), other_buffer->data(), buffer->size()));
+
+  // Data handed out as a C string lives until it is freed.
+  char* symbol_data;
+  size_t symbol_data_size;
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            other_supplier.GetCStringSymbolData(&module, NULL, &symbol_file,
+                                                &symbol_data,
+                                                &symbol_data_size));
+  EXPECT_EQ(buffer->size(), symbol_data_size);
+  EXPECT_EQ(0, memcmp(buffer->data(), symbol_data, symbol_data_size));
+  other_supplier.FreeSymbolData(&module);
+  EXPECT_EQ(0, other_text_supplier.buffers());
+}
+
+TEST(SharedSymbolCacheSupplierTest, PassesOnUncacheableModules) {
+  AutoTempDir directory;
+  CountingSymbolSupplier text_supplier(kSymbols);
+  SharedSymbolCacheSupplier supplier(&text_supplier, directory.path());
+
+  // A module whose debug file can't name a cache file gets the text symbol
+  // data as it is.
+  BasicCodeModule module = MakeModule("..");
+  string symbol_file;
+  std::shared_ptr<SymbolBuffer> buffer;
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolBuffer(&module, NULL, &symbol_file, &buffer));
+  EXPECT_EQ("/symbols/libc.so.6.sym", symbol_file);
+  EXPECT_STREQ(kSymbols, buffer->data());
+  EXPECT_TRUE(buffer->borrowed());
+  supplier.FreeSymbolData(&module);
+  EXPECT_EQ(0, text_supplier.buffers());
+
+  // So does data that is already serialized.
+  ModuleSerializer serializer;
+  size_t serialized_size;
+  std::unique_ptr<char[]> serialized(serializer.SerializeSymbolFileData(
+      kSymbols, &serialized_size));
+  CountingSymbolSupplier serialized_supplier(
+      string(serialized.get(), serialized_size));
+  SharedSymbolCacheSupplier serialized_cache_supplier(&serialized_supplier,
+                                                      directory.path());
+  BasicCodeModule libc = MakeModule("libc.so.6");
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            serialized_cache_supplier.GetSymbolBuffer(&libc, NULL,
+                                                      &symbol_file,
+                                                      &buffer));
+  EXPECT_EQ("/symbols/libc.so.6.sym", symbol_file);
+  EXPECT_TRUE(ModuleSerializer::IsSerializedData(buffer->data(),
+                                                 buffer->size()));
+  serialized_cache_supplier.FreeSymbolData(&libc);
+  EXPECT_EQ(0, serialized_supplier.buffers());
+}
+
+TEST(SharedSymbolCacheSupplierTest, EvictsLeastRecentlyUsedFiles) {
+  AutoTempDir directory;
+  CountingSymbolSupplier text_supplier(kSymbols);
+  SharedSymbolCacheSupplier supplier(&text_supplier, directory.path());
+
+  BasicCodeModule libc = MakeModule("libc.so.6");
+  BasicCodeModule libm = MakeModule("libm.so.6");
+  BasicCodeModule libz = MakeModule("libz.so.1");
+  string symbol_file;
+  std::shared_ptr<SymbolBuffer> libc_buffer;
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolBuffer(&libc, NULL, &symbol_file,
+                                     &libc_buffer));
+  std::shared_ptr<SymbolBuffer> buffer;
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolBuffer(&libm, NULL, &symbol_file, &buffer));
+
+  // Make libc the least recently used, and leave room for two files.
+  string libc_path;
+  ASSERT_TRUE(supplier.GetCachePath(&libc, &libc_path));
+  struct timespec times[2];
+  times[0].tv_sec = time(NULL) - 60;
+  times[0].tv_nsec = 0;
+  times[1].tv_sec = 0;
+  times[1].tv_nsec = UTIME_OMIT;
+  ASSERT_EQ(0, utimensat(AT_FDCWD, libc_path.c_str(), times, 0));
+  supplier.set_max_cache_size(2 * libc_buffer->size());
+
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolBuffer(&libz, NULL, &symbol_file, &buffer));
+  struct stat file_stat;
+  EXPECT_NE(0, stat(libc_path.c_str(), &file_stat));
+  string path;
+  ASSERT_TRUE(supplier.GetCachePath(&libm, &path));
+  EXPECT_EQ(0, stat(path.c_str(), &file_stat));
+  ASSERT_TRUE(supplier.GetCachePath(&libz, &path));
+  EXPECT_EQ(0, stat(path.c_str(), &file_stat));
+
+  // The evicted file stays usable where it is mapped.
+  EXPECT_TRUE(ModuleSerializer::IsSerializedData(libc_buffer->data(),
+                                                 libc_buffer->size()));
+  EXPECT_EQ(3, text_supplier.requests());
+}
+
+}  // namespace
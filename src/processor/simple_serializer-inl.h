@@ -42,6 +42,7 @@
 #include <cstdint>
 #include <string>
 
+#include "common/string_view.h"
 #include "google_breakpad/processor/basic_source_line_resolver.h"
 #include "processor/basic_source_line_resolver_types.h"
 #include "processor/linked_ptr.h"
@@ -79,6 +80,19 @@ class SimpleSerializer<string> {
   }
 };
 
+// Specializations of SimpleSerializer: StringView, written as a C-string
+template<>
+class SimpleSerializer<StringView> {
+ public:
+  static size_t SizeOf(StringView str) { return str.size() + 1; }
+
+  static char* Write(StringView str, char* dest) {
+    memcpy(dest, str.data(), str.size());
+    dest[str.size()] = '\0';
+    return dest + SizeOf(str);
+  }
+};
+
 // Specializations of SimpleSerializer: C-string
 template<>
 class SimpleSerializer<const char*> {
@@ -122,12 +136,12 @@ class SimpleSerializer<BasicSourceLineResolver::InlineOrigin> {
   static size_t SizeOf(const InlineOrigin& origin) {
     return SimpleSerializer<bool>::SizeOf(origin.has_file_id) +
            SimpleSerializer<int32_t>::SizeOf(origin.source_file_id) +
-           SimpleSerializer<string>::SizeOf(origin.name);
+           SimpleSerializer<StringView>::SizeOf(origin.name);
   }
   static char* Write(const InlineOrigin& origin, char* dest) {
     dest = SimpleSerializer<bool>::Write(origin.has_file_id, dest);
     dest = SimpleSerializer<int32_t>::Write(origin.source_file_id, dest);
-    dest = SimpleSerializer<string>::Write(origin.name, dest);
+    dest = SimpleSerializer<StringView>::Write(origin.name, dest);
     return dest;
   }
 };
@@ -138,13 +152,13 @@ class SimpleSerializer<BasicSourceLineResolver::PublicSymbol> {
   typedef BasicSourceLineResolver::PublicSymbol PublicSymbol;
  public:
   static size_t SizeOf(const PublicSymbol& pubsymbol) {
-    return SimpleSerializer<string>::SizeOf(pubsymbol.name)
+    return SimpleSerializer<StringView>::SizeOf(pubsymbol.name)
          + SimpleSerializer<MemAddr>::SizeOf(pubsymbol.address)
          + SimpleSerializer<int32_t>::SizeOf(pubsymbol.parameter_size)
          + SimpleSerializer<bool>::SizeOf(pubsymbol.is_multiple);
   }
   static char* Write(const PublicSymbol& pubsymbol, char* dest) {
-    dest = SimpleSerializer<string>::Write(pubsymbol.name, dest);
+    dest = SimpleSerializer<StringView>::Write(pubsymbol.name, dest);
     dest = SimpleSerializer<MemAddr>::Write(pubsymbol.address, dest);
     dest = SimpleSerializer<int32_t>::Write(pubsymbol.parameter_size, dest);
     dest = SimpleSerializer<bool>::Write(pubsymbol.is_multiple, dest);
@@ -285,7 +299,7 @@ class SimpleSerializer<BasicSourceLineResolver::Function> {
  public:
   static size_t SizeOf(const Function& func) {
     unsigned int size = 0;
-    size += SimpleSerializer<string>::SizeOf(func.name);
+    size += SimpleSerializer<StringView>::SizeOf(func.name);
     size += SimpleSerializer<MemAddr>::SizeOf(func.address);
     size += SimpleSerializer<MemAddr>::SizeOf(func.size);
     size += SimpleSerializer<int32_t>::SizeOf(func.parameter_size);
@@ -299,7 +313,7 @@ class SimpleSerializer<BasicSourceLineResolver::Function> {
   }
 
   static char* Write(const Function& func, char* dest) {
-    dest = SimpleSerializer<string>::Write(func.name, dest);
+    dest = SimpleSerializer<StringView>::Write(func.name, dest);
     dest = SimpleSerializer<MemAddr>::Write(func.address, dest);
     dest = SimpleSerializer<MemAddr>::Write(func.size, dest);
     dest = SimpleSerializer<int32_t>::Write(func.parameter_size, dest);
@@ -39,17 +39,22 @@
 #include "processor/simple_symbol_supplier.h"
 
 #include <assert.h>
+#include <dirent.h>
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 
 #include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <fstream>
 
 #include "common/using_std_string.h"
 #include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/fast_source_line_resolver.h"
 #include "google_breakpad/processor/system_info.h"
+#include "processor/async_file_reader.h"
+#include "processor/compressed_symbol_file.h"
 #include "processor/logging.h"
 #include "processor/pathname_stripper.h"
 
@@ -60,6 +65,67 @@ static bool file_exists(const string& file_name) {
   return stat(file_name.c_str(), &sb) == 0;
 }
 
+static bool is_serialized_symbol_file(const string& file_name) {
+  size_t extension_size = strlen(kSerializedBreakpadFileExtension);
+  return file_name.size() > extension_size &&
+         file_name.compare(file_name.size() - extension_size, extension_size,
+                           kSerializedBreakpadFileExtension) == 0;
+}
+
+// Appends the names of the entries in directory, other than "." and "..",
+// to names.  Returns false if directory cannot be read.
+// Reads the symbol file at file_name, which may be serialized or
+// compressed, into *symbol_data.
+static void read_symbol_file(const string& file_name, string* symbol_data) {
+  if (is_serialized_symbol_file(file_name)) {
+    // Serialized modules are binary and may contain any byte value,
+    // including the one getline() is made to stop at below.
+    std::ifstream in(file_name.c_str(), std::ios::binary);
+    symbol_data->assign(std::istreambuf_iterator<char>(in),
+                        std::istreambuf_iterator<char>());
+    in.close();
+  } else if (IsCompressedSymbolFile(file_name)) {
+    ReadCompressedSymbolFile(file_name, symbol_data);
+  } else {
+    std::ifstream in(file_name.c_str());
+    std::getline(in, *symbol_data, string::traits_type::to_char_type(
+                     string::traits_type::eof()));
+    in.close();
+  }
+}
+
+static bool list_directory(const string& directory, vector<string>* names) {
+  DIR* dir = opendir(directory.c_str());
+  if (!dir)
+    return false;
+  dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+      names->push_back(entry->d_name);
+  }
+  closedir(dir);
+  return true;
+}
+
+// Adds the relative paths of the files at the depth of symbol files below
+// root_path, "debug_file/debug_identifier/file", to index.
+static void index_symbol_files(const string& root_path,
+                               std::set<string>* index) {
+  vector<string> debug_files;
+  list_directory(root_path, &debug_files);
+  for (size_t i = 0; i < debug_files.size(); ++i) {
+    vector<string> identifiers;
+    list_directory(root_path + "/" + debug_files[i], &identifiers);
+    for (size_t j = 0; j < identifiers.size(); ++j) {
+      string directory = debug_files[i] + "/" + identifiers[j];
+      vector<string> files;
+      list_directory(root_path + "/" + directory, &files);
+      for (size_t k = 0; k < files.size(); ++k)
+        index->insert(directory + "/" + files[k]);
+    }
+  }
+}
+
 SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetSymbolFile(
     const CodeModule* module, const SystemInfo* system_info,
     string* symbol_file) {
@@ -68,7 +134,23 @@ SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetSymbolFile(
   assert(symbol_file);
   symbol_file->clear();
 
+  if (negative_cache_ && module &&
+      negative_cache_->IsMissing(module->debug_file(),
+                                 module->debug_identifier())) {
+    BPLOG(INFO) << "Skipping module recorded as having no symbols: "
+                << module->debug_file();
+    return NOT_FOUND;
+  }
+
+  string relative_path;
+  if (use_directory_index_ && !GetSymbolFileRelativePath(module,
+                                                         &relative_path)) {
+    return NOT_FOUND;
+  }
+
   for (unsigned int path_index = 0; path_index < paths_.size(); ++path_index) {
+    if (use_directory_index_ && !MayHaveSymbolFile(path_index, relative_path))
+      continue;
     SymbolResult result;
     if ((result = GetSymbolFileAtPathFromRoot(module, system_info,
                                               paths_[path_index],
@@ -76,6 +158,10 @@ SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetSymbolFile(
       return result;
     }
   }
+  if (negative_cache_ && module) {
+    negative_cache_->SetMissing(module->debug_file(),
+                                module->debug_identifier());
+  }
   return NOT_FOUND;
 }
 
@@ -89,12 +175,41 @@ SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetSymbolFile(
 
   SymbolSupplier::SymbolResult s = GetSymbolFile(module, system_info,
                                                  symbol_file);
-  if (s == FOUND) {
-    std::ifstream in(symbol_file->c_str());
-    std::getline(in, *symbol_data, string::traits_type::to_char_type(
-                     string::traits_type::eof()));
-    in.close();
+  if (s == FOUND)
+    read_symbol_file(*symbol_file, symbol_data);
+  return s;
+}
+
+SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetSymbolBuffer(
+    const CodeModule* module,
+    const SystemInfo* system_info,
+    string* symbol_file,
+    std::shared_ptr<SymbolBuffer>* symbol_buffer) {
+  assert(symbol_buffer);
+  symbol_buffer->reset();
+
+  SymbolSupplier::SymbolResult s = GetSymbolFile(module, system_info,
+                                                 symbol_file);
+  if (s != FOUND)
+    return s;
+
+  // Map uncompressed files rather than reading them.  A resolver overwrites
+  // the last byte of a symbol file with a null terminator, which must not
+  // cost it the end of the last record.
+  if (!IsCompressedSymbolFile(*symbol_file)) {
+    *symbol_buffer = SymbolBuffer::MapFile(*symbol_file);
+    if (*symbol_buffer && !is_serialized_symbol_file(*symbol_file)) {
+      char last = (*symbol_buffer)->data()[(*symbol_buffer)->size() - 1];
+      if (last != '\n' && last != '\0')
+        symbol_buffer->reset();
+    }
+    if (*symbol_buffer)
+      return s;
   }
+
+  string symbol_data;
+  read_symbol_file(*symbol_file, &symbol_data);
+  *symbol_buffer = SymbolBuffer::AdoptString(&symbol_data);
   return s;
 }
 
@@ -121,17 +236,78 @@ SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetCStringSymbolData(
     }
     memcpy(*symbol_data, symbol_data_string.c_str(), symbol_data_string.size());
     (*symbol_data)[symbol_data_string.size()] = '\0';
+    std::lock_guard<std::mutex> lock(memory_buffers_lock_);
     memory_buffers_.insert(make_pair(module->code_file(), *symbol_data));
   }
   return s;
 }
 
+// Completes a GetCStringSymbolDataAsync request when its symbol file has
+// been read, and then deletes itself.
+class SimpleSymbolSupplier::SymbolFileRead : public AsyncFileReader::Callback {
+ public:
+  SymbolFileRead(SimpleSymbolSupplier* supplier,
+                 const CodeModule* module,
+                 SymbolDataCallback* callback)
+      : supplier_(supplier), module_(module), callback_(callback) {}
+
+  virtual void OnRead(const string& path, char* data, size_t size) {
+    // As in GetCStringSymbolData, a file that can't be read yields empty
+    // symbols.
+    if (!data) {
+      data = new char[1];
+      data[0] = '\0';
+      size = 0;
+    }
+    {
+      std::lock_guard<std::mutex> lock(supplier_->memory_buffers_lock_);
+      supplier_->memory_buffers_.insert(make_pair(module_->code_file(), data));
+    }
+    callback_->OnSymbolData(module_, FOUND, path, data, size + 1);
+    delete this;
+  }
+
+ private:
+  SimpleSymbolSupplier* supplier_;
+  const CodeModule* module_;
+  SymbolDataCallback* callback_;
+};
+
+void SimpleSymbolSupplier::GetCStringSymbolDataAsync(
+    const CodeModule* module,
+    const SystemInfo* system_info,
+    SymbolDataCallback* callback) {
+  if (!file_reader_) {
+    SymbolSupplier::GetCStringSymbolDataAsync(module, system_info, callback);
+    return;
+  }
+
+  string symbol_file;
+  SymbolSupplier::SymbolResult s =
+      GetSymbolFile(module, system_info, &symbol_file);
+  if (s != FOUND) {
+    callback->OnSymbolData(module, s, symbol_file, NULL, 0);
+    return;
+  }
+  SymbolFileRead* read = new SymbolFileRead(this, module, callback);
+  if (IsCompressedSymbolFile(symbol_file)) {
+    string symbol_data;
+    read_symbol_file(symbol_file, &symbol_data);
+    char* data = new char[symbol_data.size() + 1];
+    memcpy(data, symbol_data.c_str(), symbol_data.size() + 1);
+    read->OnRead(symbol_file, data, symbol_data.size());
+    return;
+  }
+  file_reader_->Read(symbol_file, read);
+}
+
 void SimpleSymbolSupplier::FreeSymbolData(const CodeModule* module) {
   if (!module) {
     BPLOG(INFO) << "Cannot free symbol data buffer for NULL module";
     return;
   }
 
+  std::lock_guard<std::mutex> lock(memory_buffers_lock_);
   map<string, char*>::iterator it = memory_buffers_.find(module->code_file());
   if (it == memory_buffers_.end()) {
     BPLOG(INFO) << "Cannot find symbol data buffer for module "
@@ -142,28 +318,52 @@ void SimpleSymbolSupplier::FreeSymbolData(const CodeModule* module) {
   memory_buffers_.erase(it);
 }
 
-SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetSymbolFileAtPathFromRoot(
-    const CodeModule* module, const SystemInfo* system_info,
-    const string& root_path, string* symbol_file) {
-  BPLOG_IF(ERROR, !symbol_file) << "SimpleSymbolSupplier::GetSymbolFileAtPath "
-                                   "requires |symbol_file|";
-  assert(symbol_file);
-  symbol_file->clear();
+void SimpleSymbolSupplier::RefreshDirectoryIndex() {
+  std::lock_guard<std::mutex> lock(directory_index_lock_);
+  directory_index_.clear();
+}
 
-  if (!module)
-    return NOT_FOUND;
+bool SimpleSymbolSupplier::MayHaveSymbolFile(size_t path_index,
+                                             const string& relative_path) {
+  std::lock_guard<std::mutex> lock(directory_index_lock_);
+  map<size_t, std::set<string> >::iterator it =
+      directory_index_.find(path_index);
+  if (it == directory_index_.end()) {
+    it = directory_index_.insert(
+        make_pair(path_index, std::set<string>())).first;
+    index_symbol_files(paths_[path_index], &it->second);
+  }
+  const std::set<string>& index = it->second;
+  if (index.count(relative_path) != 0 ||
+      (prefer_serialized_symbols_ &&
+       index.count(relative_path + kSerializedBreakpadFileExtension) != 0)) {
+    return true;
+  }
+  if (read_compressed_symbols_) {
+    for (const char* const* extension =
+             kReadableCompressedSymbolFileExtensions;
+         *extension; ++extension) {
+      if (index.count(relative_path + *extension) != 0)
+        return true;
+    }
+  }
+  return false;
+}
 
-  // Start with the base path.
-  string path = root_path;
+// static
+bool SimpleSymbolSupplier::GetSymbolFileRelativePath(const CodeModule* module,
+                                                     string* relative_path) {
+  if (!module)
+    return false;
 
-  // Append the debug (pdb) file name as a directory name.
-  path.append("/");
+  // Start with the debug (pdb) file name as a directory name.
+  string path;
   string debug_file_name = PathnameStripper::File(module->debug_file());
   if (debug_file_name.empty()) {
     BPLOG(ERROR) << "Can't construct symbol file path without debug_file "
                     "(code_file = " <<
                     PathnameStripper::File(module->code_file()) << ")";
-    return NOT_FOUND;
+    return false;
   }
   path.append(debug_file_name);
 
@@ -175,7 +375,7 @@ SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetSymbolFileAtPathFromRoot(
                     "(code_file = " <<
                     PathnameStripper::File(module->code_file()) <<
                     ", debug_file = " << debug_file_name << ")";
-    return NOT_FOUND;
+    return false;
   }
   path.append(identifier);
 
@@ -195,7 +395,49 @@ SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetSymbolFileAtPathFromRoot(
   }
   path.append(".sym");
 
+  relative_path->swap(path);
+  return true;
+}
+
+SymbolSupplier::SymbolResult SimpleSymbolSupplier::GetSymbolFileAtPathFromRoot(
+    const CodeModule* module, const SystemInfo* system_info,
+    const string& root_path, string* symbol_file) {
+  BPLOG_IF(ERROR, !symbol_file) << "SimpleSymbolSupplier::GetSymbolFileAtPath "
+                                   "requires |symbol_file|";
+  assert(symbol_file);
+  symbol_file->clear();
+
+  string relative_path;
+  if (!GetSymbolFileRelativePath(module, &relative_path))
+    return NOT_FOUND;
+  string path = root_path + "/" + relative_path;
+
+  if (prefer_serialized_symbols_) {
+    string serialized_path = path + kSerializedBreakpadFileExtension;
+    struct stat serialized_stat;
+    struct stat symbol_stat;
+    if (stat(serialized_path.c_str(), &serialized_stat) == 0) {
+      if (stat(path.c_str(), &symbol_stat) != 0 ||
+          serialized_stat.st_mtime >= symbol_stat.st_mtime) {
+        *symbol_file = serialized_path;
+        return FOUND;
+      }
+      BPLOG(INFO) << "Ignoring stale serialized symbol file "
+                  << serialized_path;
+    }
+  }
+
   if (!file_exists(path)) {
+    if (read_compressed_symbols_) {
+      for (const char* const* extension =
+               kReadableCompressedSymbolFileExtensions;
+           *extension; ++extension) {
+        if (file_exists(path + *extension)) {
+          *symbol_file = path + *extension;
+          return FOUND;
+        }
+      }
+    }
     BPLOG(INFO) << "No symbol file at " << path;
     return NOT_FOUND;
   }
@@ -64,6 +64,36 @@
 // SimpleSymbolSupplier will iterate over all root paths searching for
 // a symbol file existing in that path.
 //
+// If set_prefer_serialized_symbols(true) is called, a module serialized by
+// ModuleSerializer (see sym_to_fast) next to the symbol file, named like it
+// with kSerializedBreakpadFileExtension appended, is returned instead,
+// unless the symbol file is newer.  Serialized modules can only be loaded
+// by FastSourceLineResolver.
+//
+// If set_read_compressed_symbols(true) is called, a symbol file missing from
+// a root path may instead be stored compressed, named like it with
+// kGzipSymbolFileExtension or kZstdSymbolFileExtension appended (see
+// compressed_symbol_file.h), and is decompressed as it is read.
+//
+// If a NegativeSymbolCache is set, modules it records as having no symbols
+// are reported NOT_FOUND without searching the root paths, and modules not
+// found in any root path are recorded in it.
+//
+// If set_use_directory_index(true) is called, the files below each root path
+// are listed once, on the first lookup, and modules whose symbol files are
+// not listed are skipped in that root path without checking for the files.
+// This saves a stat() per root path for each module without symbols there,
+// which adds up on network filesystems.  Symbol files added later are only
+// found after RefreshDirectoryIndex() is called.
+//
+// If an AsyncFileReader is set, GetCStringSymbolDataAsync reads symbol files
+// through it, so that the reads for many requests, such as those of the
+// minidumps of a batch, are in flight at once without a thread apiece.
+// Compressed symbol files are still read by the calling thread.
+//
+// SimpleSymbolSupplier may be called from several threads at once, as
+// MinidumpProcessor does when prefetching symbols concurrently.
+//
 // SimpleSymbolSupplier supports any debugging file which can be identified
 // by a CodeModule object's debug_file and debug_identifier accessors.  The
 // expected ultimate source of these CodeModule objects are MinidumpModule
@@ -76,10 +106,14 @@
 #define PROCESSOR_SIMPLE_SYMBOL_SUPPLIER_H__
 
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <vector>
 
 #include "common/using_std_string.h"
+#include "google_breakpad/processor/negative_symbol_cache.h"
 #include "google_breakpad/processor/symbol_supplier.h"
 
 namespace google_breakpad {
@@ -87,17 +121,30 @@ namespace google_breakpad {
 using std::map;
 using std::vector;
 
+class AsyncFileReader;
 class CodeModule;
 
 class SimpleSymbolSupplier : public SymbolSupplier {
  public:
   // Creates a new SimpleSymbolSupplier, using path as the root path where
   // symbols are stored.
-  explicit SimpleSymbolSupplier(const string& path) : paths_(1, path) {}
+  explicit SimpleSymbolSupplier(const string& path)
+      : paths_(1, path),
+        prefer_serialized_symbols_(false),
+        negative_cache_(NULL),
+        read_compressed_symbols_(false),
+        use_directory_index_(false),
+        file_reader_(NULL) {}
 
   // Creates a new SimpleSymbolSupplier, using paths as a list of root
   // paths where symbols may be stored.
-  explicit SimpleSymbolSupplier(const vector<string>& paths) : paths_(paths) {}
+  explicit SimpleSymbolSupplier(const vector<string>& paths)
+      : paths_(paths),
+        prefer_serialized_symbols_(false),
+        negative_cache_(NULL),
+        read_compressed_symbols_(false),
+        use_directory_index_(false),
+        file_reader_(NULL) {}
 
   virtual ~SimpleSymbolSupplier() {}
 
@@ -112,6 +159,14 @@ class SimpleSymbolSupplier : public SymbolSupplier {
                                      string* symbol_file,
                                      string* symbol_data);
 
+  // Maps the symbol file into memory if it is not compressed, and reads it
+  // otherwise.
+  virtual SymbolResult GetSymbolBuffer(
+      const CodeModule* module,
+      const SystemInfo* system_info,
+      string* symbol_file,
+      std::shared_ptr<SymbolBuffer>* symbol_buffer);
+
   // Allocates data buffer on heap and writes symbol data into buffer.
   // Symbol supplier ALWAYS takes ownership of the data buffer.
   virtual SymbolResult GetCStringSymbolData(const CodeModule* module,
@@ -120,18 +175,89 @@ class SimpleSymbolSupplier : public SymbolSupplier {
                                             char** symbol_data,
                                             size_t* symbol_data_size);
 
+  // Reads the symbol file through the AsyncFileReader, if one is set and
+  // the file is not compressed, and as GetCStringSymbolData does
+  // otherwise.
+  virtual void GetCStringSymbolDataAsync(const CodeModule* module,
+                                         const SystemInfo* system_info,
+                                         SymbolDataCallback* callback);
+
   // Free the data buffer allocated in the above GetCStringSymbolData();
   virtual void FreeSymbolData(const CodeModule* module);
 
+  // Whether to supply serialized modules in preference to symbol files.
+  // See the description above.
+  void set_prefer_serialized_symbols(bool prefer) {
+    prefer_serialized_symbols_ = prefer;
+  }
+
+  // Whether to look for compressed symbol files when a symbol file is
+  // missing.  See the description above.
+  void set_read_compressed_symbols(bool read_compressed_symbols) {
+    read_compressed_symbols_ = read_compressed_symbols;
+  }
+
+  // Records modules without symbols in negative_cache, and skips the
+  // search for modules recorded there.  See the description above.  The
+  // caller retains ownership of negative_cache, which may be NULL.
+  void set_negative_cache(NegativeSymbolCache* negative_cache) {
+    negative_cache_ = negative_cache;
+  }
+
+  // Whether to skip root paths whose listing lacks a module's symbol file.
+  // See the description above.
+  void set_use_directory_index(bool use_directory_index) {
+    use_directory_index_ = use_directory_index;
+  }
+
+  // Reads symbol files for GetCStringSymbolDataAsync through file_reader.
+  // See the description above.  The caller retains ownership of
+  // file_reader, which may be NULL, and must keep it alive until all
+  // requests complete.
+  void set_async_file_reader(AsyncFileReader* file_reader) {
+    file_reader_ = file_reader;
+  }
+
+  // Discards the listings of the root paths, so that they are listed again
+  // on the next lookup.
+  void RefreshDirectoryIndex();
+
+  // Sets relative_path to the path of module's symbol file below a root
+  // path, "debug_file/debug_identifier/debug_file.sym" as described above.
+  // Returns false if module lacks the debug file name or identifier.
+  static bool GetSymbolFileRelativePath(const CodeModule* module,
+                                        string* relative_path);
+
  protected:
   SymbolResult GetSymbolFileAtPathFromRoot(const CodeModule* module,
                                            const SystemInfo* system_info,
                                            const string& root_path,
                                            string* symbol_file);
 
+  NegativeSymbolCache* negative_cache() const { return negative_cache_; }
+
  private:
+  class SymbolFileRead;
+
+  // Returns false if the directory index of the root path paths_[path_index]
+  // shows that it holds no form of relative_path that would be looked for,
+  // listing the root path first if needed.
+  bool MayHaveSymbolFile(size_t path_index, const string& relative_path);
+
   map<string, char*> memory_buffers_;
+  // Guards memory_buffers_.
+  std::mutex memory_buffers_lock_;
   vector<string> paths_;
+  bool prefer_serialized_symbols_;
+  NegativeSymbolCache* negative_cache_;
+  bool read_compressed_symbols_;
+  bool use_directory_index_;
+  AsyncFileReader* file_reader_;
+  // The relative paths of the files below each root path that has been
+  // listed, by index into paths_.
+  map<size_t, std::set<string> > directory_index_;
+  // Guards directory_index_.
+  std::mutex directory_index_lock_;
 };
 
 }  // namespace google_breakpad
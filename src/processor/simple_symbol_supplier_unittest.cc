@@ -0,0 +1,274 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Unit tests for SimpleSymbolSupplier.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "breakpad_googletest_includes.h"
+#include "common/tests/auto_tempdir.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/code_module.h"
+#include "processor/async_file_reader.h"
+#include "processor/basic_code_module.h"
+#include "processor/compressed_symbol_file.h"
+#include "processor/simple_symbol_supplier.h"
+
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+
+namespace {
+
+using google_breakpad::AsyncFileReader;
+using google_breakpad::AutoTempDir;
+using google_breakpad::BasicCodeModule;
+using google_breakpad::CodeModule;
+using google_breakpad::kGzipSymbolFileExtension;
+using google_breakpad::ReadCompressedSymbolFile;
+using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::SymbolBuffer;
+using google_breakpad::SymbolSupplier;
+
+const char kDebugIdentifier[] = "F4F8DFCD5A5FB5A7CE64717E9E6AE3890";
+
+const char kSymbolData[] =
+    "MODULE Linux x86_64 F4F8DFCD5A5FB5A7CE64717E9E6AE3890 libc.so.6\n";
+
+// Writes a symbol file for libc.so.6 below root, returning its path.
+string AddSymbolFile(const string& root) {
+  string symbol_dir = root + "/libc.so.6";
+  mkdir(root.c_str(), 0755);
+  mkdir(symbol_dir.c_str(), 0755);
+  symbol_dir += string("/") + kDebugIdentifier;
+  mkdir(symbol_dir.c_str(), 0755);
+  string symbol_file = symbol_dir + "/libc.so.6.sym";
+  FILE* file = fopen(symbol_file.c_str(), "w");
+  if (file) {
+    fputs(kSymbolData, file);
+    fclose(file);
+  }
+  return symbol_file;
+}
+
+TEST(SimpleSymbolSupplierTest, FindsSymbolFileInRootPaths) {
+  AutoTempDir directory;
+  std::vector<string> roots;
+  roots.push_back(directory.path() + "/first");
+  roots.push_back(directory.path() + "/second");
+  string symbol_file = AddSymbolFile(roots[1]);
+  SimpleSymbolSupplier supplier(roots);
+  BasicCodeModule module(0x1000, 0x1000, "/lib/libc.so.6", "", "libc.so.6",
+                         kDebugIdentifier, "");
+
+  string found_file;
+  EXPECT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolFile(&module, NULL, &found_file));
+  EXPECT_EQ(symbol_file, found_file);
+
+  BasicCodeModule other_module(0x1000, 0x1000, "/lib/libm.so.6", "",
+                               "libm.so.6", kDebugIdentifier, "");
+  EXPECT_EQ(SymbolSupplier::NOT_FOUND,
+            supplier.GetSymbolFile(&other_module, NULL, &found_file));
+  EXPECT_EQ("", found_file);
+}
+
+TEST(SimpleSymbolSupplierTest, AnswersFromDirectoryIndex) {
+  AutoTempDir directory;
+  std::vector<string> roots;
+  roots.push_back(directory.path() + "/first");
+  roots.push_back(directory.path() + "/second");
+  string first_file = AddSymbolFile(roots[0]);
+  SimpleSymbolSupplier supplier(roots);
+  supplier.set_use_directory_index(true);
+  BasicCodeModule module(0x1000, 0x1000, "/lib/libc.so.6", "", "libc.so.6",
+                         kDebugIdentifier, "");
+
+  BasicCodeModule other_module(0x1000, 0x1000, "/lib/libm.so.6", "",
+                               "libm.so.6", kDebugIdentifier, "");
+  string found_file;
+  EXPECT_EQ(SymbolSupplier::NOT_FOUND,
+            supplier.GetSymbolFile(&other_module, NULL, &found_file));
+  EXPECT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolFile(&module, NULL, &found_file));
+  EXPECT_EQ(first_file, found_file);
+
+  // Both root paths were listed by the first lookup, so symbol files added
+  // since are not found until the index is refreshed.
+  string second_file = AddSymbolFile(roots[1]);
+  ASSERT_EQ(0, remove(first_file.c_str()));
+  EXPECT_EQ(SymbolSupplier::NOT_FOUND,
+            supplier.GetSymbolFile(&module, NULL, &found_file));
+
+  supplier.RefreshDirectoryIndex();
+  EXPECT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolFile(&module, NULL, &found_file));
+  EXPECT_EQ(second_file, found_file);
+}
+
+TEST(SimpleSymbolSupplierTest, SuppliesSymbolBuffer) {
+  AutoTempDir directory;
+  string symbol_file = AddSymbolFile(directory.path());
+  SimpleSymbolSupplier supplier(directory.path());
+  BasicCodeModule module(0x1000, 0x1000, "/lib/libc.so.6", "", "libc.so.6",
+                         kDebugIdentifier, "");
+
+  // The symbol file ends in a newline, so it is mapped as it is.
+  string found_file;
+  std::shared_ptr<SymbolBuffer> buffer;
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolBuffer(&module, NULL, &found_file, &buffer));
+  EXPECT_EQ(symbol_file, found_file);
+  ASSERT_TRUE(buffer);
+  EXPECT_FALSE(buffer->borrowed());
+  EXPECT_EQ(kSymbolData, string(buffer->data(), buffer->size()));
+
+  // Otherwise it is read, and a null terminator appended.
+  FILE* file = fopen(symbol_file.c_str(), "w");
+  ASSERT_TRUE(file);
+  fputs("MODULE Linux x86_64 F4F8DFCD5A5FB5A7CE64717E9E6AE3890 libc.so.6",
+        file);
+  fclose(file);
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolBuffer(&module, NULL, &found_file, &buffer));
+  ASSERT_TRUE(buffer);
+  EXPECT_EQ(strlen(kSymbolData), buffer->size());
+  EXPECT_EQ('\0', buffer->data()[buffer->size() - 1]);
+
+  BasicCodeModule other_module(0x1000, 0x1000, "/lib/libm.so.6", "",
+                               "libm.so.6", kDebugIdentifier, "");
+  EXPECT_EQ(SymbolSupplier::NOT_FOUND,
+            supplier.GetSymbolBuffer(&other_module, NULL, &found_file,
+                                     &buffer));
+  EXPECT_FALSE(buffer);
+}
+
+// Records the result of a GetCStringSymbolDataAsync request.
+class SymbolDataRecorder : public SymbolSupplier::SymbolDataCallback {
+ public:
+  SymbolDataRecorder()
+      : called_(false), result_(SymbolSupplier::INTERRUPT), data_(NULL),
+        size_(0) {}
+
+  virtual void OnSymbolData(const CodeModule* module,
+                            SymbolSupplier::SymbolResult result,
+                            const string& symbol_file,
+                            char* symbol_data,
+                            size_t symbol_data_size) {
+    EXPECT_FALSE(called_);
+    called_ = true;
+    result_ = result;
+    symbol_file_ = symbol_file;
+    data_ = symbol_data;
+    size_ = symbol_data_size;
+  }
+
+  bool called_;
+  SymbolSupplier::SymbolResult result_;
+  string symbol_file_;
+  char* data_;
+  size_t size_;
+};
+
+TEST(SimpleSymbolSupplierTest, ReadsThroughAsyncFileReader) {
+  AutoTempDir directory;
+  string symbol_file = AddSymbolFile(directory.path());
+  SimpleSymbolSupplier supplier(directory.path());
+  BasicCodeModule module(0x1000, 0x1000, "/lib/libc.so.6", "", "libc.so.6",
+                         kDebugIdentifier, "");
+  BasicCodeModule other_module(0x1000, 0x1000, "/lib/libm.so.6", "",
+                               "libm.so.6", kDebugIdentifier, "");
+
+  SymbolDataRecorder found;
+  SymbolDataRecorder missing;
+  {
+    AsyncFileReader file_reader(2);
+    supplier.set_async_file_reader(&file_reader);
+    supplier.GetCStringSymbolDataAsync(&module, NULL, &found);
+    supplier.GetCStringSymbolDataAsync(&other_module, NULL, &missing);
+  }
+
+  ASSERT_TRUE(found.called_);
+  EXPECT_EQ(SymbolSupplier::FOUND, found.result_);
+  EXPECT_EQ(symbol_file, found.symbol_file_);
+  ASSERT_EQ(strlen(kSymbolData) + 1, found.size_);
+  EXPECT_STREQ(kSymbolData, found.data_);
+  supplier.FreeSymbolData(&module);
+
+  ASSERT_TRUE(missing.called_);
+  EXPECT_EQ(SymbolSupplier::NOT_FOUND, missing.result_);
+  EXPECT_EQ(NULL, missing.data_);
+}
+
+#ifdef HAVE_LIBZ
+TEST(SimpleSymbolSupplierTest, ReadsCompressedSymbolFile) {
+  AutoTempDir directory;
+  string symbol_file = AddSymbolFile(directory.path());
+  ASSERT_EQ(0, remove(symbol_file.c_str()));
+  string compressed_file = symbol_file + kGzipSymbolFileExtension;
+  gzFile file = gzopen(compressed_file.c_str(), "wb");
+  ASSERT_TRUE(file);
+  ASSERT_EQ(static_cast<int>(strlen(kSymbolData)), gzputs(file, kSymbolData));
+  ASSERT_EQ(Z_OK, gzclose(file));
+
+  SimpleSymbolSupplier supplier(directory.path());
+  BasicCodeModule module(0x1000, 0x1000, "/lib/libc.so.6", "", "libc.so.6",
+                         kDebugIdentifier, "");
+  string found_file;
+  string symbol_data;
+  EXPECT_EQ(SymbolSupplier::NOT_FOUND,
+            supplier.GetSymbolFile(&module, NULL, &found_file, &symbol_data));
+
+  supplier.set_read_compressed_symbols(true);
+  EXPECT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolFile(&module, NULL, &found_file, &symbol_data));
+  EXPECT_EQ(compressed_file, found_file);
+  EXPECT_EQ(kSymbolData, symbol_data);
+
+  // A compressed file cut short is not read.
+  FILE* truncated = fopen(compressed_file.c_str(), "r+");
+  ASSERT_TRUE(truncated);
+  ASSERT_EQ(0, ftruncate(fileno(truncated), 20));
+  fclose(truncated);
+  EXPECT_FALSE(ReadCompressedSymbolFile(compressed_file, &symbol_data));
+  EXPECT_EQ("", symbol_data);
+}
+#endif  // HAVE_LIBZ
+
+}  // namespace
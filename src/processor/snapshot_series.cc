@@ -0,0 +1,487 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// snapshot_series.cc: Putting the snapshots of a series back together.
+//
+// See snapshot_series.h for documentation.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "processor/snapshot_series.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "common/byte_swap.h"
+#include "google_breakpad/processor/minidump.h"
+#include "processor/logging.h"
+
+namespace google_breakpad {
+
+namespace {
+
+using std::vector;
+
+// A minidump file read with Minidump, which checks its header, directory
+// and streams, and puts what it reads in the host's byte order.  Minidump
+// reads straight from data, so the memory it returns lies within data.
+class SnapshotDump {
+ public:
+  explicit SnapshotDump(const string& data)
+      : data_(data),
+        dump_(reinterpret_cast<const uint8_t*>(data.data()), data.size()) {}
+
+  SnapshotDump(const SnapshotDump&) = delete;
+  void operator=(const SnapshotDump&) = delete;
+
+  bool Read() { return dump_.Read(); }
+
+  const string& data() const { return data_; }
+  Minidump* dump() { return &dump_; }
+
+  // Returns the directory entry of the stream of type, or NULL if there is
+  // none.
+  const MDRawDirectory* FindStream(uint32_t type) const {
+    for (unsigned int i = 0; i < dump_.GetDirectoryEntryCount(); ++i) {
+      const MDRawDirectory* entry = dump_.GetDirectoryEntryAtIndex(i);
+      if (entry && entry->stream_type == type &&
+          entry->location.data_size > 0) {
+        return entry;
+      }
+    }
+    return NULL;
+  }
+
+  // Returns the offset in data of bytes that Minidump returned.
+  uint32_t OffsetOf(const uint8_t* bytes) const {
+    return static_cast<uint32_t>(
+        bytes - reinterpret_cast<const uint8_t*>(data_.data()));
+  }
+
+ private:
+  const string& data_;
+  Minidump dump_;
+};
+
+// Reads the memory list of dump into blocks, whose rvas are those of the
+// blocks' contents in dump's data.  A minidump without one has no blocks.
+bool ReadMemoryList(SnapshotDump* dump, vector<MDMemoryDescriptor>* blocks) {
+  blocks->clear();
+  if (!dump->FindStream(MD_MEMORY_LIST_STREAM))
+    return true;
+  MinidumpMemoryList* list = dump->dump()->GetMemoryList();
+  if (!list) {
+    BPLOG(ERROR) << "Memory list is malformed";
+    return false;
+  }
+  for (unsigned int i = 0; i < list->region_count(); ++i) {
+    MinidumpMemoryRegion* region = list->GetMemoryRegionAtIndex(i);
+    if (!region || region->GetSize() == 0)
+      continue;
+    const uint8_t* contents = region->GetMemory();
+    if (!contents) {
+      BPLOG(ERROR) << "Memory block is not in the minidump";
+      return false;
+    }
+    MDMemoryDescriptor block;
+    block.start_of_memory_range = region->GetBase();
+    block.memory.data_size = region->GetSize();
+    block.memory.rva = dump->OffsetOf(contents);
+    blocks->push_back(block);
+  }
+  return true;
+}
+
+// Reads the series stream of dump into series, and if regions is not NULL,
+// its regions into regions.
+bool ReadSeries(SnapshotDump* dump, MDRawSnapshotSeries* series,
+                vector<MDMemoryDescriptor>* regions) {
+  Minidump* minidump = dump->dump();
+  uint32_t length;
+  if (!minidump->SeekToStreamType(MD_SNAPSHOT_SERIES_STREAM, &length) ||
+      length < MDRawSnapshotSeries_minsize ||
+      !minidump->ReadBytes(series, MDRawSnapshotSeries_minsize)) {
+    return false;
+  }
+  const bool swap = minidump->swap();
+  if (swap) {
+    series->series_id.data1 = ByteSwap(series->series_id.data1);
+    series->series_id.data2 = ByteSwap(series->series_id.data2);
+    series->series_id.data3 = ByteSwap(series->series_id.data3);
+    series->sequence = ByteSwap(series->sequence);
+    series->region_count = ByteSwap(series->region_count);
+  }
+  if (!regions)
+    return true;
+  if (series->region_count > (length - MDRawSnapshotSeries_minsize) /
+                                 sizeof(MDMemoryDescriptor)) {
+    BPLOG(ERROR) << "Snapshot series regions are truncated";
+    return false;
+  }
+  regions->resize(series->region_count);
+  if (!regions->empty() &&
+      !minidump->ReadBytes(&(*regions)[0],
+                           regions->size() * sizeof(MDMemoryDescriptor))) {
+    return false;
+  }
+  if (swap) {
+    for (MDMemoryDescriptor& region : *regions) {
+      region.start_of_memory_range = ByteSwap(region.start_of_memory_range);
+      region.memory.data_size = ByteSwap(region.memory.data_size);
+      region.memory.rva = ByteSwap(region.memory.rva);
+    }
+  }
+  return true;
+}
+
+// A range of addresses, end excluded.
+struct Range {
+  uint64_t start;
+  uint64_t end;
+};
+
+// Sorts the ranges of blocks and merges those that overlap or touch.
+vector<Range> MergeRanges(const vector<MDMemoryDescriptor>& blocks) {
+  vector<Range> ranges;
+  for (const MDMemoryDescriptor& block : blocks) {
+    if (block.memory.data_size == 0 ||
+        block.start_of_memory_range > UINT64_MAX - block.memory.data_size) {
+      continue;
+    }
+    Range range = { block.start_of_memory_range,
+                    block.start_of_memory_range + block.memory.data_size };
+    ranges.push_back(range);
+  }
+  std::sort(ranges.begin(), ranges.end(),
+            [](const Range& a, const Range& b) { return a.start < b.start; });
+  size_t merged = 0;
+  for (const Range& range : ranges) {
+    if (merged > 0 && range.start <= ranges[merged - 1].end) {
+      ranges[merged - 1].end = std::max(ranges[merged - 1].end, range.end);
+    } else {
+      ranges[merged++] = range;
+    }
+  }
+  ranges.resize(merged);
+  return ranges;
+}
+
+// Copies the parts of blocks, from data, that fall within range to
+// contents, which holds range, marking the bytes copied in covered.
+void CopyBlocks(const string& data, const vector<MDMemoryDescriptor>& blocks,
+                const Range& range, string* contents,
+                vector<bool>* covered) {
+  for (const MDMemoryDescriptor& block : blocks) {
+    const uint64_t start = std::max<uint64_t>(block.start_of_memory_range,
+                                              range.start);
+    const uint64_t end = std::min<uint64_t>(
+        block.start_of_memory_range + block.memory.data_size, range.end);
+    if (start >= end)
+      continue;
+    memcpy(&(*contents)[start - range.start],
+           data.data() + block.memory.rva +
+               (start - block.start_of_memory_range),
+           end - start);
+    std::fill(covered->begin() + (start - range.start),
+              covered->begin() + (end - range.start), true);
+  }
+}
+
+// Pads minidump with zeros to a multiple of 8 bytes, as the client aligns
+// what it writes.
+void Align(string* minidump) {
+  minidump->resize((minidump->size() + 7) & ~static_cast<size_t>(7));
+}
+
+// Appends value to minidump, in the minidump's byte order.
+template<typename T>
+void Append(string* minidump, T value, bool swap) {
+  if (swap)
+    value = ByteSwap(value);
+  minidump->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// Overwrites the 32 bits at offset in minidump with value, in the
+// minidump's byte order.
+void Put(string* minidump, uint64_t offset, uint32_t value, bool swap) {
+  if (swap)
+    value = ByteSwap(value);
+  memcpy(&(*minidump)[offset], &value, sizeof(value));
+}
+
+}  // namespace
+
+bool ReadSnapshotSeries(const string& minidump, MDRawSnapshotSeries* series) {
+  SnapshotDump dump(minidump);
+  return dump.Read() && ReadSeries(&dump, series, NULL);
+}
+
+bool ReconstructSnapshot(const string& base, const string& delta,
+                         string* minidump) {
+  SnapshotDump base_dump(base);
+  SnapshotDump delta_dump(delta);
+  if (!base_dump.Read() || !delta_dump.Read())
+    return false;
+  // The streams taken from base and delta are kept as they are, so the
+  // result is in their byte order, which they must share.
+  const bool swap = base_dump.dump()->swap();
+  if (delta_dump.dump()->swap() != swap) {
+    BPLOG(ERROR) << "Snapshots are in different byte orders";
+    return false;
+  }
+
+  MDRawSnapshotSeries base_series;
+  MDRawSnapshotSeries delta_series;
+  vector<MDMemoryDescriptor> regions;
+  if (!ReadSeries(&base_dump, &base_series, NULL) ||
+      !ReadSeries(&delta_dump, &delta_series, &regions)) {
+    BPLOG(ERROR) << "Not a snapshot series";
+    return false;
+  }
+  if (memcmp(&base_series.series_id, &delta_series.series_id,
+             sizeof(MDGUID)) != 0 ||
+      base_series.sequence != 0 || delta_series.sequence == 0) {
+    BPLOG(ERROR) << "Snapshot " << delta_series.sequence
+                 << " is not a later snapshot of the series of snapshot "
+                 << base_series.sequence;
+    return false;
+  }
+
+  vector<MDMemoryDescriptor> base_blocks;
+  vector<MDMemoryDescriptor> delta_blocks;
+  if (!ReadMemoryList(&base_dump, &base_blocks) ||
+      !ReadMemoryList(&delta_dump, &delta_blocks)) {
+    return false;
+  }
+
+  // The result begins with base and delta as they are, so that the streams
+  // taken from them stay where they are but for delta's moving by
+  // delta_offset.
+  *minidump = base;
+  Align(minidump);
+  const uint64_t delta_offset = minidump->size();
+  minidump->append(delta);
+  Align(minidump);
+
+  // Then comes the memory delta captured, put together from delta's
+  // changes and base's memory.
+  vector<Range> ranges = MergeRanges(regions);
+  vector<MDMemoryDescriptor> memory;
+  for (const Range& range : ranges) {
+    string contents(range.end - range.start, '\0');
+    vector<bool> covered(contents.size(), false);
+    CopyBlocks(base, base_blocks, range, &contents, &covered);
+    CopyBlocks(delta, delta_blocks, range, &contents, &covered);
+    if (std::find(covered.begin(), covered.end(), false) != covered.end()) {
+      BPLOG(ERROR) << "Memory at " << HexString(range.start)
+                   << " is in neither snapshot";
+      return false;
+    }
+    MDMemoryDescriptor block;
+    block.start_of_memory_range = range.start;
+    block.memory.data_size = contents.size();
+    block.memory.rva = minidump->size();
+    memory.push_back(block);
+    minidump->append(contents);
+    Align(minidump);
+  }
+
+  // Base's memory outside of what delta captured stays where it is.
+  for (const MDMemoryDescriptor& block : base_blocks) {
+    uint64_t start = block.start_of_memory_range;
+    const uint64_t end = start + block.memory.data_size;
+    vector<Range>::const_iterator range = std::upper_bound(
+        ranges.begin(), ranges.end(), start,
+        [](uint64_t address, const Range& r) { return address < r.end; });
+    while (start < end) {
+      const uint64_t piece_end =
+          range == ranges.end() ? end : std::min(end, range->start);
+      if (start < piece_end) {
+        MDMemoryDescriptor piece;
+        piece.start_of_memory_range = start;
+        piece.memory.data_size = piece_end - start;
+        piece.memory.rva =
+            block.memory.rva + (start - block.start_of_memory_range);
+        memory.push_back(piece);
+      }
+      if (range == ranges.end())
+        break;
+      start = std::max(start, range->end);
+      ++range;
+    }
+  }
+  std::sort(memory.begin(), memory.end(),
+            [](const MDMemoryDescriptor& a, const MDMemoryDescriptor& b) {
+              return a.start_of_memory_range < b.start_of_memory_range;
+            });
+
+  // Point delta's threads at their contexts and stacks in the result.
+  if (const MDRawDirectory* entry =
+          delta_dump.FindStream(MD_THREAD_LIST_STREAM)) {
+    MinidumpThreadList* threads = delta_dump.dump()->GetThreadList();
+    if (!threads) {
+      BPLOG(ERROR) << "Thread list is malformed";
+      return false;
+    }
+    // The threads are the end of the stream, after the count and any
+    // padding.
+    const uint32_t count = threads->thread_count();
+    const uint64_t list = delta_offset + entry->location.rva +
+                          entry->location.data_size -
+                          static_cast<uint64_t>(count) * sizeof(MDRawThread);
+    for (uint32_t i = 0; i < count; ++i) {
+      const MDRawThread* thread = threads->GetThreadAtIndex(i)->thread();
+      const uint64_t offset = list + i * sizeof(MDRawThread);
+      if (thread->thread_context.data_size > 0) {
+        Put(minidump,
+            offset + offsetof(MDRawThread, thread_context) +
+                offsetof(MDLocationDescriptor, rva),
+            thread->thread_context.rva + delta_offset, swap);
+      }
+      uint32_t stack_rva = thread->stack.memory.rva;
+      if (thread->stack.memory.data_size > 0 && stack_rva == 0) {
+        const uint64_t start = thread->stack.start_of_memory_range;
+        vector<MDMemoryDescriptor>::const_iterator block = std::find_if(
+            memory.begin(), memory.end(),
+            [start](const MDMemoryDescriptor& b) {
+              return start >= b.start_of_memory_range &&
+                     start - b.start_of_memory_range < b.memory.data_size;
+            });
+        if (block == memory.end() ||
+            thread->stack.memory.data_size >
+                block->memory.data_size -
+                    (start - block->start_of_memory_range)) {
+          BPLOG(ERROR) << "Stack of thread " << thread->thread_id
+                       << " is not in the snapshot";
+          return false;
+        }
+        stack_rva =
+            block->memory.rva + (start - block->start_of_memory_range);
+      } else {
+        stack_rva += delta_offset;
+      }
+      Put(minidump,
+          offset + offsetof(MDRawThread, stack) +
+              offsetof(MDMemoryDescriptor, memory) +
+              offsetof(MDLocationDescriptor, rva),
+          stack_rva, swap);
+    }
+  }
+  if (const MDRawDirectory* entry =
+          delta_dump.FindStream(MD_EXCEPTION_STREAM)) {
+    MinidumpException* exception = delta_dump.dump()->GetException();
+    if (exception &&
+        exception->exception()->thread_context.data_size > 0) {
+      Put(minidump,
+          delta_offset + entry->location.rva +
+              offsetof(MDRawExceptionStream, thread_context) +
+              offsetof(MDLocationDescriptor, rva),
+          exception->exception()->thread_context.rva + delta_offset, swap);
+    }
+  }
+  // The result is complete, so it has no regions.
+  if (const MDRawDirectory* entry =
+          delta_dump.FindStream(MD_SNAPSHOT_SERIES_STREAM)) {
+    Put(minidump,
+        delta_offset + entry->location.rva +
+            offsetof(MDRawSnapshotSeries, region_count),
+        0, swap);
+  }
+
+  MDRawDirectory memory_entry;
+  memory_entry.stream_type = MD_MEMORY_LIST_STREAM;
+  memory_entry.location.rva = minidump->size();
+  memory_entry.location.data_size =
+      sizeof(uint32_t) + memory.size() * sizeof(MDMemoryDescriptor);
+  Append(minidump, static_cast<uint32_t>(memory.size()), swap);
+  for (const MDMemoryDescriptor& block : memory) {
+    Append(minidump, block.start_of_memory_range, swap);
+    Append(minidump, block.memory.data_size, swap);
+    Append(minidump, block.memory.rva, swap);
+  }
+  Align(minidump);
+
+  // The streams delta replaces, or that the result can't keep.
+  static const uint32_t kDeltaStreams[] = {
+    MD_THREAD_LIST_STREAM,
+    MD_EXCEPTION_STREAM,
+    MD_SNAPSHOT_SERIES_STREAM,
+    MD_DUMP_TIMING_STREAM
+  };
+  const uint32_t* const kDeltaStreamsEnd =
+      kDeltaStreams + sizeof(kDeltaStreams) / sizeof(kDeltaStreams[0]);
+  vector<MDRawDirectory> directory;
+  Minidump* base_minidump = base_dump.dump();
+  for (unsigned int i = 0; i < base_minidump->GetDirectoryEntryCount(); ++i) {
+    const MDRawDirectory* entry = base_minidump->GetDirectoryEntryAtIndex(i);
+    if (entry->stream_type != MD_UNUSED_STREAM &&
+        entry->stream_type != MD_MEMORY_LIST_STREAM &&
+        entry->stream_type != MD_LINUX_INCONSISTENT_MEMORY &&
+        std::find(kDeltaStreams, kDeltaStreamsEnd, entry->stream_type) ==
+            kDeltaStreamsEnd) {
+      directory.push_back(*entry);
+    }
+  }
+  Minidump* delta_minidump = delta_dump.dump();
+  for (unsigned int i = 0; i < delta_minidump->GetDirectoryEntryCount();
+       ++i) {
+    const MDRawDirectory* entry = delta_minidump->GetDirectoryEntryAtIndex(i);
+    if (std::find(kDeltaStreams, kDeltaStreamsEnd, entry->stream_type) !=
+        kDeltaStreamsEnd) {
+      MDRawDirectory moved = *entry;
+      moved.location.rva += delta_offset;
+      directory.push_back(moved);
+    }
+  }
+  directory.push_back(memory_entry);
+
+  const uint64_t directory_rva = minidump->size();
+  for (const MDRawDirectory& entry : directory) {
+    Append(minidump, entry.stream_type, swap);
+    Append(minidump, entry.location.data_size, swap);
+    Append(minidump, entry.location.rva, swap);
+  }
+  if (minidump->size() > UINT32_MAX) {
+    BPLOG(ERROR) << "Reconstructed snapshot is too large for a minidump";
+    return false;
+  }
+  // The header is base's, but for the directory and delta's time.
+  Put(minidump, offsetof(MDRawHeader, stream_count), directory.size(), swap);
+  Put(minidump, offsetof(MDRawHeader, stream_directory_rva), directory_rva,
+      swap);
+  Put(minidump, offsetof(MDRawHeader, time_date_stamp),
+      delta_minidump->header()->time_date_stamp, swap);
+  return true;
+}
+
+}  // namespace google_breakpad
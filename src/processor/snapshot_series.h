@@ -0,0 +1,70 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// snapshot_series.h: Putting the snapshots of a series back together.
+//
+// A series of snapshots of a process, as the Linux client's
+// MinidumpSnapshotSeries writes them, begins with a complete minidump.
+// Each later snapshot, a delta, holds only the threads' registers and the
+// pages of memory whose contents changed since the first snapshot, so a
+// snapshot series is cheap to store; see MD_SNAPSHOT_SERIES_STREAM.
+// ReconstructSnapshot() combines a delta with the first snapshot into a
+// complete minidump, which can be read with Minidump(std::istream&) and
+// processed as usual.
+//
+// The snapshots are read with Minidump, so they may be in either byte
+// order; the reconstructed minidump is in theirs.
+
+#ifndef PROCESSOR_SNAPSHOT_SERIES_H__
+#define PROCESSOR_SNAPSHOT_SERIES_H__
+
+#include <string>
+
+#include "common/using_std_string.h"
+#include "google_breakpad/common/minidump_format.h"
+
+namespace google_breakpad {
+
+// Sets series to the MD_SNAPSHOT_SERIES_STREAM of minidump, the contents
+// of a minidump file, leaving out its regions.  Returns false if minidump
+// has no such stream.
+bool ReadSnapshotSeries(const string& minidump, MDRawSnapshotSeries* series);
+
+// Sets minidump to the complete minidump of the snapshot in delta, from
+// the streams of delta and of base, the first snapshot of the same series:
+// the thread list, exception and timing streams of delta, the rest of the
+// streams of base, and a memory list holding delta's stacks and memory
+// regions as they were when delta was taken, along with base's memory
+// outside of them.  Returns false if delta is not a later snapshot of
+// base's series, or either is malformed.
+bool ReconstructSnapshot(const string& base, const string& delta,
+                         string* minidump);
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_SNAPSHOT_SERIES_H__
@@ -0,0 +1,248 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// snapshot_series_unittest.cc: Unit tests for ReconstructSnapshot.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <string.h>
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/common/minidump_format.h"
+#include "google_breakpad/processor/minidump.h"
+#include "processor/snapshot_series.h"
+#include "processor/synth_minidump.h"
+
+namespace {
+
+using google_breakpad::Minidump;
+using google_breakpad::MinidumpMemoryList;
+using google_breakpad::MinidumpMemoryRegion;
+using google_breakpad::MinidumpThread;
+using google_breakpad::MinidumpThreadList;
+using google_breakpad::ReadSnapshotSeries;
+using google_breakpad::ReconstructSnapshot;
+using google_breakpad::SynthMinidump::Context;
+using google_breakpad::SynthMinidump::Dump;
+using google_breakpad::SynthMinidump::Memory;
+using google_breakpad::SynthMinidump::Stream;
+using google_breakpad::SynthMinidump::Thread;
+using google_breakpad::test_assembler::Endianness;
+using google_breakpad::test_assembler::kBigEndian;
+using google_breakpad::test_assembler::kLittleEndian;
+using std::istringstream;
+
+const uint32_t kThreadId = 0x1a2b;
+const uint64_t kStackStart = 0x10000;
+const size_t kPage = 0x1000;
+const uint64_t kHeapStart = 0x40000;
+
+// An MD_SNAPSHOT_SERIES_STREAM of the series series_id, whose regions are
+// the stack, if stack_size is not 0.
+class SeriesStream : public Stream {
+ public:
+  SeriesStream(const Dump& dump, uint32_t series_id, uint32_t sequence,
+               size_t stack_size)
+      : Stream(dump, MD_SNAPSHOT_SERIES_STREAM) {
+    D32(series_id).D16(0).D16(0).Append(8, 0);
+    D32(sequence).D32(stack_size ? 1 : 0);
+    if (stack_size)
+      D64(kStackStart).D32(stack_size).D32(0);
+  }
+};
+
+// A thread context whose instruction pointer is ip: x86 in a little-endian
+// dump, and MIPS, which may be big-endian, otherwise.
+std::unique_ptr<Context> MakeContext(const Dump& dump, uint32_t ip) {
+  if (dump.endianness() == kLittleEndian) {
+    MDRawContextX86 raw_context = {};
+    raw_context.context_flags =
+        MD_CONTEXT_X86_INTEGER | MD_CONTEXT_X86_CONTROL;
+    raw_context.eip = ip;
+    return std::unique_ptr<Context>(new Context(dump, raw_context));
+  }
+  MDRawContextMIPS raw_context = {};
+  raw_context.context_flags = MD_CONTEXT_MIPS_FULL;
+  raw_context.epc = ip;
+  return std::unique_ptr<Context>(new Context(dump, raw_context));
+}
+
+// The first snapshot: a thread whose two page stack holds 'a's then 'b's,
+// and a page of heap holding 'h's.
+string MakeBase(uint32_t series_id, Endianness endianness = kLittleEndian) {
+  Dump dump(0, endianness);
+  Memory stack(dump, kStackStart);
+  stack.Append(kPage, 'a').Append(kPage, 'b');
+  Memory heap(dump, kHeapStart);
+  heap.Append(kPage, 'h');
+  std::unique_ptr<Context> context = MakeContext(dump, 0x1111);
+  Thread thread(dump, kThreadId, stack, *context);
+  SeriesStream series(dump, series_id, 0, 0);
+  dump.Add(&stack);
+  dump.Add(&heap);
+  dump.Add(context.get());
+  dump.Add(&thread);
+  dump.Add(&series);
+  dump.Finish();
+  string contents;
+  EXPECT_TRUE(dump.GetContents(&contents));
+  return contents;
+}
+
+// A later snapshot in which the thread's registers changed, and the second
+// page of its stack now holds 'c's.  If omit_change, the changed page is
+// missing from the delta.
+string MakeDelta(uint32_t series_id, bool omit_change,
+                 Endianness endianness = kLittleEndian) {
+  Dump dump(0, endianness);
+  Memory changed(dump, kStackStart + kPage);
+  changed.Append(kPage, 'c');
+  std::unique_ptr<Context> context = MakeContext(dump, 0x2222);
+  // The thread's stack has no contents of its own in a delta.
+  Stream threads(dump, MD_THREAD_LIST_STREAM);
+  threads.D32(1).D32(kThreadId).D32(0).D32(0).D32(0).D64(0);
+  threads.D64(kStackStart).D32(2 * kPage).D32(0);
+  context->CiteLocationIn(&threads);
+  SeriesStream series(dump, series_id, 1, 2 * kPage);
+  if (!omit_change)
+    dump.Add(&changed);
+  dump.Add(context.get());
+  dump.Add(&threads);
+  dump.Add(&series);
+  dump.Finish();
+  string contents;
+  EXPECT_TRUE(dump.GetContents(&contents));
+  return contents;
+}
+
+TEST(SnapshotSeries, ReadSeries) {
+  MDRawSnapshotSeries series;
+  ASSERT_TRUE(ReadSnapshotSeries(MakeDelta(7, false), &series));
+  EXPECT_EQ(7U, series.series_id.data1);
+  EXPECT_EQ(1U, series.sequence);
+  EXPECT_EQ(1U, series.region_count);
+
+  Dump dump(0, kLittleEndian);
+  dump.Finish();
+  string plain;
+  ASSERT_TRUE(dump.GetContents(&plain));
+  EXPECT_FALSE(ReadSnapshotSeries(plain, &series));
+}
+
+// Checks that reconstructed is the delta of MakeDelta put together with
+// the first snapshot of MakeBase.
+void CheckReconstructed(const string& reconstructed) {
+
+  MDRawSnapshotSeries series;
+  ASSERT_TRUE(ReadSnapshotSeries(reconstructed, &series));
+  EXPECT_EQ(1U, series.sequence);
+  EXPECT_EQ(0U, series.region_count);
+
+  istringstream stream(reconstructed);
+  Minidump minidump(stream);
+  ASSERT_TRUE(minidump.Read());
+
+  MinidumpThreadList* threads = minidump.GetThreadList();
+  ASSERT_TRUE(threads);
+  ASSERT_EQ(1U, threads->thread_count());
+  MinidumpThread* thread = threads->GetThreadAtIndex(0);
+  uint64_t eip;
+  ASSERT_TRUE(thread->GetContext()->GetInstructionPointer(&eip));
+  EXPECT_EQ(0x2222U, eip);
+
+  MinidumpMemoryRegion* stack = thread->GetMemory();
+  ASSERT_TRUE(stack);
+  EXPECT_EQ(kStackStart, stack->GetBase());
+  ASSERT_EQ(2 * kPage, stack->GetSize());
+  const string expected_stack = string(kPage, 'a') + string(kPage, 'c');
+  EXPECT_EQ(0, memcmp(expected_stack.data(), stack->GetMemory(),
+                      expected_stack.size()));
+
+  // The heap didn't change, so it is the first snapshot's.
+  MinidumpMemoryList* memory = minidump.GetMemoryList();
+  ASSERT_TRUE(memory);
+  MinidumpMemoryRegion* heap = memory->GetMemoryRegionForAddress(kHeapStart);
+  ASSERT_TRUE(heap);
+  ASSERT_EQ(kPage, heap->GetSize());
+  EXPECT_EQ(0, memcmp(string(kPage, 'h').data(), heap->GetMemory(), kPage));
+}
+
+TEST(SnapshotSeries, Reconstruct) {
+  string reconstructed;
+  ASSERT_TRUE(ReconstructSnapshot(MakeBase(7), MakeDelta(7, false),
+                                  &reconstructed));
+  CheckReconstructed(reconstructed);
+}
+
+TEST(SnapshotSeries, ReconstructBigEndian) {
+  string reconstructed;
+  ASSERT_TRUE(ReconstructSnapshot(MakeBase(7, kBigEndian),
+                                  MakeDelta(7, false, kBigEndian),
+                                  &reconstructed));
+  CheckReconstructed(reconstructed);
+
+  // The snapshots must share a byte order.
+  EXPECT_FALSE(ReconstructSnapshot(MakeBase(7),
+                                   MakeDelta(7, false, kBigEndian),
+                                   &reconstructed));
+}
+
+TEST(SnapshotSeries, RejectOtherSeries) {
+  string reconstructed;
+  EXPECT_FALSE(ReconstructSnapshot(MakeBase(7), MakeDelta(8, false),
+                                   &reconstructed));
+  // A snapshot isn't a delta against itself.
+  EXPECT_FALSE(ReconstructSnapshot(MakeBase(7), MakeBase(7),
+                                   &reconstructed));
+}
+
+TEST(SnapshotSeries, RejectMissingMemory) {
+  // Without a heap covering the stack in the first snapshot either.
+  Dump dump(0, kLittleEndian);
+  SeriesStream series(dump, 7, 0, 0);
+  dump.Add(&series);
+  dump.Finish();
+  string base;
+  ASSERT_TRUE(dump.GetContents(&base));
+
+  string reconstructed;
+  EXPECT_FALSE(ReconstructSnapshot(base, MakeDelta(7, false),
+                                   &reconstructed));
+  // The unchanged page is enough from the first snapshot.
+  EXPECT_TRUE(ReconstructSnapshot(MakeBase(7), MakeDelta(7, true),
+                                  &reconstructed));
+}
+
+}  // namespace
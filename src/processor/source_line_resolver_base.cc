@@ -42,12 +42,16 @@
 #include <sys/stat.h>
 
 #include <map>
+#include <mutex>
+#include <shared_mutex>
 #include <utility>
 
 #include "google_breakpad/processor/source_line_resolver_base.h"
+#include "processor/compressed_symbol_file.h"
 #include "processor/logging.h"
 #include "processor/module_factory.h"
 #include "processor/source_line_resolver_base_types.h"
+#include "processor/symbol_file_index.h"
 
 using std::make_pair;
 
@@ -56,9 +60,17 @@ namespace google_breakpad {
 SourceLineResolverBase::SourceLineResolverBase(
     ModuleFactory* module_factory)
   : modules_(new ModuleMap),
+    symbol_modules_(new ModuleMap),
     corrupt_modules_(new ModuleSet),
-    memory_buffers_(new MemoryMap),
-    module_factory_(module_factory) {
+    symbol_buffers_(new SymbolBufferMap),
+    module_factory_(module_factory),
+    memory_budget_(0),
+    memory_usage_(0),
+    huge_pages_(false),
+    use_clock_(0),
+    cache_hits_(0),
+    cache_misses_(0),
+    cache_evictions_(0) {
 }
 
 SourceLineResolverBase::~SourceLineResolverBase() {
@@ -72,17 +84,20 @@ SourceLineResolverBase::~SourceLineResolverBase() {
   delete modules_;
   modules_ = NULL;
 
+  // Delete the symbol parts of modules loaded in parts.
+  for (it = symbol_modules_->begin(); it != symbol_modules_->end(); ++it) {
+    delete it->second;
+  }
+  delete symbol_modules_;
+  symbol_modules_ = NULL;
+
   // Delete the set of corrupt modules.
   delete corrupt_modules_;
   corrupt_modules_ = NULL;
 
-  MemoryMap::iterator iter = memory_buffers_->begin();
-  for (; iter != memory_buffers_->end(); ++iter) {
-    delete [] iter->second;
-  }
-  // Delete the map of memory buffers.
-  delete memory_buffers_;
-  memory_buffers_ = NULL;
+  // Release the symbol data the modules referred to.
+  delete symbol_buffers_;
+  symbol_buffers_ = NULL;
 
   delete module_factory_;
   module_factory_ = NULL;
@@ -96,6 +111,17 @@ bool SourceLineResolverBase::ReadSymbolFile(const string& map_file,
     return false;
   }
 
+  if (IsCompressedSymbolFile(map_file)) {
+    string contents;
+    if (!ReadCompressedSymbolFile(map_file, &contents))
+      return false;
+    *symbol_data_size = contents.size() + 1;
+    *symbol_data = new char[*symbol_data_size];
+    memcpy(*symbol_data, contents.data(), contents.size());
+    (*symbol_data)[contents.size()] = '\0';
+    return true;
+  }
+
   struct stat buf;
   int error_code = stat(map_file.c_str(), &buf);
   if (error_code == -1) {
@@ -157,7 +183,7 @@ bool SourceLineResolverBase::LoadModule(const CodeModule* module,
     return false;
 
   // Make sure we don't already have a module with the given name.
-  if (modules_->find(module->code_file()) != modules_->end()) {
+  if (IsModuleLoaded(module->code_file())) {
     BPLOG(INFO) << "Symbols for module " << module->code_file()
                 << " already loaded";
     return false;
@@ -166,6 +192,21 @@ bool SourceLineResolverBase::LoadModule(const CodeModule* module,
   BPLOG(INFO) << "Loading symbols for module " << module->code_file()
               << " from " << map_file;
 
+  // Parse uncompressed files from a private mapping of the file rather than
+  // from a copy read onto the heap.  The module overwrites the last byte
+  // with a null terminator, so a file that doesn't end in a line break or a
+  // null is read as before, to keep its last record whole.
+  struct stat buf;
+  if (!IsCompressedSymbolFile(map_file) &&
+      stat(map_file.c_str(), &buf) == 0 && buf.st_size > 0) {
+    std::shared_ptr<SymbolBuffer> mapping = SymbolBuffer::MapFile(map_file);
+    if (mapping) {
+      char last = mapping->data()[mapping->size() - 1];
+      if (last == '\n' || last == '\0')
+        return LoadModuleInternal(module, mapping, NULL /* index */);
+    }
+  }
+
   char* memory_buffer;
   size_t memory_buffer_size;
   if (!ReadSymbolFile(map_file, &memory_buffer, &memory_buffer_size))
@@ -175,17 +216,9 @@ bool SourceLineResolverBase::LoadModule(const CodeModule* module,
               << "module = " << module->code_file()
               << ", memory_buffer_size = " << memory_buffer_size;
 
-  bool load_result = LoadModuleUsingMemoryBuffer(module, memory_buffer,
-                                                 memory_buffer_size);
-
-  if (load_result && !ShouldDeleteMemoryBufferAfterLoadModule()) {
-    // memory_buffer has to stay alive as long as the module.
-    memory_buffers_->insert(make_pair(module->code_file(), memory_buffer));
-  } else {
-    delete [] memory_buffer;
-  }
-
-  return load_result;
+  return LoadModuleInternal(
+      module, SymbolBuffer::AdoptArray(memory_buffer, memory_buffer_size),
+      NULL /* index */);
 }
 
 bool SourceLineResolverBase::LoadModuleUsingMapBuffer(
@@ -197,7 +230,7 @@ bool SourceLineResolverBase::LoadModuleUsingMapBuffer(
     return false;
 
   // Make sure we don't already have a module with the given name.
-  if (modules_->find(module->code_file()) != modules_->end()) {
+  if (IsModuleLoaded(module->code_file())) {
     BPLOG(INFO) << "Symbols for module " << module->code_file()
                 << " already loaded";
     return false;
@@ -214,28 +247,125 @@ bool SourceLineResolverBase::LoadModuleUsingMapBuffer(
   memcpy(memory_buffer, map_buffer.c_str(), map_buffer.size());
   memory_buffer[map_buffer.size()] = '\0';
 
-  bool load_result = LoadModuleUsingMemoryBuffer(module, memory_buffer,
-                                                 memory_buffer_size);
+  return LoadModuleInternal(
+      module, SymbolBuffer::AdoptArray(memory_buffer, memory_buffer_size),
+      NULL /* index */);
+}
 
-  if (load_result && !ShouldDeleteMemoryBufferAfterLoadModule()) {
-    // memory_buffer has to stay alive as long as the module.
-    memory_buffers_->insert(make_pair(module->code_file(), memory_buffer));
-  } else {
-    delete [] memory_buffer;
-  }
+bool SourceLineResolverBase::LoadModuleUsingMemoryBuffer(
+    const CodeModule* module,
+    char* memory_buffer,
+    size_t memory_buffer_size) {
+  return LoadModuleInternal(
+      module, SymbolBuffer::Borrow(memory_buffer, memory_buffer_size),
+      NULL /* index */);
+}
 
-  return load_result;
+bool SourceLineResolverBase::LoadModuleUsingSymbolBuffer(
+    const CodeModule* module,
+    const std::shared_ptr<SymbolBuffer>& symbol_buffer) {
+  return LoadModuleInternal(module, symbol_buffer, NULL /* index */);
 }
 
-bool SourceLineResolverBase::LoadModuleUsingMemoryBuffer(
+bool SourceLineResolverBase::LoadModuleUnwindInfoUsingMemoryBuffer(
+    const CodeModule* module,
+    char* memory_buffer,
+    size_t memory_buffer_size) {
+  return LoadModulePart(module, memory_buffer, memory_buffer_size,
+                        true /* unwind_info */);
+}
+
+bool SourceLineResolverBase::LoadModuleSymbolsUsingMemoryBuffer(
     const CodeModule* module,
     char* memory_buffer,
     size_t memory_buffer_size) {
+  return LoadModulePart(module, memory_buffer, memory_buffer_size,
+                        false /* unwind_info */);
+}
+
+bool SourceLineResolverBase::LoadModuleUsingMappedFile(
+    const CodeModule* module, const string& map_file) {
+  if (module == NULL)
+    return false;
+
+  // Make sure we don't already have a module with the given name.
+  if (IsModuleLoaded(module->code_file())) {
+    BPLOG(INFO) << "Symbols for module " << module->code_file()
+                << " already loaded";
+    return false;
+  }
+
+  BPLOG(INFO) << "Mapping symbols for module " << module->code_file()
+              << " from " << map_file;
+
+  std::shared_ptr<SymbolBuffer> mapping = SymbolBuffer::MapFile(map_file);
+  if (!mapping)
+    return false;
+
+  return LoadModuleInternal(module, mapping, NULL /* index */);
+}
+
+bool SourceLineResolverBase::LoadModuleUsingIndexedFile(
+    const CodeModule* module, const string& map_file) {
+  if (module == NULL)
+    return false;
+
+  // Without a usable index, load the whole file as LoadModule() does.
+  SymbolFileIndex index;
+  if (!index.ReadFile(map_file + kSymbolFileIndexExtension)) {
+    BPLOG(INFO) << "No usable index for " << map_file
+                << ", loading all of it";
+    return LoadModule(module, map_file);
+  }
+
+  // Make sure we don't already have a module with the given name.
+  if (IsModuleLoaded(module->code_file())) {
+    BPLOG(INFO) << "Symbols for module " << module->code_file()
+                << " already loaded";
+    return false;
+  }
+
+  BPLOG(INFO) << "Mapping indexed symbols for module " << module->code_file()
+              << " from " << map_file;
+
+  std::shared_ptr<SymbolBuffer> mapping = SymbolBuffer::MapFile(map_file);
+  if (!mapping)
+    return false;
+  if (mapping->size() != index.symbol_file_size()) {
+    // The symbol file changed since it was indexed.
+    BPLOG(INFO) << "Index for " << map_file << " is stale, loading all of it";
+    mapping.reset();
+    return LoadModule(module, map_file);
+  }
+
+  return LoadModuleInternal(module, mapping, &index);
+}
+
+bool SourceLineResolverBase::LoadModuleInternal(
+    const CodeModule* module,
+    const std::shared_ptr<SymbolBuffer>& loaded_symbol_buffer,
+    const SymbolFileIndex* index) {
   if (!module)
     return false;
 
+  // The symbol data is released right after parsing, unless the module
+  // refers to it, in which case it lives as long as the module.  An indexed
+  // module always refers to it.  Symbol data that is kept is moved to huge
+  // pages before the module refers to it, if they are wanted.
+  std::shared_ptr<SymbolBuffer> symbol_buffer = loaded_symbol_buffer;
+  bool keep_symbol_buffer =
+      !symbol_buffer->borrowed() &&
+      (index || !ShouldDeleteMemoryBufferAfterLoadModule());
+  if (keep_symbol_buffer && huge_pages_ &&
+      symbol_buffer->size() >= SymbolBuffer::kHugePageSize &&
+      !IsModuleLoaded(module->code_file())) {
+    symbol_buffer = SymbolBuffer::CopyToHugePages(symbol_buffer);
+  }
+  char* memory_buffer = symbol_buffer->data();
+  size_t memory_buffer_size = symbol_buffer->size();
+
   // Make sure we don't already have a module with the given name.
-  if (modules_->find(module->code_file()) != modules_->end()) {
+  if (IsModuleLoaded(module->code_file())) {
     BPLOG(INFO) << "Symbols for module " << module->code_file()
                 << " already loaded";
     return false;
@@ -246,19 +376,139 @@ bool SourceLineResolverBase::LoadModuleUsingMemoryBuffer(
 
   Module* basic_module = module_factory_->CreateModule(module->code_file());
 
-  // Ownership of memory is NOT transfered to Module::LoadMapFromMemory().
-  if (!basic_module->LoadMapFromMemory(memory_buffer, memory_buffer_size)) {
-    BPLOG(ERROR) << "Too many error while parsing symbol data for module "
-                 << module->code_file();
-    // Returning false from here would be an indication that the symbols for
-    // this module are missing which would be wrong.  Intentionally fall through
-    // and add the module to both the modules_ and the corrupt_modules_ lists.
+  // Only the records outside the indexed blocks are accounted to an indexed
+  // module: the blocks are parsed as they are used, from the mapping, whose
+  // pages the system can reclaim.
+  size_t memory_usage = memory_buffer_size;
+  if (index) {
+    if (!basic_module->LoadMapFromIndexedFile(memory_buffer,
+                                              memory_buffer_size, *index)) {
+      BPLOG(ERROR) << "Could not load indexed symbol data for module "
+                   << module->code_file();
+      delete basic_module;
+      return false;
+    }
+    memory_usage -= index->IndexedLength();
+  } else {
+    // Text symbol data is parsed in one pass and then, unless it is kept,
+    // never looked at again.
+    if (ShouldDeleteMemoryBufferAfterLoadModule())
+      symbol_buffer->AdviseSequential();
+    if (!basic_module->LoadMapFromMemory(memory_buffer, memory_buffer_size)) {
+      // Ownership of memory is NOT transfered to Module::LoadMapFromMemory().
+      BPLOG(ERROR) << "Too many error while parsing symbol data for module "
+                   << module->code_file();
+      // Returning false from here would be an indication that the symbols
+      // for this module are missing which would be wrong.  Intentionally
+      // fall through and add the module to both the modules_ and the
+      // corrupt_modules_ lists.
+    }
   }
 
-  modules_->insert(make_pair(module->code_file(), basic_module));
+  // Parsing happens outside of the lock, so lookups in other modules carry
+  // on meanwhile.  Another thread may have loaded the same module since the
+  // check above, in which case its copy is kept.
+  std::unique_lock<std::shared_mutex> writer_lock(modules_lock_);
+  if (!modules_->insert(make_pair(module->code_file(), basic_module)).second) {
+    BPLOG(INFO) << "Symbols for module " << module->code_file()
+                << " already loaded";
+    delete basic_module;
+    return false;
+  }
   if (basic_module->IsCorrupt()) {
     corrupt_modules_->insert(module->code_file());
   }
+  if (keep_symbol_buffer) {
+    // The symbol data has to stay alive as long as the module.
+    (*symbol_buffers_)[module->code_file()] = symbol_buffer;
+  }
+
+  basic_module->memory_usage_ = memory_usage;
+  basic_module->last_use_.store(++use_clock_, std::memory_order_relaxed);
+  memory_usage_ += memory_usage;
+  EvictModules(basic_module);
+  return true;
+}
+
+bool SourceLineResolverBase::LoadModulePart(const CodeModule* module,
+                                            char* memory_buffer,
+                                            size_t memory_buffer_size,
+                                            bool unwind_info) {
+  if (!module)
+    return false;
+
+  if (unwind_info) {
+    // Make sure we don't already have a module with the given name.
+    if (IsModuleLoaded(module->code_file())) {
+      BPLOG(INFO) << "Symbols for module " << module->code_file()
+                  << " already loaded";
+      return false;
+    }
+  } else {
+    // The unwind part must be loaded, without the symbol part.
+    std::shared_lock<std::shared_mutex> reader_lock(modules_lock_);
+    ModuleMap::const_iterator it = symbol_modules_->find(module->code_file());
+    if (it == symbol_modules_->end() || it->second) {
+      BPLOG(INFO) << "No unwind information without symbols loaded for "
+                  << "module " << module->code_file();
+      return false;
+    }
+  }
+
+  BPLOG(INFO) << "Loading " << (unwind_info ? "unwind information" : "symbols")
+              << " for module " << module->code_file()
+              << " from memory buffer, size: " << memory_buffer_size;
+
+  Module* part_module = module_factory_->CreateModule(module->code_file());
+  if (!part_module->CanLoadMapParts()) {
+    // Modules that can't be loaded in parts are loaded whole, symbols and
+    // all.
+    delete part_module;
+    return unwind_info &&
+           LoadModuleUsingMemoryBuffer(module, memory_buffer,
+                                       memory_buffer_size);
+  }
+
+  size_t part_size = 0;
+  if (!part_module->LoadMapPartFromMemory(
+          memory_buffer, memory_buffer_size,
+          unwind_info ? Module::UNWIND_RECORDS : Module::SYMBOL_RECORDS,
+          &part_size)) {
+    BPLOG(ERROR) << "Too many error while parsing symbol data for module "
+                 << module->code_file();
+    // As in LoadModuleInternal(), the module is loaded anyway, as corrupt.
+  }
+
+  // The state checked above may have changed while parsing.
+  std::unique_lock<std::shared_mutex> writer_lock(modules_lock_);
+  if (unwind_info) {
+    if (!modules_->insert(make_pair(module->code_file(),
+                                    part_module)).second) {
+      BPLOG(INFO) << "Symbols for module " << module->code_file()
+                  << " already loaded";
+      delete part_module;
+      return false;
+    }
+    symbol_modules_->insert(make_pair(module->code_file(),
+                                      static_cast<Module*>(NULL)));
+    if (part_module->IsCorrupt()) {
+      corrupt_modules_->insert(module->code_file());
+    }
+  } else {
+    ModuleMap::iterator it = symbol_modules_->find(module->code_file());
+    if (it == symbol_modules_->end() || it->second) {
+      delete part_module;
+      return false;
+    }
+    // IsModuleCorrupt() asks the symbol part itself, which may be evicted
+    // on its own.
+    it->second = part_module;
+  }
+
+  part_module->memory_usage_ = part_size;
+  part_module->last_use_.store(++use_clock_, std::memory_order_relaxed);
+  memory_usage_ += part_size;
+  EvictModules(part_module);
   return true;
 }
 
@@ -270,45 +520,203 @@ void SourceLineResolverBase::UnloadModule(const CodeModule* code_module) {
   if (!code_module)
     return;
 
+  std::unique_lock<std::shared_mutex> writer_lock(modules_lock_);
   ModuleMap::iterator mod_iter = modules_->find(code_module->code_file());
   if (mod_iter != modules_->end()) {
-    Module* symbol_module = mod_iter->second;
-    delete symbol_module;
-    corrupt_modules_->erase(mod_iter->first);
-    modules_->erase(mod_iter);
+    EraseModule(mod_iter);
   }
+}
 
-  if (ShouldDeleteMemoryBufferAfterLoadModule()) {
-    // No-op.  Because we never store any memory buffers.
-  } else {
-    // There may be a buffer stored locally, we need to find and delete it.
-    MemoryMap::iterator iter = memory_buffers_->find(code_module->code_file());
-    if (iter != memory_buffers_->end()) {
-      delete [] iter->second;
-      memory_buffers_->erase(iter);
+void SourceLineResolverBase::EraseModule(ModuleMap::iterator mod_iter) {
+  // Keep a copy of the name: it is owned by the map entry erased below.
+  string code_file = mod_iter->first;
+  Module* symbol_module = mod_iter->second;
+  memory_usage_ -= symbol_module->memory_usage_;
+  delete symbol_module;
+  corrupt_modules_->erase(code_file);
+  modules_->erase(mod_iter);
+
+  ModuleMap::iterator symbol_iter = symbol_modules_->find(code_file);
+  if (symbol_iter != symbol_modules_->end()) {
+    if (symbol_iter->second)
+      EraseSymbolModule(symbol_iter);
+    symbol_modules_->erase(symbol_iter);
+  }
+
+  // Release the symbol data the module referred to, if it was kept.
+  symbol_buffers_->erase(code_file);
+}
+
+void SourceLineResolverBase::EraseSymbolModule(
+    ModuleMap::iterator symbol_iter) {
+  memory_usage_ -= symbol_iter->second->memory_usage_;
+  delete symbol_iter->second;
+  symbol_iter->second = NULL;
+}
+
+void SourceLineResolverBase::EvictModules(const Module* keep) {
+  while (memory_budget_ && memory_usage_ > memory_budget_) {
+    // Find the least recently used symbol part other than |keep|, and the
+    // code file of the module |keep| is a part of, if any.
+    ModuleMap::iterator victim = symbol_modules_->end();
+    uint64_t victim_last_use = 0;
+    const string* keep_code_file = NULL;
+    for (ModuleMap::iterator it = symbol_modules_->begin();
+         it != symbol_modules_->end(); ++it) {
+      if (!it->second)
+        continue;
+      if (it->second == keep) {
+        keep_code_file = &it->first;
+        continue;
+      }
+      uint64_t last_use = it->second->last_use_.load(std::memory_order_relaxed);
+      if (victim == symbol_modules_->end() || last_use < victim_last_use) {
+        victim = it;
+        victim_last_use = last_use;
+      }
+    }
+    if (victim != symbol_modules_->end()) {
+      BPLOG(INFO) << "Evicting symbols, keeping unwind information, for "
+                  << "module " << victim->first
+                  << " to stay within the memory budget of " << memory_budget_;
+      EraseSymbolModule(victim);
+      cache_evictions_.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+
+    // Find the least recently used module, other than |keep|.
+    victim = modules_->end();
+    for (ModuleMap::iterator it = modules_->begin(); it != modules_->end();
+         ++it) {
+      if (it->second == keep ||
+          (keep_code_file && it->first == *keep_code_file)) {
+        continue;
+      }
+      uint64_t last_use = it->second->last_use_.load(std::memory_order_relaxed);
+      if (victim == modules_->end() || last_use < victim_last_use) {
+        victim = it;
+        victim_last_use = last_use;
+      }
+    }
+    if (victim == modules_->end())
+      return;
+
+    BPLOG(INFO) << "Evicting symbols for module " << victim->first
+                << " to stay within the memory budget of " << memory_budget_;
+    EraseModule(victim);
+    cache_evictions_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void SourceLineResolverBase::set_memory_budget(size_t memory_budget) {
+  std::unique_lock<std::shared_mutex> writer_lock(modules_lock_);
+  memory_budget_ = memory_budget;
+  EvictModules(NULL);
+}
+
+SourceLineResolverBase::ModuleCacheStats
+SourceLineResolverBase::GetModuleCacheStats() const {
+  std::shared_lock<std::shared_mutex> reader_lock(modules_lock_);
+  ModuleCacheStats stats;
+  stats.hits = cache_hits_.load(std::memory_order_relaxed);
+  stats.misses = cache_misses_.load(std::memory_order_relaxed);
+  stats.evictions = cache_evictions_.load(std::memory_order_relaxed);
+  stats.module_count = modules_->size();
+  stats.memory_usage = memory_usage_;
+  return stats;
+}
+
+std::vector<SourceLineResolverBase::ModuleMemoryStats>
+SourceLineResolverBase::GetModuleMemoryStats() const {
+  std::shared_lock<std::shared_mutex> reader_lock(modules_lock_);
+  std::vector<ModuleMemoryStats> stats;
+  stats.reserve(modules_->size());
+  for (const auto& loaded : *modules_) {
+    ModuleMemoryStats module_stats;
+    module_stats.code_file = loaded.first;
+    module_stats.memory_usage = loaded.second->memory_usage_;
+    ModuleMap::const_iterator symbol_part =
+        symbol_modules_->find(loaded.first);
+    if (symbol_part != symbol_modules_->end() && symbol_part->second)
+      module_stats.memory_usage += symbol_part->second->memory_usage_;
+    module_stats.symbol_data_size = 0;
+    module_stats.resident_size = 0;
+    module_stats.huge_page_count = 0;
+    SymbolBufferMap::const_iterator buffer =
+        symbol_buffers_->find(loaded.first);
+    if (buffer != symbol_buffers_->end()) {
+      module_stats.symbol_data_size = buffer->second->size();
+      buffer->second->GetResidency(&module_stats.resident_size,
+                                   &module_stats.huge_page_count);
     }
+    stats.push_back(module_stats);
+  }
+  return stats;
+}
+
+void SourceLineResolverBase::MarkUsed(const Module* module) {
+  if (memory_budget_) {
+    module->last_use_.store(++use_clock_, std::memory_order_relaxed);
   }
 }
 
 bool SourceLineResolverBase::HasModule(const CodeModule* module) {
   if (!module)
     return false;
-  return modules_->find(module->code_file()) != modules_->end();
+  std::shared_lock<std::shared_mutex> reader_lock(modules_lock_);
+  ModuleMap::const_iterator it = modules_->find(module->code_file());
+  if (it == modules_->end()) {
+    cache_misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  cache_hits_.fetch_add(1, std::memory_order_relaxed);
+  MarkUsed(it->second);
+  return true;
+}
+
+bool SourceLineResolverBase::HasModuleSymbols(const CodeModule* module) {
+  if (!module)
+    return false;
+  std::shared_lock<std::shared_mutex> reader_lock(modules_lock_);
+  ModuleMap::const_iterator it = modules_->find(module->code_file());
+  return it != modules_->end() &&
+         GetSymbolModule(it->first, it->second) != NULL;
 }
 
 bool SourceLineResolverBase::IsModuleCorrupt(const CodeModule* module) {
   if (!module)
     return false;
-  return corrupt_modules_->find(module->code_file()) != corrupt_modules_->end();
+  std::shared_lock<std::shared_mutex> reader_lock(modules_lock_);
+  if (corrupt_modules_->find(module->code_file()) != corrupt_modules_->end())
+    return true;
+  ModuleMap::const_iterator it = symbol_modules_->find(module->code_file());
+  return it != symbol_modules_->end() && it->second &&
+         it->second->IsCorrupt();
+}
+
+SourceLineResolverBase::Module* SourceLineResolverBase::GetSymbolModule(
+    const string& code_file, Module* module) const {
+  ModuleMap::const_iterator it = symbol_modules_->find(code_file);
+  return it == symbol_modules_->end() ? module : it->second;
+}
+
+bool SourceLineResolverBase::IsModuleLoaded(const string& code_file) {
+  std::shared_lock<std::shared_mutex> reader_lock(modules_lock_);
+  return modules_->find(code_file) != modules_->end();
 }
 
 void SourceLineResolverBase::FillSourceLineInfo(
     StackFrame* frame,
     std::deque<std::unique_ptr<StackFrame>>* inlined_frames) {
   if (frame->module) {
+    std::shared_lock<std::shared_mutex> reader_lock(modules_lock_);
     ModuleMap::const_iterator it = modules_->find(frame->module->code_file());
     if (it != modules_->end()) {
-      it->second->LookupAddress(frame, inlined_frames);
+      Module* symbol_module = GetSymbolModule(it->first, it->second);
+      if (symbol_module) {
+        MarkUsed(symbol_module);
+        symbol_module->LookupAddress(frame, inlined_frames);
+      }
     }
   }
 }
@@ -316,9 +724,20 @@ void SourceLineResolverBase::FillSourceLineInfo(
 WindowsFrameInfo* SourceLineResolverBase::FindWindowsFrameInfo(
     const StackFrame* frame) {
   if (frame->module) {
+    std::shared_lock<std::shared_mutex> reader_lock(modules_lock_);
     ModuleMap::const_iterator it = modules_->find(frame->module->code_file());
     if (it != modules_->end()) {
-      return it->second->FindWindowsFrameInfo(frame);
+      MarkUsed(it->second);
+      WindowsFrameInfo* frame_info = it->second->FindWindowsFrameInfo(frame);
+      // Without STACK WIN records covering the frame, a module falls back
+      // on the parameter size of the function or public symbol covering
+      // it, which a module loaded in parts keeps in its symbol part.
+      Module* symbol_module = GetSymbolModule(it->first, it->second);
+      if (!frame_info && symbol_module && symbol_module != it->second) {
+        MarkUsed(symbol_module);
+        frame_info = symbol_module->FindWindowsFrameInfo(frame);
+      }
+      return frame_info;
     }
   }
   return NULL;
@@ -327,19 +746,140 @@ WindowsFrameInfo* SourceLineResolverBase::FindWindowsFrameInfo(
 CFIFrameInfo* SourceLineResolverBase::FindCFIFrameInfo(
     const StackFrame* frame) {
   if (frame->module) {
+    std::shared_lock<std::shared_mutex> reader_lock(modules_lock_);
     ModuleMap::const_iterator it = modules_->find(frame->module->code_file());
     if (it != modules_->end()) {
+      MarkUsed(it->second);
       return it->second->FindCFIFrameInfo(frame);
     }
   }
   return NULL;
 }
 
+size_t SourceLineResolverBase::PrewarmModule(
+    const CodeModule* module,
+    const std::vector<uint64_t>& addresses) {
+  // The lookups a stack walk makes parse and cache what they need, so
+  // making them now is all it takes.
+  size_t functions = 0;
+  for (uint64_t address : addresses) {
+    StackFrame frame;
+    frame.instruction = module->base_address() + address;
+    frame.module = module;
+    FillSourceLineInfo(&frame, nullptr);
+    if (!frame.function_name.empty())
+      ++functions;
+    std::unique_ptr<CFIFrameInfo> cfi_frame_info(FindCFIFrameInfo(&frame));
+    std::unique_ptr<WindowsFrameInfo> windows_frame_info(
+        FindWindowsFrameInfo(&frame));
+  }
+  return functions;
+}
+
+bool SourceLineResolverBase::SymbolizeAddresses(
+    const CodeModule* module,
+    const uint64_t* addresses,
+    size_t count,
+    SymbolizedAddresses* results) {
+  if (!module)
+    return false;
+  std::shared_lock<std::shared_mutex> reader_lock(modules_lock_);
+  ModuleMap::const_iterator it = modules_->find(module->code_file());
+  if (it == modules_->end())
+    return false;
+  Module* symbol_module = GetSymbolModule(it->first, it->second);
+  if (!symbol_module)
+    return false;
+  MarkUsed(symbol_module);
+  symbol_module->LookupAddresses(module, addresses, count, results);
+  return true;
+}
+
 bool SourceLineResolverBase::CompareString::operator()(
     const string& s1, const string& s2) const {
   return strcmp(s1.c_str(), s2.c_str()) < 0;
 }
 
+void SourceLineResolverBase::Module::LookupAddresses(
+    const CodeModule* code_module,
+    const MemAddr* addresses,
+    size_t count,
+    SymbolizedAddresses* results) const {
+  const uint64_t module_base = code_module->base_address();
+  for (size_t i = 0; i < count; ++i) {
+    StackFrame frame;
+    frame.instruction = module_base + addresses[i];
+    frame.module = code_module;
+    std::deque<std::unique_ptr<StackFrame>> inlined_frames;
+    LookupAddress(&frame, &inlined_frames);
+
+    results->function_name_ids.push_back(
+        frame.function_name.empty()
+            ? SymbolizedAddresses::kNoName
+            : results->InternName(frame.function_name.data(),
+                                  frame.function_name.size()));
+    results->function_bases.push_back(
+        frame.function_name.empty() ? 0 : frame.function_base - module_base);
+    results->file_name_ids.push_back(
+        frame.source_file_name.empty()
+            ? SymbolizedAddresses::kNoName
+            : results->InternName(frame.source_file_name.data(),
+                                  frame.source_file_name.size()));
+    results->lines.push_back(frame.source_line);
+    results->inline_begins.push_back(
+        static_cast<uint32_t>(results->inline_function_name_ids.size()));
+    for (const std::unique_ptr<StackFrame>& inlined : inlined_frames) {
+      results->inline_function_name_ids.push_back(results->InternName(
+          inlined->function_name.data(), inlined->function_name.size()));
+      results->inline_function_bases.push_back(inlined->function_base -
+                                               module_base);
+      results->inline_file_name_ids.push_back(
+          inlined->source_file_name.empty()
+              ? SymbolizedAddresses::kNoName
+              : results->InternName(inlined->source_file_name.data(),
+                                    inlined->source_file_name.size()));
+      results->inline_lines.push_back(inlined->source_line);
+    }
+  }
+}
+
+// static
+void SourceLineResolverBase::Module::RepeatLastAddress(
+    SymbolizedAddresses* results) {
+  results->function_name_ids.push_back(results->function_name_ids.back());
+  results->function_bases.push_back(results->function_bases.back());
+  results->file_name_ids.push_back(results->file_name_ids.back());
+  results->lines.push_back(results->lines.back());
+  const size_t begin = results->inline_begins.back();
+  const size_t end = results->inline_function_name_ids.size();
+  results->inline_begins.push_back(static_cast<uint32_t>(end));
+  for (size_t i = begin; i < end; ++i) {
+    results->inline_function_name_ids.push_back(
+        results->inline_function_name_ids[i]);
+    results->inline_function_bases.push_back(
+        results->inline_function_bases[i]);
+    results->inline_file_name_ids.push_back(results->inline_file_name_ids[i]);
+    results->inline_lines.push_back(results->inline_lines[i]);
+  }
+}
+
+// static
+void SourceLineResolverBase::Module::RotateInlineSourcePositions(
+    size_t inline_begin,
+    SymbolizedAddresses* results) {
+  const size_t end = results->inline_file_name_ids.size();
+  if (inline_begin == end)
+    return;
+  uint32_t file_id = results->file_name_ids.back();
+  int32_t line = results->lines.back();
+  results->file_name_ids.back() = results->inline_file_name_ids[end - 1];
+  results->lines.back() = results->inline_lines[end - 1];
+  for (size_t i = inline_begin; i < end; ++i) {
+    std::swap(results->inline_file_name_ids[i], file_id);
+    std::swap(results->inline_lines[i], line);
+  }
+}
+
 bool SourceLineResolverBase::Module::ParseCFIRuleSet(
     const string& rule_set, CFIFrameInfo* frame_info) const {
   CFIFrameInfoParseHandler handler(frame_info);
@@ -39,17 +39,21 @@
 
 #include <stdio.h>
 
+#include <atomic>
 #include <deque>
 #include <map>
 #include <memory>
 #include <string>
+#include <unordered_map>
 
+#include "common/string_view.h"
 #include "google_breakpad/common/breakpad_types.h"
 #include "google_breakpad/processor/source_line_resolver_base.h"
 #include "google_breakpad/processor/stack_frame.h"
 #include "processor/cfi_frame_info.h"
 #include "processor/linked_ptr.h"
 #include "processor/range_map.h"
+#include "processor/symbol_file_index.h"
 #include "processor/windows_frame_info.h"
 
 #ifndef PROCESSOR_SOURCE_LINE_RESOLVER_BASE_TYPES_H__
@@ -69,16 +73,39 @@ class SourceLineResolverBase::AutoFileCloser {
   FILE* file_;
 };
 
+// Interns the names a module looks up for a batch of addresses into a
+// SymbolizedAddresses.  Names stay put in the module, so each is looked up
+// by where it is, and hashed only the first time it is seen in the batch.
+class SourceLineResolverBase::NameInterner {
+ public:
+  explicit NameInterner(SymbolizedAddresses* results) : results_(results) {}
+
+  uint32_t Intern(StringView name) {
+    auto it = ids_.find(name.data());
+    if (it != ids_.end() && it->second.first == name.size())
+      return it->second.second;
+    uint32_t id = results_->InternName(name.data(), name.size());
+    ids_[name.data()] = std::make_pair(name.size(), id);
+    return id;
+  }
+
+ private:
+  SymbolizedAddresses* results_;
+  // The length and id of each name seen, by where it is.
+  std::unordered_map<const char*, std::pair<size_t, uint32_t> > ids_;
+};
+
 struct SourceLineResolverBase::InlineOrigin {
   InlineOrigin() {}
-  InlineOrigin(bool has_file_id, int32_t source_file_id, const string& name)
+  InlineOrigin(bool has_file_id, int32_t source_file_id, StringView name)
       : has_file_id(has_file_id),
         source_file_id(source_file_id),
         name(name) {}
   // If it's old format, source file id is set, otherwise not useful.
   bool has_file_id;
   int32_t source_file_id;
-  string name;
+  // Points into the symbol data, or into storage owned by the module.
+  StringView name;
 };
 
 struct SourceLineResolverBase::Inline {
@@ -122,7 +149,7 @@ struct SourceLineResolverBase::Line {
 
 struct SourceLineResolverBase::Function {
   Function() { }
-  Function(const string& function_name,
+  Function(StringView function_name,
            MemAddr function_address,
            MemAddr code_size,
            int set_parameter_size,
@@ -130,7 +157,8 @@ struct SourceLineResolverBase::Function {
       : name(function_name), address(function_address), size(code_size),
         parameter_size(set_parameter_size), is_multiple(is_multiple) { }
 
-  string name;
+  // Points into the symbol data, or into storage owned by the module.
+  StringView name;
   MemAddr address;
   MemAddr size;
 
@@ -143,7 +171,7 @@ struct SourceLineResolverBase::Function {
 
 struct SourceLineResolverBase::PublicSymbol {
   PublicSymbol() { }
-  PublicSymbol(const string& set_name,
+  PublicSymbol(StringView set_name,
                MemAddr set_address,
                int set_parameter_size,
                bool is_multiple)
@@ -152,7 +180,8 @@ struct SourceLineResolverBase::PublicSymbol {
         parameter_size(set_parameter_size),
         is_multiple(is_multiple) {}
 
-  string name;
+  // Points into the symbol data, or into storage owned by the module.
+  StringView name;
   MemAddr address;
 
   // If the public symbol is used as a function entry point, parameter_size
@@ -166,6 +195,7 @@ struct SourceLineResolverBase::PublicSymbol {
 
 class SourceLineResolverBase::Module {
  public:
+  Module() : memory_usage_(0), last_use_(0) { }
   virtual ~Module() { };
   // Loads a map from the given buffer in char* type.
   // Does NOT take ownership of memory_buffer (the caller, source line resolver,
@@ -176,6 +206,35 @@ class SourceLineResolverBase::Module {
   virtual bool LoadMapFromMemory(char* memory_buffer,
                                  size_t memory_buffer_size) = 0;
 
+  // Loads a map from the symbol file contents in memory_buffer, parsing
+  // only the records that index does not cover.  The blocks index covers
+  // are parsed from memory_buffer when they are first looked up, so it
+  // must stay valid, and unmodified, as long as the module.  Returns false
+  // if the module cannot be loaded this way.
+  virtual bool LoadMapFromIndexedFile(const char* memory_buffer,
+                                      size_t memory_buffer_size,
+                                      const SymbolFileIndex& index) {
+    return false;
+  }
+
+  // The records of symbol data that LoadMapPartFromMemory() loads.
+  enum SymbolDataPart {
+    UNWIND_RECORDS,  // The STACK WIN and STACK CFI records.
+    SYMBOL_RECORDS   // All other records.
+  };
+
+  // Returns true if the module implements LoadMapPartFromMemory().
+  virtual bool CanLoadMapParts() const { return false; }
+
+  // Like LoadMapFromMemory(), but loads only the records in part, and
+  // stores the size of those records in *part_size.
+  virtual bool LoadMapPartFromMemory(char* memory_buffer,
+                                     size_t memory_buffer_size,
+                                     SymbolDataPart part,
+                                     size_t* part_size) {
+    return false;
+  }
+
   // Tells whether the loaded symbol data is corrupt.  Return value is
   // undefined, if the symbol data hasn't been loaded yet.
   virtual bool IsCorrupt() const = 0;
@@ -186,6 +245,16 @@ class SourceLineResolverBase::Module {
       StackFrame* frame,
       std::deque<std::unique_ptr<StackFrame>>* inlined_frames) const = 0;
 
+  // Looks up count addresses relative to the base of code_module, which
+  // this module holds the symbols of, sorted in increasing order, and
+  // appends the results to *results.  See
+  // SourceLineResolverInterface::SymbolizeAddresses().  The default
+  // implementation calls LookupAddress() for each address.
+  virtual void LookupAddresses(const CodeModule* code_module,
+                               const MemAddr* addresses,
+                               size_t count,
+                               SymbolizedAddresses* results) const;
+
   // If Windows stack walking information is available covering ADDRESS,
   // return a WindowsFrameInfo structure describing it. If the information
   // is not available, returns NULL. A NULL return value does not indicate
@@ -202,6 +271,27 @@ class SourceLineResolverBase::Module {
  protected:
   virtual bool ParseCFIRuleSet(const string& rule_set,
                                CFIFrameInfo* frame_info) const;
+
+  // Appends another copy of the last address in *results, with its
+  // inlined frames, for an address repeated in a batch.
+  static void RepeatLastAddress(SymbolizedAddresses* results);
+
+  // Moves the source positions of the last address in *results, whose
+  // inlined frames from inline_begin on hold the positions of their call
+  // sites, to where FillSourceLineInfo() reports them: the position the
+  // line record gives goes to the innermost inlined frame, each call site
+  // to the frame it was called from, and the outermost call site to the
+  // address itself.
+  static void RotateInlineSourcePositions(size_t inline_begin,
+                                          SymbolizedAddresses* results);
+
+ private:
+  friend class SourceLineResolverBase;
+
+  // Bookkeeping for SourceLineResolverBase's memory budget: the memory
+  // accounted to this module, and when it was last used.
+  size_t memory_usage_;
+  mutable std::atomic<uint64_t> last_use_;
 };
 
 }  // namespace google_breakpad
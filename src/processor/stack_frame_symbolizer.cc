@@ -39,22 +39,64 @@
 
 #include <assert.h>
 
+#include <condition_variable>
+#include <mutex>
+
 #include "common/scoped_ptr.h"
 #include "google_breakpad/processor/code_module.h"
 #include "google_breakpad/processor/code_modules.h"
+#include "google_breakpad/processor/frame_profile.h"
+#include "google_breakpad/processor/processing_stats.h"
 #include "google_breakpad/processor/source_line_resolver_interface.h"
 #include "google_breakpad/processor/stack_frame.h"
 #include "google_breakpad/processor/symbol_supplier.h"
 #include "google_breakpad/processor/system_info.h"
+#include "processor/basic_code_module.h"
 #include "processor/linked_ptr.h"
 #include "processor/logging.h"
 
 namespace google_breakpad {
 
+namespace {
+
+// The most frames memoized at once.  When the memo fills up it is cleared
+// and starts over, which bounds a long-lived symbolizer's memory.
+const size_t kMaxMemoizedFrames = 1 << 16;
+
+// Records the time spent fetching and parsing the symbols for module in
+// stats, which may be NULL.
+void RecordModuleLoad(ProcessingStats* stats,
+                      const CodeModule* module,
+                      double fetch_seconds,
+                      double parse_seconds,
+                      bool loaded) {
+  if (!stats)
+    return;
+  ProcessingStats::ModuleLoad module_load;
+  module_load.code_file = module->code_file();
+  module_load.debug_identifier = module->debug_identifier();
+  module_load.fetch_seconds = fetch_seconds;
+  module_load.parse_seconds = parse_seconds;
+  module_load.loaded = loaded;
+  stats->AddModuleLoad(module_load);
+}
+
+// Returns the wall-clock time if stats is not NULL, for timing a symbol
+// load that will be recorded there.
+double StartTime(ProcessingStats* stats) {
+  return stats ? ProcessingStats::WallSeconds() : 0;
+}
+
+}  // namespace
+
 StackFrameSymbolizer::StackFrameSymbolizer(
     SymbolSupplier* supplier,
-    SourceLineResolverInterface* resolver) : supplier_(supplier),
-                                             resolver_(resolver) { }
+    SourceLineResolverInterface* resolver)
+    : supplier_(supplier),
+      resolver_(resolver),
+      frame_profile_(NULL),
+      frame_memo_size_(0),
+      keep_frame_memo_across_resets_(false) { }
 
 StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::FillSourceLineInfo(
     const CodeModules* modules,
@@ -62,6 +104,26 @@ StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::FillSourceLineInfo(
     const SystemInfo* system_info,
     StackFrame* frame,
     std::deque<std::unique_ptr<StackFrame>>* inlined_frames) {
+  return FillFrame(modules, unloaded_modules, system_info, frame,
+                   inlined_frames, true);
+}
+
+StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::FillModuleInfo(
+    const CodeModules* modules,
+    const CodeModules* unloaded_modules,
+    const SystemInfo* system_info,
+    StackFrame* frame) {
+  return FillFrame(modules, unloaded_modules, system_info, frame, nullptr,
+                   false);
+}
+
+StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::FillFrame(
+    const CodeModules* modules,
+    const CodeModules* unloaded_modules,
+    const SystemInfo* system_info,
+    StackFrame* frame,
+    std::deque<std::unique_ptr<StackFrame>>* inlined_frames,
+    bool fill_source_line_info) {
   assert(frame);
 
   const CodeModule* module = NULL;
@@ -76,17 +138,37 @@ StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::FillSourceLineInfo(
   frame->module = module;
 
   if (!resolver_) return kError;  // no resolver.
-  // If module is known to have missing symbol file, return.
-  if (no_symbol_modules_.find(module->code_file()) !=
-      no_symbol_modules_.end()) {
-    return kError;
+
+  ProcessingStats* stats = ProcessingStats::current();
+  if (fill_source_line_info) {
+    if (frame_profile_) {
+      frame_profile_->Record(module,
+                             frame->instruction - module->base_address());
+    }
+    SymbolizerResult memoized_result;
+    if (FillFromFrameMemo(frame, inlined_frames, &memoized_result)) {
+      if (stats)
+        stats->CountSymbolLookup(true);
+      return memoized_result;
+    }
+    if (stats)
+      stats->CountSymbolLookup(false);
   }
 
-  // If module is already loaded, go ahead to fill source line info and return.
-  if (resolver_->HasModule(frame->module)) {
-    resolver_->FillSourceLineInfo(frame, inlined_frames);
-    return resolver_->IsModuleCorrupt(frame->module) ?
-        kWarningCorruptSymbols : kNoError;
+  {
+    std::shared_lock<std::shared_mutex> reader_lock(lock_);
+    // If module is known to have missing symbol file, return.
+    if (no_symbol_modules_.find(module->code_file()) !=
+        no_symbol_modules_.end()) {
+      return kError;
+    }
+
+    // If module is already loaded, go ahead to fill source line info and
+    // return.
+    if (HasNeededSymbols(module, fill_source_line_info)) {
+      return fill_source_line_info ? FillFromResolver(frame, inlined_frames)
+                                   : LoadedModuleResult(module);
+    }
   }
 
   // Module needs to fetch symbol file. First check to see if supplier exists.
@@ -94,27 +176,61 @@ StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::FillSourceLineInfo(
     return kError;
   }
 
+  // Fetching and loading symbols modifies the resolver, so it happens under
+  // the writer lock.  Another walker may have loaded the module, or given up
+  // on it, while this one was waiting for the lock.
+  std::unique_lock<std::shared_mutex> writer_lock(lock_);
+  if (no_symbol_modules_.find(module->code_file()) !=
+      no_symbol_modules_.end()) {
+    return kError;
+  }
+  if (HasNeededSymbols(module, fill_source_line_info)) {
+    return fill_source_line_info ? FillFromResolver(frame, inlined_frames)
+                                 : LoadedModuleResult(module);
+  }
+
   // Start fetching symbol from supplier.
   string symbol_file;
-  char* symbol_data = NULL;
-  size_t symbol_data_size;
-  SymbolSupplier::SymbolResult symbol_result = supplier_->GetCStringSymbolData(
-      module, system_info, &symbol_file, &symbol_data, &symbol_data_size);
+  std::shared_ptr<SymbolBuffer> symbol_buffer;
+  double fetch_start = StartTime(stats);
+  SymbolSupplier::SymbolResult symbol_result = supplier_->GetSymbolBuffer(
+      module, system_info, &symbol_file, &symbol_buffer);
+  double parse_start = StartTime(stats);
 
   switch (symbol_result) {
     case SymbolSupplier::FOUND: {
-      bool load_success = resolver_->LoadModuleUsingMemoryBuffer(
-          frame->module,
-          symbol_data,
-          symbol_data_size);
-      if (resolver_->ShouldDeleteMemoryBufferAfterLoadModule()) {
-        supplier_->FreeSymbolData(module);
+      // A frame that is only unwound needs only the module's unwind
+      // information, and the symbols can be loaded separately when a frame
+      // in the module is symbolized.  A resolver shared with other
+      // symbolizers may have been given the module by one of them in the
+      // meantime, which also counts as loaded.
+      bool loading_symbols = resolver_->HasModule(frame->module);
+      bool load_success;
+      if (loading_symbols) {
+        load_success = resolver_->LoadModuleSymbolsUsingMemoryBuffer(
+            frame->module, symbol_buffer->data(), symbol_buffer->size()) ||
+            resolver_->HasModuleSymbols(frame->module);
+      } else if (fill_source_line_info) {
+        load_success = resolver_->LoadModuleUsingSymbolBuffer(
+            frame->module, symbol_buffer) ||
+            resolver_->HasModule(frame->module);
+      } else {
+        load_success = resolver_->LoadModuleUnwindInfoUsingMemoryBuffer(
+            frame->module, symbol_buffer->data(), symbol_buffer->size()) ||
+            resolver_->HasModule(frame->module);
       }
+      ReleaseSymbolBuffer(module, &symbol_buffer);
+      RecordModuleLoad(stats, module, parse_start - fetch_start,
+                       StartTime(stats) - parse_start, load_success);
 
       if (load_success) {
-        resolver_->FillSourceLineInfo(frame, inlined_frames);
-        return resolver_->IsModuleCorrupt(frame->module) ?
-            kWarningCorruptSymbols : kNoError;
+        return fill_source_line_info ?
+            FillFromResolver(frame, inlined_frames) :
+            LoadedModuleResult(module);
+      } else if (loading_symbols) {
+        // The unwind information is still there for unwinding.
+        BPLOG(ERROR) << "Failed to load symbols in resolver.";
+        return kError;
       } else {
         BPLOG(ERROR) << "Failed to load symbol file in resolver.";
         no_symbol_modules_.insert(module->code_file());
@@ -123,6 +239,7 @@ StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::FillSourceLineInfo(
     }
 
     case SymbolSupplier::NOT_FOUND:
+      RecordModuleLoad(stats, module, parse_start - fetch_start, 0, false);
       no_symbol_modules_.insert(module->code_file());
       return kError;
 
@@ -136,14 +253,334 @@ StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::FillSourceLineInfo(
   return kError;
 }
 
+bool StackFrameSymbolizer::HasNeededSymbols(const CodeModule* module,
+                                            bool fill_source_line_info) {
+  return resolver_->HasModule(module) &&
+         (!fill_source_line_info || resolver_->HasModuleSymbols(module));
+}
+
+StackFrameSymbolizer::SymbolizerResult
+StackFrameSymbolizer::LoadedModuleResult(const CodeModule* module) {
+  return resolver_->IsModuleCorrupt(module) ?
+      kWarningCorruptSymbols : kNoError;
+}
+
+bool StackFrameSymbolizer::GetPrefetchedResult(const CodeModule* module,
+                                               SymbolizerResult* result) {
+  std::shared_lock<std::shared_mutex> reader_lock(lock_);
+  if (no_symbol_modules_.find(module->code_file()) !=
+      no_symbol_modules_.end()) {
+    *result = kError;
+    return true;
+  }
+  if (resolver_->HasModule(module)) {
+    *result = LoadedModuleResult(module);
+    return true;
+  }
+  return false;
+}
+
+void StackFrameSymbolizer::ReleaseSymbolBuffer(
+    const CodeModule* module,
+    std::shared_ptr<SymbolBuffer>* symbol_buffer) {
+  // A buffer the supplier lent is freed as GetCStringSymbolData's are, and
+  // only if the resolver doesn't refer to it.  Any other buffer is freed
+  // once neither this nor the resolver holds it.
+  if ((*symbol_buffer)->borrowed() &&
+      resolver_->ShouldDeleteMemoryBufferAfterLoadModule()) {
+    supplier_->FreeSymbolData(module);
+  }
+  symbol_buffer->reset();
+}
+
+StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::LoadFetchedSymbols(
+    const CodeModule* module,
+    SymbolSupplier::SymbolResult symbol_result,
+    std::shared_ptr<SymbolBuffer> symbol_buffer,
+    double fetch_seconds) {
+  ProcessingStats* stats = ProcessingStats::current();
+  bool no_symbols = false;
+  switch (symbol_result) {
+    case SymbolSupplier::FOUND: {
+      // The resolver parses symbols before taking its own lock, so modules
+      // are loaded concurrently too.
+      double parse_start = StartTime(stats);
+      bool load_success =
+          resolver_->LoadModuleUsingSymbolBuffer(module, symbol_buffer) ||
+          resolver_->HasModule(module);
+      ReleaseSymbolBuffer(module, &symbol_buffer);
+      RecordModuleLoad(stats, module, fetch_seconds,
+                       StartTime(stats) - parse_start, load_success);
+      if (!load_success) {
+        BPLOG(ERROR) << "Failed to load symbol file in resolver.";
+        no_symbols = true;
+      }
+      break;
+    }
+
+    case SymbolSupplier::NOT_FOUND:
+      RecordModuleLoad(stats, module, fetch_seconds, 0, false);
+      no_symbols = true;
+      break;
+
+    case SymbolSupplier::INTERRUPT:
+      return kInterrupt;
+
+    default:
+      BPLOG(ERROR) << "Unknown SymbolResult enum: " << symbol_result;
+      return kError;
+  }
+
+  if (no_symbols) {
+    std::unique_lock<std::shared_mutex> writer_lock(lock_);
+    no_symbol_modules_.insert(module->code_file());
+    return kError;
+  }
+  return resolver_->IsModuleCorrupt(module) ?
+      kWarningCorruptSymbols : kNoError;
+}
+
+StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::PrefetchModule(
+    const CodeModule* module,
+    const SystemInfo* system_info) {
+  assert(module);
+  if (!resolver_ || !supplier_) return kError;
+  SymbolizerResult result;
+  if (GetPrefetchedResult(module, &result)) {
+    return result;
+  }
+
+  string symbol_file;
+  std::shared_ptr<SymbolBuffer> symbol_buffer;
+  ProcessingStats* stats = ProcessingStats::current();
+  double fetch_start = StartTime(stats);
+  SymbolSupplier::SymbolResult symbol_result = supplier_->GetSymbolBuffer(
+      module, system_info, &symbol_file, &symbol_buffer);
+  return LoadFetchedSymbols(module, symbol_result, symbol_buffer,
+                            StartTime(stats) - fetch_start);
+}
+
+namespace {
+
+// Collects the results of outstanding GetCStringSymbolDataAsync requests
+// for the thread that issued them.
+class SymbolDataQueue : public SymbolSupplier::SymbolDataCallback {
+ public:
+  struct SymbolData {
+    const CodeModule* module;
+    SymbolSupplier::SymbolResult result;
+    char* symbol_data;
+    size_t symbol_data_size;
+  };
+
+  virtual void OnSymbolData(const CodeModule* module,
+                            SymbolSupplier::SymbolResult result,
+                            const string& symbol_file,
+                            char* symbol_data,
+                            size_t symbol_data_size) {
+    SymbolData data = {module, result, symbol_data, symbol_data_size};
+    std::lock_guard<std::mutex> lock(lock_);
+    completed_.push_back(data);
+    completed_condition_.notify_one();
+  }
+
+  // Waits for at least one request to complete, then moves the results of
+  // all completed requests to completed.
+  void WaitForCompleted(std::vector<SymbolData>* completed) {
+    std::unique_lock<std::mutex> lock(lock_);
+    completed_condition_.wait(lock, [this] { return !completed_.empty(); });
+    completed->swap(completed_);
+  }
+
+ private:
+  std::mutex lock_;
+  std::condition_variable completed_condition_;
+  std::vector<SymbolData> completed_;
+};
+
+}  // namespace
+
+StackFrameSymbolizer::SymbolizerResult
+StackFrameSymbolizer::PrefetchModulesAsync(
+    const std::vector<const CodeModule*>& modules,
+    const SystemInfo* system_info,
+    int max_outstanding) {
+  if (!resolver_ || !supplier_) return kError;
+
+  SymbolDataQueue queue;
+  std::vector<SymbolDataQueue::SymbolData> completed;
+  size_t next_module = 0;
+  int outstanding = 0;
+  bool interrupted = false;
+  while (true) {
+    // An interrupted request will interrupt the walk too, so there is no
+    // point in issuing more, but those already issued must complete before
+    // queue goes away.
+    while (!interrupted && next_module < modules.size() &&
+           outstanding < max_outstanding) {
+      const CodeModule* module = modules[next_module++];
+      SymbolizerResult result;
+      if (!GetPrefetchedResult(module, &result)) {
+        ++outstanding;
+        supplier_->GetCStringSymbolDataAsync(module, system_info, &queue);
+      }
+    }
+    if (outstanding == 0)
+      break;
+
+    queue.WaitForCompleted(&completed);
+    for (const SymbolDataQueue::SymbolData& data : completed) {
+      --outstanding;
+      std::shared_ptr<SymbolBuffer> symbol_buffer;
+      if (data.result == SymbolSupplier::FOUND) {
+        symbol_buffer =
+            SymbolBuffer::Borrow(data.symbol_data, data.symbol_data_size);
+      }
+      if (LoadFetchedSymbols(data.module, data.result, symbol_buffer,
+                             0) == kInterrupt) {
+        interrupted = true;
+      }
+    }
+    completed.clear();
+  }
+  return interrupted ? kInterrupt : kNoError;
+}
+
+StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::PrewarmFromProfile(
+    const FrameProfile& profile,
+    const SystemInfo* system_info) {
+  if (!resolver_ || !supplier_) return kError;
+
+  for (const auto& module_counts : profile.modules()) {
+    const FrameProfile::ModuleKey& key = module_counts.first;
+    // The addresses are relative to the module, so it can stand at 0; the
+    // resolver knows modules by code file.
+    BasicCodeModule module(0, UINT64_MAX, key.code_file, "", key.debug_file,
+                           key.debug_identifier, "");
+    SymbolizerResult result = PrefetchModule(&module, system_info);
+    if (result == kInterrupt)
+      return kInterrupt;
+    if (result != kNoError && result != kWarningCorruptSymbols)
+      continue;
+
+    std::vector<uint64_t> addresses;
+    addresses.reserve(module_counts.second.size());
+    for (const auto& address : module_counts.second)
+      addresses.push_back(address.first);
+    std::shared_lock<std::shared_mutex> reader_lock(lock_);
+    resolver_->PrewarmModule(&module, addresses);
+  }
+  return kNoError;
+}
+
 WindowsFrameInfo* StackFrameSymbolizer::FindWindowsFrameInfo(
     const StackFrame* frame) {
+  std::shared_lock<std::shared_mutex> reader_lock(lock_);
   return resolver_ ? resolver_->FindWindowsFrameInfo(frame) : NULL;
 }
 
 CFIFrameInfo* StackFrameSymbolizer::FindCFIFrameInfo(
     const StackFrame* frame) {
+  std::shared_lock<std::shared_mutex> reader_lock(lock_);
   return resolver_ ? resolver_->FindCFIFrameInfo(frame) : NULL;
 }
 
+void StackFrameSymbolizer::Reset() {
+  std::unique_lock<std::shared_mutex> writer_lock(lock_);
+  no_symbol_modules_.clear();
+  if (!keep_frame_memo_across_resets_) {
+    std::unique_lock<std::shared_mutex> memo_writer_lock(frame_memo_lock_);
+    frame_memo_.clear();
+    frame_memo_size_ = 0;
+  }
+}
+
+bool StackFrameSymbolizer::FillFromFrameMemo(
+    StackFrame* frame,
+    std::deque<std::unique_ptr<StackFrame>>* inlined_frames,
+    SymbolizerResult* result) {
+  const CodeModule* module = frame->module;
+  uint64_t base_address = module->base_address();
+  MemoAddressKey address_key(frame->instruction - base_address,
+                             inlined_frames != NULL);
+
+  std::shared_lock<std::shared_mutex> memo_reader_lock(frame_memo_lock_);
+  FrameMemo::const_iterator module_memo = frame_memo_.find(
+      MemoModuleKey(module->code_file(), module->debug_identifier()));
+  if (module_memo == frame_memo_.end()) {
+    return false;
+  }
+  ModuleFrameMemo::const_iterator memoized =
+      module_memo->second.find(address_key);
+  if (memoized == module_memo->second.end()) {
+    return false;
+  }
+
+  const StackFrame& memoized_frame = memoized->second.frame;
+  frame->function_name = memoized_frame.function_name;
+  frame->function_base = memoized_frame.function_base + base_address;
+  frame->source_file_name = memoized_frame.source_file_name;
+  frame->source_line = memoized_frame.source_line;
+  frame->source_line_base = memoized_frame.source_line_base + base_address;
+  frame->is_multiple = memoized_frame.is_multiple;
+  if (inlined_frames) {
+    for (const StackFrame& memoized_inline : memoized->second.inlined_frames) {
+      std::unique_ptr<StackFrame> inline_frame(new StackFrame(memoized_inline));
+      inline_frame->instruction = frame->instruction;
+      inline_frame->module = module;
+      inline_frame->function_base += base_address;
+      inline_frame->source_line_base += base_address;
+      inlined_frames->push_back(std::move(inline_frame));
+    }
+  }
+  *result = memoized->second.result;
+  return true;
+}
+
+StackFrameSymbolizer::SymbolizerResult StackFrameSymbolizer::FillFromResolver(
+    StackFrame* frame,
+    std::deque<std::unique_ptr<StackFrame>>* inlined_frames) {
+  size_t first_inline = inlined_frames ? inlined_frames->size() : 0;
+  resolver_->FillSourceLineInfo(frame, inlined_frames);
+  SymbolizerResult result = resolver_->IsModuleCorrupt(frame->module) ?
+      kWarningCorruptSymbols : kNoError;
+
+  // Addresses are memoized relative to the module, so that the same frame
+  // is recognized in a dump where the module was loaded elsewhere.
+  const CodeModule* module = frame->module;
+  uint64_t base_address = module->base_address();
+  MemoizedFrame memoized;
+  memoized.result = result;
+  memoized.frame.function_name = frame->function_name;
+  memoized.frame.function_base = frame->function_base - base_address;
+  memoized.frame.source_file_name = frame->source_file_name;
+  memoized.frame.source_line = frame->source_line;
+  memoized.frame.source_line_base = frame->source_line_base - base_address;
+  memoized.frame.is_multiple = frame->is_multiple;
+  if (inlined_frames) {
+    for (size_t i = first_inline; i < inlined_frames->size(); ++i) {
+      memoized.inlined_frames.push_back(*(*inlined_frames)[i]);
+      StackFrame& memoized_inline = memoized.inlined_frames.back();
+      memoized_inline.module = NULL;
+      memoized_inline.function_base -= base_address;
+      memoized_inline.source_line_base -= base_address;
+    }
+  }
+
+  std::unique_lock<std::shared_mutex> memo_writer_lock(frame_memo_lock_);
+  if (frame_memo_size_ >= kMaxMemoizedFrames) {
+    frame_memo_.clear();
+    frame_memo_size_ = 0;
+  }
+  ModuleFrameMemo& module_memo = frame_memo_[
+      MemoModuleKey(module->code_file(), module->debug_identifier())];
+  if (module_memo.insert(std::make_pair(
+          MemoAddressKey(frame->instruction - base_address,
+                         inlined_frames != NULL),
+          std::move(memoized))).second) {
+    ++frame_memo_size_;
+  }
+  return result;
+}
+
 }  // namespace google_breakpad
@@ -0,0 +1,141 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// stack_signature_generator.cc: Derives crash signatures from stacks.
+//
+// See stack_signature_generator.h for documentation.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "google_breakpad/processor/stack_signature_generator.h"
+
+#include <stdio.h>
+
+
+#include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "processor/pathname_stripper.h"
+
+namespace google_breakpad {
+
+namespace {
+
+// Functions that raise or report a crash, on the platforms Breakpad
+// supports.
+const char* const kDefaultSkippedFunctions[] = {
+  "abort",
+  "__GI_abort",
+  "raise",
+  "__GI_raise",
+  "gsignal",
+  "pthread_kill",
+  "__pthread_kill*",
+  "RaiseException",
+  "RaiseFailFastException",
+  "_CxxThrowException",
+};
+
+const char kFrameSeparator[] = " | ";
+
+}  // namespace
+
+StackSignatureGenerator::StackSignatureGenerator()
+    : frame_count_(kDefaultFrameCount) {
+  for (const char* function_name : kDefaultSkippedFunctions)
+    AddSkippedFunction(function_name);
+}
+
+void StackSignatureGenerator::AddSkippedFunction(const string& function_name) {
+  if (!function_name.empty() &&
+      function_name[function_name.size() - 1] == '*') {
+    skipped_function_prefixes_.insert(
+        function_name.substr(0, function_name.size() - 1));
+  } else {
+    skipped_functions_.insert(function_name);
+  }
+}
+
+void StackSignatureGenerator::ClearSkippedFunctions() {
+  skipped_functions_.clear();
+  skipped_function_prefixes_.clear();
+}
+
+bool StackSignatureGenerator::IsSkipped(const StackFrame& frame) const {
+  if (frame.function_name.empty())
+    return false;
+  // Symbol files may give C++ functions with their parameter lists.
+  string name = frame.function_name.substr(0, frame.function_name.find('('));
+  if (skipped_functions_.count(name))
+    return true;
+  for (const string& prefix : skipped_function_prefixes_) {
+    if (name.compare(0, prefix.size(), prefix) == 0)
+      return true;
+  }
+  return false;
+}
+
+string StackSignatureGenerator::Generate(const CallStack& stack) const {
+  string signature;
+  int frame_count = 0;
+  for (const StackFrame* frame : *stack.frames()) {
+    if (frame_count >= frame_count_)
+      break;
+    if (IsSkipped(*frame))
+      continue;
+    if (frame_count > 0)
+      signature += kFrameSeparator;
+    if (!frame->function_name.empty()) {
+      signature += frame->function_name;
+    } else if (frame->module) {
+      char offset[32];
+      snprintf(offset, sizeof(offset), "+0x%" PRIx64,
+               frame->ReturnAddress() - frame->module->base_address());
+      signature += PathnameStripper::File(frame->module->code_file());
+      signature += offset;
+    } else {
+      signature += "??";
+    }
+    ++frame_count;
+  }
+  return signature;
+}
+
+// static
+uint64_t StackSignatureGenerator::Hash(const string& signature) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (unsigned char c : signature) {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+}  // namespace google_breakpad
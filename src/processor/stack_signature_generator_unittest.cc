@@ -0,0 +1,145 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Unit tests for StackSignatureGenerator.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <stdlib.h>
+
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/minidump_processor.h"
+#include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/stack_signature_generator.h"
+#include "processor/simple_symbol_supplier.h"
+
+namespace {
+
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::CallStack;
+using google_breakpad::MinidumpProcessor;
+using google_breakpad::ProcessState;
+using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::StackSignatureGenerator;
+
+string GetTestDataPath() {
+  char* srcdir = getenv("srcdir");
+
+  return string(srcdir ? srcdir : ".") + "/src/processor/testdata/";
+}
+
+// The requesting thread of minidump2.dmp, symbolized.
+const char kSymbolizedSignature[] =
+    "`anonymous namespace'::CrashFunction | main | __tmainCRTStartup | "
+    "BaseProcessStart";
+
+class StackSignatureGeneratorTest : public ::testing::Test {
+ public:
+  StackSignatureGeneratorTest()
+      : supplier_(GetTestDataPath() + "symbols"),
+        processor_(&supplier_, &resolver_) {}
+
+  void SetUp() {
+    ASSERT_EQ(google_breakpad::PROCESS_OK,
+              processor_.Process(GetTestDataPath() + "minidump2.dmp",
+                                 &state_));
+    ASSERT_EQ(0, state_.requesting_thread());
+  }
+
+  const CallStack& stack() const { return *state_.threads()->at(0); }
+
+  SimpleSymbolSupplier supplier_;
+  BasicSourceLineResolver resolver_;
+  MinidumpProcessor processor_;
+  ProcessState state_;
+};
+
+TEST_F(StackSignatureGeneratorTest, Generate) {
+  StackSignatureGenerator generator;
+  EXPECT_EQ(kSymbolizedSignature, generator.Generate(stack()));
+
+  generator.set_frame_count(2);
+  EXPECT_EQ("`anonymous namespace'::CrashFunction | main",
+            generator.Generate(stack()));
+  generator.set_frame_count(0);
+  EXPECT_EQ("", generator.Generate(stack()));
+}
+
+TEST_F(StackSignatureGeneratorTest, SkippedFunctions) {
+  StackSignatureGenerator generator;
+  generator.set_frame_count(2);
+  generator.AddSkippedFunction("`anonymous namespace'::*");
+  EXPECT_EQ("main | __tmainCRTStartup", generator.Generate(stack()));
+  generator.AddSkippedFunction("__tmainCRTStartup");
+  EXPECT_EQ("main | BaseProcessStart", generator.Generate(stack()));
+  generator.ClearSkippedFunctions();
+  EXPECT_EQ("`anonymous namespace'::CrashFunction | main",
+            generator.Generate(stack()));
+}
+
+TEST(StackSignatureGeneratorUnsymbolizedTest, Generate) {
+  // Frames without functions are named by their module's file and offset.
+  MinidumpProcessor processor(nullptr, nullptr);
+  ProcessState state;
+  ASSERT_EQ(google_breakpad::PROCESS_OK,
+            processor.Process(GetTestDataPath() + "minidump2.dmp", &state));
+  StackSignatureGenerator generator;
+  string signature = generator.Generate(*state.threads()->at(0));
+  EXPECT_EQ(0U, signature.find("test_app.exe+0x"));
+  EXPECT_EQ(string::npos, signature.find('\\'));
+}
+
+TEST(StackSignatureGeneratorHashTest, Hash) {
+  // The FNV-1a hash is the same everywhere.
+  EXPECT_EQ(0xcbf29ce484222325ULL, StackSignatureGenerator::Hash(""));
+  EXPECT_EQ(0xaf63dc4c8601ec8cULL, StackSignatureGenerator::Hash("a"));
+  EXPECT_NE(StackSignatureGenerator::Hash("main | abort"),
+            StackSignatureGenerator::Hash("abort | main"));
+}
+
+TEST_F(StackSignatureGeneratorTest, RecordedByProcessor) {
+  EXPECT_EQ("", state_.stack_signature());
+  EXPECT_EQ(0U, state_.stack_signature_hash());
+
+  StackSignatureGenerator generator;
+  processor_.set_stack_signature_generator(&generator);
+  ASSERT_EQ(google_breakpad::PROCESS_OK,
+            processor_.Process(GetTestDataPath() + "minidump2.dmp", &state_));
+  EXPECT_EQ(kSymbolizedSignature, state_.stack_signature());
+  EXPECT_EQ(StackSignatureGenerator::Hash(kSymbolizedSignature),
+            state_.stack_signature_hash());
+}
+
+}  // namespace
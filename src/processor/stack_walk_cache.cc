@@ -0,0 +1,177 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// stack_walk_cache.cc: Stack walks kept across minidumps.
+//
+// See stack_walk_cache.h for documentation.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "google_breakpad/processor/stack_walk_cache.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "google_breakpad/processor/stack_frame.h"
+#include "google_breakpad/processor/stack_frame_cpu.h"
+
+namespace google_breakpad {
+
+namespace {
+
+// The memory accounted to each frame of a walk besides its strings: that of
+// the largest frame, which has the most registers.
+const size_t kFrameMemoryUsage = sizeof(StackFrameARM64);
+
+size_t WalkMemoryUsage(const string& key, const StackWalkCache::Walk& walk) {
+  size_t memory_usage = key.size() + sizeof(walk) +
+                        walk.frame_modules.size() * sizeof(int);
+  for (const StackFrame* frame : *walk.stack.frames()) {
+    memory_usage += kFrameMemoryUsage + frame->function_name.size() +
+                    frame->source_file_name.size();
+  }
+  return memory_usage;
+}
+
+}  // namespace
+
+StackWalkCache::StackWalkCache(size_t memory_budget)
+    : memory_budget_(memory_budget),
+      memory_usage_(0),
+      hits_(0),
+      misses_(0),
+      invalidations_(0),
+      evictions_(0) {}
+
+StackWalkCache::~StackWalkCache() {}
+
+std::shared_ptr<const StackWalkCache::Walk> StackWalkCache::Lookup(
+    const string& key) {
+  size_t hash = std::hash<string>()(key);
+  std::lock_guard<std::mutex> lock(lock_);
+  auto candidates = index_.equal_range(hash);
+  for (auto candidate = candidates.first; candidate != candidates.second;
+       ++candidate) {
+    EntryList::iterator entry = candidate->second;
+    if (entry->key == key) {
+      entries_.splice(entries_.begin(), entries_, entry);
+      ++hits_;
+      return entry->walk;
+    }
+  }
+  ++misses_;
+  return std::shared_ptr<const Walk>();
+}
+
+void StackWalkCache::Insert(const string& key,
+                            const std::shared_ptr<const Walk>& walk,
+                            const std::shared_ptr<const ModuleSet>& modules) {
+  size_t memory_usage = WalkMemoryUsage(key, *walk);
+  if (memory_usage > memory_budget_)
+    return;
+
+  size_t hash = std::hash<string>()(key);
+  std::lock_guard<std::mutex> lock(lock_);
+  auto candidates = index_.equal_range(hash);
+  for (auto candidate = candidates.first; candidate != candidates.second;
+       ++candidate) {
+    if (candidate->second->key == key) {
+      // Another processor walked the same stack meanwhile.
+      Erase(candidate->second);
+      break;
+    }
+  }
+
+  while (!entries_.empty() && memory_usage_ + memory_usage > memory_budget_) {
+    Erase(std::prev(entries_.end()));
+    ++evictions_;
+  }
+
+  Entry entry;
+  entry.key = key;
+  entry.hash = hash;
+  entry.walk = walk;
+  entry.modules = modules;
+  entry.memory_usage = memory_usage;
+  entries_.push_front(std::move(entry));
+  index_.insert(std::make_pair(hash, entries_.begin()));
+  memory_usage_ += memory_usage;
+}
+
+void StackWalkCache::InvalidateModule(const string& debug_file,
+                                      const string& debug_identifier) {
+  string module = debug_file + "/" + debug_identifier;
+  std::lock_guard<std::mutex> lock(lock_);
+  for (EntryList::iterator entry = entries_.begin();
+       entry != entries_.end(); ) {
+    EntryList::iterator next = std::next(entry);
+    if (entry->modules->count(module) != 0) {
+      Erase(entry);
+      ++invalidations_;
+    }
+    entry = next;
+  }
+}
+
+void StackWalkCache::Clear() {
+  std::lock_guard<std::mutex> lock(lock_);
+  invalidations_ += entries_.size();
+  entries_.clear();
+  index_.clear();
+  memory_usage_ = 0;
+}
+
+StackWalkCache::Stats StackWalkCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(lock_);
+  Stats stats;
+  stats.hits = hits_;
+  stats.misses = misses_;
+  stats.invalidations = invalidations_;
+  stats.evictions = evictions_;
+  stats.walk_count = entries_.size();
+  stats.memory_usage = memory_usage_;
+  return stats;
+}
+
+void StackWalkCache::Erase(EntryList::iterator entry) {
+  auto candidates = index_.equal_range(entry->hash);
+  for (auto candidate = candidates.first; candidate != candidates.second;
+       ++candidate) {
+    if (candidate->second == entry) {
+      index_.erase(candidate);
+      break;
+    }
+  }
+  memory_usage_ -= entry->memory_usage;
+  entries_.erase(entry);
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,186 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// stackwalk_benchmark.cc: Time how long MinidumpProcessor takes to walk the
+// stacks of minidumps whose symbols are already loaded.
+//
+// Each minidump is read and processed once, which loads its symbols, and
+// then processed again repeatedly; the time reported is the mean of the
+// repeated runs, so it is dominated by stack walking rather than by reading
+// files.  Given no minidumps, the benchmark walks the x86 minidumps in
+// src/processor/testdata with the symbols there, which exercise
+// StackwalkerX86's STACK WIN handling.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/minidump.h"
+#include "google_breakpad/processor/minidump_processor.h"
+#include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/system_info.h"
+#include "processor/simple_symbol_supplier.h"
+
+namespace {
+
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::Minidump;
+using google_breakpad::MinidumpProcessor;
+using google_breakpad::ProcessState;
+using google_breakpad::SimpleSymbolSupplier;
+using std::vector;
+
+void Usage(const char* program_name) {
+  fprintf(stderr,
+          "usage: %s [-n iterations] [-s symbol-path] [minidump-file...]\n"
+          "\n"
+          "Walks each minidump's stacks iterations times (default 1000)\n"
+          "with the symbols in symbol-path, and prints the mean time per\n"
+          "walk.  Given no minidumps, walks the x86 minidumps in\n"
+          "src/processor/testdata, under $srcdir if set.\n",
+          program_name);
+}
+
+// The number of frames in all of state's threads.
+size_t CountFrames(const ProcessState& state) {
+  size_t frames = 0;
+  for (const google_breakpad::CallStack* stack : *state.threads())
+    frames += stack->frames()->size();
+  return frames;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int iterations = 1000;
+  string symbol_path;
+  int ch;
+  while ((ch = getopt(argc, argv, "hn:s:")) != -1) {
+    switch (ch) {
+      case 'n':
+        iterations = atoi(optarg);
+        break;
+      case 's':
+        symbol_path = optarg;
+        break;
+      case 'h':
+      default:
+        Usage(argv[0]);
+        return ch == 'h' ? 0 : 1;
+    }
+  }
+  if (iterations < 1) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  vector<string> minidumps(argv + optind, argv + argc);
+  bool x86_only = false;
+  if (minidumps.empty()) {
+    const char* srcdir = getenv("srcdir");
+    string testdata = string(srcdir ? srcdir : ".") + "/src/processor/testdata";
+    if (symbol_path.empty())
+      symbol_path = testdata + "/symbols";
+    DIR* dir = opendir(testdata.c_str());
+    if (!dir) {
+      fprintf(stderr, "Can't open %s\n", testdata.c_str());
+      return 1;
+    }
+    while (struct dirent* entry = readdir(dir)) {
+      size_t length = strlen(entry->d_name);
+      if (length > 4 && strcmp(entry->d_name + length - 4, ".dmp") == 0)
+        minidumps.push_back(testdata + "/" + entry->d_name);
+    }
+    closedir(dir);
+    std::sort(minidumps.begin(), minidumps.end());
+    x86_only = true;
+  }
+
+  SimpleSymbolSupplier supplier(symbol_path);
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(&supplier, &resolver);
+
+  double total_seconds = 0;
+  size_t total_frames = 0;
+  printf("%-40s %8s %12s\n", "minidump", "frames", "us/walk");
+  for (const string& path : minidumps) {
+    Minidump dump(path);
+    ProcessState state;
+    bool processed = dump.Read() &&
+        processor.Process(&dump, &state) == google_breakpad::PROCESS_OK;
+    // testdata also holds microdumps and minidumps for other CPUs; skip them.
+    if (x86_only && (!processed || state.system_info()->cpu != "x86"))
+      continue;
+    if (!processed) {
+      fprintf(stderr, "Can't process %s\n", path.c_str());
+      return 1;
+    }
+
+    // Processing logs to stderr at INFO level, which would otherwise cost
+    // more than the walks being timed.
+    fflush(stderr);
+    int saved_stderr = dup(STDERR_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDERR_FILENO);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+      processor.Process(&dump, &state);
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    dup2(saved_stderr, STDERR_FILENO);
+    close(null_fd);
+    close(saved_stderr);
+
+    size_t frames = CountFrames(state);
+    size_t slash = path.find_last_of('/');
+    printf("%-40s %8zu %12.1f\n",
+           path.substr(slash == string::npos ? 0 : slash + 1).c_str(),
+           frames, seconds * 1e6 / iterations);
+    total_seconds += seconds;
+    total_frames += frames * iterations;
+  }
+  if (total_seconds > 0) {
+    printf("%.0f frames/s\n", total_frames / total_seconds);
+  }
+  return 0;
+}
@@ -42,6 +42,8 @@
 #include <string.h>
 
 #include <string>
+#include <string_view>
+#include <unordered_set>
 #include <vector>
 
 #include "common/stdio_wrapper.h"
@@ -50,6 +52,7 @@
 #include "google_breakpad/processor/code_module.h"
 #include "google_breakpad/processor/code_modules.h"
 #include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/processing_stats.h"
 #include "google_breakpad/processor/source_line_resolver_interface.h"
 #include "google_breakpad/processor/stack_frame_cpu.h"
 #include "processor/logging.h"
@@ -65,7 +68,7 @@ using std::unique_ptr;
 // Separator character for machine readable output.
 static const char kOutputSeparator = '|';
 
-// PrintRegister prints a register's name and value to stdout.  It will
+// PrintRegister prints a register's name and value to output.  It will
 // print four registers on a line.  For the first register in a set,
 // pass 0 for |start_col|.  For registers in a set, pass the most recent
 // return value of PrintRegister.
@@ -73,29 +76,31 @@ static const char kOutputSeparator = '|';
 // of registers is completely printed, regardless of the number of calls
 // to PrintRegister.
 static const int kMaxWidth = 80;  // optimize for an 80-column terminal
-static int PrintRegister(const char* name, uint32_t value, int start_col) {
+static int PrintRegister(FILE* output, const char* name, uint32_t value,
+                         int start_col) {
   char buffer[64];
   snprintf(buffer, sizeof(buffer), " %5s = 0x%08x", name, value);
 
   if (start_col + static_cast<ssize_t>(strlen(buffer)) > kMaxWidth) {
     start_col = 0;
-    printf("\n ");
+    fprintf(output, "\n ");
   }
-  fputs(buffer, stdout);
+  fputs(buffer, output);
 
   return start_col + strlen(buffer);
 }
 
 // PrintRegister64 does the same thing, but for 64-bit registers.
-static int PrintRegister64(const char* name, uint64_t value, int start_col) {
+static int PrintRegister64(FILE* output, const char* name, uint64_t value,
+                           int start_col) {
   char buffer[64];
   snprintf(buffer, sizeof(buffer), " %5s = 0x%016" PRIx64 , name, value);
 
   if (start_col + static_cast<ssize_t>(strlen(buffer)) > kMaxWidth) {
     start_col = 0;
-    printf("\n ");
+    fprintf(output, "\n ");
   }
-  fputs(buffer, stdout);
+  fputs(buffer, output);
 
   return start_col + strlen(buffer);
 }
@@ -115,8 +120,31 @@ static string StripSeparator(const string& original) {
   return result;
 }
 
-// PrintStackContents prints the stack contents of the current frame to stdout.
-static void PrintStackContents(const string& indent,
+// PrintView prints |text| to output.  It stops at an embedded NUL, as
+// printing c_str() with "%s" would, but doesn't need a NUL-terminated copy,
+// so names can be printed straight from views into the strings that hold
+// them.
+static void PrintView(FILE* output, std::string_view text) {
+  fprintf(output, "%.*s", static_cast<int>(text.size()), text.data());
+}
+
+// PrintStripped prints |text| to output with all occurrences of
+// |kOutputSeparator| and newlines removed, like StripSeparator, but without
+// copying it.  The machine-readable output uses it for the names printed
+// for every frame and module.
+static void PrintStripped(FILE* output, std::string_view text) {
+  std::string_view::size_type start = 0;
+  for (std::string_view::size_type i = 0; i < text.size(); ++i) {
+    if (text[i] == kOutputSeparator || text[i] == '\n') {
+      PrintView(output, text.substr(start, i - start));
+      start = i + 1;
+    }
+  }
+  PrintView(output, text.substr(start));
+}
+
+// PrintStackContents prints the stack contents of the current frame to output.
+static void PrintStackContents(FILE* output, const string& indent,
                                const StackFrame* frame,
                                const StackFrame* prev_frame,
                                const string& cpu,
@@ -203,13 +231,14 @@ static void PrintStackContents(const string& indent,
     return;
 
   // Print stack contents.
-  printf("\n%sStack contents:", indent.c_str());
+  fprintf(output, "\n%sStack contents:", indent.c_str());
   for(uint64_t address = stack_begin; address < stack_end; ) {
     // Print the start address of this row.
     if (word_length == 4)
-      printf("\n%s %08x", indent.c_str(), static_cast<uint32_t>(address));
+      fprintf(output, "\n%s %08x", indent.c_str(),
+              static_cast<uint32_t>(address));
     else
-      printf("\n%s %016" PRIx64, indent.c_str(), address);
+      fprintf(output, "\n%s %016" PRIx64, indent.c_str(), address);
 
     // Print data in hex.
     const int kBytesPerRow = 16;
@@ -218,19 +247,19 @@ static void PrintStackContents(const string& indent,
       uint8_t value = 0;
       if (address < stack_end &&
           memory->GetMemoryAtAddress(address, &value)) {
-        printf(" %02x", value);
+        fprintf(output, " %02x", value);
         data_as_string.push_back(isprint(value) ? value : '.');
       } else {
-        printf("   ");
+        fprintf(output, "   ");
         data_as_string.push_back(' ');
       }
     }
     // Print data as string.
-    printf("  %s", data_as_string.c_str());
+    fprintf(output, "  %s", data_as_string.c_str());
   }
 
   // Try to find instruction pointers from stack.
-  printf("\n%sPossible instruction pointers:\n", indent.c_str());
+  fprintf(output, "\n%sPossible instruction pointers:\n", indent.c_str());
   for (uint64_t address = stack_begin; address < stack_end;
        address += word_length) {
     StackFrame pointee_frame;
@@ -257,53 +286,57 @@ static void PrintStackContents(const string& indent,
     auto print_function_name = [&](StackFrame* frame) {
       if (!frame->function_name.empty()) {
         if (word_length == 4) {
-          printf("%s *(0x%08x) = 0x%08x", indent.c_str(),
+          fprintf(output, "%s *(0x%08x) = 0x%08x", indent.c_str(),
                  static_cast<uint32_t>(address),
                  static_cast<uint32_t>(frame->instruction));
         } else {
-          printf("%s *(0x%016" PRIx64 ") = 0x%016" PRIx64, indent.c_str(),
+          fprintf(output, "%s *(0x%016" PRIx64 ") = 0x%016" PRIx64,
+                  indent.c_str(),
                  address, frame->instruction);
         }
-        printf(
-            " <%s> [%s : %d + 0x%" PRIx64 "]\n", frame->function_name.c_str(),
-            PathnameStripper::File(frame->source_file_name).c_str(),
-            frame->source_line, frame->instruction - frame->source_line_base);
+        fprintf(output, " <%s> [", frame->function_name.c_str());
+        PrintView(output, PathnameStripper::FileView(frame->source_file_name));
+        fprintf(output, " : %d + 0x%" PRIx64 "]\n", frame->source_line,
+                frame->instruction - frame->source_line_base);
       }
     };
     print_function_name(&pointee_frame);
     for (unique_ptr<StackFrame> &frame : inlined_frames)
       print_function_name(frame.get());
   }
-  printf("\n");
+  fprintf(output, "\n");
 }
 
-static void PrintFrameHeader(const StackFrame* frame, int frame_index) {
-  printf("%2d  ", frame_index);
+static void PrintFrameHeader(FILE* output, const StackFrame* frame,
+                             int frame_index) {
+  fprintf(output, "%2d  ", frame_index);
 
   uint64_t instruction_address = frame->ReturnAddress();
 
   if (frame->module) {
-    printf("%s", PathnameStripper::File(frame->module->code_file()).c_str());
+    PrintView(output, PathnameStripper::FileView(frame->module->code_file()));
     if (!frame->function_name.empty()) {
-      printf("!%s", frame->function_name.c_str());
+      fprintf(output, "!%s", frame->function_name.c_str());
       if (!frame->source_file_name.empty()) {
-        string source_file = PathnameStripper::File(frame->source_file_name);
-        printf(" [%s : %d + 0x%" PRIx64 "]", source_file.c_str(),
+        fprintf(output, " [");
+        PrintView(output, PathnameStripper::FileView(frame->source_file_name));
+        fprintf(output, " : %d + 0x%" PRIx64 "]",
                frame->source_line,
                instruction_address - frame->source_line_base);
       } else {
-        printf(" + 0x%" PRIx64, instruction_address - frame->function_base);
+        fprintf(output, " + 0x%" PRIx64,
+                instruction_address - frame->function_base);
       }
     } else {
-      printf(" + 0x%" PRIx64,
+      fprintf(output, " + 0x%" PRIx64,
              instruction_address - frame->module->base_address());
     }
   } else {
-    printf("0x%" PRIx64, instruction_address);
+    fprintf(output, "0x%" PRIx64, instruction_address);
   }
 }
 
-// PrintStack prints the call stack in |stack| to stdout, in a reasonably
+// PrintStack prints the call stack in |stack| to output, in a reasonably
 // useful form.  Module, function, and source file names are displayed if
 // they are available.  The code offset to the base code address of the
 // source line, function, or module is printed, preferring them in that
@@ -312,7 +345,7 @@ static void PrintFrameHeader(const StackFrame* frame, int frame_index) {
 //
 // If |cpu| is a recognized CPU name, relevant register state for each stack
 // frame printed is also output, if available.
-static void PrintStack(const CallStack* stack,
+static void PrintStack(FILE* output, const CallStack* stack,
                        const string& cpu,
                        bool output_stack_contents,
                        const MemoryRegion* memory,
@@ -320,12 +353,12 @@ static void PrintStack(const CallStack* stack,
                        SourceLineResolverInterface* resolver) {
   int frame_count = stack->frames()->size();
   if (frame_count == 0) {
-    printf(" <no frames>\n");
+    fprintf(output, " <no frames>\n");
   }
   for (int frame_index = 0; frame_index < frame_count; ++frame_index) {
     const StackFrame* frame = stack->frames()->at(frame_index);
-    PrintFrameHeader(frame, frame_index);
-    printf("\n ");
+    PrintFrameHeader(output, frame, frame_index);
+    fprintf(output, "\n ");
 
     // Inlined frames don't have registers info.
     if (frame->trust != StackFrameAMD64::FRAME_TRUST_INLINE) {
@@ -335,81 +368,113 @@ static void PrintStack(const CallStack* stack,
             reinterpret_cast<const StackFrameX86*>(frame);
 
         if (frame_x86->context_validity & StackFrameX86::CONTEXT_VALID_EIP)
-          sequence = PrintRegister("eip", frame_x86->context.eip, sequence);
+          sequence = PrintRegister(output, "eip", frame_x86->context.eip,
+                                   sequence);
         if (frame_x86->context_validity & StackFrameX86::CONTEXT_VALID_ESP)
-          sequence = PrintRegister("esp", frame_x86->context.esp, sequence);
+          sequence = PrintRegister(output, "esp", frame_x86->context.esp,
+                                   sequence);
         if (frame_x86->context_validity & StackFrameX86::CONTEXT_VALID_EBP)
-          sequence = PrintRegister("ebp", frame_x86->context.ebp, sequence);
+          sequence = PrintRegister(output, "ebp", frame_x86->context.ebp,
+                                   sequence);
         if (frame_x86->context_validity & StackFrameX86::CONTEXT_VALID_EBX)
-          sequence = PrintRegister("ebx", frame_x86->context.ebx, sequence);
+          sequence = PrintRegister(output, "ebx", frame_x86->context.ebx,
+                                   sequence);
         if (frame_x86->context_validity & StackFrameX86::CONTEXT_VALID_ESI)
-          sequence = PrintRegister("esi", frame_x86->context.esi, sequence);
+          sequence = PrintRegister(output, "esi", frame_x86->context.esi,
+                                   sequence);
         if (frame_x86->context_validity & StackFrameX86::CONTEXT_VALID_EDI)
-          sequence = PrintRegister("edi", frame_x86->context.edi, sequence);
+          sequence = PrintRegister(output, "edi", frame_x86->context.edi,
+                                   sequence);
         if (frame_x86->context_validity == StackFrameX86::CONTEXT_VALID_ALL) {
-          sequence = PrintRegister("eax", frame_x86->context.eax, sequence);
-          sequence = PrintRegister("ecx", frame_x86->context.ecx, sequence);
-          sequence = PrintRegister("edx", frame_x86->context.edx, sequence);
-          sequence = PrintRegister("efl", frame_x86->context.eflags, sequence);
+          sequence = PrintRegister(output, "eax", frame_x86->context.eax,
+                                   sequence);
+          sequence = PrintRegister(output, "ecx", frame_x86->context.ecx,
+                                   sequence);
+          sequence = PrintRegister(output, "edx", frame_x86->context.edx,
+                                   sequence);
+          sequence = PrintRegister(output, "efl", frame_x86->context.eflags,
+                                   sequence);
         }
       } else if (cpu == "ppc") {
         const StackFramePPC* frame_ppc =
             reinterpret_cast<const StackFramePPC*>(frame);
 
         if (frame_ppc->context_validity & StackFramePPC::CONTEXT_VALID_SRR0)
-          sequence = PrintRegister("srr0", frame_ppc->context.srr0, sequence);
+          sequence = PrintRegister(output, "srr0", frame_ppc->context.srr0,
+                                   sequence);
         if (frame_ppc->context_validity & StackFramePPC::CONTEXT_VALID_GPR1)
-          sequence = PrintRegister("r1", frame_ppc->context.gpr[1], sequence);
+          sequence = PrintRegister(output, "r1", frame_ppc->context.gpr[1],
+                                   sequence);
       } else if (cpu == "amd64") {
         const StackFrameAMD64* frame_amd64 =
             reinterpret_cast<const StackFrameAMD64*>(frame);
 
         if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RAX)
-          sequence = PrintRegister64("rax", frame_amd64->context.rax, sequence);
+          sequence = PrintRegister64(output, "rax", frame_amd64->context.rax,
+                                     sequence);
         if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RDX)
-          sequence = PrintRegister64("rdx", frame_amd64->context.rdx, sequence);
+          sequence = PrintRegister64(output, "rdx", frame_amd64->context.rdx,
+                                     sequence);
         if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RCX)
-          sequence = PrintRegister64("rcx", frame_amd64->context.rcx, sequence);
+          sequence = PrintRegister64(output, "rcx", frame_amd64->context.rcx,
+                                     sequence);
         if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RBX)
-          sequence = PrintRegister64("rbx", frame_amd64->context.rbx, sequence);
+          sequence = PrintRegister64(output, "rbx", frame_amd64->context.rbx,
+                                     sequence);
         if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RSI)
-          sequence = PrintRegister64("rsi", frame_amd64->context.rsi, sequence);
+          sequence = PrintRegister64(output, "rsi", frame_amd64->context.rsi,
+                                     sequence);
         if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RDI)
-          sequence = PrintRegister64("rdi", frame_amd64->context.rdi, sequence);
+          sequence = PrintRegister64(output, "rdi", frame_amd64->context.rdi,
+                                     sequence);
         if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RBP)
-          sequence = PrintRegister64("rbp", frame_amd64->context.rbp, sequence);
+          sequence = PrintRegister64(output, "rbp", frame_amd64->context.rbp,
+                                     sequence);
         if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RSP)
-          sequence = PrintRegister64("rsp", frame_amd64->context.rsp, sequence);
+          sequence = PrintRegister64(output, "rsp", frame_amd64->context.rsp,
+                                     sequence);
         if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R8)
-          sequence = PrintRegister64("r8", frame_amd64->context.r8, sequence);
+          sequence = PrintRegister64(output, "r8", frame_amd64->context.r8,
+                                     sequence);
         if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R9)
-          sequence = PrintRegister64("r9", frame_amd64->context.r9, sequence);
+          sequence = PrintRegister64(output, "r9", frame_amd64->context.r9,
+                                     sequence);
         if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R10)
-          sequence = PrintRegister64("r10", frame_amd64->context.r10, sequence);
+          sequence = PrintRegister64(output, "r10", frame_amd64->context.r10,
+                                     sequence);
         if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R11)
-          sequence = PrintRegister64("r11", frame_amd64->context.r11, sequence);
+          sequence = PrintRegister64(output, "r11", frame_amd64->context.r11,
+                                     sequence);
         if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R12)
-          sequence = PrintRegister64("r12", frame_amd64->context.r12, sequence);
+          sequence = PrintRegister64(output, "r12", frame_amd64->context.r12,
+                                     sequence);
         if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R13)
-          sequence = PrintRegister64("r13", frame_amd64->context.r13, sequence);
+          sequence = PrintRegister64(output, "r13", frame_amd64->context.r13,
+                                     sequence);
         if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R14)
-          sequence = PrintRegister64("r14", frame_amd64->context.r14, sequence);
+          sequence = PrintRegister64(output, "r14", frame_amd64->context.r14,
+                                     sequence);
         if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_R15)
-          sequence = PrintRegister64("r15", frame_amd64->context.r15, sequence);
+          sequence = PrintRegister64(output, "r15", frame_amd64->context.r15,
+                                     sequence);
         if (frame_amd64->context_validity & StackFrameAMD64::CONTEXT_VALID_RIP)
-          sequence = PrintRegister64("rip", frame_amd64->context.rip, sequence);
+          sequence = PrintRegister64(output, "rip", frame_amd64->context.rip,
+                                     sequence);
       } else if (cpu == "sparc") {
         const StackFrameSPARC* frame_sparc =
             reinterpret_cast<const StackFrameSPARC*>(frame);
 
         if (frame_sparc->context_validity & StackFrameSPARC::CONTEXT_VALID_SP)
           sequence =
-              PrintRegister("sp", frame_sparc->context.g_r[14], sequence);
+              PrintRegister(output, "sp", frame_sparc->context.g_r[14],
+                            sequence);
         if (frame_sparc->context_validity & StackFrameSPARC::CONTEXT_VALID_FP)
           sequence =
-              PrintRegister("fp", frame_sparc->context.g_r[30], sequence);
+              PrintRegister(output, "fp", frame_sparc->context.g_r[30],
+                            sequence);
         if (frame_sparc->context_validity & StackFrameSPARC::CONTEXT_VALID_PC)
-          sequence = PrintRegister("pc", frame_sparc->context.pc, sequence);
+          sequence = PrintRegister(output, "pc", frame_sparc->context.pc,
+                                   sequence);
       } else if (cpu == "arm") {
         const StackFrameARM* frame_arm =
             reinterpret_cast<const StackFrameARM*>(frame);
@@ -417,258 +482,308 @@ static void PrintStack(const CallStack* stack,
         // Argument registers (caller-saves), which will likely only be valid
         // for the youngest frame.
         if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R0)
-          sequence = PrintRegister("r0", frame_arm->context.iregs[0], sequence);
+          sequence = PrintRegister(output, "r0", frame_arm->context.iregs[0],
+                                   sequence);
         if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R1)
-          sequence = PrintRegister("r1", frame_arm->context.iregs[1], sequence);
+          sequence = PrintRegister(output, "r1", frame_arm->context.iregs[1],
+                                   sequence);
         if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R2)
-          sequence = PrintRegister("r2", frame_arm->context.iregs[2], sequence);
+          sequence = PrintRegister(output, "r2", frame_arm->context.iregs[2],
+                                   sequence);
         if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R3)
-          sequence = PrintRegister("r3", frame_arm->context.iregs[3], sequence);
+          sequence = PrintRegister(output, "r3", frame_arm->context.iregs[3],
+                                   sequence);
 
         // General-purpose callee-saves registers.
         if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R4)
-          sequence = PrintRegister("r4", frame_arm->context.iregs[4], sequence);
+          sequence = PrintRegister(output, "r4", frame_arm->context.iregs[4],
+                                   sequence);
         if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R5)
-          sequence = PrintRegister("r5", frame_arm->context.iregs[5], sequence);
+          sequence = PrintRegister(output, "r5", frame_arm->context.iregs[5],
+                                   sequence);
         if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R6)
-          sequence = PrintRegister("r6", frame_arm->context.iregs[6], sequence);
+          sequence = PrintRegister(output, "r6", frame_arm->context.iregs[6],
+                                   sequence);
         if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R7)
-          sequence = PrintRegister("r7", frame_arm->context.iregs[7], sequence);
+          sequence = PrintRegister(output, "r7", frame_arm->context.iregs[7],
+                                   sequence);
         if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R8)
-          sequence = PrintRegister("r8", frame_arm->context.iregs[8], sequence);
+          sequence = PrintRegister(output, "r8", frame_arm->context.iregs[8],
+                                   sequence);
         if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R9)
-          sequence = PrintRegister("r9", frame_arm->context.iregs[9], sequence);
+          sequence = PrintRegister(output, "r9", frame_arm->context.iregs[9],
+                                   sequence);
         if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R10)
           sequence =
-              PrintRegister("r10", frame_arm->context.iregs[10], sequence);
+              PrintRegister(output, "r10", frame_arm->context.iregs[10],
+                            sequence);
         if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_R12)
           sequence =
-              PrintRegister("r12", frame_arm->context.iregs[12], sequence);
+              PrintRegister(output, "r12", frame_arm->context.iregs[12],
+                            sequence);
 
         // Registers with a dedicated or conventional purpose.
         if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_FP)
           sequence =
-              PrintRegister("fp", frame_arm->context.iregs[11], sequence);
+              PrintRegister(output, "fp", frame_arm->context.iregs[11],
+                            sequence);
         if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_SP)
           sequence =
-              PrintRegister("sp", frame_arm->context.iregs[13], sequence);
+              PrintRegister(output, "sp", frame_arm->context.iregs[13],
+                            sequence);
         if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_LR)
           sequence =
-              PrintRegister("lr", frame_arm->context.iregs[14], sequence);
+              PrintRegister(output, "lr", frame_arm->context.iregs[14],
+                            sequence);
         if (frame_arm->context_validity & StackFrameARM::CONTEXT_VALID_PC)
           sequence =
-              PrintRegister("pc", frame_arm->context.iregs[15], sequence);
+              PrintRegister(output, "pc", frame_arm->context.iregs[15],
+                            sequence);
       } else if (cpu == "arm64") {
         const StackFrameARM64* frame_arm64 =
             reinterpret_cast<const StackFrameARM64*>(frame);
 
         if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X0) {
           sequence =
-              PrintRegister64("x0", frame_arm64->context.iregs[0], sequence);
+              PrintRegister64(output, "x0", frame_arm64->context.iregs[0],
+                              sequence);
         }
         if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X1) {
           sequence =
-              PrintRegister64("x1", frame_arm64->context.iregs[1], sequence);
+              PrintRegister64(output, "x1", frame_arm64->context.iregs[1],
+                              sequence);
         }
         if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X2) {
           sequence =
-              PrintRegister64("x2", frame_arm64->context.iregs[2], sequence);
+              PrintRegister64(output, "x2", frame_arm64->context.iregs[2],
+                              sequence);
         }
         if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X3) {
           sequence =
-              PrintRegister64("x3", frame_arm64->context.iregs[3], sequence);
+              PrintRegister64(output, "x3", frame_arm64->context.iregs[3],
+                              sequence);
         }
         if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X4) {
           sequence =
-              PrintRegister64("x4", frame_arm64->context.iregs[4], sequence);
+              PrintRegister64(output, "x4", frame_arm64->context.iregs[4],
+                              sequence);
         }
         if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X5) {
           sequence =
-              PrintRegister64("x5", frame_arm64->context.iregs[5], sequence);
+              PrintRegister64(output, "x5", frame_arm64->context.iregs[5],
+                              sequence);
         }
         if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X6) {
           sequence =
-              PrintRegister64("x6", frame_arm64->context.iregs[6], sequence);
+              PrintRegister64(output, "x6", frame_arm64->context.iregs[6],
+                              sequence);
         }
         if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X7) {
           sequence =
-              PrintRegister64("x7", frame_arm64->context.iregs[7], sequence);
+              PrintRegister64(output, "x7", frame_arm64->context.iregs[7],
+                              sequence);
         }
         if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X8) {
           sequence =
-              PrintRegister64("x8", frame_arm64->context.iregs[8], sequence);
+              PrintRegister64(output, "x8", frame_arm64->context.iregs[8],
+                              sequence);
         }
         if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_X9) {
           sequence =
-              PrintRegister64("x9", frame_arm64->context.iregs[9], sequence);
+              PrintRegister64(output, "x9", frame_arm64->context.iregs[9],
+                              sequence);
         }
         if (frame_arm64->context_validity &
             StackFrameARM64::CONTEXT_VALID_X10) {
           sequence =
-              PrintRegister64("x10", frame_arm64->context.iregs[10], sequence);
+              PrintRegister64(output, "x10", frame_arm64->context.iregs[10],
+                              sequence);
         }
         if (frame_arm64->context_validity &
             StackFrameARM64::CONTEXT_VALID_X11) {
           sequence =
-              PrintRegister64("x11", frame_arm64->context.iregs[11], sequence);
+              PrintRegister64(output, "x11", frame_arm64->context.iregs[11],
+                              sequence);
         }
         if (frame_arm64->context_validity &
             StackFrameARM64::CONTEXT_VALID_X12) {
           sequence =
-              PrintRegister64("x12", frame_arm64->context.iregs[12], sequence);
+              PrintRegister64(output, "x12", frame_arm64->context.iregs[12],
+                              sequence);
         }
         if (frame_arm64->context_validity &
             StackFrameARM64::CONTEXT_VALID_X13) {
           sequence =
-              PrintRegister64("x13", frame_arm64->context.iregs[13], sequence);
+              PrintRegister64(output, "x13", frame_arm64->context.iregs[13],
+                              sequence);
         }
         if (frame_arm64->context_validity &
             StackFrameARM64::CONTEXT_VALID_X14) {
           sequence =
-              PrintRegister64("x14", frame_arm64->context.iregs[14], sequence);
+              PrintRegister64(output, "x14", frame_arm64->context.iregs[14],
+                              sequence);
         }
         if (frame_arm64->context_validity &
             StackFrameARM64::CONTEXT_VALID_X15) {
           sequence =
-              PrintRegister64("x15", frame_arm64->context.iregs[15], sequence);
+              PrintRegister64(output, "x15", frame_arm64->context.iregs[15],
+                              sequence);
         }
         if (frame_arm64->context_validity &
             StackFrameARM64::CONTEXT_VALID_X16) {
           sequence =
-              PrintRegister64("x16", frame_arm64->context.iregs[16], sequence);
+              PrintRegister64(output, "x16", frame_arm64->context.iregs[16],
+                              sequence);
         }
         if (frame_arm64->context_validity &
             StackFrameARM64::CONTEXT_VALID_X17) {
           sequence =
-              PrintRegister64("x17", frame_arm64->context.iregs[17], sequence);
+              PrintRegister64(output, "x17", frame_arm64->context.iregs[17],
+                              sequence);
         }
         if (frame_arm64->context_validity &
             StackFrameARM64::CONTEXT_VALID_X18) {
           sequence =
-              PrintRegister64("x18", frame_arm64->context.iregs[18], sequence);
+              PrintRegister64(output, "x18", frame_arm64->context.iregs[18],
+                              sequence);
         }
         if (frame_arm64->context_validity &
             StackFrameARM64::CONTEXT_VALID_X19) {
           sequence =
-              PrintRegister64("x19", frame_arm64->context.iregs[19], sequence);
+              PrintRegister64(output, "x19", frame_arm64->context.iregs[19],
+                              sequence);
         }
         if (frame_arm64->context_validity &
             StackFrameARM64::CONTEXT_VALID_X20) {
           sequence =
-              PrintRegister64("x20", frame_arm64->context.iregs[20], sequence);
+              PrintRegister64(output, "x20", frame_arm64->context.iregs[20],
+                              sequence);
         }
         if (frame_arm64->context_validity &
             StackFrameARM64::CONTEXT_VALID_X21) {
           sequence =
-              PrintRegister64("x21", frame_arm64->context.iregs[21], sequence);
+              PrintRegister64(output, "x21", frame_arm64->context.iregs[21],
+                              sequence);
         }
         if (frame_arm64->context_validity &
             StackFrameARM64::CONTEXT_VALID_X22) {
           sequence =
-              PrintRegister64("x22", frame_arm64->context.iregs[22], sequence);
+              PrintRegister64(output, "x22", frame_arm64->context.iregs[22],
+                              sequence);
         }
         if (frame_arm64->context_validity &
             StackFrameARM64::CONTEXT_VALID_X23) {
           sequence =
-              PrintRegister64("x23", frame_arm64->context.iregs[23], sequence);
+              PrintRegister64(output, "x23", frame_arm64->context.iregs[23],
+                              sequence);
         }
         if (frame_arm64->context_validity &
             StackFrameARM64::CONTEXT_VALID_X24) {
           sequence =
-              PrintRegister64("x24", frame_arm64->context.iregs[24], sequence);
+              PrintRegister64(output, "x24", frame_arm64->context.iregs[24],
+                              sequence);
         }
         if (frame_arm64->context_validity &
             StackFrameARM64::CONTEXT_VALID_X25) {
           sequence =
-              PrintRegister64("x25", frame_arm64->context.iregs[25], sequence);
+              PrintRegister64(output, "x25", frame_arm64->context.iregs[25],
+                              sequence);
         }
         if (frame_arm64->context_validity &
             StackFrameARM64::CONTEXT_VALID_X26) {
           sequence =
-              PrintRegister64("x26", frame_arm64->context.iregs[26], sequence);
+              PrintRegister64(output, "x26", frame_arm64->context.iregs[26],
+                              sequence);
         }
         if (frame_arm64->context_validity &
             StackFrameARM64::CONTEXT_VALID_X27) {
           sequence =
-              PrintRegister64("x27", frame_arm64->context.iregs[27], sequence);
+              PrintRegister64(output, "x27", frame_arm64->context.iregs[27],
+                              sequence);
         }
         if (frame_arm64->context_validity &
             StackFrameARM64::CONTEXT_VALID_X28) {
           sequence =
-              PrintRegister64("x28", frame_arm64->context.iregs[28], sequence);
+              PrintRegister64(output, "x28", frame_arm64->context.iregs[28],
+                              sequence);
         }
 
         // Registers with a dedicated or conventional purpose.
         if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_FP) {
           sequence =
-              PrintRegister64("fp", frame_arm64->context.iregs[29], sequence);
+              PrintRegister64(output, "fp", frame_arm64->context.iregs[29],
+                              sequence);
         }
         if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_LR) {
           sequence =
-              PrintRegister64("lr", frame_arm64->context.iregs[30], sequence);
+              PrintRegister64(output, "lr", frame_arm64->context.iregs[30],
+                              sequence);
         }
         if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_SP) {
           sequence =
-              PrintRegister64("sp", frame_arm64->context.iregs[31], sequence);
+              PrintRegister64(output, "sp", frame_arm64->context.iregs[31],
+                              sequence);
         }
         if (frame_arm64->context_validity & StackFrameARM64::CONTEXT_VALID_PC) {
           sequence =
-              PrintRegister64("pc", frame_arm64->context.iregs[32], sequence);
+              PrintRegister64(output, "pc", frame_arm64->context.iregs[32],
+                              sequence);
         }
       } else if ((cpu == "mips") || (cpu == "mips64")) {
         const StackFrameMIPS* frame_mips =
             reinterpret_cast<const StackFrameMIPS*>(frame);
 
         if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_GP)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "gp", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_GP],
               sequence);
         if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_SP)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "sp", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_SP],
               sequence);
         if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_FP)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "fp", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_FP],
               sequence);
         if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_RA)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "ra", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_RA],
               sequence);
         if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_PC)
-          sequence = PrintRegister64("pc", frame_mips->context.epc, sequence);
+          sequence = PrintRegister64(output, "pc", frame_mips->context.epc,
+                                     sequence);
 
         // Save registers s0-s7
         if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S0)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s0", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S0],
               sequence);
         if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S1)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s1", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S1],
               sequence);
         if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S2)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s2", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S2],
               sequence);
         if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S3)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s3", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S3],
               sequence);
         if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S4)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s4", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S4],
               sequence);
         if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S5)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s5", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S5],
               sequence);
         if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S6)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s6", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S6],
               sequence);
         if (frame_mips->context_validity & StackFrameMIPS::CONTEXT_VALID_S7)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s7", frame_mips->context.iregs[MD_CONTEXT_MIPS_REG_S7],
               sequence);
       } else if (cpu == "riscv") {
@@ -677,131 +792,131 @@ static void PrintStack(const CallStack* stack,
 
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_PC)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "pc", frame_riscv->context.pc, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_RA)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "ra", frame_riscv->context.ra, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_SP)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "sp", frame_riscv->context.sp, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_GP)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "gp", frame_riscv->context.gp, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_TP)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "tp", frame_riscv->context.tp, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_T0)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "t0", frame_riscv->context.t0, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_T1)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "t1", frame_riscv->context.t1, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_T2)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "t2", frame_riscv->context.t2, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_S0)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "s0", frame_riscv->context.s0, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_S1)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "s1", frame_riscv->context.s1, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_A0)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "a0", frame_riscv->context.a0, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_A1)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "a1", frame_riscv->context.a1, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_A2)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "a2", frame_riscv->context.a2, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_A3)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "a3", frame_riscv->context.a3, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_A4)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "a4", frame_riscv->context.a4, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_A5)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "a5", frame_riscv->context.a5, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_A6)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "a6", frame_riscv->context.a6, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_A7)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "a7", frame_riscv->context.a7, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_S2)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "s2", frame_riscv->context.s2, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_S3)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "s3", frame_riscv->context.s3, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_S4)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "s4", frame_riscv->context.s4, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_S5)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "s5", frame_riscv->context.s5, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_S6)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "s6", frame_riscv->context.s6, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_S7)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "s7", frame_riscv->context.s7, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_S8)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "s8", frame_riscv->context.s8, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_S9)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "s9", frame_riscv->context.s9, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_S10)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "s10", frame_riscv->context.s10, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_S11)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "s11", frame_riscv->context.s11, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_T3)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "t3", frame_riscv->context.t3, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_T4)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "t4", frame_riscv->context.t4, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_T5)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "t5", frame_riscv->context.t5, sequence);
         if (frame_riscv->context_validity &
             StackFrameRISCV::CONTEXT_VALID_T6)
-          sequence = PrintRegister(
+          sequence = PrintRegister(output,
               "t6", frame_riscv->context.t6, sequence);
       } else if (cpu == "riscv64") {
         const StackFrameRISCV64* frame_riscv64 =
@@ -809,185 +924,193 @@ static void PrintStack(const CallStack* stack,
 
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_PC)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "pc", frame_riscv64->context.pc, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_RA)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "ra", frame_riscv64->context.ra, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_SP)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "sp", frame_riscv64->context.sp, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_GP)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "gp", frame_riscv64->context.gp, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_TP)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "tp", frame_riscv64->context.tp, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_T0)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "t0", frame_riscv64->context.t0, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_T1)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "t1", frame_riscv64->context.t1, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_T2)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "t2", frame_riscv64->context.t2, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_S0)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s0", frame_riscv64->context.s0, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_S1)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s1", frame_riscv64->context.s1, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_A0)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "a0", frame_riscv64->context.a0, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_A1)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "a1", frame_riscv64->context.a1, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_A2)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "a2", frame_riscv64->context.a2, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_A3)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "a3", frame_riscv64->context.a3, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_A4)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "a4", frame_riscv64->context.a4, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_A5)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "a5", frame_riscv64->context.a5, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_A6)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "a6", frame_riscv64->context.a6, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_A7)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "a7", frame_riscv64->context.a7, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_S2)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s2", frame_riscv64->context.s2, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_S3)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s3", frame_riscv64->context.s3, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_S4)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s4", frame_riscv64->context.s4, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_S5)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s5", frame_riscv64->context.s5, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_S6)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s6", frame_riscv64->context.s6, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_S7)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s7", frame_riscv64->context.s7, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_S8)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s8", frame_riscv64->context.s8, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_S9)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s9", frame_riscv64->context.s9, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_S10)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s10", frame_riscv64->context.s10, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_S11)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "s11", frame_riscv64->context.s11, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_T3)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "t3", frame_riscv64->context.t3, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_T4)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "t4", frame_riscv64->context.t4, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_T5)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "t5", frame_riscv64->context.t5, sequence);
         if (frame_riscv64->context_validity &
             StackFrameRISCV64::CONTEXT_VALID_T6)
-          sequence = PrintRegister64(
+          sequence = PrintRegister64(output,
               "t6", frame_riscv64->context.t6, sequence);
       }
     }
-    printf("\n    Found by: %s\n", frame->trust_description().c_str());
+    fprintf(output, "\n    Found by: %s\n", frame->trust_description().c_str());
 
     // Print stack contents.
     if (output_stack_contents && frame_index + 1 < frame_count) {
       const string indent("    ");
-      PrintStackContents(indent, frame, stack->frames()->at(frame_index + 1),
+      PrintStackContents(output, indent, frame,
+                         stack->frames()->at(frame_index + 1),
                          cpu, memory, modules, resolver);
     }
   }
+  if (stack->truncated()) {
+    fprintf(output, " <stack walk stopped at its time limit>\n");
+  }
+  if (stack->ended_at_terminal_frame()) {
+    fprintf(output, " <stack walk stopped at a terminal function>\n");
+  }
 }
 
-// PrintStackMachineReadable prints the call stack in |stack| to stdout,
+// PrintStackMachineReadable prints the call stack in |stack| to output,
 // in the following machine readable pipe-delimited text format:
 // thread number|frame number|module|function|source file|line|offset
 //
 // Module, function, source file, and source line may all be empty
 // depending on availability.  The code offset follows the same rules as
 // PrintStack above.
-static void PrintStackMachineReadable(int thread_num, const CallStack* stack) {
+static void PrintStackMachineReadable(FILE* output, int thread_num,
+                                      const CallStack* stack) {
   int frame_count = stack->frames()->size();
   for (int frame_index = 0; frame_index < frame_count; ++frame_index) {
     const StackFrame* frame = stack->frames()->at(frame_index);
-    printf("%d%c%d%c", thread_num, kOutputSeparator, frame_index,
+    fprintf(output, "%d%c%d%c", thread_num, kOutputSeparator, frame_index,
            kOutputSeparator);
 
     uint64_t instruction_address = frame->ReturnAddress();
 
     if (frame->module) {
       assert(!frame->module->code_file().empty());
-      printf("%s", StripSeparator(PathnameStripper::File(
-                     frame->module->code_file())).c_str());
+      PrintStripped(output,
+                    PathnameStripper::FileView(frame->module->code_file()));
       if (!frame->function_name.empty()) {
-        printf("%c%s", kOutputSeparator,
-               StripSeparator(frame->function_name).c_str());
+        fprintf(output, "%c", kOutputSeparator);
+        PrintStripped(output, frame->function_name);
         if (!frame->source_file_name.empty()) {
-          printf("%c%s%c%d%c0x%" PRIx64,
-                 kOutputSeparator,
-                 StripSeparator(frame->source_file_name).c_str(),
+          fprintf(output, "%c", kOutputSeparator);
+          PrintStripped(output, frame->source_file_name);
+          fprintf(output, "%c%d%c0x%" PRIx64,
                  kOutputSeparator,
                  frame->source_line,
                  kOutputSeparator,
                  instruction_address - frame->source_line_base);
         } else {
-          printf("%c%c%c0x%" PRIx64,
+          fprintf(output, "%c%c%c0x%" PRIx64,
                  kOutputSeparator,  // empty source file
                  kOutputSeparator,  // empty source line
                  kOutputSeparator,
                  instruction_address - frame->function_base);
         }
       } else {
-        printf("%c%c%c%c0x%" PRIx64,
+        fprintf(output, "%c%c%c%c0x%" PRIx64,
                kOutputSeparator,  // empty function name
                kOutputSeparator,  // empty source file
                kOutputSeparator,  // empty source line
@@ -996,54 +1119,56 @@ static void PrintStackMachineReadable(int thread_num, const CallStack* stack) {
       }
     } else {
       // the printf before this prints a trailing separator for module name
-      printf("%c%c%c%c0x%" PRIx64,
+      fprintf(output, "%c%c%c%c0x%" PRIx64,
              kOutputSeparator,  // empty function name
              kOutputSeparator,  // empty source file
              kOutputSeparator,  // empty source line
              kOutputSeparator,
              instruction_address);
     }
-    printf("\n");
+    fprintf(output, "\n");
   }
 }
 
-// ContainsModule checks whether a given |module| is in the vector
-// |modules_without_symbols|.
-static bool ContainsModule(
-    const vector<const CodeModule*>* modules,
-    const CodeModule* module) {
+// ModuleKey returns the debug file and identifier of |module|, which
+// identify it among the modules with symbol issues.
+static string ModuleKey(const CodeModule* module) {
+  return module->debug_file() + '\n' + module->debug_identifier();
+}
+
+// ModuleKeys returns the keys of |modules|, so that PrintModules can look
+// each loaded module up in them in constant time.
+static std::unordered_set<string> ModuleKeys(
+    const vector<const CodeModule*>* modules) {
   assert(modules);
-  assert(module);
-  vector<const CodeModule*>::const_iterator iter;
-  for (iter = modules->begin(); iter != modules->end(); ++iter) {
-    if (module->debug_file().compare((*iter)->debug_file()) == 0 &&
-        module->debug_identifier().compare((*iter)->debug_identifier()) == 0) {
-      return true;
-    }
-  }
-  return false;
+  std::unordered_set<string> keys;
+  for (const CodeModule* module : *modules)
+    keys.insert(ModuleKey(module));
+  return keys;
 }
 
-// PrintModule prints a single |module| to stdout.
-// |modules_without_symbols| should contain the list of modules that were
-// confirmed to be missing their symbols during the stack walk.
-static void PrintModule(
+// PrintModule prints a single |module| to output.
+// |modules_without_symbols| should contain the keys of the modules that
+// were confirmed to be missing their symbols during the stack walk.
+static void PrintModule(FILE* output, 
     const CodeModule* module,
-    const vector<const CodeModule*>* modules_without_symbols,
-    const vector<const CodeModule*>* modules_with_corrupt_symbols,
+    const std::unordered_set<string>& modules_without_symbols,
+    const std::unordered_set<string>& modules_with_corrupt_symbols,
     uint64_t main_address) {
+  assert(module);
   string symbol_issues;
-  if (ContainsModule(modules_without_symbols, module)) {
+  string key = ModuleKey(module);
+  if (modules_without_symbols.count(key)) {
     symbol_issues = "  (WARNING: No symbols, " +
         PathnameStripper::File(module->debug_file()) + ", " +
         module->debug_identifier() + ")";
-  } else if (ContainsModule(modules_with_corrupt_symbols, module)) {
+  } else if (modules_with_corrupt_symbols.count(key)) {
     symbol_issues = "  (WARNING: Corrupt symbols, " +
         PathnameStripper::File(module->debug_file()) + ", " +
         module->debug_identifier() + ")";
   }
   uint64_t base_address = module->base_address();
-  printf("0x%08" PRIx64 " - 0x%08" PRIx64 "  %s  %s%s%s\n",
+  fprintf(output, "0x%08" PRIx64 " - 0x%08" PRIx64 "  %s  %s%s%s\n",
          base_address, base_address + module->size() - 1,
          PathnameStripper::File(module->code_file()).c_str(),
          module->version().empty() ? "???" : module->version().c_str(),
@@ -1051,18 +1176,18 @@ static void PrintModule(
          symbol_issues.c_str());
 }
 
-// PrintModules prints the list of all loaded |modules| to stdout.
+// PrintModules prints the list of all loaded |modules| to output.
 // |modules_without_symbols| should contain the list of modules that were
 // confirmed to be missing their symbols during the stack walk.
-static void PrintModules(
+static void PrintModules(FILE* output, 
     const CodeModules* modules,
     const vector<const CodeModule*>* modules_without_symbols,
     const vector<const CodeModule*>* modules_with_corrupt_symbols) {
   if (!modules)
     return;
 
-  printf("\n");
-  printf("Loaded modules:\n");
+  fprintf(output, "\n");
+  fprintf(output, "Loaded modules:\n");
 
   uint64_t main_address = 0;
   const CodeModule* main_module = modules->GetMainModule();
@@ -1070,13 +1195,17 @@ static void PrintModules(
     main_address = main_module->base_address();
   }
 
+  std::unordered_set<string> without_symbols_keys =
+      ModuleKeys(modules_without_symbols);
+  std::unordered_set<string> with_corrupt_symbols_keys =
+      ModuleKeys(modules_with_corrupt_symbols);
   unsigned int module_count = modules->module_count();
   for (unsigned int module_sequence = 0;
        module_sequence < module_count;
        ++module_sequence) {
     const CodeModule* module = modules->GetModuleAtSequence(module_sequence);
-    PrintModule(module, modules_without_symbols, modules_with_corrupt_symbols,
-                main_address);
+    PrintModule(output, module, without_symbols_keys,
+                with_corrupt_symbols_keys, main_address);
   }
 }
 
@@ -1085,7 +1214,8 @@ static void PrintModules(
 // text format:
 // Module|{Module Filename}|{Version}|{Debug Filename}|{Debug Identifier}|
 // {Base Address}|{Max Address}|{Main}
-static void PrintModulesMachineReadable(const CodeModules* modules) {
+static void PrintModulesMachineReadable(FILE* output,
+                                        const CodeModules* modules) {
   if (!modules)
     return;
 
@@ -1101,14 +1231,15 @@ static void PrintModulesMachineReadable(const CodeModules* modules) {
        ++module_sequence) {
     const CodeModule* module = modules->GetModuleAtSequence(module_sequence);
     uint64_t base_address = module->base_address();
-    printf("Module%c%s%c%s%c%s%c%s%c0x%08" PRIx64 "%c0x%08" PRIx64 "%c%d\n",
-           kOutputSeparator,
-           StripSeparator(PathnameStripper::File(module->code_file())).c_str(),
-           kOutputSeparator, StripSeparator(module->version()).c_str(),
-           kOutputSeparator,
-           StripSeparator(PathnameStripper::File(module->debug_file())).c_str(),
-           kOutputSeparator,
-           StripSeparator(module->debug_identifier()).c_str(),
+    fprintf(output, "Module%c", kOutputSeparator);
+    PrintStripped(output, PathnameStripper::FileView(module->code_file()));
+    fprintf(output, "%c", kOutputSeparator);
+    PrintStripped(output, module->version());
+    fprintf(output, "%c", kOutputSeparator);
+    PrintStripped(output, PathnameStripper::FileView(module->debug_file()));
+    fprintf(output, "%c", kOutputSeparator);
+    PrintStripped(output, module->debug_identifier());
+    fprintf(output, "%c0x%08" PRIx64 "%c0x%08" PRIx64 "%c%d\n",
            kOutputSeparator, base_address,
            kOutputSeparator, base_address + module->size() - 1,
            kOutputSeparator,
@@ -1116,53 +1247,128 @@ static void PrintModulesMachineReadable(const CodeModules* modules) {
   }
 }
 
+// PrintJSONString prints value to output as a quoted JSON string.  Runs of
+// characters that need no escaping are written as they are.
+static void PrintJSONString(FILE* output, const string& value) {
+  fputc('"', output);
+  const char* run = value.data();
+  const char* end = run + value.size();
+  for (const char* c = run; c != end; ++c) {
+    unsigned char character = *c;
+    if (character >= 0x20 && character != '"' && character != '\\')
+      continue;
+    fwrite(run, 1, c - run, output);
+    run = c + 1;
+    switch (character) {
+      case '"':
+        fputs("\\\"", output);
+        break;
+      case '\\':
+        fputs("\\\\", output);
+        break;
+      case '\n':
+        fputs("\\n", output);
+        break;
+      case '\t':
+        fputs("\\t", output);
+        break;
+      default:
+        fprintf(output, "\\u%04x", character);
+        break;
+    }
+  }
+  fwrite(run, 1, end - run, output);
+  fputc('"', output);
+}
+
+// FrameTrustName returns a short name for how a frame was found.
+static const char* FrameTrustName(StackFrame::FrameTrust trust) {
+  switch (trust) {
+    case StackFrame::FRAME_TRUST_CONTEXT:
+      return "context";
+    case StackFrame::FRAME_TRUST_PREWALKED:
+      return "prewalked";
+    case StackFrame::FRAME_TRUST_CFI:
+      return "cfi";
+    case StackFrame::FRAME_TRUST_CFI_SCAN:
+      return "cfi_scan";
+    case StackFrame::FRAME_TRUST_FP:
+      return "frame_pointer";
+    case StackFrame::FRAME_TRUST_SCAN:
+      return "scan";
+    case StackFrame::FRAME_TRUST_INLINE:
+      return "inline";
+    case StackFrame::FRAME_TRUST_LEAF:
+      return "leaf";
+    default:
+      return "none";
+  }
+}
+
+// PrintJSONModuleList prints modules, if any, to output as a JSON array
+// named name, giving each module's code file.
+static void PrintJSONModuleList(FILE* output, const char* name,
+                                const vector<const CodeModule*>* modules) {
+  fprintf(output, ",\n\"%s\":[", name);
+  for (size_t index = 0; index < modules->size(); ++index) {
+    if (index > 0)
+      fputc(',', output);
+    PrintJSONString(output, modules->at(index)->code_file());
+  }
+  fputc(']', output);
+}
+
 }  // namespace
 
-void PrintProcessState(const ProcessState& process_state,
+void PrintProcessState(FILE* output,
+                       const ProcessState& process_state,
                        bool output_stack_contents,
                        bool output_requesting_thread_only,
                        SourceLineResolverInterface* resolver) {
   // Print OS and CPU information.
   string cpu = process_state.system_info()->cpu;
   string cpu_info = process_state.system_info()->cpu_info;
-  printf("Operating system: %s\n", process_state.system_info()->os.c_str());
-  printf("                  %s\n",
+  fprintf(output, "Operating system: %s\n",
+          process_state.system_info()->os.c_str());
+  fprintf(output, "                  %s\n",
          process_state.system_info()->os_version.c_str());
-  printf("CPU: %s\n", cpu.c_str());
+  fprintf(output, "CPU: %s\n", cpu.c_str());
   if (!cpu_info.empty()) {
     // This field is optional.
-    printf("     %s\n", cpu_info.c_str());
+    fprintf(output, "     %s\n", cpu_info.c_str());
   }
-  printf("     %d CPU%s\n",
+  fprintf(output, "     %d CPU%s\n",
          process_state.system_info()->cpu_count,
          process_state.system_info()->cpu_count != 1 ? "s" : "");
-  printf("\n");
+  fprintf(output, "\n");
 
   // Print GPU information
   string gl_version = process_state.system_info()->gl_version;
   string gl_vendor = process_state.system_info()->gl_vendor;
   string gl_renderer = process_state.system_info()->gl_renderer;
-  printf("GPU:");
+  fprintf(output, "GPU:");
   if (!gl_version.empty() || !gl_vendor.empty() || !gl_renderer.empty()) {
-    printf(" %s\n", gl_version.c_str());
-    printf("     %s\n", gl_vendor.c_str());
-    printf("     %s\n", gl_renderer.c_str());
+    fprintf(output, " %s\n", gl_version.c_str());
+    fprintf(output, "     %s\n", gl_vendor.c_str());
+    fprintf(output, "     %s\n", gl_renderer.c_str());
   } else {
-    printf(" UNKNOWN\n");
+    fprintf(output, " UNKNOWN\n");
   }
-  printf("\n");
+  fprintf(output, "\n");
 
   // Print crash information.
   if (process_state.crashed()) {
-    printf("Crash reason:  %s\n", process_state.crash_reason().c_str());
-    printf("Crash address: 0x%" PRIx64 "\n", process_state.crash_address());
+    fprintf(output, "Crash reason:  %s\n",
+            process_state.crash_reason().c_str());
+    fprintf(output, "Crash address: 0x%" PRIx64 "\n",
+            process_state.crash_address());
   } else {
-    printf("No crash\n");
+    fprintf(output, "No crash\n");
   }
 
   string assertion = process_state.assertion();
   if (!assertion.empty()) {
-    printf("Assertion: %s\n", assertion.c_str());
+    fprintf(output, "Assertion: %s\n", assertion.c_str());
   }
 
   // Compute process uptime if the process creation and crash times are
@@ -1170,22 +1376,28 @@ void PrintProcessState(const ProcessState& process_state,
   if (process_state.time_date_stamp() != 0 &&
       process_state.process_create_time() != 0 &&
       process_state.time_date_stamp() >= process_state.process_create_time()) {
-    printf("Process uptime: %d seconds\n",
+    fprintf(output, "Process uptime: %d seconds\n",
            process_state.time_date_stamp() -
                process_state.process_create_time());
   } else {
-    printf("Process uptime: not available\n");
+    fprintf(output, "Process uptime: not available\n");
+  }
+
+  if (!process_state.stack_signature().empty()) {
+    fprintf(output, "Stack signature: %s (%016" PRIx64 ")\n",
+            process_state.stack_signature().c_str(),
+            process_state.stack_signature_hash());
   }
 
   // If the thread that requested the dump is known, print it first.
   int requesting_thread = process_state.requesting_thread();
   if (requesting_thread != -1) {
-    printf("\n");
-    printf("Thread %d (%s)\n",
+    fprintf(output, "\n");
+    fprintf(output, "Thread %d (%s)\n",
           requesting_thread,
           process_state.crashed() ? "crashed" :
                                     "requested dump, did not crash");
-    PrintStack(process_state.threads()->at(requesting_thread), cpu,
+    PrintStack(output, process_state.threads()->at(requesting_thread), cpu,
                output_stack_contents,
                process_state.thread_memory_regions()->at(requesting_thread),
                process_state.modules(), resolver);
@@ -1197,9 +1409,9 @@ void PrintProcessState(const ProcessState& process_state,
     for (int thread_index = 0; thread_index < thread_count; ++thread_index) {
       if (thread_index != requesting_thread) {
         // Don't print the crash thread again, it was already printed.
-        printf("\n");
-        printf("Thread %d\n", thread_index);
-        PrintStack(process_state.threads()->at(thread_index), cpu,
+        fprintf(output, "\n");
+        fprintf(output, "Thread %d\n", thread_index);
+        PrintStack(output, process_state.threads()->at(thread_index), cpu,
                   output_stack_contents,
                   process_state.thread_memory_regions()->at(thread_index),
                   process_state.modules(), resolver);
@@ -1207,28 +1419,29 @@ void PrintProcessState(const ProcessState& process_state,
     }
   }
 
-  PrintModules(process_state.modules(),
+  PrintModules(output, process_state.modules(),
                process_state.modules_without_symbols(),
                process_state.modules_with_corrupt_symbols());
 }
 
-void PrintProcessStateMachineReadable(const ProcessState& process_state) {
+void PrintProcessStateMachineReadable(FILE* output,
+                                      const ProcessState& process_state) {
   // Print OS and CPU information.
   // OS|{OS Name}|{OS Version}
   // CPU|{CPU Name}|{CPU Info}|{Number of CPUs}
   // GPU|{GPU version}|{GPU vendor}|{GPU renderer}
-  printf("OS%c%s%c%s\n", kOutputSeparator,
+  fprintf(output, "OS%c%s%c%s\n", kOutputSeparator,
          StripSeparator(process_state.system_info()->os).c_str(),
          kOutputSeparator,
          StripSeparator(process_state.system_info()->os_version).c_str());
-  printf("CPU%c%s%c%s%c%d\n", kOutputSeparator,
+  fprintf(output, "CPU%c%s%c%s%c%d\n", kOutputSeparator,
          StripSeparator(process_state.system_info()->cpu).c_str(),
          kOutputSeparator,
          // this may be empty
          StripSeparator(process_state.system_info()->cpu_info).c_str(),
          kOutputSeparator,
          process_state.system_info()->cpu_count);
-  printf("GPU%c%s%c%s%c%s\n", kOutputSeparator,
+  fprintf(output, "GPU%c%s%c%s%c%s\n", kOutputSeparator,
          StripSeparator(process_state.system_info()->gl_version).c_str(),
          kOutputSeparator,
          StripSeparator(process_state.system_info()->gl_vendor).c_str(),
@@ -1239,9 +1452,9 @@ void PrintProcessStateMachineReadable(const ProcessState& process_state) {
 
   // Print crash information.
   // Crash|{Crash Reason}|{Crash Address}|{Crashed Thread}
-  printf("Crash%c", kOutputSeparator);
+  fprintf(output, "Crash%c", kOutputSeparator);
   if (process_state.crashed()) {
-    printf("%s%c0x%" PRIx64 "%c",
+    fprintf(output, "%s%c0x%" PRIx64 "%c",
            StripSeparator(process_state.crash_reason()).c_str(),
            kOutputSeparator, process_state.crash_address(), kOutputSeparator);
   } else {
@@ -1249,27 +1462,27 @@ void PrintProcessStateMachineReadable(const ProcessState& process_state) {
     // instead of the unhelpful "No crash"
     string assertion = process_state.assertion();
     if (!assertion.empty()) {
-      printf("%s%c%c", StripSeparator(assertion).c_str(),
+      fprintf(output, "%s%c%c", StripSeparator(assertion).c_str(),
              kOutputSeparator, kOutputSeparator);
     } else {
-      printf("No crash%c%c", kOutputSeparator, kOutputSeparator);
+      fprintf(output, "No crash%c%c", kOutputSeparator, kOutputSeparator);
     }
   }
 
   if (requesting_thread != -1) {
-    printf("%d\n", requesting_thread);
+    fprintf(output, "%d\n", requesting_thread);
   } else {
-    printf("\n");
+    fprintf(output, "\n");
   }
 
-  PrintModulesMachineReadable(process_state.modules());
+  PrintModulesMachineReadable(output, process_state.modules());
 
   // blank line to indicate start of threads
-  printf("\n");
+  fprintf(output, "\n");
 
   // If the thread that requested the dump is known, print it first.
   if (requesting_thread != -1) {
-    PrintStackMachineReadable(requesting_thread,
+    PrintStackMachineReadable(output, requesting_thread,
                               process_state.threads()->at(requesting_thread));
   }
 
@@ -1278,27 +1491,260 @@ void PrintProcessStateMachineReadable(const ProcessState& process_state) {
   for (int thread_index = 0; thread_index < thread_count; ++thread_index) {
     if (thread_index != requesting_thread) {
       // Don't print the crash thread again, it was already printed.
-      PrintStackMachineReadable(thread_index,
+      PrintStackMachineReadable(output, thread_index,
                                 process_state.threads()->at(thread_index));
     }
   }
 }
 
-void PrintRequestingThreadBrief(const ProcessState& process_state) {
+void PrintProcessStateJSON(FILE* output, const ProcessState& process_state) {
+  JSONProcessStatePrinter printer(output);
+  printer.OnProcessInfo(process_state);
+  int thread_count = process_state.threads()->size();
+  for (int thread_index = 0; thread_index < thread_count; ++thread_index)
+    printer.OnThread(thread_index, *process_state.threads()->at(thread_index));
+  printer.Finish(process_state, true);
+}
+
+// The JSON object has the following members, in order.  Addresses and
+// offsets are strings of hexadecimal digits, since they may not fit in a
+// JSON number.
+//
+//   system: {os, os_version, cpu, cpu_info, cpu_count}
+//   crash: {reason, address}, if the process crashed
+//   assertion: the assertion, if there was one
+//   modules: [{code_file, code_identifier, debug_file, debug_identifier,
+//              version, base, end, main}]
+//   threads: [{thread, tid, frames: [{frame, trust, instruction,
+//                                     module, module_offset,
+//                                     function, function_offset,
+//                                     file, line}],
+//              truncated, terminal}]
+//   requesting_thread: index in threads, or -1
+//   modules_without_symbols, modules_with_corrupt_symbols: [code_file]
+//   stack_signature: {signature, hash}, if one was generated
+//   processed: false if processing failed, leaving the object incomplete
+//
+// Frame members other than frame, trust and instruction are present only
+// if known.  A frame's module is its index in modules.  A thread's
+// truncated is present, and true, only if its stack walk stopped at its
+// time limit, and terminal only if it stopped after a terminal function.
+void JSONProcessStatePrinter::OnProcessInfo(
+    const ProcessState& process_state) {
+  const SystemInfo* system_info = process_state.system_info();
+  fputs("{\"system\":{\"os\":", output_);
+  PrintJSONString(output_, system_info->os);
+  fputs(",\"os_version\":", output_);
+  PrintJSONString(output_, system_info->os_version);
+  fputs(",\"cpu\":", output_);
+  PrintJSONString(output_, system_info->cpu);
+  fputs(",\"cpu_info\":", output_);
+  PrintJSONString(output_, system_info->cpu_info);
+  fprintf(output_, ",\"cpu_count\":%d}", system_info->cpu_count);
+
+  if (process_state.crashed()) {
+    fputs(",\n\"crash\":{\"reason\":", output_);
+    PrintJSONString(output_, process_state.crash_reason());
+    fprintf(output_, ",\"address\":\"0x%" PRIx64 "\"}",
+            process_state.crash_address());
+  }
+  if (!process_state.assertion().empty()) {
+    fputs(",\n\"assertion\":", output_);
+    PrintJSONString(output_, process_state.assertion());
+  }
+
+  fputs(",\n\"modules\":[", output_);
+  const CodeModules* modules = process_state.modules();
+  if (modules) {
+    const CodeModule* main_module = modules->GetMainModule();
+    unsigned int module_count = modules->module_count();
+    for (unsigned int module_sequence = 0;
+         module_sequence < module_count;
+         ++module_sequence) {
+      const CodeModule* module = modules->GetModuleAtSequence(module_sequence);
+      module_indices_[module] = module_sequence;
+      fputs(module_sequence > 0 ? ",\n{\"code_file\":" : "\n{\"code_file\":",
+            output_);
+      PrintJSONString(output_, module->code_file());
+      fputs(",\"code_identifier\":", output_);
+      PrintJSONString(output_, module->code_identifier());
+      fputs(",\"debug_file\":", output_);
+      PrintJSONString(output_, module->debug_file());
+      fputs(",\"debug_identifier\":", output_);
+      PrintJSONString(output_, module->debug_identifier());
+      fputs(",\"version\":", output_);
+      PrintJSONString(output_, module->version());
+      uint64_t base_address = module->base_address();
+      fprintf(output_,
+              ",\"base\":\"0x%" PRIx64 "\",\"end\":\"0x%" PRIx64 "\","
+              "\"main\":%s}",
+              base_address, base_address + module->size() - 1,
+              main_module && base_address == main_module->base_address() ?
+                  "true" : "false");
+    }
+  }
+  fputs("],\n\"threads\":[", output_);
+  started_ = true;
+  fflush(output_);
+}
+
+void JSONProcessStatePrinter::OnThread(int thread_index,
+                                       const CallStack& stack) {
+  fprintf(output_, "%s\n{\"thread\":%d,\"tid\":%u,\"frames\":[",
+          printed_thread_ ? "," : "", thread_index, stack.tid());
+  printed_thread_ = true;
+  int frame_count = stack.frames()->size();
+  for (int frame_index = 0; frame_index < frame_count; ++frame_index) {
+    const StackFrame* frame = stack.frames()->at(frame_index);
+    uint64_t instruction_address = frame->ReturnAddress();
+    fprintf(output_,
+            "%s\n{\"frame\":%d,\"trust\":\"%s\",\"instruction\":\"0x%" PRIx64
+            "\"",
+            frame_index > 0 ? "," : "", frame_index,
+            FrameTrustName(frame->trust),
+            instruction_address);
+    if (frame->module) {
+      std::map<const CodeModule*, int>::const_iterator module_index =
+          module_indices_.find(frame->module);
+      if (module_index != module_indices_.end())
+        fprintf(output_, ",\"module\":%d", module_index->second);
+      fprintf(output_, ",\"module_offset\":\"0x%" PRIx64 "\"",
+              instruction_address - frame->module->base_address());
+    }
+    if (!frame->function_name.empty()) {
+      fputs(",\"function\":", output_);
+      PrintJSONString(output_, frame->function_name);
+      fprintf(output_, ",\"function_offset\":\"0x%" PRIx64 "\"",
+              instruction_address - frame->function_base);
+    }
+    if (!frame->source_file_name.empty()) {
+      fputs(",\"file\":", output_);
+      PrintJSONString(output_, frame->source_file_name);
+      fprintf(output_, ",\"line\":%d", frame->source_line);
+    }
+    fputc('}', output_);
+  }
+  fputc(']', output_);
+  if (stack.truncated())
+    fputs(",\"truncated\":true", output_);
+  if (stack.ended_at_terminal_frame())
+    fputs(",\"terminal\":true", output_);
+  fputc('}', output_);
+  fflush(output_);
+}
+
+void JSONProcessStatePrinter::Finish(const ProcessState& process_state,
+                                     bool processed) {
+  if (!started_)
+    fputs("{\"threads\":[", output_);
+  fprintf(output_, "],\n\"requesting_thread\":%d",
+          processed ? process_state.requesting_thread() : -1);
+  PrintJSONModuleList(output_, "modules_without_symbols",
+                      process_state.modules_without_symbols());
+  PrintJSONModuleList(output_, "modules_with_corrupt_symbols",
+                      process_state.modules_with_corrupt_symbols());
+  if (!process_state.stack_signature().empty()) {
+    fputs(",\n\"stack_signature\":{\"signature\":", output_);
+    PrintJSONString(output_, process_state.stack_signature());
+    fprintf(output_, ",\"hash\":\"0x%016" PRIx64 "\"}",
+            process_state.stack_signature_hash());
+  }
+  fprintf(output_, ",\n\"processed\":%s}\n", processed ? "true" : "false");
+  fflush(output_);
+}
+
+void PrintProcessingStats(FILE* output, const ProcessState& process_state) {
+  static const char* const kPhaseNames[ProcessingStats::PHASE_COUNT] = {
+    "read", "system info", "symbol prefetch", "walk", "exploitability"
+  };
+  const ProcessingStats* stats = process_state.stats();
+  fprintf(output, "Phase               Wall (s)    CPU (s)\n");
+  for (int phase = 0; phase < ProcessingStats::PHASE_COUNT; ++phase) {
+    ProcessingStats::Phase processing_phase =
+        static_cast<ProcessingStats::Phase>(phase);
+    fprintf(output, "%-16s %11.6f %10.6f\n", kPhaseNames[phase],
+            stats->wall_seconds(processing_phase),
+            stats->cpu_seconds(processing_phase));
+  }
+
+  fprintf(output, "\nFrames by trust:");
+  for (int trust = 0; trust < ProcessingStats::kFrameTrustCount; ++trust) {
+    StackFrame::FrameTrust frame_trust =
+        static_cast<StackFrame::FrameTrust>(trust);
+    uint64_t count = stats->frame_count(frame_trust);
+    if (count > 0) {
+      fprintf(output, " %s %" PRIu64, FrameTrustName(frame_trust), count);
+    }
+  }
+  fprintf(output, "\nSymbol lookups: %" PRIu64 ", %" PRIu64 " memoized\n",
+          stats->symbol_lookups(), stats->memoized_symbol_lookups());
+
+  vector<ProcessingStats::ModuleLoad> module_loads = stats->module_loads();
+  if (!module_loads.empty()) {
+    fprintf(output, "\nModule symbols     Fetch (s)  Parse (s)\n");
+    for (const ProcessingStats::ModuleLoad& module_load : module_loads) {
+      fprintf(output, "%-16s %11.6f %10.6f  %s%s\n",
+              PathnameStripper::File(module_load.code_file).c_str(),
+              module_load.fetch_seconds, module_load.parse_seconds,
+              module_load.debug_identifier.c_str(),
+              module_load.loaded ? "" : " (no symbols)");
+    }
+  }
+
+  const vector<MDRawDumpPhaseTiming>* dump_phases =
+      process_state.dump_phases();
+  if (!dump_phases->empty()) {
+    fprintf(output,
+            "\nDump phase            Start (s)   Time (s)    Count      Bytes\n");
+    for (const MDRawDumpPhaseTiming& phase : *dump_phases) {
+      fprintf(output, "%-19s %11.6f %10.6f %8u %10" PRIu64 "\n",
+              MinidumpDumpTiming::PhaseName(phase.phase),
+              phase.start_time / 1e9, phase.duration / 1e9, phase.count,
+              phase.bytes);
+    }
+  }
+}
+
+void PrintRequestingThreadBrief(FILE* output,
+                                const ProcessState& process_state) {
   int requesting_thread = process_state.requesting_thread();
   if (requesting_thread == -1) {
-    printf(" <no crashing or requesting dump thread identified>\n");
+    fprintf(output, " <no crashing or requesting dump thread identified>\n");
     return;
   }
 
-  printf("Thread %d (%s)\n", requesting_thread,
+  fprintf(output, "Thread %d (%s)\n", requesting_thread,
          process_state.crashed() ? "crashed" : "requested dump, did not crash");
   const CallStack* stack = process_state.threads()->at(requesting_thread);
   int frame_count = stack->frames()->size();
   for (int frame_index = 0; frame_index < frame_count; ++frame_index) {
-    PrintFrameHeader(stack->frames()->at(frame_index), frame_index);
-    printf("\n");
+    PrintFrameHeader(output, stack->frames()->at(frame_index), frame_index);
+    fprintf(output, "\n");
+  }
+}
+
+const char* ProcessResultName(ProcessResult result) {
+  switch (result) {
+    case PROCESS_OK:
+      return "PROCESS_OK";
+    case PROCESS_ERROR_MINIDUMP_NOT_FOUND:
+      return "PROCESS_ERROR_MINIDUMP_NOT_FOUND";
+    case PROCESS_ERROR_NO_MINIDUMP_HEADER:
+      return "PROCESS_ERROR_NO_MINIDUMP_HEADER";
+    case PROCESS_ERROR_NO_THREAD_LIST:
+      return "PROCESS_ERROR_NO_THREAD_LIST";
+    case PROCESS_ERROR_GETTING_THREAD:
+      return "PROCESS_ERROR_GETTING_THREAD";
+    case PROCESS_ERROR_GETTING_THREAD_ID:
+      return "PROCESS_ERROR_GETTING_THREAD_ID";
+    case PROCESS_ERROR_DUPLICATE_REQUESTING_THREADS:
+      return "PROCESS_ERROR_DUPLICATE_REQUESTING_THREADS";
+    case PROCESS_SYMBOL_SUPPLIER_INTERRUPTED:
+      return "PROCESS_SYMBOL_SUPPLIER_INTERRUPTED";
+    case PROCESS_ERROR_GETTING_THREAD_NAME:
+      return "PROCESS_ERROR_GETTING_THREAD_NAME";
   }
+  return "unknown";
 }
 
 }  // namespace google_breakpad
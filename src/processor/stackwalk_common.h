@@ -33,17 +33,67 @@
 #ifndef PROCESSOR_STACKWALK_COMMON_H__
 #define PROCESSOR_STACKWALK_COMMON_H__
 
+#include <stdio.h>
+
+#include <map>
+
+#include "google_breakpad/processor/process_result.h"
+#include "google_breakpad/processor/process_state_observer.h"
+
 namespace google_breakpad {
 
+class CodeModule;
 class ProcessState;
 class SourceLineResolverInterface;
 
-void PrintProcessStateMachineReadable(const ProcessState& process_state);
-void PrintProcessState(const ProcessState& process_state,
+// Each of these prints process_state to output.
+void PrintProcessStateMachineReadable(FILE* output,
+                                      const ProcessState& process_state);
+void PrintProcessState(FILE* output,
+                       const ProcessState& process_state,
                        bool output_stack_contents,
                        bool output_requesting_thread_only,
                        SourceLineResolverInterface* resolver);
-void PrintRequestingThreadBrief(const ProcessState& process_state);
+void PrintRequestingThreadBrief(FILE* output,
+                                const ProcessState& process_state);
+void PrintProcessStateJSON(FILE* output, const ProcessState& process_state);
+void PrintProcessingStats(FILE* output, const ProcessState& process_state);
+
+// Returns the name of result, for reporting.
+const char* ProcessResultName(ProcessResult result);
+
+// Prints a ProcessState to output as a JSON object, a part at a time as
+// MinidumpProcessor fills it in.  Set it as the processor's observer, and
+// call Finish once Process returns.  Each thread is printed, and output
+// flushed, as soon as its stack is complete, so threads may be out of
+// order; each names its index in ProcessState::threads.  Give output a
+// large buffer, since the object is printed in many small writes.
+class JSONProcessStatePrinter : public ProcessStateObserver {
+ public:
+  explicit JSONProcessStatePrinter(FILE* output)
+      : output_(output), started_(false), printed_thread_(false) {}
+
+  virtual void OnProcessInfo(const ProcessState& process_state);
+  virtual void OnThread(int thread_index, const CallStack& stack);
+
+  // Prints the rest of process_state and ends the object.  processed is
+  // false if Process failed, in which case the object holds whatever was
+  // printed before it did.
+  void Finish(const ProcessState& process_state, bool processed);
+
+ private:
+  FILE* output_;
+
+  // Whether the object and its threads array have been begun.
+  bool started_;
+
+  // Whether a thread has been printed, and so needs a separator before
+  // the next.
+  bool printed_thread_;
+
+  // The index of each module in the printed modules array.
+  std::map<const CodeModule*, int> module_indices_;
+};
 
 }  // namespace google_breakpad
 
@@ -40,14 +40,18 @@
 
 #include <assert.h>
 
+#include <algorithm>
+
 #include "common/scoped_ptr.h"
 #include "google_breakpad/processor/call_stack.h"
 #include "google_breakpad/processor/code_module.h"
 #include "google_breakpad/processor/code_modules.h"
 #include "google_breakpad/processor/dump_context.h"
 #include "google_breakpad/processor/stack_frame.h"
+#include "google_breakpad/processor/stack_frame_cpu.h"
 #include "google_breakpad/processor/stack_frame_symbolizer.h"
 #include "google_breakpad/processor/system_info.h"
+#include "google_breakpad/processor/terminal_frames.h"
 #include "processor/linked_ptr.h"
 #include "processor/logging.h"
 #include "processor/stackwalker_ppc.h"
@@ -75,6 +79,8 @@ bool Stackwalker::max_frames_set_ = false;
 
 uint32_t Stackwalker::max_frames_scanned_ = 1 << 14;  // 16k
 
+bool Stackwalker::trust_frame_pointers_ = false;
+
 Stackwalker::Stackwalker(const SystemInfo* system_info,
                          MemoryRegion* memory,
                          const CodeModules* modules,
@@ -83,28 +89,28 @@ Stackwalker::Stackwalker(const SystemInfo* system_info,
       memory_(memory),
       modules_(modules),
       unloaded_modules_(NULL),
-      frame_symbolizer_(frame_symbolizer) {
+      frame_symbolizer_(frame_symbolizer),
+      symbolize_after_walk_(false),
+      windows_unwind_tables_(NULL),
+      eh_frame_unwind_tables_(NULL),
+      deadline_(std::chrono::steady_clock::time_point::max()),
+      symbolized_frame_limit_(SIZE_MAX),
+      terminal_frames_(NULL),
+      module_ranges_built_(false) {
   assert(frame_symbolizer_);
 }
 
 void InsertSpecialAttentionModule(
     StackFrameSymbolizer::SymbolizerResult symbolizer_result,
     const CodeModule* module,
-    vector<const CodeModule*>* modules) {
+    vector<const CodeModule*>* modules,
+    std::unordered_set<const CodeModule*>* module_set) {
   if (!module) {
     return;
   }
   assert(symbolizer_result == StackFrameSymbolizer::kError ||
          symbolizer_result == StackFrameSymbolizer::kWarningCorruptSymbols);
-  bool found = false;
-  vector<const CodeModule*>::iterator iter;
-  for (iter = modules->begin(); iter != modules->end(); ++iter) {
-    if (*iter == module) {
-      found = true;
-      break;
-    }
-  }
-  if (!found) {
+  if (module_set->insert(module).second) {
     BPLOG(INFO) << ((symbolizer_result == StackFrameSymbolizer::kError) ?
                        "Couldn't load symbols for: " :
                        "Detected corrupt symbols for: ")
@@ -127,6 +133,17 @@ bool Stackwalker::Walk(
                                             << "|modules_with_corrupt_symbols|";
   assert(modules_without_symbols);
   assert(modules_with_corrupt_symbols);
+  modules_without_symbols_set_.clear();
+  modules_without_symbols_set_.insert(modules_without_symbols->begin(),
+                                      modules_without_symbols->end());
+  modules_with_corrupt_symbols_set_.clear();
+  modules_with_corrupt_symbols_set_.insert(
+      modules_with_corrupt_symbols->begin(),
+      modules_with_corrupt_symbols->end());
+
+  // The frames created during the walk end up in stack, so allocate them
+  // from its frame arena if it has one.
+  CallStack::FrameAllocationScope frame_allocation_scope(stack);
 
   // Begin with the context frame, and keep getting callers until there are
   // no more.
@@ -134,6 +151,7 @@ bool Stackwalker::Walk(
   // Keep track of the number of scanned or otherwise dubious frames seen
   // so far, as the caller may have set a limit.
   uint32_t scanned_frames = 0;
+  size_t walked_frames = 0;
 
   // Take ownership of the pointer returned by GetContextFrame.
   scoped_ptr<StackFrame> frame(GetContextFrame());
@@ -143,30 +161,14 @@ bool Stackwalker::Walk(
     // frame_pointer fields.  The frame structure comes from either the
     // context frame (above) or a caller frame (below).
 
+    // Resolve the module information, if a module map was provided, unless
+    // that waits until the whole stack is walked.
     std::deque<std::unique_ptr<StackFrame>> inlined_frames;
-    // Resolve the module information, if a module map was provided.
-    StackFrameSymbolizer::SymbolizerResult symbolizer_result =
-        frame_symbolizer_->FillSourceLineInfo(modules_, unloaded_modules_,
-                                              system_info_,
-                                              frame.get(), &inlined_frames);
-    switch (symbolizer_result) {
-      case StackFrameSymbolizer::kInterrupt:
-        BPLOG(INFO) << "Stack walk is interrupted.";
-        return false;
-        break;
-      case StackFrameSymbolizer::kError:
-        InsertSpecialAttentionModule(symbolizer_result, frame->module,
-                                     modules_without_symbols);
-        break;
-      case StackFrameSymbolizer::kWarningCorruptSymbols:
-        InsertSpecialAttentionModule(symbolizer_result, frame->module,
-                                     modules_with_corrupt_symbols);
-        break;
-      case StackFrameSymbolizer::kNoError:
-        break;
-      default:
-        assert(false);
-        break;
+    if (!symbolize_after_walk_ &&
+        !SymbolizeWalkedFrame(frame.get(), walked_frames++, &inlined_frames,
+                              modules_without_symbols,
+                              modules_with_corrupt_symbols)) {
+      return false;
     }
 
     // Keep track of the number of dubious frames so far.
@@ -195,12 +197,167 @@ bool Stackwalker::Walk(
         BPLOG(ERROR) << "The stack is over " << max_frames_ << " frames.";
       break;
     }
+    // Frames walked before they are symbolized are checked as they are
+    // symbolized instead.
+    if (!symbolize_after_walk_ && IsTerminalFrame(*stack->frames_.back())) {
+      stack->set_ended_at_terminal_frame(true);
+      break;
+    }
+    if (deadline_ != std::chrono::steady_clock::time_point::max() &&
+        std::chrono::steady_clock::now() >= deadline_) {
+      BPLOG(INFO) << "Stack walk stopped at its deadline after "
+                  << stack->frames_.size() << " frames.";
+      stack->set_truncated(true);
+      break;
+    }
 
     // Get the next frame and take ownership.
     bool stack_scan_allowed = scanned_frames < max_frames_scanned_;
     frame.reset(GetCallerFrame(stack, stack_scan_allowed));
   }
 
+  if (symbolize_after_walk_) {
+    return SymbolizeFrames(stack, modules_without_symbols,
+                           modules_with_corrupt_symbols);
+  }
+
+  return true;
+}
+
+// Returns a new frame of the same type as frame, without registers.
+static StackFrame* NewFrameLike(const StackFrame* frame) {
+  if (dynamic_cast<const StackFrameX86*>(frame))
+    return new StackFrameX86;
+  if (dynamic_cast<const StackFrameAMD64*>(frame))
+    return new StackFrameAMD64;
+  if (dynamic_cast<const StackFrameARM*>(frame))
+    return new StackFrameARM;
+  if (dynamic_cast<const StackFrameARM64*>(frame))
+    return new StackFrameARM64;
+  if (dynamic_cast<const StackFramePPC*>(frame))
+    return new StackFramePPC;
+  if (dynamic_cast<const StackFramePPC64*>(frame))
+    return new StackFramePPC64;
+  if (dynamic_cast<const StackFrameSPARC*>(frame))
+    return new StackFrameSPARC;
+  if (dynamic_cast<const StackFrameMIPS*>(frame))
+    return new StackFrameMIPS;
+  if (dynamic_cast<const StackFrameRISCV*>(frame))
+    return new StackFrameRISCV;
+  if (dynamic_cast<const StackFrameRISCV64*>(frame))
+    return new StackFrameRISCV64;
+  return new StackFrame;
+}
+
+bool Stackwalker::Resymbolize(
+    const vector<StackFrame>& frames,
+    CallStack* stack,
+    vector<const CodeModule*>* modules_without_symbols,
+    vector<const CodeModule*>* modules_with_corrupt_symbols) {
+  assert(stack);
+  assert(modules_without_symbols);
+  assert(modules_with_corrupt_symbols);
+  stack->Clear();
+  if (frames.empty())
+    return true;
+
+  modules_without_symbols_set_.clear();
+  modules_without_symbols_set_.insert(modules_without_symbols->begin(),
+                                      modules_without_symbols->end());
+  modules_with_corrupt_symbols_set_.clear();
+  modules_with_corrupt_symbols_set_.insert(
+      modules_with_corrupt_symbols->begin(),
+      modules_with_corrupt_symbols->end());
+
+  CallStack::FrameAllocationScope frame_allocation_scope(stack);
+  StackFrame* context_frame = GetContextFrame();
+  if (!context_frame)
+    return true;
+  stack->frames_.reserve(frames.size());
+  stack->frames_.push_back(context_frame);
+  for (size_t i = 1; i < frames.size(); ++i) {
+    StackFrame* frame = NewFrameLike(context_frame);
+    frame->instruction = frames[i].instruction;
+    frame->trust = frames[i].trust;
+    stack->frames_.push_back(frame);
+  }
+  return SymbolizeFrames(stack, modules_without_symbols,
+                         modules_with_corrupt_symbols);
+}
+
+bool Stackwalker::SymbolizeFrames(
+    CallStack* stack,
+    vector<const CodeModule*>* modules_without_symbols,
+    vector<const CodeModule*>* modules_with_corrupt_symbols) {
+  vector<StackFrame*> walked;
+  walked.swap(stack->frames_);
+  stack->frames_.reserve(walked.size());
+  for (size_t i = 0; i < walked.size(); ++i) {
+    std::deque<std::unique_ptr<StackFrame>> inlined_frames;
+    if (!SymbolizeWalkedFrame(walked[i], i, &inlined_frames,
+                              modules_without_symbols,
+                              modules_with_corrupt_symbols)) {
+      // The stack still owns the frames it doesn't get.
+      stack->frames_.insert(stack->frames_.end(), walked.begin() + i,
+                            walked.end());
+      return false;
+    }
+    while (!inlined_frames.empty()) {
+      stack->frames_.push_back(inlined_frames.front().release());
+      inlined_frames.pop_front();
+    }
+    stack->frames_.push_back(walked[i]);
+    if (IsTerminalFrame(*walked[i])) {
+      stack->set_ended_at_terminal_frame(true);
+      for (size_t j = i + 1; j < walked.size(); ++j)
+        delete walked[j];
+      break;
+    }
+  }
+  return true;
+}
+
+bool Stackwalker::IsTerminalFrame(const StackFrame& frame) const {
+  return terminal_frames_ &&
+         terminal_frames_->IsTerminal(system_info_ ? system_info_->os_short :
+                                                     string(),
+                                      frame);
+}
+
+bool Stackwalker::SymbolizeWalkedFrame(
+    StackFrame* frame,
+    size_t frame_index,
+    std::deque<std::unique_ptr<StackFrame>>* inlined_frames,
+    vector<const CodeModule*>* modules_without_symbols,
+    vector<const CodeModule*>* modules_with_corrupt_symbols) {
+  StackFrameSymbolizer::SymbolizerResult symbolizer_result =
+      frame_index < symbolized_frame_limit_ ?
+          frame_symbolizer_->FillSourceLineInfo(modules_, unloaded_modules_,
+                                                system_info_, frame,
+                                                inlined_frames) :
+          frame_symbolizer_->FillModuleInfo(modules_, unloaded_modules_,
+                                            system_info_, frame);
+  switch (symbolizer_result) {
+    case StackFrameSymbolizer::kInterrupt:
+      BPLOG(INFO) << "Stack walk is interrupted.";
+      return false;
+      break;
+    case StackFrameSymbolizer::kError:
+      InsertSpecialAttentionModule(symbolizer_result, frame->module,
+                                   modules_without_symbols,
+                                   &modules_without_symbols_set_);
+      break;
+    case StackFrameSymbolizer::kWarningCorruptSymbols:
+      InsertSpecialAttentionModule(symbolizer_result, frame->module,
+                                   modules_with_corrupt_symbols,
+                                   &modules_with_corrupt_symbols_set_);
+      break;
+    case StackFrameSymbolizer::kNoError:
+      break;
+    default:
+      assert(false);
+      break;
+  }
   return true;
 }
 
@@ -329,6 +486,69 @@ bool Stackwalker::TerminateWalk(uint64_t caller_ip,
   return false;
 }
 
+bool Stackwalker::AddressInModuleRanges(uint64_t address) {
+  if (!module_ranges_built_) {
+    module_ranges_built_ = true;
+    if (modules_) {
+      vector<std::pair<uint64_t, uint64_t> > ranges;
+      unsigned int module_count = modules_->module_count();
+      ranges.reserve(module_count);
+      for (unsigned int i = 0; i < module_count; ++i) {
+        const CodeModule* module = modules_->GetModuleAtIndex(i);
+        if (!module || module->size() == 0)
+          continue;
+        uint64_t base = module->base_address();
+        uint64_t end = base + module->size();
+        if (end < base)
+          end = UINT64_MAX;
+        ranges.push_back(std::make_pair(base, end));
+      }
+      std::sort(ranges.begin(), ranges.end());
+      for (size_t i = 0; i < ranges.size(); ++i) {
+        if (!module_ranges_.empty() &&
+            ranges[i].first <= module_ranges_.back().second) {
+          module_ranges_.back().second =
+              std::max(module_ranges_.back().second, ranges[i].second);
+        } else {
+          module_ranges_.push_back(ranges[i]);
+        }
+      }
+    }
+  }
+
+  if (module_ranges_.empty() ||
+      address < module_ranges_.front().first ||
+      address >= module_ranges_.back().second) {
+    return false;
+  }
+
+  // Find the last range starting at or below address.
+  vector<std::pair<uint64_t, uint64_t> >::const_iterator range =
+      std::upper_bound(module_ranges_.begin(), module_ranges_.end(),
+                       std::make_pair(address, UINT64_MAX));
+  --range;
+  return address < range->second;
+}
+
+bool Stackwalker::TrustedFramePointerStep(uint64_t callee_fp,
+                                          uint64_t caller_fp,
+                                          uint64_t caller_pc) {
+  if (!callee_fp || (caller_fp && caller_fp <= callee_fp))
+    return false;
+  if (caller_fp && caller_fp - memory_->GetBase() >= memory_->GetSize())
+    return false;
+  // caller_pc is a return address, which may be just past the end of the
+  // module if the call was its last instruction.
+  return modules_ && AddressInModuleRanges(caller_pc - 1);
+}
+
+void Stackwalker::FillModuleInfo(StackFrame* frame) {
+  if (!frame->module) {
+    frame_symbolizer_->FillModuleInfo(modules_, unloaded_modules_,
+                                      system_info_, frame);
+  }
+}
+
 bool Stackwalker::InstructionAddressSeemsValid(uint64_t address) const {
   StackFrame frame;
   frame.instruction = address;
@@ -290,3 +290,51 @@ TEST_F(StackwalkerAddressListTest, ScanWithInlining) {
   ASSERT_EQ("mod1func1", frames->at(7)->function_name);
   ASSERT_EQ(0x40001000u, frames->at(7)->function_base);
 }
+
+TEST_F(StackwalkerAddressListTest, ScanWithInliningFromFrameMemo) {
+  SetModuleSymbols(&module2,
+                   "FILE 1 module2.cc\n"
+                   "INLINE_ORIGIN 0 mod2inlinefunc1\n"
+                   "INLINE_ORIGIN 1 mod2inlinefunc2\n"
+                   "INLINE_ORIGIN 2 mod2inlinefunc3\n"
+                   "FUNC 3000 100 10 mod2func3\n"
+                   "INLINE 0 1 1 1 3000 10\n"
+                   "INLINE 1 1 1 2 3000 10\n"
+                   "3000 10 1  1\n"
+                   "FUNC 2000 200 10 mod2func2\n"
+                   "INLINE 0 1 1 0 2000 10\n"
+                   "FUNC 1000 300 10 mod2func1\n");
+  SetModuleSymbols(&module1,
+                   "FUNC 2000 200 10 mod1func2\n"
+                   "FUNC 1000 300 10 mod1func1\n");
+
+  // The second walk is symbolized from the frames memoized by the first.
+  StackFrameSymbolizer frame_symbolizer(&supplier, &resolver);
+  CallStack call_stacks[2];
+  for (CallStack& call_stack : call_stacks) {
+    StackwalkerAddressList walker(kDummyFrames, arraysize(kDummyFrames),
+                                  &modules, &frame_symbolizer);
+    vector<const CodeModule*> modules_without_symbols;
+    vector<const CodeModule*> modules_with_corrupt_symbols;
+    ASSERT_TRUE(walker.Walk(&call_stack, &modules_without_symbols,
+                            &modules_with_corrupt_symbols));
+    ASSERT_NO_FATAL_FAILURE(CheckCallStack(call_stack, /*allow_inline=*/true));
+  }
+
+  const std::vector<StackFrame*>* walked = call_stacks[0].frames();
+  const std::vector<StackFrame*>* memoized = call_stacks[1].frames();
+  ASSERT_EQ(8u, walked->size());
+  ASSERT_EQ(walked->size(), memoized->size());
+  for (size_t i = 0; i < walked->size(); ++i) {
+    EXPECT_EQ(walked->at(i)->instruction, memoized->at(i)->instruction);
+    EXPECT_EQ(walked->at(i)->module, memoized->at(i)->module);
+    EXPECT_EQ(walked->at(i)->trust, memoized->at(i)->trust);
+    EXPECT_EQ(walked->at(i)->function_name, memoized->at(i)->function_name);
+    EXPECT_EQ(walked->at(i)->function_base, memoized->at(i)->function_base);
+    EXPECT_EQ(walked->at(i)->source_file_name,
+              memoized->at(i)->source_file_name);
+    EXPECT_EQ(walked->at(i)->source_line, memoized->at(i)->source_line);
+    EXPECT_EQ(walked->at(i)->source_line_base,
+              memoized->at(i)->source_line_base);
+  }
+}
@@ -45,8 +45,10 @@
 #include "google_breakpad/processor/stack_frame_cpu.h"
 #include "google_breakpad/processor/system_info.h"
 #include "processor/cfi_frame_info.h"
+#include "processor/eh_frame_unwind_tables.h"
 #include "processor/logging.h"
 #include "processor/stackwalker_amd64.h"
+#include "processor/windows_unwind_tables.h"
 
 namespace google_breakpad {
 
@@ -103,6 +105,7 @@ StackwalkerAMD64::StackwalkerAMD64(const SystemInfo* system_info,
       context_(context),
       cfi_walker_(cfi_register_map_,
                   (sizeof(cfi_register_map_) / sizeof(cfi_register_map_[0]))) {
+  symbolize_after_walk_ = trust_frame_pointers();
 }
 
 uint64_t StackFrameAMD64::ReturnAddress() const {
@@ -314,11 +317,55 @@ StackFrame* StackwalkerAMD64::GetCallerFrame(const CallStack* stack,
   StackFrameAMD64* last_frame = static_cast<StackFrameAMD64*>(frames.back());
   scoped_ptr<StackFrameAMD64> new_frame;
 
+  // With trusted frame pointers, follow the frame pointer chain past the
+  // context frame for as long as it looks sane.
+  if (symbolize_after_walk_ &&
+      last_frame->trust != StackFrame::FRAME_TRUST_CONTEXT) {
+    new_frame.reset(GetCallerByFramePointerRecovery(frames));
+    if (new_frame.get() &&
+        !TrustedFramePointerStep(last_frame->context.rbp,
+                                 new_frame->context.rbp,
+                                 new_frame->context.rip)) {
+      new_frame.reset();
+    }
+  }
+
   // If we have CFI information, use it.
-  scoped_ptr<CFIFrameInfo> cfi_frame_info(
-      frame_symbolizer_->FindCFIFrameInfo(last_frame));
-  if (cfi_frame_info.get())
-    new_frame.reset(GetCallerByCFIFrameInfo(frames, cfi_frame_info.get()));
+  if (!new_frame.get()) {
+    if (symbolize_after_walk_)
+      FillModuleInfo(last_frame);
+    scoped_ptr<CFIFrameInfo> cfi_frame_info(
+        frame_symbolizer_->FindCFIFrameInfo(last_frame));
+    if (cfi_frame_info.get())
+      new_frame.reset(GetCallerByCFIFrameInfo(frames, cfi_frame_info.get()));
+  }
+
+  // Without symbols, an x64 Windows image's own unwind information is as
+  // good as CFI.
+  if (!new_frame.get() && windows_unwind_tables_) {
+    const CodeModule* module = last_frame->module;
+    if (!module && modules_)
+      module = modules_->GetModuleForAddress(last_frame->instruction);
+    scoped_ptr<CFIFrameInfo> cfi_frame_info(
+        windows_unwind_tables_->FindCFIFrameInfo(
+            module, last_frame->context.rip,
+            last_frame->trust == StackFrame::FRAME_TRUST_CONTEXT));
+    if (cfi_frame_info.get())
+      new_frame.reset(GetCallerByCFIFrameInfo(frames, cfi_frame_info.get()));
+  }
+
+  // Likewise a Linux image's .eh_frame.
+  if (!new_frame.get() && eh_frame_unwind_tables_) {
+    const CodeModule* module = last_frame->module;
+    if (!module && modules_)
+      module = modules_->GetModuleForAddress(last_frame->instruction);
+    scoped_ptr<CFIFrameInfo> cfi_frame_info(
+        eh_frame_unwind_tables_->FindCFIFrameInfo(
+            module, last_frame->context.rip,
+            last_frame->trust == StackFrame::FRAME_TRUST_CONTEXT));
+    if (cfi_frame_info.get())
+      new_frame.reset(GetCallerByCFIFrameInfo(frames, cfi_frame_info.get()));
+  }
 
   // If CFI was not available and this is a Windows x64 stack, check whether
   // this is a leaf function which doesn't touch any callee-saved registers.
@@ -47,6 +47,7 @@
 #include "google_breakpad/processor/code_module.h"
 #include "google_breakpad/processor/source_line_resolver_interface.h"
 #include "google_breakpad/processor/stack_frame_cpu.h"
+#include "google_breakpad/processor/terminal_frames.h"
 #include "processor/stackwalker_unittest_utils.h"
 #include "processor/stackwalker_amd64.h"
 
@@ -59,6 +60,7 @@ using google_breakpad::StackFrameAMD64;
 using google_breakpad::Stackwalker;
 using google_breakpad::StackwalkerAMD64;
 using google_breakpad::SystemInfo;
+using google_breakpad::TerminalFrames;
 using google_breakpad::test_assembler::kLittleEndian;
 using google_breakpad::test_assembler::Label;
 using google_breakpad::test_assembler::Section;
@@ -101,8 +103,10 @@ class StackwalkerAMD64Fixture {
     // directly" for FreeSymbolData().
     EXPECT_CALL(supplier, FreeSymbolData(_)).Times(AnyNumber());
 
-    // Reset max_frames_scanned since it's static.
+    // Reset max_frames_scanned and trust_frame_pointers since they're
+    // static.
     Stackwalker::set_max_frames_scanned(1024);
+    Stackwalker::set_trust_frame_pointers(false);
   }
 
   // Set the Breakpad symbol information that supplier should return for
@@ -741,6 +745,150 @@ TEST_F(GetCallerFrame, CallerPushedRBP) {
   EXPECT_EQ(0x00007500b0000100ULL, frame1->function_base);
 }
 
+TEST_F(GetCallerFrame, TrustedFramePointers) {
+  // With trusted frame pointers, frames past the context frame are
+  // unwound along the %rbp chain even when there is CFI for them, and
+  // are still symbolized once the stack is walked.
+  stack_section.start() = 0x8000000080000000ULL;
+  uint64_t return_address1 = 0x00007500b0000110ULL;
+  uint64_t return_address2 = 0x00007400c0000310ULL;
+  Label frame0_rbp, frame1_sp, frame1_rbp, frame2_sp, frame2_rbp;
+
+  stack_section
+    // frame 0
+    .Append(16, 0)                      // space
+    .Mark(&frame0_rbp)
+    .D64(frame1_rbp)                    // caller-pushed %rbp
+    .D64(return_address1)               // actual return address
+    // frame 1
+    .Mark(&frame1_sp)
+    .D64(0x00007400c0000400ULL)         // what frame 1's CFI says is the
+    .Append(8, 0)                       // return address
+    .Mark(&frame1_rbp)
+    .D64(frame2_rbp)                    // caller-pushed %rbp
+    .D64(return_address2)               // actual return address
+    // frame 2
+    .Mark(&frame2_sp)
+    .Append(16, 0)
+    .Mark(&frame2_rbp)                  // end of chain
+    .D64(0)
+    .D64(0);
+  RegionFromSection();
+
+  raw_context.rip = 0x00007400c0000200ULL;
+  raw_context.rbp = frame0_rbp.Value();
+  raw_context.rsp = stack_section.start().Value();
+
+  SetModuleSymbols(&module1,
+                   // The youngest and oldest frames' function.
+                   "FUNC 100 400 10 sasquatch\n");
+  SetModuleSymbols(&module2,
+                   // The middle frame's function, with misleading CFI.
+                   "FUNC 100 400 10 yeti\n"
+                   "STACK CFI INIT 100 400 .cfa: $rsp 8 + .ra: .cfa 8 - ^\n");
+
+  Stackwalker::set_trust_frame_pointers(true);
+  StackFrameSymbolizer frame_symbolizer(&supplier, &resolver);
+  StackwalkerAMD64 walker(&system_info, &raw_context, &stack_region, &modules,
+                          &frame_symbolizer);
+  vector<const CodeModule*> modules_without_symbols;
+  vector<const CodeModule*> modules_with_corrupt_symbols;
+  ASSERT_TRUE(walker.Walk(&call_stack, &modules_without_symbols,
+                          &modules_with_corrupt_symbols));
+  ASSERT_EQ(0U, modules_without_symbols.size());
+  ASSERT_EQ(0U, modules_with_corrupt_symbols.size());
+  frames = call_stack.frames();
+  ASSERT_EQ(3U, frames->size());
+
+  StackFrameAMD64 *frame0 = static_cast<StackFrameAMD64*>(frames->at(0));
+  EXPECT_EQ(StackFrame::FRAME_TRUST_CONTEXT, frame0->trust);
+  EXPECT_EQ("sasquatch", frame0->function_name);
+
+  StackFrameAMD64 *frame1 = static_cast<StackFrameAMD64*>(frames->at(1));
+  EXPECT_EQ(StackFrame::FRAME_TRUST_FP, frame1->trust);
+  EXPECT_EQ(return_address1, frame1->context.rip);
+  EXPECT_EQ(frame1_sp.Value(), frame1->context.rsp);
+  EXPECT_EQ(frame1_rbp.Value(), frame1->context.rbp);
+  EXPECT_EQ("yeti", frame1->function_name);
+
+  StackFrameAMD64 *frame2 = static_cast<StackFrameAMD64*>(frames->at(2));
+  EXPECT_EQ(StackFrame::FRAME_TRUST_FP, frame2->trust);
+  EXPECT_EQ(return_address2, frame2->context.rip);
+  EXPECT_EQ(frame2_sp.Value(), frame2->context.rsp);
+  EXPECT_EQ(frame2_rbp.Value(), frame2->context.rbp);
+  EXPECT_EQ("sasquatch", frame2->function_name);
+}
+
+TEST_F(GetCallerFrame, StopsAtTerminalFrame) {
+  // The %rbp chain goes on past start_thread, into a frame that is not
+  // wanted.
+  stack_section.start() = 0x8000000080000000ULL;
+  uint64_t return_address1 = 0x00007500b0000110ULL;
+  uint64_t return_address2 = 0x00007400c0000310ULL;
+  Label frame0_rbp, frame1_rbp, frame2_rbp;
+
+  stack_section
+    // frame 0
+    .Append(16, 0)                      // space
+    .Mark(&frame0_rbp)
+    .D64(frame1_rbp)                    // caller-pushed %rbp
+    .D64(return_address1)               // actual return address
+    // frame 1
+    .Append(16, 0)
+    .Mark(&frame1_rbp)
+    .D64(frame2_rbp)                    // caller-pushed %rbp
+    .D64(return_address2)               // actual return address
+    // frame 2
+    .Append(16, 0)
+    .Mark(&frame2_rbp)                  // end of chain
+    .D64(0)
+    .D64(0);
+  RegionFromSection();
+
+  raw_context.rip = 0x00007400c0000200ULL;
+  raw_context.rbp = frame0_rbp.Value();
+  raw_context.rsp = stack_section.start().Value();
+
+  SetModuleSymbols(&module1, "FUNC 100 400 10 sasquatch\n");
+  SetModuleSymbols(&module2, "FUNC 100 400 10 start_thread\n");
+
+  TerminalFrames terminal_frames;
+  terminal_frames.Add("windows", "", "start_thread");
+  terminal_frames.Add("linux", "libc.so.6", "start_thread");
+  StackFrameSymbolizer frame_symbolizer(&supplier, &resolver);
+  vector<const CodeModule*> modules_without_symbols;
+  vector<const CodeModule*> modules_with_corrupt_symbols;
+  {
+    // Neither entry applies to this frame.
+    StackwalkerAMD64 walker(&system_info, &raw_context, &stack_region,
+                            &modules, &frame_symbolizer);
+    walker.set_terminal_frames(&terminal_frames);
+    ASSERT_TRUE(walker.Walk(&call_stack, &modules_without_symbols,
+                            &modules_with_corrupt_symbols));
+    EXPECT_EQ(3U, call_stack.frames()->size());
+    EXPECT_FALSE(call_stack.ended_at_terminal_frame());
+  }
+
+  // Module names are compared without regard to case, and the walk stops
+  // whether frames are symbolized as they are found or after the whole
+  // stack is walked.
+  terminal_frames.Add("linux", "Module2", "start_thread");
+  for (int trust_frame_pointers = 0; trust_frame_pointers < 2;
+       ++trust_frame_pointers) {
+    Stackwalker::set_trust_frame_pointers(trust_frame_pointers);
+    StackwalkerAMD64 walker(&system_info, &raw_context, &stack_region,
+                            &modules, &frame_symbolizer);
+    walker.set_terminal_frames(&terminal_frames);
+    ASSERT_TRUE(walker.Walk(&call_stack, &modules_without_symbols,
+                            &modules_with_corrupt_symbols));
+    frames = call_stack.frames();
+    ASSERT_EQ(2U, frames->size());
+    EXPECT_EQ("sasquatch", frames->at(0)->function_name);
+    EXPECT_EQ("start_thread", frames->at(1)->function_name);
+    EXPECT_TRUE(call_stack.ended_at_terminal_frame());
+  }
+}
+
 struct CFIFixture: public StackwalkerAMD64Fixture {
   CFIFixture() {
     // Provide a bunch of STACK CFI records; we'll walk to the caller
@@ -45,6 +45,7 @@
 #include "google_breakpad/processor/source_line_resolver_interface.h"
 #include "google_breakpad/processor/stack_frame_cpu.h"
 #include "processor/cfi_frame_info.h"
+#include "processor/eh_frame_unwind_tables.h"
 #include "processor/logging.h"
 #include "processor/stackwalker_arm64.h"
 
@@ -75,6 +76,7 @@ StackwalkerARM64::StackwalkerARM64(const SystemInfo* system_info,
     mask |= mask >> 32;
     address_range_mask_ = mask;
   }
+  symbolize_after_walk_ = trust_frame_pointers();
 }
 
 uint64_t StackwalkerARM64::PtrauthStrip(uint64_t ptr) {
@@ -107,39 +109,47 @@ StackFrameARM64* StackwalkerARM64::GetCallerByCFIFrameInfo(
     CFIFrameInfo* cfi_frame_info) {
   StackFrameARM64* last_frame = static_cast<StackFrameARM64*>(frames.back());
 
-  static const char* register_names[] = {
-    "x0",  "x1",  "x2",  "x3",  "x4",  "x5",  "x6",  "x7",
-    "x8",  "x9",  "x10", "x11", "x12", "x13", "x14", "x15",
-    "x16", "x17", "x18", "x19", "x20", "x21", "x22", "x23",
-    "x24", "x25", "x26", "x27", "x28", "x29", "x30", "sp",
-    "pc",  NULL
+  // If the CFI doesn't recover the PC or the SP explicitly, then use .ra and
+  // .cfa.
+  static const CFIFrameInfo::RegisterName register_names[] = {
+    { "x0", NULL },  { "x1", NULL },  { "x2", NULL },  { "x3", NULL },
+    { "x4", NULL },  { "x5", NULL },  { "x6", NULL },  { "x7", NULL },
+    { "x8", NULL },  { "x9", NULL },  { "x10", NULL }, { "x11", NULL },
+    { "x12", NULL }, { "x13", NULL }, { "x14", NULL }, { "x15", NULL },
+    { "x16", NULL }, { "x17", NULL }, { "x18", NULL }, { "x19", NULL },
+    { "x20", NULL }, { "x21", NULL }, { "x22", NULL }, { "x23", NULL },
+    { "x24", NULL }, { "x25", NULL }, { "x26", NULL }, { "x27", NULL },
+    { "x28", NULL }, { "x29", NULL }, { "x30", NULL }, { "sp", ".cfa" },
+    { "pc", ".ra" }
   };
-
-  // Populate a dictionary with the valid register values in last_frame.
-  CFIFrameInfo::RegisterValueMap<uint64_t> callee_registers;
-  for (int i = 0; register_names[i]; i++) {
-    if (last_frame->context_validity & StackFrameARM64::RegisterValidFlag(i))
-      callee_registers[register_names[i]] = last_frame->context.iregs[i];
+  static const size_t register_count =
+      sizeof(register_names) / sizeof(register_names[0]);
+
+  // Gather the valid register values in last_frame.
+  bool callee_validity[register_count];
+  for (size_t i = 0; i < register_count; i++) {
+    callee_validity[i] = (last_frame->context_validity &
+                          StackFrameARM64::RegisterValidFlag(i)) != 0;
   }
 
   // Use the STACK CFI data to recover the caller's register values.
-  CFIFrameInfo::RegisterValueMap<uint64_t> caller_registers;
-  if (!cfi_frame_info->FindCallerRegs(callee_registers, *memory_,
-                                      &caller_registers)) {
+  uint64_t caller_registers[register_count];
+  bool caller_validity[register_count];
+  if (!cfi_frame_info->FindCallerRegs(register_names, register_count,
+                                      last_frame->context.iregs,
+                                      callee_validity, *memory_,
+                                      caller_registers, caller_validity)) {
     return NULL;
   }
   // Construct a new stack frame given the values the CFI recovered.
   scoped_ptr<StackFrameARM64> frame(new StackFrameARM64());
-  for (int i = 0; register_names[i]; i++) {
-    CFIFrameInfo::RegisterValueMap<uint64_t>::iterator entry =
-      caller_registers.find(register_names[i]);
-    if (entry != caller_registers.end()) {
+  for (size_t i = 0; i < register_count; i++) {
+    if (caller_validity[i]) {
       // We recovered the value of this register; fill the context with the
       // value from caller_registers.
       frame->context_validity |= StackFrameARM64::RegisterValidFlag(i);
-      frame->context.iregs[i] = entry->second;
-    } else if (19 <= i && i <= 29 && (last_frame->context_validity &
-                                      StackFrameARM64::RegisterValidFlag(i))) {
+      frame->context.iregs[i] = caller_registers[i];
+    } else if (19 <= i && i <= 29 && callee_validity[i]) {
       // If the STACK CFI data doesn't mention some callee-saves register, and
       // it is valid in the callee, assume the callee has not yet changed it.
       // Registers r19 through r29 are callee-saves, according to the Procedure
@@ -149,24 +159,6 @@ StackFrameARM64* StackwalkerARM64::GetCallerByCFIFrameInfo(
       frame->context.iregs[i] = last_frame->context.iregs[i];
     }
   }
-  // If the CFI doesn't recover the PC explicitly, then use .ra.
-  if (!(frame->context_validity & StackFrameARM64::CONTEXT_VALID_PC)) {
-    CFIFrameInfo::RegisterValueMap<uint64_t>::iterator entry =
-      caller_registers.find(".ra");
-    if (entry != caller_registers.end()) {
-      frame->context_validity |= StackFrameARM64::CONTEXT_VALID_PC;
-      frame->context.iregs[MD_CONTEXT_ARM64_REG_PC] = entry->second;
-    }
-  }
-  // If the CFI doesn't recover the SP explicitly, then use .cfa.
-  if (!(frame->context_validity & StackFrameARM64::CONTEXT_VALID_SP)) {
-    CFIFrameInfo::RegisterValueMap<uint64_t>::iterator entry =
-      caller_registers.find(".cfa");
-    if (entry != caller_registers.end()) {
-      frame->context_validity |= StackFrameARM64::CONTEXT_VALID_SP;
-      frame->context.iregs[MD_CONTEXT_ARM64_REG_SP] = entry->second;
-    }
-  }
 
   // If we didn't recover the PC and the SP, then the frame isn't very useful.
   static const uint64_t essentials = (StackFrameARM64::CONTEXT_VALID_SP
@@ -318,11 +310,44 @@ StackFrame* StackwalkerARM64::GetCallerFrame(const CallStack* stack,
   StackFrameARM64* last_frame = static_cast<StackFrameARM64*>(frames.back());
   scoped_ptr<StackFrameARM64> frame;
 
+  // With trusted frame pointers, follow the frame pointer chain past the
+  // context frame for as long as it looks sane.
+  if (symbolize_after_walk_ &&
+      last_frame->trust != StackFrame::FRAME_TRUST_CONTEXT) {
+    frame.reset(GetCallerByFramePointer(frames));
+    if (frame.get() &&
+        !TrustedFramePointerStep(
+            last_frame->context.iregs[MD_CONTEXT_ARM64_REG_FP],
+            frame->context.iregs[MD_CONTEXT_ARM64_REG_FP],
+            frame->context.iregs[MD_CONTEXT_ARM64_REG_PC])) {
+      frame.reset();
+    }
+  }
+
   // See if there is DWARF call frame information covering this address.
-  scoped_ptr<CFIFrameInfo> cfi_frame_info(
-      frame_symbolizer_->FindCFIFrameInfo(last_frame));
-  if (cfi_frame_info.get())
-    frame.reset(GetCallerByCFIFrameInfo(frames, cfi_frame_info.get()));
+  if (!frame.get()) {
+    if (symbolize_after_walk_)
+      FillModuleInfo(last_frame);
+    scoped_ptr<CFIFrameInfo> cfi_frame_info(
+        frame_symbolizer_->FindCFIFrameInfo(last_frame));
+    if (cfi_frame_info.get())
+      frame.reset(GetCallerByCFIFrameInfo(frames, cfi_frame_info.get()));
+  }
+
+  // Without symbols, the image's own .eh_frame is as good as CFI.
+  if (!frame.get() && eh_frame_unwind_tables_) {
+    const CodeModule* module = last_frame->module;
+    if (!module && modules_) {
+      module = modules_->GetModuleForAddress(
+          last_frame->context.iregs[MD_CONTEXT_ARM64_REG_PC]);
+    }
+    scoped_ptr<CFIFrameInfo> cfi_frame_info(
+        eh_frame_unwind_tables_->FindCFIFrameInfo(
+            module, last_frame->context.iregs[MD_CONTEXT_ARM64_REG_PC],
+            last_frame->trust == StackFrame::FRAME_TRUST_CONTEXT));
+    if (cfi_frame_info.get())
+      frame.reset(GetCallerByCFIFrameInfo(frames, cfi_frame_info.get()));
+  }
 
   // If CFI failed, or there wasn't CFI available, fall back to frame pointer.
   if (!frame.get())
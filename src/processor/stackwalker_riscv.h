@@ -39,6 +39,8 @@
 
 #include "google_breakpad/common/minidump_format.h"
 #include "google_breakpad/processor/stackwalker.h"
+#include "google_breakpad/processor/stack_frame_cpu.h"
+#include "processor/cfi_frame_info.h"
 
 namespace google_breakpad {
 
@@ -64,6 +66,9 @@ public:
   }
 
 private:
+  // A STACK CFI-driven frame walker for RISCV.
+  typedef SimpleCFIWalker<uint32_t, MDRawContextRISCV> CFIWalker;
+
   // Implementation of Stackwalker, using riscv context and stack conventions.
   virtual StackFrame* GetContextFrame();
   virtual StackFrame* GetCallerFrame(
@@ -93,6 +98,12 @@ private:
   // CONTEXT_VALID_ALL in real use; it is only changeable for the sake of
   // unit tests.
   int context_frame_validity_;
+
+  // Our register map, for cfi_walker_.
+  static const CFIWalker::RegisterSet cfi_register_map_[];
+
+  // Our CFI frame walker.
+  const CFIWalker cfi_walker_;
 };
 
 }  // namespace google_breakpad
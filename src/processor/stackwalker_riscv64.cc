@@ -49,6 +49,76 @@
 
 namespace google_breakpad {
 
+const StackwalkerRISCV64::CFIWalker::RegisterSet
+StackwalkerRISCV64::cfi_register_map_[] = {
+  // The callee_saves flags mean that the walker should assume s0-s11
+  // are unchanged if the CFI doesn't mention them.
+  { "pc", ".ra", false,
+    StackFrameRISCV64::CONTEXT_VALID_PC, &MDRawContextRISCV64::pc },
+  { "ra", NULL, false,
+    StackFrameRISCV64::CONTEXT_VALID_RA, &MDRawContextRISCV64::ra },
+  { "sp", ".cfa", false,
+    StackFrameRISCV64::CONTEXT_VALID_SP, &MDRawContextRISCV64::sp },
+  { "gp", NULL, false,
+    StackFrameRISCV64::CONTEXT_VALID_GP, &MDRawContextRISCV64::gp },
+  { "tp", NULL, false,
+    StackFrameRISCV64::CONTEXT_VALID_TP, &MDRawContextRISCV64::tp },
+  { "t0", NULL, false,
+    StackFrameRISCV64::CONTEXT_VALID_T0, &MDRawContextRISCV64::t0 },
+  { "t1", NULL, false,
+    StackFrameRISCV64::CONTEXT_VALID_T1, &MDRawContextRISCV64::t1 },
+  { "t2", NULL, false,
+    StackFrameRISCV64::CONTEXT_VALID_T2, &MDRawContextRISCV64::t2 },
+  { "s0", NULL, true,
+    StackFrameRISCV64::CONTEXT_VALID_S0, &MDRawContextRISCV64::s0 },
+  { "s1", NULL, true,
+    StackFrameRISCV64::CONTEXT_VALID_S1, &MDRawContextRISCV64::s1 },
+  { "a0", NULL, false,
+    StackFrameRISCV64::CONTEXT_VALID_A0, &MDRawContextRISCV64::a0 },
+  { "a1", NULL, false,
+    StackFrameRISCV64::CONTEXT_VALID_A1, &MDRawContextRISCV64::a1 },
+  { "a2", NULL, false,
+    StackFrameRISCV64::CONTEXT_VALID_A2, &MDRawContextRISCV64::a2 },
+  { "a3", NULL, false,
+    StackFrameRISCV64::CONTEXT_VALID_A3, &MDRawContextRISCV64::a3 },
+  { "a4", NULL, false,
+    StackFrameRISCV64::CONTEXT_VALID_A4, &MDRawContextRISCV64::a4 },
+  { "a5", NULL, false,
+    StackFrameRISCV64::CONTEXT_VALID_A5, &MDRawContextRISCV64::a5 },
+  { "a6", NULL, false,
+    StackFrameRISCV64::CONTEXT_VALID_A6, &MDRawContextRISCV64::a6 },
+  { "a7", NULL, false,
+    StackFrameRISCV64::CONTEXT_VALID_A7, &MDRawContextRISCV64::a7 },
+  { "s2", NULL, true,
+    StackFrameRISCV64::CONTEXT_VALID_S2, &MDRawContextRISCV64::s2 },
+  { "s3", NULL, true,
+    StackFrameRISCV64::CONTEXT_VALID_S3, &MDRawContextRISCV64::s3 },
+  { "s4", NULL, true,
+    StackFrameRISCV64::CONTEXT_VALID_S4, &MDRawContextRISCV64::s4 },
+  { "s5", NULL, true,
+    StackFrameRISCV64::CONTEXT_VALID_S5, &MDRawContextRISCV64::s5 },
+  { "s6", NULL, true,
+    StackFrameRISCV64::CONTEXT_VALID_S6, &MDRawContextRISCV64::s6 },
+  { "s7", NULL, true,
+    StackFrameRISCV64::CONTEXT_VALID_S7, &MDRawContextRISCV64::s7 },
+  { "s8", NULL, true,
+    StackFrameRISCV64::CONTEXT_VALID_S8, &MDRawContextRISCV64::s8 },
+  { "s9", NULL, true,
+    StackFrameRISCV64::CONTEXT_VALID_S9, &MDRawContextRISCV64::s9 },
+  { "s10", NULL, true,
+    StackFrameRISCV64::CONTEXT_VALID_S10, &MDRawContextRISCV64::s10 },
+  { "s11", NULL, true,
+    StackFrameRISCV64::CONTEXT_VALID_S11, &MDRawContextRISCV64::s11 },
+  { "t3", NULL, false,
+    StackFrameRISCV64::CONTEXT_VALID_T3, &MDRawContextRISCV64::t3 },
+  { "t4", NULL, false,
+    StackFrameRISCV64::CONTEXT_VALID_T4, &MDRawContextRISCV64::t4 },
+  { "t5", NULL, false,
+    StackFrameRISCV64::CONTEXT_VALID_T5, &MDRawContextRISCV64::t5 },
+  { "t6", NULL, false,
+    StackFrameRISCV64::CONTEXT_VALID_T6, &MDRawContextRISCV64::t6 },
+};
+
 StackwalkerRISCV64::StackwalkerRISCV64(const SystemInfo* system_info,
                                        const MDRawContextRISCV64* context,
                                        MemoryRegion* memory,
@@ -56,7 +126,9 @@ StackwalkerRISCV64::StackwalkerRISCV64(const SystemInfo* system_info,
                                        StackFrameSymbolizer* resolver_helper)
     : Stackwalker(system_info, memory, modules, resolver_helper),
       context_(context),
-      context_frame_validity_(StackFrameRISCV::CONTEXT_VALID_ALL) {
+      context_frame_validity_(StackFrameRISCV::CONTEXT_VALID_ALL),
+      cfi_walker_(cfi_register_map_,
+                  (sizeof(cfi_register_map_) / sizeof(cfi_register_map_[0]))) {
 }
 
 
@@ -82,329 +154,13 @@ StackFrameRISCV64* StackwalkerRISCV64::GetCallerByCFIFrameInfo(
   StackFrameRISCV64* last_frame =
       static_cast<StackFrameRISCV64*>(frames.back());
 
-  // Populate a dictionary with the valid register values in last_frame.
-  CFIFrameInfo::RegisterValueMap<uint64_t> callee_registers;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_PC)
-    callee_registers["pc"] = last_frame->context.pc;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_RA)
-    callee_registers["ra"] = last_frame->context.ra;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_SP)
-    callee_registers["sp"] = last_frame->context.sp;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_GP)
-    callee_registers["gp"] = last_frame->context.gp;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_TP)
-    callee_registers["tp"] = last_frame->context.tp;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_T0)
-    callee_registers["t0"] = last_frame->context.t0;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_T1)
-    callee_registers["t1"] = last_frame->context.t1;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_T2)
-    callee_registers["t2"] = last_frame->context.t2;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_S0)
-    callee_registers["s0"] = last_frame->context.s0;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_S1)
-    callee_registers["s1"] = last_frame->context.s1;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_A0)
-    callee_registers["a0"] = last_frame->context.a0;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_A1)
-    callee_registers["a1"] = last_frame->context.a1;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_A2)
-    callee_registers["a2"] = last_frame->context.a2;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_A3)
-    callee_registers["a3"] = last_frame->context.a3;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_A4)
-    callee_registers["a4"] = last_frame->context.a4;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_A5)
-    callee_registers["a5"] = last_frame->context.a5;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_A6)
-    callee_registers["a6"] = last_frame->context.a6;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_A7)
-    callee_registers["a7"] = last_frame->context.a7;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_S2)
-    callee_registers["s2"] = last_frame->context.s2;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_S3)
-    callee_registers["s3"] = last_frame->context.s3;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_S4)
-    callee_registers["s4"] = last_frame->context.s4;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_S5)
-    callee_registers["s5"] = last_frame->context.s5;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_S6)
-    callee_registers["s6"] = last_frame->context.s6;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_S7)
-    callee_registers["s7"] = last_frame->context.s7;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_S8)
-    callee_registers["s8"] = last_frame->context.s8;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_S9)
-    callee_registers["s9"] = last_frame->context.s9;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_S10)
-    callee_registers["s10"] = last_frame->context.s10;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_S11)
-    callee_registers["s11"] = last_frame->context.s11;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_T3)
-    callee_registers["t3"] = last_frame->context.t3;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_T4)
-    callee_registers["t4"] = last_frame->context.t4;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_T5)
-    callee_registers["t5"] = last_frame->context.t5;
-  if (last_frame->context_validity & StackFrameRISCV64::CONTEXT_VALID_T6)
-    callee_registers["t6"] = last_frame->context.t6;
-
-  // Use the STACK CFI data to recover the caller's register values.
-  CFIFrameInfo::RegisterValueMap<uint64_t> caller_registers;
-  if (!cfi_frame_info->FindCallerRegs(callee_registers, *memory_,
-                                      &caller_registers)) {
-    return NULL;
-  }
-
-  // Construct a new stack frame given the values the CFI recovered.
-  CFIFrameInfo::RegisterValueMap<uint64_t>::iterator entry;
   scoped_ptr<StackFrameRISCV64> frame(new StackFrameRISCV64());
-  entry = caller_registers.find("pc");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_PC;
-    frame->context.pc = entry->second;
-  } else{
-    // If the CFI doesn't recover the PC explicitly, then use .ra.
-    entry = caller_registers.find(".ra");
-    if (entry != caller_registers.end()) {
-      frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_PC;
-      frame->context.pc = entry->second;
-    }
-  }
-  entry = caller_registers.find("ra");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_RA;
-    frame->context.ra = entry->second;
-  }
-  entry = caller_registers.find("sp");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_SP;
-    frame->context.sp = entry->second;
-  } else {
-    // If the CFI doesn't recover the SP explicitly, then use .cfa.
-    entry = caller_registers.find(".cfa");
-    if (entry != caller_registers.end()) {
-      frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_SP;
-      frame->context.sp = entry->second;
-    }
-  }
-  entry = caller_registers.find("gp");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_GP;
-    frame->context.gp = entry->second;
-  }
-  entry = caller_registers.find("tp");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_TP;
-    frame->context.tp = entry->second;
-  }
-  entry = caller_registers.find("t0");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_T0;
-    frame->context.t0 = entry->second;
-  }
-  entry = caller_registers.find("t1");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_T1;
-    frame->context.t1 = entry->second;
-  }
-  entry = caller_registers.find("t2");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_T2;
-    frame->context.t2 = entry->second;
-  }
-  entry = caller_registers.find("s0");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S0;
-    frame->context.s0 = entry->second;
-  } else if (last_frame->context_validity &
-             StackFrameRISCV64::CONTEXT_VALID_S0) {
-    // Since the register is callee-saves, assume the callee
-    // has not yet changed it.
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S0;
-    frame->context.s0 = last_frame->context.s0;
-  }
-  entry = caller_registers.find("s1");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S1;
-    frame->context.s1 = entry->second;
-  } else if (last_frame->context_validity &
-             StackFrameRISCV64::CONTEXT_VALID_S1) {
-    // Since the register is callee-saves, assume the callee
-    // has not yet changed it.
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S1;
-    frame->context.s1 = last_frame->context.s1;
-  }
-  entry = caller_registers.find("a0");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_A0;
-    frame->context.a0 = entry->second;
-  }
-  entry = caller_registers.find("a1");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_A1;
-    frame->context.a1 = entry->second;
-  }
-  entry = caller_registers.find("a2");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_A2;
-    frame->context.a2 = entry->second;
-  }
-  entry = caller_registers.find("a3");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_A3;
-    frame->context.a3 = entry->second;
-  }
-  entry = caller_registers.find("a4");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_A4;
-    frame->context.a4 = entry->second;
-  }
-  entry = caller_registers.find("a5");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_A5;
-    frame->context.a5 = entry->second;
-  }
-  entry = caller_registers.find("a6");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_A6;
-    frame->context.a6 = entry->second;
-  }
-  entry = caller_registers.find("a7");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_A7;
-    frame->context.a7 = entry->second;
-  }
-  entry = caller_registers.find("s2");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S2;
-    frame->context.s2 = entry->second;
-  } else if (last_frame->context_validity &
-             StackFrameRISCV64::CONTEXT_VALID_S2) {
-    // Since the register is callee-saves, assume the callee
-    // has not yet changed it.
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S2;
-    frame->context.s2 = last_frame->context.s2;
-  }
-  entry = caller_registers.find("s3");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S3;
-    frame->context.s3 = entry->second;
-  } else if (last_frame->context_validity &
-             StackFrameRISCV64::CONTEXT_VALID_S3) {
-    // Since the register is callee-saves, assume the callee
-    // has not yet changed it.
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S3;
-    frame->context.s3 = last_frame->context.s3;
-  }
-  entry = caller_registers.find("s4");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S4;
-    frame->context.s4 = entry->second;
-  } else if (last_frame->context_validity &
-             StackFrameRISCV64::CONTEXT_VALID_S4) {
-    // Since the register is callee-saves, assume the callee
-    // has not yet changed it.
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S4;
-    frame->context.s4 = last_frame->context.s4;
-  }
-  entry = caller_registers.find("s5");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S5;
-    frame->context.s5 = entry->second;
-  } else if (last_frame->context_validity &
-             StackFrameRISCV64::CONTEXT_VALID_S5) {
-    // Since the register is callee-saves, assume the callee
-    // has not yet changed it.
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S5;
-    frame->context.s5 = last_frame->context.s5;
-  }
-  entry = caller_registers.find("s6");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S6;
-    frame->context.s6 = entry->second;
-  } else if (last_frame->context_validity &
-             StackFrameRISCV64::CONTEXT_VALID_S6) {
-    // Since the register is callee-saves, assume the callee
-    // has not yet changed it.
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S6;
-    frame->context.s6 = last_frame->context.s6;
-  }
-  entry = caller_registers.find("s7");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S7;
-    frame->context.s7 = entry->second;
-  } else if (last_frame->context_validity &
-             StackFrameRISCV64::CONTEXT_VALID_S7) {
-    // Since the register is callee-saves, assume the callee
-    // has not yet changed it.
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S7;
-    frame->context.s7 = last_frame->context.s7;
-  }
-  entry = caller_registers.find("s8");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S8;
-    frame->context.s8 = entry->second;
-  } else if (last_frame->context_validity &
-             StackFrameRISCV64::CONTEXT_VALID_S8) {
-    // Since the register is callee-saves, assume the callee
-    // has not yet changed it.
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S8;
-    frame->context.s8 = last_frame->context.s8;
-  }
-  entry = caller_registers.find("s9");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S9;
-    frame->context.s9 = entry->second;
-  } else if (last_frame->context_validity &
-             StackFrameRISCV64::CONTEXT_VALID_S9) {
-    // Since the register is callee-saves, assume the callee
-    // has not yet changed it.
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S9;
-    frame->context.s9 = last_frame->context.s9;
-  }
-  entry = caller_registers.find("s10");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S10;
-    frame->context.s10 = entry->second;
-  } else if (last_frame->context_validity &
-             StackFrameRISCV64::CONTEXT_VALID_S10) {
-    // Since the register is callee-saves, assume the callee
-    // has not yet changed it.
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S10;
-    frame->context.s10 = last_frame->context.s10;
-  }
-  entry = caller_registers.find("s11");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S11;
-    frame->context.s11 = entry->second;
-  } else if (last_frame->context_validity &
-             StackFrameRISCV64::CONTEXT_VALID_S11) {
-    // Since the register is callee-saves, assume the callee
-    // has not yet changed it.
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_S11;
-    frame->context.s11 = last_frame->context.s11;
-  }
-  entry = caller_registers.find("t3");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_T3;
-    frame->context.t3 = entry->second;
-  }
-  entry = caller_registers.find("t4");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_T4;
-    frame->context.t4 = entry->second;
-  }
-  entry = caller_registers.find("t5");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_T5;
-    frame->context.t5 = entry->second;
-  }
-  entry = caller_registers.find("t6");
-  if (entry != caller_registers.end()) {
-    frame->context_validity |= StackFrameRISCV64::CONTEXT_VALID_T6;
-    frame->context.t6 = entry->second;
-  }
+  if (!cfi_walker_.FindCallerRegisters(*memory_, *cfi_frame_info,
+                                       last_frame->context,
+                                       last_frame->context_validity,
+                                       &frame->context,
+                                       &frame->context_validity))
+    return NULL;
 
   // If we didn't recover the PC and the SP, then the frame isn't very useful.
   static const uint64_t essentials = (StackFrameRISCV64::CONTEXT_VALID_SP
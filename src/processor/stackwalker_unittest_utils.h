@@ -76,10 +76,16 @@ class MockMemoryRegion: public google_breakpad::MemoryRegion {
   bool GetMemoryAtAddress(uint64_t address, uint64_t* value) const {
     return GetMemoryLittleEndian(address, value);
   }
+  bool ByteSwapped() const { return !HostIsLittleEndian(); }
   void Print() const {
     assert(false);
   }
 
+ protected:
+  const uint8_t* GetSpanAtOffset(uint64_t offset, size_t size) const {
+    return reinterpret_cast<const uint8_t*>(contents_.data()) + offset;
+  }
+
  private:
   // Fetch a little-endian value from ADDRESS in contents_ whose size
   // is BYTES, and store it in *VALUE. Return true on success.
@@ -210,26 +210,11 @@ StackFrameX86* StackwalkerX86::GetCallerByWindowsFrameInfo(
       last_frame_callee_parameter_size =
           last_frame_callee_info->parameter_size;
     }
+    // Only the nearest real callee counts.  Looking any further would also
+    // make walking a deep stack quadratic.
+    break;
   }
 
-  // Set up the dictionary for the PostfixEvaluator.  %ebp, %esp, and sometimes
-  // %ebx are used in program strings, and their previous values are known, so
-  // set them here.
-  PostfixEvaluator<uint32_t>::DictionaryType dictionary;
-  // Provide the current register values.
-  dictionary["$ebp"] = last_frame->context.ebp;
-  dictionary["$esp"] = last_frame->context.esp;
-  if (last_frame->context_validity & StackFrameX86::CONTEXT_VALID_EBX)
-    dictionary["$ebx"] = last_frame->context.ebx;
-  // Provide constants from the debug info for last_frame and its callee.
-  // .cbCalleeParams is a Breakpad extension that allows us to use the
-  // PostfixEvaluator engine when certain types of debugging information
-  // are present without having to write the constants into the program
-  // string as literals.
-  dictionary[".cbCalleeParams"] = last_frame_callee_parameter_size;
-  dictionary[".cbSavedRegs"] = last_frame_info->saved_register_size;
-  dictionary[".cbLocals"] = last_frame_info->local_size;
-
   uint32_t raSearchStart = last_frame->context.esp +
                            last_frame_callee_parameter_size +
                            last_frame_info->local_size +
@@ -268,16 +253,24 @@ StackFrameX86* StackwalkerX86::GetCallerByWindowsFrameInfo(
     ScanForReturnAddress(raSearchStart, &raSearchStart, &found, 3);
   }
 
-  dictionary[".cbParams"] = last_frame_info->parameter_size;
-
-  // Decide what type of program string to use. The program string is in
-  // postfix notation and will be passed to PostfixEvaluator::Evaluate.
-  // Given the dictionary and the program string, it is possible to compute
-  // the return address and the values of other registers in the calling
-  // function. Because of bugs described below, the stack may need to be
-  // scanned for these values. The results of program string evaluation
-  // will be used to determine whether to scan for better values.
-  string program_string;
+  // The caller's registers, as recovered below.  %ebp keeps its value
+  // unless the rules say otherwise, and the nonvolatile registers are only
+  // passed on if the rules give them, as indicated in caller_validity.
+  uint32_t caller_eip = 0;
+  uint32_t caller_esp = 0;
+  uint32_t caller_ebp = last_frame->context.ebp;
+  uint32_t caller_ebx = 0, caller_esi = 0, caller_edi = 0;
+  int caller_validity = 0;
+  bool evaluated;
+
+  // Decide how to recover the caller's registers.  Given a program string,
+  // in postfix notation, PostfixEvaluator computes the return address and
+  // the values of other registers in the calling function.  Frames without
+  // one take one of two fixed shapes, whose rules are applied directly, as
+  // they are in nearly every frame of a deep stack.  Because of bugs
+  // described below, the stack may need to be scanned for these values.
+  // The results will be used to determine whether to scan for better
+  // values.
   bool recover_ebp = true;
 
   trust = StackFrame::FRAME_TRUST_CFI;
@@ -286,8 +279,78 @@ StackFrameX86* StackwalkerX86::GetCallerByWindowsFrameInfo(
     // get to the caller frame, and may even fill in the values of
     // nonvolatile registers and provide pointers to local variables and
     // parameters.  In some cases, particularly with program strings that use
-    // .raSearchStart, the stack may need to be scanned afterward.
-    program_string = last_frame_info->program_string;
+    // .raSearchStart, the stack may need to be scanned afterward.  The
+    // program is compiled once per WindowsFrameInfo.
+    const PostfixEvaluator<uint32_t>::Program& program =
+        last_frame_info->GetCompiledProgram();
+
+    // Check for alignment operators in the program string.  If alignment
+    // operators are found, then current %ebp must be valid and it is the
+    // only reliable data point that can be used for getting to the previous
+    // frame.  E.g. the .raSearchStart calculation (above) is based on %esp
+    // and since %esp was aligned in the current frame (which is a lossy
+    // operation) the calculated value of .raSearchStart cannot be correct and
+    // should not be used.  Instead .raSearchStart must be calculated based on
+    // %ebp.  The code that follows assumes that .raSearchStart is supposed to
+    // point at the saved return address (ebp + 4).
+    // For some more details on this topic, take a look at the following
+    // thread:
+    // https://groups.google.com/forum/#!topic/google-breakpad-dev/ZP1FA9B1JjM
+    if ((StackFrameX86::CONTEXT_VALID_EBP & last_frame->context_validity) !=
+            0 &&
+        program.expression().find('@') != string::npos) {
+      raSearchStart = last_frame->context.ebp + 4;
+    }
+
+    // Set up the dictionary for the PostfixEvaluator.  %ebp, %esp, and
+    // sometimes %ebx are used in program strings, and their previous values
+    // are known, so set them here.
+    PostfixEvaluator<uint32_t>::DictionaryType dictionary;
+    // Provide the current register values.
+    dictionary["$ebp"] = last_frame->context.ebp;
+    dictionary["$esp"] = last_frame->context.esp;
+    if (last_frame->context_validity & StackFrameX86::CONTEXT_VALID_EBX)
+      dictionary["$ebx"] = last_frame->context.ebx;
+    // Provide constants from the debug info for last_frame and its callee.
+    // .cbCalleeParams is a Breakpad extension that allows us to use the
+    // PostfixEvaluator engine when certain types of debugging information
+    // are present without having to write the constants into the program
+    // string as literals.
+    dictionary[".cbCalleeParams"] = last_frame_callee_parameter_size;
+    dictionary[".cbSavedRegs"] = last_frame_info->saved_register_size;
+    dictionary[".cbLocals"] = last_frame_info->local_size;
+    dictionary[".cbParams"] = last_frame_info->parameter_size;
+    // The difference between raSearch and raSearchStart is unknown,
+    // but making them the same seems to work well in practice.
+    dictionary[".raSearchStart"] = raSearchStart;
+    dictionary[".raSearch"] = raSearchStart;
+
+    // Now crank it out, making sure that the program string set at least
+    // the two required variables.
+    PostfixEvaluator<uint32_t> evaluator =
+        PostfixEvaluator<uint32_t>(&dictionary, memory_);
+    PostfixEvaluator<uint32_t>::DictionaryValidityType dictionary_validity;
+    evaluated = evaluator.Evaluate(program, &dictionary_validity) &&
+                dictionary_validity.find("$eip") != dictionary_validity.end() &&
+                dictionary_validity.find("$esp") != dictionary_validity.end();
+
+    caller_eip = dictionary["$eip"];
+    caller_esp = dictionary["$esp"];
+    caller_ebp = dictionary["$ebp"];
+    // These are nonvolatile (callee-save) registers, and the program string
+    // may have filled them in.
+    if (dictionary_validity.find("$ebx") != dictionary_validity.end()) {
+      caller_ebx = dictionary["$ebx"];
+      caller_validity |= StackFrameX86::CONTEXT_VALID_EBX;
+    }
+    if (dictionary_validity.find("$esi") != dictionary_validity.end()) {
+      caller_esi = dictionary["$esi"];
+      caller_validity |= StackFrameX86::CONTEXT_VALID_ESI;
+    }
+    if (dictionary_validity.find("$edi") != dictionary_validity.end()) {
+      caller_edi = dictionary["$edi"];
+      caller_validity |= StackFrameX86::CONTEXT_VALID_EDI;
+    }
   } else if (last_frame_info->allocates_base_pointer) {
     // The function corresponding to the last frame doesn't use the frame
     // pointer for conventional purposes, but it does allocate a new
@@ -319,14 +382,23 @@ StackFrameX86* StackwalkerX86::GetCallerByWindowsFrameInfo(
     // least, save %ebp.  For this reason, in addition to those given above
     // about the use of .raSearchStart, the stack may need to be scanned
     // for a better return address and a better frame pointer after the
-    // program string is evaluated.
+    // rules are applied.
     //
     // %eip_new = *(%esp_old + callee_params + saved_regs + locals)
     // %ebp_new = *(%esp_old + callee_params + saved_regs - 8)
     // %esp_new = %esp_old + callee_params + saved_regs + locals + 4
-    program_string = "$eip .raSearchStart ^ = "
-        "$ebp $esp .cbCalleeParams + .cbSavedRegs + 8 - ^ = "
-        "$esp .raSearchStart 4 + =";
+    uint32_t saved_ebp;
+    evaluated =
+        memory_->GetMemoryAtAddress(raSearchStart, &caller_eip) &&
+        memory_->GetMemoryAtAddress(last_frame->context.esp +
+                                        last_frame_callee_parameter_size +
+                                        last_frame_info->saved_register_size -
+                                        8,
+                                    &saved_ebp);
+    if (evaluated) {
+      caller_ebp = saved_ebp;
+      caller_esp = raSearchStart + 4;
+    }
   } else {
     // The function corresponding to the last frame doesn't use %ebp at
     // all.  The callee frame is located relative to %esp.
@@ -340,8 +412,8 @@ StackFrameX86* StackwalkerX86::GetCallerByWindowsFrameInfo(
     // straight through without bringing its validity into question.
     //
     // Because of the use of .raSearchStart, the stack will possibly be
-    // examined to locate a better return address after program string
-    // evaluation.  The stack will not be examined to locate a saved
+    // examined to locate a better return address after the rules are
+    // applied.  The stack will not be examined to locate a saved
     // %ebp value, because these frames do not save (or use) %ebp.
     //
     // We also propagate %ebx through, as it is commonly unmodifed after
@@ -353,42 +425,18 @@ StackFrameX86* StackwalkerX86::GetCallerByWindowsFrameInfo(
     // %esp_new = %esp_old + callee_params + saved_regs + locals + 4
     // %ebp_new = %ebp_old
     // %ebx_new = %ebx_old  // If available.
-    program_string = "$eip .raSearchStart ^ = "
-                     "$esp .raSearchStart 4 + =";
-    if (last_frame->context_validity & StackFrameX86::CONTEXT_VALID_EBX)
-      program_string += " $ebx $ebx =";
+    evaluated = memory_->GetMemoryAtAddress(raSearchStart, &caller_eip);
+    if (evaluated) {
+      caller_esp = raSearchStart + 4;
+      if (last_frame->context_validity & StackFrameX86::CONTEXT_VALID_EBX) {
+        caller_ebx = last_frame->context.ebx;
+        caller_validity |= StackFrameX86::CONTEXT_VALID_EBX;
+      }
+    }
     recover_ebp = false;
   }
 
-  // Check for alignment operators in the program string.  If alignment
-  // operators are found, then current %ebp must be valid and it is the only
-  // reliable data point that can be used for getting to the previous frame.
-  // E.g. the .raSearchStart calculation (above) is based on %esp and since
-  // %esp was aligned in the current frame (which is a lossy operation) the
-  // calculated value of .raSearchStart cannot be correct and should not be
-  // used.  Instead .raSearchStart must be calculated based on %ebp.
-  // The code that follows assumes that .raSearchStart is supposed to point
-  // at the saved return address (ebp + 4).
-  // For some more details on this topic, take a look at the following thread:
-  // https://groups.google.com/forum/#!topic/google-breakpad-dev/ZP1FA9B1JjM
-  if ((StackFrameX86::CONTEXT_VALID_EBP & last_frame->context_validity) != 0 &&
-      program_string.find('@') != string::npos) {
-    raSearchStart = last_frame->context.ebp + 4;
-  }
-
-  // The difference between raSearch and raSearchStart is unknown,
-  // but making them the same seems to work well in practice.
-  dictionary[".raSearchStart"] = raSearchStart;
-  dictionary[".raSearch"] = raSearchStart;
-
-  // Now crank it out, making sure that the program string set at least the
-  // two required variables.
-  PostfixEvaluator<uint32_t> evaluator =
-      PostfixEvaluator<uint32_t>(&dictionary, memory_);
-  PostfixEvaluator<uint32_t>::DictionaryValidityType dictionary_validity;
-  if (!evaluator.Evaluate(program_string, &dictionary_validity) ||
-      dictionary_validity.find("$eip") == dictionary_validity.end() ||
-      dictionary_validity.find("$esp") == dictionary_validity.end()) {
+  if (!evaluated) {
     // Program string evaluation failed. It may be that %eip is not somewhere
     // with stack frame info, and %ebp is pointing to non-stack memory, so
     // our evaluation couldn't succeed. We'll scan the stack for a return
@@ -409,8 +457,8 @@ StackFrameX86* StackwalkerX86::GetCallerByWindowsFrameInfo(
     // This seems like a reasonable return address. Since program string
     // evaluation failed, use it and set %esp to the location above the
     // one where the return address was found.
-    dictionary["$eip"] = eip;
-    dictionary["$esp"] = location + 4;
+    caller_eip = eip;
+    caller_esp = location + 4;
     trust = StackFrame::FRAME_TRUST_SCAN;
   }
 
@@ -421,7 +469,7 @@ StackFrameX86* StackwalkerX86::GetCallerByWindowsFrameInfo(
   // However, if program string evaluation resulted in both %eip and
   // %ebp values of 0, trust that the end of the stack has been
   // reached and don't scan for anything else.
-  if (dictionary["$eip"] != 0 || dictionary["$ebp"] != 0) {
+  if (caller_eip != 0 || caller_ebp != 0) {
     int offset = 0;
 
     // This scan can only be done if a CodeModules object is available, to
@@ -436,11 +484,11 @@ StackFrameX86* StackwalkerX86::GetCallerByWindowsFrameInfo(
     // ability, older OSes (pre-XP SP2) and CPUs (pre-P4) don't enforce
     // an independent execute privilege on memory pages.
 
-    uint32_t eip = dictionary["$eip"];
+    uint32_t eip = caller_eip;
     if (modules_ && !modules_->GetModuleForAddress(eip)) {
       // The instruction pointer at .raSearchStart was invalid, so start
       // looking one 32-bit word above that location.
-      uint32_t location_start = dictionary[".raSearchStart"] + 4;
+      uint32_t location_start = raSearchStart + 4;
       uint32_t location;
       if (stack_scan_allowed &&
           ScanForReturnAddress(location_start, &location, &eip,
@@ -449,8 +497,8 @@ StackFrameX86* StackwalkerX86::GetCallerByWindowsFrameInfo(
         // This is a better return address that what program string
         // evaluation found.  Use it, and set %esp to the location above the
         // one where the return address was found.
-        dictionary["$eip"] = eip;
-        dictionary["$esp"] = location + 4;
+        caller_eip = eip;
+        caller_esp = location + 4;
         offset = location - location_start;
         trust = StackFrame::FRAME_TRUST_CFI_SCAN;
       }
@@ -464,7 +512,7 @@ StackFrameX86* StackwalkerX86::GetCallerByWindowsFrameInfo(
       // stack.  The scan is performed from the highest possible address to
       // the lowest, because the expectation is that the function's prolog
       // would have saved %ebp early.
-      uint32_t ebp = dictionary["$ebp"];
+      uint32_t ebp = caller_ebp;
 
       // When a scan for return address is used, it is possible to skip one or
       // more frames (when return address is not in a known module).  One
@@ -488,7 +536,7 @@ StackFrameX86* StackwalkerX86::GetCallerByWindowsFrameInfo(
           if (memory_->GetMemoryAtAddress(ebp, &value)) {
             // The candidate value is a pointer to the same memory region
             // (the stack).  Prefer it as a recovered %ebp result.
-            dictionary["$ebp"] = ebp;
+            caller_ebp = ebp;
             break;
           }
         }
@@ -502,27 +550,19 @@ StackFrameX86* StackwalkerX86::GetCallerByWindowsFrameInfo(
 
   frame->trust = trust;
   frame->context = last_frame->context;
-  frame->context.eip = dictionary["$eip"];
-  frame->context.esp = dictionary["$esp"];
-  frame->context.ebp = dictionary["$ebp"];
+  frame->context.eip = caller_eip;
+  frame->context.esp = caller_esp;
+  frame->context.ebp = caller_ebp;
   frame->context_validity = StackFrameX86::CONTEXT_VALID_EIP |
                                 StackFrameX86::CONTEXT_VALID_ESP |
-                                StackFrameX86::CONTEXT_VALID_EBP;
-
-  // These are nonvolatile (callee-save) registers, and the program string
-  // may have filled them in.
-  if (dictionary_validity.find("$ebx") != dictionary_validity.end()) {
-    frame->context.ebx = dictionary["$ebx"];
-    frame->context_validity |= StackFrameX86::CONTEXT_VALID_EBX;
-  }
-  if (dictionary_validity.find("$esi") != dictionary_validity.end()) {
-    frame->context.esi = dictionary["$esi"];
-    frame->context_validity |= StackFrameX86::CONTEXT_VALID_ESI;
-  }
-  if (dictionary_validity.find("$edi") != dictionary_validity.end()) {
-    frame->context.edi = dictionary["$edi"];
-    frame->context_validity |= StackFrameX86::CONTEXT_VALID_EDI;
-  }
+                                StackFrameX86::CONTEXT_VALID_EBP |
+                                caller_validity;
+  if (caller_validity & StackFrameX86::CONTEXT_VALID_EBX)
+    frame->context.ebx = caller_ebx;
+  if (caller_validity & StackFrameX86::CONTEXT_VALID_ESI)
+    frame->context.esi = caller_esi;
+  if (caller_validity & StackFrameX86::CONTEXT_VALID_EDI)
+    frame->context.edi = caller_edi;
 
   return frame;
 }
@@ -591,8 +631,11 @@ StackFrameX86* StackwalkerX86::GetCallerByEBPAtBase(
 
   uint32_t caller_eip, caller_esp, caller_ebp;
 
-  if (memory_->GetMemoryAtAddress(last_ebp + 4, &caller_eip) &&
-      memory_->GetMemoryAtAddress(last_ebp, &caller_ebp)) {
+  // The saved %ebp and return address are read together.
+  uint32_t saved_words[2];
+  if (memory_->GetMemoryRangeAtAddress(last_ebp, 2, saved_words)) {
+    caller_ebp = saved_words[0];
+    caller_eip = saved_words[1];
     caller_esp = last_ebp + 8;
     trust = StackFrame::FRAME_TRUST_FP;
   } else {
@@ -56,68 +56,53 @@ StaticMap<Key, Value, Compare>::StaticMap(const char* raw_data)
       raw_data_ + (1 + num_nodes_) * sizeof(uint64_t));
 }
 
-// find(), lower_bound() and upper_bound() implement binary search algorithm.
+// find(), lower_bound() and upper_bound() share one binary search over the
+// key array, which is contiguous in the serialized data.
+template<typename Key, typename Value, typename Compare>
+int64_t StaticMap<Key, Value, Compare>::LowerBoundIndex(const Key& key) const {
+  if (num_nodes_ <= 0)
+    return 0;
+  // The loop has no data-dependent branch: each step picks the lower or
+  // upper half with a conditional move, so the processor never mispredicts
+  // it. Both keys that the next step might probe are prefetched, as on a
+  // large map every probe would otherwise be a cache miss.
+  const Key* base = keys_;
+  int64_t length = num_nodes_;
+  while (length > 1) {
+    int64_t half = length / 2;
+#if defined(__GNUC__)
+    __builtin_prefetch(base + half / 2);
+    __builtin_prefetch(base + half + half / 2);
+#endif
+    base = compare_(base[half], key) < 0 ? base + half : base;
+    length -= half;
+  }
+  return (base - keys_) + (compare_(*base, key) < 0 ? 1 : 0);
+}
+
 template<typename Key, typename Value, typename Compare>
 StaticMapIterator<Key, Value, Compare>
 StaticMap<Key, Value, Compare>::find(const Key& key) const {
-  int64_t begin = 0;
-  int64_t end = num_nodes_;
-  int64_t middle;
-  int64_t compare_result;
-  while (begin < end) {
-    middle = begin + (end - begin) / 2;
-    compare_result = compare_(key, GetKeyAtIndex(middle));
-    if (compare_result == 0)
-      return IteratorAtIndex(middle);
-    if (compare_result < 0) {
-      end = middle;
-    } else {
-      begin = middle + 1;
-    }
-  }
+  int64_t index = LowerBoundIndex(key);
+  if (index < num_nodes_ && compare_(key, keys_[index]) == 0)
+    return IteratorAtIndex(index);
   return this->end();
 }
 
 template<typename Key, typename Value, typename Compare>
 StaticMapIterator<Key, Value, Compare>
 StaticMap<Key, Value, Compare>::lower_bound(const Key& key) const {
-  int64_t begin = 0;
-  int64_t end = num_nodes_;
-  int64_t middle;
-  int64_t comp_result;
-  while (begin < end) {
-    middle = begin + (end - begin) / 2;
-    comp_result = compare_(key, GetKeyAtIndex(middle));
-    if (comp_result == 0)
-      return IteratorAtIndex(middle);
-    if (comp_result < 0) {
-      end = middle;
-    } else {
-      begin = middle + 1;
-    }
-  }
-  return IteratorAtIndex(begin);
+  return IteratorAtIndex(LowerBoundIndex(key));
 }
 
 template<typename Key, typename Value, typename Compare>
 StaticMapIterator<Key, Value, Compare>
 StaticMap<Key, Value, Compare>::upper_bound(const Key& key) const {
-  int64_t begin = 0;
-  int64_t end = num_nodes_;
-  int64_t middle;
-  int64_t compare_result;
-  while (begin < end) {
-    middle = begin + (end - begin) / 2;
-    compare_result = compare_(key, GetKeyAtIndex(middle));
-    if (compare_result == 0)
-      return IteratorAtIndex(middle + 1);
-    if (compare_result < 0) {
-      end = middle;
-    } else {
-      begin = middle + 1;
-    }
-  }
-  return IteratorAtIndex(begin);
+  // Keys are unique, so at most one is equal to |key|.
+  int64_t index = LowerBoundIndex(key);
+  if (index < num_nodes_ && compare_(key, keys_[index]) == 0)
+    ++index;
+  return IteratorAtIndex(index);
 }
 
 template<typename Key, typename Value, typename Compare>
@@ -119,6 +119,10 @@ class StaticMap {
  private:
   const Key GetKeyAtIndex(int64_t i) const;
 
+  // The index of the first key not less than |key|, or num_nodes_ if there
+  // is none.
+  int64_t LowerBoundIndex(const Key& key) const;
+
   // Start address of a raw memory chunk with serialized data.
   const char* raw_data_;
 
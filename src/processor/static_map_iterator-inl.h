@@ -45,6 +45,13 @@ template<typename Key, typename Value, typename Compare>
 StaticMapIterator<Key, Value, Compare>::StaticMapIterator(const char* base,
                                                           int64_t index):
       index_(index), base_(base) {
+  // A default-constructed StaticMap has no data, and behaves as empty.
+  if (!base_) {
+    num_nodes_ = 0;
+    offsets_ = NULL;
+    keys_ = NULL;
+    return;
+  }
   // See static_map.h for documentation on
   // bytes format of serialized StaticMap data.
   num_nodes_ = *(reinterpret_cast<const int64_t*>(base_));
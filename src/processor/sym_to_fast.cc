@@ -0,0 +1,309 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// sym_to_fast.cc: Convert the .sym files in a symbol store into modules
+// serialized for FastSourceLineResolver, written next to each symbol file
+// with kSerializedBreakpadFileExtension appended to its name.
+// SimpleSymbolSupplier picks these up when set to prefer serialized symbols.
+// With -i, it instead writes an index of each symbol file, with
+// kSymbolFileIndexExtension appended to its name, for
+// BasicSourceLineResolver::LoadModuleUsingIndexedFile.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/path_helper.h"
+#include "common/scoped_ptr.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/fast_source_line_resolver.h"
+#include "processor/logging.h"
+#include "processor/module_serializer.h"
+#include "processor/symbol_file_index.h"
+
+namespace {
+
+using google_breakpad::kSerializedBreakpadFileExtension;
+using google_breakpad::kSymbolFileIndexExtension;
+using google_breakpad::ModuleSerializer;
+using google_breakpad::scoped_array;
+using google_breakpad::SourceLineResolverBase;
+using google_breakpad::SymbolFileIndex;
+using std::vector;
+
+struct Options {
+  Options() : force(false), index(false), jobs(0) {}
+
+  bool force;
+  bool index;
+  int jobs;
+  vector<string> paths;
+};
+
+enum ConvertResult {
+  CONVERTED,
+  UP_TO_DATE,
+  FAILED
+};
+
+static bool EndsWith(const string& str, const string& suffix) {
+  return str.size() >= suffix.size() &&
+         str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Appends the .sym files found under path to symbol_files.
+static void FindSymbolFiles(const string& path, vector<string>* symbol_files) {
+  struct stat path_stat;
+  if (stat(path.c_str(), &path_stat) != 0) {
+    BPLOG(ERROR) << "Could not stat " << path;
+    return;
+  }
+  if (!S_ISDIR(path_stat.st_mode)) {
+    if (EndsWith(path, ".sym"))
+      symbol_files->push_back(path);
+    return;
+  }
+
+  DIR* dir = opendir(path.c_str());
+  if (!dir) {
+    BPLOG(ERROR) << "Could not open directory " << path;
+    return;
+  }
+  dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+      continue;
+    FindSymbolFiles(path + "/" + entry->d_name, symbol_files);
+  }
+  closedir(dir);
+}
+
+// Writes data to output_file through a temporary file renamed into place,
+// so that readers never see a partially written file.
+static bool WriteOutputFile(const string& output_file, const char* data,
+                            size_t size) {
+  char temp_suffix[32];
+  snprintf(temp_suffix, sizeof(temp_suffix), ".tmp.%d", getpid());
+  string temp_file = output_file + temp_suffix;
+  FILE* file = fopen(temp_file.c_str(), "wb");
+  if (!file) {
+    BPLOG(ERROR) << "Could not create " << temp_file;
+    return false;
+  }
+  bool written = fwrite(data, 1, size, file) == size;
+  if (fclose(file) != 0)
+    written = false;
+  if (!written || rename(temp_file.c_str(), output_file.c_str()) != 0) {
+    BPLOG(ERROR) << "Could not write " << output_file;
+    unlink(temp_file.c_str());
+    return false;
+  }
+  return true;
+}
+
+static ConvertResult ConvertSymbolFile(const string& symbol_file,
+                                       const Options& options) {
+  string output_file = symbol_file + (options.index ?
+      kSymbolFileIndexExtension : kSerializedBreakpadFileExtension);
+
+  struct stat symbol_stat;
+  struct stat output_stat;
+  if (!options.force && stat(symbol_file.c_str(), &symbol_stat) == 0 &&
+      stat(output_file.c_str(), &output_stat) == 0 &&
+      output_stat.st_mtime >= symbol_stat.st_mtime) {
+    return UP_TO_DATE;
+  }
+
+  char* symbol_data;
+  size_t symbol_data_size;
+  if (!SourceLineResolverBase::ReadSymbolFile(symbol_file, &symbol_data,
+                                              &symbol_data_size)) {
+    return FAILED;
+  }
+  scoped_array<char> symbol_data_owner(symbol_data);
+
+  if (options.index) {
+    // ReadSymbolFile() null-terminates the data it reads.
+    SymbolFileIndex index;
+    if (!index.Build(symbol_data, symbol_data_size - 1)) {
+      BPLOG(ERROR) << "Could not index " << symbol_file;
+      return FAILED;
+    }
+    string index_data = index.Serialize();
+    return WriteOutputFile(output_file, index_data.data(), index_data.size())
+        ? CONVERTED : FAILED;
+  }
+
+  ModuleSerializer serializer;
+  size_t serialized_size;
+  scoped_array<char> serialized(serializer.SerializeSymbolFileData(
+      symbol_data, symbol_data_size, &serialized_size));
+  if (!serialized.get()) {
+    BPLOG(ERROR) << "Could not convert " << symbol_file;
+    return FAILED;
+  }
+  symbol_data_owner.reset();
+
+  return WriteOutputFile(output_file, serialized.get(), serialized_size)
+      ? CONVERTED : FAILED;
+}
+
+static bool ConvertSymbolFiles(const Options& options) {
+  vector<string> symbol_files;
+  for (size_t i = 0; i < options.paths.size(); ++i) {
+    FindSymbolFiles(options.paths[i], &symbol_files);
+  }
+
+  std::atomic<size_t> next_file(0);
+  std::atomic<int> converted(0);
+  std::atomic<int> up_to_date(0);
+  std::atomic<int> failed(0);
+  auto convert = [&]() {
+    size_t index;
+    while ((index = next_file++) < symbol_files.size()) {
+      switch (ConvertSymbolFile(symbol_files[index], options)) {
+        case CONVERTED:
+          ++converted;
+          break;
+        case UP_TO_DATE:
+          ++up_to_date;
+          break;
+        case FAILED:
+          ++failed;
+          break;
+      }
+    }
+  };
+
+  int jobs = options.jobs;
+  if (jobs <= 0)
+    jobs = std::max(1U, std::thread::hardware_concurrency());
+  if (static_cast<size_t>(jobs) > symbol_files.size())
+    jobs = std::max(static_cast<size_t>(1), symbol_files.size());
+
+  vector<std::thread> workers;
+  for (int i = 1; i < jobs; ++i) {
+    workers.push_back(std::thread(convert));
+  }
+  convert();
+  for (size_t i = 0; i < workers.size(); ++i) {
+    workers[i].join();
+  }
+
+  printf("%d converted, %d up to date, %d failed\n",
+         converted.load(), up_to_date.load(), failed.load());
+  return failed == 0;
+}
+
+//=============================================================================
+static void
+Usage(int argc, char* argv[], bool error) {
+  FILE* fp = error ? stderr : stdout;
+
+  fprintf(fp,
+          "Usage: %s [options...] <symbol-path> [<symbol-path> ...]\n"
+          "Convert symbol files to the format loaded by "
+          "FastSourceLineResolver.\n"
+          "\n"
+          "Options:\n"
+          "  <symbol-path> is a .sym file, or a directory searched for\n"
+          "  .sym files.  Each is converted to a file of the same name\n"
+          "  with %s appended.\n"
+          "  -f:\t Convert files even if they are up to date\n"
+          "  -i:\t Write an index of each file, with %s appended to\n"
+          "     \t its name, instead of converting it\n"
+          "  -j <n>:\t Convert n files at a time (default: one per CPU)\n"
+          "  -h:\t Usage\n",
+          google_breakpad::BaseName(argv[0]).c_str(),
+          kSerializedBreakpadFileExtension, kSymbolFileIndexExtension);
+}
+
+//=============================================================================
+static void
+SetupOptions(int argc, char* argv[], Options* options) {
+  int ch;
+
+  while ((ch = getopt(argc, (char* const*)argv, "fhij:")) != -1) {
+    switch (ch) {
+      case 'f':
+        options->force = true;
+        break;
+      case 'h':
+        Usage(argc, argv, false);
+        exit(0);
+        break;
+      case 'i':
+        options->index = true;
+        break;
+      case 'j':
+        options->jobs = atoi(optarg);
+        if (options->jobs < 1) {
+          fprintf(stderr, "%s: Invalid job count: %s\n", argv[0], optarg);
+          exit(1);
+        }
+        break;
+
+      default:
+        Usage(argc, argv, true);
+        exit(1);
+        break;
+    }
+  }
+
+  if ((argc - optind) < 1) {
+    fprintf(stderr, "%s: Missing symbol path\n", argv[0]);
+    Usage(argc, argv, true);
+    exit(1);
+  }
+
+  for (int i = optind; i < argc; ++i) {
+    options->paths.push_back(argv[i]);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Options options;
+  BPLOG_INIT(&argc, &argv);
+  SetupOptions(argc, argv, &options);
+  return ConvertSymbolFiles(options) ? 0 : 1;
+}
@@ -0,0 +1,298 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// symbol_buffer.cc: The symbol data of one module, shared by reference.
+//
+// See symbol_buffer.h for documentation.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "google_breakpad/processor/symbol_buffer.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/vfs.h>
+#endif
+
+#include <vector>
+
+#include "processor/logging.h"
+
+namespace google_breakpad {
+
+namespace {
+
+#if defined(__linux__)
+// The f_type statfs reports for hugetlbfs, from <linux/magic.h>.
+const long kHugetlbfsMagic = 0x958458f6;
+
+// Returns how many bytes of the mapping starting at start are backed by
+// huge pages, according to /proc/self/smaps.
+size_t HugePageBytes(uintptr_t start) {
+  FILE* smaps = fopen("/proc/self/smaps", "r");
+  if (!smaps)
+    return 0;
+  size_t kilobytes = 0;
+  bool in_mapping = false;
+  char line[512];
+  while (fgets(line, sizeof(line), smaps)) {
+    unsigned long low, high;
+    if (sscanf(line, "%lx-%lx ", &low, &high) == 2) {
+      if (in_mapping)
+        break;
+      in_mapping = low == start;
+      continue;
+    }
+    if (!in_mapping)
+      continue;
+    static const char* const kHugePageFields[] = {
+      "AnonHugePages:", "FilePmdMapped:", "ShmemPmdMapped:",
+      "Private_Hugetlb:", "Shared_Hugetlb:"
+    };
+    for (const char* field : kHugePageFields) {
+      size_t length = strlen(field);
+      unsigned long field_kilobytes;
+      if (strncmp(line, field, length) == 0 &&
+          sscanf(line + length, "%lu", &field_kilobytes) == 1) {
+        kilobytes += field_kilobytes;
+      }
+    }
+  }
+  fclose(smaps);
+  return kilobytes * 1024;
+}
+#endif  // __linux__
+
+}  // namespace
+
+const size_t SymbolBuffer::kHugePageSize;
+
+SymbolBuffer::SymbolBuffer(char* data, size_t size, Storage storage)
+    : data_(data),
+      size_(size),
+      storage_(storage),
+      mapping_size_(size),
+      huge_pages_(false) {}
+
+SymbolBuffer::~SymbolBuffer() {
+  switch (storage_) {
+    case STORAGE_ARRAY:
+      delete [] data_;
+      break;
+    case STORAGE_MAPPING:
+      munmap(data_, mapping_size_);
+      break;
+    case STORAGE_HUGE_PAGES:
+      // The guard page goes too.
+      munmap(data_, mapping_size_ + sysconf(_SC_PAGESIZE));
+      break;
+    case STORAGE_STRING:
+    case STORAGE_BORROWED:
+      break;
+  }
+}
+
+// static
+std::shared_ptr<SymbolBuffer> SymbolBuffer::AdoptArray(char* data,
+                                                       size_t size) {
+  return std::shared_ptr<SymbolBuffer>(
+      new SymbolBuffer(data, size, STORAGE_ARRAY));
+}
+
+// static
+std::shared_ptr<SymbolBuffer> SymbolBuffer::AdoptString(string* data) {
+  std::shared_ptr<SymbolBuffer> buffer(
+      new SymbolBuffer(NULL, 0, STORAGE_STRING));
+  buffer->string_.swap(*data);
+  // The string's own terminator is the buffer's last byte.
+  buffer->data_ = &buffer->string_[0];
+  buffer->size_ = buffer->string_.size() + 1;
+  return buffer;
+}
+
+// static
+std::shared_ptr<SymbolBuffer> SymbolBuffer::MapFile(const string& file_name) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd == -1) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(ERROR) << "Could not open " << file_name <<
+        ", error " << error_code << ": " << error_string;
+    return NULL;
+  }
+
+  struct stat buf;
+  if (fstat(fd, &buf) == -1) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(ERROR) << "Could not stat " << file_name <<
+        ", error " << error_code << ": " << error_string;
+    close(fd);
+    return NULL;
+  }
+  if (buf.st_size <= 0) {
+    BPLOG(ERROR) << "Could not map empty file " << file_name;
+    close(fd);
+    return NULL;
+  }
+
+  // A file on hugetlbfs is mapped in huge pages, which is as much of the
+  // mapping as can be unmapped.
+  bool huge_pages = false;
+  size_t mapping_size = buf.st_size;
+#if defined(__linux__)
+  struct statfs filesystem;
+  if (fstatfs(fd, &filesystem) == 0 &&
+      static_cast<long>(filesystem.f_type) == kHugetlbfsMagic) {
+    huge_pages = true;
+    mapping_size = (mapping_size + kHugePageSize - 1) & ~(kHugePageSize - 1);
+  }
+#endif
+
+  void* mapping = mmap(NULL, mapping_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE, fd, 0);
+  // The mapping stays valid once the descriptor is closed.
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(ERROR) << "Could not map " << file_name <<
+        ", error " << error_code << ": " << error_string;
+    return NULL;
+  }
+
+  std::shared_ptr<SymbolBuffer> buffer(new SymbolBuffer(
+      static_cast<char*>(mapping), buf.st_size, STORAGE_MAPPING));
+  buffer->mapping_size_ = mapping_size;
+  buffer->huge_pages_ = huge_pages;
+  return buffer;
+}
+
+// static
+std::shared_ptr<SymbolBuffer> SymbolBuffer::CopyToHugePages(
+    const std::shared_ptr<SymbolBuffer>& buffer) {
+  if (buffer->huge_pages_ || buffer->size_ == 0)
+    return buffer;
+
+  // Map whole huge pages, with room to align them, and a guard page after
+  // them.  Copies next to each other would otherwise be merged into one
+  // mapping, whose huge pages GetResidency() could not tell apart.
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t mapping_size =
+      (buffer->size_ + kHugePageSize - 1) & ~(kHugePageSize - 1);
+  size_t reserved_size = mapping_size + kHugePageSize + page_size;
+  void* reserved = mmap(NULL, reserved_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (reserved == MAP_FAILED) {
+    string error_string;
+    int error_code = ErrnoString(&error_string);
+    BPLOG(ERROR) << "Could not map " << reserved_size << " bytes for huge "
+                 << "pages, error " << error_code << ": " << error_string;
+    return buffer;
+  }
+
+  uintptr_t reserved_start = reinterpret_cast<uintptr_t>(reserved);
+  uintptr_t reserved_end = reserved_start + reserved_size;
+  uintptr_t start = (reserved_start + kHugePageSize - 1) &
+                    ~static_cast<uintptr_t>(kHugePageSize - 1);
+  uintptr_t end = start + mapping_size + page_size;
+  if (start > reserved_start)
+    munmap(reserved, start - reserved_start);
+  if (reserved_end > end)
+    munmap(reinterpret_cast<void*>(end), reserved_end - end);
+
+  char* data = reinterpret_cast<char*>(start);
+  mprotect(data + mapping_size, page_size, PROT_NONE);
+#if defined(MADV_HUGEPAGE)
+  madvise(data, mapping_size, MADV_HUGEPAGE);
+#endif
+  memcpy(data, buffer->data_, buffer->size_);
+
+  std::shared_ptr<SymbolBuffer> copy(
+      new SymbolBuffer(data, buffer->size_, STORAGE_HUGE_PAGES));
+  copy->mapping_size_ = mapping_size;
+  copy->huge_pages_ = true;
+  return copy;
+}
+
+void SymbolBuffer::GetResidency(size_t* resident_size,
+                                size_t* huge_page_count) const {
+  *resident_size = 0;
+  *huge_page_count = 0;
+  if (!data_ || size_ == 0)
+    return;
+
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  uintptr_t start = reinterpret_cast<uintptr_t>(data_) &
+                    ~static_cast<uintptr_t>(page_size - 1);
+  uintptr_t end = reinterpret_cast<uintptr_t>(data_) + size_;
+  size_t page_count = (end - start + page_size - 1) / page_size;
+#if defined(__APPLE__)
+  std::vector<char> residency(page_count);
+#else
+  std::vector<unsigned char> residency(page_count);
+#endif
+  if (mincore(reinterpret_cast<void*>(start), end - start,
+              residency.data()) == 0) {
+    for (size_t i = 0; i < page_count; ++i) {
+      if (residency[i] & 1)
+        *resident_size += page_size;
+    }
+    if (*resident_size > size_)
+      *resident_size = size_;
+  }
+
+#if defined(__linux__)
+  if (storage_ == STORAGE_MAPPING || storage_ == STORAGE_HUGE_PAGES) {
+    *huge_page_count =
+        HugePageBytes(reinterpret_cast<uintptr_t>(data_)) / kHugePageSize;
+  }
+#endif
+}
+
+void SymbolBuffer::AdviseSequential() const {
+  if (storage_ == STORAGE_MAPPING)
+    madvise(data_, size_, MADV_SEQUENTIAL);
+}
+
+// static
+std::shared_ptr<SymbolBuffer> SymbolBuffer::Borrow(char* data, size_t size) {
+  return std::shared_ptr<SymbolBuffer>(
+      new SymbolBuffer(data, size, STORAGE_BORROWED));
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,276 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// symbol_file_index.cc: An index of the FUNC and STACK CFI INIT records in
+// a symbol file.
+//
+// See symbol_file_index.h for documentation.
+
+// For <inttypes.h> PRI* macros, before anything else might #include it.
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif  /* __STDC_FORMAT_MACROS */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "processor/symbol_file_index.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#include "processor/logging.h"
+
+namespace google_breakpad {
+
+const char kSymbolFileIndexExtension[] = ".index";
+
+namespace {
+
+bool StartsWith(const char* line, size_t length, const char* prefix) {
+  size_t prefix_length = strlen(prefix);
+  return length >= prefix_length && memcmp(line, prefix, prefix_length) == 0;
+}
+
+// Returns true if the line is empty but for a carriage return.
+bool IsBlank(const char* line, size_t length) {
+  return length == 0 || (length == 1 && line[0] == '\r');
+}
+
+// Returns true if the line is a line record, which like the other records
+// BasicSourceLineResolver parses, is any line not starting with a keyword.
+bool IsLineRecord(const char* line, size_t length) {
+  static const char* const kKeywords[] = {
+    "FILE ", "FUNC ", "INFO ", "INLINE ", "INLINE_ORIGIN ", "MODULE ",
+    "PUBLIC ", "STACK "
+  };
+  for (size_t i = 0; i < sizeof(kKeywords) / sizeof(kKeywords[0]); ++i) {
+    if (StartsWith(line, length, kKeywords[i]))
+      return false;
+  }
+  return !IsBlank(line, length);
+}
+
+// Parses the address and size following prefix at the start of line.
+bool ParseAddressAndSize(const char* line, size_t length, const char* prefix,
+                         uint64_t* address, uint64_t* size) {
+  // The numbers come well within the first 128 characters.
+  string start(line + strlen(prefix),
+               std::min<size_t>(length - strlen(prefix), 128));
+  const char* cursor = start.c_str();
+  if (strncmp(cursor, "m ", 2) == 0)
+    cursor += 2;
+  char* end;
+  *address = strtoull(cursor, &end, 16);
+  if (end == cursor || *end != ' ')
+    return false;
+  cursor = end;
+  *size = strtoull(cursor, &end, 16);
+  return end != cursor && (*end == ' ' || *end == '\r' || *end == '\0');
+}
+
+}  // namespace
+
+bool SymbolFileIndex::Build(const char* symbol_data, size_t symbol_data_size) {
+  symbol_file_size_ = symbol_data_size;
+  functions_.clear();
+  cfi_.clear();
+
+  // The block being extended, if any, and whether it is a FUNC block.
+  Block* block = NULL;
+  bool in_function = false;
+  size_t position = 0;
+  while (position < symbol_data_size) {
+    const char* line = symbol_data + position;
+    const char* newline = static_cast<const char*>(
+        memchr(line, '\n', symbol_data_size - position));
+    size_t length = newline ? newline - line : symbol_data_size - position;
+    size_t next = newline ? position + length + 1 : symbol_data_size;
+
+    bool continues = false;
+    if (block && IsBlank(line, length)) {
+      continues = true;
+    } else if (block && in_function) {
+      continues = StartsWith(line, length, "INLINE ") ||
+                  IsLineRecord(line, length);
+    } else if (block) {
+      continues = StartsWith(line, length, "STACK CFI ") &&
+                  !StartsWith(line, length, "STACK CFI INIT ");
+    }
+
+    if (continues) {
+      block->length = next - block->offset;
+    } else {
+      block = NULL;
+      Block new_block = { 0, 0, position, next - position };
+      if (StartsWith(line, length, "FUNC ") &&
+          ParseAddressAndSize(line, length, "FUNC ", &new_block.address,
+                              &new_block.size)) {
+        functions_.push_back(new_block);
+        block = &functions_.back();
+        in_function = true;
+      } else if (StartsWith(line, length, "STACK CFI INIT ") &&
+                 ParseAddressAndSize(line, length, "STACK CFI INIT ",
+                                     &new_block.address, &new_block.size)) {
+        cfi_.push_back(new_block);
+        block = &cfi_.back();
+        in_function = false;
+      } else if (StartsWith(line, length, "INLINE ") ||
+                 StartsWith(line, length, "STACK CFI ") ||
+                 IsLineRecord(line, length)) {
+        // A record parted from the record it belongs to by other records,
+        // which a block cannot hold.
+        BPLOG(ERROR) << "Cannot index symbol data with records out of place";
+        functions_.clear();
+        cfi_.clear();
+        return false;
+      }
+    }
+    position = next;
+  }
+  return true;
+}
+
+string SymbolFileIndex::Serialize() const {
+  string index_data;
+  char line[128];
+  snprintf(line, sizeof(line), "SYMINDEX %" PRIx64 "\n", symbol_file_size_);
+  index_data.append(line);
+
+  // Interleave the blocks in the order of the records.
+  size_t function = 0;
+  size_t cfi = 0;
+  while (function < functions_.size() || cfi < cfi_.size()) {
+    bool is_function =
+        cfi == cfi_.size() ||
+        (function < functions_.size() &&
+         functions_[function].offset < cfi_[cfi].offset);
+    const Block& block = is_function ? functions_[function++] : cfi_[cfi++];
+    snprintf(line, sizeof(line),
+             "%s %" PRIx64 " %" PRIx64 " %" PRIx64 " %" PRIx64 "\n",
+             is_function ? "FUNC" : "CFI", block.address, block.size,
+             block.offset, block.length);
+    index_data.append(line);
+  }
+  return index_data;
+}
+
+bool SymbolFileIndex::Parse(const string& index_data) {
+  symbol_file_size_ = 0;
+  functions_.clear();
+  cfi_.clear();
+
+  size_t position = 0;
+  bool have_header = false;
+  while (position < index_data.size()) {
+    size_t newline = index_data.find('\n', position);
+    if (newline == string::npos)
+      newline = index_data.size();
+    string line = index_data.substr(position, newline - position);
+    position = newline + 1;
+
+    if (!have_header) {
+      char extra;
+      if (sscanf(line.c_str(), "SYMINDEX %" SCNx64 " %c", &symbol_file_size_,
+                 &extra) != 1) {
+        return false;
+      }
+      have_header = true;
+      continue;
+    }
+
+    char kind[8];
+    Block block;
+    char extra;
+    if (sscanf(line.c_str(),
+               "%7s %" SCNx64 " %" SCNx64 " %" SCNx64 " %" SCNx64 " %c", kind,
+               &block.address, &block.size, &block.offset, &block.length,
+               &extra) != 5) {
+      return false;
+    }
+    if (block.offset > symbol_file_size_ ||
+        block.length > symbol_file_size_ - block.offset) {
+      return false;
+    }
+    if (strcmp(kind, "FUNC") == 0) {
+      functions_.push_back(block);
+    } else if (strcmp(kind, "CFI") == 0) {
+      cfi_.push_back(block);
+    } else {
+      return false;
+    }
+  }
+  if (!have_header)
+    return false;
+
+  // The blocks must not overlap one another.
+  std::vector<std::pair<uint64_t, uint64_t> > extents;
+  for (size_t i = 0; i < functions_.size(); ++i)
+    extents.push_back(std::make_pair(functions_[i].offset,
+                                     functions_[i].length));
+  for (size_t i = 0; i < cfi_.size(); ++i)
+    extents.push_back(std::make_pair(cfi_[i].offset, cfi_[i].length));
+  std::sort(extents.begin(), extents.end());
+  for (size_t i = 1; i < extents.size(); ++i) {
+    if (extents[i].first - extents[i - 1].first < extents[i - 1].second)
+      return false;
+  }
+  return true;
+}
+
+bool SymbolFileIndex::ReadFile(const string& index_file) {
+  std::ifstream in(index_file.c_str(), std::ios::binary);
+  if (!in)
+    return false;
+  string index_data((std::istreambuf_iterator<char>(in)),
+                    std::istreambuf_iterator<char>());
+  if (!Parse(index_data)) {
+    BPLOG(ERROR) << "Malformed symbol file index " << index_file;
+    return false;
+  }
+  return true;
+}
+
+uint64_t SymbolFileIndex::IndexedLength() const {
+  uint64_t length = 0;
+  for (size_t i = 0; i < functions_.size(); ++i)
+    length += functions_[i].length;
+  for (size_t i = 0; i < cfi_.size(); ++i)
+    length += cfi_[i].length;
+  return length;
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,119 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// symbol_file_index.h: An index of the FUNC and STACK CFI INIT records in
+// a symbol file.
+//
+// A SymbolFileIndex records where in a symbol file each FUNC record and
+// each STACK CFI INIT record lies, with the records that belong to it: the
+// line and INLINE records after a FUNC record, and the STACK CFI records
+// after a STACK CFI INIT record.  With it, BasicSourceLineResolver can
+// load a module by parsing everything else, and parse the functions and
+// CFI ranges only when they are looked up.  See
+// SourceLineResolverBase::LoadModuleUsingIndexedFile.
+//
+// The index is kept next to the symbol file, named like it with
+// kSymbolFileIndexExtension appended.  sym_to_fast -i writes it.  It is a
+// text file holding the size of the symbol file and one line per record,
+// in the order of the records in the symbol file, all numbers in
+// hexadecimal:
+//
+//   SYMINDEX <symbol file size>
+//   FUNC <address> <size> <offset> <length>
+//   CFI <address> <size> <offset> <length>
+//
+// where address and size are those of the record, and offset and length
+// give the bytes of the symbol file holding it and the records belonging
+// to it.
+
+#ifndef PROCESSOR_SYMBOL_FILE_INDEX_H__
+#define PROCESSOR_SYMBOL_FILE_INDEX_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "common/using_std_string.h"
+
+namespace google_breakpad {
+
+// Appended to the name of a symbol file to name its index.
+extern const char kSymbolFileIndexExtension[];
+
+class SymbolFileIndex {
+ public:
+  // The bytes of the symbol file holding a record and the records that
+  // belong to it.
+  struct Block {
+    uint64_t address;
+    uint64_t size;
+    uint64_t offset;
+    uint64_t length;
+  };
+
+  SymbolFileIndex() : symbol_file_size_(0) {}
+
+  // Indexes the symbol file contents in symbol_data, replacing any blocks
+  // indexed before.  Returns false, leaving no blocks, if a line, INLINE
+  // or STACK CFI record is parted from the FUNC or STACK CFI INIT record it
+  // belongs to by other records.  dump_syms never writes such files.
+  bool Build(const char* symbol_data, size_t symbol_data_size);
+
+  // Returns the index in the text form described above.
+  string Serialize() const;
+
+  // Reads the text form of an index.  Returns false if index_data is not
+  // a well-formed index.
+  bool Parse(const string& index_data);
+
+  // Reads and parses the index in index_file.
+  bool ReadFile(const string& index_file);
+
+  uint64_t symbol_file_size() const { return symbol_file_size_; }
+
+  // The FUNC blocks, in the order of the records in the symbol file.
+  const std::vector<Block>& functions() const { return functions_; }
+
+  // The STACK CFI INIT blocks, in the order of the records in the symbol
+  // file.
+  const std::vector<Block>& cfi() const { return cfi_; }
+
+  // Returns the total length of the blocks.
+  uint64_t IndexedLength() const;
+
+ private:
+  uint64_t symbol_file_size_;
+  std::vector<Block> functions_;
+  std::vector<Block> cfi_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_SYMBOL_FILE_INDEX_H__
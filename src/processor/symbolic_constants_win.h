@@ -36,13 +36,19 @@
 #define GOOGLE_BREAKPAD_PROCESSOR_SYMBOLIC_CONSTANTS_WIN_H_
 
 #include <string>
+#include <string_view>
 
 #include "common/using_std_string.h"
 #include "google_breakpad/common/breakpad_types.h"
 
 namespace google_breakpad {
 
-/* Converts a NTSTATUS code to a reason string. */
+/* Returns the name of a NTSTATUS code, or an empty string_view if the code
+ * is unknown.  The name is statically allocated. */
+std::string_view NTStatusName(uint32_t ntstatus);
+
+/* Converts a NTSTATUS code to a reason string: its name, or its value in
+ * hexadecimal if the code is unknown. */
 string NTStatusToString(uint32_t ntstatus);
 
 }  // namespace google_breakpad
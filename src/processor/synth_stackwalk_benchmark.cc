@@ -0,0 +1,479 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// synth_stackwalk_benchmark.cc: Time MinidumpProcessor::Process, phase by
+// phase, on large minidumps built with SynthMinidump.
+//
+// The benchmark builds an x86 minidump with a chosen number of threads,
+// stack depth and modules, and serves each module a generated symbol file
+// from memory, so that runs are comparable from machine to machine and
+// from change to change without a corpus of real minidumps.  Two variants
+// are walked:
+//
+//   cfi    every function has STACK CFI records, so each frame is found by
+//          call frame information
+//   scan   the symbol files have no STACK CFI records and the frame
+//          pointers are useless, so each frame is found by stack scanning
+//
+// For each variant, the minidump is processed once with no symbols loaded
+// ("cold"), and then -n more times ("warm"), of which the mean is reported.
+// The times of the phases and the frame and symbol lookup counts are those
+// of ProcessingStats.  The results are printed one per line as
+// tab-separated variant, metric, value and unit, so that they can be
+// collected and compared across runs.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/using_std_string.h"
+#include "google_breakpad/common/minidump_format.h"
+#include "google_breakpad/processor/basic_source_line_resolver.h"
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/minidump.h"
+#include "google_breakpad/processor/minidump_processor.h"
+#include "google_breakpad/processor/process_state.h"
+#include "google_breakpad/processor/processing_stats.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "google_breakpad/processor/symbol_supplier.h"
+#include "processor/synth_minidump.h"
+
+namespace {
+
+using google_breakpad::BasicSourceLineResolver;
+using google_breakpad::CodeModule;
+using google_breakpad::Minidump;
+using google_breakpad::MinidumpProcessor;
+using google_breakpad::ProcessingStats;
+using google_breakpad::ProcessState;
+using google_breakpad::StackFrame;
+using google_breakpad::SymbolSupplier;
+using google_breakpad::SystemInfo;
+using google_breakpad::test_assembler::kLittleEndian;
+using std::map;
+using std::unique_ptr;
+using std::vector;
+
+namespace synth = google_breakpad::SynthMinidump;
+
+// The shape of the synthetic minidump.
+struct Shape {
+  Shape() : threads(64), depth(64), modules(200), functions(1000) {}
+
+  int threads;
+  int depth;      // frames per thread
+  int modules;
+  int functions;  // per module
+};
+
+// The size of each synthetic function, and the offset of its code from the
+// start of its module.
+const uint32_t kFunctionSize = 0x40;
+const uint32_t kCodeOffset = 0x1000;
+
+// The stack space each frame takes, ending with the return address.
+const uint32_t kFrameSize = 0x40;
+
+// Where the modules and the thread stacks are placed.
+const uint32_t kModuleBase = 0x10000000;
+const uint32_t kStackBase = 0x01000000;
+const uint32_t kStackSpacing = 0x100000;
+
+uint32_t ModuleSize(const Shape& shape) {
+  uint32_t size = kCodeOffset + shape.functions * kFunctionSize;
+  return (size + 0xffff) & ~0xffff;
+}
+
+string ModuleName(int module) {
+  char name[64];
+  snprintf(name, sizeof(name), "c:\\synthetic\\module%d.dll", module);
+  return name;
+}
+
+// The instruction address of frame_index on the stack of thread_index:
+// somewhere in a function picked from the thread and frame indices, so
+// that stacks share modules and functions as real ones do.
+uint32_t FrameAddress(const Shape& shape, int thread_index, int frame_index) {
+  uint32_t hash = (thread_index * 2654435761u) ^ (frame_index * 40503u);
+  int module = hash % shape.modules;
+  int function = (hash / shape.modules) % shape.functions;
+  return kModuleBase + module * ModuleSize(shape) + kCodeOffset +
+         function * kFunctionSize + 0x10;
+}
+
+// Builds a minidump of shape's threads and modules.
+string MakeMinidump(const Shape& shape) {
+  synth::Dump dump(0, kLittleEndian);
+  synth::String csd_version(dump, "Service Pack 1");
+  synth::SystemInfo system_info(dump, synth::SystemInfo::windows_x86,
+                                csd_version);
+  dump.Add(&system_info);
+  dump.Add(&csd_version);
+
+  vector<unique_ptr<synth::String>> module_names;
+  vector<unique_ptr<synth::Module>> modules;
+  for (int m = 0; m < shape.modules; ++m) {
+    module_names.emplace_back(new synth::String(dump, ModuleName(m)));
+    modules.emplace_back(new synth::Module(dump,
+                                           kModuleBase + m * ModuleSize(shape),
+                                           ModuleSize(shape),
+                                           *module_names.back()));
+    dump.Add(modules.back().get());
+    dump.Add(module_names.back().get());
+  }
+
+  vector<unique_ptr<synth::Memory>> stacks;
+  vector<unique_ptr<synth::Context>> contexts;
+  vector<unique_ptr<synth::Thread>> threads;
+  for (int t = 0; t < shape.threads; ++t) {
+    uint32_t stack_address = kStackBase + t * kStackSpacing;
+    stacks.emplace_back(new synth::Memory(dump, stack_address));
+    synth::Memory* stack = stacks.back().get();
+    // Each frame's space holds values that are not code addresses, and
+    // then the return address into the next frame, or 0 after the last.
+    for (int f = 0; f < shape.depth; ++f) {
+      for (uint32_t word = 0; word < kFrameSize / 4 - 1; ++word)
+        stack->D32(word);
+      stack->D32(f + 1 < shape.depth ? FrameAddress(shape, t, f + 1) : 0);
+    }
+
+    MDRawContextX86 raw_context;
+    memset(&raw_context, 0, sizeof(raw_context));
+    raw_context.context_flags =
+        MD_CONTEXT_X86_INTEGER | MD_CONTEXT_X86_CONTROL;
+    raw_context.eip = FrameAddress(shape, t, 0);
+    raw_context.esp = stack_address;
+    contexts.emplace_back(new synth::Context(dump, raw_context));
+    threads.emplace_back(new synth::Thread(dump, 0x1000 + t, *stack,
+                                           *contexts.back()));
+    dump.Add(stack);
+    dump.Add(contexts.back().get());
+    dump.Add(threads.back().get());
+  }
+  dump.Finish();
+
+  string contents;
+  if (!dump.GetContents(&contents))
+    contents.clear();
+  return contents;
+}
+
+// Generates the symbol file of a module, with STACK CFI records if cfi is
+// true.
+string MakeSymbolFile(const Shape& shape, int module, bool cfi) {
+  char record[256];
+  snprintf(record, sizeof(record),
+           "MODULE windows x86 0000000000000000000000000000000%d module%d.pdb\n"
+           "FILE 0 module%d.cc\n", module % 10, module, module);
+  string data = record;
+  for (int f = 0; f < shape.functions; ++f) {
+    uint32_t address = kCodeOffset + f * kFunctionSize;
+    snprintf(record, sizeof(record),
+             "FUNC %x %x 0 synthetic::Module%d::Function%d()\n"
+             "%x %x %d 0\n",
+             address, kFunctionSize, module, f, address, kFunctionSize,
+             f + 1);
+    data += record;
+  }
+  if (cfi) {
+    for (int f = 0; f < shape.functions; ++f) {
+      snprintf(record, sizeof(record),
+               "STACK CFI INIT %x %x .cfa: $esp %u + .ra: .cfa 4 - ^\n",
+               kCodeOffset + f * kFunctionSize, kFunctionSize, kFrameSize);
+      data += record;
+    }
+  }
+  return data;
+}
+
+// Serves the generated symbol files from memory.
+class SyntheticSymbolSupplier : public SymbolSupplier {
+ public:
+  SyntheticSymbolSupplier(const Shape& shape, bool cfi) {
+    for (int m = 0; m < shape.modules; ++m)
+      symbol_files_[ModuleName(m)] = MakeSymbolFile(shape, m, cfi);
+  }
+
+  virtual SymbolResult GetSymbolFile(const CodeModule* module,
+                                     const SystemInfo* system_info,
+                                     string* symbol_file) {
+    string symbol_data;
+    return GetSymbolFile(module, system_info, symbol_file, &symbol_data);
+  }
+
+  virtual SymbolResult GetSymbolFile(const CodeModule* module,
+                                     const SystemInfo* system_info,
+                                     string* symbol_file,
+                                     string* symbol_data) {
+    map<string, string>::const_iterator it =
+        symbol_files_.find(module->code_file());
+    if (it == symbol_files_.end())
+      return NOT_FOUND;
+    *symbol_file = it->first;
+    *symbol_data = it->second;
+    return FOUND;
+  }
+
+  virtual SymbolResult GetCStringSymbolData(const CodeModule* module,
+                                            const SystemInfo* system_info,
+                                            string* symbol_file,
+                                            char** symbol_data,
+                                            size_t* symbol_data_size) {
+    string data;
+    SymbolResult result =
+        GetSymbolFile(module, system_info, symbol_file, &data);
+    if (result != FOUND)
+      return result;
+    *symbol_data_size = data.size() + 1;
+    *symbol_data = new char[*symbol_data_size];
+    memcpy(*symbol_data, data.c_str(), *symbol_data_size);
+    buffers_[module->code_file()].reset(*symbol_data);
+    return FOUND;
+  }
+
+  virtual void FreeSymbolData(const CodeModule* module) {
+    buffers_.erase(module->code_file());
+  }
+
+ private:
+  map<string, string> symbol_files_;
+  map<string, unique_ptr<char[]>> buffers_;
+};
+
+const char* const kPhaseNames[ProcessingStats::PHASE_COUNT] = {
+  "read", "system_info", "symbol_prefetch", "walk", "exploitability"
+};
+
+const char* const kTrustNames[ProcessingStats::kFrameTrustCount] = {
+  "none", "scan", "cfi_scan", "frame_pointer", "cfi", "prewalked", "context",
+  "inline", "leaf"
+};
+
+void PrintResult(const char* variant, const string& metric, double value,
+                 const char* unit) {
+  // Counts are printed in full, times to six significant digits.
+  if (value == static_cast<double>(static_cast<int64_t>(value)))
+    printf("%s\t%s\t%lld\t%s\n", variant, metric.c_str(),
+           static_cast<long long>(value), unit);
+  else
+    printf("%s\t%s\t%.6g\t%s\n", variant, metric.c_str(), value, unit);
+}
+
+// Prints the phase times of stats, divided by runs, with prefix.
+void PrintPhases(const char* variant, const char* prefix,
+                 const ProcessingStats& stats, int runs) {
+  for (int phase = 0; phase < ProcessingStats::PHASE_COUNT; ++phase) {
+    ProcessingStats::Phase processing_phase =
+        static_cast<ProcessingStats::Phase>(phase);
+    string name = string(prefix) + "_" + kPhaseNames[phase];
+    PrintResult(variant, name + "_wall",
+                stats.wall_seconds(processing_phase) / runs, "s");
+    PrintResult(variant, name + "_cpu",
+                stats.cpu_seconds(processing_phase) / runs, "s");
+  }
+}
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start).count();
+}
+
+// Processes minidump once cold and iterations times warm, and prints the
+// results.
+bool Benchmark(const char* variant, const Shape& shape, Minidump* minidump,
+               int iterations) {
+  SyntheticSymbolSupplier supplier(shape, strcmp(variant, "cfi") == 0);
+  BasicSourceLineResolver resolver;
+  MinidumpProcessor processor(&supplier, &resolver);
+  processor.set_collect_stats(true);
+
+  ProcessState state;
+  auto start = std::chrono::steady_clock::now();
+  if (processor.Process(minidump, &state) != google_breakpad::PROCESS_OK)
+    return false;
+  PrintResult(variant, "cold_total", Seconds(start), "s");
+  PrintPhases(variant, "cold", *state.stats(), 1);
+  PrintResult(variant, "symbol_lookups", state.stats()->symbol_lookups(),
+              "count");
+  for (int trust = 0; trust < ProcessingStats::kFrameTrustCount; ++trust) {
+    uint64_t count = state.stats()->frame_count(
+        static_cast<StackFrame::FrameTrust>(trust));
+    if (count > 0) {
+      PrintResult(variant, string("frames_") + kTrustNames[trust], count,
+                  "count");
+    }
+  }
+
+  // Each Process call clears the stats, so they are summed here.
+  ProcessingStats warm_stats;
+  double warm_seconds = 0;
+  for (int i = 0; i < iterations; ++i) {
+    start = std::chrono::steady_clock::now();
+    processor.Process(minidump, &state);
+    warm_seconds += Seconds(start);
+    for (int phase = 0; phase < ProcessingStats::PHASE_COUNT; ++phase) {
+      ProcessingStats::Phase processing_phase =
+          static_cast<ProcessingStats::Phase>(phase);
+      warm_stats.AddPhaseTime(processing_phase,
+                              state.stats()->wall_seconds(processing_phase),
+                              state.stats()->cpu_seconds(processing_phase));
+    }
+  }
+  if (iterations > 0) {
+    PrintResult(variant, "warm_total", warm_seconds / iterations, "s");
+    PrintPhases(variant, "warm", warm_stats, iterations);
+  }
+  return true;
+}
+
+void Usage(const char* program) {
+  fprintf(stderr,
+          "Usage: %s [OPTION]...\n"
+          "Time processing synthetic x86 minidumps, walked by call frame\n"
+          "information and by stack scanning.\n\n"
+          "Options:\n"
+          "  -t <N>      Threads (default 64)\n"
+          "  -d <N>      Frames per thread (default 64)\n"
+          "  -m <N>      Modules (default 200)\n"
+          "  -f <N>      Functions per module (default 1000)\n"
+          "  -n <N>      Warm runs to average (default 10)\n"
+          "  -v <name>   Walk only variant <name>, cfi or scan\n"
+          "  -o <file>   Keep the synthetic minidump in <file>\n",
+          program);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Shape shape;
+  int iterations = 10;
+  string only_variant;
+  string output_path;
+  int opt;
+  while ((opt = getopt(argc, argv, "t:d:m:f:n:v:o:h")) != -1) {
+    switch (opt) {
+      case 't':
+        shape.threads = atoi(optarg);
+        break;
+      case 'd':
+        shape.depth = atoi(optarg);
+        break;
+      case 'm':
+        shape.modules = atoi(optarg);
+        break;
+      case 'f':
+        shape.functions = atoi(optarg);
+        break;
+      case 'n':
+        iterations = atoi(optarg);
+        break;
+      case 'v':
+        only_variant = optarg;
+        break;
+      case 'o':
+        output_path = optarg;
+        break;
+      default:
+        Usage(argv[0]);
+        return 1;
+    }
+  }
+  if (optind != argc || shape.threads < 1 || shape.depth < 1 ||
+      shape.modules < 1 || shape.functions < 1 || iterations < 0 ||
+      static_cast<uint64_t>(shape.depth) * kFrameSize > kStackSpacing ||
+      kStackBase + static_cast<uint64_t>(shape.threads) * kStackSpacing >
+          kModuleBase ||
+      kModuleBase + static_cast<uint64_t>(shape.modules) * ModuleSize(shape) >
+          UINT32_MAX ||
+      (!only_variant.empty() && only_variant != "cfi" &&
+       only_variant != "scan")) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  string contents = MakeMinidump(shape);
+  if (contents.empty()) {
+    fprintf(stderr, "Can't build the synthetic minidump\n");
+    return 1;
+  }
+  if (!output_path.empty()) {
+    FILE* file = fopen(output_path.c_str(), "wb");
+    if (!file || fwrite(contents.data(), 1, contents.size(), file) !=
+                     contents.size()) {
+      fprintf(stderr, "%s: write failed\n", output_path.c_str());
+      return 1;
+    }
+    fclose(file);
+  }
+
+  Minidump minidump(reinterpret_cast<const uint8_t*>(contents.data()),
+                    contents.size());
+  if (!minidump.Read()) {
+    fprintf(stderr, "Can't read the synthetic minidump\n");
+    return 1;
+  }
+
+  PrintResult("input", "minidump", contents.size(), "bytes");
+  PrintResult("input", "frames", shape.threads * shape.depth, "count");
+  const char* const kVariants[] = { "cfi", "scan" };
+  for (const char* variant : kVariants) {
+    if (!only_variant.empty() && only_variant != variant)
+      continue;
+
+    // Processing logs to stderr at INFO level, which would otherwise cost
+    // more than some of the phases being timed.
+    fflush(stdout);
+    fflush(stderr);
+    int saved_stderr = dup(STDERR_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, STDERR_FILENO);
+    bool processed = Benchmark(variant, shape, &minidump, iterations);
+    fflush(stdout);
+    dup2(saved_stderr, STDERR_FILENO);
+    close(null_fd);
+    close(saved_stderr);
+    if (!processed) {
+      fprintf(stderr, "%s: processing failed\n", variant);
+      return 1;
+    }
+  }
+  return 0;
+}
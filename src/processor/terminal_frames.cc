@@ -0,0 +1,177 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// terminal_frames.cc: Functions at which stack walks stop.
+//
+// See terminal_frames.h for documentation.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "google_breakpad/processor/terminal_frames.h"
+
+#include <ctype.h>
+
+#include <fstream>
+#include <set>
+
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "processor/logging.h"
+#include "processor/pathname_stripper.h"
+
+namespace google_breakpad {
+
+namespace {
+
+struct DefaultTerminalFrame {
+  const char* os;
+  const char* module;
+  const char* function;
+};
+
+const DefaultTerminalFrame kDefaultTerminalFrames[] = {
+  { "linux", "", "start_thread" },
+  { "linux", "", "clone" },
+  { "linux", "", "clone3" },
+  { "linux", "", "__clone" },
+  { "linux", "", "__clone3" },
+  { "linux", "", "__libc_start_main" },
+  { "linux", "", "_start" },
+  { "android", "", "__start_thread" },
+  { "android", "", "__libc_init" },
+  { "android", "", "_start_main" },
+  { "mac", "", "thread_start" },
+  { "mac", "", "start_wqthread" },
+  { "mac", "dyld", "start" },
+  { "mac", "libdyld.dylib", "start" },
+  { "ios", "", "thread_start" },
+  { "ios", "", "start_wqthread" },
+  { "ios", "dyld", "start" },
+  { "ios", "libdyld.dylib", "start" },
+  { "windows", "ntdll.dll", "RtlUserThreadStart" },
+  { "windows", "ntdll.dll", "_RtlUserThreadStart" },
+  { "windows", "ntdll.dll", "__RtlUserThreadStart" },
+};
+
+string ToLower(const string& value) {
+  string lower(value);
+  for (size_t i = 0; i < lower.size(); ++i) {
+    lower[i] =
+        static_cast<char>(tolower(static_cast<unsigned char>(lower[i])));
+  }
+  return lower;
+}
+
+// Appends value to key, preceded by its length so that the fields of a key
+// can't run into each other.
+void AppendToKey(const string& value, string* key) {
+  key->append(std::to_string(value.size()));
+  key->push_back(':');
+  key->append(value);
+}
+
+}  // namespace
+
+void TerminalFrames::AddDefaults() {
+  for (const DefaultTerminalFrame& frame : kDefaultTerminalFrames)
+    Add(frame.os, frame.module, frame.function);
+}
+
+void TerminalFrames::Add(const string& os,
+                         const string& module,
+                         const string& function) {
+  Entry entry = { os, ToLower(module) };
+  functions_.insert(std::make_pair(function, entry));
+}
+
+bool TerminalFrames::Read(const string& path) {
+  std::ifstream file(path.c_str());
+  if (!file) {
+    BPLOG(ERROR) << "Could not read terminal frames from " << path;
+    return false;
+  }
+  string line;
+  while (std::getline(file, line)) {
+    if (!line.empty() && line[line.size() - 1] == '\r')
+      line.erase(line.size() - 1);
+    if (line.empty() || line[0] == '#')
+      continue;
+    size_t separator = line.find('!');
+    if (separator == string::npos)
+      Add("", "", line);
+    else
+      Add("", line.substr(0, separator), line.substr(separator + 1));
+  }
+  return true;
+}
+
+bool TerminalFrames::IsTerminal(const string& os,
+                                const StackFrame& frame) const {
+  if (frame.function_name.empty())
+    return false;
+  auto range = functions_.equal_range(frame.function_name);
+  if (range.first == range.second)
+    return false;
+
+  string module;
+  bool module_known = false;
+  for (auto it = range.first; it != range.second; ++it) {
+    const Entry& entry = it->second;
+    if (!entry.os.empty() && entry.os != os)
+      continue;
+    if (entry.module.empty())
+      return true;
+    if (!module_known) {
+      if (frame.module)
+        module = ToLower(PathnameStripper::File(frame.module->code_file()));
+      module_known = true;
+    }
+    if (entry.module == module)
+      return true;
+  }
+  return false;
+}
+
+string TerminalFrames::Key() const {
+  std::set<string> entries;
+  for (const auto& function : functions_) {
+    string entry;
+    AppendToKey(function.first, &entry);
+    AppendToKey(function.second.os, &entry);
+    AppendToKey(function.second.module, &entry);
+    entries.insert(entry);
+  }
+  string key;
+  for (const string& entry : entries)
+    key.append(entry);
+  return key;
+}
+
+}  // namespace google_breakpad
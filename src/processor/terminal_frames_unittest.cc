@@ -0,0 +1,138 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Unit tests for TerminalFrames.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <stdio.h>
+
+#include <string>
+
+#include "breakpad_googletest_includes.h"
+#include "common/tests/auto_tempdir.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/stack_frame.h"
+#include "google_breakpad/processor/terminal_frames.h"
+#include "processor/basic_code_module.h"
+
+namespace {
+
+using google_breakpad::AutoTempDir;
+using google_breakpad::BasicCodeModule;
+using google_breakpad::StackFrame;
+using google_breakpad::TerminalFrames;
+
+// A frame in function, in the module whose code file is code_file.
+class Frame {
+ public:
+  Frame(const string& code_file, const string& function)
+      : module_(0x1000, 0x1000, code_file, "", "", "", "") {
+    frame_.module = &module_;
+    frame_.function_name = function;
+  }
+
+  const StackFrame& frame() const { return frame_; }
+
+ private:
+  BasicCodeModule module_;
+  StackFrame frame_;
+};
+
+TEST(TerminalFramesTest, ListsDefaultsBySystem) {
+  TerminalFrames terminal_frames;
+  EXPECT_TRUE(terminal_frames.empty());
+  terminal_frames.AddDefaults();
+  EXPECT_FALSE(terminal_frames.empty());
+
+  Frame start_thread("/lib/x86_64-linux-gnu/libc.so.6", "start_thread");
+  EXPECT_TRUE(terminal_frames.IsTerminal("linux", start_thread.frame()));
+  EXPECT_FALSE(terminal_frames.IsTerminal("windows", start_thread.frame()));
+
+  Frame user_thread_start("C:\\Windows\\System32\\NTDLL.DLL",
+                          "RtlUserThreadStart");
+  EXPECT_TRUE(terminal_frames.IsTerminal("windows",
+                                         user_thread_start.frame()));
+  Frame other_thread_start("C:\\Program Files\\App\\app.exe",
+                           "RtlUserThreadStart");
+  EXPECT_FALSE(terminal_frames.IsTerminal("windows",
+                                          other_thread_start.frame()));
+
+  Frame unsymbolized("/lib/x86_64-linux-gnu/libc.so.6", "");
+  EXPECT_FALSE(terminal_frames.IsTerminal("linux", unsymbolized.frame()));
+}
+
+TEST(TerminalFramesTest, ReadsFunctionsFromFile) {
+  AutoTempDir directory;
+  string path = directory.path() + "/terminal_frames";
+  FILE* file = fopen(path.c_str(), "w");
+  ASSERT_TRUE(file);
+  fputs("# Thread pools\n"
+        "\n"
+        "WorkerMain\n"
+        "libpool.so!PoolThreadMain\r\n",
+        file);
+  fclose(file);
+
+  TerminalFrames terminal_frames;
+  ASSERT_TRUE(terminal_frames.Read(path));
+  Frame worker_main("/usr/bin/server", "WorkerMain");
+  EXPECT_TRUE(terminal_frames.IsTerminal("linux", worker_main.frame()));
+  EXPECT_TRUE(terminal_frames.IsTerminal("mac", worker_main.frame()));
+  Frame pool_thread("/usr/lib/libpool.so", "PoolThreadMain");
+  EXPECT_TRUE(terminal_frames.IsTerminal("linux", pool_thread.frame()));
+  Frame other_pool_thread("/usr/bin/server", "PoolThreadMain");
+  EXPECT_FALSE(terminal_frames.IsTerminal("linux",
+                                          other_pool_thread.frame()));
+
+  EXPECT_FALSE(terminal_frames.Read(directory.path() + "/missing"));
+}
+
+TEST(TerminalFramesTest, KeysByListedFunctions) {
+  TerminalFrames first;
+  first.Add("linux", "", "start_thread");
+  first.Add("", "libpool.so", "PoolThreadMain");
+  TerminalFrames second;
+  second.Add("", "LIBPOOL.SO", "PoolThreadMain");
+  second.Add("linux", "", "start_thread");
+  second.Add("linux", "", "start_thread");
+  EXPECT_EQ(first.Key(), second.Key());
+
+  second.Add("mac", "", "thread_start");
+  EXPECT_NE(first.Key(), second.Key());
+
+  TerminalFrames moved_field;
+  moved_field.Add("linux", "", "start_thread");
+  moved_field.Add("", "", "libpool.soPoolThreadMain");
+  EXPECT_NE(first.Key(), moved_field.Key());
+  EXPECT_NE(first.Key(), TerminalFrames().Key());
+}
+
+}  // namespace
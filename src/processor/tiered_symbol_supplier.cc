@@ -0,0 +1,504 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// tiered_symbol_supplier.cc: A SymbolSupplier that looks for symbols in
+// tiers of other suppliers, from the fastest to the slowest.
+//
+// See tiered_symbol_supplier.h for documentation.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "processor/tiered_symbol_supplier.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <utility>
+
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/system_info.h"
+#include "processor/logging.h"
+#include "processor/simple_symbol_supplier.h"
+
+namespace google_breakpad {
+
+namespace {
+
+// Creates directory and any missing parents.
+bool MakeDirectories(const string& directory) {
+  for (size_t slash = directory.find('/', 1); ;
+       slash = directory.find('/', slash + 1)) {
+    string prefix = directory.substr(0, slash);
+    if (mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST) {
+      BPLOG(ERROR) << "Could not create directory " << prefix << ": "
+                   << strerror(errno);
+      return false;
+    }
+    if (slash == string::npos)
+      return true;
+  }
+}
+
+// Waits for the result of a GetCStringSymbolDataAsync request.
+class SymbolDataWaiter : public SymbolSupplier::SymbolDataCallback {
+ public:
+  SymbolDataWaiter()
+      : result_(SymbolSupplier::NOT_FOUND),
+        symbol_data_(NULL),
+        symbol_data_size_(0),
+        done_(false) {}
+
+  virtual void OnSymbolData(const CodeModule* module,
+                            SymbolSupplier::SymbolResult result,
+                            const string& symbol_file,
+                            char* symbol_data,
+                            size_t symbol_data_size) {
+    std::lock_guard<std::mutex> lock(lock_);
+    result_ = result;
+    symbol_file_ = symbol_file;
+    symbol_data_ = symbol_data;
+    symbol_data_size_ = symbol_data_size;
+    done_ = true;
+    condition_.notify_one();
+  }
+
+  SymbolSupplier::SymbolResult Wait(string* symbol_file,
+                                    char** symbol_data,
+                                    size_t* symbol_data_size) {
+    std::unique_lock<std::mutex> lock(lock_);
+    condition_.wait(lock, [this] { return done_; });
+    *symbol_file = symbol_file_;
+    *symbol_data = symbol_data_;
+    *symbol_data_size = symbol_data_size_;
+    return result_;
+  }
+
+ private:
+  SymbolSupplier::SymbolResult result_;
+  string symbol_file_;
+  char* symbol_data_;
+  size_t symbol_data_size_;
+  bool done_;
+  std::mutex lock_;
+  std::condition_variable condition_;
+};
+
+}  // namespace
+
+// A request for a module's symbols that has gone to the remote tiers.
+struct TieredSymbolSupplier::Lookup {
+  enum TierState {
+    // Not a remote tier.
+    NOT_ASKED,
+    PENDING,
+    ANSWERED,
+    // Its budget ran out before it answered.
+    ABANDONED
+  };
+
+  // The remote tiers may answer after the caller is done with its module
+  // and system info, so they are asked about copies.
+  std::unique_ptr<const CodeModule> module;
+  SystemInfo system_info;
+  bool has_system_info;
+
+  const CodeModule* caller_module;
+  SymbolDataCallback* callback;
+
+  // The state, result and deadline of each tier, guarded by lock.
+  vector<TierState> states;
+  vector<SymbolResult> results;
+  vector<Clock::time_point> deadlines;
+  int pending;
+  // Whether callback has been or is being called.
+  bool completed;
+  std::mutex lock;
+
+  // The result once no remote tier is pending and none found the symbols.
+  // lock must be held.
+  SymbolResult UnfoundResult() const {
+    for (size_t i = 0; i < states.size(); ++i) {
+      if (states[i] == ANSWERED && results[i] == INTERRUPT)
+        return INTERRUPT;
+    }
+    return NOT_FOUND;
+  }
+};
+
+// Passes a remote tier's answer on to the lookup it was asked for.
+class TieredSymbolSupplier::TierCallback : public SymbolDataCallback {
+ public:
+  TierCallback(TieredSymbolSupplier* supplier,
+               const std::shared_ptr<Lookup>& lookup,
+               size_t tier)
+      : supplier_(supplier), lookup_(lookup), tier_(tier) {}
+
+  virtual void OnSymbolData(const CodeModule* module,
+                            SymbolResult result,
+                            const string& symbol_file,
+                            char* symbol_data,
+                            size_t symbol_data_size) {
+    supplier_->OnTierResult(lookup_, tier_, result, symbol_file, symbol_data,
+                            symbol_data_size);
+    delete this;
+  }
+
+ private:
+  TieredSymbolSupplier* supplier_;
+  std::shared_ptr<Lookup> lookup_;
+  size_t tier_;
+};
+
+TieredSymbolSupplier::TieredSymbolSupplier()
+    : outstanding_requests_(0), shutting_down_(false) {}
+
+TieredSymbolSupplier::~TieredSymbolSupplier() {
+  {
+    std::unique_lock<std::mutex> lock(requests_lock_);
+    requests_condition_.wait(lock,
+                             [this] { return outstanding_requests_ == 0; });
+  }
+  {
+    std::lock_guard<std::mutex> lock(timer_lock_);
+    shutting_down_ = true;
+  }
+  timer_condition_.notify_all();
+  if (timer_.joinable())
+    timer_.join();
+}
+
+void TieredSymbolSupplier::AddTier(SymbolSupplier* supplier,
+                                   const TierOptions& options) {
+  Tier tier = { supplier, options };
+  tiers_.push_back(tier);
+}
+
+SymbolSupplier::SymbolResult TieredSymbolSupplier::GetSymbolFile(
+    const CodeModule* module, const SystemInfo* system_info,
+    string* symbol_file) {
+  char* symbol_data = NULL;
+  size_t symbol_data_size = 0;
+  SymbolResult result = GetCStringSymbolData(
+      module, system_info, symbol_file, &symbol_data, &symbol_data_size);
+  if (result == FOUND)
+    FreeSymbolData(module);
+  return result;
+}
+
+SymbolSupplier::SymbolResult TieredSymbolSupplier::GetSymbolFile(
+    const CodeModule* module, const SystemInfo* system_info,
+    string* symbol_file, string* symbol_data) {
+  char* data = NULL;
+  size_t data_size = 0;
+  SymbolResult result = GetCStringSymbolData(module, system_info,
+                                             symbol_file, &data, &data_size);
+  if (result == FOUND) {
+    // The data is null-terminated.
+    if (symbol_data)
+      symbol_data->assign(data, data_size > 0 ? data_size - 1 : 0);
+    FreeSymbolData(module);
+  }
+  return result;
+}
+
+SymbolSupplier::SymbolResult TieredSymbolSupplier::GetCStringSymbolData(
+    const CodeModule* module, const SystemInfo* system_info,
+    string* symbol_file, char** symbol_data, size_t* symbol_data_size) {
+  SymbolDataWaiter waiter;
+  GetCStringSymbolDataAsync(module, system_info, &waiter);
+  return waiter.Wait(symbol_file, symbol_data, symbol_data_size);
+}
+
+void TieredSymbolSupplier::FreeSymbolData(const CodeModule* module) {
+  SymbolSupplier* supplier;
+  {
+    std::lock_guard<std::mutex> lock(owners_lock_);
+    std::map<string, SymbolSupplier*>::iterator owner =
+        owners_.find(module->code_file());
+    if (owner == owners_.end())
+      return;
+    supplier = owner->second;
+    owners_.erase(owner);
+  }
+  supplier->FreeSymbolData(module);
+}
+
+void TieredSymbolSupplier::GetCStringSymbolDataAsync(
+    const CodeModule* module, const SystemInfo* system_info,
+    SymbolDataCallback* callback) {
+  bool has_remote_tiers = false;
+  for (size_t i = 0; i < tiers_.size(); ++i) {
+    const Tier& tier = tiers_[i];
+    if (tier.options.remote) {
+      has_remote_tiers = true;
+      continue;
+    }
+    string symbol_file;
+    char* symbol_data = NULL;
+    size_t symbol_data_size = 0;
+    SymbolResult result = tier.supplier->GetCStringSymbolData(
+        module, system_info, &symbol_file, &symbol_data, &symbol_data_size);
+    if (result == FOUND) {
+      {
+        std::lock_guard<std::mutex> lock(owners_lock_);
+        owners_[module->code_file()] = tier.supplier;
+      }
+      callback->OnSymbolData(module, FOUND, symbol_file, symbol_data,
+                             symbol_data_size);
+      return;
+    }
+    if (result == INTERRUPT) {
+      callback->OnSymbolData(module, INTERRUPT, "", NULL, 0);
+      return;
+    }
+  }
+  if (!has_remote_tiers) {
+    callback->OnSymbolData(module, NOT_FOUND, "", NULL, 0);
+    return;
+  }
+
+  std::shared_ptr<Lookup> lookup(new Lookup);
+  lookup->module.reset(module->Copy());
+  lookup->has_system_info = system_info != NULL;
+  if (system_info)
+    lookup->system_info = *system_info;
+  lookup->caller_module = module;
+  lookup->callback = callback;
+  lookup->states.resize(tiers_.size(), Lookup::NOT_ASKED);
+  lookup->results.resize(tiers_.size(), NOT_FOUND);
+  lookup->deadlines.resize(tiers_.size());
+  lookup->pending = 0;
+  lookup->completed = false;
+
+  Clock::time_point now = Clock::now();
+  for (size_t i = 0; i < tiers_.size(); ++i) {
+    if (!tiers_[i].options.remote)
+      continue;
+    lookup->states[i] = Lookup::PENDING;
+    ++lookup->pending;
+    if (tiers_[i].options.latency_budget_ms > 0) {
+      lookup->deadlines[i] =
+          now + std::chrono::milliseconds(tiers_[i].options.latency_budget_ms);
+      std::lock_guard<std::mutex> lock(timer_lock_);
+      deadlines_.insert(std::make_pair(lookup->deadlines[i],
+                                       std::weak_ptr<Lookup>(lookup)));
+      if (!timer_.joinable())
+        timer_ = std::thread(&TieredSymbolSupplier::RunTimer, this);
+    }
+  }
+  timer_condition_.notify_one();
+
+  const SystemInfo* lookup_system_info =
+      lookup->has_system_info ? &lookup->system_info : NULL;
+  for (size_t i = 0; i < tiers_.size(); ++i) {
+    if (!tiers_[i].options.remote)
+      continue;
+    {
+      // No need to ask the rest once a tier has answered with the symbols,
+      // possibly before its request returned.
+      std::lock_guard<std::mutex> lock(lookup->lock);
+      if (lookup->completed)
+        break;
+    }
+    StartRequest();
+    tiers_[i].supplier->GetCStringSymbolDataAsync(
+        lookup->module.get(), lookup_system_info,
+        new TierCallback(this, lookup, i));
+  }
+}
+
+void TieredSymbolSupplier::OnTierResult(
+    const std::shared_ptr<Lookup>& lookup, size_t tier, SymbolResult result,
+    const string& symbol_file, char* symbol_data, size_t symbol_data_size) {
+  bool complete = false;
+  SymbolResult lookup_result = result;
+  {
+    std::lock_guard<std::mutex> lock(lookup->lock);
+    if (!lookup->completed && lookup->states[tier] == Lookup::PENDING) {
+      lookup->states[tier] = Lookup::ANSWERED;
+      lookup->results[tier] = result;
+      --lookup->pending;
+      if (result == FOUND) {
+        complete = true;
+      } else if (lookup->pending == 0) {
+        complete = true;
+        lookup_result = lookup->UnfoundResult();
+      }
+      lookup->completed = complete;
+    }
+  }
+
+  if (complete) {
+    Complete(lookup, &tiers_[tier], lookup_result, symbol_file, symbol_data,
+             symbol_data_size);
+  } else if (result == FOUND) {
+    // Another tier answered first, or this one answered too late.
+    tiers_[tier].supplier->FreeSymbolData(lookup->module.get());
+  }
+  FinishRequest();
+}
+
+void TieredSymbolSupplier::OnDeadline(const std::shared_ptr<Lookup>& lookup) {
+  SymbolResult lookup_result;
+  {
+    std::lock_guard<std::mutex> lock(lookup->lock);
+    if (lookup->completed)
+      return;
+    Clock::time_point now = Clock::now();
+    for (size_t i = 0; i < tiers_.size(); ++i) {
+      if (lookup->states[i] == Lookup::PENDING &&
+          tiers_[i].options.latency_budget_ms > 0 &&
+          lookup->deadlines[i] <= now) {
+        BPLOG(INFO) << "No answer within "
+                    << tiers_[i].options.latency_budget_ms
+                    << " ms from symbol tier " << i << " for "
+                    << lookup->module->code_file();
+        lookup->states[i] = Lookup::ABANDONED;
+        --lookup->pending;
+      }
+    }
+    if (lookup->pending > 0)
+      return;
+    lookup->completed = true;
+    lookup_result = lookup->UnfoundResult();
+  }
+  Complete(lookup, NULL, lookup_result, "", NULL, 0);
+}
+
+void TieredSymbolSupplier::Complete(const std::shared_ptr<Lookup>& lookup,
+                                    const Tier* tier,
+                                    SymbolResult result,
+                                    const string& symbol_file,
+                                    char* symbol_data,
+                                    size_t symbol_data_size) {
+  string result_file = symbol_file;
+  if (result == FOUND) {
+    if (!write_back_path_.empty()) {
+      WriteBack(lookup->module.get(), symbol_data, symbol_data_size,
+                &result_file);
+    }
+    std::lock_guard<std::mutex> lock(owners_lock_);
+    owners_[lookup->module->code_file()] = tier->supplier;
+  }
+  lookup->callback->OnSymbolData(lookup->caller_module, result, result_file,
+                                 symbol_data, symbol_data_size);
+}
+
+void TieredSymbolSupplier::WriteBack(const CodeModule* module,
+                                     const char* symbol_data,
+                                     size_t symbol_data_size,
+                                     string* symbol_file) {
+  string relative_path;
+  if (!SimpleSymbolSupplier::GetSymbolFileRelativePath(module,
+                                                       &relative_path)) {
+    return;
+  }
+  string path = write_back_path_ + "/" + relative_path;
+  size_t slash = path.rfind('/');
+  if (!MakeDirectories(path.substr(0, slash)))
+    return;
+
+  // The data is null-terminated.
+  if (symbol_data_size > 0 && symbol_data[symbol_data_size - 1] == '\0')
+    --symbol_data_size;
+
+  // Write to a temporary file renamed into place, so that readers never see
+  // a partially written file.
+  string temp_path = path + ".tmp.XXXXXX";
+  int fd = mkstemp(&temp_path[0]);
+  if (fd == -1) {
+    BPLOG(ERROR) << "Could not create " << temp_path << ": "
+                 << strerror(errno);
+    return;
+  }
+  bool written = fchmod(fd, 0644) == 0;
+  for (size_t offset = 0; written && offset < symbol_data_size; ) {
+    ssize_t count = write(fd, symbol_data + offset, symbol_data_size - offset);
+    if (count < 0 && errno == EINTR)
+      continue;
+    written = count > 0;
+    if (written)
+      offset += count;
+  }
+  if (close(fd) != 0)
+    written = false;
+  if (!written || rename(temp_path.c_str(), path.c_str()) != 0) {
+    BPLOG(ERROR) << "Could not write " << path << ": " << strerror(errno);
+    unlink(temp_path.c_str());
+    return;
+  }
+  BPLOG(INFO) << "Wrote back symbol file " << path;
+  *symbol_file = path;
+}
+
+void TieredSymbolSupplier::StartRequest() {
+  std::lock_guard<std::mutex> lock(requests_lock_);
+  ++outstanding_requests_;
+}
+
+void TieredSymbolSupplier::FinishRequest() {
+  std::lock_guard<std::mutex> lock(requests_lock_);
+  if (--outstanding_requests_ == 0)
+    requests_condition_.notify_all();
+}
+
+void TieredSymbolSupplier::RunTimer() {
+  std::unique_lock<std::mutex> lock(timer_lock_);
+  while (!shutting_down_) {
+    if (deadlines_.empty()) {
+      timer_condition_.wait(lock);
+      continue;
+    }
+    Clock::time_point deadline = deadlines_.begin()->first;
+    if (Clock::now() < deadline) {
+      timer_condition_.wait_until(lock, deadline);
+      continue;
+    }
+
+    vector<std::shared_ptr<Lookup>> expired;
+    Clock::time_point now = Clock::now();
+    while (!deadlines_.empty() && deadlines_.begin()->first <= now) {
+      if (std::shared_ptr<Lookup> lookup = deadlines_.begin()->second.lock())
+        expired.push_back(lookup);
+      deadlines_.erase(deadlines_.begin());
+    }
+    lock.unlock();
+    for (size_t i = 0; i < expired.size(); ++i)
+      OnDeadline(expired[i]);
+    expired.clear();
+    lock.lock();
+  }
+}
+
+}  // namespace google_breakpad
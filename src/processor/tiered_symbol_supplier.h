@@ -0,0 +1,198 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// tiered_symbol_supplier.h: A SymbolSupplier that looks for symbols in
+// tiers of other suppliers, from the fastest to the slowest.
+//
+// Symbol stores are commonly layered: a local disk cache, a shared file
+// system, and an HTTP store.  Asking each in turn pays the full latency of
+// every miss before the next is asked.  TieredSymbolSupplier asks its
+// local tiers in the order they were added, as SimpleSymbolSupplier does
+// its paths, since a miss there is cheap.  If none has the symbols, it asks
+// every remote tier at once through GetCStringSymbolDataAsync and takes the
+// first to find them, hedging against a slow or unreachable store.  A
+// remote tier may be given a latency budget, past which it is no longer
+// waited for: its late answer is discarded.
+//
+// Symbols found in a remote tier may be written back below a directory,
+// laid out as a SimpleSymbolSupplier root, which a local tier reads from,
+// so that they are found there next time.
+//
+// GetCStringSymbolDataAsync returns as soon as the remote tiers have been
+// asked, so with MinidumpProcessor::set_async_symbol_prefetch, the symbols
+// of every module of a minidump are fetched in about one round trip, as
+// far as the remote tiers allow as many requests at once (see
+// HttpSymbolSupplier::set_max_concurrent_downloads).
+//
+// TieredSymbolSupplier may be called from several threads at once, as
+// long as its tiers may be.
+
+#ifndef PROCESSOR_TIERED_SYMBOL_SUPPLIER_H__
+#define PROCESSOR_TIERED_SYMBOL_SUPPLIER_H__
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/symbol_supplier.h"
+
+namespace google_breakpad {
+
+using std::vector;
+
+class TieredSymbolSupplier : public SymbolSupplier {
+ public:
+  struct TierOptions {
+    TierOptions() : remote(false), latency_budget_ms(0) {}
+
+    // Remote tiers are asked at once, once no local tier has the symbols.
+    bool remote;
+    // How long to wait for a remote tier's answer, in milliseconds.  0
+    // waits for as long as the tier takes.
+    int latency_budget_ms;
+  };
+
+  TieredSymbolSupplier();
+
+  // Waits for outstanding requests, including those to remote tiers that
+  // are no longer waited for, to complete.
+  virtual ~TieredSymbolSupplier();
+
+  // Adds a tier that supplier serves.  supplier must outlive this.  Tiers
+  // must be added before any symbols are requested.
+  void AddTier(SymbolSupplier* supplier, const TierOptions& options);
+
+  // Writes symbol files found in remote tiers below path, as a
+  // SimpleSymbolSupplier root.  An empty path, the default, writes
+  // nothing back.
+  void set_write_back_path(const string& path) { write_back_path_ = path; }
+
+  virtual SymbolResult GetSymbolFile(const CodeModule* module,
+                                     const SystemInfo* system_info,
+                                     string* symbol_file);
+  virtual SymbolResult GetSymbolFile(const CodeModule* module,
+                                     const SystemInfo* system_info,
+                                     string* symbol_file,
+                                     string* symbol_data);
+  virtual SymbolResult GetCStringSymbolData(const CodeModule* module,
+                                            const SystemInfo* system_info,
+                                            string* symbol_file,
+                                            char** symbol_data,
+                                            size_t* symbol_data_size);
+  // Frees the data through the tier that supplied it.
+  virtual void FreeSymbolData(const CodeModule* module);
+
+  // Asks the local tiers before returning, and the remote tiers without
+  // waiting for them.
+  virtual void GetCStringSymbolDataAsync(const CodeModule* module,
+                                         const SystemInfo* system_info,
+                                         SymbolDataCallback* callback);
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Tier {
+    SymbolSupplier* supplier;
+    TierOptions options;
+  };
+
+  struct Lookup;
+  class TierCallback;
+
+  // Records a remote tier's answer to lookup, and completes lookup if it
+  // can.  Frees the data of an answer that is no longer wanted.
+  void OnTierResult(const std::shared_ptr<Lookup>& lookup,
+                    size_t tier,
+                    SymbolResult result,
+                    const string& symbol_file,
+                    char* symbol_data,
+                    size_t symbol_data_size);
+
+  // Gives up on the remote tiers of lookup whose budget has run out, and
+  // completes lookup if it can.
+  void OnDeadline(const std::shared_ptr<Lookup>& lookup);
+
+  // Calls lookup's callback with the result of tier, which owns the data
+  // until FreeSymbolData, first writing found symbols back if tier is
+  // remote.
+  void Complete(const std::shared_ptr<Lookup>& lookup,
+                const Tier* tier,
+                SymbolResult result,
+                const string& symbol_file,
+                char* symbol_data,
+                size_t symbol_data_size);
+
+  // Writes the symbol data of module below write_back_path_, and sets
+  // symbol_file to its path.
+  void WriteBack(const CodeModule* module,
+                 const char* symbol_data,
+                 size_t symbol_data_size,
+                 string* symbol_file);
+
+  // Counts requests to remote tiers, which must complete before this is
+  // destroyed.
+  void StartRequest();
+  void FinishRequest();
+
+  // Runs on timer_ while there are deadlines.
+  void RunTimer();
+
+  vector<Tier> tiers_;
+  string write_back_path_;
+
+  // The tier that supplied the data of each module, by code file, until
+  // FreeSymbolData.  Guarded by owners_lock_.
+  std::map<string, SymbolSupplier*> owners_;
+  std::mutex owners_lock_;
+
+  // Outstanding requests to remote tiers.  Guarded by requests_lock_.
+  int outstanding_requests_;
+  std::mutex requests_lock_;
+  std::condition_variable requests_condition_;
+
+  // Lookups by the time their next remote tier's budget runs out.
+  // Guarded by timer_lock_.
+  std::multimap<Clock::time_point, std::weak_ptr<Lookup>> deadlines_;
+  std::thread timer_;
+  bool shutting_down_;
+  std::mutex timer_lock_;
+  std::condition_variable timer_condition_;
+
+  TieredSymbolSupplier(const TieredSymbolSupplier&) = delete;
+  void operator=(const TieredSymbolSupplier&) = delete;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_TIERED_SYMBOL_SUPPLIER_H__
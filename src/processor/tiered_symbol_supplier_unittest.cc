@@ -0,0 +1,278 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// Unit tests for TieredSymbolSupplier.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "breakpad_googletest_includes.h"
+#include "common/tests/auto_tempdir.h"
+#include "common/using_std_string.h"
+#include "processor/basic_code_module.h"
+#include "processor/simple_symbol_supplier.h"
+#include "processor/tiered_symbol_supplier.h"
+
+namespace {
+
+using google_breakpad::AutoTempDir;
+using google_breakpad::BasicCodeModule;
+using google_breakpad::CodeModule;
+using google_breakpad::SimpleSymbolSupplier;
+using google_breakpad::SymbolSupplier;
+using google_breakpad::SystemInfo;
+using google_breakpad::TieredSymbolSupplier;
+using std::vector;
+
+const char kSymbols[] =
+    "MODULE Linux x86 F4F8DFCD5A5FB5A7CE64717E9E6AE3890 libc.so.6\n"
+    "FUNC 1000 20 0 malloc\n";
+
+// Answers every request with the same result and symbol data, after a
+// delay when asked asynchronously, and counts the buffers it hands out.
+class FakeSymbolSupplier : public SymbolSupplier {
+ public:
+  FakeSymbolSupplier(SymbolResult result, const string& name, int delay_ms)
+      : result_(result), name_(name), delay_ms_(delay_ms), requests_(0) {}
+
+  virtual ~FakeSymbolSupplier() {
+    for (size_t i = 0; i < threads_.size(); ++i)
+      threads_[i].join();
+  }
+
+  virtual SymbolResult GetSymbolFile(const CodeModule* module,
+                                     const SystemInfo* system_info,
+                                     string* symbol_file) {
+    *symbol_file = "/" + name_ + "/libc.so.6.sym";
+    return result_;
+  }
+  virtual SymbolResult GetSymbolFile(const CodeModule* module,
+                                     const SystemInfo* system_info,
+                                     string* symbol_file,
+                                     string* symbol_data) {
+    *symbol_data = name_ + kSymbols;
+    return GetSymbolFile(module, system_info, symbol_file);
+  }
+  virtual SymbolResult GetCStringSymbolData(const CodeModule* module,
+                                            const SystemInfo* system_info,
+                                            string* symbol_file,
+                                            char** symbol_data,
+                                            size_t* symbol_data_size) {
+    ++requests_;
+    if (result_ != FOUND)
+      return result_;
+    string data = name_ + kSymbols;
+    *symbol_data_size = data.size() + 1;
+    *symbol_data = new char[*symbol_data_size];
+    memcpy(*symbol_data, data.c_str(), *symbol_data_size);
+    {
+      std::lock_guard<std::mutex> lock(lock_);
+      buffers_[module->code_file()] = *symbol_data;
+    }
+    return GetSymbolFile(module, system_info, symbol_file);
+  }
+  virtual void FreeSymbolData(const CodeModule* module) {
+    std::lock_guard<std::mutex> lock(lock_);
+    std::map<string, char*>::iterator buffer =
+        buffers_.find(module->code_file());
+    if (buffer != buffers_.end()) {
+      delete[] buffer->second;
+      buffers_.erase(buffer);
+    }
+  }
+
+  virtual void GetCStringSymbolDataAsync(const CodeModule* module,
+                                         const SystemInfo* system_info,
+                                         SymbolDataCallback* callback) {
+    if (delay_ms_ == 0) {
+      SymbolSupplier::GetCStringSymbolDataAsync(module, system_info,
+                                                callback);
+      return;
+    }
+    std::lock_guard<std::mutex> lock(threads_lock_);
+    threads_.push_back(std::thread([=]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms_));
+      SymbolSupplier::GetCStringSymbolDataAsync(module, system_info,
+                                                callback);
+    }));
+  }
+
+  int requests() const { return requests_; }
+  // The buffers handed out and not freed yet.
+  size_t buffers() {
+    std::lock_guard<std::mutex> lock(lock_);
+    return buffers_.size();
+  }
+
+ private:
+  SymbolResult result_;
+  string name_;
+  int delay_ms_;
+  std::atomic<int> requests_;
+  std::map<string, char*> buffers_;
+  std::mutex lock_;
+  vector<std::thread> threads_;
+  std::mutex threads_lock_;
+};
+
+BasicCodeModule MakeModule() {
+  return BasicCodeModule(0x10000, 0x10000, "/lib/libc.so.6", "",
+                         "libc.so.6", "F4F8DFCD5A5FB5A7CE64717E9E6AE3890",
+                         "");
+}
+
+TieredSymbolSupplier::TierOptions Local() {
+  return TieredSymbolSupplier::TierOptions();
+}
+
+TieredSymbolSupplier::TierOptions Remote(int latency_budget_ms) {
+  TieredSymbolSupplier::TierOptions options;
+  options.remote = true;
+  options.latency_budget_ms = latency_budget_ms;
+  return options;
+}
+
+TEST(TieredSymbolSupplierTest, AsksLocalTiersInOrder) {
+  FakeSymbolSupplier missing(SymbolSupplier::NOT_FOUND, "missing", 0);
+  FakeSymbolSupplier local(SymbolSupplier::FOUND, "local", 0);
+  FakeSymbolSupplier remote(SymbolSupplier::FOUND, "remote", 0);
+  TieredSymbolSupplier supplier;
+  supplier.AddTier(&missing, Local());
+  supplier.AddTier(&local, Local());
+  supplier.AddTier(&remote, Remote(0));
+
+  BasicCodeModule module = MakeModule();
+  string symbol_file;
+  string symbol_data;
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file,
+                                   &symbol_data));
+  EXPECT_EQ("/local/libc.so.6.sym", symbol_file);
+  EXPECT_EQ(string("local") + kSymbols, symbol_data);
+  EXPECT_EQ(1, missing.requests());
+  EXPECT_EQ(0, remote.requests());
+  EXPECT_EQ(0U, local.buffers());
+}
+
+TEST(TieredSymbolSupplierTest, TakesFirstRemoteAnswer) {
+  FakeSymbolSupplier slow(SymbolSupplier::FOUND, "slow", 200);
+  FakeSymbolSupplier fast(SymbolSupplier::FOUND, "fast", 10);
+  {
+    TieredSymbolSupplier supplier;
+    supplier.AddTier(&slow, Remote(0));
+    supplier.AddTier(&fast, Remote(0));
+
+    BasicCodeModule module = MakeModule();
+    string symbol_file;
+    char* symbol_data = NULL;
+    size_t symbol_data_size = 0;
+    ASSERT_EQ(SymbolSupplier::FOUND,
+              supplier.GetCStringSymbolData(&module, NULL, &symbol_file,
+                                            &symbol_data,
+                                            &symbol_data_size));
+    EXPECT_EQ("/fast/libc.so.6.sym", symbol_file);
+    EXPECT_EQ(string("fast") + kSymbols, symbol_data);
+    EXPECT_EQ(1U, fast.buffers());
+    supplier.FreeSymbolData(&module);
+    EXPECT_EQ(0U, fast.buffers());
+  }
+  // The supplier waited for the slow tier, and freed its late answer.
+  EXPECT_EQ(1, slow.requests());
+  EXPECT_EQ(0U, slow.buffers());
+}
+
+TEST(TieredSymbolSupplierTest, StopsWaitingPastLatencyBudget) {
+  FakeSymbolSupplier slow(SymbolSupplier::FOUND, "slow", 500);
+  FakeSymbolSupplier missing(SymbolSupplier::NOT_FOUND, "missing", 10);
+  TieredSymbolSupplier supplier;
+  supplier.AddTier(&slow, Remote(50));
+  supplier.AddTier(&missing, Remote(0));
+
+  BasicCodeModule module = MakeModule();
+  string symbol_file;
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_EQ(SymbolSupplier::NOT_FOUND,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file));
+  EXPECT_LT(std::chrono::steady_clock::now() - start,
+            std::chrono::milliseconds(400));
+}
+
+TEST(TieredSymbolSupplierTest, InterruptsIfARemoteTierFails) {
+  FakeSymbolSupplier failing(SymbolSupplier::INTERRUPT, "failing", 10);
+  FakeSymbolSupplier missing(SymbolSupplier::NOT_FOUND, "missing", 10);
+  TieredSymbolSupplier supplier;
+  supplier.AddTier(&failing, Remote(0));
+  supplier.AddTier(&missing, Remote(0));
+
+  BasicCodeModule module = MakeModule();
+  string symbol_file;
+  EXPECT_EQ(SymbolSupplier::INTERRUPT,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file));
+}
+
+TEST(TieredSymbolSupplierTest, WritesBackRemoteSymbols) {
+  AutoTempDir cache;
+  SimpleSymbolSupplier local(cache.path());
+  FakeSymbolSupplier remote(SymbolSupplier::FOUND, "remote", 10);
+  TieredSymbolSupplier supplier;
+  supplier.AddTier(&local, Local());
+  supplier.AddTier(&remote, Remote(0));
+  supplier.set_write_back_path(cache.path());
+
+  BasicCodeModule module = MakeModule();
+  string symbol_file;
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file));
+  string expected_file = cache.path() +
+      "/libc.so.6/F4F8DFCD5A5FB5A7CE64717E9E6AE3890/libc.so.6.sym";
+  EXPECT_EQ(expected_file, symbol_file);
+  std::ifstream file(expected_file.c_str());
+  std::stringstream contents;
+  contents << file.rdbuf();
+  EXPECT_EQ(string("remote") + kSymbols, contents.str());
+
+  // The local tier has the symbols now.
+  ASSERT_EQ(SymbolSupplier::FOUND,
+            supplier.GetSymbolFile(&module, NULL, &symbol_file));
+  EXPECT_EQ(1, remote.requests());
+}
+
+}  // namespace
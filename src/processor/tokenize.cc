@@ -32,6 +32,12 @@
 
 #include <string.h>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #include <string>
 #include <vector>
 
@@ -72,6 +78,61 @@ bool Tokenize(char* line,
   return tokens->size() == static_cast<unsigned int>(max_tokens);
 }
 
+namespace {
+
+// Returns the first '\r', '\n' or 0 at or after p, or end if there is none
+// before it.
+char* FindLineBreak(char* p, char* end) {
+#if defined(__SSE2__)
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  const __m128i nul = _mm_setzero_si128();
+  for (; end - p >= 16; p += 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    int breaks = _mm_movemask_epi8(
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, cr),
+                                  _mm_cmpeq_epi8(bytes, lf)),
+                     _mm_cmpeq_epi8(bytes, nul)));
+    if (breaks != 0)
+      return p + __builtin_ctz(breaks);
+  }
+#elif defined(__aarch64__)
+  for (; end - p >= 16; p += 16) {
+    uint8x16_t bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    uint8x16_t breaks = vorrq_u8(vorrq_u8(vceqq_u8(bytes, vdupq_n_u8('\r')),
+                                          vceqq_u8(bytes, vdupq_n_u8('\n'))),
+                                 vceqzq_u8(bytes));
+    // Narrow each byte of the mask to four bits, so that the first break
+    // is the lowest set bit of a 64-bit word divided by four.
+    uint64_t nibbles = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(breaks), 4)), 0);
+    if (nibbles != 0)
+      return p + __builtin_ctzll(nibbles) / 4;
+  }
+#endif
+  while (p < end && *p != '\r' && *p != '\n' && *p != '\0')
+    ++p;
+  return p;
+}
+
+}  // namespace
+
+char* NextLine(char** cursor, char* end) {
+  char* p = *cursor;
+  while (p < end && (*p == '\r' || *p == '\n'))
+    ++p;
+  if (p == end || *p == '\0') {
+    *cursor = p;
+    return NULL;
+  }
+  char* line = p;
+  p = FindLineBreak(p, end);
+  if (p < end && *p != '\0')
+    *p++ = '\0';
+  *cursor = p;
+  return line;
+}
+
 void StringToVector(const string& str, vector<char>& vec) {
   vec.resize(str.length() + 1);
   std::copy(str.begin(), str.end(), vec.begin());
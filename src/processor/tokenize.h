@@ -53,6 +53,14 @@ bool Tokenize(char* line,
               const char* separators,
               int max_tokens,
               std::vector<char*>* tokens);
+// Returns the next line of the 0-terminated text at *cursor, which ends at
+// end at the latest, and advances *cursor past it.  The line break ending
+// the line is overwritten with a 0, and empty lines are skipped, so this
+// splits the text as strtok_r with "\r\n" as separators would, but looks
+// for line breaks several characters at a time.  Returns NULL at the end of
+// the text.
+char* NextLine(char** cursor, char* end);
+
 // For convenience, since you need a char* to pass to Tokenize.
 // You can call StringToVector on a string, and use &vec[0].
 void StringToVector(const string& str, std::vector<char>& vec);
@@ -0,0 +1,266 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// unsymbolized_walk.cc: The stack walks of a processed minidump, without
+// their symbols.
+//
+// See unsymbolized_walk.h for documentation.
+
+// For <inttypes.h> PRI* macros, before anything else might #include it.
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif  /* __STDC_FORMAT_MACROS */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "google_breakpad/processor/unsymbolized_walk.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "google_breakpad/processor/call_stack.h"
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/code_modules.h"
+#include "google_breakpad/processor/process_state.h"
+
+namespace google_breakpad {
+
+namespace {
+
+// Stands for an empty debug identifier, which is otherwise hexadecimal.
+const char kEmptyIdentifier[] = "-";
+
+// Returns true if line starts with prefix, and sets rest to what follows.
+bool ParseRest(const string& line, const char* prefix, string* rest) {
+  string::size_type prefix_length = strlen(prefix);
+  if (line.compare(0, prefix_length, prefix) != 0 ||
+      line.size() == prefix_length) {
+    return false;
+  }
+  *rest = line.substr(prefix_length);
+  return true;
+}
+
+// Adds the modules of modules to walk_modules, and their indexes to
+// indexes.
+void RecordModules(const CodeModules* modules,
+                   vector<UnsymbolizedWalk::Module>* walk_modules,
+                   std::unordered_map<const CodeModule*, int>* indexes) {
+  unsigned int count = modules ? modules->module_count() : 0;
+  for (unsigned int i = 0; i < count; ++i) {
+    const CodeModule* module = modules->GetModuleAtSequence(i);
+    (*indexes)[module] = static_cast<int>(walk_modules->size());
+    UnsymbolizedWalk::Module walk_module;
+    walk_module.base_address = module->base_address();
+    walk_module.size = module->size();
+    walk_module.debug_file = module->debug_file();
+    walk_module.debug_identifier = module->debug_identifier();
+    walk_modules->push_back(walk_module);
+  }
+}
+
+}  // namespace
+
+const int UnsymbolizedWalk::kNoModule;
+
+void UnsymbolizedWalk::Record(const ProcessState& process_state) {
+  Clear();
+
+  std::unordered_map<const CodeModule*, int> indexes;
+  RecordModules(process_state.modules(), &modules_, &indexes);
+  RecordModules(process_state.unloaded_modules(), &modules_, &indexes);
+
+  for (const CodeModule* module : *process_state.modules_without_symbols()) {
+    auto index = indexes.find(module);
+    if (index != indexes.end())
+      modules_without_cfi_.push_back(index->second);
+  }
+  std::sort(modules_without_cfi_.begin(), modules_without_cfi_.end());
+  modules_without_cfi_.erase(
+      std::unique(modules_without_cfi_.begin(), modules_without_cfi_.end()),
+      modules_without_cfi_.end());
+
+  const vector<CallStack*>& stacks = *process_state.threads();
+  threads_.resize(stacks.size());
+  for (size_t i = 0; i < stacks.size(); ++i) {
+    Thread& thread = threads_[i];
+    thread.thread_id = stacks[i]->tid();
+    thread.complete = !stacks[i]->truncated() &&
+                      !process_state.thread_walk_deferred(i);
+    for (const StackFrame* frame : *stacks[i]->frames()) {
+      // Inlined frames come from the symbols.
+      if (frame->trust == StackFrame::FRAME_TRUST_INLINE)
+        continue;
+      Frame walk_frame;
+      walk_frame.trust = frame->trust;
+      walk_frame.module = kNoModule;
+      walk_frame.offset = frame->instruction;
+      auto index = indexes.find(frame->module);
+      if (frame->module && index != indexes.end()) {
+        walk_frame.module = index->second;
+        walk_frame.offset -= frame->module->base_address();
+      }
+      thread.frames.push_back(walk_frame);
+    }
+  }
+}
+
+string UnsymbolizedWalk::Serialize() const {
+  string walk_data = "UNSYMBOLIZEDWALK\n";
+  char line[128];
+  for (size_t i = 0; i < modules_.size(); ++i) {
+    const Module& module = modules_[i];
+    snprintf(line, sizeof(line), "MODULE %zu %" PRIx64 " %" PRIx64 " ", i,
+             module.base_address, module.size);
+    walk_data.append(line);
+    walk_data.append(module.debug_identifier.empty() ?
+                         kEmptyIdentifier : module.debug_identifier);
+    walk_data.append(" " + module.debug_file + "\n");
+  }
+  for (int index : modules_without_cfi_) {
+    snprintf(line, sizeof(line), "NOCFI %d\n", index);
+    walk_data.append(line);
+  }
+  for (const Thread& thread : threads_) {
+    snprintf(line, sizeof(line), "THREAD %" PRIx32 " %d\n", thread.thread_id,
+             thread.complete ? 1 : 0);
+    walk_data.append(line);
+    for (const Frame& frame : thread.frames) {
+      snprintf(line, sizeof(line), "FRAME %d %d %" PRIx64 "\n", frame.trust,
+               frame.module, frame.offset);
+      walk_data.append(line);
+    }
+  }
+  return walk_data;
+}
+
+bool UnsymbolizedWalk::Parse(const string& walk_data) {
+  Clear();
+
+  size_t position = 0;
+  bool have_header = false;
+  bool well_formed = true;
+  while (well_formed && position < walk_data.size()) {
+    size_t newline = walk_data.find('\n', position);
+    if (newline == string::npos)
+      newline = walk_data.size();
+    string line = walk_data.substr(position, newline - position);
+    position = newline + 1;
+
+    string rest;
+    char extra;
+    if (!have_header) {
+      well_formed = have_header = line == "UNSYMBOLIZEDWALK";
+    } else if (ParseRest(line, "MODULE ", &rest)) {
+      // The debug identifier and file follow the numbers, and the file may
+      // hold spaces.
+      size_t index;
+      Module module;
+      int numbers_length = 0;
+      well_formed =
+          sscanf(rest.c_str(), "%zu %" SCNx64 " %" SCNx64 " %n", &index,
+                 &module.base_address, &module.size, &numbers_length) == 3 &&
+          numbers_length > 0 && index == modules_.size() &&
+          modules_without_cfi_.empty() && threads_.empty();
+      string::size_type space =
+          well_formed ? rest.find(' ', numbers_length) : string::npos;
+      well_formed = well_formed && space != string::npos &&
+                    space > static_cast<size_t>(numbers_length);
+      if (well_formed) {
+        module.debug_identifier =
+            rest.substr(numbers_length, space - numbers_length);
+        if (module.debug_identifier == kEmptyIdentifier)
+          module.debug_identifier.clear();
+        module.debug_file = rest.substr(space + 1);
+        modules_.push_back(module);
+      }
+    } else if (ParseRest(line, "NOCFI ", &rest)) {
+      int index;
+      well_formed = sscanf(rest.c_str(), "%d %c", &index, &extra) == 1 &&
+                    index >= 0 &&
+                    static_cast<size_t>(index) < modules_.size() &&
+                    (modules_without_cfi_.empty() ||
+                     index > modules_without_cfi_.back()) &&
+                    threads_.empty();
+      if (well_formed)
+        modules_without_cfi_.push_back(index);
+    } else if (ParseRest(line, "THREAD ", &rest)) {
+      Thread thread;
+      int complete;
+      well_formed = sscanf(rest.c_str(), "%" SCNx32 " %d %c",
+                           &thread.thread_id, &complete, &extra) == 2 &&
+                    (complete == 0 || complete == 1);
+      if (well_formed) {
+        thread.complete = complete == 1;
+        threads_.push_back(thread);
+      }
+    } else if (ParseRest(line, "FRAME ", &rest)) {
+      int trust;
+      Frame frame;
+      well_formed = !threads_.empty() &&
+          sscanf(rest.c_str(), "%d %d %" SCNx64 " %c", &trust, &frame.module,
+                 &frame.offset, &extra) == 3 &&
+          trust >= StackFrame::FRAME_TRUST_NONE &&
+          trust <= StackFrame::FRAME_TRUST_LEAF &&
+          frame.module >= kNoModule &&
+          (frame.module == kNoModule ||
+           static_cast<size_t>(frame.module) < modules_.size());
+      if (well_formed) {
+        frame.trust = static_cast<StackFrame::FrameTrust>(trust);
+        threads_.back().frames.push_back(frame);
+      }
+    } else {
+      well_formed = false;
+    }
+  }
+
+  if (!well_formed || !have_header) {
+    Clear();
+    return false;
+  }
+  return true;
+}
+
+void UnsymbolizedWalk::Clear() {
+  modules_.clear();
+  modules_without_cfi_.clear();
+  threads_.clear();
+}
+
+bool UnsymbolizedWalk::ModuleLackedCFI(int index) const {
+  return std::binary_search(modules_without_cfi_.begin(),
+                            modules_without_cfi_.end(), index);
+}
+
+}  // namespace google_breakpad
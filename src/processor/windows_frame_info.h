@@ -40,12 +40,16 @@
 #include <string.h>
 #include <stdlib.h>
 
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
+#include "common/scoped_ptr.h"
 #include "common/using_std_string.h"
 #include "google_breakpad/common/breakpad_types.h"
 #include "processor/logging.h"
+#include "processor/postfix_evaluator-inl.h"
 #include "processor/tokenize.h"
 
 namespace google_breakpad {
@@ -85,7 +89,8 @@ struct WindowsFrameInfo {
                      local_size(0),
                      max_stack_size(0),
                      allocates_base_pointer(0),
-                     program_string() {}
+                     program_string(),
+                     compiled_program_(new CompiledProgram) {}
 
   WindowsFrameInfo(StackInfoTypes type,
                  uint32_t set_prolog_size,
@@ -105,7 +110,8 @@ struct WindowsFrameInfo {
         local_size(set_local_size),
         max_stack_size(set_max_stack_size),
         allocates_base_pointer(set_allocates_base_pointer),
-        program_string(set_program_string) {}
+        program_string(set_program_string),
+        compiled_program_(new CompiledProgram) {}
 
   // Parse a textual serialization of a WindowsFrameInfo object from
   // a string. Returns NULL if parsing fails, or a new object
@@ -170,6 +176,7 @@ struct WindowsFrameInfo {
     max_stack_size = that.max_stack_size;
     allocates_base_pointer = that.allocates_base_pointer;
     program_string = that.program_string;
+    compiled_program_ = that.compiled_program_;
   }
 
   // Clears the WindowsFrameInfo object so that users will see it as though
@@ -178,6 +185,21 @@ struct WindowsFrameInfo {
     type_ = STACK_INFO_UNKNOWN;
     valid = VALID_NONE;
     program_string.erase();
+    compiled_program_.reset(new CompiledProgram);
+  }
+
+  // Returns program_string compiled for PostfixEvaluator.  The program is
+  // compiled on first use and shared by copies of this object, so that the
+  // copies a SourceLineResolver hands out for each frame only compile it
+  // once.  program_string must not be changed directly after this has been
+  // called.
+  const PostfixEvaluator<uint32_t>::Program& GetCompiledProgram() const {
+    CompiledProgram* compiled_program = compiled_program_.get();
+    std::call_once(compiled_program->compiled, [this, compiled_program]() {
+      compiled_program->program.reset(
+          new PostfixEvaluator<uint32_t>::Program(program_string));
+    });
+    return *compiled_program->program;
   }
 
   StackInfoTypes type_;
@@ -200,6 +222,14 @@ struct WindowsFrameInfo {
   // If program_string is empty, use allocates_base_pointer.
   bool allocates_base_pointer;
   string program_string;
+
+ private:
+  struct CompiledProgram {
+    std::once_flag compiled;
+    scoped_ptr<const PostfixEvaluator<uint32_t>::Program> program;
+  };
+
+  std::shared_ptr<CompiledProgram> compiled_program_;
 };
 
 }  // namespace google_breakpad
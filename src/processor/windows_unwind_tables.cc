@@ -0,0 +1,533 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// windows_unwind_tables.cc: Unwind x64 Windows frames with the unwind
+// information in the images themselves.
+//
+// See windows_unwind_tables.h for documentation.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include "processor/windows_unwind_tables.h"
+
+#include <algorithm>
+
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/code_module.h"
+#include "google_breakpad/processor/memory_region.h"
+#include "processor/cfi_frame_info.h"
+#include "processor/logging.h"
+
+namespace google_breakpad {
+
+using std::vector;
+
+namespace {
+
+// The names STACK CFI rules use for the registers that unwind codes
+// number.
+const char* const kRegisterNames[16] = {
+  "$rax", "$rcx", "$rdx", "$rbx", "$rsp", "$rbp", "$rsi", "$rdi",
+  "$r8", "$r9", "$r10", "$r11", "$r12", "$r13", "$r14", "$r15",
+};
+
+const int kRegisterRSP = 4;
+
+// The registers a Windows x64 function must preserve for its caller, but
+// which the System V ABI lets it change, so that the AMD64 walker doesn't
+// carry them over to the caller unless told to.
+const int kWindowsNonvolatileRegisters[] = { 6, 7 };
+
+// UNWIND_INFO flags and unwind operations.
+const uint8_t kFlagChainInfo = 0x4;
+enum UnwindOperation {
+  UWOP_PUSH_NONVOL = 0,
+  UWOP_ALLOC_LARGE = 1,
+  UWOP_ALLOC_SMALL = 2,
+  UWOP_SET_FPREG = 3,
+  UWOP_SAVE_NONVOL = 4,
+  UWOP_SAVE_NONVOL_FAR = 5,
+  UWOP_EPILOG = 6,
+  UWOP_SPARE_CODE = 7,
+  UWOP_SAVE_XMM128 = 8,
+  UWOP_SAVE_XMM128_FAR = 9,
+  UWOP_PUSH_MACHFRAME = 10,
+};
+
+// The longest chain of unwind information followed, and the most
+// instructions read looking for the end of an epilogue.
+const int kMaxChainLength = 32;
+const int kMaxEpilogueInstructions = 16;
+
+// Returns the postfix expression for expression plus offset.
+string Offset(const string& expression, int64_t offset) {
+  if (offset == 0)
+    return expression;
+  if (offset > 0)
+    return expression + " " + std::to_string(offset) + " +";
+  return expression + " " + std::to_string(-offset) + " -";
+}
+
+}  // namespace
+
+// Builds STACK CFI rules while following a frame's unwind operations, as
+// Windows' RtlVirtualUnwind follows them to change a context.  The stack
+// pointer is tracked as an expression in the callee's registers plus an
+// offset.
+class WindowsUnwindTables::RuleBuilder {
+ public:
+  RuleBuilder() : stack_base_(kRegisterNames[kRegisterRSP]),
+                  stack_offset_(0), popped_return_(false) {}
+
+  // Returns the expression for the address offset bytes above the stack
+  // pointer.
+  string StackAddress(int64_t offset) const {
+    return Offset(stack_base_, stack_offset_ + offset);
+  }
+
+  // Returns the expression for reg's value at this point of the unwind.
+  string Register(int reg) const {
+    std::map<int, string>::const_iterator rule = register_rules_.find(reg);
+    return rule == register_rules_.end() ? kRegisterNames[reg] : rule->second;
+  }
+
+  // Restores reg from the word at address.
+  void Load(int reg, const string& address) {
+    register_rules_[reg] = address + " ^";
+  }
+
+  void Pop(int reg) {
+    Load(reg, StackAddress(0));
+    stack_offset_ += 8;
+  }
+
+  void Release(int64_t size) { stack_offset_ += size; }
+
+  // Sets the stack pointer to address.
+  void SetStackPointer(const string& address) {
+    stack_base_ = address;
+    stack_offset_ = 0;
+  }
+
+  // Pops the return address and the stack pointer from a machine frame,
+  // which an interrupt or exception pushed.
+  void PopMachineFrame(bool error_code) {
+    const int64_t frame = error_code ? 8 : 0;
+    return_address_ = StackAddress(frame) + " ^";
+    SetStackPointer(StackAddress(frame + 24) + " ^");
+    popped_return_ = true;
+  }
+
+  // Returns the rules, popping the return address first unless a machine
+  // frame gave it.
+  CFIFrameInfo* Finish() {
+    if (!popped_return_) {
+      return_address_ = StackAddress(0) + " ^";
+      stack_offset_ += 8;
+    }
+    CFIFrameInfo* info = new CFIFrameInfo();
+    info->SetCFARule(StackAddress(0));
+    info->SetRARule(return_address_);
+    for (int reg : kWindowsNonvolatileRegisters)
+      info->SetRegisterRule(kRegisterNames[reg], kRegisterNames[reg]);
+    for (const std::pair<const int, string>& rule : register_rules_)
+      info->SetRegisterRule(kRegisterNames[rule.first], rule.second);
+    return info;
+  }
+
+ private:
+  string stack_base_;
+  int64_t stack_offset_;
+  std::map<int, string> register_rules_;
+  string return_address_;
+  bool popped_return_;
+};
+
+WindowsUnwindTables::WindowsUnwindTables(const MemoryRegion* process_memory)
+    : process_memory_(process_memory) {}
+
+WindowsUnwindTables::~WindowsUnwindTables() {}
+
+CFIFrameInfo* WindowsUnwindTables::FindCFIFrameInfo(const CodeModule* module,
+                                                    uint64_t rip,
+                                                    bool context_frame) {
+  if (!module)
+    return NULL;
+  const uint64_t base = module->base_address();
+  const FunctionTable* table = GetFunctionTable(base, module->size());
+  if (!table || table->empty())
+    return NULL;
+
+  // A return address may be just past the end of a function that ends
+  // with a call, so look up the call instruction instead.
+  const uint64_t lookup = context_frame ? rip : rip - 1;
+  if (lookup < base || lookup - base >= UINT32_MAX)
+    return NULL;
+  const uint32_t address = static_cast<uint32_t>(lookup - base);
+  FunctionTable::const_iterator function = std::upper_bound(
+      table->begin(), table->end(), address,
+      [](uint32_t address, const RuntimeFunction& function) {
+        return address < function.begin;
+      });
+  if (function == table->begin())
+    return NULL;
+  --function;
+  if (address >= function->end)
+    return NULL;
+
+  // Only the innermost frame can be in the middle of an epilogue; every
+  // other frame has called out of its function's body.
+  RuleBuilder rules;
+  if ((context_frame && AddEpilogueRules(base, *function, rip, &rules)) ||
+      AddPrologueRules(base, *function, rip - base - function->begin,
+                       &rules)) {
+    return rules.Finish();
+  }
+  return NULL;
+}
+
+const WindowsUnwindTables::FunctionTable*
+WindowsUnwindTables::GetFunctionTable(uint64_t base, uint64_t size) {
+  std::lock_guard<std::mutex> lock(function_tables_lock_);
+  std::unique_ptr<FunctionTable>& table = function_tables_[base];
+  if (!table) {
+    table.reset(new FunctionTable());
+    if (!ReadFunctionTable(base, size, table.get()))
+      table->clear();
+  }
+  return table.get();
+}
+
+bool WindowsUnwindTables::ReadFunctionTable(uint64_t base, uint64_t size,
+                                            FunctionTable* table) {
+  // The image's headers are at its base: the DOS header, which gives the
+  // offset of the PE header, the COFF file header and the PE32+ optional
+  // header, whose data directory locates the exception table.
+  uint16_t dos_magic;
+  uint32_t pe_offset;
+  if (!process_memory_->GetMemoryAtAddress(base, &dos_magic) ||
+      dos_magic != 0x5a4d ||
+      !process_memory_->GetMemoryAtAddress(base + 0x3c, &pe_offset)) {
+    return false;
+  }
+  const uint64_t pe_header = base + pe_offset;
+  const uint64_t optional_header = pe_header + 24;
+  uint32_t pe_signature;
+  uint16_t machine;
+  uint16_t optional_magic;
+  uint32_t directory_count;
+  uint32_t exception_rva;
+  uint32_t exception_size;
+  if (!process_memory_->GetMemoryAtAddress(pe_header, &pe_signature) ||
+      pe_signature != 0x4550 ||
+      !process_memory_->GetMemoryAtAddress(pe_header + 4, &machine) ||
+      machine != 0x8664 ||
+      !process_memory_->GetMemoryAtAddress(optional_header,
+                                           &optional_magic) ||
+      optional_magic != 0x20b ||
+      !process_memory_->GetMemoryAtAddress(optional_header + 108,
+                                           &directory_count) ||
+      directory_count < 4 ||
+      !process_memory_->GetMemoryAtAddress(optional_header + 136,
+                                           &exception_rva) ||
+      !process_memory_->GetMemoryAtAddress(optional_header + 140,
+                                           &exception_size)) {
+    return false;
+  }
+  if (exception_size == 0 ||
+      static_cast<uint64_t>(exception_rva) + exception_size > size) {
+    return false;
+  }
+
+  const uint32_t count = exception_size / 12;
+  table->reserve(count);
+  for (uint32_t index = 0; index < count; ++index) {
+    const uint64_t entry = base + exception_rva + index * 12;
+    RuntimeFunction function;
+    if (!process_memory_->GetMemoryAtAddress(entry, &function.begin) ||
+        !process_memory_->GetMemoryAtAddress(entry + 4, &function.end) ||
+        !process_memory_->GetMemoryAtAddress(entry + 8,
+                                             &function.unwind_info)) {
+      BPLOG(INFO) << "Unwind table of image at " << HexString(base)
+                  << " is not in memory";
+      return false;
+    }
+    if (function.begin < function.end && function.end <= size)
+      table->push_back(function);
+  }
+  // Linkers sort the table, but the lookup depends on it.
+  if (!std::is_sorted(table->begin(), table->end(),
+                      [](const RuntimeFunction& a, const RuntimeFunction& b) {
+                        return a.begin < b.begin;
+                      })) {
+    std::sort(table->begin(), table->end(),
+              [](const RuntimeFunction& a, const RuntimeFunction& b) {
+                return a.begin < b.begin;
+              });
+  }
+  return true;
+}
+
+bool WindowsUnwindTables::AddPrologueRules(uint64_t base,
+                                           const RuntimeFunction& function,
+                                           uint64_t offset,
+                                           RuleBuilder* rules) const {
+  RuntimeFunction current = function;
+  for (int chain = 0; chain < kMaxChainLength; ++chain) {
+    // An entry whose unwind information address is odd shares another
+    // entry's.
+    if (current.unwind_info & 1) {
+      const uint64_t entry = base + (current.unwind_info & ~1u);
+      if (!process_memory_->GetMemoryAtAddress(entry, &current.begin) ||
+          !process_memory_->GetMemoryAtAddress(entry + 4, &current.end) ||
+          !process_memory_->GetMemoryAtAddress(entry + 8,
+                                               &current.unwind_info)) {
+        return false;
+      }
+      continue;
+    }
+
+    // UNWIND_INFO: version and flags, size of prologue, count of unwind
+    // code slots, and frame register and scaled offset, then the codes.
+    const uint64_t info = base + current.unwind_info;
+    uint8_t version_flags, prologue_size, code_count, frame;
+    if (!process_memory_->GetMemoryAtAddress(info, &version_flags) ||
+        !process_memory_->GetMemoryAtAddress(info + 1, &prologue_size) ||
+        !process_memory_->GetMemoryAtAddress(info + 2, &code_count) ||
+        !process_memory_->GetMemoryAtAddress(info + 3, &frame)) {
+      return false;
+    }
+    const uint8_t version = version_flags & 0x7;
+    const uint8_t flags = version_flags >> 3;
+    if (version != 1 && version != 2)
+      return false;
+    const int frame_register = frame & 0xf;
+    const int64_t frame_offset = (frame >> 4) * 16;
+
+    vector<uint16_t> codes(code_count);
+    for (uint8_t slot = 0; slot < code_count; ++slot) {
+      if (!process_memory_->GetMemoryAtAddress(info + 4 + slot * 2,
+                                               &codes[slot])) {
+        return false;
+      }
+    }
+
+    // Chained unwind information describes the part of a prologue that
+    // the instruction is wholly past.
+    const bool whole_prologue = chain > 0 || offset >= prologue_size;
+    auto executed = [&](uint16_t code) {
+      return whole_prologue || (code & 0xff) <= offset;
+    };
+
+    // Saved registers are addressed from the frame pointer if the
+    // prologue has set it, and the stack pointer otherwise.
+    bool frame_set = false;
+    if (frame_register != 0) {
+      for (uint16_t code : codes) {
+        if (((code >> 8) & 0xf) == UWOP_SET_FPREG && executed(code))
+          frame_set = true;
+      }
+    }
+    const string frame_base = frame_set ?
+        Offset(rules->Register(frame_register), -frame_offset) :
+        rules->StackAddress(0);
+
+    for (size_t slot = 0; slot < codes.size(); ) {
+      const uint16_t code = codes[slot];
+      const int operation = (code >> 8) & 0xf;
+      const int operation_info = code >> 12;
+      size_t slots = 1;
+      switch (operation) {
+        case UWOP_ALLOC_LARGE:
+          slots = operation_info == 0 ? 2 : 3;
+          break;
+        case UWOP_SAVE_NONVOL:
+        case UWOP_SAVE_XMM128:
+        case UWOP_EPILOG:
+          slots = 2;
+          break;
+        case UWOP_SAVE_NONVOL_FAR:
+        case UWOP_SAVE_XMM128_FAR:
+        case UWOP_SPARE_CODE:
+          slots = 3;
+          break;
+      }
+      if (slot + slots > codes.size())
+        return false;
+      // Version 2 lists the function's epilogues among the codes.
+      if (operation == UWOP_EPILOG || !executed(code)) {
+        slot += slots;
+        continue;
+      }
+
+      switch (operation) {
+        case UWOP_PUSH_NONVOL:
+          rules->Pop(operation_info);
+          break;
+        case UWOP_ALLOC_LARGE:
+          if (operation_info == 0) {
+            rules->Release(codes[slot + 1] * 8);
+          } else {
+            rules->Release(codes[slot + 1] |
+                           static_cast<uint32_t>(codes[slot + 2]) << 16);
+          }
+          break;
+        case UWOP_ALLOC_SMALL:
+          rules->Release(operation_info * 8 + 8);
+          break;
+        case UWOP_SET_FPREG:
+          rules->SetStackPointer(
+              Offset(rules->Register(frame_register), -frame_offset));
+          break;
+        case UWOP_SAVE_NONVOL:
+          rules->Load(operation_info,
+                      Offset(frame_base, codes[slot + 1] * 8));
+          break;
+        case UWOP_SAVE_NONVOL_FAR:
+          rules->Load(operation_info,
+                      Offset(frame_base,
+                             codes[slot + 1] |
+                             static_cast<uint32_t>(codes[slot + 2]) << 16));
+          break;
+        case UWOP_SAVE_XMM128:
+        case UWOP_SAVE_XMM128_FAR:
+          break;
+        case UWOP_PUSH_MACHFRAME:
+          rules->PopMachineFrame(operation_info != 0);
+          break;
+        default:
+          BPLOG(INFO) << "Unknown unwind operation " << operation
+                      << " at " << HexString(info);
+          return false;
+      }
+      slot += slots;
+    }
+
+    if (!(flags & kFlagChainInfo))
+      return true;
+    const uint64_t chained = info + 4 + ((code_count + 1) & ~1) * 2;
+    if (!process_memory_->GetMemoryAtAddress(chained, &current.begin) ||
+        !process_memory_->GetMemoryAtAddress(chained + 4, &current.end) ||
+        !process_memory_->GetMemoryAtAddress(chained + 8,
+                                             &current.unwind_info)) {
+      return false;
+    }
+  }
+  BPLOG(INFO) << "Unwind information chained too deeply in image at "
+              << HexString(base);
+  return false;
+}
+
+bool WindowsUnwindTables::AddEpilogueRules(uint64_t base,
+                                           const RuntimeFunction& function,
+                                           uint64_t rip,
+                                           RuleBuilder* rules) const {
+  // An epilogue is an optional "add rsp, imm" or "lea rsp, [reg + disp]",
+  // then "pop reg" instructions, then "ret".  Read the instructions from
+  // rip, and accept them only if they reach the ret.
+  const uint64_t end = base + function.end;
+  uint64_t address = rip;
+  auto read = [&](uint8_t* byte) {
+    return address < end &&
+        process_memory_->GetMemoryAtAddress(address++, byte);
+  };
+
+  RuleBuilder epilogue;
+  uint8_t byte;
+  if (!read(&byte))
+    return false;
+  if (byte == 0x48 || byte == 0x49) {
+    const bool base_extended = byte == 0x49;
+    uint8_t opcode, modrm;
+    if (!read(&opcode) || !read(&modrm))
+      return false;
+    if (!base_extended && (opcode == 0x83 || opcode == 0x81) &&
+        modrm == 0xc4) {
+      // add rsp, imm8 or add rsp, imm32.
+      int64_t size = 0;
+      for (int i = 0; i < (opcode == 0x83 ? 1 : 4); ++i) {
+        uint8_t immediate;
+        if (!read(&immediate))
+          return false;
+        size |= static_cast<int64_t>(immediate) << (i * 8);
+      }
+      if (opcode == 0x83)
+        size = static_cast<int8_t>(size);
+      epilogue.Release(size);
+    } else if (opcode == 0x8d && (modrm & 0x38) == 0x20 &&
+               (modrm & 0x7) != 4 &&
+               ((modrm & 0xc0) == 0x40 || (modrm & 0xc0) == 0x80)) {
+      // lea rsp, [reg + disp8] or lea rsp, [reg + disp32].
+      const int reg = (modrm & 0x7) + (base_extended ? 8 : 0);
+      int64_t displacement = 0;
+      const int size = (modrm & 0xc0) == 0x40 ? 1 : 4;
+      for (int i = 0; i < size; ++i) {
+        uint8_t immediate;
+        if (!read(&immediate))
+          return false;
+        displacement |= static_cast<int64_t>(immediate) << (i * 8);
+      }
+      displacement = size == 1 ? static_cast<int8_t>(displacement) :
+          static_cast<int32_t>(displacement);
+      epilogue.SetStackPointer(Offset(kRegisterNames[reg], displacement));
+    } else {
+      return false;
+    }
+    if (!read(&byte))
+      return false;
+  }
+
+  for (int instruction = 0; instruction < kMaxEpilogueInstructions;
+       ++instruction) {
+    if (byte >= 0x58 && byte <= 0x5f) {
+      epilogue.Pop(byte - 0x58);
+    } else if (byte == 0x41) {
+      if (!read(&byte) || byte < 0x58 || byte > 0x5f)
+        return false;
+      epilogue.Pop(byte - 0x58 + 8);
+    } else if (byte == 0xf3) {
+      // rep ret.
+      if (!read(&byte) || byte != 0xc3)
+        return false;
+      *rules = epilogue;
+      return true;
+    } else if (byte == 0xc3) {
+      *rules = epilogue;
+      return true;
+    } else {
+      return false;
+    }
+    if (!read(&byte))
+      return false;
+  }
+  return false;
+}
+
+}  // namespace google_breakpad
@@ -0,0 +1,119 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// windows_unwind_tables.h: Unwind x64 Windows frames with the unwind
+// information in the images themselves.
+//
+// Every x64 PE image carries a table of RUNTIME_FUNCTION entries in its
+// .pdata section, describing with UNWIND_INFO records in .xdata how each
+// function's prologue changed the stack and the nonvolatile registers.
+// Windows unwinds with nothing else, so for a module without symbols these
+// tables are as good as STACK CFI, and far better than stack scanning.
+// Minidumps carry them when they include the module's memory.
+//
+// See
+// https://learn.microsoft.com/en-us/cpp/build/exception-handling-x64
+
+#ifndef PROCESSOR_WINDOWS_UNWIND_TABLES_H__
+#define PROCESSOR_WINDOWS_UNWIND_TABLES_H__
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "google_breakpad/common/breakpad_types.h"
+
+namespace google_breakpad {
+
+class CFIFrameInfo;
+class CodeModule;
+class MemoryRegion;
+
+class WindowsUnwindTables {
+ public:
+  // process_memory reads the memory of the process whose images are to be
+  // unwound; its base and size are not used.  It must outlive this object.
+  explicit WindowsUnwindTables(const MemoryRegion* process_memory);
+  WindowsUnwindTables(const WindowsUnwindTables&) = delete;
+  void operator=(const WindowsUnwindTables&) = delete;
+  ~WindowsUnwindTables();
+
+  // Returns rules for recovering the registers of the caller of the frame
+  // whose instruction pointer is rip, in module, or NULL if module is not an
+  // x64 image whose unwind information is in memory, or has none for rip.
+  // context_frame is true for the innermost frame, which may have stopped
+  // in a function's prologue or epilogue; other frames are at return
+  // addresses.  The caller takes ownership of the returned rules.  This may
+  // be called by several stack walkers at once.
+  CFIFrameInfo* FindCFIFrameInfo(const CodeModule* module, uint64_t rip,
+                                 bool context_frame);
+
+ private:
+  // A RUNTIME_FUNCTION entry: the function's extent and the location of
+  // its UNWIND_INFO, relative to the image's base address.
+  struct RuntimeFunction {
+    uint32_t begin;
+    uint32_t end;
+    uint32_t unwind_info;
+  };
+
+  // An image's RUNTIME_FUNCTION entries, sorted by begin.  Empty if the
+  // image has none or they couldn't be read.
+  typedef std::vector<RuntimeFunction> FunctionTable;
+
+  class RuleBuilder;
+
+  // Returns the function table of the image at base, reading it the first
+  // time.
+  const FunctionTable* GetFunctionTable(uint64_t base, uint64_t size);
+
+  // Reads the function table of the image at base into table.
+  bool ReadFunctionTable(uint64_t base, uint64_t size, FunctionTable* table);
+
+  // Adds the rules for undoing function's prologue, from the instruction
+  // at offset within it, and those of any functions its unwind information
+  // is chained to.  Returns false if the unwind information can't be read.
+  bool AddPrologueRules(uint64_t base, const RuntimeFunction& function,
+                        uint64_t offset, RuleBuilder* rules) const;
+
+  // Adds the rules for finishing the epilogue that rip, within function,
+  // is in, and returns true, or returns false if rip is not in one.
+  bool AddEpilogueRules(uint64_t base, const RuntimeFunction& function,
+                        uint64_t rip, RuleBuilder* rules) const;
+
+  const MemoryRegion* process_memory_;
+
+  // Guards function_tables_.  Tables are never changed once read.
+  std::mutex function_tables_lock_;
+  std::map<uint64_t, std::unique_ptr<FunctionTable>> function_tables_;
+};
+
+}  // namespace google_breakpad
+
+#endif  // PROCESSOR_WINDOWS_UNWIND_TABLES_H__
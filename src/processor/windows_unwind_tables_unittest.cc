@@ -0,0 +1,305 @@
+// Copyright 2026 Google LLC
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are
+// met:
+//
+//     * Redistributions of source code must retain the above copyright
+// notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above
+// copyright notice, this list of conditions and the following disclaimer
+// in the documentation and/or other materials provided with the
+// distribution.
+//     * Neither the name of Google LLC nor the names of its
+// contributors may be used to endorse or promote products derived from
+// this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+// A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+// OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+// LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+// DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+// THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+// windows_unwind_tables_unittest.cc: Unit tests for WindowsUnwindTables.
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>  // Must come first
+#endif
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "breakpad_googletest_includes.h"
+#include "common/using_std_string.h"
+#include "google_breakpad/processor/memory_region.h"
+#include "processor/basic_code_module.h"
+#include "processor/cfi_frame_info.h"
+#include "processor/windows_unwind_tables.h"
+
+namespace {
+
+using google_breakpad::BasicCodeModule;
+using google_breakpad::CFIFrameInfo;
+using google_breakpad::MemoryRegion;
+using google_breakpad::WindowsUnwindTables;
+using std::vector;
+
+// Sparse little-endian memory, holding an image and a stack.
+class FakeProcessMemory : public MemoryRegion {
+ public:
+  void Set8(uint64_t address, uint8_t value) { bytes_[address] = value; }
+  void Set16(uint64_t address, uint16_t value) { Set(address, value, 2); }
+  void Set32(uint64_t address, uint32_t value) { Set(address, value, 4); }
+  void Set64(uint64_t address, uint64_t value) { Set(address, value, 8); }
+  void SetBytes(uint64_t address, const vector<uint8_t>& bytes) {
+    for (size_t i = 0; i < bytes.size(); ++i)
+      bytes_[address + i] = bytes[i];
+  }
+
+  uint64_t GetBase() const override { return 0; }
+  uint32_t GetSize() const override { return UINT32_MAX; }
+  bool GetMemoryAtAddress(uint64_t address, uint8_t* value) const override {
+    return Get(address, value);
+  }
+  bool GetMemoryAtAddress(uint64_t address, uint16_t* value) const override {
+    return Get(address, value);
+  }
+  bool GetMemoryAtAddress(uint64_t address, uint32_t* value) const override {
+    return Get(address, value);
+  }
+  bool GetMemoryAtAddress(uint64_t address, uint64_t* value) const override {
+    return Get(address, value);
+  }
+  void Print() const override {}
+
+ private:
+  void Set(uint64_t address, uint64_t value, int size) {
+    for (int i = 0; i < size; ++i)
+      bytes_[address + i] = static_cast<uint8_t>(value >> (i * 8));
+  }
+
+  template<typename T> bool Get(uint64_t address, T* value) const {
+    uint64_t result = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) {
+      std::map<uint64_t, uint8_t>::const_iterator byte =
+          bytes_.find(address + i);
+      if (byte == bytes_.end())
+        return false;
+      result |= static_cast<uint64_t>(byte->second) << (i * 8);
+    }
+    *value = static_cast<T>(result);
+    return true;
+  }
+
+  std::map<uint64_t, uint8_t> bytes_;
+};
+
+const uint64_t kBase = 0x140000000ULL;
+const uint64_t kImageSize = 0x10000;
+const uint64_t kStack = 0x7ff000ULL;
+
+// Unwind operations and register numbers.
+enum { PUSH_NONVOL = 0, ALLOC_SMALL = 2, SET_FPREG = 3, SAVE_NONVOL = 4 };
+enum { RBX = 3, RBP = 5, RSI = 6, R12 = 12 };
+
+uint16_t Code(uint8_t offset, int operation, int info) {
+  return static_cast<uint16_t>(offset | operation << 8 | info << 12);
+}
+
+class WindowsUnwindTablesTest : public ::testing::Test {
+ public:
+  WindowsUnwindTablesTest()
+      : module_(kBase, kImageSize, "test.dll", "", "test.pdb", "", ""),
+        tables_(&memory_) {}
+
+  void SetUp() override {
+    // DOS header, PE header and PE32+ optional header, with the exception
+    // directory at 0x3000.
+    memory_.Set16(kBase, 0x5a4d);
+    memory_.Set32(kBase + 0x3c, 0x80);
+    memory_.Set32(kBase + 0x80, 0x4550);
+    memory_.Set16(kBase + 0x84, 0x8664);
+    memory_.Set16(kBase + 0x98, 0x20b);
+    memory_.Set32(kBase + 0x98 + 108, 16);
+    memory_.Set32(kBase + 0x98 + 136, 0x3000);
+  }
+
+  // Adds the function [begin, end) with the given unwind information at
+  // info to the exception directory.
+  void AddFunction(uint32_t begin, uint32_t end, uint32_t info) {
+    const uint64_t entry = kBase + 0x3000 + function_count_ * 12;
+    memory_.Set32(entry, begin);
+    memory_.Set32(entry + 4, end);
+    memory_.Set32(entry + 8, info);
+    ++function_count_;
+    memory_.Set32(kBase + 0x98 + 140, function_count_ * 12);
+  }
+
+  // Writes UNWIND_INFO at info, returning the address just past its codes,
+  // where chained unwind information goes.
+  uint64_t SetUnwindInfo(uint32_t info, int flags, uint8_t prologue_size,
+                         int frame_register, int frame_offset,
+                         const vector<uint16_t>& codes) {
+    const uint64_t address = kBase + info;
+    memory_.Set8(address, static_cast<uint8_t>(1 | flags << 3));
+    memory_.Set8(address + 1, prologue_size);
+    memory_.Set8(address + 2, static_cast<uint8_t>(codes.size()));
+    memory_.Set8(address + 3,
+                 static_cast<uint8_t>(frame_register | frame_offset << 4));
+    for (size_t i = 0; i < codes.size(); ++i)
+      memory_.Set16(address + 4 + i * 2, codes[i]);
+    return address + 4 + ((codes.size() + 1) & ~1) * 2;
+  }
+
+  // The function at 0x1000 pushes rbp and rbx and allocates 0x28 bytes.
+  void AddPushingFunction() {
+    AddFunction(0x1000, 0x1100, 0x2000);
+    SetUnwindInfo(0x2000, 0, 6, 0, 0,
+                  {Code(6, ALLOC_SMALL, 4), Code(2, PUSH_NONVOL, RBX),
+                   Code(1, PUSH_NONVOL, RBP)});
+  }
+
+  // Unwinds the frame at rip with the registers in registers, returning
+  // false if there are no rules for it.
+  bool Unwind(uint64_t rip, bool context_frame,
+              const CFIFrameInfo::RegisterValueMap<uint64_t>& registers,
+              CFIFrameInfo::RegisterValueMap<uint64_t>* caller) {
+    std::unique_ptr<CFIFrameInfo> rules(
+        tables_.FindCFIFrameInfo(&module_, rip, context_frame));
+    return rules && rules->FindCallerRegs(registers, memory_, caller);
+  }
+
+  FakeProcessMemory memory_;
+  BasicCodeModule module_;
+  WindowsUnwindTables tables_;
+  uint32_t function_count_ = 0;
+};
+
+TEST_F(WindowsUnwindTablesTest, Body) {
+  AddPushingFunction();
+  memory_.Set64(kStack + 0x28, 0xb0b0);
+  memory_.Set64(kStack + 0x30, 0xba5e);
+  memory_.Set64(kStack + 0x38, kBase + 0x4321);
+
+  CFIFrameInfo::RegisterValueMap<uint64_t> registers, caller;
+  registers["$rsp"] = kStack;
+  registers["$rsi"] = 0x5151;
+  ASSERT_TRUE(Unwind(kBase + 0x1050, true, registers, &caller));
+  EXPECT_EQ(kBase + 0x4321, caller[".ra"]);
+  EXPECT_EQ(kStack + 0x40, caller[".cfa"]);
+  EXPECT_EQ(0xb0b0U, caller["$rbx"]);
+  EXPECT_EQ(0xba5eU, caller["$rbp"]);
+  // Nonvolatile registers the function doesn't save are unchanged.
+  EXPECT_EQ(0x5151U, caller["$rsi"]);
+}
+
+TEST_F(WindowsUnwindTablesTest, Prologue) {
+  AddPushingFunction();
+  // Stopped after pushing rbp and rbx, but before allocating.
+  memory_.Set64(kStack, 0xb0b0);
+  memory_.Set64(kStack + 8, 0xba5e);
+  memory_.Set64(kStack + 16, kBase + 0x4321);
+
+  CFIFrameInfo::RegisterValueMap<uint64_t> registers, caller;
+  registers["$rsp"] = kStack;
+  ASSERT_TRUE(Unwind(kBase + 0x1002, true, registers, &caller));
+  EXPECT_EQ(kBase + 0x4321, caller[".ra"]);
+  EXPECT_EQ(kStack + 24, caller[".cfa"]);
+  EXPECT_EQ(0xb0b0U, caller["$rbx"]);
+  EXPECT_EQ(0xba5eU, caller["$rbp"]);
+}
+
+TEST_F(WindowsUnwindTablesTest, Epilogue) {
+  AddPushingFunction();
+  // add rsp, 0x28; pop rbx; pop rbp; ret.
+  memory_.SetBytes(kBase + 0x10f0,
+                   {0x48, 0x83, 0xc4, 0x28, 0x5b, 0x5d, 0xc3});
+  // Stopped at pop rbp.
+  memory_.Set64(kStack, 0xba5e);
+  memory_.Set64(kStack + 8, kBase + 0x4321);
+
+  CFIFrameInfo::RegisterValueMap<uint64_t> registers, caller;
+  registers["$rsp"] = kStack;
+  ASSERT_TRUE(Unwind(kBase + 0x10f5, true, registers, &caller));
+  EXPECT_EQ(kBase + 0x4321, caller[".ra"]);
+  EXPECT_EQ(kStack + 16, caller[".cfa"]);
+  EXPECT_EQ(0xba5eU, caller["$rbp"]);
+  // rbx is already restored.
+  EXPECT_EQ(0U, caller.count("$rbx"));
+
+  // A caller's frame is never in an epilogue, even at a return address
+  // that looks like one.
+  memory_.Set64(kStack + 0x28, 0xb0b0);
+  memory_.Set64(kStack + 0x30, 0xba5e);
+  memory_.Set64(kStack + 0x38, kBase + 0x4321);
+  ASSERT_TRUE(Unwind(kBase + 0x10f5, false, registers, &caller));
+  EXPECT_EQ(kStack + 0x40, caller[".cfa"]);
+}
+
+TEST_F(WindowsUnwindTablesTest, FramePointer) {
+  // push rbp; sub rsp, 0x40; lea rbp, [rsp + 0x20]; mov [rsp + 0x30], rsi.
+  AddFunction(0x1100, 0x1200, 0x2100);
+  SetUnwindInfo(0x2100, 0, 15, RBP, 2,
+                {Code(15, SAVE_NONVOL, RSI), 6, Code(10, SET_FPREG, 0),
+                 Code(5, ALLOC_SMALL, 7), Code(1, PUSH_NONVOL, RBP)});
+  memory_.Set64(kStack + 0x30, 0x5151);
+  memory_.Set64(kStack + 0x40, 0xba5e);
+  memory_.Set64(kStack + 0x48, kBase + 0x4321);
+
+  // The function has since moved the stack pointer, as alloca would.
+  CFIFrameInfo::RegisterValueMap<uint64_t> registers, caller;
+  registers["$rsp"] = kStack - 0x100;
+  registers["$rbp"] = kStack + 0x20;
+  ASSERT_TRUE(Unwind(kBase + 0x1180, false, registers, &caller));
+  EXPECT_EQ(kBase + 0x4321, caller[".ra"]);
+  EXPECT_EQ(kStack + 0x50, caller[".cfa"]);
+  EXPECT_EQ(0x5151U, caller["$rsi"]);
+  EXPECT_EQ(0xba5eU, caller["$rbp"]);
+}
+
+TEST_F(WindowsUnwindTablesTest, ChainedUnwindInfo) {
+  AddPushingFunction();
+  // A fragment of the function at 0x1000 that also pushes r12.
+  AddFunction(0x1200, 0x1300, 0x2200);
+  uint64_t chained =
+      SetUnwindInfo(0x2200, 0x4, 2, 0, 0, {Code(2, PUSH_NONVOL, R12)});
+  memory_.Set32(chained, 0x1000);
+  memory_.Set32(chained + 4, 0x1100);
+  memory_.Set32(chained + 8, 0x2000);
+  memory_.Set64(kStack, 0x1212);
+  memory_.Set64(kStack + 0x30, 0xb0b0);
+  memory_.Set64(kStack + 0x38, 0xba5e);
+  memory_.Set64(kStack + 0x40, kBase + 0x4321);
+
+  CFIFrameInfo::RegisterValueMap<uint64_t> registers, caller;
+  registers["$rsp"] = kStack;
+  ASSERT_TRUE(Unwind(kBase + 0x1250, false, registers, &caller));
+  EXPECT_EQ(kBase + 0x4321, caller[".ra"]);
+  EXPECT_EQ(kStack + 0x48, caller[".cfa"]);
+  EXPECT_EQ(0x1212U, caller["$r12"]);
+  EXPECT_EQ(0xb0b0U, caller["$rbx"]);
+  EXPECT_EQ(0xba5eU, caller["$rbp"]);
+}
+
+TEST_F(WindowsUnwindTablesTest, NoUnwindInformation) {
+  AddPushingFunction();
+  CFIFrameInfo::RegisterValueMap<uint64_t> registers, caller;
+  registers["$rsp"] = kStack;
+  // Outside any function.
+  EXPECT_FALSE(Unwind(kBase + 0x1180, false, registers, &caller));
+
+  // Not an x64 image.
+  FakeProcessMemory other_memory;
+  WindowsUnwindTables other_tables(&other_memory);
+  EXPECT_EQ(NULL, other_tables.FindCFIFrameInfo(&module_, kBase + 0x1050,
+                                                true));
+}
+
+}  // namespace
@@ -39,27 +39,259 @@
 #include <sys/types.h>
 #include <syslog.h>
 #include <unistd.h>
+
+#include <algorithm>
 #include <sstream>
+#include <vector>
 
 #include "client/linux/minidump_writer/linux_core_dumper.h"
 #include "client/linux/minidump_writer/minidump_writer.h"
+#include "common/linux/eintr_wrapper.h"
+#include "common/linux/elf_core_dump.h"
+#include "common/memory_range.h"
 #include "common/path_helper.h"
 #include "common/scoped_ptr.h"
 
 namespace {
 
 using google_breakpad::AppMemoryList;
+using google_breakpad::ElfCoreDump;
 using google_breakpad::LinuxCoreDumper;
+using google_breakpad::MappingInfo;
 using google_breakpad::MappingList;
+using google_breakpad::MemoryRange;
+using google_breakpad::ThreadInfo;
 using google_breakpad::scoped_array;
 
-// Size of the core dump to read in order to access all the threads
-// descriptions.
-//
-// The first section is the note0 section which contains the thread states. On
-// x86-64 a typical thread description take about 1432B. Reading 1 MB allows
-// several hundreds of threads.
-const int core_read_size = 1024 * 1024;
+// The core dump arrives on the standard input in file order: the ELF
+// header, the program headers, the notes, which describe the threads, and
+// then the memory of each PT_LOAD segment. It is read once. The notes are
+// kept whole, and of the memory only the thread stacks and the starts of
+// the modules' mappings, which hold their ELF headers and build ids. These
+// go into a condensed core dump in a memfd, which is converted to a
+// minidump. Anything else the minidump writer needs, such as the dynamic
+// linker's module list, is read from /proc/<pid>/mem, since the kernel
+// keeps the process until it has piped the rest of the core dump.
+
+// Bytes at the start of each module's mapping to keep. The kernel usually
+// dumps only the first page of a file mapping.
+const size_t kModuleHeaderLength = 64 * 1024;
+
+// Bytes to read at a time when skipping over the core dump.
+const size_t kSkipBufferSize = 64 * 1024;
+
+// Reads a core dump from a pipe, which can only be read forward.
+class CoreStream {
+ public:
+  explicit CoreStream(int fd)
+      : fd_(fd), position_(0), buffer_(new char[kSkipBufferSize]) {}
+
+  // The offset in the core dump of the next byte to read.
+  off_t position() const { return position_; }
+
+  // Reads |length| bytes into |buffer|. Returns false if they could not
+  // all be read.
+  bool Read(void* buffer, size_t length) {
+    char* data = static_cast<char*>(buffer);
+    while (length > 0) {
+      const ssize_t r = HANDLE_EINTR(read(fd_, data, length));
+      if (r <= 0)
+        return false;
+      data += r;
+      length -= r;
+      position_ += r;
+    }
+    return true;
+  }
+
+  // Reads and drops the bytes up to |offset|. Returns false if |offset|
+  // has been passed or could not be reached.
+  bool SkipTo(off_t offset) {
+    if (offset < position_)
+      return false;
+    while (position_ < offset) {
+      const size_t length =
+          std::min<off_t>(offset - position_, kSkipBufferSize);
+      if (!Read(buffer_.get(), length))
+        return false;
+    }
+    return true;
+  }
+
+  // Reads |length| bytes and writes them to |out_fd| at |out_offset|.
+  bool CopyTo(int out_fd, off_t out_offset, size_t length) {
+    while (length > 0) {
+      const size_t chunk = std::min(length, kSkipBufferSize);
+      if (!Read(buffer_.get(), chunk) ||
+          HANDLE_EINTR(pwrite(out_fd, buffer_.get(), chunk, out_offset)) !=
+              static_cast<ssize_t>(chunk)) {
+        return false;
+      }
+      out_offset += chunk;
+      length -= chunk;
+    }
+    return true;
+  }
+
+ private:
+  const int fd_;
+  off_t position_;
+  scoped_array<char> buffer_;
+};
+
+// A range of the crashed process's memory to keep.
+struct KeptRange {
+  uintptr_t start;
+  uintptr_t end;
+
+  bool operator<(const KeptRange& other) const { return start < other.start; }
+};
+
+// A piece of a PT_LOAD segment to keep: |length| bytes at |address| in the
+// process, found at |offset| in the piped core dump and written at
+// |new_offset| in the condensed one.
+struct KeptPiece {
+  ElfCoreDump::Addr address;
+  off_t offset;
+  size_t length;
+  off_t new_offset;
+};
+
+// Orders program headers by their data's offset in the core dump.
+bool ComesBefore(const ElfCoreDump::Phdr& a, const ElfCoreDump::Phdr& b) {
+  return a.p_offset < b.p_offset;
+}
+
+// Writes a core dump to |fd| with the identity of |header|, the |notes|
+// and a PT_LOAD segment for each of |pieces|, setting their |new_offset|.
+// The segments' data is left for the caller to write there.
+bool WriteCondensedCore(int fd, const ElfCoreDump::Ehdr& header,
+                        const std::vector<char>& notes,
+                        std::vector<KeptPiece>* pieces) {
+  ElfCoreDump::Ehdr new_header = header;
+  new_header.e_phoff = sizeof(new_header);
+  new_header.e_phentsize = sizeof(ElfCoreDump::Phdr);
+  new_header.e_phnum = 1 + pieces->size();
+  new_header.e_shoff = 0;
+  new_header.e_shentsize = 0;
+  new_header.e_shnum = 0;
+  new_header.e_shstrndx = 0;
+
+  std::vector<ElfCoreDump::Phdr> programs(new_header.e_phnum);
+  memset(&programs[0], 0, programs.size() * sizeof(programs[0]));
+  off_t offset = sizeof(new_header) + programs.size() * sizeof(programs[0]);
+  programs[0].p_type = PT_NOTE;
+  programs[0].p_offset = offset;
+  programs[0].p_filesz = notes.size();
+  offset += notes.size();
+  for (size_t i = 0; i < pieces->size(); ++i) {
+    KeptPiece* piece = &(*pieces)[i];
+    piece->new_offset = offset;
+    ElfCoreDump::Phdr* program = &programs[i + 1];
+    program->p_type = PT_LOAD;
+    program->p_offset = offset;
+    program->p_vaddr = piece->address;
+    program->p_filesz = program->p_memsz = piece->length;
+    program->p_flags = PF_R;
+    offset += piece->length;
+  }
+
+  if (ftruncate(fd, 0) != 0)
+    return false;
+  const ssize_t programs_size = programs.size() * sizeof(programs[0]);
+  return HANDLE_EINTR(pwrite(fd, &new_header, sizeof(new_header), 0)) ==
+             static_cast<ssize_t>(sizeof(new_header)) &&
+         HANDLE_EINTR(pwrite(fd, &programs[0], programs_size,
+                             new_header.e_phoff)) == programs_size &&
+         (notes.empty() ||
+          HANDLE_EINTR(pwrite(fd, &notes[0], notes.size(),
+                              programs[0].p_offset)) ==
+              static_cast<ssize_t>(notes.size()));
+}
+
+// Finds the memory worth keeping with a dumper that has the notes and
+// /proc/<pid>: the thread stacks and the starts of the modules.
+bool FindKeptRanges(const char* core_path, const char* procfs_dir,
+                    std::vector<KeptRange>* ranges) {
+  LinuxCoreDumper dumper(0, core_path, procfs_dir);
+  if (!dumper.Init())
+    return false;
+
+  for (size_t i = 0; i < dumper.threads().size(); ++i) {
+    ThreadInfo info;
+    const void* stack;
+    size_t stack_len;
+    if (dumper.GetThreadInfoByIndex(i, &info) &&
+        dumper.GetStackInfo(&stack, &stack_len, info.stack_pointer)) {
+      const uintptr_t start = reinterpret_cast<uintptr_t>(stack);
+      KeptRange range = { start, start + stack_len };
+      ranges->push_back(range);
+    }
+  }
+  for (size_t i = 0; i < dumper.mappings().size(); ++i) {
+    const MappingInfo& mapping = *dumper.mappings()[i];
+    if (mapping.offset != 0 || !mapping.name[0])
+      continue;
+    const uintptr_t start = mapping.system_mapping_info.start_addr;
+    const uintptr_t end = mapping.system_mapping_info.end_addr;
+    KeptRange range = { start, start + std::min(end - start,
+                                                kModuleHeaderLength) };
+    ranges->push_back(range);
+  }
+
+  // Sort and merge the ranges.
+  std::sort(ranges->begin(), ranges->end());
+  size_t merged = 0;
+  for (size_t i = 0; i < ranges->size(); ++i) {
+    if (merged && (*ranges)[i].start <= (*ranges)[merged - 1].end) {
+      (*ranges)[merged - 1].end =
+          std::max((*ranges)[merged - 1].end, (*ranges)[i].end);
+    } else {
+      (*ranges)[merged++] = (*ranges)[i];
+    }
+  }
+  ranges->resize(merged);
+  return true;
+}
+
+// Finds the pieces of the PT_LOAD segments among |programs|, which are
+// sorted by offset, that hold any of |ranges|, in the order they come in
+// the core dump.
+void FindKeptPieces(const std::vector<ElfCoreDump::Phdr>& programs,
+                    const std::vector<KeptRange>& ranges,
+                    std::vector<KeptPiece>* pieces) {
+  off_t end_of_previous = 0;
+  for (size_t i = 0; i < programs.size(); ++i) {
+    const ElfCoreDump::Phdr& program = programs[i];
+    if (program.p_type != PT_LOAD || !program.p_filesz)
+      continue;
+    // The core dump is read only once, so data that overlaps what came
+    // before is left to /proc/<pid>/mem.
+    if (static_cast<off_t>(program.p_offset) < end_of_previous)
+      continue;
+    end_of_previous = program.p_offset + program.p_filesz;
+
+    const uintptr_t start = program.p_vaddr;
+    const uintptr_t end = start + program.p_filesz;
+    KeptRange key = { start, start };
+    std::vector<KeptRange>::const_iterator range =
+        std::upper_bound(ranges.begin(), ranges.end(), key);
+    if (range != ranges.begin())
+      --range;
+    for (; range != ranges.end() && range->start < end; ++range) {
+      const uintptr_t piece_start = std::max(start, range->start);
+      const uintptr_t piece_end = std::min(end, range->end);
+      if (piece_start >= piece_end)
+        continue;
+      KeptPiece piece;
+      piece.address = piece_start;
+      piece.offset = program.p_offset + (piece_start - start);
+      piece.length = piece_end - piece_start;
+      piece.new_offset = 0;
+      pieces->push_back(piece);
+    }
+  }
+}
 
 void ShowUsage(const char* argv0) {
   fprintf(stderr, "Usage: %s <process id> <minidump file>\n\n",
@@ -84,26 +316,37 @@ bool WriteMinidumpFromCore(const char* filename,
 }
 
 bool HandleCrash(pid_t pid, const char* procfs_dir, const char* md_filename) {
-  int r = 0;
-  scoped_array<char> buf(new char[core_read_size]);
-  while (r != core_read_size) {
-    int ret = read(STDIN_FILENO, &buf[r], core_read_size - r);
-    if (ret == 0) {
-      break;
-    } else if (ret == -1) {
-      return false;
-    }
-    r += ret;
+  CoreStream core(STDIN_FILENO);
+
+  ElfCoreDump::Ehdr header;
+  if (!core.Read(&header, sizeof(header)) ||
+      !ElfCoreDump(MemoryRange(&header, sizeof(header))).IsValid() ||
+      header.e_phentsize != sizeof(ElfCoreDump::Phdr) ||
+      header.e_phnum == PN_XNUM) {
+    return false;
   }
 
-  int fd = memfd_create("core_file", MFD_CLOEXEC);
-  if (fd == -1) {
+  std::vector<ElfCoreDump::Phdr> programs(header.e_phnum);
+  if (programs.empty() ||
+      !core.SkipTo(header.e_phoff) ||
+      !core.Read(&programs[0], programs.size() * sizeof(programs[0]))) {
     return false;
   }
+  std::stable_sort(programs.begin(), programs.end(), ComesBefore);
 
-  int w = write(fd, &buf[0], r);
-  if (w != r) {
-    close(fd);
+  std::vector<ElfCoreDump::Phdr>::const_iterator note = programs.begin();
+  while (note != programs.end() && note->p_type != PT_NOTE)
+    ++note;
+  if (note == programs.end())
+    return false;
+  std::vector<char> notes(note->p_filesz);
+  if (!core.SkipTo(note->p_offset) ||
+      (!notes.empty() && !core.Read(&notes[0], notes.size()))) {
+    return false;
+  }
+
+  int fd = memfd_create("core_file", MFD_CLOEXEC);
+  if (fd == -1) {
     return false;
   }
 
@@ -111,6 +354,29 @@ bool HandleCrash(pid_t pid, const char* procfs_dir, const char* md_filename) {
   core_file_ss << "/proc/self/fd/" << fd;
   std::string core_file(core_file_ss.str());
 
+  // Find what to keep with a core dump of just the notes, then write the
+  // condensed core dump over it while reading the memory.
+  std::vector<KeptRange> ranges;
+  std::vector<KeptPiece> pieces;
+  std::vector<KeptPiece> no_pieces;
+  if (!WriteCondensedCore(fd, header, notes, &no_pieces) ||
+      !FindKeptRanges(core_file.c_str(), procfs_dir, &ranges)) {
+    close(fd);
+    return false;
+  }
+  FindKeptPieces(programs, ranges, &pieces);
+  if (!WriteCondensedCore(fd, header, notes, &pieces)) {
+    close(fd);
+    return false;
+  }
+  for (size_t i = 0; i < pieces.size(); ++i) {
+    if (!core.SkipTo(pieces[i].offset) ||
+        !core.CopyTo(fd, pieces[i].new_offset, pieces[i].length)) {
+      close(fd);
+      return false;
+    }
+  }
+
   if (!WriteMinidumpFromCore(md_filename, core_file.c_str(), procfs_dir)) {
     close(fd);
     return false;
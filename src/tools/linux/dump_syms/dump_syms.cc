@@ -32,16 +32,26 @@
 
 #include <paths.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 #include <cstring>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 
+#include "common/compressing_streambuf.h"
+#include "common/language.h"
 #include "common/linux/dump_symbols.h"
 #include "common/path_helper.h"
+#include "common/scoped_ptr.h"
+#include "processor/module_serializer.h"
 
+using google_breakpad::CompressingStreambuf;
+using google_breakpad::ModuleSerializer;
+using google_breakpad::scoped_array;
 using google_breakpad::WriteSymbolFile;
 using google_breakpad::WriteSymbolFileHeader;
 
@@ -66,9 +76,39 @@ int usage(const char* self) {
   fprintf(stderr, "  -m          Enable writing the optional 'm' field on FUNC "
                                  "and PUBLIC, denoting multiple symbols for "
                                  "the address.\n");
+  fprintf(stderr, "  -j <N>      Read debugging information on N "
+                                 "threads\n");
+  fprintf(stderr, "  -s <N>      Hold at most N CFI entries in memory, "
+                                 "spilling the rest to a temporary file\n");
+  fprintf(stderr, "  -f <N>      Hold at most N functions in memory, "
+                                 "spilling sorted runs to temporary files\n");
+  fprintf(stderr, "  -C <dir>    Cache what is read from each compilation "
+                                 "unit in dir, and reuse it in later runs\n");
+  fprintf(stderr, "  -A <addr>   Output only what describes the module-relative "
+                                 "hex address addr; may be repeated\n");
+  fprintf(stderr, "  -F          Output the serialized form "
+                                 "FastSourceLineResolver loads, rather than "
+                                 "a text symbol file\n");
+  fprintf(stderr, "  -z <format> Compress the output with format, gzip or "
+                                 "zstd, on the -j threads\n");
   return 1;
 }
 
+// Convert SYMBOL_DATA, a text symbol file, to the form
+// FastSourceLineResolver loads, and write that to STREAM, as sym_to_fast
+// would have.  The text never leaves memory.  Return false on failure.
+static bool WriteFastSymbolData(string symbol_data, std::ostream& stream) {
+  // SerializeSymbolFileData parses the data in place, terminator included.
+  ModuleSerializer serializer;
+  size_t serialized_size;
+  scoped_array<char> serialized(serializer.SerializeSymbolFileData(
+      &symbol_data[0], symbol_data.size() + 1, &serialized_size));
+  if (!serialized.get())
+    return false;
+  return static_cast<bool>(
+      stream.write(serialized.get(), serialized_size).flush());
+}
+
 int main(int argc, char** argv) {
   if (argc < 2)
     return usage(argv[0]);
@@ -79,6 +119,14 @@ int main(int argc, char** argv) {
   bool handle_inter_cu_refs = true;
   bool log_to_stderr = false;
   bool enable_multiple_field = false;
+  bool fast_format = false;
+  bool compress = false;
+  CompressingStreambuf::Format compression_format = CompressingStreambuf::GZIP;
+  int num_threads = 1;
+  size_t stack_frame_entry_limit = 0;
+  size_t function_limit = 0;
+  std::string dwarf_cache_dir;
+  std::vector<uint64_t> addresses;
   std::string obj_name;
   std::string module_id;
   const char* obj_os = "Linux";
@@ -120,6 +168,68 @@ int main(int argc, char** argv) {
       ++arg_index;
     } else if (strcmp("-m", argv[arg_index]) == 0) {
       enable_multiple_field = true;
+    } else if (strcmp("-j", argv[arg_index]) == 0) {
+      if (arg_index + 1 >= argc) {
+        fprintf(stderr, "Missing argument to -j\n");
+        return usage(argv[0]);
+      }
+      num_threads = atoi(argv[arg_index + 1]);
+      if (num_threads < 1) {
+        fprintf(stderr, "Invalid argument to -j\n");
+        return usage(argv[0]);
+      }
+      ++arg_index;
+    } else if (strcmp("-s", argv[arg_index]) == 0) {
+      if (arg_index + 1 >= argc) {
+        fprintf(stderr, "Missing argument to -s\n");
+        return usage(argv[0]);
+      }
+      stack_frame_entry_limit = strtoul(argv[arg_index + 1], NULL, 10);
+      ++arg_index;
+    } else if (strcmp("-f", argv[arg_index]) == 0) {
+      if (arg_index + 1 >= argc) {
+        fprintf(stderr, "Missing argument to -f\n");
+        return usage(argv[0]);
+      }
+      function_limit = strtoul(argv[arg_index + 1], NULL, 10);
+      ++arg_index;
+    } else if (strcmp("-C", argv[arg_index]) == 0) {
+      if (arg_index + 1 >= argc) {
+        fprintf(stderr, "Missing argument to -C\n");
+        return usage(argv[0]);
+      }
+      dwarf_cache_dir = argv[arg_index + 1];
+      ++arg_index;
+    } else if (strcmp("-A", argv[arg_index]) == 0) {
+      if (arg_index + 1 >= argc) {
+        fprintf(stderr, "Missing argument to -A\n");
+        return usage(argv[0]);
+      }
+      char* end;
+      addresses.push_back(strtoull(argv[arg_index + 1], &end, 16));
+      if (*end != '\0') {
+        fprintf(stderr, "Invalid argument to -A\n");
+        return usage(argv[0]);
+      }
+      ++arg_index;
+    } else if (strcmp("-F", argv[arg_index]) == 0) {
+      fast_format = true;
+    } else if (strcmp("-z", argv[arg_index]) == 0) {
+      if (arg_index + 1 >= argc) {
+        fprintf(stderr, "Missing argument to -z\n");
+        return usage(argv[0]);
+      }
+      if (!CompressingStreambuf::ParseFormat(argv[arg_index + 1],
+                                             &compression_format)) {
+        fprintf(stderr, "Invalid argument to -z\n");
+        return usage(argv[0]);
+      }
+      if (!CompressingStreambuf::IsSupported(compression_format)) {
+        fprintf(stderr, "This build cannot write %s\n", argv[arg_index + 1]);
+        return 1;
+      }
+      compress = true;
+      ++arg_index;
     } else {
       printf("2.4 %s\n", argv[arg_index]);
       return usage(argv[0]);
@@ -148,8 +258,19 @@ int main(int argc, char** argv) {
   if (obj_name.empty())
     obj_name = binary;
 
+  // With -z, everything written to std::cout is written compressed to
+  // stdout instead, without the text ever reaching the disk.
+  std::unique_ptr<CompressingStreambuf> compressor;
+  std::unique_ptr<std::ostream> compressed_stream;
+  if (compress) {
+    compressor.reset(
+        new CompressingStreambuf(stdout, compression_format, num_threads));
+    compressed_stream.reset(new std::ostream(compressor.get()));
+  }
+  std::ostream& output = compress ? *compressed_stream : std::cout;
+
   if (header_only) {
-    if (!WriteSymbolFileHeader(binary, obj_name, obj_os, module_id, std::cout)) {
+    if (!WriteSymbolFileHeader(binary, obj_name, obj_os, module_id, output)) {
       fprintf(saved_stderr, "Failed to process file.\n");
       return 1;
     }
@@ -158,12 +279,33 @@ int main(int argc, char** argv) {
                              (cfi ? CFI : NO_DATA) | SYMBOLS_AND_FILES;
     google_breakpad::DumpOptions options(symbol_data, handle_inter_cu_refs,
                                          enable_multiple_field, preserve_load_address);
+    options.num_threads = num_threads;
+    options.stack_frame_entry_limit = stack_frame_entry_limit;
+    options.function_limit = function_limit;
+    options.dwarf_cache_dir = dwarf_cache_dir;
+    options.addresses = addresses;
+    std::ostringstream symbol_text;
     if (!WriteSymbolFile(binary, obj_name, obj_os, module_id, debug_dirs, options,
-                         std::cout)) {
+                         fast_format ? symbol_text : output)) {
       fprintf(saved_stderr, "Failed to write symbol file.\n");
       return 1;
     }
+    if (fast_format && !WriteFastSymbolData(symbol_text.str(), output)) {
+      fprintf(saved_stderr, "Failed to serialize symbol file.\n");
+      return 1;
+    }
+    // Only visible with -v; stderr goes to /dev/null otherwise.
+    uint64_t demangle_lookups, demangle_hits;
+    google_breakpad::Language::GetDemangleCacheStats(&demangle_lookups,
+                                                     &demangle_hits);
+    fprintf(stderr, "Demangled %llu names, %llu from the cache.\n",
+            static_cast<unsigned long long>(demangle_lookups),
+            static_cast<unsigned long long>(demangle_hits));
   }
 
+  if (compressor && !compressor->Finish()) {
+    fprintf(saved_stderr, "Failed to write compressed symbol file.\n");
+    return 1;
+  }
   return 0;
 }
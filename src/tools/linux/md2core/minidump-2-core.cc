@@ -36,11 +36,13 @@
 
 #include <elf.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
 #include <link.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <sys/user.h>
 #include <unistd.h>
 
@@ -51,7 +53,6 @@
 #include "common/linux/memory_mapped_file.h"
 #include "common/minidump_type_helper.h"
 #include "common/path_helper.h"
-#include "common/scoped_ptr.h"
 #include "common/using_std_string.h"
 #include "google_breakpad/common/breakpad_types.h"
 #include "google_breakpad/common/minidump_format.h"
@@ -222,6 +223,78 @@ writea(int fd, const void* idata, size_t length) {
   return true;
 }
 
+// Writes the memory contents of the core, each at the offset laid out for
+// it in the program headers. A regular file is written with pwrite()
+// straight from the minidump's mapping and is left sparse wherever there is
+// no data, such as the padding around each mapping's contents. Anything
+// else, such as a pipe, is written in order with zeros filling the gaps.
+class SegmentWriter {
+ public:
+  // |position| is the offset in the core that the next write() to |fd|
+  // will land at.
+  SegmentWriter(int fd, size_t position)
+      : fd_(fd), seekable_(false), base_(0), position_(position) {
+    struct stat st;
+    const off_t current = lseek(fd, 0, SEEK_CUR);
+    const int flags = fcntl(fd, F_GETFL);
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && current != -1 &&
+        flags != -1 && !(flags & O_APPEND)) {
+      seekable_ = true;
+      base_ = current - position;
+    }
+  }
+
+  // Writes |length| bytes of |data| at |offset| in the core. Offsets must
+  // not go backwards.
+  bool WriteAt(size_t offset, const char* data, size_t length) {
+    if (offset < position_)
+      return false;
+    if (!seekable_) {
+      return WriteZeros(offset - position_) && writea(fd_, data, length) &&
+             (position_ += length, true);
+    }
+    size_t done = 0;
+    while (done < length) {
+      ssize_t r;
+      do {
+        r = pwrite(fd_, data + done, length - done, base_ + offset + done);
+      } while (r == -1 && errno == EINTR);
+      if (r < 1)
+        return false;
+      done += r;
+    }
+    position_ = offset + length;
+    return true;
+  }
+
+  // Ends the core at |size| bytes.
+  bool Finish(size_t size) {
+    if (size < position_)
+      return false;
+    if (seekable_)
+      return ftruncate(fd_, base_ + size) == 0;
+    return WriteZeros(size - position_);
+  }
+
+ private:
+  bool WriteZeros(size_t length) {
+    static const char kZeros[4096] = { 0 };
+    while (length > 0) {
+      const size_t chunk = length < sizeof(kZeros) ? length : sizeof(kZeros);
+      if (!writea(fd_, kZeros, chunk))
+        return false;
+      position_ += chunk;
+      length -= chunk;
+    }
+    return true;
+  }
+
+  const int fd_;
+  bool seekable_;
+  off_t base_;
+  size_t position_;
+};
+
 /* Dynamically determines the byte sex of the system. Returns non-zero
  * for big-endian machines.
  */
@@ -295,14 +368,32 @@ struct CrashedProcess {
       : permissions(0xFFFFFFFF),
         start_address(0),
         end_address(0),
-        offset(0) {
+        offset(0),
+        data_offset(0),
+        data(NULL),
+        data_length(0),
+        file_offset(0) {
+    }
+
+    // The number of bytes this mapping takes up in the core: its data,
+    // padded to whole pages.
+    size_t file_size() const {
+      const size_t size = data_offset + data_length;
+      return size ? (size + 4095) & ~4095 : 0;
     }
 
     uint32_t permissions;
     uint64_t start_address, end_address, offset;
     // The name we write out to the core.
     string filename;
-    string data;
+    // The contents we write out to the core: |data_length| bytes at |data|,
+    // which points into the minidump or at data held by CrashedProcess,
+    // |data_offset| bytes into the first page.
+    size_t data_offset;
+    const char* data;
+    size_t data_length;
+    // Where the contents go in the core.
+    size_t file_offset;
   };
   std::map<uint64_t, Mapping> mappings;
 
@@ -345,6 +436,8 @@ struct CrashedProcess {
   std::map<uintptr_t, Signature> signatures;
 
   string dynamic_data;
+  // The link map that AugmentMappings builds for the core.
+  string link_map_data;
   MDRawDebug debug;
   std::vector<MDRawLinkMap> link_map;
 };
@@ -1149,7 +1242,7 @@ ParseModuleStream(const Options& options, CrashedProcess* crashinfo,
 }
 
 static void
-AddDataToMapping(CrashedProcess* crashinfo, const string& data,
+AddDataToMapping(CrashedProcess* crashinfo, const char* data, size_t length,
                  uintptr_t addr) {
   for (std::map<uint64_t, CrashedProcess::Mapping>::iterator
          iter = crashinfo->mappings.begin();
@@ -1180,8 +1273,9 @@ AddDataToMapping(CrashedProcess* crashinfo, const string& data,
       // file. But it is OK if the mapping itself extends past the end of
       // the data.
       mapping.start_address = addr & ~4095;
-      mapping.data.assign(addr & 4095, 0).append(data);
-      mapping.data.append(-mapping.data.size() & 4095, 0);
+      mapping.data_offset = addr & 4095;
+      mapping.data = data;
+      mapping.data_length = length;
       crashinfo->mappings[mapping.start_address] = mapping;
       return;
     }
@@ -1191,9 +1285,10 @@ AddDataToMapping(CrashedProcess* crashinfo, const string& data,
   mapping.permissions = PF_R | PF_W;
   mapping.start_address = addr & ~4095;
   mapping.end_address =
-    (addr + data.size() + 4095) & ~4095;
-  mapping.data.assign(addr & 4095, 0).append(data);
-  mapping.data.append(-mapping.data.size() & 4095, 0);
+    (addr + length + 4095) & ~4095;
+  mapping.data_offset = addr & 4095;
+  mapping.data = data;
+  mapping.data_length = length;
   crashinfo->mappings[mapping.start_address] = mapping;
 }
 
@@ -1204,16 +1299,15 @@ AugmentMappings(const Options& options, CrashedProcess* crashinfo,
   // Then adjust the mapping to include the stack dump.
   for (unsigned i = 0; i < crashinfo->threads.size(); ++i) {
     const CrashedProcess::Thread& thread = crashinfo->threads[i];
-    AddDataToMapping(crashinfo,
-                     string((char*)thread.stack, thread.stack_length),
-                     thread.stack_addr);
+    AddDataToMapping(crashinfo, (const char*)thread.stack,
+                     thread.stack_length, thread.stack_addr);
   }
 
   // Create a new link map with information about DSOs. We move this map to
   // the beginning of the address space, as this area should always be
   // available.
   static const uintptr_t start_addr = 4096;
-  string data;
+  string& data = crashinfo->link_map_data;
   struct r_debug debug = { 0 };
   debug.r_version = crashinfo->debug.version;
   debug.r_brk = (ElfW(Addr))crashinfo->debug.brk;
@@ -1298,7 +1392,7 @@ AugmentMappings(const Options& options, CrashedProcess* crashinfo,
     data.append(filename);
     data.append(8 - (filename.size() & 7), 0);
   }
-  AddDataToMapping(crashinfo, data, start_addr);
+  AddDataToMapping(crashinfo, data.data(), data.size(), start_addr);
 
   // Map the page containing the _DYNAMIC array
   if (!crashinfo->dynamic_data.empty()) {
@@ -1324,7 +1418,8 @@ AugmentMappings(const Options& options, CrashedProcess* crashinfo,
         goto no_dt_debug;
       }
     }
-    AddDataToMapping(crashinfo, crashinfo->dynamic_data,
+    AddDataToMapping(crashinfo, crashinfo->dynamic_data.data(),
+                     crashinfo->dynamic_data.size(),
                      (uintptr_t)crashinfo->debug.dynamic);
   } else {
     fprintf(stderr, "dynamic data empty\n");
@@ -1495,12 +1590,13 @@ main(int argc, const char* argv[]) {
   size_t note_align = phdr.p_align - ((offset+filesz) % phdr.p_align);
   if (note_align == phdr.p_align)
     note_align = 0;
+  const size_t notes_end = offset + filesz;
   offset += note_align;
 
-  for (std::map<uint64_t, CrashedProcess::Mapping>::const_iterator iter =
+  for (std::map<uint64_t, CrashedProcess::Mapping>::iterator iter =
          crashinfo.mappings.begin();
        iter != crashinfo.mappings.end(); ++iter) {
-    const CrashedProcess::Mapping& mapping = iter->second;
+    CrashedProcess::Mapping& mapping = iter->second;
     if (mapping.permissions == 0xFFFFFFFF) {
       // This is a map that we found in MD_MODULE_LIST_STREAM (as opposed to
       // MD_LINUX_MAPS). It lacks some of the information that we would like
@@ -1511,11 +1607,12 @@ main(int argc, const char* argv[]) {
     }
     phdr.p_vaddr = mapping.start_address;
     phdr.p_memsz = mapping.end_address - mapping.start_address;
-    if (mapping.data.size()) {
+    if (mapping.file_size()) {
       offset += filesz;
-      filesz = mapping.data.size();
-      phdr.p_filesz = mapping.data.size();
+      filesz = mapping.file_size();
+      phdr.p_filesz = mapping.file_size();
       phdr.p_offset = offset;
+      mapping.file_offset = offset;
     } else {
       phdr.p_filesz = 0;
       phdr.p_offset = 0;
@@ -1582,22 +1679,21 @@ main(int argc, const char* argv[]) {
       WriteThread(options, current_thread, 0);
   }
 
-  if (note_align) {
-    google_breakpad::scoped_array<char> scratch(new char[note_align]);
-    memset(scratch.get(), 0, note_align);
-    if (!writea(options.out_fd, scratch.get(), note_align))
-      return 1;
-  }
-
+  SegmentWriter segments(options.out_fd, notes_end);
+  size_t end = notes_end + note_align;
   for (std::map<uint64_t, CrashedProcess::Mapping>::const_iterator iter =
          crashinfo.mappings.begin();
        iter != crashinfo.mappings.end(); ++iter) {
     const CrashedProcess::Mapping& mapping = iter->second;
-    if (mapping.data.size()) {
-      if (!writea(options.out_fd, mapping.data.c_str(), mapping.data.size()))
+    if (mapping.file_size()) {
+      if (!segments.WriteAt(mapping.file_offset + mapping.data_offset,
+                            mapping.data, mapping.data_length))
         return 1;
+      end = mapping.file_offset + mapping.file_size();
     }
   }
+  if (!segments.Finish(end))
+    return 1;
 
   if (options.out_fd != STDOUT_FILENO) {
     close(options.out_fd);
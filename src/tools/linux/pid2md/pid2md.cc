@@ -40,20 +40,40 @@
 #include "common/path_helper.h"
 
 int main(int argc, char* argv[]) {
-  if (argc != 3) {
-    fprintf(stderr, "Usage: %s <process id> <minidump file>\n\n",
+  bool low_pause = false;
+  bool bad_option = false;
+  int ch;
+  while ((ch = getopt(argc, argv, "l")) != -1) {
+    switch (ch) {
+      case 'l':
+        low_pause = true;
+        break;
+      default:
+        bad_option = true;
+        break;
+    }
+  }
+
+  if (bad_option || argc - optind != 2) {
+    fprintf(stderr, "Usage: %s [-l] <process id> <minidump file>\n\n",
             google_breakpad::BaseName(argv[0]).c_str());
     fprintf(stderr,
             "A tool to generate a minidump from a running process. The process "
             "resumes its\nactivity once the operation is completed. Permission "
-            "to trace the process is\nrequired.\n");
+            "to trace the process is\nrequired.\n\n"
+            "  -l  Stop the process only while the registers of its threads "
+            "and the tops of\n      their stacks are read, and read the rest "
+            "while it runs. Memory that may\n      not match is listed in "
+            "an MD_LINUX_INCONSISTENT_MEMORY stream.\n");
     return EXIT_FAILURE;
   }
 
-  pid_t process_id = atoi(argv[1]);
-  const char* minidump_file = argv[2];
+  pid_t process_id = atoi(argv[optind]);
+  const char* minidump_file = argv[optind + 1];
 
-  if (!google_breakpad::WriteMinidump(minidump_file, process_id, process_id)) {
+  if (!google_breakpad::WriteMinidump(minidump_file, process_id, process_id,
+                                      google_breakpad::AppMemoryList(),
+                                      low_pause)) {
     fprintf(stderr, "Unable to generate minidump.\n");
     return EXIT_FAILURE;
   }
@@ -50,12 +50,15 @@
 using google_breakpad::HTTPUpload;
 
 struct Options {
+  Options() : deflate(false), success(false) {}
+
   string minidumpPath;
   string uploadURLStr;
   string product;
   string version;
   string proxy;
   string proxy_user_pwd;
+  bool deflate;
   bool success;
 };
 
@@ -77,6 +80,7 @@ static void Start(Options *options) {
                                          options->proxy,
                                          options->proxy_user_pwd,
                                          "",
+                                         options->deflate,
                                          &response,
                                          NULL,
                                          &error);
@@ -107,6 +111,7 @@ Usage(int argc, const char *argv[]) {
   fprintf(stderr, "-v:\t <version> Product version\n");
   fprintf(stderr, "-x:\t <host[:port]> Use HTTP proxy on given port\n");
   fprintf(stderr, "-u:\t <user[:password]> Set proxy user and password\n");
+  fprintf(stderr, "-z:\t Compress the upload with deflate content encoding\n");
   fprintf(stderr, "-h:\t Usage\n");
   fprintf(stderr, "-?:\t Usage\n");
 }
@@ -117,7 +122,7 @@ SetupOptions(int argc, const char *argv[], Options *options) {
   extern int optind;
   int ch;
 
-  while ((ch = getopt(argc, (char * const*)argv, "p:u:v:x:h?")) != -1) {
+  while ((ch = getopt(argc, (char * const*)argv, "p:u:v:x:zh?")) != -1) {
     switch (ch) {
       case 'p':
         options->product = optarg;
@@ -131,6 +136,9 @@ SetupOptions(int argc, const char *argv[], Options *options) {
       case 'x':
         options->proxy = optarg;
         break;
+      case 'z':
+        options->deflate = true;
+        break;
 
       default:
         fprintf(stderr, "Invalid option '%c'\n", ch);
@@ -81,6 +81,15 @@ Usage(int argc, const char *argv[]) {
   fprintf(stderr, "-v:\t Version information (e.g., 1.2.3.4)\n");
   fprintf(stderr, "-x:\t <host[:port]> Use HTTP proxy on given port\n");
   fprintf(stderr, "-u:\t <user[:password]> Set proxy user and password\n");
+  fprintf(stderr, "-z:\t Compress the upload with deflate content encoding "
+          "('sym-upload-v1' only)\n");
+  fprintf(stderr, "-b:\t Batch mode: <symbol-file> is a directory, all of "
+          "whose .sym files are uploaded, or a manifest listing one symbol "
+          "file per line.\n");
+  fprintf(stderr, "-j:\t <jobs> Number of uploads to run at once in batch "
+          "mode (default 8).\n");
+  fprintf(stderr, "-r:\t <retries> Number of times to retry a failed upload "
+          "in batch mode (default 3).\n");
   fprintf(stderr, "-h:\t Usage\n");
   fprintf(stderr, "-?:\t Usage\n");
   fprintf(stderr, "\n");
@@ -107,6 +116,9 @@ Usage(int argc, const char *argv[]) {
   fprintf(stderr, "    [Defaulting to symbol type 'BREAKPAD']\n");
   fprintf(stderr, "    %s -p sym-upload-v2 -k mysecret123! "
       "path/to/symbol_file http://myuploadserver\n", argv[0]);
+  fprintf(stderr, "    [Upload every .sym file under a directory]\n");
+  fprintf(stderr, "    %s -p sym-upload-v2 -k mysecret123! -b -j 16 "
+      "path/to/symbols_dir http://myuploadserver\n", argv[0]);
   fprintf(stderr, "    [Explicitly set symbol type to 'elf']\n");
   fprintf(stderr, "    %s -p sym-upload-v2 -k mysecret123! -t elf "
       "-c app -i 11111111BBBB3333DDDD555555555555F "
@@ -118,7 +130,7 @@ static void
 SetupOptions(int argc, const char *argv[], Options *options) {
   extern int optind, optopt;
   int ch;
-  constexpr char flag_pattern[] = "u:v:x:p:k:t:c:i:hf?";
+  constexpr char flag_pattern[] = "u:v:x:p:k:t:c:i:j:r:bhfz?";
 
   while ((ch = getopt(argc, (char * const*)argv, flag_pattern)) != -1) {
     switch (ch) {
@@ -169,6 +181,28 @@ SetupOptions(int argc, const char *argv[], Options *options) {
       case 'f':
         options->force = true;
         break;
+      case 'z':
+        options->deflate = true;
+        break;
+      case 'b':
+        options->batch = true;
+        break;
+      case 'j':
+        options->jobs = atoi(optarg);
+        if (options->jobs < 1) {
+          fprintf(stderr, "Invalid number of jobs '%s'\n", optarg);
+          Usage(argc, argv);
+          exit(1);
+        }
+        break;
+      case 'r':
+        options->retries = atoi(optarg);
+        if (options->retries < 0) {
+          fprintf(stderr, "Invalid number of retries '%s'\n", optarg);
+          Usage(argc, argv);
+          exit(1);
+        }
+        break;
 
       default:
         fprintf(stderr, "Invalid option '%c'\n", ch);
@@ -195,6 +229,14 @@ SetupOptions(int argc, const char *argv[], Options *options) {
     Usage(argc, argv);
     exit(1);
   }
+  if (!is_breakpad_upload && options->batch) {
+    fprintf(stderr, "\n");
+    fprintf(stderr, "%s: batch mode only uploads breakpad symbol files.\n",
+        argv[0]);
+    fprintf(stderr, "\n");
+    Usage(argc, argv);
+    exit(1);
+  }
   if (!is_breakpad_upload && (!has_code_file || !has_debug_id)) {
     fprintf(stderr, "\n");
     fprintf(stderr, "%s: -c and -i must be specified for non-breakpad "
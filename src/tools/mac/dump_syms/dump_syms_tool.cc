@@ -39,16 +39,21 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <utility>
 #include <vector>
 
+#include "common/compressing_streambuf.h"
 #include "common/mac/dump_syms.h"
 #include "common/mac/arch_utilities.h"
 #include "common/mac/macho_utilities.h"
 #include "common/scoped_ptr.h"
 
+using google_breakpad::CompressingStreambuf;
 using google_breakpad::DumpSymbols;
 using google_breakpad::Module;
 using google_breakpad::scoped_ptr;
@@ -68,8 +73,47 @@ struct Options {
   string module_name;
   bool prefer_extern_name = false;
   bool report_warnings = false;
+  int num_threads = 1;
+  string output_dir;
+  bool shared_cache = false;
+  bool compress = false;
+  CompressingStreambuf::Format compression_format = CompressingStreambuf::GZIP;
 };
 
+// Call |write| with a stream for the symbol file |path|, or for standard
+// output if |path| is empty. With -z, the stream compresses what is
+// written to it on |num_threads| threads, and the compression format's
+// extension is appended to |path|.
+static bool WriteOutput(const Options& options, const string& path,
+                        int num_threads,
+                        const std::function<bool(std::ostream&)>& write) {
+  if (!options.compress) {
+    if (path.empty())
+      return write(std::cout);
+    std::ofstream stream(path.c_str());
+    return stream.is_open() && write(stream) && stream.flush();
+  }
+
+  FILE* file = stdout;
+  if (!path.empty()) {
+    string compressed_path =
+        path + CompressingStreambuf::FileExtension(options.compression_format);
+    file = fopen(compressed_path.c_str(), "wb");
+    if (!file)
+      return false;
+  }
+  bool written;
+  {
+    CompressingStreambuf buffer(file, options.compression_format,
+                                num_threads);
+    std::ostream stream(&buffer);
+    written = write(stream) && buffer.Finish();
+  }
+  if (file != stdout && fclose(file) != 0)
+    written = false;
+  return written;
+}
+
 static bool StackFrameEntryComparator(const Module::StackFrameEntry* a,
                                       const Module::StackFrameEntry* b) {
   return a->address < b->address;
@@ -139,6 +183,147 @@ static bool SetArchitecture(DumpSymbols& dump_symbols,
   return true;
 }
 
+// Return true if |module|, read from a dSYM, and |cfi_module|, read from
+// the Mach-O file the dSYM describes, are for the same code file. If they
+// are not, report how they differ.
+static bool SplitModulesMatch(const Options& options, const Module* module,
+                              const Module* cfi_module) {
+  bool name_matches;
+  if (!options.module_name.empty()) {
+    // Ignore the basename of the dSYM and binary and use the passed-in module
+    // name.
+    name_matches = true;
+  } else {
+    name_matches = cfi_module->name() == module->name();
+  }
+
+  // Ensure that the modules are for the same debug code file.
+  if (!name_matches || cfi_module->os() != module->os() ||
+      cfi_module->architecture() != module->architecture() ||
+      cfi_module->identifier() != module->identifier()) {
+    fprintf(stderr, "Cannot generate a symbol file from split sources that do"
+                    " not match.\n");
+    if (!name_matches) {
+      fprintf(stderr, "Name mismatch: binary=[%s], dSYM=[%s]\n",
+              cfi_module->name().c_str(), module->name().c_str());
+    }
+    if (cfi_module->os() != module->os()) {
+      fprintf(stderr, "OS mismatch: binary=[%s], dSYM=[%s]\n",
+              cfi_module->os().c_str(), module->os().c_str());
+    }
+    if (cfi_module->architecture() != module->architecture()) {
+      fprintf(stderr, "Architecture mismatch: binary=[%s], dSYM=[%s]\n",
+              cfi_module->architecture().c_str(),
+              module->architecture().c_str());
+    }
+    if (cfi_module->identifier() != module->identifier()) {
+      fprintf(stderr, "Identifier mismatch: binary=[%s], dSYM=[%s]\n",
+              cfi_module->identifier().c_str(), module->identifier().c_str());
+    }
+    return false;
+  }
+  return true;
+}
+
+// Read every architecture in |dump_symbols|' file concurrently, and write
+// each one's symbol file to |options.output_dir|, named for the module and
+// the architecture. If |split_module| is true, |dump_symbols| has read the
+// dSYM, and each architecture's CFI data is merged in from the same
+// architecture of the Mach-O file.
+static bool DumpAllArchitectures(const Options& options,
+                                 DumpSymbols& dump_symbols,
+                                 bool split_module,
+                                 SymbolData symbol_data) {
+  vector<std::unique_ptr<Module>> modules;
+  bool result = dump_symbols.ReadAllSymbolData(&modules);
+
+  if (split_module) {
+    if (!dump_symbols.Read(options.srcPath))
+      return false;
+    vector<std::unique_ptr<Module>> cfi_modules;
+    result = dump_symbols.ReadAllSymbolData(&cfi_modules) && result;
+    for (std::unique_ptr<Module>& module : modules) {
+      if (!module)
+        continue;
+      const Module* cfi_module = NULL;
+      for (const std::unique_ptr<Module>& candidate : cfi_modules) {
+        if (candidate && candidate->architecture() == module->architecture())
+          cfi_module = candidate.get();
+      }
+      if (!cfi_module) {
+        fprintf(stderr, "%s: no architecture '%s' is present in file.\n",
+                options.srcPath.c_str(), module->architecture().c_str());
+        module.reset();
+        result = false;
+      } else if (!SplitModulesMatch(options, module.get(), cfi_module)) {
+        module.reset();
+        result = false;
+      } else {
+        CopyCFIDataBetweenModules(module.get(), cfi_module);
+      }
+    }
+  }
+
+  for (const std::unique_ptr<Module>& module : modules) {
+    if (!module)
+      continue;
+    string path = options.output_dir + "/" + module->name() + "." +
+        module->architecture() + ".sym";
+    if (!WriteOutput(options, path, options.num_threads,
+                     [&](std::ostream& stream) {
+                       return module->Write(stream, symbol_data);
+                     })) {
+      fprintf(stderr, "Failed to write symbol file %s\n", path.c_str());
+      result = false;
+    }
+  }
+  return result;
+}
+
+// Return a file name that encodes some of |install_name|: the initial of
+// each directory, followed by the basename, as upload_system_symbols names
+// the symbol files it dumps. For example, /usr/lib/system/libxpc.dylib
+// becomes ulslibxpc.dylib.
+static string MangleInstallName(const string& install_name) {
+  string mangled;
+  size_t start = 0;
+  for (size_t slash = install_name.find('/'); slash != string::npos;
+       slash = install_name.find('/', start)) {
+    if (slash > start)
+      mangled += install_name[start];
+    start = slash + 1;
+  }
+  return mangled + install_name.substr(start);
+}
+
+// Read every image in the dyld shared cache |options.srcPath|
+// concurrently, and write each one's symbol file to |options.output_dir|.
+static bool DumpSharedCache(const Options& options,
+                            DumpSymbols& dump_symbols,
+                            SymbolData symbol_data) {
+  if (!dump_symbols.ReadSharedCache(options.srcPath))
+    return false;
+
+  std::atomic<bool> written(true);
+  bool read = dump_symbols.ReadSharedCacheSymbolData(
+      [&](const string& install_name, std::unique_ptr<Module> module) {
+        if (!module)
+          return;
+        string path = options.output_dir + "/" +
+            MangleInstallName(install_name) + "_" + module->architecture() +
+            ".sym";
+        // Images are written concurrently already, so compress each one on
+        // the thread that read it.
+        if (!WriteOutput(options, path, 1, [&](std::ostream& stream) {
+              return module->Write(stream, symbol_data);
+            })) {
+          fprintf(stderr, "Failed to write symbol file %s\n", path.c_str());
+          written = false;
+        }
+      });
+  return read && written;
+}
+
 static bool Start(const Options& options) {
   SymbolData symbol_data =
       (options.handle_inlines ? INLINES : NO_DATA) |
@@ -161,17 +346,28 @@ static bool Start(const Options& options) {
     split_module ? options.dsymPath : options.srcPath;
 
   dump_symbols.SetReportWarnings(options.report_warnings);
+  dump_symbols.SetNumThreads(options.num_threads);
+
+  if (options.shared_cache)
+    return DumpSharedCache(options, dump_symbols, symbol_data);
 
   if (!dump_symbols.Read(primary_file))
     return false;
 
+  if (!options.output_dir.empty())
+    return DumpAllArchitectures(options, dump_symbols, split_module,
+                                symbol_data);
+
   if (options.arch &&
       !SetArchitecture(dump_symbols, *options.arch, primary_file)) {
     return false;
   }
 
-  if (options.header_only)
-    return dump_symbols.WriteSymbolFileHeader(std::cout);
+  if (options.header_only) {
+    return WriteOutput(options, string(), 1, [&](std::ostream& stream) {
+      return dump_symbols.WriteSymbolFileHeader(stream);
+    });
+  }
 
   // Read the primary file into a Breakpad Module.
   Module* module = NULL;
@@ -194,45 +390,16 @@ static bool Start(const Options& options) {
       return false;
     scoped_ptr<Module> scoped_cfi_module(cfi_module);
 
-    bool name_matches;
-    if (!options.module_name.empty()) {
-      // Ignore the basename of the dSYM and binary and use the passed-in module
-      // name.
-      name_matches = true;
-    } else {
-      name_matches = cfi_module->name() == module->name();
-    }
-
-    // Ensure that the modules are for the same debug code file.
-    if (!name_matches || cfi_module->os() != module->os() ||
-        cfi_module->architecture() != module->architecture() ||
-        cfi_module->identifier() != module->identifier()) {
-      fprintf(stderr, "Cannot generate a symbol file from split sources that do"
-                      " not match.\n");
-      if (!name_matches) {
-        fprintf(stderr, "Name mismatch: binary=[%s], dSYM=[%s]\n",
-                cfi_module->name().c_str(), module->name().c_str());
-      }
-      if (cfi_module->os() != module->os()) {
-        fprintf(stderr, "OS mismatch: binary=[%s], dSYM=[%s]\n",
-                cfi_module->os().c_str(), module->os().c_str());
-      }
-      if (cfi_module->architecture() != module->architecture()) {
-        fprintf(stderr, "Architecture mismatch: binary=[%s], dSYM=[%s]\n",
-                cfi_module->architecture().c_str(),
-                module->architecture().c_str());
-      }
-      if (cfi_module->identifier() != module->identifier()) {
-        fprintf(stderr, "Identifier mismatch: binary=[%s], dSYM=[%s]\n",
-                cfi_module->identifier().c_str(), module->identifier().c_str());
-      }
+    if (!SplitModulesMatch(options, module, cfi_module))
       return false;
-    }
 
     CopyCFIDataBetweenModules(module, cfi_module);
   }
 
-  return module->Write(std::cout, symbol_data);
+  return WriteOutput(options, string(), options.num_threads,
+                     [&](std::ostream& stream) {
+                       return module->Write(stream, symbol_data);
+                     });
 }
 
 //=============================================================================
@@ -240,7 +407,8 @@ static void Usage(int argc, const char *argv[]) {
   fprintf(stderr, "Output a Breakpad symbol file from a Mach-o file.\n");
   fprintf(stderr,
           "Usage: %s [-a ARCHITECTURE] [-c] [-g dSYM path] "
-          "[-n MODULE] [-x] <Mach-o file>\n",
+          "[-n MODULE] [-j THREADS] [-o DIRECTORY] [-s] [-x] [-z FORMAT] "
+          "<Mach-o file>\n",
           argv[0]);
   fprintf(stderr, "\t-i: Output module header information only.\n");
   fprintf(stderr, "\t-w: Output warning information.\n");
@@ -260,6 +428,20 @@ static void Usage(int argc, const char *argv[]) {
   fprintf(stderr,
           "\t-x: Prefer the PUBLIC (extern) name over the FUNC if\n"
           "they do not match.\n");
+  fprintf(stderr,
+          "\t-j: Read DWARF compilation units on THREADS threads\n");
+  fprintf(stderr,
+          "\t-o: Dump every architecture in the file concurrently, writing\n"
+          "\t    each to DIRECTORY/MODULE.ARCHITECTURE.sym\n");
+  fprintf(stderr,
+          "\t-s: The file is a dyld shared cache; dump every image in it\n"
+          "\t    on THREADS threads, writing each to\n"
+          "\t    DIRECTORY/NAME_ARCHITECTURE.sym, where NAME encodes the\n"
+          "\t    image's install name. Requires -o\n");
+  fprintf(stderr,
+          "\t-z: Compress the output with FORMAT, gzip or zstd, on THREADS\n"
+          "\t    threads, appending .gz or .zst to the names of files in\n"
+          "\t    DIRECTORY\n");
   fprintf(stderr, "\t-h: Usage\n");
   fprintf(stderr, "\t-?: Usage\n");
 }
@@ -269,7 +451,7 @@ static void SetupOptions(int argc, const char *argv[], Options *options) {
   extern int optind;
   signed char ch;
 
-  while ((ch = getopt(argc, (char* const*)argv, "iwa:g:crdm?hn:x")) != -1) {
+  while ((ch = getopt(argc, (char* const*)argv, "iwa:g:crdm?hn:xj:o:sz:")) != -1) {
     switch (ch) {
       case 'i':
         options->header_only = true;
@@ -308,6 +490,35 @@ static void SetupOptions(int argc, const char *argv[], Options *options) {
       case 'x':
         options->prefer_extern_name = true;
         break;
+      case 'j':
+        options->num_threads = atoi(optarg);
+        if (options->num_threads < 1) {
+          fprintf(stderr, "%s: Invalid thread count: %s\n", argv[0], optarg);
+          Usage(argc, argv);
+          exit(1);
+        }
+        break;
+      case 'o':
+        options->output_dir = optarg;
+        break;
+      case 's':
+        options->shared_cache = true;
+        break;
+      case 'z':
+        if (!CompressingStreambuf::ParseFormat(optarg,
+                                               &options->compression_format)) {
+          fprintf(stderr, "%s: Invalid compression format: %s\n", argv[0],
+                  optarg);
+          Usage(argc, argv);
+          exit(1);
+        }
+        if (!CompressingStreambuf::IsSupported(options->compression_format)) {
+          fprintf(stderr, "%s: This build cannot write %s\n", argv[0],
+                  optarg);
+          exit(1);
+        }
+        options->compress = true;
+        break;
       case '?':
       case 'h':
         Usage(argc, argv);
@@ -322,6 +533,23 @@ static void SetupOptions(int argc, const char *argv[], Options *options) {
     exit(1);
   }
 
+  if (!options->output_dir.empty() && (options->arch ||
+                                       options->header_only)) {
+    fprintf(stderr, "-o dumps every architecture; it cannot be combined with"
+                    " -a or -i\n");
+    Usage(argc, argv);
+    exit(1);
+  }
+
+  if (options->shared_cache && (options->output_dir.empty() ||
+                                options->arch || options->header_only ||
+                                !options->dsymPath.empty())) {
+    fprintf(stderr, "-s requires -o, and cannot be combined with -a, -g or"
+                    " -i\n");
+    Usage(argc, argv);
+    exit(1);
+  }
+
   options->srcPath = argv[optind];
 }
 
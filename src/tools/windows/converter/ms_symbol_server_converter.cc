@@ -43,6 +43,7 @@
 
 #include <cassert>
 #include <cstdio>
+#include <mutex>
 
 #include "tools/windows/converter/ms_symbol_server_converter.h"
 #include "common/windows/pdb_source_line_writer.h"
@@ -59,6 +60,11 @@
 
 namespace {
 
+// All DbgHelp functions are single-threaded, so converters on different
+// threads take turns at the symbol engine.  Conversion, which doesn't use
+// DbgHelp, proceeds in parallel.
+std::mutex dbghelp_lock;
+
 std::wstring GetExeDirectory() {
   wchar_t directory[MAX_PATH];
 
@@ -294,6 +300,9 @@ MSSymbolServerConverter::LocateFile(const string& debug_or_code_file,
     return LOCATE_FAILURE;
   }
 
+  // Held until symsrv has cleaned up.
+  std::lock_guard<std::mutex> lock(dbghelp_lock);
+
   HANDLE process = GetCurrentProcess();  // CloseHandle is not needed.
   AutoSymSrv symsrv;
   if (!symsrv.Initialize(process,
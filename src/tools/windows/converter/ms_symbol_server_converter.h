@@ -59,6 +59,10 @@
 // included with the same versions of Debugging Tools for Windows, available at
 // http://www.microsoft.com/whdc/devtools/debugging/ .
 //
+// Separate MSSymbolServerConverter objects may be used on separate threads.
+// Their use of the symbol engine, which isn't thread-safe, is serialized,
+// but conversions run concurrently, each thread with its own DIA session.
+//
 // Author: Mark Mentovai
 
 #ifndef TOOLS_WINDOWS_MS_SYMBOL_SERVER_CONVERTER_H_
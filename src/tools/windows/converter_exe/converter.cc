@@ -35,11 +35,14 @@
 #include <config.h>  // Must come first
 #endif
 
+#include <algorithm>
 #include <cassert>
 #include <cstdio>
+#include <cstdlib>
 #include <ctime>
 #include <map>
 #include <regex>
+#include <set>
 #include <string>
 #include <vector>
 
@@ -309,7 +312,11 @@ static bool SafeToMakeExternalRequest(const MissingSymbolInfo& missing_info,
 // Converter options derived from command line parameters.
 struct ConverterOptions {
   ConverterOptions()
-      : report_fetch_failures(true), trace_symsrv(false), keep_files(false) {}
+      : report_fetch_failures(true),
+        trace_symsrv(false),
+        keep_files(false),
+        use_cache(false),
+        jobs(1) {}
 
   ~ConverterOptions() {
   }
@@ -362,12 +369,107 @@ struct ConverterOptions {
   // If set then Breakpad/PE/PDB files won't be deleted after processing.
   bool keep_files;
 
+  // If set then Breakpad files converted on earlier runs and kept in the
+  // local cache are uploaded instead of fetching and converting again.
+  bool use_cache;
+
+  // The number of symbol files to fetch and convert at once.
+  int jobs;
+
  private:
   // DISABLE_COPY_AND_ASSIGN
   ConverterOptions(const ConverterOptions&);
   ConverterOptions& operator=(const ConverterOptions&);
 };
 
+// Uploads the converted Breakpad symbol file and, if they were kept, the
+// PDB and PE files it was converted from, deleting them afterwards unless
+// |options.keep_files| is set.
+static void UploadConvertedFiles(const MissingSymbolInfo& missing_info,
+                                 const ConverterOptions& options,
+                                 const string& converted_file,
+                                 const string& symbol_file,
+                                 const string& pe_file) {
+  // Don't bother checking the return value. If this succeeds, it should
+  // disappear from the missing symbol list. If it fails, something will
+  // print an error message indicating the cause of the failure, and the
+  // item will remain on the missing symbol list.
+  UploadSymbolFile(options.upload_symbols_url, options.api_key,
+                   missing_info.debug_file, missing_info.debug_identifier,
+                   converted_file, kSymbolUploadTypeBreakpad);
+  if (!options.keep_files)
+    remove(converted_file.c_str());
+
+  // Upload PDB/PE if we have them
+  if (!symbol_file.empty()) {
+    UploadSymbolFile(options.upload_symbols_url, options.api_key,
+                     missing_info.debug_file, missing_info.debug_identifier,
+                     symbol_file, kSymbolUploadTypePDB);
+    if (!options.keep_files)
+      remove(symbol_file.c_str());
+  }
+  if (!pe_file.empty()) {
+    UploadSymbolFile(options.upload_symbols_url, options.api_key,
+                     missing_info.code_file, missing_info.debug_identifier,
+                     pe_file, kSymbolUploadTypePE);
+    if (!options.keep_files)
+      remove(pe_file.c_str());
+  }
+
+  // Note: this does leave some directories behind that could be
+  // cleaned up.  The directories inside options.local_cache_path for
+  // debug_file/debug_identifier can be removed at this point.
+}
+
+static bool FileExists(const string& path) {
+  DWORD attributes = GetFileAttributesA(path.c_str());
+  return attributes != INVALID_FILE_ATTRIBUTES &&
+         !(attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+// Returns the path at which SymSrv stores |file| with identifier |id| in
+// |options.local_cache_path|, with the file's extension replaced by
+// |extension| if it's not empty.
+static string CachePath(const ConverterOptions& options,
+                        const string& file,
+                        const string& id,
+                        const char* extension) {
+  string name = file;
+  if (*extension && name.length() > 4 && name[name.length() - 4] == '.')
+    name = name.substr(0, name.length() - 4) + extension;
+  return options.local_cache_path + "\\" + file + "\\" + id + "\\" + name;
+}
+
+// Looks in the local cache for a Breakpad symbol file converted from the
+// PDB, or failing that the PE file, described by |missing_info| on an
+// earlier run.  Returns true and sets |converted_file|, and |symbol_file|
+// and |pe_file| if they are still cached, on success.
+static bool FindCachedSymbolFiles(const MissingSymbolInfo& missing_info,
+                                  const ConverterOptions& options,
+                                  string* converted_file,
+                                  string* symbol_file,
+                                  string* pe_file) {
+  string pdb = CachePath(options, missing_info.debug_file,
+                         missing_info.debug_identifier, "");
+  string pe = CachePath(options, missing_info.code_file,
+                        missing_info.code_identifier, "");
+  string pdb_sym = CachePath(options, missing_info.debug_file,
+                             missing_info.debug_identifier, ".sym");
+  string pe_sym = CachePath(options, missing_info.code_file,
+                            missing_info.code_identifier, ".sym");
+  if (FileExists(pdb_sym)) {
+    *converted_file = pdb_sym;
+    *symbol_file = FileExists(pdb) ? pdb : "";
+  } else if (!missing_info.code_file.empty() && FileExists(pe_sym)) {
+    *converted_file = pe_sym;
+    symbol_file->clear();
+  } else {
+    return false;
+  }
+  *pe_file = !missing_info.code_file.empty() && FileExists(pe) ? pe : "";
+  return true;
+}
+
 // ConverMissingSymbolFile takes a single MissingSymbolInfo structure and
 // attempts to locate it from the symbol servers provided in the
 // |options.*_msss_servers| arguments.  "Full" servers are those that will be
@@ -387,6 +489,19 @@ static void ConvertMissingSymbolFile(const MissingSymbolInfo& missing_info,
                missing_info.debug_identifier.c_str(),
                missing_info.version.c_str());
 
+  if (options.use_cache) {
+    string converted_file;
+    string symbol_file;
+    string pe_file;
+    if (FindCachedSymbolFiles(missing_info, options, &converted_file,
+                              &symbol_file, &pe_file)) {
+      FprintfFlush(stderr, "Using cached %s\n", converted_file.c_str());
+      UploadConvertedFiles(missing_info, options, converted_file, symbol_file,
+                           pe_file);
+      return;
+    }
+  }
+
   // The first lookup is always to internal symbol servers.
   // Always ask the symbol servers identified as "full."
   vector<string> msss_servers = options.full_internal_msss_servers;
@@ -435,38 +550,8 @@ static void ConvertMissingSymbolFile(const MissingSymbolInfo& missing_info,
     switch (located) {
       case MSSymbolServerConverter::LOCATE_SUCCESS:
         FprintfFlush(stderr, "LocateResult = LOCATE_SUCCESS\n");
-        // Upload it. Don't bother checking the return value. If this
-        // succeeds, it should disappear from the missing symbol list.
-        // If it fails, something will print an error message indicating
-        // the cause of the failure, and the item will remain on the
-        // missing symbol list.
-        UploadSymbolFile(options.upload_symbols_url, options.api_key,
-                         missing_info.debug_file, missing_info.debug_identifier,
-                         converted_file, kSymbolUploadTypeBreakpad);
-        if (!options.keep_files)
-          remove(converted_file.c_str());
-
-        // Upload PDB/PE if we have them
-        if (!symbol_file.empty()) {
-          UploadSymbolFile(options.upload_symbols_url, options.api_key,
-                           missing_info.debug_file,
-                           missing_info.debug_identifier, symbol_file,
-                           kSymbolUploadTypePDB);
-          if (!options.keep_files)
-            remove(symbol_file.c_str());
-        }
-        if (!pe_file.empty()) {
-          UploadSymbolFile(options.upload_symbols_url, options.api_key,
-                           missing_info.code_file,
-                           missing_info.debug_identifier, pe_file,
-                           kSymbolUploadTypePE);
-          if (!options.keep_files)
-            remove(pe_file.c_str());
-        }
-
-        // Note: this does leave some directories behind that could be
-        // cleaned up.  The directories inside options.local_cache_path for
-        // debug_file/debug_identifier can be removed at this point.
+        UploadConvertedFiles(missing_info, options, converted_file,
+                             symbol_file, pe_file);
         break;
 
       case MSSymbolServerConverter::LOCATE_NOT_FOUND:
@@ -544,36 +629,8 @@ static void ConvertMissingSymbolFile(const MissingSymbolInfo& missing_info,
   switch (located) {
     case MSSymbolServerConverter::LOCATE_SUCCESS:
       FprintfFlush(stderr, "LocateResult = LOCATE_SUCCESS\n");
-      // Upload it. Don't bother checking the return value. If this
-      // succeeds, it should disappear from the missing symbol list.
-      // If it fails, something will print an error message indicating
-      // the cause of the failure, and the item will remain on the
-      // missing symbol list.
-      UploadSymbolFile(options.upload_symbols_url, options.api_key,
-                       missing_info.debug_file, missing_info.debug_identifier,
-                       converted_file, kSymbolUploadTypeBreakpad);
-      if (!options.keep_files)
-        remove(converted_file.c_str());
-
-      // Upload PDB/PE if we have them
-      if (!symbol_file.empty()) {
-        UploadSymbolFile(options.upload_symbols_url, options.api_key,
-                         missing_info.debug_file, missing_info.debug_identifier,
-                         symbol_file, kSymbolUploadTypePDB);
-        if (!options.keep_files)
-          remove(symbol_file.c_str());
-      }
-      if (!pe_file.empty()) {
-        UploadSymbolFile(options.upload_symbols_url, options.api_key,
-                         missing_info.code_file, missing_info.debug_identifier,
-                         pe_file, kSymbolUploadTypePE);
-        if (!options.keep_files)
-          remove(pe_file.c_str());
-      }
-
-      // Note: this does leave some directories behind that could be
-      // cleaned up.  The directories inside options.local_cache_path for
-      // debug_file/debug_identifier can be removed at this point.
+      UploadConvertedFiles(missing_info, options, converted_file, symbol_file,
+                           pe_file);
       break;
 
     case MSSymbolServerConverter::LOCATE_NOT_FOUND:
@@ -656,6 +713,54 @@ static bool ReadFile(string file_name, string* contents) {
   return true;
 }
 
+// State shared by the threads of ConvertMissingSymbolFiles.
+struct ConvertState {
+  const vector<MissingSymbolInfo>* missing;
+  const ConverterOptions* options;
+  volatile LONG next_file;  // Index of the next file to convert, less one.
+};
+
+static DWORD WINAPI ConvertMissingSymbolFilesThread(void* context) {
+  ConvertState* state = reinterpret_cast<ConvertState*>(context);
+  LONG count = static_cast<LONG>(state->missing->size());
+  for (LONG index = InterlockedIncrement(&state->next_file); index < count;
+       index = InterlockedIncrement(&state->next_file)) {
+    ConvertMissingSymbolFile((*state->missing)[index], *state->options);
+  }
+  return 0;
+}
+
+// Calls ConvertMissingSymbolFile for each of |missing| on up to
+// |options.jobs| threads.  Each thread converts with its own DIA session,
+// while fetches from the symbol servers take turns.
+static void ConvertMissingSymbolFiles(const vector<MissingSymbolInfo>& missing,
+                                      const ConverterOptions& options) {
+  ConvertState state;
+  state.missing = &missing;
+  state.options = &options;
+  state.next_file = -1;
+
+  size_t thread_count = std::min(missing.size(), static_cast<size_t>(
+      std::min(std::max(options.jobs, 1), MAXIMUM_WAIT_OBJECTS)));
+  vector<HANDLE> threads;
+  if (thread_count > 1) {
+    for (size_t i = 0; i < thread_count; ++i) {
+      HANDLE thread = CreateThread(NULL, 0, ConvertMissingSymbolFilesThread,
+                                   &state, 0, NULL);
+      if (thread)
+        threads.push_back(thread);
+    }
+  }
+  if (threads.empty()) {
+    ConvertMissingSymbolFilesThread(&state);
+  } else {
+    WaitForMultipleObjects(static_cast<DWORD>(threads.size()), &threads[0],
+                           TRUE, INFINITE);
+    for (size_t i = 0; i < threads.size(); ++i)
+      CloseHandle(threads[i]);
+  }
+}
+
 // ConvertMissingSymbolsList obtains a missing symbol list from
 // |options.missing_symbols_url| or |options.missing_symbols_file| and calls
 // ConvertMissingSymbolFile for each missing symbol file in the list.
@@ -681,7 +786,8 @@ static bool ConvertMissingSymbolsList(const ConverterOptions& options) {
 
   FprintfFlush(stderr, "Found %d missing symbol files in list.\n",
                missing_symbol_lines.size() - 1);  // last line is empty.
-  int convert_attempts = 0;
+  vector<MissingSymbolInfo> missing_symbols;
+  std::set<string> seen_symbols;
   for (vector<string>::const_iterator iterator = missing_symbol_lines.begin();
        iterator != missing_symbol_lines.end();
        ++iterator) {
@@ -711,13 +817,21 @@ static bool ConvertMissingSymbolsList(const ConverterOptions& options) {
       continue;
     }
 
-    ++convert_attempts;
-    ConvertMissingSymbolFile(missing_info, options);
+    // Converting the same file twice at once would have two threads writing
+    // to the same place in the local cache.
+    if (!seen_symbols.insert(missing_info.debug_file + "|" +
+                             missing_info.debug_identifier).second) {
+      continue;
+    }
+
+    missing_symbols.push_back(missing_info);
   }
 
+  ConvertMissingSymbolFiles(missing_symbols, options);
+
   // Say something reassuring, since ConvertMissingSymbolFile was never called
   // and therefore never reported any progress.
-  if (convert_attempts == 0) {
+  if (missing_symbols.empty()) {
     string current_time = CurrentDateAndTime();
     FprintfFlush(stdout, "converter: %s: nothing to convert\n",
                  current_time.c_str());
@@ -748,6 +862,12 @@ static int usage(const char* program_name) {
       "                               traced to stderr.\n"
       "    -keep-files                If set then don't delete Breakpad/PE/\n"
       "                               PDB files after conversion.\n"
+      "    -cache                     Keep Breakpad/PE/PDB files in the\n"
+      "                               local cache and upload previously\n"
+      "                               converted files instead of converting\n"
+      "                               them again.  Implies -keep-files.\n"
+      "    -j  <jobs>                 Number of symbol files to fetch and\n"
+      "                               convert at once (default 1)\n"
       " Note that any server specified by -f or -n that starts with \\filer\n"
       " will be treated as internal, and all others as external.\n",
       program_name);
@@ -797,6 +917,11 @@ int main(int argc, char** argv) {
       printf("Keeping Breakpad/PE/PDB files after conversion.\n");
       options.keep_files = true;
       continue;
+    } else if (option == "-cache") {
+      printf("Reusing Breakpad/PE/PDB files from the local cache.\n");
+      options.keep_files = true;
+      options.use_cache = true;
+      continue;
     }
 
     string value = argv[++argi];
@@ -848,6 +973,11 @@ int main(int argc, char** argv) {
       }
     } else if (option == "-b") {
       blacklist_regex_str = value;
+    } else if (option == "-j") {
+      options.jobs = atoi(value.c_str());
+      if (options.jobs < 1) {
+        return usage(argv[0]);
+      }
     } else {
       return usage(argv[0]);
     }
@@ -33,22 +33,32 @@
 #include <config.h>  // Must come first
 #endif
 
+#include <fcntl.h>
+#include <io.h>
 #include <stdio.h>
 #include <wchar.h>
 
+#include <functional>
 #include <memory>
+#include <ostream>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "common/compressing_streambuf.h"
 #include "common/windows/pdb_source_line_writer.h"
 #include "common/windows/pe_source_line_writer.h"
 
+using google_breakpad::CompressingStreambuf;
 using google_breakpad::PDBSourceLineWriter;
 using google_breakpad::PESourceLineWriter;
 using std::unique_ptr;
 using std::wstring;
 
 int usage(const wchar_t* self) {
-  fprintf(stderr, "Usage: %ws [--pe] [--i] <file.[pdb|exe|dll]>\n", self);
+  fprintf(stderr,
+          "Usage: %ws [--pe] [--i] [--gzip|--zstd] <file.[pdb|exe|dll]>\n",
+          self);
   fprintf(stderr, "Options:\n");
   fprintf(stderr,
           "--pe:\tRead debugging information from PE file and do "
@@ -57,13 +67,58 @@ int usage(const wchar_t* self) {
   fprintf(stderr,
           "--i:\tOutput INLINE/INLINE_ORIGIN record\n"
           "\tThis cannot be used with [--pe].\n");
+  fprintf(stderr,
+          "--gzip, --zstd:\tCompress the output with gzip or zstd, on as\n"
+          "\tmany threads as there are processors.\n");
   return 1;
 }
 
+// Call |write| with a FILE* whose contents are compressed in |format| and
+// written to stdout.  The symbol writers print to a FILE*, so their output
+// is passed to the compressor through a pipe, without the text ever
+// reaching the disk.
+static bool WriteCompressed(CompressingStreambuf::Format format,
+                            const std::function<bool(FILE*)>& write) {
+  const unsigned int kPipeSize = 1 << 20;
+  int fds[2];
+  if (_pipe(fds, kPipeSize, _O_BINARY) != 0)
+    return false;
+  FILE* pipe = _fdopen(fds[1], "wb");
+  if (!pipe) {
+    _close(fds[0]);
+    _close(fds[1]);
+    return false;
+  }
+  setvbuf(pipe, NULL, _IOFBF, kPipeSize);
+  _setmode(_fileno(stdout), _O_BINARY);
+
+  bool compressed = false;
+  std::thread compressor([&] {
+    int num_threads = std::thread::hardware_concurrency();
+    CompressingStreambuf buffer(stdout, format,
+                                num_threads > 0 ? num_threads : 1);
+    std::ostream stream(&buffer);
+    std::vector<char> chunk(kPipeSize);
+    int read;
+    while ((read = _read(fds[0], chunk.data(), kPipeSize)) > 0)
+      stream.write(chunk.data(), read);
+    compressed = read == 0 && stream.good() && buffer.Finish();
+    _close(fds[0]);
+  });
+  bool written = write(pipe);
+  // Closing the pipe lets the compressor see the end of the output.
+  if (fclose(pipe) != 0)
+    written = false;
+  compressor.join();
+  return written && compressed;
+}
+
 int wmain(int argc, wchar_t** argv) {
   bool success = false;
   bool pe = false;
   bool handle_inline = false;
+  bool compress = false;
+  CompressingStreambuf::Format compression_format = CompressingStreambuf::GZIP;
   int arg_index = 1;
   while (arg_index < argc && wcslen(argv[arg_index]) > 0 &&
          wcsncmp(L"--", argv[arg_index], 2) == 0) {
@@ -71,6 +126,12 @@ int wmain(int argc, wchar_t** argv) {
       pe = true;
     } else if (wcscmp(L"--i", argv[arg_index]) == 0) {
       handle_inline = true;
+    } else if (wcscmp(L"--gzip", argv[arg_index]) == 0) {
+      compress = true;
+      compression_format = CompressingStreambuf::GZIP;
+    } else if (wcscmp(L"--zstd", argv[arg_index]) == 0) {
+      compress = true;
+      compression_format = CompressingStreambuf::ZSTD;
     }
     ++arg_index;
   }
@@ -80,18 +141,33 @@ int wmain(int argc, wchar_t** argv) {
     return 1;
   }
 
+  if (compress && !CompressingStreambuf::IsSupported(compression_format)) {
+    fprintf(stderr, "This build cannot write the compression format.\n");
+    return 1;
+  }
+
+  // Symbol files for large PDBs run to hundreds of megabytes; write them out
+  // in large blocks rather than a few kilobytes at a time.
+  setvbuf(stdout, NULL, _IOFBF, 1 << 20);
+
   wchar_t* file_path = argv[arg_index];
+  std::function<bool(FILE*)> write;
+  unique_ptr<PESourceLineWriter> pe_writer;
+  unique_ptr<PDBSourceLineWriter> pdb_writer;
   if (pe) {
-    PESourceLineWriter pe_writer(file_path);
-    success = pe_writer.WriteSymbols(stdout);
+    pe_writer.reset(new PESourceLineWriter(file_path));
+    write = [&](FILE* file) { return pe_writer->WriteSymbols(file); };
   } else {
-    PDBSourceLineWriter pdb_writer(handle_inline);
-    if (!pdb_writer.Open(wstring(file_path), PDBSourceLineWriter::ANY_FILE)) {
+    pdb_writer.reset(new PDBSourceLineWriter(handle_inline));
+    if (!pdb_writer->Open(wstring(file_path),
+                          PDBSourceLineWriter::ANY_FILE)) {
       fprintf(stderr, "Open failed.\n");
       return 1;
     }
-    success = pdb_writer.WriteSymbols(stdout);
+    write = [&](FILE* file) { return pdb_writer->WriteSymbols(file); };
   }
+  success = compress ? WriteCompressed(compression_format, write)
+                     : write(stdout);
 
   if (!success) {
     fprintf(stderr, "WriteSymbols failed.\n");
@@ -113,6 +113,24 @@ static bool GetFileVersionString(const wchar_t* filename, wstring* version) {
   return true;
 }
 
+// Reads the paths listed one per line in |manifest| into |modules|.
+static bool ReadManifest(const wchar_t* manifest, vector<wstring>* modules) {
+  FILE* file = NULL;
+  if (_wfopen_s(&file, manifest, L"r") != 0) {
+    return false;
+  }
+  wchar_t line[_MAX_PATH];
+  while (fgetws(line, _MAX_PATH, file)) {
+    wstring path(line);
+    path.erase(path.find_last_not_of(L" \t\r\n") + 1);
+    if (!path.empty() && path[0] != L'#') {
+      modules->push_back(path);
+    }
+  }
+  fclose(file);
+  return true;
+}
+
 // Creates a new temporary file and writes the symbol data from the given
 // exe/dll file to it.  Returns the path to the temp file in temp_file_path
 // and information about the pdb in pdb_info.
@@ -184,6 +202,14 @@ __declspec(noreturn) void printUsageAndExit() {
   wprintf(L"    <API-key> is a secret used to authenticate with the API.\n");
   wprintf(L"    -p:\t Use sym_upload_v2 protocol.\n");
   wprintf(L"    -f:\t Force symbol upload if already exists.\n");
+  wprintf(L"\n");
+  wprintf(L"sym-upload-v2 batch usage:\n"
+          L"    symupload -p [-f] [--jobs NN] [--retries NN] ^\n"
+          L"              --manifest <modules.txt> <API-URL> <API-key>\n");
+  wprintf(L"\n");
+  wprintf(L"  - The manifest lists one exe or dll per line. Their symbols are\n"
+          L"    uploaded --jobs (default 8) at a time, and each failed\n"
+          L"    upload is retried up to --retries (default 3) times.\n");
 
   exit(0);
 }
@@ -196,6 +222,9 @@ int wmain(int argc, wchar_t* argv[]) {
   int currentarg = 1;
   bool use_sym_upload_v2 = false;
   bool force = false;
+  const wchar_t* manifest = nullptr;
+  int jobs = 8;
+  int retries = 3;
   const wchar_t* api_url = nullptr;
   const wchar_t* api_key = nullptr;
   while (argc > currentarg + 1) {
@@ -224,9 +253,70 @@ int wmain(int argc, wchar_t* argv[]) {
       ++currentarg;
       continue;
     }
+    if (!wcscmp(L"--manifest", argv[currentarg])) {
+      manifest = argv[currentarg + 1];
+      currentarg += 2;
+      continue;
+    }
+    if (!wcscmp(L"--jobs", argv[currentarg])) {
+      jobs = _wtoi(argv[currentarg + 1]);
+      currentarg += 2;
+      continue;
+    }
+    if (!wcscmp(L"--retries", argv[currentarg])) {
+      retries = _wtoi(argv[currentarg + 1]);
+      currentarg += 2;
+      continue;
+    }
     break;
   }
 
+  if (manifest) {
+    // Batch mode. Dumping symbols uses DIA, so it's done here one module at
+    // a time; only the uploads run in parallel.
+    if (!use_sym_upload_v2 || argc != currentarg + 2) {
+      printUsageAndExit();
+    }
+    api_url = argv[currentarg++];
+    api_key = argv[currentarg++];
+
+    vector<wstring> modules;
+    if (!ReadManifest(manifest, &modules)) {
+      fwprintf(stderr, L"Could not read manifest %s\n", manifest);
+      return 1;
+    }
+
+    bool success = true;
+    vector<google_breakpad::SymUploadV2File> files;
+    for (size_t i = 0; i < modules.size(); ++i) {
+      google_breakpad::SymUploadV2File file;
+      PDBModuleInfo pdb_info;
+      if (!DumpSymbolsToTempFile(modules[i].c_str(), &file.symbol_filename,
+                                 &pdb_info, handle_inline)) {
+        fwprintf(stderr, L"Could not get symbol data from %s\n",
+                 modules[i].c_str());
+        success = false;
+        continue;
+      }
+      file.debug_file = pdb_info.debug_file;
+      file.debug_id = pdb_info.debug_identifier;
+      file.symbol_type = kSymbolUploadTypeBreakpad;
+      files.push_back(file);
+    }
+
+    wstring product_name = product ? wstring(product) : L"";
+    if (!google_breakpad::SymUploadV2ProtocolSendBatch(
+            api_url, api_key, timeout == -1 ? nullptr : &timeout, files,
+            product_name, force, jobs, retries)) {
+      success = false;
+    }
+
+    for (size_t i = 0; i < files.size(); ++i) {
+      _wunlink(files[i].symbol_filename.c_str());
+    }
+    return success ? 0 : 1;
+  }
+
   if (argc >= currentarg + 2)
     module = argv[currentarg++];
   else